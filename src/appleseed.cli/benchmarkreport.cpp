@@ -0,0 +1,242 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "benchmarkreport.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/phaseprofile.h"
+#include "foundation/utility/statistics.h"
+
+// Standard headers.
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+
+using namespace foundation;
+using namespace std;
+
+namespace appleseed {
+namespace cli {
+
+namespace
+{
+    void write_json_string(ostream& output, const string& s)
+    {
+        output << '"';
+
+        for (size_t i = 0; i < s.size(); ++i)
+        {
+            const char c = s[i];
+
+            if (c == '"' || c == '\\')
+                output << '\\' << c;
+            else if (c == '\n')
+                output << "\\n";
+            else if (static_cast<unsigned char>(c) < 0x20)
+                output << ' ';
+            else output << c;
+        }
+
+        output << '"';
+    }
+
+    void write_json_statistics_value(ostream& output, const Statistics::Entry* entry)
+    {
+        if (const Statistics::UnsignedIntegerEntry* e = dynamic_cast<const Statistics::UnsignedIntegerEntry*>(entry))
+            output << e->m_value;
+        else if (const Statistics::IntegerEntry* e = dynamic_cast<const Statistics::IntegerEntry*>(entry))
+            output << e->m_value;
+        else if (const Statistics::FloatingPointEntry* e = dynamic_cast<const Statistics::FloatingPointEntry*>(entry))
+            output << e->m_value;
+        else write_json_string(output, entry->to_string());
+    }
+
+    void write_json_run(ostream& output, const BenchmarkRun& run, const char* indent)
+    {
+        output << "{" << endl;
+        output << indent << "  \"total_time\": " << run.m_total_time << "," << endl;
+        output << indent << "  \"preparation_time\": " << run.m_preparation_time << "," << endl;
+        output << indent << "  \"render_time\": " << run.m_render_time << "," << endl;
+        output << indent << "  \"rays\": " << run.m_ray_count << "," << endl;
+        output << indent << "  \"samples\": " << run.m_sample_count << "," << endl;
+        output << indent << "  \"rays_per_second\": "
+               << (run.m_render_time > 0.0 ? run.m_ray_count / run.m_render_time : 0.0) << "," << endl;
+        output << indent << "  \"samples_per_second\": "
+               << (run.m_render_time > 0.0 ? run.m_sample_count / run.m_render_time : 0.0) << "," << endl;
+        output << indent << "  \"peak_memory\": " << run.m_peak_memory << endl;
+        output << indent << "}";
+    }
+}
+
+
+//
+// BenchmarkReport class implementation.
+//
+
+BenchmarkReport::BenchmarkReport()
+  : m_load_time(0.0)
+  , m_warmup_run_count(0)
+  , m_preparation_profile(0)
+  , m_render_statistics(0)
+{
+}
+
+BenchmarkRun BenchmarkReport::get_average_run() const
+{
+    BenchmarkRun average;
+    average.m_total_time = 0.0;
+    average.m_preparation_time = 0.0;
+    average.m_render_time = 0.0;
+    average.m_ray_count = 0;
+    average.m_sample_count = 0;
+    average.m_peak_memory = 0;
+
+    if (m_runs.empty())
+        return average;
+
+    for (size_t i = 0; i < m_runs.size(); ++i)
+    {
+        const BenchmarkRun& run = m_runs[i];
+        average.m_total_time += run.m_total_time;
+        average.m_preparation_time += run.m_preparation_time;
+        average.m_render_time += run.m_render_time;
+        average.m_ray_count += run.m_ray_count;
+        average.m_sample_count += run.m_sample_count;
+        average.m_peak_memory = max(average.m_peak_memory, run.m_peak_memory);
+    }
+
+    const size_t n = m_runs.size();
+    average.m_total_time /= n;
+    average.m_preparation_time /= n;
+    average.m_render_time /= n;
+    average.m_ray_count /= n;
+    average.m_sample_count /= n;
+
+    return average;
+}
+
+bool BenchmarkReport::write_json(ostream& output) const
+{
+    output << fixed << setprecision(6);
+
+    output << "{" << endl;
+
+    output << "  \"project\": ";
+    write_json_string(output, m_project_path);
+    output << "," << endl;
+
+    output << "  \"load_time\": " << m_load_time << "," << endl;
+    output << "  \"warmup_runs\": " << m_warmup_run_count << "," << endl;
+
+    output << "  \"runs\": [";
+    for (size_t i = 0; i < m_runs.size(); ++i)
+    {
+        output << (i > 0 ? "," : "") << endl << "    ";
+        write_json_run(output, m_runs[i], "    ");
+    }
+    output << endl << "  ]," << endl;
+
+    output << "  \"average\": ";
+    write_json_run(output, get_average_run(), "  ");
+
+    if (m_preparation_profile)
+    {
+        output << "," << endl << "  \"preparation_phases\": [";
+        for (size_t i = 0, e = m_preparation_profile->get_phase_count(); i < e; ++i)
+        {
+            output << (i > 0 ? "," : "") << endl << "    { \"name\": ";
+            write_json_string(output, m_preparation_profile->get_phase_name(i));
+            output << ", \"depth\": " << m_preparation_profile->get_phase_depth(i);
+            output << ", \"time\": " << m_preparation_profile->get_phase_seconds(i);
+            output << ", \"peak_memory\": " << m_preparation_profile->get_phase_peak_memory(i) << " }";
+        }
+        output << endl << "  ]";
+    }
+
+    if (m_render_statistics)
+    {
+        output << "," << endl << "  \"statistics\": {";
+        for (size_t i = 0; i < m_render_statistics->size(); ++i)
+        {
+            const Statistics& stats = m_render_statistics->get(i);
+
+            output << (i > 0 ? "," : "") << endl << "    ";
+            write_json_string(output, m_render_statistics->get_name(i));
+            output << ": {";
+
+            for (size_t j = 0; j < stats.size(); ++j)
+            {
+                const Statistics::Entry* entry = stats.get(j);
+                output << (j > 0 ? "," : "") << endl << "      ";
+                write_json_string(output, entry->m_name);
+                output << ": ";
+                write_json_statistics_value(output, entry);
+            }
+
+            output << endl << "    }";
+        }
+        output << endl << "  }";
+    }
+
+    output << endl << "}" << endl;
+
+    return !output.fail();
+}
+
+bool BenchmarkReport::write_json(const char* file_path) const
+{
+    ofstream output(file_path);
+
+    if (!output.is_open())
+        return false;
+
+    return write_json(output);
+}
+
+uint64 sum_statistics(
+    const StatisticsVector&     stats,
+    const char*                 name)
+{
+    uint64 sum = 0;
+
+    for (size_t i = 0; i < stats.size(); ++i)
+    {
+        const Statistics::Entry* entry = stats.get(i).find(name);
+
+        if (const Statistics::UnsignedIntegerEntry* e = dynamic_cast<const Statistics::UnsignedIntegerEntry*>(entry))
+            sum += e->m_value;
+    }
+
+    return sum;
+}
+
+}   // namespace cli
+}   // namespace appleseed
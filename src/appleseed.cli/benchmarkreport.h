@@ -0,0 +1,97 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_CLI_BENCHMARKREPORT_H
+#define APPLESEED_CLI_BENCHMARKREPORT_H
+
+// appleseed.foundation headers.
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class PhaseProfile; }
+namespace foundation    { class StatisticsVector; }
+
+namespace appleseed {
+namespace cli {
+
+//
+// Measurements of one benchmark render.
+//
+
+struct BenchmarkRun
+{
+    double                                  m_total_time;           // in seconds
+    double                                  m_preparation_time;     // in seconds
+    double                                  m_render_time;          // in seconds
+    foundation::uint64                      m_ray_count;
+    foundation::uint64                      m_sample_count;
+    foundation::uint64                      m_peak_memory;          // peak memory of the process, in bytes
+};
+
+
+//
+// Results of a series of benchmark renders of a project.
+//
+
+struct BenchmarkReport
+{
+    std::string                             m_project_path;
+    double                                  m_load_time;            // in seconds
+    size_t                                  m_warmup_run_count;
+    std::vector<BenchmarkRun>               m_runs;                 // measured runs only
+
+    // Preparation phases and statistics of the rendering threads of the last measured run.
+    const foundation::PhaseProfile*         m_preparation_profile;
+    const foundation::StatisticsVector*     m_render_statistics;
+
+    BenchmarkReport();
+
+    // Return the average of the measured runs.
+    BenchmarkRun get_average_run() const;
+
+    // Write the report as a JSON object. Return true on success.
+    bool write_json(std::ostream& output) const;
+    bool write_json(const char* file_path) const;
+};
+
+// Return the sum of the unsigned integer statistics named 'name' across all statistics of 'stats'.
+foundation::uint64 sum_statistics(
+    const foundation::StatisticsVector&     stats,
+    const char*                             name);
+
+}       // namespace cli
+}       // namespace appleseed
+
+#endif  // !APPLESEED_CLI_BENCHMARKREPORT_H
@@ -0,0 +1,103 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "cameraframesequence.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/camera.h"
+#include "renderer/api/frame.h"
+#include "renderer/api/project.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/log.h"
+#include "foundation/utility/string.h"
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+namespace appleseed {
+namespace cli {
+
+//
+// CameraFrameSequence class implementation.
+//
+
+CameraFrameSequence::CameraFrameSequence(
+    const string&       project_pattern,
+    const string&       schema_filepath,
+    const string&       output_pattern,
+    const bool          output_aovs,
+    const size_t        first_frame,
+    const size_t        last_frame,
+    Logger&             logger)
+  : FrameSequenceBase(output_pattern, output_aovs, first_frame, last_frame, logger)
+  , m_project_pattern(project_pattern)
+  , m_schema_filepath(schema_filepath)
+{
+}
+
+bool CameraFrameSequence::on_frame_begin(
+    Project&            project,
+    const size_t        frame_index)
+{
+    const size_t frame = print_frame_begin(frame_index);
+
+    // The project of the first frame is the one being rendered.
+    if (frame_index == 0)
+        return true;
+
+    // Only read the camera of the project of this frame, skipping mesh files.
+    const string project_filepath = get_numbered_string(m_project_pattern, frame);
+    ProjectFileReader reader;
+    auto_release_ptr<Project> frame_project =
+        reader.read(
+            project_filepath.c_str(),
+            m_schema_filepath.c_str(),
+            ProjectFileReader::OmitReadingMeshFiles);
+
+    if (frame_project.get() == 0)
+        return false;
+
+    const Camera* frame_camera = frame_project->get_uncached_active_camera();
+    Camera* camera = project.get_uncached_active_camera();
+
+    if (frame_camera == 0 || camera == 0)
+    {
+        LOG_ERROR(m_logger, "no active camera in project %s.", project_filepath.c_str());
+        return false;
+    }
+
+    camera->transform_sequence() = frame_camera->transform_sequence();
+
+    return true;
+}
+
+}   // namespace cli
+}   // namespace appleseed
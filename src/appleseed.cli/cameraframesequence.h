@@ -0,0 +1,82 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_CLI_CAMERAFRAMESEQUENCE_H
+#define APPLESEED_CLI_CAMERAFRAMESEQUENCE_H
+
+// appleseed.cli headers.
+#include "framesequencebase.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+
+// Forward declarations.
+namespace foundation    { class Logger; }
+namespace renderer      { class Project; }
+
+namespace appleseed {
+namespace cli {
+
+//
+// A frame sequence that only changes the camera between frames.
+//
+// The camera of each frame is read from a numbered project file, such as the project
+// files written by animatecamera; the '#' characters of the file name patterns are
+// replaced by the frame number.
+//
+
+class CameraFrameSequence
+  : public FrameSequenceBase
+{
+  public:
+    // Constructor. 'output_pattern' may be empty if frames should not be written.
+    CameraFrameSequence(
+        const std::string&          project_pattern,
+        const std::string&          schema_filepath,
+        const std::string&          output_pattern,
+        const bool                  output_aovs,
+        const size_t                first_frame,
+        const size_t                last_frame,
+        foundation::Logger&         logger);
+
+    virtual bool on_frame_begin(
+        renderer::Project&          project,
+        const size_t                frame_index) APPLESEED_OVERRIDE;
+
+  private:
+    const std::string               m_project_pattern;
+    const std::string               m_schema_filepath;
+};
+
+}       // namespace cli
+}       // namespace appleseed
+
+#endif  // !APPLESEED_CLI_CAMERAFRAMESEQUENCE_H
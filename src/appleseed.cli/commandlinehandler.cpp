@@ -83,6 +83,21 @@ CommandLineHandler::CommandLineHandler()
             .add_name("--disable-autosave")
             .set_description("disable automatic saving of rendered images"));
 
+    parser().add_option_handler(
+        &m_deduplicate_meshes
+            .add_name("--deduplicate-meshes")
+            .set_description("share the geometry of mesh objects with identical content"));
+
+    parser().add_option_handler(
+        &m_fast_load
+            .add_name("--fast-load")
+            .set_description("skip the validation of the project file against the project schema"));
+
+    parser().add_option_handler(
+        &m_async_logging
+            .add_name("--async-logging")
+            .set_description("write renderer log messages from a background thread instead of the rendering threads"));
+
     parser().add_option_handler(
         &m_threads
             .add_name("--threads")
@@ -103,6 +118,30 @@ CommandLineHandler::CommandLineHandler()
             .add_name("--continuous-saving")
             .set_description("write tiles to disk as soon as they are rendered"));
 
+    parser().add_option_handler(
+        &m_streaming_output
+            .add_name("--streaming-output")
+            .set_description("write finished tiles to a multi-layer OpenEXR output file and release their memory"));
+
+    parser().add_option_handler(
+        &m_deep_output
+            .add_name("--deep-output")
+            .set_description("write the depth-sorted fragments of each pixel to a deep OpenEXR file")
+            .set_syntax("filename")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_checkpoint
+            .add_name("--checkpoint")
+            .set_description("save finished tiles to a checkpoint file as they are rendered")
+            .set_syntax("filename")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_resume
+            .add_name("--resume")
+            .set_description("skip the tiles already saved to the checkpoint file and render the others"));
+
     parser().add_option_handler(
         &m_resolution
             .add_name("--resolution")
@@ -134,6 +173,27 @@ CommandLineHandler::CommandLineHandler()
             .set_syntax("n")
             .set_exact_value_count(1));
 
+    parser().add_option_handler(
+        &m_target_error
+            .add_name("--target-error")
+            .set_description("stop progressive rendering once the estimated relative RMS error falls below a target")
+            .set_syntax("error")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_frame_sequence
+            .add_name("--frame-sequence")
+            .set_description("render a range of frames of a camera animation; '#' characters in file names stand for the frame number")
+            .set_syntax("first last")
+            .set_exact_value_count(2));
+
+    parser().add_option_handler(
+        &m_frame_deltas
+            .add_name("--frame-deltas")
+            .set_description("with --frame-sequence, load the project once and apply the per-frame changes of a delta file")
+            .set_syntax("filename")
+            .set_exact_value_count(1));
+
     parser().add_option_handler(
         &m_override_shading
             .add_name("--override-shading")
@@ -160,6 +220,62 @@ CommandLineHandler::CommandLineHandler()
             .set_syntax("socket")
             .set_exact_value_count(1));
 
+    parser().add_option_handler(
+        &m_shared_memory_display
+            .add_name("--shared-memory")
+            .set_description("publish rendered tiles in a named shared memory segment for external viewers")
+            .set_syntax("name")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_coordinator
+            .add_name("--coordinator")
+            .set_description("distribute the tiles of the frame to workers connecting to a given port")
+            .set_syntax("port")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_worker
+            .add_name("--worker")
+            .set_description("render the tiles handed out by a coordinator")
+            .set_syntax("host port")
+            .set_exact_value_count(2));
+
+    parser().add_option_handler(
+        &m_processes
+            .add_name("--processes")
+            .set_description("render with several processes sharing the scene and the frame buffer (POSIX only)")
+            .set_syntax("count")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_render_server
+            .add_name("--render-server")
+            .set_description("serve render jobs submitted to a given port of the local host, keeping projects loaded between jobs")
+            .set_syntax("port")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_resident_projects
+            .add_name("--resident-projects")
+            .set_description("with --render-server, set the number of projects kept loaded (default is 4)")
+            .set_syntax("count")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_submit
+            .add_name("--submit")
+            .set_description("submit the project to a render server instead of rendering it; --output, --parameter and --frame-deltas are forwarded")
+            .set_syntax("host port")
+            .set_exact_value_count(2));
+
+    parser().add_option_handler(
+        &m_stop_server
+            .add_name("--stop-server")
+            .set_description("ask a render server to shut down")
+            .set_syntax("host port")
+            .set_exact_value_count(2));
+
     parser().add_option_handler(
         &m_run_unit_tests
             .add_name("--run-unit-tests")
@@ -176,6 +292,18 @@ CommandLineHandler::CommandLineHandler()
             .set_min_value_count(0)
             .set_max_value_count(1));
 
+    parser().add_option_handler(
+        &m_compare_unit_benchmarks
+            .add_name("--compare-unit-benchmarks")
+            .set_description("compare two directories of unit benchmark results and report significant regressions")
+            .set_syntax("baseline candidate")
+            .set_exact_value_count(2));
+
+    parser().add_option_handler(
+        &m_hardware_counters
+            .add_name("--hardware-counters")
+            .set_description("collect hardware performance counters while running unit benchmarks (Linux only)"));
+
     parser().add_option_handler(
         &m_verbose_unit_tests
             .add_name("--verbose-unit-tests")
@@ -185,7 +313,29 @@ CommandLineHandler::CommandLineHandler()
     parser().add_option_handler(
         &m_benchmark_mode
             .add_name("--benchmark-mode")
+            .add_name("--benchmark")
             .set_description("enable benchmark mode"));
+
+    parser().add_option_handler(
+        &m_benchmark_runs
+            .add_name("--benchmark-runs")
+            .set_description("set the number of warm-up and measured renders in benchmark mode")
+            .set_syntax("warmup measured")
+            .set_exact_value_count(2));
+
+    parser().add_option_handler(
+        &m_benchmark_report
+            .add_name("--benchmark-report")
+            .set_description("write the results of benchmark mode to a JSON file")
+            .set_syntax("filename")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_trace_events
+            .add_name("--trace-events")
+            .set_description("record the timeline of jobs, tree builds and texture loads to a Chrome trace file")
+            .set_syntax("filename")
+            .set_exact_value_count(1));
 }
 
 void CommandLineHandler::print_program_usage(
@@ -63,27 +63,54 @@ class CommandLineHandler
     foundation::FlagOptionHandler                   m_display_output;
 #endif
     foundation::FlagOptionHandler                   m_disable_autosave;
+    foundation::FlagOptionHandler                   m_deduplicate_meshes;
+    foundation::FlagOptionHandler                   m_fast_load;
+    foundation::FlagOptionHandler                   m_async_logging;
 
     // Aliases for rendering options.
     foundation::ValueOptionHandler<std::string>     m_threads;  // std::string because we need to handle 'auto'
     foundation::ValueOptionHandler<std::string>     m_output;
     foundation::FlagOptionHandler                   m_continuous_saving;
+    foundation::FlagOptionHandler                   m_streaming_output;
+    foundation::ValueOptionHandler<std::string>     m_deep_output;
+    foundation::ValueOptionHandler<std::string>     m_checkpoint;
+    foundation::FlagOptionHandler                   m_resume;
     foundation::ValueOptionHandler<int>             m_resolution;
     foundation::ValueOptionHandler<int>             m_window;
     foundation::ValueOptionHandler<int>             m_samples;
     foundation::ValueOptionHandler<int>             m_passes;
+    foundation::ValueOptionHandler<double>          m_target_error;
+    foundation::ValueOptionHandler<int>             m_frame_sequence;
+    foundation::ValueOptionHandler<std::string>     m_frame_deltas;
     foundation::ValueOptionHandler<std::string>     m_override_shading;
     foundation::ValueOptionHandler<std::string>     m_select_object_instances;
 
     // Houdini-related options.
     foundation::FlagOptionHandler                   m_mplay_display;
     foundation::ValueOptionHandler<int>             m_hrmanpipe_display;
+    foundation::ValueOptionHandler<std::string>     m_shared_memory_display;
+
+    // Distributed rendering options.
+    foundation::ValueOptionHandler<int>             m_coordinator;
+    foundation::ValueOptionHandler<std::string>     m_worker;
+    foundation::ValueOptionHandler<int>             m_processes;
+
+    // Render server options.
+    foundation::ValueOptionHandler<int>             m_render_server;
+    foundation::ValueOptionHandler<int>             m_resident_projects;
+    foundation::ValueOptionHandler<std::string>     m_submit;
+    foundation::ValueOptionHandler<std::string>     m_stop_server;
 
     // Developer-oriented options.
     foundation::ValueOptionHandler<std::string>     m_run_unit_tests;
     foundation::ValueOptionHandler<std::string>     m_run_unit_benchmarks;
+    foundation::ValueOptionHandler<std::string>     m_compare_unit_benchmarks;
+    foundation::FlagOptionHandler                   m_hardware_counters;
     foundation::FlagOptionHandler                   m_verbose_unit_tests;
     foundation::FlagOptionHandler                   m_benchmark_mode;
+    foundation::ValueOptionHandler<int>             m_benchmark_runs;
+    foundation::ValueOptionHandler<std::string>     m_benchmark_report;
+    foundation::ValueOptionHandler<std::string>     m_trace_events;
 
     // Constructor.
     CommandLineHandler();
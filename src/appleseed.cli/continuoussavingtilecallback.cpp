@@ -37,11 +37,12 @@
 #include "renderer/api/frame.h"
 
 // appleseed.foundation headers.
-#include "foundation/image/image.h"
-#include "foundation/image/imageattributes.h"
 #include "foundation/platform/thread.h"
+#include "foundation/utility/log.h"
 
 // Boost headers.
+#include "boost/bind.hpp"
+#include "boost/date_time/posix_time/posix_time_types.hpp"
 #include "boost/filesystem/operations.hpp"
 #include "boost/random/mersenne_twister.hpp"
 #include "boost/uuid/random_generator.hpp"
@@ -62,44 +63,140 @@ namespace appleseed {
 namespace cli {
 
 //
-// ContinuousSavingTileCallback.
+// ContinuousSavingTileCallback class implementation.
+//
+// Render threads only record that the frame changed; a writer thread saves the frame
+// at most once per interval, so that all the tiles finished in the meantime are
+// written at once and rendering never waits for image I/O.
 //
 
-namespace
+class ContinuousSavingTileCallback
+  : public ProgressTileCallback
 {
-    class ContinuousSavingTileCallback
-      : public ProgressTileCallback
+  public:
+    ContinuousSavingTileCallback(
+        const string&   output_path,
+        const double    min_save_interval,
+        Logger&         logger)
+      : ProgressTileCallback(logger)
+      , m_output_path(output_path)
+      , m_min_save_interval(
+            posix_time::milliseconds(static_cast<long>(min_save_interval * 1000.0)))
+      , m_frame(0)
+      , m_pending_tile_count(0)
+      , m_abort(false)
+    {
+        boost::mt19937 rng(static_cast<uint32_t>(time(0)));
+        const uuids::uuid u = uuids::basic_random_generator<boost::mt19937>(&rng)();
+        const bf::path ext = m_output_path.extension();
+        const string tmp_filename = uuids::to_string(u) + ext.string();
+
+        m_tmp_output_path = m_output_path.parent_path() / tmp_filename;
+
+        m_writer_thread = boost::thread(boost::bind(&ContinuousSavingTileCallback::run, this));
+    }
+
+    ~ContinuousSavingTileCallback()
+    {
+        finish();
+    }
+
+    void finish()
+    {
+        // Save the tiles that were finished since the last save, then stop the writer thread.
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_abort = true;
+            m_pending_tile_changed.notify_one();
+        }
+
+        if (m_writer_thread.joinable())
+            m_writer_thread.join();
+    }
+
+  private:
+    const bf::path                      m_output_path;
+    const posix_time::time_duration     m_min_save_interval;
+    bf::path                            m_tmp_output_path;
+    boost::thread                       m_writer_thread;
+
+    // Protected by m_mutex.
+    boost::mutex                        m_mutex;
+    boost::condition_variable           m_pending_tile_changed;
+    const Frame*                        m_frame;
+    size_t                              m_pending_tile_count;
+    bool                                m_abort;
+
+    virtual void do_post_render_tile(
+        const Frame*    frame,
+        const size_t    tile_x,
+        const size_t    tile_y) APPLESEED_OVERRIDE
     {
-      public:
-        ContinuousSavingTileCallback(const string& output_path, Logger& logger)
-          : ProgressTileCallback(logger)
-          , m_output_path(output_path)
+        ProgressTileCallback::do_post_render_tile(frame, tile_x, tile_y);
+
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_frame = frame;
+        if (m_pending_tile_count++ == 0)
+            m_pending_tile_changed.notify_one();
+    }
+
+    void run()
+    {
+        set_current_thread_name("continuous_saving");
+
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        while (true)
         {
-            boost::mt19937 rng(static_cast<uint32_t>(time(0)));
-            const uuids::uuid u = uuids::basic_random_generator<boost::mt19937>(&rng)();
-            const bf::path ext = m_output_path.extension();
-            const string tmp_filename = uuids::to_string(u) + ext.string();
+            // Wait until a tile is finished.
+            while (m_pending_tile_count == 0 && !m_abort)
+                m_pending_tile_changed.wait(lock);
+
+            if (m_pending_tile_count == 0)
+                break;
+
+            // Let more tiles finish before saving, unless rendering is over.
+            const system_time deadline = get_system_time() + m_min_save_interval;
+            while (!m_abort && get_system_time() < deadline)
+                m_pending_tile_changed.timed_wait(lock, deadline);
+
+            const Frame* frame = m_frame;
+            const size_t tile_count = m_pending_tile_count;
+            m_pending_tile_count = 0;
 
-            m_tmp_output_path = m_output_path.parent_path() / tmp_filename;
+            lock.unlock();
+            save(*frame, tile_count);
+            lock.lock();
         }
+    }
 
-      private:
-        boost::mutex        m_mutex;
-        bf::path            m_output_path;
-        bf::path            m_tmp_output_path;
+    void save(const Frame& frame, const size_t tile_count)
+    {
+        if (!frame.write_main_image(m_tmp_output_path.string().c_str()))
+            return;
 
-        virtual void do_post_render_tile(
-            const Frame*    frame,
-            const size_t    tile_x,
-            const size_t    tile_y) APPLESEED_OVERRIDE
+        try
         {
-            boost::mutex::scoped_lock lock(m_mutex);
-            ProgressTileCallback::do_post_render_tile(frame, tile_x, tile_y);
-            frame->write_main_image(m_tmp_output_path.string().c_str());
             bf::rename(m_tmp_output_path, m_output_path);
         }
-    };
-}
+        catch (const bf::filesystem_error& e)
+        {
+            LOG_ERROR(
+                m_logger,
+                "could not save %s: %s.",
+                m_output_path.string().c_str(),
+                e.what());
+            return;
+        }
+
+        LOG_DEBUG(
+            m_logger,
+            "saved %s with " FMT_SIZE_T " new tile%s.",
+            m_output_path.string().c_str(),
+            tile_count,
+            tile_count > 1 ? "s" : "");
+    }
+};
 
 
 //
@@ -108,8 +205,13 @@ namespace
 
 ContinuousSavingTileCallbackFactory::ContinuousSavingTileCallbackFactory(
     const string&   output_path,
+    const double    min_save_interval,
     Logger&         logger)
-  : m_callback(new ContinuousSavingTileCallback(output_path, logger))
+  : m_callback(new ContinuousSavingTileCallback(output_path, min_save_interval, logger))
+{
+}
+
+ContinuousSavingTileCallbackFactory::~ContinuousSavingTileCallbackFactory()
 {
 }
 
@@ -123,5 +225,10 @@ ITileCallback* ContinuousSavingTileCallbackFactory::create()
     return m_callback.get();
 }
 
+void ContinuousSavingTileCallbackFactory::finish()
+{
+    m_callback->finish();
+}
+
 }   // namespace cli
 }   // namespace appleseed
@@ -46,20 +46,33 @@ namespace foundation    { class Logger; }
 namespace appleseed {
 namespace cli {
 
+class ContinuousSavingTileCallback;
+
+//
+// Saves the main image of the frame every time tiles are finished, waiting at least
+// 'min_save_interval' seconds between two saves. Saving happens on a dedicated thread.
+//
+
 class ContinuousSavingTileCallbackFactory
   : public renderer::ITileCallbackFactory
 {
   public:
     ContinuousSavingTileCallbackFactory(
         const std::string&  output_path,
+        const double        min_save_interval,
         foundation::Logger& logger);
 
+    ~ContinuousSavingTileCallbackFactory();
+
     virtual void release() APPLESEED_OVERRIDE;
 
     virtual renderer::ITileCallback* create() APPLESEED_OVERRIDE;
 
+    // Save the tiles finished since the last save and stop saving.
+    void finish();
+
   private:
-    std::auto_ptr<renderer::ITileCallback> m_callback;
+    std::auto_ptr<ContinuousSavingTileCallback> m_callback;
 };
 
 }       // namespace cli
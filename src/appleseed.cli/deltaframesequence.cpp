@@ -0,0 +1,264 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "deltaframesequence.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/camera.h"
+#include "renderer/api/project.h"
+#include "renderer/api/scene.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/matrix.h"
+#include "foundation/utility/log.h"
+#include "foundation/utility/otherwise.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <algorithm>
+#include <fstream>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+namespace appleseed {
+namespace cli {
+
+//
+// DeltaFrameSequence class implementation.
+//
+
+namespace
+{
+    bool parse_transform(
+        const vector<string>&   tokens,
+        const size_t            first,
+        Transformd&             transform)
+    {
+        if (tokens.size() != first + 16)
+            return false;
+
+        Matrix4d m;
+
+        try
+        {
+            for (size_t i = 0; i < 16; ++i)
+                m[i] = from_string<double>(tokens[first + i]);
+        }
+        catch (const ExceptionStringConversionError&)
+        {
+            return false;
+        }
+
+        transform = Transformd::from_local_to_parent(m);
+
+        return true;
+    }
+
+    struct DeltaFrameLess
+    {
+        template <typename Delta>
+        bool operator()(const Delta& lhs, const Delta& rhs) const
+        {
+            return lhs.m_frame < rhs.m_frame;
+        }
+    };
+}
+
+DeltaFrameSequence::DeltaFrameSequence(
+    const string&       output_pattern,
+    const bool          output_aovs,
+    const size_t        first_frame,
+    const size_t        last_frame,
+    Logger&             logger)
+  : FrameSequenceBase(output_pattern, output_aovs, first_frame, last_frame, logger)
+  , m_next_delta(0)
+{
+}
+
+bool DeltaFrameSequence::read(const char* filepath)
+{
+    ifstream file(filepath);
+
+    if (!file.is_open())
+    {
+        LOG_ERROR(m_logger, "could not open delta file %s.", filepath);
+        return false;
+    }
+
+    m_deltas.clear();
+    m_next_delta = 0;
+
+    size_t frame = 0;
+    size_t line_number = 0;
+    string line;
+
+    while (getline(file, line))
+    {
+        ++line_number;
+
+        vector<string> tokens;
+        tokenize(line, " \t\r", tokens);
+
+        if (tokens.empty() || tokens[0][0] == '#')
+            continue;
+
+        Delta delta;
+        bool valid = false;
+
+        if (tokens[0] == "frame" && tokens.size() == 2)
+        {
+            try
+            {
+                frame = from_string<size_t>(tokens[1]);
+                continue;
+            }
+            catch (const ExceptionStringConversionError&)
+            {
+            }
+        }
+        else if (tokens[0] == "camera_transform")
+        {
+            delta.m_type = Delta::CameraTransform;
+            valid = parse_transform(tokens, 1, delta.m_transform);
+        }
+        else if (tokens[0] == "camera_parameter" && tokens.size() >= 3)
+        {
+            delta.m_type = Delta::CameraParameter;
+            delta.m_name = tokens[1];
+            delta.m_value = tokens[2];
+            for (size_t i = 3; i < tokens.size(); ++i)
+                delta.m_value += ' ' + tokens[i];
+            valid = true;
+        }
+        else if (tokens[0] == "assembly_instance_transform" && tokens.size() >= 2)
+        {
+            delta.m_type = Delta::AssemblyInstanceTransform;
+            delta.m_name = tokens[1];
+            valid = parse_transform(tokens, 2, delta.m_transform);
+        }
+
+        if (!valid)
+        {
+            LOG_ERROR(
+                m_logger,
+                "%s, line " FMT_SIZE_T ": invalid delta \"%s\".",
+                filepath,
+                line_number,
+                trim_both(line).c_str());
+            return false;
+        }
+
+        delta.m_frame = frame;
+        m_deltas.push_back(delta);
+    }
+
+    // Keep the order of the deltas of a given frame.
+    stable_sort(m_deltas.begin(), m_deltas.end(), DeltaFrameLess());
+
+    return true;
+}
+
+bool DeltaFrameSequence::on_frame_begin(
+    Project&            project,
+    const size_t        frame_index)
+{
+    const size_t frame = print_frame_begin(frame_index);
+
+    // Apply the changes of all frames up to this one, in order.
+    while (m_next_delta < m_deltas.size() && m_deltas[m_next_delta].m_frame <= frame)
+    {
+        if (!apply(project, m_deltas[m_next_delta]))
+            return false;
+
+        ++m_next_delta;
+    }
+
+    return true;
+}
+
+bool DeltaFrameSequence::apply(
+    Project&            project,
+    const Delta&        delta) const
+{
+    switch (delta.m_type)
+    {
+      case Delta::CameraTransform:
+      case Delta::CameraParameter:
+        {
+            Camera* camera = project.get_uncached_active_camera();
+
+            if (camera == 0)
+            {
+                LOG_ERROR(m_logger, "no active camera in project.");
+                return false;
+            }
+
+            if (delta.m_type == Delta::CameraTransform)
+            {
+                camera->transform_sequence().clear();
+                camera->transform_sequence().set_transform(0.0f, delta.m_transform);
+            }
+            else camera->get_parameters().insert_path(delta.m_name, delta.m_value);
+        }
+        return true;
+
+      case Delta::AssemblyInstanceTransform:
+        {
+            AssemblyInstance* assembly_instance =
+                project.get_scene()->assembly_instances().get_by_name(delta.m_name.c_str());
+
+            if (assembly_instance == 0)
+            {
+                LOG_ERROR(m_logger, "assembly instance \"%s\" not found.", delta.m_name.c_str());
+                return false;
+            }
+
+            const Assembly* assembly = assembly_instance->find_assembly();
+            if (assembly && !assembly->lights().empty())
+            {
+                LOG_WARNING(
+                    m_logger,
+                    "assembly instance \"%s\" contains lights, which will not move.",
+                    delta.m_name.c_str());
+            }
+
+            assembly_instance->transform_sequence().clear();
+            assembly_instance->transform_sequence().set_transform(0.0f, delta.m_transform);
+        }
+        return true;
+
+      assert_otherwise;
+    }
+
+    return false;
+}
+
+}   // namespace cli
+}   // namespace appleseed
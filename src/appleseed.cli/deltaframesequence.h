@@ -0,0 +1,116 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_CLI_DELTAFRAMESEQUENCE_H
+#define APPLESEED_CLI_DELTAFRAMESEQUENCE_H
+
+// appleseed.cli headers.
+#include "framesequencebase.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/transform.h"
+#include "foundation/platform/compiler.h"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class Logger; }
+namespace renderer      { class Project; }
+
+namespace appleseed {
+namespace cli {
+
+//
+// A frame sequence that applies the changes described in a delta file to the
+// project before each frame, without reloading it.
+//
+// A delta file is a text file with one change per line. Blank lines and lines
+// starting with '#' are ignored. Changes apply to the frame declared by the last
+// 'frame' line and remain in effect for the following frames:
+//
+//   frame <number>
+//   camera_transform <16 values>
+//   camera_parameter <name> <value>
+//   assembly_instance_transform <assembly instance name> <16 values>
+//
+// Transforms are local-to-parent matrices given in row-major order. Assembly
+// instances are looked up among the assembly instances of the scene. Moving
+// assembly instances that contain lights or light-emitting objects is not
+// supported since the light sampler is built for the first frame.
+//
+
+class DeltaFrameSequence
+  : public FrameSequenceBase
+{
+  public:
+    // Constructor. 'output_pattern' may be empty if frames should not be written.
+    DeltaFrameSequence(
+        const std::string&          output_pattern,
+        const bool                  output_aovs,
+        const size_t                first_frame,
+        const size_t                last_frame,
+        foundation::Logger&         logger);
+
+    // Read a delta file. Return true on success.
+    bool read(const char* filepath);
+
+    virtual bool on_frame_begin(
+        renderer::Project&          project,
+        const size_t                frame_index) APPLESEED_OVERRIDE;
+
+  private:
+    struct Delta
+    {
+        enum Type
+        {
+            CameraTransform,
+            CameraParameter,
+            AssemblyInstanceTransform
+        };
+
+        size_t                      m_frame;
+        Type                        m_type;
+        std::string                 m_name;
+        std::string                 m_value;
+        foundation::Transformd      m_transform;
+    };
+
+    std::vector<Delta>              m_deltas;           // sorted by frame
+    size_t                          m_next_delta;       // index of the first delta not applied yet
+
+    bool apply(
+        renderer::Project&          project,
+        const Delta&                delta) const;
+};
+
+}       // namespace cli
+}       // namespace appleseed
+
+#endif  // !APPLESEED_CLI_DELTAFRAMESEQUENCE_H
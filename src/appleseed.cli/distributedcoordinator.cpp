@@ -0,0 +1,536 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "distributedcoordinator.h"
+
+// appleseed.cli headers.
+#include "distributedprotocol.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/frame.h"
+#include "renderer/api/rendering.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/image/tile.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/log.h"
+#include "foundation/utility/string.h"
+
+// Boost headers.
+#include "boost/asio/buffer.hpp"
+#include "boost/asio/io_service.hpp"
+#include "boost/asio/ip/tcp.hpp"
+#include "boost/asio/placeholders.hpp"
+#include "boost/asio/read.hpp"
+#include "boost/bind.hpp"
+#include "boost/enable_shared_from_this.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/system/error_code.hpp"
+#include "boost/system/system_error.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+namespace asio = boost::asio;
+using boost::asio::ip::tcp;
+
+namespace appleseed {
+namespace cli {
+
+namespace
+{
+    // Messages larger than this are considered malformed.
+    const uint32 MaxPayloadSize = 256 * 1024 * 1024;
+
+    class Coordinator;
+
+    //
+    // A connection to a worker.
+    //
+    // Incoming messages are read asynchronously. Outgoing messages are small
+    // and are written synchronously.
+    //
+
+    class WorkerConnection
+      : public boost::enable_shared_from_this<WorkerConnection>
+    {
+      public:
+        WorkerConnection(
+            Coordinator&        coordinator,
+            asio::io_service&   io_service,
+            const size_t        id)
+          : m_is_accepted(false)
+          , m_is_waiting(false)
+          , m_coordinator(coordinator)
+          , m_socket(io_service)
+          , m_id(id)
+          , m_is_closed(false)
+        {
+        }
+
+        tcp::socket& get_socket()
+        {
+            return m_socket;
+        }
+
+        size_t get_id() const
+        {
+            return m_id;
+        }
+
+        // Start reading messages.
+        void start()
+        {
+            read_header();
+        }
+
+        // Send a message. Return false if the connection is lost.
+        bool send(const DistributedMessage& message)
+        {
+            try
+            {
+                send_message(m_socket, message);
+                return true;
+            }
+            catch (const boost::system::system_error&)
+            {
+                return false;
+            }
+        }
+
+        void close()
+        {
+            m_is_closed = true;
+
+            boost::system::error_code error;
+            m_socket.shutdown(tcp::socket::shutdown_both, error);
+            m_socket.close(error);
+        }
+
+        bool            m_is_accepted;      // did the worker send a valid hello message?
+        bool            m_is_waiting;       // is the worker waiting for a tile?
+        set<size_t>     m_assigned_tiles;   // indices of the tiles the worker is rendering
+
+      private:
+        Coordinator&        m_coordinator;
+        tcp::socket         m_socket;
+        const size_t        m_id;
+        bool                m_is_closed;
+        uint8               m_header[DistributedMessageHeaderSize];
+        DistributedMessage  m_message;
+
+        void read_header();
+
+        void handle_header(const boost::system::error_code& error);
+
+        void handle_payload(const boost::system::error_code& error);
+    };
+
+    typedef boost::shared_ptr<WorkerConnection> WorkerConnectionPtr;
+
+
+    //
+    // The coordinator of a distributed render.
+    //
+
+    class Coordinator
+      : public NonCopyable
+    {
+      public:
+        Coordinator(
+            const Frame&                        frame,
+            const TileJobFactory::TileOrdering  tile_ordering,
+            ITileCallback*                      tile_callback,
+            Logger&                             logger)
+          : m_frame(frame)
+          , m_tile_callback(tile_callback)
+          , m_logger(logger)
+          , m_acceptor(m_io_service)
+          , m_remaining_tile_count(0)
+          , m_next_worker_id(1)
+        {
+            const CanvasProperties& props = m_frame.image().properties();
+
+            // Retrieve the tiles in the requested order.
+            vector<size_t> tiles;
+            TileJobFactory tile_job_factory;
+            tile_job_factory.generate_tile_ordering(props, tile_ordering, tiles);
+
+            // Only hand out the tiles that intersect the crop window.
+            const AABB2u& crop_window = m_frame.get_crop_window();
+            for (size_t i = 0; i < tiles.size(); ++i)
+            {
+                const size_t tile_x = tiles[i] % props.m_tile_count_x;
+                const size_t tile_y = tiles[i] / props.m_tile_count_x;
+
+                AABB2u tile_bbox;
+                tile_bbox.min.x = tile_x * props.m_tile_width;
+                tile_bbox.min.y = tile_y * props.m_tile_height;
+                tile_bbox.max.x = min(tile_bbox.min.x + props.m_tile_width, props.m_canvas_width) - 1;
+                tile_bbox.max.y = min(tile_bbox.min.y + props.m_tile_height, props.m_canvas_height) - 1;
+
+                if (AABB2u::overlap(tile_bbox, crop_window))
+                    m_pending_tiles.push_back(tiles[i]);
+            }
+
+            m_completed_tiles.assign(props.m_tile_count, false);
+            m_remaining_tile_count = m_pending_tiles.size();
+        }
+
+        bool run(const unsigned short port)
+        {
+            if (m_remaining_tile_count == 0)
+                return true;
+
+            try
+            {
+                const tcp::endpoint endpoint(tcp::v4(), port);
+                m_acceptor.open(endpoint.protocol());
+                m_acceptor.set_option(tcp::acceptor::reuse_address(true));
+                m_acceptor.bind(endpoint);
+                m_acceptor.listen();
+            }
+            catch (const boost::system::system_error& e)
+            {
+                LOG_ERROR(m_logger, "could not listen on port %u: %s.", static_cast<unsigned int>(port), e.what());
+                return false;
+            }
+
+            LOG_INFO(
+                m_logger,
+                "waiting for workers on port %u, %s tile%s to render...",
+                static_cast<unsigned int>(port),
+                pretty_uint(m_remaining_tile_count).c_str(),
+                m_remaining_tile_count > 1 ? "s" : "");
+
+            accept();
+            m_io_service.run();
+
+            return true;
+        }
+
+        void on_message(WorkerConnection& worker, const DistributedMessage& message)
+        {
+            if (!worker.m_is_accepted)
+            {
+                if (message.m_type == HelloMessage && check_frame_layout(m_frame, message))
+                {
+                    worker.m_is_accepted = true;
+                    if (worker.send(DistributedMessage(WelcomeMessage)))
+                        LOG_INFO(m_logger, "worker #%s joined.", pretty_uint(worker.get_id()).c_str());
+                    else on_worker_left(worker);
+                }
+                else
+                {
+                    LOG_WARNING(
+                        m_logger,
+                        "rejected worker #%s: protocol version or frame layout mismatch.",
+                        pretty_uint(worker.get_id()).c_str());
+                    remove_worker(worker);
+                }
+
+                return;
+            }
+
+            switch (message.m_type)
+            {
+              case TileRequestMessage:
+                worker.m_is_waiting = true;
+                serve_waiting_workers();
+                break;
+
+              case TileDataMessage:
+                {
+                    size_t tile_x, tile_y;
+                    if (read_tile(message, m_frame, tile_x, tile_y))
+                        on_tile_received(worker, tile_x, tile_y);
+                    else
+                    {
+                        LOG_WARNING(m_logger, "received a malformed tile from worker #%s.", pretty_uint(worker.get_id()).c_str());
+                        on_worker_left(worker);
+                    }
+                }
+                break;
+
+              default:
+                LOG_WARNING(m_logger, "received an unexpected message from worker #%s.", pretty_uint(worker.get_id()).c_str());
+                on_worker_left(worker);
+                break;
+            }
+        }
+
+        void on_worker_left(WorkerConnection& worker)
+        {
+            if (find_worker(worker) == m_workers.end())
+                return;
+
+            // Hand out the tiles of the worker again, before any other tile.
+            const size_t lost_tile_count = worker.m_assigned_tiles.size();
+            m_pending_tiles.insert(
+                m_pending_tiles.begin(),
+                worker.m_assigned_tiles.begin(),
+                worker.m_assigned_tiles.end());
+            worker.m_assigned_tiles.clear();
+
+            if (worker.m_is_accepted)
+            {
+                if (lost_tile_count > 0)
+                {
+                    LOG_INFO(
+                        m_logger,
+                        "worker #%s left, handing out its %s tile%s again.",
+                        pretty_uint(worker.get_id()).c_str(),
+                        pretty_uint(lost_tile_count).c_str(),
+                        lost_tile_count > 1 ? "s" : "");
+                }
+                else LOG_INFO(m_logger, "worker #%s left.", pretty_uint(worker.get_id()).c_str());
+            }
+
+            remove_worker(worker);
+            serve_waiting_workers();
+        }
+
+      private:
+        const Frame&                    m_frame;
+        ITileCallback*                  m_tile_callback;
+        Logger&                         m_logger;
+        asio::io_service                m_io_service;
+        tcp::acceptor                   m_acceptor;
+        deque<size_t>                   m_pending_tiles;            // tiles not assigned to any worker
+        vector<bool>                    m_completed_tiles;
+        size_t                          m_remaining_tile_count;     // tiles not received yet
+        size_t                          m_next_worker_id;
+        vector<WorkerConnectionPtr>     m_workers;
+
+        void accept()
+        {
+            const WorkerConnectionPtr worker(
+                new WorkerConnection(*this, m_io_service, m_next_worker_id++));
+
+            m_acceptor.async_accept(
+                worker->get_socket(),
+                boost::bind(&Coordinator::handle_accept, this, worker, asio::placeholders::error));
+        }
+
+        void handle_accept(const WorkerConnectionPtr& worker, const boost::system::error_code& error)
+        {
+            // The acceptor was closed once all tiles were rendered.
+            if (!m_acceptor.is_open())
+                return;
+
+            if (!error)
+            {
+                m_workers.push_back(worker);
+                worker->start();
+            }
+
+            accept();
+        }
+
+        vector<WorkerConnectionPtr>::iterator find_worker(const WorkerConnection& worker)
+        {
+            for (vector<WorkerConnectionPtr>::iterator i = m_workers.begin(); i != m_workers.end(); ++i)
+            {
+                if (i->get() == &worker)
+                    return i;
+            }
+
+            return m_workers.end();
+        }
+
+        void remove_worker(WorkerConnection& worker)
+        {
+            // Keep the connection alive until this function returns.
+            const WorkerConnectionPtr keep_alive = worker.shared_from_this();
+
+            const vector<WorkerConnectionPtr>::iterator i = find_worker(worker);
+            if (i != m_workers.end())
+                m_workers.erase(i);
+
+            worker.close();
+        }
+
+        void serve_waiting_workers()
+        {
+            // Iterate over a copy since workers may get removed.
+            const vector<WorkerConnectionPtr> workers(m_workers);
+
+            for (size_t i = 0; i < workers.size() && !m_pending_tiles.empty(); ++i)
+            {
+                WorkerConnection& worker = *workers[i];
+
+                if (!worker.m_is_waiting)
+                    continue;
+
+                const size_t tile_index = m_pending_tiles.front();
+                m_pending_tiles.pop_front();
+
+                worker.m_is_waiting = false;
+                worker.m_assigned_tiles.insert(tile_index);
+
+                const CanvasProperties& props = m_frame.image().properties();
+                const size_t tile_x = tile_index % props.m_tile_count_x;
+                const size_t tile_y = tile_index / props.m_tile_count_x;
+
+                DistributedMessage message(TileAssignmentMessage);
+                message.append_uint32(static_cast<uint32>(tile_x));
+                message.append_uint32(static_cast<uint32>(tile_y));
+
+                if (!worker.send(message))
+                {
+                    on_worker_left(worker);
+                    return;
+                }
+
+                if (m_tile_callback)
+                {
+                    const Tile& tile = m_frame.image().tile(tile_x, tile_y);
+                    m_tile_callback->pre_render(
+                        tile_x * props.m_tile_width,
+                        tile_y * props.m_tile_height,
+                        tile.get_width(),
+                        tile.get_height());
+                }
+            }
+        }
+
+        void on_tile_received(WorkerConnection& worker, const size_t tile_x, const size_t tile_y)
+        {
+            const size_t tile_index = tile_y * m_frame.image().properties().m_tile_count_x + tile_x;
+
+            // Ignore tiles that were not assigned to this worker.
+            if (worker.m_assigned_tiles.erase(tile_index) == 0 || m_completed_tiles[tile_index])
+                return;
+
+            m_completed_tiles[tile_index] = true;
+            --m_remaining_tile_count;
+
+            if (m_tile_callback)
+                m_tile_callback->post_render_tile(&m_frame, tile_x, tile_y);
+
+            if (m_remaining_tile_count == 0)
+                finish();
+        }
+
+        void finish()
+        {
+            boost::system::error_code error;
+            m_acceptor.close(error);
+
+            // Tell all workers to stop, whether they are waiting for a tile or not.
+            const vector<WorkerConnectionPtr> workers(m_workers);
+            for (size_t i = 0; i < workers.size(); ++i)
+            {
+                workers[i]->send(DistributedMessage(NoMoreTilesMessage));
+                remove_worker(*workers[i]);
+            }
+
+            m_io_service.stop();
+        }
+    };
+
+
+    //
+    // WorkerConnection class implementation.
+    //
+
+    void WorkerConnection::read_header()
+    {
+        asio::async_read(
+            m_socket,
+            asio::buffer(m_header, sizeof(m_header)),
+            boost::bind(&WorkerConnection::handle_header, shared_from_this(), asio::placeholders::error));
+    }
+
+    void WorkerConnection::handle_header(const boost::system::error_code& error)
+    {
+        if (m_is_closed)
+            return;
+
+        uint32 payload_size = 0;
+        if (!error)
+            DistributedMessage::decode_header(m_header, m_message.m_type, payload_size);
+
+        if (error || payload_size > MaxPayloadSize)
+        {
+            m_coordinator.on_worker_left(*this);
+            return;
+        }
+
+        m_message.m_payload.resize(payload_size);
+
+        asio::async_read(
+            m_socket,
+            asio::buffer(m_message.m_payload),
+            boost::bind(&WorkerConnection::handle_payload, shared_from_this(), asio::placeholders::error));
+    }
+
+    void WorkerConnection::handle_payload(const boost::system::error_code& error)
+    {
+        if (m_is_closed)
+            return;
+
+        if (error)
+        {
+            m_coordinator.on_worker_left(*this);
+            return;
+        }
+
+        m_coordinator.on_message(*this, m_message);
+
+        if (!m_is_closed)
+            read_header();
+    }
+}
+
+bool coordinate_distributed_render(
+    const Frame&                        frame,
+    const unsigned short                port,
+    const TileJobFactory::TileOrdering  tile_ordering,
+    ITileCallback*                      tile_callback,
+    Logger&                             logger)
+{
+    Coordinator coordinator(frame, tile_ordering, tile_callback, logger);
+    return coordinator.run(port);
+}
+
+}   // namespace cli
+}   // namespace appleseed
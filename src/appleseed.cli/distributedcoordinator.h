@@ -0,0 +1,57 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_CLI_DISTRIBUTEDCOORDINATOR_H
+#define APPLESEED_CLI_DISTRIBUTEDCOORDINATOR_H
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/generic/tilejobfactory.h"
+
+// Forward declarations.
+namespace foundation    { class Logger; }
+namespace renderer      { class Frame; }
+namespace renderer      { class ITileCallback; }
+
+namespace appleseed {
+namespace cli {
+
+// Coordinate a distributed render: hand out the tiles of a frame, in a given order,
+// to the workers that connect to a given TCP port, and store the tiles they send
+// back into the frame. Workers may join and leave at any time; the tiles held by
+// a worker that leaves are handed out again. 'tile_callback' may be 0.
+// Return true once all tiles are rendered, false if the coordinator could not start.
+bool coordinate_distributed_render(
+    const renderer::Frame&                          frame,
+    const unsigned short                            port,
+    const renderer::TileJobFactory::TileOrdering    tile_ordering,
+    renderer::ITileCallback*                        tile_callback,
+    foundation::Logger&                             logger);
+
+}       // namespace cli
+}       // namespace appleseed
+
+#endif  // !APPLESEED_CLI_DISTRIBUTEDCOORDINATOR_H
@@ -0,0 +1,292 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "distributedprotocol.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/aov.h"
+#include "renderer/api/frame.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/image/tile.h"
+
+// Boost headers.
+#include "boost/asio/buffer.hpp"
+#include "boost/asio/read.hpp"
+#include "boost/asio/write.hpp"
+
+// Standard headers.
+#include <cstring>
+#include <string>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+namespace asio = boost::asio;
+
+namespace appleseed {
+namespace cli {
+
+namespace
+{
+    // Must be incremented every time the protocol changes.
+    const uint32 ProtocolVersion = 1;
+
+    void encode_uint32(const uint32 value, uint8* bytes)
+    {
+        bytes[0] = static_cast<uint8>(value);
+        bytes[1] = static_cast<uint8>(value >> 8);
+        bytes[2] = static_cast<uint8>(value >> 16);
+        bytes[3] = static_cast<uint8>(value >> 24);
+    }
+
+    uint32 decode_uint32(const uint8* bytes)
+    {
+        return
+              static_cast<uint32>(bytes[0])
+            | (static_cast<uint32>(bytes[1]) << 8)
+            | (static_cast<uint32>(bytes[2]) << 16)
+            | (static_cast<uint32>(bytes[3]) << 24);
+    }
+
+    Tile& get_tile(
+        const Frame&    frame,
+        const size_t    image_index,
+        const size_t    tile_x,
+        const size_t    tile_y)
+    {
+        return
+            image_index == 0
+                ? frame.image().tile(tile_x, tile_y)
+                : frame.aov_images().get_image(image_index - 1).tile(tile_x, tile_y);
+    }
+}
+
+
+//
+// DistributedMessage class implementation.
+//
+
+DistributedMessage::DistributedMessage(const uint32 type)
+  : m_type(type)
+{
+}
+
+void DistributedMessage::append_uint32(const uint32 value)
+{
+    uint8 bytes[4];
+    encode_uint32(value, bytes);
+    append_bytes(bytes, sizeof(bytes));
+}
+
+void DistributedMessage::append_bytes(const void* data, const size_t size)
+{
+    const uint8* bytes = static_cast<const uint8*>(data);
+    m_payload.insert(m_payload.end(), bytes, bytes + size);
+}
+
+void DistributedMessage::append_string(const string& value)
+{
+    append_uint32(static_cast<uint32>(value.size()));
+    append_bytes(value.data(), value.size());
+}
+
+bool DistributedMessage::read_uint32(size_t& offset, uint32& value) const
+{
+    if (offset + 4 > m_payload.size())
+        return false;
+
+    value = decode_uint32(&m_payload[offset]);
+    offset += 4;
+
+    return true;
+}
+
+bool DistributedMessage::read_bytes(size_t& offset, void* data, const size_t size) const
+{
+    if (offset + size > m_payload.size())
+        return false;
+
+    if (size > 0)
+        memcpy(data, &m_payload[offset], size);
+    offset += size;
+
+    return true;
+}
+
+bool DistributedMessage::read_string(size_t& offset, string& value) const
+{
+    uint32 size;
+    if (!read_uint32(offset, size) || offset + size > m_payload.size())
+        return false;
+
+    if (size > 0)
+        value.assign(reinterpret_cast<const char*>(&m_payload[offset]), size);
+    else value.clear();
+    offset += size;
+
+    return true;
+}
+
+void DistributedMessage::encode_header(uint8 header[DistributedMessageHeaderSize]) const
+{
+    encode_uint32(m_type, header);
+    encode_uint32(static_cast<uint32>(m_payload.size()), header + 4);
+}
+
+void DistributedMessage::decode_header(
+    const uint8         header[DistributedMessageHeaderSize],
+    uint32&             type,
+    uint32&             payload_size)
+{
+    type = decode_uint32(header);
+    payload_size = decode_uint32(header + 4);
+}
+
+
+//
+// Message transmission.
+//
+
+void send_message(
+    asio::ip::tcp::socket&      socket,
+    const DistributedMessage&   message)
+{
+    uint8 header[DistributedMessageHeaderSize];
+    message.encode_header(header);
+
+    asio::write(socket, asio::buffer(header, sizeof(header)));
+
+    if (!message.m_payload.empty())
+        asio::write(socket, asio::buffer(message.m_payload));
+}
+
+void receive_message(
+    asio::ip::tcp::socket&      socket,
+    DistributedMessage&         message)
+{
+    uint8 header[DistributedMessageHeaderSize];
+    asio::read(socket, asio::buffer(header, sizeof(header)));
+
+    uint32 payload_size;
+    DistributedMessage::decode_header(header, message.m_type, payload_size);
+
+    message.m_payload.resize(payload_size);
+
+    if (payload_size > 0)
+        asio::read(socket, asio::buffer(message.m_payload));
+}
+
+
+//
+// Message payloads.
+//
+
+void append_frame_layout(
+    const Frame&                frame,
+    DistributedMessage&         message)
+{
+    const CanvasProperties& props = frame.image().properties();
+
+    message.append_uint32(ProtocolVersion);
+    message.append_uint32(static_cast<uint32>(props.m_canvas_width));
+    message.append_uint32(static_cast<uint32>(props.m_canvas_height));
+    message.append_uint32(static_cast<uint32>(props.m_tile_width));
+    message.append_uint32(static_cast<uint32>(props.m_tile_height));
+    message.append_uint32(static_cast<uint32>(props.m_channel_count));
+    message.append_uint32(static_cast<uint32>(props.m_pixel_format));
+    message.append_uint32(static_cast<uint32>(frame.aov_images().size()));
+}
+
+bool check_frame_layout(
+    const Frame&                frame,
+    const DistributedMessage&   message)
+{
+    DistributedMessage expected;
+    append_frame_layout(frame, expected);
+
+    return message.m_payload == expected.m_payload;
+}
+
+void append_tile(
+    const Frame&                frame,
+    const size_t                tile_x,
+    const size_t                tile_y,
+    DistributedMessage&         message)
+{
+    message.append_uint32(static_cast<uint32>(tile_x));
+    message.append_uint32(static_cast<uint32>(tile_y));
+
+    for (size_t i = 0, e = frame.aov_images().size(); i <= e; ++i)
+    {
+        const Tile& tile = get_tile(frame, i, tile_x, tile_y);
+        message.append_bytes(tile.get_storage(), tile.get_size());
+    }
+}
+
+bool read_tile(
+    const DistributedMessage&   message,
+    const Frame&                frame,
+    size_t&                     tile_x,
+    size_t&                     tile_y)
+{
+    const CanvasProperties& props = frame.image().properties();
+
+    size_t offset = 0;
+    uint32 x, y;
+
+    if (!message.read_uint32(offset, x) || !message.read_uint32(offset, y))
+        return false;
+
+    if (x >= props.m_tile_count_x || y >= props.m_tile_count_y)
+        return false;
+
+    // Check the size of the payload before modifying the frame.
+    size_t pixel_data_size = 0;
+    for (size_t i = 0, e = frame.aov_images().size(); i <= e; ++i)
+        pixel_data_size += get_tile(frame, i, x, y).get_size();
+
+    if (offset + pixel_data_size != message.m_payload.size())
+        return false;
+
+    for (size_t i = 0, e = frame.aov_images().size(); i <= e; ++i)
+    {
+        Tile& tile = get_tile(frame, i, x, y);
+        message.read_bytes(offset, tile.get_storage(), tile.get_size());
+    }
+
+    tile_x = x;
+    tile_y = y;
+
+    return true;
+}
+
+}   // namespace cli
+}   // namespace appleseed
@@ -0,0 +1,139 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_CLI_DISTRIBUTEDPROTOCOL_H
+#define APPLESEED_CLI_DISTRIBUTEDPROTOCOL_H
+
+// appleseed.foundation headers.
+#include "foundation/platform/types.h"
+
+// Boost headers.
+#include "boost/asio/ip/tcp.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Forward declarations.
+namespace renderer      { class Frame; }
+
+namespace appleseed {
+namespace cli {
+
+//
+// Messages exchanged by the coordinator and the workers of a distributed render,
+// and by a render server and its clients.
+//
+// A message is made of a header, holding the type of the message and the size
+// in bytes of its payload as 32-bit little-endian integers, followed by the
+// payload. Pixels are sent in the pixel format of the frame and in the native
+// byte order, so all the machines of a render must share the same byte order.
+//
+
+enum DistributedMessageType
+{
+    HelloMessage = 1,           // worker -> coordinator: protocol version and frame layout of the worker
+    WelcomeMessage,             // coordinator -> worker: the worker was accepted
+    TileRequestMessage,         // worker -> coordinator: request a tile to render
+    TileAssignmentMessage,      // coordinator -> worker: coordinates of the tile to render
+    NoMoreTilesMessage,         // coordinator -> worker: all tiles are rendered
+    TileDataMessage,            // worker -> coordinator, render server -> client: coordinates and pixels of a rendered tile
+    RenderJobMessage,           // client -> render server: project and settings of a render job
+    JobStartedMessage,          // render server -> client: protocol version and frame layout of the job
+    JobFinishedMessage,         // render server -> client: whether the job succeeded
+    ShutdownMessage             // client -> render server: stop serving
+};
+
+const size_t DistributedMessageHeaderSize = 8;
+
+class DistributedMessage
+{
+  public:
+    foundation::uint32                  m_type;
+    std::vector<foundation::uint8>      m_payload;
+
+    // Constructor.
+    explicit DistributedMessage(const foundation::uint32 type = 0);
+
+    // Append data to the payload.
+    void append_uint32(const foundation::uint32 value);
+    void append_bytes(const void* data, const size_t size);
+    void append_string(const std::string& value);
+
+    // Read data from the payload at a given offset, and advance the offset.
+    // Return false if the payload is too short.
+    bool read_uint32(size_t& offset, foundation::uint32& value) const;
+    bool read_bytes(size_t& offset, void* data, const size_t size) const;
+    bool read_string(size_t& offset, std::string& value) const;
+
+    // Encode the header of this message.
+    void encode_header(foundation::uint8 header[DistributedMessageHeaderSize]) const;
+
+    // Decode a message header.
+    static void decode_header(
+        const foundation::uint8         header[DistributedMessageHeaderSize],
+        foundation::uint32&             type,
+        foundation::uint32&             payload_size);
+};
+
+// Send and receive whole messages. These functions throw boost::system::system_error on failure.
+void send_message(
+    boost::asio::ip::tcp::socket&       socket,
+    const DistributedMessage&           message);
+void receive_message(
+    boost::asio::ip::tcp::socket&       socket,
+    DistributedMessage&                 message);
+
+// Append the protocol version and the layout of a frame to a message.
+void append_frame_layout(
+    const renderer::Frame&              frame,
+    DistributedMessage&                 message);
+
+// Return true if a message holds the protocol version and the layout of a given frame.
+bool check_frame_layout(
+    const renderer::Frame&              frame,
+    const DistributedMessage&           message);
+
+// Append the coordinates and the pixels of a tile of a frame (main image and AOVs) to a message.
+void append_tile(
+    const renderer::Frame&              frame,
+    const size_t                        tile_x,
+    const size_t                        tile_y,
+    DistributedMessage&                 message);
+
+// Copy the pixels of a tile held by a message into a frame. Return false if the message is malformed.
+bool read_tile(
+    const DistributedMessage&           message,
+    const renderer::Frame&              frame,
+    size_t&                             tile_x,
+    size_t&                             tile_y);
+
+}       // namespace cli
+}       // namespace appleseed
+
+#endif  // !APPLESEED_CLI_DISTRIBUTEDPROTOCOL_H
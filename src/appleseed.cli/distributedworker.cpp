@@ -0,0 +1,367 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "distributedworker.h"
+
+// appleseed.cli headers.
+#include "distributedprotocol.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/frame.h"
+#include "renderer/api/rendering.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/job/iabortswitch.h"
+#include "foundation/utility/log.h"
+
+// Boost headers.
+#include "boost/asio/connect.hpp"
+#include "boost/asio/io_service.hpp"
+#include "boost/asio/ip/tcp.hpp"
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+#include "boost/system/error_code.hpp"
+#include "boost/system/system_error.hpp"
+#include "boost/thread/condition_variable.hpp"
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+namespace asio = boost::asio;
+using boost::asio::ip::tcp;
+
+namespace appleseed {
+namespace cli {
+
+namespace
+{
+    //
+    // Connection to the coordinator, shared by the rendering threads.
+    //
+
+    struct WorkerState
+    {
+        const Frame&                    m_frame;
+        const size_t                    m_max_pending_tiles;
+        Logger&                         m_logger;
+
+        asio::io_service                m_io_service;
+        tcp::socket                     m_socket;
+
+        // Protects the socket and the fields below.
+        boost::mutex                    m_mutex;
+        boost::condition_variable       m_tile_sent;
+        size_t                          m_pending_tile_count;
+        bool                            m_done;
+        bool                            m_failed;
+
+        WorkerState(
+            const Frame&                frame,
+            const size_t                max_pending_tiles,
+            Logger&                     logger)
+          : m_frame(frame)
+          , m_max_pending_tiles(max_pending_tiles > 0 ? max_pending_tiles : 1)
+          , m_logger(logger)
+          , m_socket(m_io_service)
+          , m_pending_tile_count(0)
+          , m_done(false)
+          , m_failed(false)
+        {
+        }
+
+        bool acquire_tile(
+            size_t&                     tile_x,
+            size_t&                     tile_y,
+            IAbortSwitch&               abort_switch)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+
+            // Don't request tiles too far ahead of the rendering threads.
+            while (m_pending_tile_count >= m_max_pending_tiles && !m_failed && !abort_switch.is_aborted())
+                m_tile_sent.timed_wait(lock, boost::posix_time::milliseconds(100));
+
+            if (m_done || m_failed || abort_switch.is_aborted())
+                return false;
+
+            try
+            {
+                // Wait until the coordinator assigns a tile or tells us to stop.
+                send_message(m_socket, DistributedMessage(TileRequestMessage));
+
+                DistributedMessage reply;
+                receive_message(m_socket, reply);
+
+                if (reply.m_type == NoMoreTilesMessage)
+                {
+                    m_done = true;
+                    return false;
+                }
+
+                size_t offset = 0;
+                uint32 x, y;
+                if (reply.m_type != TileAssignmentMessage ||
+                    !reply.read_uint32(offset, x) ||
+                    !reply.read_uint32(offset, y))
+                {
+                    LOG_ERROR(m_logger, "received an unexpected message from the coordinator.");
+                    m_failed = true;
+                    return false;
+                }
+
+                tile_x = x;
+                tile_y = y;
+                ++m_pending_tile_count;
+
+                return true;
+            }
+            catch (const boost::system::system_error& e)
+            {
+                LOG_ERROR(m_logger, "lost connection to the coordinator: %s.", e.what());
+                m_failed = true;
+                return false;
+            }
+        }
+
+        void send_tile(
+            const size_t                tile_x,
+            const size_t                tile_y)
+        {
+            DistributedMessage message(TileDataMessage);
+            append_tile(m_frame, tile_x, tile_y, message);
+
+            boost::mutex::scoped_lock lock(m_mutex);
+
+            if (!m_failed)
+            {
+                try
+                {
+                    send_message(m_socket, message);
+                }
+                catch (const boost::system::system_error& e)
+                {
+                    LOG_ERROR(m_logger, "lost connection to the coordinator: %s.", e.what());
+                    m_failed = true;
+                }
+            }
+
+            --m_pending_tile_count;
+            m_tile_sent.notify_one();
+        }
+    };
+
+
+    //
+    // Tile source handing out the tiles assigned by the coordinator.
+    //
+
+    class WorkerTileSource
+      : public ITileSource
+    {
+      public:
+        explicit WorkerTileSource(WorkerState& state)
+          : m_state(state)
+        {
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            // Do nothing.
+        }
+
+        virtual bool acquire_tile(
+            size_t&                 tile_x,
+            size_t&                 tile_y,
+            IAbortSwitch&           abort_switch) APPLESEED_OVERRIDE
+        {
+            return m_state.acquire_tile(tile_x, tile_y, abort_switch);
+        }
+
+      private:
+        WorkerState&                m_state;
+    };
+
+
+    //
+    // Tile callback sending rendered tiles to the coordinator.
+    //
+
+    class WorkerTileCallback
+      : public TileCallbackBase
+    {
+      public:
+        explicit WorkerTileCallback(WorkerState& state)
+          : m_state(state)
+        {
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            // Do nothing.
+        }
+
+        virtual void post_render_tile(
+            const Frame*            frame,
+            const size_t            tile_x,
+            const size_t            tile_y) APPLESEED_OVERRIDE
+        {
+            m_state.send_tile(tile_x, tile_y);
+        }
+
+      private:
+        WorkerState&                m_state;
+    };
+
+
+    //
+    // Tile callback factory returning the same tile callback to all rendering threads.
+    //
+
+    class WorkerTileCallbackFactory
+      : public ITileCallbackFactory
+    {
+      public:
+        explicit WorkerTileCallbackFactory(WorkerState& state)
+          : m_callback(state)
+        {
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            // Do nothing.
+        }
+
+        virtual ITileCallback* create() APPLESEED_OVERRIDE
+        {
+            return &m_callback;
+        }
+
+      private:
+        WorkerTileCallback          m_callback;
+    };
+}
+
+
+
+//
+// DistributedWorker class implementation.
+//
+
+struct DistributedWorker::Impl
+{
+    WorkerState                     m_state;
+    WorkerTileSource                m_tile_source;
+    WorkerTileCallbackFactory       m_tile_callback_factory;
+
+    Impl(
+        const Frame&                frame,
+        const size_t                max_pending_tiles,
+        Logger&                     logger)
+      : m_state(frame, max_pending_tiles, logger)
+      , m_tile_source(m_state)
+      , m_tile_callback_factory(m_state)
+    {
+    }
+};
+
+DistributedWorker::DistributedWorker(
+    const Frame&                    frame,
+    const size_t                    max_pending_tiles,
+    Logger&                         logger)
+  : impl(new Impl(frame, max_pending_tiles, logger))
+{
+}
+
+DistributedWorker::~DistributedWorker()
+{
+    boost::system::error_code error;
+    impl->m_state.m_socket.shutdown(tcp::socket::shutdown_both, error);
+    impl->m_state.m_socket.close(error);
+
+    delete impl;
+}
+
+bool DistributedWorker::connect(
+    const char*                     host,
+    const char*                     port)
+{
+    try
+    {
+        tcp::resolver resolver(impl->m_state.m_io_service);
+        asio::connect(impl->m_state.m_socket, resolver.resolve(tcp::resolver::query(host, port)));
+        impl->m_state.m_socket.set_option(tcp::no_delay(true));
+
+        // Introduce ourselves, and make sure we render the same frame as the coordinator.
+        DistributedMessage hello(HelloMessage);
+        append_frame_layout(impl->m_state.m_frame, hello);
+        send_message(impl->m_state.m_socket, hello);
+
+        DistributedMessage reply;
+        receive_message(impl->m_state.m_socket, reply);
+
+        if (reply.m_type == NoMoreTilesMessage)
+        {
+            impl->m_state.m_done = true;
+            return true;
+        }
+
+        if (reply.m_type != WelcomeMessage)
+        {
+            LOG_ERROR(impl->m_state.m_logger, "the coordinator rejected this worker.");
+            return false;
+        }
+    }
+    catch (const boost::system::system_error& e)
+    {
+        LOG_ERROR(impl->m_state.m_logger, "could not connect to the coordinator at %s:%s: %s.", host, port, e.what());
+        return false;
+    }
+
+    LOG_INFO(impl->m_state.m_logger, "connected to the coordinator at %s:%s.", host, port);
+
+    return true;
+}
+
+bool DistributedWorker::is_healthy() const
+{
+    boost::mutex::scoped_lock lock(impl->m_state.m_mutex);
+    return !impl->m_state.m_failed;
+}
+
+ITileSource* DistributedWorker::get_tile_source()
+{
+    return &impl->m_tile_source;
+}
+
+ITileCallbackFactory* DistributedWorker::get_tile_callback_factory()
+{
+    return &impl->m_tile_callback_factory;
+}
+
+}   // namespace cli
+}   // namespace appleseed
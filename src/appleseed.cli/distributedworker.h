@@ -0,0 +1,87 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_CLI_DISTRIBUTEDWORKER_H
+#define APPLESEED_CLI_DISTRIBUTEDWORKER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class Logger; }
+namespace renderer      { class Frame; }
+namespace renderer      { class ITileCallbackFactory; }
+namespace renderer      { class ITileSource; }
+
+namespace appleseed {
+namespace cli {
+
+//
+// The worker side of a distributed render.
+//
+// The tile source hands out the tiles assigned by the coordinator, and the tile
+// callbacks send rendered tiles back to the coordinator. At most 'max_pending_tiles'
+// tiles are requested ahead of the tiles that were sent back.
+//
+
+class DistributedWorker
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    DistributedWorker(
+        const renderer::Frame&  frame,
+        const size_t            max_pending_tiles,
+        foundation::Logger&     logger);
+
+    // Destructor, disconnects from the coordinator.
+    ~DistributedWorker();
+
+    // Connect to the coordinator. Return false on failure.
+    bool connect(
+        const char*             host,
+        const char*             port);
+
+    // Return true if all tiles rendered so far were sent to the coordinator.
+    bool is_healthy() const;
+
+    // Access the tile source and the tile callback factory to pass to the renderer.
+    renderer::ITileSource* get_tile_source();
+    renderer::ITileCallbackFactory* get_tile_callback_factory();
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}       // namespace cli
+}       // namespace appleseed
+
+#endif  // !APPLESEED_CLI_DISTRIBUTEDWORKER_H
@@ -0,0 +1,110 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "framesequencebase.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/project.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/log.h"
+#include "foundation/utility/string.h"
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+namespace appleseed {
+namespace cli {
+
+//
+// FrameSequenceBase class implementation.
+//
+
+namespace
+{
+    // Frames are written by a couple of threads, as long as the frames waiting
+    // to be written fit in this budget. This covers a few 4K frames with AOVs.
+    const size_t FrameWriterThreadCount = 2;
+    const size_t FrameWriterMaxPendingBytes = size_t(2) * 1024 * 1024 * 1024;
+}
+
+FrameSequenceBase::FrameSequenceBase(
+    const string&       output_pattern,
+    const bool          output_aovs,
+    const size_t        first_frame,
+    const size_t        last_frame,
+    Logger&             logger)
+  : m_first_frame(first_frame)
+  , m_frame_count(last_frame >= first_frame ? last_frame - first_frame + 1 : 0)
+  , m_logger(logger)
+  , m_output_pattern(output_pattern)
+  , m_output_aovs(output_aovs)
+  , m_frame_writer(FrameWriterThreadCount, FrameWriterMaxPendingBytes)
+{
+}
+
+bool FrameSequenceBase::flush()
+{
+    return m_frame_writer.flush();
+}
+
+size_t FrameSequenceBase::get_frame_count() const
+{
+    return m_frame_count;
+}
+
+void FrameSequenceBase::on_frame_end(
+    const Project&      project,
+    const size_t        frame_index)
+{
+    if (m_output_pattern.empty())
+        return;
+
+    const string output_filepath = get_numbered_string(m_output_pattern, m_first_frame + frame_index);
+
+    LOG_INFO(m_logger, "writing frame to %s...", output_filepath.c_str());
+    m_frame_writer.write(*project.get_frame(), output_filepath.c_str(), m_output_aovs);
+}
+
+size_t FrameSequenceBase::print_frame_begin(const size_t frame_index) const
+{
+    const size_t frame = m_first_frame + frame_index;
+
+    LOG_INFO(
+        m_logger,
+        "rendering frame %s (%s of %s)...",
+        pretty_uint(frame).c_str(),
+        pretty_uint(frame_index + 1).c_str(),
+        pretty_uint(m_frame_count).c_str());
+
+    return frame;
+}
+
+}   // namespace cli
+}   // namespace appleseed
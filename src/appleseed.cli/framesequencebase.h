@@ -0,0 +1,95 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_CLI_FRAMESEQUENCEBASE_H
+#define APPLESEED_CLI_FRAMESEQUENCEBASE_H
+
+// appleseed.renderer headers.
+#include "renderer/api/frame.h"
+#include "renderer/api/rendering.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+
+// Forward declarations.
+namespace foundation    { class Logger; }
+namespace renderer      { class Project; }
+
+namespace appleseed {
+namespace cli {
+
+//
+// Base class for the frame sequences of the command line renderer.
+//
+// Each frame is written to a numbered image file once it is rendered, while the next
+// frame renders; the '#' characters of the output file name pattern are replaced by
+// the frame number.
+//
+
+class FrameSequenceBase
+  : public renderer::IFrameSequence
+{
+  public:
+    // Constructor. 'output_pattern' may be empty if frames should not be written.
+    FrameSequenceBase(
+        const std::string&          output_pattern,
+        const bool                  output_aovs,
+        const size_t                first_frame,
+        const size_t                last_frame,
+        foundation::Logger&         logger);
+
+    // Wait until all rendered frames are written. Return true if all of them were written successfully.
+    bool flush();
+
+    virtual size_t get_frame_count() const APPLESEED_OVERRIDE;
+
+    virtual void on_frame_end(
+        const renderer::Project&    project,
+        const size_t                frame_index) APPLESEED_OVERRIDE;
+
+  protected:
+    const size_t                    m_first_frame;
+    const size_t                    m_frame_count;
+    foundation::Logger&             m_logger;
+
+    // Log the beginning of a frame and return its frame number.
+    size_t print_frame_begin(const size_t frame_index) const;
+
+  private:
+    const std::string               m_output_pattern;
+    const bool                      m_output_aovs;
+    renderer::AsyncFrameWriter      m_frame_writer;
+};
+
+}       // namespace cli
+}       // namespace appleseed
+
+#endif  // !APPLESEED_CLI_FRAMESEQUENCEBASE_H
@@ -28,12 +28,23 @@
 //
 
 // appleseed.cli headers.
+#include "benchmarkreport.h"
+#include "cameraframesequence.h"
 #include "commandlinehandler.h"
 #include "continuoussavingtilecallback.h"
+#include "deltaframesequence.h"
+#include "distributedcoordinator.h"
+#include "distributedworker.h"
 #include "houdinitilecallbacks.h"
+#include "multiprocessrender.h"
 #include "progresstilecallback.h"
+#include "rendercheckpoint.h"
+#include "renderserver.h"
+#include "sharedmemorytilecallback.h"
+#include "streamingoutputtilecallback.h"
 
 // appleseed.renderer headers.
+#include "renderer/api/aov.h"
 #include "renderer/api/color.h"
 #include "renderer/api/frame.h"
 #include "renderer/api/log.h"
@@ -46,12 +57,17 @@
 #include "renderer/api/utility.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/thread.h"
 #include "foundation/platform/timers.h"
 #include "foundation/utility/autoreleaseptr.h"
 #include "foundation/utility/benchmark.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/filter.h"
 #include "foundation/utility/log.h"
+#include "foundation/utility/phaseprofile.h"
 #include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
 #include "foundation/utility/test.h"
@@ -68,10 +84,12 @@
 #include "boost/filesystem/path.hpp"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <cstdlib>
 #include <memory>
 #include <string>
+#include <vector>
 
 using namespace appleseed::cli;
 using namespace appleseed::shared;
@@ -220,6 +238,9 @@ namespace
         const bf::path old_current_path =
             Application::change_current_directory_to_tests_root_path();
 
+        BenchmarkSuiteRepository::instance().set_collect_hardware_counters(
+            g_cl.m_hardware_counters.is_set());
+
         // Run benchmark suites.
         if (g_cl.m_run_unit_benchmarks.values().empty())
             BenchmarkSuiteRepository::instance().run(result);
@@ -247,6 +268,51 @@ namespace
         print_unit_benchmark_result(result);
     }
 
+    bool compare_unit_benchmarks()
+    {
+        const string& baseline_path = g_cl.m_compare_unit_benchmarks.values()[0];
+        const string& candidate_path = g_cl.m_compare_unit_benchmarks.values()[1];
+
+        // Each results file in a directory counts as one measurement of the benchmark cases it contains.
+        BenchmarkAggregator baseline, candidate;
+        baseline.scan_directory(baseline_path.c_str());
+        candidate.scan_directory(candidate_path.c_str());
+
+        const BenchmarkComparison comparison(baseline, candidate);
+
+        LOG_INFO(
+            g_logger,
+            "comparing unit benchmark results from %s (baseline) and %s (candidate):",
+            baseline_path.c_str(),
+            candidate_path.c_str());
+
+        for (size_t i = 0; i < comparison.get_case_count(); ++i)
+        {
+            const BenchmarkCaseComparison& c = comparison.get_case_comparison(i);
+
+            LOG(
+                g_logger,
+                c.m_verdict == BenchmarkCaseComparison::Regression ? LogMessage::Warning : LogMessage::Info,
+                "  %s: speedup %s [%s, %s] over " FMT_SIZE_T "/" FMT_SIZE_T " measurements, %s",
+                comparison.get_case_name(i),
+                pretty_scalar(c.m_speedup, 3).c_str(),
+                pretty_scalar(c.m_speedup_low, 3).c_str(),
+                pretty_scalar(c.m_speedup_high, 3).c_str(),
+                c.m_baseline_count,
+                c.m_candidate_count,
+                get_verdict_name(c.m_verdict));
+        }
+
+        LOG_INFO(
+            g_logger,
+            "%s %s compared, %s regressed.",
+            pretty_uint(comparison.get_case_count()).c_str(),
+            plural(comparison.get_case_count(), "benchmark case").c_str(),
+            pretty_uint(comparison.get_regression_count()).c_str());
+
+        return comparison.get_regression_count() == 0;
+    }
+
     void set_frame_parameter(Project& project, const string& key, const string& value)
     {
         const Frame* frame = project.get_frame();
@@ -415,6 +481,10 @@ namespace
         // Apply --passes option.
         apply_passes_command_line_option(params);
 
+        // Apply --target-error option.
+        if (g_cl.m_target_error.is_set())
+            params.insert_path("progressive_frame_renderer.estimate_convergence", true);
+
         // Apply --override-shading option.
         if (g_cl.m_override_shading.is_set())
         {
@@ -454,20 +524,33 @@ namespace
 
 #endif
 
-    auto_release_ptr<Project> load_project(const string& project_filepath)
+    string get_project_schema_filepath()
     {
-        // Construct the schema file path.
         const bf::path schema_filepath =
               bf::path(Application::get_root_path())
             / "schemas"
             / "project.xsd";
 
+        return schema_filepath.string();
+    }
+
+    auto_release_ptr<Project> load_project(const string& project_filepath)
+    {
+        int options = ProjectFileReader::Defaults;
+
+        if (g_cl.m_deduplicate_meshes.is_set())
+            options |= ProjectFileReader::DeduplicateMeshObjects;
+
+        if (g_cl.m_fast_load.is_set())
+            options |= ProjectFileReader::OmitProjectSchemaValidation;
+
         // Load the project from disk.
         ProjectFileReader reader;
         return
             reader.read(
                 project_filepath.c_str(),
-                schema_filepath.string().c_str());
+                get_project_schema_filepath().c_str(),
+                options);
     }
 
     bool configure_project(Project& project, ParamArray& params)
@@ -511,10 +594,80 @@ namespace
         return value == "progressive";
     }
 
+    // Return true if the output of the render can be streamed to disk.
+    bool can_stream_output(const Project& project, const ParamArray& params)
+    {
+        return
+            g_cl.m_output.is_set() &&
+            !g_cl.m_continuous_saving.is_set() &&
+            !is_progressive_render(params) &&
+            !project.get_frame()->is_denoising_enabled() &&
+            !g_cl.m_coordinator.is_set() &&
+            !g_cl.m_worker.is_set() &&
+            !g_cl.m_processes.is_set() &&
+            !g_cl.m_frame_sequence.is_set();
+    }
+
+    // Render the frame, or hand out its tiles to workers when coordinating a distributed render.
+    bool render_frame(
+        Project&                project,
+        MasterRenderer&         renderer,
+        const ParamArray&       params,
+        ITileCallbackFactory*   tile_callback_factory)
+    {
+        if (g_cl.m_processes.is_set())
+        {
+            return
+                render_with_multiple_processes(
+                    project,
+                    renderer,
+                    params,
+                    static_cast<size_t>(g_cl.m_processes.value()),
+                    g_logger);
+        }
+
+        if (g_cl.m_coordinator.is_set())
+        {
+            auto_release_ptr<ITileCallback> tile_callback(
+                tile_callback_factory ? tile_callback_factory->create() : 0);
+
+            return
+                coordinate_distributed_render(
+                    *project.get_frame(),
+                    static_cast<unsigned short>(g_cl.m_coordinator.value()),
+                    TileJobFactory::SpiralOrdering,
+                    tile_callback.get(),
+                    g_logger);
+        }
+
+        return renderer.render();
+    }
+
     bool render(const string& project_filename)
     {
+        // When rendering a frame sequence, the project file of the first frame is loaded,
+        // unless the changes between frames are described by a delta file.
+        const bool is_frame_sequence = g_cl.m_frame_sequence.is_set();
+        if (is_frame_sequence &&
+            (g_cl.m_frame_sequence.values()[0] < 0 ||
+             g_cl.m_frame_sequence.values()[1] < g_cl.m_frame_sequence.values()[0]))
+        {
+            LOG_ERROR(g_logger, "invalid frame range.");
+            return false;
+        }
+
+        if (g_cl.m_frame_deltas.is_set() && !is_frame_sequence)
+        {
+            LOG_ERROR(g_logger, "--frame-deltas requires --frame-sequence.");
+            return false;
+        }
+
         // Load the project.
-        auto_release_ptr<Project> project = load_project(project_filename);
+        auto_release_ptr<Project> project =
+            load_project(
+                is_frame_sequence && !g_cl.m_frame_deltas.is_set()
+                    ? get_numbered_string(project_filename, g_cl.m_frame_sequence.values()[0])
+                    : project_filename);
         if (project.get() == 0)
             return false;
 
@@ -525,6 +678,7 @@ namespace
 
         // Create the tile callback factory.
         auto_ptr<ITileCallbackFactory> tile_callback_factory;
+        ContinuousSavingTileCallbackFactory* continuous_saving_factory = 0;
         if (g_cl.m_mplay_display.is_set())
         {
             tile_callback_factory.reset(
@@ -541,12 +695,32 @@ namespace
                     is_progressive_render(params),
                     g_logger));
         }
+        else if (g_cl.m_shared_memory_display.is_set())
+        {
+            // Make room for a whole frame so that readers don't lose tiles of the same pass.
+            const Frame* frame = project->get_frame();
+            const size_t slot_count =
+                frame->image().properties().m_tile_count * (1 + frame->aov_images().size());
+
+            SharedMemoryTileCallbackFactory* shared_memory_factory =
+                new SharedMemoryTileCallbackFactory(
+                    g_cl.m_shared_memory_display.value().c_str(),
+                    *frame,
+                    slot_count,
+                    g_logger);
+            tile_callback_factory.reset(shared_memory_factory);
+
+            if (!shared_memory_factory->is_open())
+                return false;
+        }
         else if (g_cl.m_output.is_set() && g_cl.m_continuous_saving.is_set())
         {
-            tile_callback_factory.reset(
+            continuous_saving_factory =
                 new ContinuousSavingTileCallbackFactory(
                     g_cl.m_output.value().c_str(),
-                    g_logger));
+                    1.0,    // save at most once per second
+                    g_logger);
+            tile_callback_factory.reset(continuous_saving_factory);
         }
         else if (project->get_display() == 0)
         {
@@ -558,13 +732,265 @@ namespace
             }
         }
 
+        // Stream the output to disk if the frame doesn't fit within the memory limit along
+        // with the rest of the render. Otherwise, the renderer gets what the frame leaves.
+        bool streaming_output = g_cl.m_streaming_output.is_set();
+        const MemoryLimitPolicy memory_limit_policy(params);
+        if (memory_limit_policy.get_limit() > 0)
+        {
+            const uint64 memory_limit = memory_limit_policy.get_limit();
+            const uint64 frame_size = MemoryLimitPolicy::get_frame_size(*project->get_frame());
+
+            if (!streaming_output &&
+                can_stream_output(project.ref(), params) &&
+                memory_limit_policy.should_stream_output(MemoryLimitPolicy::get_current_usage(), params, frame_size))
+            {
+                LOG_INFO(g_logger, "memory limit: streaming the output to disk.");
+                streaming_output = true;
+            }
+
+            if (!streaming_output)
+                params.insert("memory_limit", memory_limit > frame_size ? memory_limit - frame_size : 1);
+        }
+
+        // Write finished tiles to the output file and release their memory.
+        StreamingOutputTileCallbackFactory* streaming_factory = 0;
+        if (streaming_output)
+        {
+            if (!g_cl.m_output.is_set() || g_cl.m_continuous_saving.is_set())
+            {
+                LOG_ERROR(g_logger, "--streaming-output requires --output and cannot be combined with --continuous-saving.");
+                return false;
+            }
+
+            if (is_progressive_render(params))
+            {
+                LOG_ERROR(g_logger, "cannot stream the output of a progressive render.");
+                return false;
+            }
+
+            if (project->get_frame()->is_denoising_enabled())
+            {
+                LOG_ERROR(g_logger, "cannot stream the output of a denoised render.");
+                return false;
+            }
+
+            if (g_cl.m_coordinator.is_set() || g_cl.m_worker.is_set())
+            {
+                LOG_ERROR(g_logger, "cannot stream the output of a distributed render.");
+                return false;
+            }
+
+            // The streaming callback forwards tiles to the callback of the previous factory.
+            streaming_factory =
+                new StreamingOutputTileCallbackFactory(
+                    *project->get_frame(),
+                    g_cl.m_output.value(),
+                    params.get_path_optional<size_t>("generic_frame_renderer.passes", 1),
+                    tile_callback_factory.release(),
+                    g_logger);
+            tile_callback_factory.reset(streaming_factory);
+
+            if (!streaming_factory->is_open())
+                return false;
+        }
+
+        // Write the fragments of finished tiles to a deep OpenEXR file.
+        if (g_cl.m_deep_output.is_set())
+        {
+            if (is_progressive_render(params) ||
+                params.get_optional<string>("pixel_renderer", "uniform") != "uniform" ||
+                params.get_path_optional<size_t>("generic_frame_renderer.passes", 1) > 1)
+            {
+                LOG_ERROR(g_logger, "--deep-output requires a single-pass render with the uniform pixel renderer.");
+                return false;
+            }
+
+            if (g_cl.m_coordinator.is_set() || g_cl.m_worker.is_set() || is_frame_sequence)
+            {
+                LOG_ERROR(g_logger, "cannot write deep output for a distributed render or a frame sequence.");
+                return false;
+            }
+
+            if (!project->get_frame()->open_deep_output(g_cl.m_deep_output.value().c_str()))
+                return false;
+        }
+
+        // Save finished tiles to a checkpoint file, and skip the tiles already saved when resuming.
+        auto_ptr<ResumeTileSource> resume_tile_source;
+        if (g_cl.m_checkpoint.is_set())
+        {
+            if (is_progressive_render(params))
+            {
+                LOG_ERROR(g_logger, "cannot checkpoint a progressive render.");
+                return false;
+            }
+
+            if (g_cl.m_coordinator.is_set() || g_cl.m_worker.is_set())
+            {
+                LOG_ERROR(g_logger, "cannot checkpoint a distributed render.");
+                return false;
+            }
+
+            const string& checkpoint_path = g_cl.m_checkpoint.value();
+            const bool resume = g_cl.m_resume.is_set() && bf::exists(checkpoint_path);
+
+            if (resume)
+            {
+                vector<bool> finished_tiles;
+                if (!load_checkpoint(checkpoint_path, *project->get_frame(), finished_tiles, g_logger))
+                    return false;
+
+                resume_tile_source.reset(
+                    new ResumeTileSource(*project->get_frame(), finished_tiles));
+            }
+
+            // The checkpoint callback forwards tiles to the callback of the previous factory.
+            CheckpointTileCallbackFactory* checkpoint_factory =
+                new CheckpointTileCallbackFactory(
+                    *project->get_frame(),
+                    checkpoint_path,
+                    params.get_path_optional<size_t>("generic_frame_renderer.passes", 1),
+                    resume,
+                    tile_callback_factory.release(),
+                    g_logger);
+            tile_callback_factory.reset(checkpoint_factory);
+
+            if (!checkpoint_factory->is_open())
+                return false;
+        }
+        else if (g_cl.m_resume.is_set())
+            LOG_WARNING(g_logger, "--resume has no effect without --checkpoint.");
+
+        // Connect to the coordinator of a distributed render.
+        auto_ptr<DistributedWorker> worker;
+        if (g_cl.m_worker.is_set())
+        {
+            // Keep enough tiles in flight to hide the network latency from the rendering threads.
+            worker.reset(
+                new DistributedWorker(
+                    *project->get_frame(),
+                    2 * get_rendering_thread_count(params),
+                    g_logger));
+
+            if (!worker->connect(
+                    g_cl.m_worker.values()[0].c_str(),
+                    g_cl.m_worker.values()[1].c_str()))
+                return false;
+        }
+
+        // Render disjoint tiles of the frame in several processes sharing the scene.
+        if (g_cl.m_processes.is_set())
+        {
+            if (g_cl.m_processes.value() < 1)
+            {
+                LOG_ERROR(g_logger, "invalid number of processes.");
+                return false;
+            }
+
+            if (is_progressive_render(params) ||
+                params.get_path_optional<size_t>("generic_frame_renderer.passes", 1) > 1)
+            {
+                LOG_ERROR(g_logger, "--processes requires a single-pass render with the generic frame renderer.");
+                return false;
+            }
+
+            if (project->get_frame()->is_denoising_enabled())
+            {
+                LOG_ERROR(g_logger, "cannot denoise a render with multiple processes.");
+                return false;
+            }
+
+            if (g_cl.m_coordinator.is_set() || g_cl.m_worker.is_set() || g_cl.m_checkpoint.is_set() ||
+                g_cl.m_streaming_output.is_set() || g_cl.m_deep_output.is_set() || is_frame_sequence)
+            {
+                LOG_ERROR(g_logger, "cannot render with multiple processes with distributed rendering, checkpointing, streaming output, deep output or a frame sequence.");
+                return false;
+            }
+
+            // Worker processes are forked from this one and would not inherit the logging thread.
+            if (g_cl.m_async_logging.is_set())
+            {
+                LOG_ERROR(g_logger, "cannot render with multiple processes with asynchronous logging.");
+                return false;
+            }
+        }
+
+        // Stop rendering once the target error is reached, if one is specified.
+        auto_ptr<IRendererController> renderer_controller;
+        if (g_cl.m_target_error.is_set())
+        {
+            if (!is_progressive_render(params))
+            {
+                LOG_ERROR(g_logger, "--target-error requires the progressive frame renderer.");
+                return false;
+            }
+
+            renderer_controller.reset(
+                new ConvergenceRendererController(
+                    project->get_frame()->get_convergence_estimator(),
+                    g_cl.m_target_error.values()[0]));
+        }
+        else renderer_controller.reset(new DefaultRendererController());
+
         // Create the master renderer.
-        DefaultRendererController renderer_controller;
         MasterRenderer renderer(
             project.ref(),
             params,
-            &renderer_controller,
-            tile_callback_factory.get());
+            renderer_controller.get(),
+            worker.get() ? worker->get_tile_callback_factory() : tile_callback_factory.get(),
+            worker.get() ? worker->get_tile_source() : resume_tile_source.get());
+
+        // Keep the scene preparation of the first frame for the whole frame sequence.
+        auto_ptr<FrameSequenceBase> frame_sequence;
+        if (is_frame_sequence)
+        {
+            if (g_cl.m_checkpoint.is_set() || g_cl.m_streaming_output.is_set() ||
+                g_cl.m_coordinator.is_set() || g_cl.m_worker.is_set())
+            {
+                LOG_ERROR(g_logger, "cannot render a frame sequence with checkpointing, streaming output or distributed rendering.");
+                return false;
+            }
+
+            const ParamArray& frame_params = project->get_frame()->get_parameters();
+            const string output_pattern =
+                g_cl.m_output.is_set()
+                    ? g_cl.m_output.value()
+                    : frame_params.get_optional<string>("output_filename");
+            const bool output_aovs =
+                g_cl.m_output.is_set() || frame_params.get_optional<bool>("output_aovs", false);
+            const size_t first_frame = static_cast<size_t>(g_cl.m_frame_sequence.values()[0]);
+            const size_t last_frame = static_cast<size_t>(g_cl.m_frame_sequence.values()[1]);
+
+            if (g_cl.m_frame_deltas.is_set())
+            {
+                DeltaFrameSequence* delta_frame_sequence =
+                    new DeltaFrameSequence(
+                        output_pattern,
+                        output_aovs,
+                        first_frame,
+                        last_frame,
+                        g_logger);
+                frame_sequence.reset(delta_frame_sequence);
+
+                if (!delta_frame_sequence->read(g_cl.m_frame_deltas.value().c_str()))
+                    return false;
+            }
+            else
+            {
+                frame_sequence.reset(
+                    new CameraFrameSequence(
+                        project_filename,
+                        get_project_schema_filepath(),
+                        output_pattern,
+                        output_aovs,
+                        first_frame,
+                        last_frame,
+                        g_logger));
+            }
+
+            renderer.set_frame_sequence(frame_sequence.get());
+        }
 
         // Render the frame.
         LOG_INFO(g_logger, "rendering frame...");
@@ -573,14 +999,14 @@ namespace
         {
             ProcessPriorityContext background_context(ProcessPriorityLow, &g_logger);
             stopwatch.start();
-            if (!renderer.render())
+            if (!render_frame(project.ref(), renderer, params, tile_callback_factory.get()))
                 return false;
             stopwatch.measure();
         }
         else
         {
             stopwatch.start();
-            if (!renderer.render())
+            if (!render_frame(project.ref(), renderer, params, tile_callback_factory.get()))
                 return false;
             stopwatch.measure();
         }
@@ -592,9 +1018,20 @@ namespace
             "rendering finished in %s.",
             pretty_time(seconds, 3).c_str());
 
-        // Archive the frame to disk.
+        // Workers only render parts of the frame; the coordinator writes the whole frame.
+        if (worker.get())
+            return worker->is_healthy();
+
+        // The frames of a sequence are written as soon as they are rendered.
+        if (frame_sequence.get())
+        {
+            LOG_INFO(g_logger, "waiting for frames to be written to disk...");
+            return frame_sequence->flush();
+        }
+
+        // Archive the frame to disk. The tiles of a streamed frame were already released.
         char* archive_path = 0;
-        if (params.get_optional<bool>("autosave", true))
+        if (params.get_optional<bool>("autosave", true) && streaming_factory == 0)
         {
             // Construct the path to the archive directory.
             const bf::path autosave_path =
@@ -608,8 +1045,27 @@ namespace
                 &archive_path);
         }
 
+        // Finish writing the deep output file.
+        if (project->get_frame()->is_deep_output_open())
+        {
+            LOG_INFO(g_logger, "writing deep output to disk...");
+            if (!project->get_frame()->close_deep_output())
+                return false;
+        }
+
         // Write the frame to disk.
-        if (g_cl.m_output.is_set() && !g_cl.m_continuous_saving.is_set())
+        if (streaming_factory)
+        {
+            LOG_INFO(g_logger, "writing remaining tiles to disk...");
+            if (!streaming_factory->finish())
+                return false;
+        }
+        else if (continuous_saving_factory)
+        {
+            LOG_INFO(g_logger, "waiting for the frame to be saved...");
+            continuous_saving_factory->finish();
+        }
+        else if (g_cl.m_output.is_set() && !g_cl.m_continuous_saving.is_set())
         {
             LOG_INFO(g_logger, "writing frame to disk...");
             project->get_frame()->write_main_image(g_cl.m_output.value().c_str());
@@ -665,10 +1121,17 @@ namespace
         global_logger().reset_format(LogMessage::Error);
         global_logger().reset_format(LogMessage::Fatal);
 
+        BenchmarkReport report;
+        report.m_project_path = project_filename;
+
         // Load the project.
+        Stopwatch<DefaultWallclockTimer> load_stopwatch;
+        load_stopwatch.start();
         auto_release_ptr<Project> project = load_project(project_filename);
         if (project.get() == 0)
             return false;
+        load_stopwatch.measure();
+        report.m_load_time = load_stopwatch.get_seconds();
 
         // Figure out the rendering parameters.
         ParamArray params;
@@ -682,26 +1145,54 @@ namespace
             params,
             &renderer_controller);
 
-        double total_time_seconds, render_time_seconds;
+        // By default, render once to warm up caches, then once more to measure.
+        size_t warmup_run_count = 1;
+        size_t measured_run_count = 1;
+        if (g_cl.m_benchmark_runs.is_set())
+        {
+            warmup_run_count = static_cast<size_t>(max(g_cl.m_benchmark_runs.values()[0], 0));
+            measured_run_count = static_cast<size_t>(max(g_cl.m_benchmark_runs.values()[1], 1));
+        }
+        report.m_warmup_run_count = warmup_run_count;
+
         {
             // Raise the process priority to reduce interruptions.
             ProcessPriorityContext benchmark_context(ProcessPriorityHigh, &g_logger);
-            Stopwatch<DefaultWallclockTimer> stopwatch;
 
-            // Render a first time.
-            stopwatch.start();
-            if (!renderer.render())
-                return false;
-            stopwatch.measure();
-            total_time_seconds = stopwatch.get_seconds();
+            for (size_t i = 0; i < warmup_run_count + measured_run_count; ++i)
+            {
+                Stopwatch<DefaultWallclockTimer> stopwatch;
+                stopwatch.start();
+                if (!renderer.render())
+                    return false;
+                stopwatch.measure();
+
+                if (i < warmup_run_count)
+                    continue;
+
+                // The preparation time is the duration of the top-level preparation phases.
+                const PhaseProfile& profile = renderer.get_preparation_profile();
+                double preparation_time = 0.0;
+                for (size_t j = 0, e = profile.get_phase_count(); j < e; ++j)
+                {
+                    if (profile.get_phase_depth(j) == 0)
+                        preparation_time += profile.get_phase_seconds(j);
+                }
 
-            // Render a second time.
-            if (!renderer.render())
-                return false;
-            stopwatch.measure();
-            render_time_seconds = stopwatch.get_seconds() - total_time_seconds;
+                BenchmarkRun run;
+                run.m_total_time = stopwatch.get_seconds();
+                run.m_preparation_time = min(preparation_time, run.m_total_time);
+                run.m_render_time = run.m_total_time - run.m_preparation_time;
+                run.m_ray_count = sum_statistics(renderer.get_render_statistics(), "total rays");
+                run.m_sample_count = sum_statistics(renderer.get_render_statistics(), "samples");
+                run.m_peak_memory = System::get_peak_process_memory_size();
+                report.m_runs.push_back(run);
+            }
         }
 
+        report.m_preparation_profile = &renderer.get_preparation_profile();
+        report.m_render_statistics = &renderer.get_render_statistics();
+
         // Write the frame to disk.
         if (g_cl.m_output.is_set())
         {
@@ -711,13 +1202,98 @@ namespace
         }
 
         // Print benchmark results.
+        const BenchmarkRun average = report.get_average_run();
         LOG_INFO(g_logger, "result=success");
-        LOG_INFO(g_logger, "total_time=%.6f", total_time_seconds);
-        LOG_INFO(g_logger, "setup_time=%.6f", total_time_seconds - render_time_seconds);
-        LOG_INFO(g_logger, "render_time=%.6f", render_time_seconds);
+        LOG_INFO(g_logger, "total_time=%.6f", average.m_total_time);
+        LOG_INFO(g_logger, "setup_time=%.6f", average.m_preparation_time);
+        LOG_INFO(g_logger, "render_time=%.6f", average.m_render_time);
+
+        // Write the machine-readable report.
+        if (g_cl.m_benchmark_report.is_set())
+        {
+            const char* file_path = g_cl.m_benchmark_report.value().c_str();
+            if (!report.write_json(file_path))
+            {
+                LOG_ERROR(g_logger, "could not write benchmark report to %s.", file_path);
+                return false;
+            }
+        }
 
         return true;
     }
+
+    class CommandLineProjectLoader
+      : public IRenderServerProjectLoader
+    {
+      public:
+        virtual auto_release_ptr<Project> load(const string& project_filepath) APPLESEED_OVERRIDE
+        {
+            return load_project(project_filepath);
+        }
+
+        virtual bool configure(Project& project, ParamArray& params) APPLESEED_OVERRIDE
+        {
+            return configure_project(project, params);
+        }
+    };
+
+    bool serve_render_jobs()
+    {
+        const size_t max_resident_projects =
+            g_cl.m_resident_projects.is_set()
+                ? static_cast<size_t>(max(g_cl.m_resident_projects.value(), 1))
+                : 4;
+
+        CommandLineProjectLoader loader;
+
+        return
+            run_render_server(
+                static_cast<unsigned short>(g_cl.m_render_server.value()),
+                max_resident_projects,
+                loader,
+                g_logger);
+    }
+
+    bool submit_to_render_server(const string& project_filename)
+    {
+        RenderJob job;
+        job.m_project_filepath = project_filename;
+        job.m_parameters = g_cl.m_params.values();
+
+        if (g_cl.m_frame_deltas.is_set())
+        {
+            job.m_deltas_filepath = g_cl.m_frame_deltas.value();
+            if (g_cl.m_frame_sequence.is_set())
+                job.m_deltas_frame = static_cast<size_t>(g_cl.m_frame_sequence.values()[0]);
+        }
+
+        if (g_cl.m_output.is_set())
+            job.m_output_filepath = g_cl.m_output.value();
+
+        return
+            submit_render_job(
+                g_cl.m_submit.values()[0].c_str(),
+                g_cl.m_submit.values()[1].c_str(),
+                job,
+                g_logger);
+    }
+
+    void write_event_trace(const string& filepath)
+    {
+        EventTracer& tracer = global_event_tracer();
+        tracer.set_enabled(false);
+
+        if (tracer.write_chrome_trace(filepath.c_str()))
+        {
+            LOG_INFO(
+                g_logger,
+                "wrote %s trace %s to %s.",
+                pretty_uint(tracer.get_event_count()).c_str(),
+                plural(tracer.get_event_count(), "event").c_str(),
+                filepath.c_str());
+        }
+        else LOG_ERROR(g_logger, "failed to write trace events to %s.", filepath.c_str());
+    }
 }
 
 
@@ -758,15 +1334,49 @@ int main(int argc, const char* argv[])
     if (g_cl.m_run_unit_benchmarks.is_set())
         run_unit_benchmarks();
 
+    // Compare unit benchmark results.
+    if (g_cl.m_compare_unit_benchmarks.is_set())
+        success = success && compare_unit_benchmarks();
+
+    // Record the timeline of the render if requested.
+    if (g_cl.m_trace_events.is_set())
+        global_event_tracer().set_enabled(true);
+
+    // Take log message output off the rendering threads if requested.
+    if (g_cl.m_async_logging.is_set())
+        global_logger().set_async(true);
+
+    if (g_cl.m_stop_server.is_set())
+    {
+        success =
+            success &&
+            shutdown_render_server(
+                g_cl.m_stop_server.values()[0].c_str(),
+                g_cl.m_stop_server.values()[1].c_str(),
+                g_logger);
+    }
+
+    if (g_cl.m_render_server.is_set())
+        success = success && serve_render_jobs();
+
     // Render the specified project.
-    if (!g_cl.m_filename.values().empty())
+    else if (!g_cl.m_filename.values().empty())
     {
         const string project_filename = g_cl.m_filename.value();
 
-        if (g_cl.m_benchmark_mode.is_set())
+        if (g_cl.m_submit.is_set())
+            success = success && submit_to_render_server(project_filename);
+        else if (g_cl.m_benchmark_mode.is_set())
             success = success && benchmark_render(project_filename);
         else success = success && render(project_filename);
     }
 
+    if (g_cl.m_trace_events.is_set())
+        write_event_trace(g_cl.m_trace_events.value());
+
+    // Write all queued log messages.
+    if (g_cl.m_async_logging.is_set())
+        global_logger().set_async(false);
+
     return success ? 0 : 1;
 }
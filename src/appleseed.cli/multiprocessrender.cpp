@@ -0,0 +1,498 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "multiprocessrender.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/aov.h"
+#include "renderer/api/frame.h"
+#include "renderer/api/project.h"
+#include "renderer/api/rendering.h"
+#include "renderer/api/utility.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/image/tile.h"
+#include "foundation/math/aabb.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/job/iabortswitch.h"
+#include "foundation/utility/log.h"
+#include "foundation/utility/string.h"
+
+// Boost headers.
+#include "boost/interprocess/anonymous_shared_memory.hpp"
+#include "boost/interprocess/exceptions.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+#include "boost/interprocess/sync/interprocess_mutex.hpp"
+#include "boost/interprocess/sync/scoped_lock.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Platform headers.
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace boost;
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+namespace appleseed {
+namespace cli {
+
+#ifndef _WIN32
+
+namespace
+{
+    Tile& get_tile(
+        const Frame&    frame,
+        const size_t    image_index,
+        const size_t    tile_x,
+        const size_t    tile_y)
+    {
+        return
+            image_index == 0
+                ? frame.image().tile(tile_x, tile_y)
+                : frame.aov_images().get_image(image_index - 1).tile(tile_x, tile_y);
+    }
+
+
+    //
+    // Frame buffer and tile counter shared by the processes of a render.
+    //
+    // The shared memory mapping starts with a Header, followed by one byte per tile
+    // set once the tile is rendered, followed by the pixels of all the tiles of the
+    // main image and AOVs, in the pixel format of the frame. The layout is computed
+    // before forking and inherited by worker processes.
+    //
+
+    class SharedFrameBuffer
+      : public NonCopyable
+    {
+      public:
+        SharedFrameBuffer(
+            const Frame&                frame,
+            Logger&                     logger)
+          : m_header(0)
+          , m_rendered(0)
+          , m_pixels(0)
+        {
+            const CanvasProperties& props = frame.image().properties();
+            m_tile_count_x = props.m_tile_count_x;
+            m_image_count = frame.aov_images().size() + 1;
+
+            // Only hand out the tiles that intersect the crop window.
+            const AABB2u& crop_window = frame.get_crop_window();
+            for (size_t tile_y = 0; tile_y < props.m_tile_count_y; ++tile_y)
+            {
+                for (size_t tile_x = 0; tile_x < props.m_tile_count_x; ++tile_x)
+                {
+                    AABB2u tile_bbox;
+                    tile_bbox.min.x = tile_x * props.m_tile_width;
+                    tile_bbox.min.y = tile_y * props.m_tile_height;
+                    tile_bbox.max.x = min(tile_bbox.min.x + props.m_tile_width, props.m_canvas_width) - 1;
+                    tile_bbox.max.y = min(tile_bbox.min.y + props.m_tile_height, props.m_canvas_height) - 1;
+
+                    if (AABB2u::overlap(tile_bbox, crop_window))
+                        m_tiles.push_back(tile_y * props.m_tile_count_x + tile_x);
+                }
+            }
+
+            // Compute the location of the pixels of every tile of every image.
+            size_t pixels_size = 0;
+            m_offsets.resize(props.m_tile_count * m_image_count);
+            for (size_t i = 0; i < props.m_tile_count; ++i)
+            {
+                for (size_t j = 0; j < m_image_count; ++j)
+                {
+                    m_offsets[i * m_image_count + j] = pixels_size;
+                    pixels_size +=
+                        get_tile(
+                            frame,
+                            j,
+                            i % props.m_tile_count_x,
+                            i / props.m_tile_count_x).get_size();
+                }
+            }
+
+            const size_t header_size = (sizeof(Header) + 15) & ~static_cast<size_t>(15);
+            const size_t flags_size = (props.m_tile_count + 15) & ~static_cast<size_t>(15);
+
+            try
+            {
+                m_region.reset(
+                    new interprocess::mapped_region(
+                        interprocess::anonymous_shared_memory(header_size + flags_size + pixels_size)));
+            }
+            catch (const interprocess::interprocess_exception& e)
+            {
+                LOG_ERROR(logger, "could not create the shared frame buffer: %s.", e.what());
+                return;
+            }
+
+            uint8* base = static_cast<uint8*>(m_region->get_address());
+            m_header = new (base) Header();
+            m_rendered = base + header_size;
+            m_pixels = m_rendered + flags_size;
+
+            memset(m_rendered, 0, props.m_tile_count);
+        }
+
+        ~SharedFrameBuffer()
+        {
+            if (m_header)
+                m_header->~Header();
+        }
+
+        bool is_open() const
+        {
+            return m_header != 0;
+        }
+
+        size_t get_tile_count() const
+        {
+            return m_tiles.size();
+        }
+
+        // Take the next tile to render. Return false once all tiles were handed out.
+        bool acquire_tile(
+            size_t&                     tile_x,
+            size_t&                     tile_y)
+        {
+            interprocess::scoped_lock<interprocess::interprocess_mutex> lock(m_header->m_mutex);
+
+            if (m_header->m_next_tile >= m_tiles.size())
+                return false;
+
+            const size_t tile_index = m_tiles[m_header->m_next_tile++];
+            tile_x = tile_index % m_tile_count_x;
+            tile_y = tile_index / m_tile_count_x;
+
+            return true;
+        }
+
+        // Copy a rendered tile of a frame into the shared frame buffer.
+        void store_tile(
+            const Frame&                frame,
+            const size_t                tile_x,
+            const size_t                tile_y)
+        {
+            const size_t tile_index = tile_y * m_tile_count_x + tile_x;
+
+            for (size_t i = 0; i < m_image_count; ++i)
+            {
+                const Tile& tile = get_tile(frame, i, tile_x, tile_y);
+                memcpy(m_pixels + m_offsets[tile_index * m_image_count + i], tile.get_storage(), tile.get_size());
+            }
+
+            m_rendered[tile_index] = 1;
+        }
+
+        // Copy the rendered tiles into a frame. Must only be called once workers have exited.
+        // Return the number of tiles that were not rendered.
+        size_t load_tiles(const Frame& frame) const
+        {
+            size_t missing_tile_count = 0;
+
+            for (size_t t = 0; t < m_tiles.size(); ++t)
+            {
+                const size_t tile_index = m_tiles[t];
+
+                if (!m_rendered[tile_index])
+                {
+                    ++missing_tile_count;
+                    continue;
+                }
+
+                for (size_t i = 0; i < m_image_count; ++i)
+                {
+                    Tile& tile =
+                        get_tile(
+                            frame,
+                            i,
+                            tile_index % m_tile_count_x,
+                            tile_index / m_tile_count_x);
+                    memcpy(tile.get_storage(), m_pixels + m_offsets[tile_index * m_image_count + i], tile.get_size());
+                }
+            }
+
+            return missing_tile_count;
+        }
+
+      private:
+        struct Header
+        {
+            interprocess::interprocess_mutex    m_mutex;
+            size_t                              m_next_tile;    // protected by m_mutex
+
+            Header()
+              : m_next_tile(0)
+            {
+            }
+        };
+
+        size_t                                  m_tile_count_x;
+        size_t                                  m_image_count;      // main image + AOVs
+        vector<size_t>                          m_tiles;            // tiles to hand out, in order
+        vector<size_t>                          m_offsets;          // offset of the pixels of each tile of each image
+        auto_ptr<interprocess::mapped_region>   m_region;
+        Header*                                 m_header;
+        uint8*                                  m_rendered;
+        uint8*                                  m_pixels;
+    };
+
+
+    //
+    // Tile source handing out the tiles of the shared tile counter.
+    //
+
+    class SharedTileSource
+      : public ITileSource
+    {
+      public:
+        explicit SharedTileSource(SharedFrameBuffer& frame_buffer)
+          : m_frame_buffer(frame_buffer)
+        {
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            // Do nothing.
+        }
+
+        virtual bool acquire_tile(
+            size_t&                 tile_x,
+            size_t&                 tile_y,
+            IAbortSwitch&           abort_switch) APPLESEED_OVERRIDE
+        {
+            if (abort_switch.is_aborted())
+                return false;
+
+            return m_frame_buffer.acquire_tile(tile_x, tile_y);
+        }
+
+      private:
+        SharedFrameBuffer&          m_frame_buffer;
+    };
+
+
+    //
+    // Tile callback storing rendered tiles into the shared frame buffer.
+    //
+
+    class SharedFrameBufferTileCallback
+      : public TileCallbackBase
+    {
+      public:
+        explicit SharedFrameBufferTileCallback(SharedFrameBuffer& frame_buffer)
+          : m_frame_buffer(frame_buffer)
+        {
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            // Do nothing.
+        }
+
+        virtual void post_render_tile(
+            const Frame*            frame,
+            const size_t            tile_x,
+            const size_t            tile_y) APPLESEED_OVERRIDE
+        {
+            m_frame_buffer.store_tile(*frame, tile_x, tile_y);
+        }
+
+      private:
+        SharedFrameBuffer&          m_frame_buffer;
+    };
+
+
+    //
+    // Tile callback factory returning the same tile callback to all rendering threads.
+    //
+
+    class SharedFrameBufferTileCallbackFactory
+      : public ITileCallbackFactory
+    {
+      public:
+        explicit SharedFrameBufferTileCallbackFactory(SharedFrameBuffer& frame_buffer)
+          : m_callback(frame_buffer)
+        {
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            // Do nothing.
+        }
+
+        virtual ITileCallback* create() APPLESEED_OVERRIDE
+        {
+            return &m_callback;
+        }
+
+      private:
+        SharedFrameBufferTileCallback   m_callback;
+    };
+
+
+    // Body of a worker process. Return the exit code of the process.
+    int run_worker_process(
+        Project&                    project,
+        const ParamArray&           params,
+        SharedFrameBuffer&          frame_buffer)
+    {
+        SharedTileSource tile_source(frame_buffer);
+        SharedFrameBufferTileCallbackFactory tile_callback_factory(frame_buffer);
+        DefaultRendererController renderer_controller;
+
+        MasterRenderer renderer(
+            project,
+            params,
+            &renderer_controller,
+            &tile_callback_factory,
+            &tile_source);
+
+        return renderer.render() ? 0 : 1;
+    }
+}
+
+bool render_with_multiple_processes(
+    Project&                        project,
+    MasterRenderer&                 renderer,
+    const ParamArray&               params,
+    const size_t                    process_count,
+    Logger&                         logger)
+{
+    const Frame& frame = *project.get_frame();
+
+    SharedFrameBuffer frame_buffer(frame, logger);
+    if (!frame_buffer.is_open())
+        return false;
+
+    // Build the acceleration structures once, before forking, so that workers share them.
+    LOG_INFO(logger, "preparing scene for %s rendering processes...", pretty_uint(process_count).c_str());
+    if (!renderer.prepare_scene())
+        return false;
+
+    // Split rendering threads evenly between worker processes.
+    const size_t thread_count = max<size_t>(get_rendering_thread_count(params) / process_count, 1);
+    ParamArray worker_params(params);
+    worker_params.insert_path("rendering_threads", thread_count);
+
+    vector<pid_t> workers;
+    for (size_t i = 0; i < process_count; ++i)
+    {
+        const pid_t pid = fork();
+
+        if (pid == 0)
+        {
+            // Worker process: render, then exit without returning to the caller,
+            // which would write the partial frame of this process to disk.
+            _exit(run_worker_process(project, worker_params, frame_buffer));
+        }
+
+        if (pid < 0)
+        {
+            // The workers already started render the remaining tiles.
+            LOG_WARNING(logger, "could not start rendering process #" FMT_SIZE_T ".", i + 1);
+            continue;
+        }
+
+        workers.push_back(pid);
+    }
+
+    if (workers.empty())
+    {
+        LOG_ERROR(logger, "could not start any rendering process.");
+        return false;
+    }
+
+    LOG_INFO(
+        logger,
+        "rendering with %s processes of %s threads each...",
+        pretty_uint(workers.size()).c_str(),
+        pretty_uint(thread_count).c_str());
+
+    // Wait until all workers have exited.
+    bool success = true;
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        int status;
+        if (waitpid(workers[i], &status, 0) != workers[i] ||
+            !WIFEXITED(status) ||
+            WEXITSTATUS(status) != 0)
+        {
+            LOG_ERROR(logger, "rendering process #" FMT_SIZE_T " failed.", i + 1);
+            success = false;
+        }
+    }
+
+    // Gather the tiles rendered by all workers.
+    const size_t missing_tile_count = frame_buffer.load_tiles(frame);
+    if (missing_tile_count > 0)
+    {
+        LOG_ERROR(
+            logger,
+            "%s out of %s tiles were not rendered.",
+            pretty_uint(missing_tile_count).c_str(),
+            pretty_uint(frame_buffer.get_tile_count()).c_str());
+        success = false;
+    }
+
+    return success;
+}
+
+#else
+
+bool render_with_multiple_processes(
+    Project&                        project,
+    MasterRenderer&                 renderer,
+    const ParamArray&               params,
+    const size_t                    process_count,
+    Logger&                         logger)
+{
+    LOG_ERROR(logger, "rendering with multiple processes is not supported on this platform.");
+    return false;
+}
+
+#endif
+
+}   // namespace cli
+}   // namespace appleseed
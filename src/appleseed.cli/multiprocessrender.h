@@ -0,0 +1,69 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_CLI_MULTIPROCESSRENDER_H
+#define APPLESEED_CLI_MULTIPROCESSRENDER_H
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class Logger; }
+namespace renderer      { class MasterRenderer; }
+namespace renderer      { class ParamArray; }
+namespace renderer      { class Project; }
+
+namespace appleseed {
+namespace cli {
+
+//
+// Render a frame with several processes on the same machine.
+//
+// The calling process prepares the scene and builds its acceleration structures,
+// then forks 'process_count' worker processes which share its memory copy-on-write,
+// so that geometry and trees are not duplicated. Workers take tiles from a shared
+// counter and store the tiles they render in a frame buffer living in an anonymous
+// shared memory mapping. Once all workers have exited, the tiles are copied into
+// the frame of the project.
+//
+// Rendering threads are split evenly between worker processes. Only single-pass
+// renders with the generic frame renderer are supported, and only on POSIX systems.
+// Return true if all tiles were rendered.
+//
+
+bool render_with_multiple_processes(
+    renderer::Project&          project,
+    renderer::MasterRenderer&   renderer,
+    const renderer::ParamArray& params,
+    const size_t                process_count,
+    foundation::Logger&         logger);
+
+}       // namespace cli
+}       // namespace appleseed
+
+#endif  // !APPLESEED_CLI_MULTIPROCESSRENDER_H
@@ -0,0 +1,397 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "rendercheckpoint.h"
+
+// appleseed.cli headers.
+#include "distributedprotocol.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/frame.h"
+#include "renderer/kernel/rendering/generic/tilejobfactory.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/math/aabb.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/log.h"
+#include "foundation/utility/string.h"
+
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <fstream>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+namespace bf = boost::filesystem;
+
+namespace appleseed {
+namespace cli {
+
+namespace
+{
+    void write_record(ofstream& file, const DistributedMessage& message)
+    {
+        uint8 header[DistributedMessageHeaderSize];
+        message.encode_header(header);
+
+        file.write(reinterpret_cast<const char*>(header), DistributedMessageHeaderSize);
+
+        if (!message.m_payload.empty())
+        {
+            file.write(
+                reinterpret_cast<const char*>(&message.m_payload[0]),
+                static_cast<streamsize>(message.m_payload.size()));
+        }
+
+        file.flush();
+    }
+
+    // Return false at the end of the file or if the record is truncated.
+    bool read_record(ifstream& file, DistributedMessage& message)
+    {
+        uint8 header[DistributedMessageHeaderSize];
+        file.read(reinterpret_cast<char*>(header), DistributedMessageHeaderSize);
+
+        if (file.gcount() != static_cast<streamsize>(DistributedMessageHeaderSize))
+            return false;
+
+        uint32 payload_size;
+        DistributedMessage::decode_header(header, message.m_type, payload_size);
+
+        message.m_payload.resize(payload_size);
+
+        if (payload_size > 0)
+        {
+            file.read(reinterpret_cast<char*>(&message.m_payload[0]), payload_size);
+
+            if (file.gcount() != static_cast<streamsize>(payload_size))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool intersects_crop_window(
+        const Frame&            frame,
+        const size_t            tile_x,
+        const size_t            tile_y)
+    {
+        const CanvasProperties& props = frame.image().properties();
+
+        AABB2u tile_bbox;
+        tile_bbox.min.x = tile_x * props.m_tile_width;
+        tile_bbox.min.y = tile_y * props.m_tile_height;
+        tile_bbox.max.x = min(tile_bbox.min.x + props.m_tile_width, props.m_canvas_width) - 1;
+        tile_bbox.max.y = min(tile_bbox.min.y + props.m_tile_height, props.m_canvas_height) - 1;
+
+        return AABB2u::overlap(tile_bbox, frame.get_crop_window());
+    }
+}
+
+
+//
+// CheckpointTileCallback class implementation.
+//
+
+class CheckpointTileCallback
+  : public TileCallbackBase
+{
+  public:
+    CheckpointTileCallback(
+        const Frame&            frame,
+        const string&           checkpoint_path,
+        const size_t            pass_count,
+        const bool              resume,
+        ITileCallback*          tile_callback,
+        Logger&                 logger)
+      : m_pass_count(max<size_t>(pass_count, 1))
+      , m_tile_callback(tile_callback)
+      , m_logger(logger)
+      , m_render_counts(frame.image().properties().m_tile_count, 0)
+    {
+        m_file.open(
+            checkpoint_path.c_str(),
+            resume
+                ? ios_base::out | ios_base::binary | ios_base::app
+                : ios_base::out | ios_base::binary | ios_base::trunc);
+
+        if (!m_file.is_open())
+        {
+            LOG_ERROR(m_logger, "could not open checkpoint file %s for writing.", checkpoint_path.c_str());
+            return;
+        }
+
+        if (!resume)
+        {
+            DistributedMessage layout(HelloMessage);
+            append_frame_layout(frame, layout);
+            write_record(m_file, layout);
+        }
+    }
+
+    bool is_open() const
+    {
+        return m_file.is_open();
+    }
+
+    virtual void release() APPLESEED_OVERRIDE
+    {
+        // Do nothing.
+    }
+
+    virtual void pre_render(
+        const size_t            x,
+        const size_t            y,
+        const size_t            width,
+        const size_t            height) APPLESEED_OVERRIDE
+    {
+        if (m_tile_callback)
+            m_tile_callback->pre_render(x, y, width, height);
+    }
+
+    virtual void post_render_tile(
+        const Frame*            frame,
+        const size_t            tile_x,
+        const size_t            tile_y) APPLESEED_OVERRIDE
+    {
+        if (m_tile_callback)
+            m_tile_callback->post_render_tile(frame, tile_x, tile_y);
+
+        const size_t tile_index = tile_y * frame->image().properties().m_tile_count_x + tile_x;
+
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        // Only checkpoint tiles that went through all rendering passes.
+        if (++m_render_counts[tile_index] != m_pass_count || !m_file.is_open())
+            return;
+
+        DistributedMessage message(TileDataMessage);
+        append_tile(*frame, tile_x, tile_y, message);
+        write_record(m_file, message);
+
+        if (!m_file)
+        {
+            LOG_ERROR(m_logger, "failed to write to the checkpoint file, checkpointing disabled.");
+            m_file.close();
+        }
+    }
+
+    virtual void post_render(
+        const Frame*            frame) APPLESEED_OVERRIDE
+    {
+        if (m_tile_callback)
+            m_tile_callback->post_render(frame);
+    }
+
+  private:
+    const size_t                m_pass_count;
+    ITileCallback*              m_tile_callback;
+    Logger&                     m_logger;
+    boost::mutex                m_mutex;
+    ofstream                    m_file;
+    vector<size_t>              m_render_counts;
+};
+
+
+//
+// CheckpointTileCallbackFactory class implementation.
+//
+
+CheckpointTileCallbackFactory::CheckpointTileCallbackFactory(
+    const Frame&                frame,
+    const string&               checkpoint_path,
+    const size_t                pass_count,
+    const bool                  resume,
+    ITileCallbackFactory*       tile_callback_factory,
+    Logger&                     logger)
+  : m_tile_callback_factory(tile_callback_factory)
+  , m_callback(
+        new CheckpointTileCallback(
+            frame,
+            checkpoint_path,
+            pass_count,
+            resume,
+            tile_callback_factory ? tile_callback_factory->create() : 0,
+            logger))
+{
+}
+
+CheckpointTileCallbackFactory::~CheckpointTileCallbackFactory()
+{
+}
+
+void CheckpointTileCallbackFactory::release()
+{
+    delete this;
+}
+
+ITileCallback* CheckpointTileCallbackFactory::create()
+{
+    return m_callback.get();
+}
+
+bool CheckpointTileCallbackFactory::is_open() const
+{
+    return m_callback->is_open();
+}
+
+
+//
+// Checkpoint loading.
+//
+
+bool load_checkpoint(
+    const string&               checkpoint_path,
+    const Frame&                frame,
+    vector<bool>&               finished_tiles,
+    Logger&                     logger)
+{
+    finished_tiles.assign(frame.image().properties().m_tile_count, false);
+
+    ifstream file(checkpoint_path.c_str(), ios_base::in | ios_base::binary);
+    if (!file.is_open())
+    {
+        LOG_ERROR(logger, "could not open checkpoint file %s.", checkpoint_path.c_str());
+        return false;
+    }
+
+    DistributedMessage message;
+    if (!read_record(file, message) ||
+        message.m_type != HelloMessage ||
+        !check_frame_layout(frame, message))
+    {
+        LOG_ERROR(logger, "checkpoint file %s does not match the frame being rendered.", checkpoint_path.c_str());
+        return false;
+    }
+
+    // Size of the part of the file made of complete records.
+    streamoff valid_size = file.tellg();
+
+    size_t finished_tile_count = 0;
+
+    while (read_record(file, message))
+    {
+        size_t tile_x, tile_y;
+        if (message.m_type != TileDataMessage ||
+            !read_tile(message, frame, tile_x, tile_y))
+        {
+            LOG_ERROR(logger, "checkpoint file %s is corrupted.", checkpoint_path.c_str());
+            return false;
+        }
+
+        const size_t tile_index = tile_y * frame.image().properties().m_tile_count_x + tile_x;
+        if (!finished_tiles[tile_index])
+        {
+            finished_tiles[tile_index] = true;
+            ++finished_tile_count;
+        }
+
+        valid_size = file.tellg();
+    }
+
+    file.close();
+
+    // Drop a tile that was only partially written when the render was interrupted.
+    if (static_cast<boost::uintmax_t>(valid_size) < bf::file_size(checkpoint_path))
+    {
+        LOG_WARNING(logger, "discarding the truncated last tile of checkpoint file %s.", checkpoint_path.c_str());
+        bf::resize_file(checkpoint_path, static_cast<boost::uintmax_t>(valid_size));
+    }
+
+    LOG_INFO(
+        logger,
+        "resuming from checkpoint file %s, %s %s finished.",
+        checkpoint_path.c_str(),
+        pretty_uint(finished_tile_count).c_str(),
+        plural(finished_tile_count, "tile").c_str());
+
+    return true;
+}
+
+
+//
+// ResumeTileSource class implementation.
+//
+
+ResumeTileSource::ResumeTileSource(
+    const Frame&                frame,
+    const vector<bool>&         finished_tiles)
+  : m_tile_count_x(frame.image().properties().m_tile_count_x)
+  , m_next_tile(0)
+{
+    vector<size_t> tiles;
+    TileJobFactory tile_job_factory;
+    tile_job_factory.generate_tile_ordering(
+        frame.image().properties(),
+        TileJobFactory::SpiralOrdering,
+        tiles);
+
+    for (size_t i = 0; i < tiles.size(); ++i)
+    {
+        const size_t tile_x = tiles[i] % m_tile_count_x;
+        const size_t tile_y = tiles[i] / m_tile_count_x;
+
+        if (!finished_tiles[tiles[i]] && intersects_crop_window(frame, tile_x, tile_y))
+            m_tiles.push_back(tiles[i]);
+    }
+}
+
+void ResumeTileSource::release()
+{
+    delete this;
+}
+
+bool ResumeTileSource::acquire_tile(
+    size_t&                     tile_x,
+    size_t&                     tile_y,
+    IAbortSwitch&               abort_switch)
+{
+    // Start over with the next pass.
+    if (m_next_tile == m_tiles.size())
+    {
+        m_next_tile = 0;
+        return false;
+    }
+
+    const size_t tile = m_tiles[m_next_tile++];
+    tile_x = tile % m_tile_count_x;
+    tile_y = tile / m_tile_count_x;
+
+    return true;
+}
+
+}   // namespace cli
+}   // namespace appleseed
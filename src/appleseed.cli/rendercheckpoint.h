@@ -0,0 +1,129 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_CLI_RENDERCHECKPOINT_H
+#define APPLESEED_CLI_RENDERCHECKPOINT_H
+
+// appleseed.renderer headers.
+#include "renderer/api/rendering.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+
+// Standard headers.
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class Logger; }
+namespace renderer      { class Frame; }
+
+namespace appleseed {
+namespace cli {
+
+//
+// Render checkpoints.
+//
+// A checkpoint file holds the layout of the frame followed by the pixels of the
+// finished tiles (main image and AOVs), in the message encoding of distributed
+// renders. Tiles are appended and flushed to disk as soon as they are finished,
+// so an interrupted render leaves a checkpoint with all the tiles finished so far.
+// A truncated last tile is discarded when the checkpoint is loaded.
+//
+
+class CheckpointTileCallback;
+
+class CheckpointTileCallbackFactory
+  : public renderer::ITileCallbackFactory
+{
+  public:
+    // A tile is finished once it was rendered 'pass_count' times. Tiles are also
+    // forwarded to the callback of 'tile_callback_factory' (which may be 0), which
+    // is owned by the checkpoint factory.
+    // If 'resume' is true, tiles are appended to an existing checkpoint file.
+    CheckpointTileCallbackFactory(
+        const renderer::Frame&              frame,
+        const std::string&                  checkpoint_path,
+        const size_t                        pass_count,
+        const bool                          resume,
+        renderer::ITileCallbackFactory*     tile_callback_factory,
+        foundation::Logger&                 logger);
+
+    ~CheckpointTileCallbackFactory();
+
+    virtual void release() APPLESEED_OVERRIDE;
+
+    virtual renderer::ITileCallback* create() APPLESEED_OVERRIDE;
+
+    // Return true if the checkpoint file could be opened for writing.
+    bool is_open() const;
+
+  private:
+    std::auto_ptr<renderer::ITileCallbackFactory>   m_tile_callback_factory;
+    std::auto_ptr<CheckpointTileCallback>           m_callback;
+};
+
+// Load the tiles of a checkpoint file into a frame. On return, 'finished_tiles'
+// holds one entry per tile of the frame, true for the tiles that were loaded.
+// Return false if the checkpoint cannot be read or belongs to another frame.
+bool load_checkpoint(
+    const std::string&                      checkpoint_path,
+    const renderer::Frame&                  frame,
+    std::vector<bool>&                      finished_tiles,
+    foundation::Logger&                     logger);
+
+//
+// A tile source handing out, in each pass, the tiles of a frame that are not finished.
+//
+
+class ResumeTileSource
+  : public renderer::ITileSource
+{
+  public:
+    ResumeTileSource(
+        const renderer::Frame&              frame,
+        const std::vector<bool>&            finished_tiles);
+
+    virtual void release() APPLESEED_OVERRIDE;
+
+    virtual bool acquire_tile(
+        size_t&                             tile_x,
+        size_t&                             tile_y,
+        foundation::IAbortSwitch&           abort_switch) APPLESEED_OVERRIDE;
+
+  private:
+    const size_t                            m_tile_count_x;
+    std::vector<size_t>                     m_tiles;
+    size_t                                  m_next_tile;
+};
+
+}       // namespace cli
+}       // namespace appleseed
+
+#endif  // !APPLESEED_CLI_RENDERCHECKPOINT_H
@@ -0,0 +1,726 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "renderserver.h"
+
+// appleseed.cli headers.
+#include "deltaframesequence.h"
+#include "distributedprotocol.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/frame.h"
+#include "renderer/api/project.h"
+#include "renderer/api/rendering.h"
+#include "renderer/api/utility.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/timers.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/log.h"
+#include "foundation/utility/stopwatch.h"
+#include "foundation/utility/string.h"
+
+// Boost headers.
+#include "boost/asio/connect.hpp"
+#include "boost/asio/io_service.hpp"
+#include "boost/asio/ip/address_v4.hpp"
+#include "boost/asio/ip/tcp.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+#include "boost/system/error_code.hpp"
+#include "boost/system/system_error.hpp"
+
+// Standard headers.
+#include <ctime>
+#include <list>
+#include <memory>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+namespace asio = boost::asio;
+namespace bf = boost::filesystem;
+using boost::asio::ip::tcp;
+
+namespace appleseed {
+namespace cli {
+
+namespace
+{
+    //
+    // Encoding of render jobs.
+    //
+
+    void append_render_job(const RenderJob& job, DistributedMessage& message)
+    {
+        message.append_string(job.m_project_filepath);
+        message.append_string(job.m_deltas_filepath);
+        message.append_uint32(static_cast<uint32>(job.m_deltas_frame));
+        message.append_string(job.m_output_filepath);
+        message.append_uint32(static_cast<uint32>(job.m_parameters.size()));
+
+        for (size_t i = 0; i < job.m_parameters.size(); ++i)
+            message.append_string(job.m_parameters[i]);
+    }
+
+    bool read_render_job(const DistributedMessage& message, RenderJob& job)
+    {
+        size_t offset = 0;
+        uint32 deltas_frame, parameter_count;
+
+        if (!message.read_string(offset, job.m_project_filepath) ||
+            !message.read_string(offset, job.m_deltas_filepath) ||
+            !message.read_uint32(offset, deltas_frame) ||
+            !message.read_string(offset, job.m_output_filepath) ||
+            !message.read_uint32(offset, parameter_count))
+            return false;
+
+        job.m_deltas_frame = deltas_frame;
+        job.m_parameters.clear();
+
+        for (uint32 i = 0; i < parameter_count; ++i)
+        {
+            string parameter;
+            if (!message.read_string(offset, parameter))
+                return false;
+            job.m_parameters.push_back(parameter);
+        }
+
+        return offset == message.m_payload.size();
+    }
+
+
+    //
+    // Connection to the client of the job being rendered, shared by the rendering threads.
+    //
+
+    class ClientConnection
+      : public NonCopyable
+    {
+      public:
+        explicit ClientConnection(Logger& logger)
+          : m_logger(logger)
+          , m_socket(0)
+          , m_is_lost(false)
+        {
+        }
+
+        void attach(tcp::socket& socket)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_socket = &socket;
+            m_is_lost = false;
+        }
+
+        void detach()
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_socket = 0;
+        }
+
+        // Send a message to the client. Return false if the connection is lost.
+        bool send(const DistributedMessage& message)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+
+            if (m_socket == 0 || m_is_lost)
+                return false;
+
+            try
+            {
+                send_message(*m_socket, message);
+                return true;
+            }
+            catch (const boost::system::system_error& e)
+            {
+                LOG_ERROR(m_logger, "lost connection to the client: %s.", e.what());
+                m_is_lost = true;
+                return false;
+            }
+        }
+
+        void send_tile(
+            const Frame&        frame,
+            const size_t        tile_x,
+            const size_t        tile_y)
+        {
+            DistributedMessage message(TileDataMessage);
+            append_tile(frame, tile_x, tile_y, message);
+            send(message);
+        }
+
+        bool is_lost() const
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            return m_is_lost;
+        }
+
+      private:
+        Logger&                 m_logger;
+        mutable boost::mutex    m_mutex;
+        tcp::socket*            m_socket;
+        bool                    m_is_lost;
+    };
+
+
+    //
+    // Tile callback streaming rendered tiles to the client.
+    //
+
+    class ServerTileCallback
+      : public TileCallbackBase
+    {
+      public:
+        explicit ServerTileCallback(ClientConnection& connection)
+          : m_connection(connection)
+        {
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            // Do nothing.
+        }
+
+        virtual void post_render_tile(
+            const Frame*        frame,
+            const size_t        tile_x,
+            const size_t        tile_y) APPLESEED_OVERRIDE
+        {
+            m_connection.send_tile(*frame, tile_x, tile_y);
+        }
+
+        virtual void post_render(const Frame* frame) APPLESEED_OVERRIDE
+        {
+            // Progressive renders update the whole frame at once.
+            const CanvasProperties& props = frame->image().properties();
+            for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+            {
+                for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+                    m_connection.send_tile(*frame, tx, ty);
+            }
+        }
+
+      private:
+        ClientConnection&       m_connection;
+    };
+
+
+    //
+    // Tile callback factory returning the same tile callback to all rendering threads.
+    //
+
+    class ServerTileCallbackFactory
+      : public ITileCallbackFactory
+    {
+      public:
+        explicit ServerTileCallbackFactory(ClientConnection& connection)
+          : m_callback(connection)
+        {
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            // Do nothing.
+        }
+
+        virtual ITileCallback* create() APPLESEED_OVERRIDE
+        {
+            return &m_callback;
+        }
+
+      private:
+        ServerTileCallback      m_callback;
+    };
+
+
+    //
+    // Renderer controller aborting the render when the client goes away.
+    //
+
+    class ServerRendererController
+      : public DefaultRendererController
+    {
+      public:
+        explicit ServerRendererController(const ClientConnection& connection)
+          : m_connection(connection)
+        {
+        }
+
+        virtual Status get_status() const APPLESEED_OVERRIDE
+        {
+            return m_connection.is_lost() ? AbortRendering : ContinueRendering;
+        }
+
+      private:
+        const ClientConnection& m_connection;
+    };
+
+
+    //
+    // A project kept loaded between jobs.
+    //
+
+    struct ResidentProject
+      : public NonCopyable
+    {
+        string                          m_filepath;
+        time_t                          m_write_time;
+        auto_release_ptr<Project>       m_project;
+        ParamArray                      m_params;
+
+        // Declared last so that it is destroyed before the project.
+        auto_ptr<MasterRenderer>        m_renderer;
+    };
+
+
+    //
+    // The render server.
+    //
+
+    class RenderServer
+      : public NonCopyable
+    {
+      public:
+        RenderServer(
+            const size_t                    max_resident_projects,
+            IRenderServerProjectLoader&     loader,
+            Logger&                         logger)
+          : m_max_resident_projects(max_resident_projects > 0 ? max_resident_projects : 1)
+          , m_loader(loader)
+          , m_logger(logger)
+          , m_acceptor(m_io_service)
+          , m_connection(logger)
+          , m_tile_callback_factory(m_connection)
+          , m_renderer_controller(m_connection)
+          , m_is_shutting_down(false)
+        {
+        }
+
+        ~RenderServer()
+        {
+            while (!m_projects.empty())
+                unload_least_recently_used_project();
+        }
+
+        bool run(const unsigned short port)
+        {
+            try
+            {
+                // Only accept local clients: jobs name files on this machine.
+                const tcp::endpoint endpoint(asio::ip::address_v4::loopback(), port);
+                m_acceptor.open(endpoint.protocol());
+                m_acceptor.set_option(tcp::acceptor::reuse_address(true));
+                m_acceptor.bind(endpoint);
+                m_acceptor.listen();
+            }
+            catch (const boost::system::system_error& e)
+            {
+                LOG_ERROR(m_logger, "could not listen on port %u: %s.", static_cast<unsigned int>(port), e.what());
+                return false;
+            }
+
+            LOG_INFO(
+                m_logger,
+                "render server waiting for jobs on port %u, keeping up to %s project%s loaded...",
+                static_cast<unsigned int>(port),
+                pretty_uint(m_max_resident_projects).c_str(),
+                m_max_resident_projects > 1 ? "s" : "");
+
+            while (!m_is_shutting_down)
+            {
+                tcp::socket socket(m_io_service);
+
+                boost::system::error_code error;
+                m_acceptor.accept(socket, error);
+
+                if (error)
+                {
+                    LOG_WARNING(m_logger, "could not accept a client: %s.", error.message().c_str());
+                    continue;
+                }
+
+                serve_client(socket);
+
+                socket.shutdown(tcp::socket::shutdown_both, error);
+                socket.close(error);
+            }
+
+            LOG_INFO(m_logger, "render server shutting down.");
+
+            return true;
+        }
+
+      private:
+        typedef list<ResidentProject*> ResidentProjectList;
+
+        const size_t                    m_max_resident_projects;
+        IRenderServerProjectLoader&     m_loader;
+        Logger&                         m_logger;
+        asio::io_service                m_io_service;
+        tcp::acceptor                   m_acceptor;
+        ClientConnection                m_connection;
+        ServerTileCallbackFactory       m_tile_callback_factory;
+        ServerRendererController        m_renderer_controller;
+        ResidentProjectList             m_projects;             // most recently used first
+        bool                            m_is_shutting_down;
+
+        void serve_client(tcp::socket& socket)
+        {
+            while (true)
+            {
+                DistributedMessage message;
+
+                try
+                {
+                    receive_message(socket, message);
+                }
+                catch (const boost::system::system_error&)
+                {
+                    // The client disconnected.
+                    return;
+                }
+
+                switch (message.m_type)
+                {
+                  case RenderJobMessage:
+                    {
+                        RenderJob job;
+                        if (!read_render_job(message, job))
+                        {
+                            LOG_WARNING(m_logger, "received a malformed render job.");
+                            return;
+                        }
+
+                        m_connection.attach(socket);
+                        const bool success = render_job(job);
+
+                        DistributedMessage reply(JobFinishedMessage);
+                        reply.append_uint32(success ? 1 : 0);
+                        const bool sent = m_connection.send(reply);
+                        m_connection.detach();
+
+                        if (!sent)
+                            return;
+                    }
+                    break;
+
+                  case ShutdownMessage:
+                    m_is_shutting_down = true;
+                    return;
+
+                  default:
+                    LOG_WARNING(m_logger, "received an unexpected message from a client.");
+                    return;
+                }
+            }
+        }
+
+        bool render_job(const RenderJob& job)
+        {
+            LOG_INFO(m_logger, "received a render job for project %s.", job.m_project_filepath.c_str());
+
+            ResidentProject* resident = acquire_project(job.m_project_filepath);
+            if (resident == 0)
+                return false;
+
+            Project& project = resident->m_project.ref();
+
+            // Apply the deltas to the resident project.
+            if (!job.m_deltas_filepath.empty())
+            {
+                DeltaFrameSequence deltas(
+                    string(),
+                    false,
+                    job.m_deltas_frame,
+                    job.m_deltas_frame,
+                    m_logger);
+
+                if (!deltas.read(job.m_deltas_filepath.c_str()) ||
+                    !deltas.on_frame_begin(project, 0))
+                    return false;
+            }
+
+            // Apply the parameters of the job on top of the project configuration.
+            ParamArray params = resident->m_params;
+            for (size_t i = 0; i < job.m_parameters.size(); ++i)
+            {
+                const string& s = job.m_parameters[i];
+                const string::size_type equal_pos = s.find_first_of('=');
+                if (equal_pos == string::npos)
+                {
+                    LOG_ERROR(m_logger, "invalid parameter \"%s\", expected name=value.", s.c_str());
+                    return false;
+                }
+
+                params.insert_path(s.substr(0, equal_pos), s.substr(equal_pos + 1));
+            }
+
+            // Keep the texture cache warm for the next job.
+            params.insert_path("texture_store.keep_between_renders", true);
+
+            MasterRenderer& renderer = *resident->m_renderer;
+            renderer.get_parameters() = params;
+
+            // Tell the client what the tiles it is about to receive look like.
+            DistributedMessage started(JobStartedMessage);
+            append_frame_layout(*project.get_frame(), started);
+            if (!m_connection.send(started))
+                return false;
+
+            Stopwatch<DefaultWallclockTimer> stopwatch;
+            stopwatch.start();
+
+            if (!renderer.render() || m_connection.is_lost())
+                return false;
+
+            stopwatch.measure();
+            LOG_INFO(m_logger, "rendering finished in %s.", pretty_time(stopwatch.get_seconds(), 3).c_str());
+
+            if (!job.m_output_filepath.empty())
+            {
+                const Frame* frame = project.get_frame();
+                if (!frame->write_main_image(job.m_output_filepath.c_str()) ||
+                    !frame->write_aov_images(job.m_output_filepath.c_str()))
+                    return false;
+            }
+
+            return true;
+        }
+
+        // Return the resident project for a given file, loading it if needed. Return 0 on failure.
+        ResidentProject* acquire_project(const string& filepath)
+        {
+            time_t write_time;
+
+            try
+            {
+                write_time = bf::last_write_time(filepath);
+            }
+            catch (const bf::filesystem_error& e)
+            {
+                LOG_ERROR(m_logger, "could not access project file %s: %s.", filepath.c_str(), e.what());
+                return 0;
+            }
+
+            for (ResidentProjectList::iterator i = m_projects.begin(); i != m_projects.end(); ++i)
+            {
+                if ((*i)->m_filepath != filepath)
+                    continue;
+
+                if ((*i)->m_write_time == write_time)
+                {
+                    LOG_INFO(m_logger, "reusing resident project %s.", filepath.c_str());
+                    m_projects.splice(m_projects.begin(), m_projects, i);
+                    return m_projects.front();
+                }
+
+                LOG_INFO(m_logger, "project %s changed on disk, reloading it.", filepath.c_str());
+                delete *i;
+                m_projects.erase(i);
+                break;
+            }
+
+            auto_ptr<ResidentProject> resident(new ResidentProject());
+            resident->m_filepath = filepath;
+            resident->m_write_time = write_time;
+
+            auto_release_ptr<Project> project = m_loader.load(filepath);
+            if (project.get() == 0)
+                return 0;
+            resident->m_project = project;
+
+            if (!m_loader.configure(resident->m_project.ref(), resident->m_params))
+                return 0;
+
+            resident->m_renderer.reset(
+                new MasterRenderer(
+                    resident->m_project.ref(),
+                    resident->m_params,
+                    &m_renderer_controller,
+                    &m_tile_callback_factory));
+
+            while (m_projects.size() >= m_max_resident_projects)
+                unload_least_recently_used_project();
+
+            m_projects.push_front(resident.release());
+            return m_projects.front();
+        }
+
+        void unload_least_recently_used_project()
+        {
+            ResidentProject* resident = m_projects.back();
+            LOG_INFO(m_logger, "unloading project %s.", resident->m_filepath.c_str());
+            delete resident;
+            m_projects.pop_back();
+        }
+    };
+
+
+    //
+    // Client side.
+    //
+
+    bool connect_to_render_server(
+        asio::io_service&   io_service,
+        tcp::socket&        socket,
+        const char*         host,
+        const char*         port,
+        Logger&             logger)
+    {
+        try
+        {
+            tcp::resolver resolver(io_service);
+            asio::connect(socket, resolver.resolve(tcp::resolver::query(host, port)));
+            return true;
+        }
+        catch (const boost::system::system_error& e)
+        {
+            LOG_ERROR(logger, "could not connect to the render server at %s:%s: %s.", host, port, e.what());
+            return false;
+        }
+    }
+}
+
+bool run_render_server(
+    const unsigned short            port,
+    const size_t                    max_resident_projects,
+    IRenderServerProjectLoader&     loader,
+    Logger&                         logger)
+{
+    RenderServer server(max_resident_projects, loader, logger);
+    return server.run(port);
+}
+
+bool submit_render_job(
+    const char*                     host,
+    const char*                     port,
+    const RenderJob&                job,
+    Logger&                         logger)
+{
+    asio::io_service io_service;
+    tcp::socket socket(io_service);
+
+    if (!connect_to_render_server(io_service, socket, host, port, logger))
+        return false;
+
+    // The server may run in another directory.
+    RenderJob absolute_job(job);
+    absolute_job.m_project_filepath = bf::absolute(job.m_project_filepath).string();
+    if (!job.m_deltas_filepath.empty())
+        absolute_job.m_deltas_filepath = bf::absolute(job.m_deltas_filepath).string();
+    if (!job.m_output_filepath.empty())
+        absolute_job.m_output_filepath = bf::absolute(job.m_output_filepath).string();
+
+    try
+    {
+        DistributedMessage request(RenderJobMessage);
+        append_render_job(absolute_job, request);
+        send_message(socket, request);
+
+        LOG_INFO(logger, "submitted render job for project %s.", absolute_job.m_project_filepath.c_str());
+
+        size_t tile_count = 0;
+
+        while (true)
+        {
+            DistributedMessage message;
+            receive_message(socket, message);
+
+            switch (message.m_type)
+            {
+              case JobStartedMessage:
+                LOG_INFO(logger, "render job started.");
+                break;
+
+              case TileDataMessage:
+                ++tile_count;
+                break;
+
+              case JobFinishedMessage:
+                {
+                    size_t offset = 0;
+                    uint32 success = 0;
+                    message.read_uint32(offset, success);
+
+                    if (success)
+                    {
+                        LOG_INFO(
+                            logger,
+                            "render job succeeded, received %s tile%s.",
+                            pretty_uint(tile_count).c_str(),
+                            tile_count > 1 ? "s" : "");
+                    }
+                    else LOG_ERROR(logger, "render job failed, see the render server log for details.");
+
+                    return success != 0;
+                }
+
+              default:
+                LOG_ERROR(logger, "received an unexpected message from the render server.");
+                return false;
+            }
+        }
+    }
+    catch (const boost::system::system_error& e)
+    {
+        LOG_ERROR(logger, "lost connection to the render server: %s.", e.what());
+        return false;
+    }
+}
+
+bool shutdown_render_server(
+    const char*                     host,
+    const char*                     port,
+    Logger&                         logger)
+{
+    asio::io_service io_service;
+    tcp::socket socket(io_service);
+
+    if (!connect_to_render_server(io_service, socket, host, port, logger))
+        return false;
+
+    try
+    {
+        send_message(socket, DistributedMessage(ShutdownMessage));
+        return true;
+    }
+    catch (const boost::system::system_error& e)
+    {
+        LOG_ERROR(logger, "could not send the shutdown request: %s.", e.what());
+        return false;
+    }
+}
+
+}   // namespace cli
+}   // namespace appleseed
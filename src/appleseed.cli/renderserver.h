@@ -0,0 +1,118 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_CLI_RENDERSERVER_H
+#define APPLESEED_CLI_RENDERSERVER_H
+
+// appleseed.foundation headers.
+#include "foundation/utility/autoreleaseptr.h"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class Logger; }
+namespace renderer      { class ParamArray; }
+namespace renderer      { class Project; }
+
+namespace appleseed {
+namespace cli {
+
+//
+// Loads and configures the projects rendered by a render server.
+//
+
+class IRenderServerProjectLoader
+{
+  public:
+    // Destructor.
+    virtual ~IRenderServerProjectLoader() {}
+
+    // Load a project from disk. Return an empty pointer on failure.
+    virtual foundation::auto_release_ptr<renderer::Project> load(
+        const std::string&                  project_filepath) = 0;
+
+    // Retrieve the rendering parameters of a project. Return false on failure.
+    virtual bool configure(
+        renderer::Project&                  project,
+        renderer::ParamArray&               params) = 0;
+};
+
+//
+// A render job submitted to a render server.
+//
+
+struct RenderJob
+{
+    std::string                 m_project_filepath;     // absolute path to the project file
+    std::string                 m_deltas_filepath;      // delta file applied before rendering, may be empty
+    size_t                      m_deltas_frame;         // deltas up to this frame are applied
+    std::string                 m_output_filepath;      // image file written by the server, may be empty
+    std::vector<std::string>    m_parameters;           // rendering parameters overrides, as path=value
+
+    RenderJob()
+      : m_deltas_frame(0)
+    {
+    }
+};
+
+// Serve the render jobs submitted to a given TCP port of the local host, one
+// at a time, until a client asks the server to shut down. Up to 'max_resident_projects'
+// projects are kept loaded, along with their scene preparation, acceleration structures
+// and texture cache, so that successive jobs on the same project skip them; the least
+// recently used project is unloaded first, and a project is reloaded when its file
+// changes. Deltas applied by a job remain in effect for the following jobs until the
+// project is reloaded. The tiles of the frame are streamed to the client as they are
+// rendered. Return false if the server could not start.
+bool run_render_server(
+    const unsigned short                    port,
+    const size_t                            max_resident_projects,
+    IRenderServerProjectLoader&             loader,
+    foundation::Logger&                     logger);
+
+// Submit a render job to a render server and wait until it is done.
+// Return true if the job succeeded.
+bool submit_render_job(
+    const char*                             host,
+    const char*                             port,
+    const RenderJob&                        job,
+    foundation::Logger&                     logger);
+
+// Ask a render server to shut down. Return true if the request was sent.
+bool shutdown_render_server(
+    const char*                             host,
+    const char*                             port,
+    foundation::Logger&                     logger);
+
+}       // namespace cli
+}       // namespace appleseed
+
+#endif  // !APPLESEED_CLI_RENDERSERVER_H
@@ -0,0 +1,320 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "sharedmemorytilecallback.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/aov.h"
+#include "renderer/api/frame.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/utility/log.h"
+#include "foundation/utility/string.h"
+
+// Boost headers.
+#include "boost/interprocess/exceptions.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+#include "boost/interprocess/shared_memory_object.hpp"
+#include "boost/interprocess/sync/scoped_lock.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <new>
+#include <string>
+
+using namespace boost;
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+namespace appleseed {
+namespace cli {
+
+//
+// SharedMemoryTileCallback class implementation.
+//
+
+class SharedMemoryTileCallback
+  : public TileCallbackBase
+{
+  public:
+    SharedMemoryTileCallback(
+        const char*             name,
+        const Frame&            frame,
+        const size_t            slot_count,
+        Logger&                 logger)
+      : m_name(name)
+      , m_logger(logger)
+      , m_header(0)
+      , m_slots(0)
+    {
+        const CanvasProperties& props = frame.image().properties();
+        const ImageStack& aov_images = frame.aov_images();
+
+        size_t max_channel_count = props.m_channel_count;
+        for (size_t i = 0; i < aov_images.size(); ++i)
+        {
+            max_channel_count =
+                max(max_channel_count, aov_images.get_image(i).properties().m_channel_count);
+        }
+
+        // Keep the pixels of every slot aligned on a cache line.
+        const size_t slot_size =
+            align(sizeof(SharedMemoryTileSlot), CacheLineSize) +
+            align(props.m_tile_width * props.m_tile_height * max_channel_count * sizeof(float), CacheLineSize);
+        const size_t header_size = align(sizeof(SharedMemoryTileHeader), CacheLineSize);
+
+        // Writers must not wrap around the ring while another writer still fills a slot.
+        m_slot_count = max<size_t>(slot_count, 2 * MaxWriterCount);
+        m_slot_size = slot_size;
+
+        try
+        {
+            interprocess::shared_memory_object::remove(name);
+
+            m_shared_memory.reset(
+                new interprocess::shared_memory_object(
+                    interprocess::create_only,
+                    name,
+                    interprocess::read_write));
+            m_shared_memory->truncate(
+                static_cast<interprocess::offset_t>(header_size + m_slot_count * m_slot_size));
+
+            m_region.reset(
+                new interprocess::mapped_region(
+                    *m_shared_memory,
+                    interprocess::read_write));
+        }
+        catch (const interprocess::interprocess_exception& e)
+        {
+            LOG_ERROR(
+                m_logger,
+                "could not create shared memory segment %s: %s.",
+                name,
+                e.what());
+
+            m_region.reset();
+            m_shared_memory.reset();
+            interprocess::shared_memory_object::remove(name);
+            return;
+        }
+
+        uint8* base = static_cast<uint8*>(m_region->get_address());
+        m_header = new (base) SharedMemoryTileHeader();
+        m_header->m_magic = SharedMemoryTileHeader::Magic;
+        m_header->m_version = SharedMemoryTileHeader::Version;
+        m_header->m_canvas_width = static_cast<uint32>(props.m_canvas_width);
+        m_header->m_canvas_height = static_cast<uint32>(props.m_canvas_height);
+        m_header->m_tile_width = static_cast<uint32>(props.m_tile_width);
+        m_header->m_tile_height = static_cast<uint32>(props.m_tile_height);
+        m_header->m_plane_count = static_cast<uint32>(1 + aov_images.size());
+        m_header->m_slot_count = static_cast<uint32>(m_slot_count);
+        m_header->m_slot_size = static_cast<uint32>(m_slot_size);
+        m_header->m_closed = 0;
+        m_header->m_reserved_count = 0;
+        m_header->m_committed_count = 0;
+
+        m_slots = base + header_size;
+        for (size_t i = 0; i < m_slot_count; ++i)
+            new (m_slots + i * m_slot_size) SharedMemoryTileSlot();
+
+        LOG_INFO(
+            m_logger,
+            "streaming tiles to shared memory segment %s (%s slots).",
+            name,
+            pretty_uint(m_slot_count).c_str());
+    }
+
+    ~SharedMemoryTileCallback()
+    {
+        if (m_header)
+        {
+            close();
+            m_region.reset();
+            m_shared_memory.reset();
+            interprocess::shared_memory_object::remove(m_name.c_str());
+        }
+    }
+
+    bool is_open() const
+    {
+        return m_header != 0;
+    }
+
+    void close()
+    {
+        if (m_header)
+        {
+            interprocess::scoped_lock<interprocess::interprocess_mutex> lock(m_header->m_mutex);
+            m_header->m_closed = 1;
+            m_header->m_tile_committed.notify_all();
+        }
+    }
+
+    virtual void release() APPLESEED_OVERRIDE
+    {
+        // Do nothing.
+    }
+
+    virtual void post_render_tile(
+        const Frame*            frame,
+        const size_t            tile_x,
+        const size_t            tile_y) APPLESEED_OVERRIDE
+    {
+        write_tile(*frame, tile_x, tile_y);
+    }
+
+    virtual void post_render(const Frame* frame) APPLESEED_OVERRIDE
+    {
+        const CanvasProperties& props = frame->image().properties();
+
+        for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+        {
+            for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+                write_tile(*frame, tx, ty);
+        }
+    }
+
+  private:
+    enum { CacheLineSize = 64, MaxWriterCount = 64 };
+
+    const string                                        m_name;
+    Logger&                                             m_logger;
+    auto_ptr<interprocess::shared_memory_object>        m_shared_memory;
+    auto_ptr<interprocess::mapped_region>               m_region;
+    SharedMemoryTileHeader*                             m_header;
+    uint8*                                              m_slots;
+    size_t                                              m_slot_count;
+    size_t                                              m_slot_size;
+
+    static size_t align(const size_t size, const size_t alignment)
+    {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    void write_tile(
+        const Frame&            frame,
+        const size_t            tile_x,
+        const size_t            tile_y)
+    {
+        if (m_header == 0)
+            return;
+
+        write_tile(frame.image(), tile_x, tile_y, 0);
+
+        const ImageStack& aov_images = frame.aov_images();
+        for (size_t i = 0; i < aov_images.size(); ++i)
+            write_tile(aov_images.get_image(i), tile_x, tile_y, i + 1);
+    }
+
+    void write_tile(
+        const Image&            image,
+        const size_t            tile_x,
+        const size_t            tile_y,
+        const size_t            plane_index)
+    {
+        const CanvasProperties& props = image.properties();
+        const Tile& tile = image.tile(tile_x, tile_y);
+
+        // Reserve a slot and invalidate it for the time it is being written.
+        uint64 index;
+        SharedMemoryTileSlot* slot;
+        {
+            interprocess::scoped_lock<interprocess::interprocess_mutex> lock(m_header->m_mutex);
+            index = m_header->m_reserved_count++;
+            slot = reinterpret_cast<SharedMemoryTileSlot*>(m_slots + (index % m_slot_count) * m_slot_size);
+            slot->m_sequence = 0;
+        }
+
+        slot->m_plane_index = static_cast<uint32>(plane_index);
+        slot->m_channel_count = static_cast<uint32>(tile.get_channel_count());
+        slot->m_x = static_cast<uint32>(tile_x * props.m_tile_width);
+        slot->m_y = static_cast<uint32>(tile_y * props.m_tile_height);
+        slot->m_width = static_cast<uint32>(tile.get_width());
+        slot->m_height = static_cast<uint32>(tile.get_height());
+
+        // Convert the pixels straight into the slot.
+        uint8* pixels = reinterpret_cast<uint8*>(slot) + align(sizeof(SharedMemoryTileSlot), CacheLineSize);
+        const Tile slot_tile(tile, PixelFormatFloat, pixels);
+
+        // Publish the slot.
+        {
+            interprocess::scoped_lock<interprocess::interprocess_mutex> lock(m_header->m_mutex);
+            slot->m_sequence = index + 1;
+            ++m_header->m_committed_count;
+            m_header->m_tile_committed.notify_all();
+        }
+    }
+};
+
+
+//
+// SharedMemoryTileCallbackFactory class implementation.
+//
+
+SharedMemoryTileCallbackFactory::SharedMemoryTileCallbackFactory(
+    const char*                 name,
+    const Frame&                frame,
+    const size_t                slot_count,
+    Logger&                     logger)
+  : m_callback(
+        new SharedMemoryTileCallback(
+            name,
+            frame,
+            slot_count,
+            logger))
+{
+}
+
+SharedMemoryTileCallbackFactory::~SharedMemoryTileCallbackFactory()
+{
+}
+
+void SharedMemoryTileCallbackFactory::release()
+{
+    delete this;
+}
+
+ITileCallback* SharedMemoryTileCallbackFactory::create()
+{
+    return m_callback.get();
+}
+
+bool SharedMemoryTileCallbackFactory::is_open() const
+{
+    return m_callback->is_open();
+}
+
+}   // namespace cli
+}   // namespace appleseed
@@ -0,0 +1,143 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_CLI_SHAREDMEMORYTILECALLBACK_H
+#define APPLESEED_CLI_SHAREDMEMORYTILECALLBACK_H
+
+// appleseed.renderer headers.
+#include "renderer/api/rendering.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+
+// Boost headers.
+#include "boost/interprocess/sync/interprocess_condition.hpp"
+#include "boost/interprocess/sync/interprocess_mutex.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <memory>
+
+// Forward declarations.
+namespace foundation    { class Logger; }
+namespace renderer      { class Frame; }
+
+namespace appleseed {
+namespace cli {
+
+//
+// Shared memory tile transport.
+//
+// Rendered tiles (main image and AOVs) are converted to 32-bit floating point pixels
+// straight into a ring buffer of fixed-size tile slots living in a named shared memory
+// segment, from which viewers read them without any further copy or serialization.
+//
+// The segment starts with a SharedMemoryTileHeader, followed by slot_count slots of
+// slot_size bytes each. Every slot starts with a SharedMemoryTileSlot header, followed
+// by the pixels of the tile, row after row, with no padding.
+//
+// Writers never wait for readers: a reader that falls behind by more than slot_count
+// tiles loses the oldest ones. To read tiles:
+//
+//   1. lock the header mutex, wait on the condition until committed_count changes,
+//      then unlock;
+//   2. read the slots whose sequence number is greater than the last one seen;
+//   3. read the sequence number of each slot again after having read its pixels: if
+//      it changed, the slot was overwritten in the meantime and must be discarded.
+//
+// A sequence number of 0 denotes a slot that was never written or is being written.
+//
+
+struct SharedMemoryTileHeader
+{
+    enum { Magic = 0x4153544D, Version = 1 };   // 'ASTM'
+
+    foundation::uint32                                  m_magic;
+    foundation::uint32                                  m_version;
+    foundation::uint32                                  m_canvas_width;
+    foundation::uint32                                  m_canvas_height;
+    foundation::uint32                                  m_tile_width;
+    foundation::uint32                                  m_tile_height;
+    foundation::uint32                                  m_plane_count;      // main image + AOVs
+    foundation::uint32                                  m_slot_count;
+    foundation::uint32                                  m_slot_size;        // in bytes, including the slot header
+    foundation::uint32                                  m_closed;           // 1 once rendering is finished
+
+    boost::interprocess::interprocess_mutex             m_mutex;
+    boost::interprocess::interprocess_condition         m_tile_committed;
+
+    // Protected by m_mutex.
+    foundation::uint64                                  m_reserved_count;   // number of slots handed out to writers
+    foundation::uint64                                  m_committed_count;  // number of slots completely written
+};
+
+struct SharedMemoryTileSlot
+{
+    foundation::uint64                                  m_sequence;         // 1-based write index, 0 if invalid
+    foundation::uint32                                  m_plane_index;      // 0 for the main image
+    foundation::uint32                                  m_channel_count;
+    foundation::uint32                                  m_x;                // position of the tile in the canvas, in pixels
+    foundation::uint32                                  m_y;
+    foundation::uint32                                  m_width;            // dimensions of the tile, in pixels
+    foundation::uint32                                  m_height;
+};
+
+class SharedMemoryTileCallback;
+
+class SharedMemoryTileCallbackFactory
+  : public renderer::ITileCallbackFactory
+{
+  public:
+    // Create the shared memory segment 'name', replacing any existing one of the same name.
+    SharedMemoryTileCallbackFactory(
+        const char*                 name,
+        const renderer::Frame&      frame,
+        const size_t                slot_count,
+        foundation::Logger&         logger);
+
+    // Tell the readers that rendering is finished and remove the shared memory
+    // segment. Readers keep their mapping.
+    ~SharedMemoryTileCallbackFactory();
+
+    virtual void release() APPLESEED_OVERRIDE;
+
+    virtual renderer::ITileCallback* create() APPLESEED_OVERRIDE;
+
+    // Return true if the shared memory segment could be created.
+    bool is_open() const;
+
+  private:
+    std::auto_ptr<SharedMemoryTileCallback> m_callback;
+};
+
+}       // namespace cli
+}       // namespace appleseed
+
+#endif  // !APPLESEED_CLI_SHAREDMEMORYTILECALLBACK_H
@@ -0,0 +1,290 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Interface header.
+#include "streamingoutputtilecallback.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/aov.h"
+#include "renderer/api/frame.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exception.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/image/imageattributes.h"
+#include "foundation/image/progressiveexrimagefilewriter.h"
+#include "foundation/image/tile.h"
+#include "foundation/platform/thread.h"
+#include "foundation/utility/log.h"
+
+// Standard headers.
+#include <algorithm>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+namespace appleseed {
+namespace cli {
+
+//
+// StreamingOutputTileCallback class implementation.
+//
+
+class StreamingOutputTileCallback
+  : public TileCallbackBase
+{
+  public:
+    StreamingOutputTileCallback(
+        const Frame&            frame,
+        const string&           output_path,
+        const size_t            pass_count,
+        ITileCallback*          tile_callback,
+        Logger&                 logger)
+      : m_frame(frame)
+      , m_output_path(output_path)
+      , m_pass_count(max<size_t>(pass_count, 1))
+      , m_tile_callback(tile_callback)
+      , m_logger(logger)
+      , m_render_counts(frame.image().properties().m_tile_count, 0)
+      , m_written_tiles(frame.image().properties().m_tile_count, false)
+    {
+        // The main image goes into the unnamed layer.
+        const ImageStack& aov_images = frame.aov_images();
+        vector<const char*> layer_names(1, "");
+        vector<const CanvasProperties*> layer_props(1, &frame.image().properties());
+        for (size_t i = 0; i < aov_images.size(); ++i)
+        {
+            layer_names.push_back(aov_images.get_name(i));
+            layer_props.push_back(&aov_images.get_image(i).properties());
+        }
+
+        try
+        {
+            m_writer.open(
+                output_path.c_str(),
+                layer_names.size(),
+                &layer_names[0],
+                &layer_props[0],
+                ImageAttributes::create_default_attributes());
+        }
+        catch (const Exception& e)
+        {
+            LOG_ERROR(
+                m_logger,
+                "could not open image file %s for writing: %s.",
+                output_path.c_str(),
+                e.what());
+        }
+    }
+
+    bool is_open() const
+    {
+        return m_writer.is_open();
+    }
+
+    bool finish()
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        if (!m_writer.is_open())
+            return false;
+
+        const CanvasProperties& props = m_frame.image().properties();
+
+        try
+        {
+            for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+            {
+                for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+                {
+                    if (!m_written_tiles[ty * props.m_tile_count_x + tx])
+                        write_tile(tx, ty);
+                }
+            }
+
+            m_writer.close();
+        }
+        catch (const Exception& e)
+        {
+            LOG_ERROR(
+                m_logger,
+                "failed to write image file %s: %s.",
+                m_output_path.c_str(),
+                e.what());
+
+            return false;
+        }
+
+        LOG_INFO(m_logger, "wrote image file %s.", m_output_path.c_str());
+
+        return true;
+    }
+
+    virtual void release() APPLESEED_OVERRIDE
+    {
+        // Do nothing.
+    }
+
+    virtual void pre_render(
+        const size_t            x,
+        const size_t            y,
+        const size_t            width,
+        const size_t            height) APPLESEED_OVERRIDE
+    {
+        if (m_tile_callback)
+            m_tile_callback->pre_render(x, y, width, height);
+    }
+
+    virtual void post_render_tile(
+        const Frame*            frame,
+        const size_t            tile_x,
+        const size_t            tile_y) APPLESEED_OVERRIDE
+    {
+        if (m_tile_callback)
+            m_tile_callback->post_render_tile(frame, tile_x, tile_y);
+
+        const size_t tile_index = tile_y * frame->image().properties().m_tile_count_x + tile_x;
+
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        // Only stream tiles that went through all rendering passes.
+        if (++m_render_counts[tile_index] != m_pass_count || !m_writer.is_open())
+            return;
+
+        try
+        {
+            write_tile(tile_x, tile_y);
+        }
+        catch (const Exception& e)
+        {
+            LOG_ERROR(
+                m_logger,
+                "failed to write to image file %s, streaming output disabled: %s.",
+                m_output_path.c_str(),
+                e.what());
+
+            m_writer.close();
+            return;
+        }
+
+        // Release the memory of the tile, it will no longer be needed.
+        frame->image().set_tile(tile_x, tile_y, 0);
+        ImageStack& aov_images = frame->aov_images();
+        for (size_t i = 0; i < aov_images.size(); ++i)
+            aov_images.get_image(i).set_tile(tile_x, tile_y, 0);
+    }
+
+    virtual void post_render(
+        const Frame*            frame) APPLESEED_OVERRIDE
+    {
+        if (m_tile_callback)
+            m_tile_callback->post_render(frame);
+    }
+
+  private:
+    const Frame&                        m_frame;
+    const string                        m_output_path;
+    const size_t                        m_pass_count;
+    ITileCallback*                      m_tile_callback;
+    Logger&                             m_logger;
+    boost::mutex                        m_mutex;
+    ProgressiveEXRImageFileWriter       m_writer;
+    vector<size_t>                      m_render_counts;
+    vector<bool>                        m_written_tiles;
+
+    void write_tile(const size_t tile_x, const size_t tile_y)
+    {
+        // The main image is written in the output color space.
+        // Note: AOVs are always in the linear color space.
+        Tile main_tile(m_frame.image().tile(tile_x, tile_y));
+        m_frame.transform_to_output_color_space(main_tile);
+
+        const ImageStack& aov_images = m_frame.aov_images();
+        vector<const Tile*> tiles(1, &main_tile);
+        for (size_t i = 0; i < aov_images.size(); ++i)
+            tiles.push_back(&aov_images.get_image(i).tile(tile_x, tile_y));
+
+        m_writer.write_tile(tile_x, tile_y, &tiles[0]);
+
+        m_written_tiles[tile_y * m_frame.image().properties().m_tile_count_x + tile_x] = true;
+    }
+};
+
+
+//
+// StreamingOutputTileCallbackFactory class implementation.
+//
+
+StreamingOutputTileCallbackFactory::StreamingOutputTileCallbackFactory(
+    const Frame&                frame,
+    const string&               output_path,
+    const size_t                pass_count,
+    ITileCallbackFactory*       tile_callback_factory,
+    Logger&                     logger)
+  : m_tile_callback_factory(tile_callback_factory)
+  , m_callback(
+        new StreamingOutputTileCallback(
+            frame,
+            output_path,
+            pass_count,
+            tile_callback_factory ? tile_callback_factory->create() : 0,
+            logger))
+{
+}
+
+StreamingOutputTileCallbackFactory::~StreamingOutputTileCallbackFactory()
+{
+}
+
+void StreamingOutputTileCallbackFactory::release()
+{
+    delete this;
+}
+
+ITileCallback* StreamingOutputTileCallbackFactory::create()
+{
+    return m_callback.get();
+}
+
+bool StreamingOutputTileCallbackFactory::is_open() const
+{
+    return m_callback->is_open();
+}
+
+bool StreamingOutputTileCallbackFactory::finish()
+{
+    return m_callback->finish();
+}
+
+}   // namespace cli
+}   // namespace appleseed
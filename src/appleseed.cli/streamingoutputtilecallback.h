@@ -0,0 +1,99 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef APPLESEED_CLI_STREAMINGOUTPUTTILECALLBACK_H
+#define APPLESEED_CLI_STREAMINGOUTPUTTILECALLBACK_H
+
+// appleseed.renderer headers.
+#include "renderer/api/rendering.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+
+// Standard headers.
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Forward declarations.
+namespace foundation    { class Logger; }
+namespace renderer      { class Frame; }
+
+namespace appleseed {
+namespace cli {
+
+//
+// Streaming output.
+//
+// Finished tiles (main image and AOVs) are written to a tiled, multi-layer OpenEXR
+// file as soon as they are rendered, and their memory is then released from the
+// frame. Peak frame memory is thus bounded by the tiles being rendered instead of
+// the whole frame. The main image goes into the unnamed layer, each AOV into a
+// layer named after it.
+//
+
+class StreamingOutputTileCallback;
+
+class StreamingOutputTileCallbackFactory
+  : public renderer::ITileCallbackFactory
+{
+  public:
+    // A tile is finished once it was rendered 'pass_count' times. Tiles are also
+    // forwarded to the callback of 'tile_callback_factory' (which may be 0), which
+    // is owned by the streaming factory.
+    StreamingOutputTileCallbackFactory(
+        const renderer::Frame&              frame,
+        const std::string&                  output_path,
+        const size_t                        pass_count,
+        renderer::ITileCallbackFactory*     tile_callback_factory,
+        foundation::Logger&                 logger);
+
+    ~StreamingOutputTileCallbackFactory();
+
+    virtual void release() APPLESEED_OVERRIDE;
+
+    virtual renderer::ITileCallback* create() APPLESEED_OVERRIDE;
+
+    // Return true if the output file could be opened for writing.
+    bool is_open() const;
+
+    // Write the tiles that were not rendered (for instance, outside of the crop
+    // window) and close the output file. Return true if successful.
+    bool finish();
+
+  private:
+    std::auto_ptr<renderer::ITileCallbackFactory>   m_tile_callback_factory;
+    std::auto_ptr<StreamingOutputTileCallback>      m_callback;
+};
+
+}       // namespace cli
+}       // namespace appleseed
+
+#endif  // !APPLESEED_CLI_STREAMINGOUTPUTTILECALLBACK_H
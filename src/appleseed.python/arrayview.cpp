@@ -0,0 +1,168 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "arrayview.h"
+
+// Standard headers.
+#include <cassert>
+
+namespace bpy = boost::python;
+
+namespace
+{
+    const size_t MaxDimension = 3;
+
+    // A Python object exposing an array through the buffer protocol, keeping the owner of the array alive.
+    struct ArrayView
+    {
+        PyObject_HEAD
+        PyObject*       m_owner;
+        void*           m_data;
+        const char*     m_format;
+        Py_ssize_t      m_item_size;
+        Py_ssize_t      m_size;
+        int             m_dimension;
+        bool            m_read_only;
+        Py_ssize_t      m_shape[MaxDimension];
+        Py_ssize_t      m_strides[MaxDimension];
+    };
+
+    int array_view_get_buffer(PyObject* self, Py_buffer* view, int flags)
+    {
+        ArrayView* array = reinterpret_cast<ArrayView*>(self);
+
+        if (PyBuffer_FillInfo(
+                view,
+                self,
+                array->m_data,
+                array->m_size,
+                array->m_read_only ? 1 : 0,
+                flags) != 0)
+            return -1;
+
+        if (flags & PyBUF_ND)
+        {
+            view->ndim = array->m_dimension;
+            view->shape = array->m_shape;
+            view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? array->m_strides : 0;
+            view->itemsize = array->m_item_size;
+        }
+
+        view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(array->m_format) : 0;
+
+        return 0;
+    }
+
+    void array_view_dealloc(PyObject* self)
+    {
+        Py_XDECREF(reinterpret_cast<ArrayView*>(self)->m_owner);
+        PyObject_Del(self);
+    }
+
+    PyBufferProcs g_array_view_buffer_procs;
+    PyTypeObject g_array_view_type;
+
+    PyTypeObject& get_array_view_type()
+    {
+        PyTypeObject& type = g_array_view_type;
+
+        if (!(type.tp_flags & Py_TPFLAGS_READY))
+        {
+            g_array_view_buffer_procs.bf_getbuffer = array_view_get_buffer;
+
+            reinterpret_cast<PyObject*>(&type)->ob_refcnt = 1;
+            type.tp_name = "appleseed.ArrayView";
+            type.tp_basicsize = sizeof(ArrayView);
+            type.tp_dealloc = array_view_dealloc;
+            type.tp_as_buffer = &g_array_view_buffer_procs;
+#if PY_MAJOR_VERSION == 2
+            type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER;
+#else
+            type.tp_flags = Py_TPFLAGS_DEFAULT;
+#endif
+
+            if (PyType_Ready(&type) < 0)
+                bpy::throw_error_already_set();
+        }
+
+        return type;
+    }
+}
+
+bpy::object make_array_view(
+    const bpy::object&  owner,
+    const void*         data,
+    const char*         format,
+    const size_t        item_size,
+    const size_t        dimension,
+    const size_t        shape[],
+    const bool          read_only)
+{
+    assert(dimension >= 1 && dimension <= MaxDimension);
+
+    static char EmptyArray;
+
+    ArrayView* array = PyObject_New(ArrayView, &get_array_view_type());
+    if (array == 0)
+        bpy::throw_error_already_set();
+
+    Py_INCREF(owner.ptr());
+    array->m_owner = owner.ptr();
+    array->m_data = data != 0 ? const_cast<void*>(data) : &EmptyArray;
+    array->m_format = format;
+    array->m_item_size = static_cast<Py_ssize_t>(item_size);
+    array->m_dimension = static_cast<int>(dimension);
+    array->m_read_only = read_only;
+
+    // Arrays are C-contiguous: the last dimension varies fastest.
+    Py_ssize_t stride = array->m_item_size;
+    for (size_t i = dimension; i-- > 0; )
+    {
+        array->m_shape[i] = static_cast<Py_ssize_t>(shape[i]);
+        array->m_strides[i] = stride;
+        stride *= array->m_shape[i];
+    }
+    array->m_size = stride;
+
+    const bpy::object array_obj(bpy::handle<>(reinterpret_cast<PyObject*>(array)));
+
+    return bpy::object(bpy::handle<>(PyMemoryView_FromObject(array_obj.ptr())));
+}
+
+bpy::object make_array_copy(
+    const size_t        size,
+    void*&              data)
+{
+    const bpy::object copy(
+        bpy::handle<>(PyBytes_FromStringAndSize(0, static_cast<Py_ssize_t>(size))));
+
+    data = PyBytes_AS_STRING(copy.ptr());
+
+    return copy;
+}
@@ -0,0 +1,55 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_PYTHON_ARRAYVIEW_H
+#define APPLESEED_PYTHON_ARRAYVIEW_H
+
+// appleseed.python headers.
+#include "pyseed.h" // has to be first, to avoid redefinition warnings
+
+// Standard headers.
+#include <cstddef>
+
+// Return a memoryview over an array of 'dimension' dimensions given by 'shape', whose items
+// are described by a struct module format character. The memoryview keeps 'owner' alive.
+boost::python::object make_array_view(
+    const boost::python::object&    owner,
+    const void*                     data,
+    const char*                     format,
+    const size_t                    item_size,
+    const size_t                    dimension,
+    const size_t                    shape[],
+    const bool                      read_only);
+
+// Allocate a Python bytes object of 'size' bytes, to hold copies of arrays that cannot be
+// exposed in place. 'data' receives the address of its contents.
+boost::python::object make_array_copy(
+    const size_t                    size,
+    void*&                          data);
+
+#endif  // !APPLESEED_PYTHON_ARRAYVIEW_H
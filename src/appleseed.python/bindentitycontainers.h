@@ -130,14 +130,17 @@ namespace detail
     }
 }
 
+// Return the class object so that callers may bind additional methods.
 template <typename T>
-void bind_typed_entity_vector(const char* name)
+boost::python::class_<renderer::TypedEntityVector<T>, boost::python::bases<renderer::EntityVector>, boost::noncopyable>
+bind_typed_entity_vector(const char* name)
 {
-    boost::python::class_<renderer::TypedEntityVector<T>, boost::python::bases<renderer::EntityVector>, boost::noncopyable>(name)
+    return boost::python::class_<renderer::TypedEntityVector<T>, boost::python::bases<renderer::EntityVector>, boost::noncopyable>(name)
         .def("__getitem__", detail::typed_entity_vector_get_item<T>, boost::python::return_value_policy<boost::python::reference_existing_object>())
         .def("get_by_uid", &renderer::TypedEntityVector<T>::get_by_uid, boost::python::return_value_policy<boost::python::reference_existing_object>())
         .def("get_by_name", &renderer::TypedEntityVector<T>::get_by_name, boost::python::return_value_policy<boost::python::reference_existing_object>())
 
+        .def("reserve", &renderer::TypedEntityVector<T>::reserve)
         .def("insert", &renderer::TypedEntityVector<T>::insert)
         .def("remove", &detail::typed_entity_vector_remove<T>)
 
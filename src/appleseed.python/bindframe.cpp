@@ -149,6 +149,7 @@ void bind_frame()
         .def("clear_main_image", &Frame::clear_main_image)
         .def("write_main_image", &Frame::write_main_image)
         .def("write_aov_images", &Frame::write_aov_images)
+        .def("write_main_and_aov_images_to_multilayer_exr", &Frame::write_main_and_aov_images_to_multilayer_exr)
         .def("archive", archive_frame)
         ;
 }
@@ -29,6 +29,8 @@
 
 // appleseed.python headers.
 #include "pyseed.h" // has to be first, to avoid redefinition warnings
+#include "arrayview.h"
+#include "gillocks.h"
 
 // appleseed.renderer headers.
 #include "renderer/kernel/aov/imagestack.h"
@@ -44,6 +46,7 @@
 // Standard headers.
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <string>
 
 namespace bpy = boost::python;
@@ -109,6 +112,85 @@ namespace
         return pixels;
     }
 
+    // Return the struct module format character of the components of a given pixel format.
+    const char* get_buffer_format(const PixelFormat format)
+    {
+        switch (format)
+        {
+          case PixelFormatUInt8: return "B";
+          case PixelFormatUInt16: return "H";
+          case PixelFormatUInt32: return "I";
+          case PixelFormatHalf: return "e";
+          case PixelFormatFloat: return "f";
+          case PixelFormatDouble: return "d";
+          assert_otherwise;
+        }
+
+        return "B";
+    }
+
+    // Return a writable (height, width, channels) memoryview over the pixels of a tile.
+    bpy::object get_tile_pixels(const bpy::object& self)
+    {
+        Tile* tile = bpy::extract<Tile*>(self);
+        const size_t shape[] = { tile->get_height(), tile->get_width(), tile->get_channel_count() };
+
+        return
+            make_array_view(
+                self,
+                tile->get_storage(),
+                get_buffer_format(tile->get_pixel_format()),
+                Pixel::size(tile->get_pixel_format()),
+                3,
+                shape,
+                false);
+    }
+
+    // Images are made of separately allocated tiles: return a read-only
+    // (height, width, channels) memoryview over a copy of their pixels.
+    bpy::object get_image_pixels(const Image* image)
+    {
+        const CanvasProperties& props = image->properties();
+        const size_t row_size = props.m_canvas_width * props.m_pixel_size;
+
+        void* data;
+        const bpy::object copy = make_array_copy(props.m_canvas_height * row_size, data);
+        uint8* dest = static_cast<uint8*>(data);
+
+        {
+            ScopedGILUnlock unlock;
+
+            for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+            {
+                for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+                {
+                    const Tile& tile = image->tile(tx, ty);
+                    const size_t tile_row_size = tile.get_width() * props.m_pixel_size;
+
+                    for (size_t y = 0, h = tile.get_height(); y < h; ++y)
+                    {
+                        std::memcpy(
+                            dest + (ty * props.m_tile_height + y) * row_size + tx * props.m_tile_width * props.m_pixel_size,
+                            tile.pixel(0, y),
+                            tile_row_size);
+                    }
+                }
+            }
+        }
+
+        const size_t shape[] = { props.m_canvas_height, props.m_canvas_width, props.m_channel_count };
+
+        return
+            make_array_view(
+                copy,
+                dest,
+                get_buffer_format(props.m_pixel_format),
+                Pixel::size(props.m_pixel_format),
+                3,
+                shape,
+                true);
+    }
+
     Image* copy_image(const Image* source)
     {
         return new Image(*source);
@@ -167,6 +249,7 @@ void bind_image()
         .def("get_pixel_count", &Tile::get_pixel_count)
         .def("get_size", &Tile::get_size)
         .def("copy_data_to", copy_tile_data_to_py_buffer)   // todo: maybe this needs a better name
+        .def("get_pixels", get_tile_pixels)
 
         .def("blender_tile_data", blender_tile_data)
         ;
@@ -178,6 +261,7 @@ void bind_image()
         .def("__deepcopy__", copy_image, bpy::return_value_policy<bpy::manage_new_object>())
         .def("properties", &Image::properties, bpy::return_value_policy<bpy::reference_existing_object>())
         .def("tile", image_get_tile, bpy::return_value_policy<bpy::reference_existing_object>())
+        .def("get_pixels", get_image_pixels)
         ;
 
     const Image& (ImageStack::*image_stack_get_image)(const size_t) const = &ImageStack::get_image;
@@ -36,8 +36,18 @@
 #include "renderer/api/project.h"
 #include "renderer/api/rendering.h"
 
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/timers.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/otherwise.h"
+#include "foundation/utility/stopwatch.h"
+
 // Standard headers.
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 namespace bpy = boost::python;
 using namespace foundation;
@@ -45,6 +55,236 @@ using namespace renderer;
 
 namespace
 {
+    //
+    // A renderer controller that collects the tile events of the rendering threads and delivers
+    // them to a tile callback in batches, in the master renderer's thread, at most once per
+    // delivery interval. Python's global interpreter lock (GIL) is locked once per batch, and
+    // rendering threads never wait for the GIL nor for the tile callback.
+    //
+
+    class BatchingRendererController
+      : public IRendererController
+    {
+      public:
+        BatchingRendererController(
+            IRendererController*    controller,
+            ITileCallback*          tile_callback,
+            const double            delivery_interval)
+          : m_controller(controller)
+          , m_tile_callback(tile_callback)
+          , m_delivery_interval(delivery_interval)
+        {
+            m_stopwatch.start();
+        }
+
+        virtual void on_rendering_begin() APPLESEED_OVERRIDE
+        {
+            m_controller->on_rendering_begin();
+        }
+
+        virtual void on_rendering_success() APPLESEED_OVERRIDE
+        {
+            deliver_events();
+            m_controller->on_rendering_success();
+        }
+
+        virtual void on_rendering_abort() APPLESEED_OVERRIDE
+        {
+            deliver_events();
+            m_controller->on_rendering_abort();
+        }
+
+        virtual void on_frame_begin() APPLESEED_OVERRIDE
+        {
+            m_controller->on_frame_begin();
+        }
+
+        virtual void on_frame_end() APPLESEED_OVERRIDE
+        {
+            deliver_events();
+            m_controller->on_frame_end();
+        }
+
+        virtual void on_progress() APPLESEED_OVERRIDE
+        {
+            if (m_stopwatch.measure().get_seconds() >= m_delivery_interval)
+            {
+                deliver_events();
+                m_stopwatch.start();
+            }
+
+            m_controller->on_progress();
+        }
+
+        virtual Status get_status() const APPLESEED_OVERRIDE
+        {
+            return m_controller->get_status();
+        }
+
+        struct TileEvent
+        {
+            enum Type
+            {
+                PreRender,
+                PostRenderTile,
+                PostRender
+            };
+
+            Type            m_type;
+            const Frame*    m_frame;
+            size_t          m_x;
+            size_t          m_y;
+            size_t          m_width;
+            size_t          m_height;
+        };
+
+        // Called by the rendering threads.
+        void push_event(const TileEvent& event)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_events.push_back(event);
+        }
+
+      private:
+        IRendererController*                m_controller;
+        ITileCallback*                      m_tile_callback;
+        const double                        m_delivery_interval;
+        Stopwatch<DefaultWallclockTimer>    m_stopwatch;
+        boost::mutex                        m_mutex;
+        std::vector<TileEvent>              m_events;
+        std::vector<TileEvent>              m_batch;
+
+        void deliver_events()
+        {
+            {
+                boost::mutex::scoped_lock lock(m_mutex);
+                m_batch.swap(m_events);
+            }
+
+            if (m_batch.empty())
+                return;
+
+            // Lock Python's global interpreter lock (GIL) for the whole batch,
+            // it was released in MasterRenderer.render.
+            ScopedGILLock lock;
+
+            for (size_t i = 0, e = m_batch.size(); i < e; ++i)
+            {
+                const TileEvent& event = m_batch[i];
+
+                try
+                {
+                    switch (event.m_type)
+                    {
+                      case TileEvent::PreRender:
+                        m_tile_callback->pre_render(event.m_x, event.m_y, event.m_width, event.m_height);
+                        break;
+
+                      case TileEvent::PostRenderTile:
+                        m_tile_callback->post_render_tile(event.m_frame, event.m_x, event.m_y);
+                        break;
+
+                      case TileEvent::PostRender:
+                        m_tile_callback->post_render(event.m_frame);
+                        break;
+
+                      assert_otherwise;
+                    }
+                }
+                catch (bpy::error_already_set)
+                {
+                    PyErr_Print();
+                }
+            }
+
+            m_batch.clear();
+        }
+    };
+
+    class BatchingTileCallback
+      : public ITileCallback
+    {
+      public:
+        explicit BatchingTileCallback(BatchingRendererController* controller)
+          : m_controller(controller)
+        {
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            delete this;
+        }
+
+        virtual void pre_render(
+            const size_t            x,
+            const size_t            y,
+            const size_t            width,
+            const size_t            height) APPLESEED_OVERRIDE
+        {
+            BatchingRendererController::TileEvent event;
+            event.m_type = BatchingRendererController::TileEvent::PreRender;
+            event.m_frame = 0;
+            event.m_x = x;
+            event.m_y = y;
+            event.m_width = width;
+            event.m_height = height;
+            m_controller->push_event(event);
+        }
+
+        virtual void post_render_tile(
+            const Frame*            frame,
+            const size_t            tile_x,
+            const size_t            tile_y) APPLESEED_OVERRIDE
+        {
+            BatchingRendererController::TileEvent event;
+            event.m_type = BatchingRendererController::TileEvent::PostRenderTile;
+            event.m_frame = frame;
+            event.m_x = tile_x;
+            event.m_y = tile_y;
+            event.m_width = 0;
+            event.m_height = 0;
+            m_controller->push_event(event);
+        }
+
+        virtual void post_render(const Frame* frame) APPLESEED_OVERRIDE
+        {
+            BatchingRendererController::TileEvent event;
+            event.m_type = BatchingRendererController::TileEvent::PostRender;
+            event.m_frame = frame;
+            event.m_x = 0;
+            event.m_y = 0;
+            event.m_width = 0;
+            event.m_height = 0;
+            m_controller->push_event(event);
+        }
+
+      private:
+        BatchingRendererController* m_controller;
+    };
+
+    class BatchingTileCallbackFactory
+      : public ITileCallbackFactory
+    {
+      public:
+        explicit BatchingTileCallbackFactory(BatchingRendererController* controller)
+          : m_controller(controller)
+        {
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            delete this;
+        }
+
+        virtual ITileCallback* create() APPLESEED_OVERRIDE
+        {
+            return new BatchingTileCallback(m_controller);
+        }
+
+      private:
+        BatchingRendererController* m_controller;
+    };
+
     // A class that wraps MasterRenderer and keeps a Python
     // reference to the project object to prevent it being
     // destroyed by Python before the MasterRenderer is destroyed.
@@ -82,8 +322,40 @@ namespace
                     tile_callback));
         }
 
-        bpy::object                     m_project;
-        std::auto_ptr<MasterRenderer>   m_renderer;
+        // Deliver the events of the tile callback in batches, at most once every
+        // 'delivery_interval' seconds. The tile callback is kept alive as well.
+        MasterRendererWrapper(
+            bpy::object                 project,
+            const ParamArray&           params,
+            IRendererController*        renderer_controller,
+            bpy::object                 tile_callback,
+            const double                delivery_interval)
+          : m_project(project)
+          , m_tile_callback(tile_callback)
+        {
+            ITileCallback* callback = bpy::extract<ITileCallback*>(tile_callback);
+            m_batching_controller.reset(
+                new BatchingRendererController(
+                    renderer_controller,
+                    callback,
+                    delivery_interval));
+            m_batching_tile_callback_factory.reset(
+                new BatchingTileCallbackFactory(m_batching_controller.get()));
+
+            Project* proj = bpy::extract<Project*>(project);
+            m_renderer.reset(
+                new MasterRenderer(
+                    *proj,
+                    params,
+                    m_batching_controller.get(),
+                    m_batching_tile_callback_factory.get()));
+        }
+
+        bpy::object                                         m_project;
+        bpy::object                                         m_tile_callback;
+        std::auto_ptr<BatchingRendererController>           m_batching_controller;
+        auto_release_ptr<BatchingTileCallbackFactory>       m_batching_tile_callback_factory;
+        std::auto_ptr<MasterRenderer>                       m_renderer;
     };
 
     std::auto_ptr<MasterRendererWrapper> create_master_renderer(
@@ -114,6 +386,23 @@ namespace
                     tile_callback));
     }
 
+    std::auto_ptr<MasterRendererWrapper> create_master_renderer_with_batched_tile_callback(
+        bpy::object             project,
+        const bpy::dict&        params,
+        IRendererController*    renderer_controller,
+        bpy::object             tile_callback,
+        const double            delivery_interval)
+    {
+        return
+            std::auto_ptr<MasterRendererWrapper>(
+                new MasterRendererWrapper(
+                    *project,
+                    bpy_dict_to_param_array(params),
+                    renderer_controller,
+                    tile_callback,
+                    delivery_interval));
+    }
+
     bpy::dict master_renderer_get_parameters(const MasterRendererWrapper* m)
     {
         return param_array_to_bpy_dict(m->m_renderer->get_parameters());
@@ -141,6 +430,7 @@ void bind_master_renderer()
     bpy::class_<MasterRendererWrapper, std::auto_ptr<MasterRendererWrapper>, boost::noncopyable>("MasterRenderer", bpy::no_init)
         .def("__init__", bpy::make_constructor(create_master_renderer))
         .def("__init__", bpy::make_constructor(create_master_renderer_with_tile_callback))
+        .def("__init__", bpy::make_constructor(create_master_renderer_with_batched_tile_callback))
         .def("get_parameters", master_renderer_get_parameters)
         .def("set_parameters", master_renderer_set_parameters)
         .def("render", master_renderer_render)
@@ -29,18 +29,27 @@
 
 // appleseed.python headers.
 #include "pyseed.h" // has to be first, to avoid redefinition warnings
+#include "arrayview.h"
 #include "bindentitycontainers.h"
+#include "bufferaccess.h"
 #include "dict2dict.h"
+#include "gillocks.h"
 
 // appleseed.renderer headers.
 #include "renderer/api/object.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/system.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/searchpaths.h"
 
+// Boost headers.
+#include "boost/static_assert.hpp"
+
 // Standard headers.
 #include <cstddef>
 #include <string>
+#include <vector>
 
 namespace bpy = boost::python;
 using namespace foundation;
@@ -74,6 +83,204 @@ namespace
         object->get_triangle(index) = triangle;
     }
 
+    //
+    // Bulk access to the arrays of a mesh through the buffer protocol.
+    //
+    // The push_*() functions accept any buffer supported by BufferAccess and copy it into
+    // the mesh with the GIL released, converting the scalars if needed. The get_*() functions
+    // return read-only memoryviews over the arrays of the mesh; they keep the mesh alive but
+    // are invalidated by any insertion into the array they expose.
+    //
+
+    BOOST_STATIC_ASSERT(sizeof(GVector2) == 2 * sizeof(float));
+    BOOST_STATIC_ASSERT(sizeof(GVector3) == 3 * sizeof(float));
+    BOOST_STATIC_ASSERT(sizeof(Triangle) == 10 * sizeof(uint32));
+
+    void push_vectors(
+        MeshObject*         object,
+        const bpy::object&  obj,
+        void                (MeshObject::*push)(const GVector3[], const size_t))
+    {
+        const BufferAccess buffer(obj);
+        const ScalarType type = buffer.get_scalar_type(true);
+        const size_t count = buffer.get_element_count(3);
+
+        if (count == 0)
+            return;
+
+        ScopedGILUnlock unlock;
+
+        if (type == ScalarTypeFloat)
+            (object->*push)(static_cast<const GVector3*>(buffer.get_data()), count);
+        else
+        {
+            vector<GVector3> vectors(count);
+            convert_scalars(type, buffer.get_data(), &vectors[0][0], count * 3);
+            (object->*push)(&vectors[0], count);
+        }
+    }
+
+    void push_vertices(MeshObject* object, const bpy::object& obj)
+    {
+        push_vectors(object, obj, &MeshObject::push_vertices);
+    }
+
+    void push_vertex_normals(MeshObject* object, const bpy::object& obj)
+    {
+        push_vectors(object, obj, &MeshObject::push_vertex_normals);
+    }
+
+    void push_tex_coords_array(MeshObject* object, const bpy::object& obj)
+    {
+        const BufferAccess buffer(obj);
+        const ScalarType type = buffer.get_scalar_type(true);
+        const size_t count = buffer.get_element_count(2);
+
+        if (count == 0)
+            return;
+
+        ScopedGILUnlock unlock;
+
+        vector<GVector2> tex_coords;
+        if (type != ScalarTypeFloat)
+        {
+            tex_coords.resize(count);
+            convert_scalars(type, buffer.get_data(), &tex_coords[0][0], count * 2);
+        }
+
+        const GVector2* source =
+            type == ScalarTypeFloat
+                ? static_cast<const GVector2*>(buffer.get_data())
+                : &tex_coords[0];
+
+        object->reserve_tex_coords(object->get_tex_coords_count() + count);
+
+        for (size_t i = 0; i < count; ++i)
+            object->push_tex_coords(source[i]);
+    }
+
+    // Triangles are rows of 3 (v0 v1 v2), 4 (v0 v1 v2 pa), 7 (v0 v1 v2 n0 n1 n2 pa)
+    // or 10 (v0 v1 v2 n0 n1 n2 a0 a1 a2 pa) indices, matching the constructors of
+    // the Triangle class. One-dimensional buffers hold rows of 10 indices.
+    void push_triangles(MeshObject* object, const bpy::object& obj)
+    {
+        const BufferAccess buffer(obj);
+        const ScalarType type = buffer.get_scalar_type(false);
+        const size_t row_size = buffer.get_row_size() > 0 ? buffer.get_row_size() : 10;
+
+        if (row_size != 3 && row_size != 4 && row_size != 7 && row_size != 10)
+        {
+            PyErr_SetString(PyExc_ValueError, "Triangles must have 3, 4, 7 or 10 indices.");
+            bpy::throw_error_already_set();
+        }
+
+        const size_t count = buffer.get_element_count(row_size);
+
+        if (count == 0)
+            return;
+
+        ScopedGILUnlock unlock;
+
+        if (row_size == 10 && (type == ScalarTypeInt32 || type == ScalarTypeUInt32))
+        {
+            object->push_triangles(static_cast<const Triangle*>(buffer.get_data()), count);
+            return;
+        }
+
+        vector<uint32> indices(count * row_size);
+        convert_scalars(type, buffer.get_data(), &indices[0], indices.size());
+
+        vector<Triangle> triangles;
+        triangles.reserve(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint32* t = &indices[i * row_size];
+
+            switch (row_size)
+            {
+              case 3: triangles.push_back(Triangle(t[0], t[1], t[2])); break;
+              case 4: triangles.push_back(Triangle(t[0], t[1], t[2], t[3])); break;
+              case 7: triangles.push_back(Triangle(t[0], t[1], t[2], t[3], t[4], t[5], t[6])); break;
+              case 10: triangles.push_back(Triangle(t[0], t[1], t[2], t[3], t[4], t[5], t[6], t[7], t[8], t[9])); break;
+              assert_otherwise;
+            }
+        }
+
+        object->push_triangles(&triangles[0], count);
+    }
+
+    bpy::object get_vectors(
+        const bpy::object&  self,
+        size_t              (MeshObject::*get_count)() const,
+        const GVector3*     (MeshObject::*get_array)() const,
+        GVector3            (MeshObject::*get_element)(const size_t) const)
+    {
+        const MeshObject* object = bpy::extract<MeshObject*>(self);
+        const size_t count = (object->*get_count)();
+        const GVector3* vectors = (object->*get_array)();
+
+        const size_t shape[] = { count, 3 };
+
+        if (vectors != 0 || count == 0)
+            return make_array_view(self, vectors, "f", sizeof(float), 2, shape, true);
+
+        // Vectors stored in compact form are decoded into a copy.
+        void* data;
+        const bpy::object copy = make_array_copy(count * sizeof(GVector3), data);
+        GVector3* dest = static_cast<GVector3*>(data);
+
+        for (size_t i = 0; i < count; ++i)
+            dest[i] = (object->*get_element)(i);
+
+        return make_array_view(copy, dest, "f", sizeof(float), 2, shape, true);
+    }
+
+    bpy::object get_vertices(const bpy::object& self)
+    {
+        return
+            get_vectors(
+                self,
+                &MeshObject::get_vertex_count,
+                &MeshObject::get_vertices,
+                &MeshObject::get_vertex);
+    }
+
+    bpy::object get_vertex_normals(const bpy::object& self)
+    {
+        return
+            get_vectors(
+                self,
+                &MeshObject::get_vertex_normal_count,
+                &MeshObject::get_vertex_normals,
+                &MeshObject::get_vertex_normal);
+    }
+
+    // Texture coordinates are stored as vertex attributes and are always copied.
+    bpy::object get_tex_coords_array(const bpy::object& self)
+    {
+        const MeshObject* object = bpy::extract<MeshObject*>(self);
+        const size_t count = object->get_tex_coords_count();
+
+        void* data;
+        const bpy::object copy = make_array_copy(count * sizeof(GVector2), data);
+        GVector2* dest = static_cast<GVector2*>(data);
+
+        for (size_t i = 0; i < count; ++i)
+            dest[i] = object->get_tex_coords(i);
+
+        const size_t shape[] = { count, 2 };
+        return make_array_view(copy, dest, "f", sizeof(float), 2, shape, true);
+    }
+
+    bpy::object get_triangles(const bpy::object& self)
+    {
+        const MeshObject* object = bpy::extract<MeshObject*>(self);
+        const size_t shape[] = { object->get_triangle_count(), 10 };
+
+        return make_array_view(self, object->get_triangles(), "I", sizeof(uint32), 2, shape, true);
+    }
+
     bpy::list read_mesh_objects(
         const bpy::list&    search_paths,
         const string&       base_object_name,
@@ -122,6 +329,18 @@ namespace
         return MeshObjectWriter::write(*object, object_name.c_str(), filename.c_str());
     }
 
+    void compute_smooth_normals(MeshObject* object)
+    {
+        ScopedGILUnlock unlock;
+        compute_smooth_vertex_normals(*object, System::get_logical_cpu_core_count());
+    }
+
+    void compute_smooth_tangents(MeshObject* object)
+    {
+        ScopedGILUnlock unlock;
+        compute_smooth_vertex_tangents(*object, System::get_logical_cpu_core_count());
+    }
+
     auto_release_ptr<MeshObject> create_mesh_prim(
         const string&       name,
         const bpy::dict&    params)
@@ -158,23 +377,31 @@ void bind_mesh_object()
         .def("reserve_vertices", &MeshObject::reserve_vertices)
         .def("push_vertex", &MeshObject::push_vertex)
         .def("get_vertex_count", &MeshObject::get_vertex_count)
-        .def("get_vertex", &MeshObject::get_vertex, bpy::return_value_policy<bpy::reference_existing_object>())
+        .def("get_vertex", &MeshObject::get_vertex)
+        .def("push_vertices", push_vertices)
+        .def("get_vertices", get_vertices)
 
         .def("reserve_vertex_normals", &MeshObject::reserve_vertex_normals)
         .def("push_vertex_normal", &MeshObject::push_vertex_normal)
         .def("get_vertex_normal_count", &MeshObject::get_vertex_normal_count)
-        .def("get_vertex_normal", &MeshObject::get_vertex_normal, bpy::return_value_policy<bpy::reference_existing_object>())
+        .def("get_vertex_normal", &MeshObject::get_vertex_normal)
+        .def("push_vertex_normals", push_vertex_normals)
+        .def("get_vertex_normals", get_vertex_normals)
 
         .def("reserve_tex_coords", &MeshObject::reserve_tex_coords)
         .def("push_tex_coords", &MeshObject::push_tex_coords)
         .def("get_tex_coords_count", &MeshObject::get_tex_coords_count)
         .def("get_tex_coords", &MeshObject::get_tex_coords)
+        .def("push_tex_coords_array", push_tex_coords_array)
+        .def("get_tex_coords_array", get_tex_coords_array)
 
         .def("reserve_triangles", &MeshObject::reserve_triangles)
         .def("push_triangle", &MeshObject::push_triangle)
         .def("get_triangle_count", &MeshObject::get_triangle_count)
         .def("get_triangle", get_triangle, bpy::return_value_policy<bpy::reference_existing_object>())
         .def("set_triangle", set_triangle)
+        .def("push_triangles", push_triangles)
+        .def("get_triangles", get_triangles)
 
         .def("set_motion_segment_count", &MeshObject::set_motion_segment_count)
         .def("get_motion_segment_count", &MeshObject::get_motion_segment_count)
@@ -205,7 +432,7 @@ void bind_mesh_object()
         .def("write", write_mesh_object).staticmethod("write")
         ;
 
-    bpy::def("compute_smooth_vertex_normals", compute_smooth_vertex_normals);
-    bpy::def("compute_smooth_vertex_tangents", compute_smooth_vertex_tangents);
+    bpy::def("compute_smooth_vertex_normals", compute_smooth_normals);
+    bpy::def("compute_smooth_vertex_tangents", compute_smooth_tangents);
     bpy::def("create_primitive_mesh", create_mesh_prim);
 }
@@ -30,7 +30,9 @@
 // appleseed.python headers.
 #include "pyseed.h" // has to be first, to avoid redefinition warnings
 #include "bindentitycontainers.h"
+#include "bufferaccess.h"
 #include "dict2dict.h"
+#include "gillocks.h"
 #include "unalignedtransform.h"
 
 // appleseed.renderer headers.
@@ -38,9 +40,17 @@
 #include "renderer/api/scene.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/matrix.h"
+#include "foundation/math/transform.h"
 #include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/searchpaths.h"
 
+// Standard headers.
+#include <cstddef>
+#include <string>
+#include <vector>
+
 namespace bpy = boost::python;
 using namespace foundation;
 using namespace renderer;
@@ -148,6 +158,134 @@ namespace
     {
         return material_mappings_to_dict(obj->get_back_material_mappings());
     }
+
+    // Material mappings are either a single dictionary shared by all instances,
+    // or a list of dictionaries, one per instance.
+    void bpy_object_to_material_mappings(
+        const bpy::object&              obj,
+        const size_t                    instance_count,
+        vector<StringDictionary>&       mappings)
+    {
+        mappings.clear();
+
+        bpy::extract<bpy::dict> ex_dict(obj);
+        if (ex_dict.check())
+        {
+            mappings.push_back(bpy_dict_to_dictionary(ex_dict()).strings());
+            return;
+        }
+
+        bpy::extract<bpy::list> ex_list(obj);
+        if (!ex_list.check())
+        {
+            PyErr_SetString(PyExc_TypeError, "Incompatible type. Only a dictionary or a list of dictionaries.");
+            bpy::throw_error_already_set();
+        }
+
+        const bpy::list l = ex_list();
+        if (static_cast<size_t>(bpy::len(l)) != instance_count)
+        {
+            PyErr_SetString(PyExc_ValueError, "There must be one material mappings dictionary per object instance.");
+            bpy::throw_error_already_set();
+        }
+
+        mappings.reserve(instance_count);
+
+        for (size_t i = 0; i < instance_count; ++i)
+        {
+            bpy::extract<bpy::dict> ex(l[i]);
+            if (!ex.check())
+            {
+                PyErr_SetString(PyExc_TypeError, "Incompatible type. Only dictionaries.");
+                bpy::throw_error_already_set();
+            }
+
+            mappings.push_back(bpy_dict_to_dictionary(ex()).strings());
+        }
+    }
+
+    // Create object instances in bulk and insert them into a container. All instances share
+    // the same parameters; their local-to-parent matrices are given as a buffer of 16 scalars
+    // (row-major) per instance. Only the conversion of the Python arguments holds the GIL.
+    void obj_inst_container_insert_instances_with_back_mat(
+        ObjectInstanceContainer*        container,
+        const bpy::list&                names,
+        const bpy::dict&                params,
+        const bpy::list&                object_names,
+        const bpy::object&              transforms,
+        const bpy::object&              front_material_mappings,
+        const bpy::object&              back_material_mappings)
+    {
+        StringArray instance_names;
+        bpy_list_to_string_array(names, instance_names);
+        const size_t instance_count = instance_names.size();
+
+        StringArray instance_object_names;
+        bpy_list_to_string_array(object_names, instance_object_names);
+
+        if (instance_object_names.size() != instance_count)
+        {
+            PyErr_SetString(PyExc_ValueError, "There must be one object name per object instance.");
+            bpy::throw_error_already_set();
+        }
+
+        const BufferAccess buffer(transforms);
+        const ScalarType type = buffer.get_scalar_type(true);
+
+        if (buffer.get_element_count(16) != instance_count)
+        {
+            PyErr_SetString(PyExc_ValueError, "There must be one transform per object instance.");
+            bpy::throw_error_already_set();
+        }
+
+        vector<StringDictionary> front_mappings;
+        bpy_object_to_material_mappings(front_material_mappings, instance_count, front_mappings);
+
+        vector<StringDictionary> back_mappings;
+        bpy_object_to_material_mappings(back_material_mappings, instance_count, back_mappings);
+
+        const ParamArray param_array = bpy_dict_to_param_array(params);
+
+        if (instance_count == 0)
+            return;
+
+        ScopedGILUnlock unlock;
+
+        vector<double> matrices(instance_count * 16);
+        convert_scalars(type, buffer.get_data(), &matrices[0], matrices.size());
+
+        container->reserve(container->size() + instance_count);
+
+        for (size_t i = 0; i < instance_count; ++i)
+        {
+            container->insert(
+                ObjectInstanceFactory::create(
+                    instance_names[i],
+                    param_array,
+                    instance_object_names[i],
+                    Transformd::from_local_to_parent(Matrix4d(&matrices[i * 16])),
+                    front_mappings[front_mappings.size() > 1 ? i : 0],
+                    back_mappings[back_mappings.size() > 1 ? i : 0]));
+        }
+    }
+
+    void obj_inst_container_insert_instances(
+        ObjectInstanceContainer*        container,
+        const bpy::list&                names,
+        const bpy::dict&                params,
+        const bpy::list&                object_names,
+        const bpy::object&              transforms,
+        const bpy::object&              front_material_mappings)
+    {
+        obj_inst_container_insert_instances_with_back_mat(
+            container,
+            names,
+            params,
+            object_names,
+            transforms,
+            front_material_mappings,
+            bpy::dict());
+    }
 }
 
 void bind_object()
@@ -173,5 +311,8 @@ void bind_object()
         .def("get_back_material_mappings", &obj_inst_get_back_material_mappings)
         ;
 
-    bind_typed_entity_vector<ObjectInstance>("ObjectInstanceContainer");
+    bind_typed_entity_vector<ObjectInstance>("ObjectInstanceContainer")
+        .def("insert_instances", &obj_inst_container_insert_instances)
+        .def("insert_instances", &obj_inst_container_insert_instances_with_back_mat)
+        ;
 }
@@ -307,7 +307,8 @@ void bind_project()
         .value("OmitReadingMeshFiles", ProjectFileReader::OmitReadingMeshFiles)
         .value("OmitProjectFileUpdate", ProjectFileReader::OmitProjectFileUpdate)
         .value("OmitSearchPaths", ProjectFileReader::OmitSearchPaths)
-        .value("OmitProjectSchemaValidation", ProjectFileReader::OmitProjectSchemaValidation);
+        .value("OmitProjectSchemaValidation", ProjectFileReader::OmitProjectSchemaValidation)
+        .value("DeduplicateMeshObjects", ProjectFileReader::DeduplicateMeshObjects);
 
     bpy::class_<ProjectFileReader>("ProjectFileReader")
         .def("read", &project_file_reader_read_default_opts)
@@ -319,7 +320,8 @@ void bind_project()
         .value("OmitHeaderComment", ProjectFileWriter::OmitHeaderComment)
         .value("OmitWritingGeometryFiles", ProjectFileWriter::OmitWritingGeometryFiles)
         .value("OmitHandlingAssetFiles", ProjectFileWriter::OmitHandlingAssetFiles)
-        .value("CopyAllAssets", ProjectFileWriter::CopyAllAssets);
+        .value("CopyAllAssets", ProjectFileWriter::CopyAllAssets)
+        .value("PrefetchAssetFiles", ProjectFileWriter::PrefetchAssetFiles);
 
     bpy::class_<ProjectFileWriter>("ProjectFileWriter")
         // These methods are static but for symmetry with ProjectFileReader we're exposing them as non-static.
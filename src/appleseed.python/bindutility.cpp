@@ -34,10 +34,36 @@
 #include "renderer/api/log.h"
 #include "renderer/modeling/project/eventcounters.h"
 
+// appleseed.foundation headers.
+#include "foundation/utility/memorytracker.h"
+
+// Standard headers.
+#include <cstddef>
+
 namespace bpy = boost::python;
 using namespace foundation;
 using namespace renderer;
 
+namespace
+{
+    bpy::dict get_memory_usage()
+    {
+        const MemoryTracker& tracker = global_memory_tracker();
+
+        bpy::dict result;
+
+        for (size_t i = 0; i < MemoryTracker::CategoryCount; ++i)
+        {
+            const MemoryTracker::Category category = static_cast<MemoryTracker::Category>(i);
+            result[MemoryTracker::get_category_name(category)] = tracker.get_size(category);
+        }
+
+        result["total"] = tracker.get_total_size();
+
+        return result;
+    }
+}
+
 void bind_utility()
 {
     bpy::class_<EventCounters, boost::noncopyable>("EventCounters")
@@ -59,4 +85,6 @@ void bind_utility()
         ;
 
     bpy::def("global_logger", global_logger, bpy::return_value_policy<bpy::reference_existing_object>());
+
+    bpy::def("get_memory_usage", get_memory_usage);
 }
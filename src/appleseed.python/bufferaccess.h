@@ -0,0 +1,191 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_PYTHON_BUFFERACCESS_H
+#define APPLESEED_PYTHON_BUFFERACCESS_H
+
+// appleseed.python headers.
+#include "pyseed.h" // has to be first, to avoid redefinition warnings
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/otherwise.h"
+
+// Standard headers.
+#include <cstddef>
+
+//
+// Bulk access to arrays of scalars exposed through the buffer protocol.
+//
+// BufferAccess accepts any C-contiguous buffer (NumPy arrays, memoryviews, etc.) of integer
+// or floating-point scalars; convert_scalars() converts its contents to a given scalar type.
+// The data of the buffer remains valid while the BufferAccess object exists, including while
+// the GIL is released.
+//
+
+enum ScalarType
+{
+    ScalarTypeInt8,
+    ScalarTypeUInt8,
+    ScalarTypeInt16,
+    ScalarTypeUInt16,
+    ScalarTypeInt32,
+    ScalarTypeUInt32,
+    ScalarTypeInt64,
+    ScalarTypeUInt64,
+    ScalarTypeFloat,
+    ScalarTypeDouble
+};
+
+// Scoped access to the contents of an object exposing the buffer protocol.
+class BufferAccess
+  : public foundation::NonCopyable
+{
+  public:
+    explicit BufferAccess(const boost::python::object& obj)
+    {
+        if (PyObject_GetBuffer(obj.ptr(), &m_buffer, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) != 0)
+            boost::python::throw_error_already_set();
+    }
+
+    ~BufferAccess()
+    {
+        PyBuffer_Release(&m_buffer);
+    }
+
+    const void* get_data() const
+    {
+        return m_buffer.buf;
+    }
+
+    size_t get_item_count() const
+    {
+        return m_buffer.itemsize > 0 ? static_cast<size_t>(m_buffer.len / m_buffer.itemsize) : 0;
+    }
+
+    // Return the size of the last dimension of a two-dimensional buffer, 0 otherwise.
+    size_t get_row_size() const
+    {
+        return m_buffer.ndim == 2 ? static_cast<size_t>(m_buffer.shape[1]) : 0;
+    }
+
+    // Return the type of the scalars of the buffer, raising TypeError if it is not supported.
+    ScalarType get_scalar_type(const bool allow_floating_point) const
+    {
+        // Native and little-endian byte orders are the same on all supported platforms.
+        const char* format = m_buffer.format != 0 ? m_buffer.format : "B";
+        if (*format == '@' || *format == '=' || *format == '<')
+            ++format;
+
+        if (format[0] != '\0' && format[1] == '\0')
+        {
+            const Py_ssize_t size = m_buffer.itemsize;
+
+            switch (format[0])
+            {
+              case 'b': case 'h': case 'i': case 'l': case 'q':
+                if (size == 1) return ScalarTypeInt8;
+                if (size == 2) return ScalarTypeInt16;
+                if (size == 4) return ScalarTypeInt32;
+                if (size == 8) return ScalarTypeInt64;
+                break;
+
+              case 'B': case 'H': case 'I': case 'L': case 'Q':
+                if (size == 1) return ScalarTypeUInt8;
+                if (size == 2) return ScalarTypeUInt16;
+                if (size == 4) return ScalarTypeUInt32;
+                if (size == 8) return ScalarTypeUInt64;
+                break;
+
+              case 'f':
+                if (allow_floating_point && size == 4) return ScalarTypeFloat;
+                break;
+
+              case 'd':
+                if (allow_floating_point && size == 8) return ScalarTypeDouble;
+                break;
+            }
+        }
+
+        PyErr_SetString(
+            PyExc_TypeError,
+            allow_floating_point
+                ? "Incompatible buffer. Only integer or floating-point scalars."
+                : "Incompatible buffer. Only integer scalars.");
+        boost::python::throw_error_already_set();
+        return ScalarTypeUInt8;
+    }
+
+    // Return the number of elements of 'item_count' scalars, raising ValueError if the
+    // buffer does not hold a whole number of elements.
+    size_t get_element_count(const size_t item_count) const
+    {
+        if (get_item_count() % item_count != 0)
+        {
+            PyErr_SetString(PyExc_ValueError, "Buffer size is not a multiple of the element size.");
+            boost::python::throw_error_already_set();
+        }
+
+        return get_item_count() / item_count;
+    }
+
+  private:
+    Py_buffer m_buffer;
+};
+
+template <typename Source, typename Dest>
+inline void convert_scalars(const void* source, Dest* dest, const size_t count)
+{
+    const Source* s = static_cast<const Source*>(source);
+
+    for (size_t i = 0; i < count; ++i)
+        dest[i] = static_cast<Dest>(s[i]);
+}
+
+template <typename Dest>
+inline void convert_scalars(const ScalarType type, const void* source, Dest* dest, const size_t count)
+{
+    switch (type)
+    {
+      case ScalarTypeInt8: convert_scalars<foundation::int8>(source, dest, count); break;
+      case ScalarTypeUInt8: convert_scalars<foundation::uint8>(source, dest, count); break;
+      case ScalarTypeInt16: convert_scalars<foundation::int16>(source, dest, count); break;
+      case ScalarTypeUInt16: convert_scalars<foundation::uint16>(source, dest, count); break;
+      case ScalarTypeInt32: convert_scalars<foundation::int32>(source, dest, count); break;
+      case ScalarTypeUInt32: convert_scalars<foundation::uint32>(source, dest, count); break;
+      case ScalarTypeInt64: convert_scalars<foundation::int64>(source, dest, count); break;
+      case ScalarTypeUInt64: convert_scalars<foundation::uint64>(source, dest, count); break;
+      case ScalarTypeFloat: convert_scalars<float>(source, dest, count); break;
+      case ScalarTypeDouble: convert_scalars<double>(source, dest, count); break;
+      assert_otherwise;
+    }
+}
+
+#endif  // !APPLESEED_PYTHON_BUFFERACCESS_H
@@ -32,5 +32,8 @@ from testbasis import *
 from testdict2dict import *
 from testentitymap import *
 from testentityvector import *
+from testimage import *
+from testmeshobject import *
+from testobjectinstance import *
 
 unittest.TestProgram(testRunner=unittest.TextTestRunner())
@@ -0,0 +1,58 @@
+
+#
+# This source file is part of appleseed.
+# Visit http://appleseedhq.net/ for additional information and resources.
+#
+# This software is released under the MIT license.
+#
+# Copyright (c) 2016-2017 Francois Beaune, The appleseedhq Organization
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+
+import struct
+import unittest
+import appleseed as asr
+
+
+class TestTile(unittest.TestCase):
+
+    def setUp(self):
+        self.tile = asr.Tile(3, 2, 4, asr.PixelFormat.Float)
+
+    def test_get_pixels_shape(self):
+        pixels = self.tile.get_pixels()
+
+        self.assertEqual((2, 3, 4), pixels.shape)
+        self.assertEqual("f", pixels.format)
+        self.assertFalse(pixels.readonly)
+
+    def test_get_pixels_writes_tile(self):
+        pixels = self.tile.get_pixels()
+        pixels[1, 2, 3] = 0.5
+
+        copy = self.tile.get_pixels()
+
+        self.assertEqual(0.5, struct.unpack("24f", copy.tobytes())[23])
+
+    def tearDown(self):
+        pass
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,106 @@
+
+#
+# This source file is part of appleseed.
+# Visit http://appleseedhq.net/ for additional information and resources.
+#
+# This software is released under the MIT license.
+#
+# Copyright (c) 2016-2017 Francois Beaune, The appleseedhq Organization
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+
+import ctypes
+import struct
+import unittest
+import appleseed as asr
+
+
+class TestMeshObject(unittest.TestCase):
+
+    def setUp(self):
+        self.mesh = asr.MeshObject("mesh", {})
+
+    def test_push_vertices(self):
+        vertices = (ctypes.c_float * 6)(0.0, 1.0, 2.0, 3.0, 4.0, 5.0)
+
+        self.mesh.push_vertices(vertices)
+
+        self.assertEqual(2, self.mesh.get_vertex_count())
+        self.assertEqual(asr.Vector3f(3.0, 4.0, 5.0), self.mesh.get_vertex(1))
+
+    def test_push_vertices_converts_doubles(self):
+        vertices = (ctypes.c_double * 3)(1.0, 2.0, 3.0)
+
+        self.mesh.push_vertices(vertices)
+
+        self.assertEqual(asr.Vector3f(1.0, 2.0, 3.0), self.mesh.get_vertex(0))
+
+    def test_push_vertices_rejects_partial_vertices(self):
+        vertices = (ctypes.c_float * 4)(0.0, 1.0, 2.0, 3.0)
+
+        self.assertRaises(ValueError, self.mesh.push_vertices, vertices)
+
+    def test_get_vertices(self):
+        self.mesh.push_vertex(asr.Vector3f(1.0, 2.0, 3.0))
+        self.mesh.push_vertex(asr.Vector3f(4.0, 5.0, 6.0))
+
+        vertices = self.mesh.get_vertices()
+
+        self.assertTrue(vertices.readonly)
+        self.assertEqual((2, 3), vertices.shape)
+        self.assertEqual((1.0, 2.0, 3.0, 4.0, 5.0, 6.0), struct.unpack("6f", vertices.tobytes()))
+
+    def test_push_tex_coords_array(self):
+        tex_coords = (ctypes.c_float * 4)(0.0, 0.25, 0.5, 1.0)
+
+        self.mesh.push_tex_coords_array(tex_coords)
+
+        self.assertEqual(2, self.mesh.get_tex_coords_count())
+        self.assertEqual((0.0, 0.25, 0.5, 1.0), struct.unpack("4f", self.mesh.get_tex_coords_array().tobytes()))
+
+    def test_push_triangles(self):
+        indices = ((ctypes.c_uint32 * 3) * 2)((0, 1, 2), (2, 1, 3))
+
+        self.mesh.push_triangles(indices)
+
+        self.assertEqual(2, self.mesh.get_triangle_count())
+        triangle = self.mesh.get_triangle(1)
+        self.assertEqual((2, 1, 3), (triangle.v0, triangle.v1, triangle.v2))
+
+    def test_push_triangles_rejects_floats(self):
+        indices = (ctypes.c_float * 3)(0.0, 1.0, 2.0)
+
+        self.assertRaises(TypeError, self.mesh.push_triangles, indices)
+
+    def test_get_triangles(self):
+        self.mesh.push_triangle(asr.Triangle(0, 1, 2, 3))
+
+        triangles = self.mesh.get_triangles()
+
+        self.assertEqual((1, 10), triangles.shape)
+        indices = struct.unpack("10I", triangles.tobytes())
+        self.assertEqual((0, 1, 2), indices[:3])
+        self.assertEqual(3, indices[9])
+
+    def tearDown(self):
+        pass
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,95 @@
+
+#
+# This source file is part of appleseed.
+# Visit http://appleseedhq.net/ for additional information and resources.
+#
+# This software is released under the MIT license.
+#
+# Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+
+import ctypes
+import unittest
+import appleseed as asr
+
+
+class TestObjectInstanceContainer(unittest.TestCase):
+
+    def setUp(self):
+        self.ass = asr.Assembly("assembly")
+        self.instances = self.ass.object_instances()
+
+    def test_insert_instances(self):
+        transforms = (ctypes.c_double * 32)(
+            1.0, 0.0, 0.0, 1.0,
+            0.0, 1.0, 0.0, 2.0,
+            0.0, 0.0, 1.0, 3.0,
+            0.0, 0.0, 0.0, 1.0,
+            1.0, 0.0, 0.0, 4.0,
+            0.0, 1.0, 0.0, 5.0,
+            0.0, 0.0, 1.0, 6.0,
+            0.0, 0.0, 0.0, 1.0)
+
+        self.instances.insert_instances(
+            ["inst0", "inst1"],
+            {},
+            ["obj0", "obj1"],
+            transforms,
+            {"default": "mat"})
+
+        self.assertEqual(2, len(self.instances))
+
+        inst = self.instances.get_by_name("inst1")
+        self.assertEqual("obj1", inst.get_object_name())
+        self.assertEqual({"default": "mat"}, inst.get_front_material_mappings())
+        self.assertEqual({}, inst.get_back_material_mappings())
+        self.assertEqual(5.0, inst.get_transform().get_local_to_parent()[1, 3])
+
+    def test_insert_instances_with_per_instance_material_mappings(self):
+        transforms = (ctypes.c_float * 32)(*([1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0] * 2))
+
+        self.instances.insert_instances(
+            ["inst0", "inst1"],
+            {},
+            ["obj", "obj"],
+            transforms,
+            [{"default": "mat0"}, {"default": "mat1"}],
+            {"default": "back"})
+
+        self.assertEqual({"default": "mat1"}, self.instances.get_by_name("inst1").get_front_material_mappings())
+        self.assertEqual({"default": "back"}, self.instances.get_by_name("inst0").get_back_material_mappings())
+
+    def test_insert_instances_rejects_missing_transforms(self):
+        transforms = (ctypes.c_double * 16)()
+
+        self.assertRaises(
+            ValueError,
+            self.instances.insert_instances,
+            ["inst0", "inst1"],
+            {},
+            ["obj0", "obj1"],
+            transforms,
+            {})
+
+        self.assertEqual(0, len(self.instances))
+
+if __name__ == "__main__":
+    unittest.main()
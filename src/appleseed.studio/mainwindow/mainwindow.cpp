@@ -39,6 +39,7 @@
 #include "mainwindow/minimizebutton.h"
 #include "mainwindow/project/attributeeditor.h"
 #include "mainwindow/project/projectexplorer.h"
+#include "mainwindow/renderstatisticspanel.h"
 #include "utility/interop.h"
 #include "utility/miscellaneous.h"
 #include "utility/settingskeys.h"
@@ -73,6 +74,7 @@
 #include <QApplication>
 #include <QCloseEvent>
 #include <QDir>
+#include <QDockWidget>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
 #include <QIcon>
@@ -118,6 +120,7 @@ namespace
 MainWindow::MainWindow(QWidget* parent)
   : QMainWindow(parent)
   , m_ui(new Ui::MainWindow())
+  , m_render_statistics_dock(0)
   , m_rendering_manager(m_status_bar)
   , m_project_explorer(0)
   , m_attribute_editor(0)
@@ -127,6 +130,7 @@ MainWindow::MainWindow(QWidget* parent)
 
     statusBar()->addWidget(&m_status_bar);
 
+    build_render_statistics_panel();
     build_menus();
     build_toolbar();
     build_log_panel();
@@ -257,6 +261,7 @@ void MainWindow::build_menus()
     m_ui->menu_view->addAction(m_ui->project_explorer->toggleViewAction());
     m_ui->menu_view->addAction(m_ui->attribute_editor->toggleViewAction());
     m_ui->menu_view->addAction(m_ui->log->toggleViewAction());
+    m_ui->menu_view->addAction(m_render_statistics_dock->toggleViewAction());
     m_ui->menu_view->addSeparator();
 
     QAction* fullscreen_action = m_ui->menu_view->addAction("Fullscreen");
@@ -510,6 +515,19 @@ void MainWindow::build_log_panel()
     global_logger().add_target(m_log_target.get());
 }
 
+void MainWindow::build_render_statistics_panel()
+{
+    m_render_statistics_dock = new QDockWidget("Render Statistics", this);
+    m_render_statistics_dock->setObjectName("render_statistics");
+    m_render_statistics_dock->setWidget(new RenderStatisticsPanel(m_rendering_manager, m_render_statistics_dock));
+
+    // Share the space of the log panel, hidden until requested from the View menu.
+    addDockWidget(Qt::BottomDockWidgetArea, m_render_statistics_dock);
+    tabifyDockWidget(m_ui->log, m_render_statistics_dock);
+    m_ui->log->raise();
+    m_render_statistics_dock->hide();
+}
+
 void MainWindow::build_project_explorer()
 {
     m_ui->treewidget_project_explorer_scene->setColumnWidth(0, 220);    // name
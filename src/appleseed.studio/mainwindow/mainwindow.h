@@ -60,6 +60,7 @@ namespace appleseed { namespace studio { class MinimizeButton; } }
 namespace Ui        { class MainWindow; }
 class QAction;
 class QCloseEvent;
+class QDockWidget;
 class QDragEnterEvent;
 class QDropEvent;
 class QFileSystemWatcher;
@@ -114,6 +115,7 @@ class MainWindow
 
     StatusBar                               m_status_bar;
     std::auto_ptr<QtLogTarget>              m_log_target;
+    QDockWidget*                            m_render_statistics_dock;
 
     renderer::ParamArray                    m_settings;
 
@@ -154,6 +156,7 @@ class MainWindow
     // Other UI elements.
     void build_toolbar();
     void build_log_panel();
+    void build_render_statistics_panel();
     void build_project_explorer();
     void build_minimize_buttons();
     void build_connections();
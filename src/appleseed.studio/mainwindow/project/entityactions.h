@@ -31,9 +31,18 @@
 #define APPLESEED_STUDIO_MAINWINDOW_PROJECT_ENTITYACTIONS_H
 
 // appleseed.studio headers.
+#include "mainwindow/rendering/dirtyregion.h"
 #include "mainwindow/rendering/renderingmanager.h"
 
+// appleseed.renderer headers.
+#include "renderer/api/frame.h"
+#include "renderer/api/project.h"
+
 // appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/utility/containers/dictionary.h"
 
@@ -102,6 +111,49 @@ class EntityEditionAction
     const foundation::Dictionary        m_values;
 };
 
+template <typename EntityItem>
+class EntityDirtyRegionAction
+  : public RenderingManager::IScheduledAction
+{
+  public:
+    // The region covered by the entity before the edition is computed by the caller.
+    EntityDirtyRegionAction(
+        EntityItem*                     item,
+        RenderingManager&               rendering_manager,
+        const foundation::AABB2u&       region)
+      : m_item(item)
+      , m_rendering_manager(rendering_manager)
+      , m_region(region)
+    {
+    }
+
+    virtual void operator()(
+        renderer::Project&              project) APPLESEED_OVERRIDE
+    {
+        // The entity may have moved: also cover the region it covers after the edition.
+        foundation::AABB2u region;
+        if (compute_dirty_region(project, *m_item->m_entity, region))
+        {
+            region.insert(m_region);
+        }
+        else
+        {
+            const foundation::CanvasProperties& props = project.get_frame()->image().properties();
+            region =
+                foundation::AABB2u(
+                    foundation::Vector2u(0, 0),
+                    foundation::Vector2u(props.m_canvas_width - 1, props.m_canvas_height - 1));
+        }
+
+        m_rendering_manager.set_dirty_region(region);
+    }
+
+  private:
+    EntityItem*                         m_item;
+    RenderingManager&                   m_rendering_manager;
+    const foundation::AABB2u            m_region;
+};
+
 template <typename EntityItem>
 class EntityInstantiationAction
   : public RenderingManager::IScheduledAction
@@ -37,6 +37,7 @@
 #include "mainwindow/project/entityitembase.h"
 #include "mainwindow/project/itemregistry.h"
 #include "mainwindow/project/projectbuilder.h"
+#include "mainwindow/rendering/dirtyregion.h"
 #include "mainwindow/rendering/renderingmanager.h"
 #include "utility/miscellaneous.h"
 #include "utility/treewidget.h"
@@ -45,6 +46,7 @@
 #include "renderer/api/entity.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/aabb.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/utility/uid.h"
 
@@ -95,6 +97,7 @@ class EntityItem
   private:
     friend class EntityCreatorBase;
     friend class EntityEditionAction<EntityItem>;
+    friend class EntityDirtyRegionAction<EntityItem>;
     friend class EntityInstantiationAction<EntityItem>;
     friend class EntityDeletionAction<EntityItem>;
 
@@ -136,13 +139,25 @@ bool EntityItem<Entity, ParentEntity, CollectionItem>::is_fixed_position() const
 template <typename Entity, typename ParentEntity, typename CollectionItem>
 void EntityItem<Entity, ParentEntity, CollectionItem>::slot_edit_accepted(foundation::Dictionary values)
 {
-    if (Base::m_editor_context.m_rendering_manager.is_rendering())
+    RenderingManager& rendering_manager = Base::m_editor_context.m_rendering_manager;
+
+    if (rendering_manager.is_rendering())
     {
-        Base::m_editor_context.m_rendering_manager.schedule(
+        rendering_manager.schedule(
             std::auto_ptr<RenderingManager::IScheduledAction>(
                 new EntityEditionAction<EntityItem>(this, values)));
 
-        Base::m_editor_context.m_rendering_manager.reinitialize_rendering();
+        // Only render again the part of the frame covered by the entity if it can be estimated.
+        foundation::AABB2u dirty_region;
+        if (compute_dirty_region(Base::m_editor_context.m_project, *Base::m_entity, dirty_region))
+        {
+            rendering_manager.schedule(
+                std::auto_ptr<RenderingManager::IScheduledAction>(
+                    new EntityDirtyRegionAction<EntityItem>(this, rendering_manager, dirty_region)));
+
+            rendering_manager.reinitialize_rendering_dirty_regions();
+        }
+        else rendering_manager.reinitialize_rendering();
     }
     else
     {
@@ -39,6 +39,7 @@
 #include "mainwindow/project/entityeditorcontext.h"
 #include "mainwindow/project/objectinstanceitem.h"
 #include "mainwindow/project/projectbuilder.h"
+#include "mainwindow/rendering/dirtyregion.h"
 #include "mainwindow/rendering/renderingmanager.h"
 #include "utility/interop.h"
 #include "utility/miscellaneous.h"
@@ -48,6 +49,7 @@
 #include "renderer/api/object.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/aabb.h"
 #include "foundation/utility/foreach.h"
 
 // Qt headers.
@@ -312,6 +314,32 @@ MaterialAssignmentEditorWindow::SlotValue MaterialAssignmentEditorWindow::get_sl
     return slot_value;
 }
 
+namespace
+{
+    class SetDirtyRegionAction
+      : public RenderingManager::IScheduledAction
+    {
+      public:
+        SetDirtyRegionAction(
+            RenderingManager&           rendering_manager,
+            const AABB2u&               region)
+          : m_rendering_manager(rendering_manager)
+          , m_region(region)
+        {
+        }
+
+        virtual void operator()(
+            Project&                    project) APPLESEED_OVERRIDE
+        {
+            m_rendering_manager.set_dirty_region(m_region);
+        }
+
+      private:
+        RenderingManager&               m_rendering_manager;
+        const AABB2u                    m_region;
+    };
+}
+
 void MaterialAssignmentEditorWindow::assign_materials(const SlotValueCollection& slot_values)
 {
     const StringDictionary old_front_mappings = m_object_instance.get_front_material_mappings();
@@ -324,8 +352,22 @@ void MaterialAssignmentEditorWindow::assign_materials(const SlotValueCollection&
         old_back_mappings != m_object_instance.get_back_material_mappings())
         m_editor_context.m_project_builder.notify_project_modification();
 
-    if (m_editor_context.m_rendering_manager.is_rendering())
-        m_editor_context.m_rendering_manager.reinitialize_rendering();
+    RenderingManager& rendering_manager = m_editor_context.m_rendering_manager;
+
+    if (rendering_manager.is_rendering())
+    {
+        // Assigning materials doesn't move the object instance: only render its region again.
+        AABB2u dirty_region;
+        if (compute_dirty_region(m_editor_context.m_project, m_object_instance, dirty_region))
+        {
+            rendering_manager.schedule(
+                auto_ptr<RenderingManager::IScheduledAction>(
+                    new SetDirtyRegionAction(rendering_manager, dirty_region)));
+
+            rendering_manager.reinitialize_rendering_dirty_regions();
+        }
+        else rendering_manager.reinitialize_rendering();
+    }
 }
 
 namespace
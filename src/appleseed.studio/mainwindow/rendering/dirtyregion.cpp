@@ -0,0 +1,265 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "dirtyregion.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/camera.h"
+#include "renderer/api/entity.h"
+#include "renderer/api/frame.h"
+#include "renderer/api/material.h"
+#include "renderer/api/object.h"
+#include "renderer/api/project.h"
+#include "renderer/api/scene.h"
+#include "renderer/api/utility.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/math/filter.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/foreach.h"
+#include "foundation/utility/otherwise.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+namespace appleseed {
+namespace studio {
+
+namespace
+{
+    // Object instances are matched by names rather than by pointers since editing an
+    // entity replaces it by a new one, and the bounds of an edited entity need to be
+    // computed both before and after the edition.
+    class DependencyFilter
+    {
+      public:
+        enum Kind
+        {
+            ObjectInstanceDependency,
+            ObjectDependency,
+            MaterialDependency
+        };
+
+        DependencyFilter(const Kind kind, const char* name)
+          : m_kind(kind)
+          , m_name(name)
+        {
+        }
+
+        bool depends_on(const ObjectInstance& object_instance) const
+        {
+            switch (m_kind)
+            {
+              case ObjectInstanceDependency:
+                return strcmp(object_instance.get_name(), m_name) == 0;
+
+              case ObjectDependency:
+                return strcmp(object_instance.get_object_name(), m_name) == 0;
+
+              case MaterialDependency:
+                return
+                    uses_material(object_instance.get_front_material_mappings()) ||
+                    uses_material(object_instance.get_back_material_mappings());
+
+              assert_otherwise;
+            }
+
+            return false;
+        }
+
+      private:
+        const Kind  m_kind;
+        const char* m_name;
+
+        bool uses_material(const StringDictionary& mappings) const
+        {
+            for (const_each<StringDictionary> i = mappings; i; ++i)
+            {
+                if (strcmp(i->value(), m_name) == 0)
+                    return true;
+            }
+
+            return false;
+        }
+    };
+
+    // Compute the bounding box, in the space of a given assembly, of the object
+    // instances depending on the edited entity, including those of child assemblies.
+    GAABB3 compute_dependent_bbox(
+        const Assembly&         assembly,
+        const DependencyFilter& filter)
+    {
+        GAABB3 bbox;
+        bbox.invalidate();
+
+        for (const_each<ObjectInstanceContainer> i = assembly.object_instances(); i; ++i)
+        {
+            if (filter.depends_on(*i))
+                bbox.insert(i->compute_parent_bbox());
+        }
+
+        for (const_each<AssemblyInstanceContainer> i = assembly.assembly_instances(); i; ++i)
+        {
+            const Assembly* child_assembly = i->find_assembly();
+            if (child_assembly == 0)
+                continue;
+
+            const GAABB3 child_bbox = compute_dependent_bbox(*child_assembly, filter);
+            if (child_bbox.is_valid())
+                bbox.insert(i->transform_sequence().to_parent(child_bbox));
+        }
+
+        return bbox;
+    }
+
+    GAABB3 compute_dependent_bbox(
+        const Scene&            scene,
+        const DependencyFilter& filter)
+    {
+        GAABB3 bbox;
+        bbox.invalidate();
+
+        for (const_each<AssemblyInstanceContainer> i = scene.assembly_instances(); i; ++i)
+        {
+            const Assembly* assembly = i->find_assembly();
+            if (assembly == 0)
+                continue;
+
+            const GAABB3 assembly_bbox = compute_dependent_bbox(*assembly, filter);
+            if (assembly_bbox.is_valid())
+                bbox.insert(i->transform_sequence().to_parent(assembly_bbox));
+        }
+
+        return bbox;
+    }
+
+    // Project the corners of a world space bounding box onto the frame, at both ends
+    // of the shutter interval, and return the enclosing bounding box in NDC.
+    bool project_bbox(
+        const Camera&           camera,
+        const GAABB3&           bbox,
+        AABB2d&                 ndc_bbox)
+    {
+        const float times[2] =
+        {
+            camera.get_shutter_open_time(),
+            camera.get_shutter_close_time()
+        };
+
+        ndc_bbox.invalidate();
+
+        for (size_t t = 0; t < 2; ++t)
+        {
+            for (size_t c = 0; c < 8; ++c)
+            {
+                const Vector3d corner(bbox.compute_corner(c));
+
+                Vector2d ndc;
+                if (!camera.project_point(times[t], corner, ndc))
+                    return false;
+
+                ndc_bbox.insert(ndc);
+            }
+        }
+
+        return true;
+    }
+}
+
+bool compute_dirty_region(
+    const Project&              project,
+    const Entity&               entity,
+    AABB2u&                     region)
+{
+    const Scene* scene = project.get_scene();
+    const Frame* frame = project.get_frame();
+
+    if (scene == 0 || frame == 0)
+        return false;
+
+    const Camera* camera = project.get_uncached_active_camera();
+    if (camera == 0)
+        return false;
+
+    DependencyFilter::Kind kind;
+    if (dynamic_cast<const ObjectInstance*>(&entity))
+        kind = DependencyFilter::ObjectInstanceDependency;
+    else if (dynamic_cast<const Object*>(&entity))
+        kind = DependencyFilter::ObjectDependency;
+    else if (dynamic_cast<const Material*>(&entity))
+        kind = DependencyFilter::MaterialDependency;
+    else return false;
+
+    const GAABB3 bbox =
+        compute_dependent_bbox(*scene, DependencyFilter(kind, entity.get_name()));
+    if (!bbox.is_valid())
+        return false;
+
+    AABB2d ndc_bbox;
+    if (!project_bbox(*camera, bbox, ndc_bbox))
+        return false;
+
+    const CanvasProperties& props = frame->image().properties();
+    const double width = static_cast<double>(props.m_canvas_width);
+    const double height = static_cast<double>(props.m_canvas_height);
+
+    // Pad the region by the radius of the reconstruction filter since samples
+    // taken inside the region contribute to the pixels around it.
+    const double pad_x = ceil(frame->get_filter().get_xradius()) + 1.0;
+    const double pad_y = ceil(frame->get_filter().get_yradius()) + 1.0;
+
+    const double x0 = floor(ndc_bbox.min.x * width - pad_x);
+    const double y0 = floor(ndc_bbox.min.y * height - pad_y);
+    const double x1 = ceil(ndc_bbox.max.x * width + pad_x);
+    const double y1 = ceil(ndc_bbox.max.y * height + pad_y);
+
+    // The entity lies outside of the frame, yet it may still be seen indirectly.
+    if (x1 < 0.0 || y1 < 0.0 || x0 >= width || y0 >= height)
+        return false;
+
+    region.min.x = static_cast<size_t>(max(x0, 0.0));
+    region.min.y = static_cast<size_t>(max(y0, 0.0));
+    region.max.x = static_cast<size_t>(min(x1, width - 1.0));
+    region.max.y = static_cast<size_t>(min(y1, height - 1.0));
+
+    return true;
+}
+
+}   // namespace studio
+}   // namespace appleseed
@@ -0,0 +1,64 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_STUDIO_MAINWINDOW_RENDERING_DIRTYREGION_H
+#define APPLESEED_STUDIO_MAINWINDOW_RENDERING_DIRTYREGION_H
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+
+// Forward declarations.
+namespace renderer  { class Entity; }
+namespace renderer  { class Project; }
+
+namespace appleseed {
+namespace studio {
+
+//
+// Estimate the region of the frame that needs to be rendered again after an entity
+// was edited, by projecting the bounding boxes of the object instances depending on
+// that entity through the active camera.
+//
+// Object instances, objects and materials are supported. Indirect effects such as
+// shadows and reflections cast onto other parts of the scene are not accounted for.
+//
+// Returns false if the entity is of another type, if no object instance depends on
+// it, or if its bounds cannot be projected onto the frame (e.g. because they extend
+// behind the camera); the whole frame should then be rendered again.
+//
+
+bool compute_dirty_region(
+    const renderer::Project&    project,
+    const renderer::Entity&     entity,
+    foundation::AABB2u&         region);
+
+}       // namespace studio
+}       // namespace appleseed
+
+#endif  // !APPLESEED_STUDIO_MAINWINDOW_RENDERING_DIRTYREGION_H
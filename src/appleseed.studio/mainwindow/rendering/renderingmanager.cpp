@@ -49,6 +49,7 @@
 // appleseed.foundation headers.
 #include "foundation/image/analysis.h"
 #include "foundation/image/image.h"
+#include "foundation/math/aabb.h"
 #include "foundation/platform/defaulttimers.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/foreach.h"
@@ -106,6 +107,11 @@ RenderingManager::RenderingManager(StatusBar& status_bar)
   : m_status_bar(status_bar)
   , m_project(0)
   , m_render_tab(0)
+  , m_full_frame_requested(false)
+  , m_has_dirty_region(false)
+  , m_saved_has_crop_window(false)
+  , m_navigation_downscale_factor(4)
+  , m_navigation_restart_time(0)
 {
     //
     // The connections below are using the Qt::BlockingQueuedConnection connection type.
@@ -195,6 +201,15 @@ bool RenderingManager::is_rendering() const
     return m_master_renderer.get() != 0;
 }
 
+bool RenderingManager::get_live_statistics(LiveRenderStatistics& stats) const
+{
+    if (m_master_renderer.get() == 0)
+        return false;
+
+    m_master_renderer->get_live_statistics(stats);
+    return true;
+}
+
 void RenderingManager::wait_until_rendering_end()
 {
     while (is_rendering())
@@ -210,10 +225,24 @@ void RenderingManager::abort_rendering()
 
 void RenderingManager::restart_rendering()
 {
+    // Rendering the whole frame again requires the frame renderer to be recreated.
+    if (m_has_dirty_region)
+    {
+        reinitialize_rendering();
+        return;
+    }
+
     m_renderer_controller.set_status(IRendererController::RestartRendering);
 }
 
 void RenderingManager::reinitialize_rendering()
+{
+    m_full_frame_requested = true;
+
+    m_renderer_controller.set_status(IRendererController::ReinitializeRendering);
+}
+
+void RenderingManager::reinitialize_rendering_dirty_regions()
 {
     m_renderer_controller.set_status(IRendererController::ReinitializeRendering);
 }
@@ -279,6 +308,40 @@ void RenderingManager::clear_sticky_actions()
     m_sticky_actions.clear();
 }
 
+void RenderingManager::set_dirty_region(const AABB2u& region)
+{
+    assert(m_project);
+
+    if (m_full_frame_requested)
+        return;
+
+    Frame* frame = m_project->get_frame();
+
+    AABB2u crop_window = region;
+
+    if (m_has_dirty_region)
+    {
+        // Merge with the regions set by previous actions.
+        crop_window.insert(frame->get_crop_window());
+    }
+    else
+    {
+        m_saved_has_crop_window = frame->has_crop_window();
+        m_saved_crop_window = frame->get_crop_window();
+        m_has_dirty_region = true;
+    }
+
+    // Stay within the render region set by the user, if any.
+    if (m_saved_has_crop_window)
+    {
+        crop_window = AABB2u::intersect(crop_window, m_saved_crop_window);
+        if (!crop_window.is_valid())
+            crop_window = m_saved_crop_window;
+    }
+
+    frame->set_crop_window(crop_window);
+}
+
 void RenderingManager::slot_abort_rendering()
 {
     abort_rendering();
@@ -350,20 +413,69 @@ void RenderingManager::run_sticky_actions()
     }
 }
 
+void RenderingManager::restore_crop_window()
+{
+    if (!m_has_dirty_region)
+        return;
+
+    Frame* frame = m_project->get_frame();
+
+    if (m_saved_has_crop_window)
+        frame->set_crop_window(m_saved_crop_window);
+    else frame->reset_crop_window();
+
+    m_has_dirty_region = false;
+}
+
+void RenderingManager::update_navigation_downscale_factor()
+{
+    // During navigation the frame is displayed at 1/4 resolution, or at 1/8 resolution
+    // if the last restart took longer than the frame time target to reach the display.
+    DefaultWallclockTimer timer;
+    const uint64 now = timer.read();
+
+    if (m_navigation_restart_time > 0)
+    {
+        const uint64 blit_time = m_render_tab->get_render_widget()->get_last_frame_blit_time();
+        const uint64 display_time = blit_time > m_navigation_restart_time ? blit_time : now;
+        const double frame_time =
+            static_cast<double>(display_time - m_navigation_restart_time) / timer.frequency();
+        const double target_frame_time =
+            m_params.get_optional<double>("progressive_resolution_frame_time", 0.1);
+
+        m_navigation_downscale_factor = frame_time > target_frame_time ? 8 : 4;
+    }
+
+    m_navigation_restart_time = now;
+
+    m_render_tab->get_render_widget()->set_downscale_factor(m_navigation_downscale_factor);
+}
+
 void RenderingManager::slot_rendering_begin()
 {
     assert(m_master_renderer.get());
 
+    // Scheduled actions may restrict rendering to the regions affected by edits.
+    restore_crop_window();
+
     run_sticky_actions();
     run_scheduled_actions();
 
+    m_full_frame_requested = false;
+
     m_rendering_timer.clear();
 
     m_has_camera_changed = false;
+
+    m_render_tab->get_render_widget()->set_downscale_factor(1);
+    m_navigation_restart_time = 0;
 }
 
 void RenderingManager::slot_rendering_end()
 {
+    // Don't let the regions affected by edits leak into the project.
+    restore_crop_window();
+
     // Save the controller target point into the camera when rendering ends.
     m_render_tab->get_camera_controller()->save_camera_target();
 
@@ -436,6 +548,9 @@ void RenderingManager::slot_camera_changed()
     }
     else
     {
+        if (m_params.get_optional<bool>("progressive_resolution_during_navigation", false))
+            update_navigation_downscale_factor();
+
         restart_rendering();
     }
 }
@@ -453,6 +568,13 @@ void RenderingManager::slot_camera_change_end()
 
         restart_rendering();
     }
+
+    // Refine the display to full resolution once the camera stops.
+    if (m_navigation_restart_time > 0)
+    {
+        m_render_tab->get_render_widget()->set_downscale_factor(1);
+        m_navigation_restart_time = 0;
+    }
 }
 
 void RenderingManager::slot_master_renderer_thread_finished()
@@ -42,8 +42,10 @@
 #include "renderer/api/utility.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/aabb.h"
 #include "foundation/math/transform.h"
 #include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/autoreleaseptr.h"
 #include "foundation/utility/job/abortswitch.h"
 
@@ -52,6 +54,7 @@
 #include <QThread>
 
 // Standard headers.
+#include <cstddef>
 #include <map>
 #include <memory>
 #include <string>
@@ -88,6 +91,10 @@ class RenderingManager
     // Return true if currently rendering, false otherwise.
     bool is_rendering() const;
 
+    // Take a snapshot of the progress of the current render.
+    // Return false if not currently rendering.
+    bool get_live_statistics(renderer::LiveRenderStatistics& stats) const;
+
     // Wait until rendering has ended.
     void wait_until_rendering_end();
 
@@ -142,6 +149,15 @@ class RenderingManager
     // Remove all sticky actions.
     void clear_sticky_actions();
 
+    // Reinitialize rendering after an edit whose effects are confined to the regions set
+    // by scheduled actions via set_dirty_region(). The pixels outside of these regions are
+    // kept. The whole frame is rendered again if rendering gets reinitialized for another
+    // reason before rendering begins.
+    void reinitialize_rendering_dirty_regions();
+
+    // Add a region of the frame to render again. Must be called from a scheduled action.
+    void set_dirty_region(const foundation::AABB2u& region);
+
   signals:
     void signal_camera_changed();
     void signal_rendering_end();
@@ -173,6 +189,16 @@ class RenderingManager
 
     bool                                        m_has_camera_changed;
 
+    // Rendering of the regions affected by edits.
+    bool                                        m_full_frame_requested;
+    bool                                        m_has_dirty_region;
+    bool                                        m_saved_has_crop_window;
+    foundation::AABB2u                          m_saved_crop_window;
+
+    // Progressive resolution display during camera navigation.
+    size_t                                      m_navigation_downscale_factor;
+    foundation::uint64                          m_navigation_restart_time;
+
     class FrozenDisplayFunc
     {
       public:
@@ -206,6 +232,10 @@ class RenderingManager
     void run_scheduled_actions();
     void run_sticky_actions();
 
+    void restore_crop_window();
+
+    void update_navigation_downscale_factor();
+
   private slots:
     void slot_rendering_begin();
     void slot_rendering_end();
@@ -32,23 +32,43 @@
 
 // appleseed.renderer headers.
 #include "renderer/api/frame.h"
+#include "renderer/api/log.h"
 
 // appleseed.foundation headers.
 #include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/colorspace.h"
 #include "foundation/image/image.h"
 #include "foundation/image/nativedrawing.h"
+#include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
 #include "foundation/math/scalar.h"
+#include "foundation/platform/defaulttimers.h"
 #include "foundation/platform/types.h"
 
 // Qt headers.
 #include <QColor>
+#include <QGLFormat>
+#include <QGLShaderProgram>
 #include <QMutexLocker>
 #include <Qt>
 
 // Standard headers.
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
+
+// OpenGL tokens that older OpenGL headers may lack.
+#ifndef GL_RGBA32F_ARB
+#define GL_RGBA32F_ARB 0x8814
+#endif
+#ifndef GL_RGBA16F_ARB
+#define GL_RGBA16F_ARB 0x881A
+#endif
+#ifndef GL_HALF_FLOAT_ARB
+#define GL_HALF_FLOAT_ARB 0x140B
+#endif
 
 using namespace foundation;
 using namespace renderer;
@@ -65,8 +85,17 @@ RenderWidget::RenderWidget(
     const size_t    width,
     const size_t    height,
     QWidget*        parent)
-  : QWidget(parent)
+  : QGLWidget(parent)
   , m_mutex(QMutex::Recursive)
+  , m_downscale_factor(1)
+  , m_last_frame_blit_time(0)
+  , m_gpu_display_enabled(QGLFormat::hasOpenGL())
+  , m_gpu_display_active(false)
+  , m_gpu_color_space(ColorSpaceLinearRGB)
+  , m_gpu_rcp_gamma(1.0f)
+  , m_gpu_texture(0)
+  , m_gpu_texture_width(0)
+  , m_gpu_texture_height(0)
 {
     setFocusPolicy(Qt::StrongFocus);
     setAutoFillBackground(false);
@@ -75,10 +104,22 @@ RenderWidget::RenderWidget(
     resize(width, height);
 }
 
+RenderWidget::~RenderWidget()
+{
+    if (m_gpu_texture != 0)
+    {
+        makeCurrent();
+        glDeleteTextures(1, &m_gpu_texture);
+    }
+}
+
 QImage RenderWidget::get_image_copy() const
 {
     QMutexLocker locker(&m_mutex);
 
+    // The QImage is only a cache while the frame is displayed through OpenGL.
+    const_cast<RenderWidget*>(this)->leave_gpu_display();
+
     return m_image.copy();
 }
 
@@ -104,6 +145,8 @@ void RenderWidget::clear()
 {
     QMutexLocker locker(&m_mutex);
 
+    m_gpu_display_active = false;
+
     m_image.fill(QColor(0, 0, 0));
 }
 
@@ -130,6 +173,8 @@ void RenderWidget::multiply(const float multiplier)
 
     assert(multiplier >= 0.0f && multiplier <= 1.0f);
 
+    leave_gpu_display();
+
     const size_t image_width = static_cast<size_t>(m_image.width());
     const size_t image_height = static_cast<size_t>(m_image.height());
     const size_t dest_stride = static_cast<size_t>(m_image.bytesPerLine());
@@ -188,6 +233,8 @@ void RenderWidget::highlight_region(
 {
     QMutexLocker locker(&m_mutex);
 
+    leave_gpu_display();
+
     // Retrieve destination image information.
     APPLESEED_UNUSED const size_t image_width = static_cast<size_t>(m_image.width());
     APPLESEED_UNUSED const size_t image_height = static_cast<size_t>(m_image.height());
@@ -222,6 +269,8 @@ void RenderWidget::blit_tile(
 {
     QMutexLocker locker(&m_mutex);
 
+    leave_gpu_display();
+
     allocate_working_storage(frame.image().properties());
 
     blit_tile_no_lock(frame, tile_x, tile_y);
@@ -231,19 +280,80 @@ void RenderWidget::blit_frame(const Frame& frame)
 {
     QMutexLocker locker(&m_mutex);
 
-    const CanvasProperties& frame_props = frame.image().properties();
+    if (can_blit_frame_to_gpu(frame))
+        blit_frame_to_gpu(frame);
+    else
+    {
+        leave_gpu_display();
 
-    allocate_working_storage(frame_props);
+        const CanvasProperties& frame_props = frame.image().properties();
 
-    for (size_t y = 0; y < frame_props.m_tile_count_y; ++y)
-    {
-        for (size_t x = 0; x < frame_props.m_tile_count_x; ++x)
-            blit_tile_no_lock(frame, x, y);
+        allocate_working_storage(frame_props);
+
+        for (size_t y = 0; y < frame_props.m_tile_count_y; ++y)
+        {
+            for (size_t x = 0; x < frame_props.m_tile_count_x; ++x)
+                blit_tile_no_lock(frame, x, y);
+        }
     }
+
+    m_last_frame_blit_time = DefaultWallclockTimer().read();
+}
+
+void RenderWidget::set_downscale_factor(const size_t factor)
+{
+    assert(factor >= 1);
+
+    QMutexLocker locker(&m_mutex);
+
+    m_downscale_factor = factor;
+}
+
+uint64 RenderWidget::get_last_frame_blit_time() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_last_frame_blit_time;
 }
 
 namespace
 {
+    // Replace every block of factor x factor pixels of a 32-bit floating point RGBA tile by its average.
+    void downscale_tile(Tile& tile, const size_t factor)
+    {
+        assert(tile.get_pixel_format() == PixelFormatFloat);
+        assert(tile.get_channel_count() == 4);
+
+        const size_t tile_width = tile.get_width();
+        const size_t tile_height = tile.get_height();
+
+        for (size_t by = 0; by < tile_height; by += factor)
+        {
+            const size_t ey = min(by + factor, tile_height);
+
+            for (size_t bx = 0; bx < tile_width; bx += factor)
+            {
+                const size_t ex = min(bx + factor, tile_width);
+
+                Color4f sum(0.0f);
+
+                for (size_t y = by; y < ey; ++y)
+                {
+                    for (size_t x = bx; x < ex; ++x)
+                        sum += *reinterpret_cast<const Color4f*>(tile.pixel(x, y));
+                }
+
+                const Color4f average = sum / static_cast<float>((ex - bx) * (ey - by));
+
+                for (size_t y = by; y < ey; ++y)
+                {
+                    for (size_t x = bx; x < ex; ++x)
+                        *reinterpret_cast<Color4f*>(tile.pixel(x, y)) = average;
+                }
+            }
+        }
+    }
+
     bool is_compatible(const Tile& tile, const CanvasProperties& props)
     {
         return
@@ -290,9 +400,26 @@ void RenderWidget::blit_tile_no_lock(
         PixelFormatFloat,
         m_float_tile_storage->get_storage());
 
+    // Average blocks of pixels in linear space when displaying at reduced resolution.
+    if (m_downscale_factor > 1)
+        downscale_tile(fp_rgb_tile, m_downscale_factor);
+
     // Transform the tile to the color space of the frame.
     frame.transform_to_output_color_space(fp_rgb_tile);
 
+    // Compute the coordinates of the first destination pixel.
+    const CanvasProperties& frame_props = frame.image().properties();
+    const size_t x = tile_x * frame_props.m_tile_width;
+    const size_t y = tile_y * frame_props.m_tile_height;
+
+    blit_display_tile_no_lock(fp_rgb_tile, x, y);
+}
+
+void RenderWidget::blit_display_tile_no_lock(
+    const Tile&     fp_rgb_tile,
+    const size_t    x,
+    const size_t    y)
+{
     // Convert the tile to 8-bit RGB for display.
     static const size_t ShuffleTable[] = { 0, 1, 2, Pixel::SkipChannel };
     const Tile uint8_rgb_tile(
@@ -306,16 +433,11 @@ void RenderWidget::blit_tile_no_lock(
     APPLESEED_UNUSED const size_t image_height = static_cast<size_t>(m_image.height());
     const size_t dest_stride = static_cast<size_t>(m_image.bytesPerLine());
 
-    // Compute the coordinates of the first destination pixel.
-    const CanvasProperties& frame_props = frame.image().properties();
-    const size_t x = tile_x * frame_props.m_tile_width;
-    const size_t y = tile_y * frame_props.m_tile_height;
-
     // Clipping is not supported.
     assert(x < image_width);
     assert(y < image_height);
-    assert(x + tile.get_width() <= image_width);
-    assert(y + tile.get_height() <= image_height);
+    assert(x + fp_rgb_tile.get_width() <= image_width);
+    assert(y + fp_rgb_tile.get_height() <= image_height);
 
     // Get a pointer to the first destination pixel.
     uint8* dest = get_image_pointer(m_image, x, y);
@@ -324,12 +446,308 @@ void RenderWidget::blit_tile_no_lock(
     NativeDrawing::blit(dest, dest_stride, uint8_rgb_tile);
 }
 
+namespace
+{
+    bool is_compatible(const Image& image, const CanvasProperties& props)
+    {
+        const CanvasProperties& image_props = image.properties();
+
+        return
+            image_props.m_canvas_width == props.m_canvas_width &&
+            image_props.m_canvas_height == props.m_canvas_height &&
+            image_props.m_tile_width == props.m_tile_width &&
+            image_props.m_tile_height == props.m_tile_height &&
+            image_props.m_channel_count == props.m_channel_count &&
+            image_props.m_pixel_format == props.m_pixel_format;
+    }
+
+    // CPU equivalent of the display fragment shader, applied to a 32-bit floating point RGBA tile.
+    void transform_to_display(Tile& tile, const ColorSpace color_space, const float rcp_gamma)
+    {
+        assert(tile.get_pixel_format() == PixelFormatFloat);
+        assert(tile.get_channel_count() == 4);
+
+        const size_t pixel_count = tile.get_pixel_count();
+
+        for (size_t i = 0; i < pixel_count; ++i)
+        {
+            Color4f& pixel = *reinterpret_cast<Color4f*>(tile.pixel(i));
+            Color3f rgb = component_wise_max(pixel.rgb(), Color3f(0.0f));
+
+            if (color_space == ColorSpaceSRGB)
+                rgb = linear_rgb_to_srgb(rgb);
+
+            if (rcp_gamma != 1.0f)
+            {
+                for (size_t c = 0; c < 3; ++c)
+                    rgb[c] = pow(rgb[c], rcp_gamma);
+            }
+
+            pixel.rgb() = saturate(rgb);
+        }
+    }
+
+    const char* DisplayVertexShader =
+        "#version 110\n"
+        "void main()\n"
+        "{\n"
+        "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+        "    gl_Position = gl_Vertex;\n"
+        "}\n";
+
+    const char* DisplayFragmentShader =
+        "#version 110\n"
+        "uniform sampler2D frame;\n"
+        "uniform int srgb;\n"
+        "uniform float rcp_gamma;\n"
+        "void main()\n"
+        "{\n"
+        "    vec3 color = max(texture2D(frame, gl_TexCoord[0].st).rgb, vec3(0.0));\n"
+        "    if (srgb != 0)\n"
+        "    {\n"
+        "        color = mix(\n"
+        "            color * 12.92,\n"
+        "            1.055 * pow(color, vec3(1.0 / 2.4)) - 0.055,\n"
+        "            step(vec3(0.0031308), color));\n"
+        "    }\n"
+        "    color = pow(color, vec3(rcp_gamma));\n"
+        "    gl_FragColor = vec4(clamp(color, 0.0, 1.0), 1.0);\n"
+        "}\n";
+}
+
+bool RenderWidget::can_blit_frame_to_gpu(const Frame& frame) const
+{
+    if (!m_gpu_display_enabled || m_downscale_factor > 1)
+        return false;
+
+    const CanvasProperties& frame_props = frame.image().properties();
+
+    return
+        frame_props.m_canvas_width == static_cast<size_t>(m_image.width()) &&
+        frame_props.m_canvas_height == static_cast<size_t>(m_image.height()) &&
+        frame_props.m_channel_count == 4 &&
+        (frame_props.m_pixel_format == PixelFormatFloat ||
+         frame_props.m_pixel_format == PixelFormatHalf) &&
+        (frame.get_color_space() == ColorSpaceLinearRGB ||
+         frame.get_color_space() == ColorSpaceSRGB);
+}
+
+void RenderWidget::blit_frame_to_gpu(const Frame& frame)
+{
+    const Image& frame_image = frame.image();
+    const CanvasProperties& frame_props = frame_image.properties();
+
+    if (!m_gpu_staging_image.get() || !is_compatible(*m_gpu_staging_image.get(), frame_props))
+    {
+        m_gpu_staging_image.reset(
+            new Image(
+                frame_props.m_canvas_width,
+                frame_props.m_canvas_height,
+                frame_props.m_tile_width,
+                frame_props.m_tile_height,
+                frame_props.m_channel_count,
+                frame_props.m_pixel_format));
+    }
+
+    // Copy the pixels as is; the color transform is deferred to the fragment shader.
+    for (size_t y = 0; y < frame_props.m_tile_count_y; ++y)
+    {
+        for (size_t x = 0; x < frame_props.m_tile_count_x; ++x)
+        {
+            const Tile& source = frame_image.tile(x, y);
+            Tile& dest = m_gpu_staging_image->tile(x, y);
+            memcpy(dest.get_storage(), source.get_storage(), source.get_size());
+        }
+    }
+
+    m_gpu_dirty_tiles.assign(frame_props.m_tile_count, true);
+
+    m_gpu_color_space = frame.get_color_space();
+    m_gpu_rcp_gamma = 1.0f / frame.get_parameters().get_optional<float>("gamma_correction", 1.0f);
+    m_gpu_display_active = true;
+}
+
+void RenderWidget::leave_gpu_display()
+{
+    if (!m_gpu_display_active)
+        return;
+
+    m_gpu_display_active = false;
+
+    const CanvasProperties& props = m_gpu_staging_image->properties();
+
+    allocate_working_storage(props);
+
+    for (size_t y = 0; y < props.m_tile_count_y; ++y)
+    {
+        for (size_t x = 0; x < props.m_tile_count_x; ++x)
+        {
+            Tile fp_rgb_tile(
+                m_gpu_staging_image->tile(x, y),
+                PixelFormatFloat,
+                m_float_tile_storage->get_storage());
+
+            transform_to_display(fp_rgb_tile, m_gpu_color_space, m_gpu_rcp_gamma);
+
+            blit_display_tile_no_lock(
+                fp_rgb_tile,
+                x * props.m_tile_width,
+                y * props.m_tile_height);
+        }
+    }
+}
+
+bool RenderWidget::initialize_gpu_display()
+{
+    if (!QGLShaderProgram::hasOpenGLShaderPrograms(context()))
+    {
+        RENDERER_LOG_INFO("opengl shader programs are not available, using software display.");
+        return false;
+    }
+
+    m_gpu_program.reset(new QGLShaderProgram(context()));
+
+    if (!m_gpu_program->addShaderFromSourceCode(QGLShader::Vertex, DisplayVertexShader) ||
+        !m_gpu_program->addShaderFromSourceCode(QGLShader::Fragment, DisplayFragmentShader) ||
+        !m_gpu_program->link())
+    {
+        RENDERER_LOG_WARNING(
+            "failed to build opengl display program, using software display: %s",
+            m_gpu_program->log().toAscii().constData());
+        m_gpu_program.reset();
+        return false;
+    }
+
+    glGenTextures(1, &m_gpu_texture);
+    glBindTexture(GL_TEXTURE_2D, m_gpu_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return true;
+}
+
+bool RenderWidget::paint_gpu_display()
+{
+    if (!m_gpu_program.get() && !initialize_gpu_display())
+        return false;
+
+    const CanvasProperties& props = m_gpu_staging_image->properties();
+    const GLenum pixel_type = props.m_pixel_format == PixelFormatHalf ? GL_HALF_FLOAT_ARB : GL_FLOAT;
+
+    glBindTexture(GL_TEXTURE_2D, m_gpu_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // (Re)allocate the texture when the frame size changes.
+    if (m_gpu_texture_width != props.m_canvas_width || m_gpu_texture_height != props.m_canvas_height)
+    {
+        glTexImage2D(
+            GL_TEXTURE_2D,
+            0,
+            props.m_pixel_format == PixelFormatHalf ? GL_RGBA16F_ARB : GL_RGBA32F_ARB,
+            static_cast<GLsizei>(props.m_canvas_width),
+            static_cast<GLsizei>(props.m_canvas_height),
+            0,
+            GL_RGBA,
+            pixel_type,
+            0);
+
+        if (glGetError() != GL_NO_ERROR)
+        {
+            RENDERER_LOG_WARNING("failed to allocate floating-point opengl texture, using software display.");
+            glBindTexture(GL_TEXTURE_2D, 0);
+            return false;
+        }
+
+        m_gpu_texture_width = props.m_canvas_width;
+        m_gpu_texture_height = props.m_canvas_height;
+        m_gpu_dirty_tiles.assign(props.m_tile_count, true);
+    }
+
+    // Upload the tiles that changed since the last paint.
+    for (size_t y = 0; y < props.m_tile_count_y; ++y)
+    {
+        for (size_t x = 0; x < props.m_tile_count_x; ++x)
+        {
+            const size_t tile_index = y * props.m_tile_count_x + x;
+
+            if (!m_gpu_dirty_tiles[tile_index])
+                continue;
+
+            const Tile& tile = m_gpu_staging_image->tile(x, y);
+
+            glTexSubImage2D(
+                GL_TEXTURE_2D,
+                0,
+                static_cast<GLint>(x * props.m_tile_width),
+                static_cast<GLint>(y * props.m_tile_height),
+                static_cast<GLsizei>(tile.get_width()),
+                static_cast<GLsizei>(tile.get_height()),
+                GL_RGBA,
+                pixel_type,
+                tile.get_storage());
+
+            m_gpu_dirty_tiles[tile_index] = false;
+        }
+    }
+
+    glViewport(0, 0, width(), height());
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glDisable(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_TEXTURE_2D);
+
+    m_gpu_program->bind();
+    m_gpu_program->setUniformValue("frame", static_cast<GLint>(0));
+    m_gpu_program->setUniformValue("srgb", static_cast<GLint>(m_gpu_color_space == ColorSpaceSRGB ? 1 : 0));
+    m_gpu_program->setUniformValue("rcp_gamma", static_cast<GLfloat>(m_gpu_rcp_gamma));
+
+    // Draw a quad covering the viewport, with the first row of the frame at the top.
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0f, 0.0f); glVertex2f(-1.0f,  1.0f);
+    glTexCoord2f(0.0f, 1.0f); glVertex2f(-1.0f, -1.0f);
+    glTexCoord2f(1.0f, 1.0f); glVertex2f( 1.0f, -1.0f);
+    glTexCoord2f(1.0f, 0.0f); glVertex2f( 1.0f,  1.0f);
+    glEnd();
+
+    m_gpu_program->release();
+
+    glDisable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return true;
+}
+
 void RenderWidget::paintEvent(QPaintEvent* event)
 {
     QMutexLocker locker(&m_mutex);
 
     m_painter.begin(this);
-    m_painter.drawImage(rect(), m_image);
+
+    bool painted = false;
+
+    if (m_gpu_display_active)
+    {
+        m_painter.beginNativePainting();
+        painted = paint_gpu_display();
+        m_painter.endNativePainting();
+
+        // Don't try again if the OpenGL path is not usable on this system.
+        if (!painted)
+            m_gpu_display_enabled = false;
+    }
+
+    if (!painted)
+    {
+        leave_gpu_display();
+        m_painter.drawImage(rect(), m_image);
+    }
+
     m_painter.end();
 }
 
@@ -31,22 +31,27 @@
 #define APPLESEED_STUDIO_MAINWINDOW_RENDERING_RENDERWIDGET_H
 
 // appleseed.foundation headers.
+#include "foundation/image/colorspace.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
 
 // Qt headers.
+#include <QGLWidget>
 #include <QImage>
 #include <QMutex>
 #include <QPainter>
-#include <QWidget>
 
 // Standard headers.
 #include <cstddef>
 #include <memory>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class CanvasProperties; }
+namespace foundation    { class Image; }
 namespace foundation    { class Tile; }
 namespace renderer      { class Frame; }
+class QGLShaderProgram;
 class QPaintEvent;
 
 namespace appleseed {
@@ -55,9 +60,13 @@ namespace studio {
 //
 // A render widget based on QImage.
 //
+// When OpenGL shader programs are available, whole floating-point frames blitted with
+// blit_frame() are instead copied as is and uploaded as a texture, and the output color
+// transform is done in a fragment shader. The QImage is brought up-to-date on demand.
+//
 
 class RenderWidget
-  : public QWidget
+  : public QGLWidget
 {
   public:
     // Constructor.
@@ -66,6 +75,9 @@ class RenderWidget
         const size_t            height,
         QWidget*                parent = 0);
 
+    // Destructor.
+    ~RenderWidget();
+
     // Thread-safe.
     QImage get_image_copy() const;
 
@@ -96,6 +108,15 @@ class RenderWidget
     // Thread-safe.
     void blit_frame(const renderer::Frame& frame);
 
+    // Thread-safe. Display subsequently blitted tiles at 1/factor resolution, by averaging
+    // blocks of factor x factor pixels and upscaling them with nearest filtering.
+    // A factor of 1 restores full resolution display.
+    void set_downscale_factor(const size_t factor);
+
+    // Thread-safe. Return the time, as read by foundation::DefaultWallclockTimer,
+    // at which the last whole frame was blitted, or 0 if none was blitted yet.
+    foundation::uint64 get_last_frame_blit_time() const;
+
     // Direct access to internals for high-performance drawing.
     QMutex& mutex();
     QImage& image();
@@ -106,14 +127,42 @@ class RenderWidget
     QPainter                        m_painter;
     std::auto_ptr<foundation::Tile> m_float_tile_storage;
     std::auto_ptr<foundation::Tile> m_uint8_tile_storage;
+    size_t                          m_downscale_factor;
+    foundation::uint64              m_last_frame_blit_time;
+
+    // OpenGL display of floating-point frames.
+    bool                                m_gpu_display_enabled;
+    bool                                m_gpu_display_active;
+    foundation::ColorSpace              m_gpu_color_space;
+    float                               m_gpu_rcp_gamma;
+    std::auto_ptr<foundation::Image>    m_gpu_staging_image;
+    std::vector<bool>                   m_gpu_dirty_tiles;
+    std::auto_ptr<QGLShaderProgram>     m_gpu_program;
+    unsigned int                        m_gpu_texture;
+    size_t                              m_gpu_texture_width;
+    size_t                              m_gpu_texture_height;
 
     void allocate_working_storage(const foundation::CanvasProperties& frame_props);
 
+    bool can_blit_frame_to_gpu(const renderer::Frame& frame) const;
+    void blit_frame_to_gpu(const renderer::Frame& frame);
+
+    // Bring the QImage up-to-date and stop displaying the OpenGL texture.
+    void leave_gpu_display();
+
+    bool initialize_gpu_display();
+    bool paint_gpu_display();
+
     void blit_tile_no_lock(
         const renderer::Frame&  frame,
         const size_t            tile_x,
         const size_t            tile_y);
 
+    void blit_display_tile_no_lock(
+        const foundation::Tile& fp_rgb_tile,
+        const size_t            x,
+        const size_t            y);
+
     virtual void paintEvent(QPaintEvent* event) APPLESEED_OVERRIDE;
 };
 
@@ -129,6 +178,7 @@ inline QMutex& RenderWidget::mutex()
 
 inline QImage& RenderWidget::image()
 {
+    leave_gpu_display();
     return m_image;
 }
 
@@ -0,0 +1,178 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "renderstatisticspanel.h"
+
+// appleseed.studio headers.
+#include "mainwindow/rendering/renderingmanager.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/types.h"
+#include "foundation/utility/string.h"
+
+// Qt headers.
+#include <QFont>
+#include <QString>
+#include <Qt>
+
+// Standard headers.
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+namespace appleseed {
+namespace studio {
+
+//
+// RenderStatisticsPanel class implementation.
+//
+
+namespace
+{
+    const int RefreshRate = 2;      // in Hz
+
+    string pretty_rate(const uint64 count, const double seconds)
+    {
+        return pretty_uint(static_cast<uint64>(count / seconds)) + "/s";
+    }
+}
+
+RenderStatisticsPanel::RenderStatisticsPanel(
+    const RenderingManager&     rendering_manager,
+    QWidget*                    parent)
+  : QLabel(parent)
+  , m_rendering_manager(rendering_manager)
+  , m_has_previous_stats(false)
+{
+    QFont font("Courier New");
+    font.setStyleHint(QFont::TypeWriter);
+    setFont(font);
+
+    setAlignment(Qt::AlignLeft | Qt::AlignTop);
+    setTextInteractionFlags(Qt::TextSelectableByMouse);
+    setText("Not rendering.");
+
+    startTimer(1000 / RefreshRate);
+}
+
+void RenderStatisticsPanel::timerEvent(QTimerEvent* event)
+{
+    LiveRenderStatistics stats;
+
+    if (!m_rendering_manager.get_live_statistics(stats))
+    {
+        if (m_has_previous_stats)
+        {
+            setText("Not rendering.");
+            m_has_previous_stats = false;
+        }
+
+        return;
+    }
+
+    // Rates are computed over the last refresh period. Counters go back to zero
+    // when a new render starts, in which case rates are only available next time.
+    const LiveRenderStatistics& prev = m_previous_stats;
+    const double elapsed = m_has_previous_stats ? stats.m_time - prev.m_time : 0.0;
+    const bool has_rates =
+        elapsed > 0.0 &&
+        stats.m_sample_count >= prev.m_sample_count &&
+        stats.m_shading_ray_count >= prev.m_shading_ray_count &&
+        stats.m_probe_ray_count >= prev.m_probe_ray_count &&
+        stats.m_texture_cache_hit_count >= prev.m_texture_cache_hit_count &&
+        stats.m_texture_cache_miss_count >= prev.m_texture_cache_miss_count;
+
+    stringstream sstr;
+
+    sstr << "stage                  " << stats.m_stage << endl;
+    sstr << "time                   " << pretty_time(stats.m_time, 0) << endl;
+
+    sstr << "samples                " << pretty_uint(stats.m_sample_count);
+    if (has_rates)
+        sstr << " (" << pretty_rate(stats.m_sample_count - prev.m_sample_count, elapsed) << ")";
+    sstr << endl;
+
+    sstr << "shading rays           " << pretty_uint(stats.m_shading_ray_count);
+    if (has_rates)
+        sstr << " (" << pretty_rate(stats.m_shading_ray_count - prev.m_shading_ray_count, elapsed) << ")";
+    sstr << endl;
+
+    sstr << "probe rays             " << pretty_uint(stats.m_probe_ray_count);
+    if (has_rates)
+        sstr << " (" << pretty_rate(stats.m_probe_ray_count - prev.m_probe_ray_count, elapsed) << ")";
+    sstr << endl;
+
+    sstr << "texture cache hit rate ";
+    if (has_rates)
+    {
+        const uint64 hits = stats.m_texture_cache_hit_count - prev.m_texture_cache_hit_count;
+        const uint64 misses = stats.m_texture_cache_miss_count - prev.m_texture_cache_miss_count;
+        sstr << pretty_percent(hits, hits + misses);
+    }
+    else
+    {
+        sstr << pretty_percent(
+            stats.m_texture_cache_hit_count,
+            stats.m_texture_cache_hit_count + stats.m_texture_cache_miss_count);
+    }
+    sstr << endl;
+
+    // Thread utilization is the fraction of wall clock time spent executing jobs.
+    const bool has_utilization =
+        has_rates &&
+        !stats.m_thread_busy_times.empty() &&
+        stats.m_thread_busy_times.size() == prev.m_thread_busy_times.size();
+
+    if (has_utilization)
+    {
+        sstr << "thread utilization" << endl;
+
+        for (size_t i = 0; i < stats.m_thread_busy_times.size(); ++i)
+        {
+            const double busy = stats.m_thread_busy_times[i] - prev.m_thread_busy_times[i];
+            const double utilization = busy >= 0.0 ? min(busy / elapsed, 1.0) : 0.0;
+
+            sstr << "  thread " << pad_left(to_string(i), ' ', 3) << "           "
+                 << pretty_scalar(100.0 * utilization) << " %" << endl;
+        }
+    }
+
+    setText(QString::fromStdString(sstr.str()));
+
+    m_previous_stats = stats;
+    m_has_previous_stats = true;
+}
+
+}   // namespace studio
+}   // namespace appleseed
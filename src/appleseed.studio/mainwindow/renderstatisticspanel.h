@@ -0,0 +1,76 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_STUDIO_MAINWINDOW_RENDERSTATISTICSPANEL_H
+#define APPLESEED_STUDIO_MAINWINDOW_RENDERSTATISTICSPANEL_H
+
+// appleseed.renderer headers.
+#include "renderer/api/rendering.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+
+// Qt headers.
+#include <QLabel>
+#include <QObject>
+
+// Forward declarations.
+namespace appleseed { namespace studio { class RenderingManager; } }
+class QTimerEvent;
+class QWidget;
+
+namespace appleseed {
+namespace studio {
+
+//
+// A panel that periodically polls the renderer while rendering and displays
+// throughput, texture cache efficiency and rendering threads utilization.
+//
+
+class RenderStatisticsPanel
+  : public QLabel
+{
+    Q_OBJECT
+
+  public:
+    explicit RenderStatisticsPanel(
+        const RenderingManager&         rendering_manager,
+        QWidget*                        parent = 0);
+
+  private:
+    const RenderingManager&             m_rendering_manager;
+    bool                                m_has_previous_stats;
+    renderer::LiveRenderStatistics      m_previous_stats;
+
+    virtual void timerEvent(QTimerEvent* event) APPLESEED_OVERRIDE;
+};
+
+}       // namespace studio
+}       // namespace appleseed
+
+#endif  // !APPLESEED_STUDIO_MAINWINDOW_RENDERSTATISTICSPANEL_H
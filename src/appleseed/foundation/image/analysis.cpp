@@ -183,4 +183,44 @@ double compute_rms_deviation(const Image& image1, const Image& image2)
     return sqrt(mse);
 }
 
+double compute_relative_rms_deviation(const Tile& tile, const Tile& ref_tile)
+{
+    const size_t channel_count = tile.get_channel_count();
+
+    if (tile.get_width() != ref_tile.get_width() ||
+        tile.get_height() != ref_tile.get_height() ||
+        ref_tile.get_channel_count() != channel_count)
+        throw ExceptionIncompatibleImages();
+
+    // Ignore the alpha channel of RGBA tiles.
+    const size_t color_channel_count = channel_count == 4 ? 3 : channel_count;
+
+    // Keep the error of dark pixels bounded.
+    const double Epsilon = 1.0e-2;
+
+    double mse = 0.0;   // mean square error
+    size_t relevant_component_count = 0;
+
+    for (size_t i = 0, e = tile.get_pixel_count(); i < e; ++i)
+    {
+        for (size_t c = 0; c < color_channel_count; ++c)
+        {
+            const double value = tile.get_component<double>(i, c);
+            const double ref_value = ref_tile.get_component<double>(i, c);
+            const double error = square(value - ref_value) / (square(ref_value) + Epsilon);
+
+            // Skip components containing NaN values.
+            if (error != error)
+                continue;
+
+            mse += error;
+            ++relevant_component_count;
+        }
+    }
+
+    return relevant_component_count > 0
+        ? sqrt(mse / relevant_component_count)
+        : 0.0;
+}
+
 }   // namespace foundation
@@ -38,6 +38,7 @@
 
 // Forward declarations.
 namespace foundation    { class Image; }
+namespace foundation    { class Tile; }
 
 namespace foundation
 {
@@ -68,6 +69,12 @@ struct ExceptionIncompatibleImages
 // Throws a foundation::ExceptionIncompatibleImages exception if the images are not compatible.
 APPLESEED_DLLSYMBOL double compute_rms_deviation(const Image& image1, const Image& image2);
 
+// Compute the relative Root-Mean-Square deviation of a tile with respect to a reference tile,
+// i.e. the RMS of the differences of the color channels divided by the reference values.
+// The alpha channel of RGBA tiles is ignored. Components containing NaN values are skipped.
+// Throws a foundation::ExceptionIncompatibleImages exception if the tiles are not compatible.
+APPLESEED_DLLSYMBOL double compute_relative_rms_deviation(const Tile& tile, const Tile& ref_tile);
+
 }       // namespace foundation
 
 #endif  // !APPLESEED_FOUNDATION_IMAGE_ANALYSIS_H
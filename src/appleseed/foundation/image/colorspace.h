@@ -243,6 +243,12 @@ Color<T, 3> ciexyz_to_linear_rgb(const Color<T, 3>& xyz);
 template <typename T>
 Color<T, 3> linear_rgb_to_ciexyz(const Color<T, 3>& linear_rgb);
 
+#ifdef APPLESEED_USE_SSE
+// Convert four colors from the linear RGB color space to the CIE XYZ color space.
+// Each vector holds one component of the four colors; conversion is done in place.
+inline void linear_rgb_to_ciexyz(__m128& r, __m128& g, __m128& b);
+#endif
+
 
 //
 // CIE XYZ <-> CIE xyY transformations.
@@ -611,6 +617,40 @@ inline Color<T, 3> linear_rgb_to_ciexyz(const Color<T, 3>& linear_rgb)
             T(0.0));
 }
 
+#ifdef APPLESEED_USE_SSE
+
+inline void linear_rgb_to_ciexyz(__m128& r, __m128& g, __m128& b)
+{
+    const __m128 zero = _mm_setzero_ps();
+
+    const __m128 x =
+        _mm_add_ps(
+            _mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(static_cast<float>(0.412453)), r),
+                _mm_mul_ps(_mm_set1_ps(static_cast<float>(0.357580)), g)),
+            _mm_mul_ps(_mm_set1_ps(static_cast<float>(0.180423)), b));
+
+    const __m128 y =
+        _mm_add_ps(
+            _mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(static_cast<float>(0.212671)), r),
+                _mm_mul_ps(_mm_set1_ps(static_cast<float>(0.715160)), g)),
+            _mm_mul_ps(_mm_set1_ps(static_cast<float>(0.072169)), b));
+
+    const __m128 z =
+        _mm_add_ps(
+            _mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(static_cast<float>(0.019334)), r),
+                _mm_mul_ps(_mm_set1_ps(static_cast<float>(0.119193)), g)),
+            _mm_mul_ps(_mm_set1_ps(static_cast<float>(0.950227)), b));
+
+    r = _mm_max_ps(x, zero);
+    g = _mm_max_ps(y, zero);
+    b = _mm_max_ps(z, zero);
+}
+
+#endif  // APPLESEED_USE_SSE
+
 
 //
 // CIE XYZ <-> CIE xyY transformations implementation.
@@ -840,7 +880,49 @@ Color<T, 3> spectrum_to_ciexyz(
     return Color<T, 3>(x, y, z);
 }
 
-#ifdef APPLESEED_USE_SSE
+#if defined APPLESEED_USE_AVX
+
+namespace impl
+{
+    // Return (a, a, a, a, b, b, b, b).
+    inline __m256 broadcast_pair(const float a, const float b)
+    {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(a)), _mm_set1_ps(b), 1);
+    }
+}
+
+template <>
+inline Color3f spectrum_to_ciexyz<float, RegularSpectrum31f>(
+    const LightingConditions&   lighting,
+    const RegularSpectrum31f&   spectrum)
+{
+    // Each accumulator weights the color matching functions of two consecutive wavelengths.
+    __m256 xyz1 = _mm256_setzero_ps();
+    __m256 xyz2 = _mm256_setzero_ps();
+    __m256 xyz3 = _mm256_setzero_ps();
+    __m256 xyz4 = _mm256_setzero_ps();
+
+    for (size_t w = 0; w < 32; w += 8)
+    {
+        xyz1 = _mm256_add_ps(xyz1, _mm256_mul_ps(impl::broadcast_pair(spectrum[w + 0], spectrum[w + 1]), _mm256_loadu_ps(&lighting.m_cmf[w + 0][0])));
+        xyz2 = _mm256_add_ps(xyz2, _mm256_mul_ps(impl::broadcast_pair(spectrum[w + 2], spectrum[w + 3]), _mm256_loadu_ps(&lighting.m_cmf[w + 2][0])));
+        xyz3 = _mm256_add_ps(xyz3, _mm256_mul_ps(impl::broadcast_pair(spectrum[w + 4], spectrum[w + 5]), _mm256_loadu_ps(&lighting.m_cmf[w + 4][0])));
+        xyz4 = _mm256_add_ps(xyz4, _mm256_mul_ps(impl::broadcast_pair(spectrum[w + 6], spectrum[w + 7]), _mm256_loadu_ps(&lighting.m_cmf[w + 6][0])));
+    }
+
+    xyz1 = _mm256_add_ps(xyz1, xyz2);
+    xyz3 = _mm256_add_ps(xyz3, xyz4);
+    xyz1 = _mm256_add_ps(xyz1, xyz3);
+
+    const __m128 xyz = _mm_add_ps(_mm256_castps256_ps128(xyz1), _mm256_extractf128_ps(xyz1, 1));
+
+    APPLESEED_SIMD4_ALIGN float transfer[4];
+    _mm_store_ps(transfer, xyz);
+
+    return Color3f(transfer[0], transfer[1], transfer[2]);
+}
+
+#elif defined APPLESEED_USE_SSE
 
 template <>
 inline Color3f spectrum_to_ciexyz<float, RegularSpectrum31f>(
@@ -870,7 +952,7 @@ inline Color3f spectrum_to_ciexyz<float, RegularSpectrum31f>(
     return Color3f(transfer[0], transfer[1], transfer[2]);
 }
 
-#endif  // APPLESEED_USE_SSE
+#endif
 
 template <typename T, typename SpectrumType>
 void ciexyz_reflectance_to_spectrum(
@@ -0,0 +1,284 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Interface header.
+#include "compressedtile.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/tile.h"
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <algorithm>
+
+using namespace std;
+
+namespace foundation
+{
+
+//
+// CompressedTile class implementation.
+//
+
+namespace
+{
+    uint8 quantize(const float value)
+    {
+        return static_cast<uint8>(saturate(value) * 255.0f + 0.5f);
+    }
+
+    uint32 pack_rgb565(const int color[3])
+    {
+        return
+            static_cast<uint32>(((color[0] * 31 + 127) / 255) << 11) |
+            static_cast<uint32>(((color[1] * 63 + 127) / 255) << 5) |
+            static_cast<uint32>((color[2] * 31 + 127) / 255);
+    }
+
+    void unpack_rgb565(const uint32 packed, int color[3])
+    {
+        const int r = (packed >> 11) & 31;
+        const int g = (packed >> 5) & 63;
+        const int b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // Encode 16 RGB pixels into an 8-byte BC1 block using given endpoints.
+    // Return the squared error of the encoding.
+    int encode_color_block(
+        const uint8         pixels[16][4],
+        const int           hi[3],
+        const int           lo[3],
+        uint8               block[8])
+    {
+        uint32 c0 = pack_rgb565(hi);
+        uint32 c1 = pack_rgb565(lo);
+
+        // The four-color mode requires the first endpoint to be the greater one.
+        if (c0 < c1)
+            swap(c0, c1);
+
+        block[0] = static_cast<uint8>(c0 & 0xFF);
+        block[1] = static_cast<uint8>(c0 >> 8);
+        block[2] = static_cast<uint8>(c1 & 0xFF);
+        block[3] = static_cast<uint8>(c1 >> 8);
+        block[4] = block[5] = block[6] = block[7] = 0;
+
+        int palette[4][3];
+        unpack_rgb565(c0, palette[0]);
+        unpack_rgb565(c1, palette[1]);
+
+        for (size_t c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        // With a single color, all pixels use the first endpoint.
+        const size_t palette_size = c0 == c1 ? 1 : 4;
+
+        int error = 0;
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            size_t best_index = 0;
+            int best_distance = 3 * 255 * 255 + 1;
+
+            for (size_t j = 0; j < palette_size; ++j)
+            {
+                int distance = 0;
+
+                for (size_t c = 0; c < 3; ++c)
+                {
+                    const int d = pixels[i][c] - palette[j][c];
+                    distance += d * d;
+                }
+
+                if (best_distance > distance)
+                {
+                    best_distance = distance;
+                    best_index = j;
+                }
+            }
+
+            block[4 + (i >> 2)] |= static_cast<uint8>(best_index << ((i & 3) * 2));
+            error += best_distance;
+        }
+
+        return error;
+    }
+
+    // Encode 16 RGB pixels into an 8-byte BC1 block.
+    void encode_color_block(const uint8 pixels[16][4], uint8 block[8])
+    {
+        // Use the bounding box of the colors, slightly inset, to find the endpoints.
+        int lo[3] = { 255, 255, 255 };
+        int hi[3] = { 0, 0, 0 };
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            for (size_t c = 0; c < 3; ++c)
+            {
+                lo[c] = min<int>(lo[c], pixels[i][c]);
+                hi[c] = max<int>(hi[c], pixels[i][c]);
+            }
+        }
+
+        for (size_t c = 0; c < 3; ++c)
+        {
+            const int inset = (hi[c] - lo[c]) / 16;
+            lo[c] += inset;
+            hi[c] -= inset;
+        }
+
+        // Try the four diagonals of the bounding box and keep the best one.
+        int best_error = -1;
+
+        for (size_t d = 0; d < 4; ++d)
+        {
+            int e0[3] = { hi[0], hi[1], hi[2] };
+            int e1[3] = { lo[0], lo[1], lo[2] };
+
+            if (d & 1) swap(e0[1], e1[1]);
+            if (d & 2) swap(e0[2], e1[2]);
+
+            uint8 candidate[8];
+            const int error = encode_color_block(pixels, e0, e1, candidate);
+
+            if (best_error < 0 || best_error > error)
+            {
+                best_error = error;
+                copy(candidate, candidate + 8, block);
+            }
+        }
+    }
+
+    // Encode 16 alpha values into an 8-byte BC4 block.
+    void encode_alpha_block(const uint8 pixels[16][4], uint8 block[8])
+    {
+        int lo = 255;
+        int hi = 0;
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            lo = min<int>(lo, pixels[i][3]);
+            hi = max<int>(hi, pixels[i][3]);
+        }
+
+        // The eight-value mode requires the first endpoint to be the greater one.
+        block[0] = static_cast<uint8>(hi);
+        block[1] = static_cast<uint8>(lo);
+
+        uint64 bits = 0;
+
+        if (hi > lo)
+        {
+            for (size_t i = 0; i < 16; ++i)
+            {
+                // Index 0 is 'hi', index 1 is 'lo', indices 2 to 7 are evenly spaced in between.
+                const int step = ((hi - pixels[i][3]) * 7 + (hi - lo) / 2) / (hi - lo);
+                const uint64 index = step == 0 ? 0 : step == 7 ? 1 : static_cast<uint64>(step + 1);
+                bits |= index << (i * 3);
+            }
+        }
+
+        for (size_t i = 0; i < 6; ++i)
+            block[2 + i] = static_cast<uint8>((bits >> (i * 8)) & 0xFF);
+    }
+}
+
+CompressedTile::CompressedTile(const Tile& tile)
+  : m_width(tile.get_width())
+  , m_height(tile.get_height())
+  , m_channel_count(tile.get_channel_count())
+  , m_block_count_x((tile.get_width() + 3) / 4)
+  , m_block_size(tile.get_channel_count() == 4 ? 16 : 8)
+{
+    assert(m_channel_count == 3 || m_channel_count == 4);
+
+    const size_t block_count_y = (m_height + 3) / 4;
+    m_blocks = new uint8[m_block_count_x * block_count_y * m_block_size];
+
+    for (size_t by = 0; by < block_count_y; ++by)
+    {
+        for (size_t bx = 0; bx < m_block_count_x; ++bx)
+        {
+            // Gather the pixels of the block, replicating the last row and column if needed.
+            uint8 pixels[16][4];
+
+            for (size_t y = 0; y < 4; ++y)
+            {
+                for (size_t x = 0; x < 4; ++x)
+                {
+                    const size_t px = min(bx * 4 + x, m_width - 1);
+                    const size_t py = min(by * 4 + y, m_height - 1);
+
+                    Color4f color(1.0f);
+
+                    if (m_channel_count == 3)
+                    {
+                        Color3f rgb;
+                        tile.get_pixel(px, py, rgb);
+                        color = Color4f(rgb, 1.0f);
+                    }
+                    else tile.get_pixel(px, py, color);
+
+                    for (size_t c = 0; c < 4; ++c)
+                        pixels[y * 4 + x][c] = quantize(color[c]);
+                }
+            }
+
+            uint8* block = m_blocks + (by * m_block_count_x + bx) * m_block_size;
+
+            if (m_channel_count == 4)
+            {
+                encode_alpha_block(pixels, block);
+                block += 8;
+            }
+
+            encode_color_block(pixels, block);
+        }
+    }
+}
+
+CompressedTile::~CompressedTile()
+{
+    delete [] m_blocks;
+}
+
+size_t CompressedTile::get_memory_size() const
+{
+    const size_t block_count_y = (m_height + 3) / 4;
+    return sizeof(*this) + m_block_count_x * block_count_y * m_block_size;
+}
+
+}   // namespace foundation
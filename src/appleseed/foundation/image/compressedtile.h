@@ -0,0 +1,252 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef APPLESEED_FOUNDATION_IMAGE_COMPRESSEDTILE_H
+#define APPLESEED_FOUNDATION_IMAGE_COMPRESSEDTILE_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/color.h"
+#include "foundation/platform/types.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class Tile; }
+
+namespace foundation
+{
+
+//
+// A tile compressed by blocks of 4x4 pixels, decoded one pixel at a time.
+//
+// RGB tiles are stored in the BC1 format (8 bytes per block) and RGBA tiles in the
+// BC3 format (16 bytes per block). Pixel values are clamped to [0, 1] and quantized:
+// compression is lossy and is meant for low dynamic range color textures.
+//
+
+class APPLESEED_DLLSYMBOL CompressedTile
+  : public NonCopyable
+{
+  public:
+    // Compress a tile with 3 or 4 channels.
+    explicit CompressedTile(const Tile& tile);
+
+    // Destructor.
+    ~CompressedTile();
+
+    // Return the size (in bytes) of this object in memory.
+    size_t get_memory_size() const;
+
+    // Tile properties.
+    size_t get_width() const;
+    size_t get_height() const;
+    size_t get_channel_count() const;
+
+    // Decode a given pixel. The alpha channel of RGB tiles is 1.
+    void get_pixel(
+        const size_t        x,
+        const size_t        y,
+        Color3f&            color) const;
+    void get_pixel(
+        const size_t        x,
+        const size_t        y,
+        Color4f&            color) const;
+
+  private:
+    const size_t            m_width;
+    const size_t            m_height;
+    const size_t            m_channel_count;
+    const size_t            m_block_count_x;
+    const size_t            m_block_size;
+    uint8*                  m_blocks;
+
+    const uint8* get_block(
+        const size_t        x,
+        const size_t        y) const;
+
+    static void decode_color(
+        const uint8*        block,
+        const size_t        i,
+        Color3f&            color);
+
+    static float decode_alpha(
+        const uint8*        block,
+        const size_t        i);
+};
+
+
+//
+// CompressedTile class implementation.
+//
+
+inline size_t CompressedTile::get_width() const
+{
+    return m_width;
+}
+
+inline size_t CompressedTile::get_height() const
+{
+    return m_height;
+}
+
+inline size_t CompressedTile::get_channel_count() const
+{
+    return m_channel_count;
+}
+
+inline void CompressedTile::get_pixel(
+    const size_t            x,
+    const size_t            y,
+    Color3f&                color) const
+{
+    const uint8* block = get_block(x, y);
+    const size_t i = ((y & 3) << 2) | (x & 3);
+
+    // The color block follows the alpha block in RGBA tiles.
+    if (m_channel_count == 4)
+        block += 8;
+
+    decode_color(block, i, color);
+}
+
+inline void CompressedTile::get_pixel(
+    const size_t            x,
+    const size_t            y,
+    Color4f&                color) const
+{
+    const uint8* block = get_block(x, y);
+    const size_t i = ((y & 3) << 2) | (x & 3);
+
+    if (m_channel_count == 4)
+    {
+        color[3] = decode_alpha(block, i);
+        block += 8;
+    }
+    else color[3] = 1.0f;
+
+    Color3f rgb;
+    decode_color(block, i, rgb);
+    color[0] = rgb[0];
+    color[1] = rgb[1];
+    color[2] = rgb[2];
+}
+
+inline const uint8* CompressedTile::get_block(
+    const size_t            x,
+    const size_t            y) const
+{
+    assert(x < m_width);
+    assert(y < m_height);
+
+    return m_blocks + ((y >> 2) * m_block_count_x + (x >> 2)) * m_block_size;
+}
+
+inline void CompressedTile::decode_color(
+    const uint8*            block,
+    const size_t            i,
+    Color3f&                color)
+{
+    const uint32 c0 = block[0] | (block[1] << 8);
+    const uint32 c1 = block[2] | (block[3] << 8);
+    const uint32 index = (block[4 + (i >> 2)] >> ((i & 3) * 2)) & 3;
+
+    // Expand the endpoints from RGB565.
+    const float e0[3] =
+    {
+        static_cast<float>((c0 >> 11) & 31) * (1.0f / 31.0f),
+        static_cast<float>((c0 >> 5) & 63) * (1.0f / 63.0f),
+        static_cast<float>(c0 & 31) * (1.0f / 31.0f)
+    };
+    const float e1[3] =
+    {
+        static_cast<float>((c1 >> 11) & 31) * (1.0f / 31.0f),
+        static_cast<float>((c1 >> 5) & 63) * (1.0f / 63.0f),
+        static_cast<float>(c1 & 31) * (1.0f / 31.0f)
+    };
+
+    // Blending weight of the second endpoint.
+    float w;
+    if (c0 > c1)
+    {
+        static const float Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+        w = Weights[index];
+    }
+    else
+    {
+        if (index == 3)
+        {
+            color[0] = color[1] = color[2] = 0.0f;
+            return;
+        }
+
+        static const float Weights[3] = { 0.0f, 1.0f, 0.5f };
+        w = Weights[index];
+    }
+
+    for (size_t c = 0; c < 3; ++c)
+        color[c] = e0[c] + w * (e1[c] - e0[c]);
+}
+
+inline float CompressedTile::decode_alpha(
+    const uint8*            block,
+    const size_t            i)
+{
+    const float a0 = static_cast<float>(block[0]) * (1.0f / 255.0f);
+    const float a1 = static_cast<float>(block[1]) * (1.0f / 255.0f);
+
+    // Extract the 3-bit index of the pixel from the 48-bit index field.
+    const size_t bit = i * 3;
+    const uint32 bits = block[2 + (bit >> 3)] | (bit < 40 ? block[3 + (bit >> 3)] << 8 : 0);
+    const uint32 index = (bits >> (bit & 7)) & 7;
+
+    if (index == 0)
+        return a0;
+
+    if (index == 1)
+        return a1;
+
+    if (block[0] > block[1])
+        return a0 + static_cast<float>(index - 1) * (1.0f / 7.0f) * (a1 - a0);
+
+    if (index >= 6)
+        return index == 6 ? 0.0f : 1.0f;
+
+    return a0 + static_cast<float>(index - 1) * (1.0f / 5.0f) * (a1 - a0);
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_IMAGE_COMPRESSEDTILE_H
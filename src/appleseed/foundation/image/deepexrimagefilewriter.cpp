@@ -0,0 +1,236 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Interface header.
+#include "deepexrimagefilewriter.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/deeptile.h"
+#include "foundation/image/exrutils.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
+
+// OpenEXR headers.
+#include "foundation/platform/exrheaderguards.h"
+BEGIN_EXR_INCLUDES
+#include "OpenEXR/IexBaseExc.h"
+#include "OpenEXR/ImfChannelList.h"
+#include "OpenEXR/ImfCompression.h"
+#include "OpenEXR/ImfDeepFrameBuffer.h"
+#include "OpenEXR/ImfDeepTiledOutputFile.h"
+#include "OpenEXR/ImfFrameBuffer.h"
+#include "OpenEXR/ImfHeader.h"
+#include "OpenEXR/ImfLineOrder.h"
+#include "OpenEXR/ImfPartType.h"
+#include "OpenEXR/ImfPixelType.h"
+#include "OpenEXR/ImfTileDescription.h"
+END_EXR_INCLUDES
+
+// Standard headers.
+#include <cassert>
+#include <memory>
+#include <vector>
+
+using namespace Iex;
+using namespace Imf;
+using namespace std;
+
+namespace foundation
+{
+
+//
+// DeepEXRImageFileWriter class implementation.
+//
+
+namespace
+{
+    const char* ChannelNames[DeepTile::ResolvedSampleSize] = { "R", "G", "B", "A", "Z" };
+}
+
+struct DeepEXRImageFileWriter::Impl
+{
+    boost::mutex                    m_mutex;
+    auto_ptr<DeepTiledOutputFile>   m_file;
+    size_t                          m_tile_width;
+    size_t                          m_tile_height;
+};
+
+DeepEXRImageFileWriter::DeepEXRImageFileWriter()
+  : impl(new Impl())
+{
+}
+
+DeepEXRImageFileWriter::~DeepEXRImageFileWriter()
+{
+    close();
+    delete impl;
+}
+
+void DeepEXRImageFileWriter::open(
+    const char*                     filename,
+    const CanvasProperties&         props,
+    const ImageAttributes&          image_attributes)
+{
+    assert(filename);
+    assert(!is_open());
+
+    initialize_openexr();
+
+    try
+    {
+        // Construct ChannelList object.
+        ChannelList channels;
+        for (size_t c = 0; c < DeepTile::ResolvedSampleSize; ++c)
+            channels.insert(ChannelNames[c], Channel(FLOAT));
+
+        // Construct Header object.
+        Header header(
+            static_cast<int>(props.m_canvas_width),
+            static_cast<int>(props.m_canvas_height));
+        header.setType(DEEPTILE);
+        header.setTileDescription(
+            TileDescription(
+                static_cast<unsigned int>(props.m_tile_width),
+                static_cast<unsigned int>(props.m_tile_height),
+                ONE_LEVEL));
+        header.channels() = channels;
+        header.lineOrder() = RANDOM_Y;
+        header.compression() = ZIPS_COMPRESSION;
+
+        // Add image attributes to the Header object.
+        add_attributes(image_attributes, header);
+
+        impl->m_file.reset(new DeepTiledOutputFile(filename, header));
+    }
+    catch (const BaseExc& e)
+    {
+        // I/O error.
+        throw ExceptionIOError(e.what());
+    }
+
+    impl->m_tile_width = props.m_tile_width;
+    impl->m_tile_height = props.m_tile_height;
+}
+
+bool DeepEXRImageFileWriter::is_open() const
+{
+    return impl->m_file.get() != 0;
+}
+
+void DeepEXRImageFileWriter::close()
+{
+    try
+    {
+        // Destroying the file object writes the tile offset table.
+        impl->m_file.reset();
+    }
+    catch (const BaseExc& e)
+    {
+        // I/O error.
+        throw ExceptionIOError(e.what());
+    }
+}
+
+void DeepEXRImageFileWriter::write_tile(
+    const size_t                    tile_x,
+    const size_t                    tile_y,
+    const DeepTile&                 tile)
+{
+    assert(is_open());
+
+    const size_t width = tile.get_width();
+    const size_t height = tile.get_height();
+    const size_t pixel_count = width * height;
+    const size_t max_sample_count = tile.get_max_fragment_count();
+    const size_t pixel_stride = max_sample_count * DeepTile::ResolvedSampleSize;
+
+    // Resolve the fragments of all pixels.
+    vector<uint32> sample_counts(pixel_count);
+    vector<float> samples(pixel_count * pixel_stride);
+    for (size_t y = 0; y < height; ++y)
+    {
+        for (size_t x = 0; x < width; ++x)
+        {
+            const size_t i = y * width + x;
+            sample_counts[i] =
+                static_cast<uint32>(tile.resolve_pixel(x, y, &samples[i * pixel_stride]));
+        }
+    }
+
+    // Each channel is addressed through one pointer per pixel to its first sample.
+    vector<char*> sample_pointers(pixel_count * DeepTile::ResolvedSampleSize);
+    for (size_t c = 0; c < DeepTile::ResolvedSampleSize; ++c)
+    {
+        for (size_t i = 0; i < pixel_count; ++i)
+        {
+            sample_pointers[c * pixel_count + i] =
+                reinterpret_cast<char*>(&samples[i * pixel_stride + c]);
+        }
+    }
+
+    // The slices are addressed with absolute pixel coordinates.
+    const size_t origin = tile_y * impl->m_tile_height * width + tile_x * impl->m_tile_width;
+
+    // Construct DeepFrameBuffer object.
+    DeepFrameBuffer framebuffer;
+    framebuffer.insertSampleCountSlice(
+        Slice(
+            UINT,
+            reinterpret_cast<char*>(&sample_counts[0] - origin),
+            sizeof(uint32),
+            width * sizeof(uint32)));
+    for (size_t c = 0; c < DeepTile::ResolvedSampleSize; ++c)
+    {
+        framebuffer.insert(
+            ChannelNames[c],
+            DeepSlice(
+                FLOAT,
+                reinterpret_cast<char*>(&sample_pointers[c * pixel_count] - origin),
+                sizeof(char*),
+                width * sizeof(char*),
+                DeepTile::ResolvedSampleSize * sizeof(float)));
+    }
+
+    try
+    {
+        boost::mutex::scoped_lock lock(impl->m_mutex);
+        impl->m_file->setFrameBuffer(framebuffer);
+        impl->m_file->writeTile(static_cast<int>(tile_x), static_cast<int>(tile_y));
+    }
+    catch (const BaseExc& e)
+    {
+        // I/O error.
+        throw ExceptionIOError(e.what());
+    }
+}
+
+}   // namespace foundation
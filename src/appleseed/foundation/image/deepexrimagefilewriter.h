@@ -0,0 +1,94 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef APPLESEED_FOUNDATION_IMAGE_DEEPEXRIMAGEFILEWRITER_H
+#define APPLESEED_FOUNDATION_IMAGE_DEEPEXRIMAGEFILEWRITER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/imageattributes.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class CanvasProperties; }
+namespace foundation    { class DeepTile; }
+
+namespace foundation
+{
+
+//
+// A deep OpenEXR image file writer that writes deep tiles one at a time, in any order.
+//
+// Each pixel holds the deep samples obtained with DeepTile::resolve_pixel(), stored
+// in the R, G, B, A and Z channels. Tiles are stored in random line order and
+// writing tiles is thread-safe.
+//
+
+class APPLESEED_DLLSYMBOL DeepEXRImageFileWriter
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    DeepEXRImageFileWriter();
+
+    // Destructor, closes the file.
+    ~DeepEXRImageFileWriter();
+
+    // Create a deep OpenEXR image file with the dimensions and the tile size of a given canvas.
+    void open(
+        const char*                     filename,
+        const CanvasProperties&         props,
+        const ImageAttributes&          image_attributes = ImageAttributes());
+
+    // Return true if a file is open.
+    bool is_open() const;
+
+    // Close the file. Tiles that were not written are left empty.
+    void close();
+
+    // Write a deep tile. Each tile must be written at most once.
+    void write_tile(
+        const size_t                    tile_x,
+        const size_t                    tile_y,
+        const DeepTile&                 tile);
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_IMAGE_DEEPEXRIMAGEFILEWRITER_H
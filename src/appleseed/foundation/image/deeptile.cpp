@@ -0,0 +1,187 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Interface header.
+#include "deeptile.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace foundation
+{
+
+//
+// DeepTile class implementation.
+//
+
+DeepTile::DeepTile(
+    const size_t            width,
+    const size_t            height,
+    const size_t            max_fragment_count,
+    const float             depth_tolerance)
+  : m_width(width)
+  , m_height(height)
+  , m_max_fragment_count(max_fragment_count)
+  , m_depth_tolerance(depth_tolerance)
+  , m_fragments(width * height * max_fragment_count)
+  , m_fragment_counts(width * height, 0)
+  , m_sample_weights(width * height, 0.0f)
+{
+    assert(width > 0);
+    assert(height > 0);
+    assert(max_fragment_count > 0);
+    assert(depth_tolerance >= 0.0f);
+}
+
+size_t DeepTile::get_memory_size() const
+{
+    return
+          sizeof(*this)
+        + m_fragments.capacity() * sizeof(Fragment)
+        + m_fragment_counts.capacity() * sizeof(uint32)
+        + m_sample_weights.capacity() * sizeof(float);
+}
+
+void DeepTile::clear()
+{
+    fill(m_fragment_counts.begin(), m_fragment_counts.end(), 0);
+    fill(m_sample_weights.begin(), m_sample_weights.end(), 0.0f);
+}
+
+void DeepTile::add(
+    const size_t            x,
+    const size_t            y,
+    const float             depth,
+    const float             color[4])
+{
+    assert(x < m_width);
+    assert(y < m_height);
+
+    const size_t pixel_index = y * m_width + x;
+
+    m_sample_weights[pixel_index] += 1.0f;
+
+    if (color[3] <= 0.0f)
+        return;
+
+    Fragment* fragments = &m_fragments[pixel_index * m_max_fragment_count];
+    uint32& fragment_count = m_fragment_counts[pixel_index];
+
+    // Find the fragment closest in depth to the sample.
+    size_t closest = ~size_t(0);
+    float closest_distance = numeric_limits<float>::max();
+    for (size_t i = 0; i < fragment_count; ++i)
+    {
+        const float distance = abs(fragments[i].m_depth - depth);
+        if (distance < closest_distance)
+        {
+            closest = i;
+            closest_distance = distance;
+        }
+    }
+
+    // Create a new fragment if the sample is too far from existing ones and the pixel is not full.
+    if (fragment_count < m_max_fragment_count &&
+        (closest == ~size_t(0) ||
+         closest_distance > m_depth_tolerance * max(depth, fragments[closest].m_depth)))
+    {
+        // Keep the fragments sorted by increasing depth.
+        size_t i = fragment_count++;
+        for (; i > 0 && fragments[i - 1].m_depth > depth; --i)
+            fragments[i] = fragments[i - 1];
+
+        Fragment& fragment = fragments[i];
+        fragment.m_depth = depth;
+        fragment.m_color[0] = color[0];
+        fragment.m_color[1] = color[1];
+        fragment.m_color[2] = color[2];
+        fragment.m_color[3] = color[3];
+        fragment.m_weight = 1.0f;
+
+        return;
+    }
+
+    // Merge the sample into the closest fragment. The sample lies closer to this fragment
+    // than to its neighbors, so keeping the front-most depth preserves the ordering.
+    Fragment& fragment = fragments[closest];
+    fragment.m_depth = min(fragment.m_depth, depth);
+    fragment.m_color[0] += color[0];
+    fragment.m_color[1] += color[1];
+    fragment.m_color[2] += color[2];
+    fragment.m_color[3] += color[3];
+    fragment.m_weight += 1.0f;
+}
+
+size_t DeepTile::resolve_pixel(
+    const size_t            x,
+    const size_t            y,
+    float                   samples[]) const
+{
+    const size_t fragment_count = get_fragment_count(x, y);
+
+    if (fragment_count == 0)
+        return 0;
+
+    const float rcp_sample_weight = 1.0f / get_sample_weight(x, y);
+
+    // Each fragment covers a fraction of the pixel, but the over operator attenuates it
+    // by the opacity of the fragments in front of it: divide by the remaining transmittance.
+    float accumulated_alpha = 0.0f;
+    size_t sample_count = 0;
+
+    for (size_t i = 0; i < fragment_count; ++i)
+    {
+        const float transmittance = 1.0f - accumulated_alpha;
+
+        if (transmittance <= 1.0e-6f)
+            break;
+
+        const Fragment& fragment = get_fragment(x, y, i);
+        const float alpha = fragment.m_color[3] * rcp_sample_weight;
+        const float scaling = min(rcp_sample_weight / transmittance, 1.0f / fragment.m_color[3]);
+
+        *samples++ = fragment.m_color[0] * scaling;
+        *samples++ = fragment.m_color[1] * scaling;
+        *samples++ = fragment.m_color[2] * scaling;
+        *samples++ = fragment.m_color[3] * scaling;
+        *samples++ = fragment.m_depth;
+
+        accumulated_alpha += alpha;
+        ++sample_count;
+    }
+
+    return sample_count;
+}
+
+}   // namespace foundation
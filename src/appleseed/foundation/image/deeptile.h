@@ -0,0 +1,183 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef APPLESEED_FOUNDATION_IMAGE_DEEPTILE_H
+#define APPLESEED_FOUNDATION_IMAGE_DEEPTILE_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// A tile holding a depth-sorted list of fragments per pixel, suitable for deep output.
+//
+// Samples whose depths are within a relative tolerance of each other are merged into
+// a single fragment as they are added. The number of fragments per pixel is bounded:
+// once a pixel is full, new samples are merged into the fragment closest in depth,
+// so that the memory used by a tile never grows during rendering.
+//
+
+class APPLESEED_DLLSYMBOL DeepTile
+  : public NonCopyable
+{
+  public:
+    struct Fragment
+    {
+        float               m_depth;            // depth of the front-most merged sample
+        float               m_color[4];         // sum of the premultiplied RGBA values of the merged samples
+        float               m_weight;           // number of merged samples
+    };
+
+    // Number of values per resolved sample: R, G, B, A and Z.
+    enum { ResolvedSampleSize = 5 };
+
+    // Constructor. The tile is initially empty.
+    DeepTile(
+        const size_t        width,              // tile width, in pixels
+        const size_t        height,             // tile height, in pixels
+        const size_t        max_fragment_count, // maximum number of fragments per pixel
+        const float         depth_tolerance);   // relative depth below which samples are merged
+
+    // Return the size (in bytes) of this object in memory.
+    size_t get_memory_size() const;
+
+    // Tile properties.
+    size_t get_width() const;
+    size_t get_height() const;
+    size_t get_max_fragment_count() const;
+
+    // Remove all fragments.
+    void clear();
+
+    // Add a sample with a given premultiplied RGBA color to a given pixel.
+    // Fully transparent samples only contribute to the coverage of the pixel.
+    void add(
+        const size_t        x,
+        const size_t        y,
+        const float         depth,
+        const float         color[4]);
+
+    // Return the number of samples added to a given pixel.
+    float get_sample_weight(
+        const size_t        x,
+        const size_t        y) const;
+
+    // Access the fragments of a given pixel, sorted by increasing depth.
+    size_t get_fragment_count(
+        const size_t        x,
+        const size_t        y) const;
+    const Fragment& get_fragment(
+        const size_t        x,
+        const size_t        y,
+        const size_t        i) const;
+
+    // Convert the fragments of a given pixel to deep samples that, composited front to
+    // back with the over operator, reproduce the average of the samples of the pixel.
+    // 'samples' must have room for get_fragment_count(x, y) * ResolvedSampleSize values.
+    // Return the number of deep samples; fragments hidden behind opaque ones are dropped.
+    size_t resolve_pixel(
+        const size_t        x,
+        const size_t        y,
+        float               samples[]) const;
+
+  private:
+    const size_t            m_width;
+    const size_t            m_height;
+    const size_t            m_max_fragment_count;
+    const float             m_depth_tolerance;
+    std::vector<Fragment>   m_fragments;
+    std::vector<uint32>     m_fragment_counts;
+    std::vector<float>      m_sample_weights;
+};
+
+
+//
+// DeepTile class implementation.
+//
+
+inline size_t DeepTile::get_width() const
+{
+    return m_width;
+}
+
+inline size_t DeepTile::get_height() const
+{
+    return m_height;
+}
+
+inline size_t DeepTile::get_max_fragment_count() const
+{
+    return m_max_fragment_count;
+}
+
+inline float DeepTile::get_sample_weight(
+    const size_t            x,
+    const size_t            y) const
+{
+    assert(x < m_width);
+    assert(y < m_height);
+
+    return m_sample_weights[y * m_width + x];
+}
+
+inline size_t DeepTile::get_fragment_count(
+    const size_t            x,
+    const size_t            y) const
+{
+    assert(x < m_width);
+    assert(y < m_height);
+
+    return m_fragment_counts[y * m_width + x];
+}
+
+inline const DeepTile::Fragment& DeepTile::get_fragment(
+    const size_t            x,
+    const size_t            y,
+    const size_t            i) const
+{
+    assert(i < get_fragment_count(x, y));
+
+    return m_fragments[(y * m_width + x) * m_max_fragment_count + i];
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_IMAGE_DEEPTILE_H
@@ -33,29 +33,24 @@
 // appleseed.foundation headers.
 #include "foundation/core/exceptions/exceptionioerror.h"
 #include "foundation/image/canvasproperties.h"
-#include "foundation/image/exceptionunsupportedimageformat.h"
 #include "foundation/image/exrutils.h"
 #include "foundation/image/icanvas.h"
-#include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
 
 // OpenEXR headers.
 #include "foundation/platform/exrheaderguards.h"
 BEGIN_EXR_INCLUDES
 #include "OpenEXR/IexBaseExc.h"
-#include "OpenEXR/ImathBox.h"
-#include "OpenEXR/ImathVec.h"
-#include "OpenEXR/ImfChannelList.h"
 #include "OpenEXR/ImfFrameBuffer.h"
 #include "OpenEXR/ImfHeader.h"
-#include "OpenEXR/ImfPixelType.h"
-#include "OpenEXR/ImfTileDescription.h"
 #include "OpenEXR/ImfTiledOutputFile.h"
 END_EXR_INCLUDES
 
 // Standard headers.
 #include <cassert>
 #include <cstddef>
+#include <cstring>
+#include <vector>
 
 using namespace Iex;
 using namespace Imath;
@@ -71,7 +66,28 @@ namespace foundation
 
 namespace
 {
-    const char* ChannelName[] = { "R", "G", "B", "A" };
+    // Copy one row of tiles of a canvas into a contiguous band of scanlines.
+    void copy_tile_row(
+        const ICanvas&          image,
+        const size_t            tile_y,
+        vector<char>&           band)
+    {
+        const CanvasProperties& props = image.properties();
+        const size_t band_stride = props.m_canvas_width * props.m_pixel_size;
+
+        for (size_t tile_x = 0; tile_x < props.m_tile_count_x; ++tile_x)
+        {
+            const Tile& tile = image.tile(tile_x, tile_y);
+            const size_t row_size = tile.get_width() * props.m_pixel_size;
+            char* dest = &band[tile_x * props.m_tile_width * props.m_pixel_size];
+
+            for (size_t y = 0; y < tile.get_height(); ++y)
+            {
+                memcpy(dest, tile.pixel(0, y), row_size);
+                dest += band_stride;
+            }
+        }
+    }
 }
 
 void EXRImageFileWriter::write(
@@ -79,83 +95,76 @@ void EXRImageFileWriter::write(
     const ICanvas&          image,
     const ImageAttributes&  image_attributes)
 {
-    initialize_openexr();
-
-    try
-    {
-        // Retrieve canvas properties.
-        const CanvasProperties& props = image.properties();
-
-        // todo: lift this limitation.
-        assert(props.m_channel_count <= 4);
+    const char* layer_name = "";
+    const ICanvas* canvas = &image;
 
-        // Figure out the pixel type, based on the pixel format of the image.
-        PixelType pixel_type = FLOAT;
-        switch (props.m_pixel_format)
-        {
-          case PixelFormatUInt32: pixel_type = UINT; break;
-          case PixelFormatHalf: pixel_type = HALF; break;
-          case PixelFormatFloat: pixel_type = FLOAT; break;
-          default: throw ExceptionUnsupportedImageFormat();
-        }
+    write_layers(filename, 1, &layer_name, &canvas, image_attributes);
+}
 
-        // Construct TileDescription object.
-        const TileDescription tile_desc(
-            static_cast<unsigned int>(props.m_tile_width),
-            static_cast<unsigned int>(props.m_tile_height),
-            ONE_LEVEL);
+void EXRImageFileWriter::write_layers(
+    const char*             filename,
+    const size_t            layer_count,
+    const char* const       layer_names[],
+    const ICanvas* const    images[],
+    const ImageAttributes&  image_attributes)
+{
+    assert(layer_count > 0);
 
-        // Construct ChannelList object.
-        ChannelList channels;
-        for (size_t c = 0; c < props.m_channel_count; ++c)
-            channels.insert(ChannelName[c], Channel(pixel_type));
+    initialize_openexr();
 
-        // Construct Header object.
-        Header header(
-            static_cast<int>(props.m_canvas_width),
-            static_cast<int>(props.m_canvas_height));
-        header.setTileDescription(tile_desc);
-        header.channels() = channels;
+    try
+    {
+        vector<const CanvasProperties*> layer_props(layer_count);
+        for (size_t i = 0; i < layer_count; ++i)
+            layer_props[i] = &images[i]->properties();
 
-        // Add image attributes to the Header object.
-        add_attributes(image_attributes, header);
+        const CanvasProperties& props = *layer_props[0];
 
         // Create the output file.
+        const Header header =
+            create_tiled_header(
+                layer_count,
+                layer_names,
+                &layer_props[0],
+                image_attributes);
         TiledOutputFile file(filename, header);
 
-        // Write tiles.
+        // Allocate one band of scanlines per layer, large enough for a row of tiles.
+        vector<vector<char> > bands(layer_count);
+        for (size_t i = 0; i < layer_count; ++i)
+        {
+            bands[i].resize(
+                layer_props[i]->m_canvas_width * layer_props[i]->m_tile_height * layer_props[i]->m_pixel_size);
+        }
+
+        // Write tiles, one row of tiles at a time.
         for (size_t y = 0; y < props.m_tile_count_y; ++y)
         {
-            for (size_t x = 0; x < props.m_tile_count_x; ++x)
+            const int iy = static_cast<int>(y);
+            const size_t origin_y = y * props.m_tile_height;
+
+            // Construct FrameBuffer object.
+            FrameBuffer framebuffer;
+            for (size_t i = 0; i < layer_count; ++i)
             {
-                const int ix              = static_cast<int>(x);
-                const int iy              = static_cast<int>(y);
-                const Box2i range         = file.dataWindowForTile(ix, iy);
-                const Tile& tile          = image.tile(x, y);
-                const size_t channel_size = Pixel::size(tile.get_pixel_format());
-                const size_t stride_x     = channel_size * props.m_channel_count;
-                const size_t stride_y     = stride_x * tile.get_width();
-                const size_t tile_origin  = range.min.x * stride_x + range.min.y * stride_y;
-                const char* tile_base     = reinterpret_cast<const char*>(tile.pixel(0, 0)) - tile_origin;
-
-                // Construct FrameBuffer object.
-                FrameBuffer framebuffer;
-                for (size_t c = 0; c < props.m_channel_count; ++c)
-                {
-                    const char* base = tile_base + c * channel_size;
-                    framebuffer.insert(
-                        ChannelName[c],
-                        Slice(
-                            pixel_type,
-                            const_cast<char*>(base),
-                            stride_x,
-                            stride_y));
-                }
-
-                // Write tile.
-                file.setFrameBuffer(framebuffer);
-                file.writeTile(ix, iy);
+                const size_t stride_x = layer_props[i]->m_pixel_size;
+                const size_t stride_y = stride_x * layer_props[i]->m_canvas_width;
+
+                copy_tile_row(*images[i], y, bands[i]);
+
+                // The slices are addressed with absolute pixel coordinates.
+                insert_layer_slices(
+                    layer_names[i],
+                    *layer_props[i],
+                    &bands[i][0] - origin_y * stride_y,
+                    stride_x,
+                    stride_y,
+                    framebuffer);
             }
+
+            // Write the row of tiles; OpenEXR compresses them in parallel.
+            file.setFrameBuffer(framebuffer);
+            file.writeTiles(0, static_cast<int>(props.m_tile_count_x) - 1, iy, iy);
         }
     }
     catch (const BaseExc& e)
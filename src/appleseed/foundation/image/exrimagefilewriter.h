@@ -37,6 +37,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace foundation    { class ICanvas; }
 
@@ -55,6 +58,9 @@ namespace foundation
 //
 // Other image attributes will be stored as generic string attributes.
 //
+// Tiles are written one row of tiles at a time, letting OpenEXR compress
+// the tiles of a row in parallel on its global thread pool.
+//
 // Reference: openexr/ImfStandardAttributes.h
 //
 
@@ -67,6 +73,17 @@ class APPLESEED_DLLSYMBOL EXRImageFileWriter
         const char*             filename,
         const ICanvas&          image,
         const ImageAttributes&  image_attributes = ImageAttributes());
+
+    // Write multiple images as the layers of a single OpenEXR file, in one pass.
+    // All images must have the same dimensions and tile size. The channels of a
+    // layer are named after the layer (e.g. "diffuse.R"), except for layers with
+    // an empty name whose channels are simply named R, G, B and A.
+    void write_layers(
+        const char*             filename,
+        const size_t            layer_count,
+        const char* const       layer_names[],
+        const ICanvas* const    images[],
+        const ImageAttributes&  image_attributes = ImageAttributes());
 };
 
 }       // namespace foundation
@@ -31,7 +31,10 @@
 #include "exrutils.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/exceptionunsupportedimageformat.h"
 #include "foundation/image/imageattributes.h"
+#include "foundation/image/pixel.h"
 #include "foundation/platform/system.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/foreach.h"
@@ -40,12 +43,16 @@
 // OpenEXR headers.
 #include "foundation/platform/exrheaderguards.h"
 BEGIN_EXR_INCLUDES
+#include "OpenEXR/ImfChannelList.h"
+#include "OpenEXR/ImfPixelType.h"
 #include "OpenEXR/ImfStandardAttributes.h"
 #include "OpenEXR/ImfStringAttribute.h"
 #include "OpenEXR/ImfThreading.h"
+#include "OpenEXR/ImfTileDescription.h"
 END_EXR_INCLUDES
 
 // Standard headers.
+#include <cassert>
 #include <string>
 
 using namespace Imf;
@@ -64,6 +71,27 @@ namespace
                 static_cast<int>(System::get_logical_cpu_core_count()));
         }
     };
+
+    const char* ChannelName[] = { "R", "G", "B", "A" };
+
+    PixelType get_pixel_type(const PixelFormat pixel_format)
+    {
+        switch (pixel_format)
+        {
+          case PixelFormatUInt32: return UINT;
+          case PixelFormatHalf: return HALF;
+          case PixelFormatFloat: return FLOAT;
+          default: throw ExceptionUnsupportedImageFormat();
+        }
+    }
+
+    string make_channel_name(const char* layer_name, const size_t channel)
+    {
+        return
+            *layer_name == '\0'
+                ? string(ChannelName[channel])
+                : string(layer_name) + "." + ChannelName[channel];
+    }
 }
 
 void initialize_openexr()
@@ -98,4 +126,77 @@ void add_attributes(
     }
 }
 
+Header create_tiled_header(
+    const size_t            layer_count,
+    const char* const       layer_names[],
+    const CanvasProperties* const layer_props[],
+    const ImageAttributes&  image_attributes)
+{
+    assert(layer_count > 0);
+
+    // All layers share the dimensions and the tiling of the first one.
+    const CanvasProperties& props = *layer_props[0];
+
+    // Construct ChannelList object.
+    ChannelList channels;
+    for (size_t i = 0; i < layer_count; ++i)
+    {
+        const CanvasProperties& p = *layer_props[i];
+
+        if (p.m_canvas_width != props.m_canvas_width ||
+            p.m_canvas_height != props.m_canvas_height ||
+            p.m_tile_width != props.m_tile_width ||
+            p.m_tile_height != props.m_tile_height)
+            throw ExceptionUnsupportedImageFormat();
+
+        // todo: lift this limitation.
+        assert(p.m_channel_count <= 4);
+
+        // Figure out the pixel type, based on the pixel format of the layer.
+        const PixelType pixel_type = get_pixel_type(p.m_pixel_format);
+
+        for (size_t c = 0; c < p.m_channel_count; ++c)
+            channels.insert(make_channel_name(layer_names[i], c), Channel(pixel_type));
+    }
+
+    // Construct Header object.
+    Header header(
+        static_cast<int>(props.m_canvas_width),
+        static_cast<int>(props.m_canvas_height));
+    header.setTileDescription(
+        TileDescription(
+            static_cast<unsigned int>(props.m_tile_width),
+            static_cast<unsigned int>(props.m_tile_height),
+            ONE_LEVEL));
+    header.channels() = channels;
+
+    // Add image attributes to the Header object.
+    add_attributes(image_attributes, header);
+
+    return header;
+}
+
+void insert_layer_slices(
+    const char*             layer_name,
+    const CanvasProperties& layer_props,
+    const char*             base,
+    const size_t            stride_x,
+    const size_t            stride_y,
+    FrameBuffer&            framebuffer)
+{
+    const PixelType pixel_type = get_pixel_type(layer_props.m_pixel_format);
+    const size_t channel_size = Pixel::size(layer_props.m_pixel_format);
+
+    for (size_t c = 0; c < layer_props.m_channel_count; ++c)
+    {
+        framebuffer.insert(
+            make_channel_name(layer_name, c),
+            Slice(
+                pixel_type,
+                const_cast<char*>(base + c * channel_size),
+                stride_x,
+                stride_y));
+    }
+}
+
 }   // namespace foundation
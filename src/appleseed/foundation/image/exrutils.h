@@ -33,10 +33,15 @@
 // OpenEXR headers.
 #include "foundation/platform/exrheaderguards.h"
 BEGIN_EXR_INCLUDES
+#include "OpenEXR/ImfFrameBuffer.h"
 #include "OpenEXR/ImfHeader.h"
 END_EXR_INCLUDES
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
+namespace foundation    { class CanvasProperties; }
 namespace foundation    { class ImageAttributes; }
 
 namespace foundation
@@ -50,6 +55,25 @@ void add_attributes(
     const ImageAttributes&  image_attributes,
     Imf::Header&            header);
 
+// Create the header of a tiled OpenEXR file holding multiple layers. All layers
+// must have the same dimensions and tile size. The channels of a layer are named
+// after the layer (e.g. "diffuse.R"), or simply R, G, B and A if its name is empty.
+Imf::Header create_tiled_header(
+    const size_t            layer_count,
+    const char* const       layer_names[],
+    const CanvasProperties* const layer_props[],
+    const ImageAttributes&  image_attributes);
+
+// Insert the channels of a layer into an OpenEXR FrameBuffer object.
+// 'base' is the address of the pixel at the origin of the data window.
+void insert_layer_slices(
+    const char*             layer_name,
+    const CanvasProperties& layer_props,
+    const char*             base,
+    const size_t            stride_x,
+    const size_t            stride_y,
+    Imf::FrameBuffer&       framebuffer);
+
 }       // namespace foundation
 
 #endif  // !APPLESEED_FOUNDATION_IMAGE_EXRUTILS_H
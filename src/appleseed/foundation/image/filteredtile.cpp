@@ -35,6 +35,10 @@
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/atomic.h"
+#include "foundation/platform/compiler.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
 
 using namespace std;
 
@@ -87,10 +91,80 @@ void FilteredTile::clear()
         ptr[i] = 0.0f;
 }
 
+namespace
+{
+    // Largest footprint width for which the weights of the filter along x are precomputed.
+    const size_t MaxFootprintWidth = 64;
+
+    // Accumulate a weighted sample into a pixel: ptr[0] += weight, ptr[i + 1] += values[i] * weight.
+    APPLESEED_FORCE_INLINE void accumulate(
+        float* APPLESEED_RESTRICT       ptr,
+        const float* APPLESEED_RESTRICT values,
+        const size_t                    value_count,
+        const float                     weight)
+    {
+        *ptr++ += weight;
+
+        size_t i = 0;
+
+#ifdef APPLESEED_USE_SSE
+        const __m128 mweight = _mm_set1_ps(weight);
+
+        for (; i + 4 <= value_count; i += 4)
+        {
+            const __m128 mvalues = _mm_mul_ps(_mm_loadu_ps(values + i), mweight);
+            _mm_storeu_ps(ptr + i, _mm_add_ps(_mm_loadu_ps(ptr + i), mvalues));
+        }
+#endif
+
+        for (; i < value_count; ++i)
+            ptr[i] += values[i] * weight;
+    }
+
+    void accumulate_atomically(
+        float*                          ptr,
+        const float*                    values,
+        const size_t                    value_count,
+        const float                     weight)
+    {
+#ifdef ATOMIC_UPDATES
+        atomic_add(ptr++, weight);
+#else
+        *ptr++ += weight;
+#endif
+
+        for (size_t i = 0; i < value_count; ++i)
+        {
+#ifdef ATOMIC_UPDATES
+            atomic_add(ptr++, values[i] * weight);
+#else
+            *ptr++ += values[i] * weight;
+#endif
+        }
+    }
+}
+
 void FilteredTile::add(
     const float         x,
     const float         y,
     const float*        values)
+{
+    add_impl<true>(x, y, values);
+}
+
+void FilteredTile::add_exclusive(
+    const float         x,
+    const float         y,
+    const float*        values)
+{
+    add_impl<false>(x, y, values);
+}
+
+template <bool AtomicUpdates>
+void FilteredTile::add_impl(
+    const float         x,
+    const float         y,
+    const float*        values)
 {
     // Convert (x, y) from continuous image space to discrete image space.
     const float dx = x - 0.5f;
@@ -111,28 +185,36 @@ void FilteredTile::add(
     if (footprint.min.x > footprint.max.x)
         return;
 
+    const size_t footprint_width = static_cast<size_t>(footprint.max.x - footprint.min.x + 1);
+    const size_t value_count = m_channel_count - 1;
+
+    // The filter is separable: evaluate it once per column and once per row of the footprint.
+    float weights_x[MaxFootprintWidth];
+    const bool separable = footprint_width <= MaxFootprintWidth;
+
+    if (separable)
+    {
+        for (size_t i = 0; i < footprint_width; ++i)
+            weights_x[i] = m_filter.evaluate_x(footprint.min.x + static_cast<int>(i) - dx);
+    }
+
     for (int ry = footprint.min.y; ry <= footprint.max.y; ++ry)
     {
+        const float weight_y = m_filter.evaluate_y(ry - dy);
         float* APPLESEED_RESTRICT ptr = reinterpret_cast<float*>(pixel(footprint.min.x, ry));
 
-        for (int rx = footprint.min.x; rx <= footprint.max.x; ++rx)
+        for (size_t i = 0; i < footprint_width; ++i)
         {
-            const float weight = m_filter.evaluate(rx - dx, ry - dy);
+            const float weight =
+                separable
+                    ? weights_x[i] * weight_y
+                    : m_filter.evaluate(footprint.min.x + static_cast<int>(i) - dx, ry - dy);
 
-#ifdef ATOMIC_UPDATES
-            atomic_add(ptr++, weight);
-#else
-            *ptr++ += weight;
-#endif
+            if (AtomicUpdates)
+                accumulate_atomically(ptr, values, value_count, weight);
+            else accumulate(ptr, values, value_count, weight);
 
-            for (size_t i = 0, e = m_channel_count - 1; i < e; ++i)
-            {
-#ifdef ATOMIC_UPDATES
-                atomic_add(ptr++, values[i] * weight);
-#else
-                *ptr++ += values[i] * weight;
-#endif
-            }
+            ptr += m_channel_count;
         }
     }
 }
@@ -120,14 +120,29 @@ class FilteredTile
 
     // The point (x, y) is expressed in continuous image space
     // (https://github.com/appleseedhq/appleseed/wiki/Terminology).
+    // Pixels are updated atomically: samples can be added by several threads at once.
     void add(
         const float         x,
         const float         y,
         const float*        values);
 
+    // Like add(), but pixels are updated with SIMD instructions rather than atomically.
+    // Only use this method if no other thread is accessing the tile.
+    void add_exclusive(
+        const float         x,
+        const float         y,
+        const float*        values);
+
   protected:
     const AABB2u            m_crop_window;
     const Filter2f&         m_filter;
+
+  private:
+    template <bool AtomicUpdates>
+    void add_impl(
+        const float         x,
+        const float         y,
+        const float*        values);
 };
 
 
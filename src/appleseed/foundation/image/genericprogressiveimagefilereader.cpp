@@ -47,7 +47,6 @@ END_OIIO_INCLUDES
 // Standard headers.
 #include <algorithm>
 #include <cassert>
-#include <cstring>
 #include <memory>
 #include <string>
 
@@ -59,6 +58,25 @@ namespace foundation
 //
 // GenericProgressiveImageFileReader class implementation.
 //
+// Tiles of tiled image files map 1:1 to the tiles of the file: a tile read
+// only decodes the corresponding file tile, straight into the returned tile.
+//
+// Scanline OpenEXR and TIFF files can be read at arbitrary scanlines: they are
+// exposed as bands of ScanlineBandHeight full-width scanlines, such that only
+// the scanlines that are actually needed get decoded. Other scanline files
+// are exposed as a single tile covering the whole image.
+//
+
+namespace
+{
+    const size_t ScanlineBandHeight = 32;
+
+    bool supports_random_scanline_access(const OIIO::ImageInput& input)
+    {
+        const string format_name = input.format_name();
+        return format_name == "openexr" || format_name == "tiff";
+    }
+}
 
 struct GenericProgressiveImageFileReader::Impl
 {
@@ -67,6 +85,7 @@ struct GenericProgressiveImageFileReader::Impl
     OIIO::ImageInput*                       m_input;
     bool                                    m_supports_random_access;
     bool                                    m_is_tiled;
+    bool                                    m_is_banded;
     CanvasProperties                        m_props;
 
     void open()
@@ -81,6 +100,7 @@ struct GenericProgressiveImageFileReader::Impl
         const OIIO::ImageSpec& spec = m_input->spec();
 
         m_is_tiled = spec.tile_width > 0 && spec.tile_height > 0 && spec.tile_depth > 0;
+        m_is_banded = !m_is_tiled && supports_random_scanline_access(*m_input);
 
         size_t tile_width, tile_height;
         if (m_is_tiled)
@@ -89,6 +109,12 @@ struct GenericProgressiveImageFileReader::Impl
             tile_width = static_cast<size_t>(spec.tile_width);
             tile_height = static_cast<size_t>(spec.tile_height);
         }
+        else if (m_is_banded)
+        {
+            // Scanline image read in bands of scanlines.
+            tile_width = static_cast<size_t>(spec.width);
+            tile_height = min(ScanlineBandHeight, static_cast<size_t>(spec.height));
+        }
         else
         {
             // Scanline image.
@@ -147,6 +173,7 @@ GenericProgressiveImageFileReader::GenericProgressiveImageFileReader(Logger* log
     impl->m_input = 0;
     impl->m_supports_random_access = false;
     impl->m_is_tiled = false;
+    impl->m_is_banded = false;
 }
 
 GenericProgressiveImageFileReader::~GenericProgressiveImageFileReader()
@@ -208,62 +235,73 @@ Tile* GenericProgressiveImageFileReader::read_tile(
 {
     assert(is_open());
 
+    const OIIO::ImageSpec& spec = impl->m_input->spec();
+
+    const size_t origin_x = tile_x * impl->m_props.m_tile_width;
+    const size_t origin_y = tile_y * impl->m_props.m_tile_height;
+
+    // In appleseed, for images whose width or height are not multiples
+    // of the tile's width or height, border tiles are actually smaller.
+    const size_t tile_width = min(impl->m_props.m_tile_width, impl->m_props.m_canvas_width - origin_x);
+    const size_t tile_height = min(impl->m_props.m_tile_height, impl->m_props.m_canvas_height - origin_y);
+
     if (impl->m_is_tiled)
     {
         //
         // Tiled image.
         //
-        // In appleseed, for images whose width or height are not multiples
-        // of the tile's width or height, border tiles are actually smaller.
         // In OpenImageIO, border tiles have the same size as other tiles,
         // and the image's pixel data window defines which pixels of those
-        // tiles actually belong to the image.
-        //
-        // Since in appleseed we don't propagate pixel data windows through
-        // the whole image pipeline, we make sure here to return tiles of
-        // the correct dimensions, at some expenses.
+        // tiles actually belong to the image. Reading the region clipped to
+        // the data window lets OpenImageIO decode the file tile directly into
+        // a tile of the correct dimensions.
         //
 
-        auto_ptr<Tile> source_tile(
+        auto_ptr<Tile> tile(
             new Tile(
-                impl->m_props.m_tile_width,
-                impl->m_props.m_tile_height,
+                tile_width,
+                tile_height,
                 impl->m_props.m_channel_count,
                 impl->m_props.m_pixel_format));
 
-        const size_t origin_x = tile_x * impl->m_props.m_tile_width;
-        const size_t origin_y = tile_y * impl->m_props.m_tile_height;
+        const int xbegin = spec.x + static_cast<int>(origin_x);
+        const int ybegin = spec.y + static_cast<int>(origin_y);
 
-        if (!impl->m_input->read_tile(
-                static_cast<int>(origin_x),
-                static_cast<int>(origin_y),
-                0, // z
-                impl->m_input->spec().format,
-                source_tile->get_storage()))
+        if (!impl->m_input->read_tiles(
+                xbegin, xbegin + static_cast<int>(tile_width),
+                ybegin, ybegin + static_cast<int>(tile_height),
+                spec.z, spec.z + 1,
+                spec.format,
+                tile->get_storage()))
             throw ExceptionIOError(impl->m_input->geterror().c_str());
 
-        const size_t tile_width = min(impl->m_props.m_tile_width, impl->m_props.m_canvas_width - origin_x);
-        const size_t tile_height = min(impl->m_props.m_tile_height, impl->m_props.m_canvas_height - origin_y);
+        return tile.release();
+    }
+    else if (impl->m_is_banded)
+    {
+        //
+        // Scanline image read in bands of scanlines.
+        //
 
-        if (tile_width == impl->m_props.m_tile_width && tile_height == impl->m_props.m_tile_height)
-            return source_tile.release();
+        assert(tile_x == 0);
 
-        auto_ptr<Tile> shrunk_tile(
+        auto_ptr<Tile> tile(
             new Tile(
                 tile_width,
                 tile_height,
                 impl->m_props.m_channel_count,
                 impl->m_props.m_pixel_format));
 
-        for (size_t y = 0; y < tile_height; ++y)
-        {
-            memcpy(
-                shrunk_tile->pixel(0, y),
-                source_tile->pixel(0, y),
-                tile_width * impl->m_props.m_pixel_size);
-        }
+        const int ybegin = spec.y + static_cast<int>(origin_y);
 
-        return shrunk_tile.release();
+        if (!impl->m_input->read_scanlines(
+                ybegin, ybegin + static_cast<int>(tile_height),
+                spec.z,
+                spec.format,
+                tile->get_storage()))
+            throw ExceptionIOError(impl->m_input->geterror().c_str());
+
+        return tile.release();
     }
     else
     {
@@ -33,6 +33,10 @@
 // appleseed.foundation headers.
 #include "foundation/image/tile.h"
 #include "foundation/platform/types.h"
+#include "foundation/utility/memory.h"
+
+// lz4 headers.
+#include "lz4.h"
 
 // Standard headers.
 #include <cassert>
@@ -69,6 +73,7 @@ Image::Image(
     assert(channel_count > 0);
 
     m_tiles = new Tile*[m_props.m_tile_count];
+    m_compressed_tiles = new vector<uint8>[m_props.m_tile_count];
 
     for (size_t i = 0; i < m_props.m_tile_count; ++i)
         m_tiles[i] = 0;
@@ -78,6 +83,7 @@ Image::Image(const CanvasProperties& props)
   : m_props(props)
 {
     m_tiles = new Tile*[m_props.m_tile_count];
+    m_compressed_tiles = new vector<uint8>[m_props.m_tile_count];
 
     for (size_t i = 0; i < m_props.m_tile_count; ++i)
         m_tiles[i] = 0;
@@ -87,6 +93,7 @@ Image::Image(const Image& rhs)
   : m_props(rhs.m_props)
 {
     m_tiles = new Tile*[m_props.m_tile_count];
+    m_compressed_tiles = new vector<uint8>[m_props.m_tile_count];
 
     for (size_t ty = 0; ty < m_props.m_tile_count_y; ++ty)
     {
@@ -116,6 +123,7 @@ Image::Image(
     const CanvasProperties& source_props = source.properties();
 
     m_tiles = new Tile*[m_props.m_tile_count];
+    m_compressed_tiles = new vector<uint8>[m_props.m_tile_count];
 
     for (size_t ty = 0; ty < m_props.m_tile_count_y; ++ty)
     {
@@ -161,6 +169,7 @@ Image::~Image()
         delete m_tiles[i];
 
     delete [] m_tiles;
+    delete [] m_compressed_tiles;
 }
 
 void Image::release()
@@ -183,7 +192,19 @@ Tile& Image::tile(
                 m_props.m_channel_count,
                 m_props.m_pixel_format);
 
-        memset(tile->pixel(0, 0), 0, tile->get_size());
+        vector<uint8>& compressed_tile = m_compressed_tiles[tile_index];
+
+        if (compressed_tile.empty())
+            memset(tile->pixel(0, 0), 0, tile->get_size());
+        else
+        {
+            LZ4_decompress_fast(
+                reinterpret_cast<const char*>(&compressed_tile[0]),
+                reinterpret_cast<char*>(tile->pixel(0, 0)),
+                static_cast<int>(tile->get_size()));
+
+            clear_release_memory(compressed_tile);
+        }
 
         m_tiles[tile_index] = tile;
     }
@@ -208,6 +229,37 @@ void Image::set_tile(
     delete m_tiles[tile_index];
 
     m_tiles[tile_index] = tile;
+    clear_release_memory(m_compressed_tiles[tile_index]);
+}
+
+void Image::compress_tile(
+    const size_t        tile_x,
+    const size_t        tile_y)
+{
+    const size_t tile_index = tile_y * m_props.m_tile_count_x + tile_x;
+
+    Tile* tile = m_tiles[tile_index];
+
+    if (tile == 0)
+        return;
+
+    const int tile_size = static_cast<int>(tile->get_size());
+
+    vector<uint8> compressed_tile(static_cast<size_t>(LZ4_compressBound(tile_size)));
+
+    const int compressed_size =
+        LZ4_compress(
+            reinterpret_cast<const char*>(tile->pixel(0, 0)),
+            reinterpret_cast<char*>(&compressed_tile[0]),
+            tile_size);
+
+    // Only keep the compressed bytes.
+    m_compressed_tiles[tile_index].assign(
+        compressed_tile.begin(),
+        compressed_tile.begin() + compressed_size);
+
+    delete tile;
+    m_tiles[tile_index] = 0;
 }
 
 }   // namespace foundation
@@ -42,6 +42,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class Tile; }
@@ -52,7 +53,8 @@ namespace foundation
 //
 // An image whose tiles are lazily constructed.
 //
-// Tiles are initially blank.
+// Tiles are initially blank. Tiles can be compressed in memory; a compressed
+// tile is decompressed the next time it is accessed.
 //
 
 class APPLESEED_DLLSYMBOL Image
@@ -106,9 +108,16 @@ class APPLESEED_DLLSYMBOL Image
         const size_t        tile_y,
         Tile*               tile);
 
+    // Compress a tile in memory with a fast lossless codec and release its pixels.
+    // Compressing a tile that was never accessed has no effect.
+    void compress_tile(
+        const size_t        tile_x,
+        const size_t        tile_y);
+
   protected:
     CanvasProperties        m_props;
     Tile**                  m_tiles;
+    std::vector<uint8>*     m_compressed_tiles;     // empty if the tile is not compressed
 };
 
 
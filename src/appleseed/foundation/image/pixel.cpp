@@ -30,6 +30,12 @@
 // Interface header.
 #include "pixel.h"
 
+// appleseed.foundation headers.
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/sse.h"
+#endif
+
 namespace foundation
 {
 
@@ -50,6 +56,69 @@ const char* pixel_format_name(const PixelFormat pixel_format)
     return "";
 }
 
+#ifdef APPLESEED_USE_SSE
+
+namespace
+{
+    // Quantize the four channels of a float pixel to 8-bit integers, as Pixel::convert() does.
+    inline __m128i quantize_to_uint8(const float* src)
+    {
+        const __m128 value = _mm_mul_ps(_mm_loadu_ps(src), _mm_set1_ps(256.0f));
+        return
+            _mm_cvttps_epi32(
+                _mm_min_ps(
+                    _mm_max_ps(value, _mm_setzero_ps()),
+                    _mm_set1_ps(255.0f)));
+    }
+
+    // Convert RGBA float pixels to 8-bit integer pixels, shuffling channels on the way.
+    void convert_float4_to_uint8_and_shuffle(
+        const float*        src_begin,
+        const float*        src_end,
+        const size_t        dest_channels,
+        uint8*              dest,
+        const size_t*       shuffle_table)
+    {
+        // Gather the source channel of each destination channel.
+        size_t src_channel_indices[4];
+        for (size_t i = 0, k = 0; i < 4; ++i)
+        {
+            if (shuffle_table[i] != Pixel::SkipChannel)
+                src_channel_indices[k++] = shuffle_table[i];
+        }
+
+        APPLESEED_SIMD4_ALIGN uint8 values[16];
+
+        const float* it = src_begin;
+
+        // Convert four pixels at a time.
+        for (; it + 16 <= src_end; it += 16)
+        {
+            const __m128i q01 = _mm_packs_epi32(quantize_to_uint8(it), quantize_to_uint8(it + 4));
+            const __m128i q23 = _mm_packs_epi32(quantize_to_uint8(it + 8), quantize_to_uint8(it + 12));
+            _mm_store_si128(reinterpret_cast<__m128i*>(values), _mm_packus_epi16(q01, q23));
+
+            for (size_t p = 0; p < 16; p += 4)
+            {
+                for (size_t k = 0; k < dest_channels; ++k)
+                    *dest++ = values[p + src_channel_indices[k]];
+            }
+        }
+
+        // Convert the remaining pixels one at a time.
+        for (; it < src_end; it += 4)
+        {
+            const __m128i q = _mm_packs_epi32(quantize_to_uint8(it), _mm_setzero_si128());
+            _mm_store_si128(reinterpret_cast<__m128i*>(values), _mm_packus_epi16(q, q));
+
+            for (size_t k = 0; k < dest_channels; ++k)
+                *dest++ = values[src_channel_indices[k]];
+        }
+    }
+}
+
+#endif  // APPLESEED_USE_SSE
+
 void Pixel::convert_and_shuffle(
     const PixelFormat   src_format,
     const size_t        src_channels,
@@ -60,6 +129,23 @@ void Pixel::convert_and_shuffle(
     void*               dest,
     const size_t*       shuffle_table)
 {
+#ifdef APPLESEED_USE_SSE
+    // Fast path for the conversion of RGBA float pixels for display.
+    if (src_format == PixelFormatFloat && src_channels == 4 && dest_format == PixelFormatUInt8)
+    {
+        assert(dest_channels == get_dest_channel_count(src_channels, shuffle_table));
+
+        convert_float4_to_uint8_and_shuffle(
+            reinterpret_cast<const float*>(src_begin),
+            reinterpret_cast<const float*>(src_end),
+            dest_channels,
+            reinterpret_cast<uint8*>(dest),
+            shuffle_table);
+
+        return;
+    }
+#endif
+
     // Compute size in bytes of source and destination pixel formats.
     const size_t src_channel_size = size(src_format);
     const size_t dest_channel_size = size(dest_format);
@@ -0,0 +1,190 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Interface header.
+#include "progressiveexrimagefilewriter.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/exrutils.h"
+#include "foundation/image/tile.h"
+#include "foundation/platform/thread.h"
+
+// OpenEXR headers.
+#include "foundation/platform/exrheaderguards.h"
+BEGIN_EXR_INCLUDES
+#include "OpenEXR/IexBaseExc.h"
+#include "OpenEXR/ImfFrameBuffer.h"
+#include "OpenEXR/ImfHeader.h"
+#include "OpenEXR/ImfLineOrder.h"
+#include "OpenEXR/ImfTiledOutputFile.h"
+END_EXR_INCLUDES
+
+// Standard headers.
+#include <cassert>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Iex;
+using namespace Imf;
+using namespace std;
+
+namespace foundation
+{
+
+//
+// ProgressiveEXRImageFileWriter class implementation.
+//
+
+struct ProgressiveEXRImageFileWriter::Impl
+{
+    boost::mutex                m_mutex;
+    auto_ptr<TiledOutputFile>   m_file;
+    vector<string>              m_layer_names;
+    vector<CanvasProperties>    m_layer_props;
+};
+
+ProgressiveEXRImageFileWriter::ProgressiveEXRImageFileWriter()
+  : impl(new Impl())
+{
+}
+
+ProgressiveEXRImageFileWriter::~ProgressiveEXRImageFileWriter()
+{
+    close();
+    delete impl;
+}
+
+void ProgressiveEXRImageFileWriter::open(
+    const char*                     filename,
+    const size_t                    layer_count,
+    const char* const               layer_names[],
+    const CanvasProperties* const   layer_props[],
+    const ImageAttributes&          image_attributes)
+{
+    assert(filename);
+    assert(!is_open());
+
+    initialize_openexr();
+
+    try
+    {
+        Header header =
+            create_tiled_header(
+                layer_count,
+                layer_names,
+                layer_props,
+                image_attributes);
+        header.lineOrder() = RANDOM_Y;
+
+        impl->m_file.reset(new TiledOutputFile(filename, header));
+    }
+    catch (const BaseExc& e)
+    {
+        // I/O error.
+        throw ExceptionIOError(e.what());
+    }
+
+    impl->m_layer_names.assign(layer_names, layer_names + layer_count);
+    impl->m_layer_props.clear();
+    for (size_t i = 0; i < layer_count; ++i)
+        impl->m_layer_props.push_back(*layer_props[i]);
+}
+
+bool ProgressiveEXRImageFileWriter::is_open() const
+{
+    return impl->m_file.get() != 0;
+}
+
+void ProgressiveEXRImageFileWriter::close()
+{
+    try
+    {
+        // Destroying the file object writes the tile offset table.
+        impl->m_file.reset();
+    }
+    catch (const BaseExc& e)
+    {
+        // I/O error.
+        throw ExceptionIOError(e.what());
+    }
+}
+
+void ProgressiveEXRImageFileWriter::write_tile(
+    const size_t                    tile_x,
+    const size_t                    tile_y,
+    const Tile* const               tiles[])
+{
+    assert(is_open());
+
+    // Construct FrameBuffer object.
+    FrameBuffer framebuffer;
+    for (size_t i = 0; i < impl->m_layer_props.size(); ++i)
+    {
+        const CanvasProperties& props = impl->m_layer_props[i];
+        const Tile& tile = *tiles[i];
+
+        assert(tile.get_width() == props.get_tile_width(tile_x));
+        assert(tile.get_height() == props.get_tile_height(tile_y));
+        assert(tile.get_channel_count() == props.m_channel_count);
+        assert(tile.get_pixel_format() == props.m_pixel_format);
+
+        const size_t stride_x = props.m_pixel_size;
+        const size_t stride_y = stride_x * tile.get_width();
+        const size_t tile_origin =
+            tile_x * props.m_tile_width * stride_x +
+            tile_y * props.m_tile_height * stride_y;
+
+        // The slices are addressed with absolute pixel coordinates.
+        insert_layer_slices(
+            impl->m_layer_names[i].c_str(),
+            props,
+            reinterpret_cast<const char*>(tile.pixel(0, 0)) - tile_origin,
+            stride_x,
+            stride_y,
+            framebuffer);
+    }
+
+    try
+    {
+        boost::mutex::scoped_lock lock(impl->m_mutex);
+        impl->m_file->setFrameBuffer(framebuffer);
+        impl->m_file->writeTile(static_cast<int>(tile_x), static_cast<int>(tile_y));
+    }
+    catch (const BaseExc& e)
+    {
+        // I/O error.
+        throw ExceptionIOError(e.what());
+    }
+}
+
+}   // namespace foundation
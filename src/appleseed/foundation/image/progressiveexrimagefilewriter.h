@@ -0,0 +1,98 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef APPLESEED_FOUNDATION_IMAGE_PROGRESSIVEEXRIMAGEFILEWRITER_H
+#define APPLESEED_FOUNDATION_IMAGE_PROGRESSIVEEXRIMAGEFILEWRITER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/imageattributes.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class CanvasProperties; }
+namespace foundation    { class Tile; }
+
+namespace foundation
+{
+
+//
+// An OpenEXR image file writer that writes tiles one at a time, in any order,
+// so that the whole image never needs to be held in memory.
+//
+// The layers of the file are named as with EXRImageFileWriter::write_layers().
+// Tiles are stored in random line order: OpenEXR writes each tile to disk as
+// soon as it is received instead of buffering it until the tiles preceding it
+// are written. Writing tiles is thread-safe.
+//
+
+class APPLESEED_DLLSYMBOL ProgressiveEXRImageFileWriter
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    ProgressiveEXRImageFileWriter();
+
+    // Destructor, closes the file.
+    ~ProgressiveEXRImageFileWriter();
+
+    // Create an OpenEXR image file. All layers must have the same dimensions and tile size.
+    void open(
+        const char*                     filename,
+        const size_t                    layer_count,
+        const char* const               layer_names[],
+        const CanvasProperties* const   layer_props[],
+        const ImageAttributes&          image_attributes = ImageAttributes());
+
+    // Return true if a file is open.
+    bool is_open() const;
+
+    // Close the file. Tiles that were not written are left empty.
+    void close();
+
+    // Write one tile of every layer. Each tile must be written at most once.
+    void write_tile(
+        const size_t                    tile_x,
+        const size_t                    tile_y,
+        const Tile* const               tiles[]);
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_IMAGE_PROGRESSIVEEXRIMAGEFILEWRITER_H
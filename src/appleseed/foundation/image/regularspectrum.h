@@ -219,7 +219,20 @@ inline void RegularSpectrum<T, N>::set(const ValueType val)
         m_samples[i] = val;
 }
 
-#ifdef APPLESEED_USE_SSE
+#if defined APPLESEED_USE_AVX
+
+template <>
+APPLESEED_FORCE_INLINE void RegularSpectrum<float, 31>::set(const float val)
+{
+    const __m256 mval = _mm256_set1_ps(val);
+
+    _mm256_storeu_ps(&m_samples[ 0], mval);
+    _mm256_storeu_ps(&m_samples[ 8], mval);
+    _mm256_storeu_ps(&m_samples[16], mval);
+    _mm256_storeu_ps(&m_samples[24], mval);
+}
+
+#elif defined APPLESEED_USE_SSE
 
 template <>
 APPLESEED_FORCE_INLINE void RegularSpectrum<float, 31>::set(const float val)
@@ -236,7 +249,7 @@ APPLESEED_FORCE_INLINE void RegularSpectrum<float, 31>::set(const float val)
     _mm_store_ps(&m_samples[28], mval);
 }
 
-#endif  // APPLESEED_USE_SSE
+#endif
 
 template <typename T, size_t N>
 inline T& RegularSpectrum<T, N>::operator[](const size_t i)
@@ -352,6 +365,36 @@ inline RegularSpectrum<T, N> operator-(const RegularSpectrum<T, N>& lhs, const R
     return result;
 }
 
+#ifdef APPLESEED_USE_AVX
+
+template <>
+APPLESEED_FORCE_INLINE RegularSpectrum<float, 31> operator+(const RegularSpectrum<float, 31>& lhs, const RegularSpectrum<float, 31>& rhs)
+{
+    RegularSpectrum<float, 31> result;
+
+    _mm256_storeu_ps(&result[ 0], _mm256_add_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&rhs[ 0])));
+    _mm256_storeu_ps(&result[ 8], _mm256_add_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&rhs[ 8])));
+    _mm256_storeu_ps(&result[16], _mm256_add_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&rhs[16])));
+    _mm256_storeu_ps(&result[24], _mm256_add_ps(_mm256_loadu_ps(&lhs[24]), _mm256_loadu_ps(&rhs[24])));
+
+    return result;
+}
+
+template <>
+APPLESEED_FORCE_INLINE RegularSpectrum<float, 31> operator-(const RegularSpectrum<float, 31>& lhs, const RegularSpectrum<float, 31>& rhs)
+{
+    RegularSpectrum<float, 31> result;
+
+    _mm256_storeu_ps(&result[ 0], _mm256_sub_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&rhs[ 0])));
+    _mm256_storeu_ps(&result[ 8], _mm256_sub_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&rhs[ 8])));
+    _mm256_storeu_ps(&result[16], _mm256_sub_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&rhs[16])));
+    _mm256_storeu_ps(&result[24], _mm256_sub_ps(_mm256_loadu_ps(&lhs[24]), _mm256_loadu_ps(&rhs[24])));
+
+    return result;
+}
+
+#endif  // APPLESEED_USE_AVX
+
 template <typename T, size_t N>
 inline RegularSpectrum<T, N> operator-(const RegularSpectrum<T, N>& lhs)
 {
@@ -374,6 +417,25 @@ inline RegularSpectrum<T, N> operator*(const RegularSpectrum<T, N>& lhs, const T
     return result;
 }
 
+#ifdef APPLESEED_USE_AVX
+
+template <>
+APPLESEED_FORCE_INLINE RegularSpectrum<float, 31> operator*(const RegularSpectrum<float, 31>& lhs, const float rhs)
+{
+    RegularSpectrum<float, 31> result;
+
+    const __m256 mrhs = _mm256_set1_ps(rhs);
+
+    _mm256_storeu_ps(&result[ 0], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 0]), mrhs));
+    _mm256_storeu_ps(&result[ 8], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 8]), mrhs));
+    _mm256_storeu_ps(&result[16], _mm256_mul_ps(_mm256_loadu_ps(&lhs[16]), mrhs));
+    _mm256_storeu_ps(&result[24], _mm256_mul_ps(_mm256_loadu_ps(&lhs[24]), mrhs));
+
+    return result;
+}
+
+#endif  // APPLESEED_USE_AVX
+
 template <typename T, size_t N>
 inline RegularSpectrum<T, N> operator*(const T lhs, const RegularSpectrum<T, N>& rhs)
 {
@@ -391,6 +453,23 @@ inline RegularSpectrum<T, N> operator*(const RegularSpectrum<T, N>& lhs, const R
     return result;
 }
 
+#ifdef APPLESEED_USE_AVX
+
+template <>
+APPLESEED_FORCE_INLINE RegularSpectrum<float, 31> operator*(const RegularSpectrum<float, 31>& lhs, const RegularSpectrum<float, 31>& rhs)
+{
+    RegularSpectrum<float, 31> result;
+
+    _mm256_storeu_ps(&result[ 0], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&rhs[ 0])));
+    _mm256_storeu_ps(&result[ 8], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&rhs[ 8])));
+    _mm256_storeu_ps(&result[16], _mm256_mul_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&rhs[16])));
+    _mm256_storeu_ps(&result[24], _mm256_mul_ps(_mm256_loadu_ps(&lhs[24]), _mm256_loadu_ps(&rhs[24])));
+
+    return result;
+}
+
+#endif  // APPLESEED_USE_AVX
+
 template <typename T, size_t N>
 inline RegularSpectrum<T, N> operator/(const RegularSpectrum<T, N>& lhs, const T rhs)
 {
@@ -440,7 +519,20 @@ inline RegularSpectrum<T, N>& operator+=(RegularSpectrum<T, N>& lhs, const Regul
     return lhs;
 }
 
-#ifdef APPLESEED_USE_SSE
+#if defined APPLESEED_USE_AVX
+
+template <>
+APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator+=(RegularSpectrum<float, 31>& lhs, const RegularSpectrum<float, 31>& rhs)
+{
+    _mm256_storeu_ps(&lhs[ 0], _mm256_add_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&rhs[ 0])));
+    _mm256_storeu_ps(&lhs[ 8], _mm256_add_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&rhs[ 8])));
+    _mm256_storeu_ps(&lhs[16], _mm256_add_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&rhs[16])));
+    _mm256_storeu_ps(&lhs[24], _mm256_add_ps(_mm256_loadu_ps(&lhs[24]), _mm256_loadu_ps(&rhs[24])));
+
+    return lhs;
+}
+
+#elif defined APPLESEED_USE_SSE
 
 template <>
 APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator+=(RegularSpectrum<float, 31>& lhs, const RegularSpectrum<float, 31>& rhs)
@@ -457,7 +549,7 @@ APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator+=(RegularSpectrum<fl
     return lhs;
 }
 
-#endif  // APPLESEED_USE_SSE
+#endif
 
 template <typename T, size_t N>
 inline RegularSpectrum<T, N>& operator-=(RegularSpectrum<T, N>& lhs, const RegularSpectrum<T, N>& rhs)
@@ -468,6 +560,38 @@ inline RegularSpectrum<T, N>& operator-=(RegularSpectrum<T, N>& lhs, const Regul
     return lhs;
 }
 
+#if defined APPLESEED_USE_AVX
+
+template <>
+APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator-=(RegularSpectrum<float, 31>& lhs, const RegularSpectrum<float, 31>& rhs)
+{
+    _mm256_storeu_ps(&lhs[ 0], _mm256_sub_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&rhs[ 0])));
+    _mm256_storeu_ps(&lhs[ 8], _mm256_sub_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&rhs[ 8])));
+    _mm256_storeu_ps(&lhs[16], _mm256_sub_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&rhs[16])));
+    _mm256_storeu_ps(&lhs[24], _mm256_sub_ps(_mm256_loadu_ps(&lhs[24]), _mm256_loadu_ps(&rhs[24])));
+
+    return lhs;
+}
+
+#elif defined APPLESEED_USE_SSE
+
+template <>
+APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator-=(RegularSpectrum<float, 31>& lhs, const RegularSpectrum<float, 31>& rhs)
+{
+    _mm_store_ps(&lhs[ 0], _mm_sub_ps(_mm_load_ps(&lhs[ 0]), _mm_load_ps(&rhs[ 0])));
+    _mm_store_ps(&lhs[ 4], _mm_sub_ps(_mm_load_ps(&lhs[ 4]), _mm_load_ps(&rhs[ 4])));
+    _mm_store_ps(&lhs[ 8], _mm_sub_ps(_mm_load_ps(&lhs[ 8]), _mm_load_ps(&rhs[ 8])));
+    _mm_store_ps(&lhs[12], _mm_sub_ps(_mm_load_ps(&lhs[12]), _mm_load_ps(&rhs[12])));
+    _mm_store_ps(&lhs[16], _mm_sub_ps(_mm_load_ps(&lhs[16]), _mm_load_ps(&rhs[16])));
+    _mm_store_ps(&lhs[20], _mm_sub_ps(_mm_load_ps(&lhs[20]), _mm_load_ps(&rhs[20])));
+    _mm_store_ps(&lhs[24], _mm_sub_ps(_mm_load_ps(&lhs[24]), _mm_load_ps(&rhs[24])));
+    _mm_store_ps(&lhs[28], _mm_sub_ps(_mm_load_ps(&lhs[28]), _mm_load_ps(&rhs[28])));
+
+    return lhs;
+}
+
+#endif
+
 template <typename T, size_t N>
 inline RegularSpectrum<T, N>& operator*=(RegularSpectrum<T, N>& lhs, const T rhs)
 {
@@ -477,7 +601,22 @@ inline RegularSpectrum<T, N>& operator*=(RegularSpectrum<T, N>& lhs, const T rhs
     return lhs;
 }
 
-#ifdef APPLESEED_USE_SSE
+#if defined APPLESEED_USE_AVX
+
+template <>
+APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator*=(RegularSpectrum<float, 31>& lhs, const float rhs)
+{
+    const __m256 mrhs = _mm256_set1_ps(rhs);
+
+    _mm256_storeu_ps(&lhs[ 0], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 0]), mrhs));
+    _mm256_storeu_ps(&lhs[ 8], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 8]), mrhs));
+    _mm256_storeu_ps(&lhs[16], _mm256_mul_ps(_mm256_loadu_ps(&lhs[16]), mrhs));
+    _mm256_storeu_ps(&lhs[24], _mm256_mul_ps(_mm256_loadu_ps(&lhs[24]), mrhs));
+
+    return lhs;
+}
+
+#elif defined APPLESEED_USE_SSE
 
 template <>
 APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator*=(RegularSpectrum<float, 31>& lhs, const float rhs)
@@ -496,7 +635,7 @@ APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator*=(RegularSpectrum<fl
     return lhs;
 }
 
-#endif  // APPLESEED_USE_SSE
+#endif
 
 template <typename T, size_t N>
 inline RegularSpectrum<T, N>& operator*=(RegularSpectrum<T, N>& lhs, const RegularSpectrum<T, N>& rhs)
@@ -507,7 +646,20 @@ inline RegularSpectrum<T, N>& operator*=(RegularSpectrum<T, N>& lhs, const Regul
     return lhs;
 }
 
-#ifdef APPLESEED_USE_SSE
+#if defined APPLESEED_USE_AVX
+
+template <>
+APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator*=(RegularSpectrum<float, 31>& lhs, const RegularSpectrum<float, 31>& rhs)
+{
+    _mm256_storeu_ps(&lhs[ 0], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&rhs[ 0])));
+    _mm256_storeu_ps(&lhs[ 8], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&rhs[ 8])));
+    _mm256_storeu_ps(&lhs[16], _mm256_mul_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&rhs[16])));
+    _mm256_storeu_ps(&lhs[24], _mm256_mul_ps(_mm256_loadu_ps(&lhs[24]), _mm256_loadu_ps(&rhs[24])));
+
+    return lhs;
+}
+
+#elif defined APPLESEED_USE_SSE
 
 template <>
 APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator*=(RegularSpectrum<float, 31>& lhs, const RegularSpectrum<float, 31>& rhs)
@@ -524,7 +676,7 @@ APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator*=(RegularSpectrum<fl
     return lhs;
 }
 
-#endif  // APPLESEED_USE_SSE
+#endif
 
 template <typename T, size_t N>
 inline RegularSpectrum<T, N>& operator/=(RegularSpectrum<T, N>& lhs, const T rhs)
@@ -562,6 +714,24 @@ inline RegularSpectrum<T, N>& operator/=(RegularSpectrum<T, N>& lhs, const Regul
     return lhs;
 }
 
+#ifdef APPLESEED_USE_AVX
+
+template <>
+APPLESEED_FORCE_INLINE RegularSpectrum<float, 31>& operator/=(RegularSpectrum<float, 31>& lhs, const RegularSpectrum<float, 31>& rhs)
+{
+    _mm256_storeu_ps(&lhs[ 0], _mm256_div_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&rhs[ 0])));
+    _mm256_storeu_ps(&lhs[ 8], _mm256_div_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&rhs[ 8])));
+    _mm256_storeu_ps(&lhs[16], _mm256_div_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&rhs[16])));
+
+    // Leave the padding sample alone: dividing it would turn it into a NaN.
+    const __m256 l24 = _mm256_loadu_ps(&lhs[24]);
+    _mm256_storeu_ps(&lhs[24], _mm256_blend_ps(_mm256_div_ps(l24, _mm256_loadu_ps(&rhs[24])), l24, 0x80));
+
+    return lhs;
+}
+
+#endif  // APPLESEED_USE_AVX
+
 template <typename T, size_t N>
 inline RegularSpectrum<T, N> rcp(const RegularSpectrum<T, N>& s)
 {
@@ -682,7 +852,25 @@ inline T min_value(const RegularSpectrum<T, N>& s)
     return value;
 }
 
-#ifdef APPLESEED_USE_SSE
+#if defined APPLESEED_USE_AVX
+
+template <>
+inline float min_value(const RegularSpectrum<float, 31>& s)
+{
+    // Replace the padding sample by a copy of the last sample.
+    const __m256 s24 = _mm256_loadu_ps(&s[24]);
+    const __m256 m1 = _mm256_min_ps(_mm256_loadu_ps(&s[ 0]), _mm256_loadu_ps(&s[ 8]));
+    const __m256 m2 = _mm256_min_ps(_mm256_loadu_ps(&s[16]), _mm256_blend_ps(s24, _mm256_permute_ps(s24, _MM_SHUFFLE(2, 2, 1, 0)), 0x80));
+    const __m256 m3 = _mm256_min_ps(m1, m2);
+
+          __m128 m  = _mm_min_ps(_mm256_castps256_ps128(m3), _mm256_extractf128_ps(m3, 1));
+    m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+
+    return _mm_cvtss_f32(m);
+}
+
+#elif defined APPLESEED_USE_SSE
 
 template <>
 inline float min_value(const RegularSpectrum<float, 31>& s)
@@ -702,7 +890,7 @@ inline float min_value(const RegularSpectrum<float, 31>& s)
     return _mm_cvtss_f32(m);
 }
 
-#endif  // APPLESEED_USE_SSE
+#endif
 
 template <typename T, size_t N>
 inline T max_value(const RegularSpectrum<T, N>& s)
@@ -718,7 +906,25 @@ inline T max_value(const RegularSpectrum<T, N>& s)
     return value;
 }
 
-#ifdef APPLESEED_USE_SSE
+#if defined APPLESEED_USE_AVX
+
+template <>
+inline float max_value(const RegularSpectrum<float, 31>& s)
+{
+    // Replace the padding sample by a copy of the last sample.
+    const __m256 s24 = _mm256_loadu_ps(&s[24]);
+    const __m256 m1 = _mm256_max_ps(_mm256_loadu_ps(&s[ 0]), _mm256_loadu_ps(&s[ 8]));
+    const __m256 m2 = _mm256_max_ps(_mm256_loadu_ps(&s[16]), _mm256_blend_ps(s24, _mm256_permute_ps(s24, _MM_SHUFFLE(2, 2, 1, 0)), 0x80));
+    const __m256 m3 = _mm256_max_ps(m1, m2);
+
+          __m128 m  = _mm_max_ps(_mm256_castps256_ps128(m3), _mm256_extractf128_ps(m3, 1));
+    m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+
+    return _mm_cvtss_f32(m);
+}
+
+#elif defined APPLESEED_USE_SSE
 
 template <>
 inline float max_value(const RegularSpectrum<float, 31>& s)
@@ -738,7 +944,7 @@ inline float max_value(const RegularSpectrum<float, 31>& s)
     return _mm_cvtss_f32(m);
 }
 
-#endif  // APPLESEED_USE_SSE
+#endif
 
 template <typename T, size_t N>
 inline size_t min_index(const RegularSpectrum<T, N>& s)
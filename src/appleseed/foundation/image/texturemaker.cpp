@@ -0,0 +1,75 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "texturemaker.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+
+// OpenImageIO headers.
+#include "foundation/platform/oiioheaderguards.h"
+BEGIN_OIIO_INCLUDES
+#include "OpenImageIO/imagebufalgo.h"
+#include "OpenImageIO/imageio.h"
+END_OIIO_INCLUDES
+
+// Standard headers.
+#include <cassert>
+
+namespace foundation
+{
+
+void make_tiled_texture(
+    const char*     input_filepath,
+    const char*     output_filepath,
+    const size_t    tile_size,
+    const bool      generate_mipmaps)
+{
+    assert(input_filepath);
+    assert(output_filepath);
+    assert(tile_size > 0);
+
+    // Pixel format and channels are left to OpenImageIO which preserves them.
+    OIIO::ImageSpec config;
+    config.tile_width = static_cast<int>(tile_size);
+    config.tile_height = static_cast<int>(tile_size);
+    config.tile_depth = 1;
+    config.attribute("compression", "zip");
+    config.attribute("maketx:nomipmap", generate_mipmaps ? 0 : 1);
+
+    if (!OIIO::ImageBufAlgo::make_texture(
+            OIIO::ImageBufAlgo::MakeTxTexture,
+            input_filepath,
+            output_filepath,
+            config))
+        throw ExceptionIOError(OIIO::geterror().c_str());
+}
+
+}   // namespace foundation
@@ -0,0 +1,336 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Interface header.
+#include "tilecachefile.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/iprogressiveimagefilereader.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
+// Standard headers.
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace boost;
+using namespace std;
+
+namespace foundation
+{
+
+//
+// TileCacheFile class implementation.
+//
+// File layout:
+//
+//   FileHeader     header
+//   TileEntry      entries[tile_count]     tiles in row-major order
+//   uint8          pixels[]                tile pixels, each tile starting at a 16-byte boundary
+//
+
+namespace
+{
+    const char Magic[8] = { 'A', 'S', 'T', 'I', 'L', 'E', 'S', '1' };
+
+    struct FileHeader
+    {
+        char    m_magic[8];
+        uint64  m_source_stamp;
+        uint64  m_canvas_width;
+        uint64  m_canvas_height;
+        uint64  m_tile_width;
+        uint64  m_tile_height;
+        uint64  m_channel_count;
+        uint64  m_pixel_format;
+    };
+
+    struct TileEntry
+    {
+        uint64  m_offset;                   // offset of the pixels from the beginning of the file
+        uint32  m_width;
+        uint32  m_height;
+    };
+
+    uint64 align_offset(const uint64 offset)
+    {
+        return (offset + 15) & ~uint64(15);
+    }
+
+    void write_bytes(ofstream& file, const void* bytes, const size_t size, const string& filepath)
+    {
+        file.write(static_cast<const char*>(bytes), static_cast<streamsize>(size));
+
+        if (!file)
+            throw ExceptionIOError("failed to write tile cache file", filepath.c_str());
+    }
+}
+
+struct TileCacheFile::Impl
+{
+    auto_ptr<interprocess::file_mapping>    m_file_mapping;
+    auto_ptr<interprocess::mapped_region>   m_mapped_region;
+    const uint8*                            m_base;
+    size_t                                  m_size;
+    const TileEntry*                        m_entries;
+    CanvasProperties                        m_props;
+};
+
+TileCacheFile::TileCacheFile()
+  : impl(new Impl())
+{
+    impl->m_base = 0;
+}
+
+TileCacheFile::~TileCacheFile()
+{
+    close();
+    delete impl;
+}
+
+void TileCacheFile::write(
+    const char*                     filepath,
+    IProgressiveImageFileReader&    reader,
+    const uint64                    source_stamp)
+{
+    assert(filepath);
+    assert(reader.is_open());
+
+    CanvasProperties props;
+    reader.read_canvas_properties(props);
+
+    const string temp_filepath = string(filepath) + ".tmp";
+
+    {
+        ofstream file(temp_filepath.c_str(), ios_base::out | ios_base::binary | ios_base::trunc);
+
+        if (!file.is_open())
+            throw ExceptionIOError("failed to create tile cache file", temp_filepath.c_str());
+
+        FileHeader header;
+        memcpy(header.m_magic, Magic, sizeof(Magic));
+        header.m_source_stamp = source_stamp;
+        header.m_canvas_width = props.m_canvas_width;
+        header.m_canvas_height = props.m_canvas_height;
+        header.m_tile_width = props.m_tile_width;
+        header.m_tile_height = props.m_tile_height;
+        header.m_channel_count = props.m_channel_count;
+        header.m_pixel_format = static_cast<uint64>(props.m_pixel_format);
+        write_bytes(file, &header, sizeof(header), temp_filepath);
+
+        // Lay out the tiles.
+        vector<TileEntry> entries(props.m_tile_count);
+        uint64 offset = align_offset(sizeof(FileHeader) + props.m_tile_count * sizeof(TileEntry));
+
+        for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+        {
+            for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+            {
+                TileEntry& entry = entries[ty * props.m_tile_count_x + tx];
+                entry.m_offset = offset;
+                entry.m_width = static_cast<uint32>(props.get_tile_width(tx));
+                entry.m_height = static_cast<uint32>(props.get_tile_height(ty));
+                offset = align_offset(offset + entry.m_width * entry.m_height * props.m_pixel_size);
+            }
+        }
+
+        if (!entries.empty())
+            write_bytes(file, &entries[0], entries.size() * sizeof(TileEntry), temp_filepath);
+
+        // Decode and write the tiles.
+        const char padding[16] = { 0 };
+        uint64 position = sizeof(FileHeader) + props.m_tile_count * sizeof(TileEntry);
+
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            const TileEntry& entry = entries[i];
+            const size_t tx = i % props.m_tile_count_x;
+            const size_t ty = i / props.m_tile_count_x;
+
+            auto_ptr<Tile> tile(reader.read_tile(tx, ty));
+
+            if (tile->get_width() != entry.m_width ||
+                tile->get_height() != entry.m_height ||
+                tile->get_channel_count() != props.m_channel_count ||
+                tile->get_pixel_format() != props.m_pixel_format)
+                throw ExceptionIOError("unexpected tile layout while writing tile cache file", temp_filepath.c_str());
+
+            write_bytes(file, padding, static_cast<size_t>(entry.m_offset - position), temp_filepath);
+            write_bytes(file, tile->get_storage(), tile->get_size(), temp_filepath);
+
+            position = entry.m_offset + tile->get_size();
+        }
+
+        file.close();
+
+        if (!file)
+            throw ExceptionIOError("failed to write tile cache file", temp_filepath.c_str());
+    }
+
+    try
+    {
+        filesystem::rename(temp_filepath, filepath);
+    }
+    catch (const filesystem::filesystem_error&)
+    {
+        throw ExceptionIOError("failed to rename tile cache file", filepath);
+    }
+}
+
+bool TileCacheFile::open(
+    const char*                     filepath,
+    const uint64                    source_stamp)
+{
+    assert(filepath);
+    assert(!is_open());
+
+    try
+    {
+        if (!filesystem::exists(filepath))
+            return false;
+
+        impl->m_file_mapping.reset(new interprocess::file_mapping(filepath, interprocess::read_only));
+        impl->m_mapped_region.reset(new interprocess::mapped_region(*impl->m_file_mapping, interprocess::read_only));
+    }
+    catch (const interprocess::interprocess_exception&)
+    {
+        close();
+        return false;
+    }
+
+    impl->m_base = static_cast<const uint8*>(impl->m_mapped_region->get_address());
+    impl->m_size = impl->m_mapped_region->get_size();
+
+    // Validate the header.
+    if (impl->m_size < sizeof(FileHeader))
+    {
+        close();
+        return false;
+    }
+
+    const FileHeader& header = *reinterpret_cast<const FileHeader*>(impl->m_base);
+
+    if (memcmp(header.m_magic, Magic, sizeof(Magic)) != 0 ||
+        header.m_source_stamp != source_stamp ||
+        header.m_pixel_format > static_cast<uint64>(PixelFormatDouble))
+    {
+        close();
+        return false;
+    }
+
+    impl->m_props =
+        CanvasProperties(
+            static_cast<size_t>(header.m_canvas_width),
+            static_cast<size_t>(header.m_canvas_height),
+            static_cast<size_t>(header.m_tile_width),
+            static_cast<size_t>(header.m_tile_height),
+            static_cast<size_t>(header.m_channel_count),
+            static_cast<PixelFormat>(header.m_pixel_format));
+
+    // Validate the tile entries.
+    impl->m_entries = reinterpret_cast<const TileEntry*>(impl->m_base + sizeof(FileHeader));
+
+    if (impl->m_size < sizeof(FileHeader) + impl->m_props.m_tile_count * sizeof(TileEntry))
+    {
+        close();
+        return false;
+    }
+
+    for (size_t i = 0; i < impl->m_props.m_tile_count; ++i)
+    {
+        const TileEntry& entry = impl->m_entries[i];
+        const uint64 size = uint64(entry.m_width) * entry.m_height * impl->m_props.m_pixel_size;
+
+        if (entry.m_offset + size > impl->m_size)
+        {
+            close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void TileCacheFile::close()
+{
+    impl->m_mapped_region.reset();
+    impl->m_file_mapping.reset();
+    impl->m_base = 0;
+}
+
+bool TileCacheFile::is_open() const
+{
+    return impl->m_base != 0;
+}
+
+const CanvasProperties& TileCacheFile::properties() const
+{
+    assert(is_open());
+    return impl->m_props;
+}
+
+Tile* TileCacheFile::read_tile(
+    const size_t                    tile_x,
+    const size_t                    tile_y,
+    const bool                      copy) const
+{
+    assert(is_open());
+    assert(tile_x < impl->m_props.m_tile_count_x);
+    assert(tile_y < impl->m_props.m_tile_count_y);
+
+    const TileEntry& entry = impl->m_entries[tile_y * impl->m_props.m_tile_count_x + tile_x];
+    uint8* pixels = const_cast<uint8*>(impl->m_base + entry.m_offset);
+
+    Tile* tile =
+        new Tile(
+            entry.m_width,
+            entry.m_height,
+            impl->m_props.m_channel_count,
+            impl->m_props.m_pixel_format,
+            copy ? 0 : pixels);
+
+    if (copy)
+        memcpy(tile->get_storage(), pixels, tile->get_size());
+
+    return tile;
+}
+
+}   // namespace foundation
@@ -0,0 +1,110 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef APPLESEED_FOUNDATION_IMAGE_TILECACHEFILE_H
+#define APPLESEED_FOUNDATION_IMAGE_TILECACHEFILE_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class CanvasProperties; }
+namespace foundation    { class IProgressiveImageFileReader; }
+namespace foundation    { class Tile; }
+
+namespace foundation
+{
+
+//
+// A file holding the decoded tiles of an image in the native layout of foundation::Tile,
+// accessed through a read-only memory mapping. Reading a tile does not involve any
+// decoding, and the operating system's page cache decides which tiles stay in memory.
+//
+// A stamp identifying the version of the source image is stored in the file, such
+// that stale tile cache files can be detected and rebuilt.
+//
+
+class APPLESEED_DLLSYMBOL TileCacheFile
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    TileCacheFile();
+
+    // Destructor.
+    ~TileCacheFile();
+
+    // Write all the tiles of the image file open in 'reader' to a tile cache file.
+    // The file is written under a temporary name then renamed, such that concurrent
+    // readers never see a partially written file. Throws foundation::ExceptionIOError.
+    static void write(
+        const char*                     filepath,
+        IProgressiveImageFileReader&    reader,
+        const uint64                    source_stamp);
+
+    // Open a tile cache file. Return false if the file doesn't exist, is not a valid
+    // tile cache file or was not built from the version of the source image identified
+    // by 'source_stamp'.
+    bool open(
+        const char*                     filepath,
+        const uint64                    source_stamp);
+
+    // Close the tile cache file.
+    void close();
+
+    // Return true if a tile cache file is currently open.
+    bool is_open() const;
+
+    // Access the canvas properties of the image.
+    const CanvasProperties& properties() const;
+
+    // Return a newly allocated tile whose pixels are stored in the memory mapping.
+    // The pixels of the tile must not be modified, and the tile must be deleted
+    // before the tile cache file is closed. If 'copy' is true, the pixels are copied
+    // instead and the tile can be freely modified.
+    Tile* read_tile(
+        const size_t                    tile_x,
+        const size_t                    tile_y,
+        const bool                      copy = false) const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_IMAGE_TILECACHEFILE_H
@@ -0,0 +1,272 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_FOUNDATION_MATH_ALIASTABLE_H
+#define APPLESEED_FOUNDATION_MATH_ALIASTABLE_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// Alias table for sampling discrete distributions in constant time.
+//
+// This class has the same interface as foundation::CDF and can be used in its place.
+// Sampling costs one table lookup instead of a binary search, but unlike CDF sampling,
+// the mapping from the random number to the item is not monotonic.
+//
+// References:
+//
+//   http://www.keithschwarz.com/darts-dice-coins/
+//
+//   Michael D. Vose, A Linear Algorithm For Generating Random Numbers
+//   With a Given Distribution, IEEE Transactions on Software Engineering, 1991.
+//
+
+template <typename Item, typename Weight>
+class AliasTable
+  : public NonCopyable
+{
+  public:
+    typedef std::pair<Item, Weight> ItemWeightPair;
+
+    // Constructor.
+    AliasTable();
+
+    // Return true if the table is empty.
+    bool empty() const;
+
+    // Return true if the table has at least one item with a positive weight.
+    bool valid() const;
+
+    // Return the sum of the weight of all inserted items.
+    Weight weight() const;
+
+    // Remove all items from the table.
+    void clear();
+
+    // Allocate memory for a given number of items.
+    void reserve(const size_t count);
+
+    // Insert an item with a given non-negative weight.
+    void insert(const Item& item, const Weight weight);
+
+    // Access the i'th item.
+    const ItemWeightPair& operator[](const size_t i) const;
+
+    // Prepare the table for sampling.
+    // This method must be called once and only once before sample() is called.
+    void prepare();
+
+    // Sample the table. x is in [0,1).
+    const ItemWeightPair& sample(const Weight x) const;
+
+  private:
+    struct Entry
+    {
+        Weight          m_threshold;    // probability of keeping the item of this bucket
+        uint32          m_alias;        // index of the item returned otherwise
+    };
+
+    typedef std::vector<ItemWeightPair> ItemVector;
+    typedef std::vector<Entry> EntryVector;
+
+    ItemVector          m_items;
+    Weight              m_weight_sum;
+    EntryVector         m_entries;
+};
+
+
+//
+// AliasTable class implementation.
+//
+
+template <typename Item, typename Weight>
+inline AliasTable<Item, Weight>::AliasTable()
+  : m_weight_sum(0.0)
+{
+}
+
+template <typename Item, typename Weight>
+inline bool AliasTable<Item, Weight>::empty() const
+{
+    return m_items.empty();
+}
+
+template <typename Item, typename Weight>
+inline bool AliasTable<Item, Weight>::valid() const
+{
+    return m_weight_sum > Weight(0.0);
+}
+
+template <typename Item, typename Weight>
+inline Weight AliasTable<Item, Weight>::weight() const
+{
+    return m_weight_sum;
+}
+
+template <typename Item, typename Weight>
+inline void AliasTable<Item, Weight>::clear()
+{
+    m_items.clear();
+    m_weight_sum = Weight(0.0);
+    m_entries.clear();
+}
+
+template <typename Item, typename Weight>
+inline void AliasTable<Item, Weight>::reserve(const size_t count)
+{
+    m_items.reserve(count);
+}
+
+template <typename Item, typename Weight>
+inline void AliasTable<Item, Weight>::insert(const Item& item, const Weight weight)
+{
+    assert(weight >= Weight(0.0));
+    m_items.push_back(std::make_pair(item, weight));
+    m_weight_sum += weight;
+}
+
+template <typename Item, typename Weight>
+inline const std::pair<Item, Weight>& AliasTable<Item, Weight>::operator[](const size_t i) const
+{
+    assert(i < m_items.size());
+    return m_items[i];
+}
+
+template <typename Item, typename Weight>
+void AliasTable<Item, Weight>::prepare()
+{
+    assert(valid());
+
+    const size_t item_count = m_items.size();
+    assert(item_count <= ~uint32(0));
+
+    // Normalize weights so that they add up to 1.0.
+    const Weight rcp_weight_sum = Weight(1.0) / m_weight_sum;
+    for (size_t i = 0; i < item_count; ++i)
+        m_items[i].second *= rcp_weight_sum;
+
+    // Split the items into buckets that are under-full and over-full with respect to
+    // the average weight 1/n. Scaled weights are accumulated in double precision to
+    // keep the round-off errors small with millions of items.
+    std::vector<double> scaled_weights(item_count);
+    std::vector<uint32> underfull;
+    std::vector<uint32> overfull;
+    underfull.reserve(item_count);
+    overfull.reserve(item_count);
+
+    for (size_t i = 0; i < item_count; ++i)
+    {
+        scaled_weights[i] = static_cast<double>(m_items[i].second) * item_count;
+
+        if (scaled_weights[i] < 1.0)
+            underfull.push_back(static_cast<uint32>(i));
+        else
+            overfull.push_back(static_cast<uint32>(i));
+    }
+
+    m_entries.resize(item_count);
+
+    // Fill each under-full bucket with the excess of an over-full one.
+    while (!underfull.empty() && !overfull.empty())
+    {
+        const uint32 s = underfull.back();
+        underfull.pop_back();
+
+        const uint32 l = overfull.back();
+
+        m_entries[s].m_threshold = static_cast<Weight>(scaled_weights[s]);
+        m_entries[s].m_alias = l;
+
+        scaled_weights[l] -= 1.0 - scaled_weights[s];
+
+        if (scaled_weights[l] < 1.0)
+        {
+            overfull.pop_back();
+            underfull.push_back(l);
+        }
+    }
+
+    // The remaining buckets are full up to numerical errors, except for the buckets of items
+    // with a zero weight left over by these errors: they must alias an item with a positive weight.
+    size_t positive_item = 0;
+    while (m_items[positive_item].second == Weight(0.0))
+        ++positive_item;
+
+    underfull.insert(underfull.end(), overfull.begin(), overfull.end());
+
+    for (size_t i = 0; i < underfull.size(); ++i)
+    {
+        const uint32 s = underfull[i];
+
+        if (m_items[s].second > Weight(0.0))
+        {
+            m_entries[s].m_threshold = Weight(1.0);
+            m_entries[s].m_alias = s;
+        }
+        else
+        {
+            m_entries[s].m_threshold = Weight(0.0);
+            m_entries[s].m_alias = static_cast<uint32>(positive_item);
+        }
+    }
+}
+
+template <typename Item, typename Weight>
+inline const std::pair<Item, Weight>& AliasTable<Item, Weight>::sample(const Weight x) const
+{
+    assert(!m_entries.empty());
+    assert(x >= Weight(0.0));
+    assert(x < Weight(1.0));
+
+    const size_t item_count = m_entries.size();
+
+    // Select a bucket and reuse the fractional part of x to choose between its two items.
+    const double u = static_cast<double>(x) * item_count;
+    size_t i = static_cast<size_t>(u);
+    if (i >= item_count)
+        i = item_count - 1;
+
+    const Entry& entry = m_entries[i];
+    const Weight v = static_cast<Weight>(u - i);
+
+    return m_items[v < entry.m_threshold ? i : entry.m_alias];
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_ALIASTABLE_H
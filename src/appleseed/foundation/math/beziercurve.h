@@ -37,6 +37,10 @@
 #include "foundation/math/ray.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
 
 // Standard headers.
 #include <algorithm>
@@ -234,6 +238,21 @@ class BezierCurveIntersector
         const ValueType         epsilon = ValueType(0.05),
         const size_t            max_depth = 5);
 
+    // Same as above, for curves already transformed by the projection transform of the ray.
+    static bool intersect_projected(
+        const BezierCurveType&  xfm_curve,
+        const RayType&          ray,
+        ValueType&              u,
+        ValueType&              v,
+        ValueType&              t,
+        const ValueType         epsilon = ValueType(0.05),
+        const size_t            max_depth = 5);
+    static bool intersect_projected(
+        const BezierCurveType&  xfm_curve,
+        const RayType&          ray,
+        const ValueType         epsilon = ValueType(0.05),
+        const size_t            max_depth = 5);
+
   private:
     // Dot product function that only considers the x and y components of the vectors.
     static ValueType dotxy(const VectorType& lhs, const VectorType& rhs)
@@ -254,6 +273,248 @@ class BezierCurveIntersector
 };
 
 
+//
+// Bezier curve batch intersector.
+//
+// Intersects a ray with a batch of curves. The curves are transformed to the
+// projection space of the ray and tested against the ray's footprint several
+// at a time using SIMD instructions; only the curves that pass this test are
+// intersected by recursive subdivision, one at a time.
+//
+
+#ifdef APPLESEED_USE_AVX
+const size_t BezierCurveBatchSize = 8;
+#else
+const size_t BezierCurveBatchSize = 4;
+#endif
+
+template <typename BezierCurveType>
+class BezierCurveBatchIntersector
+{
+  public:
+    typedef typename BezierCurveType::ValueType ValueType;
+    typedef typename BezierCurveType::VectorType VectorType;
+    typedef typename BezierCurveType::MatrixType MatrixType;
+    typedef BezierCurveIntersector<BezierCurveType> IntersectorType;
+    typedef typename IntersectorType::RayType RayType;
+
+    // Number of curves tested at once.
+    static const size_t BatchSize = BezierCurveBatchSize;
+
+    // Compute the closest intersection between a ray and at most BatchSize curves.
+    // Return the index of the curve that was hit, or ~0 if no curve was hit.
+    static size_t intersect(
+        const BezierCurveType   curves[],
+        const size_t            curve_count,
+        const RayType&          ray,
+        const MatrixType&       xfm,
+        ValueType&              u,
+        ValueType&              v,
+        ValueType&              t,
+        const ValueType         epsilon = ValueType(0.05),
+        const size_t            max_depth = 5);
+
+    // Return whether a ray intersects any of at most BatchSize curves.
+    static bool intersect(
+        const BezierCurveType   curves[],
+        const size_t            curve_count,
+        const RayType&          ray,
+        const MatrixType&       xfm,
+        const ValueType         epsilon = ValueType(0.05),
+        const size_t            max_depth = 5);
+
+  private:
+    static const size_t PointCount = BezierCurveType::Degree + 1;
+
+    // Control points of a batch of curves in structure-of-arrays form.
+    struct Batch
+    {
+        APPLESEED_ALIGN(32) ValueType m_x[PointCount][BatchSize];
+        APPLESEED_ALIGN(32) ValueType m_y[PointCount][BatchSize];
+        APPLESEED_ALIGN(32) ValueType m_z[PointCount][BatchSize];
+        APPLESEED_ALIGN(32) ValueType m_half_max_width[BatchSize];
+    };
+
+    // Transform a batch of curves to the projection space of a ray and return
+    // a bit mask of the curves whose bounding box overlaps the ray's footprint.
+    static size_t project(
+        const BezierCurveType   curves[],
+        const size_t            curve_count,
+        const MatrixType&       xfm,
+        const ValueType         scaled_t,
+        Batch&                  batch);
+
+    // Build a projected curve from a batch.
+    static BezierCurveType make_projected_curve(
+        const BezierCurveType&  curve,
+        const Batch&            batch,
+        const size_t            index);
+};
+
+
+//
+// Transform of the control points of a batch of curves and footprint test,
+// with SIMD implementations for single precision curves.
+//
+
+namespace bezier_impl
+{
+    template <size_t PointCount, size_t BatchSize, typename T>
+    size_t project_batch(
+        const Matrix<T, 4, 4>&  m,
+        const T                 scaled_t,
+        T                       x[PointCount][BatchSize],
+        T                       y[PointCount][BatchSize],
+        T                       z[PointCount][BatchSize],
+        const T                 half_max_width[BatchSize])
+    {
+        size_t mask = 0;
+
+        for (size_t i = 0; i < BatchSize; ++i)
+        {
+            T min_x = std::numeric_limits<T>::max(), max_x = -std::numeric_limits<T>::max();
+            T min_y = std::numeric_limits<T>::max(), max_y = -std::numeric_limits<T>::max();
+            T min_z = std::numeric_limits<T>::max(), max_z = -std::numeric_limits<T>::max();
+
+            for (size_t k = 0; k < PointCount; ++k)
+            {
+                const T px = x[k][i], py = y[k][i], pz = z[k][i];
+                x[k][i] = m[ 0] * px + m[ 1] * py + m[ 2] * pz + m[ 3];
+                y[k][i] = m[ 4] * px + m[ 5] * py + m[ 6] * pz + m[ 7];
+                z[k][i] = m[ 8] * px + m[ 9] * py + m[10] * pz + m[11];
+                min_x = std::min(min_x, x[k][i]); max_x = std::max(max_x, x[k][i]);
+                min_y = std::min(min_y, y[k][i]); max_y = std::max(max_y, y[k][i]);
+                min_z = std::min(min_z, z[k][i]); max_z = std::max(max_z, z[k][i]);
+            }
+
+            const T hw = half_max_width[i];
+            if (!(min_z > scaled_t || max_z < T(1.0e-6) ||
+                  min_x > hw || max_x < -hw ||
+                  min_y > hw || max_y < -hw))
+                mask |= size_t(1) << i;
+        }
+
+        return mask;
+    }
+
+#ifdef APPLESEED_USE_SSE
+
+    template <size_t PointCount, size_t BatchSize>
+    size_t project_batch_sse(
+        const Matrix<float, 4, 4>&  m,
+        const float                 scaled_t,
+        float                       x[PointCount][BatchSize],
+        float                       y[PointCount][BatchSize],
+        float                       z[PointCount][BatchSize],
+        const float                 half_max_width[BatchSize])
+    {
+#ifdef APPLESEED_USE_AVX
+        typedef __m256 Reg;
+        const size_t Width = 8;
+        #define BEZIER_SIMD(op) _mm256_##op
+#else
+        typedef __m128 Reg;
+        const size_t Width = 4;
+        #define BEZIER_SIMD(op) _mm_##op
+#endif
+
+        size_t mask = 0;
+
+        for (size_t i = 0; i < BatchSize; i += Width)
+        {
+            Reg min_x = BEZIER_SIMD(set1_ps)(std::numeric_limits<float>::max());
+            Reg min_y = min_x, min_z = min_x;
+            Reg max_x = BEZIER_SIMD(set1_ps)(-std::numeric_limits<float>::max());
+            Reg max_y = max_x, max_z = max_x;
+
+            for (size_t k = 0; k < PointCount; ++k)
+            {
+                const Reg px = BEZIER_SIMD(load_ps)(x[k] + i);
+                const Reg py = BEZIER_SIMD(load_ps)(y[k] + i);
+                const Reg pz = BEZIER_SIMD(load_ps)(z[k] + i);
+
+                // Same evaluation order as the scalar transform: ((m0 * x + m1 * y) + m2 * z) + m3.
+#define BEZIER_TRANSFORM(r)                                                                     \
+                BEZIER_SIMD(add_ps)(                                                            \
+                    BEZIER_SIMD(add_ps)(                                                        \
+                        BEZIER_SIMD(add_ps)(                                                    \
+                            BEZIER_SIMD(mul_ps)(BEZIER_SIMD(set1_ps)(m[r * 4 + 0]), px),        \
+                            BEZIER_SIMD(mul_ps)(BEZIER_SIMD(set1_ps)(m[r * 4 + 1]), py)),       \
+                        BEZIER_SIMD(mul_ps)(BEZIER_SIMD(set1_ps)(m[r * 4 + 2]), pz)),           \
+                    BEZIER_SIMD(set1_ps)(m[r * 4 + 3]))
+
+                const Reg tx = BEZIER_TRANSFORM(0);
+                const Reg ty = BEZIER_TRANSFORM(1);
+                const Reg tz = BEZIER_TRANSFORM(2);
+
+#undef BEZIER_TRANSFORM
+
+                BEZIER_SIMD(store_ps)(x[k] + i, tx);
+                BEZIER_SIMD(store_ps)(y[k] + i, ty);
+                BEZIER_SIMD(store_ps)(z[k] + i, tz);
+
+                min_x = BEZIER_SIMD(min_ps)(min_x, tx); max_x = BEZIER_SIMD(max_ps)(max_x, tx);
+                min_y = BEZIER_SIMD(min_ps)(min_y, ty); max_y = BEZIER_SIMD(max_ps)(max_y, ty);
+                min_z = BEZIER_SIMD(min_ps)(min_z, tz); max_z = BEZIER_SIMD(max_ps)(max_z, tz);
+            }
+
+            const Reg hw = BEZIER_SIMD(load_ps)(half_max_width + i);
+            const Reg neg_hw = BEZIER_SIMD(sub_ps)(BEZIER_SIMD(setzero_ps)(), hw);
+
+            // Lanes that pass the test:
+            // min_z <= t && max_z >= 1e-6 && min_x <= hw && max_x >= -hw && min_y <= hw && max_y >= -hw.
+#ifdef APPLESEED_USE_AVX
+            const Reg overlap =
+                _mm256_and_ps(
+                    _mm256_and_ps(
+                        _mm256_and_ps(
+                            _mm256_cmp_ps(min_z, _mm256_set1_ps(scaled_t), _CMP_LE_OQ),
+                            _mm256_cmp_ps(max_z, _mm256_set1_ps(1.0e-6f), _CMP_GE_OQ)),
+                        _mm256_and_ps(
+                            _mm256_cmp_ps(min_x, hw, _CMP_LE_OQ),
+                            _mm256_cmp_ps(max_x, neg_hw, _CMP_GE_OQ))),
+                    _mm256_and_ps(
+                        _mm256_cmp_ps(min_y, hw, _CMP_LE_OQ),
+                        _mm256_cmp_ps(max_y, neg_hw, _CMP_GE_OQ)));
+            mask |= static_cast<size_t>(_mm256_movemask_ps(overlap)) << i;
+#else
+            const Reg overlap =
+                _mm_and_ps(
+                    _mm_and_ps(
+                        _mm_and_ps(
+                            _mm_cmple_ps(min_z, _mm_set1_ps(scaled_t)),
+                            _mm_cmpge_ps(max_z, _mm_set1_ps(1.0e-6f))),
+                        _mm_and_ps(
+                            _mm_cmple_ps(min_x, hw),
+                            _mm_cmpge_ps(max_x, neg_hw))),
+                    _mm_and_ps(
+                        _mm_cmple_ps(min_y, hw),
+                        _mm_cmpge_ps(max_y, neg_hw)));
+            mask |= static_cast<size_t>(_mm_movemask_ps(overlap)) << i;
+#endif
+        }
+
+#undef BEZIER_SIMD
+
+        return mask;
+    }
+
+    template <size_t PointCount, size_t BatchSize>
+    inline size_t project_batch(
+        const Matrix<float, 4, 4>&  m,
+        const float                 scaled_t,
+        float                       x[PointCount][BatchSize],
+        float                       y[PointCount][BatchSize],
+        float                       z[PointCount][BatchSize],
+        const float                 half_max_width[BatchSize])
+    {
+        return project_batch_sse<PointCount, BatchSize>(m, scaled_t, x, y, z, half_max_width);
+    }
+
+#endif  // APPLESEED_USE_SSE
+}
+
+
 //
 // BezierCurveBase class implementation.
 //
@@ -764,7 +1025,7 @@ void make_curve_projection_transform(
 //
 
 template <typename BezierCurveType>
-bool BezierCurveIntersector<BezierCurveType>::intersect(
+inline bool BezierCurveIntersector<BezierCurveType>::intersect(
     const BezierCurveType&  curve,
     const RayType&          ray,
     const MatrixType&       xfm,
@@ -775,6 +1036,31 @@ bool BezierCurveIntersector<BezierCurveType>::intersect(
     const size_t            max_depth)
 {
     const BezierCurveType xfm_curve(curve, xfm);
+    return intersect_projected(xfm_curve, ray, u, v, t, epsilon, max_depth);
+}
+
+template <typename BezierCurveType>
+inline bool BezierCurveIntersector<BezierCurveType>::intersect(
+    const BezierCurveType&  curve,
+    const RayType&          ray,
+    const MatrixType&       xfm,
+    const ValueType         epsilon,
+    const size_t            max_depth)
+{
+    const BezierCurveType xfm_curve(curve, xfm);
+    return intersect_projected(xfm_curve, ray, epsilon, max_depth);
+}
+
+template <typename BezierCurveType>
+bool BezierCurveIntersector<BezierCurveType>::intersect_projected(
+    const BezierCurveType&  xfm_curve,
+    const RayType&          ray,
+    ValueType&              u,
+    ValueType&              v,
+    ValueType&              t,
+    const ValueType         epsilon,
+    const size_t            max_depth)
+{
     const ValueType max_width = xfm_curve.compute_max_width();
     const size_t depth = xfm_curve.compute_recursion_depth(max_width * epsilon);
 
@@ -798,14 +1084,12 @@ bool BezierCurveIntersector<BezierCurveType>::intersect(
 }
 
 template <typename BezierCurveType>
-bool BezierCurveIntersector<BezierCurveType>::intersect(
-    const BezierCurveType&  curve,
+bool BezierCurveIntersector<BezierCurveType>::intersect_projected(
+    const BezierCurveType&  xfm_curve,
     const RayType&          ray,
-    const MatrixType&       xfm,
     const ValueType         epsilon,
     const size_t            max_depth)
 {
-    const BezierCurveType xfm_curve(curve, xfm);
     const ValueType max_width = xfm_curve.compute_max_width();
     const size_t depth = xfm_curve.compute_recursion_depth(max_width * epsilon);
 
@@ -922,6 +1206,123 @@ bool BezierCurveIntersector<BezierCurveType>::converge(
     }
 }
 
+
+
+//
+// BezierCurveBatchIntersector class implementation.
+//
+
+template <typename BezierCurveType>
+size_t BezierCurveBatchIntersector<BezierCurveType>::project(
+    const BezierCurveType   curves[],
+    const size_t            curve_count,
+    const MatrixType&       xfm,
+    const ValueType         scaled_t,
+    Batch&                  batch)
+{
+    assert(curve_count > 0);
+    assert(curve_count <= BatchSize);
+
+    // Gather the control points of the curves. Unused lanes get a negative width and always fail the footprint test.
+    for (size_t i = 0; i < BatchSize; ++i)
+    {
+        for (size_t k = 0; k < PointCount; ++k)
+        {
+            const VectorType& p = curves[i < curve_count ? i : 0].get_control_point(k);
+            batch.m_x[k][i] = p.x;
+            batch.m_y[k][i] = p.y;
+            batch.m_z[k][i] = p.z;
+        }
+
+        batch.m_half_max_width[i] =
+            i < curve_count
+                ? ValueType(0.5) * curves[i].compute_max_width()
+                : -std::numeric_limits<ValueType>::max();
+    }
+
+    return
+        bezier_impl::project_batch<PointCount, BatchSize>(
+            xfm,
+            scaled_t,
+            batch.m_x,
+            batch.m_y,
+            batch.m_z,
+            batch.m_half_max_width);
+}
+
+template <typename BezierCurveType>
+inline BezierCurveType BezierCurveBatchIntersector<BezierCurveType>::make_projected_curve(
+    const BezierCurveType&  curve,
+    const Batch&            batch,
+    const size_t            index)
+{
+    VectorType ctrl_pts[PointCount];
+    ValueType width[PointCount];
+
+    for (size_t k = 0; k < PointCount; ++k)
+    {
+        ctrl_pts[k] = VectorType(batch.m_x[k][index], batch.m_y[k][index], batch.m_z[k][index]);
+        width[k] = curve.get_width(k);
+    }
+
+    return BezierCurveType(ctrl_pts, width);
+}
+
+template <typename BezierCurveType>
+size_t BezierCurveBatchIntersector<BezierCurveType>::intersect(
+    const BezierCurveType   curves[],
+    const size_t            curve_count,
+    const RayType&          ray,
+    const MatrixType&       xfm,
+    ValueType&              u,
+    ValueType&              v,
+    ValueType&              t,
+    const ValueType         epsilon,
+    const size_t            max_depth)
+{
+    Batch batch;
+    size_t mask = project(curves, curve_count, xfm, t * norm(ray.m_dir), batch);
+
+    size_t hit_index = ~size_t(0);
+
+    for (size_t i = 0; mask != 0; ++i, mask >>= 1)
+    {
+        if (mask & 1)
+        {
+            const BezierCurveType xfm_curve = make_projected_curve(curves[i], batch, i);
+            if (IntersectorType::intersect_projected(xfm_curve, ray, u, v, t, epsilon, max_depth))
+                hit_index = i;
+        }
+    }
+
+    return hit_index;
+}
+
+template <typename BezierCurveType>
+bool BezierCurveBatchIntersector<BezierCurveType>::intersect(
+    const BezierCurveType   curves[],
+    const size_t            curve_count,
+    const RayType&          ray,
+    const MatrixType&       xfm,
+    const ValueType         epsilon,
+    const size_t            max_depth)
+{
+    Batch batch;
+    size_t mask = project(curves, curve_count, xfm, ray.m_tmax * norm(ray.m_dir), batch);
+
+    for (size_t i = 0; mask != 0; ++i, mask >>= 1)
+    {
+        if (mask & 1)
+        {
+            const BezierCurveType xfm_curve = make_projected_curve(curves[i], batch, i);
+            if (IntersectorType::intersect_projected(xfm_curve, ray, epsilon, max_depth))
+                return true;
+        }
+    }
+
+    return false;
+}
+
 }       // namespace foundation
 
 #endif  // !APPLESEED_FOUNDATION_MATH_BEZIERCURVE_H
@@ -0,0 +1,296 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "bluenoise.h"
+
+namespace foundation
+{
+
+const uint16 BlueNoiseMask[BlueNoiseMaskSize * BlueNoiseMaskSize] =
+{
+    1616,  279, 2712,  757, 2025, 3679, 3460, 1776, 4087,  870, 3143, 1687, 3406,  375, 1534, 3318,
+     522, 1865, 3955, 1157, 3130,  983, 3899, 2256, 3515, 1576, 3792,  863, 1454,  339,  719, 3871,
+    2739,  409, 1473, 4036,  791, 2408, 3616,  556, 3361,  311, 2533, 1047,  136, 2622,  781, 2105,
+    1702, 2427, 1131, 1484, 3969, 3162, 2289, 1198, 3046, 2389,   57, 2625,  606, 3798, 3312,  858,
+    2062, 3744, 2481, 3222, 1656, 1014,  642, 2703,  267, 1967, 3622,   81, 2558,  787, 2016, 2647,
+    3682, 2229,  759, 2554, 3410,   92, 2799, 1311, 3223, 1093, 2487, 2880, 3580, 2232, 1767, 1556,
+    3370,  579, 2924, 1939, 3063,   67, 2650, 2872, 1213, 4094, 3025, 2143, 1590, 2898, 3178, 1440,
+     981, 3666, 2977,  291, 2546, 1857,  236, 3499,  717,  458, 3617, 1956,  971, 2231, 1811, 2938,
+    3497, 1068,  108, 4028,  481, 3111, 2180, 1457, 3372, 1242, 2309, 1058, 2160, 3762, 1231, 3190,
+     261, 1410, 3016,  414, 1601, 2401, 1904,  312, 2956, 1775,  590, 2060, 1176,  152, 3740,  950,
+    2084, 1282, 2531, 1075, 1737, 3767, 1528,  953, 2347, 1822, 3243,  495, 3862, 1929,  363, 4040,
+    3426,  475, 1988, 3772,  922, 1301, 2932, 2719, 2070, 3259, 1636, 1307, 3167,  271, 1394,  690,
+     389, 3029, 1505, 1868, 2379, 2843,   55, 3782, 2484, 3005,  666, 3975, 2793, 1797,  162, 2896,
+    1010, 1760, 3787, 2055, 1267, 4020, 3568,  733, 2166, 3379,  268, 4085, 3196, 2577, 2936, 3260,
+      79, 3947, 3521,  233, 3334,  660, 2179,  382, 3660,   97, 1342,  868, 3490, 1183, 2468,   13,
+    2687,  744, 2336, 3273, 1660,  621, 4027, 1498, 1051, 3891,  809, 2915, 3706, 2370, 3966, 2588,
+    1214, 2208, 3319,  879, 1335, 3588, 1139,  790, 1748,  320, 1594, 3267,  462, 3527, 1482, 3895,
+    2492,  623, 3476, 2840,  835, 3084,  490, 1504, 3849,  992, 2734, 1640,  776, 1375,  472, 2398,
+    1836, 2270,  827, 2773, 2052, 1325, 3990, 2968, 3392, 1662, 2614, 2242, 2772,  657, 1792, 2195,
+    3090, 1569, 1249,  153, 2660, 3605, 1950,   83, 2496,  332, 2170, 2688,   99,  568, 1593, 2827,
+    1921, 3718,  538, 3847,  240, 1960, 2578, 4006, 3191, 2085, 2659, 1356,  930, 2411,  721, 2117,
+    3344,   18, 2328, 1079,  190, 2662, 2271, 1182, 2547,   78, 3534, 2346, 1976, 3878, 1084, 3659,
+     691, 3129, 1596, 3809,  454, 3184, 2469, 1115,  748, 2009, 3954,  244, 3685, 3292, 1377, 3775,
+    1055, 3505, 3945, 2124, 3031,  418, 2260, 3201, 3742, 1738, 3438, 1152, 1844, 3356,  988, 3571,
+     770, 2498, 1710, 2657, 2940, 3399, 1524,  510,  998, 3546,  186, 3814, 2966, 1952,  343, 3092,
+    1635, 1324, 3959, 1970, 3647, 1696, 3315, 3723, 1813, 3004, 1285,  569, 3083,  195, 1703, 2846,
+    1450,  294, 1199, 2617,  970, 1825,  161, 1585, 2757,  511, 3077, 1039, 1527,  434, 2965,  828,
+     232, 2792, 1768,  672,  990, 3421, 1188,  831, 1379, 3049,  652, 4095, 2532, 2083, 3098,  348,
+    1472,   28, 3192, 1037,  706, 2191,  342, 2338, 2862, 1863,  626, 2225, 3446, 1099, 4074, 2621,
+     844, 2770,  465, 3176, 1420,  333,  638,  899, 2033,  415, 3952, 1525, 3345, 2678, 2126, 3473,
+    2515, 4019, 1951, 3643, 2230, 2921, 3532, 3846, 2300, 1262, 3599, 1854, 2406, 2097, 4014, 2565,
+    1966,  496, 2397, 1402, 3781, 2516, 1831, 2838,  478, 2360, 1543,  256,  853, 1353, 3863, 2297,
+    2996, 4047, 2002, 1287, 3926, 1667, 3115, 3702, 1397, 3910, 1226, 2551, 1550,  106, 1753, 3550,
+    1185, 3739, 1830, 2557, 2168, 2881, 4059, 2413, 3207, 2837,  816, 2244, 1012, 3746,  377,  886,
+     591, 2984,   53, 3339,  565, 1439,  325,  902, 3279,   42, 2545,  720, 3210,  125, 1676, 1127,
+    3332, 3681, 3151,   64, 2927, 1572,  241, 3933, 3555, 1922, 2740, 3673, 3209, 1716,  174, 2704,
+     894, 3432,  405, 2393, 3554,  140, 1151,  843, 2684,   32, 3371,  811, 3171, 2854,  582, 2197,
+     220, 3272,  699,  979,   71, 3456, 1102, 1378,  151, 1605, 3676, 2597,   19, 1238, 1911, 3194,
+    1351, 2311, 1063, 1699,  785, 3981, 2672, 2086, 1729, 2933, 1466, 3928,  949, 3442, 2884,  610,
+    1515, 2185, 1221, 4065, 2006,  761, 3268, 2612,  940,    4, 1086, 2204, 2886,  514, 3604, 1175,
+    2173, 1599, 2857,  580, 2735, 1905, 3317, 2125, 3009, 1739, 2378,  443, 2072, 3771, 1390, 2467,
+    2952, 1536, 2337, 3927, 3028, 1641, 1937, 2700, 3544, 2104,  608, 1766, 2991, 4053, 2441, 1624,
+    3870, 3597, 2056, 2820, 3165, 2425, 1162, 3470,  637, 3779, 2186,  265, 2730, 1323, 2296, 3566,
+     283, 2638,  927,  403, 3478, 2243,  536, 1313, 2090, 3094, 3977, 1277,  732, 3380, 2430, 1862,
+     667, 3802, 3225, 1431,  926, 3752, 2510,  641,  309, 1478, 4015, 1080, 3582, 1845,  974, 3982,
+     431, 1961, 3388, 1295,  524, 3728,  740,  374, 3890,  957, 3291, 1360, 3504,  506, 2858,  741,
+     135, 2661,  352, 1518, 3725,  178, 1896, 1381,  438, 1029, 3163, 1982,  528, 3754, 1780,  851,
+    3915, 1900, 3066, 1707, 2474, 1059, 2868, 3729, 1600, 3428,  401, 2559, 2018, 1529, 3909,  264,
+    2585, 1092,  112, 2100, 1732,  228, 1315, 3866, 3533, 2012, 3100, 2586,  252, 2732,  737, 3439,
+    1147, 2649,  144, 1772, 2767, 2470, 2207, 3119, 1189, 2536, 2334,  308, 2008, 1053, 2214, 3330,
+    1829, 1215, 3449,  518,  964, 2192, 3020, 3937, 2836, 2448, 3591, 1597, 1181, 3038, 2518,   25,
+    3238, 2829,  665, 3636, 1434, 3868, 1815,  183, 2385,  632, 1781, 3776,  138, 1007, 2814, 3140,
+    1762, 3638, 2302, 4012, 3447, 2909, 2333, 1050, 2779,  822,  537, 1281, 1604, 3253,  116, 2098,
+    3088, 3810,  864, 3579, 1048,  197, 3355, 1501, 1806,  173, 3039, 3948, 2717, 1516,  221, 3786,
+     904, 3001, 2373, 4031, 1744, 2606,  735, 3307,  102, 1799,  800, 2677, 4078,  399, 2092, 1464,
+    1077, 2324, 1275,  124, 2685,  335, 3018, 3303,  880, 2746, 1429, 2980, 3263, 2287,  473, 1382,
+     834, 2990,  391, 1204,  705, 3150,  464, 1614, 3234, 1849, 3707, 2269, 2890, 3913, 2390, 1713,
+    1446,  589, 2262, 3182, 2049, 1343, 4008, 2825,  576, 3737,  861, 1671,  676, 3661, 3069, 2573,
+    1416, 2129,  678, 3218, 1303, 3517,  394, 1568, 2320, 1148, 3415,  217, 2261, 3326,  698, 3717,
+    3483,  444, 4009, 2167, 3373,  777, 1999, 1225, 4035, 2133, 1097, 3625,  802, 1912, 4068, 3427,
+    2460, 1991, 2764, 1507, 2605, 1928, 3936, 2206,  293, 2522,   74, 3362,  918,  625, 1205, 3652,
+    2519,  349, 2848, 1554, 3838,  435,  823, 1972, 3477, 2629, 1304, 2259, 3443, 1153, 1948,  493,
+    3931,  263, 2796, 1964,    2, 1090, 3832, 2068, 2731, 3677,  586, 1496, 1899, 1008, 2801, 1704,
+    2583, 1973, 1573, 3159, 1021, 1683, 2575,  486, 3512,   96, 2421,  286, 1654, 2654, 1211,   51,
+    1620,  611, 3385,  987, 3730,   14,  895, 1395, 3431, 1160, 4079, 1458, 2136, 1917,  299, 2998,
+    1001, 4058, 1885,  687, 2571, 3032, 2392, 1109,   34, 2131, 3185,  359, 2839,   73, 2454, 1726,
+    3414, 1031, 1609, 3755, 2452, 2867, 3108, 1396,  917, 3976, 2946, 2497, 3135, 3896, 1334,  160,
+    3081,  845, 2879,  583, 3662, 3893, 2282, 1476, 3144, 1853, 2841, 3889,  598, 3036, 2146, 3743,
+    3180, 3941,  184, 3078, 2417, 1680, 3583, 2673,  710, 2992, 1733,  426, 3153, 3835, 3474, 2724,
+       6, 3227, 1244, 3462,  250, 1719, 3275, 3631, 1606, 3883, 1004, 1826, 4088, 3289,  813, 1291,
+    3109, 2636, 3596,  452,  842, 1803, 2247,  227,  485, 1987, 1245,   56,  818, 3600,  371, 2364,
+    3793, 1209,  246, 2442, 1329,   36, 2948,  711, 3817,  954, 1253, 3340, 1412, 3508,  350, 1038,
+    1366, 2248, 1801, 1264, 2141,  573, 2893, 2030, 3773, 2345,  984, 2816, 2609,  753, 1299, 1785,
+    2330, 1521, 2095, 3732,  965, 2201, 1388,  520, 2908,  723, 2465, 1408,  564, 2075, 3727, 2285,
+     205,  647, 2187, 1469, 3295, 4066,  671, 3624, 3383, 1741, 3242, 2200, 1611, 2699, 2080,  649,
+    1804, 3301, 3542, 2106, 1886, 2755, 3471,  336, 1630, 2236,  447, 2562, 1965, 2357,  739, 2823,
+    2602,  302,  788, 3455, 4021,  262, 3284, 1219,  120,  507, 1955, 3575,  148, 1580, 2189,  535,
+    3620,  806,  404, 2682, 2954,  101, 4034, 2737, 1941,  230, 3082, 3612, 2658, 1583,  980, 2804,
+    3999, 1878, 1130, 2970,  154, 2668, 1655, 1067, 2581, 2819, 3805,  436, 1101, 3433, 2967, 1435,
+    3957,  991, 2675,  420, 4086,  907, 1154, 2507, 2032, 3615, 3093,  836,   76, 3924, 1734, 3585,
+    2027, 3759, 2983, 2708, 1490,  977, 2514, 1587, 3107, 3978, 1365, 3250, 2439, 1107, 4005, 3314,
+    2876, 2463, 3925, 1134, 3363, 1846,  769, 1227, 3822, 2224, 3402, 1184,  118, 2994,  417, 3236,
+    1398, 3511, 2432, 3821, 2013, 1274, 3183, 2349, 1452,  142,  736, 2435, 4003, 1870,  920, 2526,
+      80, 2253, 1642,  734, 1471, 3068, 1770, 3288,  129, 2714, 4042, 1542, 2907, 1114, 3237,  521,
+     956, 2434, 1143,  477, 1916, 3823,  694, 1835, 3425, 2217,  821, 1698, 3808,  366, 3051,  936,
+     126, 1339, 1959,  624, 1612, 2539, 3510, 2358, 1530,  369,  860, 1746, 3967, 2388, 1977,  752,
+    1731,   49,  550,  933, 3423,  307,  516, 3911,  890, 2038, 3586, 1305, 3155,  553,  295, 3698,
+    3125, 1276, 2903, 3257, 3632, 2227,  533, 3774, 1384, 1078,  628, 1824, 3377, 2139,  243, 1480,
+    3988, 1653,  177, 3173, 2335, 3529, 2778,  373, 1062, 2665,  209, 2914,  635, 2061, 2589, 1892,
+    1658, 3750, 3073, 2290,  282, 3136,  466, 1019, 2979, 3254, 2598, 2135,  654, 3489, 1254, 3882,
+    2530, 3056, 2743, 1567, 2275, 2883, 1859, 3699, 3065,  354, 2902, 1717, 2278, 2763, 1545, 3395,
+    1925,  571, 3824,  145, 2537,  296, 2828,  826, 2352, 3454,  214, 2478, 1283, 3831, 2742, 3075,
+    1890, 3328, 3669, 2165, 1319,   58, 3035, 2116, 3640, 1273, 2380, 3697, 1492, 3502, 1196,  276,
+    3404, 2711, 1002, 3574, 1433, 3942, 2035, 3741,  170, 1871, 3649, 1057, 1455, 2726,  242, 3348,
+    1013, 2059, 3724, 1352, 3986,  784, 2502, 1194, 2178, 1500, 3360,  952,   17, 3829, 1190, 2132,
+     825, 2402, 1747, 1074, 1989, 1261, 3965, 1595, 1879, 2885, 2089, 3693,  433,  866, 2277,  674,
+    1248, 2769,  889,  613, 4091, 1720,  801, 1463, 3943,  567, 3071, 1810,  901, 2298, 2834, 3836,
+     768,  505, 2099,   38, 2865,  893, 1730, 2695, 1309,  614, 2863,  453, 3795, 3127, 2194, 1613,
+     396, 3552,  686,  245, 3138, 1682,   62, 3486,  620, 2645, 4055, 1949,  681, 3525, 2568, 3008,
+     181, 4030, 2782, 3451,  680, 2159, 3359, 3099,  400, 3864,  726, 3045, 1686, 2642, 3629,   24,
+    2503,  328, 1523, 2939, 2618, 1041, 3331, 2494,  274, 2011, 3262,   21, 4039,  455, 1399, 3139,
+    2400, 1532, 4056, 2567, 1236, 3329,  702, 2431, 3408, 4067, 1622, 2488,   15, 1823,  856, 2830,
+    2354, 1224, 1891, 2613, 2120, 3322,  961, 2809, 1754,  208, 1111, 2471, 3249, 1638,  445, 1032,
+    1445, 3204,  387, 1559, 3691, 2696,   10,  978, 2552, 1197, 1497, 3265, 1028, 1962, 1448, 3436,
+    2078, 3917, 1827, 3495,  410, 1974, 3812, 2860, 1598,  942, 2753, 1135, 2566, 3341, 2171,  137,
+    1777, 1121, 3228, 1873,  390, 3670, 2138,   90, 1122, 2246, 3091, 2010, 3556, 1165, 4010,  609,
+    3212, 3800, 2951, 1069,  497, 3656, 1292, 3921, 2314, 3628, 3085,  378, 1333, 2073, 3940, 2736,
+    3623, 2263, 1233,  859, 3022, 1802, 1423,  593, 3627, 2305,  110, 2776,  278, 4060,  526, 2973,
+     775, 1022, 2372, 3147, 1193, 2274,  121,  684, 3453, 2237, 3598, 1694,  601, 1934,  839, 3930,
+    2935, 3507,  663, 2304, 3030, 1633, 2760, 3820, 1509,  266,  905,  677, 1380, 2634, 3412,  185,
+    1486, 1750,   95, 4073, 2404, 1549, 3023,  422, 2015, 1428,  849, 3859, 2942, 2366,  797, 1789,
+     603, 1971, 2616, 3816,  248, 2436, 4046, 3168, 2024, 1735, 3912, 3519, 2183, 2450, 1174, 3214,
+    1649, 3592,  219,  578, 3736, 1419, 3221, 1814, 1290,  385, 3872, 1451, 3041, 3711, 1306,  314,
+    2607,  969, 3815,  189, 1372,  865,  541, 3193, 1894, 2899, 3881, 3271, 2313,  330, 2987, 2091,
+    2541,  881, 3467, 2733,  725, 1924,  179, 2576,  692, 3418, 2745, 1852,  150, 3663,  323, 3101,
+    3419,   77, 1645, 3304,  527, 2235, 1104, 3458,  803, 2651,  379, 1361,  847, 1758, 3696,  155,
+    2611, 1337, 2913, 2121, 2750,  854, 2418, 3998, 2959, 2540,  780,  247, 2384, 2693, 3450, 2044,
+    1651,  474, 2477, 2082, 3393, 3983, 2591, 1036, 3570,  448, 2527, 1708, 3720,  994, 1875, 3873,
+    1258, 2268,  344, 1414, 3186, 2213, 3790, 1170, 3241, 1659,  501, 2264, 1223, 1565,  975, 2446,
+    1168, 3914, 2887, 1011, 2040, 1344, 2831,  157, 1592, 2955, 1043, 3375, 3079,  655, 2835, 2267,
+    3992, 3354, 1783, 3887, 1555,  251, 3577,  544, 1054, 2077, 3181, 1861, 1015,   89, 1169, 3198,
+    2805, 1461, 3637, 1138, 2849, 1701,  300, 2307, 1406, 2122, 1239,  127, 2794, 1535,  762,  460,
+    3232, 3671, 2851, 1133, 1774, 3539,  924, 2824, 3991, 2119, 1027, 3535, 2592, 3195, 4075, 2795,
+    2150, 1417,  724, 2520, 3584, 3885,  427, 1895, 3738,  559, 2128, 2517, 1923, 3845, 1494,  470,
+    1103,   54,  685,  966, 2555, 3113, 1994, 1665,   50, 3813, 2762, 3357, 4069, 2279,  570, 3876,
+     772, 1828, 3061,   48,  696, 1969, 3714, 3052,  756, 3376, 4025,  587, 3080, 2190, 3565, 2663,
+    1669,  630, 2001, 3946,   72,  512, 2451, 1348,  367,   26, 3050, 3826,  703, 1978,  105, 1685,
+     491, 3686,  297, 3011, 1743,  869, 3346, 2459, 3121, 1424, 3970,   35, 1208,  288, 3285, 2036,
+    3120, 2472, 1954, 3459,  421, 1145, 2847, 3397, 2321, 1251, 1519,  640, 1706, 2982, 1409, 3569,
+    2147,  338, 4037, 2273, 3283, 1269, 2499,  176, 1812, 2741,  928, 1983, 3327, 1345, 3929,  304,
+    1085, 3054, 2387,  840, 3366, 2963, 1619, 3715, 1902, 2363, 1462, 2852,  423, 1373, 3590,  862,
+    3358, 1855, 2331, 3220,   47, 1506, 2707, 1126,  722, 2312, 3560, 2781, 1673, 3633, 2676,  798,
+    3789, 2930, 1279, 3701, 2250, 4052, 1404,  766, 2624,  321, 3674,  925,  402, 1980, 2512,  213,
+    1044, 3389, 2639,  913, 1588, 3916,  572, 3457, 1537, 3804,  340, 2362, 1110,   70, 2486, 1927,
+    3448,  169, 3761, 1502, 2628, 2094,  718, 3154, 2702, 3481,  873, 1728, 3313, 2464, 2209, 2981,
+    2632, 1042, 4002, 1229,  634, 2258, 1992, 4089,  182, 1800,  908,  437, 3024,  989, 2220, 1426,
+     275,  539, 1628, 2727,  104, 1807,  577, 3613, 3157, 1851, 2904, 2210, 3475, 3784, 2720, 3128,
+    1664, 2399, 1336,  461, 2988, 2087, 1005, 2842, 1173, 3169, 2587, 1697, 3528, 2869,  871, 1560,
+    2241, 2790, 1300, 1848,  301, 4041, 1216,  203, 1056,  554, 4013, 2069,  235, 1081, 3894,  616,
+     201, 1557, 2045, 2821, 3444, 3751,  353, 2911, 3487, 1293, 3216, 2031, 2428,  596, 4032, 1773,
+    2341, 3230, 2096,  829, 3321, 2989, 1033, 2101,  134, 3956, 1124, 2466, 1326,   16,  841, 1232,
+     612, 3657, 1926, 3760, 2723,  280, 3578, 2329,    1, 2154,  646, 1400, 3834,  525, 3037, 4093,
+     689, 3211,  484,  982, 3290, 2308, 3563, 1790, 2233, 3224, 2529, 1272, 3664, 2710, 1889, 1331,
+    3161, 3801,  441, 2556,  921, 1371, 3137, 1627,  542, 2564, 3922, 1517, 3384, 1266,   88, 3468,
+     906, 1156, 3958,  345, 2511, 1522, 3851, 2368, 1650,  815,  476, 3060, 1607, 3324, 1842, 3858,
+    2919, 3239,   86,  796, 1721, 3208, 1432, 1887, 4048,  852, 3634, 2713,  270, 2111, 1796, 1201,
+    2593, 3589, 2037, 3860, 2917,  594, 1477, 2818, 3825, 1574,   85,  751, 3042,  469, 1637, 3411,
+    2367,  799, 3548, 1709,  133, 1901, 2403, 1026, 2151, 2810,  773,  334, 3690, 2652, 1932, 2833,
+    1563, 3017, 3607, 1876, 1314, 3514,  231, 2791, 3281, 2599, 3531, 2007,  661, 4011, 2353,  290,
+    2066, 1459, 2255, 1113, 2453, 3839,  707,  439, 3003, 1577, 3306, 1946, 1065, 3156, 3464,  372,
+    1436,   23, 1674, 2440, 1163,  149, 2579,  810,  351, 1998, 2878, 3500, 2281, 3964,  916, 2774,
+       0, 1187, 2897, 2161, 3949, 3310,  700, 3869, 3618,   61, 1864, 2292, 1091, 3134,  714, 3748,
+    2437,  166,  664, 2674, 2257,  515,  939, 1957, 1180, 1438, 3713,  199, 2822, 1095, 2631,  517,
+     968, 2747, 4084, 3484,  211, 1286, 2630, 3420, 2386, 1191,  207, 2480, 3980,  750, 2340, 2775,
+     955, 2175, 3722,  746, 3126, 1933, 3934, 3342, 1359, 3709, 1006, 1816, 1474,  292, 2134, 3619,
+    1968, 1514, 3110,  555, 1108, 2664,  226, 3026, 1489, 1228, 3349, 2958, 1681,  200, 2164, 1362,
+     430, 3367, 1672, 1046, 3189, 3734, 2912,  675, 4077,  355, 2280,  931, 3226, 2152, 1548, 3606,
+    3343, 1740,  368, 3087, 1975, 2901, 2108,  948, 1769, 3733,  581, 2905, 1357,  115, 1540, 3897,
+    3278, 2999,  315, 2709, 1533, 3530,  960, 2153, 3055, 2395,  604, 2656, 3325, 1140, 2548,  659,
+    3240, 4057,  253, 2491, 3689, 1338, 2071, 1793,  483, 2447, 3791,  855, 4062,  534, 2584, 3853,
+    1907, 2118, 2811, 4024,    7, 2053, 1725, 3469, 2482, 1623, 3007, 1808, 1368, 3758,   94, 3043,
+    1271,  669, 2550,  883, 1615,  566, 3989,  103, 2761, 3123, 2181, 1712, 3503, 2641, 1920, 3644,
+     548, 1840, 1318, 4049, 2252,  502, 1724,   45, 1200,  413, 4081, 3142,  164, 3833, 1751, 2943,
+    1310,  882, 2266, 1657,  760, 2864, 3543,  914, 3219, 2679,  285, 2048, 1441, 3491, 3200,  937,
+    2945, 3645,  779, 1460, 1171, 2582,  397, 1347, 3166,   82, 2705, 3892,  459,  774, 1953, 2422,
+    3951, 2216, 3549, 1405, 3780, 3215, 1136, 3573, 1481,  317,  812, 3797,  985,  451, 2283, 1172,
+     837, 2524, 3422, 1070,  212, 3244, 2949, 2542, 3646, 1884, 1591,  848, 1393, 2350,  500, 3667,
+     357, 2680, 3842, 1867, 3337,  393, 2343, 4018, 1581,  645, 2906, 1149, 2377, 2777, 1763, 1241,
+     131, 2501,  492, 2332, 3400, 2960, 3777,  765, 2155, 1098,  607, 3300, 2535, 3479, 2892, 1142,
+     222, 1866, 2813,   39, 2156, 2489,  419, 1910, 2318, 3903, 1268, 3294, 2067, 2964, 3203,  273,
+    1608, 2934, 2057,  662, 2419, 3818, 1427,  764, 2752, 3441, 2218, 2889, 2028, 3401,  997, 1935,
+    1547, 3493, 1073,   65, 3076, 1456, 1132,  141, 2193, 3369, 1881, 3611,   46,  758,  356, 3961,
+    1024, 1602, 3116, 3902,  239, 1832,  967, 2405, 3962, 3594, 2022, 1263, 2228,  324, 1700,  938,
+    3794,  540, 3297, 1060,  745, 2969, 1689, 3333,  656, 2534, 2721,   59, 1470,  688, 3687, 2744,
+    3939,   98, 3593, 1771, 2844, 1247, 1984, 3974,  562, 1066,  122, 3904,  670, 2619, 3072,  107,
+    2414, 2874, 2088,  619, 2509, 3877, 1958, 2627, 3745, 1321,  963, 3908, 3106, 1538, 2276, 3311,
+    1837, 3562, 1260, 2004,  648, 1566, 3258, 2749,  180, 1646, 2866,  876, 1503, 4022, 3174, 2667,
+    1430, 3027, 1643, 3700, 2694, 3923, 1341,  910, 3522, 3044, 1030, 1850, 4070, 2476, 1742, 1288,
+    2148, 3264, 1444,  440, 3705,  885, 2199,  318, 1691, 3280, 2500, 1294,  269, 3704, 1186, 4026,
+    3233,  783, 3778, 1284, 3445, 2803,  494,  817, 2978,  259, 1677,  552, 2561, 2014, 3721, 2697,
+     411, 2211,  830, 2786, 3695, 2251,  468, 1403, 1930,  362, 3382, 3710,   29, 2383,  643, 3536,
+    2076, 2339,  384, 1240, 1979,  158, 2291,  277, 2039, 1552,  407, 2240, 3398,  198,  923,  504,
+    2415, 1017,  738, 2671, 3172,  143, 3480, 3062, 2371, 1483, 2974, 3541, 1834, 1610, 2245,  560,
+    1401, 1764,  202, 2234, 1618,  973, 1788, 3602, 3199, 2457, 2145, 2832, 3429,  898, 1364,  617,
+    4092, 2590, 3368,   52, 3010, 1129, 3843, 3496, 3057, 1061, 2563, 1798, 3089, 1179, 1909,  254,
+     833, 3938, 2603, 3417,  592, 3104, 3648, 2789, 3979,  575, 3753, 2853, 1150, 3102, 3553, 3850,
+    1888, 3002, 4016, 2294, 1617, 2553, 1141, 1841, 3726,  911,  381, 2113,  755, 2766, 3000,  941,
+    2041, 3394, 2670, 3170,  326, 4080, 2326,   22, 1479, 1071, 4000,  383, 1217,  100, 3213, 2920,
+    1089,  313, 1666, 1389, 2423,  887, 2626, 2107,  743, 4061,  530, 2162,  804, 2754, 3765, 3365,
+    1320,   84, 1817,  972, 2420, 1437, 1736, 1088, 2456, 1280, 3175, 1675,  771, 2019, 2698, 1512,
+       8, 3381, 1230,  272, 2043, 3865,  584, 2802,   60, 3995, 2633, 1125, 3874, 3309,  337, 2506,
+    3950,  457, 1118, 3650,  713, 2944, 1210, 3378, 1997,  595, 3526, 1821, 2315, 3888, 1936, 1508,
+    2112, 3492, 3086, 1906, 3993,  380, 1765,   87, 1256, 2355, 3282, 1370, 3906,  425, 2504, 1561,
+    2184, 2798, 3675, 3188, 4076,  808, 2163, 3274,   31, 1893, 3463,  260, 2594, 1350,  398, 2205,
+    2873,  644, 1761, 3498,  919, 1465, 3293,  789, 1302, 1985, 3146,  498, 2365, 1442,   40, 3621,
+    1668, 2850, 2359, 1908, 1511, 2110, 2580, 3857,  786, 2653, 3124, 1582, 2985,  727, 2475, 3756,
+     875, 2382,  163,  712, 3581, 3248, 1544, 2957, 3703, 2729, 1621,  132, 2931, 1745, 1003, 3247,
+    2997, 1120,  482, 1603,  193, 2875,  428, 3564,  715, 2689,  959, 2342, 3994,  599, 3783, 3277,
+    1096, 2508, 3712, 2788,  450, 3033, 2123, 3610, 2301, 1558, 3424, 1727, 3561, 1023, 1883, 3133,
+    1278,  814,  113, 3796, 3114,  532,  229, 1688, 2894, 1297,  139, 3655,  999,  249, 2728,  467,
+    1340, 3668, 2870, 1202, 2188, 2692,  543, 3437, 1903,  305,  946, 3516, 2020, 3651,  600,  284,
+    4001,  716, 2023, 2293, 1257, 2610, 3764, 1575, 2975, 3884, 2142, 1488, 3614, 1786, 2971,  877,
+    1639,  223, 1996, 1330, 2361, 4090,  192, 2595,  388, 2926,  682,  159, 2722, 2079, 3837,  597,
+    2219, 3472, 1034, 2643, 1349, 3299,  934, 2391, 3719,  449, 2196, 2521, 1411, 3465, 1695, 3298,
+    1819,  574, 2021, 3901,  929, 1376, 2485, 1082,  697, 3953, 2222, 3097, 1206, 2455, 1449, 2323,
+    1805, 2648, 3603, 3347, 3053, 1869, 1000, 2065, 1317,  503,  204, 3117, 1105,  117, 2081, 2375,
+    3537, 3932,  754, 3202, 1020, 1818, 1629, 1161, 3807,  976, 2458, 4043, 1246,  792, 2937, 2544,
+    1491, 3907, 3006,  298, 1756, 3996, 3520, 1117, 1938, 3246, 4038,  651, 2064, 3827, 1146, 3040,
+    4045, 2462, 1526,  347, 3112,  187, 3841, 2051, 3197, 1467, 2549,  406,  749, 2856, 3848, 3396,
+       3, 1354,  884,  316, 3856,  629,  109, 2473, 3501, 1752, 3350, 2543,  729, 3409, 2751,  358,
+    1413, 3021, 2655,   75, 3763,  618, 2748, 3485, 1918, 3255, 1386, 3059, 2249,  365, 3353,  172,
+    1784,  488, 2026, 2444,  683, 2203, 2725,   68, 1487,  846, 1749, 2800, 3177,  416, 2286,   11,
+    2644, 1025, 3387, 2812, 1791, 3518, 2317, 2929,  111, 1718, 3731, 3336, 1874,  210,  912, 2093,
+    3141, 2891, 1661, 2424, 1112, 1520, 3256, 4033, 2797,  888, 1220, 2895, 1913, 1571, 4063, 1237,
+     563, 1872, 2238, 1539, 3374, 2410, 2947,  805,   20, 2157,  523, 1795, 3601, 1564, 3769,  935,
+    2759, 3205, 1155, 3692, 1553, 2918,  386, 2042, 3048, 3440, 1235,  171,  947, 1897, 2910,  782,
+    3235,  216, 2221, 3788,  763, 1586,  463, 1178,  878, 2808,  557, 1322, 4072, 2669, 1632, 1159,
+    3735,  551, 3960, 1942, 3523, 2686, 2169,  747,  303, 2325, 3919,  376, 2198, 3770,  958, 2523,
+    3296, 3688, 1119,  327, 2054, 1308,  412, 3971, 1510, 2623, 3852,  234, 2807, 1116, 1963, 2376,
+    1355, 4071,    5, 3338,  872, 1255, 3935, 2493,  546, 3785, 2310, 2635, 3918, 1327, 3635, 1626,
+    3875, 1415,  531, 1252, 2574, 1986, 3251, 4023, 3595, 2407, 2149, 1052, 2976, 2295, 3551,  392,
+    2538,  795, 2202,  128, 2941,  480, 1363, 3145, 1631, 1993, 3641, 1392,  631,   27, 3152, 1711,
+     237, 2861,  867, 4004, 3131, 3630,  962, 2284, 3158, 1203, 3430,  903, 2505,  588, 3070, 3524,
+     730, 2127, 2569,  561, 1880, 3118, 3609, 1679,  767, 2855,  306, 1546, 3513, 2426,  622, 2103,
+    2780, 1860, 3096, 3654,  996,   66, 2691, 1407, 1820,  238, 3435, 1562,   63,  668, 3269, 1995,
+    1499, 2768, 1265, 3364,  943, 3680, 1833, 3806,   69, 1045, 3245, 2600, 3012, 3559, 2316, 2047,
+     704, 3466, 2449, 1625,  558, 2570, 1722, 1981, 3694,  693, 1678, 2034, 3276, 3984,  257, 1715,
+     408, 2986, 1647, 3488, 2348,  255, 1018, 1391, 3270, 2140, 1094, 1990,  487, 3316,  123, 1137,
+     897, 3482,  281, 2381, 2961, 3886,  639, 2115, 3074,  807, 2601, 3766, 3149, 1787, 1009, 3985,
+     188, 3608, 3095, 1692,  258, 2369, 1164, 2646, 2950, 2416,  508, 1794,  820, 1192, 1495, 2718,
+    3747, 1332, 1944,   93, 2787, 1167, 3014,  168,  370, 2706, 2925,   91, 1453, 2212, 1270, 2690,
+    3844,  995, 1425, 2806, 3799, 2174, 2681,  156, 1839, 3658, 4083, 3132,  874, 1757, 2993, 2513,
+     432, 2050, 1513,  728, 2176, 1690, 3352, 1083,  361, 3972, 1250, 2017,  329, 2479, 1385, 2922,
+    2344, 1847,  605, 2604, 4082, 2046,  636, 3494,  838, 4007, 1531, 3434, 2817, 3900,  194, 1035,
+     446, 3047, 2265, 3803, 3266,  731, 3557, 2356, 1387, 3898, 1076, 2412, 3749,  778, 1858, 3187,
+    2322, 3653,  119,  794, 1195,  499, 3391, 2953, 2443,  633,   33, 2738, 1418, 2272, 3968, 3716,
+    1670, 3287, 4064, 2756, 1289,  215, 3757, 2483, 2882, 1648,  547, 2785,  900, 3867, 3390,  471,
+     824, 3830, 1072, 1443, 3261, 2877, 1578,  346, 2215, 1298,  146, 2130,  360, 1919, 2394, 3286,
+    3987, 1779,  932,  310, 1447, 2114, 4054,  892, 3308, 1882, 3506,  479, 3015, 3413,  147, 1106,
+     615, 2063, 3305, 1778, 4017, 2003, 1551, 3905,  951, 1296, 1652, 2528, 3461,  224,  701, 1312,
+    2640,   43, 1100, 3148, 3538,  513, 1940, 1367, 3567, 2288, 3323, 3665, 1493, 2182, 2715, 1222,
+    2058, 3452,   37, 2254,  429,  896, 3855, 3105, 1809, 3302, 3708, 2560,  945, 3639, 2916, 1579,
+     653, 2596, 1243, 3405, 2461, 1838,  424, 1570, 2608,  627, 2172, 1634,  944, 2765, 2525, 4050,
+    1589, 2923, 2495,  319, 3019, 2374,  709,  341, 3558, 2223, 3064, 3854, 1144, 1931, 2871, 2158,
+    3587,  650, 2429, 1755,  909, 2615, 3034,  742,   12,  986, 1843,  225, 3103,  708,  114, 1705,
+    3160, 2490, 2972, 3768, 1915, 1218, 2445,  206, 2771, 1064,  673, 1663, 3179,  545, 1358, 2177,
+    3547,   41, 2845, 3861,  602, 2716, 2962, 1123, 3122,   30, 1259, 3973,  289, 2000, 1374, 3540,
+     395,  891, 1316, 3626, 1049, 3229, 1369, 2783, 1947, 3320,  509,  819,  331, 3672, 3206,  993,
+    3013, 1898, 3828,  364, 2226, 3944, 1541, 3252, 2102, 3819, 2637, 1177, 2396, 1914, 3576, 4051,
+     322, 1328, 1584,  679, 2701, 3335, 3642, 1422, 2029, 3963, 2995, 2319, 1212, 4029,  175, 1856,
+     850, 3164, 2005, 1644, 1016, 3509,  196, 3880, 2303, 3683, 2815, 3217, 2351, 1759,  549, 3058,
+    2239, 3879, 1877, 2683,   44, 1684, 3684, 2572,  191, 1040, 2888, 2109, 1714, 2433, 1485,  489,
+    2306, 1207, 3386, 1383, 2900,  167, 1158, 2409,  456, 2859, 1421,  585, 3920, 2928, 1087, 2327,
+     915, 2784, 3545,  218, 2137, 1723,  519,  793, 2620,    9,  442, 1943, 3403, 2666, 3067, 2438,
+    1128, 3678, 2299,  287, 3231, 1346, 2074, 1693,  832, 1945, 1468,  695, 3572, 3811, 1166, 3351,
+     165, 2826,  658, 3407, 2144,  529,  857, 3840, 1782, 1475, 4044, 3416, 1234, 2758,  130, 3997
+};
+
+}   // namespace foundation
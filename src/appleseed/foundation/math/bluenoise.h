@@ -0,0 +1,105 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_FOUNDATION_MATH_BLUENOISE_H
+#define APPLESEED_FOUNDATION_MATH_BLUENOISE_H
+
+// appleseed.foundation headers.
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// Tileable blue noise mask.
+//
+// The mask was generated with the void-and-cluster method (Gaussian kernel,
+// sigma = 1.9 pixels). Thresholding it at any level yields a set of pixels
+// free of low frequencies, which makes it suitable to decorrelate the samples
+// of neighboring pixels: errors that would otherwise look like white noise
+// are pushed toward high frequencies, where they are much less visible.
+//
+// Reference:
+//
+//   Robert Ulichney, The void-and-cluster method for dither array generation
+//   http://cv.ulichney.com/papers/1993-void-cluster.pdf
+//
+//   Iliyan Georgiev and Marcos Fajardo, Blue-noise Dithered Sampling
+//   http://www.arnoldrenderer.com/research/dither_abstract.pdf
+//
+
+// Size of the mask in pixels along each axis.
+const size_t BlueNoiseMaskSize = 64;
+
+// Ranks of the pixels of the mask, row by row. The ranks are a permutation
+// of 0 ... BlueNoiseMaskSize * BlueNoiseMaskSize - 1.
+extern const uint16 BlueNoiseMask[BlueNoiseMaskSize * BlueNoiseMaskSize];
+
+// Return the value in [0, 1) of the mask tiled over the plane, at a given pixel
+// and for a given dimension. Dimensions are decorrelated by shifting the mask
+// by a different toroidal offset for each of them.
+template <typename T>
+T blue_noise(
+    const size_t        x,
+    const size_t        y,
+    const size_t        dimension);
+
+
+//
+// Implementation.
+//
+
+template <typename T>
+inline T blue_noise(
+    const size_t        x,
+    const size_t        y,
+    const size_t        dimension)
+{
+    const size_t MaskSize = BlueNoiseMaskSize;
+    const size_t Mask = BlueNoiseMaskSize - 1;
+
+    // Offsets of successive dimensions follow the R2 sequence scaled to the mask size,
+    // in 16.16 fixed point: 2^16 * (1 / g, 1 / g^2) where g is the plastic number.
+    const uint32 StepX = 49471;
+    const uint32 StepY = 37345;
+    const uint32 d = static_cast<uint32>(dimension);
+    const size_t ox = static_cast<size_t>(((d * StepX) & 0xFFFF) * MaskSize >> 16);
+    const size_t oy = static_cast<size_t>(((d * StepY) & 0xFFFF) * MaskSize >> 16);
+
+    const size_t rank = BlueNoiseMask[((y + oy) & Mask) * MaskSize + ((x + ox) & Mask)];
+
+    return (static_cast<T>(rank) + T(0.5)) / static_cast<T>(MaskSize * MaskSize);
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BLUENOISE_H
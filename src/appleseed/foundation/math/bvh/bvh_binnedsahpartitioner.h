@@ -0,0 +1,332 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_BINNEDSAHPARTITIONER_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_BINNEDSAHPARTITIONER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace foundation {
+namespace bvh {
+
+//
+// A BVH partitioner based on the Surface Area Heuristic (SAH), evaluated
+// over a fixed number of bins of item centroids instead of over every
+// possible split position.
+//
+// Unlike SAHPartitioner, this partitioner maintains a single item ordering
+// and only ever touches the items of the set it partitions. It is therefore
+// safe to partition disjoint sets of items from multiple threads.
+//
+// Reference:
+//
+//   On fast Construction of SAH-based Bounding Volume Hierarchies
+//   I. Wald
+//   IEEE Symposium on Interactive Ray Tracing 2007.
+//
+
+template <typename AABBVector, size_t BinCount = 16>
+class BinnedSAHPartitioner
+  : public NonCopyable
+{
+  public:
+    typedef AABBVector AABBVectorType;
+    typedef typename AABBVectorType::value_type AABBType;
+    typedef typename AABBType::ValueType ValueType;
+
+    // Constructor.
+    BinnedSAHPartitioner(
+        const AABBVectorType&   bboxes,
+        const size_t            max_leaf_size = 1,
+        const ValueType         interior_node_traversal_cost = ValueType(1.0),
+        const ValueType         item_intersection_cost = ValueType(1.0));
+
+    // Compute the bounding box of a given set of items.
+    AABBType compute_bbox(
+        const size_t            begin,
+        const size_t            end) const;
+
+    // Partition a set of items into two distinct sets.
+    size_t partition(
+        const size_t            begin,
+        const size_t            end,
+        const AABBType&         bbox);
+
+    // Return the items ordering.
+    const std::vector<size_t>& get_item_ordering() const;
+
+  private:
+    static const size_t Dimension = AABBType::Dimension;
+
+    // Return true if an item falls in or before a given bin.
+    class BinPredicate
+    {
+      public:
+        BinPredicate(
+            const AABBVectorType&   bboxes,
+            const size_t            dim,
+            const ValueType         min,
+            const ValueType         scale,
+            const size_t            bin);
+
+        bool operator()(const size_t index) const;
+
+      private:
+        const AABBVectorType&       m_bboxes;
+        const size_t                m_dim;
+        const ValueType             m_min;
+        const ValueType             m_scale;
+        const size_t                m_bin;
+    };
+
+    const AABBVectorType&       m_bboxes;
+    const size_t                m_max_leaf_size;
+    const ValueType             m_interior_node_traversal_cost;
+    const ValueType             m_item_intersection_cost;
+    std::vector<size_t>         m_indices;
+
+    // Return the bin a centroid coordinate falls into.
+    static size_t bin_index(
+        const ValueType         x,
+        const ValueType         min,
+        const ValueType         scale);
+};
+
+
+//
+// BinnedSAHPartitioner class implementation.
+//
+
+template <typename AABBVector, size_t BinCount>
+BinnedSAHPartitioner<AABBVector, BinCount>::BinnedSAHPartitioner(
+    const AABBVectorType&       bboxes,
+    const size_t                max_leaf_size,
+    const ValueType             interior_node_traversal_cost,
+    const ValueType             item_intersection_cost)
+  : m_bboxes(bboxes)
+  , m_max_leaf_size(max_leaf_size)
+  , m_interior_node_traversal_cost(interior_node_traversal_cost)
+  , m_item_intersection_cost(item_intersection_cost)
+{
+    const size_t size = m_bboxes.size();
+
+    // Identity ordering.
+    m_indices.resize(size);
+    for (size_t i = 0; i < size; ++i)
+        m_indices[i] = i;
+}
+
+template <typename AABBVector, size_t BinCount>
+typename AABBVector::value_type BinnedSAHPartitioner<AABBVector, BinCount>::compute_bbox(
+    const size_t                begin,
+    const size_t                end) const
+{
+    AABBType bbox;
+    bbox.invalidate();
+
+    for (size_t i = begin; i < end; ++i)
+        bbox.insert(m_bboxes[m_indices[i]]);
+
+    return bbox;
+}
+
+template <typename AABBVector, size_t BinCount>
+size_t BinnedSAHPartitioner<AABBVector, BinCount>::partition(
+    const size_t                begin,
+    const size_t                end,
+    const AABBType&             bbox)
+{
+    // Don't split leaves containing only degenerate triangles.
+    if (bbox.rank() < Dimension - 1)
+        return end;
+
+    const size_t count = end - begin;
+    assert(count > 1);
+
+    // Don't split leaves containing less than a predefined number of items.
+    if (count <= m_max_leaf_size)
+        return end;
+
+    // Compute the bounding box of the centroids of the items.
+    AABBType centroid_bbox;
+    centroid_bbox.invalidate();
+    for (size_t i = begin; i < end; ++i)
+        centroid_bbox.insert(m_bboxes[m_indices[i]].center());
+
+    ValueType best_split_cost = std::numeric_limits<ValueType>::max();
+    size_t best_split_dim = Dimension;
+    size_t best_split_bin = 0;
+    ValueType best_split_scale = ValueType(0.0);
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        const ValueType extent = centroid_bbox.max[d] - centroid_bbox.min[d];
+        if (extent <= ValueType(0.0))
+            continue;
+
+        const ValueType scale = static_cast<ValueType>(BinCount) / extent;
+
+        // Bin the items.
+        size_t bin_counts[BinCount];
+        AABBType bin_bboxes[BinCount];
+        for (size_t b = 0; b < BinCount; ++b)
+        {
+            bin_counts[b] = 0;
+            bin_bboxes[b].invalidate();
+        }
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            const AABBType& item_bbox = m_bboxes[m_indices[i]];
+            const size_t b = bin_index(item_bbox.center(d), centroid_bbox.min[d], scale);
+            ++bin_counts[b];
+            bin_bboxes[b].insert(item_bbox);
+        }
+
+        // Left-to-right sweep to accumulate bounding boxes and compute their surface area.
+        ValueType left_areas[BinCount - 1];
+        size_t left_counts[BinCount - 1];
+        AABBType bbox_accumulator;
+        bbox_accumulator.invalidate();
+        size_t count_accumulator = 0;
+        for (size_t b = 0; b < BinCount - 1; ++b)
+        {
+            bbox_accumulator.insert(bin_bboxes[b]);
+            count_accumulator += bin_counts[b];
+            left_areas[b] = count_accumulator > 0 ? half_surface_area(bbox_accumulator) : ValueType(0.0);
+            left_counts[b] = count_accumulator;
+        }
+
+        // Right-to-left sweep to accumulate bounding boxes and find the best partition.
+        bbox_accumulator.invalidate();
+        count_accumulator = 0;
+        for (size_t b = BinCount - 1; b > 0; --b)
+        {
+            bbox_accumulator.insert(bin_bboxes[b]);
+            count_accumulator += bin_counts[b];
+
+            // Skip partitions that leave one side empty.
+            if (left_counts[b - 1] == 0 || count_accumulator == 0)
+                continue;
+
+            // Compute the cost of this partition.
+            const ValueType left_cost = left_areas[b - 1] * left_counts[b - 1];
+            const ValueType right_cost = half_surface_area(bbox_accumulator) * count_accumulator;
+            const ValueType split_cost = left_cost + right_cost;
+
+            // Keep track of the partition with the lowest cost.
+            if (best_split_cost > split_cost)
+            {
+                best_split_cost = split_cost;
+                best_split_dim = d;
+                best_split_bin = b - 1;
+                best_split_scale = scale;
+            }
+        }
+    }
+
+    // All centroids coincide: split the set in the middle to keep leaves small.
+    if (best_split_dim == Dimension)
+        return begin + count / 2;
+
+    // Don't split if it's cheaper to make a leaf.
+    const ValueType split_cost =
+        m_interior_node_traversal_cost +
+        best_split_cost / half_surface_area(bbox) * m_item_intersection_cost;
+    const ValueType leaf_cost = count * m_item_intersection_cost;
+    if (leaf_cost <= split_cost)
+        return end;
+
+    // Move the items of the left partition in front of the items of the right partition.
+    const std::vector<size_t>::iterator pivot_it =
+        std::partition(
+            m_indices.begin() + begin,
+            m_indices.begin() + end,
+            BinPredicate(
+                m_bboxes,
+                best_split_dim,
+                centroid_bbox.min[best_split_dim],
+                best_split_scale,
+                best_split_bin));
+
+    const size_t pivot = pivot_it - m_indices.begin();
+    assert(pivot > begin);
+    assert(pivot < end);
+
+    return pivot;
+}
+
+template <typename AABBVector, size_t BinCount>
+inline const std::vector<size_t>& BinnedSAHPartitioner<AABBVector, BinCount>::get_item_ordering() const
+{
+    return m_indices;
+}
+
+template <typename AABBVector, size_t BinCount>
+inline size_t BinnedSAHPartitioner<AABBVector, BinCount>::bin_index(
+    const ValueType             x,
+    const ValueType             min,
+    const ValueType             scale)
+{
+    const size_t b = static_cast<size_t>((x - min) * scale);
+    return std::min(b, BinCount - 1);
+}
+
+template <typename AABBVector, size_t BinCount>
+inline BinnedSAHPartitioner<AABBVector, BinCount>::BinPredicate::BinPredicate(
+    const AABBVectorType&       bboxes,
+    const size_t                dim,
+    const ValueType             min,
+    const ValueType             scale,
+    const size_t                bin)
+  : m_bboxes(bboxes)
+  , m_dim(dim)
+  , m_min(min)
+  , m_scale(scale)
+  , m_bin(bin)
+{
+}
+
+template <typename AABBVector, size_t BinCount>
+inline bool BinnedSAHPartitioner<AABBVector, BinCount>::BinPredicate::operator()(const size_t index) const
+{
+    return bin_index(m_bboxes[index].center(m_dim), m_min, m_scale) <= m_bin;
+}
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_BINNEDSAHPARTITIONER_H
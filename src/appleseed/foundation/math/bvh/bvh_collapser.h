@@ -0,0 +1,213 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_COLLAPSER_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_COLLAPSER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Collapse the binary hierarchy of a BVH into a hierarchy of wide nodes.
+//
+// Each wide node is built by repeatedly opening the interior child with the
+// largest surface area until the node is full or only leaves are left.
+// The binary nodes of the tree are left untouched: leaf children of wide
+// nodes refer to them, and they remain usable for motion blur traversal.
+//
+// Reference:
+//
+//   Shallow Bounding Volume Hierarchies for Fast SIMD Ray Tracing of Incoherent Rays
+//   H. Dammertz, J. Hanika, A. Keller
+//   Eurographics Symposium on Rendering 2008.
+//
+
+template <typename Tree>
+class Collapser
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    Collapser();
+
+    // Collapse a tree. Does nothing if the root of the tree is a leaf.
+    template <typename Timer>
+    void collapse(Tree& tree);
+
+    // Return the collapse time.
+    double get_collapse_time() const;
+
+  private:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename Tree::WideNodeType WideNodeType;
+    typedef typename NodeType::AABBType AABBType;
+    typedef typename AABBType::ValueType ValueType;
+
+    struct Child
+    {
+        size_t      m_node_index;
+        AABBType    m_bbox;
+    };
+
+    double m_collapse_time;
+
+    // Recursively collapse the tree.
+    size_t collapse_recurse(
+        Tree&           tree,
+        const size_t    node_index);
+};
+
+
+//
+// Collapser class implementation.
+//
+
+template <typename Tree>
+Collapser<Tree>::Collapser()
+  : m_collapse_time(0.0)
+{
+}
+
+template <typename Tree>
+template <typename Timer>
+void Collapser<Tree>::collapse(Tree& tree)
+{
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    // Clear the wide nodes.
+    tree.m_wide_nodes.clear();
+
+    if (!tree.m_nodes.empty() && tree.m_nodes[0].is_interior())
+    {
+        // A full wide node replaces Width - 1 interior binary nodes.
+        const size_t interior_node_count = tree.m_nodes.size() / 2;
+        tree.m_wide_nodes.reserve(interior_node_count / (WideNodeType::Width - 1) + 1);
+
+        collapse_recurse(tree, 0);
+    }
+
+    // Measure and save collapse time.
+    stopwatch.measure();
+    m_collapse_time = stopwatch.get_seconds();
+}
+
+template <typename Tree>
+inline double Collapser<Tree>::get_collapse_time() const
+{
+    return m_collapse_time;
+}
+
+template <typename Tree>
+size_t Collapser<Tree>::collapse_recurse(
+    Tree&               tree,
+    const size_t        node_index)
+{
+    assert(tree.m_nodes[node_index].is_interior());
+
+    // Start with the two children of the binary node.
+    Child children[WideNodeType::Width];
+    size_t child_count = 2;
+    {
+        const NodeType& node = tree.m_nodes[node_index];
+        children[0].m_node_index = node.get_child_node_index();
+        children[0].m_bbox = node.get_left_bbox();
+        children[1].m_node_index = node.get_child_node_index() + 1;
+        children[1].m_bbox = node.get_right_bbox();
+    }
+
+    // Open the interior child with the largest surface area until the wide node is full.
+    while (child_count < WideNodeType::Width)
+    {
+        size_t best_child = ~size_t(0);
+        ValueType best_area(-1.0);
+
+        for (size_t i = 0; i < child_count; ++i)
+        {
+            if (tree.m_nodes[children[i].m_node_index].is_interior())
+            {
+                const ValueType area = half_surface_area(children[i].m_bbox);
+                if (area > best_area)
+                {
+                    best_area = area;
+                    best_child = i;
+                }
+            }
+        }
+
+        if (best_child == ~size_t(0))
+            break;
+
+        const NodeType& node = tree.m_nodes[children[best_child].m_node_index];
+        children[child_count].m_node_index = node.get_child_node_index() + 1;
+        children[child_count].m_bbox = node.get_right_bbox();
+        children[best_child].m_node_index = node.get_child_node_index();
+        children[best_child].m_bbox = node.get_left_bbox();
+        ++child_count;
+    }
+
+    // Allocate the wide node before recursing so that the root ends up at index 0.
+    const size_t wide_node_index = tree.m_wide_nodes.size();
+    tree.m_wide_nodes.push_back(WideNodeType());
+
+    // Recursively collapse the interior children.
+    size_t child_indices[WideNodeType::Width];
+    for (size_t i = 0; i < child_count; ++i)
+    {
+        child_indices[i] =
+            tree.m_nodes[children[i].m_node_index].is_interior()
+                ? collapse_recurse(tree, children[i].m_node_index)
+                : children[i].m_node_index;
+    }
+
+    // Fill the wide node.
+    WideNodeType& wide_node = tree.m_wide_nodes[wide_node_index];
+    for (size_t i = 0; i < child_count; ++i)
+    {
+        wide_node.add_child(
+            children[i].m_bbox,
+            child_indices[i],
+            tree.m_nodes[children[i].m_node_index].is_leaf());
+    }
+
+    return wide_node_index;
+}
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_COLLAPSER_H
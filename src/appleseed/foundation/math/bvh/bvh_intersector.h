@@ -32,7 +32,9 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_quantizedintersector.h"
 #include "foundation/math/bvh/bvh_statistics.h"
+#include "foundation/math/bvh/bvh_wideintersector.h"
 #include "foundation/math/intersection/rayaabb.h"
 #include "foundation/math/ray.h"
 #include "foundation/math/scalar.h"
@@ -40,26 +42,22 @@
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/sse.h"
 #endif
+#include "foundation/platform/types.h"
 
 // Standard headers.
 #include <cassert>
 #include <cstddef>
 
-// Enable or disable BVH traversal statistics.
-#undef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-
-#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
-#define FOUNDATION_BVH_TRAVERSAL_STATS(x) x
-#else
-#define FOUNDATION_BVH_TRAVERSAL_STATS(x)
-#endif
-
 namespace foundation {
 namespace bvh {
 
 //
 // BVH intersector.
 //
+// Rays are intersected against the quantized or wide node hierarchy of the tree,
+// if present, using bvh::QuantizedIntersector or bvh::WideIntersector. Motion
+// blur traversal always uses binary nodes.
+//
 // The Visitor class must conform to the following prototype:
 //
 //      class Visitor
@@ -96,7 +94,8 @@ class Intersector
     typedef Ray RayType;
     typedef RayInfo<ValueType, NodeType::Dimension> RayInfoType;
 
-    // Intersect a ray with a given BVH without motion.
+    // Intersect a ray with a given BVH without motion. Subtrees whose visibility
+    // mask doesn't intersect 'ray_mask' are skipped.
     void intersect_no_motion(
         const Tree&             tree,
         const RayType&          ray,
@@ -105,9 +104,12 @@ class Intersector
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , TraversalStatistics&  stats
 #endif
+        , TraversalCounters*    counters = 0
+        , const uint32          ray_mask = ~0
         ) const;
 
-    // Intersect a ray with a given BVH with motion.
+    // Intersect a ray with a given BVH with motion. Subtrees whose visibility
+    // mask doesn't intersect 'ray_mask' are skipped.
     void intersect_motion(
         const Tree&             tree,
         const RayType&          ray,
@@ -117,6 +119,8 @@ class Intersector
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , TraversalStatistics&  stats
 #endif
+        , TraversalCounters*    counters = 0
+        , const uint32          ray_mask = ~0
         ) const;
 };
 
@@ -145,11 +149,61 @@ void Intersector<Tree, Visitor, Ray, StackSize, N>::intersect_no_motion(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     , TraversalStatistics&      stats
 #endif
+    , TraversalCounters*        counters
+    , const uint32              ray_mask
     ) const
 {
     // Make sure the tree was built.
     assert(!tree.m_nodes.empty());
 
+    // Traverse the quantized node hierarchy instead if the tree has one.
+    if (!tree.m_quantized_nodes.empty())
+    {
+        QuantizedIntersector<
+            Tree,
+            Visitor,
+            Ray,
+            StackSize
+        > quantized_intersector;
+
+        quantized_intersector.intersect_no_motion(
+            tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            , counters
+            );
+
+        return;
+    }
+
+    // Traverse the wide node hierarchy instead if the tree has one.
+    if (!tree.m_wide_nodes.empty())
+    {
+        WideIntersector<
+            Tree,
+            Visitor,
+            Ray,
+            StackSize * (Tree::WideNodeType::Width - 1)
+        > wide_intersector;
+
+        wide_intersector.intersect_no_motion(
+            tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            , counters
+            );
+
+        return;
+    }
+
     // Node stack.
     const NodeType* stack[StackSize];
     const NodeType** stack_ptr = stack;
@@ -164,12 +218,17 @@ void Intersector<Tree, Visitor, Ray, StackSize, N>::intersect_no_motion(
     FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
     FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
 
+    // Initialize traversal counters.
+    size_t node_count = 0;
+    size_t leaf_count = 0;
+
     // Traverse the tree and intersect leaf nodes.
     ValueType ray_tmax = ray.m_tmax;
     while (true)
     {
         // Fetch the node.
         FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+        ++node_count;
 
         if (node_ptr->is_interior())
         {
@@ -179,10 +238,12 @@ void Intersector<Tree, Visitor, Ray, StackSize, N>::intersect_no_motion(
 
             // Intersect the left bounding box.
             const size_t hit_left =
+                (node_ptr->get_left_mask() & ray_mask) != 0 &&
                 foundation::intersect(ray, ray_info, node_ptr->get_left_bbox(), tmin[0]) && tmin[0] < ray_tmax ? 1 : 0;
 
             // Intersect the right bounding box.
             const size_t hit_right =
+                (node_ptr->get_right_mask() & ray_mask) != 0 &&
                 foundation::intersect(ray, ray_info, node_ptr->get_right_bbox(), tmin[1]) && tmin[1] < ray_tmax ? 1 : 0;
 
             node_ptr = &tree.m_nodes[node_ptr->get_child_node_index()];
@@ -218,6 +279,7 @@ void Intersector<Tree, Visitor, Ray, StackSize, N>::intersect_no_motion(
         {
             // Visit the leaf.
             FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            ++leaf_count;
             ValueType distance;
 #ifndef NDEBUG
             distance = ValueType(-1.0);
@@ -256,6 +318,13 @@ void Intersector<Tree, Visitor, Ray, StackSize, N>::intersect_no_motion(
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+
+    // Update traversal counters.
+    if (counters)
+    {
+        counters->m_visited_nodes += node_count;
+        counters->m_visited_leaves += leaf_count;
+    }
 }
 
 #if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)))
@@ -278,11 +347,16 @@ void Intersector<Tree, Visitor, Ray, StackSize, N>::intersect_motion(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     , TraversalStatistics&      stats
 #endif
+    , TraversalCounters*        counters
+    , const uint32              ray_mask
     ) const
 {
     // Make sure the tree was built.
     assert(!tree.m_nodes.empty());
 
+    // Quantized trees can only be traversed without motion.
+    assert(tree.m_quantized_nodes.empty());
+
     // Node stack.
     const NodeType* stack[StackSize];
     const NodeType** stack_ptr = stack;
@@ -297,12 +371,17 @@ void Intersector<Tree, Visitor, Ray, StackSize, N>::intersect_motion(
     FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
     FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
 
+    // Initialize traversal counters.
+    size_t node_count = 0;
+    size_t leaf_count = 0;
+
     // Traverse the tree and intersect leaf nodes.
     ValueType ray_tmax = ray.m_tmax;
     while (true)
     {
         // Fetch the node.
         FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+        ++node_count;
 
         if (node_ptr->is_interior())
         {
@@ -352,6 +431,11 @@ void Intersector<Tree, Visitor, Ray, StackSize, N>::intersect_motion(
                 hit_right = (foundation::intersect(ray, ray_info, node_ptr->get_right_bbox(), tmin[1]) && tmin[1] < ray_tmax) ? 1 : 0;
             }
 
+            // Skip the child nodes that don't contain any item visible to this ray.
+            const int visible_children = node_ptr->get_visible_children(ray_mask);
+            hit_left &= visible_children & 1;
+            hit_right &= visible_children >> 1;
+
             node_ptr = &tree.m_nodes[node_ptr->get_child_node_index()];
             node_ptr += hit_right;
 
@@ -385,6 +469,7 @@ void Intersector<Tree, Visitor, Ray, StackSize, N>::intersect_motion(
         {
             // Visit the leaf.
             FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            ++leaf_count;
             ValueType distance;
 #ifndef NDEBUG
             distance = ValueType(-1.0);
@@ -423,6 +508,13 @@ void Intersector<Tree, Visitor, Ray, StackSize, N>::intersect_motion(
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+
+    // Update traversal counters.
+    if (counters)
+    {
+        counters->m_visited_nodes += node_count;
+        counters->m_visited_leaves += leaf_count;
+    }
 }
 
 #ifdef APPLESEED_USE_SSE
@@ -441,7 +533,8 @@ class Intersector<Tree, Visitor, Ray3d, StackSize, 3>
     typedef Ray3d RayType;
     typedef RayInfo3d RayInfoType;
 
-    // Intersect a ray with a given BVH without motion.
+    // Intersect a ray with a given BVH without motion. Subtrees whose visibility
+    // mask doesn't intersect 'ray_mask' are skipped.
     void intersect_no_motion(
         const Tree&             tree,
         const RayType&          ray,
@@ -450,9 +543,12 @@ class Intersector<Tree, Visitor, Ray3d, StackSize, 3>
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , TraversalStatistics&  stats
 #endif
+        , TraversalCounters*    counters = 0
+        , const uint32          ray_mask = ~0
         ) const;
 
-    // Intersect a ray with a given BVH with motion.
+    // Intersect a ray with a given BVH with motion. Subtrees whose visibility
+    // mask doesn't intersect 'ray_mask' are skipped.
     void intersect_motion(
         const Tree&             tree,
         const RayType&          ray,
@@ -462,6 +558,8 @@ class Intersector<Tree, Visitor, Ray3d, StackSize, 3>
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , TraversalStatistics&  stats
 #endif
+        , TraversalCounters*    counters = 0
+        , const uint32          ray_mask = ~0
         ) const;
 };
 
@@ -478,11 +576,61 @@ void Intersector<Tree, Visitor, Ray3d, StackSize, 3>::intersect_no_motion(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     , TraversalStatistics&      stats
 #endif
+    , TraversalCounters*        counters
+    , const uint32              ray_mask
     ) const
 {
     // Make sure the tree was built.
     assert(!tree.m_nodes.empty());
 
+    // Traverse the quantized node hierarchy instead if the tree has one.
+    if (!tree.m_quantized_nodes.empty())
+    {
+        QuantizedIntersector<
+            Tree,
+            Visitor,
+            Ray3d,
+            StackSize
+        > quantized_intersector;
+
+        quantized_intersector.intersect_no_motion(
+            tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            , counters
+            );
+
+        return;
+    }
+
+    // Traverse the wide node hierarchy instead if the tree has one.
+    if (!tree.m_wide_nodes.empty())
+    {
+        WideIntersector<
+            Tree,
+            Visitor,
+            Ray3d,
+            StackSize * (Tree::WideNodeType::Width - 1)
+        > wide_intersector;
+
+        wide_intersector.intersect_no_motion(
+            tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            , counters
+            );
+
+        return;
+    }
+
     // Load the ray into SSE registers.
     const __m128d org_x = _mm_set1_pd(ray.m_org.x);
     const __m128d org_y = _mm_set1_pd(ray.m_org.y);
@@ -506,12 +654,17 @@ void Intersector<Tree, Visitor, Ray3d, StackSize, 3>::intersect_no_motion(
     FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
     FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
 
+    // Initialize traversal counters.
+    size_t node_count = 0;
+    size_t leaf_count = 0;
+
     // Traverse the tree and intersect leaf nodes.
     ValueType rtmax = ray.m_tmax;
     while (true)
     {
         // Fetch the node.
         FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+        ++node_count;
 
         if (node_ptr->is_interior())
         {
@@ -529,12 +682,13 @@ void Intersector<Tree, Visitor, Ray3d, StackSize, 3>::intersect_no_motion(
             const __m128d tmax = _mm_min_pd(zl2, _mm_min_pd(yl2, _mm_min_pd(xl2, ray_tmax)));
 
             const int hits =
-                _mm_movemask_pd(
+                (_mm_movemask_pd(
                     _mm_or_pd(
                         _mm_cmpgt_pd(tmin, tmax),
                         _mm_or_pd(
                             _mm_cmplt_pd(tmax, ray_tmin),
-                            _mm_cmpge_pd(tmin, ray_tmax)))) ^ 3;
+                            _mm_cmpge_pd(tmin, ray_tmax)))) ^ 3)
+                & node_ptr->get_visible_children(ray_mask);
 
             const size_t hit_left = hits & 1;
             const size_t hit_right = hits >> 1;
@@ -576,6 +730,7 @@ void Intersector<Tree, Visitor, Ray3d, StackSize, 3>::intersect_no_motion(
         {
             // Visit the leaf.
             FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            ++leaf_count;
             ValueType distance;
 #ifndef NDEBUG
             distance = ValueType(-1.0);
@@ -614,6 +769,13 @@ void Intersector<Tree, Visitor, Ray3d, StackSize, 3>::intersect_no_motion(
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+
+    // Update traversal counters.
+    if (counters)
+    {
+        counters->m_visited_nodes += node_count;
+        counters->m_visited_leaves += leaf_count;
+    }
 }
 
 template <
@@ -630,11 +792,16 @@ void Intersector<Tree, Visitor, Ray3d, StackSize, 3>::intersect_motion(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     , TraversalStatistics&      stats
 #endif
+    , TraversalCounters*        counters
+    , const uint32              ray_mask
     ) const
 {
     // Make sure the tree was built.
     assert(!tree.m_nodes.empty());
 
+    // Quantized trees can only be traversed without motion.
+    assert(tree.m_quantized_nodes.empty());
+
     // Load the ray into SSE registers.
     const __m128d org_x = _mm_set1_pd(ray.m_org.x);
     const __m128d org_y = _mm_set1_pd(ray.m_org.y);
@@ -662,12 +829,17 @@ void Intersector<Tree, Visitor, Ray3d, StackSize, 3>::intersect_motion(
     FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
     FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
 
+    // Initialize traversal counters.
+    size_t node_count = 0;
+    size_t leaf_count = 0;
+
     // Traverse the tree and intersect leaf nodes.
     ValueType rtmax = ray.m_tmax;
     while (true)
     {
         // Fetch the node.
         FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+        ++node_count;
 
         if (node_ptr->is_interior())
         {
@@ -804,12 +976,13 @@ void Intersector<Tree, Visitor, Ray3d, StackSize, 3>::intersect_motion(
             }
 
             const int hits =
-                _mm_movemask_pd(
+                (_mm_movemask_pd(
                     _mm_or_pd(
                         _mm_cmpgt_pd(tmin, tmax),
                         _mm_or_pd(
                             _mm_cmplt_pd(tmax, ray_tmin),
-                            _mm_cmpge_pd(tmin, ray_tmax)))) ^ 3;
+                            _mm_cmpge_pd(tmin, ray_tmax)))) ^ 3)
+                & node_ptr->get_visible_children(ray_mask);
 
             const size_t hit_left = hits & 1;
             const size_t hit_right = hits >> 1;
@@ -850,6 +1023,7 @@ void Intersector<Tree, Visitor, Ray3d, StackSize, 3>::intersect_motion(
         {
             // Visit the leaf.
             FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            ++leaf_count;
             ValueType distance;
 #ifndef NDEBUG
             distance = ValueType(-1.0);
@@ -888,6 +1062,13 @@ void Intersector<Tree, Visitor, Ray3d, StackSize, 3>::intersect_motion(
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
     FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+
+    // Update traversal counters.
+    if (counters)
+    {
+        counters->m_visited_nodes += node_count;
+        counters->m_visited_leaves += leaf_count;
+    }
 }
 
 #endif  // APPLESEED_USE_SSE
@@ -0,0 +1,126 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_MASKER_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_MASKER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Compute the visibility masks of the interior nodes of a BVH, bottom-up, from
+// the visibility masks of its items. The mask of a child node is the union of
+// the masks of all the items of its subtree, which lets the intersector skip
+// subtrees that don't contain any item visible to a given ray.
+//
+
+template <typename Tree>
+class Masker
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+
+    // Compute the masks of the interior nodes of a tree. 'item_masks' are the
+    // visibility masks of the items, in tree order. Return the mask of the tree.
+    template <typename MaskVector>
+    uint32 compute_masks(
+        Tree&               tree,
+        const MaskVector&   item_masks) const;
+
+  private:
+    // Recursively compute the masks of a subtree. Return the mask of its root.
+    template <typename MaskVector>
+    uint32 compute_masks_recurse(
+        Tree&               tree,
+        const MaskVector&   item_masks,
+        const size_t        node_index) const;
+};
+
+
+//
+// Masker class implementation.
+//
+
+template <typename Tree>
+template <typename MaskVector>
+uint32 Masker<Tree>::compute_masks(
+    Tree&                   tree,
+    const MaskVector&       item_masks) const
+{
+    return tree.m_nodes.empty() ? 0 : compute_masks_recurse(tree, item_masks, 0);
+}
+
+template <typename Tree>
+template <typename MaskVector>
+uint32 Masker<Tree>::compute_masks_recurse(
+    Tree&                   tree,
+    const MaskVector&       item_masks,
+    const size_t            node_index) const
+{
+    NodeType& node = tree.m_nodes[node_index];
+
+    if (node.is_interior())
+    {
+        const size_t child_node_index = node.get_child_node_index();
+        const uint32 left_mask = compute_masks_recurse(tree, item_masks, child_node_index);
+        const uint32 right_mask = compute_masks_recurse(tree, item_masks, child_node_index + 1);
+
+        // The node reference stays valid: the node array is not resized.
+        node.set_left_mask(left_mask);
+        node.set_right_mask(right_mask);
+
+        return left_mask | right_mask;
+    }
+    else
+    {
+        const size_t item_begin = node.get_item_index();
+        const size_t item_end = item_begin + node.get_item_count();
+        assert(item_end <= item_masks.size());
+
+        uint32 mask = 0;
+
+        for (size_t i = item_begin; i < item_end; ++i)
+            mask |= static_cast<uint32>(item_masks[i]);
+
+        return mask;
+    }
+}
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_MASKER_H
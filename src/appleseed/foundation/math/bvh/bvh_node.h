@@ -76,6 +76,18 @@ class APPLESEED_ALIGN(64) Node
     size_t get_right_bbox_index() const;
     size_t get_right_bbox_count() const;
 
+    // Set/get the visibility masks of the child nodes (interior nodes only). The mask
+    // of a child is the union of the masks of the items of its subtree. Nodes whose
+    // masks were never set are visible to all rays.
+    void set_left_mask(const uint32 mask);
+    void set_right_mask(const uint32 mask);
+    uint32 get_left_mask() const;
+    uint32 get_right_mask() const;
+
+    // Return the child nodes visible to rays with a given mask: bit 0 is set if the
+    // left child is visible, bit 1 is set if the right child is visible.
+    int get_visible_children(const uint32 ray_mask) const;
+
     // Access user data (leaf nodes only).
     static const size_t MaxUserDataSize;
     template <typename U> void set_user_data(const U& data);
@@ -107,6 +119,8 @@ class APPLESEED_ALIGN(64) Node
     uint32                          m_left_bbox_count;
     uint32                          m_right_bbox_index;
     uint32                          m_right_bbox_count;
+    uint32                          m_left_hidden_mask;     // complement of the left child mask
+    uint32                          m_right_hidden_mask;    // complement of the right child mask
 
     APPLESEED_SIMD4_ALIGN ValueType m_bbox_data[4 * Dimension];
 };
@@ -241,6 +255,38 @@ inline size_t Node<AABB>::get_right_bbox_count() const
     return static_cast<uint32>(m_right_bbox_count);
 }
 
+template <typename AABB>
+inline void Node<AABB>::set_left_mask(const uint32 mask)
+{
+    m_left_hidden_mask = ~mask;
+}
+
+template <typename AABB>
+inline void Node<AABB>::set_right_mask(const uint32 mask)
+{
+    m_right_hidden_mask = ~mask;
+}
+
+template <typename AABB>
+inline uint32 Node<AABB>::get_left_mask() const
+{
+    return ~m_left_hidden_mask;
+}
+
+template <typename AABB>
+inline uint32 Node<AABB>::get_right_mask() const
+{
+    return ~m_right_hidden_mask;
+}
+
+template <typename AABB>
+inline int Node<AABB>::get_visible_children(const uint32 ray_mask) const
+{
+    return
+        ((get_left_mask() & ray_mask) != 0 ? 1 : 0) |
+        ((get_right_mask() & ray_mask) != 0 ? 2 : 0);
+}
+
 #define MAX_USER_DATA_SIZE (4 * Node<AABB>::Dimension * sizeof(typename AABB::ValueType))
 
 template <typename AABB>
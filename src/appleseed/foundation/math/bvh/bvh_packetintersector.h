@@ -0,0 +1,363 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_PACKETINTERSECTOR_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_PACKETINTERSECTOR_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_statistics.h"
+#include "foundation/math/minmax.h"
+#include "foundation/math/ray.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// BVH packet intersector.
+//
+// Traverses a BVH with a packet of up to MaxPacketSize rays at once: each node
+// is fetched once for all the rays of the packet that reach it. The rays of a
+// packet must be coherent, i.e. their directions must lie in the same octant
+// (see is_coherent()); incoherent packets must be traced one ray at a time.
+//
+// Ray origins and inverse directions are gathered in structure-of-arrays form
+// before traversal. Rays that do not hit a node are masked out of its subtree.
+//
+// The Visitor class must conform to the following prototype:
+//
+//      class Visitor
+//        : public foundation::NonCopyable
+//      {
+//        public:
+//          // Return whether BVH traversal should continue or not for a given ray.
+//          // 'distance' should be set to the distance to the closest hit so far.
+//          bool visit(
+//              const NodeType&             node,
+//              const size_t                ray_index,
+//              const RayType&              ray,
+//              const RayInfoType&          ray_info,
+//              ValueType&                  distance
+//      #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+//              , TraversalStatistics&      stats
+//      #endif
+//              );
+//      };
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize = 64
+>
+class PacketIntersector
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename NodeType::AABBType AABBType;
+    typedef typename AABBType::ValueType ValueType;
+    typedef Ray RayType;
+    typedef RayInfo<ValueType, AABBType::Dimension> RayInfoType;
+
+    // Maximum number of rays in a packet.
+    static const size_t MaxPacketSize = 32;
+
+    // Return true if the directions of a set of rays all lie in the same octant.
+    static bool is_coherent(
+        const RayInfoType       ray_infos[],
+        const size_t            ray_count);
+
+    // Intersect a coherent packet of rays with a given BVH without motion.
+    void intersect_no_motion(
+        const Tree&             tree,
+        const RayType* const    rays[],
+        const RayInfoType       ray_infos[],
+        const size_t            ray_count,
+        Visitor&                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , TraversalStatistics&  stats
+#endif
+        ) const;
+
+  private:
+    static const size_t Dimension = AABBType::Dimension;
+
+    struct StackEntry
+    {
+        const NodeType*         m_node;
+        uint32                  m_mask;
+    };
+};
+
+
+//
+// PacketIntersector class implementation.
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize
+>
+bool PacketIntersector<Tree, Visitor, Ray, StackSize>::is_coherent(
+    const RayInfoType           ray_infos[],
+    const size_t                ray_count)
+{
+    for (size_t i = 1; i < ray_count; ++i)
+    {
+        for (size_t d = 0; d < Dimension; ++d)
+        {
+            if (ray_infos[i].m_sgn_dir[d] != ray_infos[0].m_sgn_dir[d])
+                return false;
+        }
+    }
+
+    return true;
+}
+
+#if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)))
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize
+>
+void PacketIntersector<Tree, Visitor, Ray, StackSize>::intersect_no_motion(
+    const Tree&                 tree,
+    const RayType* const        rays[],
+    const RayInfoType           ray_infos[],
+    const size_t                ray_count,
+    Visitor&                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , TraversalStatistics&      stats
+#endif
+    ) const
+{
+    // Make sure the tree was built.
+    assert(!tree.m_nodes.empty());
+    assert(tree.m_quantized_nodes.empty());
+    assert(ray_count > 0);
+    assert(ray_count <= MaxPacketSize);
+    assert(is_coherent(ray_infos, ray_count));
+
+    // Gather the rays in structure-of-arrays form.
+    ValueType org[Dimension][MaxPacketSize];
+    ValueType rcp_dir[Dimension][MaxPacketSize];
+    ValueType ray_tmin[MaxPacketSize];
+    ValueType ray_tmax[MaxPacketSize];
+    for (size_t i = 0; i < ray_count; ++i)
+    {
+        for (size_t d = 0; d < Dimension; ++d)
+        {
+            org[d][i] = rays[i]->m_org[d];
+            rcp_dir[d][i] = ray_infos[i].m_rcp_dir[d];
+        }
+
+        ray_tmin[i] = rays[i]->m_tmin;
+        ray_tmax[i] = rays[i]->m_tmax;
+    }
+
+    // All the rays of the packet share the same direction signs.
+    size_t near_side[Dimension];
+    for (size_t d = 0; d < Dimension; ++d)
+        near_side[d] = 1 - ray_infos[0].m_sgn_dir[d];
+
+    // Rays for which traversal is still ongoing.
+    uint32 alive_mask =
+        ray_count == MaxPacketSize ? ~uint32(0) : (uint32(1) << ray_count) - 1;
+
+    // Node stack.
+    StackEntry stack[StackSize];
+    StackEntry* stack_ptr = stack;
+
+    // Current node.
+    const NodeType* node_ptr = &tree.m_nodes[0];
+    uint32 node_mask = alive_mask;
+
+    // Initialize traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_traversal_count += ray_count);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_nodes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_leaves = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
+
+    // Traverse the tree and intersect leaf nodes.
+    while (true)
+    {
+        // Fetch the node.
+        FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+
+        if (node_ptr->is_interior())
+        {
+            const AABBType child_bboxes[2] =
+            {
+                node_ptr->get_left_bbox(),
+                node_ptr->get_right_bbox()
+            };
+
+            // Intersect the bounding boxes of both children with all active rays.
+            uint32 child_masks[2] = { 0, 0 };
+            size_t hit_both_count = 0;
+            size_t left_first_count = 0;
+            for (uint32 mask = node_mask; mask; mask &= mask - 1)
+            {
+                size_t i = 0;
+                while (!(mask & (uint32(1) << i)))
+                    ++i;
+
+                FOUNDATION_BVH_TRAVERSAL_STATS(intersected_bboxes += 2);
+
+                ValueType tmin[2];
+                for (size_t c = 0; c < 2; ++c)
+                {
+                    ValueType t0 = ray_tmin[i];
+                    ValueType t1 = ray_tmax[i];
+                    for (size_t d = 0; d < Dimension; ++d)
+                    {
+                        t0 = ssemax(t0, rcp_dir[d][i] * (child_bboxes[c][    near_side[d]][d] - org[d][i]));
+                        t1 = ssemin(t1, rcp_dir[d][i] * (child_bboxes[c][1 - near_side[d]][d] - org[d][i]));
+                    }
+                    tmin[c] = t0;
+
+                    if (!(t0 > t1 || t1 < ray_tmin[i] || t0 >= ray_tmax[i]))
+                        child_masks[c] |= uint32(1) << i;
+                }
+
+                if (child_masks[0] & child_masks[1] & (uint32(1) << i))
+                {
+                    ++hit_both_count;
+                    if (tmin[0] < tmin[1])
+                        ++left_first_count;
+                }
+            }
+
+            const NodeType* child_ptr = &tree.m_nodes[node_ptr->get_child_node_index()];
+
+            if (child_masks[0] && child_masks[1])
+            {
+                // Push the far child node to the stack, continue with the child node
+                // that is nearest for the majority of the rays that hit both children.
+                const size_t near_index = 2 * left_first_count >= hit_both_count ? 0 : 1;
+                assert(stack_ptr < stack + StackSize);
+                stack_ptr->m_node = child_ptr + (1 - near_index);
+                stack_ptr->m_mask = child_masks[1 - near_index];
+                ++stack_ptr;
+                node_ptr = child_ptr + near_index;
+                node_mask = child_masks[near_index];
+                continue;
+            }
+
+            if (child_masks[0] | child_masks[1])
+            {
+                // Continue with the left or right child node.
+                FOUNDATION_BVH_TRAVERSAL_STATS(++discarded_nodes);
+                const size_t index = child_masks[0] ? 0 : 1;
+                node_ptr = child_ptr + index;
+                node_mask = child_masks[index];
+                continue;
+            }
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += 2);
+        }
+        else
+        {
+            // Visit the leaf with all active rays.
+            FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            for (uint32 mask = node_mask; mask; mask &= mask - 1)
+            {
+                size_t i = 0;
+                while (!(mask & (uint32(1) << i)))
+                    ++i;
+
+                ValueType distance;
+#ifndef NDEBUG
+                distance = ValueType(-1.0);
+#endif
+                const bool proceed =
+                    visitor.visit(
+                        *node_ptr,
+                        i,
+                        *rays[i],
+                        ray_infos[i],
+                        distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                        , stats
+#endif
+                        );
+                assert(!proceed || distance >= ValueType(0.0));
+
+                // Terminate traversal for this ray if the visitor decided so.
+                if (!proceed)
+                    alive_mask &= ~(uint32(1) << i);
+
+                // Keep track of the distance to the closest intersection.
+                else if (ray_tmax[i] > distance)
+                    ray_tmax[i] = distance;
+            }
+        }
+
+        // Pop the top node from the stack, skipping nodes that no active ray needs.
+        node_mask = 0;
+        while (stack_ptr > stack && node_mask == 0)
+        {
+            --stack_ptr;
+            node_ptr = stack_ptr->m_node;
+            node_mask = stack_ptr->m_mask & alive_mask;
+        }
+
+        // Terminate traversal if the node stack is empty.
+        if (node_mask == 0)
+            break;
+    }
+
+    // Store traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_nodes.insert(visited_nodes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+}
+
+#if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)))
+#pragma GCC diagnostic pop
+#endif
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_PACKETINTERSECTOR_H
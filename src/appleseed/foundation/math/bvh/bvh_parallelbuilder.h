@@ -0,0 +1,517 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_PARALLELBUILDER_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_PARALLELBUILDER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class Logger; }
+
+namespace foundation {
+namespace bvh {
+
+//
+// Multithreaded BVH builder.
+//
+// The top of the tree is built on the calling thread until the sets of items
+// become small enough; the remaining subtrees are then built concurrently by
+// a pool of worker threads and finally appended to the node array of the tree.
+// The resulting tree has the same node format as the one built by Builder.
+//
+// The Partitioner class must conform to the prototype documented in Builder,
+// with the additional requirement that partition() and compute_bbox() may be
+// called concurrently on disjoint sets of items (see BinnedSAHPartitioner).
+//
+
+template <typename Tree, typename Partitioner>
+class ParallelBuilder
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    ParallelBuilder();
+
+    // Build a tree.
+    template <typename Timer>
+    void build(
+        Tree&           tree,
+        Partitioner&    partitioner,
+        const size_t    size,
+        const size_t    items_per_leaf_hint,
+        Logger&         logger,
+        const size_t    thread_count);
+
+    // Return the total construction time.
+    double get_build_time() const;
+
+    // Return the time spent building the top of the tree.
+    double get_top_level_build_time() const;
+
+    // Return the time spent building the subtrees.
+    double get_subtrees_build_time() const;
+
+    // Return the time spent merging the subtrees into the tree.
+    double get_merge_time() const;
+
+    // Return the number of subtrees built by worker threads.
+    size_t get_subtree_count() const;
+
+  private:
+    typedef typename Tree::NodeVectorType NodeVectorType;
+    typedef typename Tree::NodeType NodeType;
+    typedef typename NodeType::AABBType AABBType;
+
+    // Minimum number of items in a subtree built by a worker thread.
+    static const size_t MinSubtreeSize = 1024;
+
+    // Targeted number of subtrees per worker thread, for load balancing.
+    static const size_t SubtreesPerThread = 8;
+
+    struct Subtree
+    {
+        size_t          m_node_index;       // index of the root of this subtree in the tree
+        size_t          m_begin;
+        size_t          m_end;
+        AABBType        m_bbox;
+        NodeVectorType  m_nodes;            // local nodes, the root is at index 0
+
+        explicit Subtree(const NodeVectorType& nodes);
+    };
+
+    class SubtreeJob
+      : public IJob
+    {
+      public:
+        SubtreeJob(
+            Partitioner&    partitioner,
+            Subtree&        subtree);
+
+        virtual void execute(const size_t thread_index);
+
+      private:
+        Partitioner&        m_partitioner;
+        Subtree&            m_subtree;
+    };
+
+    double m_build_time;
+    double m_top_level_build_time;
+    double m_subtrees_build_time;
+    double m_merge_time;
+    size_t m_subtree_count;
+
+    // Recursively subdivide the top of the tree, collecting subtrees to build.
+    static void subdivide_top_level(
+        NodeVectorType&             nodes,
+        Partitioner&                partitioner,
+        const size_t                node_index,
+        const size_t                begin,
+        const size_t                end,
+        const AABBType&             bbox,
+        const size_t                subtree_size,
+        std::vector<Subtree*>&      subtrees);
+
+    // Recursively subdivide a subtree.
+    static void subdivide_recurse(
+        NodeVectorType&             nodes,
+        Partitioner&                partitioner,
+        const size_t                node_index,
+        const size_t                begin,
+        const size_t                end,
+        const AABBType&             bbox);
+
+    // Partition a set of items and turn a node into a leaf or interior node.
+    // Return the index of the first item in the right partition, or 'end'
+    // if the node was turned into a leaf.
+    static size_t subdivide_node(
+        NodeVectorType&             nodes,
+        Partitioner&                partitioner,
+        const size_t                node_index,
+        const size_t                begin,
+        const size_t                end,
+        const AABBType&             bbox,
+        AABBType&                   left_bbox,
+        AABBType&                   right_bbox);
+
+    // Append the nodes of a subtree to the tree.
+    static void merge_subtree(
+        NodeVectorType&             nodes,
+        const Subtree&              subtree);
+};
+
+
+//
+// ParallelBuilder class implementation.
+//
+
+template <typename Tree, typename Partitioner>
+ParallelBuilder<Tree, Partitioner>::ParallelBuilder()
+  : m_build_time(0.0)
+  , m_top_level_build_time(0.0)
+  , m_subtrees_build_time(0.0)
+  , m_merge_time(0.0)
+  , m_subtree_count(0)
+{
+}
+
+template <typename Tree, typename Partitioner>
+template <typename Timer>
+void ParallelBuilder<Tree, Partitioner>::build(
+    Tree&               tree,
+    Partitioner&        partitioner,
+    const size_t        size,
+    const size_t        items_per_leaf_hint,
+    Logger&             logger,
+    const size_t        thread_count)
+{
+    assert(thread_count > 0);
+
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    // Clear the tree.
+    tree.m_nodes.clear();
+
+    // Reserve memory for the nodes.
+    const size_t leaf_count_guess = size / items_per_leaf_hint;
+    const size_t node_count_guess = leaf_count_guess > 0 ? 2 * leaf_count_guess - 1 : 0;
+    tree.m_nodes.reserve(node_count_guess);
+
+    // Create the root node of the tree.
+    tree.m_nodes.push_back(NodeType());
+
+    // Compute the bounding box of the tree.
+    const AABBType root_bbox(partitioner.compute_bbox(0, size));
+
+    // Build the top of the tree.
+    const size_t subtree_size =
+        std::max<size_t>(size / (thread_count * SubtreesPerThread), MinSubtreeSize);
+    std::vector<Subtree*> subtrees;
+    subdivide_top_level(
+        tree.m_nodes,
+        partitioner,
+        0,              // node index
+        0,              // begin
+        size,           // end
+        root_bbox,
+        subtree_size,
+        subtrees);
+    m_top_level_build_time = stopwatch.measure().get_seconds();
+    m_subtree_count = subtrees.size();
+
+    // Build the subtrees in parallel.
+    if (!subtrees.empty())
+    {
+        JobQueue job_queue;
+
+        for (size_t i = 0; i < subtrees.size(); ++i)
+            job_queue.schedule(new SubtreeJob(partitioner, *subtrees[i]));
+
+        JobManager job_manager(
+            logger,
+            job_queue,
+            std::min(thread_count, subtrees.size()));
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+    }
+    m_subtrees_build_time = stopwatch.measure().get_seconds() - m_top_level_build_time;
+
+    // Merge the subtrees into the tree.
+    size_t total_node_count = tree.m_nodes.size();
+    for (size_t i = 0; i < subtrees.size(); ++i)
+        total_node_count += subtrees[i]->m_nodes.size() - 1;
+    tree.m_nodes.reserve(total_node_count);
+
+    for (size_t i = 0; i < subtrees.size(); ++i)
+    {
+        merge_subtree(tree.m_nodes, *subtrees[i]);
+        delete subtrees[i];
+    }
+
+    // Measure and save construction time.
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+    m_merge_time = m_build_time - m_top_level_build_time - m_subtrees_build_time;
+}
+
+template <typename Tree, typename Partitioner>
+inline double ParallelBuilder<Tree, Partitioner>::get_build_time() const
+{
+    return m_build_time;
+}
+
+template <typename Tree, typename Partitioner>
+inline double ParallelBuilder<Tree, Partitioner>::get_top_level_build_time() const
+{
+    return m_top_level_build_time;
+}
+
+template <typename Tree, typename Partitioner>
+inline double ParallelBuilder<Tree, Partitioner>::get_subtrees_build_time() const
+{
+    return m_subtrees_build_time;
+}
+
+template <typename Tree, typename Partitioner>
+inline double ParallelBuilder<Tree, Partitioner>::get_merge_time() const
+{
+    return m_merge_time;
+}
+
+template <typename Tree, typename Partitioner>
+inline size_t ParallelBuilder<Tree, Partitioner>::get_subtree_count() const
+{
+    return m_subtree_count;
+}
+
+template <typename Tree, typename Partitioner>
+void ParallelBuilder<Tree, Partitioner>::subdivide_top_level(
+    NodeVectorType&             nodes,
+    Partitioner&                partitioner,
+    const size_t                node_index,
+    const size_t                begin,
+    const size_t                end,
+    const AABBType&             bbox,
+    const size_t                subtree_size,
+    std::vector<Subtree*>&      subtrees)
+{
+    // Defer the construction of small enough subtrees to worker threads.
+    if (end - begin <= subtree_size)
+    {
+        Subtree* subtree = new Subtree(nodes);
+        subtree->m_node_index = node_index;
+        subtree->m_begin = begin;
+        subtree->m_end = end;
+        subtree->m_bbox = bbox;
+        subtrees.push_back(subtree);
+        return;
+    }
+
+    AABBType left_bbox, right_bbox;
+    const size_t pivot =
+        subdivide_node(
+            nodes,
+            partitioner,
+            node_index,
+            begin,
+            end,
+            bbox,
+            left_bbox,
+            right_bbox);
+
+    if (pivot < end)
+    {
+        const size_t left_node_index = nodes[node_index].get_child_node_index();
+
+        // Recurse into the left subtree.
+        subdivide_top_level(
+            nodes,
+            partitioner,
+            left_node_index,
+            begin,
+            pivot,
+            left_bbox,
+            subtree_size,
+            subtrees);
+
+        // Recurse into the right subtree.
+        subdivide_top_level(
+            nodes,
+            partitioner,
+            left_node_index + 1,
+            pivot,
+            end,
+            right_bbox,
+            subtree_size,
+            subtrees);
+    }
+}
+
+template <typename Tree, typename Partitioner>
+void ParallelBuilder<Tree, Partitioner>::subdivide_recurse(
+    NodeVectorType&             nodes,
+    Partitioner&                partitioner,
+    const size_t                node_index,
+    const size_t                begin,
+    const size_t                end,
+    const AABBType&             bbox)
+{
+    AABBType left_bbox, right_bbox;
+    const size_t pivot =
+        subdivide_node(
+            nodes,
+            partitioner,
+            node_index,
+            begin,
+            end,
+            bbox,
+            left_bbox,
+            right_bbox);
+
+    if (pivot < end)
+    {
+        const size_t left_node_index = nodes[node_index].get_child_node_index();
+
+        // Recurse into the left subtree.
+        subdivide_recurse(
+            nodes,
+            partitioner,
+            left_node_index,
+            begin,
+            pivot,
+            left_bbox);
+
+        // Recurse into the right subtree.
+        subdivide_recurse(
+            nodes,
+            partitioner,
+            left_node_index + 1,
+            pivot,
+            end,
+            right_bbox);
+    }
+}
+
+template <typename Tree, typename Partitioner>
+size_t ParallelBuilder<Tree, Partitioner>::subdivide_node(
+    NodeVectorType&             nodes,
+    Partitioner&                partitioner,
+    const size_t                node_index,
+    const size_t                begin,
+    const size_t                end,
+    const AABBType&             bbox,
+    AABBType&                   left_bbox,
+    AABBType&                   right_bbox)
+{
+    assert(node_index < nodes.size());
+
+    // Try to partition the set of items.
+    size_t pivot = end;
+    if (end - begin > 1)
+    {
+        pivot = partitioner.partition(begin, end, typename Partitioner::AABBType(bbox));
+        assert(pivot > begin);
+        assert(pivot <= end);
+    }
+
+    if (pivot == end)
+    {
+        // Turn the current node into a leaf node.
+        NodeType& node = nodes[node_index];
+        node.make_leaf();
+        node.set_item_index(begin);
+        node.set_item_count(end - begin);
+    }
+    else
+    {
+        // Compute the bounding box of the child nodes.
+        left_bbox = AABBType(partitioner.compute_bbox(begin, pivot));
+        right_bbox = AABBType(partitioner.compute_bbox(pivot, end));
+
+        // Turn the current node into an interior node.
+        NodeType& node = nodes[node_index];
+        node.make_interior();
+        node.set_left_bbox(left_bbox);
+        node.set_right_bbox(right_bbox);
+        node.set_child_node_index(nodes.size());
+
+        // Create the child nodes.
+        nodes.push_back(NodeType());
+        nodes.push_back(NodeType());
+    }
+
+    return pivot;
+}
+
+template <typename Tree, typename Partitioner>
+void ParallelBuilder<Tree, Partitioner>::merge_subtree(
+    NodeVectorType&             nodes,
+    const Subtree&              subtree)
+{
+    assert(!subtree.m_nodes.empty());
+
+    // Local node i > 0 is stored at index base + i - 1 in the tree.
+    const size_t base = nodes.size();
+
+    for (size_t i = 0; i < subtree.m_nodes.size(); ++i)
+    {
+        NodeType node = subtree.m_nodes[i];
+
+        if (node.is_interior())
+            node.set_child_node_index(base + node.get_child_node_index() - 1);
+
+        if (i == 0)
+            nodes[subtree.m_node_index] = node;
+        else nodes.push_back(node);
+    }
+}
+
+template <typename Tree, typename Partitioner>
+ParallelBuilder<Tree, Partitioner>::Subtree::Subtree(const NodeVectorType& nodes)
+  : m_nodes(nodes.get_allocator())
+{
+}
+
+template <typename Tree, typename Partitioner>
+ParallelBuilder<Tree, Partitioner>::SubtreeJob::SubtreeJob(
+    Partitioner&                partitioner,
+    Subtree&                    subtree)
+  : m_partitioner(partitioner)
+  , m_subtree(subtree)
+{
+}
+
+template <typename Tree, typename Partitioner>
+void ParallelBuilder<Tree, Partitioner>::SubtreeJob::execute(const size_t thread_index)
+{
+    m_subtree.m_nodes.push_back(NodeType());
+
+    subdivide_recurse(
+        m_subtree.m_nodes,
+        m_partitioner,
+        0,
+        m_subtree.m_begin,
+        m_subtree.m_end,
+        m_subtree.m_bbox);
+}
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_PARALLELBUILDER_H
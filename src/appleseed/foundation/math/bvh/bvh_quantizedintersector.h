@@ -0,0 +1,270 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_QUANTIZEDINTERSECTOR_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_QUANTIZEDINTERSECTOR_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_quantizednode.h"
+#include "foundation/math/bvh/bvh_statistics.h"
+#include "foundation/math/minmax.h"
+#include "foundation/math/ray.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Quantized BVH intersector.
+//
+// Traverses the quantized node hierarchy built by bvh::Quantizer. Leaves are
+// the binary leaf nodes of the tree, so the Visitor class must conform to the
+// same prototype as for bvh::Intersector.
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize = 64
+>
+class QuantizedIntersector
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename Tree::QuantizedNodeType QuantizedNodeType;
+    typedef typename QuantizedNodeType::ValueType ValueType;
+    typedef Ray RayType;
+    typedef RayInfo<ValueType, QuantizedNodeType::Dimension> RayInfoType;
+
+    // Intersect a ray with a given BVH without motion.
+    void intersect_no_motion(
+        const Tree&             tree,
+        const RayType&          ray,
+        const RayInfoType&      ray_info,
+        Visitor&                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , TraversalStatistics&  stats
+#endif
+        , TraversalCounters*    counters = 0
+        ) const;
+
+  private:
+    struct StackEntry
+    {
+        uint32                  m_index;
+        uint32                  m_is_leaf;
+        ValueType               m_tmin;
+    };
+};
+
+
+//
+// QuantizedIntersector class implementation.
+//
+
+#if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)))
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize
+>
+void QuantizedIntersector<Tree, Visitor, Ray, StackSize>::intersect_no_motion(
+    const Tree&                 tree,
+    const RayType&              ray,
+    const RayInfoType&          ray_info,
+    Visitor&                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , TraversalStatistics&      stats
+#endif
+    , TraversalCounters*        counters
+    ) const
+{
+    const size_t Dimension = QuantizedNodeType::Dimension;
+
+    // Make sure the quantized node hierarchy was built.
+    assert(!tree.m_quantized_nodes.empty());
+
+    // Node stack.
+    StackEntry stack[StackSize];
+    StackEntry* stack_ptr = stack;
+
+    // Current node.
+    size_t node_index = 0;
+    bool node_is_leaf = false;
+
+    // Initialize traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(++stats.m_traversal_count);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_nodes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_leaves = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
+
+    // Initialize traversal counters.
+    size_t node_count = 0;
+    size_t leaf_count = 0;
+
+    // Traverse the tree and intersect leaf nodes.
+    ValueType ray_tmax = ray.m_tmax;
+    while (true)
+    {
+        // Fetch the node.
+        FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+        ++node_count;
+
+        if (!node_is_leaf)
+        {
+            const QuantizedNodeType& node = tree.m_quantized_nodes[node_index];
+            FOUNDATION_BVH_TRAVERSAL_STATS(intersected_bboxes += 2);
+
+            // Intersect the dequantized bounding boxes of both children.
+            ValueType tmin[2];
+            bool hit[2];
+            for (size_t i = 0; i < 2; ++i)
+            {
+                ValueType child_tmin = ray.m_tmin;
+                ValueType child_tmax = ray_tmax;
+
+                for (size_t d = 0; d < Dimension; ++d)
+                {
+                    const size_t near_side = 1 - ray_info.m_sgn_dir[d];
+                    const ValueType near_plane = node.dequantize(d, node.m_bounds[i][near_side][d]);
+                    const ValueType far_plane = node.dequantize(d, node.m_bounds[i][1 - near_side][d]);
+                    child_tmin = ssemax(ray_info.m_rcp_dir[d] * (near_plane - ray.m_org[d]), child_tmin);
+                    child_tmax = ssemin(ray_info.m_rcp_dir[d] * (far_plane - ray.m_org[d]), child_tmax);
+                }
+
+                tmin[i] = child_tmin;
+                hit[i] = !(child_tmin > child_tmax || child_tmax < ray.m_tmin || child_tmin >= ray_tmax);
+            }
+
+            if (hit[0] && hit[1])
+            {
+                // Push the far child node to the stack, continue with the near child node.
+                const size_t near_child = tmin[0] < tmin[1] ? 0 : 1;
+                const size_t far_child = 1 - near_child;
+                assert(stack_ptr < stack + StackSize);
+                stack_ptr->m_index = node.m_child_index[far_child];
+                stack_ptr->m_is_leaf = (node.m_leaf_mask >> far_child) & 1;
+                stack_ptr->m_tmin = tmin[far_child];
+                ++stack_ptr;
+                node_index = node.m_child_index[near_child];
+                node_is_leaf = ((node.m_leaf_mask >> near_child) & 1) != 0;
+                continue;
+            }
+
+            if (hit[0] || hit[1])
+            {
+                // Continue with the left or right child node.
+                FOUNDATION_BVH_TRAVERSAL_STATS(++discarded_nodes);
+                const size_t child = hit[0] ? 0 : 1;
+                node_index = node.m_child_index[child];
+                node_is_leaf = ((node.m_leaf_mask >> child) & 1) != 0;
+                continue;
+            }
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += 2);
+        }
+        else
+        {
+            // Visit the leaf.
+            FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            ++leaf_count;
+            ValueType distance;
+#ifndef NDEBUG
+            distance = ValueType(-1.0);
+#endif
+            const bool proceed =
+                visitor.visit(
+                    tree.m_nodes[node_index],
+                    ray,
+                    ray_info,
+                    distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , stats
+#endif
+                    );
+            assert(!proceed || distance >= ValueType(0.0));
+
+            // Terminate traversal if the visitor decided so.
+            if (!proceed)
+                break;
+
+            // Keep track of the distance to the closest intersection.
+            if (ray_tmax > distance)
+                ray_tmax = distance;
+        }
+
+        // Pop the top node from the stack, skipping nodes beyond the closest intersection.
+        while (stack_ptr > stack && !((stack_ptr - 1)->m_tmin < ray_tmax))
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(++discarded_nodes);
+            --stack_ptr;
+        }
+
+        // Terminate traversal if the node stack is empty.
+        if (stack_ptr == stack)
+            break;
+
+        --stack_ptr;
+        node_index = stack_ptr->m_index;
+        node_is_leaf = stack_ptr->m_is_leaf != 0;
+    }
+
+    // Store traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_nodes.insert(visited_nodes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+
+    // Update traversal counters.
+    if (counters)
+    {
+        counters->m_visited_nodes += node_count;
+        counters->m_visited_leaves += leaf_count;
+    }
+}
+
+#if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)))
+#pragma GCC diagnostic pop
+#endif
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_QUANTIZEDINTERSECTOR_H
@@ -0,0 +1,246 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_QUANTIZEDNODE_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_QUANTIZEDNODE_H
+
+// appleseed.foundation headers.
+#include "foundation/math/fp.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Interior node of a BVH with quantized child bounding boxes.
+//
+// The bounds of both children are stored as 8-bit integers relative to the
+// bounding box of the node itself, which is stored in single precision as
+// an origin and a per-axis scale. Quantization is conservative: dequantized
+// child boxes always enclose the original ones.
+//
+// Children are either other quantized nodes or leaf nodes of the underlying
+// binary BVH.
+//
+
+template <typename AABB>
+class APPLESEED_ALIGN(16) QuantizedNode
+{
+  public:
+    typedef AABB AABBType;
+    typedef typename AABBType::ValueType ValueType;
+    static const size_t Dimension = AABBType::Dimension;
+
+    // Number of quantization steps along each axis.
+    static const size_t Resolution = 255;
+
+    // Constructor.
+    QuantizedNode();
+
+    // Quantize and store the bounding boxes of the children.
+    void set_child_bboxes(
+        const AABBType& left_bbox,
+        const AABBType& right_bbox);
+
+    // Return the (conservative) bounding box of a given child.
+    AABBType get_child_bbox(const size_t i) const;
+
+    // Set the index of a given child. Interior children are indices into the
+    // quantized nodes of the tree, leaf children are indices into its binary nodes.
+    void set_child_index(
+        const size_t    i,
+        const size_t    index,
+        const bool      is_leaf);
+
+    // Return the index of a given child.
+    size_t get_child_index(const size_t i) const;
+
+    // Return whether a given child is a leaf node.
+    bool is_leaf_child(const size_t i) const;
+
+  private:
+    template <typename Tree, typename Visitor, typename Ray, size_t StackSize>
+    friend class QuantizedIntersector;
+
+    float                           m_origin[Dimension];
+    float                           m_scale[Dimension];
+    uint8                           m_bounds[2][2][Dimension];  // [child][min/max][axis]
+    uint8                           m_leaf_mask;
+    uint32                          m_child_index[2];
+
+    // Convert a quantized coordinate back to world space.
+    ValueType dequantize(const size_t axis, const size_t q) const;
+};
+
+
+//
+// QuantizedNode class implementation.
+//
+
+template <typename AABB>
+QuantizedNode<AABB>::QuantizedNode()
+  : m_leaf_mask(0)
+{
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        m_origin[d] = 0.0f;
+        m_scale[d] = 0.0f;
+    }
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        for (size_t d = 0; d < Dimension; ++d)
+        {
+            m_bounds[i][0][d] = 0;
+            m_bounds[i][1][d] = 0;
+        }
+
+        m_child_index[i] = 0;
+    }
+}
+
+template <typename AABB>
+inline typename AABB::ValueType QuantizedNode<AABB>::dequantize(const size_t axis, const size_t q) const
+{
+    return
+        static_cast<ValueType>(m_origin[axis]) +
+        static_cast<ValueType>(m_scale[axis]) * static_cast<ValueType>(q);
+}
+
+template <typename AABB>
+void QuantizedNode<AABB>::set_child_bboxes(
+    const AABBType&     left_bbox,
+    const AABBType&     right_bbox)
+{
+    const AABBType* bboxes[2] = { &left_bbox, &right_bbox };
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        const ValueType lo = std::min(left_bbox.min[d], right_bbox.min[d]);
+        const ValueType hi = std::max(left_bbox.max[d], right_bbox.max[d]);
+
+        // Round the origin down so that it doesn't exceed the lower bound of the node.
+        float origin = static_cast<float>(lo);
+        while (static_cast<ValueType>(origin) > lo)
+            origin = shift(origin, -1);
+        m_origin[d] = origin;
+
+        // Round the scale up so that the upper bound of the node is reachable.
+        float scale = static_cast<float>((hi - static_cast<ValueType>(origin)) / Resolution);
+        while (static_cast<ValueType>(origin) + static_cast<ValueType>(scale) * Resolution < hi)
+            scale = shift(scale, 1);
+        m_scale[d] = scale;
+
+        for (size_t i = 0; i < 2; ++i)
+        {
+            const ValueType min = bboxes[i]->min[d];
+            const ValueType max = bboxes[i]->max[d];
+
+            size_t qmin = 0;
+            size_t qmax = 0;
+
+            if (scale > 0.0f)
+            {
+                const ValueType rcp_scale = ValueType(1.0) / static_cast<ValueType>(scale);
+                const ValueType fmin = std::floor((min - static_cast<ValueType>(origin)) * rcp_scale);
+                const ValueType fmax = std::ceil((max - static_cast<ValueType>(origin)) * rcp_scale);
+                qmin = fmin <= ValueType(0.0) ? 0 : fmin >= ValueType(Resolution) ? Resolution : static_cast<size_t>(fmin);
+                qmax = fmax <= ValueType(0.0) ? 0 : fmax >= ValueType(Resolution) ? Resolution : static_cast<size_t>(fmax);
+
+                // Compensate for rounding errors.
+                while (qmin > 0 && dequantize(d, qmin) > min)
+                    --qmin;
+                while (qmax < Resolution && dequantize(d, qmax) < max)
+                    ++qmax;
+            }
+
+            assert(dequantize(d, qmin) <= min);
+            assert(dequantize(d, qmax) >= max);
+
+            m_bounds[i][0][d] = static_cast<uint8>(qmin);
+            m_bounds[i][1][d] = static_cast<uint8>(qmax);
+        }
+    }
+}
+
+template <typename AABB>
+inline AABB QuantizedNode<AABB>::get_child_bbox(const size_t i) const
+{
+    assert(i < 2);
+
+    AABBType bbox;
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        bbox.min[d] = dequantize(d, m_bounds[i][0][d]);
+        bbox.max[d] = dequantize(d, m_bounds[i][1][d]);
+    }
+
+    return bbox;
+}
+
+template <typename AABB>
+inline void QuantizedNode<AABB>::set_child_index(
+    const size_t        i,
+    const size_t        index,
+    const bool          is_leaf)
+{
+    assert(i < 2);
+    assert(index <= 0xFFFFFFFFUL);
+
+    m_child_index[i] = static_cast<uint32>(index);
+
+    if (is_leaf)
+        m_leaf_mask |= static_cast<uint8>(1 << i);
+    else m_leaf_mask &= static_cast<uint8>(~(1 << i));
+}
+
+template <typename AABB>
+inline size_t QuantizedNode<AABB>::get_child_index(const size_t i) const
+{
+    assert(i < 2);
+    return static_cast<size_t>(m_child_index[i]);
+}
+
+template <typename AABB>
+inline bool QuantizedNode<AABB>::is_leaf_child(const size_t i) const
+{
+    assert(i < 2);
+    return (m_leaf_mask & (1 << i)) != 0;
+}
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_QUANTIZEDNODE_H
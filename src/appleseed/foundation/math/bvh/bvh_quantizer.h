@@ -0,0 +1,171 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_QUANTIZER_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_QUANTIZER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Convert the interior nodes of a BVH to quantized nodes.
+//
+// Interior binary nodes are replaced by quantized nodes and discarded; only
+// the leaf nodes are kept, compacted, in the binary node array of the tree.
+// After quantization the tree can only be traversed without motion blur,
+// and any wide node hierarchy is discarded.
+//
+
+template <typename Tree>
+class Quantizer
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    Quantizer();
+
+    // Quantize a tree. Does nothing if the root of the tree is a leaf.
+    template <typename Timer>
+    void quantize(Tree& tree);
+
+    // Return the quantization time.
+    double get_quantization_time() const;
+
+  private:
+    typedef typename Tree::NodeVectorType NodeVectorType;
+    typedef typename Tree::NodeType NodeType;
+    typedef typename Tree::QuantizedNodeType QuantizedNodeType;
+
+    double m_quantization_time;
+
+    // Recursively quantize the tree.
+    size_t quantize_recurse(
+        Tree&                   tree,
+        NodeVectorType&         leaves,
+        const size_t            node_index);
+};
+
+
+//
+// Quantizer class implementation.
+//
+
+template <typename Tree>
+Quantizer<Tree>::Quantizer()
+  : m_quantization_time(0.0)
+{
+}
+
+template <typename Tree>
+template <typename Timer>
+void Quantizer<Tree>::quantize(Tree& tree)
+{
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    // Clear the quantized nodes.
+    tree.m_quantized_nodes.clear();
+
+    if (!tree.m_nodes.empty() && tree.m_nodes[0].is_interior())
+    {
+        // A binary tree has one more leaf node than interior nodes.
+        const size_t leaf_count = (tree.m_nodes.size() + 1) / 2;
+        tree.m_quantized_nodes.reserve(leaf_count - 1);
+
+        NodeVectorType leaves(tree.m_nodes.get_allocator());
+        leaves.reserve(leaf_count);
+
+        quantize_recurse(tree, leaves, 0);
+
+        // Only keep the leaf nodes.
+        tree.m_nodes.swap(leaves);
+        tree.m_node_bboxes.clear();
+        tree.m_wide_nodes.clear();
+    }
+
+    // Measure and save quantization time.
+    stopwatch.measure();
+    m_quantization_time = stopwatch.get_seconds();
+}
+
+template <typename Tree>
+inline double Quantizer<Tree>::get_quantization_time() const
+{
+    return m_quantization_time;
+}
+
+template <typename Tree>
+size_t Quantizer<Tree>::quantize_recurse(
+    Tree&                   tree,
+    NodeVectorType&         leaves,
+    const size_t            node_index)
+{
+    const NodeType& node = tree.m_nodes[node_index];
+    assert(node.is_interior());
+
+    // Allocate the quantized node before recursing so that the root ends up at index 0.
+    const size_t quantized_node_index = tree.m_quantized_nodes.size();
+    tree.m_quantized_nodes.push_back(QuantizedNodeType());
+    tree.m_quantized_nodes[quantized_node_index].set_child_bboxes(
+        node.get_left_bbox(),
+        node.get_right_bbox());
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+        const size_t child_node_index = node.get_child_node_index() + i;
+        const NodeType& child_node = tree.m_nodes[child_node_index];
+
+        size_t child_index;
+        if (child_node.is_leaf())
+        {
+            child_index = leaves.size();
+            leaves.push_back(child_node);
+        }
+        else child_index = quantize_recurse(tree, leaves, child_node_index);
+
+        tree.m_quantized_nodes[quantized_node_index].set_child_index(
+            i,
+            child_index,
+            child_node.is_leaf());
+    }
+
+    return quantized_node_index;
+}
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_QUANTIZER_H
@@ -0,0 +1,239 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_REFITTER_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_REFITTER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/utility/stopwatch.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Recompute the bounding boxes of the nodes of a BVH, bottom-up, after the
+// bounding boxes of its items have changed. The topology of the tree is kept.
+//
+// Also computes the Surface Area Heuristic (SAH) cost of a tree relative to the
+// total surface area of its items. Unlike the cost normalized by the surface
+// area of the root node, this measure grows when interior nodes are inflated by
+// moving items, so it can be used to decide when a refitted tree has degraded
+// enough to be rebuilt.
+//
+
+template <typename Tree>
+class Refitter
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename NodeType::AABBType AABBType;
+    typedef typename AABBType::ValueType ValueType;
+
+    // Constructor.
+    explicit Refitter(
+        const ValueType     interior_node_traversal_cost = ValueType(1.0),
+        const ValueType     item_intersection_cost = ValueType(1.0));
+
+    // Refit a tree. 'bboxes' are the bounding boxes of the items, in tree order.
+    // Motion bounding boxes and the wide node hierarchy are not updated.
+    template <typename Timer, typename AABBVector>
+    void refit(
+        Tree&               tree,
+        const AABBVector&   bboxes);
+
+    // Return the refit time.
+    double get_refit_time() const;
+
+    // Compute the SAH cost of a tree relative to the total surface area of its items.
+    template <typename AABBVector>
+    ValueType compute_cost(
+        const Tree&         tree,
+        const AABBVector&   bboxes) const;
+
+  private:
+    const ValueType m_interior_node_traversal_cost;
+    const ValueType m_item_intersection_cost;
+    double          m_refit_time;
+
+    // Recursively refit a subtree. Return the bounding box of its root.
+    template <typename AABBVector>
+    AABBType refit_recurse(
+        Tree&               tree,
+        const AABBVector&   bboxes,
+        const size_t        node_index);
+
+    // Recursively compute the unnormalized SAH cost of a subtree.
+    ValueType compute_cost_recurse(
+        const Tree&         tree,
+        const size_t        node_index,
+        const ValueType     node_area) const;
+};
+
+
+//
+// Refitter class implementation.
+//
+
+template <typename Tree>
+Refitter<Tree>::Refitter(
+    const ValueType         interior_node_traversal_cost,
+    const ValueType         item_intersection_cost)
+  : m_interior_node_traversal_cost(interior_node_traversal_cost)
+  , m_item_intersection_cost(item_intersection_cost)
+  , m_refit_time(0.0)
+{
+}
+
+template <typename Tree>
+template <typename Timer, typename AABBVector>
+void Refitter<Tree>::refit(
+    Tree&                   tree,
+    const AABBVector&       bboxes)
+{
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    if (!tree.m_nodes.empty())
+        refit_recurse(tree, bboxes, 0);
+
+    // Measure and save refit time.
+    stopwatch.measure();
+    m_refit_time = stopwatch.get_seconds();
+}
+
+template <typename Tree>
+inline double Refitter<Tree>::get_refit_time() const
+{
+    return m_refit_time;
+}
+
+template <typename Tree>
+template <typename AABBVector>
+typename Refitter<Tree>::ValueType Refitter<Tree>::compute_cost(
+    const Tree&             tree,
+    const AABBVector&       bboxes) const
+{
+    if (tree.m_nodes.empty())
+        return ValueType(0.0);
+
+    // Compute the bounding box and the total surface area of the items.
+    AABBType items_bbox;
+    items_bbox.invalidate();
+    ValueType items_area(0.0);
+    for (size_t i = 0; i < bboxes.size(); ++i)
+    {
+        const AABBType bbox(bboxes[i]);
+        items_bbox.insert(bbox);
+        items_area += half_surface_area(bbox);
+    }
+
+    if (items_area <= ValueType(0.0))
+        return ValueType(0.0);
+
+    const NodeType& root = tree.m_nodes[0];
+
+    AABBType root_bbox;
+    if (root.is_interior())
+    {
+        root_bbox = root.get_left_bbox();
+        root_bbox.insert(root.get_right_bbox());
+    }
+    else root_bbox = items_bbox;
+
+    return compute_cost_recurse(tree, 0, half_surface_area(root_bbox)) / items_area;
+}
+
+template <typename Tree>
+template <typename AABBVector>
+typename Refitter<Tree>::AABBType Refitter<Tree>::refit_recurse(
+    Tree&                   tree,
+    const AABBVector&       bboxes,
+    const size_t            node_index)
+{
+    NodeType& node = tree.m_nodes[node_index];
+
+    AABBType bbox;
+
+    if (node.is_interior())
+    {
+        const size_t child_node_index = node.get_child_node_index();
+        const AABBType left_bbox = refit_recurse(tree, bboxes, child_node_index);
+        const AABBType right_bbox = refit_recurse(tree, bboxes, child_node_index + 1);
+
+        // The node reference stays valid: the node array is not resized.
+        node.set_left_bbox(left_bbox);
+        node.set_right_bbox(right_bbox);
+
+        bbox = left_bbox;
+        bbox.insert(right_bbox);
+    }
+    else
+    {
+        const size_t item_begin = node.get_item_index();
+        const size_t item_end = item_begin + node.get_item_count();
+        assert(item_end <= bboxes.size());
+
+        bbox.invalidate();
+
+        for (size_t i = item_begin; i < item_end; ++i)
+            bbox.insert(AABBType(bboxes[i]));
+    }
+
+    return bbox;
+}
+
+template <typename Tree>
+typename Refitter<Tree>::ValueType Refitter<Tree>::compute_cost_recurse(
+    const Tree&             tree,
+    const size_t            node_index,
+    const ValueType         node_area) const
+{
+    const NodeType& node = tree.m_nodes[node_index];
+
+    if (node.is_leaf())
+        return node_area * node.get_item_count() * m_item_intersection_cost;
+
+    const size_t child_node_index = node.get_child_node_index();
+
+    return
+          node_area * m_interior_node_traversal_cost
+        + compute_cost_recurse(tree, child_node_index, half_surface_area(node.get_left_bbox()))
+        + compute_cost_recurse(tree, child_node_index + 1, half_surface_area(node.get_right_bbox()));
+}
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_REFITTER_H
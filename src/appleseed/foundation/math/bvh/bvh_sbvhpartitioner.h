@@ -96,6 +96,16 @@ class SBVHPartitioner
         {
             return m_indices[0].size();
         }
+
+        size_t get_memory_size() const
+        {
+            size_t size = sizeof(*this);
+
+            for (size_t d = 0; d < Dimension; ++d)
+                size += m_indices[d].capacity() * sizeof(size_t);
+
+            return size;
+        }
     };
 
     // Constructor.
@@ -110,6 +120,11 @@ class SBVHPartitioner
     // Create the root leaf of the tree. Ownership of the leaf is passed to the caller.
     LeafType* create_root_leaf() const;
 
+    // Create a leaf containing a given set of items. Ownership of the leaf is passed to the caller.
+    LeafType* create_leaf(
+        const size_t*               indices,
+        const size_t                count) const;
+
     // Compute the bounding box of a given leaf.
     AABBType compute_leaf_bbox(const LeafType& leaf) const;
 
@@ -128,6 +143,9 @@ class SBVHPartitioner
     // Return the items ordering.
     const std::vector<size_t>& get_item_ordering() const;
 
+    // Return the amount of scratch memory used by the partitioner, in bytes.
+    size_t get_scratch_memory_size() const;
+
     // Split counters.
     size_t get_spatial_split_count() const;
     size_t get_object_split_count() const;
@@ -225,7 +243,6 @@ SBVHPartitioner<ItemHandler, AABBVector>::SBVHPartitioner(
   , m_rcp_bin_count(ValueType(1.0) / bin_count)
   , m_interior_node_traversal_cost(interior_node_traversal_cost)
   , m_item_intersection_cost(item_intersection_cost)
-  , m_left_bboxes(bboxes.size() > 1 ? bboxes.size() - 1 : 0)
   , m_bins(bin_count)
   , m_tags(bboxes.size())
   , m_spatial_split_count(0)
@@ -258,6 +275,26 @@ typename SBVHPartitioner<ItemHandler, AABBVector>::LeafType* SBVHPartitioner<Ite
     return leaf;
 }
 
+template <typename ItemHandler, typename AABBVector>
+typename SBVHPartitioner<ItemHandler, AABBVector>::LeafType* SBVHPartitioner<ItemHandler, AABBVector>::create_leaf(
+    const size_t*                   indices,
+    const size_t                    count) const
+{
+    LeafType* leaf = new LeafType();
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        std::vector<size_t>& leaf_indices = leaf->m_indices[d];
+        leaf_indices.assign(indices, indices + count);
+
+        // Sort the items according to their bounding boxes.
+        StableBboxSortPredicate<AABBVectorType> predicate(m_bboxes, d);
+        std::sort(leaf_indices.begin(), leaf_indices.end(), predicate);
+    }
+
+    return leaf;
+}
+
 template <typename ItemHandler, typename AABBVector>
 typename AABBVector::value_type SBVHPartitioner<ItemHandler, AABBVector>::compute_leaf_bbox(const LeafType& leaf) const
 {
@@ -435,6 +472,10 @@ void SBVHPartitioner<ItemHandler, AABBVector>::find_object_split(
     size_t&                         best_split_pivot,
     ValueType&                      best_split_cost)
 {
+    // The scratch array only grows as large as the largest leaf being split.
+    if (m_left_bboxes.size() < leaf.size() - 1)
+        m_left_bboxes.resize(leaf.size() - 1);
+
     for (size_t d = 0; d < Dimension; ++d)
     {
         const std::vector<size_t>& indices = leaf.m_indices[d];
@@ -793,6 +834,15 @@ inline const std::vector<size_t>& SBVHPartitioner<ItemHandler, AABBVector>::get_
     return m_final_indices;
 }
 
+template <typename ItemHandler, typename AABBVector>
+inline size_t SBVHPartitioner<ItemHandler, AABBVector>::get_scratch_memory_size() const
+{
+    return
+          m_left_bboxes.capacity() * sizeof(AABBType)
+        + m_bins.capacity() * sizeof(Bin)
+        + m_tags.capacity() * sizeof(uint8);
+}
+
 template <typename ItemHandler, typename AABBVector>
 inline size_t SBVHPartitioner<ItemHandler, AABBVector>::get_spatial_split_count() const
 {
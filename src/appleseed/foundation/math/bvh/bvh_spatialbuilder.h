@@ -32,9 +32,12 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_bboxsortpredicate.h"
+#include "foundation/math/vector.h"
 #include "foundation/utility/stopwatch.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <vector>
@@ -55,6 +58,9 @@ namespace bvh {
 //          {
 //              // Return the number of items in the leaf.
 //              size_t size();
+//
+//              // Return the amount of memory used by the leaf, in bytes.
+//              size_t get_memory_size() const;
 //          };
 //
 //          // Split a leaf. Return true if the split should be split or false if it should be kept unsplit.
@@ -68,6 +74,13 @@ namespace bvh {
 //
 //          // Store a leaf. Return the index of the first stored item.
 //          size_t store(const LeafType& leaf);
+//
+//          // Return the amount of scratch memory used by the partitioner, in bytes.
+//          size_t get_scratch_memory_size() const;
+//
+//          // Only required by SpatialBuilder::build_chunked().
+//          LeafType* create_leaf(const size_t* indices, const size_t count) const;
+//          AABBType compute_leaf_bbox(const LeafType& leaf) const;
 //      };
 //
 
@@ -91,23 +104,60 @@ class SpatialBuilder
         LeafType*           root_leaf,
         const AABBType&     root_leaf_bbox);
 
+    // Build a tree with bounded scratch memory. The items are first partitioned into chunks
+    // of at most chunk_size items by median splits, then the subtree of each chunk is built
+    // and stored before the next chunk is considered. Scratch memory is thus proportional
+    // to the chunk size rather than to the total number of items.
+    template <typename Timer, typename AABBVector>
+    void build_chunked(
+        Tree&               tree,
+        Partitioner&        partitioner,
+        const AABBVector&   bboxes,
+        const size_t        chunk_size);
+
     // Return the construction time.
     double get_build_time() const;
 
+    // Return the number of chunks built by the last call to build_chunked().
+    size_t get_chunk_count() const;
+
+    // Return the peak amount of scratch memory used during construction, in bytes.
+    size_t get_peak_memory_size() const;
+
   private:
     typedef std::vector<const LeafType*> LeafVector;
 
     double m_build_time;
+    size_t m_chunk_count;
+    size_t m_memory_size;
+    size_t m_peak_memory_size;
 
-    // Recursively subdivide the tree.
+    // Recursively partition the items into chunks, then build the subtree of each chunk.
+    template <typename AABBVector>
+    void subdivide_chunks_recurse(
+        Tree&               tree,
+        Partitioner&        partitioner,
+        const AABBVector&   bboxes,
+        std::vector<size_t>& indices,
+        const size_t        begin,
+        const size_t        end,
+        const size_t        node_index,
+        const size_t        chunk_size,
+        const size_t        depth);
+
+    // Recursively subdivide the tree. Leaves are stored immediately if leaves is 0.
     void subdivide_recurse(
         Tree&               tree,
         Partitioner&        partitioner,
-        LeafVector&         leaves,
+        LeafVector*         leaves,
         LeafType*           leaf,
         const AABBType&     leaf_bbox,
         const size_t        leaf_node_index,
         const size_t        depth);
+
+    // Keep track of the scratch memory used by the leaves and the partitioner.
+    void allocate_memory(const Partitioner& partitioner, const size_t size);
+    void release_memory(const size_t size);
 };
 
 
@@ -118,6 +168,9 @@ class SpatialBuilder
 template <typename Tree, typename Partitioner>
 SpatialBuilder<Tree, Partitioner>::SpatialBuilder()
   : m_build_time(0.0)
+  , m_chunk_count(0)
+  , m_memory_size(0)
+  , m_peak_memory_size(0)
 {
 }
 
@@ -141,12 +194,17 @@ void SpatialBuilder<Tree, Partitioner>::build(
 
     // todo: preallocate node memory?
 
+    m_chunk_count = 0;
+    m_memory_size = 0;
+    m_peak_memory_size = 0;
+    allocate_memory(partitioner, root_leaf->get_memory_size());
+
     // Recursively subdivide the tree.
     LeafVector leaves;
     subdivide_recurse(
         tree,
         partitioner,
-        leaves,
+        &leaves,
         root_leaf,
         root_leaf_bbox,
         0,
@@ -170,17 +228,176 @@ void SpatialBuilder<Tree, Partitioner>::build(
     m_build_time = stopwatch.get_seconds();
 }
 
+template <typename Tree, typename Partitioner>
+template <typename Timer, typename AABBVector>
+void SpatialBuilder<Tree, Partitioner>::build_chunked(
+    Tree&                   tree,
+    Partitioner&            partitioner,
+    const AABBVector&       bboxes,
+    const size_t            chunk_size)
+{
+    assert(chunk_size > 0);
+
+    // Start stopwatch.
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    // Clear the tree.
+    tree.m_nodes.clear();
+
+    // Create the root node of the tree.
+    tree.m_nodes.push_back(NodeType());
+
+    m_chunk_count = 0;
+    m_memory_size = 0;
+    m_peak_memory_size = 0;
+
+    // Identity ordering. This is the only scratch array whose size is proportional to the number of items.
+    const size_t size = bboxes.size();
+    std::vector<size_t> indices(size);
+    for (size_t i = 0; i < size; ++i)
+        indices[i] = i;
+    allocate_memory(partitioner, indices.capacity() * sizeof(size_t));
+
+    // Recursively partition the items into chunks and build their subtrees.
+    subdivide_chunks_recurse(
+        tree,
+        partitioner,
+        bboxes,
+        indices,
+        0,
+        size,
+        0,
+        chunk_size,
+        0);
+
+    // Measure and save construction time.
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+}
+
 template <typename Tree, typename Partitioner>
 inline double SpatialBuilder<Tree, Partitioner>::get_build_time() const
 {
     return m_build_time;
 }
 
+template <typename Tree, typename Partitioner>
+inline size_t SpatialBuilder<Tree, Partitioner>::get_chunk_count() const
+{
+    return m_chunk_count;
+}
+
+template <typename Tree, typename Partitioner>
+inline size_t SpatialBuilder<Tree, Partitioner>::get_peak_memory_size() const
+{
+    return m_peak_memory_size;
+}
+
+template <typename Tree, typename Partitioner>
+template <typename AABBVector>
+void SpatialBuilder<Tree, Partitioner>::subdivide_chunks_recurse(
+    Tree&                   tree,
+    Partitioner&            partitioner,
+    const AABBVector&       bboxes,
+    std::vector<size_t>&    indices,
+    const size_t            begin,
+    const size_t            end,
+    const size_t            node_index,
+    const size_t            chunk_size,
+    const size_t            depth)
+{
+    assert(node_index < tree.m_nodes.size());
+
+    const size_t count = end - begin;
+
+    if (count <= chunk_size)
+    {
+        // Build the subtree of this chunk, storing its leaves as they are created.
+        LeafType* leaf = partitioner.create_leaf(count > 0 ? &indices[begin] : 0, count);
+        allocate_memory(partitioner, leaf->get_memory_size());
+        const AABBType leaf_bbox(partitioner.compute_leaf_bbox(*leaf));
+        subdivide_recurse(
+            tree,
+            partitioner,
+            0,
+            leaf,
+            leaf_bbox,
+            node_index,
+            depth);
+        ++m_chunk_count;
+        return;
+    }
+
+    typedef typename AABBVector::value_type ItemAABBType;
+
+    // Split along the dimension of largest extent of the item centers.
+    ItemAABBType centers_bbox;
+    centers_bbox.invalidate();
+    for (size_t i = begin; i < end; ++i)
+        centers_bbox.insert(bboxes[indices[i]].center());
+    const size_t split_dim = max_index(centers_bbox.extent());
+
+    // Partition the items at their median.
+    const size_t pivot = begin + count / 2;
+    std::nth_element(
+        indices.begin() + begin,
+        indices.begin() + pivot,
+        indices.begin() + end,
+        StableBboxSortPredicate<AABBVector>(bboxes, split_dim));
+
+    // Compute the bounding boxes of the two halves.
+    ItemAABBType left_bbox, right_bbox;
+    left_bbox.invalidate();
+    right_bbox.invalidate();
+    for (size_t i = begin; i < pivot; ++i)
+        left_bbox.insert(bboxes[indices[i]]);
+    for (size_t i = pivot; i < end; ++i)
+        right_bbox.insert(bboxes[indices[i]]);
+
+    // Compute the indices of the child nodes.
+    const size_t left_node_index = tree.m_nodes.size();
+    const size_t right_node_index = left_node_index + 1;
+
+    // Turn the current node into an interior node.
+    NodeType& node = tree.m_nodes[node_index];
+    node.make_interior();
+    node.set_left_bbox(AABBType(left_bbox));
+    node.set_right_bbox(AABBType(right_bbox));
+    node.set_child_node_index(left_node_index);
+
+    // Create the child nodes.
+    tree.m_nodes.push_back(NodeType());
+    tree.m_nodes.push_back(NodeType());
+
+    // Recurse into the left and right halves.
+    subdivide_chunks_recurse(
+        tree,
+        partitioner,
+        bboxes,
+        indices,
+        begin,
+        pivot,
+        left_node_index,
+        chunk_size,
+        depth + 1);
+    subdivide_chunks_recurse(
+        tree,
+        partitioner,
+        bboxes,
+        indices,
+        pivot,
+        end,
+        right_node_index,
+        chunk_size,
+        depth + 1);
+}
+
 template <typename Tree, typename Partitioner>
 void SpatialBuilder<Tree, Partitioner>::subdivide_recurse(
     Tree&                   tree,
     Partitioner&            partitioner,
-    LeafVector&             leaves,
+    LeafVector*             leaves,
     LeafType*               leaf,
     const AABBType&         leaf_bbox,
     const size_t            leaf_node_index,
@@ -203,7 +420,12 @@ void SpatialBuilder<Tree, Partitioner>::subdivide_recurse(
 
     if (split)
     {
+        allocate_memory(
+            partitioner,
+            left_leaf->get_memory_size() + right_leaf->get_memory_size());
+
         // Get rid of the current leaf.
+        release_memory(leaf->get_memory_size());
         delete leaf;
 
         // Compute the indices of the child nodes.
@@ -250,12 +472,41 @@ void SpatialBuilder<Tree, Partitioner>::subdivide_recurse(
         // Turn the current node into a leaf node.
         NodeType& node = tree.m_nodes[leaf_node_index];
         node.make_leaf();
-        node.set_item_index(leaves.size());
         node.set_item_count(leaf->size());
-        leaves.push_back(leaf);
+
+        if (leaves)
+        {
+            node.set_item_index(leaves->size());
+            leaves->push_back(leaf);
+        }
+        else
+        {
+            node.set_item_index(partitioner.store(*leaf));
+            release_memory(leaf->get_memory_size());
+            delete leaf;
+        }
     }
 }
 
+template <typename Tree, typename Partitioner>
+inline void SpatialBuilder<Tree, Partitioner>::allocate_memory(
+    const Partitioner&      partitioner,
+    const size_t            size)
+{
+    m_memory_size += size;
+
+    const size_t memory_size = m_memory_size + partitioner.get_scratch_memory_size();
+    if (m_peak_memory_size < memory_size)
+        m_peak_memory_size = memory_size;
+}
+
+template <typename Tree, typename Partitioner>
+inline void SpatialBuilder<Tree, Partitioner>::release_memory(const size_t size)
+{
+    assert(m_memory_size >= size);
+    m_memory_size -= size;
+}
+
 }       // namespace bvh
 }       // namespace foundation
 
@@ -33,6 +33,7 @@
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/population.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/string.h"
 
@@ -40,6 +41,15 @@
 #include <cassert>
 #include <cstddef>
 
+// Enable or disable BVH traversal statistics.
+#undef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+#define FOUNDATION_BVH_TRAVERSAL_STATS(x) x
+#else
+#define FOUNDATION_BVH_TRAVERSAL_STATS(x)
+#endif
+
 namespace foundation {
 namespace bvh {
 
@@ -101,6 +111,33 @@ class TraversalStatistics
 };
 
 
+//
+// Lightweight BVH traversal counters. Contrary to bvh::TraversalStatistics, they
+// are always compiled in, and are only updated for traversals that provide them.
+//
+
+class TraversalCounters
+{
+  public:
+    uint64                  m_visited_nodes;        // number of visited nodes
+    uint64                  m_visited_leaves;       // number of visited leaves
+
+    // Constructor, clears all counters.
+    TraversalCounters();
+};
+
+
+//
+// TraversalCounters class implementation.
+//
+
+inline TraversalCounters::TraversalCounters()
+  : m_visited_nodes(0)
+  , m_visited_leaves(0)
+{
+}
+
+
 //
 // TreeStatistics class implementation.
 //
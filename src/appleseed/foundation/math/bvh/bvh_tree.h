@@ -32,6 +32,10 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_quantizednode.h"
+#include "foundation/math/bvh/bvh_widenode.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/utility/alignedvector.h"
 
 // Standard headers.
 #include <cstddef>
@@ -60,6 +64,12 @@ class Tree
     // Clear the tree.
     void clear();
 
+    // Return true if the tree has a wide node hierarchy on top of its binary nodes.
+    bool has_wide_nodes() const;
+
+    // Return true if the interior nodes of the tree are quantized.
+    bool has_quantized_nodes() const;
+
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
 
@@ -67,20 +77,50 @@ class Tree
     template <typename Tree, typename Partitioner>
     friend class Builder;
 
+    template <typename Tree, typename Partitioner>
+    friend class ParallelBuilder;
+
     template <typename Tree, typename Partitioner>
     friend class SpatialBuilder;
 
+    template <typename Tree>
+    friend class Collapser;
+
+    template <typename Tree>
+    friend class Masker;
+
+    template <typename Tree>
+    friend class Quantizer;
+
+    template <typename Tree>
+    friend class Refitter;
+
     template <typename Tree>
     friend class TreeStatistics;
 
     template <typename Tree, typename Visitor, typename Ray, size_t StackSize, size_t N>
     friend class Intersector;
 
+    template <typename Tree, typename Visitor, typename Ray, size_t StackSize>
+    friend class WideIntersector;
+
+    template <typename Tree, typename Visitor, typename Ray, size_t StackSize>
+    friend class PacketIntersector;
+
+    template <typename Tree, typename Visitor, typename Ray, size_t StackSize>
+    friend class QuantizedIntersector;
+
     typedef typename NodeType::AABBType AABBType;
     typedef std::vector<AABBType> AABBVector;
-
-    NodeVector  m_nodes;
-    AABBVector  m_node_bboxes;
+    typedef WideNode<AABBType, DefaultWideNodeWidth> WideNodeType;
+    typedef AlignedVector<WideNodeType> WideNodeVector;
+    typedef QuantizedNode<AABBType> QuantizedNodeType;
+    typedef AlignedVector<QuantizedNodeType> QuantizedNodeVector;
+
+    NodeVector          m_nodes;
+    AABBVector          m_node_bboxes;
+    WideNodeVector      m_wide_nodes;
+    QuantizedNodeVector m_quantized_nodes;
 };
 
 
@@ -91,6 +131,8 @@ class Tree
 template <typename NodeVector>
 Tree<NodeVector>::Tree(const AllocatorType& allocator)
   : m_nodes(allocator)
+  , m_wide_nodes(typename WideNodeVector::allocator_type(APPLESEED_ALIGNOF(WideNodeType)))
+  , m_quantized_nodes(typename QuantizedNodeVector::allocator_type(APPLESEED_ALIGNOF(QuantizedNodeType)))
 {
     clear();
 }
@@ -99,6 +141,20 @@ template <typename NodeVector>
 void Tree<NodeVector>::clear()
 {
     m_nodes.clear();
+    m_wide_nodes.clear();
+    m_quantized_nodes.clear();
+}
+
+template <typename NodeVector>
+inline bool Tree<NodeVector>::has_wide_nodes() const
+{
+    return !m_wide_nodes.empty();
+}
+
+template <typename NodeVector>
+inline bool Tree<NodeVector>::has_quantized_nodes() const
+{
+    return !m_quantized_nodes.empty();
 }
 
 template <typename NodeVector>
@@ -106,7 +162,9 @@ size_t Tree<NodeVector>::get_memory_size() const
 {
     return
           sizeof(*this)
-        + m_nodes.capacity() * sizeof(NodeType);
+        + m_nodes.capacity() * sizeof(NodeType)
+        + m_wide_nodes.capacity() * sizeof(WideNodeType)
+        + m_quantized_nodes.capacity() * sizeof(QuantizedNodeType);
 }
 
 }       // namespace bvh
@@ -0,0 +1,458 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_WIDEINTERSECTOR_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_WIDEINTERSECTOR_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh/bvh_statistics.h"
+#include "foundation/math/bvh/bvh_widenode.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/minmax.h"
+#include "foundation/math/ray.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
+
+// Boost headers.
+#include "boost/static_assert.hpp"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Intersect a ray with all the child bounding boxes of a wide node at once.
+//
+// Return a bit mask with one bit set per child that is hit, and store
+// in 'tmin' the distance to the entry point of each child.
+//
+
+template <typename WideNodeType, typename Ray>
+struct WideNodeChildIntersector
+{
+    typedef typename WideNodeType::ValueType ValueType;
+    typedef RayInfo<ValueType, WideNodeType::Dimension> RayInfoType;
+
+    static size_t intersect(
+        const WideNodeType&     node,
+        const Ray&              ray,
+        const RayInfoType&      ray_info,
+        const ValueType         ray_tmax,
+        ValueType               tmin[]);
+};
+
+
+//
+// Wide BVH intersector.
+//
+// Traverses the wide node hierarchy built by bvh::Collapser. Leaves are the
+// binary leaf nodes of the tree, so the Visitor class must conform to the
+// same prototype as for bvh::Intersector.
+//
+// Child nodes are visited in front-to-back order, and nodes popped from the
+// stack are skipped if they lie beyond the closest intersection found so far.
+//
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize = 64 * (DefaultWideNodeWidth - 1)
+>
+class WideIntersector
+  : public NonCopyable
+{
+  public:
+    typedef typename Tree::NodeType NodeType;
+    typedef typename Tree::WideNodeType WideNodeType;
+    typedef typename WideNodeType::ValueType ValueType;
+    typedef Ray RayType;
+    typedef RayInfo<ValueType, WideNodeType::Dimension> RayInfoType;
+
+    // Intersect a ray with a given BVH without motion.
+    void intersect_no_motion(
+        const Tree&             tree,
+        const RayType&          ray,
+        const RayInfoType&      ray_info,
+        Visitor&                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , TraversalStatistics&  stats
+#endif
+        , TraversalCounters*    counters = 0
+        ) const;
+
+  private:
+    struct StackEntry
+    {
+        uint32                  m_index;
+        uint32                  m_is_leaf;
+        ValueType               m_tmin;
+    };
+};
+
+
+//
+// WideNodeChildIntersector class implementation.
+//
+
+template <typename WideNodeType, typename Ray>
+size_t WideNodeChildIntersector<WideNodeType, Ray>::intersect(
+    const WideNodeType&         node,
+    const Ray&                  ray,
+    const RayInfoType&          ray_info,
+    const ValueType             ray_tmax,
+    ValueType                   tmin[])
+{
+    const size_t Width = WideNodeType::Width;
+    const size_t Dimension = WideNodeType::Dimension;
+
+    size_t hits = 0;
+
+    for (size_t i = 0; i < node.m_child_count; ++i)
+    {
+        ValueType child_tmin = ray.m_tmin;
+        ValueType child_tmax = ray_tmax;
+
+        for (size_t d = 0; d < Dimension; ++d)
+        {
+            const ValueType* data = node.m_bbox_data + d * 2 * Width + i;
+            const ValueType l1 = ray_info.m_rcp_dir[d] * (data[(1 - ray_info.m_sgn_dir[d]) * Width] - ray.m_org[d]);
+            const ValueType l2 = ray_info.m_rcp_dir[d] * (data[(    ray_info.m_sgn_dir[d]) * Width] - ray.m_org[d]);
+            child_tmin = ssemax(l1, child_tmin);
+            child_tmax = ssemin(l2, child_tmax);
+        }
+
+        tmin[i] = child_tmin;
+
+        if (!(child_tmin > child_tmax || child_tmax < ray.m_tmin || child_tmin >= ray_tmax))
+            hits |= size_t(1) << i;
+    }
+
+    return hits;
+}
+
+#ifdef APPLESEED_USE_SSE
+
+template <size_t W>
+struct WideNodeChildIntersector<WideNode<AABB3d, W>, Ray3d>
+{
+    typedef WideNode<AABB3d, W> WideNodeType;
+    typedef double ValueType;
+    typedef RayInfo3d RayInfoType;
+
+    // 'tmin' must be aligned on a 32-byte boundary.
+    static size_t intersect(
+        const WideNodeType&     node,
+        const Ray3d&            ray,
+        const RayInfoType&      ray_info,
+        const ValueType         ray_tmax,
+        ValueType               tmin[])
+    {
+        const size_t x_near = (0 * 2 + 1 - ray_info.m_sgn_dir.x) * W;
+        const size_t x_far  = (0 * 2 +     ray_info.m_sgn_dir.x) * W;
+        const size_t y_near = (1 * 2 + 1 - ray_info.m_sgn_dir.y) * W;
+        const size_t y_far  = (1 * 2 +     ray_info.m_sgn_dir.y) * W;
+        const size_t z_near = (2 * 2 + 1 - ray_info.m_sgn_dir.z) * W;
+        const size_t z_far  = (2 * 2 +     ray_info.m_sgn_dir.z) * W;
+
+        const double* data = node.m_bbox_data;
+        size_t hits = 0;
+
+#ifdef APPLESEED_USE_AVX
+
+        BOOST_STATIC_ASSERT(W % 4 == 0);
+
+        // Load the ray into AVX registers.
+        const __m256d org_x = _mm256_set1_pd(ray.m_org.x);
+        const __m256d org_y = _mm256_set1_pd(ray.m_org.y);
+        const __m256d org_z = _mm256_set1_pd(ray.m_org.z);
+        const __m256d rcp_dir_x = _mm256_set1_pd(ray_info.m_rcp_dir.x);
+        const __m256d rcp_dir_y = _mm256_set1_pd(ray_info.m_rcp_dir.y);
+        const __m256d rcp_dir_z = _mm256_set1_pd(ray_info.m_rcp_dir.z);
+        const __m256d ray_tmin4 = _mm256_set1_pd(ray.m_tmin);
+        const __m256d ray_tmax4 = _mm256_set1_pd(ray_tmax);
+
+        // Intersect four children at a time.
+        for (size_t i = 0; i < W; i += 4)
+        {
+            const __m256d xl1 = _mm256_mul_pd(rcp_dir_x, _mm256_sub_pd(_mm256_load_pd(data + x_near + i), org_x));
+            const __m256d xl2 = _mm256_mul_pd(rcp_dir_x, _mm256_sub_pd(_mm256_load_pd(data + x_far  + i), org_x));
+            const __m256d yl1 = _mm256_mul_pd(rcp_dir_y, _mm256_sub_pd(_mm256_load_pd(data + y_near + i), org_y));
+            const __m256d yl2 = _mm256_mul_pd(rcp_dir_y, _mm256_sub_pd(_mm256_load_pd(data + y_far  + i), org_y));
+            const __m256d zl1 = _mm256_mul_pd(rcp_dir_z, _mm256_sub_pd(_mm256_load_pd(data + z_near + i), org_z));
+            const __m256d zl2 = _mm256_mul_pd(rcp_dir_z, _mm256_sub_pd(_mm256_load_pd(data + z_far  + i), org_z));
+
+            const __m256d child_tmin = _mm256_max_pd(zl1, _mm256_max_pd(yl1, _mm256_max_pd(xl1, ray_tmin4)));
+            const __m256d child_tmax = _mm256_min_pd(zl2, _mm256_min_pd(yl2, _mm256_min_pd(xl2, ray_tmax4)));
+
+            _mm256_store_pd(tmin + i, child_tmin);
+
+            const int misses =
+                _mm256_movemask_pd(
+                    _mm256_or_pd(
+                        _mm256_cmp_pd(child_tmin, child_tmax, _CMP_GT_OQ),
+                        _mm256_or_pd(
+                            _mm256_cmp_pd(child_tmax, ray_tmin4, _CMP_LT_OQ),
+                            _mm256_cmp_pd(child_tmin, ray_tmax4, _CMP_GE_OQ))));
+
+            hits |= static_cast<size_t>(misses ^ 15) << i;
+        }
+
+#else
+
+        BOOST_STATIC_ASSERT(W % 2 == 0);
+
+        // Load the ray into SSE registers.
+        const __m128d org_x = _mm_set1_pd(ray.m_org.x);
+        const __m128d org_y = _mm_set1_pd(ray.m_org.y);
+        const __m128d org_z = _mm_set1_pd(ray.m_org.z);
+        const __m128d rcp_dir_x = _mm_set1_pd(ray_info.m_rcp_dir.x);
+        const __m128d rcp_dir_y = _mm_set1_pd(ray_info.m_rcp_dir.y);
+        const __m128d rcp_dir_z = _mm_set1_pd(ray_info.m_rcp_dir.z);
+        const __m128d ray_tmin2 = _mm_set1_pd(ray.m_tmin);
+        const __m128d ray_tmax2 = _mm_set1_pd(ray_tmax);
+
+        // Intersect two children at a time.
+        for (size_t i = 0; i < W; i += 2)
+        {
+            const __m128d xl1 = _mm_mul_pd(rcp_dir_x, _mm_sub_pd(_mm_load_pd(data + x_near + i), org_x));
+            const __m128d xl2 = _mm_mul_pd(rcp_dir_x, _mm_sub_pd(_mm_load_pd(data + x_far  + i), org_x));
+            const __m128d yl1 = _mm_mul_pd(rcp_dir_y, _mm_sub_pd(_mm_load_pd(data + y_near + i), org_y));
+            const __m128d yl2 = _mm_mul_pd(rcp_dir_y, _mm_sub_pd(_mm_load_pd(data + y_far  + i), org_y));
+            const __m128d zl1 = _mm_mul_pd(rcp_dir_z, _mm_sub_pd(_mm_load_pd(data + z_near + i), org_z));
+            const __m128d zl2 = _mm_mul_pd(rcp_dir_z, _mm_sub_pd(_mm_load_pd(data + z_far  + i), org_z));
+
+            const __m128d child_tmin = _mm_max_pd(zl1, _mm_max_pd(yl1, _mm_max_pd(xl1, ray_tmin2)));
+            const __m128d child_tmax = _mm_min_pd(zl2, _mm_min_pd(yl2, _mm_min_pd(xl2, ray_tmax2)));
+
+            _mm_store_pd(tmin + i, child_tmin);
+
+            const int misses =
+                _mm_movemask_pd(
+                    _mm_or_pd(
+                        _mm_cmpgt_pd(child_tmin, child_tmax),
+                        _mm_or_pd(
+                            _mm_cmplt_pd(child_tmax, ray_tmin2),
+                            _mm_cmpge_pd(child_tmin, ray_tmax2))));
+
+            hits |= static_cast<size_t>(misses ^ 3) << i;
+        }
+
+#endif
+
+        // Ignore empty child slots.
+        return hits & ((size_t(1) << node.m_child_count) - 1);
+    }
+};
+
+#endif  // APPLESEED_USE_SSE
+
+
+//
+// WideIntersector class implementation.
+//
+
+#if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)))
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+template <
+    typename Tree,
+    typename Visitor,
+    typename Ray,
+    size_t StackSize
+>
+void WideIntersector<Tree, Visitor, Ray, StackSize>::intersect_no_motion(
+    const Tree&                 tree,
+    const RayType&              ray,
+    const RayInfoType&          ray_info,
+    Visitor&                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , TraversalStatistics&      stats
+#endif
+    , TraversalCounters*        counters
+    ) const
+{
+    typedef WideNodeChildIntersector<WideNodeType, RayType> ChildIntersector;
+    const size_t Width = WideNodeType::Width;
+
+    // Make sure the wide node hierarchy was built.
+    assert(!tree.m_wide_nodes.empty());
+
+    // Node stack.
+    StackEntry stack[StackSize];
+    StackEntry* stack_ptr = stack;
+
+    // Current node.
+    size_t node_index = 0;
+    bool node_is_leaf = false;
+
+    // Distances to the children of the current node.
+    APPLESEED_SIMD8_ALIGN ValueType tmin[Width];
+
+    // Initialize traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(++stats.m_traversal_count);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_nodes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t visited_leaves = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t intersected_bboxes = 0);
+    FOUNDATION_BVH_TRAVERSAL_STATS(size_t discarded_nodes = 0);
+
+    // Initialize traversal counters.
+    size_t node_count = 0;
+    size_t leaf_count = 0;
+
+    // Traverse the tree and intersect leaf nodes.
+    ValueType ray_tmax = ray.m_tmax;
+    while (true)
+    {
+        // Fetch the node.
+        FOUNDATION_BVH_TRAVERSAL_STATS(++visited_nodes);
+        ++node_count;
+
+        if (!node_is_leaf)
+        {
+            const WideNodeType& node = tree.m_wide_nodes[node_index];
+            FOUNDATION_BVH_TRAVERSAL_STATS(intersected_bboxes += node.m_child_count);
+
+            // Intersect the bounding boxes of all children.
+            size_t hits = ChildIntersector::intersect(node, ray, ray_info, ray_tmax, tmin);
+
+            if (hits)
+            {
+                // Sort the children that were hit by increasing distance.
+                size_t order[Width];
+                size_t hit_count = 0;
+                for (size_t i = 0; hits; ++i, hits >>= 1)
+                {
+                    if (hits & 1)
+                    {
+                        size_t j = hit_count++;
+                        while (j > 0 && tmin[order[j - 1]] > tmin[i])
+                        {
+                            order[j] = order[j - 1];
+                            --j;
+                        }
+                        order[j] = i;
+                    }
+                }
+
+                FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += node.m_child_count - hit_count);
+
+                // Push the far child nodes to the stack, continue with the nearest child node.
+                for (size_t j = hit_count - 1; j > 0; --j)
+                {
+                    assert(stack_ptr < stack + StackSize);
+                    const size_t i = order[j];
+                    stack_ptr->m_index = node.m_child_index[i];
+                    stack_ptr->m_is_leaf = (node.m_leaf_mask >> i) & 1;
+                    stack_ptr->m_tmin = tmin[i];
+                    ++stack_ptr;
+                }
+
+                node_index = node.m_child_index[order[0]];
+                node_is_leaf = ((node.m_leaf_mask >> order[0]) & 1) != 0;
+                continue;
+            }
+
+            FOUNDATION_BVH_TRAVERSAL_STATS(discarded_nodes += node.m_child_count);
+        }
+        else
+        {
+            // Visit the leaf.
+            FOUNDATION_BVH_TRAVERSAL_STATS(++visited_leaves);
+            ++leaf_count;
+            ValueType distance;
+#ifndef NDEBUG
+            distance = ValueType(-1.0);
+#endif
+            const bool proceed =
+                visitor.visit(
+                    tree.m_nodes[node_index],
+                    ray,
+                    ray_info,
+                    distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , stats
+#endif
+                    );
+            assert(!proceed || distance >= ValueType(0.0));
+
+            // Terminate traversal if the visitor decided so.
+            if (!proceed)
+                break;
+
+            // Keep track of the distance to the closest intersection.
+            if (ray_tmax > distance)
+                ray_tmax = distance;
+        }
+
+        // Pop the top node from the stack, skipping nodes beyond the closest intersection.
+        while (stack_ptr > stack && !((stack_ptr - 1)->m_tmin < ray_tmax))
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(++discarded_nodes);
+            --stack_ptr;
+        }
+
+        // Terminate traversal if the node stack is empty.
+        if (stack_ptr == stack)
+            break;
+
+        --stack_ptr;
+        node_index = stack_ptr->m_index;
+        node_is_leaf = stack_ptr->m_is_leaf != 0;
+    }
+
+    // Store traversal statistics.
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_nodes.insert(visited_nodes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_visited_leaves.insert(visited_leaves));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_bboxes.insert(intersected_bboxes));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_discarded_nodes.insert(discarded_nodes));
+
+    // Update traversal counters.
+    if (counters)
+    {
+        counters->m_visited_nodes += node_count;
+        counters->m_visited_leaves += leaf_count;
+    }
+}
+
+#if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)))
+#pragma GCC diagnostic pop
+#endif
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_WIDEINTERSECTOR_H
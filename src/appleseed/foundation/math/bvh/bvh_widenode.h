@@ -0,0 +1,205 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_FOUNDATION_MATH_BVH_BVH_WIDENODE_H
+#define APPLESEED_FOUNDATION_MATH_BVH_BVH_WIDENODE_H
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <limits>
+
+namespace foundation {
+namespace bvh {
+
+//
+// Default width of wide nodes: 8 children when AVX is available (two child
+// boxes are tested per 256-bit register), 4 children otherwise (SSE2 tests
+// two child boxes per 128-bit register).
+//
+
+#ifdef APPLESEED_USE_AVX
+const size_t DefaultWideNodeWidth = 8;
+#else
+const size_t DefaultWideNodeWidth = 4;
+#endif
+
+
+//
+// Interior node of a wide (multi-branching) BVH.
+//
+// The bounding boxes of the children are stored in structure-of-arrays form
+// so that the children can be intersected several at a time using SIMD
+// instructions. Children are either other wide nodes or leaf nodes of the
+// underlying binary BVH.
+//
+
+template <typename AABB, size_t W>
+class APPLESEED_ALIGN(64) WideNode
+{
+  public:
+    typedef AABB AABBType;
+    typedef typename AABBType::ValueType ValueType;
+    static const size_t Dimension = AABBType::Dimension;
+    static const size_t Width = W;
+
+    // Constructor, creates a node without children.
+    WideNode();
+
+    // Append a child node.
+    void add_child(
+        const AABBType& bbox,
+        const size_t    index,
+        const bool      is_leaf);
+
+    // Return the number of children.
+    size_t get_child_count() const;
+
+    // Return the bounding box of a given child.
+    AABBType get_child_bbox(const size_t i) const;
+
+    // Return the index of a given child. Interior children are indices into
+    // the wide nodes of the tree, leaf children are indices into its binary nodes.
+    size_t get_child_index(const size_t i) const;
+
+    // Return whether a given child is a leaf node.
+    bool is_leaf_child(const size_t i) const;
+
+  private:
+    template <typename Tree, typename Visitor, typename Ray, size_t StackSize>
+    friend class WideIntersector;
+
+    template <typename WideNodeType, typename Ray>
+    friend struct WideNodeChildIntersector;
+
+    ValueType                       m_bbox_data[2 * Dimension * W];
+    uint32                          m_child_index[W];
+    uint32                          m_leaf_mask;
+    uint32                          m_child_count;
+
+    // Return the offset of the bounds of the children along a given axis.
+    // 'side' is 0 for the lower bounds and 1 for the upper bounds.
+    static size_t offset(const size_t axis, const size_t side);
+};
+
+
+//
+// WideNode class implementation.
+//
+
+template <typename AABB, size_t W>
+WideNode<AABB, W>::WideNode()
+  : m_leaf_mask(0)
+  , m_child_count(0)
+{
+    // Empty child slots get inverted bounding boxes so that they are never hit.
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        for (size_t i = 0; i < W; ++i)
+        {
+            m_bbox_data[offset(d, 0) + i] = std::numeric_limits<ValueType>::max();
+            m_bbox_data[offset(d, 1) + i] = -std::numeric_limits<ValueType>::max();
+        }
+    }
+
+    for (size_t i = 0; i < W; ++i)
+        m_child_index[i] = 0;
+}
+
+template <typename AABB, size_t W>
+inline size_t WideNode<AABB, W>::offset(const size_t axis, const size_t side)
+{
+    return (axis * 2 + side) * W;
+}
+
+template <typename AABB, size_t W>
+inline void WideNode<AABB, W>::add_child(
+    const AABBType&     bbox,
+    const size_t        index,
+    const bool          is_leaf)
+{
+    assert(m_child_count < W);
+    assert(index <= 0xFFFFFFFFUL);
+
+    const size_t i = m_child_count++;
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        m_bbox_data[offset(d, 0) + i] = bbox.min[d];
+        m_bbox_data[offset(d, 1) + i] = bbox.max[d];
+    }
+
+    m_child_index[i] = static_cast<uint32>(index);
+
+    if (is_leaf)
+        m_leaf_mask |= 1UL << i;
+}
+
+template <typename AABB, size_t W>
+inline size_t WideNode<AABB, W>::get_child_count() const
+{
+    return static_cast<size_t>(m_child_count);
+}
+
+template <typename AABB, size_t W>
+inline AABB WideNode<AABB, W>::get_child_bbox(const size_t i) const
+{
+    assert(i < m_child_count);
+
+    AABBType bbox;
+
+    for (size_t d = 0; d < Dimension; ++d)
+    {
+        bbox.min[d] = m_bbox_data[offset(d, 0) + i];
+        bbox.max[d] = m_bbox_data[offset(d, 1) + i];
+    }
+
+    return bbox;
+}
+
+template <typename AABB, size_t W>
+inline size_t WideNode<AABB, W>::get_child_index(const size_t i) const
+{
+    assert(i < m_child_count);
+    return static_cast<size_t>(m_child_index[i]);
+}
+
+template <typename AABB, size_t W>
+inline bool WideNode<AABB, W>::is_leaf_child(const size_t i) const
+{
+    assert(i < m_child_count);
+    return (m_leaf_mask & (1UL << i)) != 0;
+}
+
+}       // namespace bvh
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_BVH_BVH_WIDENODE_H
@@ -0,0 +1,86 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_FOUNDATION_MATH_FIXEDPOINT_H
+#define APPLESEED_FOUNDATION_MATH_FIXEDPOINT_H
+
+// appleseed.foundation headers.
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// Conversions between non-negative floating-point values and unsigned 64-bit fixed-point
+// values with 24 fractional bits.
+//
+// Sums of fixed-point values are exact as long as they don't overflow, and therefore don't
+// depend on the order of the additions. Accumulating values from several threads into
+// fixed-point counters yields the same totals regardless of how the threads are scheduled.
+//
+
+// Number of fractional bits of fixed-point values.
+const size_t FixedPointFractionBits = 24;
+
+// Largest value accepted by float_to_fixed_point(); larger values are clamped to it.
+// This leaves room for accumulating 2^24 maximum values without overflowing.
+const float FixedPointMaxValue = 1073741824.0f;             // 2^30
+
+// Convert a non-negative floating-point value to fixed point, rounding to the nearest value.
+uint64 float_to_fixed_point(const float x);
+
+// Convert a fixed-point value back to floating point.
+float fixed_point_to_float(const uint64 x);
+
+
+//
+// Implementation.
+//
+
+inline uint64 float_to_fixed_point(const float x)
+{
+    assert(x >= 0.0f);
+
+    const float clamped = x < FixedPointMaxValue ? x : FixedPointMaxValue;
+
+    return static_cast<uint64>(static_cast<double>(clamped) * (1 << FixedPointFractionBits) + 0.5);
+}
+
+inline float fixed_point_to_float(const uint64 x)
+{
+    return static_cast<float>(static_cast<double>(x) * (1.0 / (1 << FixedPointFractionBits)));
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_FIXEDPOINT_H
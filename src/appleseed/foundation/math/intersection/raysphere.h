@@ -32,38 +32,157 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/ray.h"
+#include "foundation/math/vector.h"
 
 // Standard headers.
 #include <cassert>
+#include <cmath>
 #include <cstddef>
 
 namespace foundation
 {
 
-/*
-        // compute the intersection between a ray and the sphere
-        double intersect_sphere(const Ray3d& r)
-        {
-            const Vector3d v = m_sphere_center - r.m_org;
-            const double   a = dot(v, r.m_dir);
-            const double   b = a * a - dot(v, v) + double(1.0);
-
-            if (b < 0.0)
-                return m_huge;        // no intersection
-
-            const double c  = sqrt(b);
-            double t = a - c;
-
-            if (t < 0.0)
-            {
-                t = a + c;
-                if (t < 0.0)
-                    return m_huge;    // no intersection
-            }
-
-            return t;
-        }
-*/
+//
+// 3D ray-sphere and ray-disk intersections.
+//
+// The direction of the ray doesn't need to be normalized. Intersections are only
+// reported in the [ray.m_tmin, ray.m_tmax) interval of the ray. When the origin
+// of the ray is inside the sphere, the exit point is returned.
+//
+// The distance to the sphere is computed from the point of the ray closest to the
+// center of the sphere, which is much more accurate than solving the quadratic
+// equation directly when the sphere is small or far away from the ray origin.
+//
+// Reference:
+//
+//   Precision Improvements for Ray/Sphere Intersection
+//   Eric Haines, Johannes Guenther, Tomas Akenine-Moller
+//   Ray Tracing Gems, 2019, chapter 7
+//
+
+// Return true if the ray hits the sphere.
+template <typename T>
+bool intersect_sphere(
+    const Ray<T, 3>&        ray,
+    const Vector<T, 3>&     center,
+    const T                 radius);
+
+// Return true if the ray hits the sphere, and the distance to the hit in 't'.
+template <typename T>
+bool intersect_sphere(
+    const Ray<T, 3>&        ray,
+    const Vector<T, 3>&     center,
+    const T                 radius,
+    T&                      t);
+
+// Return true if the ray hits the disk of a given center and radius that faces
+// the ray, and the distance to the hit in 't'. Such disks are a cheap stand-in
+// for spheres when particles are small on screen.
+template <typename T>
+bool intersect_facing_disk(
+    const Ray<T, 3>&        ray,
+    const Vector<T, 3>&     center,
+    const T                 radius,
+    T&                      t);
+
+
+//
+// 3D ray-sphere and ray-disk intersections implementation.
+//
+
+template <typename T>
+inline bool intersect_sphere(
+    const Ray<T, 3>&        ray,
+    const Vector<T, 3>&     center,
+    const T                 radius)
+{
+    T t;
+    return intersect_sphere(ray, center, radius, t);
+}
+
+template <typename T>
+inline bool intersect_sphere(
+    const Ray<T, 3>&        ray,
+    const Vector<T, 3>&     center,
+    const T                 radius,
+    T&                      t)
+{
+    assert(radius >= T(0.0));
+
+    const Vector<T, 3> f = ray.m_org - center;
+    const T a = dot(ray.m_dir, ray.m_dir);
+    const T b = -dot(f, ray.m_dir);
+
+    if (a == T(0.0))
+        return false;
+
+    // Squared distance from the center to the closest point of the ray's supporting line.
+    const Vector<T, 3> l = f + (b / a) * ray.m_dir;
+    const T d = radius * radius - dot(l, l);
+
+    if (d < T(0.0))
+        return false;
+
+    // Compute the two roots, avoiding the cancellation in (b - sqrt(a * d)).
+    const T q = b + (b >= T(0.0) ? std::sqrt(a * d) : -std::sqrt(a * d));
+    const T c = dot(f, f) - radius * radius;
+    T t0 = c / q;
+    T t1 = q / a;
+
+    if (q == T(0.0))
+        t0 = t1 = T(0.0);
+
+    if (t0 > t1)
+    {
+        const T tmp = t0;
+        t0 = t1;
+        t1 = tmp;
+    }
+
+    if (t0 >= ray.m_tmin && t0 < ray.m_tmax)
+    {
+        t = t0;
+        return true;
+    }
+
+    if (t1 >= ray.m_tmin && t1 < ray.m_tmax)
+    {
+        t = t1;
+        return true;
+    }
+
+    return false;
+}
+
+template <typename T>
+inline bool intersect_facing_disk(
+    const Ray<T, 3>&        ray,
+    const Vector<T, 3>&     center,
+    const T                 radius,
+    T&                      t)
+{
+    assert(radius >= T(0.0));
+
+    const T a = dot(ray.m_dir, ray.m_dir);
+
+    if (a == T(0.0))
+        return false;
+
+    // The disk lies in the plane orthogonal to the ray that contains its center.
+    const Vector<T, 3> f = center - ray.m_org;
+    const T tc = dot(f, ray.m_dir) / a;
+
+    if (tc < ray.m_tmin || tc >= ray.m_tmax)
+        return false;
+
+    const Vector<T, 3> l = f - tc * ray.m_dir;
+
+    if (dot(l, l) > radius * radius)
+        return false;
+
+    t = tc;
+    return true;
+}
 
 }       // namespace foundation
 
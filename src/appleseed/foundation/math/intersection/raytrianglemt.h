@@ -97,11 +97,13 @@ struct TriangleMTSupportPlane
     VectorType  m_e0;
     VectorType  m_e1;
 
-    // Constructors.
+    // Constructors. The triangle may have a different type.
     TriangleMTSupportPlane();
-    explicit TriangleMTSupportPlane(const TriangleMT<T>& triangle);
+    template <typename U>
+    explicit TriangleMTSupportPlane(const TriangleMT<U>& triangle);
 
-    void initialize(const TriangleMT<T>& triangle);
+    template <typename U>
+    void initialize(const TriangleMT<U>& triangle);
 
     ValueType intersect(
         const VectorType&   org,
@@ -279,17 +281,19 @@ inline TriangleMTSupportPlane<T>::TriangleMTSupportPlane()
 }
 
 template <typename T>
-inline TriangleMTSupportPlane<T>::TriangleMTSupportPlane(const TriangleMT<T>& triangle)
+template <typename U>
+inline TriangleMTSupportPlane<T>::TriangleMTSupportPlane(const TriangleMT<U>& triangle)
 {
     initialize(triangle);
 }
 
 template <typename T>
-inline void TriangleMTSupportPlane<T>::initialize(const TriangleMT<T>& triangle)
+template <typename U>
+inline void TriangleMTSupportPlane<T>::initialize(const TriangleMT<U>& triangle)
 {
-    m_v0 = triangle.m_v0;
-    m_e0 = triangle.m_e0;
-    m_e1 = triangle.m_e1;
+    m_v0 = VectorType(triangle.m_v0);
+    m_e0 = VectorType(triangle.m_e0);
+    m_e1 = VectorType(triangle.m_e1);
 }
 
 template <typename T>
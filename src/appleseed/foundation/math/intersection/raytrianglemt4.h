@@ -0,0 +1,405 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_FOUNDATION_MATH_INTERSECTION_RAYTRIANGLEMT4_H
+#define APPLESEED_FOUNDATION_MATH_INTERSECTION_RAYTRIANGLEMT4_H
+
+// appleseed.foundation headers.
+#include "foundation/math/intersection/raytrianglemt.h"
+#include "foundation/math/ray.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// Moeller-Trumbore 3D ray-triangle intersection test, four triangles at a time.
+//
+// The triangles are stored in structure-of-arrays form: one array of four values
+// per coordinate of the first vertex and of the two edges of the triangles. The
+// layout has no alignment requirement so that it can be embedded in arbitrary
+// buffers. Unused lanes must be cleared; cleared lanes never intersect any ray.
+//
+// When SSE is enabled, single precision triangles are tested with one 4-wide
+// instruction stream and double precision triangles with two 2-wide ones. The
+// results match the ones of TriangleMT except for rays or triangles involving NaNs.
+//
+
+template <typename T>
+struct TriangleMT4
+{
+    // Types.
+    typedef T ValueType;
+    typedef Vector<T, 3> VectorType;
+    typedef Ray<T, 3> RayType;
+    typedef TriangleMT<T> TriangleType;
+
+    // Number of triangles.
+    static const size_t Width = 4;
+
+    // First vertices.
+    ValueType   m_v0[3][Width];
+
+    // Two edges.
+    ValueType   m_e0[3][Width];
+    ValueType   m_e1[3][Width];
+
+    // Constructors.
+    TriangleMT4();
+
+    // Construct a set of triangles from another set of triangles of a different type.
+    template <typename U>
+    explicit TriangleMT4(const TriangleMT4<U>& rhs);
+
+    // Set or clear one triangle.
+    template <typename U>
+    void set(const size_t i, const TriangleMT<U>& triangle);
+    void clear(const size_t i);
+
+    // Retrieve one triangle.
+    TriangleType get(const size_t i) const;
+
+    // Intersect a ray with the four triangles. Return a bitmask of the triangles hit;
+    // t[i], u[i] and v[i] are only defined if bit i is set.
+    size_t intersect(
+        const RayType&      ray,
+        ValueType           t[Width],
+        ValueType           u[Width],
+        ValueType           v[Width]) const;
+
+    // Return a bitmask of the triangles hit by a ray.
+    size_t intersect(const RayType& ray) const;
+};
+
+// Return the index of the closest hit among the hits whose bit is set in 'mask'.
+template <typename T>
+size_t find_closest_hit(
+    const size_t            mask,
+    const T                 t[TriangleMT4<T>::Width]);
+
+
+//
+// TriangleMT4 class implementation.
+//
+
+template <typename T>
+inline TriangleMT4<T>::TriangleMT4()
+{
+}
+
+template <typename T>
+template <typename U>
+APPLESEED_FORCE_INLINE TriangleMT4<T>::TriangleMT4(const TriangleMT4<U>& rhs)
+{
+    for (size_t d = 0; d < 3; ++d)
+    {
+        for (size_t i = 0; i < Width; ++i)
+        {
+            m_v0[d][i] = static_cast<ValueType>(rhs.m_v0[d][i]);
+            m_e0[d][i] = static_cast<ValueType>(rhs.m_e0[d][i]);
+            m_e1[d][i] = static_cast<ValueType>(rhs.m_e1[d][i]);
+        }
+    }
+}
+
+template <typename T>
+template <typename U>
+inline void TriangleMT4<T>::set(const size_t i, const TriangleMT<U>& triangle)
+{
+    assert(i < Width);
+
+    for (size_t d = 0; d < 3; ++d)
+    {
+        m_v0[d][i] = static_cast<ValueType>(triangle.m_v0[d]);
+        m_e0[d][i] = static_cast<ValueType>(triangle.m_e0[d]);
+        m_e1[d][i] = static_cast<ValueType>(triangle.m_e1[d]);
+    }
+}
+
+template <typename T>
+inline void TriangleMT4<T>::clear(const size_t i)
+{
+    assert(i < Width);
+
+    // A triangle with null edges has a null determinant and is never hit.
+    for (size_t d = 0; d < 3; ++d)
+    {
+        m_v0[d][i] = ValueType(0.0);
+        m_e0[d][i] = ValueType(0.0);
+        m_e1[d][i] = ValueType(0.0);
+    }
+}
+
+template <typename T>
+inline TriangleMT<T> TriangleMT4<T>::get(const size_t i) const
+{
+    assert(i < Width);
+
+    TriangleType triangle;
+
+    for (size_t d = 0; d < 3; ++d)
+    {
+        triangle.m_v0[d] = m_v0[d][i];
+        triangle.m_e0[d] = m_e0[d][i];
+        triangle.m_e1[d] = m_e1[d][i];
+    }
+
+    return triangle;
+}
+
+template <typename T>
+APPLESEED_FORCE_INLINE size_t TriangleMT4<T>::intersect(
+    const RayType&          ray,
+    ValueType               t[Width],
+    ValueType               u[Width],
+    ValueType               v[Width]) const
+{
+    size_t mask = 0;
+
+    for (size_t i = 0; i < Width; ++i)
+    {
+        if (get(i).intersect(ray, t[i], u[i], v[i]))
+            mask |= size_t(1) << i;
+    }
+
+    return mask;
+}
+
+template <typename T>
+APPLESEED_FORCE_INLINE size_t TriangleMT4<T>::intersect(const RayType& ray) const
+{
+    size_t mask = 0;
+
+    for (size_t i = 0; i < Width; ++i)
+    {
+        if (get(i).intersect(ray))
+            mask |= size_t(1) << i;
+    }
+
+    return mask;
+}
+
+#ifdef APPLESEED_USE_SSE
+
+namespace impl
+{
+    // Thin wrappers around SSE instructions so that a single kernel serves both precisions.
+
+    struct TriangleMT4FloatOps
+    {
+        typedef float ValueType;
+        typedef __m128 PacketType;
+
+        static const size_t Width = 4;
+
+        static PacketType set1(const float x) { return _mm_set1_ps(x); }
+        static PacketType load(const float* p) { return _mm_loadu_ps(p); }
+        static void store(float* p, const PacketType x) { _mm_storeu_ps(p, x); }
+        static PacketType add(const PacketType a, const PacketType b) { return _mm_add_ps(a, b); }
+        static PacketType sub(const PacketType a, const PacketType b) { return _mm_sub_ps(a, b); }
+        static PacketType mul(const PacketType a, const PacketType b) { return _mm_mul_ps(a, b); }
+        static PacketType div(const PacketType a, const PacketType b) { return _mm_div_ps(a, b); }
+        static PacketType and_(const PacketType a, const PacketType b) { return _mm_and_ps(a, b); }
+        static PacketType xor_(const PacketType a, const PacketType b) { return _mm_xor_ps(a, b); }
+        static PacketType cmpge(const PacketType a, const PacketType b) { return _mm_cmpge_ps(a, b); }
+        static PacketType cmple(const PacketType a, const PacketType b) { return _mm_cmple_ps(a, b); }
+        static PacketType cmplt(const PacketType a, const PacketType b) { return _mm_cmplt_ps(a, b); }
+        static size_t movemask(const PacketType x) { return static_cast<size_t>(_mm_movemask_ps(x)); }
+    };
+
+    struct TriangleMT4DoubleOps
+    {
+        typedef double ValueType;
+        typedef __m128d PacketType;
+
+        static const size_t Width = 2;
+
+        static PacketType set1(const double x) { return _mm_set1_pd(x); }
+        static PacketType load(const double* p) { return _mm_loadu_pd(p); }
+        static void store(double* p, const PacketType x) { _mm_storeu_pd(p, x); }
+        static PacketType add(const PacketType a, const PacketType b) { return _mm_add_pd(a, b); }
+        static PacketType sub(const PacketType a, const PacketType b) { return _mm_sub_pd(a, b); }
+        static PacketType mul(const PacketType a, const PacketType b) { return _mm_mul_pd(a, b); }
+        static PacketType div(const PacketType a, const PacketType b) { return _mm_div_pd(a, b); }
+        static PacketType and_(const PacketType a, const PacketType b) { return _mm_and_pd(a, b); }
+        static PacketType xor_(const PacketType a, const PacketType b) { return _mm_xor_pd(a, b); }
+        static PacketType cmpge(const PacketType a, const PacketType b) { return _mm_cmpge_pd(a, b); }
+        static PacketType cmple(const PacketType a, const PacketType b) { return _mm_cmple_pd(a, b); }
+        static PacketType cmplt(const PacketType a, const PacketType b) { return _mm_cmplt_pd(a, b); }
+        static size_t movemask(const PacketType x) { return static_cast<size_t>(_mm_movemask_pd(x)); }
+    };
+
+    // Intersect a ray with the triangles of lanes [first, first + Ops::Width).
+    // The operations are ordered like the ones of TriangleMT::intersect().
+    template <typename Ops, bool ComputeHit>
+    APPLESEED_FORCE_INLINE size_t intersect_triangle_mt_packet(
+        const TriangleMT4<typename Ops::ValueType>&     triangles,
+        const size_t                                    first,
+        const Ray<typename Ops::ValueType, 3>&          ray,
+        typename Ops::ValueType*                        t,
+        typename Ops::ValueType*                        u,
+        typename Ops::ValueType*                        v)
+    {
+        typedef typename Ops::ValueType ValueType;
+        typedef typename Ops::PacketType PacketType;
+
+        const PacketType dir_x = Ops::set1(ray.m_dir.x);
+        const PacketType dir_y = Ops::set1(ray.m_dir.y);
+        const PacketType dir_z = Ops::set1(ray.m_dir.z);
+
+        const PacketType e0_x = Ops::load(&triangles.m_e0[0][first]);
+        const PacketType e0_y = Ops::load(&triangles.m_e0[1][first]);
+        const PacketType e0_z = Ops::load(&triangles.m_e0[2][first]);
+        const PacketType e1_x = Ops::load(&triangles.m_e1[0][first]);
+        const PacketType e1_y = Ops::load(&triangles.m_e1[1][first]);
+        const PacketType e1_z = Ops::load(&triangles.m_e1[2][first]);
+
+        // Calculate determinant.
+        const PacketType pvec_x = Ops::sub(Ops::mul(dir_y, e1_z), Ops::mul(e1_y, dir_z));
+        const PacketType pvec_y = Ops::sub(Ops::mul(dir_z, e1_x), Ops::mul(e1_z, dir_x));
+        const PacketType pvec_z = Ops::sub(Ops::mul(dir_x, e1_y), Ops::mul(e1_x, dir_y));
+        const PacketType det = Ops::add(Ops::add(Ops::mul(e0_x, pvec_x), Ops::mul(e0_y, pvec_y)), Ops::mul(e0_z, pvec_z));
+
+        // Calculate distance from v0 to ray origin.
+        const PacketType tvec_x = Ops::sub(Ops::set1(ray.m_org.x), Ops::load(&triangles.m_v0[0][first]));
+        const PacketType tvec_y = Ops::sub(Ops::set1(ray.m_org.y), Ops::load(&triangles.m_v0[1][first]));
+        const PacketType tvec_z = Ops::sub(Ops::set1(ray.m_org.z), Ops::load(&triangles.m_v0[2][first]));
+
+        // Calculate u parameter.
+        const PacketType uu = Ops::add(Ops::add(Ops::mul(tvec_x, pvec_x), Ops::mul(tvec_y, pvec_y)), Ops::mul(tvec_z, pvec_z));
+
+        // Calculate v and t parameters.
+        const PacketType qvec_x = Ops::sub(Ops::mul(tvec_y, e0_z), Ops::mul(e0_y, tvec_z));
+        const PacketType qvec_y = Ops::sub(Ops::mul(tvec_z, e0_x), Ops::mul(e0_z, tvec_x));
+        const PacketType qvec_z = Ops::sub(Ops::mul(tvec_x, e0_y), Ops::mul(e0_x, tvec_y));
+        const PacketType vv = Ops::add(Ops::add(Ops::mul(dir_x, qvec_x), Ops::mul(dir_y, qvec_y)), Ops::mul(dir_z, qvec_z));
+        const PacketType tt = Ops::add(Ops::add(Ops::mul(e1_x, qvec_x), Ops::mul(e1_y, qvec_y)), Ops::mul(e1_z, qvec_z));
+
+        // Flip the signs of all parameters such that the determinant is positive,
+        // which lets both orientations of the triangles share a single set of tests.
+        const PacketType sign = Ops::and_(det, Ops::set1(ValueType(-0.0)));
+        const PacketType abs_det = Ops::xor_(det, sign);
+        const PacketType su = Ops::xor_(uu, sign);
+        const PacketType sv = Ops::xor_(vv, sign);
+        const PacketType st = Ops::xor_(tt, sign);
+
+        // Test bounds.
+        const PacketType zero = Ops::set1(ValueType(0.0));
+        const PacketType inside =
+            Ops::and_(
+                Ops::and_(
+                    Ops::and_(Ops::cmpge(su, zero), Ops::cmple(su, abs_det)),
+                    Ops::and_(Ops::cmpge(sv, zero), Ops::cmple(Ops::add(su, sv), abs_det))),
+                Ops::and_(
+                    Ops::cmplt(st, Ops::mul(Ops::set1(ray.m_tmax), abs_det)),
+                    Ops::cmpge(st, Ops::mul(Ops::set1(ray.m_tmin), abs_det))));
+
+        const size_t mask = Ops::movemask(inside);
+
+        if (ComputeHit && mask)
+        {
+            // Scale parameters.
+            const PacketType rcp_det = Ops::div(Ops::set1(ValueType(1.0)), det);
+            Ops::store(t + first, Ops::mul(tt, rcp_det));
+            Ops::store(u + first, Ops::mul(uu, rcp_det));
+            Ops::store(v + first, Ops::mul(vv, rcp_det));
+        }
+
+        return mask;
+    }
+}
+
+template <>
+APPLESEED_FORCE_INLINE size_t TriangleMT4<float>::intersect(
+    const RayType&          ray,
+    ValueType               t[Width],
+    ValueType               u[Width],
+    ValueType               v[Width]) const
+{
+    return impl::intersect_triangle_mt_packet<impl::TriangleMT4FloatOps, true>(*this, 0, ray, t, u, v);
+}
+
+template <>
+APPLESEED_FORCE_INLINE size_t TriangleMT4<float>::intersect(const RayType& ray) const
+{
+    return impl::intersect_triangle_mt_packet<impl::TriangleMT4FloatOps, false>(*this, 0, ray, 0, 0, 0);
+}
+
+template <>
+APPLESEED_FORCE_INLINE size_t TriangleMT4<double>::intersect(
+    const RayType&          ray,
+    ValueType               t[Width],
+    ValueType               u[Width],
+    ValueType               v[Width]) const
+{
+    return
+          impl::intersect_triangle_mt_packet<impl::TriangleMT4DoubleOps, true>(*this, 0, ray, t, u, v)
+        | impl::intersect_triangle_mt_packet<impl::TriangleMT4DoubleOps, true>(*this, 2, ray, t, u, v) << 2;
+}
+
+template <>
+APPLESEED_FORCE_INLINE size_t TriangleMT4<double>::intersect(const RayType& ray) const
+{
+    return
+          impl::intersect_triangle_mt_packet<impl::TriangleMT4DoubleOps, false>(*this, 0, ray, 0, 0, 0)
+        | impl::intersect_triangle_mt_packet<impl::TriangleMT4DoubleOps, false>(*this, 2, ray, 0, 0, 0) << 2;
+}
+
+#endif  // APPLESEED_USE_SSE
+
+template <typename T>
+inline size_t find_closest_hit(
+    const size_t            mask,
+    const T                 t[TriangleMT4<T>::Width])
+{
+    assert(mask != 0);
+
+    size_t closest = 0;
+    while (!(mask & (size_t(1) << closest)))
+        ++closest;
+
+    for (size_t i = closest + 1; i < TriangleMT4<T>::Width; ++i)
+    {
+        if ((mask & (size_t(1) << i)) && t[i] < t[closest])
+            closest = i;
+    }
+
+    return closest;
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_INTERSECTION_RAYTRIANGLEMT4_H
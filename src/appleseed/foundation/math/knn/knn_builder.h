@@ -38,6 +38,7 @@
 #include "foundation/math/permutation.h"
 #include "foundation/math/split.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/thread.h"
 #include "foundation/utility/stopwatch.h"
 
 // Standard headers.
@@ -75,6 +76,14 @@ class Builder
     void build_move_points(
         std::vector<VectorType>&    points);
 
+    // Like build_move_points() but the subtrees below the top levels of the tree
+    // are built on 'thread_count' threads. The resulting tree answers queries
+    // exactly like the one built by the single-threaded methods.
+    template <typename Timer>
+    void build_move_points(
+        std::vector<VectorType>&    points,
+        const size_t                thread_count);
+
     // Return the construction time.
     double get_build_time() const;
 
@@ -98,13 +107,44 @@ class Builder
             const size_t            index) const;
     };
 
+    typedef std::vector<NodeType> NodeVector;
+
+    // A subtree whose construction was deferred to a worker thread.
+    struct Subtree
+    {
+        size_t                      m_root_node_index;  // index of the root node in the tree
+        size_t                      m_begin;
+        size_t                      m_end;
+        NodeVector                  m_nodes;            // nodes of the subtree, root first
+
+        bool operator<(const Subtree& rhs) const;
+    };
+
+    typedef std::vector<Subtree> SubtreeVector;
+
+    class SubtreeBuilder;
+
     TreeType&   m_tree;
     double      m_build_time;
 
+    void initialize(
+        std::vector<VectorType>&    points);
+
+    void finalize();
+
+    // Build the subtree over [begin, end) and store its root at nodes[parent_node_index].
+    // If 'subtrees' is not null, ranges of at most 'max_subtree_size' points are recorded
+    // there instead of being partitioned further.
     void partition(
+        NodeVector&                 nodes,
         const size_t                parent_node_index,
         const size_t                begin,
-        const size_t                end) const;
+        const size_t                end,
+        const size_t                max_subtree_size = 0,
+        SubtreeVector*              subtrees = 0) const;
+
+    // Append the nodes of a subtree built by a worker thread to the tree.
+    void insert_subtree(const Subtree& subtree);
 
     BboxType compute_bbox(
         const size_t                begin,
@@ -153,6 +193,124 @@ void Builder<T, N>::build_move_points(
     Stopwatch<Timer> stopwatch;
     stopwatch.start();
 
+    initialize(points);
+    partition(m_tree.m_nodes, 0, 0, m_tree.m_points.size());
+    finalize();
+
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+}
+
+template <typename T, size_t N>
+class Builder<T, N>::SubtreeBuilder
+{
+  public:
+    SubtreeBuilder(
+        const Builder&              builder,
+        SubtreeVector&              subtrees,
+        size_t&                     next_subtree,
+        boost::mutex&               mutex)
+      : m_builder(builder)
+      , m_subtrees(subtrees)
+      , m_next_subtree(next_subtree)
+      , m_mutex(mutex)
+    {
+    }
+
+    void operator()()
+    {
+        while (true)
+        {
+            size_t subtree_index;
+
+            {
+                boost::mutex::scoped_lock lock(m_mutex);
+                if (m_next_subtree == m_subtrees.size())
+                    break;
+                subtree_index = m_next_subtree++;
+            }
+
+            // Subtrees cover disjoint ranges of the index array and own their nodes.
+            Subtree& subtree = m_subtrees[subtree_index];
+            subtree.m_nodes.reserve((subtree.m_end - subtree.m_begin) * 2 + 1);
+            subtree.m_nodes.push_back(NodeType());
+            m_builder.partition(subtree.m_nodes, 0, subtree.m_begin, subtree.m_end);
+        }
+    }
+
+  private:
+    const Builder&                  m_builder;
+    SubtreeVector&                  m_subtrees;
+    size_t&                         m_next_subtree;
+    boost::mutex&                   m_mutex;
+};
+
+template <typename T, size_t N>
+template <typename Timer>
+void Builder<T, N>::build_move_points(
+    std::vector<VectorType>&    points,
+    const size_t                thread_count)
+{
+    // Below this size, a subtree is not worth handing out to a worker thread.
+    const size_t MinSubtreeSize = 1024;
+
+    const size_t count = points.size();
+
+    if (thread_count <= 1 || count <= MinSubtreeSize)
+    {
+        build_move_points<Timer>(points);
+        return;
+    }
+
+    Stopwatch<Timer> stopwatch;
+    stopwatch.start();
+
+    initialize(points);
+
+    // Build the top of the tree on the calling thread, deferring the subtrees.
+    // Several subtrees per thread keep the threads busy despite unbalanced splits.
+    const size_t max_subtree_size = std::max(count / (thread_count * 8), MinSubtreeSize);
+    SubtreeVector subtrees;
+    partition(m_tree.m_nodes, 0, 0, count, max_subtree_size, &subtrees);
+
+    // Build the largest subtrees first.
+    std::sort(subtrees.begin(), subtrees.end());
+
+    // Build the subtrees.
+    size_t next_subtree = 0;
+    boost::mutex mutex;
+    SubtreeBuilder subtree_builder(*this, subtrees, next_subtree, mutex);
+    boost::thread_group threads;
+    for (size_t i = 0; i < std::min(thread_count, subtrees.size()); ++i)
+        threads.create_thread(subtree_builder);
+    threads.join_all();
+
+    // Stitch the subtrees into the tree.
+    for (size_t i = 0; i < subtrees.size(); ++i)
+        insert_subtree(subtrees[i]);
+
+    finalize();
+
+    stopwatch.measure();
+    m_build_time = stopwatch.get_seconds();
+}
+
+template <typename T, size_t N>
+inline double Builder<T, N>::get_build_time() const
+{
+    return m_build_time;
+}
+
+template <typename T, size_t N>
+inline bool Builder<T, N>::Subtree::operator<(const Subtree& rhs) const
+{
+    return m_end - m_begin > rhs.m_end - rhs.m_begin;
+}
+
+template <typename T, size_t N>
+void Builder<T, N>::initialize(
+    std::vector<VectorType>&    points)
+{
     const size_t count = points.size();
 
     if (count > 0)
@@ -167,8 +325,12 @@ void Builder<T, N>::build_move_points(
 
     m_tree.m_nodes.reserve(count * 2 + 1);
     m_tree.m_nodes.push_back(NodeType());
+}
 
-    partition(0, 0, count);
+template <typename T, size_t N>
+void Builder<T, N>::finalize()
+{
+    const size_t count = m_tree.m_points.size();
 
     if (count > 0)
     {
@@ -180,15 +342,26 @@ void Builder<T, N>::build_move_points(
             &m_tree.m_indices[0],
             count);
     }
-
-    stopwatch.measure();
-    m_build_time = stopwatch.get_seconds();
 }
 
 template <typename T, size_t N>
-inline double Builder<T, N>::get_build_time() const
+void Builder<T, N>::insert_subtree(const Subtree& subtree)
 {
-    return m_build_time;
+    // Node i > 0 of the subtree lands at index offset + i - 1 in the tree.
+    const size_t offset = m_tree.m_nodes.size();
+
+    for (size_t i = 0; i < subtree.m_nodes.size(); ++i)
+    {
+        NodeType node = subtree.m_nodes[i];
+
+        if (node.is_interior())
+            node.set_child_node_index(offset + node.get_child_node_index() - 1);
+
+        if (i == 0)
+            m_tree.m_nodes[subtree.m_root_node_index] = node;
+        else
+            m_tree.m_nodes.push_back(node);
+    }
 }
 
 template <typename T, size_t N>
@@ -209,15 +382,26 @@ inline bool Builder<T, N>::PartitionPredicate::operator()(
 
 template <typename T, size_t N>
 void Builder<T, N>::partition(
+    NodeVector&                 nodes,
     const size_t                parent_node_index,
     const size_t                begin,
-    const size_t                end) const
+    const size_t                end,
+    const size_t                max_subtree_size,
+    SubtreeVector*              subtrees) const
 {
     const size_t count = end - begin;
 
-    if (count <= 1)
+    if (subtrees && count <= max_subtree_size)
+    {
+        subtrees->push_back(Subtree());
+        Subtree& subtree = subtrees->back();
+        subtree.m_root_node_index = parent_node_index;
+        subtree.m_begin = begin;
+        subtree.m_end = end;
+    }
+    else if (count <= 1)
     {
-        NodeType& parent_node = m_tree.m_nodes[parent_node_index];
+        NodeType& parent_node = nodes[parent_node_index];
         parent_node.make_leaf();
         parent_node.set_point_index(begin);
         parent_node.set_point_count(count);
@@ -244,13 +428,13 @@ void Builder<T, N>::partition(
         if (pivot == begin || pivot == end)
             pivot = (begin + end) / 2;
 
-        const size_t left_node_index = m_tree.m_nodes.size();
+        const size_t left_node_index = nodes.size();
         const size_t right_node_index = left_node_index + 1;
 
-        m_tree.m_nodes.push_back(NodeType());
-        m_tree.m_nodes.push_back(NodeType());
+        nodes.push_back(NodeType());
+        nodes.push_back(NodeType());
 
-        NodeType& parent_node = m_tree.m_nodes[parent_node_index];
+        NodeType& parent_node = nodes[parent_node_index];
         parent_node.make_interior();
         parent_node.set_split_dim(split.m_dimension);
         parent_node.set_split_abs(split.m_abscissa);
@@ -258,8 +442,8 @@ void Builder<T, N>::partition(
         parent_node.set_point_index(begin);
         parent_node.set_point_count(count);
 
-        partition(left_node_index, begin, pivot);
-        partition(right_node_index, pivot, end);
+        partition(nodes, left_node_index, begin, pivot, max_subtree_size, subtrees);
+        partition(nodes, right_node_index, pivot, end, max_subtree_size, subtrees);
     }
 }
 
@@ -40,11 +40,17 @@
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <limits>
+#include <utility>
+#include <vector>
 
 // Enable or disable k-nn query statistics.
 #undef FOUNDATION_KNN_ENABLE_QUERY_STATS
@@ -52,6 +58,59 @@
 namespace foundation {
 namespace knn {
 
+namespace knn_impl
+{
+    //
+    // Computes the square distances between a query point and groups of four consecutive
+    // points, so that leaves can be scanned four points at a time.
+    //
+
+    template <typename T, size_t N>
+    class PointScanner
+    {
+      public:
+        typedef Vector<T, N> VectorType;
+
+        explicit PointScanner(const VectorType& query_point);
+
+        // Store the square distances between the query point and points[0..3] into
+        // square_dists[0..3], and return a bit mask of the points that are strictly
+        // closer to the query point than the square root of 'max_square_dist'.
+        size_t scan4(
+            const VectorType    points[],
+            const T             max_square_dist,
+            T                   square_dists[4]) const;
+
+      private:
+        const VectorType        m_query_point;
+    };
+
+#ifdef APPLESEED_USE_SSE
+
+    template <>
+    class PointScanner<float, 3>
+    {
+      public:
+        typedef Vector<float, 3> VectorType;
+
+        explicit PointScanner(const VectorType& query_point);
+
+        size_t scan4(
+            const VectorType    points[],
+            const float         max_square_dist,
+            float               square_dists[4]) const;
+
+      private:
+        // The query point, replicated to match the layout of four consecutive points
+        // loaded into three registers: (x0 y0 z0 x1) (y1 z1 x2 y2) (z2 x3 y3 z3).
+        __m128                  m_q0;
+        __m128                  m_q1;
+        __m128                  m_q2;
+    };
+
+#endif
+}
+
 template <typename T, size_t N>
 class Query
   : public NonCopyable
@@ -92,6 +151,17 @@ class Query
         const ValueType     query_max_square_distance) const;
 #endif
 
+    // Run one query per point of a batch of query points. Queries are run in an order
+    // that follows the leaves of the tree, so that consecutive queries visit the same
+    // nodes and points. Once the query of query_points[i] has completed, the answer is
+    // handed to the visitor with visitor.visit(i, answer).
+    template <typename Visitor>
+    void run(
+        const VectorType    query_points[],
+        const size_t        query_count,
+        const ValueType     query_max_square_distance,
+        Visitor&            visitor) const;
+
   private:
     typedef typename TreeType::NodeType NodeType;
 
@@ -121,6 +191,29 @@ class Query
 
     const TreeType&         m_tree;
     AnswerType&             m_answer;
+
+    // Return the leaf node that contains a given point.
+    const NodeType& find_leaf(const VectorType& point) const;
+
+    // Insert a point into the answer if it is closer than the current maximum search distance.
+    void insert(
+        const size_t        point_index,
+        const ValueType     square_dist,
+        const size_t        max_answer_size,
+        ValueType&          max_square_dist) const;
+
+    // Insert the points [point_index, point_index + point_count) into the answer.
+    void scan_points(
+        const VectorType&   query_point,
+        const knn_impl::PointScanner<T, N>& scanner,
+        size_t              point_index,
+        const size_t        point_count,
+        const size_t        max_answer_size,
+        ValueType&          max_square_dist
+#ifdef FOUNDATION_KNN_ENABLE_QUERY_STATS
+        , size_t&           tested_point_count
+#endif
+        ) const;
 };
 
 typedef Query<float, 2>  Query2f;
@@ -139,6 +232,164 @@ typedef Query<double, 3> Query3d;
 #define FOUNDATION_KNN_QUERY_STATS(x)
 #endif
 
+namespace knn_impl
+{
+    template <typename T, size_t N>
+    inline PointScanner<T, N>::PointScanner(const VectorType& query_point)
+      : m_query_point(query_point)
+    {
+    }
+
+    template <typename T, size_t N>
+    inline size_t PointScanner<T, N>::scan4(
+        const VectorType        points[],
+        const T                 max_square_dist,
+        T                       square_dists[4]) const
+    {
+        size_t mask = 0;
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            square_dists[i] = square_distance(points[i], m_query_point);
+
+            if (square_dists[i] < max_square_dist)
+                mask |= size_t(1) << i;
+        }
+
+        return mask;
+    }
+
+#ifdef APPLESEED_USE_SSE
+
+    inline PointScanner<float, 3>::PointScanner(const VectorType& query_point)
+      : m_q0(_mm_setr_ps(query_point.x, query_point.y, query_point.z, query_point.x))
+      , m_q1(_mm_setr_ps(query_point.y, query_point.z, query_point.x, query_point.y))
+      , m_q2(_mm_setr_ps(query_point.z, query_point.x, query_point.y, query_point.z))
+    {
+    }
+
+    APPLESEED_FORCE_INLINE size_t PointScanner<float, 3>::scan4(
+        const VectorType        points[],
+        const float             max_square_dist,
+        float                   square_dists[4]) const
+    {
+        const float* p = &points[0].x;
+
+        // Squared differences, in the layout (x0 y0 z0 x1) (y1 z1 x2 y2) (z2 x3 y3 z3).
+        const __m128 d0 = _mm_sub_ps(_mm_loadu_ps(p + 0), m_q0);
+        const __m128 d1 = _mm_sub_ps(_mm_loadu_ps(p + 4), m_q1);
+        const __m128 d2 = _mm_sub_ps(_mm_loadu_ps(p + 8), m_q2);
+        const __m128 s0 = _mm_mul_ps(d0, d0);
+        const __m128 s1 = _mm_mul_ps(d1, d1);
+        const __m128 s2 = _mm_mul_ps(d2, d2);
+
+        // Transpose to (x0 x1 x2 x3) (y0 y1 y2 y3) (z0 z1 z2 z3).
+        const __m128 x = _mm_shuffle_ps(s0, _mm_shuffle_ps(s1, s2, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+        const __m128 y =
+            _mm_shuffle_ps(
+                _mm_shuffle_ps(s0, s1, _MM_SHUFFLE(0, 0, 1, 1)),
+                _mm_shuffle_ps(s1, s2, _MM_SHUFFLE(2, 2, 3, 3)),
+                _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(s0, s1, _MM_SHUFFLE(1, 1, 2, 2)), s2, _MM_SHUFFLE(3, 0, 2, 0));
+
+        // Same order of operations as square_distance(), so that results are identical.
+        const __m128 d = _mm_add_ps(_mm_add_ps(x, y), z);
+        _mm_storeu_ps(square_dists, d);
+
+        return static_cast<size_t>(_mm_movemask_ps(_mm_cmplt_ps(d, _mm_set1_ps(max_square_dist))));
+    }
+
+#endif
+}
+
+template <typename T, size_t N>
+inline const typename Query<T, N>::NodeType& Query<T, N>::find_leaf(const VectorType& point) const
+{
+    const NodeType* APPLESEED_RESTRICT nodes = &m_tree.m_nodes.front();
+    const NodeType* APPLESEED_RESTRICT node = nodes;
+
+    while (node->is_interior())
+    {
+        const size_t split_dim = node->get_split_dim();
+        const NodeType* APPLESEED_RESTRICT child_node = nodes + node->get_child_node_index();
+
+        if (point[split_dim] > node->get_split_abs())
+            ++child_node;
+
+        node = child_node;
+    }
+
+    return *node;
+}
+
+template <typename T, size_t N>
+APPLESEED_FORCE_INLINE void Query<T, N>::insert(
+    const size_t            point_index,
+    const ValueType         square_dist,
+    const size_t            max_answer_size,
+    ValueType&              max_square_dist) const
+{
+    if (square_dist < max_square_dist)
+    {
+        if (m_answer.m_size == max_answer_size)
+        {
+            m_answer.heap_insert(point_index, square_dist);
+            max_square_dist = m_answer.top().m_square_dist;
+        }
+        else
+        {
+            m_answer.array_insert(point_index, square_dist);
+
+            if (m_answer.m_size == max_answer_size)
+                m_answer.make_heap();
+        }
+    }
+}
+
+template <typename T, size_t N>
+inline void Query<T, N>::scan_points(
+    const VectorType&       query_point,
+    const knn_impl::PointScanner<T, N>& scanner,
+    size_t                  point_index,
+    const size_t            point_count,
+    const size_t            max_answer_size,
+    ValueType&              max_square_dist
+#ifdef FOUNDATION_KNN_ENABLE_QUERY_STATS
+    , size_t&               tested_point_count
+#endif
+    ) const
+{
+    const VectorType* APPLESEED_RESTRICT point_ptr = &m_tree.m_points.front() + point_index;
+    const VectorType* APPLESEED_RESTRICT point_end = point_ptr + point_count;
+
+    // Test points four at a time, and only look at the points closer than the current
+    // maximum search distance. That distance may shrink while a group is inserted.
+    while (point_end - point_ptr >= 4)
+    {
+        FOUNDATION_KNN_QUERY_STATS(tested_point_count += 4);
+
+        ValueType square_dists[4];
+        size_t mask = scanner.scan4(point_ptr, max_square_dist, square_dists);
+
+        for (size_t i = 0; mask != 0; ++i, mask >>= 1)
+        {
+            if (mask & 1)
+                insert(point_index + i, square_dists[i], max_answer_size, max_square_dist);
+        }
+
+        point_ptr += 4;
+        point_index += 4;
+    }
+
+    while (point_ptr < point_end)
+    {
+        FOUNDATION_KNN_QUERY_STATS(++tested_point_count);
+
+        const ValueType square_dist = square_distance(*point_ptr++, query_point);
+        insert(point_index++, square_dist, max_answer_size, max_square_dist);
+    }
+}
+
 template <typename T, size_t N>
 inline Query<T, N>::Query(
     const TreeType&         tree,
@@ -186,6 +437,7 @@ inline void Query<T, N>::run(
     const VectorType* APPLESEED_RESTRICT points = &m_tree.m_points.front();
     const NodeType* APPLESEED_RESTRICT nodes = &m_tree.m_nodes.front();
     const size_t max_answer_size = m_answer.m_max_size;
+    const knn_impl::PointScanner<T, N> scanner(query_point);
 
     //
     // Step 1:
@@ -276,20 +528,17 @@ inline void Query<T, N>::run(
             m_answer.make_heap();
 
             // Then, we insert the remaining points into the answer.
-            while (point_ptr < point_end)
-            {
-                FOUNDATION_KNN_QUERY_STATS(++tested_point_count);
-
-                const ValueType square_dist = square_distance(*point_ptr++, query_point);
-
-                if (square_dist < max_square_dist)
-                {
-                    m_answer.heap_insert(point_index, square_dist);
-                    max_square_dist = m_answer.top().m_square_dist;
-                }
-
-                ++point_index;
-            }
+            scan_points(
+                query_point,
+                scanner,
+                point_index,
+                static_cast<size_t>(point_end - point_ptr),
+                max_answer_size,
+                max_square_dist
+#ifdef FOUNDATION_KNN_ENABLE_QUERY_STATS
+                , tested_point_count
+#endif
+                );
         }
         else
         {
@@ -431,34 +680,17 @@ inline void Query<T, N>::run(
 
         FOUNDATION_KNN_QUERY_STATS(++visited_leaf_count);
 
-        size_t point_index = node->get_point_index();
-        const VectorType* APPLESEED_RESTRICT point_ptr = points + point_index;
-        const VectorType* APPLESEED_RESTRICT point_end = point_ptr + node->get_point_count();
-
-        while (point_ptr < point_end)
-        {
-            FOUNDATION_KNN_QUERY_STATS(++tested_point_count);
-
-            const ValueType square_dist = square_distance(*point_ptr++, query_point);
-
-            if (square_dist < max_square_dist)
-            {
-                if (m_answer.m_size == max_answer_size)
-                {
-                    m_answer.heap_insert(point_index, square_dist);
-                    max_square_dist = m_answer.top().m_square_dist;
-                }
-                else
-                {
-                    m_answer.array_insert(point_index, square_dist);
-
-                    if (m_answer.m_size == max_answer_size)
-                        m_answer.make_heap();
-                }
-            }
-
-            ++point_index;
-        }
+        scan_points(
+            query_point,
+            scanner,
+            node->get_point_index(),
+            node->get_point_count(),
+            max_answer_size,
+            max_square_dist
+#ifdef FOUNDATION_KNN_ENABLE_QUERY_STATS
+            , tested_point_count
+#endif
+            );
     }
 
 #undef ORDER_NODE_ENTRIES
@@ -468,6 +700,33 @@ inline void Query<T, N>::run(
     FOUNDATION_KNN_QUERY_STATS(stats.m_tested_points.insert(tested_point_count));
 }
 
+template <typename T, size_t N>
+template <typename Visitor>
+void Query<T, N>::run(
+    const VectorType        query_points[],
+    const size_t            query_count,
+    const ValueType         query_max_square_distance,
+    Visitor&                visitor) const
+{
+    assert(!m_tree.empty());
+
+    // Points are stored in the order of the leaves, and neighboring leaves have neighboring
+    // points: sorting the queries by the first point of their leaf makes them coherent.
+    std::vector<std::pair<size_t, size_t> > order(query_count);
+
+    for (size_t i = 0; i < query_count; ++i)
+        order[i] = std::make_pair(find_leaf(query_points[i]).get_point_index(), i);
+
+    std::sort(order.begin(), order.end());
+
+    for (size_t i = 0; i < query_count; ++i)
+    {
+        const size_t query_index = order[i].second;
+        run(query_points[query_index], query_max_square_distance);
+        visitor.visit(query_index, m_answer);
+    }
+}
+
 #ifdef FOUNDATION_KNN_ENABLE_QUERY_STATS
 
 template <typename T, size_t N>
@@ -34,6 +34,7 @@
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/knn/knn_node.h"
 #include "foundation/math/vector.h"
+#include "foundation/utility/memory.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
@@ -44,6 +45,7 @@
 DECLARE_TEST_CASE(Foundation_Math_Knn_Builder, Build_GivenZeroPoint_BuildsEmptyTree);
 DECLARE_TEST_CASE(Foundation_Math_Knn_Builder, Build_GivenTwoPoints_BuildsCorrectTree);
 DECLARE_TEST_CASE(Foundation_Math_Knn_Builder, Build_GivenEightPoints_GeneratesFifteenNodes);
+DECLARE_TEST_CASE(Foundation_Math_Knn_Builder, BuildMovePoints_GivenSeveralThreads_BuildsSameTreeAsSingleThreadedBuild);
 
 namespace foundation {
 namespace knn {
@@ -71,6 +73,10 @@ class Tree
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
 
+    // Ask for the arrays of the tree to be backed by large pages.
+    // Return the number of large pages covered by the request.
+    size_t advise_large_pages() const;
+
   private:
     template <typename, size_t> friend class Builder;
     template <typename, size_t> friend class Query;
@@ -79,6 +85,7 @@ class Tree
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Math_Knn_Builder, Build_GivenZeroPoint_BuildsEmptyTree);
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Math_Knn_Builder, Build_GivenTwoPoints_BuildsCorrectTree);
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Math_Knn_Builder, Build_GivenEightPoints_GeneratesFifteenNodes);
+    GRANT_ACCESS_TO_TEST_CASE(Foundation_Math_Knn_Builder, BuildMovePoints_GivenSeveralThreads_BuildsSameTreeAsSingleThreadedBuild);
 
     std::vector<VectorType> m_points;
     std::vector<size_t>     m_indices;
@@ -125,6 +132,15 @@ inline size_t Tree<T, N>::get_memory_size() const
     return mem_size;
 }
 
+template <typename T, size_t N>
+inline size_t Tree<T, N>::advise_large_pages() const
+{
+    return
+        foundation::advise_large_pages(m_points) +
+        foundation::advise_large_pages(m_indices) +
+        foundation::advise_large_pages(m_nodes);
+}
+
 }       // namespace knn
 }       // namespace foundation
 
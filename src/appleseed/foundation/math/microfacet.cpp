@@ -30,10 +30,12 @@
 #include "microfacet.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/qmc.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/specialfunctions.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 
@@ -773,4 +775,114 @@ float GTR1MDF::pdf(
     return D(h, alpha_x, alpha_y, gamma) * h.y;
 }
 
+
+//
+// MDFAlbedoTable class implementation.
+//
+
+namespace
+{
+    // Smallest alpha and view angle cosine at which the tables are integrated.
+    const float MinAlbedoTableParam = 0.001f;
+
+    float albedo_table_param(const size_t i)
+    {
+        return
+            std::max(
+                static_cast<float>(i) / (MDFAlbedoTable::TableSize - 1),
+                MinAlbedoTableParam);
+    }
+
+    float integrate_directional_albedo(
+        const MDF&      mdf,
+        const float     cos_theta,
+        const float     alpha,
+        const size_t    sample_count)
+    {
+        const Vector3f wo(std::sqrt(std::max(0.0f, 1.0f - square(cos_theta))), cos_theta, 0.0f);
+        const size_t Bases[] = { 2, 3 };
+
+        float albedo = 0.0f;
+
+        for (size_t i = 0; i < sample_count; ++i)
+        {
+            const Vector3f s = hammersley_sequence<float, 3>(Bases, sample_count, i);
+            const Vector3f m = mdf.sample(wo, s, alpha, alpha);
+            const float cos_om = dot(wo, m);
+            if (cos_om <= 0.0f)
+                continue;
+
+            const Vector3f wi = reflect(wo, m);
+            if (wi.y <= 0.0f)
+                continue;
+
+            const float pdf = mdf.pdf(wo, m, alpha, alpha) / (4.0f * cos_om);
+            if (pdf <= 0.0f)
+                continue;
+
+            // Single scattering BRDF times cos(theta_i), with a Fresnel term of 1.
+            const float D = mdf.D(m, alpha, alpha);
+            const float G = mdf.G(wi, wo, m, alpha, alpha);
+            albedo += D * G / (4.0f * cos_theta * pdf);
+        }
+
+        return saturate(albedo / sample_count);
+    }
+}
+
+MDFAlbedoTable::MDFAlbedoTable(
+    const MDF&          mdf,
+    const size_t        sample_count)
+{
+    assert(sample_count > 0);
+
+    for (size_t j = 0; j < TableSize; ++j)
+    {
+        const float alpha = albedo_table_param(j);
+        float* albedo = &m_albedo[j * TableSize];
+
+        for (size_t i = 0; i < TableSize; ++i)
+            albedo[i] = integrate_directional_albedo(mdf, albedo_table_param(i), alpha, sample_count);
+
+        // Average albedo: 2 * integral of E(mu) * mu over [0, 1], using the trapezoidal rule.
+        float avg = 0.0f;
+        for (size_t i = 0; i < TableSize - 1; ++i)
+        {
+            const float mu0 = static_cast<float>(i) / (TableSize - 1);
+            const float mu1 = static_cast<float>(i + 1) / (TableSize - 1);
+            avg += (albedo[i] * mu0 + albedo[i + 1] * mu1) * (mu1 - mu0);
+        }
+
+        m_avg_albedo[j] = saturate(avg);
+    }
+}
+
+float MDFAlbedoTable::get_directional_albedo(
+    const float         cos_theta,
+    const float         alpha) const
+{
+    const float x = saturate(cos_theta) * (TableSize - 1);
+    const float y = saturate(alpha) * (TableSize - 1);
+    const size_t x0 = std::min(truncate<size_t>(x), static_cast<size_t>(TableSize - 2));
+    const size_t y0 = std::min(truncate<size_t>(y), static_cast<size_t>(TableSize - 2));
+    const float fx = x - x0;
+    const float fy = y - y0;
+
+    const float* row0 = &m_albedo[y0 * TableSize + x0];
+    const float* row1 = row0 + TableSize;
+
+    return
+        lerp(
+            lerp(row0[0], row0[1], fx),
+            lerp(row1[0], row1[1], fx),
+            fy);
+}
+
+float MDFAlbedoTable::get_average_albedo(const float alpha) const
+{
+    const float y = saturate(alpha) * (TableSize - 1);
+    const size_t y0 = std::min(truncate<size_t>(y), static_cast<size_t>(TableSize - 2));
+    return lerp(m_avg_albedo[y0], m_avg_albedo[y0 + 1], y - y0);
+}
+
 }   // namespace foundation
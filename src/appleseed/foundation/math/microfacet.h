@@ -36,6 +36,7 @@
 
 // Standard headers.
 #include <algorithm>
+#include <cstddef>
 
 namespace foundation
 {
@@ -407,6 +408,46 @@ class GTR1MDF
         const float         gamma) const;
 };
 
+
+//
+// Directional albedo of a microfacet BRDF with a perfectly reflective Fresnel term,
+// tabulated once as a function of the cosine of the view angle and of the (isotropic)
+// alpha parameter, together with its cosine-weighted hemispherical average.
+//
+// These tables make it possible to compensate for the energy lost by single
+// scattering microfacet models at O(1) cost.
+//
+// Reference:
+//
+//   Revisiting Physically Based Shading at Imageworks
+//   http://blog.selfshadow.com/publications/s2017-shading-course/imageworks/s2017_pbs_imageworks_slides.pdf
+//
+
+class MDFAlbedoTable
+  : public NonCopyable
+{
+  public:
+    // Number of entries along each dimension of the tables.
+    enum { TableSize = 32 };
+
+    // Constructor, integrates the microfacet BRDF with 'sample_count' samples per table entry.
+    explicit MDFAlbedoTable(
+        const MDF&          mdf,
+        const size_t        sample_count = 256);
+
+    // Return the directional albedo for a given view angle and alpha, bilinearly interpolated.
+    float get_directional_albedo(
+        const float         cos_theta,
+        const float         alpha) const;
+
+    // Return the hemispherical average albedo for a given alpha, linearly interpolated.
+    float get_average_albedo(const float alpha) const;
+
+  private:
+    float   m_albedo[TableSize * TableSize];        // indexed by [alpha * TableSize + cos_theta]
+    float   m_avg_albedo[TableSize];                // indexed by [alpha]
+};
+
 }       // namespace foundation
 
 #endif  // !APPLESEED_FOUNDATION_MATH_MICROFACET_H
@@ -0,0 +1,132 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_FOUNDATION_MATH_OCTAHEDRAL_H
+#define APPLESEED_FOUNDATION_MATH_OCTAHEDRAL_H
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cmath>
+
+namespace foundation
+{
+
+//
+// Octahedral encoding of unit vectors.
+//
+// The unit sphere is projected onto an octahedron which is then unfolded onto a square.
+// Each coordinate of the square is quantized to 16 bits, and both are packed into 32 bits.
+// The maximum angular error is about 0.005 degrees.
+//
+// Reference:
+//
+//   A Survey of Efficient Representations for Independent Unit Vectors
+//   http://jcgt.org/published/0003/02/01/paper.pdf
+//
+
+// Encode a unit vector.
+template <typename T>
+uint32 octahedral_encode(const Vector<T, 3>& v);
+
+// Decode a unit vector encoded with octahedral_encode().
+template <typename T>
+Vector<T, 3> octahedral_decode(const uint32 code);
+
+
+//
+// Octahedral encoding implementation.
+//
+
+namespace impl
+{
+    template <typename T>
+    inline T octahedral_sign(const T x)
+    {
+        return x < T(0.0) ? T(-1.0) : T(1.0);
+    }
+
+    template <typename T>
+    inline uint32 octahedral_quantize(const T x)
+    {
+        return truncate<uint32>(saturate(x * T(0.5) + T(0.5)) * T(65535.0) + T(0.5));
+    }
+
+    template <typename T>
+    inline T octahedral_dequantize(const uint32 x)
+    {
+        return static_cast<T>(x) * T(2.0 / 65535.0) - T(1.0);
+    }
+}
+
+template <typename T>
+inline uint32 octahedral_encode(const Vector<T, 3>& v)
+{
+    const T rcp_norm1 = T(1.0) / (std::abs(v[0]) + std::abs(v[1]) + std::abs(v[2]));
+
+    T x = v[0] * rcp_norm1;
+    T y = v[1] * rcp_norm1;
+
+    // Fold the lower hemisphere over the diagonals.
+    if (v[2] < T(0.0))
+    {
+        const T folded_x = (T(1.0) - std::abs(y)) * impl::octahedral_sign(x);
+        const T folded_y = (T(1.0) - std::abs(x)) * impl::octahedral_sign(y);
+        x = folded_x;
+        y = folded_y;
+    }
+
+    return
+        (impl::octahedral_quantize(x) << 16) |
+         impl::octahedral_quantize(y);
+}
+
+template <typename T>
+inline Vector<T, 3> octahedral_decode(const uint32 code)
+{
+    Vector<T, 3> v;
+    v[0] = impl::octahedral_dequantize<T>(code >> 16);
+    v[1] = impl::octahedral_dequantize<T>(code & 0xFFFFUL);
+    v[2] = T(1.0) - std::abs(v[0]) - std::abs(v[1]);
+
+    // Unfold the lower hemisphere.
+    if (v[2] < T(0.0))
+    {
+        const T x = v[0];
+        v[0] = (T(1.0) - std::abs(v[1])) * impl::octahedral_sign(x);
+        v[1] = (T(1.0) - std::abs(x)) * impl::octahedral_sign(v[1]);
+    }
+
+    return normalize(v);
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_OCTAHEDRAL_H
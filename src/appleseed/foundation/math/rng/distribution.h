@@ -106,6 +106,16 @@ template <typename VectorType, typename RNG>
 VectorType rand_vector3(RNG& rng);
 
 
+//
+// Batches.
+//
+
+// Generate 'count' full-range 32-bit random numbers. Generators producing several
+// values at once (such as SimdXorshift and SimdPCG) provide their own overloads.
+template <typename RNG>
+void rand_uint32_batch(RNG& rng, uint32 values[], const size_t count);
+
+
 //
 // Implementation.
 //
@@ -350,6 +360,13 @@ inline VectorType rand_vector3(RNG& rng)
     return v;
 }
 
+template <typename RNG>
+inline void rand_uint32_batch(RNG& rng, uint32 values[], const size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        values[i] = rng.rand_uint32();
+}
+
 }       // namespace foundation
 
 #endif  // !APPLESEED_FOUNDATION_MATH_RNG_DISTRIBUTION_H
@@ -0,0 +1,242 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_FOUNDATION_MATH_RNG_SIMDPCG_H
+#define APPLESEED_FOUNDATION_MATH_RNG_SIMDPCG_H
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
+#include "foundation/platform/types.h"
+
+// Boost headers.
+#include "boost/static_assert.hpp"
+
+// Standard headers.
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// A bank of 4 or 8 PCG random number generators, stepped together with AVX2
+// instructions when available.
+//
+// All lanes share the same initial state but each one uses its own stream:
+// lane i produces the same sequence as PCG(init_state, init_seq + i).
+// Batches of values are produced one value per lane; rand_uint32() hands out
+// the values of a batch one at a time so that this class can be used like any
+// other random number generator.
+//
+
+template <size_t Lanes>
+class SimdPCG
+{
+  public:
+    BOOST_STATIC_ASSERT(Lanes == 4 || Lanes == 8);
+
+    // Number of values generated at once.
+    static const size_t LaneCount = Lanes;
+
+    // Constructor, seeds the generator.
+    SimdPCG(
+        const uint64 init_state = 0X853C49E6748FEA9BULL,
+        const uint64 init_seq = 0XDA3E39CB94B95BDBULL);
+
+    // Generate one 32-bit random number per lane.
+    void rand_uint32(uint32 values[Lanes]);
+
+    // Generate one random number in [0,1) per lane.
+    void rand_float2(float values[Lanes]);
+
+    // Generate a single 32-bit random number.
+    uint32 rand_uint32();
+
+  private:
+    // Only 16-byte aligned so that instances can be allocated with operator new;
+    // 256-bit accesses to these arrays use unaligned loads and stores.
+    APPLESEED_SIMD4_ALIGN uint64    m_state[Lanes];     // current state of the generators
+    APPLESEED_SIMD4_ALIGN uint64    m_inc[Lanes];       // streams of the generators -- must *always* be odd
+    APPLESEED_SIMD4_ALIGN uint32    m_buffer[Lanes];    // values handed out by rand_uint32()
+    size_t                          m_buffer_index;
+};
+
+// Generate 'count' 32-bit random numbers, whole batches at a time.
+template <size_t Lanes>
+void rand_uint32_batch(
+    SimdPCG<Lanes>&         rng,
+    uint32                  values[],
+    const size_t            count);
+
+
+//
+// SimdPCG class implementation.
+//
+
+#pragma warning (push)
+#pragma warning (disable : 4146)    // unary minus operator applied to unsigned type, result still unsigned
+
+namespace simdpcg_impl
+{
+    const uint64 Multiplier = 6364136223846793005ULL;
+
+    inline uint32 output(const uint64 old_state)
+    {
+        const uint32 xorshifted = static_cast<uint32>(((old_state >> 18) ^ old_state) >> 27);
+        const uint32 rot = static_cast<uint32>(old_state >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+    }
+}
+
+template <size_t Lanes>
+inline SimdPCG<Lanes>::SimdPCG(const uint64 init_state, const uint64 init_seq)
+  : m_buffer_index(Lanes)
+{
+    // Same seeding procedure as the PCG class, for each stream.
+    for (size_t i = 0; i < Lanes; ++i)
+    {
+        m_inc[i] = ((init_seq + i) << 1) | 1;
+        m_state[i] = m_inc[i];
+        m_state[i] += init_state;
+        m_state[i] = m_state[i] * simdpcg_impl::Multiplier + m_inc[i];
+    }
+}
+
+template <size_t Lanes>
+inline void SimdPCG<Lanes>::rand_uint32(uint32 values[Lanes])
+{
+#ifdef APPLESEED_USE_AVX2
+
+    const __m256i mul_lo = _mm256_set1_epi64x(static_cast<int64>(simdpcg_impl::Multiplier & 0xFFFFFFFFULL));
+    const __m256i mul_hi = _mm256_set1_epi64x(static_cast<int64>(simdpcg_impl::Multiplier >> 32));
+    const __m256i mask32 = _mm256_set1_epi64x(0xFFFFFFFFLL);
+    const __m256i thirty_two = _mm256_set1_epi64x(32);
+    const __m256i even_lanes = _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0);
+
+    for (size_t i = 0; i < Lanes; i += 4)
+    {
+        const __m256i old_state = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_state + i));
+        const __m256i inc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_inc + i));
+
+        // 64-bit low multiply from 32x32->64 bit products.
+        const __m256i lo = _mm256_mul_epu32(old_state, mul_lo);
+        const __m256i cross =
+            _mm256_add_epi64(
+                _mm256_mul_epu32(_mm256_srli_epi64(old_state, 32), mul_lo),
+                _mm256_mul_epu32(old_state, mul_hi));
+        const __m256i product = _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(m_state + i), _mm256_add_epi64(product, inc));
+
+        // XSH RR output function.
+        const __m256i xorshifted =
+            _mm256_and_si256(
+                _mm256_srli_epi64(_mm256_xor_si256(_mm256_srli_epi64(old_state, 18), old_state), 27),
+                mask32);
+        const __m256i rot = _mm256_srli_epi64(old_state, 59);
+        const __m256i rotated =
+            _mm256_or_si256(
+                _mm256_srlv_epi64(xorshifted, rot),
+                _mm256_and_si256(_mm256_sllv_epi64(xorshifted, _mm256_sub_epi64(thirty_two, rot)), mask32));
+
+        const __m256i packed = _mm256_permutevar8x32_epi32(rotated, even_lanes);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), _mm256_castsi256_si128(packed));
+    }
+
+#else
+
+    for (size_t i = 0; i < Lanes; ++i)
+    {
+        const uint64 old_state = m_state[i];
+        m_state[i] = old_state * simdpcg_impl::Multiplier + m_inc[i];
+        values[i] = simdpcg_impl::output(old_state);
+    }
+
+#endif
+}
+
+#pragma warning (pop)
+
+template <size_t Lanes>
+inline void SimdPCG<Lanes>::rand_float2(float values[Lanes])
+{
+    APPLESEED_SIMD4_ALIGN uint32 x[Lanes];
+    rand_uint32(x);
+
+#ifdef APPLESEED_USE_SSE
+
+    const __m128 scale = _mm_set1_ps(1.0f / 16777216.0f);
+
+    for (size_t i = 0; i < Lanes; i += 4)
+    {
+        const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(x + i));
+        const __m128 f = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(v, 8)), scale);
+        _mm_storeu_ps(values + i, f);
+    }
+
+#else
+
+    // Keep 24 bits so that values are exactly representable and less than 1.
+    for (size_t i = 0; i < Lanes; ++i)
+        values[i] = static_cast<float>(x[i] >> 8) * (1.0f / 16777216.0f);
+
+#endif
+}
+
+template <size_t Lanes>
+inline uint32 SimdPCG<Lanes>::rand_uint32()
+{
+    if (m_buffer_index == Lanes)
+    {
+        rand_uint32(m_buffer);
+        m_buffer_index = 0;
+    }
+
+    return m_buffer[m_buffer_index++];
+}
+
+template <size_t Lanes>
+inline void rand_uint32_batch(
+    SimdPCG<Lanes>&         rng,
+    uint32                  values[],
+    const size_t            count)
+{
+    size_t i = 0;
+
+    for (; i + Lanes <= count; i += Lanes)
+        rng.rand_uint32(values + i);
+
+    for (; i < count; ++i)
+        values[i] = rng.rand_uint32();
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_RNG_SIMDPCG_H
@@ -0,0 +1,218 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_FOUNDATION_MATH_RNG_SIMDXORSHIFT_H
+#define APPLESEED_FOUNDATION_MATH_RNG_SIMDXORSHIFT_H
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/xorshift.h"
+#include "foundation/platform/compiler.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
+#include "foundation/platform/types.h"
+
+// Boost headers.
+#include "boost/static_assert.hpp"
+
+// Standard headers.
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// A bank of 4 or 8 independent Xorshift random number generators of period 2^32 - 1,
+// stepped together with SSE2 or AVX2 instructions when available.
+//
+// The lanes are seeded with the successive outputs of a scalar Xorshift generator.
+// Batches of values are produced one value per lane; rand_uint32() hands out the
+// values of a batch one at a time so that this class can be used like any other
+// random number generator.
+//
+
+template <size_t Lanes>
+class SimdXorshift
+{
+  public:
+    BOOST_STATIC_ASSERT(Lanes == 4 || Lanes == 8);
+
+    // Number of values generated at once.
+    static const size_t LaneCount = Lanes;
+
+    // Constructor, seeds the generator.
+    explicit SimdXorshift(const uint32 seed = 2463534242UL);
+
+    // Generate one 32-bit random number per lane.
+    void rand_uint32(uint32 values[Lanes]);
+
+    // Generate one random number in [0,1) per lane.
+    void rand_float2(float values[Lanes]);
+
+    // Generate a single 32-bit random number.
+    uint32 rand_uint32();
+
+  private:
+    // Only 16-byte aligned so that instances can be allocated with operator new;
+    // 256-bit accesses to these arrays use unaligned loads and stores.
+    APPLESEED_SIMD4_ALIGN uint32    m_state[Lanes];     // current state of the generators
+    APPLESEED_SIMD4_ALIGN uint32    m_buffer[Lanes];    // values handed out by rand_uint32()
+    size_t                          m_buffer_index;
+
+    void step();
+};
+
+// Generate 'count' 32-bit random numbers, whole batches at a time.
+template <size_t Lanes>
+void rand_uint32_batch(
+    SimdXorshift<Lanes>&    rng,
+    uint32                  values[],
+    const size_t            count);
+
+
+//
+// SimdXorshift class implementation.
+//
+
+template <size_t Lanes>
+inline SimdXorshift<Lanes>::SimdXorshift(const uint32 seed)
+  : m_buffer_index(Lanes)
+{
+    Xorshift seeder(seed);
+
+    for (size_t i = 0; i < Lanes; ++i)
+        m_state[i] = seeder.rand_uint32();
+}
+
+template <size_t Lanes>
+inline void SimdXorshift<Lanes>::step()
+{
+#ifdef APPLESEED_USE_AVX2
+
+    if (Lanes == 8)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(m_state));
+        x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+        x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(m_state), x);
+        return;
+    }
+
+#endif
+
+#ifdef APPLESEED_USE_SSE
+
+    for (size_t i = 0; i < Lanes; i += 4)
+    {
+        __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(m_state + i));
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+        x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+        x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+        _mm_store_si128(reinterpret_cast<__m128i*>(m_state + i), x);
+    }
+
+#else
+
+    for (size_t i = 0; i < Lanes; ++i)
+    {
+        uint32 x = m_state[i];
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        m_state[i] = x;
+    }
+
+#endif
+}
+
+template <size_t Lanes>
+inline void SimdXorshift<Lanes>::rand_uint32(uint32 values[Lanes])
+{
+    step();
+
+    for (size_t i = 0; i < Lanes; ++i)
+        values[i] = m_state[i];
+}
+
+template <size_t Lanes>
+inline void SimdXorshift<Lanes>::rand_float2(float values[Lanes])
+{
+    step();
+
+#ifdef APPLESEED_USE_SSE
+
+    const __m128 scale = _mm_set1_ps(1.0f / 16777216.0f);
+
+    for (size_t i = 0; i < Lanes; i += 4)
+    {
+        const __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(m_state + i));
+        const __m128 f = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(x, 8)), scale);
+        _mm_storeu_ps(values + i, f);
+    }
+
+#else
+
+    // Keep 24 bits so that values are exactly representable and less than 1.
+    for (size_t i = 0; i < Lanes; ++i)
+        values[i] = static_cast<float>(m_state[i] >> 8) * (1.0f / 16777216.0f);
+
+#endif
+}
+
+template <size_t Lanes>
+inline uint32 SimdXorshift<Lanes>::rand_uint32()
+{
+    if (m_buffer_index == Lanes)
+    {
+        rand_uint32(m_buffer);
+        m_buffer_index = 0;
+    }
+
+    return m_buffer[m_buffer_index++];
+}
+
+template <size_t Lanes>
+inline void rand_uint32_batch(
+    SimdXorshift<Lanes>&    rng,
+    uint32                  values[],
+    const size_t            count)
+{
+    size_t i = 0;
+
+    for (; i + Lanes <= count; i += Lanes)
+        rng.rand_uint32(values + i);
+
+    for (; i < count; ++i)
+        values[i] = rng.rand_uint32();
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_RNG_SIMDXORSHIFT_H
@@ -0,0 +1,440 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_FOUNDATION_MATH_SAMPLING_HIERARCHICALIMPORTANCESAMPLER_H
+#define APPLESEED_FOUNDATION_MATH_SAMPLING_HIERARCHICALIMPORTANCESAMPLER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/fp.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/job/iabortswitch.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// An image importance sampler based on a pyramid of importance sums: each texel of a level
+// holds the sum of the (up to) four texels below it, and sampling descends from the single
+// texel of the top level to the image, choosing a column then a row among the children of
+// each texel. Compared to foundation::ImageImportanceSampler, it only stores the importance
+// of the pixels (plus a third for the upper levels) and no payload, and returns the position
+// of the sample within the chosen pixel so that images can be sampled continuously.
+//
+// The ImageSampler type must conform to the following prototype:
+//
+//   class ImageSampler
+//   {
+//     public:
+//       void sample(
+//           const size_t   x,
+//           const size_t   y,
+//           Importance&    importance);
+//   };
+//
+
+template <typename Importance>
+class HierarchicalImportanceSampler
+  : public NonCopyable
+{
+  public:
+    typedef Vector<Importance, 2> Vector2Type;
+
+    // Constructor.
+    HierarchicalImportanceSampler(
+        const size_t                width,
+        const size_t                height);
+
+    // Return the dimensions of the image.
+    size_t get_width() const;
+    size_t get_height() const;
+
+    // Resample the image and rebuild the pyramid.
+    template <typename ImageSampler>
+    void rebuild(
+        ImageSampler&               sampler,
+        IAbortSwitch*               abort_switch = 0);
+
+    // Replace the importance of the pixels, given in scanline order, and rebuild the pyramid.
+    // 'importance' must contain width * height values; it is swapped into the sampler.
+    void set_importance(std::vector<Importance>& importance);
+
+    // Return the importance of the pixels in scanline order.
+    const std::vector<Importance>& get_importance() const;
+
+    // Sample the image and return the coordinates of the chosen pixel
+    // and its probability.
+    void sample(
+        const Vector2Type&          s,
+        size_t&                     x,
+        size_t&                     y,
+        Importance&                 probability) const;
+
+    // Sample the image and return the coordinates of the chosen pixel, the position
+    // of the sample within this pixel, in [0,1)^2, and the probability of the pixel.
+    void sample(
+        const Vector2Type&          s,
+        size_t&                     x,
+        size_t&                     y,
+        Vector2Type&                pixel_s,
+        Importance&                 probability) const;
+
+    // Return the probability of a given pixel.
+    Importance get_pdf(
+        const size_t                x,
+        const size_t                y) const;
+
+    // Return the size in bytes of the pyramid.
+    size_t get_memory_size() const;
+
+  private:
+    struct Level
+    {
+        size_t                      m_width;
+        size_t                      m_height;
+        std::vector<Importance>     m_importance;
+    };
+
+    const size_t                    m_width;
+    const size_t                    m_height;
+    const Importance                m_rcp_pixel_count;
+    std::vector<Level>              m_levels;       // m_levels[0] is the image, m_levels.back() is 1x1
+
+    void build_upper_levels();
+
+    // Retrieve the four children of texel (x, y) of a given level, in the order
+    // (2x, 2y), (2x + 1, 2y), (2x, 2y + 1), (2x + 1, 2y + 1); missing children are 0.
+    void get_children(
+        const size_t                level,
+        const size_t                x,
+        const size_t                y,
+        Importance                  children[4]) const;
+
+    static Importance sum_children(const Importance children[4]);
+
+    // Choose one of two weights with s and remap s to [0,1).
+    static bool choose_second(
+        Importance&                 s,
+        const Importance            first,
+        const Importance            second);
+};
+
+
+//
+// HierarchicalImportanceSampler class implementation.
+//
+
+template <typename Importance>
+HierarchicalImportanceSampler<Importance>::HierarchicalImportanceSampler(
+    const size_t                    width,
+    const size_t                    height)
+  : m_width(width)
+  , m_height(height)
+  , m_rcp_pixel_count(Importance(1.0) / (width * height))
+{
+    assert(width > 0);
+    assert(height > 0);
+}
+
+template <typename Importance>
+inline size_t HierarchicalImportanceSampler<Importance>::get_width() const
+{
+    return m_width;
+}
+
+template <typename Importance>
+inline size_t HierarchicalImportanceSampler<Importance>::get_height() const
+{
+    return m_height;
+}
+
+template <typename Importance>
+template <typename ImageSampler>
+void HierarchicalImportanceSampler<Importance>::rebuild(
+    ImageSampler&                   sampler,
+    IAbortSwitch*                   abort_switch)
+{
+    std::vector<Importance> importance(m_width * m_height);
+
+    for (size_t y = 0; y < m_height; ++y)
+    {
+        if (is_aborted(abort_switch))
+        {
+            m_levels.clear();
+            return;
+        }
+
+        for (size_t x = 0; x < m_width; ++x)
+            sampler.sample(x, y, importance[y * m_width + x]);
+    }
+
+    set_importance(importance);
+}
+
+template <typename Importance>
+void HierarchicalImportanceSampler<Importance>::set_importance(std::vector<Importance>& importance)
+{
+    assert(importance.size() == m_width * m_height);
+
+    // Negative importance values cannot be sampled.
+    for (size_t i = 0, e = importance.size(); i < e; ++i)
+        importance[i] = std::max(importance[i], Importance(0.0));
+
+    m_levels.resize(1);
+    m_levels[0].m_width = m_width;
+    m_levels[0].m_height = m_height;
+    m_levels[0].m_importance.swap(importance);
+
+    build_upper_levels();
+}
+
+template <typename Importance>
+inline const std::vector<Importance>& HierarchicalImportanceSampler<Importance>::get_importance() const
+{
+    assert(!m_levels.empty());
+    return m_levels[0].m_importance;
+}
+
+template <typename Importance>
+inline void HierarchicalImportanceSampler<Importance>::sample(
+    const Vector2Type&              s,
+    size_t&                         x,
+    size_t&                         y,
+    Importance&                     probability) const
+{
+    Vector2Type pixel_s;
+    sample(s, x, y, pixel_s, probability);
+}
+
+template <typename Importance>
+inline void HierarchicalImportanceSampler<Importance>::sample(
+    const Vector2Type&              s,
+    size_t&                         x,
+    size_t&                         y,
+    Vector2Type&                    pixel_s,
+    Importance&                     probability) const
+{
+    assert(!m_levels.empty());
+    assert(s[0] >= Importance(0.0) && s[0] < Importance(1.0));
+    assert(s[1] >= Importance(0.0) && s[1] < Importance(1.0));
+
+    if (m_levels.back().m_importance[0] > Importance(0.0))
+    {
+        pixel_s = s;
+        probability = Importance(1.0);
+        x = 0;
+        y = 0;
+
+        for (size_t level = m_levels.size() - 1; level > 0; --level)
+        {
+            Importance children[4];
+            get_children(level, x, y, children);
+
+            // Select a column, then a row within this column.
+            const size_t i =
+                choose_second(pixel_s[0], children[0] + children[2], children[1] + children[3]) ? 1 : 0;
+            const size_t j =
+                choose_second(pixel_s[1], children[i], children[i + 2]) ? 1 : 0;
+
+            probability *= children[j * 2 + i] / sum_children(children);
+
+            x = 2 * x + i;
+            y = 2 * y + j;
+        }
+
+        assert(x < m_width);
+        assert(y < m_height);
+    }
+    else
+    {
+        // Uniform random sampling.
+        const Importance fx = s[0] * m_width;
+        const Importance fy = s[1] * m_height;
+        x = std::min(truncate<size_t>(fx), m_width - 1);
+        y = std::min(truncate<size_t>(fy), m_height - 1);
+
+        const Importance OneMinusEps = shift(Importance(1.0), -1);
+        pixel_s[0] = std::min(fx - x, OneMinusEps);
+        pixel_s[1] = std::min(fy - y, OneMinusEps);
+
+        probability = m_rcp_pixel_count;
+    }
+
+    assert(probability > Importance(0.0));
+}
+
+template <typename Importance>
+inline Importance HierarchicalImportanceSampler<Importance>::get_pdf(
+    const size_t                    x,
+    const size_t                    y) const
+{
+    assert(!m_levels.empty());
+    assert(x < m_width);
+    assert(y < m_height);
+
+    if (m_levels.back().m_importance[0] == Importance(0.0))
+        return m_rcp_pixel_count;
+
+    // Compute the probabilities of choosing each ancestor of the pixel among its siblings.
+    assert(m_levels.size() <= sizeof(size_t) * 8);
+    Importance ratios[sizeof(size_t) * 8];
+    size_t px = x;
+    size_t py = y;
+
+    for (size_t level = 1; level < m_levels.size(); ++level)
+    {
+        const size_t i = px & 1;
+        const size_t j = py & 1;
+        px >>= 1;
+        py >>= 1;
+
+        Importance children[4];
+        get_children(level, px, py, children);
+
+        const Importance value = children[j * 2 + i];
+        if (value == Importance(0.0))
+            return Importance(0.0);
+
+        ratios[level - 1] = value / sum_children(children);
+    }
+
+    // Multiply them in the order of sample() to return the exact same probability.
+    Importance probability = Importance(1.0);
+    for (size_t level = m_levels.size() - 1; level > 0; --level)
+        probability *= ratios[level - 1];
+
+    return probability;
+}
+
+template <typename Importance>
+size_t HierarchicalImportanceSampler<Importance>::get_memory_size() const
+{
+    size_t size = sizeof(*this) + m_levels.capacity() * sizeof(Level);
+
+    for (size_t i = 0, e = m_levels.size(); i < e; ++i)
+        size += m_levels[i].m_importance.capacity() * sizeof(Importance);
+
+    return size;
+}
+
+template <typename Importance>
+void HierarchicalImportanceSampler<Importance>::build_upper_levels()
+{
+    while (m_levels.back().m_width > 1 || m_levels.back().m_height > 1)
+    {
+        const size_t child_level = m_levels.size() - 1;
+
+        Level level;
+        level.m_width = (m_levels[child_level].m_width + 1) / 2;
+        level.m_height = (m_levels[child_level].m_height + 1) / 2;
+        level.m_importance.resize(level.m_width * level.m_height);
+        m_levels.push_back(level);
+
+        // Parents are computed exactly as sampling sums their children so that nonzero
+        // texels always have a nonzero child.
+        Level& parent = m_levels.back();
+        for (size_t y = 0; y < parent.m_height; ++y)
+        {
+            for (size_t x = 0; x < parent.m_width; ++x)
+            {
+                Importance children[4];
+                get_children(child_level + 1, x, y, children);
+                parent.m_importance[y * parent.m_width + x] = sum_children(children);
+            }
+        }
+    }
+}
+
+template <typename Importance>
+inline void HierarchicalImportanceSampler<Importance>::get_children(
+    const size_t                    level,
+    const size_t                    x,
+    const size_t                    y,
+    Importance                      children[4]) const
+{
+    assert(level > 0);
+
+    const Level& child_level = m_levels[level - 1];
+    const size_t cx = 2 * x;
+    const size_t cy = 2 * y;
+    const bool has_right = cx + 1 < child_level.m_width;
+    const bool has_bottom = cy + 1 < child_level.m_height;
+    const Importance* row = &child_level.m_importance[cy * child_level.m_width + cx];
+
+    children[0] = row[0];
+    children[1] = has_right ? row[1] : Importance(0.0);
+
+    if (has_bottom)
+    {
+        row += child_level.m_width;
+        children[2] = row[0];
+        children[3] = has_right ? row[1] : Importance(0.0);
+    }
+    else
+    {
+        children[2] = Importance(0.0);
+        children[3] = Importance(0.0);
+    }
+}
+
+template <typename Importance>
+inline Importance HierarchicalImportanceSampler<Importance>::sum_children(const Importance children[4])
+{
+    return (children[0] + children[2]) + (children[1] + children[3]);
+}
+
+template <typename Importance>
+inline bool HierarchicalImportanceSampler<Importance>::choose_second(
+    Importance&                     s,
+    const Importance                first,
+    const Importance                second)
+{
+    const Importance OneMinusEps = shift(Importance(1.0), -1);
+    const Importance split = s * (first + second);
+
+    if (split < first || second == Importance(0.0))
+    {
+        s = std::min(split / first, OneMinusEps);
+        return false;
+    }
+    else
+    {
+        s = std::min((split - first) / second, OneMinusEps);
+        return true;
+    }
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_SAMPLING_HIERARCHICALIMPORTANCESAMPLER_H
@@ -35,6 +35,7 @@
 #include "foundation/image/color.h"
 #include "foundation/image/colorspace.h"
 #include "foundation/image/image.h"
+#include "foundation/math/aliastable.h"
 #include "foundation/math/cdf.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
@@ -60,8 +61,15 @@ namespace foundation
 //           Importance&    importance);
 //   };
 //
+// The Distribution type is used to sample rows and columns; it must conform to the
+// interface of foundation::CDF. foundation::AliasTable samples in constant time but
+// does not preserve the stratification of the input samples.
+//
 
-template <typename Payload, typename Importance>
+template <
+    typename Payload,
+    typename Importance,
+    template <typename, typename> class Distribution = CDF>
 class ImageImportanceSampler
   : public NonCopyable
 {
@@ -105,8 +113,8 @@ class ImageImportanceSampler
         const size_t        y) const;
 
   private:
-    typedef CDF<size_t, Importance> RowCDF;
-    typedef CDF<Payload, Importance> ColCDF;
+    typedef Distribution<size_t, Importance> RowCDF;
+    typedef Distribution<Payload, Importance> ColCDF;
 
     const size_t            m_width;
     const size_t            m_height;
@@ -139,8 +147,8 @@ class ImageSampler
 // ImageImportanceSampler class implementation.
 //
 
-template <typename Payload, typename Importance>
-ImageImportanceSampler<Payload, Importance>::ImageImportanceSampler(
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
+ImageImportanceSampler<Payload, Importance, Distribution>::ImageImportanceSampler(
     const size_t            width,
     const size_t            height)
   : m_width(width)
@@ -150,15 +158,15 @@ ImageImportanceSampler<Payload, Importance>::ImageImportanceSampler(
     m_cols_cdf = new ColCDF[m_height];
 }
 
-template <typename Payload, typename Importance>
-ImageImportanceSampler<Payload, Importance>::~ImageImportanceSampler()
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
+ImageImportanceSampler<Payload, Importance, Distribution>::~ImageImportanceSampler()
 {
     delete [] m_cols_cdf;
 }
 
-template <typename Payload, typename Importance>
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
 template <typename ImageSampler>
-void ImageImportanceSampler<Payload, Importance>::rebuild(
+void ImageImportanceSampler<Payload, Importance, Distribution>::rebuild(
     ImageSampler&           sampler,
     IAbortSwitch*           abort_switch)
 {
@@ -196,8 +204,8 @@ void ImageImportanceSampler<Payload, Importance>::rebuild(
         m_rows_cdf.prepare();
 }
 
-template <typename Payload, typename Importance>
-inline void ImageImportanceSampler<Payload, Importance>::sample(
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
+inline void ImageImportanceSampler<Payload, Importance, Distribution>::sample(
     const Vector2Type&      s,
     size_t&                 x,
     size_t&                 y,
@@ -229,8 +237,8 @@ inline void ImageImportanceSampler<Payload, Importance>::sample(
     assert(probability > Importance(0.0));
 }
 
-template <typename Payload, typename Importance>
-inline void ImageImportanceSampler<Payload, Importance>::sample(
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
+inline void ImageImportanceSampler<Payload, Importance, Distribution>::sample(
     const Vector2Type&      s,
     size_t&                 x,
     size_t&                 y,
@@ -265,8 +273,8 @@ inline void ImageImportanceSampler<Payload, Importance>::sample(
     assert(probability > Importance(0.0));
 }
 
-template <typename Payload, typename Importance>
-inline Importance ImageImportanceSampler<Payload, Importance>::get_pdf(
+template <typename Payload, typename Importance, template <typename, typename> class Distribution>
+inline Importance ImageImportanceSampler<Payload, Importance, Distribution>::get_pdf(
     const size_t            x,
     const size_t            y) const
 {
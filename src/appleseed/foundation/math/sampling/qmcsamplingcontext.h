@@ -31,11 +31,15 @@
 #define APPLESEED_FOUNDATION_MATH_SAMPLING_QMCSAMPLINGCONTEXT_H
 
 // appleseed.foundation headers.
+#include "foundation/math/bluenoise.h"
+#include "foundation/math/hash.h"
 #include "foundation/math/permutation.h"
 #include "foundation/math/primes.h"
 #include "foundation/math/qmc.h"
 #include "foundation/math/rng/distribution.h"
+#include "foundation/math/sobol.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/test/helpers.h"
 
 // Standard headers.
@@ -47,6 +51,7 @@ DECLARE_TEST_CASE(Foundation_Math_Sampling_QMCSamplingContext, InitialStateIsCor
 DECLARE_TEST_CASE(Foundation_Math_Sampling_QMCSamplingContext, TestAssignmentOperator);
 DECLARE_TEST_CASE(Foundation_Math_Sampling_QMCSamplingContext, TestSplitting);
 DECLARE_TEST_CASE(Foundation_Math_Sampling_QMCSamplingContext, TestDoubleSplitting);
+DECLARE_TEST_CASE(Foundation_Math_Sampling_QMCSamplingContext, TestBlueNoisePixelIsInherited);
 
 namespace foundation
 {
@@ -59,6 +64,12 @@ namespace foundation
 //   - Cranley-Patterson rotation
 //   - Monte Carlo padding
 //
+// or, alternatively, on Owen-scrambled Sobol sequences (see foundation/math/sobol.h).
+//
+// Optionally, all samples can be rotated by the values of a tiled blue noise mask
+// at a given pixel (see foundation/math/bluenoise.h). When neighboring pixels use
+// the same sequences, this distributes their error as blue noise.
+//
 // Reference:
 //
 //   Kollig and Keller, Efficient Multidimensional Sampling
@@ -72,10 +83,12 @@ class QMCSamplingContext
     // Random number generator type.
     typedef RNG RNGType;
 
-    // This sampler can operate in two modes:
+    // This sampler can operate in three modes:
     //   1. In QMC mode, it uses possibly patent-encumbered techniques.
     //   2. In RNG mode, it works like RNGSamplingContext and sticks to random sampling.
-    enum Mode { QMCMode, RNGMode };
+    //   3. In Sobol mode, each split draws from its own shuffled and Owen-scrambled
+    //      Sobol sequence, seeded from the base dimension and base instance.
+    enum Mode { QMCMode, RNGMode, SobolMode };
 
     // Construct a sampling context of dimension 0. It cannot be used
     // directly; only child contexts obtained by splitting can.
@@ -110,6 +123,12 @@ class QMCSamplingContext
     // Set the instance number.
     void set_instance(const size_t instance);
 
+    // Rotate the samples of this context and of its children by the values of
+    // the blue noise mask at a given pixel.
+    void set_blue_noise_pixel(
+        const size_t    x,
+        const size_t    y);
+
     // Return the next sample in [0,1)^N.
     // Works for scalars and foundation::Vector<>.
     template <typename T> T next2();
@@ -125,6 +144,7 @@ class QMCSamplingContext
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Math_Sampling_QMCSamplingContext, TestAssignmentOperator);
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Math_Sampling_QMCSamplingContext, TestSplitting);
     GRANT_ACCESS_TO_TEST_CASE(Foundation_Math_Sampling_QMCSamplingContext, TestDoubleSplitting);
+    GRANT_ACCESS_TO_TEST_CASE(Foundation_Math_Sampling_QMCSamplingContext, TestBlueNoisePixelIsInherited);
 
     typedef Vector<double, 4> VectorType;
 
@@ -139,6 +159,11 @@ class QMCSamplingContext
 
     size_t      m_instance;
     VectorType  m_offset;
+    uint32      m_seed;
+
+    bool        m_use_blue_noise;
+    size_t      m_blue_noise_x;
+    size_t      m_blue_noise_y;
 
     // Cranley-Patterson rotation.
     template <typename T>
@@ -153,6 +178,7 @@ class QMCSamplingContext
         const size_t    sample_count);
 
     void compute_offset();
+    void compute_seed();
 
     template <typename T> struct Tag {};
 
@@ -177,6 +203,10 @@ inline QMCSamplingContext<RNG>::QMCSamplingContext(
   , m_sample_count(0)
   , m_instance(0)
   , m_offset(0.0)
+  , m_seed(0)
+  , m_use_blue_noise(false)
+  , m_blue_noise_x(0)
+  , m_blue_noise_y(0)
 {
 }
 
@@ -195,8 +225,14 @@ inline QMCSamplingContext<RNG>::QMCSamplingContext(
   , m_sample_count(sample_count)
   , m_instance(instance)
   , m_offset(0.0)
+  , m_use_blue_noise(false)
+  , m_blue_noise_x(0)
+  , m_blue_noise_y(0)
 {
     assert(dimension <= VectorType::Dimension);
+
+    if (m_mode == SobolMode)
+        compute_seed();
 }
 
 template <typename RNG>
@@ -214,11 +250,17 @@ inline QMCSamplingContext<RNG>::QMCSamplingContext(
   , m_dimension(dimension)
   , m_sample_count(sample_count)
   , m_instance(0)
+  , m_seed(0)
+  , m_use_blue_noise(false)
+  , m_blue_noise_x(0)
+  , m_blue_noise_y(0)
 {
     assert(dimension <= VectorType::Dimension);
 
     if (m_mode == QMCMode)
         compute_offset();
+    else if (m_mode == SobolMode)
+        compute_seed();
 }
 
 template <typename RNG> inline
@@ -232,6 +274,10 @@ QMCSamplingContext<RNG>::operator=(const QMCSamplingContext& rhs)
     m_sample_count = rhs.m_sample_count;
     m_instance = rhs.m_instance;
     m_offset = rhs.m_offset;
+    m_seed = rhs.m_seed;
+    m_use_blue_noise = rhs.m_use_blue_noise;
+    m_blue_noise_x = rhs.m_blue_noise_x;
+    m_blue_noise_y = rhs.m_blue_noise_y;
 
     return *this;
 }
@@ -241,14 +287,19 @@ inline QMCSamplingContext<RNG> QMCSamplingContext<RNG>::split(
     const size_t        dimension,
     const size_t        sample_count) const
 {
-    return
-        QMCSamplingContext(
-            m_rng,
-            m_mode,
-            m_base_dimension + m_dimension,         // dimension allocation
-            m_base_instance + m_instance,           // decorrelation by generalization
-            dimension,
-            sample_count);
+    QMCSamplingContext child(
+        m_rng,
+        m_mode,
+        m_base_dimension + m_dimension,             // dimension allocation
+        m_base_instance + m_instance,               // decorrelation by generalization
+        dimension,
+        sample_count);
+
+    child.m_use_blue_noise = m_use_blue_noise;
+    child.m_blue_noise_x = m_blue_noise_x;
+    child.m_blue_noise_y = m_blue_noise_y;
+
+    return child;
 }
 
 template <typename RNG>
@@ -267,6 +318,8 @@ inline void QMCSamplingContext<RNG>::split_in_place(
 
     if (m_mode == QMCMode)
         compute_offset();
+    else if (m_mode == SobolMode)
+        compute_seed();
 }
 
 template <typename RNG>
@@ -275,6 +328,16 @@ inline void QMCSamplingContext<RNG>::set_instance(const size_t instance)
     m_instance = instance;
 }
 
+template <typename RNG>
+inline void QMCSamplingContext<RNG>::set_blue_noise_pixel(
+    const size_t        x,
+    const size_t        y)
+{
+    m_use_blue_noise = true;
+    m_blue_noise_x = x;
+    m_blue_noise_y = y;
+}
+
 template <typename RNG>
 template <typename T>
 inline T QMCSamplingContext<RNG>::next2()
@@ -331,6 +394,15 @@ inline void QMCSamplingContext<RNG>::compute_offset()
     }
 }
 
+template <typename RNG>
+inline void QMCSamplingContext<RNG>::compute_seed()
+{
+    m_seed =
+        mix_uint32(
+            static_cast<uint32>(m_base_dimension),
+            static_cast<uint32>(m_base_instance));
+}
+
 template <typename RNG>
 template <typename T>
 inline T QMCSamplingContext<RNG>::next2(Tag<T>)
@@ -370,12 +442,29 @@ inline Vector<T, N> QMCSamplingContext<RNG>::next2(Tag<Vector<T, N> >)
             }
         }
     }
+    else if (m_mode == SobolMode)
+    {
+        v = shuffled_scrambled_sobol_sequence<T, N>(
+                m_seed,
+                static_cast<uint32>(m_instance));
+    }
     else
     {
         for (size_t i = 0; i < N; ++i)
             v[i] = rand2<T>(m_rng);
     }
 
+    if (m_use_blue_noise)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            v[i] =
+                rotate(
+                    v[i],
+                    blue_noise<T>(m_blue_noise_x, m_blue_noise_y, m_base_dimension + i));
+        }
+    }
+
     ++m_instance;
 
     return v;
@@ -33,6 +33,7 @@
 // appleseed.foundation headers.
 #include "foundation/math/rng/distribution.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
 
 // Standard headers.
 #include <cstddef>
@@ -43,6 +44,10 @@ namespace foundation
 //
 // A sampling context implementing random sampling.
 //
+// Random numbers are drawn from the generator in small batches (see rand_uint32_batch()
+// in foundation/math/rng/distribution.h) so that generators producing several values
+// at once, such as SimdXorshift and SimdPCG, can be used at full speed.
+//
 
 template <typename RNG>
 class RNGSamplingContext
@@ -64,6 +69,9 @@ class RNGSamplingContext
         const size_t    sample_count,
         const size_t    initial_instance = 0);
 
+    // Copy constructor. Buffered random numbers are not shared with the copy.
+    RNGSamplingContext(const RNGSamplingContext& rhs);
+
     // Assignment operator.
     RNGSamplingContext& operator=(const RNGSamplingContext& rhs);
 
@@ -89,7 +97,13 @@ class RNGSamplingContext
     size_t get_total_instance() const;
 
   private:
-    RNG& m_rng;
+    enum { BufferSize = 8 };
+
+    RNG&        m_rng;
+    uint32      m_buffer[BufferSize];
+    size_t      m_buffer_index;
+
+    double next_double();
 
     template <typename T> struct Tag {};
 
@@ -105,6 +119,7 @@ class RNGSamplingContext
 template <typename RNG>
 inline RNGSamplingContext<RNG>::RNGSamplingContext(RNG& rng)
   : m_rng(rng)
+  , m_buffer_index(BufferSize)
 {
 }
 
@@ -115,6 +130,14 @@ inline RNGSamplingContext<RNG>::RNGSamplingContext(
     const size_t    sample_count,
     const size_t    initial_instance)
   : m_rng(rng)
+  , m_buffer_index(BufferSize)
+{
+}
+
+template <typename RNG>
+inline RNGSamplingContext<RNG>::RNGSamplingContext(const RNGSamplingContext& rhs)
+  : m_rng(rhs.m_rng)
+  , m_buffer_index(BufferSize)
 {
 }
 
@@ -163,11 +186,23 @@ inline size_t RNGSamplingContext<RNG>::get_total_instance() const
     return 0;
 }
 
+template <typename RNG>
+inline double RNGSamplingContext<RNG>::next_double()
+{
+    if (m_buffer_index == BufferSize)
+    {
+        rand_uint32_batch(m_rng, m_buffer, BufferSize);
+        m_buffer_index = 0;
+    }
+
+    return m_buffer[m_buffer_index++] * (1.0 / 4294967296.0);
+}
+
 template <typename RNG>
 template <typename T>
 inline T RNGSamplingContext<RNG>::next2(Tag<T>)
 {
-    return rand_double2(m_rng);
+    return static_cast<T>(next_double());
 }
 
 template <typename RNG>
@@ -177,7 +212,7 @@ inline Vector<T, N> RNGSamplingContext<RNG>::next2(Tag<Vector<T, N> >)
     Vector<T, N> v;
 
     for (size_t i = 0; i < N; ++i)
-        v[i] = rand_double2(m_rng);
+        v[i] = static_cast<T>(next_double());
 
     return v;
 }
@@ -0,0 +1,191 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_FOUNDATION_MATH_SOBOL_H
+#define APPLESEED_FOUNDATION_MATH_SOBOL_H
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// Owen-scrambled Sobol sequence.
+//
+// Only the first four dimensions of the Sobol sequence are provided. Rather than
+// relying on higher (and lower quality) dimensions, independent 4D patterns are
+// obtained by shuffling the sample indices and scrambling the sample values with
+// different seeds. Both operations are nested uniform (Owen) scramblings in base 2,
+// computed with a hash-based permutation instead of permutation tables.
+//
+// Reference:
+//
+//   Brent Burley, Practical Hash-based Owen Scrambling
+//   http://www.jcgt.org/published/0009/04/01/
+//
+
+// Number of dimensions of the Sobol sequence.
+const size_t SobolDimensionCount = 4;
+
+// Generator matrices of the first dimensions of the Sobol sequence, one column per input bit.
+extern const uint32 SobolMatrices[SobolDimensionCount][32];
+
+// Reverse the order of the bits of a 32-bit integer.
+uint32 reverse_bits(uint32 value);
+
+// Return a given dimension of a given point of the Sobol sequence, as 32 bits of fixed point fraction.
+uint32 sobol_uint32(
+    const size_t        dimension,
+    uint32              index);
+
+// Nested uniform scrambling in base 2 of a 32-bit fixed point fraction.
+uint32 nested_uniform_scramble_base2(
+    uint32              value,
+    const uint32        seed);
+
+// Convert a 32-bit fixed point fraction to a value in [0, 1).
+template <typename T>
+T fixed_point_to_unit(const uint32 value);
+
+// Return a given point of an Owen-scrambled and shuffled 2D to 4D Sobol sequence.
+// Each seed yields an independent sequence. All components are in [0, 1).
+template <typename T, size_t N>
+Vector<T, N> shuffled_scrambled_sobol_sequence(
+    const uint32        seed,
+    const uint32        index);
+
+
+//
+// Owen-scrambled Sobol sequence implementation.
+//
+
+namespace sobol_impl
+{
+    inline uint32 laine_karras_permutation(uint32 x, const uint32 seed)
+    {
+        x += seed;
+        x ^= x * 0x6C50B47CUL;
+        x ^= x * 0xB82F1E52UL;
+        x ^= x * 0xC7AFE638UL;
+        x ^= x * 0x8D22F6E6UL;
+        return x;
+    }
+
+    inline uint32 hash_combine(const uint32 seed, const uint32 value)
+    {
+        return seed ^ (value + (seed << 6) + (seed >> 2));
+    }
+}
+
+inline uint32 reverse_bits(uint32 value)
+{
+    value = (value >> 16) | (value << 16);                                                      // 16-bit swap
+    value = ((value & 0xFF00FF00UL) >> 8) | ((value & 0x00FF00FFUL) << 8);                      // 8-bit swap
+    value = ((value & 0xF0F0F0F0UL) >> 4) | ((value & 0x0F0F0F0FUL) << 4);                      // 4-bit swap
+    value = ((value & 0xCCCCCCCCUL) >> 2) | ((value & 0x33333333UL) << 2);                      // 2-bit swap
+    value = ((value & 0xAAAAAAAAUL) >> 1) | ((value & 0x55555555UL) << 1);                      // 1-bit swap
+    return value;
+}
+
+inline uint32 sobol_uint32(
+    const size_t        dimension,
+    uint32              index)
+{
+    assert(dimension < SobolDimensionCount);
+
+    const uint32* matrix = SobolMatrices[dimension];
+    uint32 x = 0;
+
+    for (size_t bit = 0; index != 0; index >>= 1, ++bit)
+    {
+        if (index & 1)
+            x ^= matrix[bit];
+    }
+
+    return x;
+}
+
+inline uint32 nested_uniform_scramble_base2(
+    uint32              value,
+    const uint32        seed)
+{
+    // The Laine-Karras permutation only lets lower bits affect higher bits;
+    // reversing the bits turns it into an Owen scrambling of the fraction.
+    value = reverse_bits(value);
+    value = sobol_impl::laine_karras_permutation(value, seed);
+    value = reverse_bits(value);
+    return value;
+}
+
+template <>
+inline float fixed_point_to_unit<float>(const uint32 value)
+{
+    // Keep 24 bits so that the result is exactly representable and less than 1.
+    return static_cast<float>(value >> 8) * (1.0f / 16777216.0f);
+}
+
+template <>
+inline double fixed_point_to_unit<double>(const uint32 value)
+{
+    return static_cast<double>(value) * (1.0 / 4294967296.0);
+}
+
+template <typename T, size_t N>
+inline Vector<T, N> shuffled_scrambled_sobol_sequence(
+    const uint32        seed,
+    const uint32        index)
+{
+    assert(N <= SobolDimensionCount);
+
+    const uint32 shuffled_index = nested_uniform_scramble_base2(index, seed);
+
+    Vector<T, N> v;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        const uint32 x =
+            nested_uniform_scramble_base2(
+                sobol_uint32(i, shuffled_index),
+                sobol_impl::hash_combine(seed, static_cast<uint32>(i)));
+
+        v[i] = fixed_point_to_unit<T>(x);
+    }
+
+    return v;
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_MATH_SOBOL_H
@@ -35,14 +35,21 @@
 #include "foundation/core/exceptions/exceptionioerror.h"
 #include "foundation/math/vector.h"
 #include "foundation/mesh/imeshbuilder.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/bufferedfile.h"
 #include "foundation/utility/memory.h"
 
+// Boost headers.
+#include "boost/interprocess/exceptions.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
 // Standard headers.
 #include <cstring>
 #include <memory>
 
+using namespace boost;
 using namespace std;
 
 namespace foundation
@@ -76,6 +83,59 @@ namespace
     {
         checked_read(file, &object, sizeof(T));
     }
+
+    // Bounds-checked sequential access to a memory-mapped file.
+    class MappedFileCursor
+    {
+      public:
+        MappedFileCursor(const uint8* base, const size_t size, const size_t offset)
+          : m_base(base)
+          , m_size(size)
+          , m_offset(offset)
+        {
+        }
+
+        bool at_end() const
+        {
+            return m_offset >= m_size;
+        }
+
+        const void* read(const size_t size)
+        {
+            if (size > m_size - m_offset)
+                throw ExceptionIOError("truncated binarymesh file");
+
+            const void* p = m_base + m_offset;
+            m_offset += size;
+            return p;
+        }
+
+        template <typename T>
+        T read()
+        {
+            T value;
+            memcpy(&value, read(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        string read_string()
+        {
+            const uint16 length = read<uint16>();
+            return string(static_cast<const char*>(read(length)), length);
+        }
+
+        // Sections are aligned on 16-byte boundaries.
+        void align()
+        {
+            const size_t aligned = (m_offset + 15) & ~size_t(15);
+            m_offset = min(aligned, m_size);
+        }
+
+      private:
+        const uint8*    m_base;
+        const size_t    m_size;
+        size_t          m_offset;
+    };
 }
 
 BinaryMeshFileReader::BinaryMeshFileReader(const string& filename)
@@ -115,9 +175,15 @@ void BinaryMeshFileReader::read(IMeshBuilder& builder)
 
       // LZ4-compressed.
       case 3:
-        reader.reset(new LZ4CompressedReaderAdapter(file));
+        reader.reset(new LZ4CompressedReaderAdapter(file, System::get_logical_cpu_core_count()));
         break;
 
+      // Uncompressed triangle arrays, memory-mapped.
+      case 4:
+        file.close();
+        read_mapped_meshes(builder);
+        return;
+
       // Unknown format.
       default:
         throw ExceptionIOError("unknown binarymesh format version");
@@ -137,6 +203,106 @@ void BinaryMeshFileReader::read_and_check_signature(BufferedFile& file)
         throw ExceptionIOError("invalid binarymesh format signature");
 }
 
+void BinaryMeshFileReader::read_mapped_meshes(IMeshBuilder& builder)
+{
+    auto_ptr<interprocess::file_mapping> file_mapping;
+    auto_ptr<interprocess::mapped_region> mapped_region;
+
+    try
+    {
+        file_mapping.reset(new interprocess::file_mapping(m_filename.c_str(), interprocess::read_only));
+        mapped_region.reset(new interprocess::mapped_region(*file_mapping, interprocess::read_only));
+    }
+    catch (const interprocess::interprocess_exception&)
+    {
+        throw ExceptionIOError();
+    }
+
+    // Skip the signature and the version, then the padding of the header.
+    MappedFileCursor cursor(
+        static_cast<const uint8*>(mapped_region->get_address()),
+        mapped_region->get_size(),
+        12);
+    cursor.align();
+
+    while (!cursor.at_end())
+    {
+        TriangleMeshArrays arrays;
+        arrays.m_vertex_count = static_cast<size_t>(cursor.read<uint64>());
+        arrays.m_vertex_normal_count = static_cast<size_t>(cursor.read<uint64>());
+        arrays.m_tex_coords_count = static_cast<size_t>(cursor.read<uint64>());
+        arrays.m_triangle_count = static_cast<size_t>(cursor.read<uint64>());
+
+        const string mesh_name = cursor.read_string();
+
+        builder.begin_mesh(mesh_name.c_str());
+
+        const uint16 material_slot_count = cursor.read<uint16>();
+        for (uint16 i = 0; i < material_slot_count; ++i)
+            builder.push_material_slot(cursor.read_string().c_str());
+
+        // The arrays are used in place, without any copy.
+        cursor.align();
+        arrays.m_vertices = static_cast<const float*>(cursor.read(arrays.m_vertex_count * 3 * sizeof(float)));
+        cursor.align();
+        arrays.m_vertex_normals = static_cast<const float*>(cursor.read(arrays.m_vertex_normal_count * 3 * sizeof(float)));
+        cursor.align();
+        arrays.m_tex_coords = static_cast<const float*>(cursor.read(arrays.m_tex_coords_count * 2 * sizeof(float)));
+        cursor.align();
+        arrays.m_triangles = static_cast<const uint32*>(cursor.read(arrays.m_triangle_count * 10 * sizeof(uint32)));
+        cursor.align();
+
+        if (!builder.push_triangle_arrays(arrays))
+            push_triangle_arrays(arrays, builder);
+
+        builder.end_mesh();
+    }
+}
+
+void BinaryMeshFileReader::push_triangle_arrays(const TriangleMeshArrays& arrays, IMeshBuilder& builder)
+{
+    for (size_t i = 0; i < arrays.m_vertex_count; ++i)
+    {
+        const float* v = arrays.m_vertices + i * 3;
+        builder.push_vertex(Vector3d(v[0], v[1], v[2]));
+    }
+
+    for (size_t i = 0; i < arrays.m_vertex_normal_count; ++i)
+    {
+        const float* n = arrays.m_vertex_normals + i * 3;
+        builder.push_vertex_normal(Vector3d(n[0], n[1], n[2]));
+    }
+
+    for (size_t i = 0; i < arrays.m_tex_coords_count; ++i)
+    {
+        const float* uv = arrays.m_tex_coords + i * 2;
+        builder.push_tex_coords(Vector2d(uv[0], uv[1]));
+    }
+
+    ensure_minimum_size(m_vertices, 3);
+    ensure_minimum_size(m_vertex_normals, 3);
+    ensure_minimum_size(m_tex_coords, 3);
+
+    for (size_t i = 0; i < arrays.m_triangle_count; ++i)
+    {
+        const uint32* triangle = arrays.m_triangles + i * 10;
+
+        for (size_t j = 0; j < 3; ++j)
+        {
+            m_vertices[j] = triangle[j];
+            m_vertex_normals[j] = triangle[3 + j];
+            m_tex_coords[j] = triangle[6 + j];
+        }
+
+        builder.begin_face(3);
+        builder.set_face_vertices(&m_vertices[0]);
+        builder.set_face_vertex_normals(&m_vertex_normals[0]);
+        builder.set_face_vertex_tex_coords(&m_tex_coords[0]);
+        builder.set_face_material(triangle[9]);
+        builder.end_face();
+    }
+}
+
 string BinaryMeshFileReader::read_string(ReaderAdapter& reader)
 {
     uint16 length;
@@ -43,6 +43,7 @@
 namespace foundation    { class BufferedFile; }
 namespace foundation    { class IMeshBuilder; }
 namespace foundation    { class ReaderAdapter; }
+namespace foundation    { struct TriangleMeshArrays; }
 
 namespace foundation
 {
@@ -69,6 +70,10 @@ class BinaryMeshFileReader
 
     static void read_and_check_signature(BufferedFile& file);
 
+    // Read version 4 files, which are memory-mapped rather than streamed.
+    void read_mapped_meshes(IMeshBuilder& builder);
+    void push_triangle_arrays(const TriangleMeshArrays& arrays, IMeshBuilder& builder);
+
     static std::string read_string(ReaderAdapter& reader);
     void read_meshes(ReaderAdapter& reader, IMeshBuilder& builder);
     void read_vertices(ReaderAdapter& reader, IMeshBuilder& builder);
@@ -32,12 +32,15 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/exceptions/exceptionioerror.h"
+#include "foundation/math/triangulator.h"
 #include "foundation/math/vector.h"
 #include "foundation/mesh/imeshwalker.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/types.h"
 
 // Standard headers.
 #include <cstring>
+#include <vector>
 
 using namespace std;
 
@@ -66,9 +69,12 @@ namespace
     }
 }
 
-BinaryMeshFileWriter::BinaryMeshFileWriter(const string& filename)
+BinaryMeshFileWriter::BinaryMeshFileWriter(
+    const string&           filename,
+    const Format            format)
   : m_filename(filename)
-  , m_writer(m_file, 256 * 1024)
+  , m_format(format)
+  , m_writer(m_file, 256 * 1024, System::get_logical_cpu_core_count())
 {
 }
 
@@ -86,9 +92,14 @@ void BinaryMeshFileWriter::write(const IMeshWalker& walker)
 
         write_signature();
         write_version();
+
+        if (m_format == MappableFormat)
+            write_padding();
     }
 
-    write_mesh(walker);
+    if (m_format == MappableFormat)
+        write_mappable_mesh(walker);
+    else write_mesh(walker);
 }
 
 void BinaryMeshFileWriter::write_signature()
@@ -100,7 +111,7 @@ void BinaryMeshFileWriter::write_signature()
 
 void BinaryMeshFileWriter::write_version()
 {
-    const uint16 Version = 3;
+    const uint16 Version = m_format == MappableFormat ? 4 : 3;
 
     checked_write(m_file, Version);
 }
@@ -183,4 +194,131 @@ void BinaryMeshFileWriter::write_face(const IMeshWalker& walker, const size_t fa
     checked_write(m_writer, static_cast<uint16>(walker.get_face_material(face_index)));
 }
 
+void BinaryMeshFileWriter::write_padding()
+{
+    static const uint8 Zeros[16] = { 0 };
+
+    const size_t position = static_cast<size_t>(m_file.tell());
+    const size_t padding = ((position + 15) & ~size_t(15)) - position;
+
+    checked_write(m_file, Zeros, padding);
+}
+
+void BinaryMeshFileWriter::write_mappable_mesh(const IMeshWalker& walker)
+{
+    // Triangulate the faces.
+    Triangulator<double> triangulator(Triangulator<double>::KeepDegenerateTriangles);
+    Triangulator<double>::Polygon3 polygon;
+    Triangulator<double>::IndexArray triangle_indices;
+    vector<uint32> triangles;
+
+    const size_t face_count = walker.get_face_count();
+    triangles.reserve(face_count * 10);
+
+    for (size_t i = 0; i < face_count; ++i)
+    {
+        const size_t vertex_count = walker.get_face_vertex_count(i);
+
+        if (vertex_count == 3)
+        {
+            push_triangle(walker, i, 0, 1, 2, triangles);
+            continue;
+        }
+
+        polygon.clear();
+        for (size_t j = 0; j < vertex_count; ++j)
+            polygon.push_back(walker.get_vertex(walker.get_face_vertex(i, j)));
+
+        triangle_indices.clear();
+
+        if (triangulator.triangulate(polygon, triangle_indices))
+        {
+            for (size_t j = 0; j < triangle_indices.size(); j += 3)
+                push_triangle(walker, i, triangle_indices[j], triangle_indices[j + 1], triangle_indices[j + 2], triangles);
+        }
+        else
+        {
+            // Insert zero-area triangles to preserve the number of triangles.
+            for (size_t j = 0; j < vertex_count - 2; ++j)
+                push_triangle(walker, i, 0, 0, 0, triangles);
+        }
+    }
+
+    // Write the mesh header.
+    const uint64 vertex_count = walker.get_vertex_count();
+    const uint64 vertex_normal_count = walker.get_vertex_normal_count();
+    const uint64 tex_coords_count = walker.get_tex_coords_count();
+    const uint64 triangle_count = triangles.size() / 10;
+    checked_write(m_file, vertex_count);
+    checked_write(m_file, vertex_normal_count);
+    checked_write(m_file, tex_coords_count);
+    checked_write(m_file, triangle_count);
+
+    const char* name = walker.get_name();
+    const uint16 name_length = static_cast<uint16>(strlen(name));
+    checked_write(m_file, name_length);
+    checked_write(m_file, name, name_length);
+
+    const uint16 material_slot_count = static_cast<uint16>(walker.get_material_slot_count());
+    checked_write(m_file, material_slot_count);
+
+    for (uint16 i = 0; i < material_slot_count; ++i)
+    {
+        const char* slot = walker.get_material_slot(i);
+        const uint16 slot_length = static_cast<uint16>(strlen(slot));
+        checked_write(m_file, slot_length);
+        checked_write(m_file, slot, slot_length);
+    }
+
+    // Write the arrays.
+    write_padding();
+
+    for (size_t i = 0; i < vertex_count; ++i)
+        checked_write(m_file, Vector3f(walker.get_vertex(i)));
+
+    write_padding();
+
+    for (size_t i = 0; i < vertex_normal_count; ++i)
+    {
+        // Normals are stored unit-length; null normals are replaced by an arbitrary unit vector.
+        const Vector3d n = walker.get_vertex_normal(i);
+        const double norm_n = norm(n);
+        checked_write(m_file, norm_n > 0.0 ? Vector3f(n / norm_n) : Vector3f(1.0f, 0.0f, 0.0f));
+    }
+
+    write_padding();
+
+    for (size_t i = 0; i < tex_coords_count; ++i)
+        checked_write(m_file, Vector2f(walker.get_tex_coords(i)));
+
+    write_padding();
+
+    if (!triangles.empty())
+        checked_write(m_file, &triangles[0], triangles.size() * sizeof(uint32));
+
+    write_padding();
+}
+
+void BinaryMeshFileWriter::push_triangle(
+    const IMeshWalker&      walker,
+    const size_t            face_index,
+    const size_t            v0,
+    const size_t            v1,
+    const size_t            v2,
+    vector<uint32>&         triangles)
+{
+    const size_t vertices[3] = { v0, v1, v2 };
+
+    for (size_t i = 0; i < 3; ++i)
+        triangles.push_back(static_cast<uint32>(walker.get_face_vertex(face_index, vertices[i])));
+
+    for (size_t i = 0; i < 3; ++i)
+        triangles.push_back(static_cast<uint32>(walker.get_face_vertex_normal(face_index, vertices[i])));
+
+    for (size_t i = 0; i < 3; ++i)
+        triangles.push_back(static_cast<uint32>(walker.get_face_tex_coords(face_index, vertices[i])));
+
+    triangles.push_back(static_cast<uint32>(walker.get_face_material(face_index)));
+}
+
 }   // namespace foundation
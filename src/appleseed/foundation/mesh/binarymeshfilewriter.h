@@ -38,6 +38,7 @@
 // Standard headers.
 #include <cstddef>
 #include <string>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class IMeshWalker; }
@@ -53,14 +54,24 @@ class BinaryMeshFileWriter
   : public IMeshFileWriter
 {
   public:
+    // Formats of the written files.
+    enum Format
+    {
+        CompressedFormat,       // version 3: LZ4-compressed, compact
+        MappableFormat          // version 4: triangulated and uncompressed, fast to load
+    };
+
     // Constructor.
-    explicit BinaryMeshFileWriter(const std::string& filename);
+    explicit BinaryMeshFileWriter(
+        const std::string&      filename,
+        const Format            format = CompressedFormat);
 
     // Write a mesh.
     virtual void write(const IMeshWalker& walker) APPLESEED_OVERRIDE;
 
   private:
     const std::string           m_filename;
+    const Format                m_format;
     BufferedFile                m_file;
     LZ4CompressedWriterAdapter  m_writer;
 
@@ -75,6 +86,16 @@ class BinaryMeshFileWriter
     void write_material_slots(const IMeshWalker& walker);
     void write_faces(const IMeshWalker& walker);
     void write_face(const IMeshWalker& walker, const size_t face_index);
+
+    void write_padding();
+    void write_mappable_mesh(const IMeshWalker& walker);
+    static void push_triangle(
+        const IMeshWalker&      walker,
+        const size_t            face_index,
+        const size_t            v0,
+        const size_t            v1,
+        const size_t            v2,
+        std::vector<uint32>&    triangles);
 };
 
 }       // namespace foundation
@@ -51,8 +51,11 @@ class APPLESEED_DLLSYMBOL GenericMeshFileWriter
   : public IMeshFileWriter
 {
   public:
-    // Constructor.
-    explicit GenericMeshFileWriter(const char* filename);
+    // Constructor. BinaryMesh files are written in the memory-mappable format
+    // (version 4) if mappable_binarymesh is true, in the compressed one otherwise.
+    explicit GenericMeshFileWriter(
+        const char*     filename,
+        const bool      mappable_binarymesh = false);
 
     // Destructor.
     virtual ~GenericMeshFileWriter();
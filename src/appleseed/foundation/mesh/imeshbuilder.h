@@ -33,6 +33,7 @@
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
 
 // appleseed.main headers.
 #include "main/dllsymbol.h"
@@ -43,6 +44,23 @@
 namespace foundation
 {
 
+//
+// Arrays of triangulated geometry, laid out as in version 4 BinaryMesh files.
+//
+
+struct TriangleMeshArrays
+{
+    size_t          m_vertex_count;
+    const float*    m_vertices;                 // 3 floats per vertex
+    size_t          m_vertex_normal_count;
+    const float*    m_vertex_normals;           // 3 floats per vertex normal, unit-length
+    size_t          m_tex_coords_count;
+    const float*    m_tex_coords;               // 2 floats per texture coordinate
+    size_t          m_triangle_count;
+    const uint32*   m_triangles;                // 10 indices per triangle, see binarymeshspecs.txt
+};
+
+
 //
 // Mesh builder interface.
 //
@@ -72,6 +90,13 @@ class APPLESEED_DLLSYMBOL IMeshBuilder
     // Append a material slot to the mesh.
     virtual size_t push_material_slot(const char* name) = 0;
 
+    // Append triangulated geometry to the mesh in one go. The arrays are only valid
+    // during the call. Return false to receive the geometry element by element instead.
+    virtual bool push_triangle_arrays(const TriangleMeshArrays& arrays)
+    {
+        return false;
+    }
+
     // Begin the definition of a face.
     virtual void begin_face(const size_t vertex_count) = 0;
 
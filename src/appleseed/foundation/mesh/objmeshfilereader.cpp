@@ -35,14 +35,27 @@
 #include "foundation/math/vector.h"
 #include "foundation/mesh/imeshbuilder.h"
 #include "foundation/mesh/objmeshfilelexer.h"
+#include "foundation/platform/system.h"
+#include "foundation/platform/thread.h"
+#include "foundation/utility/foreach.h"
 #include "foundation/utility/memory.h"
 
+// Boost headers.
+#include "boost/interprocess/exceptions.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
 // Standard headers.
+#include <algorithm>
+#include <climits>
 #include <cstring>
 #include <map>
+#include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
+using namespace boost;
 using namespace std;
 
 namespace foundation
@@ -55,102 +68,67 @@ namespace foundation
 namespace
 {
     const size_t Undefined = ~0;
-}
 
-struct OBJMeshFileReader::Impl
-{
-    const int               m_options;
-    IMeshBuilder&           m_builder;
-    OBJMeshFileLexer        m_lexer;
-
-    // Current state.
-    bool                    m_inside_mesh_def;              // currently inside a mesh definition?
-    string                  m_current_mesh_name;            // name of the current mesh
-    map<string, size_t>     m_material_slots;               // material slots for the current mesh
-    size_t                  m_current_material_slot_index;  // index of the current material slot
-
-    // Features defined in the file.
-    vector<Vector3d>        m_vertices;
-    vector<Vector2d>        m_tex_coords;
-    vector<Vector3d>        m_normals;
-
-    // Mappings between internal indices and mesh indices.
-    vector<size_t>          m_vertex_index_mapping;
-    vector<size_t>          m_tex_coord_index_mapping;
-    vector<size_t>          m_normal_index_mapping;
-
-    // Temporary vectors for collecting indices while parsing face statements.
-    vector<size_t>          m_face_vertex_indices;
-    vector<size_t>          m_face_tex_coord_indices;
-    vector<size_t>          m_face_normal_indices;
-
-    // Constructor.
-    Impl(
-        const int           options,
-        IMeshBuilder&       builder)
-      : m_options(options)
-      , m_builder(builder)
-      , m_lexer(
-            (options & FavorSpeedOverPrecision)
-                ? OBJMeshFileLexer::Fast
-                : OBJMeshFileLexer::Precise)
-      , m_inside_mesh_def(false)
-      , m_current_material_slot_index(0)
-    {
-    }
-
-    // Close the input file and throw an ExceptionParseError exception.
-    void parse_error()
-    {
-        const size_t line_number = m_lexer.get_line_number();
-
-        m_lexer.close();
-
-        throw ExceptionParseError(line_number);
-    }
-
-    void parse_file()
+    // Marker for absent texture coordinate or normal indices in face statements.
+    const long NoIndex = LONG_MIN;
+
+    //
+    // Parse the statements of an OBJ file and forward them to a handler.
+    //
+    // The handler must provide the following methods, called with the lexer positioned
+    // on the arguments of the statement:
+    //
+    //   void parse_f_statement();
+    //   void parse_o_g_statement();
+    //   void parse_usemtl_statement();
+    //   void parse_v_statement();
+    //   void parse_vn_statement();
+    //   void parse_vt_statement();
+    //
+
+    template <typename Handler>
+    void parse_statements(OBJMeshFileLexer& lexer, Handler& handler)
     {
         while (true)
         {
-            m_lexer.eat_blanks();
+            lexer.eat_blanks();
 
             // Handle end of file.
-            if (m_lexer.is_eof())
+            if (lexer.is_eof())
                 break;
 
             // Handle empty lines.
-            if (m_lexer.is_eol())
+            if (lexer.is_eol())
             {
-                m_lexer.accept_newline();
+                lexer.accept_newline();
                 continue;
             }
 
             const char* keyword;
             size_t keyword_length;
 
-            m_lexer.accept_string(&keyword, &keyword_length);
+            lexer.accept_string(&keyword, &keyword_length);
 
             if (keyword_length == 1)
             {
                 switch (keyword[0])
                 {
                   case 'f':
-                    parse_f_statement();
+                    handler.parse_f_statement();
                     break;
 
                   case 'g':
                   case 'o':
-                    parse_o_g_statement();
+                    handler.parse_o_g_statement();
                     break;
 
                   case 'v':
-                    parse_v_statement();
+                    handler.parse_v_statement();
                     break;
 
                   default:
                     // Ignore unknown or unhandled statements.
-                    m_lexer.eat_line();
+                    lexer.eat_line();
                     continue;
                 }
             }
@@ -159,50 +137,44 @@ struct OBJMeshFileReader::Impl
                 switch (keyword[0] * 256 + keyword[1])
                 {
                   case 'v' * 256 + 'n':
-                    parse_vn_statement();
+                    handler.parse_vn_statement();
                     break;
 
                   case 'v' * 256 + 't':
-                    parse_vt_statement();
+                    handler.parse_vt_statement();
                     break;
 
                   default:
                     // Ignore unknown or unhandled statements.
-                    m_lexer.eat_line();
+                    lexer.eat_line();
                     continue;
                 }
             }
             else if (strncmp(keyword, "usemtl", keyword_length) == 0)
             {
-                parse_usemtl_statement();
+                handler.parse_usemtl_statement();
             }
             else
             {
                 // Ignore unknown or unhandled statements.
-                m_lexer.eat_line();
+                lexer.eat_line();
                 continue;
             }
 
-            m_lexer.eat_blanks();
-            m_lexer.accept_newline();
+            lexer.eat_blanks();
+            lexer.accept_newline();
         }
-
-        // End the definition of the last object.
-        if (m_inside_mesh_def)
-            m_builder.end_mesh();
     }
 
-    void parse_f_statement()
+    // Parse the indices of a face statement as (vertex, texture coordinate, normal) triples
+    // of raw, 1-based or negative indices. Absent indices are set to NoIndex.
+    void parse_face_indices(OBJMeshFileLexer& lexer, vector<long>& indices)
     {
-        clear_keep_memory(m_face_vertex_indices);
-        clear_keep_memory(m_face_tex_coord_indices);
-        clear_keep_memory(m_face_normal_indices);
-
         while (true)
         {
-            m_lexer.eat_blanks();
+            lexer.eat_blanks();
 
-            if (m_lexer.is_eol())
+            if (lexer.is_eol())
                 break;
 
             //
@@ -210,11 +182,9 @@ struct OBJMeshFileReader::Impl
             // Accept n
             //
 
-            {
-                const long n = m_lexer.accept_long();
-                const size_t v = fix_index(n, m_vertices.size());
-                m_face_vertex_indices.push_back(v);
-            }
+            indices.push_back(lexer.accept_long());
+            indices.push_back(NoIndex);
+            indices.push_back(NoIndex);
 
             //
             // Recognized n
@@ -222,12 +192,12 @@ struct OBJMeshFileReader::Impl
             //
 
             {
-                const unsigned char c = m_lexer.get_char();
-                if (m_lexer.is_space(c))
+                const unsigned char c = lexer.get_char();
+                if (lexer.is_space(c))
                     continue;
                 else if (c == '/')
-                    m_lexer.next_char();
-                else parse_error();
+                    lexer.next_char();
+                else throw OBJMeshFileReader::ExceptionParseError(lexer.get_line_number());
             }
 
             //
@@ -236,18 +206,13 @@ struct OBJMeshFileReader::Impl
             //
 
             {
-                const unsigned char c = m_lexer.get_char();
+                const unsigned char c = lexer.get_char();
                 if (c == '/')
                 {
-                    m_lexer.next_char();
+                    lexer.next_char();
                     goto skip;
                 }
-                else
-                {
-                    const long n = m_lexer.accept_long();
-                    const size_t vt = fix_index(n, m_tex_coords.size());
-                    m_face_tex_coord_indices.push_back(vt);
-                }
+                else indices[indices.size() - 2] = lexer.accept_long();
             }
 
             //
@@ -256,12 +221,12 @@ struct OBJMeshFileReader::Impl
             //
 
             {
-                const unsigned char c = m_lexer.get_char();
-                if (m_lexer.is_space(c))
+                const unsigned char c = lexer.get_char();
+                if (lexer.is_space(c))
                     continue;
                 else if (c == '/')
-                    m_lexer.next_char();
-                else parse_error();
+                    lexer.next_char();
+                else throw OBJMeshFileReader::ExceptionParseError(lexer.get_line_number());
             }
 
           skip:
@@ -272,18 +237,421 @@ struct OBJMeshFileReader::Impl
             //
 
             {
-                const unsigned char c = m_lexer.get_char();
-                if (m_lexer.is_space(c))
-                    continue;
-                else
-                {
-                    const long n = m_lexer.accept_long();
-                    const size_t vn = fix_index(n, m_normals.size());
-                    m_face_normal_indices.push_back(vn);
-                }
+                const unsigned char c = lexer.get_char();
+                if (!lexer.is_space(c))
+                    indices.back() = lexer.accept_long();
+            }
+        }
+    }
+
+    string parse_compound_identifier(OBJMeshFileLexer& lexer)
+    {
+        string identifier;
+
+        lexer.eat_blanks();
+
+        while (!lexer.is_eol())
+        {
+            const char* token;
+            size_t token_length;
+
+            lexer.accept_string(&token, &token_length);
+            lexer.eat_blanks();
+
+            if (!identifier.empty())
+                identifier += ' ';
+
+            identifier.append(token, token_length);
+        }
+
+        return identifier;
+    }
+
+    Vector3d parse_vertex(OBJMeshFileLexer& lexer)
+    {
+        Vector3d v;
+
+        lexer.eat_blanks();
+        v.x = lexer.accept_double();
+
+        lexer.eat_blanks();
+        v.y = lexer.accept_double();
+
+        lexer.eat_blanks();
+        v.z = lexer.accept_double();
+
+        lexer.eat_blanks();
+
+        if (!lexer.is_eol())
+            lexer.accept_double();
+
+        return v;
+    }
+
+    Vector2d parse_tex_coords(OBJMeshFileLexer& lexer)
+    {
+        Vector2d v;
+
+        lexer.eat_blanks();
+        v.x = lexer.accept_double();
+
+        lexer.eat_blanks();
+        v.y = lexer.accept_double();
+
+        lexer.eat_blanks();
+
+        if (!lexer.is_eol())
+            lexer.accept_double();
+
+        return v;
+    }
+
+    Vector3d parse_normal(OBJMeshFileLexer& lexer)
+    {
+        Vector3d n;
+
+        lexer.eat_blanks();
+        n.x = lexer.accept_double();
+
+        lexer.eat_blanks();
+        n.y = lexer.accept_double();
+
+        lexer.eat_blanks();
+        n.z = lexer.accept_double();
+
+        return n;
+    }
+
+    //
+    // The statements of a newline-aligned chunk of an OBJ file, parsed independently
+    // of the rest of the file. Since features may be referenced with indices relative
+    // to the number of features defined so far, the number of features defined in the
+    // chunk is recorded with each statement.
+    //
+
+    struct Chunk
+    {
+        enum StatementType
+        {
+            FaceStatement,
+            ObjectStatement,
+            UseMaterialStatement
+        };
+
+        struct Statement
+        {
+            StatementType   m_type;
+            size_t          m_line;                 // line number, relative to the chunk
+            size_t          m_vertex_count;         // vertices defined in the chunk before the statement
+            size_t          m_tex_coord_count;      // texture coordinates defined in the chunk before the statement
+            size_t          m_normal_count;         // normals defined in the chunk before the statement
+            size_t          m_begin;                // face: first index in m_indices; others: index in m_names
+            size_t          m_end;                  // face: one past the last index in m_indices
+        };
+
+        const char*         m_begin;
+        const char*         m_end;
+
+        vector<Vector3d>    m_vertices;
+        vector<Vector2d>    m_tex_coords;
+        vector<Vector3d>    m_normals;
+        vector<Statement>   m_statements;
+        vector<long>        m_indices;
+        vector<string>      m_names;
+
+        size_t              m_line_count;
+        bool                m_parse_error;
+        size_t              m_parse_error_line;     // relative to the chunk
+    };
+
+    class ChunkParser
+    {
+      public:
+        ChunkParser(
+            Chunk&                              chunk,
+            const OBJMeshFileLexer::ParsingMode parsing_mode)
+          : m_chunk(&chunk)
+          , m_parsing_mode(parsing_mode)
+        {
+        }
+
+        void operator()()
+        {
+            Chunk& chunk = *m_chunk;
+
+            chunk.m_line_count = count(chunk.m_begin, chunk.m_end, '\n');
+            chunk.m_parse_error = false;
+
+            OBJMeshFileLexer lexer(m_parsing_mode);
+            lexer.open(chunk.m_begin, chunk.m_end);
+            m_lexer = &lexer;
+
+            try
+            {
+                parse_statements(lexer, *this);
+            }
+            catch (const OBJMeshFileReader::ExceptionParseError& e)
+            {
+                chunk.m_parse_error = true;
+                chunk.m_parse_error_line = e.m_line;
+            }
+
+            lexer.close();
+        }
+
+        void parse_f_statement()
+        {
+            Chunk::Statement& statement = push_statement(Chunk::FaceStatement);
+            statement.m_begin = m_chunk->m_indices.size();
+            parse_face_indices(*m_lexer, m_chunk->m_indices);
+            statement.m_end = m_chunk->m_indices.size();
+        }
+
+        void parse_o_g_statement()
+        {
+            push_statement(Chunk::ObjectStatement).m_begin = m_chunk->m_names.size();
+            m_chunk->m_names.push_back(parse_compound_identifier(*m_lexer));
+        }
+
+        void parse_usemtl_statement()
+        {
+            push_statement(Chunk::UseMaterialStatement).m_begin = m_chunk->m_names.size();
+            m_chunk->m_names.push_back(parse_compound_identifier(*m_lexer));
+        }
+
+        void parse_v_statement()
+        {
+            m_chunk->m_vertices.push_back(parse_vertex(*m_lexer));
+        }
+
+        void parse_vn_statement()
+        {
+            m_chunk->m_normals.push_back(parse_normal(*m_lexer));
+        }
+
+        void parse_vt_statement()
+        {
+            m_chunk->m_tex_coords.push_back(parse_tex_coords(*m_lexer));
+        }
+
+      private:
+        Chunk*                              m_chunk;
+        OBJMeshFileLexer::ParsingMode       m_parsing_mode;
+        OBJMeshFileLexer*                   m_lexer;
+
+        Chunk::Statement& push_statement(const Chunk::StatementType type)
+        {
+            Chunk::Statement statement;
+            statement.m_type = type;
+            statement.m_line = m_lexer->get_line_number();
+            statement.m_vertex_count = m_chunk->m_vertices.size();
+            statement.m_tex_coord_count = m_chunk->m_tex_coords.size();
+            statement.m_normal_count = m_chunk->m_normals.size();
+            statement.m_begin = 0;
+            statement.m_end = 0;
+
+            m_chunk->m_statements.push_back(statement);
+
+            return m_chunk->m_statements.back();
+        }
+    };
+}
+
+struct OBJMeshFileReader::Impl
+{
+    const int               m_options;
+    IMeshBuilder&           m_builder;
+    OBJMeshFileLexer        m_lexer;
+
+    // Current state.
+    bool                    m_inside_mesh_def;              // currently inside a mesh definition?
+    string                  m_current_mesh_name;            // name of the current mesh
+    map<string, size_t>     m_material_slots;               // material slots for the current mesh
+    size_t                  m_current_material_slot_index;  // index of the current material slot
+
+    // Features defined in the file.
+    vector<Vector3d>        m_vertices;
+    vector<Vector2d>        m_tex_coords;
+    vector<Vector3d>        m_normals;
+
+    // Mappings between internal indices and mesh indices.
+    vector<size_t>          m_vertex_index_mapping;
+    vector<size_t>          m_tex_coord_index_mapping;
+    vector<size_t>          m_normal_index_mapping;
+
+    // Temporary vectors for collecting indices while parsing face statements.
+    vector<long>            m_face_indices;
+    vector<size_t>          m_face_vertex_indices;
+    vector<size_t>          m_face_tex_coord_indices;
+    vector<size_t>          m_face_normal_indices;
+
+    // Constructor.
+    Impl(
+        const int           options,
+        IMeshBuilder&       builder)
+      : m_options(options)
+      , m_builder(builder)
+      , m_lexer(get_parsing_mode(options))
+      , m_inside_mesh_def(false)
+      , m_current_material_slot_index(0)
+    {
+    }
+
+    static OBJMeshFileLexer::ParsingMode get_parsing_mode(const int options)
+    {
+        return
+            (options & FavorSpeedOverPrecision)
+                ? OBJMeshFileLexer::Fast
+                : OBJMeshFileLexer::Precise;
+    }
+
+    // Close the input file and throw an ExceptionParseError exception.
+    void parse_error(const size_t line_number)
+    {
+        m_lexer.close();
+
+        throw ExceptionParseError(line_number);
+    }
+
+    void parse_file()
+    {
+        parse_statements(m_lexer, *this);
+
+        // End the definition of the last object.
+        if (m_inside_mesh_def)
+            m_builder.end_mesh();
+    }
+
+    // Parse the file with multiple threads, one newline-aligned chunk per thread at a time.
+    void parse_file_in_parallel(const char* begin, const char* end)
+    {
+        const size_t ChunkSize = 16 * 1024 * 1024;
+        const size_t thread_count = max<size_t>(System::get_logical_cpu_core_count(), 1);
+        const OBJMeshFileLexer::ParsingMode parsing_mode = get_parsing_mode(m_options);
+
+        size_t first_line = 1;
+        const char* chunk_begin = begin;
+
+        while (chunk_begin < end)
+        {
+            // Cut and parse the next batch of chunks.
+            vector<Chunk> chunks(thread_count);
+            boost::thread_group threads;
+            size_t chunk_count = 0;
+
+            while (chunk_count < thread_count && chunk_begin < end)
+            {
+                const char* chunk_end =
+                    static_cast<size_t>(end - chunk_begin) > ChunkSize
+                        ? find(chunk_begin + ChunkSize, end, '\n')
+                        : end;
+
+                if (chunk_end < end)
+                    ++chunk_end;
+
+                chunks[chunk_count].m_begin = chunk_begin;
+                chunks[chunk_count].m_end = chunk_end;
+                threads.create_thread(ChunkParser(chunks[chunk_count], parsing_mode));
+
+                chunk_begin = chunk_end;
+                ++chunk_count;
+            }
+
+            threads.join_all();
+
+            // Forward the statements to the builder in the order of the file.
+            for (size_t i = 0; i < chunk_count; ++i)
+            {
+                insert_chunk(chunks[i], first_line);
+
+                first_line += chunks[i].m_line_count;
+                clear_release_memory(chunks[i].m_indices);
             }
         }
 
+        // End the definition of the last object.
+        if (m_inside_mesh_def)
+            m_builder.end_mesh();
+    }
+
+    void insert_chunk(const Chunk& chunk, const size_t first_line)
+    {
+        const size_t base_vertex_count = m_vertices.size();
+        const size_t base_tex_coord_count = m_tex_coords.size();
+        const size_t base_normal_count = m_normals.size();
+
+        m_vertices.insert(m_vertices.end(), chunk.m_vertices.begin(), chunk.m_vertices.end());
+        m_tex_coords.insert(m_tex_coords.end(), chunk.m_tex_coords.begin(), chunk.m_tex_coords.end());
+        m_normals.insert(m_normals.end(), chunk.m_normals.begin(), chunk.m_normals.end());
+
+        for (const_each<vector<Chunk::Statement> > i = chunk.m_statements; i; ++i)
+        {
+            const size_t line = first_line + i->m_line - 1;
+
+            switch (i->m_type)
+            {
+              case Chunk::FaceStatement:
+                insert_face(
+                    chunk.m_indices.begin() + i->m_begin,
+                    chunk.m_indices.begin() + i->m_end,
+                    base_vertex_count + i->m_vertex_count,
+                    base_tex_coord_count + i->m_tex_coord_count,
+                    base_normal_count + i->m_normal_count,
+                    line);
+                break;
+
+              case Chunk::ObjectStatement:
+                begin_object(chunk.m_names[i->m_begin]);
+                break;
+
+              case Chunk::UseMaterialStatement:
+                use_material(chunk.m_names[i->m_begin]);
+                break;
+            }
+        }
+
+        if (chunk.m_parse_error)
+            throw ExceptionParseError(first_line + chunk.m_parse_error_line - 1);
+    }
+
+    void parse_f_statement()
+    {
+        clear_keep_memory(m_face_indices);
+
+        parse_face_indices(m_lexer, m_face_indices);
+
+        insert_face(
+            m_face_indices.begin(),
+            m_face_indices.end(),
+            m_vertices.size(),
+            m_tex_coords.size(),
+            m_normals.size(),
+            m_lexer.get_line_number());
+    }
+
+    void insert_face(
+        vector<long>::const_iterator    begin,
+        vector<long>::const_iterator    end,
+        const size_t                    vertex_count,
+        const size_t                    tex_coord_count,
+        const size_t                    normal_count,
+        const size_t                    line)
+    {
+        clear_keep_memory(m_face_vertex_indices);
+        clear_keep_memory(m_face_tex_coord_indices);
+        clear_keep_memory(m_face_normal_indices);
+
+        for (vector<long>::const_iterator i = begin; i != end; i += 3)
+        {
+            m_face_vertex_indices.push_back(fix_index(i[0], vertex_count, line));
+
+            if (i[1] != NoIndex)
+                m_face_tex_coord_indices.push_back(fix_index(i[1], tex_coord_count, line));
+
+            if (i[2] != NoIndex)
+                m_face_normal_indices.push_back(fix_index(i[2], normal_count, line));
+        }
+
         // Check whether the face is well-formed.
         const size_t vc = m_face_vertex_indices.size();
         const size_t tc = m_face_tex_coord_indices.size();
@@ -302,30 +670,30 @@ struct OBJMeshFileReader::Impl
         {
             // The face is ill-formed, ignore it or abort parsing.
             if (m_options & StopOnInvalidFaceDef)
-                throw ExceptionInvalidFaceDef(m_lexer.get_line_number());
+                throw ExceptionInvalidFaceDef(line);
         }
     }
 
     // Convert 1-based indices (including negative indices) to 0-based indices.
-    size_t fix_index(const long index, const size_t count)
+    size_t fix_index(const long index, const size_t count, const size_t line)
     {
         if (index > 0)
         {
             const size_t i = static_cast<size_t>(index);
             if (i > count)
-                parse_error();
+                parse_error(line);
             return i - 1;
         }
         else if (index < 0)
         {
             const size_t i = static_cast<size_t>(-index);
             if (i > count)
-                parse_error();
+                parse_error(line);
             return count - i;
         }
         else
         {
-            parse_error();
+            parse_error(line);
             return 0;       // keep the compiler happy
         }
     }
@@ -419,9 +787,11 @@ struct OBJMeshFileReader::Impl
 
     void parse_o_g_statement()
     {
-        // Retrieve the name of the upcoming mesh.
-        const string upcoming_mesh_name = parse_compound_identifier();
+        begin_object(parse_compound_identifier(m_lexer));
+    }
 
+    void begin_object(const string& upcoming_mesh_name)
+    {
         // Start a new mesh only if the name of the object or group actually changes.
         if (upcoming_mesh_name != m_current_mesh_name)
         {
@@ -440,92 +810,31 @@ struct OBJMeshFileReader::Impl
         }
     }
 
-    string parse_compound_identifier()
-    {
-        string identifier;
-
-        m_lexer.eat_blanks();
-
-        while (!m_lexer.is_eol())
-        {
-            const char* token;
-            size_t token_length;
-
-            m_lexer.accept_string(&token, &token_length);
-            m_lexer.eat_blanks();
-
-            if (!identifier.empty())
-                identifier += ' ';
-
-            identifier.append(token, token_length);
-        }
-
-        return identifier;
-    }
-
     void parse_v_statement()
     {
-        Vector3d v;
-
-        m_lexer.eat_blanks();
-        v.x = m_lexer.accept_double();
-
-        m_lexer.eat_blanks();
-        v.y = m_lexer.accept_double();
-
-        m_lexer.eat_blanks();
-        v.z = m_lexer.accept_double();
-
-        m_lexer.eat_blanks();
-
-        if (!m_lexer.is_eol())
-            m_lexer.accept_double();
-
-        m_vertices.push_back(v);
+        m_vertices.push_back(parse_vertex(m_lexer));
     }
 
     void parse_vt_statement()
     {
-        Vector2d v;
-
-        m_lexer.eat_blanks();
-        v.x = m_lexer.accept_double();
-
-        m_lexer.eat_blanks();
-        v.y = m_lexer.accept_double();
-
-        m_lexer.eat_blanks();
-
-        if (!m_lexer.is_eol())
-            m_lexer.accept_double();
-
-        m_tex_coords.push_back(v);
+        m_tex_coords.push_back(parse_tex_coords(m_lexer));
     }
 
     void parse_vn_statement()
     {
-        Vector3d n;
-
-        m_lexer.eat_blanks();
-        n.x = m_lexer.accept_double();
-
-        m_lexer.eat_blanks();
-        n.y = m_lexer.accept_double();
-
-        m_lexer.eat_blanks();
-        n.z = m_lexer.accept_double();
-
-        m_normals.push_back(n);
+        m_normals.push_back(parse_normal(m_lexer));
     }
 
     void parse_usemtl_statement()
+    {
+        use_material(parse_compound_identifier(m_lexer));
+    }
+
+    void use_material(const string& material_slot_name)
     {
         // Begin a mesh definition if we're not already inside one.
         ensure_mesh_def();
 
-        // Retrieve the name of the material slot.
-        const string material_slot_name = parse_compound_identifier();
-
         // Check whether this material slot has already been defined for this mesh.
         const map<string, size_t>::const_iterator& it =
             m_material_slots.find(material_slot_name);
@@ -570,15 +879,42 @@ void OBJMeshFileReader::read(IMeshBuilder& builder)
 {
     Impl impl(m_options, builder);
 
-    // Open the input file.
-    if (!impl.m_lexer.open(m_filename))
-        throw ExceptionIOError();
+    // Map the input file if it should be parsed in parallel.
+    auto_ptr<interprocess::file_mapping> file_mapping;
+    auto_ptr<interprocess::mapped_region> mapped_region;
+
+    if (m_options & ParallelParsing)
+    {
+        try
+        {
+            file_mapping.reset(new interprocess::file_mapping(m_filename.c_str(), interprocess::read_only));
+            mapped_region.reset(new interprocess::mapped_region(*file_mapping, interprocess::read_only));
+        }
+        catch (const interprocess::interprocess_exception&)
+        {
+            // Empty or unmappable files are parsed sequentially.
+            mapped_region.reset();
+        }
+    }
+
+    if (mapped_region.get())
+    {
+        // Parse the file.
+        const char* begin = static_cast<const char*>(mapped_region->get_address());
+        impl.parse_file_in_parallel(begin, begin + mapped_region->get_size());
+    }
+    else
+    {
+        // Open the input file.
+        if (!impl.m_lexer.open(m_filename))
+            throw ExceptionIOError();
 
-    // Parse the file.
-    impl.parse_file();
+        // Parse the file.
+        impl.parse_file();
 
-    // Close the input file.
-    impl.m_lexer.close();
+        // Close the input file.
+        impl.m_lexer.close();
+    }
 }
 
 }   // namespace foundation
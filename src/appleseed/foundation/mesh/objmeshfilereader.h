@@ -83,7 +83,8 @@ class OBJMeshFileReader
     {
         Default                 = 0,            // none of the flags below
         FavorSpeedOverPrecision = 1 << 0,       // use approximate algorithm for parsing floating-point values
-        StopOnInvalidFaceDef    = 1 << 1        // stop parsing on invalid face definitions
+        StopOnInvalidFaceDef    = 1 << 1,       // stop parsing on invalid face definitions
+        ParallelParsing         = 1 << 2        // parse chunks of the file on multiple threads
     };
 
     // Constructor.
@@ -35,15 +35,16 @@ using namespace foundation;
 
 BENCHMARK_SUITE(Foundation_Image_FilteredTile)
 {
-    struct Fixture
+    template <typename Filter>
+    struct FixtureBase
     {
-        GaussianFilter2<float>  m_filter;
+        Filter                  m_filter;
         FilteredTile            m_tile;
         const volatile float    m_x;
         const volatile float    m_y;
 
-        Fixture()
-          : m_filter(2.0f, 2.0f, 8.0f)
+        explicit FixtureBase(const Filter& filter)
+          : m_filter(filter)
           , m_tile(1024, 1024, 4, m_filter)
           , m_x(42.42f)
           , m_y(66.66f)
@@ -51,10 +52,62 @@ BENCHMARK_SUITE(Foundation_Image_FilteredTile)
         }
     };
 
+    struct Fixture
+      : public FixtureBase<GaussianFilter2<float> >
+    {
+        Fixture()
+          : FixtureBase<GaussianFilter2<float> >(GaussianFilter2<float>(2.0f, 2.0f, 8.0f))
+        {
+        }
+    };
+
+    struct BlackmanHarrisFixture
+      : public FixtureBase<BlackmanHarrisFilter2<float> >
+    {
+        BlackmanHarrisFixture()
+          : FixtureBase<BlackmanHarrisFilter2<float> >(BlackmanHarrisFilter2<float>(1.5f, 1.5f))
+        {
+        }
+    };
+
+    struct LargeBlackmanHarrisFixture
+      : public FixtureBase<BlackmanHarrisFilter2<float> >
+    {
+        LargeBlackmanHarrisFixture()
+          : FixtureBase<BlackmanHarrisFilter2<float> >(BlackmanHarrisFilter2<float>(4.0f, 4.0f))
+        {
+        }
+    };
+
+    const float Values[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+
     BENCHMARK_CASE_F(Add, Fixture)
     {
-        const float Values[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+        m_tile.add(m_x, m_y, Values);
+    }
+
+    BENCHMARK_CASE_F(AddExclusive, Fixture)
+    {
+        m_tile.add_exclusive(m_x, m_y, Values);
+    }
+
+    BENCHMARK_CASE_F(Add_BlackmanHarris, BlackmanHarrisFixture)
+    {
+        m_tile.add(m_x, m_y, Values);
+    }
+
+    BENCHMARK_CASE_F(AddExclusive_BlackmanHarris, BlackmanHarrisFixture)
+    {
+        m_tile.add_exclusive(m_x, m_y, Values);
+    }
 
+    BENCHMARK_CASE_F(Add_LargeBlackmanHarris, LargeBlackmanHarrisFixture)
+    {
         m_tile.add(m_x, m_y, Values);
     }
+
+    BENCHMARK_CASE_F(AddExclusive_LargeBlackmanHarris, LargeBlackmanHarrisFixture)
+    {
+        m_tile.add_exclusive(m_x, m_y, Values);
+    }
 }
@@ -0,0 +1,162 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/math/hash.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/scalar.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/benchmark.h"
+#include "foundation/utility/containers/hashtable.h"
+#include "foundation/utility/containers/openhashtable.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+BENCHMARK_SUITE(Foundation_Utility_Containers_HashTable)
+{
+    // Same layout as the keys of light-emitting triangles.
+    struct Key
+    {
+        uint32  m_a;
+        uint32  m_b;
+        uint32  m_c;
+        uint32  m_d;
+
+        bool operator==(const Key& rhs) const
+        {
+            return m_d == rhs.m_d && m_b == rhs.m_b && m_a == rhs.m_a && m_c == rhs.m_c;
+        }
+    };
+
+    struct KeyHasher
+    {
+        size_t operator()(const Key& key) const
+        {
+            return mix_uint32(key.m_a, key.m_b, key.m_c, key.m_d);
+        }
+    };
+
+    const size_t ElementCount = 100000;
+    const size_t LookupCount = 1000;
+
+    template <typename TableType>
+    struct Fixture
+    {
+        KeyHasher       m_hasher;
+        TableType       m_table;
+        vector<Key>     m_keys;
+        vector<Key>     m_lookups;
+        size_t          m_dummy;
+
+        Fixture()
+          : m_table(m_hasher)
+          , m_dummy(0)
+        {
+            MersenneTwister rng;
+
+            m_keys.resize(ElementCount);
+            for (size_t i = 0; i < ElementCount; ++i)
+            {
+                m_keys[i].m_a = static_cast<uint32>(i / 1000);
+                m_keys[i].m_b = 0;
+                m_keys[i].m_c = 0;
+                m_keys[i].m_d = static_cast<uint32>(i);
+            }
+
+            // Randomly ordered lookups of existing keys, as with rays hitting random lights.
+            for (size_t i = 0; i < LookupCount; ++i)
+                m_lookups.push_back(m_keys[rand_int1(rng, 0, static_cast<int32>(ElementCount - 1))]);
+        }
+
+        void lookup_payload()
+        {
+            for (size_t i = 0; i < LookupCount; ++i)
+                m_dummy += m_table.get(m_lookups[i]);
+        }
+    };
+
+    typedef HashTable<Key, KeyHasher, size_t> ChainedTable;
+    typedef OpenHashTable<Key, KeyHasher, size_t> OpenTable;
+
+    struct ChainedFixture
+      : public Fixture<ChainedTable>
+    {
+        ChainedFixture()
+        {
+            m_table.resize(next_pow2(ElementCount));
+
+            for (size_t i = 0; i < ElementCount; ++i)
+                m_table.insert(m_keys[i], i);
+        }
+    };
+
+    struct OpenFixture
+      : public Fixture<OpenTable>
+    {
+        OpenFixture()
+        {
+            m_table.resize(ElementCount);
+
+            for (size_t i = 0; i < ElementCount; ++i)
+                m_table.insert(m_keys[i], i);
+        }
+    };
+
+    BENCHMARK_CASE_F(HashTable_Get, ChainedFixture)
+    {
+        lookup_payload();
+    }
+
+    BENCHMARK_CASE_F(OpenHashTable_Get, OpenFixture)
+    {
+        lookup_payload();
+    }
+
+    BENCHMARK_CASE_F(HashTable_Build, Fixture<ChainedTable>)
+    {
+        m_table.resize(next_pow2(ElementCount));
+
+        for (size_t i = 0; i < ElementCount; ++i)
+            m_table.insert(m_keys[i], i);
+    }
+
+    BENCHMARK_CASE_F(OpenHashTable_Build, Fixture<OpenTable>)
+    {
+        m_table.resize(ElementCount);
+
+        for (size_t i = 0; i < ElementCount; ++i)
+            m_table.insert(m_keys[i], i);
+    }
+}
@@ -31,6 +31,7 @@
 #include "foundation/math/aabb.h"
 #include "foundation/math/intersection/rayaabb.h"
 #include "foundation/math/intersection/raytrianglemt.h"
+#include "foundation/math/intersection/raytrianglemt4.h"
 #include "foundation/math/intersection/raytrianglessk.h"
 #include "foundation/math/ray.h"
 #include "foundation/math/rng/distribution.h"
@@ -276,6 +277,87 @@ BENCHMARK_SUITE(Foundation_Math_Intersection_RayTriangleMT)
     BENCHMARK_CASE_F(Intersect_DoublePrecision_HitRateIs100Percents, FixtureDouble100) { payload(); }
 }
 
+BENCHMARK_SUITE(Foundation_Math_Intersection_RayTriangleMT4)
+{
+    // Find the closest of four triangles, one at a time or all at once.
+    template <typename T>
+    struct Fixture
+      : public FixtureBase<T>
+    {
+        typedef typename FixtureBase<T>::VectorType VectorType;
+        typedef typename FixtureBase<T>::RayType RayType;
+
+        static const size_t RayCount = 1000;
+
+        TriangleMT<T>   m_triangles[4];
+        TriangleMT4<T>  m_triangles4;
+        RayType         m_ray[RayCount];
+
+        size_t          m_hit;
+        T               m_t;
+        T               m_u;
+        T               m_v;
+
+        Fixture()
+          : m_hit(0)
+        {
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < 4; ++i)
+            {
+                const VectorType v0 = FixtureBase<T>::template get_random_vector<3>(rng, T(-1.0), T(1.0));
+                const VectorType v1 = FixtureBase<T>::template get_random_vector<3>(rng, T(-1.0), T(1.0));
+                const VectorType v2 = FixtureBase<T>::template get_random_vector<3>(rng, T(-1.0), T(1.0));
+                m_triangles[i] = TriangleMT<T>(v0, v1, v2);
+                m_triangles4.set(i, m_triangles[i]);
+            }
+
+            for (size_t i = 0; i < RayCount; ++i)
+                FixtureBase<T>::get_random_ray(rng, T(10.0), m_ray[i]);
+        }
+
+        APPLESEED_FORCE_INLINE void scalar_payload()
+        {
+            for (size_t i = 0; i < RayCount; ++i)
+            {
+                RayType ray = m_ray[i];
+
+                for (size_t j = 0; j < 4; ++j)
+                {
+                    if (m_triangles[j].intersect(ray, m_t, m_u, m_v))
+                    {
+                        ray.m_tmax = m_t;
+                        m_hit ^= j;
+                    }
+                }
+            }
+        }
+
+        APPLESEED_FORCE_INLINE void simd_payload()
+        {
+            for (size_t i = 0; i < RayCount; ++i)
+            {
+                T t[4], u[4], v[4];
+                const size_t mask = m_triangles4.intersect(m_ray[i], t, u, v);
+
+                if (mask)
+                {
+                    const size_t j = find_closest_hit(mask, t);
+                    m_t = t[j];
+                    m_u = u[j];
+                    m_v = v[j];
+                    m_hit ^= j;
+                }
+            }
+        }
+    };
+
+    BENCHMARK_CASE_F(IntersectFourTriangles_SinglePrecision_Scalar, Fixture<float>) { scalar_payload(); }
+    BENCHMARK_CASE_F(IntersectFourTriangles_SinglePrecision_SIMD, Fixture<float>) { simd_payload(); }
+    BENCHMARK_CASE_F(IntersectFourTriangles_DoublePrecision_Scalar, Fixture<double>) { scalar_payload(); }
+    BENCHMARK_CASE_F(IntersectFourTriangles_DoublePrecision_SIMD, Fixture<double>) { simd_payload(); }
+}
+
 BENCHMARK_SUITE(Foundation_Math_Intersection_RayTriangleSSK)
 {
     template <typename T, int TargetHitRate>
@@ -48,7 +48,7 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
         }
     };
 
-    template <size_t ThreadCount>
+    template <size_t ThreadCount, int Flags = 0>
     struct Fixture
     {
         Logger      m_logger;
@@ -56,7 +56,7 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
         JobManager  m_job_manager;
 
         Fixture()
-          : m_job_manager(m_logger, m_job_queue, ThreadCount, JobManager::KeepRunningOnEmptyQueue)
+          : m_job_manager(m_logger, m_job_queue, ThreadCount, JobManager::KeepRunningOnEmptyQueue | Flags)
         {
             m_job_manager.start();
         }
@@ -73,6 +73,9 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
         }
     };
 
+    typedef Fixture<2, JobManager::WorkStealing> DoubleThreadedWorkStealingFixture;
+    typedef Fixture<8, JobManager::WorkStealing> OctoThreadedWorkStealingFixture;
+
     BENCHMARK_CASE_F(SingleThreadedJobExecution, Fixture<1>)
     {
         payload();
@@ -82,4 +85,19 @@ BENCHMARK_SUITE(Foundation_Utility_Job)
     {
         payload();
     }
+
+    BENCHMARK_CASE_F(OctoThreadedJobExecution, Fixture<8>)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(DoubleThreadedJobExecutionWithWorkStealing, DoubleThreadedWorkStealingFixture)
+    {
+        payload();
+    }
+
+    BENCHMARK_CASE_F(OctoThreadedJobExecutionWithWorkStealing, OctoThreadedWorkStealingFixture)
+    {
+        payload();
+    }
 }
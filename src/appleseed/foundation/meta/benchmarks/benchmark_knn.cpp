@@ -45,6 +45,7 @@
 // Standard headers.
 #include <cassert>
 #include <cstddef>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -182,6 +183,24 @@ BENCHMARK_SUITE(Foundation_Math_Knn_Query)
             }
         }
 
+        void run_batched_queries()
+        {
+            knn::Query3f query(m_tree, m_answer);
+
+            query.run(
+                &m_query_points[0],
+                m_query_points.size(),
+                numeric_limits<float>::max(),
+                *this);
+        }
+
+      public:
+        // Visitor interface for batched queries.
+        void visit(const size_t query_index, const knn::Answer<float>& answer)
+        {
+            m_accumulator += answer.size();
+        }
+
       private:
         Logger                              m_logger;
         auto_release_ptr<FileLogTarget>     m_log_target;
@@ -281,4 +300,46 @@ BENCHMARK_SUITE(Foundation_Math_Knn_Query)
     BENCHMARK_CASE_F(PhotonMap_K20, PhotonMapFixture<20>)    { run_queries(); }
     BENCHMARK_CASE_F(PhotonMap_K100, PhotonMapFixture<100>)  { run_queries(); }
     BENCHMARK_CASE_F(PhotonMap_K500, PhotonMapFixture<500>)  { run_queries(); }
+
+    BENCHMARK_CASE_F(Particles_K20_Batched, ParticlesFixture<20>)    { run_batched_queries(); }
+    BENCHMARK_CASE_F(Particles_K100_Batched, ParticlesFixture<100>)  { run_batched_queries(); }
+
+    BENCHMARK_CASE_F(PhotonMap_K20_Batched, PhotonMapFixture<20>)    { run_batched_queries(); }
+    BENCHMARK_CASE_F(PhotonMap_K100_Batched, PhotonMapFixture<100>)  { run_batched_queries(); }
+}
+
+BENCHMARK_SUITE(Foundation_Math_Knn_Builder)
+{
+    template <size_t ThreadCount>
+    struct Fixture
+    {
+        vector<Vector3f>    m_points;
+        vector<Vector3f>    m_points_copy;
+        knn::Tree3f         m_tree;
+
+        Fixture()
+        {
+            const size_t PointCount = 50000;
+
+            MersenneTwister rng;
+
+            m_points.reserve(PointCount);
+
+            for (size_t i = 0; i < PointCount; ++i)
+                m_points.push_back(rand_vector1<Vector3f>(rng));
+        }
+
+        void build()
+        {
+            // The builder moves the points into the tree.
+            m_points_copy = m_points;
+
+            knn::Builder3f builder(m_tree);
+            builder.build_move_points<DefaultWallclockTimer>(m_points_copy, ThreadCount);
+        }
+    };
+
+    BENCHMARK_CASE_F(BuildMovePoints_OneThread, Fixture<1>)      { build(); }
+    BENCHMARK_CASE_F(BuildMovePoints_FourThreads, Fixture<4>)    { build(); }
+    BENCHMARK_CASE_F(BuildMovePoints_EightThreads, Fixture<8>)   { build(); }
 }
@@ -137,4 +137,39 @@ BENCHMARK_SUITE(Foundation_Math_Microfacet)
     {
         evaluate(0.5f, 0.5f);
     }
+
+    //
+    // Albedo tables.
+    //
+
+    struct AlbedoTableFixture
+      : public FixtureBase<GGXMDF>
+    {
+        const MDFAlbedoTable& m_table;
+
+        AlbedoTableFixture()
+          : m_table(get_table())
+        {
+        }
+
+        static const MDFAlbedoTable& get_table()
+        {
+            static const GGXMDF mdf;
+            static const MDFAlbedoTable table(mdf);
+            return table;
+        }
+    };
+
+    BENCHMARK_CASE_F(GGXMDF_DirectionalAlbedoLookup, AlbedoTableFixture)
+    {
+        m_dummy +=
+            m_table.get_directional_albedo(
+                rand_float2(m_rng),
+                rand_float2(m_rng));
+    }
+
+    BENCHMARK_CASE_F(GGXMDF_AverageAlbedoLookup, AlbedoTableFixture)
+    {
+        m_dummy += m_table.get_average_albedo(rand_float2(m_rng));
+    }
 }
@@ -31,10 +31,17 @@
 #include "foundation/math/permutation.h"
 #include "foundation/math/primes.h"
 #include "foundation/math/qmc.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/sampling/qmcsamplingcontext.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/sobol.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/benchmark.h"
 
 // Standard headers.
+#include <cmath>
 #include <cstddef>
 
 using namespace foundation;
@@ -256,6 +263,87 @@ BENCHMARK_SUITE(Foundation_Math_QMC)
             for (size_t i = 0; i < 64; ++i)
                 m_x += hammersley_sequence<T, 2>(Bases, 64, i);
         }
+
+        void sobol_payload()
+        {
+            m_x = Vector<T, 2>(0.0f);
+
+            for (uint32 i = 0; i < 64; ++i)
+            {
+                m_x[0] += fixed_point_to_unit<T>(sobol_uint32(0, i));
+                m_x[1] += fixed_point_to_unit<T>(sobol_uint32(1, i));
+            }
+        }
+
+        void scrambled_sobol_payload()
+        {
+            m_x = Vector<T, 2>(0.0f);
+
+            for (uint32 i = 0; i < 64; ++i)
+                m_x += shuffled_scrambled_sobol_sequence<T, 2>(0x12345678UL, i);
+        }
+    };
+
+    //
+    // Integrate sin(pi x) sin(pi y) over the unit square with QMCSamplingContext,
+    // and report the RMS error of the estimate over a number of independent
+    // randomizations of the sampling pattern.
+    //
+
+    typedef QMCSamplingContext<MersenneTwister> SamplingContext;
+
+    template <SamplingContext::Mode Mode>
+    struct ConvergenceBenchmarkCase
+      : public IBenchmarkCase
+    {
+        static const size_t SampleCount = 256;
+        static const size_t RandomizationCount = 16;
+
+        MersenneTwister m_rng;
+        double          m_rms_error;
+
+        ConvergenceBenchmarkCase()
+          : m_rms_error(0.0)
+        {
+        }
+
+        virtual size_t get_metric_count() const APPLESEED_OVERRIDE
+        {
+            return 1;
+        }
+
+        virtual void get_metric(const size_t index, MetricResult& metric) const APPLESEED_OVERRIDE
+        {
+            metric.m_name = "rms error";
+            metric.m_unit = "%";
+            metric.m_value = m_rms_error;
+        }
+
+        void integrate()
+        {
+            const double Expected = 4.0 / (Pi<double>() * Pi<double>());
+            double sum_squared_error = 0.0;
+
+            for (size_t r = 0; r < RandomizationCount; ++r)
+            {
+                // Each randomization gets its own base instance, as pixels do in the renderer.
+                SamplingContext parent(m_rng, Mode, 1, 0, r);
+                SamplingContext context = parent.split(2, SampleCount);
+
+                double sum = 0.0;
+
+                for (size_t i = 0; i < SampleCount; ++i)
+                {
+                    const Vector2d s = context.next2<Vector2d>();
+                    sum += std::sin(Pi<double>() * s[0]) * std::sin(Pi<double>() * s[1]);
+                }
+
+                const double error = sum / SampleCount - Expected;
+                sum_squared_error += error * error;
+            }
+
+            m_rms_error = 100.0 * std::sqrt(sum_squared_error / RandomizationCount) / Expected;
+        }
     };
 
     //
@@ -367,4 +455,47 @@ BENCHMARK_SUITE(Foundation_Math_QMC)
     {
         hammersley_payload();
     }
+
+    //
+    // Sobol sequence.
+    //
+
+    BENCHMARK_CASE_F(SobolSequence_SinglePrecision, Vector2Fixture<float>)
+    {
+        sobol_payload();
+    }
+
+    BENCHMARK_CASE_F(SobolSequence_DoublePrecision, Vector2Fixture<double>)
+    {
+        sobol_payload();
+    }
+
+    BENCHMARK_CASE_F(ScrambledSobolSequence_SinglePrecision, Vector2Fixture<float>)
+    {
+        scrambled_sobol_payload();
+    }
+
+    BENCHMARK_CASE_F(ScrambledSobolSequence_DoublePrecision, Vector2Fixture<double>)
+    {
+        scrambled_sobol_payload();
+    }
+
+    //
+    // Convergence of the sampling modes of QMCSamplingContext.
+    //
+
+    BENCHMARK_CASE_WITH_BASE(Convergence_RNGMode, ConvergenceBenchmarkCase<SamplingContext::RNGMode>)
+    {
+        integrate();
+    }
+
+    BENCHMARK_CASE_WITH_BASE(Convergence_QMCMode, ConvergenceBenchmarkCase<SamplingContext::QMCMode>)
+    {
+        integrate();
+    }
+
+    BENCHMARK_CASE_WITH_BASE(Convergence_SobolMode, ConvergenceBenchmarkCase<SamplingContext::SobolMode>)
+    {
+        integrate();
+    }
 }
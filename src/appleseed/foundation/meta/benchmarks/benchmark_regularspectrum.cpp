@@ -66,4 +66,24 @@ BENCHMARK_SUITE(Foundation_Image_RegularSpectrum31f)
     {
         m_spectrum1 *= m_spectrum2;
     }
+
+    BENCHMARK_CASE_F(InPlaceSubtraction, Fixture)
+    {
+        m_spectrum1 -= m_spectrum2;
+    }
+
+    BENCHMARK_CASE_F(InPlaceDivisionBySpectrum, Fixture)
+    {
+        m_spectrum1 /= m_spectrum2;
+    }
+
+    BENCHMARK_CASE_F(MinValue, Fixture)
+    {
+        m_spectrum1[0] = min_value(m_spectrum2);
+    }
+
+    BENCHMARK_CASE_F(MaxValue, Fixture)
+    {
+        m_spectrum1[0] = max_value(m_spectrum2);
+    }
 }
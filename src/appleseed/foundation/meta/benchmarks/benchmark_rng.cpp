@@ -33,6 +33,8 @@
 #ifdef APPLESEED_USE_SSE
 #include "foundation/math/rng/simdmersennetwister.h"
 #endif
+#include "foundation/math/rng/simdpcg.h"
+#include "foundation/math/rng/simdxorshift.h"
 #include "foundation/math/rng/xorshift.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/benchmark.h"
@@ -114,4 +116,94 @@ BENCHMARK_SUITE(Foundation_Math_RNG)
             m_dummy ^= m_rng.rand_uint32();
         }
     }
+
+    //
+    // Batched generators. Each case generates the same number of values as the cases above.
+    //
+
+    template <typename RNG>
+    struct BatchFixture
+      : public Fixture<RNG>
+    {
+        void rand_uint32_payload()
+        {
+            uint32 values[RNG::LaneCount];
+
+            for (size_t i = 0; i < 1000000 / RNG::LaneCount; ++i)
+            {
+                this->m_rng.rand_uint32(values);
+
+                for (size_t j = 0; j < RNG::LaneCount; ++j)
+                    this->m_dummy ^= values[j];
+            }
+        }
+
+        void rand_float2_payload()
+        {
+            float values[RNG::LaneCount];
+            float sum = 0.0f;
+
+            for (size_t i = 0; i < 1000000 / RNG::LaneCount; ++i)
+            {
+                this->m_rng.rand_float2(values);
+
+                for (size_t j = 0; j < RNG::LaneCount; ++j)
+                    sum += values[j];
+            }
+
+            this->m_dummy ^= static_cast<uint32>(sum);
+        }
+    };
+
+    BENCHMARK_CASE_F(SimdPCG4_RandUint32, Fixture<SimdPCG<4> >)
+    {
+        for (size_t i = 0; i < 250000; ++i)
+        {
+            m_dummy ^= m_rng.rand_uint32();
+            m_dummy ^= m_rng.rand_uint32();
+            m_dummy ^= m_rng.rand_uint32();
+            m_dummy ^= m_rng.rand_uint32();
+        }
+    }
+
+    BENCHMARK_CASE_F(SimdPCG4_RandUint32Batch, BatchFixture<SimdPCG<4> >)
+    {
+        rand_uint32_payload();
+    }
+
+    BENCHMARK_CASE_F(SimdPCG8_RandUint32Batch, BatchFixture<SimdPCG<8> >)
+    {
+        rand_uint32_payload();
+    }
+
+    BENCHMARK_CASE_F(SimdPCG8_RandFloat2Batch, BatchFixture<SimdPCG<8> >)
+    {
+        rand_float2_payload();
+    }
+
+    BENCHMARK_CASE_F(SimdXorshift4_RandUint32, Fixture<SimdXorshift<4> >)
+    {
+        for (size_t i = 0; i < 250000; ++i)
+        {
+            m_dummy ^= m_rng.rand_uint32();
+            m_dummy ^= m_rng.rand_uint32();
+            m_dummy ^= m_rng.rand_uint32();
+            m_dummy ^= m_rng.rand_uint32();
+        }
+    }
+
+    BENCHMARK_CASE_F(SimdXorshift4_RandUint32Batch, BatchFixture<SimdXorshift<4> >)
+    {
+        rand_uint32_payload();
+    }
+
+    BENCHMARK_CASE_F(SimdXorshift8_RandUint32Batch, BatchFixture<SimdXorshift<8> >)
+    {
+        rand_uint32_payload();
+    }
+
+    BENCHMARK_CASE_F(SimdXorshift8_RandFloat2Batch, BatchFixture<SimdXorshift<8> >)
+    {
+        rand_float2_payload();
+    }
 }
@@ -30,6 +30,8 @@
 // appleseed.foundation headers.
 #include "foundation/math/rng/distribution.h"
 #include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/rng/simdpcg.h"
+#include "foundation/math/rng/simdxorshift.h"
 #include "foundation/math/sampling/mappings.h"
 #include "foundation/math/sampling/qmcsamplingcontext.h"
 #include "foundation/math/sampling/rngsamplingcontext.h"
@@ -60,11 +62,58 @@ namespace
 
 BENCHMARK_SUITE(Foundation_Math_Sampling_RNGSamplingContext)
 {
-    BENCHMARK_CASE_F(BenchmarkTrajectory, SamplingContextFixture)
+    template <typename RNG>
+    struct Fixture
+    {
+        RNG         m_rng;
+        Vector2d    m_v;
+
+        Fixture()
+          : m_v(0.0)
+        {
+        }
+
+        void trajectory_payload()
+        {
+            const size_t InitialInstance = 1234567;
+            RNGSamplingContext<RNG> context(
+                m_rng,
+                1,
+                InitialInstance,
+                InitialInstance);
+
+            for (size_t i = 0; i < 32; ++i)
+            {
+                context.split_in_place(2, 1);
+                m_v += context.template next2<Vector2d>();
+            }
+        }
+    };
+
+    BENCHMARK_CASE_F(BenchmarkTrajectory, Fixture<MersenneTwister>)
+    {
+        trajectory_payload();
+    }
+
+    BENCHMARK_CASE_F(BenchmarkTrajectory_SimdPCG8, Fixture<SimdPCG<8> >)
+    {
+        trajectory_payload();
+    }
+
+    BENCHMARK_CASE_F(BenchmarkTrajectory_SimdXorshift8, Fixture<SimdXorshift<8> >)
+    {
+        trajectory_payload();
+    }
+}
+
+BENCHMARK_SUITE(Foundation_Math_Sampling_QMCSamplingContext)
+{
+    BENCHMARK_CASE_F(BenchmarkTrajectory_RNGMode, SamplingContextFixture)
     {
         const size_t InitialInstance = 1234567;
-        RNGSamplingContext<RNG> context(
+        QMCSamplingContext<RNG> context(
             m_rng,
+            QMCSamplingContext<RNG>::RNGMode,
             1,
             InitialInstance,
             InitialInstance);
@@ -75,16 +124,13 @@ BENCHMARK_SUITE(Foundation_Math_Sampling_RNGSamplingContext)
             m_v += context.next2<Vector2d>();
         }
     }
-}
 
-BENCHMARK_SUITE(Foundation_Math_Sampling_QMCSamplingContext)
-{
-    BENCHMARK_CASE_F(BenchmarkTrajectory_RNGMode, SamplingContextFixture)
+    BENCHMARK_CASE_F(BenchmarkTrajectory_QMCMode, SamplingContextFixture)
     {
         const size_t InitialInstance = 1234567;
         QMCSamplingContext<RNG> context(
             m_rng,
-            QMCSamplingContext<RNG>::RNGMode,
+            QMCSamplingContext<RNG>::QMCMode,
             1,
             InitialInstance,
             InitialInstance);
@@ -96,12 +142,12 @@ BENCHMARK_SUITE(Foundation_Math_Sampling_QMCSamplingContext)
         }
     }
 
-    BENCHMARK_CASE_F(BenchmarkTrajectory_QMCMode, SamplingContextFixture)
+    BENCHMARK_CASE_F(BenchmarkTrajectory_SobolMode, SamplingContextFixture)
     {
         const size_t InitialInstance = 1234567;
         QMCSamplingContext<RNG> context(
             m_rng,
-            QMCSamplingContext<RNG>::QMCMode,
+            QMCSamplingContext<RNG>::SobolMode,
             1,
             InitialInstance,
             InitialInstance);
@@ -0,0 +1,147 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.foundation headers.
+#include "foundation/math/aliastable.h"
+#include "foundation/math/fp.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Math_AliasTable)
+{
+    typedef foundation::AliasTable<int, double> AliasTable;
+
+    TEST_CASE(Empty_GivenTableInInitialState_ReturnsTrue)
+    {
+        AliasTable table;
+
+        EXPECT_TRUE(table.empty());
+    }
+
+    TEST_CASE(Valid_GivenTableInInitialState_ReturnsFalse)
+    {
+        AliasTable table;
+
+        EXPECT_FALSE(table.valid());
+    }
+
+    TEST_CASE(Valid_GivenTableWithOneItemWithZeroWeight_ReturnsFalse)
+    {
+        AliasTable table;
+        table.insert(1, 0.0);
+
+        EXPECT_FALSE(table.valid());
+    }
+
+    TEST_CASE(Sample_GivenTableWithOneItemWithPositiveWeight_ReturnsItem)
+    {
+        AliasTable table;
+        table.insert(1, 0.5);
+        table.prepare();
+
+        const AliasTable::ItemWeightPair result = table.sample(0.5);
+
+        EXPECT_EQ(1, result.first);
+        EXPECT_FEQ(1.0, result.second);
+    }
+
+    TEST_CASE(Sample_GivenInputOneUlpBeforeOne_ReturnsItemWithPositiveWeight)
+    {
+        AliasTable table;
+        table.insert(1, 0.4);
+        table.insert(2, 1.6);
+        table.insert(3, 0.0);
+        table.prepare();
+
+        const AliasTable::ItemWeightPair result = table.sample(shift(1.0, -1));
+
+        EXPECT_TRUE(result.second > 0.0);
+    }
+
+    TEST_CASE(Sample_GivenItemsWithZeroWeight_NeverReturnsThem)
+    {
+        AliasTable table;
+        table.insert(0, 0.0);
+        table.insert(1, 3.0);
+        table.insert(2, 0.0);
+        table.insert(3, 1.0);
+        table.insert(4, 0.0);
+        table.prepare();
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            const double x = static_cast<double>(i) / 1000;
+            const int item = table.sample(x).first;
+
+            EXPECT_TRUE(item == 1 || item == 3);
+        }
+    }
+
+    TEST_CASE(Sample_GivenUniformInputs_ReturnsItemsInProportionOfTheirWeight)
+    {
+        const size_t ItemCount = 100;
+        const size_t SampleCount = 100000;
+
+        MersenneTwister rng;
+
+        AliasTable table;
+        double weight_sum = 0.0;
+        for (size_t i = 0; i < ItemCount; ++i)
+        {
+            const double weight = i % 7 == 0 ? 0.0 : rand_double1(rng);
+            table.insert(static_cast<int>(i), weight);
+            weight_sum += weight;
+        }
+        table.prepare();
+
+        // Stratified inputs make the histogram match the weights up to the bucket discretization.
+        vector<size_t> histogram(ItemCount, 0);
+        for (size_t i = 0; i < SampleCount; ++i)
+        {
+            const double x = (i + 0.5) / SampleCount;
+            const AliasTable::ItemWeightPair& result = table.sample(x);
+            EXPECT_FEQ(table[result.first].second, result.second);
+            ++histogram[result.first];
+        }
+
+        for (size_t i = 0; i < ItemCount; ++i)
+        {
+            const double expected = table[i].second;
+            const double actual = static_cast<double>(histogram[i]) / SampleCount;
+            EXPECT_LT(1.0e-4, abs(actual - expected));
+        }
+    }
+}
@@ -36,6 +36,9 @@
 #include "foundation/math/fp.h"
 #include "foundation/utility/test.h"
 
+// Standard headers.
+#include <cmath>
+
 using namespace foundation;
 
 TEST_SUITE(Foundation_Image_Analysis)
@@ -119,4 +122,44 @@ TEST_SUITE(Foundation_Image_Analysis)
 
         EXPECT_FEQ(1.0, rmsd);
     }
+
+    TEST_CASE(ComputeRelativeRMSDeviation_GivenIdenticalTiles_ReturnsZero)
+    {
+        Tile tile(2, 2, 4, PixelFormatFloat);
+        Tile ref_tile(2, 2, 4, PixelFormatFloat);
+
+        tile.clear(Color4f(0.5f));
+        ref_tile.clear(Color4f(0.5f));
+
+        const double rmsd = compute_relative_rms_deviation(tile, ref_tile);
+
+        EXPECT_EQ(0.0, rmsd);
+    }
+
+    TEST_CASE(ComputeRelativeRMSDeviation_GivenTilesWithDifferentColors_ReturnsDeviationRelativeToReference)
+    {
+        Tile tile(2, 2, 4, PixelFormatFloat);
+        Tile ref_tile(2, 2, 4, PixelFormatFloat);
+
+        tile.clear(Color4f(1.5f, 1.5f, 1.5f, 0.0f));
+        ref_tile.clear(Color4f(1.0f, 1.0f, 1.0f, 1.0f));
+
+        const double rmsd = compute_relative_rms_deviation(tile, ref_tile);
+
+        EXPECT_FEQ(std::sqrt(0.25 / 1.01), rmsd);
+    }
+
+    TEST_CASE(ComputeRelativeRMSDeviation_GivenTilesOfDifferentSizes_ThrowsExceptionIncompatibleImages)
+    {
+        Tile tile(2, 2, 4, PixelFormatFloat);
+        Tile ref_tile(2, 4, 4, PixelFormatFloat);
+
+        tile.clear(Color4f(0.0f));
+        ref_tile.clear(Color4f(0.0f));
+
+        EXPECT_EXCEPTION(ExceptionIncompatibleImages,
+        {
+            compute_relative_rms_deviation(tile, ref_tile);
+        });
+    }
 }
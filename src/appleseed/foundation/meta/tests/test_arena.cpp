@@ -0,0 +1,123 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// appleseed.foundation headers.
+#include "foundation/platform/types.h"
+#include "foundation/utility/arena.h"
+#include "foundation/utility/memory.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <cstring>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Utility_Arena)
+{
+    TEST_CASE(Allocate_ReturnsAlignedMemory)
+    {
+        Arena arena;
+
+        EXPECT_TRUE(is_aligned(arena.allocate(3), 16));
+        EXPECT_TRUE(is_aligned(arena.allocate(5), 16));
+    }
+
+    TEST_CASE(AllocateArray_GivenZeroCount_ReturnsNull)
+    {
+        Arena arena;
+
+        EXPECT_EQ(0, arena.allocate_array<float>(0));
+    }
+
+    TEST_CASE(Rewind_ReleasesAllocationsMadeSinceMark)
+    {
+        Arena arena;
+        arena.allocate(64);
+
+        const size_t mark = arena.get_mark();
+        void* ptr1 = arena.allocate(64);
+        arena.rewind(mark);
+        void* ptr2 = arena.allocate(64);
+
+        EXPECT_EQ(ptr1, ptr2);
+    }
+
+    TEST_CASE(Allocate_GivenSizeLargerThanArena_ReturnsUsableMemory)
+    {
+        Arena arena;
+
+        const size_t size = 1024 * 1024;
+        uint8* ptr = static_cast<uint8*>(arena.allocate(size));
+        memset(ptr, 0xFF, size);
+
+        EXPECT_TRUE(is_aligned(ptr, 16));
+    }
+
+    TEST_CASE(Rewind_GivenMarkBeforeHeapAllocations_KeepsArenaUsable)
+    {
+        Arena arena;
+        arena.allocate(64);
+
+        const size_t mark = arena.get_mark();
+        arena.allocate(1024 * 1024);
+        arena.allocate(1024 * 1024);
+        arena.rewind(mark);
+
+        EXPECT_EQ(mark, arena.get_mark());
+    }
+
+#ifndef NDEBUG
+
+    TEST_CASE(GetHeapAllocationCount_GivenAllocationsFittingInArena_ReturnsZero)
+    {
+        Arena arena;
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            arena.clear();
+            arena.allocate_array<double>(100);
+        }
+
+        EXPECT_EQ(0, arena.get_heap_allocation_count());
+    }
+
+    TEST_CASE(GetHeapAllocationCount_GivenAllocationLargerThanArena_CountsHeapAllocation)
+    {
+        Arena arena;
+        arena.allocate(1024 * 1024);
+        arena.clear();
+        arena.allocate(1024 * 1024);
+
+        EXPECT_EQ(2, arena.get_heap_allocation_count());
+    }
+
+#endif
+}
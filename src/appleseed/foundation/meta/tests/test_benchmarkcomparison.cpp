@@ -0,0 +1,136 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/utility/benchmark/benchmarkcomparison.h"
+#include "foundation/utility/benchmark/benchmarkdatapoint.h"
+#include "foundation/utility/benchmark/benchmarkserie.h"
+#include "foundation/utility/test.h"
+
+// Boost headers.
+#include "boost/date_time/gregorian/gregorian.hpp"
+#include "boost/date_time/posix_time/posix_time.hpp"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace boost::gregorian;
+using namespace boost::posix_time;
+using namespace foundation;
+
+TEST_SUITE(Foundation_Utility_Benchmark_BenchmarkComparison)
+{
+    BenchmarkSerie make_serie(const double ticks[], const size_t count)
+    {
+        const ptime Date(date(2017, 3, 14), time_duration(9, 26, 53));
+
+        BenchmarkSerie serie;
+
+        for (size_t i = 0; i < count; ++i)
+            serie.push_back(BenchmarkDataPoint(Date, ticks[i]));
+
+        return serie;
+    }
+
+    TEST_CASE(CompareBenchmarkSeries_GivenSingleMeasurements_ReturnsInconclusive)
+    {
+        const double Baseline[] = { 100.0 };
+        const double Candidate[] = { 200.0 };
+
+        const BenchmarkCaseComparison result =
+            compare_benchmark_series(make_serie(Baseline, 1), make_serie(Candidate, 1));
+
+        EXPECT_EQ(BenchmarkCaseComparison::Inconclusive, result.m_verdict);
+        EXPECT_FEQ(0.5, result.m_speedup);
+    }
+
+    TEST_CASE(CompareBenchmarkSeries_GivenIdenticalSeries_ReturnsUnchanged)
+    {
+        const double Ticks[] = { 100.0, 102.0, 98.0, 101.0 };
+
+        const BenchmarkCaseComparison result =
+            compare_benchmark_series(make_serie(Ticks, 4), make_serie(Ticks, 4));
+
+        EXPECT_EQ(BenchmarkCaseComparison::Unchanged, result.m_verdict);
+        EXPECT_FEQ(1.0, result.m_speedup);
+        EXPECT_GT(1.0, result.m_speedup_high);
+        EXPECT_LT(1.0, result.m_speedup_low);
+    }
+
+    TEST_CASE(CompareBenchmarkSeries_GivenSlowerCandidate_ReturnsRegression)
+    {
+        const double Baseline[] = { 100.0, 102.0, 98.0, 101.0 };
+        const double Candidate[] = { 200.0, 203.0, 197.0, 199.0 };
+
+        const BenchmarkCaseComparison result =
+            compare_benchmark_series(make_serie(Baseline, 4), make_serie(Candidate, 4));
+
+        EXPECT_EQ(BenchmarkCaseComparison::Regression, result.m_verdict);
+        EXPECT_EQ(4, result.m_baseline_count);
+        EXPECT_EQ(4, result.m_candidate_count);
+        EXPECT_FEQ_EPS(0.5, result.m_speedup, 1.0e-2);
+        EXPECT_LT(result.m_speedup, result.m_speedup_low);
+        EXPECT_GT(result.m_speedup, result.m_speedup_high);
+    }
+
+    TEST_CASE(CompareBenchmarkSeries_GivenFasterCandidate_ReturnsImprovement)
+    {
+        const double Baseline[] = { 200.0, 203.0, 197.0, 199.0 };
+        const double Candidate[] = { 100.0, 102.0, 98.0, 101.0 };
+
+        const BenchmarkCaseComparison result =
+            compare_benchmark_series(make_serie(Baseline, 4), make_serie(Candidate, 4));
+
+        EXPECT_EQ(BenchmarkCaseComparison::Improvement, result.m_verdict);
+        EXPECT_FEQ_EPS(2.0, result.m_speedup, 1.0e-2);
+    }
+
+    TEST_CASE(CompareBenchmarkSeries_GivenNoisyOverlappingSeries_ReturnsUnchanged)
+    {
+        const double Baseline[] = { 100.0, 140.0, 80.0, 120.0 };
+        const double Candidate[] = { 110.0, 150.0, 90.0, 125.0 };
+
+        const BenchmarkCaseComparison result =
+            compare_benchmark_series(make_serie(Baseline, 4), make_serie(Candidate, 4));
+
+        EXPECT_EQ(BenchmarkCaseComparison::Unchanged, result.m_verdict);
+        EXPECT_LT(1.0, result.m_speedup);
+    }
+
+    TEST_CASE(CompareBenchmarkSeries_GivenChangeWithinTolerance_ReturnsUnchanged)
+    {
+        const double Baseline[] = { 100.0, 100.1, 99.9, 100.0 };
+        const double Candidate[] = { 101.0, 101.1, 100.9, 101.0 };
+
+        const BenchmarkCaseComparison result =
+            compare_benchmark_series(make_serie(Baseline, 4), make_serie(Candidate, 4), 0.02);
+
+        EXPECT_EQ(BenchmarkCaseComparison::Unchanged, result.m_verdict);
+    }
+}
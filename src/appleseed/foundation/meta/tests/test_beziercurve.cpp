@@ -515,3 +515,101 @@ TEST_SUITE(Foundation_Math_BezierCurveIntersector)
         render_curves_to_image(Curves, countof(Curves), "unit tests/outputs/test_beziercurveintersector_bezier3curve_checkboard.png", true);
     }
 }
+
+TEST_SUITE(Foundation_Math_BezierCurveBatchIntersector)
+{
+    // Return the number of rays for which the batch intersector and the regular intersector disagree.
+    template <typename BezierCurveType>
+    size_t count_mismatches(
+        const BezierCurveType   curves[],
+        const size_t            curve_count)
+    {
+        typedef typename BezierCurveType::ValueType ValueType;
+        typedef typename BezierCurveType::VectorType VectorType;
+        typedef typename BezierCurveType::MatrixType MatrixType;
+        typedef Ray<ValueType, 3> RayType;
+        typedef BezierCurveIntersector<BezierCurveType> IntersectorType;
+        typedef BezierCurveBatchIntersector<BezierCurveType> BatchIntersectorType;
+
+        const size_t GridSize = 64;
+        size_t mismatch_count = 0;
+
+        for (size_t y = 0; y < GridSize; ++y)
+        {
+            for (size_t x = 0; x < GridSize; ++x)
+            {
+                const VectorType origin(
+                    ValueType(2.0) * (x + ValueType(0.5)) / GridSize - ValueType(1.0),
+                    ValueType(2.0) * (y + ValueType(0.5)) / GridSize - ValueType(1.0),
+                    ValueType(-2.0));
+                const RayType ray(origin, VectorType(ValueType(0.1), ValueType(-0.05), ValueType(1.0)));
+
+                MatrixType xfm_matrix;
+                make_curve_projection_transform(xfm_matrix, ray);
+
+                // Intersect the curves one at a time.
+                size_t expected_hit = ~size_t(0);
+                ValueType expected_u, expected_v, expected_t = numeric_limits<ValueType>::max();
+                for (size_t i = 0; i < curve_count; ++i)
+                {
+                    if (IntersectorType::intersect(curves[i], ray, xfm_matrix, expected_u, expected_v, expected_t))
+                        expected_hit = i;
+                }
+
+                // Intersect the curves in batches.
+                size_t hit = ~size_t(0);
+                ValueType u, v, t = numeric_limits<ValueType>::max();
+                bool any_hit = false;
+                for (size_t i = 0; i < curve_count; i += BatchIntersectorType::BatchSize)
+                {
+                    const size_t count = min(BatchIntersectorType::BatchSize, curve_count - i);
+                    const size_t batch_hit = BatchIntersectorType::intersect(curves + i, count, ray, xfm_matrix, u, v, t);
+                    if (batch_hit != ~size_t(0))
+                        hit = i + batch_hit;
+                    any_hit = any_hit || BatchIntersectorType::intersect(curves + i, count, ray, xfm_matrix);
+                }
+
+                if (hit != expected_hit ||
+                    any_hit != (expected_hit != ~size_t(0)) ||
+                    (hit != ~size_t(0) && (t != expected_t || u != expected_u || v != expected_v)))
+                    ++mismatch_count;
+            }
+        }
+
+        return mismatch_count;
+    }
+
+    TEST_CASE(Intersect_GivenBezier1Curves_MatchesBezierCurveIntersector)
+    {
+        vector<BezierCurve1f> curves;
+
+        for (size_t i = 0; i < 11; ++i)
+        {
+            const float x = -0.9f + 0.17f * i;
+            const Vector3f ControlPoints[] = { Vector3f(x, -0.8f, 0.1f * i), Vector3f(x + 0.3f, 0.8f, 0.0f) };
+            curves.push_back(BezierCurve1f(ControlPoints, 0.04f));
+        }
+
+        EXPECT_EQ(0, count_mismatches(&curves[0], curves.size()));
+    }
+
+    TEST_CASE(Intersect_GivenBezier3Curves_MatchesBezierCurveIntersector)
+    {
+        vector<BezierCurve3f> curves;
+
+        for (size_t i = 0; i < 11; ++i)
+        {
+            const float y = -0.9f + 0.17f * i;
+            const Vector3f ControlPoints[] =
+            {
+                Vector3f(-0.8f, y, 0.0f),
+                Vector3f(-0.3f, y + 0.4f, 0.2f),
+                Vector3f( 0.3f, y - 0.4f, -0.2f),
+                Vector3f( 0.8f, y, 0.05f * i)
+            };
+            curves.push_back(BezierCurve3f(ControlPoints, 0.05f));
+        }
+
+        EXPECT_EQ(0, count_mismatches(&curves[0], curves.size()));
+    }
+}
@@ -0,0 +1,217 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/mesh/binarymeshfilereader.h"
+#include "foundation/mesh/binarymeshfilewriter.h"
+#include "foundation/mesh/imeshbuilder.h"
+#include "foundation/mesh/imeshwalker.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Mesh_BinaryMeshFile)
+{
+    const char* Filepath = "unit tests/outputs/test_binarymeshfile.binarymesh";
+
+    // A unit square made of a single quad.
+    class QuadMeshWalker
+      : public IMeshWalker
+    {
+      public:
+        virtual const char* get_name() const APPLESEED_OVERRIDE { return "quad"; }
+
+        virtual size_t get_vertex_count() const APPLESEED_OVERRIDE { return 4; }
+        virtual Vector3d get_vertex(const size_t i) const APPLESEED_OVERRIDE
+        {
+            return Vector3d(i == 1 || i == 2 ? 1.0 : 0.0, i >= 2 ? 1.0 : 0.0, 0.0);
+        }
+
+        virtual size_t get_vertex_normal_count() const APPLESEED_OVERRIDE { return 1; }
+        virtual Vector3d get_vertex_normal(const size_t i) const APPLESEED_OVERRIDE { return Vector3d(0.0, 0.0, 2.0); }
+
+        virtual size_t get_tex_coords_count() const APPLESEED_OVERRIDE { return 0; }
+        virtual Vector2d get_tex_coords(const size_t i) const APPLESEED_OVERRIDE { return Vector2d(0.0); }
+
+        virtual size_t get_material_slot_count() const APPLESEED_OVERRIDE { return 1; }
+        virtual const char* get_material_slot(const size_t i) const APPLESEED_OVERRIDE { return "default"; }
+
+        virtual size_t get_face_count() const APPLESEED_OVERRIDE { return 1; }
+        virtual size_t get_face_vertex_count(const size_t face_index) const APPLESEED_OVERRIDE { return 4; }
+        virtual size_t get_face_vertex(const size_t face_index, const size_t vertex_index) const APPLESEED_OVERRIDE { return vertex_index; }
+        virtual size_t get_face_vertex_normal(const size_t face_index, const size_t vertex_index) const APPLESEED_OVERRIDE { return 0; }
+        virtual size_t get_face_tex_coords(const size_t face_index, const size_t vertex_index) const APPLESEED_OVERRIDE { return None; }
+        virtual size_t get_face_material(const size_t face_index) const APPLESEED_OVERRIDE { return 0; }
+    };
+
+    class MeshBuilder
+      : public IMeshBuilder
+    {
+      public:
+        string              m_name;
+        vector<Vector3d>    m_vertices;
+        vector<Vector3d>    m_vertex_normals;
+        vector<string>      m_material_slots;
+        vector<size_t>      m_face_vertices;
+        size_t              m_face_count;
+        bool                m_received_arrays;
+
+        explicit MeshBuilder(const bool accept_arrays)
+          : m_face_count(0)
+          , m_received_arrays(false)
+          , m_accept_arrays(accept_arrays)
+        {
+        }
+
+        virtual void begin_mesh(const char* name) APPLESEED_OVERRIDE { m_name = name; }
+
+        virtual size_t push_vertex(const Vector3d& v) APPLESEED_OVERRIDE
+        {
+            m_vertices.push_back(v);
+            return m_vertices.size() - 1;
+        }
+
+        virtual size_t push_vertex_normal(const Vector3d& v) APPLESEED_OVERRIDE
+        {
+            m_vertex_normals.push_back(v);
+            return m_vertex_normals.size() - 1;
+        }
+
+        virtual size_t push_tex_coords(const Vector2d& v) APPLESEED_OVERRIDE { return 0; }
+
+        virtual size_t push_material_slot(const char* name) APPLESEED_OVERRIDE
+        {
+            m_material_slots.push_back(name);
+            return m_material_slots.size() - 1;
+        }
+
+        virtual bool push_triangle_arrays(const TriangleMeshArrays& arrays) APPLESEED_OVERRIDE
+        {
+            if (!m_accept_arrays)
+                return false;
+
+            m_received_arrays = true;
+
+            for (size_t i = 0; i < arrays.m_vertex_count; ++i)
+            {
+                const float* v = arrays.m_vertices + i * 3;
+                push_vertex(Vector3d(v[0], v[1], v[2]));
+            }
+
+            for (size_t i = 0; i < arrays.m_vertex_normal_count; ++i)
+            {
+                const float* n = arrays.m_vertex_normals + i * 3;
+                push_vertex_normal(Vector3d(n[0], n[1], n[2]));
+            }
+
+            for (size_t i = 0; i < arrays.m_triangle_count; ++i)
+            {
+                for (size_t j = 0; j < 3; ++j)
+                    m_face_vertices.push_back(arrays.m_triangles[i * 10 + j]);
+            }
+
+            m_face_count += arrays.m_triangle_count;
+
+            return true;
+        }
+
+        virtual void begin_face(const size_t vertex_count) APPLESEED_OVERRIDE { ++m_face_count; }
+
+        virtual void set_face_vertices(const size_t vertices[]) APPLESEED_OVERRIDE
+        {
+            m_face_vertices.insert(m_face_vertices.end(), vertices, vertices + 3);
+        }
+
+        virtual void set_face_vertex_normals(const size_t vertex_normals[]) APPLESEED_OVERRIDE {}
+        virtual void set_face_vertex_tex_coords(const size_t tex_coords[]) APPLESEED_OVERRIDE {}
+        virtual void set_face_material(const size_t material) APPLESEED_OVERRIDE {}
+        virtual void end_face() APPLESEED_OVERRIDE {}
+        virtual void end_mesh() APPLESEED_OVERRIDE {}
+
+      private:
+        const bool m_accept_arrays;
+    };
+
+    void write_quad_mesh_file()
+    {
+        BinaryMeshFileWriter writer(Filepath, BinaryMeshFileWriter::MappableFormat);
+        writer.write(QuadMeshWalker());
+    }
+
+    TEST_CASE(Read_GivenMappableFileAndBuilderAcceptingArrays_ProvidesTriangulatedArrays)
+    {
+        write_quad_mesh_file();
+
+        MeshBuilder builder(true);
+        BinaryMeshFileReader reader(Filepath);
+        reader.read(builder);
+
+        EXPECT_TRUE(builder.m_received_arrays);
+        EXPECT_EQ("quad", builder.m_name);
+        ASSERT_EQ(4, builder.m_vertices.size());
+        EXPECT_EQ(Vector3d(1.0, 1.0, 0.0), builder.m_vertices[2]);
+        ASSERT_EQ(1, builder.m_vertex_normals.size());
+        EXPECT_EQ(Vector3d(0.0, 0.0, 1.0), builder.m_vertex_normals[0]);
+        ASSERT_EQ(1, builder.m_material_slots.size());
+        EXPECT_EQ("default", builder.m_material_slots[0]);
+        EXPECT_EQ(2, builder.m_face_count);
+        EXPECT_EQ(6, builder.m_face_vertices.size());
+    }
+
+    TEST_CASE(Read_GivenMappableFileAndBuilderRefusingArrays_ProvidesTriangles)
+    {
+        write_quad_mesh_file();
+
+        MeshBuilder builder(false);
+        BinaryMeshFileReader reader(Filepath);
+        reader.read(builder);
+
+        EXPECT_FALSE(builder.m_received_arrays);
+        EXPECT_EQ("quad", builder.m_name);
+        ASSERT_EQ(4, builder.m_vertices.size());
+        EXPECT_EQ(Vector3d(1.0, 1.0, 0.0), builder.m_vertices[2]);
+        ASSERT_EQ(1, builder.m_vertex_normals.size());
+        EXPECT_EQ(Vector3d(0.0, 0.0, 1.0), builder.m_vertex_normals[0]);
+        ASSERT_EQ(1, builder.m_material_slots.size());
+        EXPECT_EQ("default", builder.m_material_slots[0]);
+        EXPECT_EQ(2, builder.m_face_count);
+        EXPECT_EQ(6, builder.m_face_vertices.size());
+    }
+}
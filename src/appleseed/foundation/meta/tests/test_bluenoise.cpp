@@ -0,0 +1,95 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.foundation headers.
+#include "foundation/math/bluenoise.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Math_BlueNoise)
+{
+    TEST_CASE(BlueNoiseMask_IsPermutation)
+    {
+        const size_t PixelCount = BlueNoiseMaskSize * BlueNoiseMaskSize;
+        vector<bool> seen(PixelCount, false);
+
+        for (size_t i = 0; i < PixelCount; ++i)
+        {
+            ASSERT_TRUE(BlueNoiseMask[i] < PixelCount);
+            EXPECT_FALSE(seen[BlueNoiseMask[i]]);
+            seen[BlueNoiseMask[i]] = true;
+        }
+    }
+
+    TEST_CASE(BlueNoise_IsTileable)
+    {
+        for (size_t d = 0; d < 4; ++d)
+        {
+            EXPECT_EQ(
+                blue_noise<double>(3, 5, d),
+                blue_noise<double>(3 + BlueNoiseMaskSize, 5 + 2 * BlueNoiseMaskSize, d));
+        }
+    }
+
+    TEST_CASE(BlueNoise_ReturnsValuesInUnitInterval)
+    {
+        for (size_t y = 0; y < BlueNoiseMaskSize; ++y)
+        {
+            for (size_t x = 0; x < BlueNoiseMaskSize; ++x)
+            {
+                const float value = blue_noise<float>(x, y, 1);
+
+                EXPECT_TRUE(value > 0.0f);
+                EXPECT_TRUE(value < 1.0f);
+            }
+        }
+    }
+
+    TEST_CASE(BlueNoise_GivenDifferentDimensions_ReturnsShiftedMasks)
+    {
+        size_t equal_count = 0;
+
+        for (size_t y = 0; y < BlueNoiseMaskSize; ++y)
+        {
+            for (size_t x = 0; x < BlueNoiseMaskSize; ++x)
+            {
+                if (blue_noise<double>(x, y, 0) == blue_noise<double>(x, y, 1))
+                    ++equal_count;
+            }
+        }
+
+        EXPECT_EQ(0, equal_count);
+    }
+}
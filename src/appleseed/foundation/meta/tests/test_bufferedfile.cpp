@@ -30,11 +30,14 @@
 // appleseed.foundation headers.
 #include "foundation/platform/types.h"
 #include "foundation/utility/bufferedfile.h"
+#include "foundation/utility/iostreamop.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 using namespace std;
@@ -276,3 +279,70 @@ TEST_SUITE(Foundation_Utility_BufferedFile)
         EXPECT_EQ(Value2, value);
     }
 }
+
+TEST_SUITE(Foundation_Utility_LZ4CompressedAdapters)
+{
+    const char* Filename = "unit tests/outputs/test_bufferedfile_lz4.tmp";
+    const size_t CompressionBufferSize = 1024;
+
+    vector<uint32> make_data()
+    {
+        // Enough data for several batches of blocks, with a trailing partial block.
+        vector<uint32> data(64 * 1024 + 17);
+
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = static_cast<uint32>((i * 2654435761UL) >> (i % 13));
+
+        return data;
+    }
+
+    void write_data(const vector<uint32>& data, const size_t thread_count)
+    {
+        BufferedFile file(Filename, BufferedFile::BinaryType, BufferedFile::WriteMode);
+        LZ4CompressedWriterAdapter writer(file, CompressionBufferSize, thread_count);
+
+        // Write in pieces that do not line up with the compression buffer.
+        const size_t PieceSize = 333;
+        for (size_t i = 0; i < data.size(); i += PieceSize)
+            writer.write(&data[i], min(PieceSize, data.size() - i) * sizeof(uint32));
+    }
+
+    vector<uint32> read_data(const size_t size, const size_t thread_count)
+    {
+        BufferedFile file(Filename, BufferedFile::BinaryType, BufferedFile::ReadMode);
+        LZ4CompressedReaderAdapter reader(file, thread_count);
+
+        vector<uint32> data(size + 1);
+        const size_t bytes_read = reader.read(&data[0], data.size() * sizeof(uint32));
+        data.resize(bytes_read / sizeof(uint32));
+
+        return data;
+    }
+
+    TEST_CASE(ParallelReader_GivenFileWrittenWithSerialWriter_ReadsOriginalData)
+    {
+        const vector<uint32> data = make_data();
+
+        write_data(data, 1);
+
+        EXPECT_EQ(data, read_data(data.size(), 4));
+    }
+
+    TEST_CASE(SerialReader_GivenFileWrittenWithParallelWriter_ReadsOriginalData)
+    {
+        const vector<uint32> data = make_data();
+
+        write_data(data, 4);
+
+        EXPECT_EQ(data, read_data(data.size(), 1));
+    }
+
+    TEST_CASE(ParallelReader_GivenFileWrittenWithParallelWriter_ReadsOriginalData)
+    {
+        const vector<uint32> data = make_data();
+
+        write_data(data, 3);
+
+        EXPECT_EQ(data, read_data(data.size(), 5));
+    }
+}
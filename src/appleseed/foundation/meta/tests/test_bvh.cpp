@@ -30,13 +30,20 @@
 // appleseed.foundation headers.
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
+#include "foundation/math/intersection/rayaabb.h"
 #include "foundation/math/ray.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/sampling/mappings.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/timers.h"
 #include "foundation/utility/alignedvector.h"
 #include "foundation/utility/iostreamop.h"
+#include "foundation/utility/log.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <vector>
 
@@ -74,6 +81,922 @@ TEST_SUITE(Foundation_Math_BVH_Node)
     }
 }
 
+TEST_SUITE(Foundation_Math_BVH_WideNode)
+{
+    TEST_CASE(TestStorageAndRetrievalOfChildren)
+    {
+        static const AABB3d LeftBBox(Vector3d(1.0, 2.0, 3.0), Vector3d(4.0, 5.0, 6.0));
+        static const AABB3d RightBBox(Vector3d(7.0, 8.0, 9.0), Vector3d(10.0, 11.0, 12.0));
+
+        bvh::WideNode<AABB3d, 4> node;
+
+        node.add_child(LeftBBox, 12, false);
+        node.add_child(RightBBox, 34, true);
+
+        EXPECT_EQ(2, node.get_child_count());
+        EXPECT_EQ(LeftBBox, node.get_child_bbox(0));
+        EXPECT_EQ(RightBBox, node.get_child_bbox(1));
+        EXPECT_EQ(12, node.get_child_index(0));
+        EXPECT_EQ(34, node.get_child_index(1));
+        EXPECT_FALSE(node.is_leaf_child(0));
+        EXPECT_TRUE(node.is_leaf_child(1));
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_WideIntersector)
+{
+    typedef bvh::Tree<AlignedVector<bvh::Node<AABB3d> > > Tree;
+    typedef vector<AABB3d> AABBVector;
+
+    struct Visitor
+    {
+        const AABBVector&       m_bboxes;
+        const vector<size_t>&   m_ordering;
+        size_t                  m_hit_item;
+        double                  m_hit_distance;
+
+        Visitor(
+            const AABBVector&       bboxes,
+            const vector<size_t>&   ordering,
+            const double            tmax)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+          , m_hit_item(~size_t(0))
+          , m_hit_distance(tmax)
+        {
+        }
+
+        bool visit(
+            const Tree::NodeType&       node,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            const size_t begin = node.get_item_index();
+            const size_t end = begin + node.get_item_count();
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const size_t item = m_ordering[i];
+                double tmin;
+                if (intersect(ray, ray_info, m_bboxes[item], tmin) && tmin < m_hit_distance)
+                {
+                    m_hit_item = item;
+                    m_hit_distance = tmin;
+                }
+            }
+
+            distance = m_hit_distance;
+            return true;
+        }
+    };
+
+    void compute_closest_hits(
+        const Tree&             tree,
+        const AABBVector&       bboxes,
+        const vector<size_t>&   ordering,
+        vector<size_t>&         hits)
+    {
+        MersenneTwister rng;
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        bvh::TraversalStatistics stats;
+#endif
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            Vector2d s;
+            s[0] = rand_double2(rng);
+            s[1] = rand_double2(rng);
+            const Vector3d dir = sample_sphere_uniform(s);
+            const Ray3d ray(-20.0 * dir + Vector3d(rand_double1(rng, -4.0, 4.0)), dir, 0.0, 40.0);
+            const RayInfo3d ray_info(ray);
+
+            Visitor visitor(bboxes, ordering, ray.m_tmax);
+            bvh::Intersector<Tree, Visitor, Ray3d> intersector;
+            intersector.intersect_no_motion(
+                tree,
+                ray,
+                ray_info,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+
+            hits.push_back(visitor.m_hit_item);
+        }
+    }
+
+    TEST_CASE(WideTraversalFindsSameClosestHitsAsBinaryTraversal)
+    {
+        // A grid of small boxes.
+        AABBVector bboxes;
+        for (size_t z = 0; z < 6; ++z)
+        {
+            for (size_t y = 0; y < 6; ++y)
+            {
+                for (size_t x = 0; x < 6; ++x)
+                {
+                    const Vector3d p(
+                        static_cast<double>(x) - 3.0,
+                        static_cast<double>(y) - 3.0,
+                        static_cast<double>(z) - 3.0);
+                    bboxes.push_back(AABB3d(p, p + Vector3d(0.5)));
+                }
+            }
+        }
+
+        typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+        Partitioner partitioner(bboxes);
+
+        Tree tree;
+        bvh::Builder<Tree, Partitioner> builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 1);
+
+        vector<size_t> binary_hits;
+        compute_closest_hits(tree, bboxes, partitioner.get_item_ordering(), binary_hits);
+
+        bvh::Collapser<Tree> collapser;
+        collapser.collapse<DefaultWallclockTimer>(tree);
+        ASSERT_TRUE(tree.has_wide_nodes());
+
+        vector<size_t> wide_hits;
+        compute_closest_hits(tree, bboxes, partitioner.get_item_ordering(), wide_hits);
+
+        EXPECT_EQ(binary_hits, wide_hits);
+    }
+
+    struct CountingVisitor
+      : public Visitor
+    {
+        size_t                  m_visit_count;
+
+        CountingVisitor(
+            const AABBVector&       bboxes,
+            const vector<size_t>&   ordering,
+            const double            tmax)
+          : Visitor(bboxes, ordering, tmax)
+          , m_visit_count(0)
+        {
+        }
+
+        bool visit(
+            const Tree::NodeType&       node,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            ++m_visit_count;
+
+            return
+                Visitor::visit(
+                    node,
+                    ray,
+                    ray_info,
+                    distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , stats
+#endif
+                    );
+        }
+    };
+
+    TEST_CASE(TraversalCounters_CountVisitedLeavesOfBinaryAndWideTraversals)
+    {
+        AABBVector bboxes;
+        for (size_t x = 0; x < 32; ++x)
+        {
+            const Vector3d p(static_cast<double>(x) - 16.0, 0.0, 0.0);
+            bboxes.push_back(AABB3d(p, p + Vector3d(0.5)));
+        }
+
+        typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+        Partitioner partitioner(bboxes);
+
+        Tree tree;
+        bvh::Builder<Tree, Partitioner> builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 1);
+
+        const Ray3d ray(Vector3d(-20.0, 0.25, 0.25), Vector3d(1.0, 0.0, 0.0), 0.0, 40.0);
+        const RayInfo3d ray_info(ray);
+
+        for (size_t pass = 0; pass < 2; ++pass)
+        {
+            if (pass == 1)
+            {
+                bvh::Collapser<Tree> collapser;
+                collapser.collapse<DefaultWallclockTimer>(tree);
+            }
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            bvh::TraversalStatistics stats;
+#endif
+
+            CountingVisitor visitor(bboxes, partitioner.get_item_ordering(), ray.m_tmax);
+            bvh::TraversalCounters counters;
+            bvh::Intersector<Tree, CountingVisitor, Ray3d> intersector;
+            intersector.intersect_no_motion(
+                tree,
+                ray,
+                ray_info,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                , &counters);
+
+            EXPECT_EQ(visitor.m_visit_count, counters.m_visited_leaves);
+            EXPECT_GT(counters.m_visited_leaves, counters.m_visited_nodes);
+        }
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_QuantizedNode)
+{
+    typedef bvh::QuantizedNode<AABB3d> QuantizedNodeType;
+
+    TEST_CASE(GetChildBBox_ReturnsBoxEnclosingOriginalBox)
+    {
+        const AABB3d left_bbox(Vector3d(-1.3, 0.1, 1000.0), Vector3d(0.7, 0.2, 1000.001));
+        const AABB3d right_bbox(Vector3d(0.3, -5.0, 1000.0005), Vector3d(2.9, 0.15, 1000.0007));
+
+        QuantizedNodeType node;
+        node.set_child_bboxes(left_bbox, right_bbox);
+
+        const AABB3d qleft_bbox = node.get_child_bbox(0);
+        const AABB3d qright_bbox = node.get_child_bbox(1);
+
+        for (size_t d = 0; d < 3; ++d)
+        {
+            EXPECT_TRUE(qleft_bbox.min[d] <= left_bbox.min[d]);
+            EXPECT_TRUE(qleft_bbox.max[d] >= left_bbox.max[d]);
+            EXPECT_TRUE(qright_bbox.min[d] <= right_bbox.min[d]);
+            EXPECT_TRUE(qright_bbox.max[d] >= right_bbox.max[d]);
+        }
+    }
+
+    TEST_CASE(SetChildIndex_GivenLeafChild_MarksChildAsLeaf)
+    {
+        QuantizedNodeType node;
+        node.set_child_index(0, 12, false);
+        node.set_child_index(1, 7, true);
+
+        EXPECT_EQ(12, node.get_child_index(0));
+        EXPECT_EQ(7, node.get_child_index(1));
+        EXPECT_FALSE(node.is_leaf_child(0));
+        EXPECT_TRUE(node.is_leaf_child(1));
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_QuantizedIntersector)
+{
+    typedef bvh::Tree<AlignedVector<bvh::Node<AABB3d> > > Tree;
+    typedef vector<AABB3d> AABBVector;
+
+    struct Visitor
+    {
+        const AABBVector&       m_bboxes;
+        const vector<size_t>&   m_ordering;
+        size_t                  m_hit_item;
+        double                  m_hit_distance;
+
+        Visitor(
+            const AABBVector&       bboxes,
+            const vector<size_t>&   ordering,
+            const double            tmax)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+          , m_hit_item(~size_t(0))
+          , m_hit_distance(tmax)
+        {
+        }
+
+        bool visit(
+            const Tree::NodeType&       node,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            const size_t begin = node.get_item_index();
+            const size_t end = begin + node.get_item_count();
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const size_t item = m_ordering[i];
+                double tmin;
+                if (intersect(ray, ray_info, m_bboxes[item], tmin) && tmin < m_hit_distance)
+                {
+                    m_hit_item = item;
+                    m_hit_distance = tmin;
+                }
+            }
+
+            distance = m_hit_distance;
+            return true;
+        }
+    };
+
+    void compute_closest_hits(
+        const Tree&             tree,
+        const AABBVector&       bboxes,
+        const vector<size_t>&   ordering,
+        vector<size_t>&         hits)
+    {
+        MersenneTwister rng;
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        bvh::TraversalStatistics stats;
+#endif
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            Vector2d s;
+            s[0] = rand_double2(rng);
+            s[1] = rand_double2(rng);
+            const Vector3d dir = sample_sphere_uniform(s);
+            const Ray3d ray(-20.0 * dir + Vector3d(rand_double1(rng, -4.0, 4.0)), dir, 0.0, 40.0);
+            const RayInfo3d ray_info(ray);
+
+            Visitor visitor(bboxes, ordering, ray.m_tmax);
+            bvh::Intersector<Tree, Visitor, Ray3d> intersector;
+            intersector.intersect_no_motion(
+                tree,
+                ray,
+                ray_info,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+
+            hits.push_back(visitor.m_hit_item);
+        }
+    }
+
+    TEST_CASE(QuantizedTraversalFindsSameClosestHitsAsBinaryTraversal)
+    {
+        // A grid of small boxes.
+        AABBVector bboxes;
+        for (size_t z = 0; z < 6; ++z)
+        {
+            for (size_t y = 0; y < 6; ++y)
+            {
+                for (size_t x = 0; x < 6; ++x)
+                {
+                    const Vector3d p(
+                        static_cast<double>(x) - 3.0,
+                        static_cast<double>(y) - 3.0,
+                        static_cast<double>(z) - 3.0);
+                    bboxes.push_back(AABB3d(p, p + Vector3d(0.5)));
+                }
+            }
+        }
+
+        typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+        Partitioner partitioner(bboxes);
+
+        Tree tree;
+        bvh::Builder<Tree, Partitioner> builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 1);
+
+        vector<size_t> binary_hits;
+        compute_closest_hits(tree, bboxes, partitioner.get_item_ordering(), binary_hits);
+
+        const size_t binary_memory_size = tree.get_memory_size();
+
+        bvh::Quantizer<Tree> quantizer;
+        quantizer.quantize<DefaultWallclockTimer>(tree);
+        ASSERT_TRUE(tree.has_quantized_nodes());
+        EXPECT_GT(tree.get_memory_size(), binary_memory_size);
+
+        vector<size_t> quantized_hits;
+        compute_closest_hits(tree, bboxes, partitioner.get_item_ordering(), quantized_hits);
+
+        EXPECT_EQ(binary_hits, quantized_hits);
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_PacketIntersector)
+{
+    typedef bvh::Tree<AlignedVector<bvh::Node<AABB3d> > > Tree;
+    typedef vector<AABB3d> AABBVector;
+
+    struct PacketVisitor
+    {
+        const AABBVector&       m_bboxes;
+        const vector<size_t>&   m_ordering;
+        size_t*                 m_hit_items;
+        double*                 m_hit_distances;
+
+        PacketVisitor(
+            const AABBVector&       bboxes,
+            const vector<size_t>&   ordering,
+            size_t                  hit_items[],
+            double                  hit_distances[])
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+          , m_hit_items(hit_items)
+          , m_hit_distances(hit_distances)
+        {
+        }
+
+        bool visit(
+            const Tree::NodeType&       node,
+            const size_t                ray_index,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            const size_t begin = node.get_item_index();
+            const size_t end = begin + node.get_item_count();
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const size_t item = m_ordering[i];
+                double tmin;
+                if (intersect(ray, ray_info, m_bboxes[item], tmin) && tmin < m_hit_distances[ray_index])
+                {
+                    m_hit_items[ray_index] = item;
+                    m_hit_distances[ray_index] = tmin;
+                }
+            }
+
+            distance = m_hit_distances[ray_index];
+            return true;
+        }
+    };
+
+    struct Visitor
+      : public PacketVisitor
+    {
+        Visitor(
+            const AABBVector&       bboxes,
+            const vector<size_t>&   ordering,
+            size_t                  hit_items[],
+            double                  hit_distances[])
+          : PacketVisitor(bboxes, ordering, hit_items, hit_distances)
+        {
+        }
+
+        bool visit(
+            const Tree::NodeType&       node,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            return
+                PacketVisitor::visit(
+                    node,
+                    0,
+                    ray,
+                    ray_info,
+                    distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , stats
+#endif
+                    );
+        }
+    };
+
+    TEST_CASE(PacketTraversalFindsSameClosestHitsAsSingleRayTraversal)
+    {
+        // A grid of small boxes.
+        AABBVector bboxes;
+        for (size_t z = 0; z < 6; ++z)
+        {
+            for (size_t y = 0; y < 6; ++y)
+            {
+                for (size_t x = 0; x < 6; ++x)
+                {
+                    const Vector3d p(
+                        static_cast<double>(x) - 3.0,
+                        static_cast<double>(y) - 3.0,
+                        static_cast<double>(z) - 3.0);
+                    bboxes.push_back(AABB3d(p, p + Vector3d(0.5)));
+                }
+            }
+        }
+
+        typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+        Partitioner partitioner(bboxes);
+
+        Tree tree;
+        bvh::Builder<Tree, Partitioner> builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 1);
+
+        typedef bvh::PacketIntersector<Tree, PacketVisitor, Ray3d> PacketIntersector;
+        const size_t PacketSize = PacketIntersector::MaxPacketSize;
+
+        MersenneTwister rng;
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        bvh::TraversalStatistics stats;
+#endif
+
+        size_t hit_count = 0;
+        size_t mismatch_count = 0;
+
+        for (size_t p = 0; p < 32; ++p)
+        {
+            // A packet of rays with directions in the positive octant.
+            Ray3d rays[PacketSize];
+            RayInfo3d ray_infos[PacketSize];
+            const Ray3d* ray_ptrs[PacketSize];
+            for (size_t i = 0; i < PacketSize; ++i)
+            {
+                const Vector3d dir =
+                    normalize(
+                        Vector3d(
+                            rand_double1(rng, 0.1, 1.0),
+                            rand_double1(rng, 0.1, 1.0),
+                            rand_double1(rng, 0.1, 1.0)));
+                rays[i] = Ray3d(Vector3d(-10.0) + Vector3d(rand_double1(rng, -4.0, 4.0)), dir, 0.0, 40.0);
+                ray_infos[i] = RayInfo3d(rays[i]);
+                ray_ptrs[i] = &rays[i];
+            }
+
+            ASSERT_TRUE(PacketIntersector::is_coherent(ray_infos, PacketSize));
+
+            size_t packet_hit_items[PacketSize];
+            double packet_hit_distances[PacketSize];
+            for (size_t i = 0; i < PacketSize; ++i)
+            {
+                packet_hit_items[i] = ~size_t(0);
+                packet_hit_distances[i] = rays[i].m_tmax;
+            }
+
+            PacketVisitor packet_visitor(bboxes, partitioner.get_item_ordering(), packet_hit_items, packet_hit_distances);
+            PacketIntersector packet_intersector;
+            packet_intersector.intersect_no_motion(
+                tree,
+                ray_ptrs,
+                ray_infos,
+                PacketSize,
+                packet_visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+
+            for (size_t i = 0; i < PacketSize; ++i)
+            {
+                size_t hit_item = ~size_t(0);
+                double hit_distance = rays[i].m_tmax;
+
+                Visitor visitor(bboxes, partitioner.get_item_ordering(), &hit_item, &hit_distance);
+                bvh::Intersector<Tree, Visitor, Ray3d> intersector;
+                intersector.intersect_no_motion(
+                    tree,
+                    rays[i],
+                    ray_infos[i],
+                    visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                    , stats
+#endif
+                    );
+
+                if (hit_item != ~size_t(0))
+                    ++hit_count;
+
+                if (hit_item != packet_hit_items[i])
+                    ++mismatch_count;
+            }
+        }
+
+        EXPECT_GT(0, hit_count);
+        EXPECT_EQ(0, mismatch_count);
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_BinnedSAHPartitioner)
+{
+    typedef vector<AABB3d> AABBVector;
+
+    TEST_CASE(Partition_TwoClustersOfItems_SeparatesClusters)
+    {
+        AABBVector bboxes;
+        bboxes.push_back(AABB3d(Vector3d(10.0, 0.0, 0.0), Vector3d(11.0, 1.0, 1.0)));
+        bboxes.push_back(AABB3d(Vector3d(0.0, 0.0, 0.0), Vector3d(1.0, 1.0, 1.0)));
+        bboxes.push_back(AABB3d(Vector3d(10.5, 0.0, 0.0), Vector3d(11.5, 1.0, 1.0)));
+        bboxes.push_back(AABB3d(Vector3d(0.5, 0.0, 0.0), Vector3d(1.5, 1.0, 1.0)));
+
+        typedef bvh::BinnedSAHPartitioner<AABBVector> Partitioner;
+        Partitioner partitioner(bboxes);
+
+        const size_t pivot = partitioner.partition(0, 4, partitioner.compute_bbox(0, 4));
+
+        ASSERT_EQ(2, pivot);
+
+        const vector<size_t>& ordering = partitioner.get_item_ordering();
+        EXPECT_TRUE(ordering[0] == 1 || ordering[0] == 3);
+        EXPECT_TRUE(ordering[1] == 1 || ordering[1] == 3);
+        EXPECT_TRUE(ordering[2] == 0 || ordering[2] == 2);
+        EXPECT_TRUE(ordering[3] == 0 || ordering[3] == 2);
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_ParallelBuilder)
+{
+    typedef bvh::Tree<AlignedVector<bvh::Node<AABB3d> > > Tree;
+    typedef vector<AABB3d> AABBVector;
+
+    struct Visitor
+    {
+        const AABBVector&       m_bboxes;
+        const vector<size_t>&   m_ordering;
+        size_t                  m_hit_item;
+        double                  m_hit_distance;
+
+        Visitor(
+            const AABBVector&       bboxes,
+            const vector<size_t>&   ordering,
+            const double            tmax)
+          : m_bboxes(bboxes)
+          , m_ordering(ordering)
+          , m_hit_item(~size_t(0))
+          , m_hit_distance(tmax)
+        {
+        }
+
+        bool visit(
+            const Tree::NodeType&       node,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            const size_t begin = node.get_item_index();
+            const size_t end = begin + node.get_item_count();
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const size_t item = m_ordering[i];
+                double tmin;
+                if (intersect(ray, ray_info, m_bboxes[item], tmin) && tmin < m_hit_distance)
+                {
+                    m_hit_item = item;
+                    m_hit_distance = tmin;
+                }
+            }
+
+            distance = m_hit_distance;
+            return true;
+        }
+    };
+
+    void compute_closest_hits(
+        const Tree&             tree,
+        const AABBVector&       bboxes,
+        const vector<size_t>&   ordering,
+        vector<size_t>&         hits)
+    {
+        MersenneTwister rng;
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        bvh::TraversalStatistics stats;
+#endif
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            Vector2d s;
+            s[0] = rand_double2(rng);
+            s[1] = rand_double2(rng);
+            const Vector3d dir = sample_sphere_uniform(s);
+            const Ray3d ray(-20.0 * dir + Vector3d(rand_double1(rng, -8.0, 8.0)), dir, 0.0, 40.0);
+            const RayInfo3d ray_info(ray);
+
+            Visitor visitor(bboxes, ordering, ray.m_tmax);
+            bvh::Intersector<Tree, Visitor, Ray3d> intersector;
+            intersector.intersect_no_motion(
+                tree,
+                ray,
+                ray_info,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , stats
+#endif
+                );
+
+            hits.push_back(visitor.m_hit_item);
+        }
+    }
+
+    TEST_CASE(ParallelBuildFindsSameClosestHitsAsSerialBuild)
+    {
+        // A grid of small boxes, large enough to be split into several subtrees.
+        AABBVector bboxes;
+        for (size_t z = 0; z < 16; ++z)
+        {
+            for (size_t y = 0; y < 16; ++y)
+            {
+                for (size_t x = 0; x < 16; ++x)
+                {
+                    const Vector3d p(
+                        static_cast<double>(x) - 8.0,
+                        static_cast<double>(y) - 8.0,
+                        static_cast<double>(z) - 8.0);
+                    bboxes.push_back(AABB3d(p, p + Vector3d(0.5)));
+                }
+            }
+        }
+
+        typedef bvh::SAHPartitioner<AABBVector> SerialPartitioner;
+        SerialPartitioner serial_partitioner(bboxes);
+        Tree serial_tree;
+        bvh::Builder<Tree, SerialPartitioner> serial_builder;
+        serial_builder.build<DefaultWallclockTimer>(serial_tree, serial_partitioner, bboxes.size(), 1);
+
+        typedef bvh::BinnedSAHPartitioner<AABBVector> ParallelPartitioner;
+        ParallelPartitioner parallel_partitioner(bboxes);
+        Tree parallel_tree;
+        Logger logger;
+        bvh::ParallelBuilder<Tree, ParallelPartitioner> parallel_builder;
+        parallel_builder.build<DefaultWallclockTimer>(parallel_tree, parallel_partitioner, bboxes.size(), 1, logger, 4);
+        EXPECT_GT(1, parallel_builder.get_subtree_count());
+
+        vector<size_t> serial_hits;
+        compute_closest_hits(serial_tree, bboxes, serial_partitioner.get_item_ordering(), serial_hits);
+
+        vector<size_t> parallel_hits;
+        compute_closest_hits(parallel_tree, bboxes, parallel_partitioner.get_item_ordering(), parallel_hits);
+
+        EXPECT_EQ(serial_hits, parallel_hits);
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_Refitter)
+{
+    typedef bvh::Tree<AlignedVector<bvh::Node<AABB3d> > > Tree;
+    typedef vector<AABB3d> AABBVector;
+
+    struct Fixture
+    {
+        AABBVector                          m_bboxes;
+        bvh::SAHPartitioner<AABBVector>     m_partitioner;
+        Tree                                m_tree;
+
+        Fixture()
+          : m_partitioner(make_bboxes(m_bboxes))
+        {
+            bvh::Builder<Tree, bvh::SAHPartitioner<AABBVector> > builder;
+            builder.build<DefaultWallclockTimer>(m_tree, m_partitioner, m_bboxes.size(), 1);
+        }
+
+        static const AABBVector& make_bboxes(AABBVector& bboxes)
+        {
+            for (size_t i = 0; i < 8; ++i)
+            {
+                const Vector3d p(static_cast<double>(i), 0.0, 0.0);
+                bboxes.push_back(AABB3d(p, p + Vector3d(0.5)));
+            }
+
+            return bboxes;
+        }
+
+        AABBVector get_ordered_bboxes(const Vector3d& offset) const
+        {
+            const vector<size_t>& ordering = m_partitioner.get_item_ordering();
+
+            AABBVector ordered_bboxes;
+            for (size_t i = 0; i < ordering.size(); ++i)
+            {
+                const AABB3d& bbox = m_bboxes[ordering[i]];
+                ordered_bboxes.push_back(AABB3d(bbox.min + offset, bbox.max + offset));
+            }
+
+            return ordered_bboxes;
+        }
+    };
+
+    TEST_CASE_F(Refit_GivenTranslatedItems_PreservesCost, Fixture)
+    {
+        bvh::Refitter<Tree> refitter;
+        const double initial_cost = refitter.compute_cost(m_tree, m_bboxes);
+
+        const AABBVector ordered_bboxes = get_ordered_bboxes(Vector3d(10.0, -3.0, 7.0));
+        refitter.refit<DefaultWallclockTimer>(m_tree, ordered_bboxes);
+
+        EXPECT_FEQ(initial_cost, refitter.compute_cost(m_tree, ordered_bboxes));
+    }
+
+    TEST_CASE_F(Refit_GivenScatteredItems_IncreasesCost, Fixture)
+    {
+        bvh::Refitter<Tree> refitter;
+        const double initial_cost = refitter.compute_cost(m_tree, m_bboxes);
+
+        AABBVector ordered_bboxes = get_ordered_bboxes(Vector3d(0.0));
+        ordered_bboxes[0] = AABB3d(Vector3d(100.0, 100.0, 100.0), Vector3d(100.5, 100.5, 100.5));
+        refitter.refit<DefaultWallclockTimer>(m_tree, ordered_bboxes);
+
+        EXPECT_GT(initial_cost, refitter.compute_cost(m_tree, ordered_bboxes));
+    }
+}
+
+TEST_SUITE(Foundation_Math_BVH_Masker)
+{
+    typedef bvh::Tree<AlignedVector<bvh::Node<AABB3d> > > Tree;
+    typedef vector<AABB3d> AABBVector;
+
+    struct Visitor
+    {
+        vector<size_t> m_visited_items;
+
+        bool visit(
+            const Tree::NodeType&       node,
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            double&                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , bvh::TraversalStatistics& stats
+#endif
+            )
+        {
+            const size_t item_begin = node.get_item_index();
+            const size_t item_end = item_begin + node.get_item_count();
+
+            for (size_t i = item_begin; i < item_end; ++i)
+                m_visited_items.push_back(i);
+
+            distance = ray.m_tmax;
+            return true;
+        }
+    };
+
+    TEST_CASE(Intersect_GivenRayMask_SkipsSubtreesOfInvisibleItems)
+    {
+        AABBVector bboxes;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            const Vector3d p(static_cast<double>(i), 0.0, 0.0);
+            bboxes.push_back(AABB3d(p, p + Vector3d(0.5)));
+        }
+
+        typedef bvh::SAHPartitioner<AABBVector> Partitioner;
+        Partitioner partitioner(bboxes);
+
+        Tree tree;
+        bvh::Builder<Tree, Partitioner> builder;
+        builder.build<DefaultWallclockTimer>(tree, partitioner, bboxes.size(), 1);
+
+        // Items with an even index in tree order are only visible to rays with mask 1.
+        vector<uint32> item_masks;
+        for (size_t i = 0; i < bboxes.size(); ++i)
+            item_masks.push_back(i % 2 == 0 ? 1 : 2);
+
+        bvh::Masker<Tree> masker;
+        EXPECT_EQ(3, masker.compute_masks(tree, item_masks));
+
+        const Ray3d ray(Vector3d(-1.0, 0.25, 0.25), Vector3d(1.0, 0.0, 0.0), 0.0, 10.0);
+        const RayInfo3d ray_info(ray);
+
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        bvh::TraversalStatistics stats;
+#endif
+
+        Visitor visitor;
+        bvh::Intersector<Tree, Visitor, Ray3d> intersector;
+        intersector.intersect_no_motion(
+            tree,
+            ray,
+            ray_info,
+            visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            , 0
+            , 1);
+
+        ASSERT_EQ(4, visitor.m_visited_items.size());
+
+        for (size_t i = 0; i < visitor.m_visited_items.size(); ++i)
+            EXPECT_EQ(1, item_masks[visitor.m_visited_items[i]]);
+    }
+}
+
 TEST_SUITE(Foundation_Math_BVH_SpatialBuilder)
 {
     struct ItemHandler
@@ -117,6 +1040,39 @@ TEST_SUITE(Foundation_Math_BVH_SpatialBuilder)
         Tree tree;
         bvh::SpatialBuilder<Tree, Partitioner> builder;
     }
+
+    TEST_CASE(BuildChunked_GivenDisjointItems_StoresEveryItemExactlyOnce)
+    {
+        typedef AlignedVector<bvh::Node<AABB3d> > NodeVector;
+        typedef vector<AABB3d> AABBVector;
+
+        typedef bvh::Tree<NodeVector> Tree;
+        typedef bvh::SBVHPartitioner<ItemHandler, AABBVector> Partitioner;
+
+        AABBVector bboxes;
+        for (size_t i = 0; i < 10; ++i)
+        {
+            const double x = static_cast<double>(9 - i) * 2.0;
+            bboxes.push_back(AABB3d(Vector3d(x, 0.0, 0.0), Vector3d(x + 1.0, 1.0, 1.0)));
+        }
+
+        ItemHandler item_handler;
+        Partitioner partitioner(item_handler, bboxes);
+
+        Tree tree;
+        bvh::SpatialBuilder<Tree, Partitioner> builder;
+        builder.build_chunked<DefaultWallclockTimer>(tree, partitioner, bboxes, 3);
+
+        vector<size_t> ordering = partitioner.get_item_ordering();
+        sort(ordering.begin(), ordering.end());
+
+        ASSERT_EQ(bboxes.size(), ordering.size());
+        for (size_t i = 0; i < ordering.size(); ++i)
+            EXPECT_EQ(i, ordering[i]);
+
+        EXPECT_EQ(4, builder.get_chunk_count());
+        EXPECT_GT(0, builder.get_peak_memory_size());
+    }
 }
 
 TEST_SUITE(Foundation_Math_BVH_Intersector_2D)
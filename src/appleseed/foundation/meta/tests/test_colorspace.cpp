@@ -400,6 +400,33 @@ TEST_SUITE(Foundation_Image_ColorSpace)
             1.0e-5);
     }
 
+#ifdef APPLESEED_USE_SSE
+
+    TEST_CASE(TestLinearRGBToCIEXYZConversion_SSE)
+    {
+        APPLESEED_SIMD4_ALIGN const float r[4] = { 0.444527f, 0.0f, 1.0f, -0.5f };
+        APPLESEED_SIMD4_ALIGN const float g[4] = { 0.836877f, 0.5f, 1.0f, 0.2f };
+        APPLESEED_SIMD4_ALIGN const float b[4] = { 0.096456f, 0.25f, 1.0f, 0.1f };
+
+        __m128 x = _mm_load_ps(r);
+        __m128 y = _mm_load_ps(g);
+        __m128 z = _mm_load_ps(b);
+        linear_rgb_to_ciexyz(x, y, z);
+
+        APPLESEED_SIMD4_ALIGN float result[3][4];
+        _mm_store_ps(result[0], x);
+        _mm_store_ps(result[1], y);
+        _mm_store_ps(result[2], z);
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            const Color3f expected = linear_rgb_to_ciexyz(Color3f(r[i], g[i], b[i]));
+            EXPECT_EQ(expected, Color3f(result[0][i], result[1][i], result[2][i]));
+        }
+    }
+
+#endif
+
     TEST_CASE(TestCIEXYZToCIExyYConversion)
     {
         const Color3d ciexyz(0.5, 0.7, 0.2);
@@ -0,0 +1,122 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/image/compressedtile.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Image_CompressedTile)
+{
+    TEST_CASE(GetPixel_GivenUniformRGBTile_ReturnsOriginalColor)
+    {
+        Tile tile(6, 5, 3, PixelFormatUInt8);
+        tile.clear(Color3f(1.0f, 0.0f, 1.0f));
+
+        const CompressedTile compressed(tile);
+
+        Color3f color;
+        compressed.get_pixel(5, 4, color);
+
+        EXPECT_FEQ(Color3f(1.0f, 0.0f, 1.0f), color);
+    }
+
+    TEST_CASE(GetPixel_GivenTwoColorRGBABlock_ReturnsOriginalColors)
+    {
+        Tile tile(4, 4, 4, PixelFormatUInt8);
+
+        for (size_t y = 0; y < 4; ++y)
+        {
+            for (size_t x = 0; x < 4; ++x)
+            {
+                tile.set_pixel(
+                    x, y,
+                    x < 2 ? Color4f(0.0f, 0.0f, 0.0f, 0.0f) : Color4f(1.0f, 1.0f, 1.0f, 1.0f));
+            }
+        }
+
+        const CompressedTile compressed(tile);
+
+        Color4f left, right;
+        compressed.get_pixel(1, 2, left);
+        compressed.get_pixel(2, 2, right);
+
+        EXPECT_FEQ_EPS(Color4f(0.0f, 0.0f, 0.0f, 0.0f), left, 0.1f);
+        EXPECT_FEQ_EPS(Color4f(1.0f, 1.0f, 1.0f, 1.0f), right, 0.1f);
+    }
+
+    TEST_CASE(GetPixel_GivenHorizontalGradient_ReturnsApproximateColors)
+    {
+        Tile tile(8, 8, 3, PixelFormatUInt8);
+
+        for (size_t y = 0; y < 8; ++y)
+        {
+            for (size_t x = 0; x < 8; ++x)
+                tile.set_pixel(x, y, Color3f(x / 7.0f, 1.0f - x / 7.0f, 0.5f));
+        }
+
+        const CompressedTile compressed(tile);
+
+        for (size_t y = 0; y < 8; ++y)
+        {
+            for (size_t x = 0; x < 8; ++x)
+            {
+                Color3f color;
+                compressed.get_pixel(x, y, color);
+
+                const Color3f expected(x / 7.0f, 1.0f - x / 7.0f, 0.5f);
+
+                for (size_t c = 0; c < 3; ++c)
+                    EXPECT_LT(0.05f, abs(color[c] - expected[c]));
+            }
+        }
+    }
+
+    TEST_CASE(GetMemorySize_GivenRGBTile_IsSmallerThanUncompressedTile)
+    {
+        Tile tile(64, 64, 3, PixelFormatUInt8);
+        tile.clear(Color3f(0.5f));
+
+        const CompressedTile compressed(tile);
+
+        EXPECT_LT(tile.get_memory_size() / 5, compressed.get_memory_size());
+        EXPECT_EQ(tile.get_size() / 6, compressed.get_memory_size() - sizeof(compressed));
+    }
+}
@@ -0,0 +1,100 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.foundation headers.
+#include "foundation/math/population.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/counterblock.h"
+#include "foundation/utility/statistics.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Utility_CounterBlock)
+{
+    TEST_CASE(Flush_GivenNoUpdate_InsertsNothing)
+    {
+        CounterBlock block;
+        block.declare_counter("counter");
+        block.declare_timer("timer");
+
+        Statistics stats;
+        block.flush(stats);
+
+        EXPECT_EQ(0, stats.size());
+    }
+
+    TEST_CASE(Flush_AccumulatesCountersIntoStatistics)
+    {
+        CounterBlock block;
+        const size_t counter = block.declare_counter("counter");
+
+        Statistics stats;
+
+        block.add(counter, 5);
+        block.increment(counter);
+        block.flush(stats);
+
+        block.add(counter, 3);
+        block.flush(stats);
+
+        const Statistics::UnsignedIntegerEntry* entry =
+            dynamic_cast<const Statistics::UnsignedIntegerEntry*>(stats.find("counter"));
+
+        ASSERT_NEQ(0, entry);
+        EXPECT_EQ(9, entry->m_value);
+    }
+
+    TEST_CASE(Flush_AddsOneTimerSamplePerFlush)
+    {
+        CounterBlock block;
+        const size_t timer = block.declare_timer("timer");
+
+        Statistics stats;
+
+        for (size_t i = 0; i < 3; ++i)
+        {
+            {
+                ScopedCounterBlockTimer scoped_timer(block, timer);
+            }
+
+            block.flush(stats);
+        }
+
+        const Statistics::PopulationEntry<double>* entry =
+            dynamic_cast<const Statistics::PopulationEntry<double>*>(stats.find("timer"));
+
+        ASSERT_NEQ(0, entry);
+        EXPECT_EQ(3, entry->m_value.get_size());
+        EXPECT_TRUE(entry->m_value.get_min() >= 0.0);
+    }
+}
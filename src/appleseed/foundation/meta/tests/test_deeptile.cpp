@@ -0,0 +1,142 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// appleseed.foundation headers.
+#include "foundation/image/deeptile.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Image_DeepTile)
+{
+    const float Red[4] = { 0.5f, 0.0f, 0.0f, 0.5f };
+    const float Green[4] = { 0.0f, 1.0f, 0.0f, 1.0f };
+    const float Transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    TEST_CASE(Add_GivenSamplesWithinDepthTolerance_MergesSamples)
+    {
+        DeepTile tile(2, 2, 4, 0.01f);
+
+        tile.add(1, 0, 10.0f, Red);
+        tile.add(1, 0, 10.05f, Red);
+
+        ASSERT_EQ(1, tile.get_fragment_count(1, 0));
+        EXPECT_EQ(10.0f, tile.get_fragment(1, 0, 0).m_depth);
+        EXPECT_EQ(2.0f, tile.get_fragment(1, 0, 0).m_weight);
+        EXPECT_FEQ(1.0f, tile.get_fragment(1, 0, 0).m_color[3]);
+        EXPECT_EQ(0, tile.get_fragment_count(0, 0));
+    }
+
+    TEST_CASE(Add_GivenDistantSamples_SortsFragmentsByDepth)
+    {
+        DeepTile tile(1, 1, 4, 0.01f);
+
+        tile.add(0, 0, 20.0f, Red);
+        tile.add(0, 0, 10.0f, Green);
+        tile.add(0, 0, 30.0f, Red);
+
+        ASSERT_EQ(3, tile.get_fragment_count(0, 0));
+        EXPECT_EQ(10.0f, tile.get_fragment(0, 0, 0).m_depth);
+        EXPECT_EQ(20.0f, tile.get_fragment(0, 0, 1).m_depth);
+        EXPECT_EQ(30.0f, tile.get_fragment(0, 0, 2).m_depth);
+    }
+
+    TEST_CASE(Add_GivenFullPixel_MergesSampleIntoClosestFragment)
+    {
+        DeepTile tile(1, 1, 2, 0.01f);
+
+        tile.add(0, 0, 10.0f, Red);
+        tile.add(0, 0, 20.0f, Red);
+        tile.add(0, 0, 18.0f, Green);
+
+        ASSERT_EQ(2, tile.get_fragment_count(0, 0));
+        EXPECT_EQ(10.0f, tile.get_fragment(0, 0, 0).m_depth);
+        EXPECT_EQ(18.0f, tile.get_fragment(0, 0, 1).m_depth);
+        EXPECT_EQ(2.0f, tile.get_fragment(0, 0, 1).m_weight);
+    }
+
+    TEST_CASE(Add_GivenTransparentSample_OnlyIncreasesSampleWeight)
+    {
+        DeepTile tile(1, 1, 2, 0.01f);
+
+        tile.add(0, 0, 10.0f, Transparent);
+
+        EXPECT_EQ(0, tile.get_fragment_count(0, 0));
+        EXPECT_EQ(1.0f, tile.get_sample_weight(0, 0));
+    }
+
+    TEST_CASE(ResolvePixel_CompositedOver_MatchesAverageOfSamples)
+    {
+        DeepTile tile(1, 1, 4, 0.01f);
+
+        tile.add(0, 0, 10.0f, Red);
+        tile.add(0, 0, 20.0f, Green);
+        tile.add(0, 0, 30.0f, Red);
+        tile.add(0, 0, 40.0f, Transparent);
+
+        float samples[4 * DeepTile::ResolvedSampleSize];
+        const size_t sample_count = tile.resolve_pixel(0, 0, samples);
+        ASSERT_EQ(3, sample_count);
+
+        // Composite the deep samples front to back.
+        float result[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (size_t i = 0; i < sample_count; ++i)
+        {
+            const float* s = samples + i * DeepTile::ResolvedSampleSize;
+            const float transmittance = 1.0f - result[3];
+            for (size_t c = 0; c < 4; ++c)
+                result[c] += transmittance * s[c];
+        }
+
+        EXPECT_FEQ(1.0f / 4, result[0]);
+        EXPECT_FEQ(1.0f / 4, result[1]);
+        EXPECT_FEQ(0.0f, result[2]);
+        EXPECT_FEQ(2.0f / 4, result[3]);
+        EXPECT_EQ(20.0f, samples[DeepTile::ResolvedSampleSize + 4]);
+    }
+
+    TEST_CASE(Clear_RemovesFragmentsAndSampleWeights)
+    {
+        DeepTile tile(1, 1, 4, 0.01f);
+
+        tile.add(0, 0, 10.0f, Green);
+        tile.add(0, 0, 20.0f, Red);
+        tile.clear();
+        tile.add(0, 0, 20.0f, Red);
+
+        float samples[4 * DeepTile::ResolvedSampleSize];
+        ASSERT_EQ(1, tile.resolve_pixel(0, 0, samples));
+        EXPECT_FEQ(0.5f, samples[3]);
+        EXPECT_EQ(20.0f, samples[4]);
+    }
+}
@@ -134,6 +134,129 @@ TEST_SUITE(Foundation_Utility_StringDictionary)
         });
     }
 
+    TEST_CASE(GetAsInt_CalledTwice_ReturnsSameValue)
+    {
+        StringDictionary sd;
+        sd.insert("key", 42);
+
+        EXPECT_EQ(42, sd.get<int>("key"));
+        EXPECT_EQ(42, sd.get<int>("key"));
+    }
+
+    TEST_CASE(GetAsInt_AfterSettingNewValue_ReturnsNewValue)
+    {
+        StringDictionary sd;
+        sd.insert("key", 42);
+        sd.get<int>("key");
+
+        sd.set("key", 17);
+
+        EXPECT_EQ(17, sd.get<int>("key"));
+    }
+
+    TEST_CASE(GetAsInt_AfterReinsertingItem_ReturnsNewValue)
+    {
+        StringDictionary sd;
+        sd.insert("key", 42);
+        sd.get<int>("key");
+
+        sd.insert("key", 17);
+
+        EXPECT_EQ(17, sd.get<int>("key"));
+    }
+
+    TEST_CASE(GetAsInt_GivenItemCachedAsDouble_StillValidatesConversion)
+    {
+        StringDictionary sd;
+        sd.insert("key", "3.5e1");
+
+        EXPECT_EQ(35.0, sd.get<double>("key"));
+        EXPECT_EXCEPTION(ExceptionStringConversionError,
+        {
+            sd.get<int>("key");
+        });
+        EXPECT_EQ(35.0, sd.get<double>("key"));
+    }
+
+    TEST_CASE(Get_GivenManyItemsInsertedInReverseOrder_ReturnsEachItem)
+    {
+        StringDictionary sd;
+
+        for (int i = 99; i >= 0; --i)
+            sd.insert("key" + to_string(i), i);
+
+        ASSERT_EQ(100, sd.size());
+
+        for (int i = 0; i < 100; ++i)
+            EXPECT_EQ(i, sd.get<int>("key" + to_string(i)));
+
+        EXPECT_EQ(string("key0"), sd.begin().key());
+    }
+
+    TEST_CASE(Get_ThenInsertManyOtherItems_ReturnedValueRemainsValid)
+    {
+        StringDictionary sd;
+        sd.insert("key50", "value");
+
+        const char* value = sd.get("key50");
+
+        for (int i = 0; i < 100; ++i)
+        {
+            if (i != 50)
+                sd.insert("key" + to_string(i), i);
+        }
+
+        EXPECT_EQ(value, sd.get("key50"));
+        EXPECT_EQ(string("value"), value);
+    }
+
+    TEST_CASE(Iterator_GivenItemsInsertedDuringIteration_RemainsValid)
+    {
+        StringDictionary sd;
+        sd.insert("b", "1");
+        sd.insert("d", "2");
+
+        StringDictionary::const_iterator i = sd.begin();
+        EXPECT_EQ(string("b"), i.key());
+
+        sd.insert("a", "3");
+        sd.insert("c", "4");
+
+        for (int k = 0; k < 100; ++k)
+            sd.insert("e" + to_string(k), k);
+
+        EXPECT_EQ(string("b"), i.key());
+        EXPECT_EQ(string("1"), i.value());
+
+        ++i;
+        EXPECT_EQ(string("c"), i.key());
+
+        ++i;
+        EXPECT_EQ(string("d"), i.key());
+
+        --i;
+        --i;
+        --i;
+        EXPECT_TRUE(i == sd.begin());
+        EXPECT_EQ(string("a"), i.key());
+    }
+
+    TEST_CASE(Iterator_GivenLastItem_IncrementsToEnd)
+    {
+        StringDictionary sd;
+        sd.insert("a", "1");
+        sd.insert("b", "2");
+
+        StringDictionary::const_iterator i = sd.begin();
+        ++i;
+        ++i;
+
+        EXPECT_TRUE(i == sd.end());
+
+        --i;
+        EXPECT_EQ(string("b"), i.key());
+    }
+
     TEST_CASE(Remove_GivenCStringKeyOfExistingItem_RemovesItem)
     {
         StringDictionary sd;
@@ -0,0 +1,138 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// appleseed.foundation headers.
+#include "foundation/platform/types.h"
+#include "foundation/utility/eventtracer.h"
+#include "foundation/utility/string.h"
+#include "foundation/utility/test.h"
+
+// Boost headers.
+#include "boost/bind.hpp"
+#include "boost/thread/thread.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Utility_EventTracer)
+{
+    TEST_CASE(ScopedTraceEvent_GivenDisabledTracer_RecordsNothing)
+    {
+        EventTracer tracer;
+
+        {
+            ScopedTraceEvent event("event", "test", tracer);
+        }
+
+        EXPECT_EQ(0, tracer.get_event_count());
+    }
+
+    TEST_CASE(ScopedTraceEvent_GivenEnabledTracer_RecordsEvent)
+    {
+        EventTracer tracer;
+        tracer.set_enabled(true);
+
+        {
+            ScopedTraceEvent event("event", "test", tracer);
+        }
+
+        EXPECT_EQ(1, tracer.get_event_count());
+    }
+
+    TEST_CASE(Record_GivenFullBuffer_KeepsMostRecentEvents)
+    {
+        EventTracer tracer(2);
+        tracer.set_enabled(true);
+
+        tracer.record("first", "test", 0, 1);
+        tracer.record("second", "test", 1, 2);
+        tracer.record("third", "test", 2, 3);
+
+        const string trace = tracer.to_chrome_trace();
+
+        EXPECT_EQ(2, tracer.get_event_count());
+        EXPECT_EQ(string::npos, trace.find("\"first\""));
+        EXPECT_NEQ(string::npos, trace.find("\"second\""));
+        EXPECT_NEQ(string::npos, trace.find("\"third\""));
+    }
+
+    TEST_CASE(Clear_DiscardsEvents)
+    {
+        EventTracer tracer;
+        tracer.set_enabled(true);
+        tracer.record("event", "test", 0, 1);
+
+        tracer.clear();
+
+        EXPECT_EQ(0, tracer.get_event_count());
+    }
+
+    TEST_CASE(ToChromeTrace_GivenOneEvent_ReturnsCompleteEvent)
+    {
+        EventTracer tracer;
+        tracer.record("tile \"0\"", "rendering", 10, 25);
+
+        const string trace = tracer.to_chrome_trace();
+
+        EXPECT_EQ(
+            "{\"traceEvents\":[\n"
+            "{\"name\":\"tile \\\"0\\\"\",\"cat\":\"rendering\",\"ph\":\"X\",\"ts\":10,\"dur\":15,\"pid\":1,\"tid\":1}\n"
+            "],\"displayTimeUnit\":\"ms\"}\n",
+            trace);
+    }
+
+    void record_events(EventTracer* tracer, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            ScopedTraceEvent event("event", "test", *tracer);
+    }
+
+    TEST_CASE(ToChromeTrace_GivenEventsFromSeveralThreads_AssignsOneThreadIdPerThread)
+    {
+        EventTracer tracer;
+        tracer.set_enabled(true);
+
+        boost::thread thread1(boost::bind(&record_events, &tracer, 3));
+        boost::thread thread2(boost::bind(&record_events, &tracer, 3));
+        thread1.join();
+        thread2.join();
+
+        const string trace = tracer.to_chrome_trace();
+
+        EXPECT_EQ(6, tracer.get_event_count());
+        EXPECT_NEQ(string::npos, trace.find("\"tid\":1}"));
+        EXPECT_NEQ(string::npos, trace.find("\"tid\":2}"));
+        EXPECT_EQ(string::npos, trace.find("\"tid\":3}"));
+    }
+}
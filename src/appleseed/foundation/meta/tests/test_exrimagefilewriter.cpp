@@ -73,4 +73,36 @@ TEST_SUITE(Foundation_Image_EXRImageFileWriter)
             EXPECT_EQ(Reference, c);
         }
     }
+
+    TEST_CASE(WriteLayers_GivenPartialTiles_WritesMainLayer)
+    {
+        static const char* LayersFilename = "unit tests/outputs/test_exrimagefilewriter_layers.exr";
+        static const Color4b Other(10, 20, 30, 40);
+
+        Image main_image(70, 40, 32, 32, 4, PixelFormatFloat);
+        main_image.clear(Reference);
+
+        Image aov_image(70, 40, 32, 32, 4, PixelFormatFloat);
+        aov_image.clear(Other);
+
+        const char* const layer_names[] = { "", "diffuse" };
+        const ICanvas* const images[] = { &main_image, &aov_image };
+
+        EXRImageFileWriter writer;
+        writer.write_layers(LayersFilename, 2, layer_names, images);
+
+        GenericProgressiveImageFileReader reader;
+        reader.open(LayersFilename);
+        auto_ptr<Tile> tile(reader.read_tile(2, 1));
+
+        ASSERT_EQ(6, tile->get_width());
+        ASSERT_EQ(8, tile->get_height());
+
+        for (size_t i = 0; i < tile->get_pixel_count(); ++i)
+        {
+            Color4b c;
+            tile->get_pixel(i, c);
+            EXPECT_EQ(Reference, c);
+        }
+    }
 }
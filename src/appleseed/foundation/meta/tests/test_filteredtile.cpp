@@ -30,6 +30,7 @@
 // appleseed.foundation headers.
 #include "foundation/image/filteredtile.h"
 #include "foundation/math/filter.h"
+#include "foundation/math/scalar.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
@@ -102,4 +103,35 @@ TEST_SUITE(Foundation_Image_FilteredTile)
         const BoxFilter2<float> filter(2.0f, 2.0f);
         test("unit tests/outputs/test_filteredtile_boxfilter_radius_2_0.txt", filter);
     }
+
+    TEST_CASE(AddExclusive_GivenSameSamples_ProducesSameTileAsAdd)
+    {
+        const BlackmanHarrisFilter2<float> filter(2.0f, 2.0f);
+
+        FilteredTile tile1(16, 16, 5, filter);
+        FilteredTile tile2(16, 16, 5, filter);
+        tile1.clear();
+        tile2.clear();
+
+        const float values[5] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f };
+
+        for (size_t i = 0; i < 10; ++i)
+        {
+            const float x = 0.5f + 1.7f * i;
+            const float y = 15.5f - 1.3f * i;
+
+            tile1.add(x, y, values);
+            tile2.add_exclusive(x, y, values);
+        }
+
+        bool same = true;
+
+        for (size_t i = 0, e = tile1.get_pixel_count() * tile1.get_channel_count(); i < e; ++i)
+        {
+            if (!feq(tile1.pixel(0)[i], tile2.pixel(0)[i], 1.0e-6f))
+                same = false;
+        }
+
+        EXPECT_TRUE(same);
+    }
 }
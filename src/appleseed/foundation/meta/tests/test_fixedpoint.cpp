@@ -0,0 +1,70 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.foundation headers.
+#include "foundation/math/fixedpoint.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Math_FixedPoint)
+{
+    TEST_CASE(FloatToFixedPoint_GivenZero_ReturnsZero)
+    {
+        EXPECT_EQ(0, float_to_fixed_point(0.0f));
+    }
+
+    TEST_CASE(FixedPointToFloat_GivenFixedPointOfExactlyRepresentableValue_ReturnsValue)
+    {
+        EXPECT_EQ(0.75f, fixed_point_to_float(float_to_fixed_point(0.75f)));
+        EXPECT_EQ(1000.0f, fixed_point_to_float(float_to_fixed_point(1000.0f)));
+    }
+
+    TEST_CASE(FloatToFixedPoint_GivenValueLargerThanMaxValue_ClampsValue)
+    {
+        EXPECT_EQ(float_to_fixed_point(FixedPointMaxValue), float_to_fixed_point(1.0e20f));
+    }
+
+    TEST_CASE(FixedPointSum_DoesNotDependOnOrderOfAdditions)
+    {
+        const float Values[] = { 1.0e6f, 1.0e-3f, 3.3f, 1.0e-3f, 7.0e5f, 0.1f };
+        const size_t ValueCount = sizeof(Values) / sizeof(Values[0]);
+
+        uint64 forward = 0;
+        for (size_t i = 0; i < ValueCount; ++i)
+            forward += float_to_fixed_point(Values[i]);
+
+        uint64 backward = 0;
+        for (size_t i = ValueCount; i > 0; --i)
+            backward += float_to_fixed_point(Values[i - 1]);
+
+        EXPECT_EQ(forward, backward);
+    }
+}
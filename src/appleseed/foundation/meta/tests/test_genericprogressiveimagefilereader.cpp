@@ -27,11 +27,16 @@
 //
 
 // appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/exrimagefilewriter.h"
 #include "foundation/image/genericprogressiveimagefilereader.h"
+#include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
+#include <cstddef>
 #include <memory>
 
 using namespace foundation;
@@ -52,4 +57,37 @@ TEST_SUITE(Foundation_Image_GenericProgressiveImageFileReader)
         // See https://github.com/OpenImageIO/oiio/issues/1600 for details.
         delete reader.read_tile(0, 0);
     }
+
+    TEST_CASE(ReadTile_GivenBorderTileOfTiledEXRFile_ReturnsTileClippedToImage)
+    {
+        const char* Filename = "unit tests/outputs/test_genericprogressiveimagefilereader_tiled.exr";
+
+        Image image(100, 70, 32, 32, 1, PixelFormatFloat);
+        for (size_t y = 0; y < 70; ++y)
+        {
+            for (size_t x = 0; x < 100; ++x)
+            {
+                const float value = static_cast<float>(y * 1000 + x);
+                image.set_pixel(x, y, &value);
+            }
+        }
+
+        EXRImageFileWriter writer;
+        writer.write(Filename, image);
+
+        GenericProgressiveImageFileReader reader;
+        reader.open(Filename);
+
+        CanvasProperties props;
+        reader.read_canvas_properties(props);
+        EXPECT_EQ(32, props.m_tile_width);
+        EXPECT_EQ(32, props.m_tile_height);
+
+        auto_ptr<Tile> tile(reader.read_tile(3, 2));
+
+        ASSERT_EQ(4, tile->get_width());
+        ASSERT_EQ(6, tile->get_height());
+        EXPECT_EQ(64 * 1000 + 96.0f, tile->get_component<float>(0, 0, 0));
+        EXPECT_EQ(69 * 1000 + 99.0f, tile->get_component<float>(3, 5, 0));
+    }
 }
@@ -0,0 +1,65 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.foundation headers.
+#include "foundation/platform/hardwarecounters.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Platform_HardwareCounters)
+{
+    // Hardware counters may not be accessible (virtual machines, perf_event_paranoid),
+    // so these tests only check counters that could be opened.
+
+    TEST_CASE(GetValue_GivenCountersNeverStarted_ReturnsZero)
+    {
+        HardwareCounters counters;
+
+        for (size_t i = 0; i < HardwareCounters::CounterCount; ++i)
+            EXPECT_EQ(0, counters.get_value(static_cast<HardwareCounters::Counter>(i)));
+    }
+
+    TEST_CASE(GetValue_GivenInstructionsCounterAroundLoop_ReturnsNonZeroValue)
+    {
+        HardwareCounters counters;
+
+        counters.start();
+
+        volatile uint32 sum = 0;
+        for (uint32 i = 0; i < 10000; ++i)
+            sum += i;
+
+        counters.stop();
+
+        if (counters.is_available(HardwareCounters::Instructions))
+            EXPECT_GT(10000, counters.get_value(HardwareCounters::Instructions));
+    }
+}
@@ -0,0 +1,202 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.foundation headers.
+#include "foundation/math/qmc.h"
+#include "foundation/math/sampling/hierarchicalimportancesampler.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Math_Sampling_HierarchicalImportanceSampler)
+{
+    // Importance of pixel (x, y) is x + y, on purpose not a power of two in either dimension.
+    struct DiagonalGradientSampler
+    {
+        void sample(const size_t x, const size_t y, double& importance) const
+        {
+            importance = static_cast<double>(x + y);
+        }
+    };
+
+    TEST_CASE(Sample_ReturnsProbabilityProportionalToImportance)
+    {
+        const size_t Width = 7;
+        const size_t Height = 5;
+
+        HierarchicalImportanceSampler<double> importance_sampler(Width, Height);
+        DiagonalGradientSampler sampler;
+        importance_sampler.rebuild(sampler);
+
+        double total = 0.0;
+        for (size_t y = 0; y < Height; ++y)
+        {
+            for (size_t x = 0; x < Width; ++x)
+                total += static_cast<double>(x + y);
+        }
+
+        size_t x, y;
+        double prob_xy;
+        importance_sampler.sample(Vector2d(0.3, 0.7), x, y, prob_xy);
+
+        EXPECT_FEQ((x + y) / total, prob_xy);
+    }
+
+    TEST_CASE(GetPDF_ReturnsSameProbabilityAsSample)
+    {
+        const size_t Width = 7;
+        const size_t Height = 5;
+
+        HierarchicalImportanceSampler<double> importance_sampler(Width, Height);
+        DiagonalGradientSampler sampler;
+        importance_sampler.rebuild(sampler);
+
+        const size_t SampleCount = 64;
+        const size_t Bases[1] = { 2 };
+
+        for (size_t i = 0; i < SampleCount; ++i)
+        {
+            const Vector2d s = hammersley_sequence<double, 2>(Bases, SampleCount, i);
+
+            size_t x, y;
+            double prob_xy;
+            importance_sampler.sample(s, x, y, prob_xy);
+
+            EXPECT_EQ(prob_xy, importance_sampler.get_pdf(x, y));
+        }
+    }
+
+    TEST_CASE(Sample_NeverReturnsPixelsOfZeroImportance)
+    {
+        const size_t Width = 7;
+        const size_t Height = 5;
+
+        HierarchicalImportanceSampler<double> importance_sampler(Width, Height);
+        DiagonalGradientSampler sampler;
+        importance_sampler.rebuild(sampler);
+
+        size_t x, y;
+        double prob_xy;
+        importance_sampler.sample(Vector2d(0.0, 0.0), x, y, prob_xy);
+
+        EXPECT_NEQ(0, x + y);
+        EXPECT_EQ(0.0, importance_sampler.get_pdf(0, 0));
+    }
+
+    TEST_CASE(Sample_DistributesSamplesAccordingToImportance)
+    {
+        const size_t Width = 7;
+        const size_t Height = 5;
+
+        HierarchicalImportanceSampler<double> importance_sampler(Width, Height);
+        DiagonalGradientSampler sampler;
+        importance_sampler.rebuild(sampler);
+
+        const size_t SampleCount = 64 * 1024;
+        const size_t Bases[1] = { 2 };
+        vector<size_t> histogram(Width * Height, 0);
+
+        for (size_t i = 0; i < SampleCount; ++i)
+        {
+            const Vector2d s = hammersley_sequence<double, 2>(Bases, SampleCount, i);
+
+            size_t x, y;
+            Vector2d pixel_s;
+            double prob_xy;
+            importance_sampler.sample(s, x, y, pixel_s, prob_xy);
+
+            EXPECT_TRUE(pixel_s[0] >= 0.0 && pixel_s[0] < 1.0);
+            EXPECT_TRUE(pixel_s[1] >= 0.0 && pixel_s[1] < 1.0);
+
+            ++histogram[y * Width + x];
+        }
+
+        for (size_t y = 0; y < Height; ++y)
+        {
+            for (size_t x = 0; x < Width; ++x)
+            {
+                const double expected = importance_sampler.get_pdf(x, y);
+                const double actual = static_cast<double>(histogram[y * Width + x]) / SampleCount;
+                EXPECT_LT(1.0e-3, abs(actual - expected));
+            }
+        }
+    }
+
+    struct UniformBlackImageSampler
+    {
+        void sample(const size_t x, const size_t y, float& importance) const
+        {
+            importance = 0.0f;
+        }
+    };
+
+    TEST_CASE(Sample_GivenUniformBlackImage_SamplesUniformly)
+    {
+        HierarchicalImportanceSampler<float> importance_sampler(2, 2);
+        UniformBlackImageSampler sampler;
+        importance_sampler.rebuild(sampler);
+
+        size_t x, y;
+        Vector2f pixel_s;
+        float prob_xy;
+        importance_sampler.sample(Vector2f(0.75f, 0.25f), x, y, pixel_s, prob_xy);
+
+        EXPECT_EQ(1, x);
+        EXPECT_EQ(0, y);
+        EXPECT_EQ(0.5f, pixel_s[0]);
+        EXPECT_EQ(0.5f, pixel_s[1]);
+        EXPECT_EQ(0.25f, prob_xy);
+        EXPECT_EQ(0.25f, importance_sampler.get_pdf(1, 1));
+    }
+
+    TEST_CASE(SetImportance_BuildsSameSamplerAsRebuild)
+    {
+        const size_t Width = 7;
+        const size_t Height = 5;
+
+        HierarchicalImportanceSampler<double> importance_sampler1(Width, Height);
+        DiagonalGradientSampler sampler;
+        importance_sampler1.rebuild(sampler);
+
+        vector<double> importance = importance_sampler1.get_importance();
+        HierarchicalImportanceSampler<double> importance_sampler2(Width, Height);
+        importance_sampler2.set_importance(importance);
+
+        for (size_t y = 0; y < Height; ++y)
+        {
+            for (size_t x = 0; x < Width; ++x)
+                EXPECT_EQ(importance_sampler1.get_pdf(x, y), importance_sampler2.get_pdf(x, y));
+        }
+    }
+}
@@ -96,4 +96,42 @@ TEST_SUITE(Foundation_Image_Image)
             }
         }
     }
+
+    TEST_CASE(CompressTile_ThenAccessTile_RestoresPixels)
+    {
+        Image image(4, 4, 2, 2, 3, PixelFormatFloat);
+
+        Tile& tile = image.tile(1, 0);
+        for (size_t y = 0; y < 2; ++y)
+        {
+            for (size_t x = 0; x < 2; ++x)
+                tile.set_pixel(x, y, Color3f(static_cast<float>(y * 2 + x)));
+        }
+
+        image.compress_tile(1, 0);
+
+        const Tile& restored = image.tile(1, 0);
+        for (size_t y = 0; y < 2; ++y)
+        {
+            for (size_t x = 0; x < 2; ++x)
+            {
+                Color3f value;
+                restored.get_pixel(x, y, value);
+
+                EXPECT_EQ(Color3f(static_cast<float>(y * 2 + x)), value);
+            }
+        }
+    }
+
+    TEST_CASE(CompressTile_GivenVirginTile_LeavesTileBlank)
+    {
+        Image image(4, 4, 2, 2, 3, PixelFormatFloat);
+
+        image.compress_tile(0, 0);
+
+        Color3f value;
+        image.tile(0, 0).get_pixel(0, 0, value);
+
+        EXPECT_EQ(Color3f(0.0f), value);
+    }
 }
@@ -0,0 +1,126 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.foundation headers.
+#include "foundation/math/intersection/raysphere.h"
+#include "foundation/math/ray.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Math_Intersection_RaySphere)
+{
+    const Vector3d Center(0.0, 0.0, 0.0);
+    const double Radius = 1.0;
+
+    TEST_CASE(IntersectSphere_GivenRayPointingTowardSphere_ReturnsDistanceToNearSide)
+    {
+        const Ray3d ray(Vector3d(0.0, 0.0, 5.0), Vector3d(0.0, 0.0, -1.0));
+
+        double t;
+        const bool hit = intersect_sphere(ray, Center, Radius, t);
+
+        EXPECT_TRUE(hit);
+        EXPECT_FEQ(4.0, t);
+    }
+
+    TEST_CASE(IntersectSphere_GivenRayWithUnnormalizedDirection_ReturnsDistanceInRayUnits)
+    {
+        const Ray3d ray(Vector3d(0.0, 0.0, 5.0), Vector3d(0.0, 0.0, -2.0));
+
+        double t;
+        const bool hit = intersect_sphere(ray, Center, Radius, t);
+
+        EXPECT_TRUE(hit);
+        EXPECT_FEQ(2.0, t);
+    }
+
+    TEST_CASE(IntersectSphere_GivenRayOriginInsideSphere_ReturnsDistanceToExitPoint)
+    {
+        const Ray3d ray(Vector3d(0.0, 0.0, 0.5), Vector3d(0.0, 0.0, -1.0));
+
+        double t;
+        const bool hit = intersect_sphere(ray, Center, Radius, t);
+
+        EXPECT_TRUE(hit);
+        EXPECT_FEQ(1.5, t);
+    }
+
+    TEST_CASE(IntersectSphere_GivenRayPointingAwayFromSphere_ReturnsFalse)
+    {
+        const Ray3d ray(Vector3d(0.0, 0.0, 5.0), Vector3d(0.0, 0.0, 1.0));
+
+        EXPECT_FALSE(intersect_sphere(ray, Center, Radius));
+    }
+
+    TEST_CASE(IntersectSphere_GivenRayMissingSphere_ReturnsFalse)
+    {
+        const Ray3d ray(Vector3d(2.0, 0.0, 5.0), Vector3d(0.0, 0.0, -1.0));
+
+        EXPECT_FALSE(intersect_sphere(ray, Center, Radius));
+    }
+
+    TEST_CASE(IntersectSphere_GivenSphereBeyondRayInterval_ReturnsFalse)
+    {
+        const Ray3d ray(Vector3d(0.0, 0.0, 5.0), Vector3d(0.0, 0.0, -1.0), 0.0, 3.0);
+
+        EXPECT_FALSE(intersect_sphere(ray, Center, Radius));
+    }
+
+    TEST_CASE(IntersectSphere_GivenSmallSphereFarFromRayOrigin_ReturnsAccurateDistance)
+    {
+        const Ray3d ray(Vector3d(0.0, 0.0, 1.0e6), Vector3d(0.0, 0.0, -1.0));
+
+        double t;
+        const bool hit = intersect_sphere(ray, Center, 1.0e-3, t);
+
+        EXPECT_TRUE(hit);
+        EXPECT_FEQ(1.0e6 - 1.0e-3, t);
+    }
+
+    TEST_CASE(IntersectFacingDisk_GivenRayThroughDisk_ReturnsDistanceToCenterPlane)
+    {
+        const Ray3d ray(Vector3d(0.5, 0.0, 5.0), Vector3d(0.0, 0.0, -1.0));
+
+        double t;
+        const bool hit = intersect_facing_disk(ray, Center, Radius, t);
+
+        EXPECT_TRUE(hit);
+        EXPECT_FEQ(5.0, t);
+    }
+
+    TEST_CASE(IntersectFacingDisk_GivenRayMissingDisk_ReturnsFalse)
+    {
+        const Ray3d ray(Vector3d(1.5, 0.0, 5.0), Vector3d(0.0, 0.0, -1.0));
+
+        double t;
+        EXPECT_FALSE(intersect_facing_disk(ray, Center, Radius, t));
+    }
+}
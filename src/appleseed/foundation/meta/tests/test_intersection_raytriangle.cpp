@@ -29,12 +29,20 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/intersection/raytrianglemt.h"
+#include "foundation/math/intersection/raytrianglemt4.h"
 #include "foundation/math/intersection/raytrianglessk.h"
 #include "foundation/math/ray.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 #include "foundation/utility/test.h"
 
+// Standard headers.
+#include <cstddef>
+
 using namespace foundation;
+using namespace std;
 
 namespace
 {
@@ -110,6 +118,110 @@ TEST_SUITE(Foundation_Math_Intersection_RayTriangleMT)
     }
 }
 
+TEST_SUITE(Foundation_Math_Intersection_RayTriangleMT4)
+{
+    template <typename T>
+    Vector<T, 3> rand_vector(MersenneTwister& rng, const T min, const T max)
+    {
+        Vector<T, 3> v;
+        v[0] = rand1(rng, min, max);
+        v[1] = rand1(rng, min, max);
+        v[2] = rand1(rng, min, max);
+        return v;
+    }
+
+    // Return true if TriangleMT4 and TriangleMT agree on random rays and triangles.
+    template <typename T>
+    bool matches_triangle_mt()
+    {
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            TriangleMT<T> triangles[4];
+            TriangleMT4<T> triangles4;
+
+            for (size_t j = 0; j < 4; ++j)
+            {
+                triangles[j] =
+                    TriangleMT<T>(
+                        rand_vector<T>(rng, T(-1.0), T(1.0)),
+                        rand_vector<T>(rng, T(-1.0), T(1.0)),
+                        rand_vector<T>(rng, T(-1.0), T(1.0)));
+                triangles4.set(j, triangles[j]);
+            }
+
+            for (size_t j = 0; j < 100; ++j)
+            {
+                const Vector<T, 3> org = rand_vector<T>(rng, T(-3.0), T(3.0));
+                const Vector<T, 3> target = rand_vector<T>(rng, T(-1.0), T(1.0));
+                const Ray<T, 3> ray(org, target - org, T(0.0), rand1(rng, T(0.5), T(2.0)));
+
+                T t[4], u[4], v[4];
+                const size_t mask = triangles4.intersect(ray, t, u, v);
+
+                if (triangles4.intersect(ray) != mask)
+                    return false;
+
+                for (size_t k = 0; k < 4; ++k)
+                {
+                    T expected_t, expected_u, expected_v;
+                    const bool expected_hit = triangles[k].intersect(ray, expected_t, expected_u, expected_v);
+
+                    if (expected_hit != ((mask & (size_t(1) << k)) != 0))
+                        return false;
+
+                    // Allow for differences in rounding when the compiler contracts operations.
+                    const T Eps = T(1.0e-3);
+                    if (expected_hit &&
+                        !(fz(expected_t - t[k], Eps) && fz(expected_u - u[k], Eps) && fz(expected_v - v[k], Eps)))
+                        return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    TEST_CASE(Intersect_SinglePrecision_MatchesTriangleMT)
+    {
+        EXPECT_TRUE(matches_triangle_mt<float>());
+    }
+
+    TEST_CASE(Intersect_DoublePrecision_MatchesTriangleMT)
+    {
+        EXPECT_TRUE(matches_triangle_mt<double>());
+    }
+
+    TEST_CASE(Intersect_GivenStackedTriangles_ClosestHitIsNearestTriangle)
+    {
+        TriangleMT4<double> triangles;
+
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const double y = 1.0 - 0.25 * i;
+            triangles.set(
+                i,
+                TriangleMT<double>(
+                    Vector3d(0.5, y, 0.5),
+                    Vector3d(-0.5, y, 0.5),
+                    Vector3d(-0.5, y, -0.5)));
+        }
+
+        triangles.clear(3);
+
+        const Ray3d ray(Vector3d(-0.2, 2.0, 0.2), Vector3d(0.0, -1.0, 0.0));
+
+        double t[4], u[4], v[4];
+        const size_t mask = triangles.intersect(ray, t, u, v);
+
+        ASSERT_EQ(7, mask);
+        EXPECT_EQ(0, find_closest_hit(mask, t));
+        EXPECT_FEQ(1.0, t[0]);
+        EXPECT_EQ(1, find_closest_hit(6, t));
+    }
+}
+
 TEST_SUITE(Foundation_Math_Intersection_RayTriangleSSK)
 {
     typedef RayTriangleFixture<TriangleSSK<double> > Fixture;
@@ -30,10 +30,12 @@
 // appleseed.foundation headers.
 #include "foundation/platform/atomic.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/thread.h"
 #include "foundation/platform/timers.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/job/abortswitch.h"
 #include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobgraph.h"
 #include "foundation/utility/job/jobmanager.h"
 #include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/job/workerthread.h"
@@ -374,6 +376,203 @@ TEST_SUITE(Foundation_Utility_Job_JobManager)
 
         EXPECT_EQ(1, execution_count);
     }
+
+    struct SleepingJob
+      : public IJob
+    {
+        virtual void execute(const size_t thread_index) APPLESEED_OVERRIDE
+        {
+            foundation::sleep(10);
+        }
+    };
+
+    TEST_CASE_F(GetBusyTime_GivenNoJobWasExecuted_ReturnsZero, FixtureJobManager)
+    {
+        EXPECT_EQ(0.0, job_manager.get_busy_time(0));
+    }
+
+    TEST_CASE_F(GetBusyTime_GivenSleepingJobWasExecuted_ReturnsNonZero, FixtureJobManager)
+    {
+        job_queue.schedule(new SleepingJob());
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        EXPECT_GT(0.0, job_manager.get_busy_time(0));
+    }
+
+    struct FixtureWorkStealingJobManager
+    {
+        Logger      logger;
+        JobQueue    job_queue;
+        JobManager  job_manager;
+
+        FixtureWorkStealingJobManager()
+          : job_manager(logger, job_queue, 4, JobManager::WorkStealing)
+        {
+        }
+    };
+
+    TEST_CASE_F(JobManagerWithWorkStealingExecutesAllJobs, FixtureWorkStealingJobManager)
+    {
+        volatile uint32 execution_count = 0;
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            job_queue.schedule(
+                new JobNotifyingAboutExecution(&execution_count));
+        }
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(100, execution_count);
+        EXPECT_FALSE(job_queue.has_scheduled_or_running_jobs());
+    }
+
+    TEST_CASE_F(JobManagerWithWorkStealingExecutesSubJobs, FixtureWorkStealingJobManager)
+    {
+        volatile uint32 execution_count = 0;
+
+        job_queue.schedule(
+            new JobCreatingAnotherJob(job_queue, &execution_count));
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(1, execution_count);
+    }
+
+    TEST_CASE(JobManagerWithPinnedWorkerThreadsExecutesJobs)
+    {
+        Logger logger;
+        JobQueue job_queue;
+        JobManager job_manager(logger, job_queue, 2, JobManager::PinWorkerThreads);
+
+        volatile uint32 execution_count = 0;
+
+        for (size_t i = 0; i < 10; ++i)
+        {
+            job_queue.schedule(
+                new JobNotifyingAboutExecution(&execution_count));
+        }
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(10, execution_count);
+    }
+
+    TEST_CASE_F(StoppingJobManagerWithWorkStealingKeepsScheduledJobs, FixtureWorkStealingJobManager)
+    {
+        job_manager.start();
+        job_manager.stop();
+
+        job_queue.schedule(new EmptyJob());
+        job_queue.schedule(new EmptyJob());
+
+        EXPECT_EQ(2, job_queue.get_scheduled_job_count());
+    }
+}
+
+TEST_SUITE(Foundation_Utility_Job_JobGraph)
+{
+    // Record the rank at which the job was executed.
+    class JobRecordingExecutionRank
+      : public IJob
+    {
+      public:
+        JobRecordingExecutionRank(
+            volatile uint32*    next_rank,
+            volatile uint32*    rank)
+          : m_next_rank(next_rank)
+          , m_rank(rank)
+        {
+        }
+
+        virtual void execute(const size_t thread_index) APPLESEED_OVERRIDE
+        {
+            foundation::sleep(1);
+            atomic_write(m_rank, atomic_inc(m_next_rank));
+        }
+
+      private:
+        volatile uint32*    m_next_rank;
+        volatile uint32*    m_rank;
+    };
+
+    struct FixtureJobGraph
+    {
+        Logger          logger;
+        JobQueue        job_queue;
+        JobManager      job_manager;
+        JobGraph        job_graph;
+        volatile uint32 next_rank;
+        volatile uint32 ranks[4];
+
+        FixtureJobGraph()
+          : job_manager(logger, job_queue, 4)
+          , job_graph(job_queue)
+          , next_rank(0)
+        {
+            for (size_t i = 0; i < 4; ++i)
+            {
+                ranks[i] = ~uint32(0);
+                job_graph.add_job(new JobRecordingExecutionRank(&next_rank, &ranks[i]));
+            }
+        }
+    };
+
+    TEST_CASE_F(Schedule_GivenCycle_ReturnsFalseAndSchedulesNothing, FixtureJobGraph)
+    {
+        job_graph.add_dependency(0, 1);
+        job_graph.add_dependency(1, 2);
+        job_graph.add_dependency(2, 1);
+
+        EXPECT_FALSE(job_graph.schedule());
+        EXPECT_FALSE(job_queue.has_scheduled_jobs());
+    }
+
+    TEST_CASE_F(Schedule_GivenNoDependency_SchedulesAllJobs, FixtureJobGraph)
+    {
+        EXPECT_TRUE(job_graph.schedule());
+        EXPECT_EQ(4, job_queue.get_scheduled_job_count());
+    }
+
+    TEST_CASE_F(Schedule_GivenChain_ExecutesJobsInOrder, FixtureJobGraph)
+    {
+        job_graph.add_dependency(2, 1);
+        job_graph.add_dependency(1, 3);
+        job_graph.add_dependency(3, 0);
+
+        ASSERT_TRUE(job_graph.schedule());
+        EXPECT_EQ(1, job_queue.get_scheduled_job_count());
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(3, ranks[0]);
+        EXPECT_EQ(1, ranks[1]);
+        EXPECT_EQ(0, ranks[2]);
+        EXPECT_EQ(2, ranks[3]);
+    }
+
+    TEST_CASE_F(Schedule_GivenDiamond_ExecutesJoinJobLast, FixtureJobGraph)
+    {
+        job_graph.add_dependency(0, 1);
+        job_graph.add_dependency(0, 2);
+        job_graph.add_dependency(1, 3);
+        job_graph.add_dependency(2, 3);
+
+        ASSERT_TRUE(job_graph.schedule());
+
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        EXPECT_EQ(4, next_rank);
+        EXPECT_EQ(0, ranks[0]);
+        EXPECT_EQ(3, ranks[3]);
+    }
 }
 
 TEST_SUITE(Foundation_Utility_Job_WorkerThread)
@@ -420,7 +619,8 @@ TEST_SUITE(Foundation_Utility_Job_WorkerThread)
         job_queue.schedule(new JobThrowingBadAllocException());
 
         Logger logger;
-        WorkerThread worker(0, logger, job_queue, 0);
+        boost::atomic<uint64> busy_time(0);
+        WorkerThread worker(0, logger, job_queue, 0, busy_time);
 
         worker.start();
 
@@ -444,7 +644,8 @@ TEST_SUITE(Foundation_Utility_Job_WorkerThread)
         job_queue.schedule(new JobNotifyingAboutExecution(&execution_count));
 
         Logger logger;
-        WorkerThread worker(0, logger, job_queue, 0);
+        boost::atomic<uint64> busy_time(0);
+        WorkerThread worker(0, logger, job_queue, 0, busy_time);
 
         worker.start();
 
@@ -469,7 +670,8 @@ TEST_SUITE(Foundation_Utility_Job_WorkerThread)
         job_queue.schedule(new JobNotifyingAboutExecution(&execution_count));
 
         Logger logger;
-        WorkerThread worker(0, logger, job_queue, JobManager::KeepRunningOnJobFailure);
+        boost::atomic<uint64> busy_time(0);
+        WorkerThread worker(0, logger, job_queue, JobManager::KeepRunningOnJobFailure, busy_time);
 
         worker.start();
 
@@ -141,6 +141,54 @@ TEST_SUITE(Foundation_Math_Knn_Builder)
         knn::Builder3d builder(tree);
         builder.build<DefaultWallclockTimer>(points, PointCount);
     }
+
+    TEST_CASE(BuildMovePoints_GivenSeveralThreads_BuildsSameTreeAsSingleThreadedBuild)
+    {
+        const size_t PointCount = 20000;
+
+        MersenneTwister rng;
+
+        vector<Vector3d> points;
+        points.reserve(PointCount);
+        for (size_t i = 0; i < PointCount; ++i)
+            points.push_back(rand_vector1<Vector3d>(rng));
+
+        vector<Vector3d> points_copy(points);
+
+        knn::Tree3d serial_tree;
+        knn::Builder3d serial_builder(serial_tree);
+        serial_builder.build_move_points<DefaultWallclockTimer>(points);
+
+        knn::Tree3d parallel_tree;
+        knn::Builder3d parallel_builder(parallel_tree);
+        parallel_builder.build_move_points<DefaultWallclockTimer>(points_copy, 4);
+
+        ASSERT_EQ(serial_tree.m_nodes.size(), parallel_tree.m_nodes.size());
+        EXPECT_EQ(serial_tree.m_indices, parallel_tree.m_indices);
+        EXPECT_EQ(serial_tree.m_points, parallel_tree.m_points);
+
+        knn::Answer<double> serial_answer(10);
+        knn::Query3d serial_query(serial_tree, serial_answer);
+
+        knn::Answer<double> parallel_answer(10);
+        knn::Query3d parallel_query(parallel_tree, parallel_answer);
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            const Vector3d q = rand_vector1<Vector3d>(rng);
+
+            serial_query.run(q);
+            serial_answer.sort();
+
+            parallel_query.run(q);
+            parallel_answer.sort();
+
+            ASSERT_EQ(serial_answer.size(), parallel_answer.size());
+
+            for (size_t j = 0; j < serial_answer.size(); ++j)
+                EXPECT_EQ(serial_answer.get(j).m_index, parallel_answer.get(j).m_index);
+        }
+    }
 }
 
 TEST_SUITE(Foundation_Math_Knn_Answer)
@@ -443,4 +491,110 @@ TEST_SUITE(Foundation_Math_Knn_Query)
 
         EXPECT_TRUE(do_results_match_naive_algorithm(points, AnswerSize, QueryCount, rng));
     }
+
+    TEST_CASE(Run_GivenSinglePrecisionPoints_ReturnsSameDistancesAsNaiveAlgorithm)
+    {
+        const size_t PointCount = 1000;
+        const size_t QueryCount = 200;
+        const size_t AnswerSize = 23;
+
+        MersenneTwister rng;
+
+        vector<Vector3f> points;
+        points.reserve(PointCount);
+        for (size_t i = 0; i < PointCount; ++i)
+            points.push_back(rand_vector1<Vector3f>(rng));
+
+        knn::Tree3f tree;
+        knn::Builder3f builder(tree);
+        builder.build<DefaultWallclockTimer>(&points[0], PointCount);
+
+        knn::Answer<float> answer(AnswerSize);
+        knn::Query3f query(tree, answer);
+
+        bool match = true;
+
+        for (size_t i = 0; i < QueryCount; ++i)
+        {
+            const Vector3f q = rand_vector1<Vector3f>(rng);
+
+            vector<float> ref_square_dists(PointCount);
+            for (size_t j = 0; j < PointCount; ++j)
+                ref_square_dists[j] = square_distance(points[j], q);
+            sort(ref_square_dists.begin(), ref_square_dists.end());
+
+            query.run(q);
+            answer.sort();
+
+            if (answer.size() != AnswerSize)
+                match = false;
+
+            for (size_t j = 0; j < answer.size(); ++j)
+            {
+                if (answer.get(j).m_square_dist != ref_square_dists[j])
+                    match = false;
+            }
+        }
+
+        EXPECT_TRUE(match);
+    }
+
+    struct RecordAnswersVisitor
+    {
+        vector<vector<size_t> >     m_answers;
+
+        explicit RecordAnswersVisitor(const size_t query_count)
+          : m_answers(query_count)
+        {
+        }
+
+        void visit(const size_t query_index, knn::Answer<float>& answer)
+        {
+            answer.sort();
+
+            for (size_t i = 0; i < answer.size(); ++i)
+                m_answers[query_index].push_back(answer.get(i).m_index);
+        }
+    };
+
+    TEST_CASE(Run_GivenBatchOfQueryPoints_ReturnsSameAnswersAsIndividualQueries)
+    {
+        const size_t PointCount = 1000;
+        const size_t QueryCount = 100;
+        const size_t AnswerSize = 10;
+        const float QueryMaxSquareDistance = square(0.2f);
+
+        MersenneTwister rng;
+
+        vector<Vector3f> points;
+        points.reserve(PointCount);
+        for (size_t i = 0; i < PointCount; ++i)
+            points.push_back(rand_vector1<Vector3f>(rng));
+
+        vector<Vector3f> query_points;
+        query_points.reserve(QueryCount);
+        for (size_t i = 0; i < QueryCount; ++i)
+            query_points.push_back(rand_vector1<Vector3f>(rng));
+
+        knn::Tree3f tree;
+        knn::Builder3f builder(tree);
+        builder.build<DefaultWallclockTimer>(&points[0], PointCount);
+
+        knn::Answer<float> answer(AnswerSize);
+        knn::Query3f query(tree, answer);
+
+        RecordAnswersVisitor visitor(QueryCount);
+        query.run(&query_points[0], QueryCount, QueryMaxSquareDistance, visitor);
+
+        for (size_t i = 0; i < QueryCount; ++i)
+        {
+            query.run(query_points[i], QueryMaxSquareDistance);
+            answer.sort();
+
+            ASSERT_EQ(answer.size(), visitor.m_answers[i].size());
+
+            for (size_t j = 0; j < answer.size(); ++j)
+                EXPECT_EQ(answer.get(j).m_index, visitor.m_answers[i][j]);
+        }
+    }
 }
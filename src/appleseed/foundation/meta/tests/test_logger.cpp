@@ -0,0 +1,147 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/platform/thread.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/log.h"
+#include "foundation/utility/test.h"
+
+// Boost headers.
+#include "boost/bind.hpp"
+#include "boost/thread/thread.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Utility_Log_Logger)
+{
+    struct Fixture
+    {
+        Logger                              m_logger;
+        auto_release_ptr<StringLogTarget>   m_target;
+
+        Fixture()
+          : m_target(create_string_log_target())
+        {
+            m_logger.set_all_formats("{message}");
+            m_logger.add_target(m_target.get());
+        }
+
+        ~Fixture()
+        {
+            m_logger.set_async(false);
+            m_logger.remove_target(m_target.get());
+        }
+    };
+
+    TEST_CASE_F(Write_SynchronousMode_WritesMessageImmediately, Fixture)
+    {
+        LOG_INFO(m_logger, "hello %d", 42);
+
+        EXPECT_EQ("hello 42\n", string(m_target->get_string()));
+    }
+
+    TEST_CASE_F(SetAsync_EnablesAsynchronousMode, Fixture)
+    {
+        m_logger.set_async(true);
+
+        EXPECT_TRUE(m_logger.is_async());
+    }
+
+    TEST_CASE_F(Write_AsynchronousMode_WritesMessagesInOrderAfterFlush, Fixture)
+    {
+        m_logger.set_async(true);
+
+        LOG_INFO(m_logger, "a");
+        LOG_INFO(m_logger, "b");
+        LOG_INFO(m_logger, "c");
+        m_logger.flush();
+
+        EXPECT_EQ("a\nb\nc\n", string(m_target->get_string()));
+    }
+
+    TEST_CASE_F(SetAsync_DisablingAsynchronousMode_WritesQueuedMessages, Fixture)
+    {
+        m_logger.set_async(true);
+
+        LOG_INFO(m_logger, "a");
+        m_logger.set_async(false);
+
+        EXPECT_FALSE(m_logger.is_async());
+        EXPECT_EQ("a\n", string(m_target->get_string()));
+    }
+
+    TEST_CASE_F(Write_AsynchronousMode_MessageBelowVerbosityLevel_IsNotWritten, Fixture)
+    {
+        m_logger.set_async(true);
+        m_logger.set_verbosity_level(LogMessage::Warning);
+
+        LOG_INFO(m_logger, "a");
+        m_logger.flush();
+
+        EXPECT_EQ("", string(m_target->get_string()));
+    }
+
+    void write_messages(Logger* logger, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            LOG_INFO(*logger, "x");
+    }
+
+    TEST_CASE_F(Write_AsynchronousMode_ManyThreads_EveryMessageIsWrittenOrDropped, Fixture)
+    {
+        const size_t ThreadCount = 8;
+        const size_t MessageCount = 1000;
+
+        m_logger.set_all_formats("{message}");
+        m_logger.set_async(true, 16);
+
+        boost::thread_group threads;
+        for (size_t i = 0; i < ThreadCount; ++i)
+            threads.create_thread(boost::bind(write_messages, &m_logger, MessageCount));
+        threads.join_all();
+
+        m_logger.set_async(false);
+
+        const string output = m_target->get_string();
+        size_t written = 0;
+        for (size_t i = 0; i < output.size(); ++i)
+        {
+            if (output[i] == 'x')
+                ++written;
+        }
+
+        EXPECT_EQ(ThreadCount * MessageCount, written + m_logger.get_dropped_message_count());
+    }
+}
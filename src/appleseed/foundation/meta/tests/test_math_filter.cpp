@@ -60,6 +60,27 @@ namespace
             fz(filter.evaluate(-filter.get_xradius(),                T(0.0)), Eps);
     }
 
+    template <typename T>
+    bool is_separable(const Filter2<T>& filter)
+    {
+        const size_t PointCount = 16;
+
+        for (size_t j = 0; j < PointCount; ++j)
+        {
+            const T y = fit<size_t, T>(j, 0, PointCount - 1, -filter.get_yradius(), filter.get_yradius());
+
+            for (size_t i = 0; i < PointCount; ++i)
+            {
+                const T x = fit<size_t, T>(i, 0, PointCount - 1, -filter.get_xradius(), filter.get_xradius());
+
+                if (!feq(filter.evaluate(x, y), filter.evaluate_x(x) * filter.evaluate_y(y)))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
     template <typename T>
     vector<Vector2d> make_points(const Filter2<T>& filter)
     {
@@ -117,6 +138,13 @@ TEST_SUITE(Foundation_Math_Filter_BoxFilter2)
         EXPECT_EQ(3.0, filter.get_yradius());
     }
 
+    TEST_CASE(Evaluate_ReturnsProductOfEvaluateXAndEvaluateY)
+    {
+        const BoxFilter2<double> filter(2.0, 3.0);
+
+        EXPECT_TRUE(is_separable(filter));
+    }
+
     TEST_CASE(Plot)
     {
         const BoxFilter2<double> filter(2.0, 3.0);
@@ -137,6 +165,13 @@ TEST_SUITE(Foundation_Math_Filter_TriangleFilter2)
         EXPECT_TRUE(is_zero_on_domain_border(filter));
     }
 
+    TEST_CASE(Evaluate_ReturnsProductOfEvaluateXAndEvaluateY)
+    {
+        const TriangleFilter2<double> filter(2.0, 3.0);
+
+        EXPECT_TRUE(is_separable(filter));
+    }
+
     TEST_CASE(Plot)
     {
         const TriangleFilter2<double> filter(2.0, 3.0);
@@ -159,6 +194,13 @@ TEST_SUITE(Foundation_Math_Filter_GaussianFilter2)
         EXPECT_TRUE(is_zero_on_domain_border(filter));
     }
 
+    TEST_CASE(Evaluate_ReturnsProductOfEvaluateXAndEvaluateY)
+    {
+        const GaussianFilter2<double> filter(2.0, 3.0, Alpha);
+
+        EXPECT_TRUE(is_separable(filter));
+    }
+
     TEST_CASE(Plot)
     {
         const GaussianFilter2<double> accurate_filter(2.0, 3.0, Alpha);
@@ -184,6 +226,13 @@ TEST_SUITE(Foundation_Math_Filter_MitchellFilter2)
         EXPECT_TRUE(is_zero_on_domain_border(filter));
     }
 
+    TEST_CASE(Evaluate_ReturnsProductOfEvaluateXAndEvaluateY)
+    {
+        const MitchellFilter2<double> filter(2.0, 3.0, B, C);
+
+        EXPECT_TRUE(is_separable(filter));
+    }
+
     TEST_CASE(Plot)
     {
         const MitchellFilter2<double> filter(2.0, 3.0, B, C);
@@ -206,6 +255,13 @@ TEST_SUITE(Foundation_Math_Filter_LanczosFilter2)
         EXPECT_TRUE(is_zero_on_domain_border(filter));
     }
 
+    TEST_CASE(Evaluate_ReturnsProductOfEvaluateXAndEvaluateY)
+    {
+        const LanczosFilter2<double> filter(2.0, 3.0, Tau);
+
+        EXPECT_TRUE(is_separable(filter));
+    }
+
     TEST_CASE(Plot)
     {
         const LanczosFilter2<double> filter(2.0, 3.0, Tau);
@@ -226,6 +282,13 @@ TEST_SUITE(Foundation_Math_Filter_BlackmanHarrisFilter2)
         EXPECT_TRUE(is_zero_on_domain_border(filter));
     }
 
+    TEST_CASE(Evaluate_ReturnsProductOfEvaluateXAndEvaluateY)
+    {
+        const BlackmanHarrisFilter2<double> filter(2.0, 3.0);
+
+        EXPECT_TRUE(is_separable(filter));
+    }
+
     TEST_CASE(Plot)
     {
         const BlackmanHarrisFilter2<double> accurate_filter(2.0, 3.0);
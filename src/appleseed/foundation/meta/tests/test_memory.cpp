@@ -224,6 +224,47 @@ TEST_SUITE(Foundation_Utility_Memory)
         EXPECT_EQ(default_capacity, v.capacity());
     }
 
+    TEST_CASE(LargePageMalloc_GivenSizeOfSeveralLargePages_ReturnsLargePageAlignedWritableMemory)
+    {
+        const size_t size = 3 * get_large_page_size() + 1;
+        char* ptr = static_cast<char*>(large_page_malloc(size, 16));
+
+        ASSERT_TRUE(ptr != 0);
+        EXPECT_TRUE(is_aligned(ptr, 16));
+
+        ptr[0] = 1;
+        ptr[size - 1] = 2;
+        EXPECT_EQ(1, ptr[0]);
+        EXPECT_EQ(2, ptr[size - 1]);
+
+        large_page_free(ptr, size);
+    }
+
+    TEST_CASE(LargePageMalloc_GivenSmallSize_ReturnsAlignedMemory)
+    {
+        void* ptr = large_page_malloc(100, 64);
+
+        ASSERT_TRUE(ptr != 0);
+        EXPECT_TRUE(is_aligned(ptr, 64));
+
+        large_page_free(ptr, 100);
+    }
+
+    TEST_CASE(ClearReleaseMemory_GivenLargeVector_UsingLargePageAlignedAllocator_ResetsVectorCapacityToDefaultValue)
+    {
+        typedef AlignedAllocator<int> Allocator;
+
+        vector<int, AlignedAllocator<int> > v(Allocator(32, true));
+        const size_t default_capacity = v.capacity();
+
+        v.resize(get_large_page_size());
+        EXPECT_TRUE(is_aligned(&v[0], 32));
+
+        clear_release_memory(v);
+
+        EXPECT_EQ(default_capacity, v.capacity());
+    }
+
     TEST_CASE(ClearKeepMemory_GivenVectorWithThousandElements_ClearsVector)
     {
         vector<int> v(1000);
@@ -0,0 +1,163 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// appleseed.foundation headers.
+#include "foundation/platform/types.h"
+#include "foundation/utility/memorytracker.h"
+#include "foundation/utility/test.h"
+
+// Boost headers.
+#include "boost/bind.hpp"
+#include "boost/thread/thread.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Utility_MemoryTracker)
+{
+    TEST_CASE(GetSize_GivenNewTracker_ReturnsZero)
+    {
+        MemoryTracker tracker;
+
+        EXPECT_EQ(0, tracker.get_size(MemoryTracker::Textures));
+        EXPECT_EQ(0, tracker.get_total_size());
+    }
+
+    TEST_CASE(GetSize_GivenAllocationsAndReleases_ReturnsSizeOfCategory)
+    {
+        MemoryTracker tracker;
+
+        tracker.allocate(MemoryTracker::Trees, 1000);
+        tracker.allocate(MemoryTracker::Trees, 500);
+        tracker.release(MemoryTracker::Trees, 200);
+        tracker.allocate(MemoryTracker::Textures, 64);
+
+        EXPECT_EQ(1300, tracker.get_size(MemoryTracker::Trees));
+        EXPECT_EQ(64, tracker.get_size(MemoryTracker::Textures));
+        EXPECT_EQ(0, tracker.get_size(MemoryTracker::PhotonMaps));
+        EXPECT_EQ(1364, tracker.get_total_size());
+    }
+
+    void allocate(MemoryTracker* tracker, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            tracker->allocate(MemoryTracker::FrameBuffers, 10);
+    }
+
+    void release(MemoryTracker* tracker, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            tracker->release(MemoryTracker::FrameBuffers, 10);
+    }
+
+    TEST_CASE(GetSize_GivenAllocationsFromSeveralThreads_MergesThreadCounters)
+    {
+        MemoryTracker tracker;
+
+        boost::thread thread1(boost::bind(&allocate, &tracker, 100));
+        boost::thread thread2(boost::bind(&allocate, &tracker, 100));
+        thread1.join();
+        thread2.join();
+
+        EXPECT_EQ(2000, tracker.get_size(MemoryTracker::FrameBuffers));
+    }
+
+    TEST_CASE(GetSize_GivenMemoryReleasedByAnotherThread_ReturnsZero)
+    {
+        MemoryTracker tracker;
+
+        allocate(&tracker, 100);
+
+        boost::thread thread(boost::bind(&release, &tracker, 100));
+        thread.join();
+
+        EXPECT_EQ(0, tracker.get_size(MemoryTracker::FrameBuffers));
+    }
+
+    TEST_CASE(TrackedMemorySize_Set_RecordsDifferenceWithPreviousSize)
+    {
+        MemoryTracker tracker;
+        TrackedMemorySize size(MemoryTracker::Tessellations, tracker);
+
+        size.set(100);
+        size.set(250);
+        size.set(50);
+
+        EXPECT_EQ(50, size.get());
+        EXPECT_EQ(50, tracker.get_size(MemoryTracker::Tessellations));
+    }
+
+    TEST_CASE(TrackedMemorySize_Destructor_ReleasesSize)
+    {
+        MemoryTracker tracker;
+
+        {
+            TrackedMemorySize size(MemoryTracker::ImageStacks, tracker);
+            size.set(100);
+        }
+
+        EXPECT_EQ(0, tracker.get_size(MemoryTracker::ImageStacks));
+    }
+
+    TEST_CASE(TrackedMemorySize_CopyConstructor_TracksSizeAgain)
+    {
+        MemoryTracker tracker;
+        TrackedMemorySize size(MemoryTracker::ImageStacks, tracker);
+        size.set(100);
+
+        {
+            TrackedMemorySize copy(size);
+            EXPECT_EQ(200, tracker.get_size(MemoryTracker::ImageStacks));
+        }
+
+        EXPECT_EQ(100, tracker.get_size(MemoryTracker::ImageStacks));
+    }
+
+    TEST_CASE(GetStatistics_ReturnsOneEntryPerCategoryAndTotal)
+    {
+        MemoryTracker tracker;
+        tracker.allocate(MemoryTracker::PhotonMaps, 2048);
+
+        const string statistics = tracker.get_statistics().to_string();
+
+        for (size_t i = 0; i < MemoryTracker::CategoryCount; ++i)
+        {
+            const MemoryTracker::Category category = static_cast<MemoryTracker::Category>(i);
+            EXPECT_NEQ(string::npos, statistics.find(MemoryTracker::get_category_name(category)));
+        }
+
+        EXPECT_NEQ(string::npos, statistics.find("total"));
+        EXPECT_NEQ(string::npos, statistics.find("2.0 KB"));
+    }
+}
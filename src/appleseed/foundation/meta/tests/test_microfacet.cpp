@@ -374,5 +374,41 @@ TEST_SUITE(Foundation_Math_Microfacet)
     }
 
 
+    //
+    // Albedo tables.
+    //
+
+    TEST_CASE(MDFAlbedoTable_GivenSmoothGGX_DirectionalAlbedoIsCloseToOne)
+    {
+        const GGXMDF mdf;
+        const MDFAlbedoTable table(mdf);
+
+        EXPECT_FEQ_EPS(1.0f, table.get_directional_albedo(1.0f, 0.0f), 0.01f);
+        EXPECT_FEQ_EPS(1.0f, table.get_directional_albedo(0.5f, 0.0f), 0.01f);
+    }
+
+    TEST_CASE(MDFAlbedoTable_GivenRoughGGX_LosesEnergy)
+    {
+        const GGXMDF mdf;
+        const MDFAlbedoTable table(mdf);
+
+        const float albedo = table.get_directional_albedo(0.5f, 1.0f);
+        const float avg_albedo = table.get_average_albedo(1.0f);
+
+        EXPECT_LT(0.9f, albedo);
+        EXPECT_GT(0.2f, albedo);
+        EXPECT_LT(0.9f, avg_albedo);
+        EXPECT_GT(0.2f, avg_albedo);
+    }
+
+    TEST_CASE(MDFAlbedoTable_GivenBeckmann_AverageAlbedoDecreasesWithRoughness)
+    {
+        const BeckmannMDF mdf;
+        const MDFAlbedoTable table(mdf);
+
+        EXPECT_GT(table.get_average_albedo(0.5f), table.get_average_albedo(0.1f));
+        EXPECT_GT(table.get_average_albedo(1.0f), table.get_average_albedo(0.5f));
+    }
+
 #undef EXPECT_WEAK_WHITE_FURNACE_PASS
 }
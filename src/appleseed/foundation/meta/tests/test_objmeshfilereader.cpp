@@ -32,6 +32,7 @@
 #include "foundation/mesh/meshbuilderbase.h"
 #include "foundation/mesh/objmeshfilereader.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/utility/iostreamop.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
@@ -121,4 +122,30 @@ TEST_SUITE(Foundation_Mesh_OBJMeshFileReader)
         EXPECT_EQ(4, mesh.m_tex_coords.size());
         EXPECT_EQ(1, mesh.m_faces.size());
     }
+
+    TEST_CASE(ReadCubeMeshFile_GivenParallelParsing_MatchesSequentialParsing)
+    {
+        MeshBuilder sequential_builder;
+        OBJMeshFileReader sequential_reader("unit tests/inputs/test_objmeshfilereader_cube.obj");
+        sequential_reader.read(sequential_builder);
+
+        MeshBuilder parallel_builder;
+        OBJMeshFileReader parallel_reader(
+            "unit tests/inputs/test_objmeshfilereader_cube.obj",
+            OBJMeshFileReader::ParallelParsing);
+        parallel_reader.read(parallel_builder);
+
+        ASSERT_EQ(1, parallel_builder.m_meshes.size());
+
+        const Mesh& expected = sequential_builder.m_meshes.front();
+        const Mesh& mesh = parallel_builder.m_meshes.front();
+        EXPECT_EQ(expected.m_name, mesh.m_name);
+        ASSERT_EQ(expected.m_vertices.size(), mesh.m_vertices.size());
+        ASSERT_EQ(expected.m_vertex_normals.size(), mesh.m_vertex_normals.size());
+        ASSERT_EQ(expected.m_tex_coords.size(), mesh.m_tex_coords.size());
+        EXPECT_SEQUENCE_EQ(expected.m_vertices.size(), &expected.m_vertices[0], &mesh.m_vertices[0]);
+        EXPECT_SEQUENCE_EQ(expected.m_vertex_normals.size(), &expected.m_vertex_normals[0], &mesh.m_vertex_normals[0]);
+        EXPECT_SEQUENCE_EQ(expected.m_tex_coords.size(), &expected.m_tex_coords[0], &mesh.m_tex_coords[0]);
+        EXPECT_EQ(expected.m_faces.size(), mesh.m_faces.size());
+    }
 }
@@ -0,0 +1,87 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.foundation headers.
+#include "foundation/math/octahedral.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/sampling/mappings.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Math_Octahedral)
+{
+    TEST_CASE(OctahedralDecode_GivenEncodedAxis_ReturnsAxis)
+    {
+        const Vector3f Axes[6] =
+        {
+            Vector3f( 1.0f, 0.0f, 0.0f),
+            Vector3f(-1.0f, 0.0f, 0.0f),
+            Vector3f(0.0f,  1.0f, 0.0f),
+            Vector3f(0.0f, -1.0f, 0.0f),
+            Vector3f(0.0f, 0.0f,  1.0f),
+            Vector3f(0.0f, 0.0f, -1.0f)
+        };
+
+        for (size_t i = 0; i < 6; ++i)
+        {
+            const uint32 code = octahedral_encode(Axes[i]);
+            EXPECT_FEQ_EPS(Axes[i], octahedral_decode<float>(code), 1.0e-4f);
+        }
+    }
+
+    TEST_CASE(OctahedralDecode_GivenEncodedRandomUnitVectors_ReturnsCloseVectors)
+    {
+        MersenneTwister rng;
+
+        float max_angle = 0.0f;
+
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            Vector2f s;
+            s[0] = rand_float2(rng);
+            s[1] = rand_float2(rng);
+
+            const Vector3f v = sample_sphere_uniform(s);
+            const Vector3f decoded = octahedral_decode<float>(octahedral_encode(v));
+
+            EXPECT_FEQ_EPS(1.0f, norm(decoded), 1.0e-5f);
+
+            max_angle = max(max_angle, std::asin(min(norm(cross(v, decoded)), 1.0f)));
+        }
+
+        EXPECT_LT(deg_to_rad(0.005f), max_angle);
+    }
+}
@@ -0,0 +1,141 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/math/hash.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/containers/openhashtable.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+
+TEST_SUITE(Foundation_Utility_Containers_OpenHashTable)
+{
+    struct KeyHasher
+    {
+        size_t operator()(const uint32 key) const
+        {
+            return hash_uint32(key);
+        }
+    };
+
+    // A hasher sending all keys to the same slot, to exercise probing.
+    struct ConstantKeyHasher
+    {
+        size_t operator()(const uint32 key) const
+        {
+            return 7;
+        }
+    };
+
+    typedef OpenHashTable<uint32, KeyHasher, size_t> TableType;
+    typedef OpenHashTable<uint32, ConstantKeyHasher, size_t> CollidingTableType;
+
+    TEST_CASE(Find_GivenEmptyTable_ReturnsNull)
+    {
+        KeyHasher hasher;
+        TableType table(hasher);
+
+        EXPECT_EQ(0, table.find(42));
+    }
+
+    TEST_CASE(Resize_KeepsTableAtMostHalfFull)
+    {
+        KeyHasher hasher;
+        TableType table(hasher);
+
+        table.resize(100);
+
+        EXPECT_EQ(256, table.capacity());
+        EXPECT_EQ(0, table.size());
+    }
+
+    TEST_CASE(Get_GivenInsertedKeys_ReturnsValues)
+    {
+        KeyHasher hasher;
+        TableType table(hasher);
+
+        const size_t Count = 1000;
+        table.resize(Count);
+
+        for (size_t i = 0; i < Count; ++i)
+            table.insert(static_cast<uint32>(i * 3), i);
+
+        EXPECT_EQ(Count, table.size());
+
+        for (size_t i = 0; i < Count; ++i)
+            EXPECT_EQ(i, table.get(static_cast<uint32>(i * 3)));
+    }
+
+    TEST_CASE(Find_GivenMissingKey_ReturnsNull)
+    {
+        KeyHasher hasher;
+        TableType table(hasher);
+
+        table.resize(10);
+
+        for (uint32 i = 0; i < 10; ++i)
+            table.insert(i * 2, i);
+
+        EXPECT_EQ(0, table.find(3));
+        EXPECT_EQ(0, table.find(1000));
+    }
+
+    TEST_CASE(Get_GivenCollidingKeys_ReturnsValues)
+    {
+        ConstantKeyHasher hasher;
+        CollidingTableType table(hasher);
+
+        table.resize(8);
+
+        for (uint32 i = 0; i < 8; ++i)
+            table.insert(i, 10 * i);
+
+        for (uint32 i = 0; i < 8; ++i)
+            EXPECT_EQ(10 * i, table.get(i));
+
+        EXPECT_EQ(0, table.find(8));
+    }
+
+    TEST_CASE(Resize_ClearsTable)
+    {
+        KeyHasher hasher;
+        TableType table(hasher);
+
+        table.resize(4);
+        table.insert(1, 1);
+        table.resize(4);
+
+        EXPECT_EQ(0, table.size());
+        EXPECT_EQ(0, table.find(1));
+    }
+}
@@ -0,0 +1,120 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.foundation headers.
+#include "foundation/utility/phaseprofile.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <string>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Utility_PhaseProfile)
+{
+    TEST_CASE(GetPhaseCount_GivenNoPhase_ReturnsZero)
+    {
+        PhaseProfile profile;
+
+        EXPECT_EQ(0, profile.get_phase_count());
+        EXPECT_EQ("", profile.to_string());
+    }
+
+    TEST_CASE(EndPhase_GivenNestedPhases_RecordsPhasesInBeginOrderWithDepths)
+    {
+        PhaseProfile profile;
+
+        profile.begin_phase("outer");
+        {
+            ScopedPhase phase(profile, "inner 1");
+        }
+        {
+            ScopedPhase phase(profile, "inner 2");
+        }
+        profile.end_phase();
+        profile.begin_phase("last");
+        profile.end_phase();
+
+        ASSERT_EQ(4, profile.get_phase_count());
+        EXPECT_EQ(string("outer"), profile.get_phase_name(0));
+        EXPECT_EQ(0, profile.get_phase_depth(0));
+        EXPECT_EQ(string("inner 1"), profile.get_phase_name(1));
+        EXPECT_EQ(1, profile.get_phase_depth(1));
+        EXPECT_EQ(string("inner 2"), profile.get_phase_name(2));
+        EXPECT_EQ(1, profile.get_phase_depth(2));
+        EXPECT_EQ(string("last"), profile.get_phase_name(3));
+        EXPECT_EQ(0, profile.get_phase_depth(3));
+    }
+
+    TEST_CASE(EndPhase_GivenNestedPhases_OuterPhaseLastsAtLeastAsLongAsInnerPhases)
+    {
+        PhaseProfile profile;
+
+        profile.begin_phase("outer");
+        profile.begin_phase("inner");
+        profile.end_phase();
+        profile.end_phase();
+
+        EXPECT_TRUE(profile.get_phase_seconds(0) >= profile.get_phase_seconds(1));
+        EXPECT_TRUE(profile.get_phase_peak_memory(0) >= profile.get_phase_peak_memory(1));
+    }
+
+    TEST_CASE(Append_GivenOpenPhase_NestsAppendedPhasesInOpenPhase)
+    {
+        PhaseProfile loading;
+        loading.begin_phase("loading");
+        loading.begin_phase("parsing");
+        loading.end_phase();
+        loading.end_phase();
+
+        PhaseProfile profile;
+        profile.begin_phase("startup");
+        profile.append(loading);
+        profile.end_phase();
+
+        ASSERT_EQ(3, profile.get_phase_count());
+        EXPECT_EQ(string("startup"), profile.get_phase_name(0));
+        EXPECT_EQ(0, profile.get_phase_depth(0));
+        EXPECT_EQ(string("loading"), profile.get_phase_name(1));
+        EXPECT_EQ(1, profile.get_phase_depth(1));
+        EXPECT_EQ(string("parsing"), profile.get_phase_name(2));
+        EXPECT_EQ(2, profile.get_phase_depth(2));
+        EXPECT_EQ(loading.get_phase_seconds(0), profile.get_phase_seconds(1));
+    }
+
+    TEST_CASE(Clear_RemovesAllPhases)
+    {
+        PhaseProfile profile;
+        profile.begin_phase("phase");
+        profile.end_phase();
+
+        profile.clear();
+
+        EXPECT_EQ(0, profile.get_phase_count());
+    }
+}
@@ -101,4 +101,45 @@ TEST_SUITE(Foundation_Image_Pixel)
 
         EXPECT_EQ(4294967295UL, output);
     }
+
+    TEST_CASE(ConvertAndShuffle_FloatToUInt8_MatchesConvert)
+    {
+        // Five RGBA pixels, to exercise both the four-pixel loop and the remainder.
+        const float input[5 * 4] =
+        {
+            0.0f, 0.5f, 1.0f, 0.25f,
+            -1.0f, 2.0f, 0.999f, 0.0039f,
+            0.1f, 0.2f, 0.3f, 0.4f,
+            0.6f, 0.7f, 0.8f, 0.9f,
+            1.0f, 0.0f, 0.5f, 0.75f
+        };
+
+        const size_t ShuffleTable[] = { 2, 1, 0, Pixel::SkipChannel };
+
+        uint8 output[5 * 3];
+        Pixel::convert_and_shuffle(
+            PixelFormatFloat,
+            4,
+            input, input + 5 * 4,
+            PixelFormatUInt8,
+            3,
+            output,
+            ShuffleTable);
+
+        for (size_t i = 0; i < 5; ++i)
+        {
+            for (size_t c = 0; c < 3; ++c)
+            {
+                uint8 expected;
+                Pixel::convert_from_format(
+                    PixelFormatFloat,
+                    &input[i * 4 + ShuffleTable[c]], &input[i * 4 + ShuffleTable[c]] + 1,
+                    1,
+                    &expected,
+                    1);
+
+                EXPECT_EQ(expected, output[i * 3 + c]);
+            }
+        }
+    }
 }
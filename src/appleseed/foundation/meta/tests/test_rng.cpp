@@ -34,6 +34,9 @@
 #ifdef APPLESEED_USE_SSE
 #include "foundation/math/rng/simdmersennetwister.h"
 #endif
+#include "foundation/math/rng/simdpcg.h"
+#include "foundation/math/rng/simdxorshift.h"
+#include "foundation/math/rng/xorshift.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/countof.h"
 #include "foundation/utility/test.h"
@@ -997,3 +1000,138 @@ TEST_SUITE(Foundation_Math_RNG_SimdMersenneTwister)
 }
 
 #endif
+
+TEST_SUITE(Foundation_Math_RNG_SimdPCG)
+{
+    template <size_t Lanes>
+    bool lanes_match_scalar_generators()
+    {
+        const uint64 InitState = 42;
+        const uint64 InitSeq = 54;
+
+        for (size_t i = 0; i < Lanes; ++i)
+        {
+            SimdPCG<Lanes> lane_rng(InitState, InitSeq);
+            PCG scalar_rng(InitState, InitSeq + i);
+
+            for (size_t j = 0; j < 100; ++j)
+            {
+                uint32 values[Lanes];
+                lane_rng.rand_uint32(values);
+
+                if (values[i] != scalar_rng.rand_uint32())
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    TEST_CASE(RandUint32_4Lanes_LanesMatchScalarGenerators)
+    {
+        EXPECT_TRUE(lanes_match_scalar_generators<4>());
+    }
+
+    TEST_CASE(RandUint32_8Lanes_LanesMatchScalarGenerators)
+    {
+        EXPECT_TRUE(lanes_match_scalar_generators<8>());
+    }
+
+    TEST_CASE(RandUint32_Scalar_ReturnsValuesOfSuccessiveBatches)
+    {
+        SimdPCG<4> batch_rng;
+        SimdPCG<4> scalar_rng;
+
+        for (size_t j = 0; j < 10; ++j)
+        {
+            uint32 values[4];
+            batch_rng.rand_uint32(values);
+
+            for (size_t i = 0; i < 4; ++i)
+                EXPECT_EQ(values[i], scalar_rng.rand_uint32());
+        }
+    }
+
+    TEST_CASE(RandFloat2_ReturnsValuesInUnitInterval)
+    {
+        SimdPCG<8> rng;
+
+        for (size_t j = 0; j < 1000; ++j)
+        {
+            float values[8];
+            rng.rand_float2(values);
+
+            for (size_t i = 0; i < 8; ++i)
+                EXPECT_TRUE(values[i] >= 0.0f && values[i] < 1.0f);
+        }
+    }
+}
+
+TEST_SUITE(Foundation_Math_RNG_SimdXorshift)
+{
+    template <size_t Lanes>
+    bool lanes_match_scalar_generators()
+    {
+        const uint32 Seed = 123456789UL;
+
+        SimdXorshift<Lanes> simd_rng(Seed);
+
+        Xorshift seeder(Seed);
+        uint32 scalar_states[Lanes];
+        for (size_t i = 0; i < Lanes; ++i)
+            scalar_states[i] = seeder.rand_uint32();
+
+        for (size_t j = 0; j < 100; ++j)
+        {
+            uint32 values[Lanes];
+            simd_rng.rand_uint32(values);
+
+            for (size_t i = 0; i < Lanes; ++i)
+            {
+                Xorshift scalar_rng(scalar_states[i]);
+                scalar_states[i] = scalar_rng.rand_uint32();
+
+                if (values[i] != scalar_states[i])
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    TEST_CASE(RandUint32_4Lanes_LanesMatchScalarGenerators)
+    {
+        EXPECT_TRUE(lanes_match_scalar_generators<4>());
+    }
+
+    TEST_CASE(RandUint32_8Lanes_LanesMatchScalarGenerators)
+    {
+        EXPECT_TRUE(lanes_match_scalar_generators<8>());
+    }
+
+    TEST_CASE(RandUint32Batch_GivenPartialBatch_FillsAllValues)
+    {
+        SimdXorshift<4> rng;
+
+        uint32 values[7] = { 0, 0, 0, 0, 0, 0, 0 };
+        rand_uint32_batch(rng, values, 7);
+
+        // Xorshift never generates zeros.
+        for (size_t i = 0; i < 7; ++i)
+            EXPECT_NEQ(0, values[i]);
+    }
+
+    TEST_CASE(RandFloat2_ReturnsValuesInUnitInterval)
+    {
+        SimdXorshift<4> rng;
+
+        for (size_t j = 0; j < 1000; ++j)
+        {
+            float values[4];
+            rng.rand_float2(values);
+
+            for (size_t i = 0; i < 4; ++i)
+                EXPECT_TRUE(values[i] >= 0.0f && values[i] < 1.0f);
+        }
+    }
+}
@@ -108,6 +108,18 @@ TEST_SUITE(Foundation_Math_Sampling_QMCSamplingContext)
         EXPECT_EQ(4, child_child_context.m_dimension);
         EXPECT_EQ(0, child_child_context.m_instance);
     }
+
+    TEST_CASE(TestBlueNoisePixelIsInherited)
+    {
+        RNG rng;
+        SamplingContext context(rng, SamplingContext::QMCMode, 2, 64, 7);
+        context.set_blue_noise_pixel(3, 5);
+        SamplingContext child_context = context.split(3, 16);
+
+        EXPECT_TRUE(child_context.m_use_blue_noise);
+        EXPECT_EQ(3, child_context.m_blue_noise_x);
+        EXPECT_EQ(5, child_context.m_blue_noise_y);
+    }
 }
 
 TEST_SUITE(Foundation_Math_Sampling_QMCSamplingContext_DirectIlluminationSimulation)
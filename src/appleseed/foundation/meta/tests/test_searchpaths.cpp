@@ -27,16 +27,24 @@
 //
 
 // appleseed.foundation headers.
+#include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/searchpaths.h"
 #include "foundation/utility/test.h"
 
+// Boost headers.
+#include "boost/filesystem/fstream.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
 // Standard headers.
 #include <cassert>
+#include <cstddef>
 #include <cstdlib>
 #include <string>
 
 using namespace foundation;
 using namespace std;
+namespace bf = boost::filesystem;
 
 TEST_SUITE(Foundation_Utility_SearchPaths)
 {
@@ -167,4 +175,84 @@ TEST_SUITE(Foundation_Utility_SearchPaths)
     }
 
 #endif
+
+    struct SearchPathsWithFiles
+    {
+        SearchPaths m_search_paths;
+
+        SearchPathsWithFiles()
+        {
+            const bf::path root = bf::absolute("unit tests/outputs/test_searchpaths");
+            bf::remove_all(root);
+
+            create_file(root / "low" / "a.txt");
+            create_file(root / "low" / "sub" / "b.txt");
+            create_file(root / "high" / "a.txt");
+            create_file(root / "c.txt");
+
+            m_search_paths.set_root_path(root.string());
+            m_search_paths.push_back("low");
+            m_search_paths.push_back("high");
+        }
+
+        static void create_file(const bf::path& path)
+        {
+            bf::create_directories(path.parent_path());
+            bf::ofstream file(path);
+        }
+
+        void qualify_one_by_one(
+            const StringArray&  filepaths,
+            StringArray&        qualified_filepaths,
+            StringArray&        search_paths)
+        {
+            for (size_t i = 0; i < filepaths.size(); ++i)
+            {
+                string qualified_filepath, search_path;
+                m_search_paths.qualify(filepaths[i], qualified_filepath, search_path);
+                qualified_filepaths.push_back(qualified_filepath.c_str());
+                search_paths.push_back(search_path.c_str());
+            }
+        }
+    };
+
+    TEST_CASE_F(QualifyBatch_GivenFilesInSearchPaths_MatchesQualifyingFilesOneByOne, SearchPathsWithFiles)
+    {
+        StringArray filepaths;
+        filepaths.push_back("a.txt");
+        filepaths.push_back("sub/b.txt");
+        filepaths.push_back("c.txt");
+        filepaths.push_back("missing.txt");
+        filepaths.push_back("sub/missing.txt");
+        filepaths.push_back("missing/d.txt");
+
+        StringArray expected_qualified_filepaths, expected_search_paths;
+        qualify_one_by_one(filepaths, expected_qualified_filepaths, expected_search_paths);
+
+        for (size_t thread_count = 1; thread_count <= 4; ++thread_count)
+        {
+            StringArray qualified_filepaths, search_paths;
+            m_search_paths.qualify(filepaths, qualified_filepaths, search_paths, thread_count);
+
+            ASSERT_EQ(filepaths.size(), qualified_filepaths.size());
+            ASSERT_EQ(filepaths.size(), search_paths.size());
+
+            for (size_t i = 0; i < filepaths.size(); ++i)
+            {
+                EXPECT_EQ(string(expected_qualified_filepaths[i]), string(qualified_filepaths[i]));
+                EXPECT_EQ(string(expected_search_paths[i]), string(search_paths[i]));
+            }
+        }
+    }
+
+    TEST_CASE_F(QualifyBatch_GivenFileInSeveralSearchPaths_ReturnsLastInsertedSearchPath, SearchPathsWithFiles)
+    {
+        StringArray filepaths;
+        filepaths.push_back("a.txt");
+
+        StringArray qualified_filepaths, search_paths;
+        m_search_paths.qualify(filepaths, qualified_filepaths, search_paths);
+
+        EXPECT_EQ("high", string(search_paths[0]));
+    }
 }
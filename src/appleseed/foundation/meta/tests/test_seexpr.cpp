@@ -27,10 +27,13 @@
 //
 
 // appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/utility/iostreamop.h"
 #include "foundation/utility/seexpr.h"
 #include "foundation/utility/test.h"
 
 // Standard headers.
+#include <cstddef>
 #include <string>
 
 using namespace foundation;
@@ -117,3 +120,116 @@ TEST_SUITE(Foundation_Utility_SeExpr_SeExprFilePathExtractor)
         ASSERT_EQ("texture(\"/bruce/lee.exr\", $u, $v) * texture(\"/bruce/lee.exr\", $u, $v)", result);
     }
 }
+
+TEST_SUITE(Foundation_Utility_SeExpr_SeExprProgram)
+{
+    // Return the texture index and the lookup coordinates instead of a color.
+    struct TextureLookupStub
+      : public SeExprProgram::ITextureLookup
+    {
+        virtual Color3d lookup(
+            const size_t    texture_index,
+            const double    u,
+            const double    v) const APPLESEED_OVERRIDE
+        {
+            return Color3d(static_cast<double>(texture_index), u, v);
+        }
+    };
+
+    TEST_CASE(Compile_GivenConstantArithmetic_FoldsIntoConstant)
+    {
+        SeExprProgram program;
+        const bool success = program.compile("2 * (1 + 0.5) - 2^-1", false);
+
+        ASSERT_TRUE(success);
+        EXPECT_TRUE(program.is_constant());
+        EXPECT_EQ(Color3d(2.5), program.evaluate(0.0, 0.0));
+    }
+
+    TEST_CASE(Compile_GivenNegatedPower_NegatesResultOfPower)
+    {
+        SeExprProgram program;
+        program.compile("-2^2", false);
+
+        EXPECT_EQ(Color3d(-4.0), program.evaluate(0.0, 0.0));
+    }
+
+    TEST_CASE(Evaluate_GivenExpressionOfUV_ReturnsReplicatedScalar)
+    {
+        SeExprProgram program;
+        const bool success = program.compile("clamp($u * 4, 0, 1) + $v", false);
+
+        ASSERT_TRUE(success);
+        EXPECT_FALSE(program.is_constant());
+        EXPECT_FALSE(program.is_vector());
+        EXPECT_EQ(Color3d(1.5), program.evaluate(0.5, 0.5));
+    }
+
+    TEST_CASE(Evaluate_GivenVectorExpression_AppliesOperatorsComponentWise)
+    {
+        SeExprProgram program;
+        const bool success = program.compile("[1, $u, 3] * 2", true);
+
+        ASSERT_TRUE(success);
+        EXPECT_TRUE(program.is_vector());
+        EXPECT_EQ(Color3d(2.0, 1.0, 6.0), program.evaluate(0.5, 0.0));
+    }
+
+    TEST_CASE(Evaluate_GivenTextureLookups_PerformsLookupsWithDistinctTextureIndices)
+    {
+        SeExprProgram program;
+        const bool success =
+            program.compile("texture(\"a.exr\", $u, $v) + texture(\"b.exr\", 1 - $v, $u) + texture(\"a.exr\", 0, 0)", true);
+
+        ASSERT_TRUE(success);
+        ASSERT_EQ(2, program.get_texture_paths().size());
+        EXPECT_EQ("a.exr", program.get_texture_paths()[0]);
+        EXPECT_EQ("b.exr", program.get_texture_paths()[1]);
+
+        const TextureLookupStub texture_lookup;
+        EXPECT_EQ(Color3d(1.0, 0.75, 0.75), program.evaluate(0.25, 0.5, &texture_lookup));
+    }
+
+    TEST_CASE(Compile_GivenVectorExpressionWhileScalarIsWanted_ReturnsFalse)
+    {
+        SeExprProgram program;
+
+        EXPECT_FALSE(program.compile("[1, 2, 3]", false));
+    }
+
+    TEST_CASE(Compile_GivenUnsupportedConstructs_ReturnsFalse)
+    {
+        SeExprProgram program;
+
+        EXPECT_FALSE(program.compile("$x", false));
+        EXPECT_FALSE(program.compile("$u > 0.5 ? 1 : 0", false));
+        EXPECT_FALSE(program.compile("noise($u)", false));
+        EXPECT_FALSE(program.compile("1 +", false));
+        EXPECT_FALSE(program.compile("0x10", false));
+    }
+}
+
+TEST_SUITE(Foundation_Utility_SeExpr_SeExprProgramCache)
+{
+    TEST_CASE(Get_GivenSameExpressionTwice_ReturnsSameProgram)
+    {
+        SeExprProgramCache cache;
+
+        const SeExprProgramCache::ProgramPtr program1 = cache.get("$u * 2", false);
+        const SeExprProgramCache::ProgramPtr program2 = cache.get("$u * 2", false);
+
+        ASSERT_TRUE(program1.get() != 0);
+        EXPECT_EQ(program1.get(), program2.get());
+        EXPECT_EQ(1, cache.size());
+    }
+
+    TEST_CASE(Get_GivenUnsupportedExpression_ReturnsNullProgram)
+    {
+        SeExprProgramCache cache;
+
+        const SeExprProgramCache::ProgramPtr program = cache.get("noise($u)", false);
+
+        EXPECT_TRUE(program.get() == 0);
+        EXPECT_EQ(1, cache.size());
+    }
+}
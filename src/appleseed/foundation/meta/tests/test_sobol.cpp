@@ -0,0 +1,139 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.foundation headers.
+#include "foundation/math/sobol.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Math_Sobol)
+{
+    TEST_CASE(ReverseBits)
+    {
+        EXPECT_EQ(0x00000000UL, reverse_bits(0x00000000UL));
+        EXPECT_EQ(0x80000000UL, reverse_bits(0x00000001UL));
+        EXPECT_EQ(0x00000001UL, reverse_bits(0x80000000UL));
+        EXPECT_EQ(0x1E6A2C48UL, reverse_bits(0x12345678UL));
+    }
+
+    TEST_CASE(SobolSequence_FirstPoints)
+    {
+        static const double Expected[][SobolDimensionCount] =
+        {
+            { 0.0,   0.0,   0.0,   0.0   },
+            { 0.5,   0.5,   0.5,   0.5   },
+            { 0.25,  0.75,  0.75,  0.75  },
+            { 0.75,  0.25,  0.25,  0.25  },
+            { 0.125, 0.625, 0.375, 0.125 }
+        };
+
+        for (size_t i = 0; i < sizeof(Expected) / sizeof(Expected[0]); ++i)
+        {
+            for (size_t d = 0; d < SobolDimensionCount; ++d)
+            {
+                EXPECT_EQ(
+                    Expected[i][d],
+                    fixed_point_to_unit<double>(sobol_uint32(d, static_cast<uint32>(i))));
+            }
+        }
+    }
+
+    TEST_CASE(NestedUniformScrambleBase2_IsBijective)
+    {
+        // Scrambling must permute the 2^k first points among themselves.
+        const size_t Count = 256;
+        vector<bool> seen(Count, false);
+
+        for (uint32 i = 0; i < Count; ++i)
+        {
+            const uint32 x = nested_uniform_scramble_base2(i << 24, 0xDEADBEEFUL) >> 24;
+            EXPECT_FALSE(seen[x]);
+            seen[x] = true;
+        }
+    }
+
+    TEST_CASE(ShuffledScrambledSobolSequence_IsStratified)
+    {
+        // Each dimension of the first 2^k points must have exactly one point in each of 2^k strata.
+        const size_t Count = 64;
+        const uint32 Seeds[] = { 0, 1, 0x12345678UL };
+
+        for (size_t s = 0; s < sizeof(Seeds) / sizeof(Seeds[0]); ++s)
+        {
+            vector<size_t> strata[SobolDimensionCount];
+
+            for (size_t d = 0; d < SobolDimensionCount; ++d)
+                strata[d].assign(Count, 0);
+
+            for (uint32 i = 0; i < Count; ++i)
+            {
+                const Vector4d p = shuffled_scrambled_sobol_sequence<double, 4>(Seeds[s], i);
+
+                for (size_t d = 0; d < SobolDimensionCount; ++d)
+                {
+                    EXPECT_TRUE(p[d] >= 0.0 && p[d] < 1.0);
+                    ++strata[d][static_cast<size_t>(p[d] * Count)];
+                }
+            }
+
+            for (size_t d = 0; d < SobolDimensionCount; ++d)
+            {
+                for (size_t i = 0; i < Count; ++i)
+                    EXPECT_EQ(1, strata[d][i]);
+            }
+        }
+    }
+
+    TEST_CASE(ShuffledScrambledSobolSequence_SinglePrecisionValuesAreLessThanOne)
+    {
+        for (uint32 i = 0; i < 1024; ++i)
+        {
+            const Vector2f p = shuffled_scrambled_sobol_sequence<float, 2>(0xFFFFFFFFUL, i);
+            EXPECT_TRUE(p[0] < 1.0f);
+            EXPECT_TRUE(p[1] < 1.0f);
+        }
+    }
+
+    TEST_CASE(ShuffledScrambledSobolSequence_DifferentSeedsGiveDifferentPoints)
+    {
+        const Vector2d p1 = shuffled_scrambled_sobol_sequence<double, 2>(1, 0);
+        const Vector2d p2 = shuffled_scrambled_sobol_sequence<double, 2>(2, 0);
+
+        EXPECT_NEQ(p1, p2);
+    }
+}
@@ -185,6 +185,27 @@ TEST_SUITE(Foundation_Utility_Statistics)
 
         EXPECT_EQ("  existing value   17,042", stats.to_string());
     }
+
+    TEST_CASE(Find_GivenExistingName_ReturnsEntry)
+    {
+        Statistics stats;
+        stats.insert<uint64>("counter 1", 17);
+        stats.insert<uint64>("counter 2", 42);
+
+        const Statistics::Entry* entry = stats.find("counter 2");
+
+        ASSERT_NEQ(0, entry);
+        EXPECT_EQ(stats.get(1), entry);
+        EXPECT_EQ(42, dynamic_cast<const Statistics::UnsignedIntegerEntry*>(entry)->m_value);
+    }
+
+    TEST_CASE(Find_GivenUnknownName_ReturnsNull)
+    {
+        Statistics stats;
+        stats.insert<uint64>("counter", 17);
+
+        EXPECT_EQ(0, stats.find("other counter"));
+    }
 }
 
 TEST_SUITE(Foundation_Utility_StatisticsVector)
@@ -203,4 +224,22 @@ TEST_SUITE(Foundation_Utility_StatisticsVector)
 
         EXPECT_EQ("stats 1:\n  counter 1        17\nstats 2:\n  counter 2        42", vec.to_string());
     }
+
+    TEST_CASE(Get_GivenTwoItems_ReturnsThemInInsertionOrder)
+    {
+        Statistics stats1;
+        stats1.insert<uint64>("counter 1", 17);
+
+        Statistics stats2;
+        stats2.insert<uint64>("counter 2", 42);
+
+        StatisticsVector vec;
+        vec.insert("stats 1", stats1);
+        vec.insert("stats 2", stats2);
+
+        ASSERT_EQ(2, vec.size());
+        EXPECT_EQ("stats 1", vec.get_name(0));
+        EXPECT_EQ("stats 2", vec.get_name(1));
+        EXPECT_NEQ(0, vec.get(1).find("counter 2"));
+    }
 }
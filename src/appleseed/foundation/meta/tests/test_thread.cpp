@@ -33,6 +33,13 @@
 #include "foundation/utility/stopwatch.h"
 #include "foundation/utility/test.h"
 
+// Boost headers.
+#include "boost/bind.hpp"
+#include "boost/thread/thread.hpp"
+
+// Standard headers.
+#include <cstddef>
+
 using namespace foundation;
 
 TEST_SUITE(Foundation_Platform_Thread)
@@ -44,6 +51,50 @@ TEST_SUITE(Foundation_Platform_Thread)
         sleep(1000 * 3600, abort_switch);
     }
 
+    void increment_under_lock(AdaptiveLock* lock, size_t* counter, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            AdaptiveLock::ScopedLock scoped_lock(*lock);
+            ++*counter;
+        }
+    }
+
+    TEST_CASE(AdaptiveLock_GivenConcurrentIncrements_CountsEveryIncrementAndAcquisition)
+    {
+        const size_t ThreadCount = 8;
+        const size_t IncrementCount = 10000;
+
+        LockContentionCounters counters;
+        AdaptiveLock lock(&counters);
+        size_t counter = 0;
+
+        boost::thread_group threads;
+        for (size_t i = 0; i < ThreadCount; ++i)
+            threads.create_thread(boost::bind(increment_under_lock, &lock, &counter, IncrementCount));
+        threads.join_all();
+
+        EXPECT_EQ(ThreadCount * IncrementCount, counter);
+        EXPECT_EQ(ThreadCount * IncrementCount, counters.get_acquisition_count());
+        EXPECT_TRUE(lock.try_lock());
+
+        lock.unlock();
+    }
+
+    TEST_CASE(AdaptiveLock_TryLock_CountsSuccessfulAcquisitionsOnly)
+    {
+        LockContentionCounters counters;
+        AdaptiveLock lock(&counters);
+
+        EXPECT_TRUE(lock.try_lock());
+        EXPECT_FALSE(lock.try_lock());
+
+        lock.unlock();
+
+        EXPECT_EQ(1, counters.get_acquisition_count());
+        EXPECT_EQ(0, counters.get_contended_count());
+    }
+
 #ifdef EXPLORATION_TESTS
 
     TEST_CASE(Sleep_CheckElapsedTime)
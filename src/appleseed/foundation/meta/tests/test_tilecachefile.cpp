@@ -0,0 +1,151 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/iprogressiveimagefilereader.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/image/tilecachefile.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <memory>
+
+using namespace foundation;
+using namespace std;
+
+TEST_SUITE(Foundation_Image_TileCacheFile)
+{
+    const char* Filepath = "unit tests/outputs/test_tilecachefile.tiles";
+
+    // A 5x3 image made of 2x2 tiles, where each pixel encodes its coordinates.
+    class FakeImageFileReader
+      : public IProgressiveImageFileReader
+    {
+      public:
+        FakeImageFileReader()
+          : m_props(5, 3, 2, 2, 3, PixelFormatFloat)
+        {
+        }
+
+        virtual void open(const char* filename) APPLESEED_OVERRIDE {}
+        virtual void close() APPLESEED_OVERRIDE {}
+        virtual bool is_open() const APPLESEED_OVERRIDE { return true; }
+
+        virtual void read_canvas_properties(CanvasProperties& props) APPLESEED_OVERRIDE
+        {
+            props = m_props;
+        }
+
+        virtual void read_image_attributes(ImageAttributes& attrs) APPLESEED_OVERRIDE
+        {
+        }
+
+        virtual Tile* read_tile(const size_t tile_x, const size_t tile_y) APPLESEED_OVERRIDE
+        {
+            const size_t width = m_props.get_tile_width(tile_x);
+            const size_t height = m_props.get_tile_height(tile_y);
+
+            Tile* tile = new Tile(width, height, 3, PixelFormatFloat);
+
+            for (size_t y = 0; y < height; ++y)
+            {
+                for (size_t x = 0; x < width; ++x)
+                    tile->set_pixel(x, y, expected_pixel(tile_x * 2 + x, tile_y * 2 + y));
+            }
+
+            return tile;
+        }
+
+        static Color3f expected_pixel(const size_t x, const size_t y)
+        {
+            return Color3f(static_cast<float>(x), static_cast<float>(y), 1.0f);
+        }
+
+      private:
+        const CanvasProperties m_props;
+    };
+
+    TEST_CASE(Open_GivenNonExistingFile_ReturnsFalse)
+    {
+        TileCacheFile file;
+
+        EXPECT_FALSE(file.open("unit tests/outputs/test_tilecachefile_nonexisting.tiles", 0));
+        EXPECT_FALSE(file.is_open());
+    }
+
+    TEST_CASE(Open_GivenMismatchingSourceStamp_ReturnsFalse)
+    {
+        FakeImageFileReader reader;
+        TileCacheFile::write(Filepath, reader, 42);
+
+        TileCacheFile file;
+
+        EXPECT_FALSE(file.open(Filepath, 43));
+    }
+
+    TEST_CASE(ReadTile_AfterWrite_ReturnsOriginalPixels)
+    {
+        FakeImageFileReader reader;
+        TileCacheFile::write(Filepath, reader, 42);
+
+        TileCacheFile file;
+        ASSERT_TRUE(file.open(Filepath, 42));
+
+        const CanvasProperties& props = file.properties();
+        EXPECT_EQ(5, props.m_canvas_width);
+        EXPECT_EQ(3, props.m_canvas_height);
+        EXPECT_EQ(PixelFormatFloat, props.m_pixel_format);
+
+        for (size_t ty = 0; ty < props.m_tile_count_y; ++ty)
+        {
+            for (size_t tx = 0; tx < props.m_tile_count_x; ++tx)
+            {
+                auto_ptr<Tile> tile(file.read_tile(tx, ty, tx == 1));
+
+                ASSERT_EQ(props.get_tile_width(tx), tile->get_width());
+                ASSERT_EQ(props.get_tile_height(ty), tile->get_height());
+
+                for (size_t y = 0; y < tile->get_height(); ++y)
+                {
+                    for (size_t x = 0; x < tile->get_width(); ++x)
+                    {
+                        Color3f c;
+                        tile->get_pixel(x, y, c);
+                        EXPECT_EQ(FakeImageFileReader::expected_pixel(tx * 2 + x, ty * 2 + y), c);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -81,4 +81,24 @@ TEST_SUITE(Foundation_Platform_Timers)
         const uint64 val2 = timer.read();
         EXPECT_TRUE(val1 <= val2);
     }
+
+    TEST_CASE(TestTSCTimerFrequency)
+    {
+        TSCTimer timer;
+        EXPECT_TRUE(timer.frequency() > 0);
+    }
+
+    TEST_CASE(TestTSCTimerFrequencyIsMeasuredOnce)
+    {
+        TSCTimer timer1, timer2;
+        EXPECT_EQ(timer1.frequency(), timer2.frequency());
+    }
+
+    TEST_CASE(TestTSCTimerValues)
+    {
+        TSCTimer timer;
+        const uint64 val1 = timer.read();
+        const uint64 val2 = timer.read();
+        EXPECT_TRUE(val1 <= val2);
+    }
 }
@@ -74,6 +74,10 @@ void atomic_add(
     volatile float*     ptr,
     const float         operand);
 
+uint64 atomic_add(
+    volatile uint64*    ptr,
+    const uint64        operand);
+
 
 //
 // Implementation.
@@ -138,6 +142,24 @@ APPLESEED_FORCE_INLINE void atomic_add(
     }
 }
 
+APPLESEED_FORCE_INLINE uint64 atomic_add(
+    volatile uint64*    ptr,
+    const uint64        operand)
+{
+    assert(is_aligned(ptr, 8));
+
+#if defined _WIN32
+    return static_cast<uint64>(
+        InterlockedExchangeAdd64(
+            reinterpret_cast<volatile LONGLONG*>(ptr),
+            static_cast<LONGLONG>(operand)));
+#elif defined __GNUC__
+    return __sync_fetch_and_add(ptr, operand);
+#else
+    #error Unsupported platform.
+#endif
+}
+
 }       // namespace foundation
 
 #endif  // !APPLESEED_FOUNDATION_PLATFORM_ATOMIC_H
@@ -0,0 +1,215 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "hardwarecounters.h"
+
+// Platform headers.
+#if defined __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Standard headers.
+#include <cassert>
+#include <cstring>
+
+namespace foundation
+{
+
+//
+// HardwareCounters class implementation.
+//
+
+const char* HardwareCounters::get_name(const Counter counter)
+{
+    static const char* const Names[CounterCount] =
+    {
+        "cycles",
+        "instructions",
+        "llc misses",
+        "branch misses"
+    };
+
+    assert(counter < CounterCount);
+    return Names[counter];
+}
+
+#if defined __linux__
+
+struct HardwareCounters::Impl
+{
+    int     m_fds[CounterCount];
+    uint64  m_values[CounterCount];
+
+    static int open_counter(const uint64 config)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        return
+            static_cast<int>(
+                syscall(
+                    __NR_perf_event_open,
+                    &attr,
+                    0,                      // calling thread
+                    -1,                     // any CPU
+                    -1,                     // no group
+                    0));                    // flags
+    }
+};
+
+HardwareCounters::HardwareCounters()
+  : impl(new Impl())
+{
+    static const uint64 Configs[CounterCount] =
+    {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    for (size_t i = 0; i < CounterCount; ++i)
+    {
+        impl->m_fds[i] = Impl::open_counter(Configs[i]);
+        impl->m_values[i] = 0;
+    }
+}
+
+HardwareCounters::~HardwareCounters()
+{
+    for (size_t i = 0; i < CounterCount; ++i)
+    {
+        if (impl->m_fds[i] != -1)
+            close(impl->m_fds[i]);
+    }
+
+    delete impl;
+}
+
+bool HardwareCounters::is_available(const Counter counter) const
+{
+    assert(counter < CounterCount);
+    return impl->m_fds[counter] != -1;
+}
+
+void HardwareCounters::start()
+{
+    for (size_t i = 0; i < CounterCount; ++i)
+    {
+        if (impl->m_fds[i] != -1)
+        {
+            ioctl(impl->m_fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(impl->m_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void HardwareCounters::stop()
+{
+    for (size_t i = 0; i < CounterCount; ++i)
+    {
+        if (impl->m_fds[i] != -1)
+            ioctl(impl->m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    for (size_t i = 0; i < CounterCount; ++i)
+    {
+        impl->m_values[i] = 0;
+
+        if (impl->m_fds[i] == -1)
+            continue;
+
+        // Value, time enabled, time running.
+        uint64 data[3];
+        if (read(impl->m_fds[i], data, sizeof(data)) != sizeof(data))
+            continue;
+
+        // Extrapolate the value if the counter was multiplexed with others.
+        impl->m_values[i] =
+            data[2] == 0 ? 0 :
+            data[2] < data[1]
+                ? static_cast<uint64>(static_cast<double>(data[0]) * data[1] / data[2])
+                : data[0];
+    }
+}
+
+uint64 HardwareCounters::get_value(const Counter counter) const
+{
+    assert(counter < CounterCount);
+    return impl->m_values[counter];
+}
+
+#else
+
+struct HardwareCounters::Impl
+{
+};
+
+HardwareCounters::HardwareCounters()
+  : impl(new Impl())
+{
+}
+
+HardwareCounters::~HardwareCounters()
+{
+    delete impl;
+}
+
+bool HardwareCounters::is_available(const Counter counter) const
+{
+    return false;
+}
+
+void HardwareCounters::start()
+{
+}
+
+void HardwareCounters::stop()
+{
+}
+
+uint64 HardwareCounters::get_value(const Counter counter) const
+{
+    return 0;
+}
+
+#endif
+
+}   // namespace foundation
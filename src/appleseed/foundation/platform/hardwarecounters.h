@@ -0,0 +1,96 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_FOUNDATION_PLATFORM_HARDWARECOUNTERS_H
+#define APPLESEED_FOUNDATION_PLATFORM_HARDWARECOUNTERS_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+namespace foundation
+{
+
+//
+// Hardware performance counters of the calling thread, in user mode.
+//
+// On Linux, counters are opened with perf_event_open(2); counters that the processor,
+// the kernel or its perf_event_paranoid setting don't allow are reported as unavailable.
+// On other platforms, no counter is available.
+//
+// When more counters are requested than the processor can count at once, the kernel
+// time-multiplexes them and the returned values are extrapolated.
+//
+
+class APPLESEED_DLLSYMBOL HardwareCounters
+  : public NonCopyable
+{
+  public:
+    enum Counter
+    {
+        Cycles,
+        Instructions,
+        LLCMisses,                      // last level cache misses
+        BranchMisses,                   // mispredicted branches
+        CounterCount
+    };
+
+    // Return a human-readable name for a given counter.
+    static const char* get_name(const Counter counter);
+
+    // Constructor, opens the counters.
+    HardwareCounters();
+
+    // Destructor, closes the counters.
+    ~HardwareCounters();
+
+    // Return true if a given counter could be opened.
+    bool is_available(const Counter counter) const;
+
+    // Reset the counters and start counting.
+    void start();
+
+    // Stop counting.
+    void stop();
+
+    // Return the number of events counted between start() and stop(),
+    // or 0 if the counter is not available.
+    uint64 get_value(const Counter counter) const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_PLATFORM_HARDWARECOUNTERS_H
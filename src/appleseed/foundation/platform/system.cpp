@@ -36,7 +36,9 @@
 #include "foundation/utility/string.h"
 
 // Standard headers.
+#include <cassert>
 #include <string>
+#include <vector>
 
 // Windows.
 #if defined _WIN32
@@ -60,6 +62,7 @@
     #include <mach/task_info.h>
     #include <sys/mount.h>
     #include <sys/param.h>
+    #include <sys/resource.h>
     #include <sys/sysctl.h>
     #include <sys/types.h>
 
@@ -70,6 +73,7 @@
     #include <cstdio>
 
     // Platform headers.
+    #include <sys/resource.h>
     #include <sys/sysinfo.h>
     #include <sys/types.h>
     #include <unistd.h>
@@ -104,12 +108,14 @@ void System::print_information(Logger& logger)
         logger,
         "system information:\n"
         "  logical cores    %s\n"
+        "  NUMA nodes       %s\n"
         "  L1 data cache    size %s, line size %s\n"
         "  L2 cache         size %s, line size %s\n"
         "  L3 cache         size %s, line size %s\n"
         "  physical memory  size %s\n"
         "  virtual memory   size %s",
         pretty_uint(get_logical_cpu_core_count()).c_str(),
+        pretty_uint(get_numa_node_count()).c_str(),
         pretty_size(get_l1_data_cache_size()).c_str(),
         pretty_size(get_l1_data_cache_line_size()).c_str(),
         pretty_size(get_l2_cache_size()).c_str(),
@@ -128,6 +134,97 @@ size_t System::get_logical_cpu_core_count()
     return concurrency > 1 ? concurrency : 1;
 }
 
+size_t System::get_numa_node_count()
+{
+#if defined _WIN32
+
+    ULONG highest_node_number;
+    return GetNumaHighestNodeNumber(&highest_node_number) ? highest_node_number + 1 : 1;
+
+#elif defined __linux__
+
+    // Nodes are listed in /sys/devices/system/node/ on NUMA-enabled kernels.
+    size_t node_count = 0;
+
+    while (true)
+    {
+        const string path = "/sys/devices/system/node/node" + to_string(node_count);
+        if (access(path.c_str(), F_OK) != 0)
+            break;
+        ++node_count;
+    }
+
+    return node_count > 1 ? node_count : 1;
+
+#else
+
+    return 1;
+
+#endif
+}
+
+size_t System::get_numa_node_of_logical_cpu_core(const size_t core_index)
+{
+#if defined _WIN32
+
+    UCHAR node_number;
+    return
+        core_index <= 0xFF && GetNumaProcessorNode(static_cast<UCHAR>(core_index), &node_number)
+            ? node_number
+            : 0;
+
+#elif defined __linux__
+
+    // Each CPU core directory contains a link to the node it belongs to.
+    const size_t node_count = get_numa_node_count();
+    const string core_path = "/sys/devices/system/cpu/cpu" + to_string(core_index) + "/node";
+
+    for (size_t i = 0; i < node_count; ++i)
+    {
+        const string path = core_path + to_string(i);
+        if (access(path.c_str(), F_OK) == 0)
+            return i;
+    }
+
+    return 0;
+
+#else
+
+    return 0;
+
+#endif
+}
+
+size_t System::get_numa_grouped_logical_cpu_core(const size_t thread_index)
+{
+    const size_t core_count = get_logical_cpu_core_count();
+    const size_t node_count = get_numa_node_count();
+
+    if (node_count == 1)
+        return thread_index % core_count;
+
+    // Order logical CPU cores by NUMA node, then by index.
+    vector<size_t> core_nodes(core_count);
+    for (size_t core = 0; core < core_count; ++core)
+        core_nodes[core] = get_numa_node_of_logical_cpu_core(core);
+
+    vector<size_t> cores;
+    cores.reserve(core_count);
+
+    for (size_t node = 0; node < node_count; ++node)
+    {
+        for (size_t core = 0; core < core_count; ++core)
+        {
+            if (core_nodes[core] == node)
+                cores.push_back(core);
+        }
+    }
+
+    assert(cores.size() == core_count);
+
+    return cores[thread_index % core_count];
+}
+
 // ------------------------------------------------------------------------------------------------
 // Windows.
 // ------------------------------------------------------------------------------------------------
@@ -252,6 +349,17 @@ uint64 System::get_process_virtual_memory_size()
     return pmc.PrivateUsage;
 }
 
+uint64 System::get_peak_process_memory_size()
+{
+    PROCESS_MEMORY_COUNTERS pmc;
+    GetProcessMemoryInfo(
+        GetCurrentProcess(),
+        &pmc,
+        sizeof(pmc));
+
+    return pmc.PeakWorkingSetSize;
+}
+
 // ------------------------------------------------------------------------------------------------
 // OS X.
 // ------------------------------------------------------------------------------------------------
@@ -349,6 +457,16 @@ uint64 System::get_process_virtual_memory_size()
     return info.resident_size;
 }
 
+uint64 System::get_peak_process_memory_size()
+{
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+        return 0;
+
+    // On OS X, ru_maxrss is expressed in bytes.
+    return static_cast<uint64>(ru.ru_maxrss);
+}
+
 // ------------------------------------------------------------------------------------------------
 // Linux.
 // ------------------------------------------------------------------------------------------------
@@ -429,6 +547,16 @@ uint64 System::get_process_virtual_memory_size()
     return static_cast<uint64>(rss) * sysconf(_SC_PAGESIZE);
 }
 
+uint64 System::get_peak_process_memory_size()
+{
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+        return 0;
+
+    // On Linux, ru_maxrss is expressed in kilobytes.
+    return static_cast<uint64>(ru.ru_maxrss) * 1024;
+}
+
 // ------------------------------------------------------------------------------------------------
 // FreeBSD.
 // ------------------------------------------------------------------------------------------------
@@ -812,6 +940,11 @@ uint64 System::get_process_virtual_memory_size()
     return static_cast<uint64>(ru.ru_maxrss) * 1024;
 }
 
+uint64 System::get_peak_process_memory_size()
+{
+    return get_process_virtual_memory_size();
+}
+
 #endif
 
 }   // namespace foundation
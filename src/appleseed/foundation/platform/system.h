@@ -64,6 +64,21 @@ class APPLESEED_DLLSYMBOL System
     // Return the number of logical CPU cores available in the system.
     static size_t get_logical_cpu_core_count();
 
+    //
+    // NUMA nodes.
+    //
+
+    // Return the number of NUMA nodes in the system (1 on non-NUMA systems).
+    static size_t get_numa_node_count();
+
+    // Return the NUMA node a given logical CPU core belongs to.
+    static size_t get_numa_node_of_logical_cpu_core(const size_t core_index);
+
+    // Return the logical CPU core assigned to the thread of a given index when threads
+    // are grouped by NUMA node: consecutive thread indices fill all the cores of a node
+    // before moving on to the next node. Thread indices wrap around the core count.
+    static size_t get_numa_grouped_logical_cpu_core(const size_t thread_index);
+
     //
     // CPU caches.
     //
@@ -102,6 +117,9 @@ class APPLESEED_DLLSYMBOL System
 
     // Return the amount in bytes of virtual memory used by the current process.
     static uint64 get_process_virtual_memory_size();
+
+    // Return the highest amount in bytes of memory used by the current process so far.
+    static uint64 get_peak_process_memory_size();
 };
 
 }       // namespace foundation
@@ -38,12 +38,14 @@
 #endif
 #include "foundation/utility/job/iabortswitch.h"
 #include "foundation/utility/log.h"
+#include "foundation/utility/string.h"
 
 // Boost headers.
 #include "boost/chrono.hpp"
 
 // Standard headers.
 #include <cassert>
+#include <string>
 
 // Platform headers.
 #if defined __APPLE__
@@ -52,6 +54,8 @@
 #include <pthread.h>
 #include <pthread_np.h>
 #elif defined __linux__
+#include <pthread.h>
+#include <sched.h>
 #include <sys/prctl.h>
 #endif
 
@@ -166,6 +170,138 @@ void yield()
     this_thread::yield();
 }
 
+void spin_wait(const uint32 iterations)
+{
+    for (uint32 i = 0; i < iterations; ++i)
+    {
+#if defined _MSC_VER
+        YieldProcessor();
+#elif defined __GNUC__ && (defined __i386__ || defined __x86_64__)
+        __asm__ __volatile__("pause");
+#endif
+    }
+}
+
+
+//
+// LockContentionCounters class implementation.
+//
+
+LockContentionCounters::LockContentionCounters()
+{
+    clear();
+}
+
+void LockContentionCounters::clear()
+{
+    m_acquisition_count = 0;
+    m_contended_count = 0;
+    m_spin_count = 0;
+    m_park_count = 0;
+    m_wait_ticks = 0;
+}
+
+uint64 LockContentionCounters::get_acquisition_count() const
+{
+    return m_acquisition_count;
+}
+
+uint64 LockContentionCounters::get_contended_count() const
+{
+    return m_contended_count;
+}
+
+uint64 LockContentionCounters::get_spin_count() const
+{
+    return m_spin_count;
+}
+
+uint64 LockContentionCounters::get_park_count() const
+{
+    return m_park_count;
+}
+
+double LockContentionCounters::get_wait_time() const
+{
+    DefaultWallclockTimer timer;
+    return static_cast<double>(m_wait_ticks) / timer.frequency();
+}
+
+std::string LockContentionCounters::to_string() const
+{
+    const uint64 acquisitions = get_acquisition_count();
+    const uint64 contended = get_contended_count();
+
+    return
+        pretty_uint(acquisitions) + " acquisitions  " +
+        "contended " + pretty_uint(contended) + " (" + pretty_percent(contended, acquisitions) + ")  " +
+        "spins " + pretty_uint(get_spin_count()) + "  " +
+        "parks " + pretty_uint(get_park_count()) + "  " +
+        "wait time " + pretty_time(get_wait_time());
+}
+
+
+//
+// AdaptiveLock class implementation.
+//
+
+void AdaptiveLock::lock_contended()
+{
+    // Read the counters once, in case they are changed while we wait.
+    LockContentionCounters* counters = m_counters;
+
+    DefaultWallclockTimer timer;
+    uint64 start_time = 0;
+
+    if (counters)
+    {
+        ++counters->m_contended_count;
+        start_time = timer.read_start();
+    }
+
+    // Spin with bounded exponential backoff: locks are usually held briefly.
+    const uint32 MaxBackoffRounds = 10;
+    bool acquired = false;
+
+    for (uint32 i = 0; i < MaxBackoffRounds; ++i)
+    {
+        spin_wait(1u << i);
+
+        if (counters)
+            ++counters->m_spin_count;
+
+        if (m_state.load(boost::memory_order_relaxed) == Unlocked && try_acquire())
+        {
+            acquired = true;
+            break;
+        }
+    }
+
+    if (!acquired)
+    {
+        // Sleep until the lock is released. Marking the lock as having sleepers
+        // under the sleep mutex guarantees that the unlocking thread wakes us up.
+        boost::unique_lock<boost::mutex> lock(m_sleep_mutex);
+
+        while (m_state.exchange(LockedWithSleepers, boost::memory_order_acquire) != Unlocked)
+        {
+            if (counters)
+                ++counters->m_park_count;
+
+            m_sleep_event.wait(lock);
+        }
+    }
+
+    if (counters)
+        counters->m_wait_ticks += timer.read_end() - start_time;
+}
+
+void AdaptiveLock::wake_sleeper()
+{
+    boost::lock_guard<boost::mutex> lock(m_sleep_mutex);
+    m_sleep_event.notify_one();
+}
+
 
 //
 // ProcessPriorityContext class implementation (Windows).
@@ -339,6 +475,102 @@ void yield()
 #endif
 
 
+//
+// ThreadAffinityContext class implementation.
+//
+
+#if defined _WIN32
+
+    struct ThreadAffinityContext::Impl
+    {
+        Logger*     m_logger;
+        DWORD_PTR   m_initial_affinity_mask;
+    };
+
+    ThreadAffinityContext::ThreadAffinityContext(
+        const size_t            core_index,
+        Logger*                 logger)
+      : impl(new Impl())
+    {
+        impl->m_logger = logger;
+
+        // Only the cores of the current processor group can be addressed.
+        const DWORD_PTR mask = static_cast<DWORD_PTR>(1) << (core_index % (8 * sizeof(DWORD_PTR)));
+        impl->m_initial_affinity_mask = SetThreadAffinityMask(GetCurrentThread(), mask);
+
+        if (impl->m_initial_affinity_mask == 0 && logger)
+        {
+            LOG_WARNING(
+                *logger,
+                "failed to pin thread to logical core " FMT_SIZE_T " (%lu).",
+                core_index,
+                GetLastError());
+        }
+    }
+
+    ThreadAffinityContext::~ThreadAffinityContext()
+    {
+        if (impl->m_initial_affinity_mask != 0)
+            SetThreadAffinityMask(GetCurrentThread(), impl->m_initial_affinity_mask);
+
+        delete impl;
+    }
+
+#elif defined __linux__
+
+    struct ThreadAffinityContext::Impl
+    {
+        bool        m_restore;
+        cpu_set_t   m_initial_cpu_set;
+    };
+
+    ThreadAffinityContext::ThreadAffinityContext(
+        const size_t            core_index,
+        Logger*                 logger)
+      : impl(new Impl())
+    {
+        impl->m_restore =
+            pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &impl->m_initial_cpu_set) == 0;
+
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(core_index, &cpu_set);
+
+        const int result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+
+        if (result != 0 && logger)
+        {
+            LOG_WARNING(
+                *logger,
+                "failed to pin thread to logical core " FMT_SIZE_T " (%d).",
+                core_index,
+                result);
+        }
+    }
+
+    ThreadAffinityContext::~ThreadAffinityContext()
+    {
+        if (impl->m_restore)
+            pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &impl->m_initial_cpu_set);
+
+        delete impl;
+    }
+
+#else
+
+    ThreadAffinityContext::ThreadAffinityContext(
+        const size_t            core_index,
+        Logger*                 logger)
+    {
+    }
+
+    ThreadAffinityContext::~ThreadAffinityContext()
+    {
+    }
+
+#endif
+
+
 //
 // BenchmarkingThreadContext class implementation (Windows).
 //
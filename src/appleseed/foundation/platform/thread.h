@@ -39,11 +39,16 @@
 #include "main/dllsymbol.h"
 
 // Boost headers.
+#include "boost/atomic/atomic.hpp"
 #include "boost/smart_ptr/detail/spinlock.hpp"
+#include "boost/thread/condition_variable.hpp"
 #include "boost/thread/locks.hpp"
 #include "boost/thread/mutex.hpp"
 #include "boost/thread/thread.hpp"
 
+// Standard headers.
+#include <string>
+
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
 namespace foundation    { class Logger; }
@@ -66,6 +71,9 @@ APPLESEED_DLLSYMBOL void sleep(const uint32 ms, IAbortSwitch& abort_switch);
 // Give up the remainder of the current thread's time slice, to allow other threads to run.
 APPLESEED_DLLSYMBOL void yield();
 
+// Busy-wait for a number of iterations of the CPU's spin-wait hint instruction.
+APPLESEED_DLLSYMBOL void spin_wait(const uint32 iterations);
+
 
 //
 // A simple spinlock.
@@ -96,6 +104,107 @@ class Spinlock
 };
 
 
+//
+// Contention counters of one or several locks.
+//
+// Counters are updated with atomic operations and may be shared by several locks,
+// for instance by all the shards of a sharded data structure.
+//
+
+class APPLESEED_DLLSYMBOL LockContentionCounters
+  : public NonCopyable
+{
+  public:
+    // Constructor, clears the counters.
+    LockContentionCounters();
+
+    // Clear the counters.
+    void clear();
+
+    // Return the number of lock acquisitions, including successful calls to try_lock().
+    uint64 get_acquisition_count() const;
+
+    // Return the number of acquisitions that found the lock already held.
+    uint64 get_contended_count() const;
+
+    // Return the number of backoff rounds spent spinning on held locks.
+    uint64 get_spin_count() const;
+
+    // Return the number of times a thread was put to sleep waiting for a lock.
+    uint64 get_park_count() const;
+
+    // Return the total time spent waiting on contended locks, in seconds.
+    double get_wait_time() const;
+
+    // Return a one-line summary of the counters, for statistics reports.
+    std::string to_string() const;
+
+  private:
+    friend class AdaptiveLock;
+
+    boost::atomic<uint64>   m_acquisition_count;
+    boost::atomic<uint64>   m_contended_count;
+    boost::atomic<uint64>   m_spin_count;
+    boost::atomic<uint64>   m_park_count;
+    boost::atomic<uint64>   m_wait_ticks;
+};
+
+
+//
+// A lock that spins with bounded exponential backoff, then puts the waiting thread
+// to sleep. Unlike Spinlock, it doesn't waste whole time slices when there are more
+// threads than cores, and may be held for long periods of time.
+//
+
+class APPLESEED_DLLSYMBOL AdaptiveLock
+  : public NonCopyable
+{
+  public:
+    // Constructor. Contention counters are optional and must outlive the lock.
+    explicit AdaptiveLock(LockContentionCounters* counters = 0);
+
+    // Set the contention counters updated by this lock, or 0 to disable counting.
+    void set_contention_counters(LockContentionCounters* counters);
+
+    bool try_lock();
+    void lock();
+    void unlock();
+
+    class ScopedLock
+      : public NonCopyable
+    {
+      public:
+        explicit ScopedLock(AdaptiveLock& lock);
+        ~ScopedLock();
+
+      private:
+        AdaptiveLock& m_lock;
+    };
+
+  private:
+    enum State
+    {
+        Unlocked,
+        Locked,
+        LockedWithSleepers
+    };
+
+    boost::atomic<uint32>       m_state;
+    boost::mutex                m_sleep_mutex;
+    boost::condition_variable   m_sleep_event;
+    LockContentionCounters*     m_counters;
+
+    // Acquire the lock if it is free, without updating the counters.
+    bool try_acquire();
+
+    // Slow path of lock(), when the lock is already held.
+    void lock_contended();
+
+    // Slow path of unlock(), when threads are waiting for the lock.
+    void wake_sleeper();
+};
+
+
 //
 // A read/write lock.
 //
@@ -105,6 +214,19 @@ struct NoWaitPolicy
     static void pause(const uint32 iteration) {}
 };
 
+// Spin with exponential backoff, then yield, then sleep.
+struct BackoffWaitPolicy
+{
+    static void pause(const uint32 iteration)
+    {
+        if (iteration < 8)
+            spin_wait(1u << iteration);
+        else if (iteration < 16)
+            yield();
+        else sleep(1);
+    }
+};
+
 struct YieldWaitPolicy
 {
     static void pause(const uint32 iteration) { yield(); }
@@ -217,6 +339,32 @@ class APPLESEED_DLLSYMBOL ThreadPriorityContext
 };
 
 
+//
+// An object to pin the current thread to a given logical CPU core.
+//
+// Memory pages are usually allocated on the NUMA node of the thread that first
+// touches them, so data structures created while the context is active end up
+// in memory local to that core.
+//
+
+class APPLESEED_DLLSYMBOL ThreadAffinityContext
+  : public NonCopyable
+{
+  public:
+    // The constructor restricts the current thread to a given logical CPU core.
+    explicit ThreadAffinityContext(
+        const size_t            core_index,
+        Logger*                 logger = 0);
+
+    // The destructor restores previous settings.
+    ~ThreadAffinityContext();
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+
 //
 // An object to configure the current process and thread for accurate microbenchmarking.
 //
@@ -322,6 +470,65 @@ inline Spinlock::ScopedLock::ScopedLock(Spinlock& spinlock)
 }
 
 
+//
+// AdaptiveLock class implementation.
+//
+
+inline AdaptiveLock::AdaptiveLock(LockContentionCounters* counters)
+  : m_state(Unlocked)
+  , m_counters(counters)
+{
+}
+
+inline void AdaptiveLock::set_contention_counters(LockContentionCounters* counters)
+{
+    m_counters = counters;
+}
+
+inline bool AdaptiveLock::try_lock()
+{
+    if (!try_acquire())
+        return false;
+
+    if (m_counters)
+        ++m_counters->m_acquisition_count;
+
+    return true;
+}
+
+inline void AdaptiveLock::lock()
+{
+    if (m_counters)
+        ++m_counters->m_acquisition_count;
+
+    if (!try_acquire())
+        lock_contended();
+}
+
+inline void AdaptiveLock::unlock()
+{
+    if (m_state.exchange(Unlocked, boost::memory_order_release) == LockedWithSleepers)
+        wake_sleeper();
+}
+
+inline bool AdaptiveLock::try_acquire()
+{
+    uint32 expected = Unlocked;
+    return m_state.compare_exchange_strong(expected, Locked, boost::memory_order_acquire);
+}
+
+inline AdaptiveLock::ScopedLock::ScopedLock(AdaptiveLock& lock)
+  : m_lock(lock)
+{
+    m_lock.lock();
+}
+
+inline AdaptiveLock::ScopedLock::~ScopedLock()
+{
+    m_lock.unlock();
+}
+
+
 //
 // ReadWriteLock class implementation.
 //
@@ -32,6 +32,7 @@
 
 // Include all available timer classes here.
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/tsctimer.h"
 #ifdef APPLESEED_X86
 #include "foundation/platform/x86timer.h"
 #endif
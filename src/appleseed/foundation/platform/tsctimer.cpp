@@ -0,0 +1,101 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "tsctimer.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/defaulttimers.h"
+#ifdef APPLESEED_X86
+#include "foundation/platform/x86timer.h"
+#endif
+
+// Boost headers.
+#include "boost/thread/once.hpp"
+
+// Standard headers.
+#include <cassert>
+
+namespace foundation
+{
+
+//
+// TSCTimer class implementation.
+//
+
+namespace
+{
+    boost::once_flag g_calibration_flag = BOOST_ONCE_INIT;
+    uint64 g_frequency = 0;
+
+    void calibrate()
+    {
+#ifdef APPLESEED_X86
+
+        // Measure the time stamp counter against the wallclock timer, using the
+        // serialized reads of X86Timer at both ends of the calibration interval.
+        const uint64 CalibrationTimeUs = 20000;
+
+        X86Timer x86_timer(1);
+        DefaultWallclockTimer wallclock_timer;
+        const uint64 wallclock_frequency = wallclock_timer.frequency();
+
+        const uint64 wallclock_begin = wallclock_timer.read();
+        const uint64 tsc_begin = x86_timer.read_start();
+
+        uint64 wallclock_end;
+        do
+        {
+            wallclock_end = wallclock_timer.read();
+        } while ((wallclock_end - wallclock_begin) * 1000000 < CalibrationTimeUs * wallclock_frequency);
+
+        const uint64 tsc_end = x86_timer.read_end();
+
+        g_frequency =
+            static_cast<uint64>(
+                static_cast<double>(tsc_end - tsc_begin) * wallclock_frequency / (wallclock_end - wallclock_begin));
+
+#else
+
+        DefaultWallclockTimer wallclock_timer;
+        g_frequency = wallclock_timer.frequency();
+
+#endif
+
+        assert(g_frequency > 0);
+    }
+}
+
+uint64 TSCTimer::frequency()
+{
+    boost::call_once(g_calibration_flag, &calibrate);
+    return g_frequency;
+}
+
+}   // namespace foundation
@@ -0,0 +1,112 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_FOUNDATION_PLATFORM_TSCTIMER_H
+#define APPLESEED_FOUNDATION_PLATFORM_TSCTIMER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
+#ifndef APPLESEED_X86
+#include "foundation/platform/defaulttimers.h"
+#endif
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Platform headers.
+#if defined APPLESEED_X86 && defined _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace foundation
+{
+
+//
+// A cheap wallclock-time timer for instrumenting hot code paths.
+//
+// On x86, it reads the processor time stamp counter with a single RDTSC instruction.
+// Unlike X86Timer, reads are not serialized with CPUID, which makes them an order of
+// magnitude cheaper at the expense of a few cycles of imprecision, and the frequency
+// is measured once per process instead of once per timer. This assumes the time stamp
+// counter runs at a constant rate and is synchronized across cores, as it is on all
+// recent x86 processors.
+//
+// On other platforms, this timer falls back to DefaultWallclockTimer.
+//
+
+class APPLESEED_DLLSYMBOL TSCTimer
+  : public NonCopyable
+{
+  public:
+    // Get the timer frequency, in Hz. The first call in the process calibrates the
+    // timer, which takes a few milliseconds. Thread-safe.
+    uint64 frequency();
+
+    // Read the timer value.
+    uint64 read();
+
+    // For benchmarking, read the timer value before the benchmark starts.
+    uint64 read_start() { return read(); }
+
+    // For benchmarking, read the timer value after the benchmark ends.
+    uint64 read_end() { return read(); }
+};
+
+
+//
+// TSCTimer class implementation.
+//
+
+inline uint64 TSCTimer::read()
+{
+// x86, Visual C++.
+#if defined APPLESEED_X86 && defined _MSC_VER
+
+    return __rdtsc();
+
+// x86, gcc.
+#elif defined APPLESEED_X86 && defined __GNUC__
+
+    uint32 h, l;
+    asm volatile ("rdtsc" : "=a" (l), "=d" (h));
+    return (static_cast<uint64>(h) << 32) | l;
+
+// Other platforms.
+#else
+
+    DefaultWallclockTimer timer;
+    return timer.read();
+
+#endif
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_PLATFORM_TSCTIMER_H
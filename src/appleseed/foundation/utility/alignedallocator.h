@@ -42,7 +42,9 @@ namespace foundation
 {
 
 //
-// A standard-conformant allocator allocating aligned memory.
+// A standard-conformant allocator allocating aligned memory, optionally backed by
+// large pages (see foundation::large_page_malloc()) to reduce TLB misses when large
+// arrays are accessed randomly.
 //
 
 template <typename T>
@@ -63,31 +65,39 @@ class AlignedAllocator
         typedef AlignedAllocator<U> other;
     };
 
-    explicit AlignedAllocator(const size_t alignment = 16)
+    explicit AlignedAllocator(
+        const size_t    alignment = 16,
+        const bool      use_large_pages = false)
       : m_alignment(alignment)
+      , m_use_large_pages(use_large_pages)
     {
     }
 
     AlignedAllocator(const AlignedAllocator& rhs)
       : m_alignment(rhs.m_alignment)
+      , m_use_large_pages(rhs.m_use_large_pages)
     {
     }
 
     template <typename U>
     AlignedAllocator(const AlignedAllocator<U>& rhs)
       : m_alignment(rhs.m_alignment)
+      , m_use_large_pages(rhs.m_use_large_pages)
     {
     }
 
     AlignedAllocator& operator=(const AlignedAllocator& rhs)
     {
         m_alignment = rhs.m_alignment;
+        m_use_large_pages = rhs.m_use_large_pages;
         return *this;
     }
 
     bool operator==(const AlignedAllocator<T>& rhs) const
     {
-        return m_alignment == rhs.m_alignment;
+        return
+            m_alignment == rhs.m_alignment &&
+            m_use_large_pages == rhs.m_use_large_pages;
     }
 
     template <typename U>
@@ -117,7 +127,11 @@ class AlignedAllocator
         if (n == 0)
             return 0;
 
-        pointer p = static_cast<pointer>(aligned_malloc(n * sizeof(T), m_alignment));
+        pointer p =
+            static_cast<pointer>(
+                m_use_large_pages
+                    ? large_page_malloc(n * sizeof(T), m_alignment)
+                    : aligned_malloc(n * sizeof(T), m_alignment));
 
         if (p == 0)
              throw std::bad_alloc();
@@ -128,7 +142,11 @@ class AlignedAllocator
     void deallocate(pointer p, size_type n)
     {
         if (p)
-            aligned_free(p);
+        {
+            if (m_use_large_pages)
+                large_page_free(p, n * sizeof(T));
+            else aligned_free(p);
+        }
     }
 
     size_type max_size() const
@@ -152,6 +170,7 @@ class AlignedAllocator
     friend class AlignedAllocator;
 
     size_t m_alignment;
+    bool   m_use_large_pages;
 };
 
 // A partial specialization for the void value type is required for rebinding
@@ -170,14 +189,18 @@ class AlignedAllocator<void>
         typedef AlignedAllocator<U> other;
     };
 
-    explicit AlignedAllocator(const size_t alignment = 16)
+    explicit AlignedAllocator(
+        const size_t    alignment = 16,
+        const bool      use_large_pages = false)
       : m_alignment(alignment)
+      , m_use_large_pages(use_large_pages)
     {
     }
 
     template <typename U>
     AlignedAllocator(const AlignedAllocator<U>& rhs)
       : m_alignment(rhs.m_alignment)
+      , m_use_large_pages(rhs.m_use_large_pages)
     {
     }
 
@@ -187,6 +210,7 @@ class AlignedAllocator<void>
     friend class AlignedAllocator;
 
     const size_t m_alignment;
+    const bool   m_use_large_pages;
 };
 
 }       // namespace foundation
@@ -31,7 +31,7 @@
 #define APPLESEED_FOUNDATION_UTILITY_ARENA_H
 
 // appleseed.foundation headers.
-#include "foundation/core/exceptions/exception.h"
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/memory.h"
@@ -46,25 +46,55 @@ namespace foundation
 //
 // An arena is a temporary heap providing extremely cheap memory allocation.
 //
+// Each rendering thread owns an arena, reachable from its shading context, and clears
+// it before each sample. Allocations that don't fit in the arena are made on the heap
+// and released with the arena; they are counted so that they can be tracked down.
+//
 
 class Arena
+  : public NonCopyable
 {
   public:
     Arena();
+    ~Arena();
 
     void clear();
 
+    // Release all allocations made since a given mark.
+    size_t get_mark() const;
+    void rewind(const size_t mark);
+
     void* allocate(const size_t size);
 
     template <typename T> T* allocate();
     template <typename T> T* allocate_noinit();
 
+    // Allocate an array of uninitialized objects. Return 0 if count is 0.
+    template <typename T> T* allocate_array(const size_t count);
+
+    // Return the number of allocations that did not fit in the arena and were made on the
+    // heap since the arena was constructed. Heap allocations are only counted in debug builds.
+    uint64 get_heap_allocation_count() const;
+
   private:
     enum { ArenaSize = 256 * 1024 };    // bytes
 
+    // Header of the memory blocks allocated on the heap.
+    struct HeapBlock
+    {
+        HeapBlock*  m_next;
+        uint8       m_padding[16 - sizeof(HeapBlock*)];
+    };
+
     APPLESEED_SIMD4_ALIGN uint8 m_storage[ArenaSize];
     const uint8*                m_end;
     uint8*                      m_current;
+    HeapBlock*                  m_heap_blocks;          // most recent first
+    size_t                      m_heap_block_count;
+    uint64                      m_heap_allocation_count;
+
+    void* allocate_on_heap(const size_t size);
+    void release_heap_blocks(const size_t count);
 };
 
 
@@ -75,18 +105,45 @@ class Arena
 inline Arena::Arena()
   : m_end(m_storage + ArenaSize)
   , m_current(m_storage)
+  , m_heap_blocks(0)
+  , m_heap_block_count(0)
+  , m_heap_allocation_count(0)
+{
+}
+
+inline Arena::~Arena()
 {
+    release_heap_blocks(m_heap_block_count);
 }
 
 inline void Arena::clear()
 {
     m_current = m_storage;
+    release_heap_blocks(m_heap_block_count);
+}
+
+inline size_t Arena::get_mark() const
+{
+    // The mark encodes both the position in the storage and the number of heap blocks.
+    return m_heap_block_count * (ArenaSize + 1) + (m_current - m_storage);
+}
+
+inline void Arena::rewind(const size_t mark)
+{
+    const size_t heap_block_count = mark / (ArenaSize + 1);
+    const size_t offset = mark % (ArenaSize + 1);
+
+    assert(heap_block_count <= m_heap_block_count);
+    assert(m_storage + offset <= m_current);
+
+    release_heap_blocks(m_heap_block_count - heap_block_count);
+    m_current = m_storage + offset;
 }
 
 inline void* Arena::allocate(const size_t size)
 {
     if (m_current + size > m_end)
-        throw Exception("out of arena memory");
+        return allocate_on_heap(size);
 
     void* ptr = m_current;
     m_current += align(size, 16);
@@ -112,6 +169,45 @@ inline T* Arena::allocate_noinit()
     return static_cast<T*>(allocate(sizeof(T)));
 }
 
+template <typename T>
+inline T* Arena::allocate_array(const size_t count)
+{
+    return count > 0 ? static_cast<T*>(allocate(count * sizeof(T))) : 0;
+}
+
+inline uint64 Arena::get_heap_allocation_count() const
+{
+    return m_heap_allocation_count;
+}
+
+inline void* Arena::allocate_on_heap(const size_t size)
+{
+    HeapBlock* block = static_cast<HeapBlock*>(aligned_malloc(sizeof(HeapBlock) + size, 16));
+    block->m_next = m_heap_blocks;
+    m_heap_blocks = block;
+    ++m_heap_block_count;
+
+#ifndef NDEBUG
+    ++m_heap_allocation_count;
+#endif
+
+    return block + 1;
+}
+
+inline void Arena::release_heap_blocks(const size_t count)
+{
+    assert(count <= m_heap_block_count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        HeapBlock* block = m_heap_blocks;
+        m_heap_blocks = block->m_next;
+        aligned_free(block);
+    }
+
+    m_heap_block_count -= count;
+}
+
 }       // namespace foundation
 
 #endif  // !APPLESEED_FOUNDATION_UTILITY_ARENA_H
@@ -30,6 +30,9 @@
 // Interface header.
 #include "attributeset.h"
 
+// appleseed.foundation headers.
+#include "foundation/utility/siphash.h"
+
 // Standard headers.
 #include <cstring>
 
@@ -89,4 +92,53 @@ AttributeSet::ChannelID AttributeSet::find_channel(const char* name) const
     return InvalidChannelID;
 }
 
+uint64 AttributeSet::compute_hash() const
+{
+    uint64 hash = siphash24(m_channels.size());
+
+    for (size_t i = 0; i < m_channels.size(); ++i)
+    {
+        const Channel& channel = *m_channels[i];
+
+        hash = siphash24(hash, siphash24(channel.m_name.c_str(), channel.m_name.size()));
+        hash = siphash24(hash, static_cast<uint64>(channel.m_type));
+        hash = siphash24(hash, static_cast<uint64>(channel.m_dimension));
+
+        if (!channel.m_storage.empty())
+            hash = siphash24(hash, siphash24(&channel.m_storage[0], channel.m_storage.size()));
+    }
+
+    return hash;
+}
+
+bool AttributeSet::is_equal(const AttributeSet& rhs) const
+{
+    if (m_channels.size() != rhs.m_channels.size())
+        return false;
+
+    for (size_t i = 0; i < m_channels.size(); ++i)
+    {
+        const Channel& lhs_channel = *m_channels[i];
+        const Channel& rhs_channel = *rhs.m_channels[i];
+
+        if (lhs_channel.m_name != rhs_channel.m_name ||
+            lhs_channel.m_type != rhs_channel.m_type ||
+            lhs_channel.m_dimension != rhs_channel.m_dimension ||
+            lhs_channel.m_storage != rhs_channel.m_storage)
+            return false;
+    }
+
+    return true;
+}
+
+size_t AttributeSet::get_memory_size() const
+{
+    size_t size = sizeof(*this) + m_channels.capacity() * sizeof(Channel*);
+
+    for (size_t i = 0; i < m_channels.size(); ++i)
+        size += sizeof(Channel) + m_channels[i]->m_storage.capacity();
+
+    return size;
+}
+
 }   // namespace foundation
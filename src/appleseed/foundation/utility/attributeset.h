@@ -75,6 +75,15 @@ class AttributeSet
     // the cost of constructing a std::string object.
     ChannelID find_channel(const char* name) const;
 
+    // Compute a hash of the channels and their attributes.
+    uint64 compute_hash() const;
+
+    // Return true if this attribute set has the same channels and attributes as another one.
+    bool is_equal(const AttributeSet& rhs) const;
+
+    // Return the amount of memory used by the attribute set, in bytes.
+    size_t get_memory_size() const;
+
     // Return the number of attributes in a given attribute channel.
     size_t get_attribute_count(const ChannelID channel_id) const;
 
@@ -0,0 +1,262 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "benchmarkcomparison.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/population.h"
+#include "foundation/math/scalar.h"
+#include "foundation/utility/benchmark/benchmarkaggregator.h"
+#include "foundation/utility/benchmark/benchmarkdatapoint.h"
+#include "foundation/utility/benchmark/benchmarkserie.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/foreach.h"
+#include "foundation/utility/otherwise.h"
+#include "foundation/utility/uid.h"
+
+// Standard headers.
+#include <cassert>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace foundation
+{
+
+//
+// compare_benchmark_series() function implementation.
+//
+
+namespace
+{
+    // Return the two-sided 95% critical value of Student's t distribution.
+    double get_t_critical_value(const double dof)
+    {
+        static const double Table[] =
+        {
+            12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+             2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+             2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+        };
+
+        const size_t TableSize = sizeof(Table) / sizeof(Table[0]);
+
+        if (dof < 1.0)
+            return Table[0];
+
+        // Round the degrees of freedom down to stay on the conservative side.
+        const size_t index = static_cast<size_t>(dof) - 1;
+
+        if (index < TableSize)
+            return Table[index];
+
+        // Cornish-Fisher expansion of the critical value around the normal one.
+        const double z = 1.959964;
+        return z + (z * z * z + z) / (4.0 * dof);
+    }
+
+    // Return the squared relative standard error of the mean of a serie.
+    double get_relative_variance(const Population<double>& pop)
+    {
+        const size_t n = pop.get_size();
+        const double mean = pop.get_mean();
+
+        assert(n > 1);
+
+        if (mean == 0.0)
+            return 0.0;
+
+        // Unbiased variance of the measurements.
+        const double variance = square(pop.get_dev()) * n / (n - 1);
+
+        return variance / (n * square(mean));
+    }
+}
+
+BenchmarkCaseComparison compare_benchmark_series(
+    const BenchmarkSerie&   baseline,
+    const BenchmarkSerie&   candidate,
+    const double            tolerance)
+{
+    Population<double> baseline_pop, candidate_pop;
+
+    for (size_t i = 0; i < baseline.size(); ++i)
+        baseline_pop.insert(baseline[i].get_ticks());
+
+    for (size_t i = 0; i < candidate.size(); ++i)
+        candidate_pop.insert(candidate[i].get_ticks());
+
+    BenchmarkCaseComparison result;
+    result.m_baseline_count = baseline_pop.get_size();
+    result.m_candidate_count = candidate_pop.get_size();
+    result.m_speedup =
+        candidate_pop.get_mean() > 0.0
+            ? baseline_pop.get_mean() / candidate_pop.get_mean()
+            : 1.0;
+    result.m_speedup_low = result.m_speedup;
+    result.m_speedup_high = result.m_speedup;
+
+    if (result.m_baseline_count < 2 || result.m_candidate_count < 2)
+    {
+        result.m_verdict = BenchmarkCaseComparison::Inconclusive;
+        return result;
+    }
+
+    // The variance of the log of a ratio is approximately the sum of the
+    // squared relative standard errors of its terms (delta method).
+    const double rb = get_relative_variance(baseline_pop);
+    const double rc = get_relative_variance(candidate_pop);
+    const double r = rb + rc;
+
+    if (r > 0.0)
+    {
+        // Welch-Satterthwaite approximation of the degrees of freedom.
+        const double dof =
+            square(r) /
+            (square(rb) / (result.m_baseline_count - 1) + square(rc) / (result.m_candidate_count - 1));
+
+        const double half_width = get_t_critical_value(dof) * sqrt(r);
+        result.m_speedup_low = result.m_speedup * exp(-half_width);
+        result.m_speedup_high = result.m_speedup * exp(half_width);
+    }
+
+    if (result.m_speedup_high < 1.0 - tolerance)
+        result.m_verdict = BenchmarkCaseComparison::Regression;
+    else if (result.m_speedup_low > 1.0 + tolerance)
+        result.m_verdict = BenchmarkCaseComparison::Improvement;
+    else result.m_verdict = BenchmarkCaseComparison::Unchanged;
+
+    return result;
+}
+
+const char* get_verdict_name(const BenchmarkCaseComparison::Verdict verdict)
+{
+    switch (verdict)
+    {
+      case BenchmarkCaseComparison::Inconclusive: return "inconclusive";
+      case BenchmarkCaseComparison::Unchanged:    return "unchanged";
+      case BenchmarkCaseComparison::Improvement:  return "improvement";
+      case BenchmarkCaseComparison::Regression:   return "regression";
+      assert_otherwise;
+    }
+
+    // Keep the compiler happy.
+    return "";
+}
+
+
+//
+// BenchmarkComparison class implementation.
+//
+
+struct BenchmarkComparison::Impl
+{
+    vector<string>                      m_case_names;
+    vector<BenchmarkCaseComparison>     m_comparisons;
+    size_t                              m_regression_count;
+};
+
+BenchmarkComparison::BenchmarkComparison(
+    const BenchmarkAggregator&  baseline,
+    const BenchmarkAggregator&  candidate,
+    const double                tolerance)
+  : impl(new Impl())
+{
+    impl->m_regression_count = 0;
+
+    const Dictionary& baseline_configs = baseline.get_benchmarks();
+    const Dictionary& candidate_configs = candidate.get_benchmarks();
+
+    for (const_each<DictionaryDictionary> c = baseline_configs.dictionaries(); c; ++c)
+    {
+        if (!candidate_configs.dictionaries().exist(c->key()))
+            continue;
+
+        const Dictionary& candidate_suites = candidate_configs.dictionaries().get(c->key());
+
+        for (const_each<DictionaryDictionary> s = c->value().dictionaries(); s; ++s)
+        {
+            if (!candidate_suites.dictionaries().exist(s->key()))
+                continue;
+
+            const Dictionary& candidate_cases = candidate_suites.dictionaries().get(s->key());
+
+            for (const_each<StringDictionary> i = s->value().strings(); i; ++i)
+            {
+                if (!candidate_cases.strings().exist(i->key()))
+                    continue;
+
+                const BenchmarkCaseComparison comparison =
+                    compare_benchmark_series(
+                        baseline.get_serie(i->value<UniqueID>()),
+                        candidate.get_serie(candidate_cases.get<UniqueID>(i->key())),
+                        tolerance);
+
+                impl->m_case_names.push_back(
+                    string(c->key()) + "/" + s->key() + "/" + i->key());
+                impl->m_comparisons.push_back(comparison);
+
+                if (comparison.m_verdict == BenchmarkCaseComparison::Regression)
+                    ++impl->m_regression_count;
+            }
+        }
+    }
+}
+
+BenchmarkComparison::~BenchmarkComparison()
+{
+    delete impl;
+}
+
+size_t BenchmarkComparison::get_case_count() const
+{
+    return impl->m_comparisons.size();
+}
+
+const char* BenchmarkComparison::get_case_name(const size_t index) const
+{
+    assert(index < impl->m_case_names.size());
+    return impl->m_case_names[index].c_str();
+}
+
+const BenchmarkCaseComparison& BenchmarkComparison::get_case_comparison(const size_t index) const
+{
+    assert(index < impl->m_comparisons.size());
+    return impl->m_comparisons[index];
+}
+
+size_t BenchmarkComparison::get_regression_count() const
+{
+    return impl->m_regression_count;
+}
+
+}   // namespace foundation
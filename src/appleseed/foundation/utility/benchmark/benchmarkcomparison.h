@@ -0,0 +1,127 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_FOUNDATION_UTILITY_BENCHMARK_BENCHMARKCOMPARISON_H
+#define APPLESEED_FOUNDATION_UTILITY_BENCHMARK_BENCHMARKCOMPARISON_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class BenchmarkAggregator; }
+namespace foundation    { class BenchmarkSerie; }
+
+namespace foundation
+{
+
+//
+// Comparison of the running times of a benchmark case between a baseline
+// and a candidate set of results.
+//
+// The speedup is the ratio of the mean baseline running time to the mean
+// candidate running time: values greater than 1 mean that the candidate is
+// faster. Its 95% confidence interval is derived from the spread of the
+// repeated measurements of each set (Welch's t-test on the log of the ratio).
+//
+
+class BenchmarkCaseComparison
+{
+  public:
+    enum Verdict
+    {
+        Inconclusive,                   // less than two measurements in one of the sets
+        Unchanged,                      // the confidence interval overlaps the tolerance band
+        Improvement,                    // the candidate is significantly faster
+        Regression                      // the candidate is significantly slower
+    };
+
+    size_t  m_baseline_count;           // number of baseline measurements
+    size_t  m_candidate_count;          // number of candidate measurements
+    double  m_speedup;                  // mean baseline time / mean candidate time
+    double  m_speedup_low;              // lower bound of the 95% confidence interval
+    double  m_speedup_high;             // upper bound of the 95% confidence interval
+    Verdict m_verdict;
+};
+
+// Compare two series of measurements of the same benchmark case. A change is
+// only reported when the whole confidence interval lies outside [1 - tolerance, 1 + tolerance].
+APPLESEED_DLLSYMBOL BenchmarkCaseComparison compare_benchmark_series(
+    const BenchmarkSerie&   baseline,
+    const BenchmarkSerie&   candidate,
+    const double            tolerance = 0.01);
+
+// Return a string identifying a verdict.
+APPLESEED_DLLSYMBOL const char* get_verdict_name(const BenchmarkCaseComparison::Verdict verdict);
+
+
+//
+// Comparison of all the benchmark cases found in both a baseline and a candidate
+// set of results, typically loaded from two directories of XML result files
+// where each file holds one run of the benchmarks.
+//
+
+class APPLESEED_DLLSYMBOL BenchmarkComparison
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    BenchmarkComparison(
+        const BenchmarkAggregator&  baseline,
+        const BenchmarkAggregator&  candidate,
+        const double                tolerance = 0.01);
+
+    // Destructor.
+    ~BenchmarkComparison();
+
+    // Return the number of benchmark cases found in both sets of results.
+    size_t get_case_count() const;
+
+    // Return the name of a benchmark case, as "configuration/suite/case".
+    const char* get_case_name(const size_t index) const;
+
+    // Return the comparison of a benchmark case.
+    const BenchmarkCaseComparison& get_case_comparison(const size_t index) const;
+
+    // Return the number of benchmark cases that significantly regressed.
+    size_t get_regression_count() const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_UTILITY_BENCHMARK_BENCHMARKCOMPARISON_H
@@ -42,6 +42,7 @@
 // Forward declarations.
 namespace foundation    { class BenchmarkSuite; }
 namespace foundation    { class IBenchmarkCase; }
+namespace foundation    { class MetricResult; }
 namespace foundation    { class TimingResult; }
 
 namespace foundation
@@ -100,6 +101,16 @@ class APPLESEED_DLLSYMBOL BenchmarkListenerBase
         const TimingResult&     timing_result)
     {
     }
+
+    // Write a measurement other than running time.
+    virtual void write(
+        const BenchmarkSuite&   benchmark_suite,
+        const IBenchmarkCase&   benchmark_case,
+        const char*             file,
+        const size_t            line,
+        const MetricResult&     metric_result)
+    {
+    }
 };
 
 }       // namespace foundation
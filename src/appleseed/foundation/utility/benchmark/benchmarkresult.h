@@ -44,6 +44,7 @@
 namespace foundation    { class BenchmarkSuite; }
 namespace foundation    { class IBenchmarkCase; }
 namespace foundation    { class IBenchmarkListener; }
+namespace foundation    { class MetricResult; }
 namespace foundation    { class TimingResult; }
 
 namespace foundation
@@ -119,6 +120,14 @@ class APPLESEED_DLLSYMBOL BenchmarkResult
         const size_t            line,
         const TimingResult&     timing_result);
 
+    // Write a measurement other than running time.
+    void write(
+        const BenchmarkSuite&   benchmark_suite,
+        const IBenchmarkCase&   benchmark_case,
+        const char*             file,
+        const size_t            line,
+        const MetricResult&     metric_result);
+
   private:
     struct Impl;
     Impl* impl;
@@ -33,12 +33,14 @@
 // appleseed.foundation headers.
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/hardwarecounters.h"
 #include "foundation/platform/thread.h"
 #include "foundation/platform/timers.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/benchmark/benchmarkresult.h"
 #include "foundation/utility/benchmark/ibenchmarkcase.h"
 #include "foundation/utility/benchmark/ibenchmarkcasefactory.h"
+#include "foundation/utility/benchmark/metricresult.h"
 #include "foundation/utility/benchmark/timingresult.h"
 #include "foundation/utility/filter.h"
 #include "foundation/utility/gnuplotfile.h"
@@ -94,6 +96,7 @@ struct BenchmarkSuite::Impl
 
     string                          m_name;
     vector<IBenchmarkCaseFactory*>  m_factories;
+    bool                            m_collect_hardware_counters;
 
     static double measure_runtime_seconds(
         IBenchmarkCase*         benchmark,
@@ -156,6 +159,50 @@ struct BenchmarkSuite::Impl
                 min(MaxMeasurementCount * measurement_time, MaxTargetTotalTime) / measurement_time));
     }
 
+    // Count hardware events over a given number of runs of a benchmark case. This is done
+    // separately from timing measurements so that controlling the counters doesn't perturb them.
+    static void measure_hardware_counters(
+        IBenchmarkCase*         benchmark,
+        const size_t            measurement_count,
+        vector<MetricResult>&   metrics)
+    {
+        HardwareCounters counters;
+
+        counters.start();
+
+        for (size_t i = 0; i < measurement_count; ++i)
+            benchmark->run();
+
+        counters.stop();
+
+        for (size_t i = 0; i < HardwareCounters::CounterCount; ++i)
+        {
+            const HardwareCounters::Counter counter = static_cast<HardwareCounters::Counter>(i);
+
+            if (counters.is_available(counter))
+            {
+                MetricResult metric;
+                metric.m_name = HardwareCounters::get_name(counter);
+                metric.m_unit = "per run";
+                metric.m_value = static_cast<double>(counters.get_value(counter)) / measurement_count;
+                metrics.push_back(metric);
+            }
+        }
+
+        if (counters.is_available(HardwareCounters::Cycles) &&
+            counters.is_available(HardwareCounters::Instructions) &&
+            counters.get_value(HardwareCounters::Cycles) > 0)
+        {
+            MetricResult metric;
+            metric.m_name = "instructions per cycle";
+            metric.m_unit = "";
+            metric.m_value =
+                  static_cast<double>(counters.get_value(HardwareCounters::Instructions))
+                / counters.get_value(HardwareCounters::Cycles);
+            metrics.push_back(metric);
+        }
+    }
+
     // Measure and return the overhead (in ticks) of running an empty benchmark case.
     static double measure_call_overhead_ticks(
         StopwatchType&          stopwatch,
@@ -176,6 +223,7 @@ BenchmarkSuite::BenchmarkSuite(const char* name)
 {
     assert(name);
     impl->m_name = name;
+    impl->m_collect_hardware_counters = false;
 }
 
 BenchmarkSuite::~BenchmarkSuite()
@@ -194,6 +242,11 @@ void BenchmarkSuite::register_case(IBenchmarkCaseFactory* factory)
     impl->m_factories.push_back(factory);
 }
 
+void BenchmarkSuite::set_collect_hardware_counters(const bool collect)
+{
+    impl->m_collect_hardware_counters = collect;
+}
+
 void BenchmarkSuite::run(BenchmarkResult& suite_result) const
 {
     PassThroughFilter filter;
@@ -241,9 +294,11 @@ void BenchmarkSuite::run(
         {
             suite_result.signal_case_execution();
 
-            // Estimate benchmarking parameters.
+            // Estimate benchmarking parameters, unless the benchmark case imposes them.
             const size_t measurement_count =
-                Impl::compute_measurement_count(benchmark.get(), stopwatch);
+                benchmark->get_measurement_count() > 0
+                    ? benchmark->get_measurement_count()
+                    : Impl::compute_measurement_count(benchmark.get(), stopwatch);
 
             // Measure the overhead of calling IBenchmarkCase::run().
             const double overhead_ticks =
@@ -258,30 +313,34 @@ void BenchmarkSuite::run(
                     measurement_count);
 
 #ifdef GENERATE_BENCHMARK_PLOTS
-            vector<Vector2d> points;
-
-            for (size_t j = 0; j < 100; ++j)
+            // Plotting requires many more runs, skip it for benchmark cases with a fixed measurement count.
+            if (benchmark->get_measurement_count() == 0)
             {
-                const double ticks =
-                    Impl::measure_runtime(
-                        benchmark.get(),
-                        stopwatch,
-                        BenchmarkSuite::Impl::measure_runtime_ticks,
-                        max<size_t>(1, measurement_count / 100));
-                points.push_back(
-                    Vector2d(
-                        static_cast<double>(j),
-                        ticks > overhead_ticks ? ticks - overhead_ticks : 0.0));
+                vector<Vector2d> points;
+
+                for (size_t j = 0; j < 100; ++j)
+                {
+                    const double ticks =
+                        Impl::measure_runtime(
+                            benchmark.get(),
+                            stopwatch,
+                            BenchmarkSuite::Impl::measure_runtime_ticks,
+                            max<size_t>(1, measurement_count / 100));
+                    points.push_back(
+                        Vector2d(
+                            static_cast<double>(j),
+                            ticks > overhead_ticks ? ticks - overhead_ticks : 0.0));
+                }
+
+                stringstream sstr;
+                sstr << "unit benchmarks/plots/";
+                sstr << get_name() << "_" << benchmark->get_name();
+                sstr << ".gnuplot";
+
+                GnuplotFile plotfile;
+                plotfile.new_plot().set_points(points);
+                plotfile.write(sstr.str());
             }
-
-            stringstream sstr;
-            sstr << "unit benchmarks/plots/";
-            sstr << get_name() << "_" << benchmark->get_name();
-            sstr << ".gnuplot";
-
-            GnuplotFile plotfile;
-            plotfile.new_plot().set_points(points);
-            plotfile.write(sstr.str());
 #endif
 
             // Gather the timing results.
@@ -298,6 +357,37 @@ void BenchmarkSuite::run(
                 __FILE__,
                 __LINE__,
                 timing_result);
+
+            // Post the other measurements made by the benchmark case.
+            for (size_t j = 0; j < benchmark->get_metric_count(); ++j)
+            {
+                MetricResult metric_result;
+                benchmark->get_metric(j, metric_result);
+
+                suite_result.write(
+                    *this,
+                    *benchmark.get(),
+                    __FILE__,
+                    __LINE__,
+                    metric_result);
+            }
+
+            // Post the hardware counters.
+            if (impl->m_collect_hardware_counters)
+            {
+                vector<MetricResult> counter_metrics;
+                Impl::measure_hardware_counters(benchmark.get(), measurement_count, counter_metrics);
+
+                for (size_t j = 0; j < counter_metrics.size(); ++j)
+                {
+                    suite_result.write(
+                        *this,
+                        *benchmark.get(),
+                        __FILE__,
+                        __LINE__,
+                        counter_metrics[j]);
+                }
+            }
         }
 #ifdef NDEBUG
         catch (const exception& e)
@@ -64,6 +64,11 @@ class APPLESEED_DLLSYMBOL BenchmarkSuite
     // Register a benchmark case (via its factory function).
     void register_case(IBenchmarkCaseFactory* factory);
 
+    // Enable or disable the collection of hardware performance counters (cycles,
+    // instructions, cache and branch misses) for each benchmark case. Disabled by default.
+    // The counters are reported as metrics, per run of the benchmark case.
+    void set_collect_hardware_counters(const bool collect);
+
     // Run all the registered benchmark cases.
     void run(BenchmarkResult& suite_result) const;
 
@@ -52,11 +52,13 @@ namespace foundation
 struct BenchmarkSuiteRepository::Impl
 {
     vector<BenchmarkSuite*> m_suites;
+    bool                    m_collect_hardware_counters;
 };
 
 BenchmarkSuiteRepository::BenchmarkSuiteRepository()
   : impl(new Impl())
 {
+    impl->m_collect_hardware_counters = false;
 }
 
 BenchmarkSuiteRepository::~BenchmarkSuiteRepository()
@@ -70,6 +72,11 @@ void BenchmarkSuiteRepository::register_suite(BenchmarkSuite* suite)
     impl->m_suites.push_back(suite);
 }
 
+void BenchmarkSuiteRepository::set_collect_hardware_counters(const bool collect)
+{
+    impl->m_collect_hardware_counters = collect;
+}
+
 void BenchmarkSuiteRepository::run(BenchmarkResult& result) const
 {
     PassThroughFilter filter;
@@ -89,6 +96,7 @@ void BenchmarkSuiteRepository::run(
         suite_result.add_listeners(result);
 
         // Run the benchmark suite.
+        suite.set_collect_hardware_counters(impl->m_collect_hardware_counters);
         if (filter.accepts(suite.get_name()))
             suite.run(suite_result);
         else suite.run(filter, suite_result);
@@ -55,6 +55,9 @@ class APPLESEED_DLLSYMBOL BenchmarkSuiteRepository
     // Register a benchmark suite.
     void register_suite(BenchmarkSuite* suite);
 
+    // Enable or disable the collection of hardware performance counters in all benchmark suites.
+    void set_collect_hardware_counters(const bool collect);
+
     // Run all the registered benchmark suites.
     void run(BenchmarkResult& result) const;
 
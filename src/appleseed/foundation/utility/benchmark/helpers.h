@@ -168,6 +168,54 @@ namespace foundation
     void BenchmarkCase##Name::run()
 
 
+//
+// Define a benchmark case deriving from a given base class, itself deriving from
+// foundation::IBenchmarkCase. Unlike a fixture, the base class can override the
+// optional methods of IBenchmarkCase, for instance to impose the number of
+// measurements or to report measurements other than running time.
+//
+
+#define BENCHMARK_CASE_WITH_BASE(Name, BaseName)                                            \
+    struct BenchmarkCase##Name                                                              \
+      : public BaseName                                                                     \
+    {                                                                                       \
+        virtual const char* get_name() const                                                \
+        {                                                                                   \
+            return #Name;                                                                   \
+        }                                                                                   \
+                                                                                            \
+        virtual void run();                                                                 \
+    };                                                                                      \
+                                                                                            \
+    struct BenchmarkCase##Name##Factory                                                     \
+      : public foundation::IBenchmarkCaseFactory                                            \
+    {                                                                                       \
+        virtual const char* get_name() const                                                \
+        {                                                                                   \
+            return #Name;                                                                   \
+        }                                                                                   \
+                                                                                            \
+        virtual foundation::IBenchmarkCase* create()                                        \
+        {                                                                                   \
+            return new BenchmarkCase##Name();                                               \
+        }                                                                                   \
+    };                                                                                      \
+                                                                                            \
+    struct RegisterBenchmarkCase##Name                                                      \
+    {                                                                                       \
+        RegisterBenchmarkCase##Name()                                                       \
+        {                                                                                   \
+            using namespace foundation;                                                     \
+            static BenchmarkCase##Name##Factory factory;                                    \
+            current_benchmark_suite__().register_case(&factory);                            \
+        }                                                                                   \
+    };                                                                                      \
+                                                                                            \
+    static RegisterBenchmarkCase##Name RegisterBenchmarkCase##Name##_instance__;            \
+                                                                                            \
+    void BenchmarkCase##Name::run()
+
+
 //
 // Forward-declare a benchmark case.
 //
@@ -36,6 +36,12 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class MetricResult; }
+
 namespace foundation
 {
 
@@ -55,6 +61,25 @@ class APPLESEED_DLLSYMBOL IBenchmarkCase
 
     // Run the benchmark case.
     virtual void run() = 0;
+
+    // Return the number of times the benchmark case must be run, or 0 to let
+    // the benchmark suite figure it out from a first estimate of the running time.
+    // Expensive benchmark cases (such as full renders) should return a small count.
+    virtual size_t get_measurement_count() const
+    {
+        return 0;
+    }
+
+    // Return the number of measurements other than running time made by the benchmark case.
+    virtual size_t get_metric_count() const
+    {
+        return 0;
+    }
+
+    // Retrieve a measurement other than running time. Called after the benchmark case has run.
+    virtual void get_metric(const size_t index, MetricResult& metric) const
+    {
+    }
 };
 
 }       // namespace foundation
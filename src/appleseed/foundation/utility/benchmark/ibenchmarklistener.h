@@ -42,6 +42,7 @@
 // Forward declarations.
 namespace foundation    { class BenchmarkSuite; }
 namespace foundation    { class IBenchmarkCase; }
+namespace foundation    { class MetricResult; }
 namespace foundation    { class TimingResult; }
 
 namespace foundation
@@ -88,6 +89,14 @@ class APPLESEED_DLLSYMBOL IBenchmarkListener
         const char*             file,
         const size_t            line,
         const TimingResult&     timing_result) = 0;
+
+    // Write a measurement other than running time.
+    virtual void write(
+        const BenchmarkSuite&   benchmark_suite,
+        const IBenchmarkCase&   benchmark_case,
+        const char*             file,
+        const size_t            line,
+        const MetricResult&     metric_result) = 0;
 };
 
 }       // namespace foundation
@@ -35,6 +35,7 @@
 #include "foundation/utility/benchmark/benchmarklistenerbase.h"
 #include "foundation/utility/benchmark/benchmarksuite.h"
 #include "foundation/utility/benchmark/ibenchmarkcase.h"
+#include "foundation/utility/benchmark/metricresult.h"
 #include "foundation/utility/benchmark/timingresult.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/log.h"
@@ -200,6 +201,24 @@ namespace
                 callrate_string.c_str());
         }
 
+        virtual void write(
+            const BenchmarkSuite&   benchmark_suite,
+            const IBenchmarkCase&   benchmark_case,
+            const char*             file,
+            const size_t            line,
+            const MetricResult&     metric_result)
+        {
+            print_suite_name(benchmark_suite);
+
+            LOG_INFO(
+                m_logger,
+                "  %s: %s: %s %s",
+                benchmark_case.get_name(),
+                metric_result.m_name,
+                pretty_scalar(metric_result.m_value, 3).c_str(),
+                metric_result.m_unit);
+        }
+
       private:
         Logger&     m_logger;
         bool        m_suite_name_printed;
@@ -35,6 +35,7 @@
 #include "foundation/platform/types.h"
 #include "foundation/utility/benchmark/benchmarksuite.h"
 #include "foundation/utility/benchmark/ibenchmarkcase.h"
+#include "foundation/utility/benchmark/metricresult.h"
 #include "foundation/utility/benchmark/timingresult.h"
 #include "foundation/utility/indenter.h"
 
@@ -187,6 +188,21 @@ void XMLFileBenchmarkListener::write(
     fprintf(impl->m_file, "%s</results>\n", impl->m_indenter.c_str());
 }
 
+void XMLFileBenchmarkListener::write(
+    const BenchmarkSuite&   benchmark_suite,
+    const IBenchmarkCase&   benchmark_case,
+    const char*             file,
+    const size_t            line,
+    const MetricResult&     metric_result)
+{
+    fprintf(impl->m_file,
+        "%s<metric name=\"%s\" unit=\"%s\">%f</metric>\n",
+        impl->m_indenter.c_str(),
+        metric_result.m_name,
+        metric_result.m_unit,
+        metric_result.m_value);
+}
+
 bool XMLFileBenchmarkListener::open(const char* filename)
 {
     assert(filename);
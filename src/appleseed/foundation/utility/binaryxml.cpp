@@ -0,0 +1,556 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Interface header.
+#include "binaryxml.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/bufferedfile.h"
+
+// Xerces-C++ headers.
+#include "xercesc/framework/MemBufInputSource.hpp"
+#include "xercesc/sax2/Attributes.hpp"
+#include "xercesc/sax2/DefaultHandler.hpp"
+#include "xercesc/sax2/SAX2XMLReader.hpp"
+#include "xercesc/sax2/XMLReaderFactory.hpp"
+#include "xercesc/util/XMLException.hpp"
+#include "xercesc/util/XMLString.hpp"
+#include "xercesc/util/XMLUni.hpp"
+
+// Standard headers.
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace xercesc;
+
+namespace foundation
+{
+
+namespace
+{
+    //
+    // File layout (version 1):
+    //
+    //   signature          9 bytes, "BINARYXML"
+    //   version            uint16
+    //
+    //   followed by an LZ4-compressed stream made of:
+    //
+    //   string count       uint32
+    //   strings            for each string: uint32 length, then length UTF-16 code units
+    //   event word count   uint32
+    //   events             uint32 words, see EventType below
+    //
+
+    const char Signature[9] = { 'B', 'I', 'N', 'A', 'R', 'Y', 'X', 'M', 'L' };
+    const uint16 Version = 1;
+    const size_t CompressionBufferSize = 256 * 1024;
+
+    enum EventType
+    {
+        StartElementEvent,      // followed by name, attribute count, and (name, value) pairs
+        EndElementEvent,        // not followed by anything
+        CharactersEvent         // followed by the character data
+    };
+
+    typedef basic_string<XMLCh> XMLChString;
+
+    const XMLCh EmptyString[] = { 0 };
+
+    template <typename File>
+    bool checked_read(File& file, void* outbuf, const size_t size)
+    {
+        return file.read(outbuf, size) == size;
+    }
+
+    template <typename File>
+    bool checked_write(File& file, const void* inbuf, const size_t size)
+    {
+        return file.write(inbuf, size) == size;
+    }
+
+
+    //
+    // Records the SAX events of an XML document.
+    //
+
+    class EventRecorder
+      : public DefaultHandler
+    {
+      public:
+        vector<XMLChString>     m_strings;
+        vector<uint32>          m_events;
+
+        virtual void startElement(
+            const XMLCh* const  uri,
+            const XMLCh* const  localname,
+            const XMLCh* const  qname,
+            const Attributes&   attrs) APPLESEED_OVERRIDE
+        {
+            flush_characters();
+
+            const XMLSize_t attr_count = attrs.getLength();
+
+            m_events.push_back(StartElementEvent);
+            m_events.push_back(intern(localname));
+            m_events.push_back(static_cast<uint32>(attr_count));
+
+            for (XMLSize_t i = 0; i < attr_count; ++i)
+            {
+                m_events.push_back(intern(attrs.getQName(i)));
+                m_events.push_back(intern(attrs.getValue(i)));
+            }
+        }
+
+        virtual void endElement(
+            const XMLCh* const  uri,
+            const XMLCh* const  localname,
+            const XMLCh* const  qname) APPLESEED_OVERRIDE
+        {
+            flush_characters();
+
+            m_events.push_back(EndElementEvent);
+        }
+
+        virtual void characters(
+            const XMLCh* const  chars,
+            const XMLSize_t     length) APPLESEED_OVERRIDE
+        {
+            // The parser may deliver the character data of an element in several chunks.
+            m_characters.append(chars, length);
+        }
+
+        virtual void endDocument() APPLESEED_OVERRIDE
+        {
+            flush_characters();
+        }
+
+      private:
+        typedef map<XMLChString, uint32> StringIndexMap;
+
+        StringIndexMap          m_string_indices;
+        XMLChString             m_characters;
+
+        uint32 intern(const XMLChString& s)
+        {
+            const pair<StringIndexMap::iterator, bool> result =
+                m_string_indices.insert(
+                    make_pair(s, static_cast<uint32>(m_strings.size())));
+
+            if (result.second)
+                m_strings.push_back(s);
+
+            return result.first->second;
+        }
+
+        uint32 intern(const XMLCh* s)
+        {
+            return intern(XMLChString(s));
+        }
+
+        void flush_characters()
+        {
+            if (!m_characters.empty())
+            {
+                m_events.push_back(CharactersEvent);
+                m_events.push_back(intern(m_characters));
+                m_characters.clear();
+            }
+        }
+    };
+
+
+    //
+    // Attributes of an element, as (name, value) pairs of indices into the string table.
+    //
+
+    class IndexedAttributes
+      : public Attributes
+    {
+      public:
+        explicit IndexedAttributes(const vector<XMLChString>& strings)
+          : m_strings(strings)
+          , m_pairs(0)
+          , m_count(0)
+        {
+        }
+
+        void set(const uint32* pairs, const size_t count)
+        {
+            m_pairs = pairs;
+            m_count = count;
+        }
+
+        virtual XMLSize_t getLength() const APPLESEED_OVERRIDE
+        {
+            return m_count;
+        }
+
+        virtual const XMLCh* getURI(const XMLSize_t index) const APPLESEED_OVERRIDE
+        {
+            return index < m_count ? EmptyString : 0;
+        }
+
+        virtual const XMLCh* getLocalName(const XMLSize_t index) const APPLESEED_OVERRIDE
+        {
+            return getQName(index);
+        }
+
+        virtual const XMLCh* getQName(const XMLSize_t index) const APPLESEED_OVERRIDE
+        {
+            return index < m_count ? m_strings[m_pairs[index * 2 + 0]].c_str() : 0;
+        }
+
+        virtual const XMLCh* getType(const XMLSize_t index) const APPLESEED_OVERRIDE
+        {
+            return index < m_count ? XMLUni::fgCDATAString : 0;
+        }
+
+        virtual const XMLCh* getValue(const XMLSize_t index) const APPLESEED_OVERRIDE
+        {
+            return index < m_count ? m_strings[m_pairs[index * 2 + 1]].c_str() : 0;
+        }
+
+        virtual bool getIndex(
+            const XMLCh* const  uri,
+            const XMLCh* const  localPart,
+            XMLSize_t&          index) const APPLESEED_OVERRIDE
+        {
+            return getIndex(localPart, index);
+        }
+
+        virtual int getIndex(
+            const XMLCh* const  uri,
+            const XMLCh* const  localPart) const APPLESEED_OVERRIDE
+        {
+            return getIndex(localPart);
+        }
+
+        virtual bool getIndex(
+            const XMLCh* const  qName,
+            XMLSize_t&          index) const APPLESEED_OVERRIDE
+        {
+            for (size_t i = 0; i < m_count; ++i)
+            {
+                if (XMLString::equals(m_strings[m_pairs[i * 2]].c_str(), qName))
+                {
+                    index = i;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        virtual int getIndex(const XMLCh* const qName) const APPLESEED_OVERRIDE
+        {
+            XMLSize_t index;
+            return getIndex(qName, index) ? static_cast<int>(index) : -1;
+        }
+
+        virtual const XMLCh* getType(
+            const XMLCh* const  uri,
+            const XMLCh* const  localPart) const APPLESEED_OVERRIDE
+        {
+            return getType(localPart);
+        }
+
+        virtual const XMLCh* getType(const XMLCh* const qName) const APPLESEED_OVERRIDE
+        {
+            XMLSize_t index;
+            return getIndex(qName, index) ? getType(index) : 0;
+        }
+
+        virtual const XMLCh* getValue(
+            const XMLCh* const  uri,
+            const XMLCh* const  localPart) const APPLESEED_OVERRIDE
+        {
+            return getValue(localPart);
+        }
+
+        virtual const XMLCh* getValue(const XMLCh* const qName) const APPLESEED_OVERRIDE
+        {
+            XMLSize_t index;
+            return getIndex(qName, index) ? getValue(index) : 0;
+        }
+
+      private:
+        const vector<XMLChString>&  m_strings;
+        const uint32*               m_pairs;
+        size_t                      m_count;
+    };
+
+    bool replay_events(
+        const vector<XMLChString>&  strings,
+        const vector<uint32>&       events,
+        ContentHandler&             handler)
+    {
+        IndexedAttributes attrs(strings);
+        vector<uint32> open_elements;
+
+        handler.startDocument();
+
+        size_t i = 0;
+        while (i < events.size())
+        {
+            switch (events[i++])
+            {
+              case StartElementEvent:
+                {
+                    if (events.size() - i < 2)
+                        return false;
+
+                    const uint32 name = events[i++];
+                    const uint32 attr_count = events[i++];
+
+                    if (name >= strings.size() || attr_count > (events.size() - i) / 2)
+                        return false;
+
+                    for (size_t j = 0; j < attr_count * 2; ++j)
+                    {
+                        if (events[i + j] >= strings.size())
+                            return false;
+                    }
+
+                    attrs.set(attr_count > 0 ? &events[i] : 0, attr_count);
+                    i += attr_count * 2;
+
+                    open_elements.push_back(name);
+
+                    const XMLCh* name_string = strings[name].c_str();
+                    handler.startElement(EmptyString, name_string, name_string, attrs);
+                }
+                break;
+
+              case EndElementEvent:
+                {
+                    if (open_elements.empty())
+                        return false;
+
+                    const XMLCh* name_string = strings[open_elements.back()].c_str();
+                    open_elements.pop_back();
+
+                    handler.endElement(EmptyString, name_string, name_string);
+                }
+                break;
+
+              case CharactersEvent:
+                {
+                    if (i == events.size() || events[i] >= strings.size())
+                        return false;
+
+                    const XMLChString& chars = strings[events[i++]];
+                    handler.characters(chars.c_str(), chars.size());
+                }
+                break;
+
+              default:
+                return false;
+            }
+        }
+
+        if (!open_elements.empty())
+            return false;
+
+        handler.endDocument();
+
+        return true;
+    }
+}
+
+bool is_binary_xml_file(const char* filepath)
+{
+    BufferedFile file(
+        filepath,
+        BufferedFile::BinaryType,
+        BufferedFile::ReadMode);
+
+    if (!file.is_open())
+        return false;
+
+    char signature[sizeof(Signature)];
+
+    return
+        checked_read(file, signature, sizeof(signature)) &&
+        memcmp(signature, Signature, sizeof(Signature)) == 0;
+}
+
+
+//
+// BinaryXMLFileWriter class implementation.
+//
+
+bool BinaryXMLFileWriter::write(
+    const char*                 filepath,
+    const char*                 xml,
+    const size_t                xml_size)
+{
+    // Record the events of the document.
+    EventRecorder recorder;
+    {
+        auto_ptr<SAX2XMLReader> parser(XMLReaderFactory::createXMLReader());
+        parser->setFeature(XMLUni::fgSAX2CoreNameSpaces, true);
+        parser->setFeature(XMLUni::fgSAX2CoreValidation, false);
+        parser->setFeature(XMLUni::fgXercesSchema, false);
+        parser->setContentHandler(&recorder);
+        parser->setErrorHandler(&recorder);
+
+        const MemBufInputSource input(
+            reinterpret_cast<const XMLByte*>(xml),
+            xml_size,
+            filepath);
+
+        try
+        {
+            parser->parse(input);
+        }
+        catch (const XMLException&)
+        {
+            return false;
+        }
+        catch (const SAXParseException&)
+        {
+            return false;
+        }
+    }
+
+    BufferedFile file(
+        filepath,
+        BufferedFile::BinaryType,
+        BufferedFile::WriteMode);
+
+    if (!file.is_open())
+        return false;
+
+    bool success =
+        checked_write(file, Signature, sizeof(Signature)) &&
+        checked_write(file, &Version, sizeof(Version));
+
+    if (success)
+    {
+        // The adapter flushes its last compressed block when it is destroyed.
+        LZ4CompressedWriterAdapter writer(file, CompressionBufferSize);
+
+        const uint32 string_count = static_cast<uint32>(recorder.m_strings.size());
+        success = checked_write(writer, &string_count, sizeof(string_count));
+
+        for (uint32 i = 0; success && i < string_count; ++i)
+        {
+            const XMLChString& s = recorder.m_strings[i];
+            const uint32 length = static_cast<uint32>(s.size());
+
+            success =
+                checked_write(writer, &length, sizeof(length)) &&
+                checked_write(writer, s.c_str(), length * sizeof(XMLCh));
+        }
+
+        const uint32 event_word_count = static_cast<uint32>(recorder.m_events.size());
+
+        success =
+            success &&
+            checked_write(writer, &event_word_count, sizeof(event_word_count)) &&
+            (event_word_count == 0 ||
+             checked_write(writer, &recorder.m_events[0], event_word_count * sizeof(uint32)));
+    }
+
+    return file.close() && success;
+}
+
+
+//
+// BinaryXMLFileReader class implementation.
+//
+
+bool BinaryXMLFileReader::read(
+    const char*                 filepath,
+    ContentHandler&             handler)
+{
+    // todo: fix for big endian CPUs.
+
+    BufferedFile file(
+        filepath,
+        BufferedFile::BinaryType,
+        BufferedFile::ReadMode);
+
+    if (!file.is_open())
+        return false;
+
+    char signature[sizeof(Signature)];
+    uint16 version;
+
+    if (!checked_read(file, signature, sizeof(signature)) ||
+        memcmp(signature, Signature, sizeof(Signature)) != 0 ||
+        !checked_read(file, &version, sizeof(version)) ||
+        version != Version)
+        return false;
+
+    LZ4CompressedReaderAdapter reader(file);
+
+    uint32 string_count;
+    if (!checked_read(reader, &string_count, sizeof(string_count)))
+        return false;
+
+    vector<XMLChString> strings(string_count);
+
+    for (uint32 i = 0; i < string_count; ++i)
+    {
+        uint32 length;
+        if (!checked_read(reader, &length, sizeof(length)))
+            return false;
+
+        if (length > 0)
+        {
+            strings[i].resize(length);
+            if (!checked_read(reader, &strings[i][0], length * sizeof(XMLCh)))
+                return false;
+        }
+    }
+
+    uint32 event_word_count;
+    if (!checked_read(reader, &event_word_count, sizeof(event_word_count)))
+        return false;
+
+    vector<uint32> events(event_word_count);
+
+    if (event_word_count > 0 &&
+        !checked_read(reader, &events[0], event_word_count * sizeof(uint32)))
+        return false;
+
+    return replay_events(strings, events, handler);
+}
+
+}   // namespace foundation
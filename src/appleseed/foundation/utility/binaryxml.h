@@ -0,0 +1,81 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef APPLESEED_FOUNDATION_UTILITY_BINARYXML_H
+#define APPLESEED_FOUNDATION_UTILITY_BINARYXML_H
+
+// Xerces-C++ headers.
+#include "xercesc/sax2/ContentHandler.hpp"
+
+// Standard headers.
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// Binary XML files hold the SAX events of an XML document: element starts with their
+// attributes, element ends and character data. Element names, attribute names, attribute
+// values and character data are interned in a string table and the events are stored as
+// a single packed block of string indices. The whole file is LZ4-compressed.
+//
+// Reading a binary XML file replays its events into a SAX2 content handler, bypassing
+// XML tokenization and validation altogether.
+//
+// Xerces-C++ must be initialized before any of the functions below are called.
+//
+
+// Return true if a given file starts with the signature of binary XML files.
+bool is_binary_xml_file(const char* filepath);
+
+class BinaryXMLFileWriter
+{
+  public:
+    // Convert an XML document held in memory to a binary XML file.
+    // Return true on success, false otherwise.
+    static bool write(
+        const char*                 filepath,
+        const char*                 xml,
+        const size_t                xml_size);
+};
+
+class BinaryXMLFileReader
+{
+  public:
+    // Replay the events of a binary XML file into a SAX2 content handler.
+    // Return true on success, false if the file could not be read or is corrupted.
+    static bool read(
+        const char*                 filepath,
+        xercesc::ContentHandler&    handler);
+};
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_UTILITY_BINARYXML_H
@@ -31,6 +31,7 @@
 #include "bufferedfile.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/thread.h"
 #include "foundation/utility/memory.h"
 #include "foundation/utility/otherwise.h"
 
@@ -40,6 +41,7 @@
 // Standard headers.
 #include <algorithm>
 #include <cstring>
+#include <memory>
 
 using namespace std;
 
@@ -520,7 +522,7 @@ size_t CompressedReaderAdapter::read(
                 break;
         }
 
-        const size_t copy = min(size, m_buffer_end - m_buffer_index);
+        const size_t copy = min(remaining, m_buffer_end - m_buffer_index);
         memcpy(outbuf, &m_buffer[m_buffer_index], copy);
 
         outbuf = reinterpret_cast<uint8*>(outbuf) + copy;
@@ -549,19 +551,127 @@ namespace
 }
 
 
+//
+// Blocks of data compressed or decompressed on worker threads by the LZ4 adapters.
+//
+
+namespace
+{
+    // Number of blocks given to each worker thread per batch.
+    const size_t BlocksPerThread = 2;
+
+    struct LZ4Block
+    {
+        std::vector<uint8>  m_data;
+        size_t              m_size;
+        std::vector<uint8>  m_compressed_data;
+        size_t              m_compressed_size;
+    };
+
+    void compress_block(LZ4Block& block)
+    {
+        const size_t max_compressed_size =
+            static_cast<size_t>(LZ4_compressBound(static_cast<int>(block.m_size)));
+        ensure_minimum_size(block.m_compressed_data, max_compressed_size);
+
+        block.m_compressed_size =
+            static_cast<size_t>(
+                LZ4_compress(
+                    reinterpret_cast<const char*>(&block.m_data[0]),
+                    reinterpret_cast<char*>(&block.m_compressed_data[0]),
+                    static_cast<int>(block.m_size)));
+    }
+
+    void decompress_block(LZ4Block& block)
+    {
+        ensure_minimum_size(block.m_data, block.m_size);
+
+        LZ4_decompress_fast(
+            reinterpret_cast<const char*>(&block.m_compressed_data[0]),
+            reinterpret_cast<char*>(&block.m_data[0]),
+            static_cast<int>(block.m_size));
+    }
+
+    // Process every thread_count-th block of a batch, starting with a given block.
+    template <void (*Process)(LZ4Block&)>
+    struct BlockWorker
+    {
+        LZ4Block*           m_blocks;
+        size_t              m_begin;
+        size_t              m_end;
+        size_t              m_step;
+
+        void operator()() const
+        {
+            for (size_t i = m_begin; i < m_end; i += m_step)
+                Process(m_blocks[i]);
+        }
+    };
+
+    // Start processing a batch of blocks on up to thread_count threads. Returns immediately.
+    template <void (*Process)(LZ4Block&)>
+    void launch_batch(
+        boost::thread_group&    threads,
+        std::vector<LZ4Block>&  blocks,
+        const size_t            block_count,
+        const size_t            thread_count)
+    {
+        const size_t worker_count = min(block_count, thread_count);
+
+        for (size_t i = 0; i < worker_count; ++i)
+        {
+            BlockWorker<Process> worker;
+            worker.m_blocks = &blocks[0];
+            worker.m_begin = i;
+            worker.m_end = block_count;
+            worker.m_step = worker_count;
+            threads.create_thread(worker);
+        }
+    }
+}
+
+
 //
 // LZ4CompressedWriterAdapter class implementation.
 //
 
+struct LZ4CompressedWriterAdapter::ParallelCompression
+{
+    const size_t                        m_thread_count;
+    std::vector<LZ4Block>               m_filling_blocks;   // blocks waiting for the batch to be full
+    size_t                              m_filling_count;
+    std::vector<LZ4Block>               m_pending_blocks;   // blocks being compressed
+    size_t                              m_pending_count;
+    auto_ptr<boost::thread_group>       m_threads;
+
+    explicit ParallelCompression(const size_t thread_count)
+      : m_thread_count(thread_count)
+      , m_filling_blocks(thread_count * BlocksPerThread)
+      , m_filling_count(0)
+      , m_pending_blocks(thread_count * BlocksPerThread)
+      , m_pending_count(0)
+    {
+    }
+
+    ~ParallelCompression()
+    {
+        if (m_threads.get())
+            m_threads->join_all();
+    }
+};
+
 LZ4CompressedWriterAdapter::LZ4CompressedWriterAdapter(BufferedFile& file)
   : CompressedWriterAdapter(file)
+  , m_parallel(0)
 {
 }
 
 LZ4CompressedWriterAdapter::LZ4CompressedWriterAdapter(
     BufferedFile&       file,
-    const size_t        buffer_size)
+    const size_t        buffer_size,
+    const size_t        thread_count)
   : CompressedWriterAdapter(file, buffer_size)
+  , m_parallel(thread_count > 1 ? new ParallelCompression(thread_count) : 0)
 {
 }
 
@@ -569,10 +679,34 @@ LZ4CompressedWriterAdapter::~LZ4CompressedWriterAdapter()
 {
     if (m_buffer_index > 0)
         flush_buffer();
+
+    if (m_parallel)
+    {
+        // Compress the last, partial batch and write all remaining blocks.
+        flush_batch();
+        m_parallel->m_threads->join_all();
+        write_pending_blocks();
+
+        delete m_parallel;
+    }
 }
 
 void LZ4CompressedWriterAdapter::flush_buffer()
 {
+    if (m_parallel)
+    {
+        // Hand the buffer over to the batch being filled.
+        LZ4Block& block = m_parallel->m_filling_blocks[m_parallel->m_filling_count++];
+        block.m_data.swap(m_buffer);
+        block.m_size = m_buffer_index;
+        m_buffer_index = 0;
+
+        if (m_parallel->m_filling_count == m_parallel->m_filling_blocks.size())
+            flush_batch();
+
+        return;
+    }
+
     const size_t max_compressed_buffer_size =
         static_cast<size_t>(LZ4_compressBound(static_cast<int>(m_buffer_index)));
     ensure_minimum_size(m_compressed_buffer, max_compressed_buffer_size);
@@ -590,18 +724,118 @@ void LZ4CompressedWriterAdapter::flush_buffer()
     m_buffer_index = 0;
 }
 
+void LZ4CompressedWriterAdapter::flush_batch()
+{
+    assert(m_parallel);
+
+    // Wait for the previous batch and write it.
+    if (m_parallel->m_threads.get())
+        m_parallel->m_threads->join_all();
+    write_pending_blocks();
+
+    // Start compressing the batch that was being filled.
+    m_parallel->m_filling_blocks.swap(m_parallel->m_pending_blocks);
+    m_parallel->m_pending_count = m_parallel->m_filling_count;
+    m_parallel->m_filling_count = 0;
+    m_parallel->m_threads.reset(new boost::thread_group());
+    launch_batch<compress_block>(
+        *m_parallel->m_threads,
+        m_parallel->m_pending_blocks,
+        m_parallel->m_pending_count,
+        m_parallel->m_thread_count);
+}
+
+void LZ4CompressedWriterAdapter::write_pending_blocks()
+{
+    assert(m_parallel);
+
+    for (size_t i = 0; i < m_parallel->m_pending_count; ++i)
+    {
+        const LZ4Block& block = m_parallel->m_pending_blocks[i];
+        m_file.write(static_cast<uint64>(block.m_size));
+        m_file.write(static_cast<uint64>(block.m_compressed_size));
+        m_file.write(&block.m_compressed_data[0], block.m_compressed_size);
+    }
+
+    m_parallel->m_pending_count = 0;
+}
+
 
 //
 // LZ4CompressedReaderAdapter class implementation.
 //
 
-LZ4CompressedReaderAdapter::LZ4CompressedReaderAdapter(BufferedFile& file)
+struct LZ4CompressedReaderAdapter::ReadAhead
+{
+    const size_t                        m_thread_count;
+    std::vector<LZ4Block>               m_ready_blocks;     // decompressed blocks
+    size_t                              m_ready_index;
+    size_t                              m_ready_count;
+    std::vector<LZ4Block>               m_pending_blocks;   // blocks being decompressed
+    size_t                              m_pending_count;
+    auto_ptr<boost::thread_group>       m_threads;
+
+    explicit ReadAhead(const size_t thread_count)
+      : m_thread_count(thread_count)
+      , m_ready_blocks(thread_count * BlocksPerThread)
+      , m_ready_index(0)
+      , m_ready_count(0)
+      , m_pending_blocks(thread_count * BlocksPerThread)
+      , m_pending_count(0)
+    {
+    }
+
+    ~ReadAhead()
+    {
+        if (m_threads.get())
+            m_threads->join_all();
+    }
+};
+
+LZ4CompressedReaderAdapter::LZ4CompressedReaderAdapter(
+    BufferedFile&       file,
+    const size_t        thread_count)
   : CompressedReaderAdapter(file)
+  , m_read_ahead(thread_count > 1 ? new ReadAhead(thread_count) : 0)
 {
 }
 
+LZ4CompressedReaderAdapter::~LZ4CompressedReaderAdapter()
+{
+    delete m_read_ahead;
+}
+
 bool LZ4CompressedReaderAdapter::fill_buffer()
 {
+    if (m_read_ahead)
+    {
+        if (m_read_ahead->m_ready_index == m_read_ahead->m_ready_count)
+        {
+            // Start reading ahead on the first call.
+            if (m_read_ahead->m_threads.get() == 0)
+                read_ahead();
+
+            // Wait for the batch being decompressed, and start decompressing the next one.
+            m_read_ahead->m_threads->join_all();
+            m_read_ahead->m_ready_blocks.swap(m_read_ahead->m_pending_blocks);
+            m_read_ahead->m_ready_index = 0;
+            m_read_ahead->m_ready_count = m_read_ahead->m_pending_count;
+            read_ahead();
+
+            if (m_read_ahead->m_ready_count == 0)
+                return false;
+        }
+
+        // Hand the next decompressed block over to the reader.
+        LZ4Block& block = m_read_ahead->m_ready_blocks[m_read_ahead->m_ready_index++];
+        block.m_data.swap(m_buffer);
+
+        m_buffer_index = 0;
+        m_buffer_end = block.m_size;
+
+        return true;
+    }
+
     size_t buffer_size;
     if (read_uint64(m_file, buffer_size) == 0)
         return false;
@@ -625,4 +859,36 @@ bool LZ4CompressedReaderAdapter::fill_buffer()
     return true;
 }
 
+void LZ4CompressedReaderAdapter::read_ahead()
+{
+    assert(m_read_ahead);
+
+    // Read the next batch of compressed blocks.
+    std::vector<LZ4Block>& blocks = m_read_ahead->m_pending_blocks;
+    size_t block_count = 0;
+
+    while (block_count < blocks.size())
+    {
+        LZ4Block& block = blocks[block_count];
+
+        if (read_uint64(m_file, block.m_size) == 0)
+            break;
+
+        read_uint64(m_file, block.m_compressed_size);
+        ensure_minimum_size(block.m_compressed_data, block.m_compressed_size);
+        m_file.read(&block.m_compressed_data[0], block.m_compressed_size);
+
+        ++block_count;
+    }
+
+    // Decompress them on worker threads.
+    m_read_ahead->m_pending_count = block_count;
+    m_read_ahead->m_threads.reset(new boost::thread_group());
+    launch_batch<decompress_block>(
+        *m_read_ahead->m_threads,
+        blocks,
+        block_count,
+        m_read_ahead->m_thread_count);
+}
+
 }   // namespace foundation
@@ -31,6 +31,7 @@
 #define APPLESEED_FOUNDATION_UTILITY_BUFFEREDFILE_H
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/types.h"
 
@@ -317,35 +318,59 @@ class CompressedReaderAdapter
 //
 // LZ4 compression adapters.
 //
+// With more than one thread, the writer compresses full buffers in batches on worker
+// threads while the next batch is being filled, and the reader decompresses batches
+// of upcoming blocks on worker threads while the current batch is being consumed.
+// Files are written to and read from on the calling thread only, and the file
+// format does not depend on the number of threads.
+//
 
 class LZ4CompressedWriterAdapter
   : public CompressedWriterAdapter
+  , public NonCopyable
 {
   public:
     explicit LZ4CompressedWriterAdapter(BufferedFile& file);
 
     LZ4CompressedWriterAdapter(
         BufferedFile&       file,
-        const size_t        buffer_size);               // compression buffer size, in bytes
+        const size_t        buffer_size,                // compression buffer size, in bytes
+        const size_t        thread_count = 1);          // number of compression threads
 
     virtual ~LZ4CompressedWriterAdapter();
 
   private:
+    struct ParallelCompression;
+
     std::vector<uint8>      m_compressed_buffer;
+    ParallelCompression*    m_parallel;
 
     virtual void flush_buffer() APPLESEED_OVERRIDE;
+
+    void flush_batch();
+    void write_pending_blocks();
 };
 
 class LZ4CompressedReaderAdapter
   : public CompressedReaderAdapter
+  , public NonCopyable
 {
   public:
-    explicit LZ4CompressedReaderAdapter(BufferedFile& file);
+    explicit LZ4CompressedReaderAdapter(
+        BufferedFile&       file,
+        const size_t        thread_count = 1);          // number of decompression threads
+
+    virtual ~LZ4CompressedReaderAdapter();
 
   private:
+    struct ReadAhead;
+
     std::vector<uint8>      m_compressed_buffer;
+    ReadAhead*              m_read_ahead;
 
     virtual bool fill_buffer() APPLESEED_OVERRIDE;
+
+    void read_ahead();
 };
 
 
@@ -31,33 +31,182 @@
 #include "dictionary.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/atomic.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/foreach.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <map>
+#include <memory>
+#include <string>
+#include <vector>
 
 using namespace std;
 
 namespace foundation
 {
 
-typedef map<string, string> StringMap;
 typedef map<string, Dictionary> DictionaryMap;
 
 
+//
+// StringDictionary items are individually allocated and referenced by a vector of pointers
+// sorted by key: lookups are binary searches that compare the key in place, without
+// allocating any string. Since items never move, the strings returned by get() and
+// the iterators remain valid when other items are inserted or removed, as with a map.
+//
+// Each item also caches the typed value last returned by get<T>() for arithmetic types,
+// so that repeated lookups of a parameter don't parse its string value again. The cache
+// is filled at most once per item, atomically, so concurrent readers remain safe.
+//
+
+namespace
+{
+    const size_t CacheStorageSize = 16;     // bytes, large enough for any arithmetic type
+
+    enum CacheState
+    {
+        CacheEmpty,
+        CacheFilling,
+        CacheFilled
+    };
+
+    struct StringItem
+    {
+        string                          m_key;
+        string                          m_value;
+        mutable volatile uint32         m_cache_state;
+        mutable StringDictionary::ParseFunction m_cache_type;
+        mutable double                  m_cache_storage[CacheStorageSize / sizeof(double)];
+
+        StringItem(const char* key, const char* value)
+          : m_key(key)
+          , m_value(value)
+          , m_cache_state(CacheEmpty)
+          , m_cache_type(0)
+        {
+        }
+
+        StringItem(const StringItem& rhs)
+          : m_key(rhs.m_key)
+          , m_value(rhs.m_value)
+          , m_cache_state(CacheEmpty)
+          , m_cache_type(0)
+        {
+        }
+
+        StringItem& operator=(const StringItem& rhs)
+        {
+            m_key = rhs.m_key;
+            m_value = rhs.m_value;
+            reset_cache();
+            return *this;
+        }
+
+        void reset_cache()
+        {
+            m_cache_state = CacheEmpty;
+            m_cache_type = 0;
+        }
+    };
+
+    typedef vector<StringItem*> StringVector;
+
+    struct StringItemKeyLess
+    {
+        bool operator()(const StringItem* lhs, const char* rhs) const
+        {
+            return strcmp(lhs->m_key.c_str(), rhs) < 0;
+        }
+
+        bool operator()(const char* lhs, const StringItem* rhs) const
+        {
+            return strcmp(lhs, rhs->m_key.c_str()) < 0;
+        }
+    };
+
+    StringVector::const_iterator find_item(const StringVector& items, const char* key)
+    {
+        const StringVector::const_iterator i =
+            lower_bound(items.begin(), items.end(), key, StringItemKeyLess());
+
+        return i != items.end() && strcmp((*i)->m_key.c_str(), key) == 0 ? i : items.end();
+    }
+
+    StringItem* find_item_ptr(const StringVector& items, const char* key)
+    {
+        const StringVector::const_iterator i = find_item(items, key);
+        return i != items.end() ? *i : 0;
+    }
+
+    void clear_items(StringVector& items)
+    {
+        for (const_each<StringVector> i = items; i; ++i)
+            delete *i;
+
+        items.clear();
+    }
+
+    void copy_items(const StringVector& source, StringVector& dest)
+    {
+        assert(dest.empty());
+
+        dest.reserve(source.size());
+
+        try
+        {
+            for (const_each<StringVector> i = source; i; ++i)
+                dest.push_back(new StringItem(**i));
+        }
+        catch (...)
+        {
+            clear_items(dest);
+            throw;
+        }
+    }
+}
+
+
 //
 // StringDictionary::const_iterator class implementation.
 //
 
+// An iterator points to an item rather than to a slot of the vector, so that it remains
+// valid when other items are inserted or removed. The index of the item in the vector is
+// only a hint: if the item has moved, it is searched for again.
 struct StringDictionary::const_iterator::Impl
 {
-    StringMap::const_iterator m_it;
+    const StringVector*     m_items;
+    const StringItem*       m_item;     // 0 for the end iterator
+    size_t                  m_index;
+
+    size_t index() const
+    {
+        if (m_item == 0)
+            return m_items->size();
+
+        if (m_index < m_items->size() && (*m_items)[m_index] == m_item)
+            return m_index;
+
+        return find_item(*m_items, m_item->m_key.c_str()) - m_items->begin();
+    }
+
+    void set_index(const size_t index)
+    {
+        m_index = index;
+        m_item = index < m_items->size() ? (*m_items)[index] : 0;
+    }
 };
 
 StringDictionary::const_iterator::const_iterator()
   : impl(new Impl())
 {
+    impl->m_items = 0;
+    impl->m_item = 0;
+    impl->m_index = 0;
 }
 
 StringDictionary::const_iterator::const_iterator(const const_iterator& rhs)
@@ -78,23 +227,23 @@ StringDictionary::const_iterator& StringDictionary::const_iterator::operator=(co
 
 bool StringDictionary::const_iterator::operator==(const const_iterator& rhs) const
 {
-    return impl->m_it == rhs.impl->m_it;
+    return impl->m_item == rhs.impl->m_item;
 }
 
 bool StringDictionary::const_iterator::operator!=(const const_iterator& rhs) const
 {
-    return impl->m_it != rhs.impl->m_it;
+    return impl->m_item != rhs.impl->m_item;
 }
 
 StringDictionary::const_iterator& StringDictionary::const_iterator::operator++()
 {
-    ++impl->m_it;
+    impl->set_index(impl->index() + 1);
     return *this;
 }
 
 StringDictionary::const_iterator& StringDictionary::const_iterator::operator--()
 {
-    --impl->m_it;
+    impl->set_index(impl->index() - 1);
     return *this;
 }
 
@@ -105,12 +254,12 @@ const StringDictionary::const_iterator::value_type& StringDictionary::const_iter
 
 const char* StringDictionary::const_iterator::key() const
 {
-    return impl->m_it->first.c_str();
+    return impl->m_item->m_key.c_str();
 }
 
 const char* StringDictionary::const_iterator::value() const
 {
-    return impl->m_it->second.c_str();
+    return impl->m_item->m_value.c_str();
 }
 
 
@@ -120,7 +269,34 @@ const char* StringDictionary::const_iterator::value() const
 
 struct StringDictionary::Impl
 {
-    StringMap m_strings;
+    StringVector m_strings;
+
+    Impl()
+    {
+    }
+
+    Impl(const Impl& rhs)
+    {
+        copy_items(rhs.m_strings, m_strings);
+    }
+
+    ~Impl()
+    {
+        clear_items(m_strings);
+    }
+
+    Impl& operator=(const Impl& rhs)
+    {
+        if (this != &rhs)
+        {
+            StringVector strings;
+            copy_items(rhs.m_strings, strings);
+            clear_items(m_strings);
+            m_strings.swap(strings);
+        }
+
+        return *this;
+    }
 };
 
 StringDictionary::StringDictionary()
@@ -150,11 +326,11 @@ bool StringDictionary::operator==(const StringDictionary& rhs) const
         return false;
 
     for (
-        StringMap::const_iterator it = impl->m_strings.begin(), rhs_it = rhs.impl->m_strings.begin();
+        StringVector::const_iterator it = impl->m_strings.begin(), rhs_it = rhs.impl->m_strings.begin();
         it != impl->m_strings.end();
         ++it, ++rhs_it)
     {
-        if (it->first != rhs_it->first || it->second != rhs_it->second)
+        if ((*it)->m_key != (*rhs_it)->m_key || (*it)->m_value != (*rhs_it)->m_value)
             return false;
     }
 
@@ -178,7 +354,7 @@ bool StringDictionary::empty() const
 
 void StringDictionary::clear()
 {
-    impl->m_strings.clear();
+    clear_items(impl->m_strings);
 }
 
 StringDictionary& StringDictionary::insert(const char* key, const char* value)
@@ -186,7 +362,20 @@ StringDictionary& StringDictionary::insert(const char* key, const char* value)
     assert(key);
     assert(value);
 
-    impl->m_strings[key] = value;
+    const StringVector::iterator i =
+        lower_bound(impl->m_strings.begin(), impl->m_strings.end(), key, StringItemKeyLess());
+
+    if (i != impl->m_strings.end() && strcmp((*i)->m_key.c_str(), key) == 0)
+    {
+        (*i)->m_value = value;
+        (*i)->reset_cache();
+    }
+    else
+    {
+        auto_ptr<StringItem> item(new StringItem(key, value));
+        impl->m_strings.insert(i, item.get());
+        item.release();
+    }
 
     return *this;
 }
@@ -196,12 +385,13 @@ StringDictionary& StringDictionary::set(const char* key, const char* value)
     assert(key);
     assert(value);
 
-    const StringMap::iterator i = impl->m_strings.find(key);
+    StringItem* item = find_item_ptr(impl->m_strings, key);
 
-    if (i == impl->m_strings.end())
+    if (item == 0)
         throw ExceptionDictionaryKeyNotFound(key);
 
-    i->second = value;
+    item->m_value = value;
+    item->reset_cache();
 
     return *this;
 }
@@ -210,29 +400,32 @@ const char* StringDictionary::get(const char* key) const
 {
     assert(key);
 
-    const StringMap::const_iterator i = impl->m_strings.find(key);
+    const StringItem* item = find_item_ptr(impl->m_strings, key);
 
-    if (i == impl->m_strings.end())
+    if (item == 0)
         throw ExceptionDictionaryKeyNotFound(key);
 
-    return i->second.c_str();
+    return item->m_value.c_str();
 }
 
 bool StringDictionary::exist(const char* key) const
 {
     assert(key);
 
-    return impl->m_strings.find(key) != impl->m_strings.end();
+    return find_item(impl->m_strings, key) != impl->m_strings.end();
 }
 
 StringDictionary& StringDictionary::remove(const char* key)
 {
     assert(key);
 
-    const StringMap::iterator i = impl->m_strings.find(key);
+    const StringVector::const_iterator i = find_item(impl->m_strings, key);
 
     if (i != impl->m_strings.end())
-        impl->m_strings.erase(i);
+    {
+        delete *i;
+        impl->m_strings.erase(impl->m_strings.begin() + (i - impl->m_strings.begin()));
+    }
 
     return *this;
 }
@@ -240,17 +433,51 @@ StringDictionary& StringDictionary::remove(const char* key)
 StringDictionary::const_iterator StringDictionary::begin() const
 {
     const_iterator it;
-    it.impl->m_it = impl->m_strings.begin();
+    it.impl->m_items = &impl->m_strings;
+    it.impl->set_index(0);
     return it;
 }
 
 StringDictionary::const_iterator StringDictionary::end() const
 {
     const_iterator it;
-    it.impl->m_it = impl->m_strings.end();
+    it.impl->m_items = &impl->m_strings;
+    it.impl->set_index(impl->m_strings.size());
     return it;
 }
 
+void StringDictionary::get_typed(
+    const char*         key,
+    ParseFunction       parse,
+    void*               value,
+    const size_t        size) const
+{
+    assert(key);
+    assert(size <= CacheStorageSize);
+
+    const StringItem* i = find_item_ptr(impl->m_strings, key);
+
+    if (i == 0)
+        throw ExceptionDictionaryKeyNotFound(key);
+
+    if (atomic_read(&i->m_cache_state) == CacheFilled && i->m_cache_type == parse)
+    {
+        memcpy(value, i->m_cache_storage, size);
+        return;
+    }
+
+    // Parse the value; this throws if the string cannot be converted.
+    parse(i->m_value.c_str(), value);
+
+    // Cache the value unless another thread is doing it or has done it already.
+    if (atomic_cas(&i->m_cache_state, CacheEmpty, CacheFilling) == CacheEmpty)
+    {
+        memcpy(i->m_cache_storage, value, size);
+        i->m_cache_type = parse;
+        atomic_cas(&i->m_cache_state, CacheFilling, CacheFilled);
+    }
+}
+
 
 //
 // DictionaryDictionary::iterator class implementation.
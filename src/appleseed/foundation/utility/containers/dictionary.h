@@ -37,6 +37,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Boost headers.
+#include "boost/type_traits/is_arithmetic.hpp"
+
 // Standard headers.
 #include <cstddef>
 #include <string>
@@ -146,6 +149,7 @@ class APPLESEED_DLLSYMBOL StringDictionary
     template <typename T> StringDictionary& set(const std::string& key, const T& value);
 
     // Retrieve an item from the dictionary.
+    // The returned string remains valid until this item is modified or removed.
     // Throws a ExceptionDictionaryKeyNotFound exception if the item could not be found.
     const char* get(const char* key) const;
     template <typename T> T get(const char* key) const;
@@ -161,9 +165,24 @@ class APPLESEED_DLLSYMBOL StringDictionary
     template <typename T> StringDictionary& remove(const std::basic_string<T>& key);
 
     // Return constant begin and end input iterators.
+    // An iterator remains valid until the item it points to is removed.
     const_iterator begin() const;
     const_iterator end() const;
 
+    // Function converting a string value to a value of a given type.
+    typedef void (*ParseFunction)(const char* s, void* value);
+
+    // Retrieve an item converted by 'parse' into 'value' ('size' bytes, at most 16).
+    // The first converted value of an item is cached and returned by subsequent calls
+    // made with the same conversion function, until the item is modified. get<T>()
+    // relies on this method for arithmetic types.
+    // Throws a ExceptionDictionaryKeyNotFound exception if the item could not be found.
+    void get_typed(
+        const char*         key,
+        ParseFunction       parse,
+        void*               value,
+        const size_t        size) const;
+
   private:
     struct Impl;
     Impl* impl;
@@ -433,10 +452,39 @@ inline StringDictionary& StringDictionary::set(const std::string& key, const T&
     return set(key.c_str(), value);
 }
 
+namespace dictionary_impl
+{
+    template <typename T>
+    void parse_value(const char* s, void* value)
+    {
+        *static_cast<T*>(value) = from_string<T>(s);
+    }
+
+    template <typename T, bool IsArithmetic = boost::is_arithmetic<T>::value>
+    struct StringDictionaryGetter
+    {
+        static T get(const StringDictionary& dictionary, const char* key)
+        {
+            return from_string<T>(dictionary.get(key));
+        }
+    };
+
+    template <typename T>
+    struct StringDictionaryGetter<T, true>
+    {
+        static T get(const StringDictionary& dictionary, const char* key)
+        {
+            T value;
+            dictionary.get_typed(key, &parse_value<T>, &value, sizeof(T));
+            return value;
+        }
+    };
+}
+
 template <typename T>
 inline T StringDictionary::get(const char* key) const
 {
-    return from_string<T>(get(key));
+    return dictionary_impl::StringDictionaryGetter<T>::get(*this, key);
 }
 
 template <typename T>
@@ -0,0 +1,208 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_FOUNDATION_UTILITY_CONTAINERS_OPENHASHTABLE_H
+#define APPLESEED_FOUNDATION_UTILITY_CONTAINERS_OPENHASHTABLE_H
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace foundation
+{
+
+//
+// A hash table using open addressing with linear probing.
+//
+// Slots are stored as three parallel arrays: a compact array of 32-bit tags
+// (derived from the hash of the keys), an array of keys and an array of values.
+// Probing only walks the tag array, which packs 16 slots per cache line; keys
+// are compared only when tags match, and values are touched only on a hit.
+// The table is kept at most half full so that probe sequences remain short.
+//
+// The table is meant to be built once and then queried: elements cannot be
+// removed and the table is cleared on resize. Once built, any number of threads
+// may query the table concurrently since find() and get() never write to it.
+//
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+class OpenHashTable
+{
+  public:
+    // Constructor, creates an empty hash table with a given key hasher.
+    explicit OpenHashTable(const KeyHasherType& key_hasher);
+
+    // Make room for a given number of elements.
+    // All previously inserted elements are lost.
+    void resize(const size_t element_count);
+
+    // Insert an element into the hash table. The key must be unique, and
+    // no more elements than specified in the last call to resize() can be inserted.
+    void insert(const KeyType& key, const ValueType& value);
+
+    // Return the number of elements in the hash table.
+    size_t size() const;
+
+    // Return the number of slots in the hash table.
+    size_t capacity() const;
+
+    // Find an element in the hash table. Return 0 if the element cannot be found.
+    const ValueType* find(const KeyType& key) const;
+
+    // Retrieve an existing element from the hash table.
+    const ValueType& get(const KeyType& key) const;
+
+  private:
+    const KeyHasherType&    m_key_hasher;
+    size_t                  m_mask;
+    size_t                  m_size;
+    size_t                  m_max_size;
+    std::vector<uint32>     m_tags;     // 0 for empty slots
+    std::vector<KeyType>    m_keys;
+    std::vector<ValueType>  m_values;
+
+    // Compute the tag of a key from its hash; tags of occupied slots are never 0.
+    static uint32 make_tag(const size_t hash);
+};
+
+
+//
+// OpenHashTable class implementation.
+//
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+OpenHashTable<KeyType, KeyHasherType, ValueType>::OpenHashTable(const KeyHasherType& key_hasher)
+  : m_key_hasher(key_hasher)
+  , m_mask(0)
+  , m_size(0)
+  , m_max_size(0)
+{
+}
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+void OpenHashTable<KeyType, KeyHasherType, ValueType>::resize(const size_t element_count)
+{
+    const size_t slot_count = element_count > 0 ? next_pow2(2 * element_count) : 0;
+
+    m_mask = slot_count > 0 ? slot_count - 1 : 0;
+    m_size = 0;
+    m_max_size = element_count;
+
+    m_tags.assign(slot_count, 0);
+    m_keys.assign(slot_count, KeyType());
+    m_values.assign(slot_count, ValueType());
+}
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+inline uint32 OpenHashTable<KeyType, KeyHasherType, ValueType>::make_tag(const size_t hash)
+{
+    return static_cast<uint32>(hash) | 0x80000000UL;
+}
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+void OpenHashTable<KeyType, KeyHasherType, ValueType>::insert(const KeyType& key, const ValueType& value)
+{
+    assert(m_size < m_max_size);
+    assert(find(key) == 0);
+
+    const size_t hash = m_key_hasher(key);
+    size_t index = hash & m_mask;
+
+    while (m_tags[index] != 0)
+        index = (index + 1) & m_mask;
+
+    m_tags[index] = make_tag(hash);
+    m_keys[index] = key;
+    m_values[index] = value;
+
+    ++m_size;
+}
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+inline size_t OpenHashTable<KeyType, KeyHasherType, ValueType>::size() const
+{
+    return m_size;
+}
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+inline size_t OpenHashTable<KeyType, KeyHasherType, ValueType>::capacity() const
+{
+    return m_tags.size();
+}
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+inline const ValueType* OpenHashTable<KeyType, KeyHasherType, ValueType>::find(const KeyType& key) const
+{
+    if (m_size == 0)
+        return 0;
+
+    const size_t hash = m_key_hasher(key);
+    const uint32 tag = make_tag(hash);
+    size_t index = hash & m_mask;
+
+    while (true)
+    {
+        const uint32 slot_tag = m_tags[index];
+
+        if (slot_tag == tag && m_keys[index] == key)
+            return &m_values[index];
+
+        if (slot_tag == 0)
+            return 0;
+
+        index = (index + 1) & m_mask;
+    }
+}
+
+template <typename KeyType, typename KeyHasherType, typename ValueType>
+inline const ValueType& OpenHashTable<KeyType, KeyHasherType, ValueType>::get(const KeyType& key) const
+{
+    assert(m_size > 0);
+
+    const size_t hash = m_key_hasher(key);
+    const uint32 tag = make_tag(hash);
+    size_t index = hash & m_mask;
+
+    while (!(m_tags[index] == tag && m_keys[index] == key))
+    {
+        assert(m_tags[index] != 0);
+        index = (index + 1) & m_mask;
+    }
+
+    return m_values[index];
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_UTILITY_CONTAINERS_OPENHASHTABLE_H
@@ -0,0 +1,98 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "counterblock.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/population.h"
+#include "foundation/utility/statistics.h"
+
+namespace foundation
+{
+
+//
+// CounterBlock class implementation.
+//
+
+CounterBlock::CounterBlock()
+  : m_ms_per_tick(1000.0 / m_timer.frequency())
+{
+}
+
+size_t CounterBlock::declare_counter(const char* name)
+{
+    return declare(name, false);
+}
+
+size_t CounterBlock::declare_timer(const char* name)
+{
+    return declare(name, true);
+}
+
+void CounterBlock::flush(Statistics& stats)
+{
+    Statistics block_stats;
+
+    for (size_t i = 0, e = m_slots.size(); i < e; ++i)
+    {
+        Slot& slot = m_slots[i];
+
+        if (!slot.m_updated)
+            continue;
+
+        if (slot.m_is_timer)
+        {
+            Population<double> times;
+            times.insert(slot.m_value * m_ms_per_tick);
+            block_stats.insert(slot.m_name, times, " ms");
+        }
+        else block_stats.insert<uint64>(slot.m_name, slot.m_value);
+
+        slot.m_value = 0;
+        slot.m_updated = false;
+    }
+
+    stats.merge(block_stats);
+}
+
+size_t CounterBlock::declare(const char* name, const bool is_timer)
+{
+    Slot slot;
+    slot.m_name = name;
+    slot.m_is_timer = is_timer;
+    slot.m_value = 0;
+    slot.m_updated = false;
+
+    m_slots.push_back(slot);
+
+    return m_slots.size() - 1;
+}
+
+}   // namespace foundation
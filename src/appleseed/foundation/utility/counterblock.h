@@ -0,0 +1,183 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_FOUNDATION_UTILITY_COUNTERBLOCK_H
+#define APPLESEED_FOUNDATION_UTILITY_COUNTERBLOCK_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/tsctimer.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class Statistics; }
+
+namespace foundation
+{
+
+//
+// A block of named counters and timers owned by a single thread.
+//
+// Counters and timers are updated with plain arithmetic, which makes them cheap enough
+// to be left enabled in hot code paths. The block is flushed into a Statistics object
+// once in a while, typically at the end of each job, which keeps the cost of inserting
+// entries into Statistics out of the hot paths.
+//
+// Counters accumulate integers. Timers accumulate TSCTimer ticks; each flush adds the
+// time accumulated since the previous flush, in milliseconds, as one sample to the
+// population of the timer, such that flushing at the end of each job yields per-job
+// timing statistics.
+//
+
+class CounterBlock
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    CounterBlock();
+
+    // Declare a counter and return its index.
+    size_t declare_counter(const char* name);
+
+    // Declare a timer and return its index.
+    size_t declare_timer(const char* name);
+
+    // Add a value to a counter.
+    void add(const size_t index, const uint64 value);
+
+    // Increment a counter.
+    void increment(const size_t index);
+
+    // Read the current time, for later use with add_time().
+    uint64 read_time();
+
+    // Add the time elapsed since 'start_time' to a timer.
+    void add_time(const size_t index, const uint64 start_time);
+
+    // Add the counters and timers to a set of statistics and reset them.
+    void flush(Statistics& stats);
+
+  private:
+    struct Slot
+    {
+        std::string     m_name;
+        bool            m_is_timer;
+        uint64          m_value;            // counter value or accumulated timer ticks
+        bool            m_updated;          // was the slot updated since the last flush?
+    };
+
+    TSCTimer            m_timer;
+    const double        m_ms_per_tick;
+    std::vector<Slot>   m_slots;
+
+    size_t declare(const char* name, const bool is_timer);
+};
+
+
+//
+// Time the lifetime of a scope into a timer of a counter block.
+//
+
+class ScopedCounterBlockTimer
+  : public NonCopyable
+{
+  public:
+    ScopedCounterBlockTimer(CounterBlock& block, const size_t index);
+    ~ScopedCounterBlockTimer();
+
+  private:
+    CounterBlock&       m_block;
+    const size_t        m_index;
+    const uint64        m_start_time;
+};
+
+
+//
+// CounterBlock class implementation.
+//
+
+inline void CounterBlock::add(const size_t index, const uint64 value)
+{
+    assert(index < m_slots.size());
+    assert(!m_slots[index].m_is_timer);
+
+    m_slots[index].m_value += value;
+    m_slots[index].m_updated = true;
+}
+
+inline void CounterBlock::increment(const size_t index)
+{
+    add(index, 1);
+}
+
+inline uint64 CounterBlock::read_time()
+{
+    return m_timer.read();
+}
+
+inline void CounterBlock::add_time(const size_t index, const uint64 start_time)
+{
+    assert(index < m_slots.size());
+    assert(m_slots[index].m_is_timer);
+
+    const uint64 end_time = m_timer.read();
+
+    // The time stamp counter may appear to go backward if the thread migrated to another core.
+    if (end_time > start_time)
+        m_slots[index].m_value += end_time - start_time;
+
+    m_slots[index].m_updated = true;
+}
+
+
+//
+// ScopedCounterBlockTimer class implementation.
+//
+
+inline ScopedCounterBlockTimer::ScopedCounterBlockTimer(CounterBlock& block, const size_t index)
+  : m_block(block)
+  , m_index(index)
+  , m_start_time(block.read_time())
+{
+}
+
+inline ScopedCounterBlockTimer::~ScopedCounterBlockTimer()
+{
+    m_block.add_time(m_index, m_start_time);
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_UTILITY_COUNTERBLOCK_H
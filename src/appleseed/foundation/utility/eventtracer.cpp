@@ -0,0 +1,291 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Interface header.
+#include "eventtracer.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/thread.h"
+
+// Boost headers.
+#include "boost/chrono/system_clocks.hpp"
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/tss.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+namespace foundation
+{
+
+//
+// EventTracer class implementation.
+//
+
+namespace
+{
+    typedef boost::chrono::steady_clock Clock;
+
+    struct Event
+    {
+        const char*     m_name;
+        const char*     m_category;
+        uint64          m_begin_time;
+        uint64          m_duration;
+    };
+
+    // The ring buffer of the events of a thread. It is only written by its thread, the
+    // lock protects it against concurrent reads and clears.
+    struct ThreadBuffer
+    {
+        Spinlock        m_spinlock;
+        size_t          m_thread_id;
+        vector<Event>   m_events;
+        size_t          m_next;             // index of the next event to write
+        size_t          m_size;             // number of valid events
+
+        ThreadBuffer(const size_t thread_id, const size_t capacity)
+          : m_thread_id(thread_id)
+          , m_events(capacity)
+          , m_next(0)
+          , m_size(0)
+        {
+        }
+    };
+
+    void write_json_string(ostream& output, const char* s)
+    {
+        output << '"';
+
+        for (; *s; ++s)
+        {
+            if (*s == '"' || *s == '\\')
+                output << '\\';
+            output << *s;
+        }
+
+        output << '"';
+    }
+
+    // Thread buffers are owned by their tracer, not by the thread that fills them.
+    void no_cleanup(ThreadBuffer*)
+    {
+    }
+}
+
+struct EventTracer::Impl
+{
+    const size_t                            m_events_per_thread;
+    boost::thread_specific_ptr<ThreadBuffer> m_thread_buffer;
+    boost::mutex                            m_mutex;
+    vector<ThreadBuffer*>                   m_thread_buffers;
+    Clock::time_point                       m_start_time;
+
+    explicit Impl(const size_t events_per_thread)
+      : m_events_per_thread(max<size_t>(events_per_thread, 1))
+      , m_thread_buffer(&no_cleanup)
+      , m_start_time(Clock::now())
+    {
+    }
+
+    ~Impl()
+    {
+        for (size_t i = 0, e = m_thread_buffers.size(); i < e; ++i)
+            delete m_thread_buffers[i];
+    }
+
+    ThreadBuffer& get_thread_buffer()
+    {
+        ThreadBuffer* buffer = m_thread_buffer.get();
+
+        if (buffer == 0)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            buffer = new ThreadBuffer(m_thread_buffers.size() + 1, m_events_per_thread);
+            m_thread_buffers.push_back(buffer);
+            m_thread_buffer.reset(buffer);
+        }
+
+        return *buffer;
+    }
+};
+
+EventTracer::EventTracer(const size_t events_per_thread)
+  : impl(new Impl(events_per_thread))
+  , m_enabled(false)
+{
+}
+
+EventTracer::~EventTracer()
+{
+    delete impl;
+}
+
+void EventTracer::set_enabled(const bool enabled)
+{
+    m_enabled = enabled;
+}
+
+void EventTracer::clear()
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    for (size_t i = 0, e = impl->m_thread_buffers.size(); i < e; ++i)
+    {
+        ThreadBuffer& buffer = *impl->m_thread_buffers[i];
+        Spinlock::ScopedLock buffer_lock(buffer.m_spinlock);
+        buffer.m_next = 0;
+        buffer.m_size = 0;
+    }
+
+    impl->m_start_time = Clock::now();
+}
+
+uint64 EventTracer::get_time() const
+{
+    const Clock::duration elapsed = Clock::now() - impl->m_start_time;
+    const boost::chrono::microseconds us = boost::chrono::duration_cast<boost::chrono::microseconds>(elapsed);
+    return us.count() > 0 ? static_cast<uint64>(us.count()) : 0;
+}
+
+void EventTracer::record(
+    const char*     name,
+    const char*     category,
+    const uint64    begin_time,
+    const uint64    end_time)
+{
+    assert(name);
+    assert(category);
+
+    ThreadBuffer& buffer = impl->get_thread_buffer();
+    Spinlock::ScopedLock lock(buffer.m_spinlock);
+
+    Event& event = buffer.m_events[buffer.m_next];
+    event.m_name = name;
+    event.m_category = category;
+    event.m_begin_time = begin_time;
+    event.m_duration = end_time > begin_time ? end_time - begin_time : 0;
+
+    if (++buffer.m_next == buffer.m_events.size())
+        buffer.m_next = 0;
+
+    buffer.m_size = min(buffer.m_size + 1, buffer.m_events.size());
+}
+
+size_t EventTracer::get_event_count() const
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    size_t count = 0;
+
+    for (size_t i = 0, e = impl->m_thread_buffers.size(); i < e; ++i)
+    {
+        ThreadBuffer& buffer = *impl->m_thread_buffers[i];
+        Spinlock::ScopedLock buffer_lock(buffer.m_spinlock);
+        count += buffer.m_size;
+    }
+
+    return count;
+}
+
+string EventTracer::to_chrome_trace() const
+{
+    stringstream output;
+    output << "{\"traceEvents\":[";
+
+    bool first = true;
+
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    for (size_t i = 0, e = impl->m_thread_buffers.size(); i < e; ++i)
+    {
+        ThreadBuffer& buffer = *impl->m_thread_buffers[i];
+        Spinlock::ScopedLock buffer_lock(buffer.m_spinlock);
+
+        const size_t capacity = buffer.m_events.size();
+        const size_t oldest = (buffer.m_next + capacity - buffer.m_size) % capacity;
+
+        for (size_t j = 0; j < buffer.m_size; ++j)
+        {
+            const Event& event = buffer.m_events[(oldest + j) % capacity];
+
+            if (!first)
+                output << ',';
+            first = false;
+
+            output << "\n{\"name\":";
+            write_json_string(output, event.m_name);
+            output << ",\"cat\":";
+            write_json_string(output, event.m_category);
+            output << ",\"ph\":\"X\",\"ts\":" << event.m_begin_time;
+            output << ",\"dur\":" << event.m_duration;
+            output << ",\"pid\":1,\"tid\":" << buffer.m_thread_id << '}';
+        }
+    }
+
+    output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    return output.str();
+}
+
+bool EventTracer::write_chrome_trace(const char* filepath) const
+{
+    assert(filepath);
+
+    ofstream file(filepath);
+
+    if (!file.is_open())
+        return false;
+
+    file << to_chrome_trace();
+    file.close();
+
+    return !file.fail();
+}
+
+namespace
+{
+    // Constructed at load time, before any thread may record events.
+    EventTracer g_global_event_tracer;
+}
+
+EventTracer& global_event_tracer()
+{
+    return g_global_event_tracer;
+}
+
+}   // namespace foundation
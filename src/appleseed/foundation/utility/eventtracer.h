@@ -0,0 +1,164 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef APPLESEED_FOUNDATION_UTILITY_EVENTTRACER_H
+#define APPLESEED_FOUNDATION_UTILITY_EVENTTRACER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+
+namespace foundation
+{
+
+//
+// A recorder of timed events, such as jobs, tree builds or file writes, that shows how
+// the work of the different threads overlaps in time.
+//
+// Each thread records its events into its own ring buffer: once a buffer is full, the
+// oldest events of the thread are overwritten. Recording is disabled by default, and
+// costs a single test when disabled. Events are written in the Chrome trace event
+// format, which can be viewed in chrome://tracing or in Perfetto.
+//
+
+class APPLESEED_DLLSYMBOL EventTracer
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    explicit EventTracer(const size_t events_per_thread = 64 * 1024);
+
+    // Destructor.
+    ~EventTracer();
+
+    // Enable or disable the recording of events.
+    void set_enabled(const bool enabled);
+    bool is_enabled() const;
+
+    // Discard all recorded events and restart the clock.
+    void clear();
+
+    // Return the current time in microseconds, relative to the last clear of the tracer.
+    uint64 get_time() const;
+
+    // Record an event of the calling thread. 'name' and 'category' are not copied and
+    // must remain valid until the events are written; they are typically string literals.
+    void record(
+        const char*     name,
+        const char*     category,
+        const uint64    begin_time,
+        const uint64    end_time);
+
+    // Return the number of recorded events, across all threads.
+    size_t get_event_count() const;
+
+    // Return the recorded events in Chrome trace event format.
+    std::string to_chrome_trace() const;
+
+    // Write the recorded events to a file in Chrome trace event format.
+    // Return true on success, false otherwise.
+    bool write_chrome_trace(const char* filepath) const;
+
+  private:
+    struct Impl;
+    Impl*           impl;
+    volatile bool   m_enabled;
+};
+
+// Return the event tracer used to instrument appleseed.
+APPLESEED_DLLSYMBOL EventTracer& global_event_tracer();
+
+
+//
+// Record an event spanning the lifetime of the object.
+//
+
+class ScopedTraceEvent
+  : public NonCopyable
+{
+  public:
+    ScopedTraceEvent(
+        const char*     name,
+        const char*     category,
+        EventTracer&    tracer = global_event_tracer());
+
+    ~ScopedTraceEvent();
+
+  private:
+    EventTracer&        m_tracer;
+    const char*         m_name;
+    const char*         m_category;
+    const bool          m_enabled;
+    uint64              m_begin_time;
+};
+
+
+//
+// EventTracer class implementation.
+//
+
+inline bool EventTracer::is_enabled() const
+{
+    return m_enabled;
+}
+
+
+//
+// ScopedTraceEvent class implementation.
+//
+
+inline ScopedTraceEvent::ScopedTraceEvent(
+    const char*         name,
+    const char*         category,
+    EventTracer&        tracer)
+  : m_tracer(tracer)
+  , m_name(name)
+  , m_category(category)
+  , m_enabled(tracer.is_enabled())
+  , m_begin_time(m_enabled ? tracer.get_time() : 0)
+{
+}
+
+inline ScopedTraceEvent::~ScopedTraceEvent()
+{
+    if (m_enabled)
+        m_tracer.record(m_name, m_category, m_begin_time, m_tracer.get_time());
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_UTILITY_EVENTTRACER_H
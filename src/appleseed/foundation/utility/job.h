@@ -33,6 +33,7 @@
 // Interface headers.
 #include "foundation/utility/job/abortswitch.h"
 #include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobgraph.h"
 #include "foundation/utility/job/jobmanager.h"
 #include "foundation/utility/job/jobqueue.h"
 
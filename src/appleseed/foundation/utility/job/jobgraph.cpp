@@ -0,0 +1,199 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "jobgraph.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/atomic.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobqueue.h"
+
+// Standard headers.
+#include <cassert>
+#include <vector>
+
+using namespace std;
+
+namespace foundation
+{
+
+//
+// JobGraph class implementation.
+//
+
+namespace
+{
+    // Wraps a job of the graph and schedules its dependents once it has completed.
+    class NodeJob
+      : public IJob
+    {
+      public:
+        NodeJob(JobQueue& job_queue, IJob* job, const size_t index)
+          : m_job_queue(job_queue)
+          , m_job(job)
+          , m_index(index)
+          , m_prerequisite_count(0)
+          , m_pending_count(0)
+        {
+        }
+
+        ~NodeJob()
+        {
+            delete m_job;
+        }
+
+        virtual void execute(const size_t thread_index) APPLESEED_OVERRIDE
+        {
+            m_job->execute(thread_index);
+
+            for (size_t i = 0, e = m_dependents.size(); i < e; ++i)
+            {
+                NodeJob* dependent = m_dependents[i];
+
+                // atomic_dec() returns the value before the decrement.
+                if (atomic_dec(&dependent->m_pending_count) == 1)
+                    m_job_queue.schedule(dependent, false);
+            }
+        }
+
+        JobQueue&           m_job_queue;
+        IJob*               m_job;
+        const size_t        m_index;
+        vector<NodeJob*>    m_dependents;
+        uint32              m_prerequisite_count;
+        volatile uint32     m_pending_count;
+    };
+}
+
+struct JobGraph::Impl
+{
+    JobQueue&               m_job_queue;
+    vector<NodeJob*>        m_nodes;
+
+    explicit Impl(JobQueue& job_queue)
+      : m_job_queue(job_queue)
+    {
+    }
+
+    bool is_acyclic() const
+    {
+        // Kahn's algorithm: repeatedly remove the jobs without remaining prerequisites.
+        vector<uint32> remaining(m_nodes.size());
+        vector<size_t> ready;
+
+        for (size_t i = 0, e = m_nodes.size(); i < e; ++i)
+        {
+            remaining[i] = m_nodes[i]->m_prerequisite_count;
+            if (remaining[i] == 0)
+                ready.push_back(i);
+        }
+
+        size_t visited = 0;
+
+        while (!ready.empty())
+        {
+            const NodeJob* node = m_nodes[ready.back()];
+            ready.pop_back();
+            ++visited;
+
+            for (size_t i = 0, e = node->m_dependents.size(); i < e; ++i)
+            {
+                const size_t index = node->m_dependents[i]->m_index;
+                if (--remaining[index] == 0)
+                    ready.push_back(index);
+            }
+        }
+
+        return visited == m_nodes.size();
+    }
+};
+
+JobGraph::JobGraph(JobQueue& job_queue)
+  : impl(new Impl(job_queue))
+{
+}
+
+JobGraph::~JobGraph()
+{
+    for (size_t i = 0, e = impl->m_nodes.size(); i < e; ++i)
+        delete impl->m_nodes[i];
+
+    delete impl;
+}
+
+size_t JobGraph::add_job(IJob* job)
+{
+    assert(job);
+
+    const size_t index = impl->m_nodes.size();
+    impl->m_nodes.push_back(new NodeJob(impl->m_job_queue, job, index));
+
+    return index;
+}
+
+size_t JobGraph::get_job_count() const
+{
+    return impl->m_nodes.size();
+}
+
+void JobGraph::add_dependency(const size_t before, const size_t after)
+{
+    assert(before < impl->m_nodes.size());
+    assert(after < impl->m_nodes.size());
+
+    impl->m_nodes[before]->m_dependents.push_back(impl->m_nodes[after]);
+    ++impl->m_nodes[after]->m_prerequisite_count;
+}
+
+bool JobGraph::schedule()
+{
+    if (!impl->is_acyclic())
+        return false;
+
+    // Reset all counters before scheduling anything since jobs may start right away.
+    for (size_t i = 0, e = impl->m_nodes.size(); i < e; ++i)
+    {
+        NodeJob* node = impl->m_nodes[i];
+        atomic_write(&node->m_pending_count, node->m_prerequisite_count);
+    }
+
+    for (size_t i = 0, e = impl->m_nodes.size(); i < e; ++i)
+    {
+        NodeJob* node = impl->m_nodes[i];
+        if (node->m_prerequisite_count == 0)
+            impl->m_job_queue.schedule(node, false);
+    }
+
+    return true;
+}
+
+}   // namespace foundation
@@ -0,0 +1,94 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_FOUNDATION_UTILITY_JOB_JOBGRAPH_H
+#define APPLESEED_FOUNDATION_UTILITY_JOB_JOBGRAPH_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class IJob; }
+namespace foundation    { class JobQueue; }
+
+namespace foundation
+{
+
+//
+// A directed acyclic graph of jobs.
+//
+// A job is scheduled into the job queue only once all the jobs it depends on have
+// completed: the worker thread that completes the last prerequisite of a job schedules
+// it right away, before retiring the prerequisite. As a consequence, the job queue
+// never runs dry while the graph is in progress and JobQueue::wait_until_completion()
+// returns only once every job of the graph has been executed.
+//
+// If a job terminates with an exception, the jobs that depend on it are never executed.
+//
+// None of the methods of this class are thread-safe. The graph must outlive the
+// execution of its jobs.
+//
+
+class APPLESEED_DLLSYMBOL JobGraph
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    explicit JobGraph(JobQueue& job_queue);
+
+    // Destructor. Deletes all the jobs of the graph.
+    ~JobGraph();
+
+    // Add a job to the graph and return its index. Ownership of the job is transfered to the graph.
+    size_t add_job(IJob* job);
+
+    // Return the number of jobs in the graph.
+    size_t get_job_count() const;
+
+    // Require job 'before' to complete before job 'after' is executed.
+    void add_dependency(const size_t before, const size_t after);
+
+    // Schedule the jobs that don't depend on any other job. Return false and don't
+    // schedule anything if the dependencies contain a cycle, true otherwise.
+    bool schedule();
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_UTILITY_JOB_JOBGRAPH_H
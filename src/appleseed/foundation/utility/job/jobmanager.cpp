@@ -31,6 +31,8 @@
 #include "jobmanager.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/atomic.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/job/workerthread.h"
@@ -60,6 +62,10 @@ struct JobManager::Impl
     const int           m_flags;
     WorkerThreads       m_worker_threads;
 
+    // Time spent executing jobs by each worker thread, in microseconds.
+    // Kept here rather than in worker threads since those are deleted by stop().
+    boost::atomic<uint64>* m_busy_times;
+
     // Constructor.
     Impl(
         Logger&         logger,
@@ -70,7 +76,16 @@ struct JobManager::Impl
       , m_job_queue(job_queue)
       , m_thread_count(thread_count)
       , m_flags(flags)
+      , m_busy_times(new boost::atomic<uint64>[thread_count])
     {
+        for (size_t i = 0; i < thread_count; ++i)
+            m_busy_times[i] = 0;
+    }
+
+    // Destructor.
+    ~Impl()
+    {
+        delete[] m_busy_times;
     }
 };
 
@@ -95,6 +110,13 @@ size_t JobManager::get_thread_count() const
     return impl->m_thread_count;
 }
 
+double JobManager::get_busy_time(const size_t thread_index) const
+{
+    assert(thread_index < impl->m_thread_count);
+
+    return static_cast<double>(impl->m_busy_times[thread_index].load()) * 1.0e-6;
+}
+
 void JobManager::start()
 {
     assert(impl->m_worker_threads.empty() ||
@@ -103,6 +125,10 @@ void JobManager::start()
     // Create worker threads if they don't already exist.
     if (impl->m_worker_threads.empty())
     {
+        // Distribute the job queue among worker threads.
+        if ((impl->m_flags & WorkStealing) && impl->m_thread_count > 0)
+            impl->m_job_queue.enable_work_stealing(impl->m_thread_count);
+
         for (size_t i = 0; i < impl->m_thread_count; ++i)
         {
             impl->m_worker_threads.push_back(
@@ -110,7 +136,8 @@ void JobManager::start()
                     i,
                     impl->m_logger,
                     impl->m_job_queue,
-                    impl->m_flags));
+                    impl->m_flags,
+                    impl->m_busy_times[i]));
         }
     }
 
@@ -125,6 +152,10 @@ void JobManager::stop()
     for (each<Impl::WorkerThreads> i = impl->m_worker_threads; i; ++i)
         delete *i;
     impl->m_worker_threads.clear();
+
+    // Gather remaining scheduled jobs back into a single job list.
+    if (impl->m_flags & WorkStealing)
+        impl->m_job_queue.disable_work_stealing();
 }
 
 void JobManager::pause()
@@ -49,7 +49,8 @@ namespace foundation
 //
 // A multithreaded job manager.
 //
-// The job manager itself is thread-local: none of its methods are thread-safe.
+// The job manager itself is thread-local: none of its methods are thread-safe,
+// with the exception of get_busy_time().
 //
 
 class APPLESEED_DLLSYMBOL JobManager
@@ -59,7 +60,9 @@ class APPLESEED_DLLSYMBOL JobManager
     enum Flags
     {
         KeepRunningOnEmptyQueue = 1 << 0,   // the worker thread keeps running even if the job queue is empty
-        KeepRunningOnJobFailure = 1 << 1    // the worker thread keeps executing jobs from the work queue even if one or more jobs failed
+        KeepRunningOnJobFailure = 1 << 1,   // the worker thread keeps executing jobs from the work queue even if one or more jobs failed
+        WorkStealing            = 1 << 2,   // give each worker thread its own job list and let idle worker threads steal jobs from the others
+        PinWorkerThreads        = 1 << 3    // pin each worker thread to a logical CPU core, filling one NUMA node after the other
     };
 
     // Constructor.
@@ -75,6 +78,10 @@ class APPLESEED_DLLSYMBOL JobManager
     // Return the number of worker threads.
     size_t get_thread_count() const;
 
+    // Return the wall clock time a given worker thread spent executing jobs since
+    // the job manager was constructed, in seconds. Thread-safe.
+    double get_busy_time(const size_t thread_index) const;
+
     // Start job execution. Returns immediately.
     void start();
 
@@ -31,6 +31,7 @@
 #include "jobqueue.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/atomic.h"
 #include "foundation/platform/thread.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/iterators.h"
@@ -42,6 +43,8 @@
 
 // Standard headers.
 #include <cassert>
+#include <deque>
+#include <vector>
 
 using namespace std;
 
@@ -51,23 +54,82 @@ namespace foundation
 //
 // JobQueue class implementation.
 //
+// In work stealing mode, scheduled jobs are stored in per-worker job lists, each
+// guarded by its own adaptive lock, and job counts are maintained with atomic operations.
+// The main mutex is only acquired to put idle threads to sleep and to wake them up,
+// and only when some thread is actually waiting.
+//
 
 struct JobQueue::Impl
 {
+    // Job list of a worker thread in work stealing mode.
+    struct WorkerQueue
+    {
+        AdaptiveLock                m_lock;
+        deque<JobInfo>              m_jobs;
+
+        explicit WorkerQueue(LockContentionCounters* lock_counters)
+          : m_lock(lock_counters)
+        {
+        }
+    };
+
+    typedef vector<WorkerQueue*> WorkerQueueVector;
+
     mutable boost::mutex            m_mutex;
     boost::condition_variable_any   m_event;
     JobList                         m_scheduled_jobs;
     JobList                         m_running_jobs;
 
-    static void delete_jobs(JobList& list)
+    // Work stealing mode.
+    WorkerQueueVector               m_worker_queues;
+    LockContentionCounters          m_worker_queue_lock_counters;
+    boost::atomic<size_t>           m_next_worker_queue;
+    boost::atomic<size_t>           m_scheduled_job_count;
+    boost::atomic<size_t>           m_pending_job_count;    // scheduled and running jobs
+    boost::atomic<size_t>           m_waiting_thread_count;
+
+    Impl()
+      : m_next_worker_queue(0)
+      , m_scheduled_job_count(0)
+      , m_pending_job_count(0)
+      , m_waiting_thread_count(0)
+    {
+    }
+
+    bool is_work_stealing() const
+    {
+        return !m_worker_queues.empty();
+    }
+
+    size_t get_running_job_count_work_stealing() const
+    {
+        // Read the scheduled job count first: it never exceeds the pending job count.
+        const size_t scheduled = m_scheduled_job_count;
+        const size_t pending = m_pending_job_count;
+        return pending > scheduled ? pending - scheduled : 0;
+    }
+
+    // Wake up threads waiting on the queue event. Does not lock if no thread is waiting.
+    void notify_waiting_threads()
+    {
+        if (m_waiting_thread_count > 0)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_event.notify_all();
+        }
+    }
+
+    template <typename JobContainer>
+    static void delete_jobs(JobContainer& jobs)
     {
-        for (each<JobList> i = list; i; ++i)
+        for (each<JobContainer> i = jobs; i; ++i)
         {
             if (i->m_owned)
                 delete i->m_job;
         }
 
-        list.clear();
+        jobs.clear();
     }
 };
 
@@ -84,6 +146,7 @@ JobQueue::~JobQueue()
     assert(impl->m_running_jobs.empty());
 
     // Delete all scheduled jobs that the queue owns.
+    disable_work_stealing();
     Impl::delete_jobs(impl->m_scheduled_jobs);
 
     delete impl;
@@ -91,6 +154,20 @@ JobQueue::~JobQueue()
 
 void JobQueue::clear_scheduled_jobs()
 {
+    if (impl->is_work_stealing())
+    {
+        for (each<Impl::WorkerQueueVector> i = impl->m_worker_queues; i; ++i)
+        {
+            AdaptiveLock::ScopedLock lock((*i)->m_lock);
+
+            const size_t job_count = (*i)->m_jobs.size();
+            impl->m_scheduled_job_count -= job_count;
+            impl->m_pending_job_count -= job_count;
+
+            impl->delete_jobs((*i)->m_jobs);
+        }
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     impl->delete_jobs(impl->m_scheduled_jobs);
@@ -101,6 +178,9 @@ void JobQueue::clear_scheduled_jobs()
 
 bool JobQueue::has_scheduled_jobs() const
 {
+    if (impl->is_work_stealing())
+        return impl->m_scheduled_job_count > 0;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return !impl->m_scheduled_jobs.empty();
@@ -108,6 +188,9 @@ bool JobQueue::has_scheduled_jobs() const
 
 bool JobQueue::has_running_jobs() const
 {
+    if (impl->is_work_stealing())
+        return impl->get_running_job_count_work_stealing() > 0;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return !impl->m_running_jobs.empty();
@@ -115,6 +198,9 @@ bool JobQueue::has_running_jobs() const
 
 bool JobQueue::has_scheduled_or_running_jobs() const
 {
+    if (impl->is_work_stealing())
+        return impl->m_pending_job_count > 0;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return !impl->m_scheduled_jobs.empty() || !impl->m_running_jobs.empty();
@@ -122,6 +208,9 @@ bool JobQueue::has_scheduled_or_running_jobs() const
 
 size_t JobQueue::get_scheduled_job_count() const
 {
+    if (impl->is_work_stealing())
+        return impl->m_scheduled_job_count;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return impl->m_scheduled_jobs.size();
@@ -129,6 +218,9 @@ size_t JobQueue::get_scheduled_job_count() const
 
 size_t JobQueue::get_running_job_count() const
 {
+    if (impl->is_work_stealing())
+        return impl->get_running_job_count_work_stealing();
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return impl->m_running_jobs.size();
@@ -136,15 +228,44 @@ size_t JobQueue::get_running_job_count() const
 
 size_t JobQueue::get_total_job_count() const
 {
+    if (impl->is_work_stealing())
+        return impl->m_pending_job_count;
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return impl->m_scheduled_jobs.size() + impl->m_running_jobs.size();
 }
 
+const LockContentionCounters& JobQueue::get_worker_queue_lock_counters() const
+{
+    return impl->m_worker_queue_lock_counters;
+}
+
 void JobQueue::schedule(IJob* job, const bool transfer_ownership)
 {
     assert(job);
 
+    if (impl->is_work_stealing())
+    {
+        // Distribute jobs among worker threads in a round-robin fashion.
+        const size_t index = impl->m_next_worker_queue++ % impl->m_worker_queues.size();
+        Impl::WorkerQueue& queue = *impl->m_worker_queues[index];
+
+        {
+            AdaptiveLock::ScopedLock lock(queue.m_lock);
+
+            queue.m_jobs.push_back(JobInfo(job, transfer_ownership));
+
+            ++impl->m_pending_job_count;
+            ++impl->m_scheduled_job_count;
+        }
+
+        // Notify idle worker threads that a new scheduled job is available.
+        impl->notify_waiting_threads();
+
+        return;
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     impl->m_scheduled_jobs.push_back(JobInfo(job, transfer_ownership));
@@ -157,20 +278,109 @@ void JobQueue::wait_until_completion()
 {
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
+    if (impl->is_work_stealing())
+    {
+        // Wait until there is no more scheduled or running jobs.
+        ++impl->m_waiting_thread_count;
+        while (impl->m_pending_job_count > 0)
+            impl->m_event.wait(lock);
+        --impl->m_waiting_thread_count;
+
+        return;
+    }
+
     // Wait until there is no more scheduled or running jobs.
     while (!impl->m_scheduled_jobs.empty() || !impl->m_running_jobs.empty())
         impl->m_event.wait(lock);
 }
 
+void JobQueue::enable_work_stealing(const size_t worker_count)
+{
+    assert(worker_count > 0);
+    assert(!impl->is_work_stealing());
+    assert(impl->m_running_jobs.empty());
+
+    for (size_t i = 0; i < worker_count; ++i)
+        impl->m_worker_queues.push_back(new Impl::WorkerQueue(&impl->m_worker_queue_lock_counters));
+
+    // Move scheduled jobs to the job lists of the worker threads.
+    const size_t job_count = impl->m_scheduled_jobs.size();
+    for (size_t i = 0; i < job_count; ++i)
+    {
+        impl->m_worker_queues[i % worker_count]->m_jobs.push_back(impl->m_scheduled_jobs.front());
+        impl->m_scheduled_jobs.pop_front();
+    }
+
+    impl->m_next_worker_queue = job_count;
+    impl->m_scheduled_job_count = job_count;
+    impl->m_pending_job_count = job_count;
+}
+
+void JobQueue::disable_work_stealing()
+{
+    if (!impl->is_work_stealing())
+        return;
+
+    assert(impl->get_running_job_count_work_stealing() == 0);
+
+    // Move scheduled jobs back to the main job list, preserving the order in which
+    // they would have been picked up by worker threads.
+    bool moved_job = true;
+    for (size_t rank = 0; moved_job; ++rank)
+    {
+        moved_job = false;
+
+        for (each<Impl::WorkerQueueVector> i = impl->m_worker_queues; i; ++i)
+        {
+            if (rank < (*i)->m_jobs.size())
+            {
+                impl->m_scheduled_jobs.push_back((*i)->m_jobs[rank]);
+                moved_job = true;
+            }
+        }
+    }
+
+    for (each<Impl::WorkerQueueVector> i = impl->m_worker_queues; i; ++i)
+        delete *i;
+
+    impl->m_worker_queues.clear();
+    impl->m_scheduled_job_count = 0;
+    impl->m_pending_job_count = 0;
+}
+
 JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job()
 {
+    if (impl->is_work_stealing())
+        return acquire_scheduled_job_work_stealing(0);
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     return acquire_scheduled_job_unlocked();
 }
 
-JobQueue::RunningJobInfo JobQueue::wait_for_scheduled_job(AbortSwitch& abort_switch)
+JobQueue::RunningJobInfo JobQueue::wait_for_scheduled_job(
+    const size_t        worker_index,
+    AbortSwitch&        abort_switch)
 {
+    if (impl->is_work_stealing())
+    {
+        while (true)
+        {
+            const RunningJobInfo running_job_info =
+                acquire_scheduled_job_work_stealing(worker_index);
+
+            if (running_job_info.first.m_job || abort_switch.is_aborted())
+                return running_job_info;
+
+            // Sleep until a scheduled job is available.
+            boost::mutex::scoped_lock lock(impl->m_mutex);
+            ++impl->m_waiting_thread_count;
+            while (!abort_switch.is_aborted() && impl->m_scheduled_job_count == 0)   // order matters
+                impl->m_event.wait(lock);
+            --impl->m_waiting_thread_count;
+        }
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     // Wait for a scheduled job to be available.
@@ -197,8 +407,51 @@ JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job_unlocked()
     return RunningJobInfo(job_info, pred(impl->m_running_jobs.end()));
 }
 
+JobQueue::RunningJobInfo JobQueue::acquire_scheduled_job_work_stealing(const size_t worker_index)
+{
+    // Running jobs are only counted in work stealing mode, they are not stored in a list.
+    const size_t worker_count = impl->m_worker_queues.size();
+
+    for (size_t i = 0; i < worker_count; ++i)
+    {
+        Impl::WorkerQueue& queue = *impl->m_worker_queues[(worker_index + i) % worker_count];
+
+        AdaptiveLock::ScopedLock lock(queue.m_lock);
+
+        if (queue.m_jobs.empty())
+            continue;
+
+        // Take the oldest job from our own job list, steal the newest one from other worker threads.
+        const bool own_queue = i == 0;
+        const JobInfo job_info = own_queue ? queue.m_jobs.front() : queue.m_jobs.back();
+        if (own_queue)
+            queue.m_jobs.pop_front();
+        else
+            queue.m_jobs.pop_back();
+
+        --impl->m_scheduled_job_count;
+
+        return RunningJobInfo(job_info, impl->m_running_jobs.end());
+    }
+
+    return RunningJobInfo(JobInfo(0, false), impl->m_running_jobs.end());
+}
+
 void JobQueue::retire_running_job(const RunningJobInfo& running_job_info)
 {
+    if (impl->is_work_stealing())
+    {
+        // Delete the job.
+        if (running_job_info.first.m_owned)
+            delete running_job_info.first.m_job;
+
+        // Notify waiting threads once all jobs are completed.
+        if (--impl->m_pending_job_count == 0)
+            impl->notify_waiting_threads();
+
+        return;
+    }
+
     boost::mutex::scoped_lock lock(impl->m_mutex);
 
     // Remove the job from the running list.
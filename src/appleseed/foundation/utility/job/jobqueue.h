@@ -46,6 +46,7 @@
 // Forward declarations.
 namespace foundation    { class AbortSwitch; }
 namespace foundation    { class IJob; }
+namespace foundation    { class LockContentionCounters; }
 
 // Unit test case declarations.
 DECLARE_TEST_CASE(Foundation_Utility_Job_JobQueue, AcquireScheduledJobWorksOnEmptyJobQueue);
@@ -67,6 +68,12 @@ namespace foundation
 //   - scheduled: the job was inserted into the job queue, but hasn't yet been executed
 //   - running: the job is currently being executed
 //
+// By default, scheduled jobs are stored in a single list guarded by a single mutex.
+// A job manager created with the JobManager::WorkStealing flag switches the queue to
+// one job list per worker thread while it is running: jobs are distributed among
+// worker threads as they are scheduled, and a worker thread that runs out of jobs
+// steals jobs from the other worker threads.
+//
 
 class APPLESEED_DLLSYMBOL JobQueue
   : public NonCopyable
@@ -99,6 +106,9 @@ class APPLESEED_DLLSYMBOL JobQueue
     // Return the number of scheduled and running jobs in the job queue.
     size_t get_total_job_count() const;
 
+    // Return the contention counters of the per-worker job lists (work stealing mode).
+    const LockContentionCounters& get_worker_queue_lock_counters() const;
+
     // Schedule a job for execution. Ownership of the job is transfered
     // to the job queue if and only if transfer_ownership is true.
     void schedule(IJob* job, const bool transfer_ownership = true);
@@ -107,6 +117,7 @@ class APPLESEED_DLLSYMBOL JobQueue
     void wait_until_completion();
 
   private:
+    friend class JobManager;
     friend class WorkerThread;
 
     struct Impl;
@@ -134,15 +145,31 @@ class APPLESEED_DLLSYMBOL JobQueue
 
     typedef std::pair<JobInfo, JobList::iterator> RunningJobInfo;
 
+    // Switch to one job list per worker thread. Scheduled jobs are moved to the
+    // job lists of the worker threads. Not thread-safe: worker threads must not
+    // be running and no job may be scheduled concurrently.
+    void enable_work_stealing(const size_t worker_count);
+
+    // Switch back to a single job list. Scheduled jobs are moved back to it.
+    // Not thread-safe: worker threads must not be running.
+    void disable_work_stealing();
+
     // Acquire a scheduled job and change its state from 'scheduled' to 'running'.
     RunningJobInfo acquire_scheduled_job();
 
-    // Wait for a scheduled job to be available.
-    RunningJobInfo wait_for_scheduled_job(AbortSwitch& abort_switch);
+    // Wait for a scheduled job to be available. In work stealing mode, the job
+    // list of the worker thread 'worker_index' is considered first.
+    RunningJobInfo wait_for_scheduled_job(
+        const size_t    worker_index,
+        AbortSwitch&    abort_switch);
 
     // Acquire a scheduled job without any locking.
     RunningJobInfo acquire_scheduled_job_unlocked();
 
+    // Acquire a scheduled job from the job list of a given worker thread,
+    // or steal one from another worker thread.
+    RunningJobInfo acquire_scheduled_job_work_stealing(const size_t worker_index);
+
     // Retire a running job. The job is deleted if it is owned by the queue.
     void retire_running_job(const RunningJobInfo& running_job_info);
 
@@ -31,15 +31,20 @@
 #include "workerthread.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/defaulttimers.h"
 #include "foundation/platform/snprintf.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/types.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/job/ijob.h"
 #include "foundation/utility/job/jobmanager.h"
 #include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/log.h"
+#include "foundation/utility/stopwatch.h"
 
 // Standard headers.
 #include <exception>
+#include <memory>
 
 using namespace boost;
 using namespace std;
@@ -55,11 +60,13 @@ WorkerThread::WorkerThread(
     const size_t    index,
     Logger&         logger,
     JobQueue&       job_queue,
-    const int       flags)
+    const int       flags,
+    boost::atomic<uint64>& busy_time)
   : m_index(index)
   , m_logger(logger)
   , m_job_queue(job_queue)
   , m_flags(flags)
+  , m_busy_time(busy_time)
   , m_thread_func(*this)
   , m_thread(0)
 {
@@ -136,6 +143,18 @@ void WorkerThread::run()
 {
     set_thread_name();
 
+    // Optionally pin the thread to a logical CPU core for its whole lifetime.
+    auto_ptr<ThreadAffinityContext> affinity_context;
+    if (m_flags & JobManager::PinWorkerThreads)
+    {
+        affinity_context.reset(
+            new ThreadAffinityContext(
+                System::get_numa_grouped_logical_cpu_core(m_index),
+                &m_logger));
+    }
+
+    Stopwatch<DefaultWallclockTimer> stopwatch(0);
+
     while (!m_abort_switch.is_aborted())
     {
         if (m_pause_flag.is_set())
@@ -148,7 +167,7 @@ void WorkerThread::run()
 
         // Acquire a job.
         const JobQueue::RunningJobInfo running_job_info =
-            m_job_queue.wait_for_scheduled_job(m_abort_switch);
+            m_job_queue.wait_for_scheduled_job(m_index, m_abort_switch);
 
         // Handle the case where the job queue is empty.
         if (running_job_info.first.m_job == 0)
@@ -166,7 +185,9 @@ void WorkerThread::run()
         }
 
         // Execute the job.
+        stopwatch.start();
         const bool success = execute_job(*running_job_info.first.m_job);
+        m_busy_time += static_cast<uint64>(stopwatch.measure().get_seconds() * 1.0e6);
 
         // Retire the job.
         m_job_queue.retire_running_job(running_job_info);
@@ -184,6 +205,7 @@ bool WorkerThread::execute_job(IJob& job)
 {
     try
     {
+        ScopedTraceEvent event("job", "worker thread");
         job.execute(m_index);
     }
     catch (const bad_alloc&)
@@ -32,7 +32,9 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/atomic.h"
 #include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/job/abortswitch.h"
 
 // Boost headers.
@@ -63,7 +65,8 @@ class WorkerThread
         const size_t    index,
         Logger&         logger,
         JobQueue&       job_queue,
-        const int       flags);     // see foundation::JobManager::Flags
+        const int       flags,      // see foundation::JobManager::Flags
+        boost::atomic<uint64>& busy_time);
 
     // Destructor.
     ~WorkerThread();
@@ -102,6 +105,7 @@ class WorkerThread
     Logger&                         m_logger;
     JobQueue&                       m_job_queue;
     const int                       m_flags;
+    boost::atomic<uint64>&          m_busy_time;        // time spent executing jobs, in microseconds
 
     AbortSwitch                     m_abort_switch;
 
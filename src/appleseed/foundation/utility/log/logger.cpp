@@ -40,7 +40,10 @@
 #include "foundation/utility/string.h"
 
 // Boost headers.
+#include "boost/atomic/atomic.hpp"
 #include "boost/date_time/posix_time/posix_time.hpp"
+#include "boost/lockfree/policies.hpp"
+#include "boost/lockfree/queue.hpp"
 
 // Standard headers.
 #include <algorithm>
@@ -203,35 +206,237 @@ namespace
 // Logger class implementation.
 //
 
-struct Logger::Impl
-{
-    typedef list<ILogTarget*> LogTargetContainer;
-
-    boost::mutex            m_mutex;
-    bool                    m_enabled;
-    LogMessage::Category    m_verbosity_level;
-    LogTargetContainer      m_targets;
-    vector<char>            m_message_buffer;
-    ThreadMap               m_thread_map;
-    Formatter               m_formatter;
-};
-
 namespace
 {
     const size_t InitialBufferSize = 1024;      // in bytes
     const size_t MaxBufferSize = 1024 * 1024;   // in bytes
+    const size_t MaxQueueCapacity = 65534;      // limit of boost::lockfree::queue with fixed_sized<true>
+    const uint32 ConsumerSleepTime = 1;         // in milliseconds
+
+    bool write_to_buffer(
+        vector<char>&   buffer,
+        const size_t    max_buffer_size,
+        const char*     format,
+        va_list         argptr)
+    {
+        while (true)
+        {
+            va_list argptr_copy;
+            va_copy(argptr_copy, argptr);
+
+            const size_t buffer_size = buffer.size();
+
+            const int result =
+                portable_vsnprintf(&buffer[0], buffer_size, format, argptr_copy);
+
+            if (result < 0)
+            {
+                sprintf(
+                    &buffer[0],
+                    "(failed to format message, format string is \"%s\".)",
+                    replace(format, "\n", "\\n").c_str());
+
+                return false;
+            }
+
+            const size_t needed_buffer_size = static_cast<size_t>(result) + 1;
+
+            if (needed_buffer_size <= buffer_size)
+                return true;
+
+            if (buffer_size >= max_buffer_size)
+                return false;
+
+            buffer.resize(min(needed_buffer_size, max_buffer_size));
+        }
+    }
+
+    struct AsyncMessage
+    {
+        LogMessage::Category    m_category;
+        const char*             m_file;
+        size_t                  m_line;
+        ptime                   m_datetime;
+        boost::thread::id       m_thread_id;
+        string                  m_text;
+    };
 }
 
+struct Logger::Impl
+{
+    typedef list<ILogTarget*> LogTargetContainer;
+    typedef boost::lockfree::queue<
+        AsyncMessage*,
+        boost::lockfree::fixed_sized<true>
+    > AsyncMessageQueue;
+
+    boost::mutex                        m_mutex;
+    boost::atomic<bool>                 m_enabled;
+    boost::atomic<LogMessage::Category> m_verbosity_level;
+    LogTargetContainer                  m_targets;
+    vector<char>                        m_message_buffer;
+    ThreadMap                           m_thread_map;
+    Formatter                           m_formatter;
+
+    // Asynchronous mode.
+    boost::mutex                        m_async_mutex;          // serializes set_async() calls
+    boost::atomic<bool>                 m_async;
+    boost::atomic<bool>                 m_stop_consumer;
+    AsyncMessageQueue*                  m_queue;                // created the first time asynchronous mode is enabled
+    boost::thread*                      m_consumer;
+    boost::atomic<uint64>               m_pushed_message_count;
+    boost::atomic<uint64>               m_written_message_count;
+    boost::atomic<uint64>               m_dropped_message_count;
+    uint64                              m_reported_dropped_message_count;
+
+    Impl()
+      : m_enabled(true)
+      , m_verbosity_level(LogMessage::Info)
+      , m_async(false)
+      , m_stop_consumer(false)
+      , m_queue(0)
+      , m_consumer(0)
+      , m_pushed_message_count(0)
+      , m_written_message_count(0)
+      , m_dropped_message_count(0)
+      , m_reported_dropped_message_count(0)
+    {
+        m_message_buffer.resize(InitialBufferSize);
+    }
+
+    // Format the header and message and send them to all log targets.
+    // The caller must hold m_mutex.
+    void dispatch(
+        const LogMessage::Category  category,
+        const char*                 file,
+        const size_t                line,
+        const ptime&                datetime,
+        const boost::thread::id     thread_id,
+        const char*                 text)
+    {
+        const size_t thread = m_thread_map.thread_id_to_int(thread_id);
+        const FormatEvaluator format_evaluator(category, datetime, thread, text);
+        const string header = format_evaluator.evaluate(m_formatter.get_header_format(category));
+        const string message = format_evaluator.evaluate(m_formatter.get_message_format(category));
+
+        if (!message.empty())
+        {
+            for (const_each<LogTargetContainer> i = m_targets; i; ++i)
+            {
+                ILogTarget* target = *i;
+                target->write(
+                    category,
+                    file,
+                    line,
+                    header.c_str(),
+                    message.c_str());
+            }
+        }
+    }
+
+    // Write all queued messages. Return the number of messages written.
+    size_t drain()
+    {
+        size_t count = 0;
+
+        if (m_queue == 0)
+            return count;
+
+        boost::mutex::scoped_lock lock(m_mutex);
+
+        AsyncMessage* message;
+        while (m_queue->pop(message))
+        {
+            if (m_enabled)
+            {
+                dispatch(
+                    message->m_category,
+                    message->m_file,
+                    message->m_line,
+                    message->m_datetime,
+                    message->m_thread_id,
+                    message->m_text.c_str());
+            }
+
+            delete message;
+            ++count;
+        }
+
+        report_dropped_messages();
+
+        m_written_message_count += count;
+
+        return count;
+    }
+
+    // Emit a warning if messages were dropped since the last report.
+    // The caller must hold m_mutex.
+    void report_dropped_messages()
+    {
+        const uint64 dropped = m_dropped_message_count;
+
+        if (dropped == m_reported_dropped_message_count || !m_enabled)
+            return;
+
+        const string text =
+            "log queue full, " +
+            pretty_uint(dropped - m_reported_dropped_message_count) + " message(s) dropped.";
+
+        dispatch(
+            LogMessage::Warning,
+            __FILE__,
+            __LINE__,
+            microsec_clock::universal_time(),
+            boost::this_thread::get_id(),
+            text.c_str());
+
+        m_reported_dropped_message_count = dropped;
+    }
+
+    void consume()
+    {
+        set_current_thread_name("logger");
+
+        while (true)
+        {
+            // Read the stop flag before draining so that no message pushed before the request is left behind.
+            const bool stop = m_stop_consumer;
+
+            if (drain() == 0)
+            {
+                if (stop)
+                    break;
+
+                foundation::sleep(ConsumerSleepTime);
+            }
+        }
+    }
+
+    void start_consumer()
+    {
+        m_stop_consumer = false;
+        m_consumer = new boost::thread(&Impl::consume, this);
+    }
+
+    void stop_consumer()
+    {
+        m_stop_consumer = true;
+        m_consumer->join();
+        delete m_consumer;
+        m_consumer = 0;
+    }
+};
+
 Logger::Logger()
   : impl(new Impl())
 {
-    impl->m_enabled = true;
-    impl->m_verbosity_level = LogMessage::Info;
-    impl->m_message_buffer.resize(InitialBufferSize);
 }
 
 Logger::~Logger()
 {
+    set_async(false);
+
+    delete impl->m_queue;
     delete impl;
 }
 
@@ -240,8 +445,8 @@ void Logger::initialize_from(const Logger& source)
     boost::mutex::scoped_lock source_lock(source.impl->m_mutex);
     boost::mutex::scoped_lock this_lock(impl->m_mutex);
 
-    impl->m_enabled = source.impl->m_enabled;
-    impl->m_verbosity_level = source.impl->m_verbosity_level;
+    impl->m_enabled = source.impl->m_enabled.load();
+    impl->m_verbosity_level = source.impl->m_verbosity_level.load();
 
     impl->m_targets.clear();
     for (const_each<Impl::LogTargetContainer> i = source.impl->m_targets; i; ++i)
@@ -260,6 +465,52 @@ void Logger::set_enabled(const bool enabled)
     impl->m_enabled = enabled;
 }
 
+void Logger::set_async(const bool async, const size_t queue_capacity)
+{
+    boost::mutex::scoped_lock lock(impl->m_async_mutex);
+
+    if (async == impl->m_async)
+        return;
+
+    if (async)
+    {
+        if (impl->m_queue == 0)
+            impl->m_queue = new Impl::AsyncMessageQueue(min(max<size_t>(queue_capacity, 1), MaxQueueCapacity));
+
+        impl->start_consumer();
+        impl->m_async = true;
+    }
+    else
+    {
+        impl->m_async = false;
+        impl->stop_consumer();
+
+        // Write messages pushed by threads that were already in write() when asynchronous mode was disabled.
+        impl->drain();
+    }
+}
+
+bool Logger::is_async() const
+{
+    return impl->m_async;
+}
+
+void Logger::flush()
+{
+    const uint64 pushed = impl->m_pushed_message_count;
+
+    while (impl->m_async && impl->m_written_message_count < pushed)
+        foundation::sleep(ConsumerSleepTime);
+
+    if (!impl->m_async)
+        impl->drain();
+}
+
+uint64 Logger::get_dropped_message_count() const
+{
+    return impl->m_dropped_message_count;
+}
+
 void Logger::set_verbosity_level(const LogMessage::Category level)
 {
     boost::mutex::scoped_lock lock(impl->m_mutex);
@@ -268,7 +519,6 @@ void Logger::set_verbosity_level(const LogMessage::Category level)
 
 LogMessage::Category Logger::get_verbosity_level() const
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
     return impl->m_verbosity_level;
 }
 
@@ -318,58 +568,53 @@ void Logger::remove_target(ILogTarget* target)
     impl->m_targets.remove(target);
 }
 
-namespace
-{
-    bool write_to_buffer(
-        vector<char>&   buffer,
-        const size_t    max_buffer_size,
-        const char*     format,
-        va_list         argptr)
-    {
-        while (true)
-        {
-            va_list argptr_copy;
-            va_copy(argptr_copy, argptr);
-
-            const size_t buffer_size = buffer.size();
-
-            const int result =
-                portable_vsnprintf(&buffer[0], buffer_size, format, argptr_copy);
-
-            if (result < 0)
-            {
-                sprintf(
-                    &buffer[0],
-                    "(failed to format message, format string is \"%s\".)",
-                    replace(format, "\n", "\\n").c_str());
-
-                return false;
-            }
-
-            const size_t needed_buffer_size = static_cast<size_t>(result) + 1;
-
-            if (needed_buffer_size <= buffer_size)
-                return true;
-
-            if (buffer_size >= max_buffer_size)
-                return false;
-
-            buffer.resize(min(needed_buffer_size, max_buffer_size));
-        }
-    }
-}
-
 void Logger::write(
     const LogMessage::Category          category,
     const char*                         file,
     const size_t                        line,
     APPLESEED_PRINTF_FMT const char*    format, ...)
 {
-    boost::mutex::scoped_lock lock(impl->m_mutex);
-
     if (category < impl->m_verbosity_level)
         return;
 
+    if (impl->m_async && category != LogMessage::Fatal)
+    {
+        if (!impl->m_enabled)
+            return;
+
+        // Format the message into a buffer owned by this thread.
+        vector<char> buffer(InitialBufferSize);
+        va_list argptr;
+        va_start(argptr, format);
+        const bool formatting_succeeded =
+            write_to_buffer(buffer, MaxBufferSize, format, argptr);
+        va_end(argptr);
+
+        AsyncMessage* message = new AsyncMessage();
+        message->m_category = formatting_succeeded ? category : LogMessage::Error;
+        message->m_file = file;
+        message->m_line = line;
+        message->m_datetime = microsec_clock::universal_time();
+        message->m_thread_id = boost::this_thread::get_id();
+        message->m_text = &buffer[0];
+
+        if (impl->m_queue->bounded_push(message))
+            ++impl->m_pushed_message_count;
+        else
+        {
+            ++impl->m_dropped_message_count;
+            delete message;
+        }
+
+        return;
+    }
+
+    // Make sure Fatal messages come after all queued messages.
+    if (impl->m_async)
+        flush();
+
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
     LogMessage::Category effective_category = category;
 
     if (impl->m_enabled)
@@ -379,34 +624,20 @@ void Logger::write(
         va_start(argptr, format);
         const bool formatting_succeeded =
             write_to_buffer(impl->m_message_buffer, MaxBufferSize, format, argptr);
+        va_end(argptr);
 
         // If formatting failed, print the message as an error.
         if (!formatting_succeeded)
             effective_category = LogMessage::Error;
 
-        // Retrieve the current UTC time.
-        const ptime datetime(microsec_clock::universal_time());
-
-        // Format the header and message.
-        const size_t thread = impl->m_thread_map.thread_id_to_int(boost::this_thread::get_id());
-        const FormatEvaluator format_evaluator(effective_category, datetime, thread, &impl->m_message_buffer[0]);
-        const string header = format_evaluator.evaluate(impl->m_formatter.get_header_format(effective_category));
-        const string message = format_evaluator.evaluate(impl->m_formatter.get_message_format(effective_category));
-
-        if (!message.empty())
-        {
-            // Send the header and message to all log targets.
-            for (const_each<Impl::LogTargetContainer> i = impl->m_targets; i; ++i)
-            {
-                ILogTarget* target = *i;
-                target->write(
-                    effective_category,
-                    file,
-                    line,
-                    header.c_str(),
-                    message.c_str());
-            }
-        }
+        // Format the header and message and send them to all log targets.
+        impl->dispatch(
+            effective_category,
+            file,
+            line,
+            microsec_clock::universal_time(),
+            boost::this_thread::get_id(),
+            &impl->m_message_buffer[0]);
     }
 
     // Terminate the application if the message category is 'Fatal'.
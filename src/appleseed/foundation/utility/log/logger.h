@@ -33,6 +33,7 @@
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/log/logmessage.h"
 
 // appleseed.main headers.
@@ -53,6 +54,13 @@ namespace foundation
 //
 // All methods of this class are thread-safe.
 //
+// By default, messages are formatted and written to the log targets by the thread
+// calling write(), under a lock. In asynchronous mode, write() only formats the
+// message text and pushes it into a bounded lock-free queue; a background thread
+// then formats headers and dispatches messages to the log targets. When the queue
+// is full, messages are dropped and counted. Fatal messages are always written
+// synchronously, after all queued messages.
+//
 
 class APPLESEED_DLLSYMBOL Logger
   : public NonCopyable
@@ -73,6 +81,17 @@ class APPLESEED_DLLSYMBOL Logger
     // Enable/disable logging.
     void set_enabled(const bool enabled = true);
 
+    // Enable/disable asynchronous logging. Disabling asynchronous logging
+    // waits until all queued messages have been written.
+    void set_async(const bool async = true, const size_t queue_capacity = 4096);
+    bool is_async() const;
+
+    // Wait until all queued messages have been written to the log targets.
+    void flush();
+
+    // Return the number of messages dropped because the queue was full.
+    uint64 get_dropped_message_count() const;
+
     // Set/get the verbosity level.
     void set_verbosity_level(const LogMessage::Category level);
     LogMessage::Category get_verbosity_level() const;
@@ -30,11 +30,20 @@
 // Interface header.
 #include "memory.h"
 
+// appleseed.foundation headers.
+#include "foundation/platform/thread.h"
+
 // appleseed.main headers.
 #include "main/allocator.h"
 
+// Platform headers.
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
 // Standard headers.
 #include <cstdlib>
+#include <map>
 
 using namespace std;
 
@@ -95,4 +104,149 @@ void aligned_free(void* aligned_ptr)
     log_deallocation(aligned_ptr);
 }
 
+
+
+//
+// Large pages related functions implementation.
+//
+
+namespace
+{
+    const size_t LargePageSize = 2 * 1024 * 1024;
+
+    // Number of large pages backing each block allocated with large_page_malloc().
+    boost::mutex g_large_page_mutex;
+    map<const void*, size_t> g_large_page_blocks;
+    size_t g_allocated_large_page_count = 0;
+
+    size_t large_page_count(const size_t size)
+    {
+        return (size + LargePageSize - 1) / LargePageSize;
+    }
+
+    void register_large_page_block(const void* ptr, const size_t page_count)
+    {
+        boost::mutex::scoped_lock lock(g_large_page_mutex);
+        g_large_page_blocks[ptr] = page_count;
+        g_allocated_large_page_count += page_count;
+    }
+
+    void unregister_large_page_block(const void* ptr)
+    {
+        boost::mutex::scoped_lock lock(g_large_page_mutex);
+        const map<const void*, size_t>::iterator i = g_large_page_blocks.find(ptr);
+        if (i != g_large_page_blocks.end())
+        {
+            g_allocated_large_page_count -= i->second;
+            g_large_page_blocks.erase(i);
+        }
+    }
+}
+
+size_t get_large_page_size()
+{
+    return LargePageSize;
+}
+
+void* large_page_malloc(const size_t size, size_t alignment)
+{
+#ifdef __linux__
+
+    assert(alignment <= LargePageSize);
+
+    if (size >= LargePageSize)
+    {
+        const size_t page_count = large_page_count(size);
+        const size_t mapped_size = page_count * LargePageSize;
+
+        // Try explicit huge pages first; this only succeeds if some were reserved.
+        void* ptr =
+            mmap(0, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (ptr == MAP_FAILED)
+        {
+            // Map one extra large page and trim the mapping to a large page boundary.
+            uint8* base = static_cast<uint8*>(
+                mmap(0, mapped_size + LargePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+
+            if (base == MAP_FAILED)
+            {
+                log_allocation_failure(mapped_size);
+                return 0;
+            }
+
+            uint8* aligned_base = align(base, LargePageSize);
+            const size_t head_size = aligned_base - base;
+            if (head_size > 0)
+                munmap(base, head_size);
+            munmap(aligned_base + mapped_size, LargePageSize - head_size);
+
+            // Request transparent huge pages; fall back to regular pages if they are disabled.
+            if (madvise(aligned_base, mapped_size, MADV_HUGEPAGE) == 0)
+                register_large_page_block(aligned_base, page_count);
+
+            ptr = aligned_base;
+        }
+        else register_large_page_block(ptr, page_count);
+
+        log_allocation(ptr, mapped_size);
+
+        return ptr;
+    }
+
+#endif
+
+    return aligned_malloc(size, alignment);
+}
+
+void large_page_free(void* ptr, const size_t size)
+{
+    assert(ptr);
+
+#ifdef __linux__
+
+    if (size >= LargePageSize)
+    {
+        unregister_large_page_block(ptr);
+        munmap(ptr, large_page_count(size) * LargePageSize);
+        log_deallocation(ptr);
+
+        return;
+    }
+
+#endif
+
+    aligned_free(ptr);
+}
+
+size_t advise_large_pages(const void* ptr, const size_t size)
+{
+#ifdef __linux__
+
+    const uint8* begin = align(static_cast<const uint8*>(ptr), LargePageSize);
+    const uint8* end = static_cast<const uint8*>(ptr) + size;
+
+    if (end < begin + LargePageSize)
+        return 0;
+
+    const size_t page_count = (end - begin) / LargePageSize;
+
+    if (madvise(const_cast<uint8*>(begin), page_count * LargePageSize, MADV_HUGEPAGE) != 0)
+        return 0;
+
+    return page_count;
+
+#else
+
+    return 0;
+
+#endif
+}
+
+size_t get_allocated_large_page_count()
+{
+    boost::mutex::scoped_lock lock(g_large_page_mutex);
+    return g_allocated_large_page_count;
+}
+
 }   // namespace foundation
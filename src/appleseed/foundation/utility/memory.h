@@ -65,6 +65,32 @@ void* aligned_malloc(const size_t size, size_t alignment);
 void aligned_free(void* aligned_ptr);
 
 
+//
+// Large pages related functions.
+//
+// On Linux, large memory blocks are backed by explicit huge pages when some are
+// reserved, and by transparent huge pages requested with madvise() otherwise.
+// On other platforms, and for blocks smaller than a large page, these functions
+// fall back to aligned_malloc() and aligned_free().
+//
+
+// Return the size of a large page, in bytes.
+size_t get_large_page_size();
+
+// Allocate memory backed by large pages when possible, on a specified alignment boundary.
+void* large_page_malloc(const size_t size, size_t alignment);
+
+// Free a block of memory that was allocated with large_page_malloc() with the same size.
+void large_page_free(void* ptr, const size_t size);
+
+// Ask for the large page aligned part of an existing block of memory to be backed by
+// large pages. Return the number of large pages covered by the request, 0 if none.
+size_t advise_large_pages(const void* ptr, const size_t size);
+
+// Return the number of large pages currently backing blocks allocated with large_page_malloc().
+size_t get_allocated_large_page_count();
+
+
 //
 // STL containers related functions.
 //
@@ -92,6 +118,11 @@ void clear_keep_memory(Container& container);
 template <typename Container>
 void shrink_to_fit(Container& container);
 
+// Ask for the storage of a contiguous container to be backed by large pages.
+// Return the number of large pages covered by the request, 0 if none.
+template <typename Container>
+size_t advise_large_pages(const Container& container);
+
 
 //
 // Utility classes to read/write typed data from/to unstructured memory blocks.
@@ -226,6 +257,15 @@ inline void shrink_to_fit(Container& container)
     Container(container).swap(container);
 }
 
+template <typename Container>
+inline size_t advise_large_pages(const Container& container)
+{
+    return
+        container.empty()
+            ? 0
+            : advise_large_pages(&container[0], container.size() * sizeof(container[0]));
+}
+
 
 //
 // MemoryReader class implementation.
@@ -0,0 +1,205 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "memorytracker.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/tss.hpp"
+
+// Standard headers.
+#include <cassert>
+#include <vector>
+
+using namespace std;
+
+namespace foundation
+{
+
+//
+// MemoryTracker class implementation.
+//
+
+namespace
+{
+    // The counters of a thread. They are only written by their thread; since memory
+    // may be released by another thread than the one that allocated it, individual
+    // counters may be negative, only their sum is meaningful.
+    struct ThreadCounters
+    {
+        boost::atomic<int64>    m_sizes[MemoryTracker::CategoryCount];
+
+        ThreadCounters()
+        {
+            for (size_t i = 0; i < MemoryTracker::CategoryCount; ++i)
+                m_sizes[i].store(0, boost::memory_order_relaxed);
+        }
+    };
+
+    // Thread counters are owned by their tracker, not by the thread that updates them.
+    void no_cleanup(ThreadCounters*)
+    {
+    }
+}
+
+struct MemoryTracker::Impl
+{
+    boost::thread_specific_ptr<ThreadCounters>  m_thread_counters;
+    boost::mutex                                m_mutex;
+    vector<ThreadCounters*>                     m_all_thread_counters;
+
+    Impl()
+      : m_thread_counters(&no_cleanup)
+    {
+    }
+
+    ~Impl()
+    {
+        for (size_t i = 0, e = m_all_thread_counters.size(); i < e; ++i)
+            delete m_all_thread_counters[i];
+    }
+
+    ThreadCounters& get_thread_counters()
+    {
+        ThreadCounters* counters = m_thread_counters.get();
+
+        if (counters == 0)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            counters = new ThreadCounters();
+            m_all_thread_counters.push_back(counters);
+            m_thread_counters.reset(counters);
+        }
+
+        return *counters;
+    }
+
+    void add(const Category category, const int64 bytes)
+    {
+        assert(category < CategoryCount);
+
+        boost::atomic<int64>& size = get_thread_counters().m_sizes[category];
+
+        // Only the calling thread writes its counters: a relaxed load and store suffice.
+        size.store(size.load(boost::memory_order_relaxed) + bytes, boost::memory_order_relaxed);
+    }
+};
+
+const char* MemoryTracker::get_category_name(const Category category)
+{
+    switch (category)
+    {
+      case Textures:        return "textures";
+      case Trees:           return "trees";
+      case Tessellations:   return "tessellations";
+      case PhotonMaps:      return "photon maps";
+      case FrameBuffers:    return "frame buffers";
+      case ImageStacks:     return "image stacks";
+      default:              return "unknown";
+    }
+}
+
+MemoryTracker::MemoryTracker()
+  : impl(new Impl())
+{
+}
+
+MemoryTracker::~MemoryTracker()
+{
+    delete impl;
+}
+
+void MemoryTracker::allocate(const Category category, const size_t bytes)
+{
+    impl->add(category, static_cast<int64>(bytes));
+}
+
+void MemoryTracker::release(const Category category, const size_t bytes)
+{
+    impl->add(category, -static_cast<int64>(bytes));
+}
+
+uint64 MemoryTracker::get_size(const Category category) const
+{
+    assert(category < CategoryCount);
+
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    int64 size = 0;
+
+    for (size_t i = 0, e = impl->m_all_thread_counters.size(); i < e; ++i)
+        size += impl->m_all_thread_counters[i]->m_sizes[category].load(boost::memory_order_relaxed);
+
+    // The counters of the different threads are not read atomically as a whole.
+    return size > 0 ? static_cast<uint64>(size) : 0;
+}
+
+uint64 MemoryTracker::get_total_size() const
+{
+    uint64 size = 0;
+
+    for (size_t i = 0; i < CategoryCount; ++i)
+        size += get_size(static_cast<Category>(i));
+
+    return size;
+}
+
+Statistics MemoryTracker::get_statistics() const
+{
+    Statistics statistics;
+    uint64 total_size = 0;
+
+    for (size_t i = 0; i < CategoryCount; ++i)
+    {
+        const Category category = static_cast<Category>(i);
+        const uint64 size = get_size(category);
+        statistics.insert_size(get_category_name(category), size);
+        total_size += size;
+    }
+
+    statistics.insert_size("total", total_size);
+
+    return statistics;
+}
+
+namespace
+{
+    // Constructed at load time, before any thread may record allocations.
+    MemoryTracker g_global_memory_tracker;
+}
+
+MemoryTracker& global_memory_tracker()
+{
+    return g_global_memory_tracker;
+}
+
+}   // namespace foundation
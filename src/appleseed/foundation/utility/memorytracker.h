@@ -0,0 +1,186 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_FOUNDATION_UTILITY_MEMORYTRACKER_H
+#define APPLESEED_FOUNDATION_UTILITY_MEMORYTRACKER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/statistics.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+namespace foundation
+{
+
+//
+// An accounting of the memory used by the different subsystems of the renderer,
+// complementing the process-level numbers of foundation/utility/memory.h.
+//
+// Sizes are recorded per category into counters private to the calling thread,
+// so that recording never contends with other threads; the counters of all the
+// threads are merged when sizes are queried. Memory may be released by another
+// thread than the one that allocated it.
+//
+
+class APPLESEED_DLLSYMBOL MemoryTracker
+  : public NonCopyable
+{
+  public:
+    enum Category
+    {
+        Textures,
+        Trees,
+        Tessellations,
+        PhotonMaps,
+        FrameBuffers,
+        ImageStacks,
+        CategoryCount
+    };
+
+    // Return the name of a category, e.g. "photon maps".
+    static const char* get_category_name(const Category category);
+
+    // Constructor.
+    MemoryTracker();
+
+    // Destructor.
+    ~MemoryTracker();
+
+    // Record the allocation or the release of a given amount of memory.
+    void allocate(const Category category, const size_t bytes);
+    void release(const Category category, const size_t bytes);
+
+    // Return the amount of memory currently used by a category, or by all of them.
+    uint64 get_size(const Category category) const;
+    uint64 get_total_size() const;
+
+    // Return the amount of memory used by each category, and in total.
+    Statistics get_statistics() const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+// Return the memory tracker used to instrument appleseed.
+APPLESEED_DLLSYMBOL MemoryTracker& global_memory_tracker();
+
+
+//
+// Track the memory used by an object over its lifetime: the size is released
+// when the tracked size is destroyed. Copies track the same size again.
+//
+
+class TrackedMemorySize
+{
+  public:
+    explicit TrackedMemorySize(
+        const MemoryTracker::Category   category,
+        MemoryTracker&                  tracker = global_memory_tracker());
+
+    TrackedMemorySize(const TrackedMemorySize& rhs);
+
+    ~TrackedMemorySize();
+
+    TrackedMemorySize& operator=(const TrackedMemorySize& rhs);
+
+    // Set or get the tracked size, in bytes.
+    void set(const size_t bytes);
+    size_t get() const;
+
+  private:
+    MemoryTracker*                      m_tracker;
+    MemoryTracker::Category             m_category;
+    size_t                              m_bytes;
+};
+
+
+//
+// TrackedMemorySize class implementation.
+//
+
+inline TrackedMemorySize::TrackedMemorySize(
+    const MemoryTracker::Category       category,
+    MemoryTracker&                      tracker)
+  : m_tracker(&tracker)
+  , m_category(category)
+  , m_bytes(0)
+{
+}
+
+inline TrackedMemorySize::TrackedMemorySize(const TrackedMemorySize& rhs)
+  : m_tracker(rhs.m_tracker)
+  , m_category(rhs.m_category)
+  , m_bytes(0)
+{
+    set(rhs.m_bytes);
+}
+
+inline TrackedMemorySize::~TrackedMemorySize()
+{
+    set(0);
+}
+
+inline TrackedMemorySize& TrackedMemorySize::operator=(const TrackedMemorySize& rhs)
+{
+    if (this != &rhs)
+    {
+        set(0);
+        m_tracker = rhs.m_tracker;
+        m_category = rhs.m_category;
+        set(rhs.m_bytes);
+    }
+
+    return *this;
+}
+
+inline void TrackedMemorySize::set(const size_t bytes)
+{
+    if (bytes > m_bytes)
+        m_tracker->allocate(m_category, bytes - m_bytes);
+    else if (bytes < m_bytes)
+        m_tracker->release(m_category, m_bytes - bytes);
+
+    m_bytes = bytes;
+}
+
+inline size_t TrackedMemorySize::get() const
+{
+    return m_bytes;
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_UTILITY_MEMORYTRACKER_H
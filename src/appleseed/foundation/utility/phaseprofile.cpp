@@ -0,0 +1,188 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "phaseprofile.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/system.h"
+#include "foundation/platform/timers.h"
+#include "foundation/utility/stopwatch.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+namespace foundation
+{
+
+//
+// PhaseProfile class implementation.
+//
+
+struct PhaseProfile::Impl
+{
+    struct Phase
+    {
+        string      m_name;
+        size_t      m_depth;
+        double      m_begin;
+        double      m_seconds;
+        uint64      m_peak_memory;
+    };
+
+    Stopwatch<DefaultWallclockTimer>    m_stopwatch;
+    vector<Phase>                       m_phases;
+    vector<size_t>                      m_open_phases;
+
+    double now()
+    {
+        return m_stopwatch.measure().get_seconds();
+    }
+};
+
+PhaseProfile::PhaseProfile()
+  : impl(new Impl())
+{
+    impl->m_stopwatch.start();
+}
+
+PhaseProfile::~PhaseProfile()
+{
+    delete impl;
+}
+
+void PhaseProfile::clear()
+{
+    impl->m_phases.clear();
+    impl->m_open_phases.clear();
+    impl->m_stopwatch.start();
+}
+
+void PhaseProfile::begin_phase(const char* name)
+{
+    assert(name);
+
+    Impl::Phase phase;
+    phase.m_name = name;
+    phase.m_depth = impl->m_open_phases.size();
+    phase.m_begin = impl->now();
+    phase.m_seconds = 0.0;
+    phase.m_peak_memory = 0;
+
+    impl->m_open_phases.push_back(impl->m_phases.size());
+    impl->m_phases.push_back(phase);
+}
+
+void PhaseProfile::end_phase()
+{
+    assert(!impl->m_open_phases.empty());
+
+    Impl::Phase& phase = impl->m_phases[impl->m_open_phases.back()];
+    phase.m_seconds = impl->now() - phase.m_begin;
+    phase.m_peak_memory = System::get_peak_process_memory_size();
+
+    impl->m_open_phases.pop_back();
+}
+
+void PhaseProfile::append(const PhaseProfile& profile)
+{
+    assert(&profile != this);
+
+    const size_t depth = impl->m_open_phases.size();
+
+    for (size_t i = 0, e = profile.impl->m_phases.size(); i < e; ++i)
+    {
+        Impl::Phase phase = profile.impl->m_phases[i];
+        phase.m_depth += depth;
+        impl->m_phases.push_back(phase);
+    }
+}
+
+size_t PhaseProfile::get_phase_count() const
+{
+    return impl->m_phases.size();
+}
+
+const char* PhaseProfile::get_phase_name(const size_t index) const
+{
+    assert(index < impl->m_phases.size());
+    return impl->m_phases[index].m_name.c_str();
+}
+
+size_t PhaseProfile::get_phase_depth(const size_t index) const
+{
+    assert(index < impl->m_phases.size());
+    return impl->m_phases[index].m_depth;
+}
+
+double PhaseProfile::get_phase_seconds(const size_t index) const
+{
+    assert(index < impl->m_phases.size());
+    return impl->m_phases[index].m_seconds;
+}
+
+uint64 PhaseProfile::get_phase_peak_memory(const size_t index) const
+{
+    assert(index < impl->m_phases.size());
+    return impl->m_phases[index].m_peak_memory;
+}
+
+string PhaseProfile::to_string() const
+{
+    // Compute the width of the name column.
+    size_t name_width = 0;
+    for (size_t i = 0, e = impl->m_phases.size(); i < e; ++i)
+    {
+        const Impl::Phase& phase = impl->m_phases[i];
+        name_width = max(name_width, 2 * phase.m_depth + phase.m_name.size());
+    }
+
+    stringstream sstr;
+
+    for (size_t i = 0, e = impl->m_phases.size(); i < e; ++i)
+    {
+        const Impl::Phase& phase = impl->m_phases[i];
+
+        if (i > 0)
+            sstr << endl;
+
+        const string name = string(2 * phase.m_depth, ' ') + phase.m_name;
+        sstr << "  " << name << string(name_width - name.size(), ' ');
+        sstr << "  " << pretty_time(phase.m_seconds);
+        sstr << "  (peak memory " << pretty_size(phase.m_peak_memory) << ")";
+    }
+
+    return sstr.str();
+}
+
+}   // namespace foundation
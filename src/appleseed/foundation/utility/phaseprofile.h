@@ -0,0 +1,125 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_FOUNDATION_UTILITY_PHASEPROFILE_H
+#define APPLESEED_FOUNDATION_UTILITY_PHASEPROFILE_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+
+namespace foundation
+{
+
+//
+// A tree of timed phases, such as the preparation steps of a render.
+//
+// For each phase, the profile records the wall clock time spent in the phase
+// and the peak memory usage of the process when the phase ended.
+//
+
+class APPLESEED_DLLSYMBOL PhaseProfile
+  : public NonCopyable
+{
+  public:
+    // Constructor.
+    PhaseProfile();
+
+    // Destructor.
+    ~PhaseProfile();
+
+    // Remove all phases and restart the clock.
+    void clear();
+
+    // Begin a phase nested in the current one, if any.
+    void begin_phase(const char* name);
+
+    // End the current phase.
+    void end_phase();
+
+    // Append the phases of another profile, nested in the current phase if any.
+    void append(const PhaseProfile& profile);
+
+    // Return the number of recorded phases, in the order they began.
+    size_t get_phase_count() const;
+
+    // Access the properties of a given phase.
+    const char* get_phase_name(const size_t index) const;
+    size_t get_phase_depth(const size_t index) const;
+    double get_phase_seconds(const size_t index) const;
+    uint64 get_phase_peak_memory(const size_t index) const;
+
+    // Return a human-readable representation of the phase tree.
+    std::string to_string() const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+
+//
+// Begin a phase on construction and end it on destruction.
+//
+
+class ScopedPhase
+  : public NonCopyable
+{
+  public:
+    ScopedPhase(PhaseProfile& profile, const char* name);
+    ~ScopedPhase();
+
+  private:
+    PhaseProfile& m_profile;
+};
+
+
+//
+// ScopedPhase class implementation.
+//
+
+inline ScopedPhase::ScopedPhase(PhaseProfile& profile, const char* name)
+  : m_profile(profile)
+{
+    m_profile.begin_phase(name);
+}
+
+inline ScopedPhase::~ScopedPhase()
+{
+    m_profile.end_phase();
+}
+
+}       // namespace foundation
+
+#endif  // !APPLESEED_FOUNDATION_UTILITY_PHASEPROFILE_H
@@ -31,18 +31,26 @@
 #include "searchpaths.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/string.h"
 
 // Boost headers.
+#include "boost/bind.hpp"
 #include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/path.hpp"
+#include "boost/system/error_code.hpp"
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
 
 // Standard headers.
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <iterator>
+#include <map>
+#include <set>
 #include <vector>
 
 using namespace std;
@@ -69,6 +77,113 @@ const char SearchPaths::osl_path_separator()
     return ':';
 }
 
+namespace
+{
+    // Check the existence of files on the file system.
+    struct FileSystemQuery
+    {
+        bool exists(const bf::path& filepath)
+        {
+            return bf::exists(filepath);
+        }
+    };
+
+    // The names of the entries of a directory, listed on first use.
+    class DirectoryListing
+      : public NonCopyable
+    {
+      public:
+        DirectoryListing()
+          : m_listed(false)
+        {
+        }
+
+        bool contains(const bf::path& directory, const string& name)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+
+            if (!m_listed)
+            {
+                list(directory);
+                m_listed = true;
+            }
+
+            return m_names.find(normalize(name)) != m_names.end();
+        }
+
+      private:
+        boost::mutex    m_mutex;
+        bool            m_listed;
+        set<string>     m_names;
+
+        static string normalize(const string& name)
+        {
+#if defined _WIN32 || defined __APPLE__
+            // These file systems are case-insensitive by default.
+            return lower_case(name);
+#else
+            return name;
+#endif
+        }
+
+        void list(const bf::path& directory)
+        {
+            // Directories that don't exist or can't be read have no entries.
+            boost::system::error_code ec;
+            bf::directory_iterator i(directory, ec), e;
+
+            while (!ec && i != e)
+            {
+                m_names.insert(normalize(i->path().filename().string()));
+                i.increment(ec);
+            }
+        }
+    };
+
+    // Check the existence of files by listing the directories that contain them.
+    // Each directory is listed once and may be queried from several threads.
+    class DirectoryListingQuery
+      : public NonCopyable
+    {
+      public:
+        ~DirectoryListingQuery()
+        {
+            for (const_each<ListingMap> i = m_listings; i; ++i)
+                delete i->second;
+        }
+
+        bool exists(const bf::path& filepath)
+        {
+            const bf::path filename = filepath.filename();
+
+            if (filename.empty() || filename == "." || filename == "..")
+                return bf::exists(filepath);
+
+            const bf::path directory = filepath.parent_path();
+
+            DirectoryListing* listing;
+
+            {
+                boost::mutex::scoped_lock lock(m_mutex);
+
+                DirectoryListing*& slot = m_listings[directory.string()];
+                if (slot == 0)
+                    slot = new DirectoryListing();
+
+                listing = slot;
+            }
+
+            return listing->contains(directory, filename.string());
+        }
+
+      private:
+        typedef map<string, DirectoryListing*> ListingMap;
+
+        boost::mutex    m_mutex;
+        ListingMap      m_listings;
+    };
+}
+
 struct SearchPaths::Impl
 {
     typedef vector<string> PathCollection;
@@ -77,6 +192,80 @@ struct SearchPaths::Impl
     PathCollection  m_explicit_paths;
     PathCollection  m_environment_paths;
     PathCollection  m_all_paths;
+
+    // Find a file in the search paths. Return true and set 'search_path' to the search path
+    // inside which the file was found, or to 0 if it was found in the root path; return false
+    // if the file was not found.
+    template <typename Query>
+    bool qualify(
+        Query&              query,
+        const bf::path&     fp,
+        bf::path&           qualified_fp,
+        const string*&      search_path_ptr) const
+    {
+        if (fp.is_absolute())
+            return false;
+
+        // Look in search paths.
+        for (PathCollection::const_reverse_iterator
+                i = m_all_paths.rbegin(), e = m_all_paths.rend(); i != e; ++i)
+        {
+            bf::path search_path(*i);
+
+            // Make the search path absolute if there is a root path.
+            if (!m_root_path.empty() && search_path.is_relative())
+                search_path = m_root_path / search_path;
+
+            qualified_fp = search_path / fp;
+
+            if (query.exists(qualified_fp))
+            {
+                qualified_fp.make_preferred();
+                search_path_ptr = &*i;
+                return true;
+            }
+        }
+
+        // Look in the root path if there is one.
+        if (!m_root_path.empty())
+        {
+            qualified_fp = m_root_path / fp;
+
+            if (query.exists(qualified_fp))
+            {
+                qualified_fp.make_preferred();
+                search_path_ptr = 0;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Qualify the files of indices thread_index, thread_index + thread_count, etc.
+    void qualify_files(
+        DirectoryListingQuery&  query,
+        const StringArray&      filepaths,
+        vector<string>&         qualified_filepaths,
+        vector<string>&         search_paths,
+        const size_t            thread_index,
+        const size_t            thread_count) const
+    {
+        for (size_t i = thread_index, e = filepaths.size(); i < e; i += thread_count)
+        {
+            const bf::path fp(filepaths[i]);
+            bf::path qualified_fp;
+            const string* search_path_ptr;
+
+            if (qualify(query, fp, qualified_fp, search_path_ptr))
+            {
+                qualified_filepaths[i] = qualified_fp.string();
+                if (search_path_ptr)
+                    search_paths[i] = *search_path_ptr;
+            }
+            else qualified_filepaths[i] = fp.string();
+        }
+    }
 };
 
 SearchPaths::SearchPaths()
@@ -238,50 +427,68 @@ void SearchPaths::do_qualify(const char* filepath, char** qualified_filepath_cst
     assert(filepath);
 
     const bf::path fp(filepath);
+    bf::path qualified_fp;
+    const string* search_path_ptr;
+    FileSystemQuery query;
 
-    if (!fp.is_absolute())
+    if (impl->qualify(query, fp, qualified_fp, search_path_ptr))
     {
-        // Look in search paths.
-        for (Impl::PathCollection::const_reverse_iterator
-                i = impl->m_all_paths.rbegin(), e = impl->m_all_paths.rend(); i != e; ++i)
-        {
-            bf::path search_path(*i);
+        *qualified_filepath_cstr = duplicate_string(qualified_fp.string().c_str());
+        if (search_path_cstr)
+            *search_path_cstr = search_path_ptr ? duplicate_string(search_path_ptr->c_str()) : 0;
+        return;
+    }
 
-            // Make the search path absolute if there is a root path.
-            if (has_root_path() && search_path.is_relative())
-                search_path = impl->m_root_path / search_path;
+    *qualified_filepath_cstr = duplicate_string(fp.string().c_str());
+    if (search_path_cstr)
+        *search_path_cstr = 0;
+}
 
-            bf::path qualified_fp = search_path / fp;
+void SearchPaths::qualify(
+    const StringArray&      filepaths,
+    StringArray&            qualified_filepaths,
+    StringArray&            search_paths,
+    const size_t            thread_count) const
+{
+    const size_t file_count = filepaths.size();
 
-            if (bf::exists(qualified_fp))
-            {
-                qualified_fp.make_preferred();
-                *qualified_filepath_cstr = duplicate_string(qualified_fp.string().c_str());
-                if (search_path_cstr)
-                    *search_path_cstr = duplicate_string(i->c_str());
-                return;
-            }
-        }
+    vector<string> qualified(file_count);
+    vector<string> found_in(file_count);
 
-        // Look in the root path if there is one.
-        if (has_root_path())
-        {
-            bf::path qualified_fp = impl->m_root_path / fp;
+    DirectoryListingQuery query;
+    const size_t effective_thread_count = max<size_t>(min(thread_count, file_count), 1);
 
-            if (bf::exists(qualified_fp))
-            {
-                qualified_fp.make_preferred();
-                *qualified_filepath_cstr = duplicate_string(qualified_fp.string().c_str());
-                if (search_path_cstr)
-                    *search_path_cstr = 0;
-                return;
-            }
+    if (effective_thread_count == 1)
+        impl->qualify_files(query, filepaths, qualified, found_in, 0, 1);
+    else
+    {
+        boost::thread_group threads;
+
+        for (size_t i = 0; i < effective_thread_count; ++i)
+        {
+            threads.create_thread(
+                boost::bind(
+                    &Impl::qualify_files,
+                    impl,
+                    boost::ref(query),
+                    boost::cref(filepaths),
+                    boost::ref(qualified),
+                    boost::ref(found_in),
+                    i,
+                    effective_thread_count));
         }
+
+        threads.join_all();
     }
 
-    *qualified_filepath_cstr = duplicate_string(fp.string().c_str());
-    if (search_path_cstr)
-        *search_path_cstr = 0;
+    qualified_filepaths.resize(file_count);
+    search_paths.resize(file_count);
+
+    for (size_t i = 0; i < file_count; ++i)
+    {
+        qualified_filepaths.set(i, qualified[i].c_str());
+        search_paths.set(i, found_in[i].c_str());
+    }
 }
 
 char* SearchPaths::do_to_string(const char separator, const bool reversed) const
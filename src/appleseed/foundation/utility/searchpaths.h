@@ -31,6 +31,7 @@
 #define APPLESEED_FOUNDATION_UTILITY_SEARCHPATHS_H
 
 // appleseed.foundation headers.
+#include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/string.h"
 
 // appleseed.main headers.
@@ -125,6 +126,16 @@ class APPLESEED_DLLSYMBOL SearchPaths
     std::string qualify(const std::string& filepath) const;
     void qualify(const std::string& filepath, std::string& qualified_filepath, std::string& search_path);
 
+    // Find several files in the search paths at once, using a given number of threads.
+    // Each candidate directory is listed once instead of checking the existence of every
+    // candidate file, which is much faster on network file systems. 'search_paths' receives
+    // the search path inside which each file was found, or an empty string.
+    void qualify(
+        const StringArray&      filepaths,
+        StringArray&            qualified_filepaths,
+        StringArray&            search_paths,
+        const size_t            thread_count = 1) const;
+
     // Return a string with all the search paths separated by the specified separator.
     // The second variant returns the search paths in reverse order.
     std::string to_string(const char separator) const;
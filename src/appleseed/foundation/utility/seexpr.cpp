@@ -29,6 +29,17 @@
 // Interface header.
 #include "seexpr.h"
 
+// appleseed.foundation headers.
+#include "foundation/utility/otherwise.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
 using namespace boost;
 using namespace std;
 
@@ -89,4 +100,675 @@ string SeExprFilePathExtractor::replace_paths(
     return regex_replace(expression, m_regex, formatter);
 }
 
+
+//
+// SeExprProgram class implementation.
+//
+
+namespace
+{
+    enum Opcode
+    {
+        OpPushConstant,             // operand: index of the constant
+        OpPushU,
+        OpPushV,
+        OpNegate,
+        OpAdd,
+        OpSubtract,
+        OpMultiply,
+        OpDivide,
+        OpPower,
+        OpMakeVector,
+        OpCall,                     // operand: function
+        OpTexture                   // operand: index of the texture path
+    };
+
+    enum Function
+    {
+        FuncAbs,
+        FuncCeil,
+        FuncFloor,
+        FuncSqrt,
+        FuncExp,
+        FuncLog,
+        FuncSin,
+        FuncCos,
+        FuncTan,
+        FuncMin,
+        FuncMax,
+        FuncPow,
+        FuncClamp,
+        FunctionCount
+    };
+
+    struct FunctionInfo
+    {
+        const char*     m_name;
+        size_t          m_arity;
+    };
+
+    const FunctionInfo Functions[FunctionCount] =
+    {
+        { "abs",    1 },
+        { "ceil",   1 },
+        { "floor",  1 },
+        { "sqrt",   1 },
+        { "exp",    1 },
+        { "log",    1 },
+        { "sin",    1 },
+        { "cos",    1 },
+        { "tan",    1 },
+        { "min",    2 },
+        { "max",    2 },
+        { "pow",    2 },
+        { "clamp",  3 }
+    };
+
+    // Deeper programs are rejected by the compiler.
+    const size_t MaxStackDepth = 32;
+
+    double call_function(const size_t function, const double* args)
+    {
+        switch (function)
+        {
+          case FuncAbs:     return std::abs(args[0]);
+          case FuncCeil:    return std::ceil(args[0]);
+          case FuncFloor:   return std::floor(args[0]);
+          case FuncSqrt:    return std::sqrt(args[0]);
+          case FuncExp:     return std::exp(args[0]);
+          case FuncLog:     return std::log(args[0]);
+          case FuncSin:     return std::sin(args[0]);
+          case FuncCos:     return std::cos(args[0]);
+          case FuncTan:     return std::tan(args[0]);
+          case FuncMin:     return std::min(args[0], args[1]);
+          case FuncMax:     return std::max(args[0], args[1]);
+          case FuncPow:     return std::pow(args[0], args[1]);
+          case FuncClamp:   return std::min(std::max(args[0], args[1]), args[2]);
+          assert_otherwise;
+        }
+
+        return 0.0;
+    }
+
+    // Return the number of values an instruction pops from the stack.
+    size_t get_arg_count(const Opcode opcode, const size_t operand)
+    {
+        switch (opcode)
+        {
+          case OpPushConstant:
+          case OpPushU:
+          case OpPushV:
+            return 0;
+
+          case OpNegate:
+            return 1;
+
+          case OpAdd:
+          case OpSubtract:
+          case OpMultiply:
+          case OpDivide:
+          case OpPower:
+          case OpTexture:
+            return 2;
+
+          case OpMakeVector:
+            return 3;
+
+          case OpCall:
+            return Functions[operand].m_arity;
+
+          assert_otherwise;
+        }
+
+        return 0;
+    }
+
+    // Apply an instruction that does not read variables or textures to its arguments.
+    Color3d apply(const Opcode opcode, const size_t operand, const Color3d* args)
+    {
+        Color3d result;
+
+        switch (opcode)
+        {
+          case OpNegate:
+            for (size_t i = 0; i < 3; ++i)
+                result[i] = -args[0][i];
+            break;
+
+          case OpAdd:
+            for (size_t i = 0; i < 3; ++i)
+                result[i] = args[0][i] + args[1][i];
+            break;
+
+          case OpSubtract:
+            for (size_t i = 0; i < 3; ++i)
+                result[i] = args[0][i] - args[1][i];
+            break;
+
+          case OpMultiply:
+            for (size_t i = 0; i < 3; ++i)
+                result[i] = args[0][i] * args[1][i];
+            break;
+
+          case OpDivide:
+            for (size_t i = 0; i < 3; ++i)
+                result[i] = args[0][i] / args[1][i];
+            break;
+
+          case OpPower:
+            for (size_t i = 0; i < 3; ++i)
+                result[i] = std::pow(args[0][i], args[1][i]);
+            break;
+
+          case OpMakeVector:
+            for (size_t i = 0; i < 3; ++i)
+                result[i] = args[i][0];
+            break;
+
+          case OpCall:
+            for (size_t i = 0; i < 3; ++i)
+            {
+                double component_args[3];
+                for (size_t j = 0; j < Functions[operand].m_arity; ++j)
+                    component_args[j] = args[j][i];
+                result[i] = call_function(operand, component_args);
+            }
+            break;
+
+          assert_otherwise;
+        }
+
+        return result;
+    }
+}
+
+class SeExprCompiler
+{
+  public:
+    SeExprCompiler(
+        const string&       expression,
+        SeExprProgram&      program)
+      : m_expression(expression)
+      , m_position(0)
+      , m_program(program)
+    {
+    }
+
+    bool compile(bool& is_vector)
+    {
+        if (!parse_expression(is_vector))
+            return false;
+
+        skip_whitespaces();
+
+        return m_position == m_expression.size() && get_max_stack_depth() <= MaxStackDepth;
+    }
+
+  private:
+    const string&           m_expression;
+    size_t                  m_position;
+    SeExprProgram&          m_program;
+
+    void skip_whitespaces()
+    {
+        while (m_position < m_expression.size() && isspace(static_cast<unsigned char>(m_expression[m_position])))
+            ++m_position;
+    }
+
+    // Consume a given character if it is the next one.
+    bool accept(const char c)
+    {
+        skip_whitespaces();
+
+        if (m_position < m_expression.size() && m_expression[m_position] == c)
+        {
+            ++m_position;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool parse_identifier(string& identifier)
+    {
+        skip_whitespaces();
+
+        const size_t begin = m_position;
+
+        while (m_position < m_expression.size() &&
+               (isalnum(static_cast<unsigned char>(m_expression[m_position])) || m_expression[m_position] == '_'))
+            ++m_position;
+
+        identifier = m_expression.substr(begin, m_position - begin);
+
+        return !identifier.empty() && !isdigit(static_cast<unsigned char>(identifier[0]));
+    }
+
+    bool parse_number(double& value)
+    {
+        skip_whitespaces();
+
+        const char* begin = m_expression.c_str() + m_position;
+
+        if (!isdigit(static_cast<unsigned char>(*begin)) && *begin != '.')
+            return false;
+
+        char* end;
+        value = strtod(begin, &end);
+
+        // Reject what strtod() accepts beyond SeExpr's decimal literals, such as hexadecimal numbers.
+        if (end == begin || strcspn(begin, "xX") < static_cast<size_t>(end - begin))
+            return false;
+
+        m_position += end - begin;
+
+        return true;
+    }
+
+    bool parse_string(string& value)
+    {
+        if (!accept('"'))
+            return false;
+
+        const size_t end = m_expression.find('"', m_position);
+
+        if (end == string::npos)
+            return false;
+
+        value = m_expression.substr(m_position, end - m_position);
+        m_position = end + 1;
+
+        return true;
+    }
+
+    // expression := term (('+' | '-') term)*
+    bool parse_expression(bool& is_vector)
+    {
+        if (!parse_term(is_vector))
+            return false;
+
+        while (true)
+        {
+            Opcode opcode;
+
+            if (accept('+'))
+                opcode = OpAdd;
+            else if (accept('-'))
+                opcode = OpSubtract;
+            else return true;
+
+            bool rhs_is_vector;
+            if (!parse_term(rhs_is_vector))
+                return false;
+
+            emit(opcode);
+            is_vector = is_vector || rhs_is_vector;
+        }
+    }
+
+    // term := unary (('*' | '/') unary)*
+    bool parse_term(bool& is_vector)
+    {
+        if (!parse_unary(is_vector))
+            return false;
+
+        while (true)
+        {
+            Opcode opcode;
+
+            if (accept('*'))
+                opcode = OpMultiply;
+            else if (accept('/'))
+                opcode = OpDivide;
+            else return true;
+
+            bool rhs_is_vector;
+            if (!parse_unary(rhs_is_vector))
+                return false;
+
+            emit(opcode);
+            is_vector = is_vector || rhs_is_vector;
+        }
+    }
+
+    // unary := '-' unary | power
+    // As in SeExpr, negation and exponentiation have the same right-associative precedence.
+    bool parse_unary(bool& is_vector)
+    {
+        if (accept('-'))
+        {
+            if (!parse_unary(is_vector))
+                return false;
+
+            emit(OpNegate);
+            return true;
+        }
+
+        return parse_power(is_vector);
+    }
+
+    // power := primary ('^' unary)?
+    bool parse_power(bool& is_vector)
+    {
+        if (!parse_primary(is_vector))
+            return false;
+
+        if (accept('^'))
+        {
+            bool rhs_is_vector;
+            if (!parse_unary(rhs_is_vector))
+                return false;
+
+            emit(OpPower);
+            is_vector = is_vector || rhs_is_vector;
+        }
+
+        return true;
+    }
+
+    // primary := number | '$u' | '$v' | '(' expression ')' | '[' expression ',' expression ',' expression ']' | call
+    bool parse_primary(bool& is_vector)
+    {
+        is_vector = false;
+
+        double value;
+        if (parse_number(value))
+        {
+            emit_constant(Color3d(value));
+            return true;
+        }
+
+        if (accept('$'))
+        {
+            string name;
+            if (!parse_identifier(name))
+                return false;
+
+            if (name == "u")
+                emit(OpPushU);
+            else if (name == "v")
+                emit(OpPushV);
+            else return false;
+
+            return true;
+        }
+
+        if (accept('('))
+            return parse_expression(is_vector) && accept(')');
+
+        if (accept('['))
+        {
+            for (size_t i = 0; i < 3; ++i)
+            {
+                bool component_is_vector;
+                if (i > 0 && !accept(','))
+                    return false;
+                if (!parse_expression(component_is_vector) || component_is_vector)
+                    return false;
+            }
+
+            if (!accept(']'))
+                return false;
+
+            emit(OpMakeVector);
+            is_vector = true;
+            return true;
+        }
+
+        string name;
+        if (parse_identifier(name) && accept('('))
+            return name == "texture" ? parse_texture_args(is_vector) : parse_function_args(name, is_vector);
+
+        return false;
+    }
+
+    bool parse_texture_args(bool& is_vector)
+    {
+        string path;
+        if (!parse_string(path) || path.empty())
+            return false;
+
+        for (size_t i = 0; i < 2; ++i)
+        {
+            bool arg_is_vector;
+            if (!accept(',') || !parse_expression(arg_is_vector) || arg_is_vector)
+                return false;
+        }
+
+        if (!accept(')'))
+            return false;
+
+        vector<string>& paths = m_program.m_texture_paths;
+        const size_t index = find(paths.begin(), paths.end(), path) - paths.begin();
+        if (index == paths.size())
+            paths.push_back(path);
+
+        emit(OpTexture, index);
+        is_vector = true;
+
+        return true;
+    }
+
+    bool parse_function_args(const string& name, bool& is_vector)
+    {
+        size_t function = 0;
+        while (function < FunctionCount && name != Functions[function].m_name)
+            ++function;
+
+        if (function == FunctionCount)
+            return false;
+
+        for (size_t i = 0; i < Functions[function].m_arity; ++i)
+        {
+            bool arg_is_vector;
+            if (i > 0 && !accept(','))
+                return false;
+            if (!parse_expression(arg_is_vector))
+                return false;
+            is_vector = is_vector || arg_is_vector;
+        }
+
+        if (!accept(')'))
+            return false;
+
+        emit(OpCall, function);
+
+        return true;
+    }
+
+    void emit_constant(const Color3d& value)
+    {
+        emit(OpPushConstant, m_program.m_constants.size());
+        m_program.m_constants.push_back(value);
+    }
+
+    void emit(const Opcode opcode, const size_t operand = 0)
+    {
+        vector<SeExprProgram::Instruction>& instructions = m_program.m_instructions;
+        const size_t arg_count = get_arg_count(opcode, operand);
+
+        // Fold instructions whose arguments are all constants, except texture lookups.
+        if (arg_count > 0 && opcode != OpTexture && instructions.size() >= arg_count)
+        {
+            const size_t first = instructions.size() - arg_count;
+
+            bool constant_args = true;
+            for (size_t i = first; i < instructions.size(); ++i)
+                constant_args = constant_args && instructions[i].m_opcode == OpPushConstant;
+
+            if (constant_args)
+            {
+                Color3d args[3];
+                for (size_t i = 0; i < arg_count; ++i)
+                    args[i] = m_program.m_constants[instructions[first + i].m_operand];
+
+                const Color3d result = apply(opcode, operand, args);
+
+                // The folded constants are always the last ones of the pool.
+                m_program.m_constants.resize(m_program.m_constants.size() - arg_count);
+                instructions.resize(first);
+
+                emit_constant(result);
+                return;
+            }
+        }
+
+        SeExprProgram::Instruction instruction;
+        instruction.m_opcode = static_cast<uint16>(opcode);
+        instruction.m_operand = static_cast<uint16>(operand);
+        instructions.push_back(instruction);
+    }
+
+    size_t get_max_stack_depth() const
+    {
+        const vector<SeExprProgram::Instruction>& instructions = m_program.m_instructions;
+
+        size_t depth = 0;
+        size_t max_depth = 0;
+
+        for (size_t i = 0; i < instructions.size(); ++i)
+        {
+            const Opcode opcode = static_cast<Opcode>(instructions[i].m_opcode);
+            depth -= get_arg_count(opcode, instructions[i].m_operand);
+            depth += 1;
+            max_depth = max(max_depth, depth);
+        }
+
+        assert(depth == 1);
+
+        return max_depth;
+    }
+};
+
+SeExprProgram::SeExprProgram()
+  : m_is_vector(false)
+{
+}
+
+bool SeExprProgram::compile(
+    const string&               expression,
+    const bool                  want_vector)
+{
+    m_instructions.clear();
+    m_constants.clear();
+    m_texture_paths.clear();
+    m_is_vector = false;
+
+    SeExprCompiler compiler(expression, *this);
+
+    if (!compiler.compile(m_is_vector) || (m_is_vector && !want_vector))
+    {
+        m_instructions.clear();
+        m_constants.clear();
+        m_texture_paths.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool SeExprProgram::is_constant() const
+{
+    return m_instructions.size() == 1 && m_instructions[0].m_opcode == OpPushConstant;
+}
+
+bool SeExprProgram::is_vector() const
+{
+    return m_is_vector;
+}
+
+const vector<string>& SeExprProgram::get_texture_paths() const
+{
+    return m_texture_paths;
+}
+
+Color3d SeExprProgram::evaluate(
+    const double                u,
+    const double                v,
+    const ITextureLookup*       texture_lookup) const
+{
+    assert(!m_instructions.empty());
+
+    Color3d stack[MaxStackDepth];
+    size_t top = 0;
+
+    for (size_t i = 0, e = m_instructions.size(); i < e; ++i)
+    {
+        const Opcode opcode = static_cast<Opcode>(m_instructions[i].m_opcode);
+        const size_t operand = m_instructions[i].m_operand;
+
+        switch (opcode)
+        {
+          case OpPushConstant:
+            stack[top++] = m_constants[operand];
+            break;
+
+          case OpPushU:
+            stack[top++] = Color3d(u);
+            break;
+
+          case OpPushV:
+            stack[top++] = Color3d(v);
+            break;
+
+          case OpTexture:
+            assert(texture_lookup);
+            --top;
+            stack[top - 1] = texture_lookup->lookup(operand, stack[top - 1][0], stack[top][0]);
+            break;
+
+          default:
+            {
+                const size_t arg_count = get_arg_count(opcode, operand);
+                top -= arg_count;
+                stack[top] = apply(opcode, operand, &stack[top]);
+                ++top;
+            }
+            break;
+        }
+    }
+
+    assert(top == 1);
+
+    return stack[0];
+}
+
+
+//
+// SeExprProgramCache class implementation.
+//
+
+SeExprProgramCache::ProgramPtr SeExprProgramCache::get(
+    const string&               expression,
+    const bool                  want_vector)
+{
+    const Key key(expression, want_vector);
+    const ProgramMap::const_iterator i = m_programs.find(key);
+
+    if (i != m_programs.end())
+        return i->second;
+
+    ProgramPtr program;
+
+    SeExprProgram* new_program = new SeExprProgram();
+    program.reset(new_program);
+
+    if (!new_program->compile(expression, want_vector))
+        program.reset();
+
+    m_programs[key] = program;
+
+    return program;
+}
+
+size_t SeExprProgramCache::size() const
+{
+    return m_programs.size();
+}
+
+void SeExprProgramCache::clear()
+{
+    m_programs.clear();
+}
+
 }   // namespace foundation
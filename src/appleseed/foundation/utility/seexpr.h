@@ -31,13 +31,18 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/color.h"
+#include "foundation/platform/types.h"
 
 // Boost headers.
 #include "boost/regex.hpp"
+#include "boost/shared_ptr.hpp"
 
 // Standard headers.
+#include <cstddef>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace foundation
@@ -68,6 +73,109 @@ class SeExprFilePathExtractor
     const boost::regex m_regex;
 };
 
+
+//
+// Compiles the subset of SeExpr used by most material expressions to a compact stack-based
+// bytecode program that is evaluated without walking an expression tree.
+//
+// The subset covers numbers, [x, y, z] vectors, the $u and $v variables, the + - * / ^
+// operators, parentheses, texture("path", u, v) lookups and the abs, ceil, floor, sqrt,
+// exp, log, sin, cos, tan, min, max, pow and clamp functions, applied component-wise.
+// Subexpressions that only involve constants are folded at compilation time.
+//
+// compile() fails on anything outside this subset so that callers can fall back to the
+// SeExpr interpreter. Scalars are stored replicated in the three components of values.
+//
+
+class SeExprProgram
+  : public NonCopyable
+{
+  public:
+    // Interface used to perform the texture lookups of a program.
+    class ITextureLookup
+    {
+      public:
+        virtual ~ITextureLookup() {}
+
+        // 'texture_index' is the index of the texture in get_texture_paths().
+        virtual Color3d lookup(
+            const size_t            texture_index,
+            const double            u,
+            const double            v) const = 0;
+    };
+
+    // Constructor.
+    SeExprProgram();
+
+    // Compile an expression. Return false if the expression is not part of the
+    // supported subset, or if it has a vector type while want_vector is false.
+    bool compile(
+        const std::string&          expression,
+        const bool                  want_vector);
+
+    // Return true if the program evaluates to a constant.
+    bool is_constant() const;
+
+    // Return true if the program evaluates to a vector.
+    bool is_vector() const;
+
+    // Return the paths of the textures looked up by the program.
+    const std::vector<std::string>& get_texture_paths() const;
+
+    // Evaluate the program.
+    Color3d evaluate(
+        const double                u,
+        const double                v,
+        const ITextureLookup*       texture_lookup = 0) const;
+
+  private:
+    friend class SeExprCompiler;
+
+    struct Instruction
+    {
+        uint16                      m_opcode;
+        uint16                      m_operand;
+    };
+
+    std::vector<Instruction>        m_instructions;
+    std::vector<Color3d>            m_constants;
+    std::vector<std::string>        m_texture_paths;
+    bool                            m_is_vector;
+};
+
+
+//
+// A cache of compiled SeExpr programs keyed by expression text.
+// Expressions that cannot be compiled are cached as null programs.
+//
+// This class is not thread-safe.
+//
+
+class SeExprProgramCache
+  : public NonCopyable
+{
+  public:
+    typedef boost::shared_ptr<const SeExprProgram> ProgramPtr;
+
+    // Return the program compiled from a given expression, or a null
+    // pointer if the expression cannot be compiled.
+    ProgramPtr get(
+        const std::string&          expression,
+        const bool                  want_vector);
+
+    // Return the number of cached expressions.
+    size_t size() const;
+
+    // Remove all programs from the cache.
+    void clear();
+
+  private:
+    typedef std::pair<std::string, bool> Key;
+    typedef std::map<Key, ProgramPtr> ProgramMap;
+
+    ProgramMap                      m_programs;
+};
+
 }       // namespace foundation
 
 #endif  // !APPLESEED_FOUNDATION_UTILITY_SEEXPR_H
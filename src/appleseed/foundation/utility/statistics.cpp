@@ -319,6 +319,28 @@ void StatisticsVector::merge(const NamedStatistics& other)
     m_stats.push_back(other);
 }
 
+void StatisticsVector::clear()
+{
+    m_stats.clear();
+}
+
+size_t StatisticsVector::size() const
+{
+    return m_stats.size();
+}
+
+const string& StatisticsVector::get_name(const size_t index) const
+{
+    assert(index < m_stats.size());
+    return m_stats[index].m_name;
+}
+
+const Statistics& StatisticsVector::get(const size_t index) const
+{
+    assert(index < m_stats.size());
+    return m_stats[index].m_stats;
+}
+
 string StatisticsVector::to_string(const size_t max_header_length) const
 {
     stringstream sstr;
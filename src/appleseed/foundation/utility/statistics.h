@@ -217,6 +217,13 @@ class Statistics
 
     void merge(const Statistics& other);
 
+    // Access the entries in the order they were inserted.
+    size_t size() const;
+    const Entry* get(const size_t index) const;
+
+    // Return the entry with a given name, or 0 if there is no such entry.
+    const Entry* find(const std::string& name) const;
+
     std::string to_string(const size_t max_header_length = 16) const;
 
   private:
@@ -248,6 +255,13 @@ class StatisticsVector
 
     void merge(const StatisticsVector& other);
 
+    void clear();
+
+    // Access the named statistics in the order they were inserted.
+    size_t size() const;
+    const std::string& get_name(const size_t index) const;
+    const Statistics& get(const size_t index) const;
+
     std::string to_string(const size_t max_header_length = 16) const;
 
   private:
@@ -393,6 +407,23 @@ void Statistics::insert_percent(
     insert(name, pretty_percent(numerator, denominator, precision));
 }
 
+inline size_t Statistics::size() const
+{
+    return m_entries.size();
+}
+
+inline const Statistics::Entry* Statistics::get(const size_t index) const
+{
+    assert(index < m_entries.size());
+    return m_entries[index];
+}
+
+inline const Statistics::Entry* Statistics::find(const std::string& name) const
+{
+    const EntryIndex::const_iterator i = m_index.find(name);
+    return i != m_index.end() ? i->second : 0;
+}
+
 
 //
 // Statistics::Entry class implementation.
@@ -31,6 +31,7 @@
 #define APPLESEED_RENDERER_API_FRAME_H
 
 // API headers.
+#include "renderer/modeling/frame/asyncframewriter.h"
 #include "renderer/modeling/frame/frame.h"
 
 #endif  // !APPLESEED_RENDERER_API_FRAME_H
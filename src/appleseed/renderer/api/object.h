@@ -31,6 +31,7 @@
 #define APPLESEED_RENDERER_API_OBJECT_H
 
 // API headers.
+#include "renderer/modeling/object/curvegenerator.h"
 #include "renderer/modeling/object/curveobject.h"
 #include "renderer/modeling/object/curveobjectreader.h"
 #include "renderer/modeling/object/curveobjectwriter.h"
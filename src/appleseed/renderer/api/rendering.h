@@ -31,18 +31,25 @@
 #define APPLESEED_RENDERER_API_RENDERING_H
 
 // API headers.
+#include "renderer/kernel/rendering/convergenceestimator.h"
+#include "renderer/kernel/rendering/convergencerenderercontroller.h"
 #include "renderer/kernel/rendering/debug/blanktilerenderer.h"
 #include "renderer/kernel/rendering/debug/debugtilerenderer.h"
 #include "renderer/kernel/rendering/defaultrenderercontroller.h"
+#include "renderer/kernel/rendering/framedenoiser.h"
 #include "renderer/kernel/rendering/generic/genericframerenderer.h"
 #include "renderer/kernel/rendering/generic/genericsamplerenderer.h"
 #include "renderer/kernel/rendering/generic/generictilerenderer.h"
 #include "renderer/kernel/rendering/iframerenderer.h"
+#include "renderer/kernel/rendering/iframesequence.h"
 #include "renderer/kernel/rendering/irenderercontroller.h"
 #include "renderer/kernel/rendering/isamplerenderer.h"
 #include "renderer/kernel/rendering/itilecallback.h"
 #include "renderer/kernel/rendering/itilerenderer.h"
+#include "renderer/kernel/rendering/itilesource.h"
+#include "renderer/kernel/rendering/liverenderstatistics.h"
 #include "renderer/kernel/rendering/masterrenderer.h"
+#include "renderer/kernel/rendering/memorylimitpolicy.h"
 #include "renderer/kernel/rendering/nulltilecallback.h"
 #include "renderer/kernel/rendering/progressive/progressiveframerenderer.h"
 #include "renderer/kernel/rendering/scenepicker.h"
@@ -37,5 +37,6 @@
 #include "renderer/modeling/texture/texture.h"
 #include "renderer/modeling/texture/texturefactoryregistrar.h"
 #include "renderer/modeling/texture/texturetraits.h"
+#include "renderer/modeling/texture/udimtexture2d.h"
 
 #endif  // !APPLESEED_RENDERER_API_TEXTURE_H
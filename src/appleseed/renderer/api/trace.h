@@ -31,6 +31,8 @@
 #define APPLESEED_RENDERER_API_TRACE_H
 
 // API headers.
+#include "renderer/kernel/intersection/iintersectionbackend.h"
+#include "renderer/kernel/intersection/intersectionbackendregistrar.h"
 #include "renderer/kernel/intersection/tracecontext.h"
 #include "renderer/kernel/shading/shadingray.h"
 
@@ -35,6 +35,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/image/image.h"
+#include "foundation/utility/memorytracker.h"
 
 // Standard headers.
 #include <cassert>
@@ -63,6 +64,13 @@ struct ImageStack::Impl
     };
 
     vector<NamedImage>      m_images;
+
+    TrackedMemorySize       m_tracked_memory_size;
+
+    Impl()
+      : m_tracked_memory_size(MemoryTracker::ImageStacks)
+    {
+    }
 };
 
 ImageStack::ImageStack(
@@ -93,6 +101,7 @@ void ImageStack::clear()
         delete impl->m_images[i].m_image;
 
     impl->m_images.clear();
+    impl->m_tracked_memory_size.set(0);
 }
 
 bool ImageStack::empty() const
@@ -165,6 +174,10 @@ size_t ImageStack::append(
 
     impl->m_images.push_back(named_image);
 
+    impl->m_tracked_memory_size.set(
+        impl->m_tracked_memory_size.get() +
+        impl->m_canvas_width * impl->m_canvas_height * channel_count * Pixel::size(pixel_format));
+
     return aov_index;
 }
 
@@ -182,4 +195,14 @@ TileStack ImageStack::tiles(
     return tile_stack;
 }
 
+void ImageStack::compress_tiles(
+    const size_t            tile_x,
+    const size_t            tile_y)
+{
+    const size_t size = impl->m_images.size();
+
+    for (size_t i = 0; i < size; ++i)
+        impl->m_images[i].m_image->compress_tile(tile_x, tile_y);
+}
+
 }   // namespace renderer
@@ -95,6 +95,12 @@ class APPLESEED_DLLSYMBOL ImageStack
         const size_t                    tile_x,
         const size_t                    tile_y) const;
 
+    // Compress a given tile of all images in memory. The tiles are
+    // transparently decompressed the next time they are accessed.
+    void compress_tiles(
+        const size_t                    tile_x,
+        const size_t                    tile_y);
+
   private:
     struct Impl;
     Impl* impl;
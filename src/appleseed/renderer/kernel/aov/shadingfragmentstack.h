@@ -39,10 +39,13 @@
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/image/color.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
 
 // Standard headers.
 #include <cassert>
 #include <cstddef>
+#include <new>
 
 namespace renderer
 {
@@ -50,6 +53,9 @@ namespace renderer
 //
 // A small array of shading fragments.
 //
+// Only the fragments of the AOVs requested by the frame are constructed,
+// so shading results carry no per-sample cost when AOVs are disabled.
+//
 
 class ShadingFragmentStack
   : public foundation::NonCopyable
@@ -95,8 +101,11 @@ class ShadingFragmentStack
     AlphaProxy      m_alpha;
 
   private:
-    ShadingFragment m_fragments[MaxAOVCount];
     size_t          m_size;
+    APPLESEED_SIMD4_ALIGN foundation::uint8 m_storage[MaxAOVCount * sizeof(ShadingFragment)];
+
+    ShadingFragment* fragments();
+    const ShadingFragment* fragments() const;
 };
 
 
@@ -110,6 +119,20 @@ inline ShadingFragmentStack::ShadingFragmentStack(const size_t size)
   , m_size(size)
 {
     assert(size <= MaxAOVCount);
+
+    ShadingFragment* fragments = this->fragments();
+    for (size_t i = 0; i < size; ++i)
+        new (&fragments[i]) ShadingFragment();
+}
+
+inline ShadingFragment* ShadingFragmentStack::fragments()
+{
+    return reinterpret_cast<ShadingFragment*>(m_storage);
+}
+
+inline const ShadingFragment* ShadingFragmentStack::fragments() const
+{
+    return reinterpret_cast<const ShadingFragment*>(m_storage);
 }
 
 inline size_t ShadingFragmentStack::size() const
@@ -120,13 +143,13 @@ inline size_t ShadingFragmentStack::size() const
 inline ShadingFragment& ShadingFragmentStack::operator[](const size_t index)
 {
     assert(index < m_size);
-    return m_fragments[index];
+    return fragments()[index];
 }
 
 inline const ShadingFragment& ShadingFragmentStack::operator[](const size_t index) const
 {
     assert(index < m_size);
-    return m_fragments[index];
+    return fragments()[index];
 }
 
 inline ShadingFragmentStack& ShadingFragmentStack::operator+=(const ShadingFragmentStack& rhs)
@@ -134,7 +157,7 @@ inline ShadingFragmentStack& ShadingFragmentStack::operator+=(const ShadingFragm
     assert(m_size == rhs.m_size);
 
     for (size_t i = 0, e = m_size; i < e; ++i)
-        m_fragments[i] += rhs.m_fragments[i];
+        fragments()[i] += rhs.fragments()[i];
 
     return *this;
 }
@@ -142,7 +165,7 @@ inline ShadingFragmentStack& ShadingFragmentStack::operator+=(const ShadingFragm
 inline ShadingFragmentStack& ShadingFragmentStack::operator*=(const float rhs)
 {
     for (size_t i = 0, e = m_size; i < e; ++i)
-        m_fragments[i] *= rhs;
+        fragments()[i] *= rhs;
 
     return *this;
 }
@@ -150,13 +173,13 @@ inline ShadingFragmentStack& ShadingFragmentStack::operator*=(const float rhs)
 inline void ShadingFragmentStack::set(const size_t index, const ShadingFragment& rhs)
 {
     if (index < m_size)
-        m_fragments[index] = rhs;
+        fragments()[index] = rhs;
 }
 
 inline void ShadingFragmentStack::add(const size_t index, const ShadingFragment& rhs)
 {
     if (index < m_size)
-        m_fragments[index] += rhs;
+        fragments()[index] += rhs;
 }
 
 inline ShadingFragmentStack::ColorProxy::ColorProxy(ShadingFragmentStack& parent)
@@ -167,7 +190,7 @@ inline ShadingFragmentStack::ColorProxy::ColorProxy(ShadingFragmentStack& parent
 inline void ShadingFragmentStack::ColorProxy::set(const float val)
 {
     for (size_t i = 0, e = m_parent.m_size; i < e; ++i)
-        m_parent.m_fragments[i].m_color.set(val);
+        m_parent.fragments()[i].m_color.set(val);
 }
 
 inline ShadingFragmentStack::ColorProxy& ShadingFragmentStack::ColorProxy::operator=(const SpectrumStack& rhs)
@@ -175,7 +198,7 @@ inline ShadingFragmentStack::ColorProxy& ShadingFragmentStack::ColorProxy::opera
     assert(m_parent.m_size == rhs.size());
 
     for (size_t i = 0, e = m_parent.m_size; i < e; ++i)
-        m_parent.m_fragments[i].m_color = rhs[i];
+        m_parent.fragments()[i].m_color = rhs[i];
 
     return *this;
 }
@@ -183,7 +206,7 @@ inline ShadingFragmentStack::ColorProxy& ShadingFragmentStack::ColorProxy::opera
 inline ShadingFragmentStack::ColorProxy& ShadingFragmentStack::ColorProxy::operator*=(const float rhs)
 {
     for (size_t i = 0, e = m_parent.m_size; i < e; ++i)
-        m_parent.m_fragments[i].m_color *= rhs;
+        m_parent.fragments()[i].m_color *= rhs;
 
     return *this;
 }
@@ -196,13 +219,13 @@ inline ShadingFragmentStack::AlphaProxy::AlphaProxy(ShadingFragmentStack& parent
 inline void ShadingFragmentStack::AlphaProxy::set(const float val)
 {
     for (size_t i = 0, e = m_parent.m_size; i < e; ++i)
-        m_parent.m_fragments[i].m_alpha.set(val);
+        m_parent.fragments()[i].m_alpha.set(val);
 }
 
 inline ShadingFragmentStack::AlphaProxy& ShadingFragmentStack::AlphaProxy::operator*=(const float rhs)
 {
     for (size_t i = 0, e = m_parent.m_size; i < e; ++i)
-        m_parent.m_fragments[i].m_alpha *= rhs;
+        m_parent.fragments()[i].m_alpha *= rhs;
 
     return *this;
 }
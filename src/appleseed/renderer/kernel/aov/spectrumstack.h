@@ -36,10 +36,13 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
 
 // Standard headers.
 #include <cassert>
 #include <cstddef>
+#include <new>
 
 namespace renderer
 {
@@ -47,6 +50,8 @@ namespace renderer
 //
 // A small array of spectra.
 //
+// Only the first size() spectra are constructed.
+//
 
 class SpectrumStack
   : public foundation::NonCopyable
@@ -70,7 +75,12 @@ class SpectrumStack
 
   private:
     const size_t    m_size;
-    Spectrum        m_spectra[MaxAOVCount];
+    APPLESEED_SIMD4_ALIGN foundation::uint8 m_storage[MaxAOVCount * sizeof(Spectrum)];
+
+    void construct();
+
+    Spectrum* spectra();
+    const Spectrum* spectra() const;
 };
 
 
@@ -82,15 +92,34 @@ inline SpectrumStack::SpectrumStack(const size_t size)
   : m_size(size)
 {
     assert(size <= MaxAOVCount);
+    construct();
 }
 
 inline SpectrumStack::SpectrumStack(const size_t size, const float val)
   : m_size(size)
 {
     assert(size <= MaxAOVCount);
+    construct();
     set(val);
 }
 
+inline void SpectrumStack::construct()
+{
+    Spectrum* spectra = this->spectra();
+    for (size_t i = 0; i < m_size; ++i)
+        new (&spectra[i]) Spectrum();
+}
+
+inline Spectrum* SpectrumStack::spectra()
+{
+    return reinterpret_cast<Spectrum*>(m_storage);
+}
+
+inline const Spectrum* SpectrumStack::spectra() const
+{
+    return reinterpret_cast<const Spectrum*>(m_storage);
+}
+
 inline size_t SpectrumStack::size() const
 {
     return m_size;
@@ -99,19 +128,19 @@ inline size_t SpectrumStack::size() const
 inline void SpectrumStack::set(const float val)
 {
     for (size_t i = 0; i < m_size; ++i)
-        m_spectra[i].set(val);
+        spectra()[i].set(val);
 }
 
 inline Spectrum& SpectrumStack::operator[](const size_t index)
 {
     assert(index < m_size);
-    return m_spectra[index];
+    return spectra()[index];
 }
 
 inline const Spectrum& SpectrumStack::operator[](const size_t index) const
 {
     assert(index < m_size);
-    return m_spectra[index];
+    return spectra()[index];
 }
 
 inline SpectrumStack& SpectrumStack::operator+=(const SpectrumStack& rhs)
@@ -119,7 +148,7 @@ inline SpectrumStack& SpectrumStack::operator+=(const SpectrumStack& rhs)
     assert(m_size == rhs.m_size);
 
     for (size_t i = 0; i < m_size; ++i)
-        m_spectra[i] += rhs.m_spectra[i];
+        spectra()[i] += rhs.spectra()[i];
 
     return *this;
 }
@@ -127,7 +156,7 @@ inline SpectrumStack& SpectrumStack::operator+=(const SpectrumStack& rhs)
 inline SpectrumStack& SpectrumStack::operator*=(const Spectrum& rhs)
 {
     for (size_t i = 0; i < m_size; ++i)
-        m_spectra[i] *= rhs;
+        spectra()[i] *= rhs;
 
     return *this;
 }
@@ -135,7 +164,7 @@ inline SpectrumStack& SpectrumStack::operator*=(const Spectrum& rhs)
 inline SpectrumStack& SpectrumStack::operator*=(const float rhs)
 {
     for (size_t i = 0; i < m_size; ++i)
-        m_spectra[i] *= rhs;
+        spectra()[i] *= rhs;
 
     return *this;
 }
@@ -143,7 +172,7 @@ inline SpectrumStack& SpectrumStack::operator*=(const float rhs)
 inline void SpectrumStack::add(const size_t index, const Spectrum& rhs)
 {
     if (index < m_size)
-        m_spectra[index] += rhs;
+        spectra()[index] += rhs;
 }
 
 }       // namespace renderer
@@ -41,26 +41,39 @@
 #include "renderer/modeling/object/iregion.h"
 #include "renderer/modeling/object/meshobject.h"
 #include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/particleobject.h"
 #include "renderer/modeling/object/regionkit.h"
+#include "renderer/modeling/scene/archiveassembly.h"
 #include "renderer/modeling/scene/assemblyinstance.h"
 #include "renderer/modeling/scene/objectinstance.h"
 #include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/visibilityflags.h"
 #include "renderer/utility/bbox.h"
+#include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
 #include "foundation/math/beziercurve.h"
+#include "foundation/math/intersection/frustumaabb.h"
+#include "foundation/math/intersection/rayaabb.h"
 #include "foundation/math/permutation.h"
 #include "foundation/math/ray.h"
 #include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
 #include "foundation/platform/system.h"
 #include "foundation/platform/timers.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/alignedallocator.h"
+#include "foundation/utility/api/apistring.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/foreach.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/lazy.h"
 #include "foundation/utility/siphash.h"
 #include "foundation/utility/statistics.h"
+#include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
 
 // Standard headers.
@@ -68,7 +81,9 @@
 #include <cassert>
 #include <cstring>
 #include <set>
+#include <string>
 #include <utility>
+#include <vector>
 
 using namespace foundation;
 using namespace std;
@@ -81,8 +96,10 @@ namespace renderer
 //
 
 AssemblyTree::AssemblyTree(const Scene& scene)
-  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
+  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size(), true))
   , m_scene(scene)
+  , m_build_cost(0.0)
+  , m_use_region_trees(true)
 {
     update();
 }
@@ -94,8 +111,68 @@ AssemblyTree::~AssemblyTree()
 
 void AssemblyTree::update()
 {
-    rebuild_assembly_tree();
+    ScopedTraceEvent event("assembly tree update", "intersection");
+
+    const ParamArray& params = m_scene.get_parameters().child("acceleration_structure");
+
+    // Flushable assemblies are normally split by a region tree (a BSP tree) with one
+    // triangle tree per region tree leaf. They can instead get a single triangle tree
+    // over all their regions, like other assemblies. Child trees must be recreated if
+    // this choice changed.
+    const bool use_region_trees = params.get_optional<bool>("region_trees", true);
+    if (use_region_trees != m_use_region_trees)
+    {
+        for (const_each<AssemblyVersionMap> i = m_assembly_versions; i; ++i)
+            delete_child_trees(i->first);
+
+        m_assembly_versions.clear();
+        m_use_region_trees = use_region_trees;
+    }
+
+    // Refit the tree if only assembly instance transforms changed, rebuild it otherwise.
+    if (!refit_assembly_tree())
+        rebuild_assembly_tree();
+
     update_tree_hierarchy();
+
+    // Optionally build all child trees now instead of on first access during rendering.
+    if (params.get_optional<bool>("prebuild", false))
+    {
+        prebuild_child_trees(
+            params.get_optional<size_t>(
+                "prebuild_threads",
+                System::get_logical_cpu_core_count()));
+    }
+}
+
+void AssemblyTree::set_camera_frustum(const Frustum<double, 4>* frustum)
+{
+    const ParamArray& params = m_scene.get_parameters().child("acceleration_structure");
+    const bool camera_culling = frustum && params.get_optional<bool>("camera_culling", true);
+
+    size_t culled_instance_count = 0;
+
+    for (size_t i = 0; i < m_instances.size(); ++i)
+    {
+        Instance& instance = m_instances[i];
+        instance.m_vis_flags = instance.m_assembly_instance->get_vis_flags();
+
+        if (camera_culling && !intersect(*frustum, m_instance_bboxes[i]))
+        {
+            instance.m_vis_flags &= ~VisibilityFlags::CameraRay;
+            ++culled_instance_count;
+        }
+    }
+
+    compute_node_masks();
+
+    if (camera_culling)
+    {
+        RENDERER_LOG_DEBUG(
+            "%s out of %s outside of the camera frustum.",
+            pretty_int(culled_instance_count).c_str(),
+            plural(m_instances.size(), "assembly instance").c_str());
+    }
 }
 
 size_t AssemblyTree::get_memory_size() const
@@ -104,13 +181,19 @@ size_t AssemblyTree::get_memory_size() const
           TreeType::get_memory_size()
         - sizeof(*static_cast<const TreeType*>(this))
         + sizeof(*this)
-        + m_items.capacity() * sizeof(AssemblyInstance*)
+        + m_items.capacity() * sizeof(Item)
+        + m_instances.capacity() * sizeof(Instance)
+        + m_instance_bboxes.capacity() * sizeof(AABB3d)
+        + m_motion_segments.capacity() * sizeof(MotionSegment)
+        + m_item_ordering.capacity() * sizeof(size_t)
+        + m_item_instance_uids.capacity() * sizeof(UniqueID)
         + m_assembly_versions.size() * sizeof(pair<UniqueID, VersionID>);
 }
 
 void AssemblyTree::collect_assembly_instances(
     const AssemblyInstanceContainer&    assembly_instances,
     const TransformSequence&            parent_transform_seq,
+    ItemVector&                         items,
     AABBVector&                         assembly_instance_bboxes)
 {
     for (const_each<AssemblyInstanceContainer> i = assembly_instances; i; ++i)
@@ -130,6 +213,7 @@ void AssemblyTree::collect_assembly_instances(
         collect_assembly_instances(
             assembly.assembly_instances(),
             cumulated_transform_seq,
+            items,
             assembly_instance_bboxes);
 
         // Skip empty assemblies.
@@ -137,7 +221,7 @@ void AssemblyTree::collect_assembly_instances(
             continue;
 
         // Create and store an item for this assembly instance.
-        m_items.push_back(
+        items.push_back(
             Item(
                 &assembly,
                 &assembly_instance,
@@ -157,6 +241,11 @@ void AssemblyTree::rebuild_assembly_tree()
     // Clear the current tree.
     clear();
     m_items.clear();
+    m_instances.clear();
+    m_instance_bboxes.clear();
+    m_motion_segments.clear();
+    m_item_ordering.clear();
+    m_item_instance_uids.clear();
 
     Statistics statistics;
 
@@ -166,6 +255,7 @@ void AssemblyTree::rebuild_assembly_tree()
     collect_assembly_instances(
         m_scene.assembly_instances(),
         TransformSequence(),
+        m_items,
         assembly_instance_bboxes);
 
     RENDERER_LOG_INFO(
@@ -201,10 +291,31 @@ void AssemblyTree::rebuild_assembly_tree()
             &ordering[0],
             ordering.size());
 
-        // Store the items in the tree leaves whenever possible.
-        store_items_in_leaves(statistics);
+        // Keep the bounding boxes of the items in tree order to cull them later.
+        m_instance_bboxes.resize(ordering.size());
+        for (size_t i = 0; i < ordering.size(); ++i)
+            m_instance_bboxes[i] = assembly_instance_bboxes[ordering[i]];
+
+        // Keep the ordering to be able to refit the tree later.
+        m_item_ordering = ordering;
+        m_item_instance_uids.resize(m_items.size());
+        for (size_t i = 0; i < m_items.size(); ++i)
+            m_item_instance_uids[i] = m_items[i].m_assembly_instance->get_uid();
+
+        // Flatten the items into the array of instances used during traversal.
+        store_instances(statistics);
+
+        // Collapse the tree into a wide BVH.
+        collapse_assembly_tree(statistics);
     }
 
+    // Keep track of the cost of the tree to detect the degradation caused by refits.
+    const bvh::Refitter<AssemblyTree> refitter(
+        AssemblyTreeInteriorNodeTraversalCost,
+        AssemblyTreeTriangleIntersectionCost);
+    m_build_cost = refitter.compute_cost(*this, assembly_instance_bboxes);
+    statistics.insert("sah cost", m_build_cost);
+
     // Print assembly tree statistics.
     RENDERER_LOG_DEBUG("%s",
         StatisticsVector::make(
@@ -212,37 +323,181 @@ void AssemblyTree::rebuild_assembly_tree()
             statistics).to_string().c_str());
 }
 
-void AssemblyTree::store_items_in_leaves(Statistics& statistics)
+bool AssemblyTree::refit_assembly_tree()
 {
-    size_t leaf_count = 0;
-    size_t fat_leaf_count = 0;
+    // The tree must have been built before it can be refitted.
+    if (m_items.empty())
+        return false;
+
+    const ParamArray& params = m_scene.get_parameters().child("acceleration_structure");
+    if (!params.get_optional<bool>("refit", true))
+        return false;
 
-    const size_t node_count = m_nodes.size();
+    Statistics statistics;
 
-    for (size_t i = 0; i < node_count; ++i)
+    // Collect assembly instances and their bounding boxes.
+    ItemVector items;
+    AABBVector assembly_instance_bboxes;
+    collect_assembly_instances(
+        m_scene.assembly_instances(),
+        TransformSequence(),
+        items,
+        assembly_instance_bboxes);
+
+    // The topology of the tree can only be kept if the set of assembly instances is unchanged.
+    if (items.size() != m_items.size())
+        return false;
+
+    for (size_t i = 0; i < items.size(); ++i)
     {
-        NodeType& node = m_nodes[i];
+        const Item& item = items[m_item_ordering[i]];
 
-        if (node.is_leaf())
-        {
-            ++leaf_count;
+        if (item.m_assembly_instance->get_uid() != m_item_instance_uids[i] ||
+            item.m_assembly_uid != m_items[i].m_assembly_uid)
+            return false;
+    }
+
+    RENDERER_LOG_INFO(
+        "refitting assembly tree (%s %s)...",
+        pretty_int(items.size()).c_str(),
+        plural(items.size(), "assembly instance").c_str());
 
-            const size_t item_count = node.get_item_count();
+    // Store the items and their bounding boxes in tree order.
+    AABBVector ordered_bboxes(items.size());
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        m_items[i] = items[m_item_ordering[i]];
+        ordered_bboxes[i] = assembly_instance_bboxes[m_item_ordering[i]];
+    }
 
-            if (item_count <= NodeType::MaxUserDataSize / sizeof(Item))
-            {
-                ++fat_leaf_count;
+    // Refit the assembly tree.
+    bvh::Refitter<AssemblyTree> refitter(
+        AssemblyTreeInteriorNodeTraversalCost,
+        AssemblyTreeTriangleIntersectionCost);
+    refitter.refit<DefaultWallclockTimer>(*this, ordered_bboxes);
+    statistics.insert_time("refit time", refitter.get_refit_time());
+
+    // Rebuild the tree if its quality degraded too much.
+    const double cost = refitter.compute_cost(*this, ordered_bboxes);
+    const double max_cost_increase =
+        params.get_optional<double>("max_refit_cost_increase", AssemblyTreeDefaultMaxRefitCostIncrease);
+    statistics.insert("build sah cost", m_build_cost);
+    statistics.insert("sah cost", cost);
+    if (cost > m_build_cost * (1.0 + max_cost_increase))
+    {
+        RENDERER_LOG_INFO("refitted assembly tree is too inefficient, rebuilding it...");
+        return false;
+    }
 
-                const size_t item_begin = node.get_item_index();
-                Item* user_data = &node.get_user_data<Item>();
+    // Flatten the items into the array of instances used during traversal.
+    m_instance_bboxes.swap(ordered_bboxes);
+    store_instances(statistics);
 
-                for (size_t j = 0; j < item_count; ++j)
-                    user_data[j] = m_items[item_begin + j];
+    // Collapse the tree into a wide BVH.
+    collapse_assembly_tree(statistics);
+
+    // Print assembly tree statistics.
+    RENDERER_LOG_DEBUG("%s",
+        StatisticsVector::make(
+            "assembly tree statistics",
+            statistics).to_string().c_str());
+
+    return true;
+}
+
+namespace
+{
+    const ArchiveAssembly* get_deferred_archive(const Assembly& assembly)
+    {
+        const ArchiveAssembly* archive_assembly = dynamic_cast<const ArchiveAssembly*>(&assembly);
+        return archive_assembly && archive_assembly->is_deferred() ? archive_assembly : 0;
+    }
+}
+
+void AssemblyTree::store_instances(Statistics& statistics)
+{
+    const size_t item_count = m_items.size();
+
+    m_instances.resize(item_count);
+    m_motion_segments.clear();
+
+    size_t moving_instance_count = 0;
+
+    for (size_t i = 0; i < item_count; ++i)
+    {
+        const Item& item = m_items[i];
+        const TransformSequence& transform_seq = item.m_transform_sequence;
+
+        Instance& instance = m_instances[i];
+        instance.m_assembly = item.m_assembly;
+        instance.m_assembly_instance = item.m_assembly_instance;
+        instance.m_transform_sequence = &transform_seq;
+        instance.m_deferred_archive = get_deferred_archive(*item.m_assembly);
+        instance.m_assembly_uid = item.m_assembly_uid;
+        instance.m_assembly_instance_uid = item.m_assembly_instance->get_uid();
+        instance.m_vis_flags = item.m_assembly_instance->get_vis_flags();
+        instance.m_has_region_tree = m_use_region_trees && item.m_assembly->is_flushable();
+        instance.m_motion_segment_index = static_cast<uint32>(m_motion_segments.size());
+        instance.m_motion_segment_count = 0;
+
+        if (transform_seq.size() <= 1)
+        {
+            // Precompute the transform (and its inverse) of static instances.
+            instance.m_transform = transform_seq.evaluate(0.0f);
+            continue;
+        }
+
+        ++moving_instance_count;
+
+        // Bound moving instances separately over each motion segment.
+        const AABB3d local_bbox = item.m_assembly->compute_non_hierarchical_local_bbox();
+        const size_t segment_count = transform_seq.size() - 1;
+        for (size_t j = 0; j < segment_count; ++j)
+        {
+            float end_time;
+            Transformd end_transform;
+            transform_seq.get_transform(j + 1, end_time, end_transform);
+
+            MotionSegment segment;
+            segment.m_end_time = end_time;
+            segment.m_bbox = local_bbox;
+            if (local_bbox.is_valid())
+            {
+                segment.m_bbox = transform_seq.segment_to_parent(local_bbox, j);
+                segment.m_bbox.robust_grow(1.0e-15);
             }
+            m_motion_segments.push_back(segment);
         }
+
+        instance.m_motion_segment_count = static_cast<uint32>(segment_count);
     }
 
-    statistics.insert_percent("fat leaves", fat_leaf_count, leaf_count);
+    compute_node_masks();
+
+    statistics.insert_percent("moving instances", moving_instance_count, item_count);
+    statistics.insert("motion segments", m_motion_segments.size());
+}
+
+void AssemblyTree::compute_node_masks()
+{
+    // Compute the visibility masks of the nodes from the visibility flags of the instances.
+    vector<uint32> instance_vis_flags(m_instances.size());
+    for (size_t i = 0; i < m_instances.size(); ++i)
+        instance_vis_flags[i] = m_instances[i].m_vis_flags;
+
+    bvh::Masker<AssemblyTree> masker;
+    masker.compute_masks(*this, instance_vis_flags);
+}
+
+void AssemblyTree::collapse_assembly_tree(Statistics& statistics)
+{
+    if (m_scene.get_parameters().child("acceleration_structure").get_optional<bool>("wide_bvh", false))
+    {
+        bvh::Collapser<AssemblyTree> collapser;
+        collapser.collapse<DefaultWallclockTimer>(*this);
+        statistics.insert("wide nodes", m_wide_nodes.size());
+        statistics.insert_time("collapse time", collapser.get_collapse_time());
+    }
 }
 
 void AssemblyTree::update_tree_hierarchy()
@@ -351,10 +606,11 @@ namespace
 
             if (strcmp(object.get_model(), model) == 0)
             {
-                uint64 values[2 + 16];
+                uint64 values[3 + 16];
                 values[0] = hash;
                 values[1] = object.get_uid();
-                memcpy(&values[2], &i->get_transform().get_local_to_parent()[0], 16 * 8);
+                values[2] = i->get_curve_lod();
+                memcpy(&values[3], &i->get_transform().get_local_to_parent()[0], 16 * 8);
                 hash = siphash24(&values, sizeof(values));
             }
         }
@@ -408,7 +664,7 @@ void AssemblyTree::create_child_trees(const Assembly& assembly)
     // Create a region or a triangle tree if there are mesh objects.
     if (has_object_instances_of_type(assembly, MeshObjectFactory::get_model()))
     {
-        assembly.is_flushable()
+        m_use_region_trees && assembly.is_flushable()
             ? create_region_tree(assembly)
             : create_triangle_tree(assembly);
     }
@@ -416,6 +672,10 @@ void AssemblyTree::create_child_trees(const Assembly& assembly)
     // Create a curve tree if there are curve objects.
     if (has_object_instances_of_type(assembly, CurveObjectFactory::get_model()))
         create_curve_tree(assembly);
+
+    // Create a particle tree if there are particle objects.
+    if (has_object_instances_of_type(assembly, ParticleObjectFactory::get_model()))
+        create_particle_tree(assembly);
 }
 
 void AssemblyTree::create_region_tree(const Assembly& assembly)
@@ -499,11 +759,40 @@ void AssemblyTree::create_curve_tree(const Assembly& assembly)
     m_curve_trees.insert(make_pair(assembly.get_uid(), tree));
 }
 
+void AssemblyTree::create_particle_tree(const Assembly& assembly)
+{
+    const uint64 hash = hash_assembly_geometry(assembly, ParticleObjectFactory::get_model());
+    Lazy<ParticleTree>* tree = m_particle_tree_repository.acquire(hash);
+
+    if (tree == 0)
+    {
+        // Compute the assembly space bounding box of the assembly.
+        const GAABB3 assembly_bbox =
+            compute_parent_bbox<GAABB3>(
+                assembly.object_instances().begin(),
+                assembly.object_instances().end());
+
+        auto_ptr<ILazyFactory<ParticleTree> > particle_tree_factory(
+            new ParticleTreeFactory(
+                ParticleTree::Arguments(
+                    m_scene,
+                    assembly.get_uid(),
+                    assembly_bbox,
+                    assembly)));
+
+        tree = new Lazy<ParticleTree>(particle_tree_factory);
+        m_particle_tree_repository.insert(hash, tree);
+    }
+
+    m_particle_trees.insert(make_pair(assembly.get_uid(), tree));
+}
+
 void AssemblyTree::delete_child_trees(const UniqueID assembly_id)
 {
     delete_region_tree(assembly_id);
     delete_triangle_tree(assembly_id);
     delete_curve_tree(assembly_id);
+    delete_particle_tree(assembly_id);
 }
 
 void AssemblyTree::delete_region_tree(const UniqueID assembly_id)
@@ -536,6 +825,16 @@ void AssemblyTree::delete_curve_tree(const UniqueID assembly_id)
     }
 }
 
+void AssemblyTree::delete_particle_tree(const UniqueID assembly_id)
+{
+    const ParticleTreeContainer::iterator it = m_particle_trees.find(assembly_id);
+    if (it != m_particle_trees.end())
+    {
+        m_particle_tree_repository.release(it->second);
+        m_particle_trees.erase(it);
+    }
+}
+
 namespace
 {
     template <typename TreeType>
@@ -566,6 +865,191 @@ void AssemblyTree::update_triangle_trees()
     m_triangle_tree_repository.for_each(update_trees);
 }
 
+namespace
+{
+    // A job that builds a child tree ahead of rendering.
+    class ChildTreeBuildJob
+      : public IJob
+    {
+      public:
+        const string    m_name;
+        const size_t    m_primitive_count;      // used as an estimate of the build cost
+        double          m_build_time;           // in seconds
+
+        ChildTreeBuildJob(
+            const string&   name,
+            const size_t    primitive_count)
+          : m_name(name)
+          , m_primitive_count(primitive_count)
+          , m_build_time(0.0)
+        {
+        }
+    };
+
+    template <typename TreeType>
+    class LazyChildTreeBuildJob
+      : public ChildTreeBuildJob
+    {
+      public:
+        LazyChildTreeBuildJob(
+            const string&       name,
+            const size_t        primitive_count,
+            Lazy<TreeType>&     tree)
+          : ChildTreeBuildJob(name, primitive_count)
+          , m_tree(tree)
+        {
+        }
+
+        virtual void execute(const size_t thread_index) APPLESEED_OVERRIDE
+        {
+            Stopwatch<DefaultWallclockTimer> stopwatch;
+            stopwatch.start();
+
+            // Accessing the lazy tree builds it if it wasn't already built.
+            const Access<TreeType> access(&m_tree);
+
+            m_build_time = stopwatch.measure().get_seconds();
+        }
+
+      private:
+        Lazy<TreeType>&         m_tree;
+    };
+
+    typedef vector<ChildTreeBuildJob*> ChildTreeBuildJobVector;
+
+    struct CompareBuildCosts
+    {
+        bool operator()(const ChildTreeBuildJob* lhs, const ChildTreeBuildJob* rhs) const
+        {
+            return lhs->m_primitive_count > rhs->m_primitive_count;
+        }
+    };
+
+    struct CompareBuildTimes
+    {
+        bool operator()(const ChildTreeBuildJob* lhs, const ChildTreeBuildJob* rhs) const
+        {
+            return lhs->m_build_time > rhs->m_build_time;
+        }
+    };
+
+    size_t count_primitives(const Assembly& assembly, const char* model)
+    {
+        size_t count = 0;
+
+        for (const_each<ObjectInstanceContainer> i = assembly.object_instances(); i; ++i)
+        {
+            const Object& object = i->get_object();
+
+            if (strcmp(object.get_model(), model) != 0)
+                continue;
+
+            if (strcmp(model, MeshObjectFactory::get_model()) == 0)
+                count += static_cast<const MeshObject&>(object).get_triangle_count();
+            else if (strcmp(model, ParticleObjectFactory::get_model()) == 0)
+                count += static_cast<const ParticleObject&>(object).get_particle_count();
+            else
+            {
+                const CurveObject& curve_object = static_cast<const CurveObject&>(object);
+                count += curve_object.get_curve1_count() + curve_object.get_curve3_count();
+            }
+        }
+
+        return count;
+    }
+
+    template <typename TreeType>
+    void collect_child_tree_build_job(
+        const Assembly&                             assembly,
+        const map<UniqueID, Lazy<TreeType>*>&       trees,
+        const char*                                 tree_type,
+        const char*                                 model,
+        set<const void*>&                           collected_trees,
+        ChildTreeBuildJobVector&                    jobs)
+    {
+        const typename map<UniqueID, Lazy<TreeType>*>::const_iterator i = trees.find(assembly.get_uid());
+
+        // Trees are shared between assemblies with identical geometry: only build them once.
+        if (i == trees.end() || !collected_trees.insert(i->second).second)
+            return;
+
+        jobs.push_back(
+            new LazyChildTreeBuildJob<TreeType>(
+                string(tree_type) + " of assembly \"" + assembly.get_path().c_str() + "\"",
+                count_primitives(assembly, model),
+                *i->second));
+    }
+}
+
+void AssemblyTree::prebuild_child_trees(const size_t thread_count)
+{
+    // Collect the child trees of all the assemblies of the scene.
+    AssemblyVector assemblies;
+    collect_unique_assemblies(assemblies);
+
+    set<const void*> collected_trees;
+    ChildTreeBuildJobVector jobs;
+
+    for (const_each<AssemblyVector> i = assemblies; i; ++i)
+    {
+        const Assembly& assembly = **i;
+        const char* mesh_model = MeshObjectFactory::get_model();
+        const char* curve_model = CurveObjectFactory::get_model();
+        const char* particle_model = ParticleObjectFactory::get_model();
+        collect_child_tree_build_job(assembly, m_region_trees, "region tree", mesh_model, collected_trees, jobs);
+        collect_child_tree_build_job(assembly, m_triangle_trees, "triangle tree", mesh_model, collected_trees, jobs);
+        collect_child_tree_build_job(assembly, m_curve_trees, "curve tree", curve_model, collected_trees, jobs);
+        collect_child_tree_build_job(assembly, m_particle_trees, "particle tree", particle_model, collected_trees, jobs);
+    }
+
+    if (jobs.empty())
+        return;
+
+    RENDERER_LOG_INFO(
+        "prebuilding %s child %s using %s %s...",
+        pretty_uint(jobs.size()).c_str(),
+        plural(jobs.size(), "tree").c_str(),
+        pretty_uint(thread_count).c_str(),
+        plural(thread_count, "thread").c_str());
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    // Schedule the most expensive trees first so that they don't end up
+    // being built on their own while the other threads are idle.
+    stable_sort(jobs.begin(), jobs.end(), CompareBuildCosts());
+
+    JobQueue job_queue;
+    for (const_each<ChildTreeBuildJobVector> i = jobs; i; ++i)
+        job_queue.schedule(*i, false);
+
+    // Build the trees.
+    {
+        JobManager job_manager(global_logger(), job_queue, thread_count);
+        job_manager.start();
+        job_queue.wait_until_completion();
+    }
+
+    const double total_time = stopwatch.measure().get_seconds();
+
+    // Report the slowest builds to help spotting pathological assets.
+    const size_t MaxReportedBuildCount = 10;
+    stable_sort(jobs.begin(), jobs.end(), CompareBuildTimes());
+
+    Statistics statistics;
+    statistics.insert_time("total time", total_time);
+    for (size_t i = 0; i < min(jobs.size(), MaxReportedBuildCount); ++i)
+        statistics.insert_time(jobs[i]->m_name, jobs[i]->m_build_time);
+
+    RENDERER_LOG_INFO("%s",
+        StatisticsVector::make(
+            "child trees prebuild statistics",
+            statistics).to_string().c_str());
+
+    for (const_each<ChildTreeBuildJobVector> i = jobs; i; ++i)
+        delete *i;
+}
+
 
 //
 // Utility function to transform a ray to the space of an assembly instance.
@@ -574,7 +1058,7 @@ void AssemblyTree::update_triangle_trees()
 namespace
 {
     void compute_assembly_instance_ray(
-        const AssemblyInstance&     assembly_instance,
+        const UniqueID              assembly_instance_uid,
         const Transformd&           assembly_instance_transform,
         const ShadingPoint*         parent_sp,
         const ShadingRay&           input_ray,
@@ -585,7 +1069,7 @@ namespace
 
         // Compute the ray origin in assembly instance space.
         if (parent_sp &&
-            parent_sp->get_assembly_instance().get_uid() == assembly_instance.get_uid() &&
+            parent_sp->get_assembly_instance().get_uid() == assembly_instance_uid &&
             parent_sp->get_object_instance().get_ray_bias_method() == ObjectInstance::RayBiasMethodNone)
         {
             // The caller provided the previous intersection, and we are about
@@ -617,6 +1101,48 @@ namespace
 }
 
 
+//
+// ProbeOccluder class implementation.
+//
+
+void ProbeOccluder::set(
+    const AssemblyInstance&             assembly_instance,
+    const Transformd&                   assembly_instance_transform,
+    const GTriangleType&                triangle,
+    const VisibilityFlags::Type         ray_flags)
+{
+    assert(ray_flags != 0);
+
+    m_assembly_instance_uid = assembly_instance.get_uid();
+    m_assembly_instance_transform = assembly_instance_transform;
+    m_triangle = triangle;
+    m_ray_flags = ray_flags;
+}
+
+bool ProbeOccluder::intersect(
+    const ShadingRay&                   ray,
+    const ShadingPoint*                 parent_shading_point) const
+{
+    // The occluder was recorded for a ray of a given type and would otherwise
+    // need to be checked against the visibility flags of the scene entities.
+    if (empty() || ray.m_flags != m_ray_flags)
+        return false;
+
+    // Transform the ray to assembly instance space.
+    ShadingRay local_ray;
+    compute_assembly_instance_ray(
+        m_assembly_instance_uid,
+        m_assembly_instance_transform,
+        parent_shading_point,
+        ray,
+        local_ray);
+
+    // Intersect the triangle.
+    const TriangleType triangle(m_triangle);
+    return triangle.intersect(TriangleType::RayType(local_ray));
+}
+
+
 //
 // AssemblyLeafVisitor class implementation.
 //
@@ -632,43 +1158,55 @@ bool AssemblyLeafVisitor::visit(
     )
 {
     // Retrieve the assembly instances for this leaf.
-    const size_t assembly_instance_index = node.get_item_index();
     const size_t assembly_instance_count = node.get_item_count();
-    const AssemblyTree::Item* items =
-        assembly_instance_count <= AssemblyTree::NodeType::MaxUserDataSize / sizeof(AssemblyTree::Item)
-            ? &node.get_user_data<AssemblyTree::Item>()     // items are stored in the leaf node
-            : &m_tree.m_items[assembly_instance_index];     // items are stored in the tree
+    const AssemblyTree::Instance* instances = &m_tree.m_instances[node.get_item_index()];
 
     for (size_t i = 0; i < assembly_instance_count; ++i)
     {
         // Retrieve the assembly instance.
-        const AssemblyTree::Item& item = items[i];
-        const AssemblyInstance& assembly_instance = *item.m_assembly_instance;
+        const AssemblyTree::Instance& item = instances[i];
 
         // Skip this assembly instance if it isn't visible for this ray.
-        if (!(assembly_instance.get_vis_flags() & ray.m_flags))
+        if (!(item.m_vis_flags & ray.m_flags))
+            continue;
+
+        // Skip this assembly instance if it is elsewhere at the time of the ray.
+        if (!m_tree.may_hit(item, ray, ray_info))
             continue;
 
         FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
 
+        // Retrieve the profiling counters of this assembly if this ray is profiled.
+        IntersectionProfiler::Counters* counters =
+            m_profiler ? &m_profiler->get_assembly_counters(*item.m_assembly) : 0;
+        bvh::TraversalCounters* traversal_counters = counters ? &counters->m_traversal : 0;
+
         // Evaluate the transformation of the assembly instance.
-        const TransformSequence* assembly_instance_transform_seq =
-            &item.m_transform_sequence;
         Transformd scratch;
         const Transformd& assembly_instance_transform =
-            assembly_instance_transform_seq->evaluate(ray.m_time.m_absolute, scratch);
+            AssemblyTree::evaluate_transform(item, ray.m_time.m_absolute, m_transform_cache, scratch);
 
         // Transform the ray to assembly instance space.
         ShadingPoint local_shading_point;
         compute_assembly_instance_ray(
-            assembly_instance,
+            item.m_assembly_instance_uid,
             assembly_instance_transform,
             m_parent_shading_point,
             ray,
             local_shading_point.m_ray);
         const RayInfo3d local_ray_info(local_shading_point.m_ray);
 
-        if (item.m_assembly->is_flushable())
+        // Deferred archive assemblies are loaded once a ray enters their bounding box.
+        if (item.m_deferred_archive)
+        {
+            if (intersect(local_shading_point.m_ray, local_ray_info, item.m_deferred_archive->get_deferred_bbox()))
+                item.m_deferred_archive->record_ray_entry();
+
+            if (!item.m_deferred_archive->is_expanded())
+                continue;
+        }
+
+        if (item.m_has_region_tree)
         {
             // Retrieve the region tree of this assembly.
             const RegionTree& region_tree =
@@ -703,7 +1241,7 @@ bool AssemblyLeafVisitor::visit(
             {
                 // Check the intersection between the ray and the triangle tree.
                 TriangleTreeIntersector intersector;
-                TriangleLeafVisitor visitor(*triangle_tree, local_shading_point);
+                TriangleLeafVisitor visitor(*triangle_tree, local_shading_point, counters);
                 if (triangle_tree->get_moving_triangle_count() > 0)
                 {
                     intersector.intersect_motion(
@@ -715,6 +1253,8 @@ bool AssemblyLeafVisitor::visit(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                         , m_triangle_tree_stats
 #endif
+                        , traversal_counters
+                        , local_shading_point.m_ray.m_flags
                         );
                 }
                 else
@@ -727,6 +1267,8 @@ bool AssemblyLeafVisitor::visit(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                         , m_triangle_tree_stats
 #endif
+                        , traversal_counters
+                        , local_shading_point.m_ray.m_flags
                         );
                 }
                 visitor.read_hit_triangle_data();
@@ -746,7 +1288,7 @@ bool AssemblyLeafVisitor::visit(
             const GRayInfo3 ray_info(local_ray_info);
             CurveMatrixType xfm_matrix;
             make_curve_projection_transform(xfm_matrix, ray);
-            CurveLeafVisitor visitor(*curve_tree, xfm_matrix, local_shading_point);
+            CurveLeafVisitor visitor(*curve_tree, xfm_matrix, local_shading_point, counters);
             CurveTreeIntersector intersector;
             intersector.intersect_no_motion(
                 *curve_tree,
@@ -756,6 +1298,32 @@ bool AssemblyLeafVisitor::visit(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                 , m_curve_tree_stats
 #endif
+                , traversal_counters
+                );
+        }
+
+        // Retrieve the particle tree of this assembly.
+        const ParticleTree* particle_tree =
+            m_particle_tree_cache.access(
+                item.m_assembly_uid,
+                m_tree.m_particle_trees);
+
+        if (particle_tree)
+        {
+            // Check the intersection between the ray and the particle tree.
+            const GRay3 ray(local_shading_point.m_ray);
+            const GRayInfo3 ray_info(local_ray_info);
+            ParticleLeafVisitor visitor(*particle_tree, local_shading_point);
+            ParticleTreeIntersector intersector;
+            intersector.intersect_no_motion(
+                *particle_tree,
+                ray,
+                ray_info,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , m_curve_tree_stats
+#endif
+                , traversal_counters
                 );
         }
 
@@ -767,7 +1335,7 @@ bool AssemblyLeafVisitor::visit(
             m_shading_point.m_bary = local_shading_point.m_bary;
             m_shading_point.m_assembly_instance = item.m_assembly_instance;
             m_shading_point.m_assembly_instance_transform = assembly_instance_transform;
-            m_shading_point.m_assembly_instance_transform_seq = assembly_instance_transform_seq;
+            m_shading_point.m_assembly_instance_transform_seq = item.m_transform_sequence;
             m_shading_point.m_object_instance_index = local_shading_point.m_object_instance_index;
             m_shading_point.m_region_index = local_shading_point.m_region_index;
             m_shading_point.m_primitive_index = local_shading_point.m_primitive_index;
@@ -797,39 +1365,54 @@ bool AssemblyLeafProbeVisitor::visit(
 {
     // Retrieve the assembly instances for this leaf.
     const size_t assembly_instance_count = node.get_item_count();
-    const AssemblyTree::Item* items =
-        assembly_instance_count <= AssemblyTree::NodeType::MaxUserDataSize / sizeof(AssemblyTree::Item)
-            ? &node.get_user_data<AssemblyTree::Item>()     // items are stored in the leaf node
-            : &m_tree.m_items[node.get_item_index()];       // items are stored in the tree
+    const AssemblyTree::Instance* instances = &m_tree.m_instances[node.get_item_index()];
 
     for (size_t i = 0; i < assembly_instance_count; ++i)
     {
         // Retrieve the assembly instance.
-        const AssemblyTree::Item& item = items[i];
-        const AssemblyInstance& assembly_instance = *item.m_assembly_instance;
+        const AssemblyTree::Instance& item = instances[i];
 
         // Skip this assembly instance if it isn't visible for this ray.
-        if (!(assembly_instance.get_vis_flags() & ray.m_flags))
+        if (!(item.m_vis_flags & ray.m_flags))
+            continue;
+
+        // Skip this assembly instance if it is elsewhere at the time of the ray.
+        if (!m_tree.may_hit(item, ray, ray_info))
             continue;
 
         FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
 
+        // Retrieve the profiling counters of this assembly if this ray is profiled.
+        IntersectionProfiler::Counters* counters =
+            m_profiler ? &m_profiler->get_assembly_counters(*item.m_assembly) : 0;
+        bvh::TraversalCounters* traversal_counters = counters ? &counters->m_traversal : 0;
+
         // Evaluate the transformation of the assembly instance.
         Transformd scratch;
         const Transformd& assembly_instance_transform =
-            item.m_transform_sequence.evaluate(ray.m_time.m_absolute, scratch);
+            AssemblyTree::evaluate_transform(item, ray.m_time.m_absolute, m_transform_cache, scratch);
 
         // Transform the ray to assembly instance space.
         ShadingRay local_ray;
         compute_assembly_instance_ray(
-            assembly_instance,
+            item.m_assembly_instance_uid,
             assembly_instance_transform,
             m_parent_shading_point,
             ray,
             local_ray);
         const RayInfo3d local_ray_info(local_ray);
 
-        if (item.m_assembly->is_flushable())
+        // Deferred archive assemblies are loaded once a ray enters their bounding box.
+        if (item.m_deferred_archive)
+        {
+            if (intersect(local_ray, local_ray_info, item.m_deferred_archive->get_deferred_bbox()))
+                item.m_deferred_archive->record_ray_entry();
+
+            if (!item.m_deferred_archive->is_expanded())
+                continue;
+        }
+
+        if (item.m_has_region_tree)
         {
             // Retrieve the region tree of this assembly.
             const RegionTree& region_tree =
@@ -854,6 +1437,10 @@ bool AssemblyLeafProbeVisitor::visit(
             // Terminate traversal if there was a hit.
             if (visitor.hit())
             {
+                // Region trees are not cached across probe rays.
+                if (m_occluder)
+                    m_occluder->clear();
+
                 m_hit = true;
                 return false;
             }
@@ -870,7 +1457,11 @@ bool AssemblyLeafProbeVisitor::visit(
             {
                 // Check the intersection between the ray and the triangle tree.
                 TriangleTreeProbeIntersector intersector;
-                TriangleLeafProbeVisitor visitor(*triangle_tree, local_ray.m_time.m_normalized, local_ray.m_flags);
+                TriangleLeafProbeVisitor visitor(
+                    *triangle_tree,
+                    local_ray.m_time.m_normalized,
+                    local_ray.m_flags,
+                    counters);
                 if (triangle_tree->get_moving_triangle_count() > 0)
                 {
                     intersector.intersect_motion(
@@ -882,6 +1473,8 @@ bool AssemblyLeafProbeVisitor::visit(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                         , m_triangle_tree_stats
 #endif
+                        , traversal_counters
+                        , local_ray.m_flags
                         );
                 }
                 else
@@ -894,12 +1487,24 @@ bool AssemblyLeafProbeVisitor::visit(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                         , m_triangle_tree_stats
 #endif
+                        , traversal_counters
+                        , local_ray.m_flags
                         );
                 }
 
                 // Terminate traversal if there was a hit.
                 if (visitor.hit())
                 {
+                    if (m_occluder)
+                    {
+                        // Only record static occluders.
+                        const GTriangleType* triangle = visitor.get_static_hit_triangle();
+                        if (triangle && item.m_motion_segment_count == 0)
+                            m_occluder->set(*item.m_assembly_instance, assembly_instance_transform, *triangle, ray.m_flags);
+                        else
+                            m_occluder->clear();
+                    }
+
                     m_hit = true;
                     return false;
                 }
@@ -919,7 +1524,7 @@ bool AssemblyLeafProbeVisitor::visit(
             const GRayInfo3 ray_info(local_ray_info);
             CurveMatrixType xfm_matrix;
             make_curve_projection_transform(xfm_matrix, ray);
-            CurveLeafProbeVisitor visitor(*curve_tree, xfm_matrix);
+            CurveLeafProbeVisitor visitor(*curve_tree, xfm_matrix, counters);
             CurveTreeProbeIntersector intersector;
             intersector.intersect_no_motion(
                 *curve_tree,
@@ -929,11 +1534,52 @@ bool AssemblyLeafProbeVisitor::visit(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                 , m_curve_tree_stats
 #endif
+                , traversal_counters
                 );
 
             // Terminate traversal if there was a hit.
             if (visitor.hit())
             {
+                // Curves are not cached across probe rays.
+                if (m_occluder)
+                    m_occluder->clear();
+
+                m_hit = true;
+                return false;
+            }
+        }
+
+        // Retrieve the particle tree of this assembly.
+        const ParticleTree* particle_tree =
+            m_particle_tree_cache.access(
+                item.m_assembly_uid,
+                m_tree.m_particle_trees);
+
+        if (particle_tree)
+        {
+            // Check intersection between ray and particle tree.
+            const GRay3 ray(local_ray);
+            const GRayInfo3 ray_info(local_ray_info);
+            ParticleLeafProbeVisitor visitor(*particle_tree);
+            ParticleTreeProbeIntersector intersector;
+            intersector.intersect_no_motion(
+                *particle_tree,
+                ray,
+                ray_info,
+                visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+                , m_curve_tree_stats
+#endif
+                , traversal_counters
+                );
+
+            // Terminate traversal if there was a hit.
+            if (visitor.hit())
+            {
+                // Particles are not cached across probe rays.
+                if (m_occluder)
+                    m_occluder->clear();
+
                 m_hit = true;
                 return false;
             }
@@ -32,6 +32,8 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/intersection/curvetree.h"
+#include "renderer/kernel/intersection/particletree.h"
+#include "renderer/kernel/intersection/intersectionprofiler.h"
 #include "renderer/kernel/intersection/probevisitorbase.h"
 #include "renderer/kernel/intersection/regiontree.h"
 #include "renderer/kernel/intersection/treerepository.h"
@@ -45,6 +47,10 @@
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/aabb.h"
 #include "foundation/math/bvh.h"
+#include "foundation/math/frustum.h"
+#include "foundation/math/intersection/rayaabb.h"
+#include "foundation/math/transform.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/alignedvector.h"
 #include "foundation/utility/uid.h"
 #include "foundation/utility/version.h"
@@ -56,6 +62,7 @@
 
 // Forward declarations.
 namespace foundation    { class Statistics; }
+namespace renderer      { class ArchiveAssembly; }
 namespace renderer      { class AssemblyInstance; }
 namespace renderer      { class Scene; }
 namespace renderer      { class ShadingPoint; }
@@ -84,6 +91,11 @@ class AssemblyTree
     // Update the assembly tree and all the child trees.
     void update();
 
+    // Let camera rays skip the assembly instances lying entirely outside of a world space
+    // frustum that encloses all camera rays, or stop culling them if 'frustum' is null.
+    // Culling is reset by update(). Must not be called while rays are being traced.
+    void set_camera_frustum(const foundation::Frustum<double, 4>* frustum);
+
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
 
@@ -113,13 +125,48 @@ class AssemblyTree
         }
     };
 
+    // Compact representation of an assembly instance, used during traversal. Instances
+    // are stored in tree order, so that the instances of a leaf are contiguous in memory.
+    struct Instance
+    {
+        foundation::Transformd                  m_transform;                // only valid for static instances
+        const renderer::Assembly*               m_assembly;
+        const renderer::AssemblyInstance*       m_assembly_instance;
+        const renderer::TransformSequence*      m_transform_sequence;
+        const renderer::ArchiveAssembly*        m_deferred_archive;         // only set for deferred archive assemblies
+        foundation::UniqueID                    m_assembly_uid;
+        foundation::UniqueID                    m_assembly_instance_uid;
+        VisibilityFlags::Type                   m_vis_flags;
+        bool                                    m_has_region_tree;
+        foundation::uint32                      m_motion_segment_index;
+        foundation::uint32                      m_motion_segment_count;     // 0 for static instances
+    };
+
+    // Bounding box of a moving assembly instance between two consecutive transforms.
+    struct MotionSegment
+    {
+        float                                   m_end_time;
+        foundation::AABB3d                      m_bbox;
+    };
+
     typedef std::vector<Item> ItemVector;
+    typedef std::vector<Instance> InstanceVector;
+    typedef std::vector<MotionSegment> MotionSegmentVector;
     typedef std::vector<foundation::AABB3d> AABBVector;
     typedef std::vector<const Assembly*> AssemblyVector;
     typedef std::map<foundation::UniqueID, foundation::VersionID> AssemblyVersionMap;
 
+    typedef std::vector<foundation::UniqueID> UniqueIDVector;
+
     const Scene&                    m_scene;
     ItemVector                      m_items;
+    InstanceVector                  m_instances;
+    AABBVector                      m_instance_bboxes;          // world space, in tree order
+    MotionSegmentVector             m_motion_segments;
+    std::vector<size_t>             m_item_ordering;
+    UniqueIDVector                  m_item_instance_uids;
+    double                          m_build_cost;
+    bool                            m_use_region_trees;
     AssemblyVersionMap              m_assembly_versions;
 
     TreeRepository<TriangleTree>    m_triangle_tree_repository;
@@ -131,13 +178,20 @@ class AssemblyTree
     TreeRepository<CurveTree>       m_curve_tree_repository;
     CurveTreeContainer              m_curve_trees;
 
+    TreeRepository<ParticleTree>    m_particle_tree_repository;
+    ParticleTreeContainer           m_particle_trees;
+
     void collect_assembly_instances(
         const AssemblyInstanceContainer&        assembly_instances,
         const TransformSequence&                parent_transform_seq,
+        ItemVector&                             items,
         AABBVector&                             assembly_instance_bboxes);
 
     void rebuild_assembly_tree();
-    void store_items_in_leaves(foundation::Statistics& statistics);
+    bool refit_assembly_tree();
+    void store_instances(foundation::Statistics& statistics);
+    void compute_node_masks();
+    void collapse_assembly_tree(foundation::Statistics& statistics);
 
     void update_tree_hierarchy();
     void collect_unique_assemblies(AssemblyVector& assemblies) const;
@@ -147,14 +201,31 @@ class AssemblyTree
     void create_region_tree(const Assembly& assembly);
     void create_triangle_tree(const Assembly& assembly);
     void create_curve_tree(const Assembly& assembly);
+    void create_particle_tree(const Assembly& assembly);
 
     void delete_child_trees(const foundation::UniqueID assembly_id);
     void delete_region_tree(const foundation::UniqueID assembly_id);
     void delete_triangle_tree(const foundation::UniqueID assembly_id);
     void delete_curve_tree(const foundation::UniqueID assembly_id);
+    void delete_particle_tree(const foundation::UniqueID assembly_id);
 
     void update_region_trees();
     void update_triangle_trees();
+
+    void prebuild_child_trees(const size_t thread_count);
+
+    // Return false if a ray cannot hit a given instance at the time of the ray.
+    bool may_hit(
+        const Instance&                         instance,
+        const ShadingRay&                       ray,
+        const ShadingRay::RayInfoType&          ray_info) const;
+
+    // Evaluate the transform of a given instance at a given time.
+    static const foundation::Transformd& evaluate_transform(
+        const Instance&                         instance,
+        const float                             time,
+        TransformSequenceCache&                 transform_cache,
+        foundation::Transformd&                 scratch);
 };
 
 
@@ -166,14 +237,17 @@ class AssemblyLeafVisitor
   : public foundation::NonCopyable
 {
   public:
-    // Constructor.
+    // Constructor. 'profiler' is null unless this ray is profiled.
     AssemblyLeafVisitor(
         ShadingPoint&                               shading_point,
         const AssemblyTree&                         tree,
         RegionTreeAccessCache&                      region_tree_cache,
         TriangleTreeAccessCache&                    triangle_tree_cache,
         CurveTreeAccessCache&                       curve_tree_cache,
-        const ShadingPoint*                         parent_shading_point
+        ParticleTreeAccessCache&                    particle_tree_cache,
+        TransformSequenceCache&                     transform_cache,
+        const ShadingPoint*                         parent_shading_point,
+        IntersectionProfiler*                       profiler
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , foundation::bvh::TraversalStatistics&     triangle_tree_stats
         , foundation::bvh::TraversalStatistics&     curve_tree_stats
@@ -197,7 +271,10 @@ class AssemblyLeafVisitor
     RegionTreeAccessCache&                          m_region_tree_cache;
     TriangleTreeAccessCache&                        m_triangle_tree_cache;
     CurveTreeAccessCache&                           m_curve_tree_cache;
+    ParticleTreeAccessCache&                        m_particle_tree_cache;
+    TransformSequenceCache&                         m_transform_cache;
     const ShadingPoint*                             m_parent_shading_point;
+    IntersectionProfiler*                           m_profiler;
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
     foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
@@ -205,6 +282,44 @@ class AssemblyLeafVisitor
 };
 
 
+//
+// A triangle that blocked a probe ray. Only static triangles of assembly instances
+// without transformation motion blur are recorded, so that the occluder can be
+// tested again by subsequent probe rays without traversing the scene.
+//
+
+class ProbeOccluder
+{
+  public:
+    // Constructor, creates an empty occluder.
+    ProbeOccluder();
+
+    // Return true if this occluder is empty.
+    bool empty() const;
+
+    // Make this occluder empty.
+    void clear();
+
+    // Record an occluder.
+    void set(
+        const AssemblyInstance&                     assembly_instance,
+        const foundation::Transformd&               assembly_instance_transform,
+        const GTriangleType&                        triangle,
+        const VisibilityFlags::Type                 ray_flags);
+
+    // Return true if a given world space probe ray hits this occluder.
+    bool intersect(
+        const ShadingRay&                           ray,
+        const ShadingPoint*                         parent_shading_point) const;
+
+  private:
+    foundation::UniqueID                            m_assembly_instance_uid;
+    foundation::Transformd                          m_assembly_instance_transform;
+    GTriangleType                                   m_triangle;
+    VisibilityFlags::Type                           m_ray_flags;
+};
+
+
 //
 // Assembly leaf visitor for probe rays, only return boolean answers
 // (whether an intersection was found or not).
@@ -214,13 +329,19 @@ class AssemblyLeafProbeVisitor
   : public ProbeVisitorBase
 {
   public:
-    // Constructor.
+    // Constructor. If 'occluder' is not null, it receives the triangle that
+    // blocked the ray, or is made empty if the ray was blocked by something
+    // that cannot be cached. 'profiler' is null unless this ray is profiled.
     AssemblyLeafProbeVisitor(
         const AssemblyTree&                         tree,
         RegionTreeAccessCache&                      region_tree_cache,
         TriangleTreeAccessCache&                    triangle_tree_cache,
         CurveTreeAccessCache&                       curve_tree_cache,
-        const ShadingPoint*                         parent_shading_point
+        ParticleTreeAccessCache&                    particle_tree_cache,
+        TransformSequenceCache&                     transform_cache,
+        const ShadingPoint*                         parent_shading_point,
+        ProbeOccluder*                              occluder,
+        IntersectionProfiler*                       profiler
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , foundation::bvh::TraversalStatistics&     triangle_tree_stats
         , foundation::bvh::TraversalStatistics&     curve_tree_stats
@@ -243,7 +364,117 @@ class AssemblyLeafProbeVisitor
     RegionTreeAccessCache&                          m_region_tree_cache;
     TriangleTreeAccessCache&                        m_triangle_tree_cache;
     CurveTreeAccessCache&                           m_curve_tree_cache;
+    ParticleTreeAccessCache&                        m_particle_tree_cache;
+    TransformSequenceCache&                         m_transform_cache;
     const ShadingPoint*                             m_parent_shading_point;
+    ProbeOccluder*                                  m_occluder;
+    IntersectionProfiler*                           m_profiler;
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
+    foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
+#endif
+};
+
+
+//
+// Assembly leaf visitor for packets of rays, used during packet traversal of the tree.
+// Leaves are intersected one ray at a time with an AssemblyLeafVisitor.
+//
+
+class AssemblyLeafPacketVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    AssemblyLeafPacketVisitor(
+        ShadingPoint* const                         shading_points[],
+        const AssemblyTree&                         tree,
+        RegionTreeAccessCache&                      region_tree_cache,
+        TriangleTreeAccessCache&                    triangle_tree_cache,
+        CurveTreeAccessCache&                       curve_tree_cache,
+        ParticleTreeAccessCache&                    particle_tree_cache,
+        TransformSequenceCache&                     transform_cache,
+        const ShadingPoint* const                   parent_shading_points[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     triangle_tree_stats
+        , foundation::bvh::TraversalStatistics&     curve_tree_stats
+#endif
+        );
+
+    // Visit a leaf with a given ray of the packet.
+    bool visit(
+        const AssemblyTree::NodeType&               node,
+        const size_t                                ray_index,
+        const ShadingRay&                           ray,
+        const ShadingRay::RayInfoType&              ray_info,
+        double&                                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     stats
+#endif
+        );
+
+  private:
+    ShadingPoint* const*                            m_shading_points;
+    const AssemblyTree&                             m_tree;
+    RegionTreeAccessCache&                          m_region_tree_cache;
+    TriangleTreeAccessCache&                        m_triangle_tree_cache;
+    CurveTreeAccessCache&                           m_curve_tree_cache;
+    ParticleTreeAccessCache&                        m_particle_tree_cache;
+    TransformSequenceCache&                         m_transform_cache;
+    const ShadingPoint* const*                      m_parent_shading_points;
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
+    foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
+#endif
+};
+
+
+//
+// Assembly leaf visitor for packets of probe rays, only return boolean answers
+// (whether an intersection was found or not for each ray).
+//
+
+class AssemblyLeafProbePacketVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. All entries of 'hits' must be initialized to false.
+    AssemblyLeafProbePacketVisitor(
+        bool                                        hits[],
+        const AssemblyTree&                         tree,
+        RegionTreeAccessCache&                      region_tree_cache,
+        TriangleTreeAccessCache&                    triangle_tree_cache,
+        CurveTreeAccessCache&                       curve_tree_cache,
+        ParticleTreeAccessCache&                    particle_tree_cache,
+        TransformSequenceCache&                     transform_cache,
+        const ShadingPoint* const                   parent_shading_points[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     triangle_tree_stats
+        , foundation::bvh::TraversalStatistics&     curve_tree_stats
+#endif
+        );
+
+    // Visit a leaf with a given ray of the packet.
+    bool visit(
+        const AssemblyTree::NodeType&               node,
+        const size_t                                ray_index,
+        const ShadingRay&                           ray,
+        const ShadingRay::RayInfoType&              ray_info,
+        double&                                     distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics&     stats
+#endif
+        );
+
+  private:
+    bool*                                           m_hits;
+    const AssemblyTree&                             m_tree;
+    RegionTreeAccessCache&                          m_region_tree_cache;
+    TriangleTreeAccessCache&                        m_triangle_tree_cache;
+    CurveTreeAccessCache&                           m_curve_tree_cache;
+    ParticleTreeAccessCache&                        m_particle_tree_cache;
+    TransformSequenceCache&                         m_transform_cache;
+    const ShadingPoint* const*                      m_parent_shading_points;
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     foundation::bvh::TraversalStatistics&           m_triangle_tree_stats;
     foundation::bvh::TraversalStatistics&           m_curve_tree_stats;
@@ -267,6 +498,55 @@ typedef foundation::bvh::Intersector<
     ShadingRay
 > AssemblyTreeProbeIntersector;
 
+typedef foundation::bvh::PacketIntersector<
+    AssemblyTree,
+    AssemblyLeafPacketVisitor,
+    ShadingRay
+> AssemblyTreePacketIntersector;
+
+typedef foundation::bvh::PacketIntersector<
+    AssemblyTree,
+    AssemblyLeafProbePacketVisitor,
+    ShadingRay
+> AssemblyTreeProbePacketIntersector;
+
+
+//
+// AssemblyTree class implementation.
+//
+
+inline bool AssemblyTree::may_hit(
+    const Instance&                                 instance,
+    const ShadingRay&                               ray,
+    const ShadingRay::RayInfoType&                  ray_info) const
+{
+    // Static instances are fully bounded by their leaf node.
+    if (instance.m_motion_segment_count == 0)
+        return true;
+
+    // Find the motion segment that contains the time of the ray.
+    const MotionSegment* segment = &m_motion_segments[instance.m_motion_segment_index];
+    const MotionSegment* last_segment = segment + instance.m_motion_segment_count - 1;
+    while (segment < last_segment && ray.m_time.m_absolute > segment->m_end_time)
+        ++segment;
+
+    return foundation::intersect(ray, ray_info, segment->m_bbox);
+}
+
+inline const foundation::Transformd& AssemblyTree::evaluate_transform(
+    const Instance&                                 instance,
+    const float                                     time,
+    TransformSequenceCache&                         transform_cache,
+    foundation::Transformd&                         scratch)
+{
+    if (instance.m_motion_segment_count == 0)
+        return instance.m_transform;
+
+    // Copy the transform out of the cache since its line may be evicted while the transform is in use.
+    scratch = transform_cache.evaluate(*instance.m_transform_sequence, time);
+    return scratch;
+}
+
 
 //
 // AssemblyLeafVisitor class implementation.
@@ -278,7 +558,10 @@ inline AssemblyLeafVisitor::AssemblyLeafVisitor(
     RegionTreeAccessCache&                          region_tree_cache,
     TriangleTreeAccessCache&                        triangle_tree_cache,
     CurveTreeAccessCache&                           curve_tree_cache,
-    const ShadingPoint*                             parent_shading_point
+    ParticleTreeAccessCache&                        particle_tree_cache,
+    TransformSequenceCache&                         transform_cache,
+    const ShadingPoint*                             parent_shading_point,
+    IntersectionProfiler*                           profiler
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     , foundation::bvh::TraversalStatistics&         triangle_tree_stats
     , foundation::bvh::TraversalStatistics&         curve_tree_stats
@@ -289,7 +572,10 @@ inline AssemblyLeafVisitor::AssemblyLeafVisitor(
   , m_region_tree_cache(region_tree_cache)
   , m_triangle_tree_cache(triangle_tree_cache)
   , m_curve_tree_cache(curve_tree_cache)
+  , m_particle_tree_cache(particle_tree_cache)
+  , m_transform_cache(transform_cache)
   , m_parent_shading_point(parent_shading_point)
+  , m_profiler(profiler)
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
   , m_triangle_tree_stats(triangle_tree_stats)
   , m_curve_tree_stats(curve_tree_stats)
@@ -298,6 +584,27 @@ inline AssemblyLeafVisitor::AssemblyLeafVisitor(
 }
 
 
+//
+// ProbeOccluder class implementation.
+//
+
+inline ProbeOccluder::ProbeOccluder()
+  : m_assembly_instance_uid(~foundation::UniqueID(0))
+  , m_ray_flags(0)
+{
+}
+
+inline bool ProbeOccluder::empty() const
+{
+    return m_ray_flags == 0;
+}
+
+inline void ProbeOccluder::clear()
+{
+    m_ray_flags = 0;
+}
+
+
 //
 // AssemblyLeafProbeVisitor class implementation.
 //
@@ -307,7 +614,11 @@ inline AssemblyLeafProbeVisitor::AssemblyLeafProbeVisitor(
     RegionTreeAccessCache&                          region_tree_cache,
     TriangleTreeAccessCache&                        triangle_tree_cache,
     CurveTreeAccessCache&                           curve_tree_cache,
-    const ShadingPoint*                             parent_shading_point
+    ParticleTreeAccessCache&                        particle_tree_cache,
+    TransformSequenceCache&                         transform_cache,
+    const ShadingPoint*                             parent_shading_point,
+    ProbeOccluder*                                  occluder,
+    IntersectionProfiler*                           profiler
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     , foundation::bvh::TraversalStatistics&         triangle_tree_stats
     , foundation::bvh::TraversalStatistics&         curve_tree_stats
@@ -317,7 +628,11 @@ inline AssemblyLeafProbeVisitor::AssemblyLeafProbeVisitor(
   , m_region_tree_cache(region_tree_cache)
   , m_triangle_tree_cache(triangle_tree_cache)
   , m_curve_tree_cache(curve_tree_cache)
+  , m_particle_tree_cache(particle_tree_cache)
+  , m_transform_cache(transform_cache)
   , m_parent_shading_point(parent_shading_point)
+  , m_occluder(occluder)
+  , m_profiler(profiler)
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
   , m_triangle_tree_stats(triangle_tree_stats)
   , m_curve_tree_stats(curve_tree_stats)
@@ -325,6 +640,157 @@ inline AssemblyLeafProbeVisitor::AssemblyLeafProbeVisitor(
 {
 }
 
+
+//
+// AssemblyLeafPacketVisitor class implementation.
+//
+
+inline AssemblyLeafPacketVisitor::AssemblyLeafPacketVisitor(
+    ShadingPoint* const                             shading_points[],
+    const AssemblyTree&                             tree,
+    RegionTreeAccessCache&                          region_tree_cache,
+    TriangleTreeAccessCache&                        triangle_tree_cache,
+    CurveTreeAccessCache&                           curve_tree_cache,
+    ParticleTreeAccessCache&                        particle_tree_cache,
+    TransformSequenceCache&                         transform_cache,
+    const ShadingPoint* const                       parent_shading_points[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&         triangle_tree_stats
+    , foundation::bvh::TraversalStatistics&         curve_tree_stats
+#endif
+    )
+  : m_shading_points(shading_points)
+  , m_tree(tree)
+  , m_region_tree_cache(region_tree_cache)
+  , m_triangle_tree_cache(triangle_tree_cache)
+  , m_curve_tree_cache(curve_tree_cache)
+  , m_particle_tree_cache(particle_tree_cache)
+  , m_transform_cache(transform_cache)
+  , m_parent_shading_points(parent_shading_points)
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+  , m_triangle_tree_stats(triangle_tree_stats)
+  , m_curve_tree_stats(curve_tree_stats)
+#endif
+{
+}
+
+inline bool AssemblyLeafPacketVisitor::visit(
+    const AssemblyTree::NodeType&                   node,
+    const size_t                                    ray_index,
+    const ShadingRay&                               ray,
+    const ShadingRay::RayInfoType&                  ray_info,
+    double&                                         distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&         stats
+#endif
+    )
+{
+    AssemblyLeafVisitor visitor(
+        *m_shading_points[ray_index],
+        m_tree,
+        m_region_tree_cache,
+        m_triangle_tree_cache,
+        m_curve_tree_cache,
+        m_particle_tree_cache,
+        m_transform_cache,
+        m_parent_shading_points ? m_parent_shading_points[ray_index] : 0,
+        0
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_triangle_tree_stats
+        , m_curve_tree_stats
+#endif
+        );
+
+    return
+        visitor.visit(
+            node,
+            ray,
+            ray_info,
+            distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+}
+
+
+//
+// AssemblyLeafProbePacketVisitor class implementation.
+//
+
+inline AssemblyLeafProbePacketVisitor::AssemblyLeafProbePacketVisitor(
+    bool                                            hits[],
+    const AssemblyTree&                             tree,
+    RegionTreeAccessCache&                          region_tree_cache,
+    TriangleTreeAccessCache&                        triangle_tree_cache,
+    CurveTreeAccessCache&                           curve_tree_cache,
+    ParticleTreeAccessCache&                        particle_tree_cache,
+    TransformSequenceCache&                         transform_cache,
+    const ShadingPoint* const                       parent_shading_points[]
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&         triangle_tree_stats
+    , foundation::bvh::TraversalStatistics&         curve_tree_stats
+#endif
+    )
+  : m_hits(hits)
+  , m_tree(tree)
+  , m_region_tree_cache(region_tree_cache)
+  , m_triangle_tree_cache(triangle_tree_cache)
+  , m_curve_tree_cache(curve_tree_cache)
+  , m_particle_tree_cache(particle_tree_cache)
+  , m_transform_cache(transform_cache)
+  , m_parent_shading_points(parent_shading_points)
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+  , m_triangle_tree_stats(triangle_tree_stats)
+  , m_curve_tree_stats(curve_tree_stats)
+#endif
+{
+}
+
+inline bool AssemblyLeafProbePacketVisitor::visit(
+    const AssemblyTree::NodeType&                   node,
+    const size_t                                    ray_index,
+    const ShadingRay&                               ray,
+    const ShadingRay::RayInfoType&                  ray_info,
+    double&                                         distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&         stats
+#endif
+    )
+{
+    AssemblyLeafProbeVisitor visitor(
+        m_tree,
+        m_region_tree_cache,
+        m_triangle_tree_cache,
+        m_curve_tree_cache,
+        m_particle_tree_cache,
+        m_transform_cache,
+        m_parent_shading_points ? m_parent_shading_points[ray_index] : 0,
+        0,
+        0
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_triangle_tree_stats
+        , m_curve_tree_stats
+#endif
+        );
+
+    const bool proceed =
+        visitor.visit(
+            node,
+            ray,
+            ray_info,
+            distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+            , stats
+#endif
+            );
+
+    if (visitor.hit())
+        m_hits[ray_index] = true;
+
+    return proceed;
+}
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_KERNEL_INTERSECTION_ASSEMBLYTREE_H
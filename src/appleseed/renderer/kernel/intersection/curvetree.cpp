@@ -41,13 +41,16 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/exceptions/exceptionnotimplemented.h"
+#include "foundation/math/aabb.h"
 #include "foundation/math/beziercurve.h"
+#include "foundation/math/minmax.h"
 #include "foundation/math/permutation.h"
 #include "foundation/math/transform.h"
 #include "foundation/platform/defaulttimers.h"
 #include "foundation/platform/system.h"
 #include "foundation/utility/alignedallocator.h"
 #include "foundation/utility/api/apistring.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/makevector.h"
 #include "foundation/utility/memory.h"
 #include "foundation/utility/statistics.h"
@@ -82,9 +85,11 @@ CurveTree::Arguments::Arguments(
 }
 
 CurveTree::CurveTree(const Arguments& arguments)
-  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
+  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size(), true))
   , m_arguments(arguments)
 {
+    ScopedTraceEvent event("curve tree build", "intersection");
+
     // Retrieve construction parameters.
     const MessageContext message_context(
         format("while building curve tree for assembly \"{0}\"", m_arguments.m_assembly.get_path()));
@@ -104,6 +109,7 @@ CurveTree::CurveTree(const Arguments& arguments)
 
     // Print curve tree statistics.
     statistics.insert_size("nodes alignment", alignment(&m_nodes[0]));
+    statistics.insert("large pages", advise_large_pages(m_nodes) + advise_large_pages(m_curves3));
     statistics.insert_time("total time", stopwatch.measure().get_seconds());
     RENDERER_LOG_DEBUG("%s",
         StatisticsVector::make(
@@ -111,8 +117,166 @@ CurveTree::CurveTree(const Arguments& arguments)
             statistics).to_string().c_str());
 }
 
-void CurveTree::collect_curves(vector<GAABB3>& curve_bboxes)
+namespace
+{
+    // Split a curve until the bounding boxes of its pieces have a much smaller
+    // surface area than the bounding box of the whole curve, which is typical of
+    // long, thin, diagonal curves. Each bounding box accounts for the width of
+    // its piece so that their union bounds the whole curve.
+    template <typename CurveType>
+    void compute_curve_bboxes(
+        const CurveType&        curve,
+        const size_t            max_split_count,
+        vector<GAABB3>&         bboxes)
+    {
+        // Only keep a split if it reduces the surface area of the bounds by at least this factor.
+        const GScalar SplitAreaRatio(0.7);
+
+        vector<CurveType> pieces(1, curve);
+        vector<GAABB3> piece_bboxes(1, curve.compute_bbox());
+        piece_bboxes[0].grow(GVector3(GScalar(0.5) * curve.compute_max_width()));
+
+        while (pieces.size() < max_split_count)
+        {
+            // Find the piece with the largest bounding box.
+            size_t largest = 0;
+            for (size_t i = 1; i < pieces.size(); ++i)
+            {
+                if (half_surface_area(piece_bboxes[i]) > half_surface_area(piece_bboxes[largest]))
+                    largest = i;
+            }
+
+            // Split it in two.
+            CurveType c1, c2;
+            pieces[largest].split(c1, c2);
+            GAABB3 c1_bbox = c1.compute_bbox();
+            c1_bbox.grow(GVector3(GScalar(0.5) * c1.compute_max_width()));
+            GAABB3 c2_bbox = c2.compute_bbox();
+            c2_bbox.grow(GVector3(GScalar(0.5) * c2.compute_max_width()));
+
+            if (half_surface_area(c1_bbox) + half_surface_area(c2_bbox) >
+                SplitAreaRatio * half_surface_area(piece_bboxes[largest]))
+                break;
+
+            pieces[largest] = c1;
+            piece_bboxes[largest] = c1_bbox;
+            pieces.push_back(c2);
+            piece_bboxes.push_back(c2_bbox);
+        }
+
+        bboxes.insert(bboxes.end(), piece_bboxes.begin(), piece_bboxes.end());
+    }
+
+    // Merge two connected curves into one curve following both. The end points and
+    // the end tangents are preserved, and the inner widths are the largest widths of
+    // the merged curves so that simplified strands do not get thinner.
+    Curve1Type merge_curves(const Curve1Type& c1, const Curve1Type& c2)
+    {
+        const GVector3 ctrl_pts[2] =
+        {
+            c1.get_control_point(0),
+            c2.get_control_point(1)
+        };
+
+        const GScalar width[2] =
+        {
+            c1.get_width(0),
+            c2.get_width(1)
+        };
+
+        return Curve1Type(ctrl_pts, width);
+    }
+
+    Curve3Type merge_curves(const Curve3Type& c1, const Curve3Type& c2)
+    {
+        const GVector3& p0 = c1.get_control_point(0);
+        const GVector3& p3 = c2.get_control_point(3);
+
+        // Each curve covers half of the parameter range of the merged curve.
+        const GVector3 ctrl_pts[4] =
+        {
+            p0,
+            p0 + GScalar(2.0) * (c1.get_control_point(1) - p0),
+            p3 + GScalar(2.0) * (c2.get_control_point(2) - p3),
+            p3
+        };
+
+        const GScalar width[4] =
+        {
+            c1.get_width(0),
+            max(c1.get_width(1), c1.get_width(2), c1.get_width(3)),
+            max(c2.get_width(0), c2.get_width(1), c2.get_width(2)),
+            c2.get_width(3)
+        };
+
+        return Curve3Type(ctrl_pts, width);
+    }
+
+    // Merge runs of up to 2^level connected curves of a curve object, in object space.
+    // Each resulting curve is stored with the index of the first curve of its run.
+    template <typename CurveType>
+    void simplify_curves(
+        const CurveType*        curves,
+        const size_t            curve_count,
+        const size_t            level,
+        vector<CurveType>&      simplified_curves,
+        vector<size_t>&         first_indices)
+    {
+        const size_t MaxRunLength = size_t(1) << level;
+
+        vector<CurveType> run;
+        run.reserve(MaxRunLength);
+
+        size_t i = 0;
+
+        while (i < curve_count)
+        {
+            first_indices.push_back(i);
+
+            // Gather connected curves.
+            run.clear();
+            run.push_back(curves[i++]);
+            while (i < curve_count &&
+                   run.size() < MaxRunLength &&
+                   curves[i].get_control_point(0) ==
+                   run.back().get_control_point(CurveType::Degree))
+                run.push_back(curves[i++]);
+
+            // Merge them pairwise to keep the parameterization balanced.
+            while (run.size() > 1)
+            {
+                size_t merged_count = 0;
+
+                for (size_t j = 0; j < run.size(); j += 2)
+                {
+                    run[merged_count++] =
+                        j + 1 < run.size()
+                            ? merge_curves(run[j], run[j + 1])
+                            : run[j];
+                }
+
+                run.resize(merged_count);
+            }
+
+            simplified_curves.push_back(run[0]);
+        }
+    }
+}
+
+size_t CurveTree::collect_curves(
+    const bool              split_curve_bounds,
+    vector<GAABB3>&         curve_bboxes,
+    size_t&                 original_curve_count)
 {
+    size_t curve_count = 0;
+    original_curve_count = 0;
+
+    vector<GAABB3> bboxes;
+    vector<Curve1Type> curves1;
+    vector<Curve3Type> curves3;
+    vector<size_t> curve1_indices;
+    vector<size_t> curve3_indices;
+
     const ObjectInstanceContainer& object_instances = m_arguments.m_assembly.object_instances();
 
     for (size_t i = 0; i < object_instances.size(); ++i)
@@ -134,46 +298,96 @@ void CurveTree::collect_curves(vector<GAABB3>& curve_bboxes)
         const Transformd::MatrixType& transform =
             object_instance->get_transform().get_local_to_parent();
 
+        // Merge the curves of the object according to the curve level of detail.
+        const size_t curve_lod = object_instance->get_curve_lod();
+        const size_t object_curve1_count = curve_object.get_curve1_count();
+        const size_t object_curve3_count = curve_object.get_curve3_count();
+        curves1.clear();
+        curves3.clear();
+        curve1_indices.clear();
+        curve3_indices.clear();
+        if (object_curve1_count > 0)
+        {
+            simplify_curves(
+                &curve_object.get_curve1(0),
+                object_curve1_count,
+                curve_lod,
+                curves1,
+                curve1_indices);
+        }
+        if (object_curve3_count > 0)
+        {
+            simplify_curves(
+                &curve_object.get_curve3(0),
+                object_curve3_count,
+                curve_lod,
+                curves3,
+                curve3_indices);
+        }
+
+        if (curve_lod > 0)
+        {
+            RENDERER_LOG_INFO(
+                "object instance \"%s\": rendering %s of %s curve segments (curve level of detail %s).",
+                object_instance->get_path().c_str(),
+                pretty_uint(curves1.size() + curves3.size()).c_str(),
+                pretty_uint(object_curve1_count + object_curve3_count).c_str(),
+                pretty_uint(curve_lod).c_str());
+        }
+
         // Store degree-1 curves, curve keys and curve bounding boxes.
-        const size_t curve1_count = curve_object.get_curve1_count();
-        for (size_t j = 0; j < curve1_count; ++j)
+        for (size_t j = 0; j < curves1.size(); ++j)
         {
-            const Curve1Type curve(curve_object.get_curve1(j), transform);
-            const CurveKey curve_key(
-                i,                  // object instance index
-                j,                  // curve index in object
-                m_curves1.size(),   // curve index in tree
-                0,                  // for now we assume all the curves have the same material
-                1);                 // curve degree
-
-            GAABB3 curve_bbox = curve.compute_bbox();
-            curve_bbox.grow(GVector3(GScalar(0.5) * curve.compute_max_width()));
-
-            m_curves1.push_back(curve);
-            m_curve_keys.push_back(curve_key);
-            curve_bboxes.push_back(curve_bbox);
+            const Curve1Type curve(curves1[j], transform);
+
+            bboxes.clear();
+            compute_curve_bboxes(curve, split_curve_bounds ? CurveTreeMaxCurveSplitCount : 1, bboxes);
+
+            // Store one copy of the curve per bounding box.
+            for (size_t k = 0; k < bboxes.size(); ++k)
+            {
+                const CurveKey curve_key(
+                    i,                  // object instance index
+                    curve1_indices[j],  // curve index in object
+                    m_curves1.size(),   // curve index in tree
+                    0,                  // for now we assume all the curves have the same material
+                    1);                 // curve degree
+
+                m_curves1.push_back(curve);
+                m_curve_keys.push_back(curve_key);
+                curve_bboxes.push_back(bboxes[k]);
+            }
         }
 
         // Store degree-3 curves, curve keys and curve bounding boxes.
-        const size_t curve3_count = curve_object.get_curve3_count();
-        for (size_t j = 0; j < curve3_count; ++j)
+        for (size_t j = 0; j < curves3.size(); ++j)
         {
-            const Curve3Type curve(curve_object.get_curve3(j), transform);
-            const CurveKey curve_key(
-                i,                  // object instance index
-                j,                  // curve index in object
-                m_curves3.size(),   // curve index in tree
-                0,                  // for now we assume all the curves have the same material
-                3);                 // curve degree
-
-            GAABB3 curve_bbox = curve.compute_bbox();
-            curve_bbox.grow(GVector3(GScalar(0.5) * curve.compute_max_width()));
-
-            m_curves3.push_back(curve);
-            m_curve_keys.push_back(curve_key);
-            curve_bboxes.push_back(curve_bbox);
+            const Curve3Type curve(curves3[j], transform);
+
+            bboxes.clear();
+            compute_curve_bboxes(curve, split_curve_bounds ? CurveTreeMaxCurveSplitCount : 1, bboxes);
+
+            // Store one copy of the curve per bounding box.
+            for (size_t k = 0; k < bboxes.size(); ++k)
+            {
+                const CurveKey curve_key(
+                    i,                  // object instance index
+                    curve3_indices[j],  // curve index in object
+                    m_curves3.size(),   // curve index in tree
+                    0,                  // for now we assume all the curves have the same material
+                    3);                 // curve degree
+
+                m_curves3.push_back(curve);
+                m_curve_keys.push_back(curve_key);
+                curve_bboxes.push_back(bboxes[k]);
+            }
         }
+
+        curve_count += curves1.size() + curves3.size();
+        original_curve_count += object_curve1_count + object_curve3_count;
     }
+
+    return curve_count;
 }
 
 void CurveTree::build_bvh(
@@ -186,15 +400,23 @@ void CurveTree::build_bvh(
         "collecting geometry for curve tree #" FMT_UNIQUE_ID " from assembly \"%s\"...",
         m_arguments.m_curve_tree_uid,
         m_arguments.m_assembly.get_path().c_str());
+    const bool split_curve_bounds = params.get_optional<bool>("split_curve_bounds", false);
     vector<GAABB3> curve_bboxes;
-    collect_curves(curve_bboxes);
+    size_t original_curve_count;
+    const size_t curve_count = collect_curves(split_curve_bounds, curve_bboxes, original_curve_count);
 
     // Print statistics about the input geometry.
     RENDERER_LOG_INFO(
         "building curve tree #" FMT_UNIQUE_ID " (bvh, %s %s)...",
         m_arguments.m_curve_tree_uid,
-        pretty_uint(m_curve_keys.size()).c_str(),
-        plural(m_curve_keys.size(), "curve").c_str());
+        pretty_uint(curve_count).c_str(),
+        plural(curve_count, "curve").c_str());
+
+    statistics.insert("original curves", original_curve_count);
+    statistics.insert("rendered curves", curve_count);
+
+    if (split_curve_bounds)
+        statistics.insert_percent("split curves", m_curve_keys.size() - curve_count, curve_count);
 
     // Create the partitioner.
     typedef bvh::SAHPartitioner<vector<GAABB3> > Partitioner;
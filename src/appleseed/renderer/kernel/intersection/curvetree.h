@@ -32,6 +32,7 @@
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/intersection/curvekey.h"
+#include "renderer/kernel/intersection/intersectionprofiler.h"
 #include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/intersection/probevisitorbase.h"
 #include "renderer/kernel/shading/shadingpoint.h"
@@ -47,6 +48,7 @@
 #include "foundation/utility/uid.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <map>
 #include <memory>
@@ -109,7 +111,14 @@ class CurveTree
     std::vector<Curve3Type> m_curves3;
     std::vector<CurveKey>   m_curve_keys;
 
-    void collect_curves(std::vector<GAABB3>& curve_bboxes);
+    // Collect the curves of the assembly and return their number. With split curve bounds,
+    // a curve may be referenced several times from the tree, each time with a smaller bounding box.
+    // Object instances with a curve level of detail contribute fewer curves than their objects
+    // contain; the number of curves of the objects is returned in original_curve_count.
+    size_t collect_curves(
+        const bool                              split_curve_bounds,
+        std::vector<GAABB3>&                    curve_bboxes,
+        size_t&                                 original_curve_count);
 
     void build_bvh(
         const ParamArray&                       params,
@@ -176,11 +185,12 @@ class CurveLeafVisitor
   : public foundation::NonCopyable
 {
   public:
-    // Constructor.
+    // Constructor. 'counters' may be null.
     CurveLeafVisitor(
         const CurveTree&                        tree,
         const CurveMatrixType&                  xfm_matrix,
-        ShadingPoint&                           shading_point);
+        ShadingPoint&                           shading_point,
+        IntersectionProfiler::Counters*         counters = 0);
 
     // Visit a leaf.
     bool visit(
@@ -197,6 +207,7 @@ class CurveLeafVisitor
     const CurveTree&                            m_tree;
     const CurveMatrixType&                      m_xfm_matrix;
     ShadingPoint&                               m_shading_point;
+    IntersectionProfiler::Counters*             m_counters;
 };
 
 
@@ -209,10 +220,11 @@ class CurveLeafProbeVisitor
   : public ProbeVisitorBase
 {
   public:
-    // Constructor.
+    // Constructor. 'counters' may be null.
     CurveLeafProbeVisitor(
         const CurveTree&                        tree,
-        const CurveMatrixType&                  xfm_matrix);
+        const CurveMatrixType&                  xfm_matrix,
+        IntersectionProfiler::Counters*         counters = 0);
 
     // Visit a leaf.
     bool visit(
@@ -228,6 +240,7 @@ class CurveLeafProbeVisitor
   private:
     const CurveTree&                            m_tree;
     const CurveMatrixType&                      m_xfm_matrix;
+    IntersectionProfiler::Counters*             m_counters;
 };
 
 
@@ -257,10 +270,12 @@ typedef foundation::bvh::Intersector<
 inline CurveLeafVisitor::CurveLeafVisitor(
     const CurveTree&                            tree,
     const CurveMatrixType&                      xfm_matrix,
-    ShadingPoint&                               shading_point)
+    ShadingPoint&                               shading_point,
+    IntersectionProfiler::Counters*             counters)
   : m_tree(tree)
   , m_xfm_matrix(xfm_matrix)
   , m_shading_point(shading_point)
+  , m_counters(counters)
 {
 }
 
@@ -276,39 +291,62 @@ inline bool CurveLeafVisitor::visit(
 {
     const CurveTree::LeafUserData& user_data = node.get_user_data<CurveTree::LeafUserData>();
 
+    if (m_counters)
+        m_counters->m_intersected_curves += user_data.m_curve1_count + user_data.m_curve3_count;
+
     size_t curve_index = node.get_item_index();
     size_t hit_curve_index = ~0;
     GScalar u, v, t = ray.m_tmax;
 
-    for (foundation::uint32 i = 0; i < user_data.m_curve1_count; ++i, ++curve_index)
+    // Intersect degree-1 curves, one batch at a time.
+    for (foundation::uint32 i = 0; i < user_data.m_curve1_count; i += Curve1BatchIntersectorType::BatchSize)
     {
-        const Curve1Type& curve = m_tree.m_curves1[user_data.m_curve1_offset + i];
-        if (Curve1IntersectorType::intersect(curve, ray, m_xfm_matrix, u, v, t))
+        const size_t batch_size =
+            std::min<size_t>(Curve1BatchIntersectorType::BatchSize, user_data.m_curve1_count - i);
+        const size_t hit_index =
+            Curve1BatchIntersectorType::intersect(
+                &m_tree.m_curves1[user_data.m_curve1_offset + i],
+                batch_size,
+                ray,
+                m_xfm_matrix,
+                u, v, t);
+        if (hit_index != size_t(~0))
         {
             m_shading_point.m_primitive_type = ShadingPoint::PrimitiveCurve1;
             m_shading_point.m_ray.m_tmax = static_cast<double>(t);
             m_shading_point.m_bary[0] = static_cast<float>(u);
             m_shading_point.m_bary[1] = static_cast<float>(v);
-            hit_curve_index = curve_index;
+            hit_curve_index = curve_index + i + hit_index;
         }
     }
 
-    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(curve1_curve_count));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(user_data.m_curve1_count));
 
-    for (foundation::uint32 i = 0; i < user_data.m_curve3_count; ++i, ++curve_index)
+    curve_index += user_data.m_curve1_count;
+
+    // Intersect degree-3 curves, one batch at a time.
+    for (foundation::uint32 i = 0; i < user_data.m_curve3_count; i += Curve3BatchIntersectorType::BatchSize)
     {
-        const Curve3Type& curve = m_tree.m_curves3[user_data.m_curve3_offset + i];
-        if (Curve3IntersectorType::intersect(curve, ray, m_xfm_matrix, u, v, t))
+        const size_t batch_size =
+            std::min<size_t>(Curve3BatchIntersectorType::BatchSize, user_data.m_curve3_count - i);
+        const size_t hit_index =
+            Curve3BatchIntersectorType::intersect(
+                &m_tree.m_curves3[user_data.m_curve3_offset + i],
+                batch_size,
+                ray,
+                m_xfm_matrix,
+                u, v, t);
+        if (hit_index != size_t(~0))
         {
             m_shading_point.m_primitive_type = ShadingPoint::PrimitiveCurve3;
             m_shading_point.m_ray.m_tmax = static_cast<double>(t);
             m_shading_point.m_bary[0] = static_cast<float>(u);
             m_shading_point.m_bary[1] = static_cast<float>(v);
-            hit_curve_index = curve_index;
+            hit_curve_index = curve_index + i + hit_index;
         }
     }
 
-    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(curve3_curve_count));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(user_data.m_curve3_count));
 
     if (hit_curve_index != size_t(~0))
     {
@@ -329,9 +367,11 @@ inline bool CurveLeafVisitor::visit(
 
 inline CurveLeafProbeVisitor::CurveLeafProbeVisitor(
     const CurveTree&                            tree,
-    const CurveMatrixType&                      xfm_matrix)
+    const CurveMatrixType&                      xfm_matrix,
+    IntersectionProfiler::Counters*             counters)
   : m_tree(tree)
   , m_xfm_matrix(xfm_matrix)
+  , m_counters(counters)
 {
 }
 
@@ -347,31 +387,46 @@ inline bool CurveLeafProbeVisitor::visit(
 {
     const CurveTree::LeafUserData& user_data = node.get_user_data<CurveTree::LeafUserData>();
 
-    for (foundation::uint32 i = 0; i < user_data.m_curve1_count; ++i)
+    if (m_counters)
+        m_counters->m_intersected_curves += user_data.m_curve1_count + user_data.m_curve3_count;
+
+    // Intersect degree-1 curves, one batch at a time.
+    for (foundation::uint32 i = 0; i < user_data.m_curve1_count; i += Curve1BatchIntersectorType::BatchSize)
     {
-        const Curve1Type& curve = m_tree.m_curves1[user_data.m_curve1_offset + i];
-        if (Curve1IntersectorType::intersect(curve, ray, m_xfm_matrix))
+        const size_t batch_size =
+            std::min<size_t>(Curve1BatchIntersectorType::BatchSize, user_data.m_curve1_count - i);
+        if (Curve1BatchIntersectorType::intersect(
+                &m_tree.m_curves1[user_data.m_curve1_offset + i],
+                batch_size,
+                ray,
+                m_xfm_matrix))
         {
-            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(i + 1));
+            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(i + batch_size));
             m_hit = true;
             return false;
         }
     }
 
-    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(curve1_curve_count));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(user_data.m_curve1_count));
 
-    for (foundation::uint32 i = 0; i < user_data.m_curve3_count; ++i)
+    // Intersect degree-3 curves, one batch at a time.
+    for (foundation::uint32 i = 0; i < user_data.m_curve3_count; i += Curve3BatchIntersectorType::BatchSize)
     {
-        const Curve3Type& curve = m_tree.m_curves3[user_data.m_curve3_offset + i];
-        if (Curve3IntersectorType::intersect(curve, ray, m_xfm_matrix))
+        const size_t batch_size =
+            std::min<size_t>(Curve3BatchIntersectorType::BatchSize, user_data.m_curve3_count - i);
+        if (Curve3BatchIntersectorType::intersect(
+                &m_tree.m_curves3[user_data.m_curve3_offset + i],
+                batch_size,
+                ray,
+                m_xfm_matrix))
         {
-            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(i + 1));
+            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(i + batch_size));
             m_hit = true;
             return false;
         }
     }
 
-    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(curve3_curve_count));
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(user_data.m_curve3_count));
 
     // Continue traversal.
     distance = ray.m_tmax;
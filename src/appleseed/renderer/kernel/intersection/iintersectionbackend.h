@@ -0,0 +1,131 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_RENDERER_KERNEL_INTERSECTION_IINTERSECTIONBACKEND_H
+#define APPLESEED_RENDERER_KERNEL_INTERSECTION_IINTERSECTIONBACKEND_H
+
+// appleseed.renderer headers.
+#include "renderer/kernel/intersection/intersectionsettings.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/iunknown.h"
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace renderer      { class AssemblyInstance; }
+namespace renderer      { class ParamArray; }
+namespace renderer      { class Scene; }
+namespace renderer      { class ShadingRay; }
+
+namespace renderer
+{
+
+//
+// The closest hit found by an intersection backend, in the same terms as
+// Intersector::manufacture_hit(): the intersector turns it into a shading point.
+//
+
+class IntersectionBackendHit
+{
+  public:
+    ShadingPoint::PrimitiveType     m_primitive_type;
+    double                          m_distance;
+    foundation::Vector2f            m_bary;
+    const AssemblyInstance*         m_assembly_instance;
+    foundation::Transformd          m_assembly_instance_transform;  // transform at the time of the ray
+    size_t                          m_object_instance_index;
+    size_t                          m_region_index;
+    size_t                          m_primitive_index;
+    TriangleSupportPlaneType        m_triangle_support_plane;       // assembly instance space
+};
+
+
+//
+// Intersection backend interface.
+//
+// An intersection backend replaces the built-in assembly, triangle and curve trees
+// with its own acceleration structures. It builds them from the same region kits
+// and static tessellations, so that the hits it reports can be shaded as usual.
+//
+// Backends are shared amongst threads: trace() and trace_probe() must be thread-safe.
+//
+
+class APPLESEED_DLLSYMBOL IIntersectionBackend
+  : public foundation::IUnknown
+{
+  public:
+    // Synchronize the acceleration structures of the backend with the scene.
+    virtual void update() = 0;
+
+    // Find the closest hit along a world space ray. Return false if there is none.
+    // 'parent_shading_point' is the point the ray originates from, if any, and
+    // may be used to reject self-intersections.
+    virtual bool trace(
+        const ShadingRay&           ray,
+        const ShadingPoint*         parent_shading_point,
+        IntersectionBackendHit&     hit) const = 0;
+
+    // Return whether a world space ray hits the scene.
+    virtual bool trace_probe(
+        const ShadingRay&           ray,
+        const ShadingPoint*         parent_shading_point) const = 0;
+};
+
+
+//
+// Intersection backend factory interface.
+//
+
+class APPLESEED_DLLSYMBOL IIntersectionBackendFactory
+  : public foundation::NonCopyable
+{
+  public:
+    // Destructor.
+    virtual ~IIntersectionBackendFactory() {}
+
+    // Return a string identifying this intersection backend.
+    virtual const char* get_model() const = 0;
+
+    // Create a new intersection backend for a given scene.
+    virtual foundation::auto_release_ptr<IIntersectionBackend> create(
+        const Scene&                scene,
+        const ParamArray&           params) const = 0;
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_INTERSECTION_IINTERSECTIONBACKEND_H
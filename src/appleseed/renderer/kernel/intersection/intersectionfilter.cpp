@@ -49,6 +49,8 @@
 #include "foundation/utility/lazy.h"
 
 // Standard headers.
+#include <algorithm>
+#include <cassert>
 #include <memory>
 
 using namespace foundation;
@@ -76,10 +78,15 @@ namespace
         return triangle_count;
     }
 
-    void copy_uv_coordinates(const StaticTriangleTess& tess, vector<Vector2f>& uv)
+    void copy_uv_coordinates(
+        const StaticTriangleTess&   tess,
+        vector<Vector2f>&           uv,
+        vector<uint32>&             pa)
     {
         for (const_each<StaticTriangleTess::PrimitiveArray> i = tess.m_primitives; i; ++i)
         {
+            pa.push_back(i->m_pa);
+
             if (i->has_vertex_attributes() && tess.get_tex_coords_count() > 0)
             {
                 const Vector2f uv0(tess.get_tex_coords(i->m_a0));
@@ -99,7 +106,10 @@ namespace
         }
     }
 
-    void copy_uv_coordinates(Object& object, vector<Vector2f>& uv)
+    void copy_uv_coordinates(
+        Object&                     object,
+        vector<Vector2f>&           uv,
+        vector<uint32>&             pa)
     {
         Access<RegionKit> region_kit(&object.get_region_kit());
 
@@ -108,7 +118,7 @@ namespace
             const IRegion* region = *i;
             Access<StaticTriangleTess> tess(&region->get_static_triangle_tess());
 
-            copy_uv_coordinates(*tess, uv);
+            copy_uv_coordinates(*tess, uv, pa);
         }
     }
 }
@@ -130,8 +140,13 @@ IntersectionFilter::IntersectionFilter(
     if (has_alpha_masks())
     {
         // Make a local copy of the object's UV coordinates.
-        m_uv.reserve(get_triangle_count(object) * 3);
-        copy_uv_coordinates(object, m_uv);
+        const size_t triangle_count = get_triangle_count(object);
+        m_uv.reserve(triangle_count * 3);
+        m_triangle_pa.reserve(triangle_count);
+        copy_uv_coordinates(object, m_uv, m_triangle_pa);
+
+        // Classify triangles now that their UV coordinates are known.
+        classify_triangles();
     }
 }
 
@@ -226,6 +241,8 @@ void IntersectionFilter::update(
         else
             delete_and_clear(m_material_alpha_masks[i]);
     }
+
+    classify_triangles();
 }
 
 bool IntersectionFilter::has_alpha_masks() const
@@ -244,7 +261,7 @@ bool IntersectionFilter::has_alpha_masks() const
 
 size_t IntersectionFilter::get_masks_memory_size() const
 {
-    size_t size = 0;
+    size_t size = m_triangle_coverage.capacity() * sizeof(uint8);
 
     if (m_obj_alpha_mask)
         size += m_obj_alpha_mask->get_memory_size();
@@ -260,7 +277,128 @@ size_t IntersectionFilter::get_masks_memory_size() const
 
 size_t IntersectionFilter::get_uv_memory_size() const
 {
-    return m_uv.capacity() * sizeof(Vector2f);
+    return
+        m_uv.capacity() * sizeof(Vector2f) +
+        m_triangle_pa.capacity() * sizeof(uint32);
+}
+
+void IntersectionFilter::classify_triangles()
+{
+    const size_t triangle_count = m_triangle_pa.size();
+    assert(m_uv.size() == triangle_count * 3);
+
+    m_triangle_coverage.resize(triangle_count);
+
+    for (size_t i = 0; i < triangle_count; ++i)
+    {
+        const Vector2f& uv0 = m_uv[i * 3 + 0];
+        const Vector2f& uv1 = m_uv[i * 3 + 1];
+        const Vector2f& uv2 = m_uv[i * 3 + 2];
+
+        Coverage coverage =
+            m_obj_alpha_mask
+                ? m_obj_alpha_mask->get_coverage(uv0, uv1, uv2)
+                : CoverageOpaque;
+
+        const size_t pa = m_triangle_pa[i];
+        const AlphaMask* mtl_alpha_mask =
+            pa < m_material_alpha_masks.size() ? m_material_alpha_masks[pa] : 0;
+
+        if (mtl_alpha_mask && coverage != CoverageTransparent)
+        {
+            const Coverage mtl_coverage = mtl_alpha_mask->get_coverage(uv0, uv1, uv2);
+            if (mtl_coverage != CoverageOpaque)
+                coverage = mtl_coverage;
+        }
+
+        m_triangle_coverage[i] = static_cast<uint8>(coverage);
+    }
+}
+
+void IntersectionFilter::AlphaMask::build_coverage_hierarchy()
+{
+    m_coverage_levels.clear();
+
+    size_t src_width = m_bitmask.get_width();
+    size_t src_height = m_bitmask.get_height();
+
+    while (src_width > 1 || src_height > 1)
+    {
+        CoverageLevel level;
+        level.m_width = (src_width + 1) / 2;
+        level.m_height = (src_height + 1) / 2;
+        level.m_flags.assign(level.m_width * level.m_height, 0);
+
+        const CoverageLevel* src_level =
+            m_coverage_levels.empty() ? 0 : &m_coverage_levels.back();
+
+        for (size_t y = 0; y < src_height; ++y)
+        {
+            for (size_t x = 0; x < src_width; ++x)
+            {
+                const uint8 flags =
+                    src_level
+                        ? src_level->m_flags[y * src_width + x]
+                        : get_texel_flags(x, y);
+
+                level.m_flags[(y / 2) * level.m_width + x / 2] |= flags;
+            }
+        }
+
+        m_coverage_levels.push_back(level);
+
+        src_width = level.m_width;
+        src_height = level.m_height;
+    }
+}
+
+IntersectionFilter::Coverage IntersectionFilter::AlphaMask::get_coverage(
+    const Vector2f&         uv0,
+    const Vector2f&         uv1,
+    const Vector2f&         uv2) const
+{
+    // Compute the texel space bounding box of the triangle. Since texture coordinates
+    // are clamped when sampling the mask, so is the bounding box.
+    const size_t x0 = to_texel_x(min(uv0[0], min(uv1[0], uv2[0])));
+    const size_t y0 = to_texel_y(min(uv0[1], min(uv1[1], uv2[1])));
+    const size_t x1 = to_texel_x(max(uv0[0], max(uv1[0], uv2[0])));
+    const size_t y1 = to_texel_y(max(uv0[1], max(uv1[1], uv2[1])));
+
+    // Find the finest level at which the bounding box overlaps at most 2x2 cells.
+    size_t level = 0;
+    while ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)
+        ++level;
+
+    // Merge the flags of these cells.
+    uint8 flags = 0;
+    for (size_t y = y0 >> level, ye = y1 >> level; y <= ye; ++y)
+    {
+        for (size_t x = x0 >> level, xe = x1 >> level; x <= xe; ++x)
+        {
+            if (level == 0)
+                flags |= get_texel_flags(x, y);
+            else
+            {
+                const CoverageLevel& l = m_coverage_levels[level - 1];
+                flags |= l.m_flags[y * l.m_width + x];
+            }
+        }
+    }
+
+    return
+        flags == HasOpaqueTexels ? CoverageOpaque :
+        flags == HasTransparentTexels ? CoverageTransparent :
+        CoveragePartial;
+}
+
+size_t IntersectionFilter::AlphaMask::get_memory_size() const
+{
+    size_t size = m_bitmask.get_memory_size();
+
+    for (size_t i = 0; i < m_coverage_levels.size(); ++i)
+        size += m_coverage_levels[i].m_flags.capacity();
+
+    return size;
 }
 
 IntersectionFilter::AlphaMask* IntersectionFilter::create_alpha_mask(
@@ -313,6 +451,9 @@ IntersectionFilter::AlphaMask* IntersectionFilter::create_alpha_mask(
         }
     }
 
+    // Build the coverage hierarchy used to classify triangles.
+    alpha_mask->build_coverage_hierarchy();
+
     // Compute the ratio of transparent texels to the total number of texels.
     transparency = static_cast<double>(transparent_texel_count) / (width * height);
 
@@ -39,12 +39,18 @@
 #include "foundation/math/vector.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/bitmask.h"
+#include "foundation/utility/test.h"
 
 // Standard headers.
 #include <cassert>
 #include <cstddef>
 #include <vector>
 
+DECLARE_TEST_CASE(Renderer_Kernel_Intersection_IntersectionFilter, GetCoverage_GivenTriangleOverOpaqueRegion_ReturnsOpaque);
+DECLARE_TEST_CASE(Renderer_Kernel_Intersection_IntersectionFilter, GetCoverage_GivenTriangleOverTransparentRegion_ReturnsTransparent);
+DECLARE_TEST_CASE(Renderer_Kernel_Intersection_IntersectionFilter, GetCoverage_GivenTriangleOverMixedRegion_ReturnsPartial);
+DECLARE_TEST_CASE(Renderer_Kernel_Intersection_IntersectionFilter, GetCoverage_GivenNonPowerOfTwoMask_IsConservative);
+
 // Forward declarations.
 namespace renderer  { class MaterialArray; }
 namespace renderer  { class Object; }
@@ -81,6 +87,19 @@ class IntersectionFilter
         const double            v) const;
 
   private:
+    GRANT_ACCESS_TO_TEST_CASE(Renderer_Kernel_Intersection_IntersectionFilter, GetCoverage_GivenTriangleOverOpaqueRegion_ReturnsOpaque);
+    GRANT_ACCESS_TO_TEST_CASE(Renderer_Kernel_Intersection_IntersectionFilter, GetCoverage_GivenTriangleOverTransparentRegion_ReturnsTransparent);
+    GRANT_ACCESS_TO_TEST_CASE(Renderer_Kernel_Intersection_IntersectionFilter, GetCoverage_GivenTriangleOverMixedRegion_ReturnsPartial);
+    GRANT_ACCESS_TO_TEST_CASE(Renderer_Kernel_Intersection_IntersectionFilter, GetCoverage_GivenNonPowerOfTwoMask_IsConservative);
+
+    // Conservative coverage of a triangle (or of a region of an alpha mask).
+    enum Coverage
+    {
+        CoverageTransparent,    // fully transparent: hits are always rejected
+        CoverageOpaque,         // fully opaque: hits are always accepted
+        CoveragePartial         // the alpha masks must be sampled
+    };
+
     class AlphaMask
       : public foundation::NonCopyable
     {
@@ -118,15 +137,53 @@ class IntersectionFilter
             return !is_opaque(uv);
         }
 
-        size_t get_memory_size() const
+        // Build the coverage hierarchy once all texels have been set.
+        void build_coverage_hierarchy();
+
+        // Return the conservative coverage of the triangle with texture coordinates (uv0, uv1, uv2).
+        Coverage get_coverage(
+            const foundation::Vector2f& uv0,
+            const foundation::Vector2f& uv1,
+            const foundation::Vector2f& uv2) const;
+
+        size_t get_memory_size() const;
+
+      private:
+        // Flags of a cell of the coverage hierarchy.
+        enum { HasOpaqueTexels = 1, HasTransparentTexels = 2 };
+
+        struct CoverageLevel
+        {
+            size_t                          m_width;
+            size_t                          m_height;
+            std::vector<foundation::uint8>  m_flags;
+        };
+
+        const float                 m_max_x;
+        const float                 m_max_y;
+        foundation::BitMask2        m_bitmask;
+
+        // Level i covers 2^(i+1) x 2^(i+1) texels per cell, down to a single cell.
+        std::vector<CoverageLevel>  m_coverage_levels;
+
+        size_t to_texel_x(const float u) const
+        {
+            return foundation::truncate<size_t>(
+                foundation::clamp(u * m_bitmask.get_width(), 0.0f, m_max_x));
+        }
+
+        size_t to_texel_y(const float v) const
         {
-            return m_bitmask.get_memory_size();
+            return foundation::truncate<size_t>(
+                foundation::clamp(v * m_bitmask.get_height(), 0.0f, m_max_y));
         }
 
-      private:
-        const float             m_max_x;
-        const float             m_max_y;
-        foundation::BitMask2    m_bitmask;
+        foundation::uint8 get_texel_flags(
+            const size_t                x,
+            const size_t                y) const
+        {
+            return m_bitmask.is_set(x, y) ? HasOpaqueTexels : HasTransparentTexels;
+        }
     };
 
     foundation::uint64                  m_obj_alpha_map_signature;
@@ -134,6 +191,11 @@ class IntersectionFilter
     std::vector<foundation::uint64>     m_material_alpha_map_signatures;
     std::vector<AlphaMask*>             m_material_alpha_masks;
     std::vector<foundation::Vector2f>   m_uv;
+    std::vector<foundation::uint32>     m_triangle_pa;
+    std::vector<foundation::uint8>      m_triangle_coverage;
+
+    // Classify all triangles according to the current alpha masks.
+    void classify_triangles();
 
     template <typename EntityType>
     static void do_update(
@@ -169,12 +231,17 @@ inline bool IntersectionFilter::accept(
     if (u != u || v != v)
         return true;
 
+    const size_t triangle_index = triangle_key.get_triangle_index();
+
+    // Skip sampling the alpha masks if this triangle is classified as fully opaque or transparent.
+    const foundation::uint8 coverage = m_triangle_coverage[triangle_index];
+    if (coverage != CoveragePartial)
+        return coverage == CoverageOpaque;
+
     const AlphaMask* mtl_alpha_mask = m_material_alpha_masks[triangle_key.get_triangle_pa()];
 
     if (m_obj_alpha_mask || mtl_alpha_mask)
     {
-        const size_t triangle_index = triangle_key.get_triangle_index();
-
         const float fu = static_cast<float>(u);
         const float fv = static_cast<float>(v);
 
@@ -0,0 +1,159 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "intersectionprofiler.h"
+
+// appleseed.renderer headers.
+#include "renderer/modeling/scene/assembly.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/api/apistring.h"
+#include "foundation/utility/foreach.h"
+#include "foundation/utility/statistics.h"
+
+// Standard headers.
+#include <string>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// IntersectionProfiler class implementation.
+//
+
+IntersectionProfiler::IntersectionProfiler(const size_t sampling_period)
+  : m_sampling_period(sampling_period)
+  , m_ray_index(0)
+  , m_ray_counts(VisibilityFlags::Count, 0)
+  , m_assembly_tree_records(VisibilityFlags::Count)
+  , m_ray_type(0)
+{
+}
+
+void IntersectionProfiler::end_ray()
+{
+    ++m_ray_counts[m_ray_type];
+
+    m_assembly_tree_records[m_ray_type].insert(m_assembly_tree_counters);
+
+    for (const_each<vector<RayEntry> > i = m_ray_entries; i; ++i)
+        i->m_record->m_ray_types[m_ray_type].insert(i->m_counters);
+}
+
+IntersectionProfiler::Counters& IntersectionProfiler::get_assembly_counters(const Assembly& assembly)
+{
+    const UniqueID assembly_uid = assembly.get_uid();
+
+    // Assemblies visited by the profiled ray so far.
+    for (each<vector<RayEntry> > i = m_ray_entries; i; ++i)
+    {
+        if (i->m_assembly_uid == assembly_uid)
+            return i->m_counters;
+    }
+
+    AssemblyRecordMap::iterator it = m_assembly_records.find(assembly_uid);
+
+    if (it == m_assembly_records.end())
+    {
+        it = m_assembly_records.insert(make_pair(assembly_uid, AssemblyRecord())).first;
+        it->second.m_name = assembly.get_path().c_str();
+        it->second.m_ray_types.resize(VisibilityFlags::Count);
+    }
+
+    RayEntry entry;
+    entry.m_assembly_uid = assembly_uid;
+    entry.m_record = &it->second;
+    m_ray_entries.push_back(entry);
+
+    return m_ray_entries.back().m_counters;
+}
+
+StatisticsVector IntersectionProfiler::get_statistics() const
+{
+    StatisticsVector vec;
+
+    if (!is_enabled())
+        return vec;
+
+    Statistics assembly_tree_stats;
+    assembly_tree_stats.insert("sampling period", m_sampling_period);
+
+    for (size_t i = 0; i < VisibilityFlags::Count; ++i)
+    {
+        if (m_ray_counts[i] == 0)
+            continue;
+
+        const string type = VisibilityFlags::Names[i];
+        const RayTypeRecord& record = m_assembly_tree_records[i];
+        assembly_tree_stats.insert(type + " rays", m_ray_counts[i]);
+        assembly_tree_stats.insert(type + " nodes", record.m_visited_nodes);
+        assembly_tree_stats.insert(type + " leaves", record.m_visited_leaves);
+    }
+
+    vec.insert("intersection profile: assembly tree", assembly_tree_stats);
+
+    for (const_each<AssemblyRecordMap> i = m_assembly_records; i; ++i)
+    {
+        const AssemblyRecord& assembly_record = i->second;
+
+        Statistics assembly_stats;
+
+        for (size_t j = 0; j < VisibilityFlags::Count; ++j)
+        {
+            const RayTypeRecord& record = assembly_record.m_ray_types[j];
+
+            if (record.m_visited_nodes.get_size() == 0)
+                continue;
+
+            const string type = VisibilityFlags::Names[j];
+            assembly_stats.insert(type + " nodes", record.m_visited_nodes);
+            assembly_stats.insert(type + " leaves", record.m_visited_leaves);
+            assembly_stats.insert(type + " triangles", record.m_intersected_triangles);
+            assembly_stats.insert(type + " curves", record.m_intersected_curves);
+            assembly_stats.insert(type + " filters", record.m_filter_invocations);
+        }
+
+        vec.insert("intersection profile: assembly \"" + assembly_record.m_name + "\"", assembly_stats);
+    }
+
+    return vec;
+}
+
+void IntersectionProfiler::RayTypeRecord::insert(const Counters& counters)
+{
+    m_visited_nodes.insert(counters.m_traversal.m_visited_nodes);
+    m_visited_leaves.insert(counters.m_traversal.m_visited_leaves);
+    m_intersected_triangles.insert(counters.m_intersected_triangles);
+    m_intersected_curves.insert(counters.m_intersected_curves);
+    m_filter_invocations.insert(counters.m_filter_invocations);
+}
+
+}   // namespace renderer
@@ -0,0 +1,186 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_RENDERER_KERNEL_INTERSECTION_INTERSECTIONPROFILER_H
+#define APPLESEED_RENDERER_KERNEL_INTERSECTION_INTERSECTIONPROFILER_H
+
+// appleseed.renderer headers.
+#include "renderer/modeling/scene/visibilityflags.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh.h"
+#include "foundation/math/population.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/uid.h"
+
+// Standard headers.
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class StatisticsVector; }
+namespace renderer      { class Assembly; }
+
+namespace renderer
+{
+
+//
+// Sampled intersection instrumentation.
+//
+// One out of every N rays traced by an intersector is profiled: the number of
+// BVH nodes and leaves visited, of primitives tested and of intersection filter
+// invocations are recorded per ray type, and per assembly. Rays that are not
+// sampled only pay for a counter increment.
+//
+// Only single rays are profiled; packets of rays are not.
+//
+
+class IntersectionProfiler
+  : public foundation::NonCopyable
+{
+  public:
+    // Counters of a profiled ray for a given acceleration structure.
+    struct Counters
+    {
+        foundation::bvh::TraversalCounters  m_traversal;
+        foundation::uint64                  m_intersected_triangles;
+        foundation::uint64                  m_intersected_curves;
+        foundation::uint64                  m_filter_invocations;
+
+        // Constructor, clears all counters.
+        Counters();
+    };
+
+    // Constructor. A sampling period of 0 disables profiling.
+    explicit IntersectionProfiler(const size_t sampling_period = 0);
+
+    // Return true if profiling is enabled.
+    bool is_enabled() const;
+
+    // Start tracing a new ray. Return true if this ray is profiled,
+    // in which case end_ray() must be called once the ray was traced.
+    bool begin_ray(const VisibilityFlags::Type ray_flags);
+
+    // Record the counters of the profiled ray.
+    void end_ray();
+
+    // Return the counters of the assembly tree for the profiled ray.
+    Counters& get_assembly_tree_counters();
+
+    // Return the counters of a given assembly for the profiled ray.
+    Counters& get_assembly_counters(const Assembly& assembly);
+
+    // Retrieve profiling statistics.
+    foundation::StatisticsVector get_statistics() const;
+
+  private:
+    struct RayTypeRecord
+    {
+        foundation::Population<foundation::uint64>  m_visited_nodes;
+        foundation::Population<foundation::uint64>  m_visited_leaves;
+        foundation::Population<foundation::uint64>  m_intersected_triangles;
+        foundation::Population<foundation::uint64>  m_intersected_curves;
+        foundation::Population<foundation::uint64>  m_filter_invocations;
+
+        void insert(const Counters& counters);
+    };
+
+    struct AssemblyRecord
+    {
+        std::string                                 m_name;
+        std::vector<RayTypeRecord>                  m_ray_types;
+    };
+
+    struct RayEntry
+    {
+        foundation::UniqueID                        m_assembly_uid;
+        AssemblyRecord*                             m_record;
+        Counters                                    m_counters;
+    };
+
+    typedef std::map<foundation::UniqueID, AssemblyRecord> AssemblyRecordMap;
+
+    const size_t                                    m_sampling_period;
+    size_t                                          m_ray_index;
+
+    // Records of all the profiled rays.
+    std::vector<foundation::uint64>                 m_ray_counts;
+    std::vector<RayTypeRecord>                      m_assembly_tree_records;
+    AssemblyRecordMap                               m_assembly_records;
+
+    // Counters of the profiled ray.
+    size_t                                          m_ray_type;
+    Counters                                        m_assembly_tree_counters;
+    std::vector<RayEntry>                           m_ray_entries;
+};
+
+
+//
+// IntersectionProfiler class implementation.
+//
+
+inline IntersectionProfiler::Counters::Counters()
+  : m_intersected_triangles(0)
+  , m_intersected_curves(0)
+  , m_filter_invocations(0)
+{
+}
+
+inline bool IntersectionProfiler::is_enabled() const
+{
+    return m_sampling_period > 0;
+}
+
+inline bool IntersectionProfiler::begin_ray(const VisibilityFlags::Type ray_flags)
+{
+    if (m_sampling_period == 0 || ++m_ray_index < m_sampling_period)
+        return false;
+
+    m_ray_index = 0;
+
+    // Rays are attributed to the type of their lowest visibility flag.
+    m_ray_type = 0;
+    while (m_ray_type + 1 < VisibilityFlags::Count && !(ray_flags & (1UL << m_ray_type)))
+        ++m_ray_type;
+
+    m_assembly_tree_counters = Counters();
+    m_ray_entries.clear();
+
+    return true;
+}
+
+inline IntersectionProfiler::Counters& IntersectionProfiler::get_assembly_tree_counters()
+{
+    return m_assembly_tree_counters;
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_INTERSECTION_INTERSECTIONPROFILER_H
@@ -36,6 +36,7 @@
 // appleseed.foundation headers.
 #include "foundation/math/beziercurve.h"
 #include "foundation/math/intersection/raytrianglemt.h"
+#include "foundation/math/intersection/raytrianglemt4.h"
 #include "foundation/math/matrix.h"
 
 // Standard headers.
@@ -57,6 +58,9 @@ const double AssemblyTreeInteriorNodeTraversalCost = 1.0;
 // Relative cost of intersecting an assembly.
 const double AssemblyTreeTriangleIntersectionCost = 10.0;
 
+// Maximum relative increase of the SAH cost of the tree before a refit is replaced by a rebuild.
+const double AssemblyTreeDefaultMaxRefitCostIncrease = 0.25;
+
 
 //
 // Region tree settings.
@@ -83,13 +87,26 @@ const size_t RegionTreeAccessCacheWays = 1;
 // Triangle format used for storage.
 typedef foundation::TriangleMT<GScalar> GTriangleType;
 
-// Triangle format used for intersection.
+// Triangle format used for intersection. When appleseed is built with single precision
+// triangles, rays are intersected with triangles in the precision of their storage.
+// The support plane used to refine intersection points is always in double precision.
+#ifdef APPLESEED_USE_SINGLE_PRECISION_TRIANGLES
+typedef foundation::TriangleMT<GScalar> TriangleType;
+#else
 typedef foundation::TriangleMT<double> TriangleType;
+#endif
 typedef foundation::TriangleMTSupportPlane<double> TriangleSupportPlaneType;
 
+// Formats of the groups of triangles of packed leaves, for storage and for intersection.
+typedef foundation::TriangleMT4<GScalar> GTriangle4Type;
+typedef foundation::TriangleMT4<TriangleType::ValueType> Triangle4Type;
+
 // Maximum number of triangles per leaf.
 const size_t TriangleTreeDefaultMaxLeafSize = 2;
 
+// Maximum number of triangles per leaf when leaves are packed, so that a leaf fills a group.
+const size_t TriangleTreePackedMaxLeafSize = GTriangle4Type::Width;
+
 // Relative cost of traversing an interior node.
 const GScalar TriangleTreeDefaultInteriorNodeTraversalCost(1.0);
 
@@ -126,11 +143,18 @@ typedef foundation::BezierCurve3<GScalar> Curve3Type;
 typedef foundation::BezierCurveIntersector<Curve1Type> Curve1IntersectorType;
 typedef foundation::BezierCurveIntersector<Curve3Type> Curve3IntersectorType;
 
+// Curve intersectors testing several curves at once.
+typedef foundation::BezierCurveBatchIntersector<Curve1Type> Curve1BatchIntersectorType;
+typedef foundation::BezierCurveBatchIntersector<Curve3Type> Curve3BatchIntersectorType;
+
 // Matrix used in curve intersections
 typedef foundation::Matrix<GScalar, 4, 4> CurveMatrixType;
 
-// Maximum number of curves per leaf.
-const size_t CurveTreeDefaultMaxLeafSize = 1;
+// Maximum number of curves per leaf. Leaves hold one batch of curves so that they can be intersected at once.
+const size_t CurveTreeDefaultMaxLeafSize = foundation::BezierCurveBatchSize;
+
+// Maximum number of bounding boxes a curve can be split into when split curve bounds are enabled.
+const size_t CurveTreeMaxCurveSplitCount = 4;
 
 // Relative cost of traversing an interior node.
 const GScalar CurveTreeDefaultInteriorNodeTraversalCost(1.0);
@@ -146,6 +170,27 @@ const size_t CurveTreeAccessCacheWays = 2;
 const size_t CurveTreeStackSize = 64;
 
 
+//
+// Particle tree settings.
+//
+
+// Maximum number of particles per leaf.
+const size_t ParticleTreeDefaultMaxLeafSize = 8;
+
+// Relative cost of traversing an interior node.
+const GScalar ParticleTreeDefaultInteriorNodeTraversalCost(1.0);
+
+// Relative cost of intersecting a particle.
+const GScalar ParticleTreeDefaultParticleIntersectionCost(0.5);
+
+// Size of the particle tree access cache.
+const size_t ParticleTreeAccessCacheLines = 128;
+const size_t ParticleTreeAccessCacheWays = 2;
+
+// Size of the stack (in number of nodes) used during traversal.
+const size_t ParticleTreeStackSize = 64;
+
+
 //
 // Miscellaneous settings.
 //
@@ -154,6 +199,8 @@ const size_t CurveTreeStackSize = 64;
 // If left undefined, a fixed, constant-time procedure is used. The adaptive
 // procedure handles degenerate cases better but is slightly slower. It must
 // be used when the triangle model is set to Moller-Trumbore (MT).
+// With single precision triangles, intersection points are instead offset by
+// a bound on their floating-point error.
 #define RENDERER_ADAPTIVE_OFFSET
 
 }       // namespace renderer
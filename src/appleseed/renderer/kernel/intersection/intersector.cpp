@@ -33,11 +33,13 @@
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
 #include "renderer/kernel/intersection/assemblytree.h"
+#include "renderer/kernel/intersection/iintersectionbackend.h"
 #include "renderer/kernel/intersection/tracecontext.h"
 #include "renderer/kernel/shading/shadingray.h"
 #include "renderer/modeling/scene/assemblyinstance.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/scalar.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/utility/cache.h"
 #include "foundation/utility/casts.h"
@@ -48,7 +50,9 @@
 
 // Standard headers.
 #include <cassert>
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <memory>
 #include <string>
 
@@ -61,12 +65,20 @@ namespace renderer
 Intersector::Intersector(
     const TraceContext&             trace_context,
     TextureCache&                   texture_cache,
-    const bool                      report_self_intersections)
+    const bool                      report_self_intersections,
+    const bool                      use_occluder_cache,
+    const size_t                    profiling_period)
   : m_trace_context(trace_context)
   , m_texture_cache(texture_cache)
   , m_report_self_intersections(report_self_intersections)
+  , m_use_occluder_cache(use_occluder_cache)
+  , m_transform_cache_version_id(trace_context.get_version_id())
   , m_shading_ray_count(0)
   , m_probe_ray_count(0)
+  , m_packet_ray_count(0)
+  , m_reordered_ray_count(0)
+  , m_occluder_cache_hit_count(0)
+  , m_profiler(profiling_period)
 {
 }
 
@@ -202,6 +214,63 @@ void Intersector::adaptive_offset(
     back = adaptive_offset_point(support_plane, p, -n, InitialMag);
 }
 
+void Intersector::error_bounded_offset(
+    const TriangleSupportPlaneType& support_plane,
+    const Vector3d&                 p,
+    Vector3d                        n,
+    Vector3d&                       front,
+    Vector3d&                       back)
+{
+    //
+    // A ray leaving p is rejected by the Moller-Trumbore test if the sign of the
+    // triple product dot(e1, cross(p - v0, e0)) says that p is in front of the
+    // triangle along the ray. Computed in single precision, this product is off
+    // by at most gamma(n) * dot(|e1|, cross(|p - v0|, |e0|)), and rounding the
+    // ray origin to single precision moves p by at most eps * |p|. Moving p by
+    // the matching distance along the normal of the triangle keeps the sign of
+    // the triple product correct.
+    //
+    // Reference:
+    //
+    //   Physically Based Rendering, Third Edition, section 3.9
+    //
+
+    const double Eps = 0.5 * numeric_limits<float>::epsilon();
+    const double Gamma7 = (7.0 * Eps) / (1.0 - 7.0 * Eps);
+
+    const Vector3d& e0 = support_plane.m_e0;
+    const Vector3d& e1 = support_plane.m_e1;
+    const Vector3d t = p - support_plane.m_v0;
+
+    const Vector3d abs_e0(abs(e0[0]), abs(e0[1]), abs(e0[2]));
+    const Vector3d abs_e1(abs(e1[0]), abs(e1[1]), abs(e1[2]));
+    const Vector3d abs_t(abs(t[0]), abs(t[1]), abs(t[2]));
+    const Vector3d abs_p(abs(p[0]), abs(p[1]), abs(p[2]));
+
+    // Bound the error of the triple product and of the rounding of the ray origin.
+    const Vector3d ng = cross(e0, e1);
+    const Vector3d abs_ng(abs(ng[0]), abs(ng[1]), abs(ng[2]));
+    const Vector3d abs_cross(
+        abs_t[1] * abs_e0[2] + abs_t[2] * abs_e0[1],
+        abs_t[2] * abs_e0[0] + abs_t[0] * abs_e0[2],
+        abs_t[0] * abs_e0[1] + abs_t[1] * abs_e0[0]);
+    const double error = Gamma7 * dot(abs_e1, abs_cross) + Eps * dot(abs_ng, abs_p);
+
+    // Convert the error of the triple product to a distance from the plane of the triangle.
+    const double ng_norm = norm(ng);
+    if (ng_norm == 0.0)
+    {
+        fixed_offset(p, n, front, back);
+        return;
+    }
+    const double distance = error / ng_norm;
+
+    n = normalize(n);
+
+    front = p + distance * n;
+    back = p - distance * n;
+}
+
 namespace
 {
     // Return true if two shading points reference the same triangle.
@@ -257,18 +326,53 @@ bool Intersector::trace(
     shading_point.m_scene = &m_trace_context.get_scene();
     shading_point.m_ray = ray;
 
-    // Compute ray info once for the entire traversal.
-    const ShadingRay::RayInfoType ray_info(shading_point.m_ray);
-
     // Refine and offset the previous intersection point.
     if (parent_shading_point &&
         parent_shading_point->hit() &&
         !(parent_shading_point->m_members & ShadingPoint::HasRefinedPoints))
         parent_shading_point->refine_and_offset();
 
+    // Let the intersection backend find the closest hit, if one is used.
+    if (const IIntersectionBackend* backend = m_trace_context.get_backend())
+    {
+        IntersectionBackendHit hit;
+        if (backend->trace(ray, parent_shading_point, hit))
+        {
+            ShadingRay hit_ray(ray);
+            hit_ray.m_tmax = hit.m_distance;
+
+            manufacture_hit(
+                shading_point,
+                hit_ray,
+                hit.m_primitive_type,
+                hit.m_bary,
+                hit.m_assembly_instance,
+                hit.m_assembly_instance_transform,
+                hit.m_object_instance_index,
+                hit.m_region_index,
+                hit.m_primitive_index,
+                hit.m_triangle_support_plane);
+        }
+
+        // Detect and report self-intersections.
+        if (m_report_self_intersections)
+            report_self_intersection(shading_point, parent_shading_point);
+
+        return shading_point.hit();
+    }
+
+    // Compute ray info once for the entire traversal.
+    const ShadingRay::RayInfoType ray_info(shading_point.m_ray);
+
     // Retrieve assembly tree.
     const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
 
+    // Drop cached instance transforms if the scene has changed.
+    validate_transform_cache();
+
+    // Decide whether this ray is profiled.
+    IntersectionProfiler* profiler = m_profiler.begin_ray(ray.m_flags) ? &m_profiler : 0;
+
     // Check the intersection between the ray and the assembly tree.
     AssemblyTreeIntersector intersector;
     AssemblyLeafVisitor visitor(
@@ -277,7 +381,10 @@ bool Intersector::trace(
         m_region_tree_cache,
         m_triangle_tree_cache,
         m_curve_tree_cache,
-        parent_shading_point
+        m_particle_tree_cache,
+        m_transform_cache,
+        parent_shading_point,
+        profiler
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , m_triangle_tree_traversal_stats
 #endif
@@ -290,7 +397,11 @@ bool Intersector::trace(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , m_assembly_tree_traversal_stats
 #endif
-        );
+        , profiler ? &profiler->get_assembly_tree_counters().m_traversal : 0
+        , shading_point.m_ray.m_flags);
+
+    if (profiler)
+        profiler->end_ray();
 
     // Detect and report self-intersections.
     if (m_report_self_intersections)
@@ -309,18 +420,41 @@ bool Intersector::trace_probe(
     // Update ray casting statistics.
     ++m_probe_ray_count;
 
-    // Compute ray info once for the entire traversal.
-    const ShadingRay::RayInfoType ray_info(ray);
-
     // Refine and offset the previous intersection point.
     if (parent_shading_point &&
         parent_shading_point->hit() &&
         !(parent_shading_point->m_members & ShadingPoint::HasRefinedPoints))
         parent_shading_point->refine_and_offset();
 
+    // Let the intersection backend trace the ray, if one is used.
+    if (const IIntersectionBackend* backend = m_trace_context.get_backend())
+        return backend->trace_probe(ray, parent_shading_point);
+
+    // Compute ray info once for the entire traversal.
+    const ShadingRay::RayInfoType ray_info(ray);
+
+    // Test the last occluder found in this direction first.
+    ProbeOccluder* occluder = 0;
+    if (m_use_occluder_cache)
+    {
+        occluder = &m_occluder_cache[get_occluder_cache_slot(ray.m_dir)];
+
+        if (occluder->intersect(ray, parent_shading_point))
+        {
+            ++m_occluder_cache_hit_count;
+            return true;
+        }
+    }
+
     // Retrieve assembly tree.
     const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
 
+    // Drop cached instance transforms if the scene has changed.
+    validate_transform_cache();
+
+    // Decide whether this ray is profiled.
+    IntersectionProfiler* profiler = m_profiler.begin_ray(ray.m_flags) ? &m_profiler : 0;
+
     // Check the intersection between the ray and the assembly tree.
     AssemblyTreeProbeIntersector intersector;
     AssemblyLeafProbeVisitor visitor(
@@ -328,7 +462,11 @@ bool Intersector::trace_probe(
         m_region_tree_cache,
         m_triangle_tree_cache,
         m_curve_tree_cache,
-        parent_shading_point
+        m_particle_tree_cache,
+        m_transform_cache,
+        parent_shading_point,
+        occluder,
+        profiler
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , m_triangle_tree_traversal_stats
 #endif
@@ -341,11 +479,319 @@ bool Intersector::trace_probe(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
         , m_assembly_tree_traversal_stats
 #endif
-        );
+        , profiler ? &profiler->get_assembly_tree_counters().m_traversal : 0
+        , ray.m_flags);
+
+    if (profiler)
+        profiler->end_ray();
 
     return visitor.hit();
 }
 
+void Intersector::trace(
+    const ShadingRay                rays[],
+    const size_t                    ray_count,
+    ShadingPoint                    shading_points[],
+    const ShadingPoint* const       parent_shading_points[]) const
+{
+    const size_t MaxPacketSize = AssemblyTreePacketIntersector::MaxPacketSize;
+
+    order_rays(rays, ray_count, MaxPacketSize);
+
+    for (size_t begin = 0; begin < ray_count; begin += MaxPacketSize)
+    {
+        trace_packet(
+            rays,
+            m_ray_orderer.get_order() + begin,
+            min(ray_count - begin, MaxPacketSize),
+            shading_points,
+            parent_shading_points);
+    }
+}
+
+void Intersector::trace_probe(
+    const ShadingRay                rays[],
+    const size_t                    ray_count,
+    bool                            hits[],
+    const ShadingPoint* const       parent_shading_points[]) const
+{
+    const size_t MaxPacketSize = AssemblyTreeProbePacketIntersector::MaxPacketSize;
+
+    order_rays(rays, ray_count, MaxPacketSize);
+
+    for (size_t begin = 0; begin < ray_count; begin += MaxPacketSize)
+    {
+        trace_probe_packet(
+            rays,
+            m_ray_orderer.get_order() + begin,
+            min(ray_count - begin, MaxPacketSize),
+            hits,
+            parent_shading_points);
+    }
+}
+
+size_t Intersector::get_occluder_cache_slot(const Vector3d& direction)
+{
+    // The dominant axis and its sign select a face of the unit cube.
+    const size_t axis = max_abs_index(direction);
+    const size_t face = 2 * axis + (direction[axis] < 0.0 ? 1 : 0);
+
+    // The direction projected onto that face selects a cell of the face.
+    const double rcp_len = 1.0 / abs(direction[axis]);
+    const double u = 0.5 * (direction[(axis + 1) % 3] * rcp_len + 1.0);
+    const double v = 0.5 * (direction[(axis + 2) % 3] * rcp_len + 1.0);
+    const size_t GridSize = OccluderCacheGridSize;
+    const size_t iu = min(truncate<size_t>(u * GridSize), GridSize - 1);
+    const size_t iv = min(truncate<size_t>(v * GridSize), GridSize - 1);
+
+    return (face * GridSize + iv) * GridSize + iu;
+}
+
+void Intersector::validate_transform_cache() const
+{
+    const VersionID version_id = m_trace_context.get_version_id();
+
+    if (m_transform_cache_version_id != version_id)
+    {
+        m_transform_cache.clear();
+        m_transform_cache_version_id = version_id;
+    }
+}
+
+void Intersector::order_rays(
+    const ShadingRay                rays[],
+    const size_t                    ray_count,
+    const size_t                    packet_size) const
+{
+    // Batches that fit in a single packet are traced as they come. Larger batches
+    // are sorted so that each packet gathers rays going in the same direction from
+    // nearby origins, and consecutive packets visit neighboring parts of the scene.
+    if (ray_count > packet_size)
+    {
+        m_ray_orderer.sort(rays, ray_count);
+        m_reordered_ray_count += ray_count;
+    }
+    else m_ray_orderer.keep(ray_count);
+}
+
+void Intersector::trace_packet(
+    const ShadingRay                rays[],
+    const size_t                    indices[],
+    const size_t                    ray_count,
+    ShadingPoint                    shading_points[],
+    const ShadingPoint* const       parent_shading_points[]) const
+{
+    const size_t MaxPacketSize = AssemblyTreePacketIntersector::MaxPacketSize;
+    assert(ray_count <= MaxPacketSize);
+
+    // Gather the shading points and parent shading points of the packet's rays.
+    ShadingPoint* packet_shading_points[MaxPacketSize];
+    const ShadingPoint* packet_parent_shading_points[MaxPacketSize];
+    for (size_t i = 0; i < ray_count; ++i)
+    {
+        packet_shading_points[i] = &shading_points[indices[i]];
+        packet_parent_shading_points[i] = parent_shading_points ? parent_shading_points[indices[i]] : 0;
+    }
+
+    // Compute ray infos once for the entire traversal.
+    ShadingRay::RayInfoType ray_infos[MaxPacketSize];
+    for (size_t i = 0; i < ray_count; ++i)
+        ray_infos[i] = ShadingRay::RayInfoType(rays[indices[i]]);
+
+    // Trace incoherent rays one at a time, as well as all rays when the intersection
+    // backend is not the built-in one.
+    if (ray_count == 1 ||
+        m_trace_context.get_backend() ||
+        !AssemblyTreePacketIntersector::is_coherent(ray_infos, ray_count))
+    {
+        for (size_t i = 0; i < ray_count; ++i)
+        {
+            trace(
+                rays[indices[i]],
+                *packet_shading_points[i],
+                packet_parent_shading_points[i]);
+        }
+
+        return;
+    }
+
+    // Update ray casting statistics.
+    m_shading_ray_count += ray_count;
+    m_packet_ray_count += ray_count;
+
+    const ShadingRay* packet_rays[MaxPacketSize];
+
+    for (size_t i = 0; i < ray_count; ++i)
+    {
+        const ShadingRay& ray = rays[indices[i]];
+        ShadingPoint& shading_point = *packet_shading_points[i];
+        const ShadingPoint* parent_shading_point = packet_parent_shading_points[i];
+
+        assert(is_normalized(ray.m_dir));
+        assert(shading_point.m_scene == 0);
+        assert(shading_point.hit() == false);
+        assert(parent_shading_point == 0 || parent_shading_point != &shading_point);
+        assert(parent_shading_point == 0 || parent_shading_point->hit());
+
+        // Initialize the shading point.
+        shading_point.m_region_kit_cache = &m_region_kit_cache;
+        shading_point.m_tess_cache = &m_tess_cache;
+        shading_point.m_texture_cache = &m_texture_cache;
+        shading_point.m_scene = &m_trace_context.get_scene();
+        shading_point.m_ray = ray;
+        packet_rays[i] = &shading_point.m_ray;
+
+        // Refine and offset the previous intersection point.
+        if (parent_shading_point &&
+            parent_shading_point->hit() &&
+            !(parent_shading_point->m_members & ShadingPoint::HasRefinedPoints))
+            parent_shading_point->refine_and_offset();
+    }
+
+    // Retrieve assembly tree.
+    const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
+
+    // Drop cached instance transforms if the scene has changed.
+    validate_transform_cache();
+
+    // Check the intersection between the packet and the assembly tree.
+    AssemblyTreePacketIntersector intersector;
+    AssemblyLeafPacketVisitor visitor(
+        packet_shading_points,
+        assembly_tree,
+        m_region_tree_cache,
+        m_triangle_tree_cache,
+        m_curve_tree_cache,
+        m_particle_tree_cache,
+        m_transform_cache,
+        packet_parent_shading_points
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_triangle_tree_traversal_stats
+        , m_curve_tree_traversal_stats
+#endif
+        );
+    intersector.intersect_no_motion(
+        assembly_tree,
+        packet_rays,
+        ray_infos,
+        ray_count,
+        visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_assembly_tree_traversal_stats
+#endif
+        );
+
+    // Detect and report self-intersections.
+    if (m_report_self_intersections)
+    {
+        for (size_t i = 0; i < ray_count; ++i)
+        {
+            report_self_intersection(
+                *packet_shading_points[i],
+                packet_parent_shading_points[i]);
+        }
+    }
+}
+
+void Intersector::trace_probe_packet(
+    const ShadingRay                rays[],
+    const size_t                    indices[],
+    const size_t                    ray_count,
+    bool                            hits[],
+    const ShadingPoint* const       parent_shading_points[]) const
+{
+    const size_t MaxPacketSize = AssemblyTreeProbePacketIntersector::MaxPacketSize;
+    assert(ray_count <= MaxPacketSize);
+
+    // Gather the parent shading points of the packet's rays.
+    const ShadingPoint* packet_parent_shading_points[MaxPacketSize];
+    for (size_t i = 0; i < ray_count; ++i)
+        packet_parent_shading_points[i] = parent_shading_points ? parent_shading_points[indices[i]] : 0;
+
+    // Compute ray infos once for the entire traversal.
+    ShadingRay::RayInfoType ray_infos[MaxPacketSize];
+    for (size_t i = 0; i < ray_count; ++i)
+        ray_infos[i] = ShadingRay::RayInfoType(rays[indices[i]]);
+
+    // Trace incoherent rays one at a time, as well as all rays when the intersection
+    // backend is not the built-in one.
+    if (ray_count == 1 ||
+        m_trace_context.get_backend() ||
+        !AssemblyTreeProbePacketIntersector::is_coherent(ray_infos, ray_count))
+    {
+        for (size_t i = 0; i < ray_count; ++i)
+        {
+            hits[indices[i]] =
+                trace_probe(
+                    rays[indices[i]],
+                    packet_parent_shading_points[i]);
+        }
+
+        return;
+    }
+
+    // Update ray casting statistics.
+    m_probe_ray_count += ray_count;
+    m_packet_ray_count += ray_count;
+
+    const ShadingRay* packet_rays[MaxPacketSize];
+    bool packet_hits[MaxPacketSize];
+
+    for (size_t i = 0; i < ray_count; ++i)
+    {
+        const ShadingPoint* parent_shading_point = packet_parent_shading_points[i];
+
+        assert(is_normalized(rays[indices[i]].m_dir));
+        assert(parent_shading_point == 0 || parent_shading_point->hit());
+
+        packet_hits[i] = false;
+        packet_rays[i] = &rays[indices[i]];
+
+        // Refine and offset the previous intersection point.
+        if (parent_shading_point &&
+            parent_shading_point->hit() &&
+            !(parent_shading_point->m_members & ShadingPoint::HasRefinedPoints))
+            parent_shading_point->refine_and_offset();
+    }
+
+    // Retrieve assembly tree.
+    const AssemblyTree& assembly_tree = m_trace_context.get_assembly_tree();
+
+    // Drop cached instance transforms if the scene has changed.
+    validate_transform_cache();
+
+    // Check the intersection between the packet and the assembly tree.
+    AssemblyTreeProbePacketIntersector intersector;
+    AssemblyLeafProbePacketVisitor visitor(
+        packet_hits,
+        assembly_tree,
+        m_region_tree_cache,
+        m_triangle_tree_cache,
+        m_curve_tree_cache,
+        m_particle_tree_cache,
+        m_transform_cache,
+        packet_parent_shading_points
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_triangle_tree_traversal_stats
+        , m_curve_tree_traversal_stats
+#endif
+        );
+    intersector.intersect_no_motion(
+        assembly_tree,
+        packet_rays,
+        ray_infos,
+        ray_count,
+        visitor
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , m_assembly_tree_traversal_stats
+#endif
+        );
+
+    // Scatter the results back to the rays of the batch.
+    for (size_t i = 0; i < ray_count; ++i)
+        hits[indices[i]] = packet_hits[i];
+}
+
 void Intersector::manufacture_hit(
     ShadingPoint&                       shading_point,
     const ShadingRay&                   shading_ray,
@@ -385,6 +831,20 @@ void Intersector::manufacture_hit(
     shading_point.m_members = 0;
 }
 
+void Intersector::manufacture_miss(
+    ShadingPoint&                       shading_point,
+    const ShadingRay&                   shading_ray) const
+{
+    shading_point.clear();
+
+    // Context.
+    shading_point.m_region_kit_cache = &m_region_kit_cache;
+    shading_point.m_tess_cache = &m_tess_cache;
+    shading_point.m_texture_cache = &m_texture_cache;
+    shading_point.m_scene = &m_trace_context.get_scene();
+    shading_point.m_ray = shading_ray;
+}
+
 namespace
 {
     struct RayCountStatisticsEntry
@@ -442,6 +902,42 @@ StatisticsVector Intersector::get_statistics() const
                 "probe rays",
                 m_probe_ray_count,
                 total_ray_count)));
+    intersection_stats.insert(
+        auto_ptr<RayCountStatisticsEntry>(
+            new RayCountStatisticsEntry(
+                "packet rays",
+                m_packet_ray_count,
+                total_ray_count)));
+
+    intersection_stats.insert(
+        auto_ptr<RayCountStatisticsEntry>(
+            new RayCountStatisticsEntry(
+                "reordered rays",
+                m_reordered_ray_count,
+                total_ray_count)));
+
+    if (m_use_occluder_cache)
+    {
+        intersection_stats.insert(
+            auto_ptr<RayCountStatisticsEntry>(
+                new RayCountStatisticsEntry(
+                    "occluder cache hits",
+                    m_occluder_cache_hit_count,
+                    m_probe_ray_count)));
+    }
+
+    const uint64 transform_cache_access_count =
+        m_transform_cache.get_hit_count() + m_transform_cache.get_miss_count();
+
+    if (transform_cache_access_count > 0)
+    {
+        intersection_stats.insert(
+            auto_ptr<RayCountStatisticsEntry>(
+                new RayCountStatisticsEntry(
+                    "transform cache hits",
+                    m_transform_cache.get_hit_count(),
+                    transform_cache_access_count)));
+    }
 
     StatisticsVector vec;
 
@@ -465,6 +961,10 @@ StatisticsVector Intersector::get_statistics() const
         "triangle tree access cache statistics",
         make_dual_stage_cache_stats(m_triangle_tree_cache));
 
+    vec.insert(
+        "particle tree access cache statistics",
+        make_dual_stage_cache_stats(m_particle_tree_cache));
+
     vec.insert(
         "region kit access cache statistics",
         make_dual_stage_cache_stats(m_region_kit_cache));
@@ -473,6 +973,8 @@ StatisticsVector Intersector::get_statistics() const
         "tessellation access cache statistics",
         make_dual_stage_cache_stats(m_tess_cache));
 
+    vec.merge(m_profiler.get_statistics());
+
     return vec;
 }
 
@@ -31,13 +31,18 @@
 #define APPLESEED_RENDERER_KERNEL_INTERSECTION_INTERSECTOR_H
 
 // appleseed.renderer headers.
+#include "renderer/kernel/intersection/assemblytree.h"
 #include "renderer/kernel/intersection/curvetree.h"
+#include "renderer/kernel/intersection/intersectionprofiler.h"
 #include "renderer/kernel/intersection/intersectionsettings.h"
+#include "renderer/kernel/intersection/particletree.h"
+#include "renderer/kernel/intersection/rayorderer.h"
 #include "renderer/kernel/intersection/regiontree.h"
 #include "renderer/kernel/intersection/triangletree.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/kernel/tessellation/statictessellation.h"
 #include "renderer/modeling/object/regionkit.h"
+#include "renderer/utility/transformsequence.h"
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
@@ -45,6 +50,7 @@
 #include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/types.h"
+#include "foundation/utility/version.h"
 
 // Standard headers.
 #include <cstddef>
@@ -68,10 +74,17 @@ class Intersector
 {
   public:
     // Constructor, binds the intersector to a given trace context.
+    // If 'use_occluder_cache' is true, the last triangle that blocked a probe ray
+    // is remembered per direction bin and tested first by subsequent probe rays
+    // going in a similar direction (for instance, shadow rays toward a given light).
+    // If 'profiling_period' is not 0, one out of every 'profiling_period' rays is
+    // profiled and the results are reported in the statistics of the intersector.
     Intersector(
         const TraceContext&             trace_context,
         TextureCache&                   texture_cache,
-        const bool                      report_self_intersections = false);
+        const bool                      report_self_intersections = false,
+        const bool                      use_occluder_cache = false,
+        const size_t                    profiling_period = 0);
 
     // Refine the location of a point on a surface.
     static foundation::Vector3d refine(
@@ -92,6 +105,15 @@ class Intersector
         foundation::Vector3d&           front,
         foundation::Vector3d&           back);
 
+    // Offset a point of a triangle away from it by a bound on the rounding error of
+    // single precision ray-triangle tests performed by rays leaving that point.
+    static void error_bounded_offset(
+        const TriangleSupportPlaneType& support_plane,
+        const foundation::Vector3d&     p,
+        foundation::Vector3d            n,
+        foundation::Vector3d&           front,
+        foundation::Vector3d&           back);
+
     // Trace a world space ray through the scene.
     bool trace(
         const ShadingRay&               ray,
@@ -103,6 +125,25 @@ class Intersector
         const ShadingRay&               ray,
         const ShadingPoint*             parent_shading_point = 0) const;
 
+    // Trace a batch of world space rays through the scene. Batches larger than
+    // a packet are first reordered by direction and origin locality (results are
+    // still returned in the order of the rays). Rays are then traced in packets
+    // when their directions are coherent, one at a time otherwise.
+    // 'parent_shading_points' may be null, or contain one entry (possibly null) per ray.
+    void trace(
+        const ShadingRay                rays[],
+        const size_t                    ray_count,
+        ShadingPoint                    shading_points[],
+        const ShadingPoint* const       parent_shading_points[] = 0) const;
+
+    // Trace a batch of world space probe rays through the scene.
+    // hits[i] is set to true if rays[i] hit the scene, false otherwise.
+    void trace_probe(
+        const ShadingRay                rays[],
+        const size_t                    ray_count,
+        bool                            hits[],
+        const ShadingPoint* const       parent_shading_points[] = 0) const;
+
     // Manufacture a hit "by hand".
     // There is no restriction placed on the shading point passed to this method.
     // For instance it may have been previously initialized and used.
@@ -118,31 +159,95 @@ class Intersector
         const size_t                        primitive_index,
         const TriangleSupportPlaneType&     triangle_support_plane) const;
 
+    // Manufacture a miss "by hand", as if a ray had been traced and escaped the scene.
+    void manufacture_miss(
+        ShadingPoint&                       shading_point,
+        const ShadingRay&                   shading_ray) const;
+
     // Retrieve performance statistics.
     foundation::StatisticsVector get_statistics() const;
+    foundation::uint64 get_shading_ray_count() const;
+    foundation::uint64 get_probe_ray_count() const;
 
   private:
     const TraceContext&                             m_trace_context;
     TextureCache&                                   m_texture_cache;
     const bool                                      m_report_self_intersections;
+    const bool                                      m_use_occluder_cache;
 
     // Access caches.
     mutable RegionTreeAccessCache                   m_region_tree_cache;
     mutable TriangleTreeAccessCache                 m_triangle_tree_cache;
     mutable CurveTreeAccessCache                    m_curve_tree_cache;
+    mutable ParticleTreeAccessCache                 m_particle_tree_cache;
     mutable RegionKitAccessCache                    m_region_kit_cache;
     mutable StaticTriangleTessAccessCache           m_tess_cache;
 
+    // Transforms of moving assembly instances, invalidated when the trace context changes.
+    mutable TransformSequenceCache                  m_transform_cache;
+    mutable foundation::VersionID                   m_transform_cache_version_id;
+
+    // Trace order of the current batch of rays.
+    mutable RayOrderer                              m_ray_orderer;
+
+    // Occluder cache: 6 cube faces subdivided into a grid of direction bins.
+    enum { OccluderCacheGridSize = 4 };
+    enum { OccluderCacheSize = 6 * OccluderCacheGridSize * OccluderCacheGridSize };
+    mutable ProbeOccluder                           m_occluder_cache[OccluderCacheSize];
+
     // Intersection statistics.
     mutable foundation::uint64                      m_shading_ray_count;
     mutable foundation::uint64                      m_probe_ray_count;
+    mutable foundation::uint64                      m_packet_ray_count;
+    mutable foundation::uint64                      m_reordered_ray_count;
+    mutable foundation::uint64                      m_occluder_cache_hit_count;
+    mutable IntersectionProfiler                    m_profiler;
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
     mutable foundation::bvh::TraversalStatistics    m_assembly_tree_traversal_stats;
     mutable foundation::bvh::TraversalStatistics    m_triangle_tree_traversal_stats;
     mutable foundation::bvh::TraversalStatistics    m_curve_tree_traversal_stats;
 #endif
+
+    static size_t get_occluder_cache_slot(const foundation::Vector3d& direction);
+
+    void validate_transform_cache() const;
+
+    void order_rays(
+        const ShadingRay                rays[],
+        const size_t                    ray_count,
+        const size_t                    packet_size) const;
+
+    // Trace the rays rays[indices[0]] ... rays[indices[ray_count - 1]] as a packet.
+    void trace_packet(
+        const ShadingRay                rays[],
+        const size_t                    indices[],
+        const size_t                    ray_count,
+        ShadingPoint                    shading_points[],
+        const ShadingPoint* const       parent_shading_points[]) const;
+
+    void trace_probe_packet(
+        const ShadingRay                rays[],
+        const size_t                    indices[],
+        const size_t                    ray_count,
+        bool                            hits[],
+        const ShadingPoint* const       parent_shading_points[]) const;
 };
 
+
+//
+// Intersector class implementation.
+//
+
+inline foundation::uint64 Intersector::get_shading_ray_count() const
+{
+    return m_shading_ray_count;
+}
+
+inline foundation::uint64 Intersector::get_probe_ray_count() const
+{
+    return m_probe_ray_count;
+}
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_KERNEL_INTERSECTION_INTERSECTOR_H
@@ -0,0 +1,235 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "particletree.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/particleobject.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/permutation.h"
+#include "foundation/math/transform.h"
+#include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
+#include "foundation/utility/alignedallocator.h"
+#include "foundation/utility/api/apistring.h"
+#include "foundation/utility/eventtracer.h"
+#include "foundation/utility/memory.h"
+#include "foundation/utility/statistics.h"
+#include "foundation/utility/stopwatch.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// ParticleTree class implementation.
+//
+
+ParticleTree::Arguments::Arguments(
+    const Scene&            scene,
+    const UniqueID          particle_tree_uid,
+    const GAABB3&           bbox,
+    const Assembly&         assembly)
+  : m_scene(scene)
+  , m_particle_tree_uid(particle_tree_uid)
+  , m_bbox(bbox)
+  , m_assembly(assembly)
+{
+}
+
+ParticleTree::ParticleTree(const Arguments& arguments)
+  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size(), true))
+  , m_arguments(arguments)
+{
+    ScopedTraceEvent event("particle tree build", "intersection");
+
+    // Start stopwatch.
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    // Build the tree.
+    Statistics statistics;
+    build_bvh(statistics);
+
+    // Print particle tree statistics.
+    statistics.insert_size("particles size", m_particles.size() * sizeof(Particle));
+    statistics.insert_size("keys size", m_particle_keys.size() * sizeof(ParticleKey));
+    statistics.insert_size("nodes size", m_nodes.size() * sizeof(NodeType));
+    statistics.insert("large pages", advise_large_pages(m_nodes) + advise_large_pages(m_particles));
+    statistics.insert_time("total time", stopwatch.measure().get_seconds());
+    RENDERER_LOG_DEBUG("%s",
+        StatisticsVector::make(
+            "particle tree #" + to_string(m_arguments.m_particle_tree_uid) + " statistics",
+            statistics).to_string().c_str());
+}
+
+void ParticleTree::collect_particles(vector<GAABB3>& particle_bboxes)
+{
+    const ObjectInstanceContainer& object_instances = m_arguments.m_assembly.object_instances();
+
+    for (size_t i = 0; i < object_instances.size(); ++i)
+    {
+        // Retrieve the object instance.
+        const ObjectInstance* object_instance = object_instances.get_by_index(i);
+        assert(object_instance);
+
+        // Retrieve the object.
+        const Object& object = object_instance->get_object();
+
+        // Process only particle objects.
+        if (strcmp(object.get_model(), ParticleObjectFactory::get_model()))
+            continue;
+
+        const ParticleObject& particle_object = static_cast<const ParticleObject&>(object);
+
+        // Retrieve the object instance transform. Particles remain spheres or disks:
+        // radii are scaled by the average scaling factor of the transform.
+        const Transformd& transform = object_instance->get_transform();
+        const double radius_scale =
+            pow(
+                norm(transform.vector_to_parent(Vector3d(1.0, 0.0, 0.0))) *
+                norm(transform.vector_to_parent(Vector3d(0.0, 1.0, 0.0))) *
+                norm(transform.vector_to_parent(Vector3d(0.0, 0.0, 1.0))),
+                1.0 / 3.0);
+
+        // Disks are told apart from spheres by the sign of their radius.
+        const double radius_sign =
+            particle_object.get_shape() == ParticleObject::ShapeDisk ? -1.0 : 1.0;
+
+        // Store particles, particle keys and particle bounding boxes.
+        const size_t particle_count = particle_object.get_particle_count();
+        for (size_t j = 0; j < particle_count; ++j)
+        {
+            const Vector3d center =
+                transform.point_to_parent(Vector3d(particle_object.get_particle_center(j)));
+            const double radius =
+                radius_scale * static_cast<double>(particle_object.get_particle_radius(j));
+
+            Particle particle;
+            particle.m_center = GVector3(center);
+            particle.m_radius = static_cast<GScalar>(radius_sign * radius);
+            m_particles.push_back(particle);
+
+            ParticleKey particle_key;
+            particle_key.m_object_instance_index = static_cast<uint32>(i);
+            particle_key.m_particle_index = static_cast<uint32>(j);
+            m_particle_keys.push_back(particle_key);
+
+            GAABB3 bbox;
+            bbox.min = GVector3(center - Vector3d(radius));
+            bbox.max = GVector3(center + Vector3d(radius));
+            particle_bboxes.push_back(bbox);
+        }
+    }
+}
+
+void ParticleTree::build_bvh(Statistics& statistics)
+{
+    // Collect particles for this tree.
+    RENDERER_LOG_INFO(
+        "collecting geometry for particle tree #" FMT_UNIQUE_ID " from assembly \"%s\"...",
+        m_arguments.m_particle_tree_uid,
+        m_arguments.m_assembly.get_path().c_str());
+    vector<GAABB3> particle_bboxes;
+    collect_particles(particle_bboxes);
+
+    // Print statistics about the input geometry.
+    const size_t particle_count = m_particles.size();
+    RENDERER_LOG_INFO(
+        "building particle tree #" FMT_UNIQUE_ID " (bvh, %s %s)...",
+        m_arguments.m_particle_tree_uid,
+        pretty_uint(particle_count).c_str(),
+        plural(particle_count, "particle").c_str());
+
+    // Create the partitioner.
+    typedef bvh::SAHPartitioner<vector<GAABB3> > Partitioner;
+    Partitioner partitioner(
+        particle_bboxes,
+        ParticleTreeDefaultMaxLeafSize,
+        ParticleTreeDefaultInteriorNodeTraversalCost,
+        ParticleTreeDefaultParticleIntersectionCost);
+
+    // Build the tree.
+    typedef bvh::Builder<ParticleTree, Partitioner> Builder;
+    Builder builder;
+    builder.build<DefaultWallclockTimer>(
+        *this,
+        partitioner,
+        particle_count,
+        ParticleTreeDefaultMaxLeafSize);
+    statistics.merge(
+        bvh::TreeStatistics<ParticleTree>(*this, m_arguments.m_bbox));
+
+    // The bounding boxes are not needed anymore.
+    clear_release_memory(particle_bboxes);
+
+    // Store the particles in the order of the leaves of the tree.
+    if (particle_count > 0)
+    {
+        const vector<size_t>& ordering = partitioner.get_item_ordering();
+        vector<Particle> temp_particles(particle_count);
+        small_item_reorder(&m_particles[0], &temp_particles[0], &ordering[0], particle_count);
+        vector<ParticleKey> temp_keys(particle_count);
+        small_item_reorder(&m_particle_keys[0], &temp_keys[0], &ordering[0], particle_count);
+    }
+}
+
+
+//
+// ParticleTreeFactory class implementation.
+//
+
+ParticleTreeFactory::ParticleTreeFactory(const ParticleTree::Arguments& arguments)
+  : m_arguments(arguments)
+{
+}
+
+auto_ptr<ParticleTree> ParticleTreeFactory::create()
+{
+    return auto_ptr<ParticleTree>(new ParticleTree(m_arguments));
+}
+
+}   // namespace renderer
@@ -0,0 +1,363 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_RENDERER_KERNEL_INTERSECTION_PARTICLETREE_H
+#define APPLESEED_RENDERER_KERNEL_INTERSECTION_PARTICLETREE_H
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
+#include "renderer/kernel/intersection/probevisitorbase.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/bvh.h"
+#include "foundation/math/intersection/raysphere.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/alignedvector.h"
+#include "foundation/utility/lazy.h"
+#include "foundation/utility/poolallocator.h"
+#include "foundation/utility/uid.h"
+
+// Standard headers.
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class Statistics; }
+namespace renderer      { class Assembly; }
+namespace renderer      { class ParamArray; }
+namespace renderer      { class Scene; }
+
+namespace renderer
+{
+
+//
+// Particle tree.
+//
+// Particles are stored in assembly space, in the order of the leaves of the tree,
+// so that a leaf only needs its item range to find them. Each particle takes 16
+// bytes (24 with double precision geometry) plus 8 bytes for its key.
+//
+
+class ParticleTree
+  : public foundation::bvh::Tree<
+               foundation::AlignedVector<
+                   foundation::bvh::Node<GAABB3>
+               >
+           >
+{
+  public:
+    // Construction arguments.
+    struct Arguments
+    {
+        const Scene&                            m_scene;
+        const foundation::UniqueID              m_particle_tree_uid;
+        const GAABB3                            m_bbox;
+        const Assembly&                         m_assembly;
+
+        // Constructor.
+        Arguments(
+            const Scene&                        scene,
+            const foundation::UniqueID          particle_tree_uid,
+            const GAABB3&                       bbox,
+            const Assembly&                     assembly);
+    };
+
+    // Constructor, builds the tree for a given assembly.
+    explicit ParticleTree(const Arguments& arguments);
+
+  private:
+    friend class ParticleLeafVisitor;
+    friend class ParticleLeafProbeVisitor;
+
+    // A particle in assembly space. Disks facing incoming rays have a negative radius.
+    struct Particle
+    {
+        GVector3            m_center;
+        GScalar             m_radius;
+    };
+
+    // The particle of a given object instance a tree particle comes from.
+    struct ParticleKey
+    {
+        foundation::uint32  m_object_instance_index;
+        foundation::uint32  m_particle_index;
+    };
+
+    const Arguments             m_arguments;
+    std::vector<Particle>       m_particles;
+    std::vector<ParticleKey>    m_particle_keys;
+
+    // Collect the particles of the assembly, and their bounding boxes.
+    void collect_particles(std::vector<GAABB3>& particle_bboxes);
+
+    void build_bvh(foundation::Statistics& statistics);
+};
+
+
+//
+// Particle tree factory.
+//
+
+class ParticleTreeFactory
+  : public foundation::ILazyFactory<ParticleTree>
+{
+  public:
+    // Constructor.
+    explicit ParticleTreeFactory(
+        const ParticleTree::Arguments&  arguments);
+
+    // Create the particle tree.
+    virtual std::auto_ptr<ParticleTree> create();
+
+  private:
+    const ParticleTree::Arguments       m_arguments;
+};
+
+
+//
+// Some additional types.
+//
+
+// Particle tree container and iterator types.
+typedef std::map<
+    foundation::UniqueID,
+    foundation::Lazy<ParticleTree>*
+> ParticleTreeContainer;
+typedef ParticleTreeContainer::iterator ParticleTreeIterator;
+typedef ParticleTreeContainer::const_iterator ParticleTreeConstIterator;
+
+// Particle tree access cache type.
+typedef foundation::AccessCacheMap<
+    ParticleTreeContainer,
+    ParticleTreeAccessCacheLines,
+    ParticleTreeAccessCacheWays,
+    foundation::PoolAllocator<void, ParticleTreeAccessCacheLines * ParticleTreeAccessCacheWays>
+> ParticleTreeAccessCache;
+
+
+//
+// Particle leaf visitor, used during tree intersection.
+//
+
+class ParticleLeafVisitor
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    ParticleLeafVisitor(
+        const ParticleTree&                     tree,
+        ShadingPoint&                           shading_point);
+
+    // Visit a leaf.
+    bool visit(
+        const ParticleTree::NodeType&           node,
+        const GRay3&                            ray,
+        const GRayInfo3&                        ray_info,
+        GScalar&                                distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        );
+
+  private:
+    const ParticleTree&                         m_tree;
+    ShadingPoint&                               m_shading_point;
+};
+
+
+//
+// Particle leaf visitor for probe rays, only return boolean answers
+// (whether an intersection was found or not).
+//
+
+class ParticleLeafProbeVisitor
+  : public ProbeVisitorBase
+{
+  public:
+    // Constructor.
+    explicit ParticleLeafProbeVisitor(
+        const ParticleTree&                     tree);
+
+    // Visit a leaf.
+    bool visit(
+        const ParticleTree::NodeType&           node,
+        const GRay3&                            ray,
+        const GRayInfo3&                        ray_info,
+        GScalar&                                distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+        , foundation::bvh::TraversalStatistics& stats
+#endif
+        );
+
+  private:
+    const ParticleTree&                         m_tree;
+};
+
+
+//
+// Particle tree intersectors.
+//
+
+typedef foundation::bvh::Intersector<
+    ParticleTree,
+    ParticleLeafVisitor,
+    GRay3,
+    ParticleTreeStackSize
+> ParticleTreeIntersector;
+
+typedef foundation::bvh::Intersector<
+    ParticleTree,
+    ParticleLeafProbeVisitor,
+    GRay3,
+    ParticleTreeStackSize
+> ParticleTreeProbeIntersector;
+
+
+//
+// ParticleLeafVisitor class implementation.
+//
+
+inline ParticleLeafVisitor::ParticleLeafVisitor(
+    const ParticleTree&                         tree,
+    ShadingPoint&                               shading_point)
+  : m_tree(tree)
+  , m_shading_point(shading_point)
+{
+}
+
+inline bool ParticleLeafVisitor::visit(
+    const ParticleTree::NodeType&               node,
+    const GRay3&                                ray,
+    const GRayInfo3&                            ray_info,
+    GScalar&                                    distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&     stats
+#endif
+    )
+{
+    const size_t particle_index = node.get_item_index();
+    const size_t particle_count = node.get_item_count();
+
+    // Only look for hits closer than the closest hit so far.
+    GRay3 closest_ray(ray);
+    closest_ray.m_tmax = static_cast<GScalar>(m_shading_point.m_ray.m_tmax);
+
+    size_t hit_particle_index = ~0;
+
+    for (size_t i = 0; i < particle_count; ++i)
+    {
+        const ParticleTree::Particle& particle = m_tree.m_particles[particle_index + i];
+
+        GScalar t;
+        const bool hit =
+            particle.m_radius >= GScalar(0.0)
+                ? foundation::intersect_sphere(closest_ray, particle.m_center, particle.m_radius, t)
+                : foundation::intersect_facing_disk(closest_ray, particle.m_center, -particle.m_radius, t);
+
+        if (hit)
+        {
+            closest_ray.m_tmax = t;
+            hit_particle_index = particle_index + i;
+        }
+    }
+
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(particle_count));
+
+    if (hit_particle_index != size_t(~0))
+    {
+        const ParticleTree::ParticleKey& particle_key = m_tree.m_particle_keys[hit_particle_index];
+        m_shading_point.m_primitive_type = ShadingPoint::PrimitiveParticle;
+        m_shading_point.m_ray.m_tmax = static_cast<double>(closest_ray.m_tmax);
+        m_shading_point.m_object_instance_index = particle_key.m_object_instance_index;
+        m_shading_point.m_primitive_index = particle_key.m_particle_index;
+    }
+
+    // Continue traversal.
+    distance = static_cast<GScalar>(m_shading_point.m_ray.m_tmax);
+    return true;
+}
+
+
+//
+// ParticleLeafProbeVisitor class implementation.
+//
+
+inline ParticleLeafProbeVisitor::ParticleLeafProbeVisitor(
+    const ParticleTree&                         tree)
+  : m_tree(tree)
+{
+}
+
+inline bool ParticleLeafProbeVisitor::visit(
+    const ParticleTree::NodeType&               node,
+    const GRay3&                                ray,
+    const GRayInfo3&                            ray_info,
+    GScalar&                                    distance
+#ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
+    , foundation::bvh::TraversalStatistics&     stats
+#endif
+    )
+{
+    const size_t particle_index = node.get_item_index();
+    const size_t particle_count = node.get_item_count();
+
+    for (size_t i = 0; i < particle_count; ++i)
+    {
+        const ParticleTree::Particle& particle = m_tree.m_particles[particle_index + i];
+
+        GScalar t;
+        const bool hit =
+            particle.m_radius >= GScalar(0.0)
+                ? foundation::intersect_sphere(ray, particle.m_center, particle.m_radius)
+                : foundation::intersect_facing_disk(ray, particle.m_center, -particle.m_radius, t);
+
+        if (hit)
+        {
+            FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(i + 1));
+            m_hit = true;
+            return false;
+        }
+    }
+
+    FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(particle_count));
+
+    // Continue traversal.
+    distance = ray.m_tmax;
+    return true;
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_INTERSECTION_PARTICLETREE_H
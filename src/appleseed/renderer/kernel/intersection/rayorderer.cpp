@@ -0,0 +1,128 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "rayorderer.h"
+
+// appleseed.renderer headers.
+#include "renderer/kernel/shading/shadingray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <algorithm>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    // Spread the 10 low bits of x so that there are two zero bits between each of them.
+    uint32 spread_bits(uint32 x)
+    {
+        x &= 0x000003FF;
+        x = (x | (x << 16)) & 0xFF0000FF;
+        x = (x | (x << 8))  & 0x0300F00F;
+        x = (x | (x << 4))  & 0x030C30C3;
+        x = (x | (x << 2))  & 0x09249249;
+        return x;
+    }
+
+    uint32 quantize(const double value, const double min_value, const double max_value)
+    {
+        const uint32 MaxValue = (1UL << RayOrderer::OriginBits) - 1;
+        const double extent = max_value - min_value;
+
+        if (!(extent > 0.0))
+            return 0;
+
+        const double x = (value - min_value) / extent;
+        return min(truncate<uint32>(saturate(x) * (MaxValue + 1)), MaxValue);
+    }
+}
+
+uint32 RayOrderer::compute_key(
+    const Vector3d&                 origin,
+    const Vector3d&                 direction,
+    const AABB3d&                   origin_bbox)
+{
+    const uint32 octant =
+        (direction[0] < 0.0 ? 1 : 0) |
+        (direction[1] < 0.0 ? 2 : 0) |
+        (direction[2] < 0.0 ? 4 : 0);
+
+    const uint32 morton =
+        (spread_bits(quantize(origin[0], origin_bbox.min[0], origin_bbox.max[0])) << 2) |
+        (spread_bits(quantize(origin[1], origin_bbox.min[1], origin_bbox.max[1])) << 1) |
+        (spread_bits(quantize(origin[2], origin_bbox.min[2], origin_bbox.max[2])) << 0);
+
+    return (octant << (3 * OriginBits)) | morton;
+}
+
+void RayOrderer::sort(
+    const ShadingRay                rays[],
+    const size_t                    ray_count)
+{
+    AABB3d origin_bbox;
+    origin_bbox.invalidate();
+
+    for (size_t i = 0; i < ray_count; ++i)
+        origin_bbox.insert(rays[i].m_org);
+
+    // Keys go in the high half of 64-bit integers and ray indices in the low
+    // half, so that sorting the integers sorts the rays and breaks ties by index.
+    m_keys.resize(ray_count);
+
+    for (size_t i = 0; i < ray_count; ++i)
+    {
+        const uint64 key = compute_key(rays[i].m_org, rays[i].m_dir, origin_bbox);
+        m_keys[i] = (key << 32) | static_cast<uint64>(i);
+    }
+
+    std::sort(m_keys.begin(), m_keys.end());
+
+    m_order.resize(ray_count);
+
+    for (size_t i = 0; i < ray_count; ++i)
+        m_order[i] = static_cast<size_t>(m_keys[i] & 0xFFFFFFFFUL);
+}
+
+void RayOrderer::keep(const size_t ray_count)
+{
+    m_order.resize(ray_count);
+
+    for (size_t i = 0; i < ray_count; ++i)
+        m_order[i] = i;
+}
+
+}   // namespace renderer
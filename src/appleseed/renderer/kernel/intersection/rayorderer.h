@@ -0,0 +1,112 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_RENDERER_KERNEL_INTERSECTION_RAYORDERER_H
+#define APPLESEED_RENDERER_KERNEL_INTERSECTION_RAYORDERER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace renderer      { class ShadingRay; }
+
+namespace renderer
+{
+
+//
+// Computes the order in which to trace a batch of rays.
+//
+// Rays are sorted by direction octant first, then along a Morton curve through
+// the bounding box of their origins. Consecutive rays therefore go in the same
+// general direction and start close to each other, which makes packets built
+// from them coherent and keeps the nodes of the acceleration structures they
+// visit warm in the caches.
+//
+// The order only depends on the rays, and ties are broken by ray index.
+//
+
+class RayOrderer
+  : public foundation::NonCopyable
+{
+  public:
+    // Number of bits per axis of the quantized ray origins.
+    enum { OriginBits = 10 };
+
+    // Compute the sort key of a ray whose origin lies within a given bounding box.
+    static foundation::uint32 compute_key(
+        const foundation::Vector3d&     origin,
+        const foundation::Vector3d&     direction,
+        const foundation::AABB3d&       origin_bbox);
+
+    // Sort a batch of rays.
+    void sort(
+        const ShadingRay                rays[],
+        const size_t                    ray_count);
+
+    // Keep a batch of rays in its original order.
+    void keep(const size_t ray_count);
+
+    // Return the index of the i'th ray to trace.
+    size_t operator[](const size_t i) const;
+
+    // Return the order as an array of ray indices.
+    const size_t* get_order() const;
+
+  private:
+    std::vector<foundation::uint64>     m_keys;
+    std::vector<size_t>                 m_order;
+};
+
+
+//
+// RayOrderer class implementation.
+//
+
+inline size_t RayOrderer::operator[](const size_t i) const
+{
+    assert(i < m_order.size());
+    return m_order[i];
+}
+
+inline const size_t* RayOrderer::get_order() const
+{
+    return m_order.empty() ? 0 : &m_order[0];
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_INTERSECTION_RAYORDERER_H
@@ -47,6 +47,7 @@
 #include "foundation/math/aabb.h"
 #include "foundation/math/split.h"
 #include "foundation/math/transform.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/memory.h"
 #include "foundation/utility/string.h"
@@ -424,6 +425,8 @@ RegionTree::Arguments::Arguments(
 RegionTree::RegionTree(const Arguments& arguments)
   : m_assembly_uid(arguments.m_assembly_uid)
 {
+    ScopedTraceEvent event("region tree build", "intersection");
+
     // Build the intermediate representation of the tree.
     IntermRegionTree interm_tree(arguments);
 
@@ -533,6 +536,8 @@ double RegionLeafVisitor::visit(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                 , m_triangle_tree_stats
 #endif
+                , 0
+                , ray.m_flags
                 );
         }
         else
@@ -545,6 +550,8 @@ double RegionLeafVisitor::visit(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                 , m_triangle_tree_stats
 #endif
+                , 0
+                , ray.m_flags
                 );
         }
         visitor.read_hit_triangle_data();
@@ -588,6 +595,8 @@ double RegionLeafProbeVisitor::visit(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                 , m_triangle_tree_stats
 #endif
+                , 0
+                , ray.m_flags
                 );
         }
         else
@@ -600,6 +609,8 @@ double RegionLeafProbeVisitor::visit(
 #ifdef FOUNDATION_BVH_ENABLE_TRAVERSAL_STATS
                 , m_triangle_tree_stats
 #endif
+                , 0
+                , ray.m_flags
                 );
         }
 
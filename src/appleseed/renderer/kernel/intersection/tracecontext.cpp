@@ -33,6 +33,7 @@
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
 #include "renderer/kernel/intersection/assemblytree.h"
+#include "renderer/kernel/intersection/iintersectionbackend.h"
 #include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/intersection/regioninfo.h"
 #include "renderer/kernel/intersection/trianglekey.h"
@@ -60,6 +61,8 @@ namespace renderer
 TraceContext::TraceContext(const Scene& scene)
   : m_scene(scene)
   , m_assembly_tree(new AssemblyTree(scene))
+  , m_backend(0)
+  , m_version_id(0)
 {
     RENDERER_LOG_DEBUG(
         "data structures size:\n"
@@ -81,12 +84,37 @@ TraceContext::TraceContext(const Scene& scene)
 
 TraceContext::~TraceContext()
 {
+    if (m_backend)
+        m_backend->release();
+
     delete m_assembly_tree;
 }
 
+void TraceContext::set_backend(auto_release_ptr<IIntersectionBackend> backend)
+{
+    if (m_backend)
+        m_backend->release();
+
+    m_backend = backend.release();
+}
+
 void TraceContext::update()
 {
+    // The built-in acceleration structures are kept up-to-date even if another
+    // intersection backend is used, so that switching back to them is cheap.
     m_assembly_tree->update();
+
+    if (m_backend)
+        m_backend->update();
+
+    ++m_version_id;
+}
+
+void TraceContext::set_camera_frustum(const Frustum<double, 4>* frustum)
+{
+    m_assembly_tree->set_camera_frustum(frustum);
+
+    ++m_version_id;
 }
 
 }   // namespace renderer
@@ -32,12 +32,16 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/frustum.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/version.h"
 
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
 // Forward declarations.
 namespace renderer  { class AssemblyTree; }
+namespace renderer  { class IIntersectionBackend; }
 namespace renderer  { class Scene; }
 
 namespace renderer
@@ -66,12 +70,30 @@ class APPLESEED_DLLSYMBOL TraceContext
     // Get the assembly tree.
     const AssemblyTree& get_assembly_tree() const;
 
+    // Set the intersection backend, or pass a null pointer to use the built-in one.
+    // Must not be called while rays are being traced.
+    void set_backend(foundation::auto_release_ptr<IIntersectionBackend> backend);
+
+    // Get the intersection backend. Returns 0 if the built-in one is used.
+    const IIntersectionBackend* get_backend() const;
+
     // Synchronize the trace context with the scene.
     void update();
 
+    // Let camera rays skip the parts of the scene outside of a world space frustum enclosing
+    // all of them, or stop culling if 'frustum' is null. Only affects the built-in acceleration
+    // structures. Must not be called while rays are being traced.
+    void set_camera_frustum(const foundation::Frustum<double, 4>* frustum);
+
+    // Return an identifier that changes whenever the result of tracing a given ray may change,
+    // i.e. every time the trace context is updated or the camera frustum is set.
+    foundation::VersionID get_version_id() const;
+
   private:
-    const Scene&    m_scene;
-    AssemblyTree*   m_assembly_tree;
+    const Scene&            m_scene;
+    AssemblyTree*           m_assembly_tree;
+    IIntersectionBackend*   m_backend;
+    foundation::VersionID   m_version_id;
 };
 
 
@@ -89,6 +111,16 @@ inline const AssemblyTree& TraceContext::get_assembly_tree() const
     return *m_assembly_tree;
 }
 
+inline const IIntersectionBackend* TraceContext::get_backend() const
+{
+    return m_backend;
+}
+
+inline foundation::VersionID TraceContext::get_version_id() const
+{
+    return m_version_id;
+}
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_KERNEL_INTERSECTION_TRACECONTEXT_H
@@ -35,70 +35,435 @@
 #include "renderer/kernel/intersection/trianglevertexinfo.h"
 
 // appleseed.foundation headers.
-#include "foundation/platform/types.h"
+#include "foundation/math/scalar.h"
 #include "foundation/utility/memory.h"
 
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 using namespace foundation;
 using namespace std;
 
 namespace renderer
 {
 
+namespace
+{
+    // Size in bytes of the per-triangle record of indexed and quantized leaves:
+    // visibility flags followed by three 8-bit vertex indices and one byte of padding.
+    const size_t IndexedTriangleSize = sizeof(uint32) + 4 * sizeof(uint8);
+
+    // Size in bytes of a group of triangles of packed leaves: visibility flags followed by the triangles.
+    const size_t PackedGroupSize = GTriangle4Type::Width * sizeof(uint32) + sizeof(GTriangle4Type);
+
+    // Largest quantized coordinate.
+    const double MaxQuantizedCoordinate = 65535.0;
+
+    size_t align_to_uint32(const size_t size)
+    {
+        return (size + sizeof(uint32) - 1) & ~(sizeof(uint32) - 1);
+    }
+
+    bool has_moving_triangles(
+        const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+        const vector<size_t>&               triangle_indices,
+        const size_t                        item_begin,
+        const size_t                        item_count)
+    {
+        for (size_t i = 0; i < item_count; ++i)
+        {
+            const size_t triangle_index = triangle_indices[item_begin + i];
+            if (triangle_vertex_infos[triangle_index].m_motion_segment_count > 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    // Collect the distinct vertices of a leaf of static triangles. Return false
+    // if there are more than TriangleEncoder::MaxLeafVertexCount of them.
+    bool collect_leaf_vertices(
+        const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+        const vector<GVector3>&             triangle_vertices,
+        const vector<size_t>&               triangle_indices,
+        const size_t                        item_begin,
+        const size_t                        item_count,
+        vector<GVector3>&                   vertices,
+        vector<uint8>&                      vertex_indices)
+    {
+        vertices.clear();
+        vertex_indices.clear();
+
+        for (size_t i = 0; i < item_count; ++i)
+        {
+            const size_t triangle_index = triangle_indices[item_begin + i];
+            const TriangleVertexInfo& vertex_info = triangle_vertex_infos[triangle_index];
+
+            for (size_t j = 0; j < 3; ++j)
+            {
+                const GVector3& vertex = triangle_vertices[vertex_info.m_vertex_index + j];
+
+                size_t index = 0;
+                while (index < vertices.size() && vertices[index] != vertex)
+                    ++index;
+
+                if (index == vertices.size())
+                {
+                    if (vertices.size() == TriangleEncoder::MaxLeafVertexCount)
+                        return false;
+                    vertices.push_back(vertex);
+                }
+
+                vertex_indices.push_back(static_cast<uint8>(index));
+            }
+        }
+
+        return true;
+    }
+
+    // Quantize the vertices of a leaf on a 16-bit grid such that the cell of
+    // each quantized vertex contains the original vertex. Return false if the
+    // extent of the leaf is too small or too large for such a grid to exist.
+    bool quantize_leaf_vertices(
+        const vector<GVector3>&             vertices,
+        GVector3&                           origin,
+        GVector3&                           scale,
+        vector<uint16>&                     quantized_vertices)
+    {
+        GAABB3 bbox;
+        bbox.invalidate();
+
+        for (size_t i = 0; i < vertices.size(); ++i)
+            bbox.insert(vertices[i]);
+
+        for (size_t d = 0; d < 3; ++d)
+        {
+            origin[d] = bbox.min[d];
+            const GScalar extent = bbox.max[d] - bbox.min[d];
+            scale[d] = extent > GScalar(0.0)
+                ? static_cast<GScalar>(extent / (MaxQuantizedCoordinate - 1.0))
+                : static_cast<GScalar>(max(abs(origin[d]), GScalar(1.0)) * numeric_limits<GScalar>::epsilon());
+            if (!(scale[d] > GScalar(0.0)))
+                return false;
+        }
+
+        quantized_vertices.resize(3 * vertices.size());
+
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            uint16 q[3];
+
+            for (size_t d = 0; d < 3; ++d)
+            {
+                const double o = static_cast<double>(origin[d]);
+                const double s = static_cast<double>(scale[d]);
+                const double v = static_cast<double>(vertices[i][d]);
+
+                // Rounding may put the vertex in a neighboring cell: fix it up.
+                double c = floor((v - o) / s);
+                if (o + c * s > v)
+                    c -= 1.0;
+                else if (o + (c + 1.0) * s < v)
+                    c += 1.0;
+
+                if (c < 0.0 || c > MaxQuantizedCoordinate || o + c * s > v || o + (c + 1.0) * s < v)
+                    return false;
+
+                q[d] = static_cast<uint16>(c);
+            }
+
+            quantized_vertices[i * 3 + 0] = q[0];
+            quantized_vertices[i * 3 + 1] = q[1];
+            quantized_vertices[i * 3 + 2] = q[2];
+        }
+
+        return true;
+    }
+
+    size_t compute_flat_size(
+        const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+        const vector<size_t>&               triangle_indices,
+        const size_t                        item_begin,
+        const size_t                        item_count)
+    {
+        size_t size = 0;
+
+        for (size_t i = 0; i < item_count; ++i)
+        {
+            const size_t triangle_index = triangle_indices[item_begin + i];
+            const TriangleVertexInfo& vertex_info = triangle_vertex_infos[triangle_index];
+
+            size += sizeof(uint32);         // visibility flags
+            size += sizeof(uint32);         // motion segment count
+
+            if (vertex_info.m_motion_segment_count == 0)
+                size += sizeof(GTriangleType);
+            else size += (vertex_info.m_motion_segment_count + 1) * 3 * sizeof(GVector3);
+        }
+
+        return size;
+    }
+
+    void encode_flat(
+        const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+        const vector<GVector3>&             triangle_vertices,
+        const vector<size_t>&               triangle_indices,
+        const size_t                        item_begin,
+        const size_t                        item_count,
+        MemoryWriter&                       writer)
+    {
+        for (size_t i = 0; i < item_count; ++i)
+        {
+            const size_t triangle_index = triangle_indices[item_begin + i];
+            const TriangleVertexInfo& vertex_info = triangle_vertex_infos[triangle_index];
+
+            writer.write(vertex_info.m_vis_flags);
+            writer.write(static_cast<uint32>(vertex_info.m_motion_segment_count));
+
+            if (vertex_info.m_motion_segment_count == 0)
+            {
+                writer.write(
+                    GTriangleType(
+                        triangle_vertices[vertex_info.m_vertex_index + 0],
+                        triangle_vertices[vertex_info.m_vertex_index + 1],
+                        triangle_vertices[vertex_info.m_vertex_index + 2]));
+            }
+            else
+            {
+                writer.write(
+                    &triangle_vertices[vertex_info.m_vertex_index],
+                    (vertex_info.m_motion_segment_count + 1) * 3 * sizeof(GVector3));
+            }
+        }
+    }
+
+    void encode_packed(
+        const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+        const vector<GVector3>&             triangle_vertices,
+        const vector<size_t>&               triangle_indices,
+        const size_t                        item_begin,
+        const size_t                        item_count,
+        MemoryWriter&                       writer)
+    {
+        for (size_t group_begin = 0; group_begin < item_count; group_begin += GTriangle4Type::Width)
+        {
+            GTriangle4Type triangles;
+
+            for (size_t i = 0; i < GTriangle4Type::Width; ++i)
+            {
+                if (group_begin + i < item_count)
+                {
+                    const size_t triangle_index = triangle_indices[item_begin + group_begin + i];
+                    const TriangleVertexInfo& vertex_info = triangle_vertex_infos[triangle_index];
+
+                    writer.write(vertex_info.m_vis_flags);
+                    triangles.set(
+                        i,
+                        GTriangleType(
+                            triangle_vertices[vertex_info.m_vertex_index + 0],
+                            triangle_vertices[vertex_info.m_vertex_index + 1],
+                            triangle_vertices[vertex_info.m_vertex_index + 2]));
+                }
+                else
+                {
+                    writer.write(uint32(0));
+                    triangles.clear(i);
+                }
+            }
+
+            writer.write(triangles);
+        }
+    }
+
+    void encode_triangle_records(
+        const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+        const vector<size_t>&               triangle_indices,
+        const size_t                        item_begin,
+        const size_t                        item_count,
+        const vector<uint8>&                vertex_indices,
+        MemoryWriter&                       writer)
+    {
+        for (size_t i = 0; i < item_count; ++i)
+        {
+            const size_t triangle_index = triangle_indices[item_begin + i];
+            writer.write(triangle_vertex_infos[triangle_index].m_vis_flags);
+            writer.write(vertex_indices[i * 3 + 0]);
+            writer.write(vertex_indices[i * 3 + 1]);
+            writer.write(vertex_indices[i * 3 + 2]);
+            writer.write(uint8(0));
+        }
+    }
+}
+
+TriangleEncoder::LeafFormat TriangleEncoder::select_format(
+    const LeafFormat                    format,
+    const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+    const vector<GVector3>&             triangle_vertices,
+    const vector<size_t>&               triangle_indices,
+    const size_t                        item_begin,
+    const size_t                        item_count)
+{
+    if (format == FlatLeaf)
+        return FlatLeaf;
+
+    // Moving triangles are only supported by flat leaves.
+    if (has_moving_triangles(triangle_vertex_infos, triangle_indices, item_begin, item_count))
+        return FlatLeaf;
+
+    // Packed leaves have no limit on the number of distinct vertices.
+    if (format == PackedLeaf)
+        return PackedLeaf;
+
+    vector<GVector3> vertices;
+    vector<uint8> vertex_indices;
+    if (!collect_leaf_vertices(
+            triangle_vertex_infos,
+            triangle_vertices,
+            triangle_indices,
+            item_begin,
+            item_count,
+            vertices,
+            vertex_indices))
+        return FlatLeaf;
+
+    if (format == QuantizedLeaf)
+    {
+        GVector3 origin, scale;
+        vector<uint16> quantized_vertices;
+        if (!quantize_leaf_vertices(vertices, origin, scale, quantized_vertices))
+            return IndexedLeaf;
+    }
+
+    return format;
+}
+
 size_t TriangleEncoder::compute_size(
+    const LeafFormat                    format,
     const vector<TriangleVertexInfo>&   triangle_vertex_infos,
+    const vector<GVector3>&             triangle_vertices,
     const vector<size_t>&               triangle_indices,
     const size_t                        item_begin,
     const size_t                        item_count)
 {
-    size_t size = 0;
+    if (format == FlatLeaf)
+    {
+        return
+            compute_flat_size(
+                triangle_vertex_infos,
+                triangle_indices,
+                item_begin,
+                item_count);
+    }
 
-    for (size_t i = 0; i < item_count; ++i)
+    if (format == PackedLeaf)
     {
-        const size_t triangle_index = triangle_indices[item_begin + i];
-        const TriangleVertexInfo& vertex_info = triangle_vertex_infos[triangle_index];
+        const size_t group_count = (item_count + GTriangle4Type::Width - 1) / GTriangle4Type::Width;
+        return sizeof(uint32) + group_count * PackedGroupSize;
+    }
 
-        size += sizeof(uint32);         // visibility flags
-        size += sizeof(uint32);         // motion segment count
+    vector<GVector3> vertices;
+    vector<uint8> vertex_indices;
+    collect_leaf_vertices(
+        triangle_vertex_infos,
+        triangle_vertices,
+        triangle_indices,
+        item_begin,
+        item_count,
+        vertices,
+        vertex_indices);
 
-        if (vertex_info.m_motion_segment_count == 0)
-            size += sizeof(GTriangleType);
-        else size += (vertex_info.m_motion_segment_count + 1) * 3 * sizeof(GVector3);
+    size_t size = sizeof(uint32);           // header
+    size += item_count * IndexedTriangleSize;
+
+    if (format == IndexedLeaf)
+        size += vertices.size() * sizeof(GVector3);
+    else
+    {
+        size += sizeof(uint32);             // index of the first full-precision vertex
+        size += 2 * sizeof(GVector3);       // origin and scale of the quantization grid
+        size += align_to_uint32(vertices.size() * 3 * sizeof(uint16));
     }
 
     return size;
 }
 
 void TriangleEncoder::encode(
+    const LeafFormat                    format,
     const vector<TriangleVertexInfo>&   triangle_vertex_infos,
     const vector<GVector3>&             triangle_vertices,
     const vector<size_t>&               triangle_indices,
     const size_t                        item_begin,
     const size_t                        item_count,
-    MemoryWriter&                       writer)
+    MemoryWriter&                       writer,
+    vector<GVector3>&                   leaf_vertices)
 {
-    for (size_t i = 0; i < item_count; ++i)
+    if (format == FlatLeaf)
+    {
+        encode_flat(
+            triangle_vertex_infos,
+            triangle_vertices,
+            triangle_indices,
+            item_begin,
+            item_count,
+            writer);
+        return;
+    }
+
+    if (format == PackedLeaf)
     {
-        const size_t triangle_index = triangle_indices[item_begin + i];
-        const TriangleVertexInfo& vertex_info = triangle_vertex_infos[triangle_index];
+        writer.write(make_leaf_header(PackedLeaf, 0));
+        encode_packed(
+            triangle_vertex_infos,
+            triangle_vertices,
+            triangle_indices,
+            item_begin,
+            item_count,
+            writer);
+        return;
+    }
 
-        writer.write(vertex_info.m_vis_flags);
-        writer.write(static_cast<uint32>(vertex_info.m_motion_segment_count));
+    vector<GVector3> vertices;
+    vector<uint8> vertex_indices;
+    collect_leaf_vertices(
+        triangle_vertex_infos,
+        triangle_vertices,
+        triangle_indices,
+        item_begin,
+        item_count,
+        vertices,
+        vertex_indices);
 
-        if (vertex_info.m_motion_segment_count == 0)
-        {
-            writer.write(
-                GTriangleType(
-                    triangle_vertices[vertex_info.m_vertex_index + 0],
-                    triangle_vertices[vertex_info.m_vertex_index + 1],
-                    triangle_vertices[vertex_info.m_vertex_index + 2]));
-        }
-        else
-        {
-            writer.write(
-                &triangle_vertices[vertex_info.m_vertex_index],
-                (vertex_info.m_motion_segment_count + 1) * 3 * sizeof(GVector3));
-        }
+    writer.write(make_leaf_header(format, vertices.size()));
+
+    if (format == IndexedLeaf)
+        writer.write(&vertices[0], vertices.size() * sizeof(GVector3));
+    else
+    {
+        GVector3 origin, scale;
+        vector<uint16> quantized_vertices;
+        quantize_leaf_vertices(vertices, origin, scale, quantized_vertices);
+
+        writer.write(static_cast<uint32>(leaf_vertices.size()));
+        writer.write(origin);
+        writer.write(scale);
+
+        const size_t quantized_vertices_size = quantized_vertices.size() * sizeof(uint16);
+        writer.write(&quantized_vertices[0], quantized_vertices_size);
+        for (size_t i = quantized_vertices_size; i < align_to_uint32(quantized_vertices_size); ++i)
+            writer.write(uint8(0));
+
+        leaf_vertices.insert(leaf_vertices.end(), vertices.begin(), vertices.end());
     }
+
+    encode_triangle_records(
+        triangle_vertex_infos,
+        triangle_indices,
+        item_begin,
+        item_count,
+        vertex_indices,
+        writer);
 }
 
 }   // namespace renderer
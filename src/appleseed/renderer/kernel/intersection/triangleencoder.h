@@ -33,6 +33,10 @@
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
 
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/platform/types.h"
+
 // Standard headers.
 #include <cstddef>
 #include <vector>
@@ -44,24 +48,129 @@ namespace renderer      { class TriangleVertexInfo; }
 namespace renderer
 {
 
+//
+// Encoding of the triangles of triangle tree leaves.
+//
+// Flat leaves store full-precision vertices for each triangle. They are the only
+// format that supports moving triangles.
+//
+// Indexed leaves store each distinct vertex of the leaf once, followed by the
+// vertex indices of the triangles.
+//
+// Quantized leaves store 16-bit leaf-relative vertex positions, used to reject
+// triangles with a conservative ray-box test. Full-precision vertices used for
+// the exact ray-triangle test live outside the leaf and are only fetched when a
+// triangle passes the conservative test.
+//
+// Packed leaves store the triangles in groups of four, in the structure-of-arrays
+// layout of foundation::TriangleMT4, so that rays can be intersected with each
+// group at once. Each group starts with the visibility flags of its triangles;
+// the trailing lanes of the last group are cleared and have null visibility flags.
+//
+// Indexed, quantized and packed leaves start with a header (see make_leaf_header()).
+// A leaf that cannot be stored in the requested format falls back to a simpler
+// one; in trees that request a compact format, flat leaves start with a header
+// too so that leaves of different formats can be told apart.
+//
+
 class TriangleEncoder
 {
   public:
+    enum LeafFormat
+    {
+        FlatLeaf,
+        IndexedLeaf,
+        QuantizedLeaf,
+        PackedLeaf
+    };
+
+    // Maximum number of distinct vertices in indexed and quantized leaves.
+    static const size_t MaxLeafVertexCount = 256;
+
+    // Return the format in which a given leaf will be stored when the requested format is 'format'.
+    static LeafFormat select_format(
+        const LeafFormat                        format,
+        const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+        const std::vector<GVector3>&            triangle_vertices,
+        const std::vector<size_t>&              triangle_indices,
+        const size_t                            item_begin,
+        const size_t                            item_count);
+
+    // Return the size in bytes of a leaf stored in a given format, including the header of compact leaves.
     static size_t compute_size(
+        const LeafFormat                        format,
         const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
+        const std::vector<GVector3>&            triangle_vertices,
         const std::vector<size_t>&              triangle_indices,
         const size_t                            item_begin,
         const size_t                            item_count);
 
+    // Encode a leaf in a given format, including the header of compact leaves.
+    // The full-precision vertices of quantized leaves are appended to 'leaf_vertices'.
     static void encode(
+        const LeafFormat                        format,
         const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
         const std::vector<GVector3>&            triangle_vertices,
         const std::vector<size_t>&              triangle_indices,
         const size_t                            item_begin,
         const size_t                            item_count,
-        foundation::MemoryWriter&               writer);
+        foundation::MemoryWriter&               writer,
+        std::vector<GVector3>&                  leaf_vertices);
+
+    // Leaf headers.
+    static foundation::uint32 make_leaf_header(
+        const LeafFormat                        format,
+        const size_t                            vertex_count);
+    static LeafFormat get_leaf_format(const foundation::uint32 header);
+    static size_t get_leaf_vertex_count(const foundation::uint32 header);
+
+    // Compute a conservative bounding box of a quantized vertex, given the
+    // origin and the scale of the quantization grid of its leaf.
+    static foundation::AABB3d dequantize_vertex(
+        const GVector3&                         origin,
+        const GVector3&                         scale,
+        const foundation::uint16                q[3]);
 };
 
+
+//
+// TriangleEncoder class implementation.
+//
+
+inline foundation::uint32 TriangleEncoder::make_leaf_header(
+    const LeafFormat                            format,
+    const size_t                                vertex_count)
+{
+    return static_cast<foundation::uint32>(format) | static_cast<foundation::uint32>(vertex_count << 8);
+}
+
+inline TriangleEncoder::LeafFormat TriangleEncoder::get_leaf_format(const foundation::uint32 header)
+{
+    return static_cast<LeafFormat>(header & 0xFF);
+}
+
+inline size_t TriangleEncoder::get_leaf_vertex_count(const foundation::uint32 header)
+{
+    return static_cast<size_t>(header >> 8);
+}
+
+inline foundation::AABB3d TriangleEncoder::dequantize_vertex(
+    const GVector3&                             origin,
+    const GVector3&                             scale,
+    const foundation::uint16                    q[3])
+{
+    // The cell of the vertex is grown by one cell on each side to absorb rounding errors.
+    foundation::AABB3d bbox;
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        bbox.min[i] = static_cast<double>(origin[i]) + (static_cast<double>(q[i]) - 1.0) * static_cast<double>(scale[i]);
+        bbox.max[i] = static_cast<double>(origin[i]) + (static_cast<double>(q[i]) + 2.0) * static_cast<double>(scale[i]);
+    }
+
+    return bbox;
+}
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_KERNEL_INTERSECTION_TRIANGLEENCODER_H
@@ -50,6 +50,7 @@
 #include "renderer/modeling/scene/assembly.h"
 #include "renderer/modeling/scene/containers.h"
 #include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
 #include "renderer/utility/bbox.h"
 #include "renderer/utility/messagecontext.h"
 #include "renderer/utility/paramarray.h"
@@ -57,6 +58,8 @@
 // appleseed.foundation headers.
 #include "foundation/math/area.h"
 #include "foundation/math/intersection/aabbtriangle.h"
+#include "foundation/math/intersection/rayaabb.h"
+#include "foundation/math/intersection/raytrianglemt4.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/transform.h"
 #include "foundation/math/treeoptimizer.h"
@@ -65,21 +68,32 @@
 #include "foundation/platform/timers.h"
 #include "foundation/utility/alignedallocator.h"
 #include "foundation/utility/api/apistring.h"
+#include "foundation/utility/bufferedfile.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/makevector.h"
 #include "foundation/utility/memory.h"
+#include "foundation/utility/siphash.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
 
+// Boost headers.
+#include "boost/filesystem.hpp"
+
 // Standard headers.
 #include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <exception>
+#include <iomanip>
 #include <set>
+#include <sstream>
 #include <string>
 
 using namespace foundation;
 using namespace std;
+namespace bf = boost::filesystem;
 
 namespace renderer
 {
@@ -134,9 +148,9 @@ namespace
             const Triangle& triangle = tess.m_primitives[i];
 
             // Retrieve the object space vertices of the triangle.
-            const GVector3& v0_os = tess.m_vertices[triangle.m_v0];
-            const GVector3& v1_os = tess.m_vertices[triangle.m_v1];
-            const GVector3& v2_os = tess.m_vertices[triangle.m_v2];
+            const GVector3 v0_os = tess.get_vertex(triangle.m_v0);
+            const GVector3 v1_os = tess.get_vertex(triangle.m_v1);
+            const GVector3 v2_os = tess.get_vertex(triangle.m_v2);
 
             // Ignore degenerate triangles.
             if (square_area(v0_os, v1_os, v2_os) == GScalar(0.0))
@@ -233,9 +247,9 @@ namespace
             const Triangle& triangle = tess.m_primitives[i];
 
             // Retrieve the object space vertices of the triangle.
-            const GVector3& v0_os = tess.m_vertices[triangle.m_v0];
-            const GVector3& v1_os = tess.m_vertices[triangle.m_v1];
-            const GVector3& v2_os = tess.m_vertices[triangle.m_v2];
+            const GVector3 v0_os = tess.get_vertex(triangle.m_v0);
+            const GVector3 v1_os = tess.get_vertex(triangle.m_v1);
+            const GVector3 v2_os = tess.get_vertex(triangle.m_v2);
 
             // Transform triangle vertices to assembly space.
             const GVector3 v0 = transform.point_to_parent(v0_os);
@@ -391,6 +405,84 @@ namespace
             }
         }
     }
+
+    // Version of the on-disk format of triangle trees; increase when changing it.
+    const uint32 TriangleTreeCacheFormatVersion = 5;
+
+    const char TriangleTreeCacheSignature[] = "ASTT";
+
+    template <typename Vector>
+    uint64 hash_vector(const uint64 hash, const Vector& vec)
+    {
+        return
+            vec.empty()
+                ? siphash24(hash, 0)
+                : siphash24(hash, siphash24(&vec[0], vec.size() * sizeof(typename Vector::value_type)));
+    }
+
+    uint64 hash_string(const uint64 hash, const char* s)
+    {
+        return siphash24(hash, siphash24(s, strlen(s)));
+    }
+
+    // Hash triangles field by field so that the result doesn't depend on padding bytes.
+    uint64 hash_triangles(uint64 hash, const vector<Triangle>& triangles)
+    {
+        hash = siphash24(hash, triangles.size());
+
+        for (size_t i = 0, e = triangles.size(); i < e; ++i)
+        {
+            const Triangle& triangle = triangles[i];
+            hash = siphash24(hash, triangle.m_v0);
+            hash = siphash24(hash, triangle.m_v1);
+            hash = siphash24(hash, triangle.m_v2);
+            hash = siphash24(hash, triangle.m_n0);
+            hash = siphash24(hash, triangle.m_n1);
+            hash = siphash24(hash, triangle.m_n2);
+            hash = siphash24(hash, triangle.m_a0);
+            hash = siphash24(hash, triangle.m_a1);
+            hash = siphash24(hash, triangle.m_a2);
+            hash = siphash24(hash, triangle.m_pa);
+        }
+
+        return hash;
+    }
+
+    string make_cache_file_name(const uint64 key)
+    {
+        stringstream sstr;
+        sstr << hex << setw(16) << setfill('0') << key << ".tree";
+        return sstr.str();
+    }
+
+    template <typename Vector>
+    bool write_vector(BufferedFile& file, const Vector& vec)
+    {
+        const uint64 size = vec.size();
+        if (file.write(size) != sizeof(size))
+            return false;
+
+        const size_t byte_count = vec.size() * sizeof(typename Vector::value_type);
+        return byte_count == 0 || file.write(&vec[0], byte_count) == byte_count;
+    }
+
+    template <typename Vector>
+    bool read_vector(BufferedFile& file, const int64 file_size, Vector& vec)
+    {
+        uint64 size;
+        if (file.read(size) != sizeof(size))
+            return false;
+
+        // Reject sizes that don't fit in the rest of the file.
+        const uint64 ItemSize = sizeof(typename Vector::value_type);
+        if (size > static_cast<uint64>(file_size - file.tell()) / ItemSize)
+            return false;
+
+        // Read the whole array at once, directly into its final storage.
+        vec.resize(static_cast<size_t>(size));
+        const size_t byte_count = vec.size() * sizeof(typename Vector::value_type);
+        return byte_count == 0 || file.read(&vec[0], byte_count) == byte_count;
+    }
 }
 
 TriangleTree::Arguments::Arguments(
@@ -408,36 +500,111 @@ TriangleTree::Arguments::Arguments(
 }
 
 TriangleTree::TriangleTree(const Arguments& arguments)
-  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size()))
+  : TreeType(AlignedAllocator<void>(System::get_l1_data_cache_line_size(), true))
   , m_arguments(arguments)
+  , m_loaded_from_cache(false)
+  , m_tracked_memory_size(MemoryTracker::Trees)
 {
+    ScopedTraceEvent event("triangle tree build", "intersection");
+
     // Retrieve construction parameters.
     const MessageContext message_context(
         format("while building triangle tree for assembly \"{0}\"", m_arguments.m_assembly.get_path()));
     const ParamArray& params = m_arguments.m_assembly.get_parameters().child("acceleration_structure");
+    const ParamArray& scene_params = m_arguments.m_scene.get_parameters().child("acceleration_structure");
     const string algorithm = params.get_optional<string>("algorithm", "bvh", make_vector("bvh", "sbvh"), message_context);
     const double time = params.get_optional<double>("time", 0.5);
     const bool save_memory = params.get_optional<bool>("save_temporary_memory", false);
+    const bool wide_bvh = params.get_optional<bool>("wide_bvh", false);
+
+    // Assemblies that don't choose their node type or leaf encoding use the ones of the scene.
+    const string node_type =
+        params.get_optional<string>(
+            "node_type",
+            scene_params.get_optional<string>("node_type", "binary"),
+            make_vector("binary", "quantized"),
+            message_context);
+    const string leaf_encoding =
+        params.get_optional<string>(
+            "leaf_encoding",
+            scene_params.get_optional<string>("leaf_encoding", "flat"),
+            make_vector("flat", "indexed", "quantized", "packed"),
+            message_context);
+
+    m_leaf_format =
+        leaf_encoding == "indexed" ? TriangleEncoder::IndexedLeaf :
+        leaf_encoding == "quantized" ? TriangleEncoder::QuantizedLeaf :
+        leaf_encoding == "packed" ? TriangleEncoder::PackedLeaf :
+        TriangleEncoder::FlatLeaf;
+
+    // Retrieve the location of the on-disk tree cache.
+    const string cache_directory =
+        scene_params.get_optional<string>("triangle_tree_cache_directory", "");
 
     // Start stopwatch.
     Stopwatch<DefaultWallclockTimer> stopwatch;
     stopwatch.start();
 
-    // Build the tree.
+    // Look the tree up in the on-disk cache.
     Statistics statistics;
-    if (algorithm == "bvh")
-        build_bvh(params, time, save_memory, statistics);
-    else build_sbvh(params, time, save_memory, statistics);
+    uint64 cache_key = 0;
+    string cache_file_path;
+    if (!cache_directory.empty())
+    {
+        cache_key = compute_cache_key(m_arguments, params, node_type, m_leaf_format);
+        cache_file_path = (bf::path(cache_directory) / make_cache_file_name(cache_key)).string();
+        m_loaded_from_cache = load_from_cache(cache_file_path, cache_key);
+        statistics.insert("cache", m_loaded_from_cache ? "hit" : "miss");
+    }
+
+    if (m_loaded_from_cache)
+    {
+        RENDERER_LOG_INFO(
+            "loaded triangle tree #" FMT_UNIQUE_ID " from %s.",
+            m_arguments.m_triangle_tree_uid,
+            cache_file_path.c_str());
+    }
+    else
+    {
+        // Build the tree.
+        if (algorithm == "bvh")
+            build_bvh(params, time, save_memory, statistics);
+        else build_sbvh(params, time, save_memory, statistics);
 
 #ifdef RENDERER_TRIANGLE_TREE_REORDER_NODES
-    // Optimize the tree layout in memory.
-    TreeOptimizer<NodeVectorType> tree_optimizer(m_nodes);
-    tree_optimizer.optimize_node_layout(TriangleTreeSubtreeDepth);
-    assert(m_nodes.size() == m_nodes.capacity());
+        // Optimize the tree layout in memory.
+        TreeOptimizer<NodeVectorType> tree_optimizer(m_nodes);
+        tree_optimizer.optimize_node_layout(TriangleTreeSubtreeDepth);
+        assert(m_nodes.size() == m_nodes.capacity());
 #endif
 
+        // Quantize the tree or collapse it into a wide BVH. Motion blur traversal only uses binary nodes.
+        if (m_moving_triangle_count == 0)
+        {
+            if (node_type == "quantized")
+                quantize_bvh(statistics);
+            else if (wide_bvh)
+                collapse_bvh(statistics);
+        }
+
+        // Store the tree in the on-disk cache.
+        if (!cache_file_path.empty())
+            save_to_cache(cache_file_path, cache_key);
+    }
+
+    m_tracked_memory_size.set(get_memory_size());
+
+    // Back the arrays accessed during traversal with large pages where possible.
+    const size_t large_page_count =
+        advise_large_pages(m_nodes) +
+        advise_large_pages(m_wide_nodes) +
+        advise_large_pages(m_quantized_nodes) +
+        advise_large_pages(m_leaf_data) +
+        advise_large_pages(m_leaf_vertices);
+
     // Print triangle tree statistics.
     statistics.insert_size("nodes alignment", alignment(&m_nodes[0]));
+    statistics.insert("large pages", large_page_count);
     statistics.insert_time("total time", stopwatch.measure().get_seconds());
     RENDERER_LOG_DEBUG("%s",
         StatisticsVector::make(
@@ -469,7 +636,8 @@ size_t TriangleTree::get_memory_size() const
         - sizeof(*static_cast<const TreeType*>(this))
         + sizeof(*this)
         + m_triangle_keys.capacity() * sizeof(TriangleKey)
-        + m_leaf_data.capacity() * sizeof(uint8);
+        + m_leaf_data.capacity() * sizeof(uint8)
+        + m_leaf_vertices.capacity() * sizeof(GVector3);
 }
 
 namespace
@@ -507,6 +675,194 @@ namespace
     }
 }
 
+uint64 TriangleTree::compute_cache_key(
+    const Arguments&                    arguments,
+    const ParamArray&                   params,
+    const string&                       node_type,
+    const TriangleEncoder::LeafFormat   leaf_format)
+{
+    // Format of the tree.
+    uint64 key = siphash24(TriangleTreeCacheFormatVersion, sizeof(NodeType));
+    key = siphash24(key, sizeof(GScalar));
+
+    // Build parameters.
+    for (const_each<StringDictionary> i = params.strings(); i; ++i)
+    {
+        key = hash_string(key, i->key());
+        key = hash_string(key, i->value());
+    }
+
+    // Node type and leaf encoding, which may come from the scene rather than from the assembly.
+    key = hash_string(key, node_type.c_str());
+    key = siphash24(key, static_cast<uint64>(leaf_format));
+
+    // Bounding box of the tree.
+    key = siphash24(key, siphash24(&arguments.m_bbox, sizeof(arguments.m_bbox)));
+
+    // Geometry of the regions.
+    for (size_t i = 0; i < arguments.m_regions.size(); ++i)
+    {
+        const RegionInfo& region_info = arguments.m_regions[i];
+
+        key = siphash24(key, region_info.get_object_instance_index());
+        key = siphash24(key, region_info.get_region_index());
+
+        // Retrieve the object instance and its transformation.
+        const ObjectInstance* object_instance =
+            arguments.m_assembly.object_instances().get_by_index(
+                region_info.get_object_instance_index());
+        assert(object_instance);
+        const Matrix4d& xfm = object_instance->get_transform().get_local_to_parent();
+        key = siphash24(key, siphash24(&xfm[0], 16 * sizeof(double)));
+        key = siphash24(key, object_instance->get_vis_flags());
+
+        // Retrieve the tessellation of the region.
+        Access<RegionKit> region_kit(&object_instance->get_object().get_region_kit());
+        const IRegion* region = (*region_kit)[region_info.get_region_index()];
+        Access<StaticTriangleTess> tess(&region->get_static_triangle_tess());
+
+        if (tess->has_compact_vertex_attributes())
+        {
+            for (size_t v = 0; v < tess->get_vertex_count(); ++v)
+            {
+                const GVector3 vertex = tess->get_vertex(v);
+                key = siphash24(key, siphash24(&vertex, sizeof(vertex)));
+            }
+        }
+        else key = hash_vector(key, tess->m_vertices);
+        key = hash_triangles(key, tess->m_primitives);
+
+        // Vertex poses.
+        const size_t motion_segment_count = tess->get_motion_segment_count();
+        key = siphash24(key, motion_segment_count);
+        for (size_t m = 0; m < motion_segment_count; ++m)
+        {
+            for (size_t v = 0; v < tess->get_vertex_count(); ++v)
+            {
+                const GVector3 pose = tess->get_vertex_pose(v, m);
+                key = siphash24(key, siphash24(&pose, sizeof(pose)));
+            }
+        }
+    }
+
+    return key;
+}
+
+bool TriangleTree::load_from_cache(
+    const string&       path,
+    const uint64        key)
+{
+    if (!bf::exists(path))
+        return false;
+
+    BufferedFile file;
+    if (!file.open(path.c_str(), BufferedFile::BinaryType, BufferedFile::ReadMode))
+        return false;
+
+    if (!file.seek(0, BufferedFile::SeekFromEnd))
+        return false;
+    const int64 file_size = file.tell();
+    if (!file.seek(0, BufferedFile::SeekFromBeginning))
+        return false;
+
+    // Check the header.
+    char signature[sizeof(TriangleTreeCacheSignature) - 1];
+    uint32 version;
+    uint64 stored_key;
+    uint32 leaf_format;
+    if (file.read(signature, sizeof(signature)) != sizeof(signature) ||
+        memcmp(signature, TriangleTreeCacheSignature, sizeof(signature)) != 0 ||
+        file.read(version) != sizeof(version) ||
+        version != TriangleTreeCacheFormatVersion ||
+        file.read(stored_key) != sizeof(stored_key) ||
+        stored_key != key ||
+        file.read(leaf_format) != sizeof(leaf_format) ||
+        leaf_format != static_cast<uint32>(m_leaf_format))
+    {
+        RENDERER_LOG_WARNING("ignoring invalid triangle tree cache file %s.", path.c_str());
+        return false;
+    }
+
+    uint64 static_triangle_count, moving_triangle_count;
+    if (file.read(static_triangle_count) != sizeof(static_triangle_count) ||
+        file.read(moving_triangle_count) != sizeof(moving_triangle_count) ||
+        !read_vector(file, file_size, m_nodes) ||
+        !read_vector(file, file_size, m_node_bboxes) ||
+        !read_vector(file, file_size, m_wide_nodes) ||
+        !read_vector(file, file_size, m_quantized_nodes) ||
+        !read_vector(file, file_size, m_triangle_keys) ||
+        !read_vector(file, file_size, m_leaf_data) ||
+        !read_vector(file, file_size, m_leaf_vertices) ||
+        m_nodes.empty())
+    {
+        RENDERER_LOG_WARNING("ignoring truncated triangle tree cache file %s.", path.c_str());
+        clear();
+        m_node_bboxes.clear();
+        m_triangle_keys.clear();
+        m_leaf_data.clear();
+        m_leaf_vertices.clear();
+        return false;
+    }
+
+    m_static_triangle_count = static_cast<size_t>(static_triangle_count);
+    m_moving_triangle_count = static_cast<size_t>(moving_triangle_count);
+
+    return true;
+}
+
+void TriangleTree::save_to_cache(
+    const string&       path,
+    const uint64        key) const
+{
+    try
+    {
+        // Write to a temporary file first so that concurrent renders never read a partial file.
+        const bf::path final_path(path);
+        bf::create_directories(final_path.parent_path());
+        const bf::path temp_path =
+            final_path.parent_path() / bf::unique_path(final_path.filename().string() + ".%%%%-%%%%-%%%%");
+
+        bool success = false;
+        {
+            BufferedFile file;
+            if (file.open(temp_path.string().c_str(), BufferedFile::BinaryType, BufferedFile::WriteMode))
+            {
+                const uint32 version = TriangleTreeCacheFormatVersion;
+                const uint32 leaf_format = static_cast<uint32>(m_leaf_format);
+                const uint64 static_triangle_count = m_static_triangle_count;
+                const uint64 moving_triangle_count = m_moving_triangle_count;
+                success =
+                    file.write(TriangleTreeCacheSignature, sizeof(TriangleTreeCacheSignature) - 1) == sizeof(TriangleTreeCacheSignature) - 1 &&
+                    file.write(version) == sizeof(version) &&
+                    file.write(key) == sizeof(key) &&
+                    file.write(leaf_format) == sizeof(leaf_format) &&
+                    file.write(static_triangle_count) == sizeof(static_triangle_count) &&
+                    file.write(moving_triangle_count) == sizeof(moving_triangle_count) &&
+                    write_vector(file, m_nodes) &&
+                    write_vector(file, m_node_bboxes) &&
+                    write_vector(file, m_wide_nodes) &&
+                    write_vector(file, m_quantized_nodes) &&
+                    write_vector(file, m_triangle_keys) &&
+                    write_vector(file, m_leaf_data) &&
+                    write_vector(file, m_leaf_vertices);
+                success = file.close() && success;
+            }
+        }
+
+        if (success)
+            bf::rename(temp_path, final_path);
+        else
+        {
+            bf::remove(temp_path);
+            RENDERER_LOG_WARNING("failed to write triangle tree cache file %s.", path.c_str());
+        }
+    }
+    catch (const std::exception& e)     // namespace qualification required
+    {
+        RENDERER_LOG_WARNING("failed to write triangle tree cache file %s: %s.", path.c_str(), e.what());
+    }
+}
+
 void TriangleTree::build_bvh(
     const ParamArray&   params,
     const double        time,
@@ -550,26 +906,72 @@ void TriangleTree::build_bvh(
         plural(m_moving_triangle_count, "moving triangle").c_str());
 
     // Retrieving the partitioner parameters.
-    const size_t max_leaf_size = params.get_optional<size_t>("max_leaf_size", TriangleTreeDefaultMaxLeafSize);
+    const size_t max_leaf_size =
+        params.get_optional<size_t>(
+            "max_leaf_size",
+            m_leaf_format == TriangleEncoder::PackedLeaf ? TriangleTreePackedMaxLeafSize : TriangleTreeDefaultMaxLeafSize);
     const GScalar interior_node_traversal_cost = params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost);
     const GScalar triangle_intersection_cost = params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost);
 
-    // Create the partitioner.
-    typedef bvh::SAHPartitioner<vector<GAABB3> > Partitioner;
-    Partitioner partitioner(
-        triangle_bboxes,
-        max_leaf_size,
-        interior_node_traversal_cost,
-        triangle_intersection_cost);
+    // Retrieve the builder parameters.
+    const bool parallel_build = params.get_optional<bool>("parallel_build", false);
+    const size_t build_thread_count =
+        params.get_optional<size_t>("build_thread_count", System::get_logical_cpu_core_count());
+
+    vector<size_t> triangle_ordering;
+    double partition_time;
+
+    if (parallel_build && build_thread_count > 1)
+    {
+        // Create the partitioner.
+        typedef bvh::BinnedSAHPartitioner<vector<GAABB3> > Partitioner;
+        Partitioner partitioner(
+            triangle_bboxes,
+            max_leaf_size,
+            interior_node_traversal_cost,
+            triangle_intersection_cost);
+
+        // Build the tree.
+        typedef bvh::ParallelBuilder<TriangleTree, Partitioner> Builder;
+        Builder builder;
+        builder.build<DefaultWallclockTimer>(
+            *this,
+            partitioner,
+            triangle_keys.size(),
+            max_leaf_size,
+            global_logger(),
+            build_thread_count);
+        triangle_ordering = partitioner.get_item_ordering();
+        partition_time = builder.get_build_time();
+
+        statistics.insert("build threads", build_thread_count);
+        statistics.insert("subtrees", builder.get_subtree_count());
+        statistics.insert_time("top level time", builder.get_top_level_build_time());
+        statistics.insert_time("subtrees time", builder.get_subtrees_build_time());
+        statistics.insert_time("merge time", builder.get_merge_time());
+    }
+    else
+    {
+        // Create the partitioner.
+        typedef bvh::SAHPartitioner<vector<GAABB3> > Partitioner;
+        Partitioner partitioner(
+            triangle_bboxes,
+            max_leaf_size,
+            interior_node_traversal_cost,
+            triangle_intersection_cost);
+
+        // Build the tree.
+        typedef bvh::Builder<TriangleTree, Partitioner> Builder;
+        Builder builder;
+        builder.build<DefaultWallclockTimer>(
+            *this,
+            partitioner,
+            triangle_keys.size(),
+            max_leaf_size);
+        triangle_ordering = partitioner.get_item_ordering();
+        partition_time = builder.get_build_time();
+    }
 
-    // Build the tree.
-    typedef bvh::Builder<TriangleTree, Partitioner> Builder;
-    Builder builder;
-    builder.build<DefaultWallclockTimer>(
-        *this,
-        partitioner,
-        triangle_keys.size(),
-        max_leaf_size);
     statistics.merge(
         bvh::TreeStatistics<TriangleTree>(*this, AABB3d(m_arguments.m_bbox)));
 
@@ -591,14 +993,14 @@ void TriangleTree::build_bvh(
 
     // Compute and propagate motion bounding boxes.
     compute_motion_bboxes(
-        partitioner.get_item_ordering(),
+        triangle_ordering,
         triangle_vertex_infos,
         triangle_vertices,
         0);
 
     // Store triangles and triangle keys into the tree.
     store_triangles(
-        partitioner.get_item_ordering(),
+        triangle_ordering,
         triangle_vertex_infos,
         triangle_vertices,
         triangle_keys,
@@ -607,7 +1009,7 @@ void TriangleTree::build_bvh(
     const double storing_time = stopwatch.measure().get_seconds();
 
     statistics.insert_time("collection time", collection_time);
-    statistics.insert_time("partition time", builder.get_build_time());
+    statistics.insert_time("partition time", partition_time);
     statistics.insert_time("store time", storing_time);
 }
 
@@ -655,7 +1057,10 @@ void TriangleTree::build_sbvh(
         plural(m_moving_triangle_count, "moving triangle").c_str());
 
     // Retrieving the partitioner parameters.
-    const size_t max_leaf_size = params.get_optional<size_t>("max_leaf_size", TriangleTreeDefaultMaxLeafSize);
+    const size_t max_leaf_size =
+        params.get_optional<size_t>(
+            "max_leaf_size",
+            m_leaf_format == TriangleEncoder::PackedLeaf ? TriangleTreePackedMaxLeafSize : TriangleTreeDefaultMaxLeafSize);
     const size_t bin_count = params.get_optional<size_t>("bin_count", TriangleTreeDefaultBinCount);
     const GScalar interior_node_traversal_cost = params.get_optional<GScalar>("interior_node_traversal_cost", TriangleTreeDefaultInteriorNodeTraversalCost);
     const GScalar triangle_intersection_cost = params.get_optional<GScalar>("triangle_intersection_cost", TriangleTreeDefaultTriangleIntersectionCost);
@@ -674,20 +1079,39 @@ void TriangleTree::build_sbvh(
         interior_node_traversal_cost,
         triangle_intersection_cost);
 
-    // Create the root leaf.
-    Partitioner::LeafType* root_leaf = partitioner.create_root_leaf();
-    const AABB3d root_leaf_bbox = partitioner.compute_leaf_bbox(*root_leaf);
+    // Retrieve the builder parameters. A non-zero chunk size bounds the scratch memory of the build.
+    const size_t build_chunk_size = params.get_optional<size_t>("build_chunk_size", 0);
 
     // Build the tree.
     typedef bvh::SpatialBuilder<TriangleTree, Partitioner> Builder;
     Builder builder;
-    builder.build<DefaultWallclockTimer>(
-        *this,
-        partitioner,
-        root_leaf,
-        root_leaf_bbox);
+    if (build_chunk_size > 0)
+    {
+        builder.build_chunked<DefaultWallclockTimer>(
+            *this,
+            partitioner,
+            triangle_bboxes,
+            build_chunk_size);
+    }
+    else
+    {
+        // Create the root leaf.
+        Partitioner::LeafType* root_leaf = partitioner.create_root_leaf();
+        const AABB3d root_leaf_bbox = partitioner.compute_leaf_bbox(*root_leaf);
+
+        builder.build<DefaultWallclockTimer>(
+            *this,
+            partitioner,
+            root_leaf,
+            root_leaf_bbox);
+    }
     statistics.merge(bvh::TreeStatistics<TriangleTree>(*this, AABB3d(m_arguments.m_bbox)));
 
+    // Add build memory statistics.
+    if (build_chunk_size > 0)
+        statistics.insert("chunks", builder.get_chunk_count());
+    statistics.insert_size("build peak memory", builder.get_peak_memory_size());
+
     // Add splits statistics.
     const size_t spatial_splits = partitioner.get_spatial_split_count();
     const size_t object_splits = partitioner.get_object_split_count();
@@ -769,6 +1193,31 @@ namespace
 #endif
 }
 
+void TriangleTree::collapse_bvh(Statistics& statistics)
+{
+    bvh::Collapser<TriangleTree> collapser;
+    collapser.collapse<DefaultWallclockTimer>(*this);
+
+    const size_t wide_node_width = WideNodeType::Width;
+    statistics.insert("wide nodes", m_wide_nodes.size());
+    statistics.insert("wide node width", wide_node_width);
+    statistics.insert_time("collapse time", collapser.get_collapse_time());
+}
+
+void TriangleTree::quantize_bvh(Statistics& statistics)
+{
+    const size_t memory_size_before = TreeType::get_memory_size();
+
+    bvh::Quantizer<TriangleTree> quantizer;
+    quantizer.quantize<DefaultWallclockTimer>(*this);
+
+    const size_t memory_size_after = TreeType::get_memory_size();
+
+    statistics.insert("quantized nodes", m_quantized_nodes.size());
+    statistics.insert_size("memory saved", memory_size_before - memory_size_after);
+    statistics.insert_time("quantization time", quantizer.get_quantization_time());
+}
+
 vector<GAABB3> TriangleTree::compute_motion_bboxes(
     const vector<size_t>&               triangle_indices,
     const vector<TriangleVertexInfo>&   triangle_vertex_infos,
@@ -901,10 +1350,25 @@ void TriangleTree::store_triangles(
 {
     const size_t node_count = m_nodes.size();
 
+    // Compute the visibility masks of the nodes before the item indices of the leaves are remapped.
+    vector<uint32> item_vis_flags(triangle_indices.size());
+    for (size_t i = 0; i < triangle_indices.size(); ++i)
+        item_vis_flags[i] = triangle_vertex_infos[triangle_indices[i]].m_vis_flags;
+
+    bvh::Masker<TriangleTree> masker;
+    masker.compute_masks(*this, item_vis_flags);
+    clear_release_memory(item_vis_flags);
+
+    // Flat leaves only start with a header if other leaves may use a compact format.
+    const size_t flat_leaf_header_size = m_leaf_format == TriangleEncoder::FlatLeaf ? 0 : sizeof(uint32);
+
     // Gather statistics.
 
     size_t leaf_count = 0;
     size_t fat_leaf_count = 0;
+    size_t indexed_leaf_count = 0;
+    size_t quantized_leaf_count = 0;
+    size_t packed_leaf_count = 0;
     size_t leaf_data_size = 0;
 
     for (size_t i = 0; i < node_count; ++i)
@@ -918,9 +1382,28 @@ void TriangleTree::store_triangles(
             const size_t item_begin = node.get_item_index();
             const size_t item_count = node.get_item_count();
 
+            const TriangleEncoder::LeafFormat leaf_format =
+                TriangleEncoder::select_format(
+                    m_leaf_format,
+                    triangle_vertex_infos,
+                    triangle_vertices,
+                    triangle_indices,
+                    item_begin,
+                    item_count);
+
+            if (leaf_format == TriangleEncoder::IndexedLeaf)
+                ++indexed_leaf_count;
+            else if (leaf_format == TriangleEncoder::QuantizedLeaf)
+                ++quantized_leaf_count;
+            else if (leaf_format == TriangleEncoder::PackedLeaf)
+                ++packed_leaf_count;
+
             const size_t leaf_size =
+                (leaf_format == TriangleEncoder::FlatLeaf ? flat_leaf_header_size : 0) +
                 TriangleEncoder::compute_size(
+                    leaf_format,
                     triangle_vertex_infos,
+                    triangle_vertices,
                     triangle_indices,
                     item_begin,
                     item_count);
@@ -935,6 +1418,7 @@ void TriangleTree::store_triangles(
 
     m_triangle_keys.reserve(triangle_indices.size());
     m_leaf_data.resize(leaf_data_size);
+    m_leaf_vertices.clear();
 
     MemoryWriter leaf_data_writer(m_leaf_data.empty() ? 0 : &m_leaf_data[0]);
 
@@ -955,43 +1439,62 @@ void TriangleTree::store_triangles(
                 m_triangle_keys.push_back(triangle_keys[triangle_index]);
             }
 
+            const TriangleEncoder::LeafFormat leaf_format =
+                TriangleEncoder::select_format(
+                    m_leaf_format,
+                    triangle_vertex_infos,
+                    triangle_vertices,
+                    triangle_indices,
+                    item_begin,
+                    item_count);
+
             const size_t leaf_size =
+                (leaf_format == TriangleEncoder::FlatLeaf ? flat_leaf_header_size : 0) +
                 TriangleEncoder::compute_size(
+                    leaf_format,
                     triangle_vertex_infos,
+                    triangle_vertices,
                     triangle_indices,
                     item_begin,
                     item_count);
 
             MemoryWriter user_data_writer(&node.get_user_data<uint8>());
 
+            MemoryWriter* writer;
             if (leaf_size <= NodeType::MaxUserDataSize - sizeof(uint32))
             {
                 user_data_writer.write<uint32>(~0);
-
-                TriangleEncoder::encode(
-                    triangle_vertex_infos,
-                    triangle_vertices,
-                    triangle_indices,
-                    item_begin,
-                    item_count,
-                    user_data_writer);
+                writer = &user_data_writer;
             }
             else
             {
                 user_data_writer.write(static_cast<uint32>(leaf_data_writer.offset()));
-
-                TriangleEncoder::encode(
-                    triangle_vertex_infos,
-                    triangle_vertices,
-                    triangle_indices,
-                    item_begin,
-                    item_count,
-                    leaf_data_writer);
+                writer = &leaf_data_writer;
             }
+
+            if (leaf_format == TriangleEncoder::FlatLeaf && flat_leaf_header_size > 0)
+                writer->write(TriangleEncoder::make_leaf_header(TriangleEncoder::FlatLeaf, 0));
+
+            TriangleEncoder::encode(
+                leaf_format,
+                triangle_vertex_infos,
+                triangle_vertices,
+                triangle_indices,
+                item_begin,
+                item_count,
+                *writer,
+                m_leaf_vertices);
         }
     }
 
     statistics.insert_percent("fat leaves", fat_leaf_count, leaf_count);
+
+    if (m_leaf_format != TriangleEncoder::FlatLeaf)
+    {
+        statistics.insert_percent("indexed leaves", indexed_leaf_count, leaf_count);
+        statistics.insert_percent("quantized leaves", quantized_leaf_count, leaf_count);
+        statistics.insert_percent("packed leaves", packed_leaf_count, leaf_count);
+    }
 }
 
 namespace
@@ -1347,6 +1850,173 @@ namespace
     typedef TriangleReaderImpl<
         sizeof(GTriangleType::ValueType) == sizeof(TriangleType::ValueType)
     > TriangleReader;
+
+    template <bool CompatibleTypes> struct Triangle4ReaderImpl;
+
+    // Compatible types: no conversion or copy.
+    template <> struct Triangle4ReaderImpl<true>
+    {
+        const Triangle4Type& m_triangles;
+
+        explicit Triangle4ReaderImpl(const Triangle4Type& triangles)
+          : m_triangles(triangles)
+        {
+        }
+    };
+
+    // Incompatible types: perform a conversion.
+    template <> struct Triangle4ReaderImpl<false>
+    {
+        const Triangle4Type m_triangles;
+
+        explicit Triangle4ReaderImpl(const GTriangle4Type& triangles)
+          : m_triangles(triangles)
+        {
+        }
+    };
+
+    typedef Triangle4ReaderImpl<
+        sizeof(GTriangle4Type::ValueType) == sizeof(Triangle4Type::ValueType)
+    > Triangle4Reader;
+
+    // Return a bitmask of the triangles of a group of a packed leaf that are visible to a ray.
+    size_t get_visible_triangles(
+        const uint32                vis_flags[GTriangle4Type::Width],
+        const uint32                ray_flags)
+    {
+        size_t mask = 0;
+
+        for (size_t i = 0; i < GTriangle4Type::Width; ++i)
+        {
+            if (vis_flags[i] & ray_flags)
+                mask |= size_t(1) << i;
+        }
+
+        return mask;
+    }
+
+    template <bool CompatibleTypes> struct TriangleRayReaderImpl;
+
+    // Compatible types: no conversion or copy.
+    template <> struct TriangleRayReaderImpl<true>
+    {
+        const Ray3d& m_ray;
+
+        explicit TriangleRayReaderImpl(const Ray3d& ray)
+          : m_ray(ray)
+        {
+        }
+
+        void set_tmax(const double)
+        {
+            // The ray is the one of the shading point, its distance is already updated.
+        }
+    };
+
+    // Incompatible types: perform a conversion.
+    template <> struct TriangleRayReaderImpl<false>
+    {
+        TriangleType::RayType m_ray;
+
+        explicit TriangleRayReaderImpl(const Ray3d& ray)
+          : m_ray(ray)
+        {
+        }
+
+        void set_tmax(const double tmax)
+        {
+            m_ray.m_tmax = static_cast<TriangleType::ValueType>(tmax);
+        }
+    };
+
+    typedef TriangleRayReaderImpl<
+        sizeof(Ray3d::ValueType) == sizeof(TriangleType::ValueType)
+    > TriangleRayReader;
+}
+
+
+//
+// Utility class to sequentially read the triangles of indexed and quantized leaves.
+//
+
+namespace
+{
+    class CompactLeafReader
+    {
+      public:
+        CompactLeafReader(
+            const vector<GVector3>&     leaf_vertices,
+            const uint32                header,
+            MemoryReader&               reader)
+          : m_reader(reader)
+          , m_quantized(TriangleEncoder::get_leaf_format(header) == TriangleEncoder::QuantizedLeaf)
+          , m_triangle_vertex_indices(0)
+        {
+            const size_t vertex_count = TriangleEncoder::get_leaf_vertex_count(header);
+            assert(vertex_count > 0);
+
+            if (m_quantized)
+            {
+                m_vertices = &leaf_vertices[m_reader.read<uint32>()];
+                m_origin = &m_reader.read<GVector3>();
+                m_scale = &m_reader.read<GVector3>();
+                m_quantized_vertices = reinterpret_cast<const uint16*>(m_reader.read(vertex_count * 3 * sizeof(uint16)));
+                m_reader += (sizeof(uint32) - (vertex_count * 3 * sizeof(uint16)) % sizeof(uint32)) % sizeof(uint32);
+            }
+            else
+            {
+                m_vertices = reinterpret_cast<const GVector3*>(m_reader.read(vertex_count * sizeof(GVector3)));
+                m_origin = 0;
+                m_scale = 0;
+                m_quantized_vertices = 0;
+            }
+        }
+
+        // Read the next triangle of the leaf. Return false if the triangle can be skipped,
+        // either because of its visibility flags or because the ray misses its quantized bounds.
+        bool read_triangle(
+            const Ray3d&                ray,
+            const RayInfo3d&            ray_info,
+            const uint32                ray_flags)
+        {
+            const uint32 vis_flags = m_reader.read<uint32>();
+            m_triangle_vertex_indices = reinterpret_cast<const uint8*>(m_reader.read(4 * sizeof(uint8)));
+
+            if (!(vis_flags & ray_flags))
+                return false;
+
+            if (m_quantized)
+            {
+                AABB3d bbox = TriangleEncoder::dequantize_vertex(*m_origin, *m_scale, &m_quantized_vertices[m_triangle_vertex_indices[0] * 3]);
+                bbox.insert(TriangleEncoder::dequantize_vertex(*m_origin, *m_scale, &m_quantized_vertices[m_triangle_vertex_indices[1] * 3]));
+                bbox.insert(TriangleEncoder::dequantize_vertex(*m_origin, *m_scale, &m_quantized_vertices[m_triangle_vertex_indices[2] * 3]));
+
+                if (!intersect(ray, ray_info, bbox))
+                    return false;
+            }
+
+            return true;
+        }
+
+        // Fetch the full-precision vertices of the last triangle read.
+        GTriangleType get_triangle() const
+        {
+            return
+                GTriangleType(
+                    m_vertices[m_triangle_vertex_indices[0]],
+                    m_vertices[m_triangle_vertex_indices[1]],
+                    m_vertices[m_triangle_vertex_indices[2]]);
+        }
+
+      private:
+        MemoryReader&                   m_reader;
+        const bool                      m_quantized;
+        const GVector3*                 m_vertices;
+        const GVector3*                 m_origin;
+        const GVector3*                 m_scale;
+        const uint16*                   m_quantized_vertices;
+        const uint8*                    m_triangle_vertex_indices;
+    };
 }
 
 
@@ -1364,6 +2034,9 @@ bool TriangleLeafVisitor::visit(
 #endif
     )
 {
+    if (m_counters)
+        m_counters->m_intersected_triangles += node.get_item_count();
+
     // Retrieve the pointer to the data of this leaf.
     const uint8* user_data = &node.get_user_data<uint8>();
     const uint32 leaf_data_index = *reinterpret_cast<const uint32*>(user_data);
@@ -1373,6 +2046,134 @@ bool TriangleLeafVisitor::visit(
             : &m_tree.m_leaf_data[leaf_data_index];     // triangles are stored in the tree
     MemoryReader reader(leaf_data);
 
+    // Convert the ray to the format used for intersection if necessary.
+    TriangleRayReader ray_reader(ray);
+
+    // Retrieve the format of the leaf.
+    if (m_tree.m_leaf_format != TriangleEncoder::FlatLeaf)
+    {
+        const uint32 header = reader.read<uint32>();
+
+        if (TriangleEncoder::get_leaf_format(header) == TriangleEncoder::PackedLeaf)
+        {
+            const size_t item_index = node.get_item_index();
+            const size_t item_count = node.get_item_count();
+
+            // Intersect the triangles of the leaf four at a time.
+            for (size_t group_begin = 0; group_begin < item_count; group_begin += GTriangle4Type::Width)
+            {
+                FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+                const uint32* vis_flags = reinterpret_cast<const uint32*>(reader.read(GTriangle4Type::Width * sizeof(uint32)));
+                const GTriangle4Type& triangles = reader.read<GTriangle4Type>();
+
+                // Check visibility flags.
+                size_t mask = get_visible_triangles(vis_flags, m_shading_point.m_ray.m_flags);
+                if (mask == 0)
+                    continue;
+
+                // Convert the triangles to the right format if necessary.
+                const Triangle4Reader triangle_reader(triangles);
+
+                // Intersect the triangles.
+                TriangleType::ValueType t[GTriangle4Type::Width], u[GTriangle4Type::Width], v[GTriangle4Type::Width];
+                mask &= triangle_reader.m_triangles.intersect(ray_reader.m_ray, t, u, v);
+
+                // Keep the closest hit accepted by the intersection filters.
+                while (mask)
+                {
+                    const size_t i = find_closest_hit(mask, t);
+                    mask &= ~(size_t(1) << i);
+
+                    const size_t triangle_index = item_index + group_begin + i;
+
+                    // Optionally filter intersections.
+                    if (m_has_intersection_filters)
+                    {
+                        const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
+                        const IntersectionFilter* filter =
+                            m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
+                        if (filter)
+                        {
+                            if (m_counters)
+                                ++m_counters->m_filter_invocations;
+
+                            if (!filter->accept(triangle_key, u[i], v[i]))
+                                continue;
+                        }
+                    }
+
+                    m_decoded_triangle = triangles.get(i);
+                    m_hit_triangle = &m_decoded_triangle;
+                    m_hit_triangle_index = triangle_index;
+                    m_shading_point.m_ray.m_tmax = t[i];
+                    ray_reader.set_tmax(t[i]);
+                    m_shading_point.m_bary[0] = static_cast<float>(u[i]);
+                    m_shading_point.m_bary[1] = static_cast<float>(v[i]);
+                    break;
+                }
+            }
+
+            // Continue traversal.
+            distance = m_shading_point.m_ray.m_tmax;
+            return true;
+        }
+
+        if (TriangleEncoder::get_leaf_format(header) != TriangleEncoder::FlatLeaf)
+        {
+            CompactLeafReader leaf_reader(m_tree.m_leaf_vertices, header, reader);
+
+            // Sequentially intersect all triangles of the leaf.
+            for (size_t triangle_index = node.get_item_index(),
+                        triangle_count = node.get_item_count();
+                        triangle_count--;
+                        triangle_index++)
+            {
+                FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+                if (!leaf_reader.read_triangle(ray, ray_info, m_shading_point.m_ray.m_flags))
+                    continue;
+
+                // Fetch the triangle and convert it to the right format if necessary.
+                const GTriangleType triangle = leaf_reader.get_triangle();
+                const TriangleReader triangle_reader(triangle);
+
+                // Intersect the triangle.
+                TriangleType::ValueType t, u, v;
+                if (triangle_reader.m_triangle.intersect(ray_reader.m_ray, t, u, v))
+                {
+                    // Optionally filter intersections.
+                    if (m_has_intersection_filters)
+                    {
+                        const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
+                        const IntersectionFilter* filter =
+                            m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
+                        if (filter)
+                        {
+                            if (m_counters)
+                                ++m_counters->m_filter_invocations;
+
+                            if (!filter->accept(triangle_key, u, v))
+                                continue;
+                        }
+                    }
+
+                    m_decoded_triangle = triangle;
+                    m_hit_triangle = &m_decoded_triangle;
+                    m_hit_triangle_index = triangle_index;
+                    m_shading_point.m_ray.m_tmax = t;
+                    ray_reader.set_tmax(t);
+                    m_shading_point.m_bary[0] = static_cast<float>(u);
+                    m_shading_point.m_bary[1] = static_cast<float>(v);
+                }
+            }
+
+            // Continue traversal.
+            distance = m_shading_point.m_ray.m_tmax;
+            return true;
+        }
+    }
+
     // Sequentially intersect all triangles of the leaf.
     for (size_t triangle_index = node.get_item_index(),
                 triangle_count = node.get_item_count();
@@ -1402,8 +2203,8 @@ bool TriangleLeafVisitor::visit(
             const TriangleReader triangle_reader(triangle);
 
             // Intersect the triangle.
-            double t, u, v;
-            if (triangle_reader.m_triangle.intersect(ray, t, u, v))
+            TriangleType::ValueType t, u, v;
+            if (triangle_reader.m_triangle.intersect(ray_reader.m_ray, t, u, v))
             {
                 // Optionally filter intersections.
                 if (m_has_intersection_filters)
@@ -1411,13 +2212,20 @@ bool TriangleLeafVisitor::visit(
                     const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
                     const IntersectionFilter* filter =
                         m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
-                    if (filter && !filter->accept(triangle_key, u, v))
-                        continue;
+                    if (filter)
+                    {
+                        if (m_counters)
+                            ++m_counters->m_filter_invocations;
+
+                        if (!filter->accept(triangle_key, u, v))
+                            continue;
+                    }
                 }
 
                 m_hit_triangle = &triangle;
                 m_hit_triangle_index = triangle_index;
                 m_shading_point.m_ray.m_tmax = t;
+                ray_reader.set_tmax(t);
                 m_shading_point.m_bary[0] = static_cast<float>(u);
                 m_shading_point.m_bary[1] = static_cast<float>(v);
             }
@@ -1457,8 +2265,8 @@ bool TriangleLeafVisitor::visit(
             const TriangleReader reader(triangle);
 
             // Intersect the triangle.
-            double t, u, v;
-            if (reader.m_triangle.intersect(ray, t, u, v))
+            TriangleType::ValueType t, u, v;
+            if (reader.m_triangle.intersect(ray_reader.m_ray, t, u, v))
             {
                 // Optionally filter intersections.
                 if (m_has_intersection_filters)
@@ -1466,14 +2274,21 @@ bool TriangleLeafVisitor::visit(
                     const TriangleKey& triangle_key = m_tree.m_triangle_keys[triangle_index];
                     const IntersectionFilter* filter =
                         m_tree.m_intersection_filters[triangle_key.get_object_instance_index()];
-                    if (filter && !filter->accept(triangle_key, u, v))
-                        continue;
+                    if (filter)
+                    {
+                        if (m_counters)
+                            ++m_counters->m_filter_invocations;
+
+                        if (!filter->accept(triangle_key, u, v))
+                            continue;
+                    }
                 }
 
-                m_interpolated_triangle = triangle;
-                m_hit_triangle = &m_interpolated_triangle;
+                m_decoded_triangle = triangle;
+                m_hit_triangle = &m_decoded_triangle;
                 m_hit_triangle_index = triangle_index;
                 m_shading_point.m_ray.m_tmax = t;
+                ray_reader.set_tmax(t);
                 m_shading_point.m_bary[0] = static_cast<float>(u);
                 m_shading_point.m_bary[1] = static_cast<float>(v);
             }
@@ -1519,6 +2334,9 @@ bool TriangleLeafProbeVisitor::visit(
 #endif
     )
 {
+    if (m_counters)
+        m_counters->m_intersected_triangles += node.get_item_count();
+
     // Retrieve the pointer to the data of this leaf.
     const uint8* user_data = &node.get_user_data<uint8>();
     const uint32 leaf_data_index = *reinterpret_cast<const uint32*>(user_data);
@@ -1528,6 +2346,86 @@ bool TriangleLeafProbeVisitor::visit(
             : &m_tree.m_leaf_data[leaf_data_index];     // triangles are stored in the tree
     MemoryReader reader(leaf_data);
 
+    // Convert the ray to the format used for intersection if necessary.
+    const TriangleRayReader ray_reader(ray);
+
+    // Retrieve the format of the leaf.
+    if (m_tree.m_leaf_format != TriangleEncoder::FlatLeaf)
+    {
+        const uint32 header = reader.read<uint32>();
+
+        if (TriangleEncoder::get_leaf_format(header) == TriangleEncoder::PackedLeaf)
+        {
+            // Intersect the triangles of the leaf four at a time until a hit is found.
+            for (size_t group_begin = 0, item_count = node.get_item_count();
+                        group_begin < item_count;
+                        group_begin += GTriangle4Type::Width)
+            {
+                FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+                const uint32* vis_flags = reinterpret_cast<const uint32*>(reader.read(GTriangle4Type::Width * sizeof(uint32)));
+                const GTriangle4Type& triangles = reader.read<GTriangle4Type>();
+
+                // Check visibility flags.
+                size_t mask = get_visible_triangles(vis_flags, m_ray_flags);
+                if (mask == 0)
+                    continue;
+
+                // Convert the triangles to the right format if necessary.
+                const Triangle4Reader triangle_reader(triangles);
+
+                // Intersect the triangles.
+                mask &= triangle_reader.m_triangles.intersect(ray_reader.m_ray);
+                if (mask)
+                {
+                    size_t i = 0;
+                    while (!(mask & (size_t(1) << i)))
+                        ++i;
+
+                    m_hit = true;
+                    m_hit_triangle_is_static = true;
+                    m_hit_triangle = triangles.get(i);
+                    return false;
+                }
+            }
+
+            // Continue traversal.
+            distance = ray.m_tmax;
+            return true;
+        }
+
+        if (TriangleEncoder::get_leaf_format(header) != TriangleEncoder::FlatLeaf)
+        {
+            CompactLeafReader leaf_reader(m_tree.m_leaf_vertices, header, reader);
+
+            // Sequentially intersect triangles until a hit is found.
+            for (size_t triangle_count = node.get_item_count(); triangle_count--; )
+            {
+                FOUNDATION_BVH_TRAVERSAL_STATS(stats.m_intersected_items.insert(1));
+
+                if (!leaf_reader.read_triangle(ray, ray_info, m_ray_flags))
+                    continue;
+
+                // Fetch the triangle and convert it to the right format if necessary.
+                const GTriangleType triangle = leaf_reader.get_triangle();
+                const TriangleReader triangle_reader(triangle);
+
+                // Intersect the triangle.
+                if (triangle_reader.m_triangle.intersect(ray_reader.m_ray))
+                {
+                    m_hit = true;
+                    m_hit_triangle_is_static = true;
+                    m_hit_triangle = triangle;
+                    return false;
+                }
+            }
+
+            // Continue traversal.
+            distance = ray.m_tmax;
+            return true;
+        }
+    }
+
     // Sequentially intersect triangles until a hit is found.
     for (size_t triangle_count = node.get_item_count(); triangle_count--; )
     {
@@ -1554,9 +2452,11 @@ bool TriangleLeafProbeVisitor::visit(
             const TriangleReader triangle_reader(triangle);
 
             // Intersect the triangle.
-            if (triangle_reader.m_triangle.intersect(ray))
+            if (triangle_reader.m_triangle.intersect(ray_reader.m_ray))
             {
                 m_hit = true;
+                m_hit_triangle_is_static = true;
+                m_hit_triangle = triangle;
                 return false;
             }
         }
@@ -1592,7 +2492,7 @@ bool TriangleLeafProbeVisitor::visit(
             const TriangleReader triangle_reader(triangle);
 
             // Intersect the triangle.
-            if (triangle_reader.m_triangle.intersect(ray))
+            if (triangle_reader.m_triangle.intersect(ray_reader.m_ray))
             {
                 m_hit = true;
                 return false;
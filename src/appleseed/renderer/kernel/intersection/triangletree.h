@@ -32,9 +32,11 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersectionprofiler.h"
 #include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/intersection/probevisitorbase.h"
 #include "renderer/kernel/intersection/regioninfo.h"
+#include "renderer/kernel/intersection/triangleencoder.h"
 #include "renderer/kernel/intersection/trianglekey.h"
 #include "renderer/kernel/intersection/trianglevertexinfo.h"
 #include "renderer/modeling/scene/visibilityflags.h"
@@ -47,6 +49,7 @@
 #include "foundation/platform/types.h"
 #include "foundation/utility/alignedvector.h"
 #include "foundation/utility/lazy.h"
+#include "foundation/utility/memorytracker.h"
 #include "foundation/utility/poolallocator.h"
 #include "foundation/utility/uid.h"
 
@@ -116,6 +119,9 @@ class TriangleTree
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
 
+    // Return true if the tree was loaded from the on-disk tree cache rather than built.
+    bool is_loaded_from_cache() const;
+
   private:
     friend class TriangleLeafVisitor;
     friend class TriangleLeafProbeVisitor;
@@ -125,12 +131,31 @@ class TriangleTree
     size_t                                      m_static_triangle_count;
     size_t                                      m_moving_triangle_count;
 
+    TriangleEncoder::LeafFormat                 m_leaf_format;
     std::vector<TriangleKey>                    m_triangle_keys;
     std::vector<foundation::uint8>              m_leaf_data;
+    std::vector<GVector3>                       m_leaf_vertices;    // full-precision vertices of quantized leaves
+    bool                                        m_loaded_from_cache;
 
     IntersectionFilterRepository                m_intersection_filters_repository;
     std::vector<const IntersectionFilter*>      m_intersection_filters;
 
+    foundation::TrackedMemorySize               m_tracked_memory_size;
+
+    static foundation::uint64 compute_cache_key(
+        const Arguments&                        arguments,
+        const ParamArray&                       params,
+        const std::string&                      node_type,
+        const TriangleEncoder::LeafFormat       leaf_format);
+
+    bool load_from_cache(
+        const std::string&                      path,
+        const foundation::uint64                key);
+
+    void save_to_cache(
+        const std::string&                      path,
+        const foundation::uint64                key) const;
+
     void build_bvh(
         const ParamArray&                       params,
         const double                            time,
@@ -143,6 +168,10 @@ class TriangleTree
         const bool                              save_memory,
         foundation::Statistics&                 statistics);
 
+    void collapse_bvh(foundation::Statistics& statistics);
+
+    void quantize_bvh(foundation::Statistics& statistics);
+
     std::vector<GAABB3> compute_motion_bboxes(
         const std::vector<size_t>&              triangle_indices,
         const std::vector<TriangleVertexInfo>&  triangle_vertex_infos,
@@ -210,10 +239,11 @@ class TriangleLeafVisitor
   : public foundation::NonCopyable
 {
   public:
-    // Constructor.
+    // Constructor. 'counters' may be null.
     TriangleLeafVisitor(
         const TriangleTree&                     tree,
-        ShadingPoint&                           shading_point);
+        ShadingPoint&                           shading_point,
+        IntersectionProfiler::Counters*         counters = 0);
 
     // Visit a leaf.
     bool visit(
@@ -233,9 +263,10 @@ class TriangleLeafVisitor
     const TriangleTree&     m_tree;
     const bool              m_has_intersection_filters;
     ShadingPoint&           m_shading_point;
-    GTriangleType           m_interpolated_triangle;
+    GTriangleType           m_decoded_triangle;
     const GTriangleType*    m_hit_triangle;
     size_t                  m_hit_triangle_index;
+    IntersectionProfiler::Counters* m_counters;
 };
 
 
@@ -248,11 +279,12 @@ class TriangleLeafProbeVisitor
   : public ProbeVisitorBase
 {
   public:
-    // Constructor.
+    // Constructor. 'counters' may be null.
     TriangleLeafProbeVisitor(
         const TriangleTree&                     tree,
         const double                            ray_time,
-        const VisibilityFlags::Type             ray_flags);
+        const VisibilityFlags::Type             ray_flags,
+        IntersectionProfiler::Counters*         counters = 0);
 
     // Visit a leaf.
     bool visit(
@@ -265,11 +297,18 @@ class TriangleLeafProbeVisitor
 #endif
         );
 
+    // Return the triangle that was hit, or 0 if there was no hit or if the
+    // triangle that was hit is a moving triangle.
+    const GTriangleType* get_static_hit_triangle() const;
+
   private:
     const TriangleTree&         m_tree;
     const double                m_ray_time;
     const VisibilityFlags::Type m_ray_flags;
     const bool                  m_has_intersection_filters;
+    bool                        m_hit_triangle_is_static;
+    GTriangleType               m_hit_triangle;
+    IntersectionProfiler::Counters* m_counters;
 };
 
 
@@ -306,6 +345,11 @@ inline size_t TriangleTree::get_moving_triangle_count() const
     return m_moving_triangle_count;
 }
 
+inline bool TriangleTree::is_loaded_from_cache() const
+{
+    return m_loaded_from_cache;
+}
+
 
 //
 // TriangleLeafVisitor class implementation.
@@ -313,11 +357,13 @@ inline size_t TriangleTree::get_moving_triangle_count() const
 
 inline TriangleLeafVisitor::TriangleLeafVisitor(
     const TriangleTree&         tree,
-    ShadingPoint&               shading_point)
+    ShadingPoint&               shading_point,
+    IntersectionProfiler::Counters* counters)
   : m_tree(tree)
   , m_has_intersection_filters(!tree.m_intersection_filters.empty())
   , m_shading_point(shading_point)
   , m_hit_triangle(0)
+  , m_counters(counters)
 {
 }
 
@@ -329,12 +375,20 @@ inline TriangleLeafVisitor::TriangleLeafVisitor(
 inline TriangleLeafProbeVisitor::TriangleLeafProbeVisitor(
     const TriangleTree&         tree,
     const double                ray_time,
-    const VisibilityFlags::Type ray_flags)
+    const VisibilityFlags::Type ray_flags,
+    IntersectionProfiler::Counters* counters)
   : m_tree(tree)
   , m_ray_time(ray_time)
   , m_ray_flags(ray_flags)
   , m_has_intersection_filters(!tree.m_intersection_filters.empty())
+  , m_hit_triangle_is_static(false)
+  , m_counters(counters)
+{
+}
+
+inline const GTriangleType* TriangleLeafProbeVisitor::get_static_hit_triangle() const
 {
+    return m_hit_triangle_is_static ? &m_hit_triangle : 0;
 }
 
 }       // namespace renderer
@@ -32,7 +32,9 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/aov/spectrumstack.h"
+#include "renderer/kernel/lighting/lightreservoir.h"
 #include "renderer/kernel/lighting/lightsampler.h"
+#include "renderer/kernel/lighting/lightselectionguide.h"
 #include "renderer/kernel/lighting/tracer.h"
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
@@ -67,10 +69,12 @@ namespace renderer
 //   compute_outgoing_radiance_light_sampling
 //       add_emitting_triangle_sample_contribution
 //       add_non_physical_light_sample_contribution
+//       flush_deferred_light_samples
 //
 //   compute_outgoing_radiance_light_sampling_low_variance
 //       add_emitting_triangle_sample_contribution
 //       add_non_physical_light_sample_contribution
+//       flush_deferred_light_samples
 //
 //   compute_outgoing_radiance_combined_sampling
 //       compute_outgoing_radiance_bsdf_sampling
@@ -80,6 +84,9 @@ namespace renderer
 //       compute_outgoing_radiance_bsdf_sampling
 //       compute_outgoing_radiance_light_sampling_low_variance
 //
+//   compute_outgoing_radiance_light_sampling_resampled
+//       evaluate_light_sample
+//
 //   compute_incoming_radiance
 //
 
@@ -93,7 +100,9 @@ DirectLightingIntegrator::DirectLightingIntegrator(
     const int                   light_sampling_modes,
     const size_t                bsdf_sample_count,
     const size_t                light_sample_count,
-    const bool                  indirect)
+    const bool                  indirect,
+    const bool                  deferred_shadow_rays,
+    LightSelectionGuide*        light_selection_guide)
   : m_shading_context(shading_context)
   , m_light_sampler(light_sampler)
   , m_shading_point(shading_point)
@@ -108,6 +117,13 @@ DirectLightingIntegrator::DirectLightingIntegrator(
   , m_bsdf_sample_count(bsdf_sample_count)
   , m_light_sample_count(light_sample_count)
   , m_indirect(indirect)
+  , m_deferred_shadow_rays(deferred_shadow_rays)
+  , m_light_selection_guide(light_selection_guide)
+{
+}
+
+DirectLightingIntegrator::DeferredLightSamples::DeferredLightSamples()
+  : m_count(0)
 {
 }
 
@@ -163,15 +179,30 @@ void DirectLightingIntegrator::compute_outgoing_radiance_light_sampling(
 
     sampling_context.split_in_place(3, m_light_sample_count);
 
+    DeferredLightSamples deferred_samples;
+    DeferredLightSamples* deferred_samples_ptr = m_deferred_shadow_rays ? &deferred_samples : 0;
+
     // Add contributions from both emitting triangles and non-physical light sources.
     for (size_t i = 0; i < m_light_sample_count; ++i)
     {
         // Sample both emitting triangles and non-physical light sources.
         LightSample sample;
-        m_light_sampler.sample(
-            m_time,
-            sampling_context.next2<Vector3f>(),
-            sample);
+        if (m_light_selection_guide)
+        {
+            m_light_selection_guide->sample(
+                m_time,
+                m_point,
+                sampling_context.next2<Vector3f>(),
+                sample);
+        }
+        else
+        {
+            m_light_sampler.sample(
+                m_time,
+                m_point,
+                sampling_context.next2<Vector3f>(),
+                sample);
+        }
 
         if (sample.m_triangle)
         {
@@ -180,18 +211,23 @@ void DirectLightingIntegrator::compute_outgoing_radiance_light_sampling(
                 mis_heuristic,
                 outgoing,
                 radiance,
-                aovs);
+                aovs,
+                deferred_samples_ptr);
         }
         else
         {
             add_non_physical_light_sample_contribution(
                 sample,
+                ~size_t(0),
                 outgoing,
                 radiance,
-                aovs);
+                aovs,
+                deferred_samples_ptr);
         }
     }
 
+    flush_deferred_light_samples(radiance, aovs, deferred_samples);
+
     if (m_light_sample_count > 1)
     {
         const float rcp_light_sample_count = 1.0f / m_light_sample_count;
@@ -218,6 +254,9 @@ void DirectLightingIntegrator::compute_outgoing_radiance_light_sampling_low_vari
     if (m_bsdf.is_purely_specular())
         return;
 
+    DeferredLightSamples deferred_samples;
+    DeferredLightSamples* deferred_samples_ptr = m_deferred_shadow_rays ? &deferred_samples : 0;
+
     // Add contributions from emitting triangles only.
     if (m_light_sampler.get_emitting_triangle_count() > 0)
     {
@@ -227,19 +266,34 @@ void DirectLightingIntegrator::compute_outgoing_radiance_light_sampling_low_vari
         {
             // Sample emitting triangles only.
             LightSample sample;
-            m_light_sampler.sample_emitting_triangles(
-                m_time,
-                sampling_context.next2<Vector3f>(),
-                sample);
+            if (m_light_selection_guide)
+            {
+                m_light_selection_guide->sample_emitting_triangles(
+                    m_time,
+                    m_point,
+                    sampling_context.next2<Vector3f>(),
+                    sample);
+            }
+            else
+            {
+                m_light_sampler.sample_emitting_triangles(
+                    m_time,
+                    m_point,
+                    sampling_context.next2<Vector3f>(),
+                    sample);
+            }
 
             add_emitting_triangle_sample_contribution(
                 sample,
                 mis_heuristic,
                 outgoing,
                 radiance,
-                aovs);
+                aovs,
+                deferred_samples_ptr);
         }
 
+        flush_deferred_light_samples(radiance, aovs, deferred_samples);
+
         if (m_light_sample_count > 1)
         {
             const float rcp_light_sample_count = 1.0f / m_light_sample_count;
@@ -251,15 +305,38 @@ void DirectLightingIntegrator::compute_outgoing_radiance_light_sampling_low_vari
     // Add contributions from non-physical light sources only.
     for (size_t i = 0, e = m_light_sampler.get_non_physical_light_count(); i < e; ++i)
     {
+        // Skip lights that cannot illuminate this point, saving their shadow rays.
+        if (!m_light_sampler.may_illuminate(i, m_point))
+            continue;
+
+        // Randomly skip lights that were learned to contribute little to this region,
+        // dividing the contributions of the lights that are kept by their probability.
+        float light_prob = 1.0f;
+        if (m_light_selection_guide)
+        {
+            light_prob = m_light_selection_guide->get_non_physical_light_probability(i, m_point);
+            if (light_prob < 1.0f)
+            {
+                sampling_context.split_in_place(1, 1);
+                if (sampling_context.next2<float>() >= light_prob)
+                    continue;
+            }
+        }
+
         LightSample sample;
         m_light_sampler.sample_non_physical_light(m_time, i, sample);
+        sample.m_probability *= light_prob;
 
         add_non_physical_light_sample_contribution(
             sample,
+            i,
             outgoing,
             radiance,
-            aovs);
+            aovs,
+            deferred_samples_ptr);
     }
+
+    flush_deferred_light_samples(radiance, aovs, deferred_samples);
 }
 
 void DirectLightingIntegrator::compute_outgoing_radiance_combined_sampling(
@@ -316,6 +393,136 @@ void DirectLightingIntegrator::compute_outgoing_radiance_combined_sampling_low_v
     aovs += aovs_light_sampling;
 }
 
+void DirectLightingIntegrator::compute_outgoing_radiance_light_sampling_resampled(
+    SamplingContext&            sampling_context,
+    const Dual3d&               outgoing,
+    Spectrum&                   radiance,
+    SpectrumStack&              aovs,
+    const LightReservoir*       reused_reservoirs,
+    const size_t                reused_reservoir_count,
+    LightReservoir*             output_reservoir) const
+{
+    radiance.set(0.0f);
+    aovs.set(0.0f);
+
+    if (output_reservoir)
+        *output_reservoir = LightReservoir();
+
+    // No light source in the scene.
+    if (!m_light_sampler.has_lights_or_emitting_triangles())
+        return;
+
+    // There cannot be any contribution for purely specular BSDFs.
+    if (m_bsdf.is_purely_specular())
+        return;
+
+    // A single random number drives the selection among all candidates.
+    sampling_context.split_in_place(1, 1);
+    float s = sampling_context.next2<float>();
+
+    LightReservoir reservoir;
+    Spectrum selected_value(Spectrum::Illuminance);
+    Vector3d selected_target;
+    size_t selected_render_layer = 0;
+
+    // Stream the candidates through the reservoir.
+    if (m_light_sample_count > 0)
+    {
+        sampling_context.split_in_place(3, m_light_sample_count);
+
+        for (size_t i = 0; i < m_light_sample_count; ++i)
+        {
+            LightSample sample;
+            if (m_light_selection_guide)
+            {
+                m_light_selection_guide->sample(
+                    m_time,
+                    m_point,
+                    sampling_context.next2<Vector3f>(),
+                    sample);
+            }
+            else
+            {
+                m_light_sampler.sample(
+                    m_time,
+                    m_point,
+                    sampling_context.next2<Vector3f>(),
+                    sample);
+            }
+
+            Spectrum value(Spectrum::Illuminance);
+            Vector3d target;
+            size_t render_layer;
+            if (!evaluate_light_sample(sample, outgoing, value, target, render_layer))
+            {
+                reservoir.m_sample_count += 1.0f;
+                continue;
+            }
+
+            const float target_function = average_value(value);
+            if (reservoir.update(sample, target_function, target_function / sample.m_probability, 1.0f, s))
+            {
+                selected_value = value;
+                selected_target = target;
+                selected_render_layer = render_layer;
+            }
+        }
+    }
+
+    // Stream the reused reservoirs, with their selected sample evaluated at this shading point.
+    // The history of reused reservoirs is bounded to let the estimate adapt to changes.
+    const float max_reused_sample_count = 20.0f * max<size_t>(m_light_sample_count, 1);
+    for (size_t i = 0; i < reused_reservoir_count; ++i)
+    {
+        const LightReservoir& reused = reused_reservoirs[i];
+        const float count = min(reused.m_sample_count, max_reused_sample_count);
+
+        Spectrum value(Spectrum::Illuminance);
+        Vector3d target;
+        size_t render_layer;
+        if (!evaluate_light_sample(reused.m_sample, outgoing, value, target, render_layer))
+        {
+            reservoir.m_sample_count += count;
+            continue;
+        }
+
+        const float target_function = average_value(value);
+        const float weight = target_function * reused.get_contribution_weight() * count;
+        if (reservoir.update(reused.m_sample, target_function, weight, count, s))
+        {
+            selected_value = value;
+            selected_target = target;
+            selected_render_layer = render_layer;
+        }
+    }
+
+    if (reservoir.m_target == 0.0f)
+        return;
+
+    // Compute the transmission factor between the selected light sample and the shading point.
+    const float transmission =
+        m_shading_context.get_tracer().trace_between(
+            m_shading_point,
+            selected_target,
+            VisibilityFlags::ShadowRay);
+
+    // Occluded samples are kept with a zero weight so that they are not propagated.
+    if (output_reservoir)
+    {
+        *output_reservoir = reservoir;
+        if (transmission == 0.0f)
+            output_reservoir->m_weight_sum = 0.0f;
+    }
+
+    if (transmission == 0.0f)
+        return;
+
+    // Add the contribution of the selected sample to the illumination.
+    selected_value *= transmission * reservoir.get_contribution_weight();
+    radiance += selected_value;
+    aovs.add(selected_render_layer, selected_value);
+}
+
 bool DirectLightingIntegrator::compute_incoming_radiance(
     SamplingContext&            sampling_context,
     Vector3d&                   incoming,
@@ -332,10 +539,22 @@ bool DirectLightingIntegrator::compute_incoming_radiance(
 
     // Sample both emitting triangles and non-physical light sources.
     LightSample sample;
-    m_light_sampler.sample(
-        m_time,
-        sampling_context.next2<Vector3f>(),
-        sample);
+    if (m_light_selection_guide)
+    {
+        m_light_selection_guide->sample(
+            m_time,
+            m_point,
+            sampling_context.next2<Vector3f>(),
+            sample);
+    }
+    else
+    {
+        m_light_sampler.sample(
+            m_time,
+            m_point,
+            sampling_context.next2<Vector3f>(),
+            sample);
+    }
 
     if (sample.m_triangle)
     {
@@ -537,7 +756,10 @@ void DirectLightingIntegrator::take_single_bsdf_sample(
             const float bsdf_prob_area = sample.m_probability * cos_on / static_cast<float>(square_distance);
 
             // Compute the probability density wrt. surface area mesure of the light sample.
-            const float light_prob_area = m_light_sampler.evaluate_pdf(light_shading_point);
+            const float light_prob_area =
+                m_light_selection_guide
+                    ? m_light_selection_guide->evaluate_pdf(light_shading_point, m_point)
+                    : m_light_sampler.evaluate_pdf(light_shading_point, m_point);
 
             // Apply the weighting function.
             weight *=
@@ -561,7 +783,8 @@ void DirectLightingIntegrator::add_emitting_triangle_sample_contribution(
     const MISHeuristic          mis_heuristic,
     const Dual3d&               outgoing,
     Spectrum&                   radiance,
-    SpectrumStack&              aovs) const
+    SpectrumStack&              aovs,
+    DeferredLightSamples*       deferred_samples) const
 {
     const Material* material = sample.m_triangle->m_material;
     const Material::RenderData& material_data = material->get_render_data();
@@ -590,16 +813,21 @@ void DirectLightingIntegrator::add_emitting_triangle_sample_contribution(
     if (cos_on <= 0.0)
         return;
 
-    // Compute the transmission factor between the light sample and the shading point.
-    const float transmission =
-        m_shading_context.get_tracer().trace_between(
-            m_shading_point,
-            sample.m_point,
-            VisibilityFlags::ShadowRay);
+    // Compute the transmission factor between the light sample and the shading point,
+    // unless visibility is resolved later.
+    float transmission = 1.0f;
+    if (deferred_samples == 0)
+    {
+        transmission =
+            m_shading_context.get_tracer().trace_between(
+                m_shading_point,
+                sample.m_point,
+                VisibilityFlags::ShadowRay);
 
-    // Discard occluded samples.
-    if (transmission == 0.0f)
-        return;
+        // Discard occluded samples.
+        if (transmission == 0.0f)
+            return;
+    }
 
     // Compute the square distance between the light sample and the shading point.
     const double square_distance = square_norm(incoming);
@@ -666,15 +894,33 @@ void DirectLightingIntegrator::add_emitting_triangle_sample_contribution(
     // Add the contribution of this sample to the illumination.
     edf_value *= weight;
     edf_value *= bsdf_value;
-    radiance += edf_value;
-    aovs.add(edf->get_render_layer_index(), edf_value);
+    if (deferred_samples)
+    {
+        defer_light_sample_contribution(
+            sample.m_point,
+            edf_value,
+            edf->get_render_layer_index(),
+            sample.m_triangle,
+            ~size_t(0),
+            radiance,
+            aovs,
+            *deferred_samples);
+    }
+    else
+    {
+        radiance += edf_value;
+        aovs.add(edf->get_render_layer_index(), edf_value);
+        record_light_sample_contribution(sample.m_triangle, ~size_t(0), edf_value);
+    }
 }
 
 void DirectLightingIntegrator::add_non_physical_light_sample_contribution(
     const LightSample&          sample,
+    const size_t                light_index,
     const Dual3d&               outgoing,
     Spectrum&                   radiance,
-    SpectrumStack&              aovs) const
+    SpectrumStack&              aovs,
+    DeferredLightSamples*       deferred_samples) const
 {
     const Light* light = sample.m_light;
 
@@ -707,16 +953,21 @@ void DirectLightingIntegrator::add_non_physical_light_sample_contribution(
             return;
     }
 
-    // Compute the transmission factor between the light sample and the shading point.
-    const float transmission =
-        m_shading_context.get_tracer().trace_between(
-            m_shading_point,
-            emission_position,
-            VisibilityFlags::ShadowRay);
+    // Compute the transmission factor between the light sample and the shading point,
+    // unless visibility is resolved later.
+    float transmission = 1.0f;
+    if (deferred_samples == 0)
+    {
+        transmission =
+            m_shading_context.get_tracer().trace_between(
+                m_shading_point,
+                emission_position,
+                VisibilityFlags::ShadowRay);
 
-    // Discard occluded samples.
-    if (transmission == 0.0f)
-        return;
+        // Discard occluded samples.
+        if (transmission == 0.0f)
+            return;
+    }
 
     // Evaluate the BSDF.
     Spectrum bsdf_value;
@@ -739,8 +990,215 @@ void DirectLightingIntegrator::add_non_physical_light_sample_contribution(
     const float weight = transmission * attenuation / sample.m_probability;
     light_value *= weight;
     light_value *= bsdf_value;
-    radiance += light_value;
-    aovs.add(light->get_render_layer_index(), light_value);
+    if (deferred_samples)
+    {
+        defer_light_sample_contribution(
+            emission_position,
+            light_value,
+            light->get_render_layer_index(),
+            0,
+            light_index,
+            radiance,
+            aovs,
+            *deferred_samples);
+    }
+    else
+    {
+        radiance += light_value;
+        aovs.add(light->get_render_layer_index(), light_value);
+        record_light_sample_contribution(0, light_index, light_value);
+    }
+}
+
+void DirectLightingIntegrator::defer_light_sample_contribution(
+    const Vector3d&             target,
+    const Spectrum&             value,
+    const size_t                render_layer,
+    const EmittingTriangle*     triangle,
+    const size_t                light_index,
+    Spectrum&                   radiance,
+    SpectrumStack&              aovs,
+    DeferredLightSamples&       deferred_samples) const
+{
+    if (deferred_samples.m_count == DeferredLightSamples::MaxSampleCount)
+        flush_deferred_light_samples(radiance, aovs, deferred_samples);
+
+    const size_t index = deferred_samples.m_count++;
+    deferred_samples.m_targets[index] = target;
+    deferred_samples.m_values[index] = value;
+    deferred_samples.m_render_layers[index] = render_layer;
+    deferred_samples.m_triangles[index] = triangle;
+    deferred_samples.m_light_indices[index] = light_index;
+}
+
+void DirectLightingIntegrator::flush_deferred_light_samples(
+    Spectrum&                   radiance,
+    SpectrumStack&              aovs,
+    DeferredLightSamples&       deferred_samples) const
+{
+    if (deferred_samples.m_count == 0)
+        return;
+
+    // Compute the transmission factors of all queued samples at once.
+    float transmissions[DeferredLightSamples::MaxSampleCount];
+    m_shading_context.get_tracer().trace_between(
+        m_shading_point,
+        deferred_samples.m_targets,
+        deferred_samples.m_count,
+        VisibilityFlags::ShadowRay,
+        transmissions);
+
+    // Add the contributions of the visible samples to the illumination.
+    for (size_t i = 0; i < deferred_samples.m_count; ++i)
+    {
+        if (transmissions[i] == 0.0f)
+            continue;
+
+        Spectrum& value = deferred_samples.m_values[i];
+        value *= transmissions[i];
+        radiance += value;
+        aovs.add(deferred_samples.m_render_layers[i], value);
+        record_light_sample_contribution(
+            deferred_samples.m_triangles[i],
+            deferred_samples.m_light_indices[i],
+            value);
+    }
+
+    deferred_samples.m_count = 0;
+}
+
+bool DirectLightingIntegrator::evaluate_light_sample(
+    const LightSample&          sample,
+    const Dual3d&               outgoing,
+    Spectrum&                   value,
+    Vector3d&                   target,
+    size_t&                     render_layer) const
+{
+    Vector3d incoming;
+    float weight;
+
+    if (sample.m_triangle)
+    {
+        const Material* material = sample.m_triangle->m_material;
+        const Material::RenderData& material_data = material->get_render_data();
+        const EDF* edf = material_data.m_edf;
+
+        // No contribution if we are computing indirect lighting but this light does not cast indirect light.
+        if (m_indirect && !(edf->get_flags() & EDF::CastIndirectLight))
+            return false;
+
+        // Compute the incoming direction in world space.
+        incoming = sample.m_point - m_point;
+
+        // No contribution if the shading point is behind the light.
+        double cos_on = dot(-incoming, sample.m_shading_normal);
+        if (cos_on <= 0.0)
+            return false;
+
+        // Don't use this sample if we're closer than the light near start value.
+        const double square_distance = square_norm(incoming);
+        if (square_distance < square(edf->get_light_near_start()))
+            return false;
+
+        // Normalize the incoming direction.
+        const double rcp_square_distance = 1.0 / square_distance;
+        const double rcp_distance = sqrt(rcp_square_distance);
+        incoming *= rcp_distance;
+        cos_on *= rcp_distance;
+
+        // Build a shading point on the light source.
+        ShadingPoint light_shading_point;
+        sample.make_shading_point(
+            light_shading_point,
+            sample.m_shading_normal,
+            m_shading_context.get_intersector());
+
+        if (material_data.m_shader_group)
+        {
+            m_shading_context.execute_osl_emission(
+                *material_data.m_shader_group,
+                light_shading_point);
+        }
+
+        // Evaluate the EDF.
+        edf->evaluate(
+            edf->evaluate_inputs(m_shading_context, light_shading_point),
+            Vector3f(sample.m_geometric_normal),
+            Basis3f(Vector3f(sample.m_shading_normal)),
+            -Vector3f(incoming),
+            value);
+
+        target = sample.m_point;
+        render_layer = edf->get_render_layer_index();
+        weight = static_cast<float>(cos_on * rcp_square_distance);
+    }
+    else
+    {
+        const Light* light = sample.m_light;
+
+        // No contribution if we are computing indirect lighting but this light does not cast indirect light.
+        if (m_indirect && !(light->get_flags() & Light::CastIndirectLight))
+            return false;
+
+        // Evaluate the light.
+        Vector3d emission_direction;
+        light->evaluate(
+            m_shading_context,
+            sample.m_light_transform,
+            m_point,
+            target,
+            emission_direction,
+            value);
+
+        incoming = -emission_direction;
+        render_layer = light->get_render_layer_index();
+        weight = light->compute_distance_attenuation(m_point, target);
+    }
+
+    // Cull light samples behind the shading surface if the BSDF is either reflective or transmissive,
+    // but not both.
+    if (m_bsdf.get_type() != BSDF::AllBSDFTypes)
+    {
+        double cos_in = dot(incoming, m_shading_basis.get_normal());
+        if (m_bsdf.get_type() == BSDF::Transmissive)
+            cos_in = -cos_in;
+        if (cos_in <= 0.0)
+            return false;
+    }
+
+    // Evaluate the BSDF.
+    Spectrum bsdf_value;
+    const float bsdf_prob =
+        m_bsdf.evaluate(
+            m_bsdf_data,
+            false,              // not adjoint
+            true,               // multiply by |cos(incoming, normal)|
+            Vector3f(m_geometric_normal),
+            Basis3f(m_shading_basis),
+            Vector3f(outgoing.get_value()),
+            Vector3f(incoming),
+            m_light_sampling_modes,
+            bsdf_value);
+    if (bsdf_prob == 0.0f)
+        return false;
+
+    value *= weight;
+    value *= bsdf_value;
+
+    return true;
+}
+
+void DirectLightingIntegrator::record_light_sample_contribution(
+    const EmittingTriangle*     triangle,
+    const size_t                light_index,
+    const Spectrum&             value) const
+{
+    if (m_light_selection_guide == 0 || !m_light_selection_guide->is_training())
+        return;
+
+    if (triangle)
+        m_light_selection_guide->record_emitting_triangle(m_point, triangle, average_value(value));
+    else m_light_selection_guide->record_non_physical_light(m_point, light_index, average_value(value));
 }
 
 }   // namespace renderer
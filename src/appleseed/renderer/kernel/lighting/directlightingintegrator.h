@@ -45,8 +45,11 @@
 
 // Forward declarations.
 namespace renderer  { class BSDF; }
+namespace renderer  { class EmittingTriangle; }
+namespace renderer  { class LightReservoir; }
 namespace renderer  { class LightSample; }
 namespace renderer  { class LightSampler; }
+namespace renderer  { class LightSelectionGuide; }
 namespace renderer  { class ShadingContext; }
 namespace renderer  { class ShadingPoint; }
 namespace renderer  { class SpectrumStack; }
@@ -68,6 +71,29 @@ namespace renderer
 //   The number of shadow rays cast by these functions may be as high as the number of light
 //   samples passed to the constructor plus the number of non-physical lights in the scene.
 //
+// Note about deferred shadow rays:
+//
+//   When 'deferred_shadow_rays' is true, the light sampling methods first compute the unoccluded
+//   contribution of all light samples, then trace their shadow rays as a batch and only then
+//   accumulate the contributions of the visible samples. This amortizes the cost of tracing
+//   rays in scenes with many lights, at the expense of evaluating the BSDF and the EDFs of
+//   occluded samples.
+//
+// Note about resampled light sampling:
+//
+//   compute_outgoing_radiance_light_sampling_resampled() draws 'light_sample_count' light samples
+//   as candidates, keeps a single one of them with a probability proportional to its unoccluded
+//   contribution, and only traces the shadow ray of that one. Reservoirs of candidates gathered
+//   at other shading points may be passed to it to be reused. Since it is meant to be the sole
+//   estimator of direct lighting, its results are not weighted by multiple importance sampling.
+//
+// Note about the light selection guide:
+//
+//   When a light selection guide is provided, emitting triangles are chosen with its learned
+//   distributions, non-physical lights enumerated by the low variance methods are skipped with
+//   its learned probabilities, and the contributions of the light samples are recorded into it
+//   while it is training.
+//
 
 class DirectLightingIntegrator
 {
@@ -83,7 +109,9 @@ class DirectLightingIntegrator
         const int                       light_sampling_modes,       // permitted scattering modes during environment sampling
         const size_t                    bsdf_sample_count,          // number of samples in BSDF sampling
         const size_t                    light_sample_count,         // number of samples in light sampling
-        const bool                      indirect);                  // are we computing indirect lighting?
+        const bool                      indirect,                   // are we computing indirect lighting?
+        const bool                      deferred_shadow_rays = false,   // trace shadow rays of light samples as a batch?
+        LightSelectionGuide*            light_selection_guide = 0);     // learned light selection probabilities, or 0
 
     // Compute outgoing radiance due to direct lighting via combined BSDF and light sampling.
     void compute_outgoing_radiance_combined_sampling(
@@ -119,6 +147,17 @@ class DirectLightingIntegrator
         Spectrum&                       radiance,
         SpectrumStack&                  aovs) const;
 
+    // Compute outgoing radiance due to direct lighting via resampled light sampling only.
+    // If 'output_reservoir' is not null, the final reservoir is stored into it for later reuse.
+    void compute_outgoing_radiance_light_sampling_resampled(
+        SamplingContext&                sampling_context,
+        const foundation::Dual3d&       outgoing,                   // world space outgoing direction, unit-length
+        Spectrum&                       radiance,
+        SpectrumStack&                  aovs,
+        const LightReservoir*           reused_reservoirs = 0,
+        const size_t                    reused_reservoir_count = 0,
+        LightReservoir*                 output_reservoir = 0) const;
+
     // Evaluate incoming radiance.
     bool compute_incoming_radiance(
         SamplingContext&                sampling_context,
@@ -141,6 +180,23 @@ class DirectLightingIntegrator
     const size_t                        m_bsdf_sample_count;
     const size_t                        m_light_sample_count;
     const bool                          m_indirect;
+    const bool                          m_deferred_shadow_rays;
+    LightSelectionGuide*                m_light_selection_guide;
+
+    // Light samples whose visibility has not been resolved yet.
+    struct DeferredLightSamples
+    {
+        enum { MaxSampleCount = 16 };
+
+        size_t                          m_count;
+        foundation::Vector3d            m_targets[MaxSampleCount];
+        Spectrum                        m_values[MaxSampleCount];   // unoccluded contributions
+        size_t                          m_render_layers[MaxSampleCount];
+        const EmittingTriangle*         m_triangles[MaxSampleCount];    // emitting triangle of the sample, or 0
+        size_t                          m_light_indices[MaxSampleCount];
+
+        DeferredLightSamples();
+    };
 
     void take_single_bsdf_sample(
         SamplingContext&                sampling_context,
@@ -149,18 +205,55 @@ class DirectLightingIntegrator
         Spectrum&                       radiance,
         SpectrumStack&                  aovs) const;
 
+    // If 'deferred_samples' is not null, the contribution of the sample is queued
+    // instead of being traced and added right away.
     void add_emitting_triangle_sample_contribution(
         const LightSample&              sample,
         const foundation::MISHeuristic  mis_heuristic,
         const foundation::Dual3d&       outgoing,
         Spectrum&                       radiance,
-        SpectrumStack&                  aovs) const;
+        SpectrumStack&                  aovs,
+        DeferredLightSamples*           deferred_samples) const;
 
+    // 'light_index' is the index of the sampled light in the light sampler, or ~0 if unknown.
     void add_non_physical_light_sample_contribution(
         const LightSample&              sample,
+        const size_t                    light_index,
         const foundation::Dual3d&       outgoing,
         Spectrum&                       radiance,
-        SpectrumStack&                  aovs) const;
+        SpectrumStack&                  aovs,
+        DeferredLightSamples*           deferred_samples) const;
+
+    void defer_light_sample_contribution(
+        const foundation::Vector3d&     target,
+        const Spectrum&                 value,
+        const size_t                    render_layer,
+        const EmittingTriangle*         triangle,
+        const size_t                    light_index,
+        Spectrum&                       radiance,
+        SpectrumStack&                  aovs,
+        DeferredLightSamples&           deferred_samples) const;
+
+    // Trace the shadow rays of the queued light samples and add the contributions of the visible ones.
+    void flush_deferred_light_samples(
+        Spectrum&                       radiance,
+        SpectrumStack&                  aovs,
+        DeferredLightSamples&           deferred_samples) const;
+
+    // Compute the unoccluded contribution of a light sample, not divided by its probability density.
+    // Return false if the light sample does not contribute.
+    bool evaluate_light_sample(
+        const LightSample&              sample,
+        const foundation::Dual3d&       outgoing,
+        Spectrum&                       value,
+        foundation::Vector3d&           target,                     // world space point at which to aim the shadow ray
+        size_t&                         render_layer) const;
+
+    // Record the final contribution of a light sample into the light selection guide.
+    void record_light_sample_contribution(
+        const EmittingTriangle*         triangle,
+        const size_t                    light_index,
+        const Spectrum&                 value) const;
 };
 
 }       // namespace renderer
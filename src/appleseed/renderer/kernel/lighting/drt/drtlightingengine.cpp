@@ -36,23 +36,30 @@
 #include "renderer/kernel/aov/spectrumstack.h"
 #include "renderer/kernel/lighting/directlightingintegrator.h"
 #include "renderer/kernel/lighting/imagebasedlighting.h"
+#include "renderer/kernel/lighting/irradiancecache.h"
 #include "renderer/kernel/lighting/pathtracer.h"
 #include "renderer/kernel/lighting/pathvertex.h"
 #include "renderer/kernel/lighting/scatteringmode.h"
+#include "renderer/kernel/intersection/intersector.h"
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
 #include "renderer/modeling/bsdf/bsdf.h"
 #include "renderer/modeling/edf/edf.h"
 #include "renderer/modeling/environment/environment.h"
 #include "renderer/modeling/environmentedf/environmentedf.h"
+#include "renderer/modeling/material/material.h"
 #include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/visibilityflags.h"
 #include "renderer/utility/stochasticcast.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/basis.h"
 #include "foundation/math/mis.h"
 #include "foundation/math/population.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/types.h"
+#include "foundation/utility/arena.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/string.h"
@@ -61,6 +68,8 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <limits>
+#include <new>
 #include <string>
 
 // Forward declarations.
@@ -92,6 +101,9 @@ namespace
 
             const float     m_dl_light_sample_count;        // number of light samples used to estimate direct illumination
             const float     m_ibl_env_sample_count;         // number of environment samples used to estimate IBL
+            const bool      m_ibl_prefiltered_glossy;       // look up glossy reflections of the environment in a prefiltered map?
+
+            const bool      m_enable_irradiance_cache;      // are diffuse interreflections computed with an irradiance cache?
 
             float           m_rcp_dl_light_sample_count;
             float           m_rcp_ibl_env_sample_count;
@@ -102,6 +114,8 @@ namespace
               , m_rr_min_path_length(nz(params.get_optional<size_t>("rr_min_path_length", 6)))
               , m_dl_light_sample_count(params.get_optional<float>("dl_light_samples", 1.0f))
               , m_ibl_env_sample_count(params.get_optional<float>("ibl_env_samples", 1.0f))
+              , m_ibl_prefiltered_glossy(params.get_optional<bool>("ibl_prefiltered_glossy", false))
+              , m_enable_irradiance_cache(params.get_optional<bool>("enable_irradiance_cache", false))
             {
                 // Precompute the reciprocal of the number of light samples.
                 m_rcp_dl_light_sample_count =
@@ -129,20 +143,26 @@ namespace
                     "  max path length  %s\n"
                     "  rr min path len. %s\n"
                     "  dl light samples %s\n"
-                    "  ibl env samples  %s",
+                    "  ibl env samples  %s\n"
+                    "  prefiltered ibl  %s\n"
+                    "  irradiance cache %s",
                     m_enable_ibl ? "on" : "off",
                     m_max_path_length == size_t(~0) ? "infinite" : pretty_uint(m_max_path_length).c_str(),
                     m_rr_min_path_length == size_t(~0) ? "infinite" : pretty_uint(m_rr_min_path_length).c_str(),
                     pretty_scalar(m_dl_light_sample_count).c_str(),
-                    pretty_scalar(m_ibl_env_sample_count).c_str());
+                    pretty_scalar(m_ibl_env_sample_count).c_str(),
+                    m_ibl_prefiltered_glossy ? "on" : "off",
+                    m_enable_irradiance_cache ? "on" : "off");
             }
         };
 
         DRTLightingEngine(
             const LightSampler&     light_sampler,
+            IrradianceCache*        irradiance_cache,
             const ParamArray&       params)
           : m_params(params)
           , m_light_sampler(light_sampler)
+          , m_irradiance_cache(irradiance_cache)
           , m_path_count(0)
         {
         }
@@ -163,6 +183,7 @@ namespace
             PathVisitor path_visitor(
                 m_params,
                 m_light_sampler,
+                m_irradiance_cache,
                 sampling_context,
                 shading_context,
                 shading_point.get_scene(),
@@ -192,12 +213,16 @@ namespace
             stats.insert("path count", m_path_count);
             stats.insert("path length", m_path_length);
 
+            if (m_irradiance_cache)
+                stats.insert<uint64>("irradiance cache records", m_irradiance_cache->get_record_count());
+
             return StatisticsVector::make("distribution ray tracing statistics", stats);
         }
 
       private:
         const Parameters        m_params;
         const LightSampler&     m_light_sampler;
+        IrradianceCache*        m_irradiance_cache;
 
         uint64                  m_path_count;
         Population<uint64>      m_path_length;
@@ -206,6 +231,7 @@ namespace
         {
             const Parameters&           m_params;
             const LightSampler&         m_light_sampler;
+            IrradianceCache*            m_irradiance_cache;
             SamplingContext&            m_sampling_context;
             const ShadingContext&       m_shading_context;
             const EnvironmentEDF*       m_env_edf;
@@ -215,6 +241,7 @@ namespace
             PathVisitor(
                 const Parameters&       params,
                 const LightSampler&     light_sampler,
+                IrradianceCache*        irradiance_cache,
                 SamplingContext&        sampling_context,
                 const ShadingContext&   shading_context,
                 const Scene&            scene,
@@ -222,6 +249,7 @@ namespace
                 SpectrumStack&          path_aovs)
               : m_params(params)
               , m_light_sampler(light_sampler)
+              , m_irradiance_cache(irradiance_cache)
               , m_sampling_context(sampling_context)
               , m_shading_context(shading_context)
               , m_env_edf(scene.get_environment()->get_environment_edf())
@@ -264,6 +292,14 @@ namespace
                             vertex_radiance,
                             vertex_aovs);
                     }
+
+                    // Diffuse interreflections.
+                    if (m_irradiance_cache)
+                    {
+                        add_indirect_diffuse_contribution(
+                            vertex,
+                            vertex_radiance);
+                    }
                 }
 
                 // Emitted light.
@@ -346,7 +382,9 @@ namespace
 
                 // Always sample both the environment and the BSDF. When sampling the BSDF,
                 // we limit ourselves to sampling diffuse components of the BSDF; sampling
-                // of glossy components will be done by extending the current path.
+                // of glossy components will be done by extending the current path. With
+                // prefiltered glossy IBL, glossy components are left out of environment
+                // sampling too: they are entirely estimated where the path escapes.
                 compute_ibl_combined_sampling(
                     m_sampling_context,
                     m_shading_context,
@@ -356,7 +394,9 @@ namespace
                     *vertex.m_bsdf,
                     vertex.m_bsdf_data,
                     ScatteringMode::Diffuse,
-                    ScatteringMode::All,
+                    m_params.m_ibl_prefiltered_glossy
+                        ? ScatteringMode::Diffuse
+                        : ScatteringMode::All,
                     bsdf_sample_count,
                     env_sample_count,
                     ibl_radiance);
@@ -370,6 +410,210 @@ namespace
                 vertex_aovs.add(m_env_edf->get_render_layer_index(), ibl_radiance);
             }
 
+            void add_indirect_diffuse_contribution(
+                const PathVertex&       vertex,
+                Spectrum&               vertex_radiance)
+            {
+                const ShadingPoint& shading_point = *vertex.m_shading_point;
+
+                // Work on the side of the surface facing the outgoing direction.
+                const Vector3d& shading_normal = shading_point.get_shading_normal();
+                const Vector3d normal = vertex.m_cos_on < 0.0 ? -shading_normal : shading_normal;
+
+                // Interpolate the irradiance from the cache, or create a new record.
+                Spectrum irradiance(Spectrum::Illuminance);
+                if (!m_irradiance_cache->lookup(shading_point.get_point(), normal, irradiance))
+                    create_irradiance_record(vertex, normal, irradiance);
+
+                // For a Lambertian BSDF, outgoing radiance is f * E.
+                Spectrum indirect_radiance(Spectrum::Illuminance);
+                const bool has_diffuse =
+                    evaluate_diffuse_bsdf(
+                        shading_point,
+                        *vertex.m_bsdf,
+                        vertex.m_bsdf_data,
+                        vertex.m_outgoing,
+                        normal,
+                        indirect_radiance);
+                if (!has_diffuse)
+                    return;
+
+                indirect_radiance *= irradiance;
+                vertex_radiance += indirect_radiance;
+            }
+
+            void create_irradiance_record(
+                const PathVertex&       vertex,
+                const Vector3d&         normal,
+                Spectrum&               irradiance)
+            {
+                const ShadingPoint& shading_point = *vertex.m_shading_point;
+                const ShadingRay& ray = shading_point.get_ray();
+                const Basis3d basis(normal);
+
+                const size_t theta_count = m_irradiance_cache->get_theta_stratum_count();
+                const size_t phi_count = m_irradiance_cache->get_phi_stratum_count();
+                const size_t sample_count = theta_count * phi_count;
+
+                // The per-stratum arrays live in the arena, below the mark that is rewound after each sample.
+                Arena& arena = m_shading_context.get_arena();
+                Vector2f* jitters = arena.allocate_array<Vector2f>(sample_count);
+                Spectrum* radiance = arena.allocate_array<Spectrum>(sample_count);
+                double* distances = arena.allocate_array<double>(sample_count);
+
+                // Generate the jitters of all strata upfront: the lighting computations
+                // at the hit points split the sampling context again.
+                SamplingContext child_sampling_context = m_sampling_context.split(2, sample_count);
+                for (size_t i = 0; i < sample_count; ++i)
+                {
+                    jitters[i] = child_sampling_context.next2<Vector2f>();
+                    new (&radiance[i]) Spectrum(0.0f, Spectrum::Illuminance);
+                    distances[i] = numeric_limits<double>::max();
+                }
+
+                // Memory allocated in the arena while shading the hit points is released after each sample.
+                const size_t arena_mark = arena.get_mark();
+
+                for (size_t j = 0; j < theta_count; ++j)
+                {
+                    for (size_t k = 0; k < phi_count; ++k)
+                    {
+                        const size_t i = j * phi_count + k;
+
+                        const Vector3d incoming =
+                            basis.transform_to_parent(m_irradiance_cache->sample_stratum(j, k, jitters[i]));
+
+                        const ShadingRay hemisphere_ray(
+                            shading_point.get_biased_point(incoming),
+                            incoming,
+                            ray.m_time,
+                            VisibilityFlags::DiffuseRay,
+                            ray.m_depth + 1);
+
+                        ShadingPoint hit;
+                        if (!m_shading_context.get_intersector().trace(hemisphere_ray, hit, &shading_point))
+                            continue;
+
+                        distances[i] = hit.get_distance();
+
+                        compute_hit_radiance(child_sampling_context, hit, radiance[i]);
+                        arena.rewind(arena_mark);
+                    }
+                }
+
+                m_irradiance_cache->insert(
+                    shading_point.get_point(),
+                    basis,
+                    radiance,
+                    distances,
+                    irradiance);
+            }
+
+            void compute_hit_radiance(
+                SamplingContext&        sampling_context,
+                const ShadingPoint&     hit,
+                Spectrum&               radiance)
+            {
+                // Skip surfaces without a BSDF. Light emitted by surfaces is excluded
+                // since it is already accounted for by direct lighting.
+                const Material* material = hit.get_material();
+                if (material == 0)
+                    return;
+
+                const Material::RenderData& material_data = material->get_render_data();
+                if (material_data.m_bsdf == 0)
+                    return;
+
+                if (material_data.m_shader_group)
+                {
+                    m_shading_context.execute_osl_shading(
+                        *material_data.m_shader_group,
+                        hit);
+                }
+
+                const BSDF& bsdf = *material_data.m_bsdf;
+                const void* bsdf_data = bsdf.evaluate_inputs(m_shading_context, hit);
+                const Dual3d outgoing(-hit.get_ray().m_dir);
+
+                // Direct lighting reflected by the diffuse components of the BSDF.
+                SpectrumStack aovs(0);
+                const DirectLightingIntegrator integrator(
+                    m_shading_context,
+                    m_light_sampler,
+                    hit,
+                    bsdf,
+                    bsdf_data,
+                    ScatteringMode::Diffuse,
+                    ScatteringMode::Diffuse,
+                    1,
+                    1,
+                    true);
+                integrator.compute_outgoing_radiance_light_sampling_low_variance(
+                    sampling_context,
+                    MISNone,
+                    outgoing,
+                    radiance,
+                    aovs);
+
+                // Image-based lighting reflected by the diffuse components of the BSDF.
+                if (m_params.m_enable_ibl && m_env_edf)
+                {
+                    Spectrum ibl_radiance(Spectrum::Illuminance);
+                    compute_ibl_environment_sampling(
+                        sampling_context,
+                        m_shading_context,
+                        *m_env_edf,
+                        hit,
+                        outgoing,
+                        bsdf,
+                        bsdf_data,
+                        ScatteringMode::Diffuse,
+                        0,
+                        1,
+                        ibl_radiance);
+                    radiance += ibl_radiance;
+                }
+
+                // Further bounces, from the records already in the cache.
+                const Vector3d& shading_normal = hit.get_shading_normal();
+                const Vector3d normal =
+                    dot(outgoing.get_value(), shading_normal) < 0.0 ? -shading_normal : shading_normal;
+                Spectrum irradiance(Spectrum::Illuminance);
+                if (m_irradiance_cache->lookup(hit.get_point(), normal, irradiance))
+                {
+                    Spectrum indirect_radiance(Spectrum::Illuminance);
+                    if (evaluate_diffuse_bsdf(hit, bsdf, bsdf_data, outgoing, normal, indirect_radiance))
+                    {
+                        indirect_radiance *= irradiance;
+                        radiance += indirect_radiance;
+                    }
+                }
+            }
+
+            // Evaluate the diffuse components of a BSDF for light arriving along the normal.
+            static bool evaluate_diffuse_bsdf(
+                const ShadingPoint&     shading_point,
+                const BSDF&             bsdf,
+                const void*             bsdf_data,
+                const Dual3d&           outgoing,
+                const Vector3d&         normal,
+                Spectrum&               value)
+            {
+                const float probability =
+                    bsdf.evaluate(
+                        bsdf_data,
+                        false,          // not adjoint
+                        true,           // multiply by |cos(incoming, normal)|
+                        Vector3f(shading_point.get_geometric_normal()),
+                        Basis3f(shading_point.get_shading_basis()),
+                        Vector3f(outgoing.get_value()),
+                        Vector3f(normal),
+                        ScatteringMode::Diffuse,
+                        value);
+
+                return probability > 0.0f;
+            }
+
             void add_emitted_light_contribution(
                 const PathVertex&       vertex,
                 Spectrum&               vertex_radiance,
@@ -407,6 +651,26 @@ namespace
                 if (!m_params.m_enable_ibl && vertex.m_prev_mode != ScatteringMode::Specular)
                     return;
 
+                // Look up glossy reflections of the environment in its prefiltered map, over a cone
+                // whose solid angle is the one covered by the BSDF sample. Environment sampling
+                // ignored glossy components, hence no multiple importance sampling.
+                if (m_params.m_ibl_prefiltered_glossy && vertex.m_prev_mode == ScatteringMode::Glossy)
+                {
+                    assert(vertex.m_prev_prob > 0.0f);
+
+                    Spectrum env_radiance(Spectrum::Illuminance);
+                    m_env_edf->evaluate_filtered(
+                        m_shading_context,
+                        -Vector3f(vertex.m_outgoing.get_value()),
+                        1.0f / vertex.m_prev_prob,
+                        env_radiance);
+
+                    env_radiance *= vertex.m_throughput;
+                    m_path_radiance += env_radiance;
+                    m_path_aovs.add(m_env_edf->get_render_layer_index(), env_radiance);
+                    return;
+                }
+
                 // Evaluate the environment EDF.
                 Spectrum env_radiance(Spectrum::Illuminance);
                 float env_prob;
@@ -448,12 +712,21 @@ namespace
 //
 
 DRTLightingEngineFactory::DRTLightingEngineFactory(
+    const Scene&        scene,
     const LightSampler& light_sampler,
     const ParamArray&   params)
   : m_light_sampler(light_sampler)
   , m_params(params)
 {
-    DRTLightingEngine::Parameters(params).print();
+    const DRTLightingEngine::Parameters engine_params(params);
+    engine_params.print();
+
+    if (engine_params.m_enable_irradiance_cache)
+        m_irradiance_cache.reset(new IrradianceCache(scene, params));
+}
+
+DRTLightingEngineFactory::~DRTLightingEngineFactory()
+{
 }
 
 void DRTLightingEngineFactory::release()
@@ -463,7 +736,7 @@ void DRTLightingEngineFactory::release()
 
 ILightingEngine* DRTLightingEngineFactory::create()
 {
-    return new DRTLightingEngine(m_light_sampler, m_params);
+    return new DRTLightingEngine(m_light_sampler, m_irradiance_cache.get(), m_params);
 }
 
 Dictionary DRTLightingEngineFactory::get_params_metadata()
@@ -489,6 +762,16 @@ Dictionary DRTLightingEngineFactory::get_params_metadata()
             .insert("min", "1")
             .insert("help", "Consider pruning low contribution paths starting with this bounce"));
 
+    metadata.dictionaries().insert(
+        "ibl_prefiltered_glossy",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Prefiltered Glossy IBL")
+            .insert("help", "Look up glossy reflections of the environment in a prefiltered map instead of sampling it (for previews)"));
+
+    IrradianceCache::add_params_metadata(metadata);
+
     return metadata;
 }
 
@@ -37,9 +37,14 @@
 // appleseed.foundation headers.
 #include "foundation/platform/compiler.h"
 
+// Standard headers.
+#include <memory>
+
 // Forward declarations.
 namespace foundation    { class Dictionary; }
+namespace renderer      { class IrradianceCache; }
 namespace renderer      { class LightSampler; }
+namespace renderer      { class Scene; }
 
 namespace renderer
 {
@@ -54,9 +59,13 @@ class DRTLightingEngineFactory
   public:
     // Constructor.
     DRTLightingEngineFactory(
+        const Scene&        scene,
         const LightSampler& light_sampler,
         const ParamArray&   params);
 
+    // Destructor.
+    ~DRTLightingEngineFactory();
+
     // Delete this instance.
     virtual void release() APPLESEED_OVERRIDE;
 
@@ -69,6 +78,9 @@ class DRTLightingEngineFactory
   private:
     const LightSampler&     m_light_sampler;
     ParamArray              m_params;
+
+    // Irradiance cache shared by all DRT lighting engines, or null if disabled.
+    std::auto_ptr<IrradianceCache>  m_irradiance_cache;
 };
 
 }       // namespace renderer
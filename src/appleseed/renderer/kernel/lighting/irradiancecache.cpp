@@ -0,0 +1,422 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "irradiancecache.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// IrradianceCache class implementation.
+//
+
+IrradianceCache::Parameters::Parameters(const ParamArray& params)
+  : m_max_error(params.get_optional<float>("irradiance_cache_max_error", 0.3f))
+  , m_sample_count(max<size_t>(params.get_optional<size_t>("irradiance_cache_samples", 256), 1))
+  , m_min_radius(params.get_optional<double>("irradiance_cache_min_radius", 0.001))
+  , m_max_radius(params.get_optional<double>("irradiance_cache_max_radius", 0.1))
+{
+}
+
+IrradianceCache::Node::Node()
+  : m_records(0)
+{
+    for (size_t i = 0; i < 8; ++i)
+        m_children[i].store(0);
+}
+
+IrradianceCache::Node::~Node()
+{
+    for (size_t i = 0; i < 8; ++i)
+        delete m_children[i].load();
+
+    Record* record = m_records.load();
+    while (record)
+    {
+        Record* next = record->m_next;
+        delete record;
+        record = next;
+    }
+}
+
+IrradianceCache::IrradianceCache(
+    const Scene&            scene,
+    const ParamArray&       params)
+  : m_params(params)
+  , m_record_count(0)
+{
+    // Split the hemisphere into M x N strata with N = Pi * M (Ward and Heckbert).
+    m_theta_stratum_count =
+        max<size_t>(static_cast<size_t>(sqrt(m_params.m_sample_count / Pi<double>()) + 0.5), 1);
+    m_phi_stratum_count =
+        max<size_t>((m_params.m_sample_count + m_theta_stratum_count / 2) / m_theta_stratum_count, 1);
+
+    // Make the bounds of the octree cubic.
+    AABB3d scene_bbox(scene.compute_bbox());
+    if (!scene_bbox.is_valid())
+        scene_bbox = AABB3d(Vector3d(-1.0), Vector3d(1.0));
+    const Vector3d center = scene_bbox.center();
+    const double half_size = max(0.5 * max_value(scene_bbox.extent()), 1.0e-6);
+    m_bbox = AABB3d(center - Vector3d(half_size), center + Vector3d(half_size));
+
+    const double scene_diameter = max(norm(scene_bbox.extent()), 1.0e-6);
+    m_min_radius = m_params.m_min_radius * scene_diameter;
+    m_max_radius = max(m_params.m_max_radius * scene_diameter, m_min_radius);
+
+    RENDERER_LOG_INFO(
+        "irradiance cache: %s hemisphere samples per record (%s x %s strata), max error %s.",
+        pretty_uint(m_theta_stratum_count * m_phi_stratum_count).c_str(),
+        pretty_uint(m_theta_stratum_count).c_str(),
+        pretty_uint(m_phi_stratum_count).c_str(),
+        pretty_scalar(m_params.m_max_error).c_str());
+}
+
+IrradianceCache::~IrradianceCache()
+{
+    RENDERER_LOG_DEBUG(
+        "irradiance cache: deleting %s %s...",
+        pretty_uint(m_record_count.load()).c_str(),
+        plural(m_record_count.load(), "record").c_str());
+}
+
+Vector3d IrradianceCache::sample_stratum(
+    const size_t            j,
+    const size_t            k,
+    const Vector2f&         s) const
+{
+    assert(j < m_theta_stratum_count);
+    assert(k < m_phi_stratum_count);
+
+    const double sin2_theta = (j + s[0]) / m_theta_stratum_count;
+    const double sin_theta = sqrt(sin2_theta);
+    const double cos_theta = sqrt(max(1.0 - sin2_theta, 0.0));
+    const double phi = TwoPi<double>() * (k + s[1]) / m_phi_stratum_count;
+
+    return Vector3d(sin_theta * cos(phi), cos_theta, sin_theta * sin(phi));
+}
+
+bool IrradianceCache::lookup(
+    const Vector3d&         point,
+    const Vector3d&         normal,
+    Spectrum&               irradiance) const
+{
+    irradiance.set(0.0f);
+
+    float weight_sum = 0.0f;
+    lookup(m_root, m_bbox, point, normal, irradiance, weight_sum);
+
+    if (weight_sum == 0.0f)
+        return false;
+
+    irradiance /= weight_sum;
+    return true;
+}
+
+void IrradianceCache::insert(
+    const Vector3d&         point,
+    const Basis3d&          basis,
+    const Spectrum          radiance[],
+    const double            distances[],
+    Spectrum&               irradiance)
+{
+    const size_t theta_count = m_theta_stratum_count;
+    const size_t phi_count = m_phi_stratum_count;
+    const size_t sample_count = theta_count * phi_count;
+
+    // Compute the irradiance and the harmonic mean distance to the surrounding surfaces.
+    irradiance.set(0.0f);
+    vector<float> luminance(sample_count);
+    double rcp_distance_sum = 0.0;
+    for (size_t i = 0; i < sample_count; ++i)
+    {
+        irradiance += radiance[i];
+        luminance[i] = average_value(radiance[i]);
+        rcp_distance_sum += 1.0 / distances[i];
+    }
+    irradiance *= Pi<float>() / sample_count;
+
+    // Compute the gradients of the average irradiance in the local space of the record.
+    Vector3d rotational_gradient(0.0);
+    Vector3d translational_gradient(0.0);
+    for (size_t k = 0; k < phi_count; ++k)
+    {
+        const size_t prev_k = (k + phi_count - 1) % phi_count;
+
+        const double phi = TwoPi<double>() * (k + 0.5) / phi_count;
+        const double phi_minus = TwoPi<double>() * k / phi_count;
+        const Vector3d u_k(cos(phi), 0.0, sin(phi));
+        const Vector3d v_k(-sin(phi), 0.0, cos(phi));
+        const Vector3d v_k_minus(-sin(phi_minus), 0.0, cos(phi_minus));
+
+        double rotational_sum = 0.0;
+        double u_sum = 0.0;
+        double v_sum = 0.0;
+
+        for (size_t j = 0; j < theta_count; ++j)
+        {
+            const size_t i = j * phi_count + k;
+
+            const double sin2_theta = (j + 0.5) / theta_count;
+            const double tan_theta = sqrt(sin2_theta / (1.0 - sin2_theta));
+            rotational_sum -= tan_theta * luminance[i];
+
+            const double sin2_theta_minus = static_cast<double>(j) / theta_count;
+            const double sin_theta_minus = sqrt(sin2_theta_minus);
+            const double sin_theta_plus = sqrt(static_cast<double>(j + 1) / theta_count);
+
+            if (j > 0)
+            {
+                const size_t prev_i = i - phi_count;
+                u_sum +=
+                      sin_theta_minus * (1.0 - sin2_theta_minus)
+                    / min(distances[i], distances[prev_i])
+                    * (luminance[i] - luminance[prev_i]);
+            }
+
+            const size_t prev_k_i = j * phi_count + prev_k;
+            v_sum +=
+                  (sin_theta_plus - sin_theta_minus)
+                / min(distances[i], distances[prev_k_i])
+                * (luminance[i] - luminance[prev_k_i]);
+        }
+
+        rotational_gradient += rotational_sum * v_k;
+        translational_gradient += (TwoPi<double>() / phi_count * u_sum) * u_k + v_sum * v_k_minus;
+    }
+    rotational_gradient *= Pi<double>() / sample_count;
+
+    // The validity radius is the harmonic mean distance, reduced where irradiance changes quickly.
+    const float average_irradiance = average_value(irradiance);
+    double radius = rcp_distance_sum > 0.0 ? sample_count / rcp_distance_sum : m_max_radius;
+    const double gradient_norm = norm(translational_gradient);
+    if (gradient_norm > 0.0 && average_irradiance > 0.0f)
+        radius = min(radius, average_irradiance / gradient_norm);
+    radius = clamp(radius, m_min_radius, m_max_radius);
+
+    Record* record = new Record();
+    record->m_point = point;
+    record->m_normal = basis.get_normal();
+    record->m_radius = radius;
+    record->m_irradiance = irradiance;
+    record->m_average_irradiance = average_irradiance;
+    record->m_rotational_gradient = Vector3f(basis.transform_to_parent(rotational_gradient));
+    record->m_translational_gradient = Vector3f(basis.transform_to_parent(translational_gradient));
+    record->m_next = 0;
+
+    add_record(record);
+}
+
+void IrradianceCache::add_params_metadata(Dictionary& metadata)
+{
+    metadata.dictionaries().insert(
+        "enable_irradiance_cache",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Enable Irradiance Cache")
+            .insert("help", "Compute diffuse interreflections and interpolate them from a cache of irradiance records"));
+
+    metadata.dictionaries().insert(
+        "irradiance_cache_max_error",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.3")
+            .insert("min", "0.01")
+            .insert("max", "1.0")
+            .insert("label", "Irradiance Cache Max Error")
+            .insert("help", "Maximum interpolation error; lower values create more records"));
+
+    metadata.dictionaries().insert(
+        "irradiance_cache_samples",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "256")
+            .insert("min", "1")
+            .insert("label", "Irradiance Cache Samples")
+            .insert("help", "Number of hemisphere samples used to create each record"));
+
+    metadata.dictionaries().insert(
+        "irradiance_cache_min_radius",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.001")
+            .insert("min", "0.0")
+            .insert("label", "Irradiance Cache Min Radius")
+            .insert("help", "Minimum radius of records, as a fraction of the scene diameter"));
+
+    metadata.dictionaries().insert(
+        "irradiance_cache_max_radius",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.1")
+            .insert("min", "0.0")
+            .insert("label", "Irradiance Cache Max Radius")
+            .insert("help", "Maximum radius of records, as a fraction of the scene diameter"));
+}
+
+void IrradianceCache::lookup(
+    const Node&             node,
+    const AABB3d&           bbox,
+    const Vector3d&         point,
+    const Vector3d&         normal,
+    Spectrum&               irradiance,
+    float&                  weight_sum) const
+{
+    for (const Record* record = node.m_records.load(); record; record = record->m_next)
+    {
+        const Vector3d d = point - record->m_point;
+
+        // Skip records in front of the point.
+        if (dot(d, normal + record->m_normal) < -0.1 * record->m_radius)
+            continue;
+
+        // Skip records whose estimated error at this point is too large.
+        const double error =
+              norm(d) / record->m_radius
+            + sqrt(max(1.0 - dot(normal, record->m_normal), 0.0));
+        if (error >= m_params.m_max_error)
+            continue;
+
+        // Extrapolate the irradiance of the record to this point using its gradients.
+        float scale = 1.0f;
+        if (record->m_average_irradiance > 0.0f)
+        {
+            const float delta =
+                  dot(Vector3f(cross(record->m_normal, normal)), record->m_rotational_gradient)
+                + dot(Vector3f(d), record->m_translational_gradient);
+            scale = max(1.0f + delta / record->m_average_irradiance, 0.0f);
+        }
+
+        const float weight = static_cast<float>(1.0 / max(error, 1.0e-6));
+
+        Spectrum value = record->m_irradiance;
+        value *= weight * scale;
+        irradiance += value;
+        weight_sum += weight;
+    }
+
+    // Records of a node do not extend beyond its bounds by more than half its size.
+    const Vector3d center = bbox.center();
+    const double margin = 0.25 * (bbox.max[0] - bbox.min[0]);
+
+    for (size_t i = 0; i < 8; ++i)
+    {
+        const Node* child = node.m_children[i].load();
+        if (child == 0)
+            continue;
+
+        AABB3d child_bbox;
+        for (size_t d = 0; d < 3; ++d)
+        {
+            child_bbox.min[d] = (i >> d) & 1 ? center[d] : bbox.min[d];
+            child_bbox.max[d] = (i >> d) & 1 ? bbox.max[d] : center[d];
+        }
+
+        if (point[0] >= child_bbox.min[0] - margin && point[0] <= child_bbox.max[0] + margin &&
+            point[1] >= child_bbox.min[1] - margin && point[1] <= child_bbox.max[1] + margin &&
+            point[2] >= child_bbox.min[2] - margin && point[2] <= child_bbox.max[2] + margin)
+            lookup(*child, child_bbox, point, normal, irradiance, weight_sum);
+    }
+}
+
+void IrradianceCache::add_record(Record* record)
+{
+    // Find the deepest node at least twice as large as the region where the record is valid.
+    const double validity_radius = m_params.m_max_error * record->m_radius;
+    Node* node = &m_root;
+    AABB3d bbox = m_bbox;
+
+    for (size_t depth = 0; depth < MaxDepth; ++depth)
+    {
+        const double child_size = 0.5 * (bbox.max[0] - bbox.min[0]);
+        if (child_size < 2.0 * validity_radius)
+            break;
+
+        // Select the child containing the record.
+        const Vector3d center = bbox.center();
+        size_t child_index = 0;
+        AABB3d child_bbox;
+        for (size_t d = 0; d < 3; ++d)
+        {
+            if (record->m_point[d] >= center[d])
+            {
+                child_index |= size_t(1) << d;
+                child_bbox.min[d] = center[d];
+                child_bbox.max[d] = bbox.max[d];
+            }
+            else
+            {
+                child_bbox.min[d] = bbox.min[d];
+                child_bbox.max[d] = center[d];
+            }
+        }
+
+        // Create the child if needed; if another thread created it first, use theirs.
+        Node* child = node->m_children[child_index].load();
+        if (child == 0)
+        {
+            Node* new_child = new Node();
+            if (node->m_children[child_index].compare_exchange_strong(child, new_child))
+                child = new_child;
+            else delete new_child;
+        }
+
+        node = child;
+        bbox = child_bbox;
+    }
+
+    // Insert the record at the head of the list of records of the node.
+    Record* head = node->m_records.load();
+    do
+    {
+        record->m_next = head;
+    } while (!node->m_records.compare_exchange_weak(head, record));
+
+    ++m_record_count;
+}
+
+}   // namespace renderer
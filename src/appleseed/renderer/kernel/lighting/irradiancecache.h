@@ -0,0 +1,203 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_RENDERER_KERNEL_LIGHTING_IRRADIANCECACHE_H
+#define APPLESEED_RENDERER_KERNEL_LIGHTING_IRRADIANCECACHE_H
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/basis.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class Dictionary; }
+namespace renderer      { class ParamArray; }
+namespace renderer      { class Scene; }
+
+namespace renderer
+{
+
+//
+// A world space cache of indirect irradiance records, interpolated at nearby points.
+//
+// Records are created on demand from stratified, cosine-weighted samples of the incident
+// radiance over the hemisphere. Their radius of validity is the harmonic mean distance to
+// the surfaces seen by the samples, reduced where the translational gradient of irradiance
+// is large, and the rotational and translational gradients are used to extrapolate each
+// record when interpolating. Records are stored in an octree that threads extend and read
+// concurrently without locks; records are never removed.
+//
+// References:
+//
+//   A Ray Tracing Solution for Diffuse Interreflection
+//   Gregory J. Ward, Francis M. Rubinstein, Robert D. Clear
+//   http://radsite.lbl.gov/radiance/papers/sg88/paper.html
+//
+//   Irradiance Gradients
+//   Gregory J. Ward, Paul S. Heckbert
+//   http://www.graphics.cornell.edu/~jaroslav/papers/2004-irradiance_gradients/
+//
+//   Making Radiance and Irradiance Caching Practical: Adaptive Caching and Neighbor Clamping
+//   Jaroslav Krivanek, Kadi Bouatouch, Sumanta N. Pattanaik, Jiri Zara
+//   http://www.graphics.cornell.edu/~jaroslav/papers/egsr06/
+//
+
+class IrradianceCache
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    IrradianceCache(
+        const Scene&                scene,
+        const ParamArray&           params);
+
+    // Destructor.
+    ~IrradianceCache();
+
+    // Return the number of strata of the hemisphere along theta and phi.
+    size_t get_theta_stratum_count() const;
+    size_t get_phi_stratum_count() const;
+
+    // Return a cosine-weighted direction in stratum (j, k) of the hemisphere, in a local
+    // space whose Y axis is the normal.
+    foundation::Vector3d sample_stratum(
+        const size_t                j,
+        const size_t                k,
+        const foundation::Vector2f& s) const;
+
+    // Interpolate the irradiance at a given point from the records valid there.
+    // Return false if there is no such record. This method is thread-safe.
+    bool lookup(
+        const foundation::Vector3d& point,
+        const foundation::Vector3d& normal,
+        Spectrum&                   irradiance) const;
+
+    // Create a record at a given point, given the radiance incident in each stratum (j, k)
+    // and the distance to the surface seen in this stratum (infinite if none), both at index
+    // j * get_phi_stratum_count() + k. Return the irradiance of the new record.
+    // This method is thread-safe.
+    void insert(
+        const foundation::Vector3d& point,
+        const foundation::Basis3d&  basis,
+        const Spectrum              radiance[],
+        const double                distances[],
+        Spectrum&                   irradiance);
+
+    // Return the number of records in the cache.
+    foundation::uint64 get_record_count() const;
+
+    // Add the metadata of the irradiance cache parameters to a dictionary.
+    static void add_params_metadata(foundation::Dictionary& metadata);
+
+  private:
+    struct Parameters
+    {
+        const float     m_max_error;                    // maximum interpolation error, the "a" of Ward et al.
+        const size_t    m_sample_count;                 // number of hemisphere samples per record
+        const double    m_min_radius;                   // minimum radius of records, as a fraction of the scene diameter
+        const double    m_max_radius;                   // maximum radius of records, as a fraction of the scene diameter
+
+        explicit Parameters(const ParamArray& params);
+    };
+
+    struct Record
+    {
+        foundation::Vector3d        m_point;
+        foundation::Vector3d        m_normal;
+        double                      m_radius;
+        Spectrum                    m_irradiance;
+        float                       m_average_irradiance;
+        foundation::Vector3f        m_rotational_gradient;      // of the average irradiance
+        foundation::Vector3f        m_translational_gradient;   // of the average irradiance
+        Record*                     m_next;                     // next record of the same octree node
+    };
+
+    struct Node
+    {
+        boost::atomic<Node*>        m_children[8];
+        boost::atomic<Record*>      m_records;
+
+        Node();
+        ~Node();
+    };
+
+    enum { MaxDepth = 24 };
+
+    const Parameters                m_params;
+    size_t                          m_theta_stratum_count;
+    size_t                          m_phi_stratum_count;
+    foundation::AABB3d              m_bbox;                     // cubic bounds of the octree
+    double                          m_min_radius;
+    double                          m_max_radius;
+    Node                            m_root;
+    boost::atomic<foundation::uint64> m_record_count;
+
+    void lookup(
+        const Node&                 node,
+        const foundation::AABB3d&   bbox,
+        const foundation::Vector3d& point,
+        const foundation::Vector3d& normal,
+        Spectrum&                   irradiance,
+        float&                      weight_sum) const;
+
+    void add_record(Record* record);
+};
+
+
+//
+// IrradianceCache class implementation.
+//
+
+inline size_t IrradianceCache::get_theta_stratum_count() const
+{
+    return m_theta_stratum_count;
+}
+
+inline size_t IrradianceCache::get_phi_stratum_count() const
+{
+    return m_phi_stratum_count;
+}
+
+inline foundation::uint64 IrradianceCache::get_record_count() const
+{
+    return m_record_count.load();
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_LIGHTING_IRRADIANCECACHE_H
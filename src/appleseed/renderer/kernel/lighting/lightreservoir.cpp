@@ -0,0 +1,289 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "lightreservoir.h"
+
+// appleseed.renderer headers.
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    // Neighbors are chosen in a square of this radius, in pixels.
+    const int NeighborRadius = 16;
+
+    // Minimum cosine of the angle between the normals of shading points sharing reservoirs.
+    const float MinNormalCosine = 0.9f;
+
+    // Maximum relative difference between the distances of shading points sharing reservoirs.
+    const float MaxRelativeDistance = 0.1f;
+}
+
+
+//
+// LightReservoir class implementation.
+//
+
+LightReservoir::LightReservoir()
+  : m_target(0.0f)
+  , m_weight_sum(0.0f)
+  , m_sample_count(0.0f)
+{
+}
+
+bool LightReservoir::update(
+    const LightSample&      sample,
+    const float             target,
+    const float             weight,
+    const float             count,
+    float&                  s)
+{
+    assert(weight >= 0.0f);
+    assert(count >= 0.0f);
+
+    m_sample_count += count;
+
+    if (!(weight > 0.0f))
+        return false;
+
+    m_weight_sum += weight;
+
+    // Select the candidate with a probability proportional to its weight, and remap
+    // the random number to the interval of the outcome to reuse it for later candidates.
+    const float p = weight / m_weight_sum;
+
+    if (s < p)
+    {
+        s = min(s / p, 1.0f - numeric_limits<float>::epsilon());
+        m_sample = sample;
+        m_target = target;
+        return true;
+    }
+    else
+    {
+        s = min((s - p) / (1.0f - p), 1.0f - numeric_limits<float>::epsilon());
+        return false;
+    }
+}
+
+float LightReservoir::get_contribution_weight() const
+{
+    return
+        m_target > 0.0f && m_sample_count > 0.0f
+            ? m_weight_sum / (m_sample_count * m_target)
+            : 0.0f;
+}
+
+
+//
+// LightReservoirBuffer class implementation.
+//
+
+LightReservoirBuffer::LightReservoirBuffer(
+    const LightSampler&     light_sampler,
+    const size_t            width,
+    const size_t            height,
+    const ParamArray&       params)
+  : m_light_sampler(light_sampler)
+  , m_width(width)
+  , m_height(height)
+  , m_neighbor_count(
+        min<size_t>(
+            params.get_optional<size_t>("dl_resampling_neighbors", 2),
+            MaxNeighborCount))
+{
+    Entry empty_entry;
+    empty_entry.m_emitter_index = ~uint32(0);
+    empty_entry.m_is_triangle = 0;
+    empty_entry.m_bary = Vector2f(0.0f);
+    empty_entry.m_target = 0.0f;
+    empty_entry.m_weight_sum = 0.0f;
+    empty_entry.m_sample_count = 0.0f;
+    empty_entry.m_normal = Vector3f(0.0f);
+    empty_entry.m_distance = 0.0f;
+
+    m_entries.assign(m_width * m_height, empty_entry);
+}
+
+size_t LightReservoirBuffer::fetch(
+    const ShadingRay::Time& time,
+    const Vector2i&         pixel_coords,
+    const Vector3d&         geometric_normal,
+    const double            distance,
+    SamplingContext&        sampling_context,
+    LightReservoir          reservoirs[MaxReusedReservoirCount]) const
+{
+    if (pixel_coords.x < 0 || pixel_coords.y < 0 ||
+        static_cast<size_t>(pixel_coords.x) >= m_width ||
+        static_cast<size_t>(pixel_coords.y) >= m_height)
+        return 0;
+
+    size_t count = 0;
+
+    // Reservoir of this pixel.
+    if (fetch(time, pixel_coords.x, pixel_coords.y, geometric_normal, distance, reservoirs[count]))
+        ++count;
+
+    // Reservoirs of randomly chosen neighbors.
+    if (m_neighbor_count > 0)
+    {
+        sampling_context.split_in_place(2, m_neighbor_count);
+
+        for (size_t i = 0; i < m_neighbor_count; ++i)
+        {
+            const Vector2f s = sampling_context.next2<Vector2f>();
+            const int x = pixel_coords.x + truncate<int>((2.0f * s[0] - 1.0f) * NeighborRadius);
+            const int y = pixel_coords.y + truncate<int>((2.0f * s[1] - 1.0f) * NeighborRadius);
+
+            if (x < 0 || y < 0 ||
+                static_cast<size_t>(x) >= m_width ||
+                static_cast<size_t>(y) >= m_height ||
+                (x == pixel_coords.x && y == pixel_coords.y))
+                continue;
+
+            if (fetch(time, x, y, geometric_normal, distance, reservoirs[count]))
+                ++count;
+        }
+    }
+
+    return count;
+}
+
+void LightReservoirBuffer::store(
+    const Vector2i&         pixel_coords,
+    const Vector3d&         geometric_normal,
+    const double            distance,
+    const LightReservoir&   reservoir)
+{
+    if (pixel_coords.x < 0 || pixel_coords.y < 0 ||
+        static_cast<size_t>(pixel_coords.x) >= m_width ||
+        static_cast<size_t>(pixel_coords.y) >= m_height)
+        return;
+
+    Entry entry;
+
+    if (reservoir.m_target > 0.0f)
+    {
+        const LightSample& sample = reservoir.m_sample;
+        if (sample.m_triangle)
+        {
+            entry.m_emitter_index =
+                static_cast<uint32>(sample.m_triangle - &m_light_sampler.get_emitting_triangle(0));
+            entry.m_is_triangle = 1;
+            entry.m_bary = sample.m_bary;
+        }
+        else
+        {
+            entry.m_emitter_index = static_cast<uint32>(sample.m_light_index);
+            entry.m_is_triangle = 0;
+            entry.m_bary = Vector2f(0.0f);
+        }
+    }
+    else
+    {
+        entry.m_emitter_index = ~uint32(0);
+        entry.m_is_triangle = 0;
+        entry.m_bary = Vector2f(0.0f);
+    }
+
+    entry.m_target = reservoir.m_target;
+    entry.m_weight_sum = reservoir.m_weight_sum;
+    entry.m_sample_count = reservoir.m_sample_count;
+    entry.m_normal = Vector3f(geometric_normal);
+    entry.m_distance = static_cast<float>(distance);
+
+    const size_t index = pixel_coords.y * m_width + pixel_coords.x;
+    Spinlock::ScopedLock lock(m_locks[index % LockCount]);
+    m_entries[index] = entry;
+}
+
+bool LightReservoirBuffer::fetch(
+    const ShadingRay::Time& time,
+    const size_t            x,
+    const size_t            y,
+    const Vector3d&         geometric_normal,
+    const double            distance,
+    LightReservoir&         reservoir) const
+{
+    const size_t index = y * m_width + x;
+
+    Entry entry;
+    {
+        Spinlock::ScopedLock lock(m_locks[index % LockCount]);
+        entry = m_entries[index];
+    }
+
+    if (entry.m_emitter_index == ~uint32(0))
+        return false;
+
+    // Only reuse the reservoirs of shading points with a similar geometry.
+    if (dot(entry.m_normal, Vector3f(geometric_normal)) < MinNormalCosine)
+        return false;
+    if (abs(entry.m_distance - static_cast<float>(distance)) > MaxRelativeDistance * static_cast<float>(distance))
+        return false;
+
+    // Rebuild the light sample.
+    if (entry.m_is_triangle)
+    {
+        reservoir.m_sample.m_light = 0;
+        m_light_sampler.make_emitting_triangle_sample(
+            Vector3d(entry.m_bary[0], entry.m_bary[1], 1.0 - entry.m_bary[0] - entry.m_bary[1]),
+            entry.m_emitter_index,
+            1.0f,
+            reservoir.m_sample);
+    }
+    else
+    {
+        reservoir.m_sample.m_triangle = 0;
+        m_light_sampler.sample_non_physical_light(time, entry.m_emitter_index, reservoir.m_sample);
+    }
+
+    reservoir.m_target = entry.m_target;
+    reservoir.m_weight_sum = entry.m_weight_sum;
+    reservoir.m_sample_count = entry.m_sample_count;
+
+    return true;
+}
+
+}   // namespace renderer
@@ -0,0 +1,169 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_RENDERER_KERNEL_LIGHTING_LIGHTRESERVOIR_H
+#define APPLESEED_RENDERER_KERNEL_LIGHTING_LIGHTRESERVOIR_H
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/lighting/lightsampler.h"
+#include "renderer/kernel/shading/shadingray.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace renderer  { class ParamArray; }
+
+namespace renderer
+{
+
+//
+// A reservoir of light samples for resampled importance sampling: light sample candidates
+// are streamed through the reservoir, which keeps a single one of them with a probability
+// proportional to its resampling weight.
+//
+// Reference:
+//
+//   Spatiotemporal Reservoir Resampling for Real-Time Ray Tracing with Dynamic Direct Lighting
+//   Benedikt Bitterli, Chris Wyman, Matt Pharr, Peter Shirley, Aaron Lefohn, Wojciech Jarosz
+//
+
+class LightReservoir
+{
+  public:
+    LightSample     m_sample;               // selected light sample
+    float           m_target;               // target function (unoccluded contribution) of the selected sample
+    float           m_weight_sum;           // sum of the resampling weights of all candidates
+    float           m_sample_count;         // number of candidates seen by the reservoir
+
+    // Constructor, creates an empty reservoir.
+    LightReservoir();
+
+    // Stream a candidate, or a reservoir of 'count' candidates, through the reservoir.
+    // 's' is a uniform random number in [0, 1) which is remapped to remain uniform and
+    // independent of the outcome. Return true if the candidate was selected.
+    bool update(
+        const LightSample&  sample,
+        const float         target,
+        const float         weight,
+        const float         count,
+        float&              s);
+
+    // Return the weight by which the contribution of the selected sample must be multiplied,
+    // i.e. the estimated reciprocal of its probability density.
+    float get_contribution_weight() const;
+};
+
+
+//
+// Per-pixel light reservoirs, allowing the light samples of the first vertex of camera paths
+// to be reused by the same pixel during subsequent samples and passes, and by neighboring
+// pixels. Reservoirs are only reused at shading points of similar orientation and distance.
+//
+// Reusing reservoirs makes the estimates biased but dramatically lowers the noise of scenes
+// with many lights in the first passes, which makes it suited for interactive rendering.
+//
+// All methods are thread-safe.
+//
+
+class LightReservoirBuffer
+  : public foundation::NonCopyable
+{
+  public:
+    enum { MaxNeighborCount = 4 };
+    enum { MaxReusedReservoirCount = MaxNeighborCount + 1 };
+
+    // Constructor.
+    LightReservoirBuffer(
+        const LightSampler&             light_sampler,
+        const size_t                    width,
+        const size_t                    height,
+        const ParamArray&               params);
+
+    // Fetch the reservoirs of a given pixel and of some of its neighbors that may be reused at
+    // a shading point with a given geometric normal, at a given distance from the camera.
+    // Return the number of reservoirs written to 'reservoirs'.
+    size_t fetch(
+        const ShadingRay::Time&         time,
+        const foundation::Vector2i&     pixel_coords,
+        const foundation::Vector3d&     geometric_normal,
+        const double                    distance,
+        SamplingContext&                sampling_context,
+        LightReservoir                  reservoirs[MaxReusedReservoirCount]) const;
+
+    // Store the reservoir of a given pixel.
+    void store(
+        const foundation::Vector2i&     pixel_coords,
+        const foundation::Vector3d&     geometric_normal,
+        const double                    distance,
+        const LightReservoir&           reservoir);
+
+  private:
+    enum { LockCount = 256 };
+
+    // Compact representation of a reservoir.
+    struct Entry
+    {
+        foundation::uint32              m_emitter_index;    // ~0 if the entry is empty
+        foundation::uint32              m_is_triangle;
+        foundation::Vector2f            m_bary;             // barycentric coordinates of triangle samples
+        float                           m_target;
+        float                           m_weight_sum;
+        float                           m_sample_count;
+        foundation::Vector3f            m_normal;           // geometric normal of the shading point
+        float                           m_distance;         // distance of the shading point to the camera
+    };
+
+    const LightSampler&                 m_light_sampler;
+    const size_t                        m_width;
+    const size_t                        m_height;
+    const size_t                        m_neighbor_count;
+    std::vector<Entry>                  m_entries;
+    mutable foundation::Spinlock        m_locks[LockCount];
+
+    bool fetch(
+        const ShadingRay::Time&         time,
+        const size_t                    x,
+        const size_t                    y,
+        const foundation::Vector3d&     geometric_normal,
+        const double                    distance,
+        LightReservoir&                 reservoir) const;
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_LIGHTING_LIGHTRESERVOIR_H
@@ -37,8 +37,14 @@
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/kernel/shading/shadingray.h"
 #include "renderer/kernel/tessellation/statictessellation.h"
+#include "renderer/kernel/texturing/texturecache.h"
 #include "renderer/modeling/edf/edf.h"
+#include "renderer/modeling/entity/entity.h"
+#include "renderer/modeling/input/inputarray.h"
+#include "renderer/modeling/input/source.h"
+#include "renderer/modeling/light/directionallight.h"
 #include "renderer/modeling/light/light.h"
+#include "renderer/modeling/light/sunlight.h"
 #include "renderer/modeling/material/material.h"
 #include "renderer/modeling/object/iregion.h"
 #include "renderer/modeling/object/object.h"
@@ -50,17 +56,29 @@
 #include "renderer/modeling/scene/scene.h"
 #include "renderer/modeling/scene/visibilityflags.h"
 #include "renderer/modeling/shadergroup/shadergroup.h"
+#include "renderer/utility/settingsparsing.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/aabb.h"
 #include "foundation/math/sampling/mappings.h"
 #include "foundation/math/scalar.h"
+#include "foundation/platform/thread.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/lazy.h"
+#include "foundation/utility/siphash.h"
 #include "foundation/utility/string.h"
 
+// Boost headers.
+#include "boost/bind.hpp"
+
 // Standard headers.
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 using namespace std;
@@ -103,7 +121,10 @@ void LightSample::make_shading_point(
 // LightSampler class implementation.
 //
 
-LightSampler::LightSampler(const Scene& scene, const ParamArray& params)
+LightSampler::LightSampler(
+    const Scene&                        scene,
+    const ParamArray&                   params,
+    TextureStore*                       texture_store)
   : m_params(params)
   , m_emitting_triangle_hash_table(m_triangle_key_hasher)
 {
@@ -114,12 +135,14 @@ LightSampler::LightSampler(const Scene& scene, const ParamArray& params)
     m_non_physical_light_count = m_non_physical_lights.size();
 
     // Collect all light-emitting triangles.
-    collect_emitting_triangles(
-        scene.assembly_instances(),
-        TransformSequence());
+    const size_t thread_count = get_rendering_thread_count(params);
+    collect_emitting_triangles(scene, thread_count, texture_store);
 
-    // Build the hash table of emitting triangles.
-    build_emitting_triangle_hash_table();
+    // Build the hash table of emitting triangles while the CDFs are being prepared.
+    boost::thread hash_table_builder;
+    if (thread_count > 1)
+        hash_table_builder = boost::thread(boost::bind(&LightSampler::build_emitting_triangle_hash_table, this));
+    else build_emitting_triangle_hash_table();
 
     // Prepare the CDFs for sampling.
     if (m_non_physical_lights_cdf.valid())
@@ -127,11 +150,20 @@ LightSampler::LightSampler(const Scene& scene, const ParamArray& params)
     if (m_emitting_triangles_cdf.valid())
         m_emitting_triangles_cdf.prepare();
 
+    if (hash_table_builder.joinable())
+        hash_table_builder.join();
+
     // Store the triangle probability densities into the emitting triangles.
     const size_t emitting_triangle_count = m_emitting_triangles.size();
     for (size_t i = 0; i < emitting_triangle_count; ++i)
         m_emitting_triangles[i].m_triangle_prob = m_emitting_triangles_cdf[i].second;
 
+    if (m_params.m_light_tree)
+        build_light_trees();
+
+    if (m_params.m_light_culling)
+        build_light_culling_grid(scene);
+
    RENDERER_LOG_INFO(
         "found %s %s, %s emitting %s.",
         pretty_int(m_non_physical_light_count).c_str(),
@@ -140,6 +172,80 @@ LightSampler::LightSampler(const Scene& scene, const ParamArray& params)
         plural(m_emitting_triangles.size(), "triangle").c_str());
 }
 
+LightSampler::~LightSampler()
+{
+    for (size_t i = 0, e = m_culling_grid_cells.size(); i < e; ++i)
+        delete m_culling_grid_cells[i];
+}
+
+namespace
+{
+    template <typename EntityContainer>
+    uint64 combine_entity_signatures(uint64 signature, const EntityContainer& entities)
+    {
+        for (const_each<EntityContainer> i = entities; i; ++i)
+            signature = Entity::combine_signatures(signature, i->compute_signature());
+
+        return signature;
+    }
+
+    uint64 combine_transform_sequence_signature(
+        uint64                              signature,
+        const TransformSequence&            transform_sequence)
+    {
+        for (size_t i = 0, e = transform_sequence.size(); i < e; ++i)
+        {
+            float time;
+            Transformd transform;
+            transform_sequence.get_transform(i, time, transform);
+
+            signature = Entity::combine_signatures(signature, siphash24(time));
+            signature = Entity::combine_signatures(signature, siphash24(transform.get_local_to_parent()));
+        }
+
+        return signature;
+    }
+
+    uint64 combine_assembly_instance_signatures(
+        uint64                              signature,
+        const AssemblyInstanceContainer&    assembly_instances)
+    {
+        for (const_each<AssemblyInstanceContainer> i = assembly_instances; i; ++i)
+        {
+            const AssemblyInstance& assembly_instance = *i;
+            const Assembly& assembly = assembly_instance.get_assembly();
+
+            // Transforms are not always edited through new entities, hash them too.
+            signature = Entity::combine_signatures(signature, assembly_instance.compute_signature());
+            signature = combine_transform_sequence_signature(signature, assembly_instance.transform_sequence());
+
+            signature = Entity::combine_signatures(signature, assembly.compute_signature());
+            signature = combine_entity_signatures(signature, assembly.lights());
+            signature = combine_entity_signatures(signature, assembly.materials());
+            signature = combine_entity_signatures(signature, assembly.edfs());
+            signature = combine_entity_signatures(signature, assembly.shader_groups());
+
+            for (const_each<ObjectInstanceContainer> j = assembly.object_instances(); j; ++j)
+            {
+                signature = Entity::combine_signatures(signature, j->compute_signature());
+                signature = Entity::combine_signatures(signature, siphash24(j->get_transform().get_local_to_parent()));
+            }
+
+            signature = combine_assembly_instance_signatures(signature, assembly.assembly_instances());
+        }
+
+        return signature;
+    }
+}
+
+uint64 LightSampler::compute_signature(const Scene& scene)
+{
+    // The signature of the scene itself is left out: it changes whenever the camera,
+    // the environment or any other entity of the scene is edited.
+    uint64 signature = combine_entity_signatures(0, scene.shader_groups());
+    return combine_assembly_instance_signatures(signature, scene.assembly_instances());
+}
+
 void LightSampler::collect_non_physical_lights(
     const AssemblyInstanceContainer&    assembly_instances,
     const TransformSequence&            parent_transform_seq)
@@ -193,62 +299,124 @@ void LightSampler::collect_non_physical_lights(
     }
 }
 
-void LightSampler::collect_emitting_triangles(
-    const AssemblyInstanceContainer&    assembly_instances,
-    const TransformSequence&            parent_transform_seq)
+namespace
 {
-    for (const_each<AssemblyInstanceContainer> i = assembly_instances; i; ++i)
+    // An object instance with light-emitting materials, and the emitting triangles collected from it.
+    struct EmittingObjectInstance
     {
-        // Retrieve the assembly instance.
-        const AssemblyInstance& assembly_instance = *i;
+        const AssemblyInstance*         m_assembly_instance;
+        Transformd                      m_assembly_instance_transform;
+        const ObjectInstance*           m_object_instance;
+        size_t                          m_object_instance_index;
+
+        vector<EmittingTriangle>        m_triangles;
+        vector<float>                   m_triangle_probs;
+        double                          m_area;
+    };
+
+    typedef vector<EmittingObjectInstance> EmittingObjectInstanceVector;
+
+    // Recursively gather the object instances with light-emitting materials, in a deterministic order.
+    void gather_emitting_object_instances(
+        const AssemblyInstanceContainer&    assembly_instances,
+        const TransformSequence&            parent_transform_seq,
+        EmittingObjectInstanceVector&       emitting_object_instances)
+    {
+        for (const_each<AssemblyInstanceContainer> i = assembly_instances; i; ++i)
+        {
+            // Retrieve the assembly instance.
+            const AssemblyInstance& assembly_instance = *i;
+
+            // Retrieve the assembly.
+            const Assembly& assembly = assembly_instance.get_assembly();
+
+            // Compute the cumulated transform sequence of this assembly instance.
+            TransformSequence cumulated_transform_seq =
+                assembly_instance.transform_sequence() * parent_transform_seq;
+            cumulated_transform_seq.prepare();
+
+            // Recurse into child assembly instances.
+            gather_emitting_object_instances(
+                assembly.assembly_instances(),
+                cumulated_transform_seq,
+                emitting_object_instances);
+
+            // Gather the object instances of this assembly instance.
+            const size_t object_instance_count = assembly.object_instances().size();
+            for (size_t object_instance_index = 0; object_instance_index < object_instance_count; ++object_instance_index)
+            {
+                // Retrieve the object instance.
+                const ObjectInstance* object_instance = assembly.object_instances().get_by_index(object_instance_index);
 
-        // Retrieve the assembly.
-        const Assembly& assembly = assembly_instance.get_assembly();
+                // Skip object instances without light-emitting materials.
+                if (!has_emitting_materials(object_instance->get_front_materials()) &&
+                    !has_emitting_materials(object_instance->get_back_materials()))
+                    continue;
 
-        // Compute the cumulated transform sequence of this assembly instance.
-        TransformSequence cumulated_transform_seq =
-            assembly_instance.transform_sequence() * parent_transform_seq;
-        cumulated_transform_seq.prepare();
+                // todo: add support for moving light-emitters.
+                EmittingObjectInstance emitting_object_instance;
+                emitting_object_instance.m_assembly_instance = &assembly_instance;
+                emitting_object_instance.m_assembly_instance_transform = cumulated_transform_seq.get_earliest_transform();
+                emitting_object_instance.m_object_instance = object_instance;
+                emitting_object_instance.m_object_instance_index = object_instance_index;
+                emitting_object_instance.m_area = 0.0;
+                emitting_object_instances.push_back(emitting_object_instance);
+            }
+        }
+    }
 
-        // Recurse into child assembly instances.
-        collect_emitting_triangles(
-            assembly.assembly_instances(),
-            cumulated_transform_seq);
+    // Estimate the average value of a textured radiance input over the UV footprint of a triangle.
+    // The source is evaluated at the centroids of the four midpoint subdivisions of the triangle,
+    // with UV derivatives spanning each subtriangle so that a coarse mipmap level gets fetched.
+    float estimate_average_radiance(
+        TextureCache&                       texture_cache,
+        const Source&                       radiance_source,
+        const Vector2f&                     uv0,
+        const Vector2f&                     uv1,
+        const Vector2f&                     uv2)
+    {
+        const Vector2f duvdx = 0.5f * (uv1 - uv0);
+        const Vector2f duvdy = 0.5f * (uv2 - uv0);
 
-        // Collect emitting triangles from this assembly instance.
-        collect_emitting_triangles(
-            assembly,
-            assembly_instance,
-            cumulated_transform_seq);
+        const Vector2f m01 = 0.5f * (uv0 + uv1);
+        const Vector2f m12 = 0.5f * (uv1 + uv2);
+        const Vector2f m20 = 0.5f * (uv2 + uv0);
+
+        const Vector2f points[4] =
+        {
+            (uv0 + m01 + m20) * (1.0f / 3.0f),
+            (m01 + uv1 + m12) * (1.0f / 3.0f),
+            (m20 + m12 + uv2) * (1.0f / 3.0f),
+            (m01 + m12 + m20) * (1.0f / 3.0f)
+        };
+
+        float sum = 0.0f;
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            Spectrum radiance;
+            radiance_source.evaluate(texture_cache, points[i], duvdx, duvdy, radiance);
+            sum += max(average_value(radiance), 0.0f);
+        }
+
+        return 0.25f * sum;
     }
-}
 
-void LightSampler::collect_emitting_triangles(
-    const Assembly&                     assembly,
-    const AssemblyInstance&             assembly_instance,
-    const TransformSequence&            transform_sequence)
-{
-    // Loop over the object instances of the assembly.
-    const size_t object_instance_count = assembly.object_instances().size();
-    for (size_t object_instance_index = 0; object_instance_index < object_instance_count; ++object_instance_index)
+    // Collect the emitting triangles of a given object instance.
+    void collect_emitting_triangles(
+        EmittingObjectInstance&             emitting_object_instance,
+        const bool                          importance_sampling,
+        TextureCache*                       texture_cache)
     {
-        // Retrieve the object instance.
-        const ObjectInstance* object_instance = assembly.object_instances().get_by_index(object_instance_index);
+        const ObjectInstance* object_instance = emitting_object_instance.m_object_instance;
 
         // Retrieve the materials of the object instance.
         const MaterialArray& front_materials = object_instance->get_front_materials();
         const MaterialArray& back_materials = object_instance->get_back_materials();
 
-        // Skip object instances without light-emitting materials.
-        if (!has_emitting_materials(front_materials) && !has_emitting_materials(back_materials))
-            continue;
-
-        double object_area = 0.0;
-
         // Compute the object space to world space transformation.
-        // todo: add support for moving light-emitters.
         const Transformd& object_instance_transform = object_instance->get_transform();
-        const Transformd& assembly_instance_transform = transform_sequence.get_earliest_transform();
+        const Transformd& assembly_instance_transform = emitting_object_instance.m_assembly_instance_transform;
         const Transformd global_transform = assembly_instance_transform * object_instance_transform;
 
         // Retrieve the object.
@@ -257,6 +425,13 @@ void LightSampler::collect_emitting_triangles(
         // Retrieve the region kit of the object.
         Access<RegionKit> region_kit(&object.get_region_kit());
 
+        // Triangles whose probability is scaled by the emission texture. Their probabilities are
+        // renormalized at the end so that the object instance keeps its share of the samples.
+        vector<size_t> textured_triangles;
+        vector<float> textured_area_probs;
+        float textured_area_importance = 0.0f;
+        float textured_power_importance = 0.0f;
+
         // Loop over the regions of the object.
         const size_t region_count = region_kit->size();
         for (size_t region_index = 0; region_index < region_count; ++region_index)
@@ -291,9 +466,9 @@ void LightSampler::collect_emitting_triangles(
                     continue;
 
                 // Retrieve object instance space vertices of the triangle.
-                const GVector3& v0_os = tess->m_vertices[triangle.m_v0];
-                const GVector3& v1_os = tess->m_vertices[triangle.m_v1];
-                const GVector3& v2_os = tess->m_vertices[triangle.m_v2];
+                const GVector3 v0_os = tess->get_vertex(triangle.m_v0);
+                const GVector3 v1_os = tess->get_vertex(triangle.m_v1);
+                const GVector3 v2_os = tess->get_vertex(triangle.m_v2);
 
                 // Transform triangle vertices to assembly space.
                 const GVector3 v0_as = object_instance_transform.point_to_parent(v0_os);
@@ -328,9 +503,9 @@ void LightSampler::collect_emitting_triangles(
                     triangle.m_n1 != Triangle::None &&
                     triangle.m_n2 != Triangle::None)
                 {
-                    n0_os = Vector3d(tess->m_vertex_normals[triangle.m_n0]);
-                    n1_os = Vector3d(tess->m_vertex_normals[triangle.m_n1]);
-                    n2_os = Vector3d(tess->m_vertex_normals[triangle.m_n2]);
+                    n0_os = Vector3d(tess->get_vertex_normal(triangle.m_n0));
+                    n1_os = Vector3d(tess->get_vertex_normal(triangle.m_n1));
+                    n2_os = Vector3d(tess->get_vertex_normal(triangle.m_n2));
                 }
                 else
                     n0_os = n1_os = n2_os = geometric_normal;
@@ -348,21 +523,42 @@ void LightSampler::collect_emitting_triangles(
                         continue;
 
                     // Retrieve the EDF and get the importance multiplier.
-                    float importance_multiplier = 1.0f;
-                    if (const EDF* edf = material->get_uncached_edf())
-                        importance_multiplier = edf->get_uncached_importance_multiplier();
+                    const EDF* edf = material->get_uncached_edf();
+                    const float importance_multiplier = edf ? edf->get_uncached_importance_multiplier() : 1.0f;
 
                     // Accumulate the object area for OSL shaders.
-                    object_area += area;
+                    emitting_object_instance.m_area += area;
 
                     // Compute the probability density of this triangle.
-                    const float triangle_importance = m_params.m_importance_sampling ? static_cast<float>(area) : 1.0f;
-                    const float triangle_prob = triangle_importance * importance_multiplier;
+                    const float triangle_importance = importance_sampling ? static_cast<float>(area) : 1.0f;
+                    float triangle_prob = triangle_importance * importance_multiplier;
+
+                    // Weight triangles of textured emitters by the radiance they actually emit.
+                    if (importance_sampling && texture_cache && edf && triangle.has_vertex_attributes())
+                    {
+                        const Source* radiance_source = edf->get_inputs().source("radiance");
+                        if (radiance_source && !radiance_source->is_uniform())
+                        {
+                            const float average_radiance =
+                                estimate_average_radiance(
+                                    *texture_cache,
+                                    *radiance_source,
+                                    Vector2f(tess->get_tex_coords(triangle.m_a0)),
+                                    Vector2f(tess->get_tex_coords(triangle.m_a1)),
+                                    Vector2f(tess->get_tex_coords(triangle.m_a2)));
+
+                            textured_triangles.push_back(emitting_object_instance.m_triangles.size());
+                            textured_area_probs.push_back(triangle_prob);
+                            textured_area_importance += triangle_prob;
+                            triangle_prob *= average_radiance;
+                            textured_power_importance += triangle_prob;
+                        }
+                    }
 
                     // Create a light-emitting triangle.
                     EmittingTriangle emitting_triangle;
-                    emitting_triangle.m_assembly_instance = &assembly_instance;
-                    emitting_triangle.m_object_instance_index = object_instance_index;
+                    emitting_triangle.m_assembly_instance = emitting_object_instance.m_assembly_instance;
+                    emitting_triangle.m_object_instance_index = emitting_object_instance.m_object_instance_index;
                     emitting_triangle.m_region_index = region_index;
                     emitting_triangle.m_triangle_index = triangle_index;
                     emitting_triangle.m_v0 = v0;
@@ -377,27 +573,152 @@ void LightSampler::collect_emitting_triangles(
                     emitting_triangle.m_triangle_prob = 0.0f;   // will be initialized once the emitting triangle CDF is built
                     emitting_triangle.m_material = material;
 
-                    // Store the light-emitting triangle.
-                    const size_t emitting_triangle_index = m_emitting_triangles.size();
-                    m_emitting_triangles.push_back(emitting_triangle);
+                    // Store the light-emitting triangle and its probability density.
+                    emitting_object_instance.m_triangles.push_back(emitting_triangle);
+                    emitting_object_instance.m_triangle_probs.push_back(triangle_prob);
+                }
+            }
+        }
+
+        // Redistribute the area-based probability of textured triangles according to their emitted power.
+        if (!textured_triangles.empty())
+        {
+            const size_t textured_triangle_count = textured_triangles.size();
+
+            if (textured_power_importance > 0.0f)
+            {
+                const float scale = textured_area_importance / textured_power_importance;
+                for (size_t i = 0; i < textured_triangle_count; ++i)
+                    emitting_object_instance.m_triangle_probs[textured_triangles[i]] *= scale;
+            }
+            else
+            {
+                // The textures are black everywhere: fall back to area-based probabilities.
+                for (size_t i = 0; i < textured_triangle_count; ++i)
+                    emitting_object_instance.m_triangle_probs[textured_triangles[i]] = textured_area_probs[i];
+            }
+        }
+    }
+
+    // Collect the emitting triangles of object instances handed out one at a time.
+    class CollectEmittingTriangles
+    {
+      public:
+        CollectEmittingTriangles(
+            EmittingObjectInstanceVector&   emitting_object_instances,
+            size_t&                         next_index,
+            boost::mutex&                   mutex,
+            const bool                      importance_sampling,
+            TextureStore*                   texture_store)
+          : m_emitting_object_instances(emitting_object_instances)
+          , m_next_index(next_index)
+          , m_mutex(mutex)
+          , m_importance_sampling(importance_sampling)
+          , m_texture_store(texture_store)
+        {
+        }
+
+        void operator()()
+        {
+            // Each worker has its own texture cache.
+            auto_ptr<TextureCache> texture_cache;
+            if (m_texture_store)
+                texture_cache.reset(new TextureCache(*m_texture_store));
+
+            while (true)
+            {
+                size_t index;
 
-                    // Insert the light-emitting triangle into the CDF.
-                    m_emitting_triangles_cdf.insert(emitting_triangle_index, triangle_prob);
+                {
+                    boost::mutex::scoped_lock lock(m_mutex);
+                    index = m_next_index++;
                 }
+
+                if (index >= m_emitting_object_instances.size())
+                    break;
+
+                collect_emitting_triangles(
+                    m_emitting_object_instances[index],
+                    m_importance_sampling,
+                    texture_cache.get());
             }
         }
 
+      private:
+        EmittingObjectInstanceVector&       m_emitting_object_instances;
+        size_t&                             m_next_index;
+        boost::mutex&                       m_mutex;
+        const bool                          m_importance_sampling;
+        TextureStore*                       m_texture_store;
+    };
+}
+
+void LightSampler::collect_emitting_triangles(
+    const Scene&                        scene,
+    const size_t                        thread_count,
+    TextureStore*                       texture_store)
+{
+    // Gather the object instances with light-emitting materials.
+    EmittingObjectInstanceVector emitting_object_instances;
+    gather_emitting_object_instances(
+        scene.assembly_instances(),
+        TransformSequence(),
+        emitting_object_instances);
+
+    // Collect the emitting triangles of these object instances in parallel.
+    size_t next_index = 0;
+    boost::mutex mutex;
+    CollectEmittingTriangles collect(
+        emitting_object_instances,
+        next_index,
+        mutex,
+        m_params.m_importance_sampling,
+        texture_store);
+    const size_t worker_count = min(thread_count, emitting_object_instances.size());
+    if (worker_count > 1)
+    {
+        boost::thread_group threads;
+        for (size_t i = 0; i < worker_count; ++i)
+            threads.create_thread(collect);
+        threads.join_all();
+    }
+    else collect();
+
+    // Concatenate the emitting triangles in the order of the object instances,
+    // so that the results are independent of the number of threads.
+    size_t emitting_triangle_count = 0;
+    for (size_t i = 0, e = emitting_object_instances.size(); i < e; ++i)
+        emitting_triangle_count += emitting_object_instances[i].m_triangles.size();
+    m_emitting_triangles.reserve(emitting_triangle_count);
+
+    for (size_t i = 0, e = emitting_object_instances.size(); i < e; ++i)
+    {
+        const EmittingObjectInstance& emitting_object_instance = emitting_object_instances[i];
+
+        for (size_t j = 0, je = emitting_object_instance.m_triangles.size(); j < je; ++j)
+        {
+            // Store the light-emitting triangle.
+            const size_t emitting_triangle_index = m_emitting_triangles.size();
+            m_emitting_triangles.push_back(emitting_object_instance.m_triangles[j]);
+
+            // Insert the light-emitting triangle into the CDF.
+            m_emitting_triangles_cdf.insert(emitting_triangle_index, emitting_object_instance.m_triangle_probs[j]);
+        }
+
+        const ObjectInstance* object_instance = emitting_object_instance.m_object_instance;
+        const float object_area = static_cast<float>(emitting_object_instance.m_area);
+
         store_object_area_in_shadergroups(
-            &assembly_instance,
+            emitting_object_instance.m_assembly_instance,
             object_instance,
-            static_cast<float>(object_area),
-            front_materials);
+            object_area,
+            object_instance->get_front_materials());
 
         store_object_area_in_shadergroups(
-            &assembly_instance,
+            emitting_object_instance.m_assembly_instance,
             object_instance,
-            static_cast<float>(object_area),
-            back_materials);
+            object_area,
+            object_instance->get_back_materials());
     }
 }
 
@@ -405,8 +726,7 @@ void LightSampler::build_emitting_triangle_hash_table()
 {
     const size_t emitting_triangle_count = m_emitting_triangles.size();
 
-    m_emitting_triangle_hash_table.resize(
-        emitting_triangle_count > 0 ? next_pow2(emitting_triangle_count) : 0);
+    m_emitting_triangle_hash_table.resize(emitting_triangle_count);
 
     for (size_t i = 0; i < emitting_triangle_count; ++i)
     {
@@ -422,6 +742,262 @@ void LightSampler::build_emitting_triangle_hash_table()
     }
 }
 
+void LightSampler::build_light_trees()
+{
+    // Non-physical lights located at a point go into a tree, distant lights into a CDF.
+    vector<LightTree::Item> light_items;
+    for (size_t i = 0; i < m_non_physical_light_count; ++i)
+    {
+        const NonPhysicalLightInfo& light_info = m_non_physical_lights[i];
+        const Light& light = *light_info.m_light;
+        const float importance = light.get_uncached_importance_multiplier();
+
+        if (strcmp(light.get_model(), DirectionalLightFactory().get_model()) == 0 ||
+            strcmp(light.get_model(), SunLightFactory().get_model()) == 0)
+        {
+            m_distant_lights_cdf.insert(i, importance);
+            continue;
+        }
+
+        // todo: add support for moving lights.
+        const Transformd light_transform =
+              light.get_transform()
+            * light_info.m_transform_sequence.get_earliest_transform();
+        const Vector3d position = light_transform.point_to_parent(Vector3d(0.0));
+
+        // Spot lights are conservatively treated as omnidirectional lights.
+        LightTree::Item item;
+        item.m_bbox = AABB3d(position, position);
+        item.m_axis = Vector3d(0.0, 1.0, 0.0);
+        item.m_cos_theta_o = -1.0;
+        item.m_power = importance;
+        light_items.push_back(item);
+        m_local_lights.push_back(i);
+    }
+
+    m_local_lights_tree.build(light_items);
+
+    if (m_distant_lights_cdf.valid())
+        m_distant_lights_cdf.prepare();
+
+    // Emitting triangles are bounded by a cone around their geometric normal
+    // that also contains their vertex normals.
+    const size_t emitting_triangle_count = m_emitting_triangles.size();
+    vector<LightTree::Item> triangle_items(emitting_triangle_count);
+    for (size_t i = 0; i < emitting_triangle_count; ++i)
+    {
+        const EmittingTriangle& emitting_triangle = m_emitting_triangles[i];
+        LightTree::Item& item = triangle_items[i];
+
+        item.m_bbox = AABB3d::invalid();
+        item.m_bbox.insert(emitting_triangle.m_v0);
+        item.m_bbox.insert(emitting_triangle.m_v1);
+        item.m_bbox.insert(emitting_triangle.m_v2);
+
+        item.m_axis = emitting_triangle.m_geometric_normal;
+        item.m_cos_theta_o =
+            min(
+                1.0,
+                min(
+                    dot(item.m_axis, emitting_triangle.m_n0),
+                    min(
+                        dot(item.m_axis, emitting_triangle.m_n1),
+                        dot(item.m_axis, emitting_triangle.m_n2))));
+
+        item.m_power = m_emitting_triangles_cdf[i].second;
+    }
+
+    m_emitting_triangles_tree.build(triangle_items);
+
+    RENDERER_LOG_INFO(
+        "built light trees: %s %s, %s %s.",
+        pretty_int(m_local_lights_tree.get_node_count()).c_str(),
+        plural(m_local_lights_tree.get_node_count(), "light node").c_str(),
+        pretty_int(m_emitting_triangles_tree.get_node_count()).c_str(),
+        plural(m_emitting_triangles_tree.get_node_count(), "emitting triangle node").c_str());
+}
+
+namespace
+{
+    // Return true if a given sphere may intersect a given cone truncated at a given distance from its apex.
+    bool sphere_intersects_truncated_cone(
+        const Vector3d&                 center,
+        const double                    radius,
+        const Vector3d&                 apex,
+        const Vector3d&                 axis,
+        const double                    cos_half_angle,
+        const double                    max_distance)
+    {
+        // Small relative tolerance to remain conservative in the presence of rounding errors.
+        const double Eps = 1.0e-4;
+
+        const Vector3d d = center - apex;
+        const double dist = norm(d);
+
+        if (dist - radius > max_distance * (1.0 + Eps))
+            return false;
+
+        if (dist <= radius || cos_half_angle <= -1.0)
+            return true;
+
+        // Compare the angle between the axis and the direction to the center of the sphere
+        // with the half-angle of the cone widened by the angular radius of the sphere.
+        const double angle = acos(clamp(dot(d, axis) / dist, -1.0, 1.0));
+        const double half_angle = acos(clamp(cos_half_angle, -1.0, 1.0));
+        const double angular_radius = asin(min(radius / dist, 1.0));
+
+        return angle <= half_angle + angular_radius + Eps;
+    }
+}
+
+void LightSampler::build_light_culling_grid(const Scene& scene)
+{
+    // Compute the bounds of the regions lit by non-physical lights.
+    m_light_influences.resize(m_non_physical_light_count);
+    size_t local_light_count = 0;
+    for (size_t i = 0; i < m_non_physical_light_count; ++i)
+    {
+        const NonPhysicalLightInfo& light_info = m_non_physical_lights[i];
+        const Light& light = *light_info.m_light;
+        LightInfluence& influence = m_light_influences[i];
+
+        // Distant lights and moving lights are never culled.
+        influence.m_distant =
+            strcmp(light.get_model(), DirectionalLightFactory().get_model()) == 0 ||
+            strcmp(light.get_model(), SunLightFactory().get_model()) == 0 ||
+            light_info.m_transform_sequence.size() > 1;
+
+        if (influence.m_distant)
+            continue;
+
+        const Transformd light_transform =
+              light.get_transform()
+            * light_info.m_transform_sequence.get_earliest_transform();
+
+        influence.m_position = light_transform.point_to_parent(Vector3d(0.0));
+        light.get_influence_bounds(
+            light_transform,
+            influence.m_axis,
+            influence.m_cos_half_angle,
+            influence.m_max_distance);
+
+        ++local_light_count;
+    }
+
+    // Nothing to cull if all lights illuminate the whole scene.
+    if (local_light_count == 0)
+        return;
+
+    // Compute the bounding box and the resolution of the grid.
+    m_culling_grid_bbox = AABB3d(scene.compute_bbox());
+    m_culling_grid_bbox.robust_grow(1.0e-4);
+    const Vector3d extent = m_culling_grid_bbox.extent();
+    const double max_extent = max_value(extent);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        m_culling_grid_res[i] =
+            max<size_t>(
+                1,
+                static_cast<size_t>(ceil(m_params.m_light_culling_resolution * extent[i] / max_extent)));
+        m_culling_grid_scale[i] = m_culling_grid_res[i] / extent[i];
+    }
+
+    const Vector3d cell_extent(
+        extent[0] / m_culling_grid_res[0],
+        extent[1] / m_culling_grid_res[1],
+        extent[2] / m_culling_grid_res[2]);
+    const double cell_radius = 0.5 * norm(cell_extent);
+
+    // Collect the lights that may illuminate each cell.
+    m_culling_grid_cells.resize(m_culling_grid_res[0] * m_culling_grid_res[1] * m_culling_grid_res[2], 0);
+    size_t cell_light_count = 0;
+    for (size_t z = 0, cell_index = 0; z < m_culling_grid_res[2]; ++z)
+    {
+        for (size_t y = 0; y < m_culling_grid_res[1]; ++y)
+        {
+            for (size_t x = 0; x < m_culling_grid_res[0]; ++x, ++cell_index)
+            {
+                const Vector3d cell_center =
+                    m_culling_grid_bbox.min +
+                    Vector3d(x + 0.5, y + 0.5, z + 0.5) * cell_extent;
+
+                auto_ptr<EmitterDistribution> cell(new EmitterDistribution());
+
+                for (size_t i = 0; i < m_non_physical_light_count; ++i)
+                {
+                    const LightInfluence& influence = m_light_influences[i];
+
+                    if (influence.m_distant ||
+                        sphere_intersects_truncated_cone(
+                            cell_center,
+                            cell_radius,
+                            influence.m_position,
+                            influence.m_axis,
+                            influence.m_cos_half_angle,
+                            influence.m_max_distance))
+                    {
+                        const float importance = m_non_physical_lights[i].m_light->get_uncached_importance_multiplier();
+                        cell->insert(i, importance);
+                        ++cell_light_count;
+                    }
+                }
+
+                if (cell->valid())
+                {
+                    cell->prepare();
+                    m_culling_grid_cells[cell_index] = cell.release();
+                }
+            }
+        }
+    }
+
+    RENDERER_LOG_INFO(
+        "built light culling grid: %s x %s x %s cells, %s non-physical lights per cell on average.",
+        pretty_uint(m_culling_grid_res[0]).c_str(),
+        pretty_uint(m_culling_grid_res[1]).c_str(),
+        pretty_uint(m_culling_grid_res[2]).c_str(),
+        pretty_ratio(cell_light_count, m_culling_grid_cells.size()).c_str());
+}
+
+const LightSampler::EmitterDistribution* LightSampler::find_culling_grid_cell(const Vector3d& point) const
+{
+    if (m_culling_grid_cells.empty() || !m_culling_grid_bbox.contains(point))
+        return 0;
+
+    size_t cell_index = 0;
+    for (size_t i = 3; i-- > 0; )
+    {
+        const size_t c =
+            min(
+                truncate<size_t>((point[i] - m_culling_grid_bbox.min[i]) * m_culling_grid_scale[i]),
+                m_culling_grid_res[i] - 1);
+        cell_index = cell_index * m_culling_grid_res[i] + c;
+    }
+
+    // Cells without lights fall back to the set of all lights.
+    return m_culling_grid_cells[cell_index];
+}
+
+bool LightSampler::may_illuminate(
+    const size_t                        light_index,
+    const Vector3d&                     point) const
+{
+    if (m_light_influences.empty())
+        return true;
+
+    const LightInfluence& influence = m_light_influences[light_index];
+
+    return
+        influence.m_distant ||
+        sphere_intersects_truncated_cone(
+            point,
+            0.0,
+            influence.m_position,
+            influence.m_axis,
+            influence.m_cos_half_angle,
+            influence.m_max_distance);
+}
+
 void LightSampler::sample_non_physical_lights(
     const ShadingRay::Time&             time,
     const Vector3f&                     s,
@@ -429,7 +1005,7 @@ void LightSampler::sample_non_physical_lights(
 {
     assert(m_non_physical_lights_cdf.valid());
 
-    const EmitterCDF::ItemWeightPair result = m_non_physical_lights_cdf.sample(s[0]);
+    const EmitterDistribution::ItemWeightPair result = m_non_physical_lights_cdf.sample(s[0]);
     const size_t light_index = result.first;
     const float light_prob = result.second;
 
@@ -444,6 +1020,83 @@ void LightSampler::sample_non_physical_lights(
     assert(light_sample.m_probability > 0.0f);
 }
 
+void LightSampler::sample_non_physical_lights(
+    const ShadingRay::Time&             time,
+    const Vector3d&                     point,
+    const Vector3f&                     s,
+    LightSample&                        light_sample) const
+{
+    // Only consider the lights that may illuminate the point.
+    if (m_params.m_light_culling)
+    {
+        const EmitterDistribution* cell = find_culling_grid_cell(point);
+
+        if (cell)
+        {
+            const EmitterDistribution::ItemWeightPair result = cell->sample(s[0]);
+
+            light_sample.m_triangle = 0;
+            sample_non_physical_light(
+                time,
+                result.first,
+                result.second,
+                light_sample);
+
+            assert(light_sample.m_light);
+            return;
+        }
+    }
+
+    if (!m_params.m_light_tree)
+    {
+        sample_non_physical_lights(time, s, light_sample);
+        return;
+    }
+
+    assert(m_non_physical_lights_cdf.valid());
+
+    // Choose between distant lights and lights located at a point in proportion of their number.
+    const size_t local_light_count = m_local_lights.size();
+    const float distant_lights_prob =
+        m_local_lights_tree.empty() ? 1.0f :
+        m_distant_lights_cdf.valid()
+            ? static_cast<float>(m_non_physical_light_count - local_light_count) / m_non_physical_light_count
+            : 0.0f;
+
+    light_sample.m_triangle = 0;
+
+    if (s[0] < distant_lights_prob)
+    {
+        const EmitterDistribution::ItemWeightPair result =
+            m_distant_lights_cdf.sample(s[0] / distant_lights_prob);
+
+        sample_non_physical_light(
+            time,
+            result.first,
+            result.second * distant_lights_prob,
+            light_sample);
+    }
+    else
+    {
+        const float local_lights_prob = 1.0f - distant_lights_prob;
+
+        float light_prob;
+        const size_t item_index =
+            m_local_lights_tree.sample(
+                point,
+                (s[0] - distant_lights_prob) / local_lights_prob,
+                light_prob);
+
+        sample_non_physical_light(
+            time,
+            m_local_lights[item_index],
+            light_prob * local_lights_prob,
+            light_sample);
+    }
+
+    assert(light_sample.m_light);
+}
+
 void LightSampler::sample_emitting_triangles(
     const ShadingRay::Time&             time,
     const Vector3f&                     s,
@@ -451,7 +1104,7 @@ void LightSampler::sample_emitting_triangles(
 {
     assert(m_emitting_triangles_cdf.valid());
 
-    const EmitterCDF::ItemWeightPair result = m_emitting_triangles_cdf.sample(s[0]);
+    const EmitterDistribution::ItemWeightPair result = m_emitting_triangles_cdf.sample(s[0]);
     const size_t emitter_index = result.first;
     const float emitter_prob = result.second;
 
@@ -467,6 +1120,35 @@ void LightSampler::sample_emitting_triangles(
     assert(light_sample.m_probability > 0.0f);
 }
 
+void LightSampler::sample_emitting_triangles(
+    const ShadingRay::Time&             time,
+    const Vector3d&                     point,
+    const Vector3f&                     s,
+    LightSample&                        light_sample) const
+{
+    if (!m_params.m_light_tree)
+    {
+        sample_emitting_triangles(time, s, light_sample);
+        return;
+    }
+
+    assert(m_emitting_triangles_cdf.valid());
+
+    float emitter_prob;
+    const size_t emitter_index =
+        m_emitting_triangles_tree.sample(point, s[0], emitter_prob);
+
+    light_sample.m_light = 0;
+    sample_emitting_triangle(
+        time,
+        Vector2f(s[1], s[2]),
+        emitter_index,
+        emitter_prob,
+        light_sample);
+
+    assert(light_sample.m_triangle);
+}
+
 void LightSampler::sample(
     const ShadingRay::Time&             time,
     const Vector3f&                     s,
@@ -500,7 +1182,69 @@ void LightSampler::sample(
     else sample_emitting_triangles(time, s, light_sample);
 }
 
+void LightSampler::sample(
+    const ShadingRay::Time&             time,
+    const Vector3d&                     point,
+    const Vector3f&                     s,
+    LightSample&                        light_sample) const
+{
+    assert(m_non_physical_lights_cdf.valid() || m_emitting_triangles_cdf.valid());
+
+    if (m_non_physical_lights_cdf.valid())
+    {
+        if (m_emitting_triangles_cdf.valid())
+        {
+            if (s[0] < 0.5f)
+            {
+                sample_non_physical_lights(
+                    time,
+                    point,
+                    Vector3f(s[0] * 2.0f, s[1], s[2]),
+                    light_sample);
+            }
+            else
+            {
+                sample_emitting_triangles(
+                    time,
+                    point,
+                    Vector3f((s[0] - 0.5f) * 2.0f, s[1], s[2]),
+                    light_sample);
+            }
+
+            light_sample.m_probability *= 0.5f;
+        }
+        else sample_non_physical_lights(time, point, s, light_sample);
+    }
+    else sample_emitting_triangles(time, point, s, light_sample);
+}
+
 float LightSampler::evaluate_pdf(const ShadingPoint& shading_point) const
+{
+    const EmittingTriangle* triangle = find_emitting_triangle(shading_point);
+    return triangle->m_triangle_prob * triangle->m_rcp_area;
+}
+
+float LightSampler::evaluate_pdf(
+    const ShadingPoint&                 shading_point,
+    const Vector3d&                     point) const
+{
+    const EmittingTriangle* triangle = find_emitting_triangle(shading_point);
+    return evaluate_pdf(triangle - &m_emitting_triangles[0], point);
+}
+
+float LightSampler::evaluate_pdf(
+    const size_t                        triangle_index,
+    const Vector3d&                     point) const
+{
+    const EmittingTriangle& triangle = m_emitting_triangles[triangle_index];
+
+    if (!m_params.m_light_tree)
+        return triangle.m_triangle_prob * triangle.m_rcp_area;
+
+    return m_emitting_triangles_tree.evaluate_pdf(point, triangle_index) * triangle.m_rcp_area;
+}
+
+const EmittingTriangle* LightSampler::find_emitting_triangle(const ShadingPoint& shading_point) const
 {
     assert(shading_point.is_triangle_primitive());
 
@@ -510,8 +1254,7 @@ float LightSampler::evaluate_pdf(const ShadingPoint& shading_point) const
         shading_point.get_region_index(),
         shading_point.get_primitive_index());
 
-    const EmittingTriangle* triangle = m_emitting_triangle_hash_table.get(triangle_key);
-    return triangle->m_triangle_prob * triangle->m_rcp_area;
+    return m_emitting_triangle_hash_table.get(triangle_key);
 }
 
 void LightSampler::sample_non_physical_light(
@@ -523,6 +1266,7 @@ void LightSampler::sample_non_physical_light(
     // Fetch the light.
     const NonPhysicalLightInfo& light_info = m_non_physical_lights[light_index];
     light_sample.m_light = light_info.m_light;
+    light_sample.m_light_index = light_index;
 
     // Evaluate and store the transform of the light.
     light_sample.m_light_transform =
@@ -539,17 +1283,29 @@ void LightSampler::sample_emitting_triangle(
     const size_t                        triangle_index,
     const float                         triangle_prob,
     LightSample&                        light_sample) const
+{
+    // Uniformly sample the surface of the triangle.
+    const Vector3d bary = sample_triangle_uniform(Vector2d(s));
+
+    make_emitting_triangle_sample(
+        bary,
+        triangle_index,
+        triangle_prob,
+        light_sample);
+}
+
+void LightSampler::make_emitting_triangle_sample(
+    const Vector3d&                     bary,
+    const size_t                        triangle_index,
+    const float                         triangle_prob,
+    LightSample&                        light_sample) const
 {
     // Fetch the emitting triangle.
     const EmittingTriangle& emitting_triangle = m_emitting_triangles[triangle_index];
-    assert(emitting_triangle.m_triangle_prob == triangle_prob);
 
     // Store a pointer to the emitting triangle.
     light_sample.m_triangle = &emitting_triangle;
 
-    // Uniformly sample the surface of the triangle.
-    const Vector3d bary = sample_triangle_uniform(Vector2d(s));
-
     // Set the barycentric coordinates.
     light_sample.m_bary[0] = static_cast<float>(bary[0]);
     light_sample.m_bary[1] = static_cast<float>(bary[1]);
@@ -600,7 +1356,48 @@ void LightSampler::store_object_area_in_shadergroups(
 
 LightSampler::Parameters::Parameters(const ParamArray& params)
   : m_importance_sampling(params.get_optional<bool>("enable_importance_sampling", false))
+  , m_light_tree(params.get_optional<bool>("enable_light_tree", false))
+  , m_light_culling(params.get_optional<bool>("enable_light_culling", false))
+  , m_light_culling_resolution(max<size_t>(params.get_optional<size_t>("light_culling_resolution", 16), 1))
+{
+}
+
+
+//
+// LightSamplerCache class implementation.
+//
+
+LightSamplerCache::LightSamplerCache()
+  : m_signature(0)
+{
+}
+
+const LightSampler& LightSamplerCache::get(
+    const Scene&                        scene,
+    const ParamArray&                   params,
+    TextureStore*                       texture_store)
+{
+    const uint64 signature = LightSampler::compute_signature(scene);
+
+    if (m_light_sampler.get() && signature == m_signature && params == m_params)
+    {
+        RENDERER_LOG_INFO("light emitters are unchanged, reusing light sampler.");
+        return *m_light_sampler;
+    }
+
+    // Release the previous light sampler before building the new one.
+    m_light_sampler.reset();
+    m_light_sampler.reset(new LightSampler(scene, params, texture_store));
+    m_signature = signature;
+    m_params = params;
+
+    return *m_light_sampler;
+}
+
+void LightSamplerCache::clear()
 {
+    m_light_sampler.reset();
+    m_params = ParamArray();
 }
 
 }   // namespace renderer
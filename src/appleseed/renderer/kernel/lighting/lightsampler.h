@@ -32,22 +32,27 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/intersection/intersectionsettings.h"
+#include "renderer/kernel/lighting/lighttree.h"
 #include "renderer/kernel/shading/shadingray.h"
 #include "renderer/modeling/scene/containers.h"
+#include "renderer/utility/paramarray.h"
 #include "renderer/utility/transformsequence.h"
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
-#include "foundation/math/cdf.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/aliastable.h"
 #include "foundation/math/hash.h"
 #include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/types.h"
-#include "foundation/utility/containers/hashtable.h"
+#include "foundation/utility/containers/openhashtable.h"
 #include "foundation/utility/uid.h"
 
 // Standard headers.
+#include <cassert>
 #include <cstddef>
+#include <memory>
 #include <vector>
 
 // Forward declarations.
@@ -58,9 +63,9 @@ namespace renderer  { class Light; }
 namespace renderer  { class Material; }
 namespace renderer  { class MaterialArray; }
 namespace renderer  { class ObjectInstance; }
-namespace renderer  { class ParamArray; }
 namespace renderer  { class Scene; }
 namespace renderer  { class ShadingPoint; }
+namespace renderer  { class TextureStore; }
 
 namespace renderer
 {
@@ -130,7 +135,7 @@ struct EmittingTriangleKeyHasher
     size_t operator()(const EmittingTriangleKey& key) const;
 };
 
-typedef foundation::HashTable<
+typedef foundation::OpenHashTable<
     EmittingTriangleKey,
     EmittingTriangleKeyHasher,
     const EmittingTriangle*
@@ -153,6 +158,7 @@ class LightSample
 
     // Data for a non-physical light sample.
     const Light*                m_light;
+    size_t                      m_light_index;                  // index of the light in the light sampler
     foundation::Transformd      m_light_transform;              // light space to world space transform
 
     // Data common to all sample types.
@@ -170,15 +176,36 @@ class LightSample
 // The light sampler collects all the light-emitting entities (non-physical lights, mesh lights)
 // and allows to sample them.
 //
+// When the light tree is enabled, the sampling methods taking a world space point choose
+// emitters according to their estimated contribution to this point; the other methods,
+// meant for paths starting on lights, always sample emitters in proportion of their power.
+//
+// When light culling is enabled, non-physical lights are sampled from a given world space
+// point among the lights that may illuminate the cell of a uniform grid containing that point.
+// The lights of each cell are found using conservative bounds of the regions lit by the lights
+// (spot light cones, cutoff distances).
+//
 
 class LightSampler
   : public foundation::NonCopyable
 {
   public:
     // Constructor.
+    // When a texture store is provided and importance sampling is enabled, triangles of
+    // emitters with a textured radiance are weighted by their average emitted radiance.
     LightSampler(
         const Scene&                        scene,
-        const ParamArray&                   params = ParamArray());
+        const ParamArray&                   params = ParamArray(),
+        TextureStore*                       texture_store = 0);
+
+    // Destructor.
+    ~LightSampler();
+
+    // Compute a signature of the scene entities a light sampler depends on: assembly
+    // instances and their transforms, assemblies, lights, materials, EDFs, shader groups,
+    // object instances and objects. A light sampler built for a scene remains valid as
+    // long as the signature of the scene does not change.
+    static foundation::uint64 compute_signature(const Scene& scene);
 
     // Return the number of non-physical lights in the scene.
     size_t get_non_physical_light_count() const;
@@ -189,12 +216,28 @@ class LightSampler
     // Return true if the scene contains at least one light or emitting triangle.
     bool has_lights_or_emitting_triangles() const;
 
+    // Return true if non-physical lights, respectively emitting triangles, can be sampled.
+    bool has_non_physical_lights() const;
+    bool has_emitting_triangles() const;
+
     // Sample the set of non-physical lights.
     void sample_non_physical_lights(
         const ShadingRay::Time&             time,
         const foundation::Vector3f&         s,
         LightSample&                        light_sample) const;
 
+    // Sample the set of non-physical lights as seen from a given world space point.
+    void sample_non_physical_lights(
+        const ShadingRay::Time&             time,
+        const foundation::Vector3d&         point,
+        const foundation::Vector3f&         s,
+        LightSample&                        light_sample) const;
+
+    // Return false if a given non-physical light certainly does not illuminate a given world space point.
+    bool may_illuminate(
+        const size_t                        light_index,
+        const foundation::Vector3d&         point) const;
+
     // Sample a single given non-physical light.
     void sample_non_physical_light(
         const ShadingRay::Time&             time,
@@ -207,26 +250,77 @@ class LightSampler
         const foundation::Vector3f&         s,
         LightSample&                        light_sample) const;
 
+    // Sample the set of emitting triangles as seen from a given world space point.
+    void sample_emitting_triangles(
+        const ShadingRay::Time&             time,
+        const foundation::Vector3d&         point,
+        const foundation::Vector3f&         s,
+        LightSample&                        light_sample) const;
+
     // Sample the sets of non-physical lights and emitting triangles.
     void sample(
         const ShadingRay::Time&             time,
         const foundation::Vector3f&         s,
         LightSample&                        light_sample) const;
 
+    // Sample the sets of non-physical lights and emitting triangles as seen from a given world space point.
+    void sample(
+        const ShadingRay::Time&             time,
+        const foundation::Vector3d&         point,
+        const foundation::Vector3f&         s,
+        LightSample&                        light_sample) const;
+
     // Compute the probability density in area measure of a given light sample.
     float evaluate_pdf(const ShadingPoint& shading_point) const;
 
+    // Compute the probability density in area measure of a given light sample
+    // taken by sample_emitting_triangles() from a given world space point.
+    float evaluate_pdf(
+        const ShadingPoint&                 shading_point,
+        const foundation::Vector3d&         point) const;
+
+    // Compute the probability density in area measure of sampling a point on a given
+    // emitting triangle with sample_emitting_triangles() from a given world space point.
+    float evaluate_pdf(
+        const size_t                        triangle_index,
+        const foundation::Vector3d&         point) const;
+
+    // Return a given emitting triangle. Emitting triangles of the same object instance are contiguous.
+    const EmittingTriangle& get_emitting_triangle(const size_t triangle_index) const;
+
+    // Find the emitting triangle at a given shading point.
+    const EmittingTriangle* find_emitting_triangle(const ShadingPoint& shading_point) const;
+
+    // Uniformly sample a given emitting triangle chosen with a given probability.
+    void sample_emitting_triangle(
+        const ShadingRay::Time&             time,
+        const foundation::Vector2f&         s,
+        const size_t                        triangle_index,
+        const float                         triangle_prob,
+        LightSample&                        sample) const;
+
+    // Build the sample at given barycentric coordinates of a given emitting triangle chosen with a given probability.
+    void make_emitting_triangle_sample(
+        const foundation::Vector3d&         bary,
+        const size_t                        triangle_index,
+        const float                         triangle_prob,
+        LightSample&                        sample) const;
+
   private:
     struct Parameters
     {
-        const bool m_importance_sampling;
+        const bool      m_importance_sampling;
+        const bool      m_light_tree;
+        const bool      m_light_culling;
+        const size_t    m_light_culling_resolution;        // number of grid cells along the largest dimension of the scene
 
         explicit Parameters(const ParamArray& params);
     };
 
     typedef std::vector<NonPhysicalLightInfo> NonPhysicalLightVector;
     typedef std::vector<EmittingTriangle> EmittingTriangleVector;
-    typedef foundation::CDF<size_t, float> EmitterCDF;
+    // Emitters are chosen with alias tables, in constant time.
+    typedef foundation::AliasTable<size_t, float> EmitterDistribution;
 
     const Parameters            m_params;
 
@@ -235,8 +329,31 @@ class LightSampler
 
     EmittingTriangleVector      m_emitting_triangles;
 
-    EmitterCDF                  m_non_physical_lights_cdf;
-    EmitterCDF                  m_emitting_triangles_cdf;
+    EmitterDistribution         m_non_physical_lights_cdf;
+    EmitterDistribution         m_emitting_triangles_cdf;
+
+    // Light trees, only built when the light tree is enabled. Distant lights are kept in a CDF.
+    std::vector<size_t>         m_local_lights;                 // indices of the non-physical lights of the tree
+    LightTree                   m_local_lights_tree;
+    EmitterDistribution         m_distant_lights_cdf;
+    LightTree                   m_emitting_triangles_tree;
+
+    // Conservative bounds of the regions lit by non-physical lights.
+    struct LightInfluence
+    {
+        bool                    m_distant;                      // distant lights illuminate the whole scene
+        foundation::Vector3d    m_position;                     // world space position of the light
+        foundation::Vector3d    m_axis;                         // world space axis of the cone of influence, unit-length
+        double                  m_cos_half_angle;               // cosine of the half-angle of the cone, -1 for omnidirectional lights
+        double                  m_max_distance;                 // distance reached by the light
+    };
+
+    // Light culling grid, only built when light culling is enabled.
+    std::vector<LightInfluence> m_light_influences;
+    foundation::AABB3d          m_culling_grid_bbox;
+    size_t                      m_culling_grid_res[3];
+    foundation::Vector3d        m_culling_grid_scale;           // grid resolution divided by grid extent
+    std::vector<EmitterDistribution*> m_culling_grid_cells;       // owned, 0 for cells without lights
 
     EmittingTriangleKeyHasher   m_triangle_key_hasher;
     EmittingTriangleHashTable   m_emitting_triangle_hash_table;
@@ -251,20 +368,25 @@ class LightSampler
         const Assembly&                     assembly,
         const TransformSequence&            transform_sequence);
 
-    // Recursively collect emitting triangles from a given set of assembly instances.
-    void collect_emitting_triangles(
-        const AssemblyInstanceContainer&    assembly_instances,
-        const TransformSequence&            parent_transform_seq);
-
-    // Collect emitting triangles from a given assembly.
+    // Collect emitting triangles from all object instances of the scene.
+    // Object instances are processed in parallel but the results are deterministic.
     void collect_emitting_triangles(
-        const Assembly&                     assembly,
-        const AssemblyInstance&             assembly_instance,
-        const TransformSequence&            transform_sequence);
+        const Scene&                        scene,
+        const size_t                        thread_count,
+        TextureStore*                       texture_store);
 
     // Build a hash table that allows to find the emitting triangle at a given shading point.
     void build_emitting_triangle_hash_table();
 
+    // Build the light trees of non-physical lights and emitting triangles.
+    void build_light_trees();
+
+    // Build the light culling grid.
+    void build_light_culling_grid(const Scene& scene);
+
+    // Return the light culling grid cell containing a given world space point, or 0 if there is none.
+    const EmitterDistribution* find_culling_grid_cell(const foundation::Vector3d& point) const;
+
     // Sample a given non-physical light.
     void sample_non_physical_light(
         const ShadingRay::Time&             time,
@@ -272,14 +394,6 @@ class LightSampler
         const float                         light_prob,
         LightSample&                        sample) const;
 
-    // Sample a given emitting triangle.
-    void sample_emitting_triangle(
-        const ShadingRay::Time&             time,
-        const foundation::Vector2f&         s,
-        const size_t                        triangle_index,
-        const float                         triangle_prob,
-        LightSample&                        sample) const;
-
     void store_object_area_in_shadergroups(
         const AssemblyInstance*             assembly_instance,
         const ObjectInstance*               object_instance,
@@ -288,6 +402,34 @@ class LightSampler
 };
 
 
+//
+// Keeps the light sampler of a scene across rendering sessions, and only rebuilds it
+// when the scene entities it depends on or its parameters have changed.
+//
+
+class LightSamplerCache
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    LightSamplerCache();
+
+    // Return a light sampler for a given scene, rebuilding it if necessary.
+    const LightSampler& get(
+        const Scene&                        scene,
+        const ParamArray&                   params,
+        TextureStore*                       texture_store = 0);
+
+    // Release the light sampler.
+    void clear();
+
+  private:
+    std::auto_ptr<LightSampler>             m_light_sampler;
+    foundation::uint64                      m_signature;
+    ParamArray                              m_params;
+};
+
+
 //
 // EmittingTriangleKey class implementation.
 //
@@ -347,11 +489,27 @@ inline size_t LightSampler::get_emitting_triangle_count() const
     return m_emitting_triangles.size();
 }
 
+inline const EmittingTriangle& LightSampler::get_emitting_triangle(const size_t triangle_index) const
+{
+    assert(triangle_index < m_emitting_triangles.size());
+    return m_emitting_triangles[triangle_index];
+}
+
 inline bool LightSampler::has_lights_or_emitting_triangles() const
 {
     return m_non_physical_lights_cdf.valid() || m_emitting_triangles_cdf.valid();
 }
 
+inline bool LightSampler::has_non_physical_lights() const
+{
+    return m_non_physical_lights_cdf.valid();
+}
+
+inline bool LightSampler::has_emitting_triangles() const
+{
+    return m_emitting_triangles_cdf.valid();
+}
+
 inline void LightSampler::sample_non_physical_light(
     const ShadingRay::Time&                 time,
     const size_t                            light_index,
@@ -0,0 +1,518 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "lightselectionguide.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/kernel/lighting/lightsampler.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/fixedpoint.h"
+#include "foundation/math/hash.h"
+#include "foundation/math/scalar.h"
+#include "foundation/platform/atomic.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    // Beyond this number of lights or object instances, the statistics would take too much memory.
+    const size_t MaxLearnedEmitterCount = 256;
+}
+
+
+//
+// LightSelectionGuide class implementation.
+//
+
+LightSelectionGuide::LightSelectionGuide(
+    const Scene&            scene,
+    const LightSampler&     light_sampler,
+    const ParamArray&       params)
+  : m_params(params)
+  , m_light_sampler(light_sampler)
+  , m_bbox(scene.compute_bbox())
+  , m_pass_number(0)
+  , m_light_count(0)
+  , m_group_count(0)
+{
+    // Compute the size of the grid cells from the largest dimension of the scene.
+    const double max_extent = max_value(m_bbox.extent());
+    m_rcp_cell_size = max_extent > 0.0 ? m_params.m_spatial_resolution / max_extent : 0.0;
+
+    // Non-physical lights.
+    const size_t light_count = m_light_sampler.get_non_physical_light_count();
+    if (light_count > MaxLearnedEmitterCount)
+    {
+        RENDERER_LOG_INFO(
+            "adaptive light selection: %s non-physical lights, their selection probabilities will not be learned.",
+            pretty_uint(light_count).c_str());
+    }
+    else if (light_count > 0)
+    {
+        m_light_count = light_count;
+        m_light_contributions.assign(m_params.m_bucket_count * m_light_count, 0);
+        m_light_probs.assign(m_params.m_bucket_count * m_light_count, 1.0f);
+    }
+
+    // Group the emitting triangles by object instance; they are contiguous in the light sampler.
+    const size_t triangle_count = m_light_sampler.get_emitting_triangle_count();
+    if (m_light_sampler.has_emitting_triangles())
+    {
+        m_triangle_groups.resize(triangle_count);
+        m_triangle_cdfs.resize(triangle_count);
+
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            const EmittingTriangle& triangle = m_light_sampler.get_emitting_triangle(i);
+
+            if (i == 0 ||
+                triangle.m_assembly_instance != m_light_sampler.get_emitting_triangle(i - 1).m_assembly_instance ||
+                triangle.m_object_instance_index != m_light_sampler.get_emitting_triangle(i - 1).m_object_instance_index)
+            {
+                m_group_begin.push_back(i);
+                m_group_power_probs.push_back(0.0f);
+            }
+
+            m_triangle_groups[i] = static_cast<uint32>(m_group_begin.size() - 1);
+            m_group_power_probs.back() += triangle.m_triangle_prob;
+            m_triangle_cdfs[i] = m_group_power_probs.back();
+        }
+
+        m_group_begin.push_back(triangle_count);
+
+        // Normalize the cumulative probabilities of the triangles within each object instance.
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            const float group_power_prob = m_group_power_probs[m_triangle_groups[i]];
+            m_triangle_cdfs[i] = group_power_prob > 0.0f ? m_triangle_cdfs[i] / group_power_prob : 1.0f;
+        }
+
+        for (size_t g = 0, e = m_group_power_probs.size(); g < e; ++g)
+            m_triangle_cdfs[m_group_begin[g + 1] - 1] = 1.0f;
+
+        const size_t group_count = m_group_power_probs.size();
+        if (group_count > MaxLearnedEmitterCount)
+        {
+            RENDERER_LOG_INFO(
+                "adaptive light selection: %s object instances with emitting triangles, their selection probabilities will not be learned.",
+                pretty_uint(group_count).c_str());
+        }
+        else if (group_count > 1)
+        {
+            m_group_count = group_count;
+            m_group_contributions.assign(m_params.m_bucket_count * m_group_count, 0);
+            m_group_cdfs.assign(m_params.m_bucket_count * m_group_count, 0.0f);
+        }
+    }
+
+    RENDERER_LOG_INFO(
+        "adaptive light selection: %s training %s, %s cells, learning %s %s and %s %s.",
+        pretty_uint(m_params.m_training_passes).c_str(),
+        plural(m_params.m_training_passes, "pass", "passes").c_str(),
+        pretty_uint(m_params.m_bucket_count).c_str(),
+        pretty_uint(m_light_count).c_str(),
+        plural(m_light_count, "non-physical light").c_str(),
+        pretty_uint(m_group_count).c_str(),
+        plural(m_group_count, "object instance").c_str());
+}
+
+void LightSelectionGuide::release()
+{
+    delete this;
+}
+
+void LightSelectionGuide::pre_render(
+    const Frame&            frame,
+    JobQueue&               job_queue,
+    IAbortSwitch&           abort_switch)
+{
+}
+
+bool LightSelectionGuide::post_render(
+    const Frame&            frame,
+    JobQueue&               job_queue,
+    IAbortSwitch&           abort_switch)
+{
+    // Rebuild the selection probabilities after each training pass.
+    if (is_training())
+        update_distributions();
+
+    ++m_pass_number;
+
+    // The recorded contributions are no longer needed once training is over.
+    if (!is_training())
+    {
+        vector<uint64>().swap(m_light_contributions);
+        vector<uint64>().swap(m_group_contributions);
+    }
+
+    return false;
+}
+
+float LightSelectionGuide::get_non_physical_light_probability(
+    const size_t            light_index,
+    const Vector3d&         point) const
+{
+    if (m_light_count == 0)
+        return 1.0f;
+
+    assert(light_index < m_light_count);
+
+    return m_light_probs[get_bucket_index(point) * m_light_count + light_index];
+}
+
+void LightSelectionGuide::sample_emitting_triangles(
+    const ShadingRay::Time& time,
+    const Vector3d&         point,
+    const Vector3f&         s,
+    LightSample&            light_sample) const
+{
+    // Only use the light sampler when there is nothing to guide.
+    const size_t bucket_index = get_bucket_index(point);
+    if (!is_guided(bucket_index))
+    {
+        m_light_sampler.sample_emitting_triangles(time, point, s, light_sample);
+        return;
+    }
+
+    const float learned_fraction = m_params.m_learned_fraction;
+    size_t triangle_index;
+
+    if (s[0] < learned_fraction)
+    {
+        // Choose an object instance according to the learned distribution.
+        const float* group_cdf = &m_group_cdfs[bucket_index * m_group_count];
+        const float t = s[0] / learned_fraction;
+        const size_t group =
+            min<size_t>(upper_bound(group_cdf, group_cdf + m_group_count, t) - group_cdf, m_group_count - 1);
+
+        // Reuse the remapped random number to choose a triangle of this object instance.
+        const float group_begin_cdf = group > 0 ? group_cdf[group - 1] : 0.0f;
+        const float group_prob = group_cdf[group] - group_begin_cdf;
+        const float u = group_prob > 0.0f ? min((t - group_begin_cdf) / group_prob, 1.0f) : 0.0f;
+        const float* triangle_cdf_begin = &m_triangle_cdfs[m_group_begin[group]];
+        const float* triangle_cdf_end = &m_triangle_cdfs[0] + m_group_begin[group + 1];
+        triangle_index =
+            min<size_t>(
+                upper_bound(triangle_cdf_begin, triangle_cdf_end, u) - &m_triangle_cdfs[0],
+                m_group_begin[group + 1] - 1);
+
+        light_sample.m_light = 0;
+        m_light_sampler.sample_emitting_triangle(
+            time,
+            Vector2f(s[1], s[2]),
+            triangle_index,
+            1.0f,
+            light_sample);
+    }
+    else
+    {
+        m_light_sampler.sample_emitting_triangles(
+            time,
+            point,
+            Vector3f((s[0] - learned_fraction) / (1.0f - learned_fraction), s[1], s[2]),
+            light_sample);
+
+        triangle_index = light_sample.m_triangle - &m_light_sampler.get_emitting_triangle(0);
+    }
+
+    // The probability density of the sample is that of the mixture of both distributions.
+    light_sample.m_probability = evaluate_pdf(bucket_index, triangle_index, point);
+}
+
+void LightSelectionGuide::sample(
+    const ShadingRay::Time& time,
+    const Vector3d&         point,
+    const Vector3f&         s,
+    LightSample&            light_sample) const
+{
+    assert(m_light_sampler.has_lights_or_emitting_triangles());
+
+    if (m_light_sampler.has_non_physical_lights())
+    {
+        if (m_light_sampler.has_emitting_triangles())
+        {
+            if (s[0] < 0.5f)
+            {
+                m_light_sampler.sample_non_physical_lights(
+                    time,
+                    point,
+                    Vector3f(s[0] * 2.0f, s[1], s[2]),
+                    light_sample);
+            }
+            else
+            {
+                sample_emitting_triangles(
+                    time,
+                    point,
+                    Vector3f((s[0] - 0.5f) * 2.0f, s[1], s[2]),
+                    light_sample);
+            }
+
+            light_sample.m_probability *= 0.5f;
+        }
+        else m_light_sampler.sample_non_physical_lights(time, point, s, light_sample);
+    }
+    else sample_emitting_triangles(time, point, s, light_sample);
+}
+
+float LightSelectionGuide::evaluate_pdf(
+    const ShadingPoint&     shading_point,
+    const Vector3d&         point) const
+{
+    const EmittingTriangle* triangle = m_light_sampler.find_emitting_triangle(shading_point);
+    const size_t triangle_index = triangle - &m_light_sampler.get_emitting_triangle(0);
+    const size_t bucket_index = get_bucket_index(point);
+
+    return
+        is_guided(bucket_index)
+            ? evaluate_pdf(bucket_index, triangle_index, point)
+            : m_light_sampler.evaluate_pdf(triangle_index, point);
+}
+
+void LightSelectionGuide::record_non_physical_light(
+    const Vector3d&         point,
+    const size_t            light_index,
+    const float             contribution)
+{
+    if (!is_training() || m_light_count == 0 || light_index >= m_light_count)
+        return;
+
+    if (!(contribution > 0.0f) || !FP<float>::is_finite(contribution))
+        return;
+
+    atomic_add(
+        &m_light_contributions[get_bucket_index(point) * m_light_count + light_index],
+        float_to_fixed_point(contribution));
+}
+
+void LightSelectionGuide::record_emitting_triangle(
+    const Vector3d&         point,
+    const EmittingTriangle* triangle,
+    const float             contribution)
+{
+    if (!is_training() || m_group_count == 0)
+        return;
+
+    if (!(contribution > 0.0f) || !FP<float>::is_finite(contribution))
+        return;
+
+    const size_t triangle_index = triangle - &m_light_sampler.get_emitting_triangle(0);
+    const size_t group = m_triangle_groups[triangle_index];
+    atomic_add(
+        &m_group_contributions[get_bucket_index(point) * m_group_count + group],
+        float_to_fixed_point(contribution));
+}
+
+void LightSelectionGuide::add_params_metadata(Dictionary& metadata)
+{
+    metadata.dictionaries().insert(
+        "enable_adaptive_light_selection",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Enable Adaptive Light Selection")
+            .insert("help", "Learn which lights contribute to each region of the scene during the first passes and sample them preferentially"));
+
+    metadata.dictionaries().insert(
+        "adaptive_light_selection_training_passes",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "4")
+            .insert("min", "1")
+            .insert("label", "Adaptive Light Selection Training Passes")
+            .insert("help", "Number of passes during which light contributions are learned"));
+
+    metadata.dictionaries().insert(
+        "adaptive_light_selection_spatial_resolution",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "32")
+            .insert("min", "1")
+            .insert("label", "Adaptive Light Selection Spatial Resolution")
+            .insert("help", "Number of cells along the largest dimension of the scene bounds"));
+
+    metadata.dictionaries().insert(
+        "adaptive_light_selection_cell_count",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "4096")
+            .insert("min", "1")
+            .insert("label", "Adaptive Light Selection Cell Count")
+            .insert("help", "Number of cells in which light contributions are recorded; spatial cells beyond this number share statistics"));
+
+    metadata.dictionaries().insert(
+        "adaptive_light_selection_fraction",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.5")
+            .insert("min", "0.0")
+            .insert("max", "0.9")
+            .insert("label", "Adaptive Light Selection Fraction")
+            .insert("help", "Weight of the learned light selection probabilities"));
+}
+
+size_t LightSelectionGuide::get_bucket_index(const Vector3d& point) const
+{
+    const Vector3d p = (point - m_bbox.min) * m_rcp_cell_size;
+
+    const uint32 h =
+        mix_uint32(
+            static_cast<uint32>(truncate<int32>(fast_floor(p[0]))),
+            static_cast<uint32>(truncate<int32>(fast_floor(p[1]))),
+            static_cast<uint32>(truncate<int32>(fast_floor(p[2]))));
+
+    return h % m_params.m_bucket_count;
+}
+
+bool LightSelectionGuide::is_guided(const size_t bucket_index) const
+{
+    return
+        m_group_count > 0 &&
+        m_group_cdfs[bucket_index * m_group_count + m_group_count - 1] > 0.0f;
+}
+
+void LightSelectionGuide::update_distributions()
+{
+    const float learned_fraction = m_params.m_learned_fraction;
+    size_t guided_bucket_count = 0;
+
+    for (size_t b = 0; b < m_params.m_bucket_count; ++b)
+    {
+        bool guided = false;
+
+        // Selection probabilities of the non-physical lights, relative to the largest contribution.
+        if (m_light_count > 0)
+        {
+            const uint64* contributions = &m_light_contributions[b * m_light_count];
+            float* probs = &m_light_probs[b * m_light_count];
+
+            const uint64 max_contribution = *max_element(contributions, contributions + m_light_count);
+
+            if (max_contribution > 0)
+            {
+                const double rcp_max_contribution = 1.0 / max_contribution;
+                for (size_t i = 0; i < m_light_count; ++i)
+                {
+                    probs[i] =
+                          (1.0f - learned_fraction)
+                        + learned_fraction * static_cast<float>(contributions[i] * rcp_max_contribution);
+                }
+                guided = true;
+            }
+        }
+
+        // Distribution of the object instances, in proportion of their contributions.
+        if (m_group_count > 0)
+        {
+            const uint64* contributions = &m_group_contributions[b * m_group_count];
+            float* cdf = &m_group_cdfs[b * m_group_count];
+
+            uint64 total = 0;
+            for (size_t g = 0; g < m_group_count; ++g)
+                total += contributions[g];
+
+            if (total > 0)
+            {
+                const double rcp_total = 1.0 / total;
+                uint64 sum = 0;
+                for (size_t g = 0; g < m_group_count; ++g)
+                {
+                    sum += contributions[g];
+                    cdf[g] = static_cast<float>(sum * rcp_total);
+                }
+                cdf[m_group_count - 1] = 1.0f;
+                guided = true;
+            }
+        }
+
+        if (guided)
+            ++guided_bucket_count;
+    }
+
+    RENDERER_LOG_INFO(
+        "adaptive light selection: pass %s recorded light contributions in %s of %s cells.",
+        pretty_uint(m_pass_number + 1).c_str(),
+        pretty_uint(guided_bucket_count).c_str(),
+        pretty_uint(m_params.m_bucket_count).c_str());
+}
+
+float LightSelectionGuide::evaluate_pdf(
+    const size_t            bucket_index,
+    const size_t            triangle_index,
+    const Vector3d&         point) const
+{
+    const EmittingTriangle& triangle = m_light_sampler.get_emitting_triangle(triangle_index);
+    const size_t group = m_triangle_groups[triangle_index];
+
+    // Probability of choosing this triangle with the learned distribution.
+    const float* group_cdf = &m_group_cdfs[bucket_index * m_group_count];
+    const float learned_group_prob = group_cdf[group] - (group > 0 ? group_cdf[group - 1] : 0.0f);
+    const float group_power_prob = m_group_power_probs[group];
+    const float learned_pdf =
+        group_power_prob > 0.0f
+            ? learned_group_prob * (triangle.m_triangle_prob / group_power_prob) * triangle.m_rcp_area
+            : 0.0f;
+
+    const float learned_fraction = m_params.m_learned_fraction;
+    return
+        (1.0f - learned_fraction) * m_light_sampler.evaluate_pdf(triangle_index, point) +
+        learned_fraction * learned_pdf;
+}
+
+
+//
+// LightSelectionGuide::Parameters class implementation.
+//
+
+LightSelectionGuide::Parameters::Parameters(const ParamArray& params)
+  : m_training_passes(params.get_optional<size_t>("adaptive_light_selection_training_passes", 4))
+  , m_spatial_resolution(max<size_t>(params.get_optional<size_t>("adaptive_light_selection_spatial_resolution", 32), 1))
+  , m_bucket_count(max<size_t>(params.get_optional<size_t>("adaptive_light_selection_cell_count", 4096), 1))
+  , m_learned_fraction(clamp(params.get_optional<float>("adaptive_light_selection_fraction", 0.5f), 0.0f, 0.9f))
+{
+}
+
+}   // namespace renderer
@@ -0,0 +1,208 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_RENDERER_KERNEL_LIGHTING_LIGHTSELECTIONGUIDE_H
+#define APPLESEED_RENDERER_KERNEL_LIGHTING_LIGHTSELECTIONGUIDE_H
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/ipasscallback.h"
+#include "renderer/kernel/shading/shadingray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class Dictionary; }
+namespace foundation    { class IAbortSwitch; }
+namespace foundation    { class JobQueue; }
+namespace renderer      { class EmittingTriangle; }
+namespace renderer      { class Frame; }
+namespace renderer      { class LightSample; }
+namespace renderer      { class LightSampler; }
+namespace renderer      { class ParamArray; }
+namespace renderer      { class Scene; }
+namespace renderer      { class ShadingPoint; }
+
+namespace renderer
+{
+
+//
+// Per-region light selection probabilities, learned from the contributions of the light
+// samples taken during the first passes, so that lights that never illuminate a region
+// of the scene (for instance because they are behind walls) are rarely sampled there.
+//
+// Space is divided into cells of a uniform grid which are hashed into a fixed number of
+// buckets; cells sharing a bucket share their statistics. Each bucket holds:
+//
+//   - A selection probability per non-physical light, used when lights are enumerated:
+//     a light is only sampled with this probability and its contribution is divided by it.
+//
+//   - A distribution over the object instances with emitting triangles, mixed with the
+//     distribution of the light sampler for robustness. Triangles are then chosen within
+//     object instances in proportion of their power.
+//
+// Probabilities are never lower than one minus the learned fraction, and distributions are
+// only rebuilt between passes, so the light samples remain unbiased. Contributions are
+// accumulated in fixed point so that they don't depend on the order in which rendering
+// threads record them. The probability
+// densities of the light samples are available through evaluate_pdf().
+//
+
+class LightSelectionGuide
+  : public IPassCallback
+{
+  public:
+    // Constructor.
+    LightSelectionGuide(
+        const Scene&                    scene,
+        const LightSampler&             light_sampler,
+        const ParamArray&               params);
+
+    // Delete this instance.
+    virtual void release() APPLESEED_OVERRIDE;
+
+    // This method is called at the beginning of a pass.
+    virtual void pre_render(
+        const Frame&                    frame,
+        foundation::JobQueue&           job_queue,
+        foundation::IAbortSwitch&       abort_switch) APPLESEED_OVERRIDE;
+
+    // This method is called at the end of a pass.
+    virtual bool post_render(
+        const Frame&                    frame,
+        foundation::JobQueue&           job_queue,
+        foundation::IAbortSwitch&       abort_switch) APPLESEED_OVERRIDE;
+
+    // Return true if light sample contributions should be recorded during the current pass.
+    bool is_training() const;
+
+    // Return the probability with which a given non-physical light should be sampled at a
+    // given world space point when all lights are enumerated.
+    float get_non_physical_light_probability(
+        const size_t                    light_index,
+        const foundation::Vector3d&     point) const;
+
+    // Sample the set of emitting triangles as seen from a given world space point.
+    void sample_emitting_triangles(
+        const ShadingRay::Time&         time,
+        const foundation::Vector3d&     point,
+        const foundation::Vector3f&     s,
+        LightSample&                    light_sample) const;
+
+    // Sample the sets of non-physical lights and emitting triangles as seen from a given world space point.
+    void sample(
+        const ShadingRay::Time&         time,
+        const foundation::Vector3d&     point,
+        const foundation::Vector3f&     s,
+        LightSample&                    light_sample) const;
+
+    // Compute the probability density in area measure of a given light sample
+    // taken by sample_emitting_triangles() from a given world space point.
+    float evaluate_pdf(
+        const ShadingPoint&             shading_point,
+        const foundation::Vector3d&     point) const;
+
+    // Record the contribution of a light sample to a given world space point, divided by
+    // the probability of the sample. These methods are thread-safe.
+    void record_non_physical_light(
+        const foundation::Vector3d&     point,
+        const size_t                    light_index,
+        const float                     contribution);
+    void record_emitting_triangle(
+        const foundation::Vector3d&     point,
+        const EmittingTriangle*         triangle,
+        const float                     contribution);
+
+    // Add the metadata of the adaptive light selection parameters to a dictionary.
+    static void add_params_metadata(foundation::Dictionary& metadata);
+
+  private:
+    struct Parameters
+    {
+        const size_t    m_training_passes;                      // number of passes during which contributions are recorded
+        const size_t    m_spatial_resolution;                   // number of grid cells along the largest dimension of the scene
+        const size_t    m_bucket_count;                         // number of hash table buckets
+        const float     m_learned_fraction;                     // weight of the learned distributions
+
+        explicit Parameters(const ParamArray& params);
+    };
+
+    const Parameters                    m_params;
+    const LightSampler&                 m_light_sampler;
+    foundation::AABB3d                  m_bbox;
+    double                              m_rcp_cell_size;
+    size_t                              m_pass_number;
+
+    // Non-physical lights, empty if they are not learned.
+    size_t                              m_light_count;
+    std::vector<foundation::uint64>     m_light_contributions;  // recorded contributions in fixed point, per bucket and per light
+    std::vector<float>                  m_light_probs;          // selection probability of each light, per bucket
+
+    // Object instances with emitting triangles, empty if they are not learned.
+    size_t                              m_group_count;
+    std::vector<foundation::uint32>     m_triangle_groups;      // object instance of each emitting triangle
+    std::vector<float>                  m_triangle_cdfs;        // cumulative triangle probabilities within object instances
+    std::vector<size_t>                 m_group_begin;          // index of the first triangle of each object instance, plus end
+    std::vector<float>                  m_group_power_probs;    // probability of each object instance in proportion of its power
+    std::vector<foundation::uint64>     m_group_contributions;  // recorded contributions in fixed point, per bucket and per object instance
+    std::vector<float>                  m_group_cdfs;           // cumulative learned probabilities of the object instances, per bucket
+
+    size_t get_bucket_index(const foundation::Vector3d& point) const;
+
+    bool is_guided(const size_t bucket_index) const;
+
+    // Rebuild the selection probabilities from the recorded contributions.
+    void update_distributions();
+
+    float evaluate_pdf(
+        const size_t                    bucket_index,
+        const size_t                    triangle_index,
+        const foundation::Vector3d&     point) const;
+};
+
+
+//
+// LightSelectionGuide class implementation.
+//
+
+inline bool LightSelectionGuide::is_training() const
+{
+    return m_pass_number < m_params.m_training_passes;
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_LIGHTING_LIGHTSELECTIONGUIDE_H
@@ -73,6 +73,7 @@
 #include "foundation/math/vector.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/arena.h"
+#include "foundation/utility/memory.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/string.h"
 
@@ -80,12 +81,14 @@
 #include <cassert>
 #include <cmath>
 #include <string>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
 namespace foundation    { class LightingConditions; }
 
 using namespace foundation;
+using namespace std;
 
 namespace renderer
 {
@@ -122,6 +125,9 @@ namespace
             const size_t                m_max_path_length;              // maximum path length, ~0 for unlimited
             const size_t                m_rr_min_path_length;           // minimum path length before Russian Roulette kicks in, ~0 for unlimited
 
+            const bool                  m_per_thread_accumulation;      // accumulate samples into per-thread buffers?
+            const size_t                m_camera_connection_batch_size; // number of camera connections whose visibility is resolved together, 0 to disable
+
             explicit Parameters(const ParamArray& params)
               : m_sampling_mode(get_sampling_context_mode(params))
               , m_enable_ibl(params.get_optional<bool>("enable_ibl", true))
@@ -131,6 +137,8 @@ namespace
               , m_report_self_intersections(params.get_optional<bool>("report_self_intersections", false))
               , m_max_path_length(nz(params.get_optional<size_t>("max_path_length", 0)))
               , m_rr_min_path_length(nz(params.get_optional<size_t>("rr_min_path_length", 3)))
+              , m_per_thread_accumulation(params.get_optional<bool>("per_thread_accumulation", false))
+              , m_camera_connection_batch_size(params.get_optional<size_t>("camera_connection_batch_size", 0))
             {
             }
 
@@ -146,11 +154,15 @@ namespace
                     "  ibl              %s\n"
                     "  caustics         %s\n"
                     "  max path length  %s\n"
-                    "  rr min path len. %s",
+                    "  rr min path len. %s\n"
+                    "  accumulation     %s\n"
+                    "  camera conn. bt. %s",
                     m_enable_ibl ? "on" : "off",
                     m_enable_caustics ? "on" : "off",
                     m_max_path_length == size_t(~0) ? "infinite" : pretty_uint(m_max_path_length).c_str(),
-                    m_rr_min_path_length == size_t(~0) ? "infinite" : pretty_uint(m_rr_min_path_length).c_str());
+                    m_rr_min_path_length == size_t(~0) ? "infinite" : pretty_uint(m_rr_min_path_length).c_str(),
+                    m_per_thread_accumulation ? "per thread" : "shared",
+                    m_camera_connection_batch_size == 0 ? "off" : pretty_uint(m_camera_connection_batch_size).c_str());
             }
         };
 
@@ -194,6 +206,9 @@ namespace
           , m_light_sample_count(0)
           , m_path_count(0)
         {
+            if (m_params.m_camera_connection_batch_size > 0)
+                m_camera_connections.reserve(m_params.m_camera_connection_batch_size);
+
             const Scene::RenderData& scene_data = m_scene.get_render_data();
             m_scene_center = Vector3d(scene_data.m_center);
             m_scene_radius = scene_data.m_radius;
@@ -215,6 +230,7 @@ namespace
         {
             SampleGeneratorBase::reset();
             m_rng = SamplingContext::RNGType();
+            clear_keep_memory(m_camera_connections);
         }
 
         virtual void generate_samples(
@@ -226,10 +242,27 @@ namespace
 
             SampleGeneratorBase::generate_samples(sample_count, buffer, abort_switch);
 
+            // Store the samples of camera connections that are still pending
+            // so that they are normalized by the light samples of this batch.
+            clear_keep_memory(m_flushed_samples);
+            const size_t flushed_sample_count = flush_camera_connections(m_flushed_samples);
+            if (flushed_sample_count > 0)
+                store_samples(buffer, flushed_sample_count, &m_flushed_samples[0], abort_switch);
+
             static_cast<GlobalSampleAccumulationBuffer&>(buffer)
                 .increment_sample_count(m_light_sample_count);
         }
 
+        virtual void store_samples(
+            SampleAccumulationBuffer&   buffer,
+            const size_t                sample_count,
+            const Sample                samples[],
+            IAbortSwitch&               abort_switch) APPLESEED_OVERRIDE
+        {
+            static_cast<GlobalSampleAccumulationBuffer&>(buffer)
+                .store_samples(get_generator_index(), sample_count, samples, abort_switch);
+        }
+
         virtual StatisticsVector get_statistics() const APPLESEED_OVERRIDE
         {
             Statistics stats;
@@ -240,6 +273,18 @@ namespace
         }
 
       private:
+        // A connection between a light path vertex and the camera whose visibility is yet to be resolved.
+        struct CameraConnection
+        {
+            Vector3d                        m_camera_point;
+            Vector3d                        m_vertex_point;
+            ShadingRay::Time                m_time;
+            ShadingRay::DepthType           m_ray_depth;
+            Sample                          m_sample;               // sample to store if the vertex is visible
+        };
+
+        typedef vector<CameraConnection> CameraConnectionVector;
+
         struct PathVisitor
         {
             const Parameters&               m_params;
@@ -252,6 +297,7 @@ namespace
             const Spectrum                  m_initial_flux;         // initial particle flux (in W)
             SampleVector&                   m_samples;
             size_t                          m_sample_count;         // the number of samples added to m_samples
+            CameraConnectionVector*         m_camera_connections;   // if not null, camera connections are deferred
 
             PathVisitor(
                 const Parameters&           params,
@@ -260,6 +306,7 @@ namespace
                 const ShadingContext&       shading_context,
                 SamplingContext&            sampling_context,
                 SampleVector&               samples,
+                CameraConnectionVector*     camera_connections,
                 const Spectrum&             initial_flux)
               : m_params(params)
               , m_camera(*scene.get_active_camera())
@@ -269,6 +316,7 @@ namespace
               , m_sampling_context(sampling_context)
               , m_samples(samples)
               , m_sample_count(0)
+              , m_camera_connections(camera_connections)
               , m_initial_flux(initial_flux)
             {
             }
@@ -317,28 +365,22 @@ namespace
                 if (cos_alpha <= 0.0)
                     return;
 
-                // Compute the transmission factor between the light vertex and the camera.
-                // Prevent self-intersections by letting the ray originate from the camera.
-                const float transmission =
-                    m_shading_context.get_tracer().trace_between(
-                        light_sample.m_point - camera_outgoing,
-                        light_sample.m_point,
-                        time,
-                        VisibilityFlags::CameraRay,
-                        0);
-
-                // Ignore occluded vertices.
-                if (transmission == 0.0f)
-                    return;
-
                 // Adjust cos(alpha) to account for the fact that the camera outgoing direction was not unit-length.
                 const double distance = norm(camera_outgoing);
                 cos_alpha /= distance;
 
-                // Store the contribution of this vertex.
+                // Store the contribution of this vertex if it is visible from the camera.
+                // Prevent self-intersections by letting the ray originate from the camera.
                 Spectrum radiance = light_particle_flux;
-                radiance *= static_cast<float>(transmission * cos_alpha * importance);
-                emit_sample(sample_position, distance, radiance);
+                radiance *= static_cast<float>(cos_alpha * importance);
+                connect_to_camera(
+                    light_sample.m_point - camera_outgoing,
+                    light_sample.m_point,
+                    time,
+                    0,
+                    sample_position,
+                    distance,
+                    radiance);
             }
 
             void visit_non_physical_light_vertex(
@@ -359,23 +401,17 @@ namespace
                         importance))
                     return;
 
-                // Compute the transmission factor between the light vertex and the camera.
-                const float transmission =
-                    m_shading_context.get_tracer().trace_between(
-                        light_vertex - camera_outgoing,
-                        light_vertex,
-                        time,
-                        VisibilityFlags::CameraRay,
-                        0);
-
-                // Ignore occluded vertices.
-                if (transmission == 0.0f)
-                    return;
-
-                // Store the contribution of this vertex.
+                // Store the contribution of this vertex if it is visible from the camera.
                 Spectrum radiance = light_particle_flux;
-                radiance *= transmission * importance;
-                emit_sample(sample_position, norm(camera_outgoing), radiance);
+                radiance *= importance;
+                connect_to_camera(
+                    light_vertex - camera_outgoing,
+                    light_vertex,
+                    time,
+                    0,
+                    sample_position,
+                    norm(camera_outgoing),
+                    radiance);
             }
 
             void visit_vertex(const PathVertex& vertex)
@@ -402,19 +438,27 @@ namespace
                 if (dot(camera_outgoing, shading_normal) >= 0.0)
                     return;
 
-                // Compute the transmission factor between the path vertex and the camera.
-                // Prevent self-intersections by letting the ray originate from the camera.
-                const float transmission =
-                    m_shading_context.get_tracer().trace_between(
-                        vertex.get_point() - camera_outgoing,
-                        vertex.get_point(),
-                        vertex.get_time(),
-                        VisibilityFlags::CameraRay,
-                        static_cast<ShadingRay::DepthType>(vertex.m_path_length));  // ray depth = (path length - 1) + 1
-
-                // Ignore occluded vertices.
-                if (transmission == 0.0f)
-                    return;
+                // Compute the transmission factor between the path vertex and the camera
+                // now, unless camera connections are deferred. Prevent self-intersections
+                // by letting the ray originate from the camera.
+                const Vector3d camera_point = vertex.get_point() - camera_outgoing;
+                const ShadingRay::DepthType camera_ray_depth =
+                    static_cast<ShadingRay::DepthType>(vertex.m_path_length);   // ray depth = (path length - 1) + 1
+                float transmission = 1.0f;
+                if (m_camera_connections == 0)
+                {
+                    transmission =
+                        m_shading_context.get_tracer().trace_between(
+                            camera_point,
+                            vertex.get_point(),
+                            vertex.get_time(),
+                            VisibilityFlags::CameraRay,
+                            camera_ray_depth);
+
+                    // Ignore occluded vertices.
+                    if (transmission == 0.0f)
+                        return;
+                }
 
                 // Normalize the camera outgoing direction.
                 const double distance = norm(camera_outgoing);
@@ -447,7 +491,19 @@ namespace
                 radiance *= vertex.m_throughput;
                 radiance *= bsdf_value;
                 radiance *= transmission * importance;
-                emit_sample(sample_position, distance, radiance);
+
+                if (m_camera_connections)
+                {
+                    defer_camera_connection(
+                        camera_point,
+                        vertex.get_point(),
+                        vertex.get_time(),
+                        camera_ray_depth,
+                        sample_position,
+                        distance,
+                        radiance);
+                }
+                else emit_sample(sample_position, distance, radiance);
             }
 
             void visit_environment(const PathVertex& vertex)
@@ -455,31 +511,100 @@ namespace
                 // The particle escapes.
             }
 
+            void connect_to_camera(
+                const Vector3d&             camera_point,
+                const Vector3d&             vertex_point,
+                const ShadingRay::Time&     time,
+                const ShadingRay::DepthType ray_depth,
+                const Vector2d&             position_ndc,
+                const double                distance,
+                Spectrum&                   radiance)
+            {
+                if (m_camera_connections)
+                {
+                    defer_camera_connection(
+                        camera_point,
+                        vertex_point,
+                        time,
+                        ray_depth,
+                        position_ndc,
+                        distance,
+                        radiance);
+                    return;
+                }
+
+                // Compute the transmission factor between the vertex and the camera.
+                const float transmission =
+                    m_shading_context.get_tracer().trace_between(
+                        camera_point,
+                        vertex_point,
+                        time,
+                        VisibilityFlags::CameraRay,
+                        ray_depth);
+
+                // Ignore occluded vertices.
+                if (transmission == 0.0f)
+                    return;
+
+                radiance *= transmission;
+                emit_sample(position_ndc, distance, radiance);
+            }
+
+            void defer_camera_connection(
+                const Vector3d&             camera_point,
+                const Vector3d&             vertex_point,
+                const ShadingRay::Time&     time,
+                const ShadingRay::DepthType ray_depth,
+                const Vector2d&             position_ndc,
+                const double                distance,
+                const Spectrum&             radiance)
+            {
+                CameraConnection connection;
+                connection.m_camera_point = camera_point;
+                connection.m_vertex_point = vertex_point;
+                connection.m_time = time;
+                connection.m_ray_depth = ray_depth;
+                connection.m_sample =
+                    make_sample(m_lighting_conditions, position_ndc, distance, radiance);
+                m_camera_connections->push_back(connection);
+            }
+
             void emit_sample(
                 const Vector2d&             position_ndc,
                 const double                distance,
                 const Spectrum&             radiance)
             {
-                assert(min_value(radiance) >= 0.0f);
-
-                const Color3f linear_rgb =
-                    radiance.is_rgb()
-                        ? radiance.rgb()
-                        : radiance.convert_to_rgb(m_lighting_conditions);
-
-                Sample sample;
-                sample.m_position = Vector2f(position_ndc);
-                sample.m_values[0] = linear_rgb.r;
-                sample.m_values[1] = linear_rgb.g;
-                sample.m_values[2] = linear_rgb.b;
-                sample.m_values[3] = 1.0f;
-                sample.m_values[4] = static_cast<float>(distance);
-                m_samples.push_back(sample);
+                m_samples.push_back(
+                    make_sample(m_lighting_conditions, position_ndc, distance, radiance));
 
                 ++m_sample_count;
             }
         };
 
+        static Sample make_sample(
+            const LightingConditions&   lighting_conditions,
+            const Vector2d&             position_ndc,
+            const double                distance,
+            const Spectrum&             radiance)
+        {
+            assert(min_value(radiance) >= 0.0f);
+
+            const Color3f linear_rgb =
+                radiance.is_rgb()
+                    ? radiance.rgb()
+                    : radiance.convert_to_rgb(lighting_conditions);
+
+            Sample sample;
+            sample.m_position = Vector2f(position_ndc);
+            sample.m_values[0] = linear_rgb.r;
+            sample.m_values[1] = linear_rgb.g;
+            sample.m_values[2] = linear_rgb.b;
+            sample.m_values[3] = 1.0f;
+            sample.m_values[4] = static_cast<float>(distance);
+
+            return sample;
+        }
+
         typedef PathTracer<PathVisitor, true> PathTracerType;   // true = adjoint
 
         const Parameters                m_params;
@@ -511,6 +636,73 @@ namespace
         float                           m_shutter_open_time;
         float                           m_shutter_close_time;
 
+        // Deferred camera connections and storage to resolve them.
+        CameraConnectionVector          m_camera_connections;
+        vector<Vector3d>                m_camera_points;
+        vector<Vector3d>                m_vertex_points;
+        vector<ShadingRay::Time>        m_camera_ray_times;
+        vector<ShadingRay::DepthType>   m_camera_ray_depths;
+        vector<float>                   m_camera_transmissions;
+        SampleVector                    m_flushed_samples;
+
+        CameraConnectionVector* get_camera_connections()
+        {
+            return m_params.m_camera_connection_batch_size > 0 ? &m_camera_connections : 0;
+        }
+
+        // Resolve the visibility of all deferred camera connections at once and
+        // store the samples of the visible ones. Return the number of samples stored.
+        size_t flush_camera_connections(SampleVector& samples)
+        {
+            const size_t count = m_camera_connections.size();
+            if (count == 0)
+                return 0;
+
+            m_camera_points.resize(count);
+            m_vertex_points.resize(count);
+            m_camera_ray_times.resize(count);
+            m_camera_ray_depths.resize(count);
+            m_camera_transmissions.resize(count);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const CameraConnection& connection = m_camera_connections[i];
+                m_camera_points[i] = connection.m_camera_point;
+                m_vertex_points[i] = connection.m_vertex_point;
+                m_camera_ray_times[i] = connection.m_time;
+                m_camera_ray_depths[i] = connection.m_ray_depth;
+            }
+
+            m_tracer.trace_between(
+                &m_camera_points[0],
+                &m_vertex_points[0],
+                &m_camera_ray_times[0],
+                &m_camera_ray_depths[0],
+                count,
+                VisibilityFlags::CameraRay,
+                &m_camera_transmissions[0]);
+
+            size_t stored_sample_count = 0;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const float transmission = m_camera_transmissions[i];
+                if (transmission == 0.0f)
+                    continue;
+
+                Sample sample = m_camera_connections[i].m_sample;
+                for (size_t c = 0; c < 3; ++c)
+                    sample.m_values[c] *= transmission;
+                samples.push_back(sample);
+
+                ++stored_sample_count;
+            }
+
+            clear_keep_memory(m_camera_connections);
+
+            return stored_sample_count;
+        }
+
         virtual size_t generate_samples(
             const size_t                sequence_index,
             SampleVector&               samples) APPLESEED_OVERRIDE
@@ -542,6 +734,11 @@ namespace
 
             ++m_light_sample_count;
 
+            // Resolve deferred camera connections once enough of them have accumulated.
+            if (m_params.m_camera_connection_batch_size > 0 &&
+                m_camera_connections.size() >= m_params.m_camera_connection_batch_size)
+                stored_sample_count += flush_camera_connections(samples);
+
             return stored_sample_count;
         }
 
@@ -645,6 +842,7 @@ namespace
                 m_shading_context,
                 sampling_context,
                 samples,
+                get_camera_connections(),
                 initial_flux);
             PathTracerType path_tracer(
                 path_visitor,
@@ -722,6 +920,7 @@ namespace
                 m_shading_context,
                 sampling_context,
                 samples,
+                get_camera_connections(),
                 initial_flux);
             PathTracerType path_tracer(
                 path_visitor,
@@ -809,6 +1008,7 @@ namespace
                 m_shading_context,
                 sampling_context,
                 samples,
+                get_camera_connections(),
                 initial_flux);
             PathTracerType path_tracer(
                 path_visitor,
@@ -886,11 +1086,18 @@ SampleAccumulationBuffer* LightTracingSampleGeneratorFactory::create_sample_accu
 {
     const CanvasProperties& props = m_frame.image().properties();
 
+    // When enabled, use one sample buffer per rendering thread to avoid contention.
+    const size_t thread_buffer_count =
+        LightTracingSampleGenerator::Parameters(m_params).m_per_thread_accumulation
+            ? get_rendering_thread_count(m_params)
+            : 0;
+
     return
         new GlobalSampleAccumulationBuffer(
             props.m_canvas_width,
             props.m_canvas_height,
-            m_frame.get_filter());
+            m_frame.get_filter(),
+            thread_buffer_count);
 }
 
 }   // namespace renderer
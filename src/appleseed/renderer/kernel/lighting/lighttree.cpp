@@ -0,0 +1,343 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "lighttree.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/fp.h"
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    // The largest float smaller than 1.
+    const float OneMinusEpsilon = shift(1.0f, -1);
+
+    // Maximum depth of the tree; the median split keeps it close to log2(item count).
+    const size_t MaxDepth = 64;
+
+    // Smallest squared distance between a point and an emitter.
+    const double MinSquareDistance = 1.0e-12;
+
+    // Order items by the coordinate of their bounding box center along a given dimension.
+    class CentroidOrder
+    {
+      public:
+        CentroidOrder(
+            const vector<LightTree::Item>&  items,
+            const size_t                    dim)
+          : m_items(items)
+          , m_dim(dim)
+        {
+        }
+
+        bool operator()(const size_t lhs, const size_t rhs) const
+        {
+            return m_items[lhs].m_bbox.center(m_dim) < m_items[rhs].m_bbox.center(m_dim);
+        }
+
+      private:
+        const vector<LightTree::Item>&      m_items;
+        const size_t                        m_dim;
+    };
+
+    // Compute the smallest cone (approximately) containing two given cones.
+    void merge_cones(
+        const Vector3d&                     axis_a,
+        const double                        cos_theta_a,
+        const Vector3d&                     axis_b,
+        const double                        cos_theta_b,
+        Vector3d&                           axis,
+        double&                             cos_theta)
+    {
+        // Default to the whole sphere of directions.
+        axis = axis_a;
+        cos_theta = -1.0;
+
+        if (cos_theta_a <= -1.0 || cos_theta_b <= -1.0)
+            return;
+
+        const double theta_a = acos(clamp(cos_theta_a, -1.0, 1.0));
+        const double theta_b = acos(clamp(cos_theta_b, -1.0, 1.0));
+        const double theta_d = acos(clamp(dot(axis_a, axis_b), -1.0, 1.0));
+
+        // Check whether one cone contains the other.
+        if (min(theta_d + theta_b, Pi<double>()) <= theta_a)
+        {
+            cos_theta = cos_theta_a;
+            return;
+        }
+        if (min(theta_d + theta_a, Pi<double>()) <= theta_b)
+        {
+            axis = axis_b;
+            cos_theta = cos_theta_b;
+            return;
+        }
+
+        const double theta_o = 0.5 * (theta_a + theta_d + theta_b);
+        if (theta_o >= Pi<double>())
+            return;
+
+        const Vector3d rotation_axis = cross(axis_a, axis_b);
+        const double rotation_axis_norm = norm(rotation_axis);
+        if (rotation_axis_norm == 0.0)
+            return;
+
+        // Rotate the axis of the first cone toward the axis of the second one.
+        const double theta_r = theta_o - theta_a;
+        const Vector3d k = rotation_axis / rotation_axis_norm;
+        axis = normalize(cos(theta_r) * axis_a + sin(theta_r) * cross(k, axis_a));
+        cos_theta = cos(theta_o);
+    }
+
+    // Estimate the contribution of a set of emitters to a given point.
+    template <typename Bounds>
+    double compute_importance(
+        const Bounds&                       bounds,
+        const Vector3d&                     point)
+    {
+        const Vector3d d = point - bounds.m_bbox.center();
+        const double dist2 = square_norm(d);
+        const double radius2 = square(bounds.m_bbox.radius());
+
+        // Bound the angle between the emission directions and the direction to the point.
+        // When the point is inside the bounding sphere, any direction is possible.
+        double cos_theta_p = 1.0;
+        if (bounds.m_cos_theta_o > -1.0 && dist2 > radius2)
+        {
+            const double dist = sqrt(dist2);
+            const double cos_theta_w = dot(bounds.m_axis, d) / dist;
+            const double sin_theta_w = sqrt(max(1.0 - square(cos_theta_w), 0.0));
+            const double cos_theta_o = bounds.m_cos_theta_o;
+            const double sin_theta_o = sqrt(max(1.0 - square(cos_theta_o), 0.0));
+
+            // theta_x = max(theta_w - theta_o, 0).
+            double cos_theta_x = 1.0, sin_theta_x = 0.0;
+            if (cos_theta_w < cos_theta_o)
+            {
+                cos_theta_x = cos_theta_w * cos_theta_o + sin_theta_w * sin_theta_o;
+                sin_theta_x = sin_theta_w * cos_theta_o - cos_theta_w * sin_theta_o;
+            }
+
+            // Half-angle subtended by the bounding sphere.
+            const double sin2_theta_b = radius2 / dist2;
+            const double sin_theta_b = sqrt(sin2_theta_b);
+            const double cos_theta_b = sqrt(max(1.0 - sin2_theta_b, 0.0));
+
+            // theta_p = max(theta_x - theta_b, 0).
+            if (cos_theta_x < cos_theta_b)
+                cos_theta_p = cos_theta_x * cos_theta_b + sin_theta_x * sin_theta_b;
+
+            // Emitters don't emit light beyond 90 degrees from their normals.
+            if (cos_theta_p <= 0.0)
+                return 0.0;
+        }
+
+        // Clamp the distance to avoid the singularity at point emitters.
+        return bounds.m_power * cos_theta_p / max(dist2, max(radius2, MinSquareDistance));
+    }
+}
+
+void LightTree::build(const vector<Item>& items)
+{
+    m_nodes.clear();
+    m_item_leaves.clear();
+
+    if (items.empty())
+        return;
+
+    vector<size_t> indices(items.size());
+    for (size_t i = 0, e = items.size(); i < e; ++i)
+        indices[i] = i;
+
+    m_nodes.resize(2 * items.size() - 1);
+    m_item_leaves.resize(items.size());
+    m_nodes[0].m_parent = ~size_t(0);
+
+    size_t node_count = 1;
+    build(items, indices, 0, items.size(), 0, node_count);
+    assert(node_count == m_nodes.size());
+}
+
+void LightTree::build(
+    const vector<Item>&                 items,
+    vector<size_t>&                     indices,
+    const size_t                        begin,
+    const size_t                        end,
+    const size_t                        node_index,
+    size_t&                             node_count)
+{
+    assert(end > begin);
+
+    // Create a leaf for a single item.
+    if (end - begin == 1)
+    {
+        const size_t item_index = indices[begin];
+        const Item& item = items[item_index];
+
+        Node& node = m_nodes[node_index];
+        node.m_bbox = item.m_bbox;
+        node.m_axis = item.m_axis;
+        node.m_cos_theta_o = item.m_cos_theta_o;
+        node.m_power = item.m_power;
+        node.m_index = item_index;
+        node.m_leaf = true;
+
+        m_item_leaves[item_index] = node_index;
+        return;
+    }
+
+    // Split the items at the median of their centers along the dimension of largest extent.
+    AABB3d centroid_bbox(AABB3d::invalid());
+    for (size_t i = begin; i < end; ++i)
+        centroid_bbox.insert(items[indices[i]].m_bbox.center());
+    const size_t split_dim = max_index(centroid_bbox.extent());
+    const size_t mid = (begin + end) / 2;
+    nth_element(
+        indices.begin() + begin,
+        indices.begin() + mid,
+        indices.begin() + end,
+        CentroidOrder(items, split_dim));
+
+    // Build the children.
+    const size_t left_index = node_count;
+    node_count += 2;
+    m_nodes[left_index].m_parent = node_index;
+    m_nodes[left_index + 1].m_parent = node_index;
+    build(items, indices, begin, mid, left_index, node_count);
+    build(items, indices, mid, end, left_index + 1, node_count);
+
+    // Bound the children.
+    const Node& left = m_nodes[left_index];
+    const Node& right = m_nodes[left_index + 1];
+    Node& node = m_nodes[node_index];
+    node.m_bbox = left.m_bbox;
+    node.m_bbox.insert(right.m_bbox);
+    merge_cones(
+        left.m_axis,
+        left.m_cos_theta_o,
+        right.m_axis,
+        right.m_cos_theta_o,
+        node.m_axis,
+        node.m_cos_theta_o);
+    node.m_power = left.m_power + right.m_power;
+    node.m_index = left_index;
+    node.m_leaf = false;
+}
+
+size_t LightTree::sample(
+    const Vector3d&                     point,
+    const float                         s,
+    float&                              probability) const
+{
+    assert(!m_nodes.empty());
+
+    size_t node_index = 0;
+    float u = s;
+    probability = 1.0f;
+
+    while (!m_nodes[node_index].m_leaf)
+    {
+        const Node& node = m_nodes[node_index];
+        const float left_prob = compute_left_child_probability(node, point);
+
+        if (u < left_prob)
+        {
+            u /= left_prob;
+            probability *= left_prob;
+            node_index = node.m_index;
+        }
+        else
+        {
+            const float right_prob = 1.0f - left_prob;
+            u = (u - left_prob) / right_prob;
+            probability *= right_prob;
+            node_index = node.m_index + 1;
+        }
+
+        u = min(u, OneMinusEpsilon);
+    }
+
+    return m_nodes[node_index].m_index;
+}
+
+float LightTree::evaluate_pdf(
+    const Vector3d&                     point,
+    const size_t                        item_index) const
+{
+    assert(item_index < m_item_leaves.size());
+
+    // Find the path from the root to the leaf of the item.
+    size_t path[MaxDepth];
+    size_t depth = 0;
+    for (size_t i = m_item_leaves[item_index]; m_nodes[i].m_parent != ~size_t(0); i = m_nodes[i].m_parent)
+    {
+        assert(depth < MaxDepth);
+        path[depth++] = i;
+    }
+
+    // Accumulate the probabilities of the choices made by sample(), in the same order.
+    float probability = 1.0f;
+    size_t node_index = 0;
+    while (depth > 0)
+    {
+        const Node& node = m_nodes[node_index];
+        const size_t child_index = path[--depth];
+        const float left_prob = compute_left_child_probability(node, point);
+        probability *= child_index == node.m_index ? left_prob : 1.0f - left_prob;
+        node_index = child_index;
+    }
+
+    return probability;
+}
+
+float LightTree::compute_left_child_probability(
+    const Node&                         node,
+    const Vector3d&                     point) const
+{
+    assert(!node.m_leaf);
+
+    const double left = compute_importance(m_nodes[node.m_index], point);
+    const double right = compute_importance(m_nodes[node.m_index + 1], point);
+    const double total = left + right;
+
+    // Split evenly when the bounds tell nothing about the children.
+    return total > 0.0 ? static_cast<float>(left / total) : 0.5f;
+}
+
+}   // namespace renderer
@@ -0,0 +1,139 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_RENDERER_KERNEL_LIGHTING_LIGHTTREE_H
+#define APPLESEED_RENDERER_KERNEL_LIGHTING_LIGHTTREE_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A bounding volume hierarchy over light emitters, allowing to choose an emitter
+// according to an estimate of its contribution to a given point.
+//
+// Every node stores the bounding box, the total power and a cone bounding the
+// emission directions of the emitters below it. Traversal picks a child with a
+// probability proportional to its importance as seen from the point; the product
+// of these probabilities is the probability of the chosen emitter.
+//
+// Reference:
+//
+//   Importance Sampling of Many Lights with Adaptive Tree Splitting
+//   Alejandro Conty Estevez, Christopher Kulla
+//   http://www.aconty.com/pdf/many-lights-hpg2018.pdf
+//
+
+class LightTree
+  : public foundation::NonCopyable
+{
+  public:
+    // An emitter, as seen by the light tree.
+    struct Item
+    {
+        foundation::AABB3d      m_bbox;                 // world space bounding box
+        foundation::Vector3d    m_axis;                 // axis of the cone bounding the emission normals, unit-length
+        double                  m_cos_theta_o;          // cosine of the half-angle of this cone, -1 for omnidirectional emitters
+        float                   m_power;                // estimated emitted power
+    };
+
+    // Build the tree. Item indices are preserved.
+    void build(const std::vector<Item>& items);
+
+    // Return true if the tree contains no item.
+    bool empty() const;
+
+    // Return the number of nodes in the tree.
+    size_t get_node_count() const;
+
+    // Choose an item given a world space point and a uniform sample in [0, 1).
+    // Return the index of the item and its probability.
+    size_t sample(
+        const foundation::Vector3d&     point,
+        const float                     s,
+        float&                          probability) const;
+
+    // Return the probability that sample() chooses a given item from a given point.
+    float evaluate_pdf(
+        const foundation::Vector3d&     point,
+        const size_t                    item_index) const;
+
+  private:
+    struct Node
+    {
+        foundation::AABB3d      m_bbox;
+        foundation::Vector3d    m_axis;
+        double                  m_cos_theta_o;
+        float                   m_power;
+        size_t                  m_parent;               // index of the parent node, ~0 for the root
+        size_t                  m_index;                // index of the left child (the right one follows it), or of the item for leaves
+        bool                    m_leaf;
+    };
+
+    std::vector<Node>           m_nodes;
+    std::vector<size_t>         m_item_leaves;          // index of the leaf node of each item
+
+    void build(
+        const std::vector<Item>&        items,
+        std::vector<size_t>&            indices,
+        const size_t                    begin,
+        const size_t                    end,
+        const size_t                    node_index,
+        size_t&                         node_count);
+
+    // Return the probability of choosing the left child of a given interior node.
+    float compute_left_child_probability(
+        const Node&                     node,
+        const foundation::Vector3d&     point) const;
+};
+
+
+//
+// LightTree class implementation.
+//
+
+inline bool LightTree::empty() const
+{
+    return m_nodes.empty();
+}
+
+inline size_t LightTree::get_node_count() const
+{
+    return m_nodes.size();
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_LIGHTING_LIGHTTREE_H
@@ -0,0 +1,414 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "pathguide.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/kernel/lighting/pathvertex.h"
+#include "renderer/kernel/lighting/scatteringmode.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/modeling/bsdf/bsdf.h"
+#include "renderer/modeling/bsdf/bsdfsample.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/fixedpoint.h"
+#include "foundation/math/mis.h"
+#include "foundation/math/scalar.h"
+#include "foundation/platform/atomic.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    // Fraction of the sampling distributions spread uniformly over the sphere,
+    // to remain robust to directions that were not sampled during training.
+    const float UniformFraction = 0.1f;
+}
+
+
+//
+// PathGuide class implementation.
+//
+
+PathGuide::PathGuide(
+    const Scene&            scene,
+    const ParamArray&       params)
+  : m_params(params)
+  , m_bbox(scene.compute_bbox())
+  , m_pass_number(0)
+  , m_guided_cell_count(0)
+{
+    // Compute the scale from world space to grid space, leaving flat dimensions with a single cell.
+    const Vector3d extent = m_bbox.extent();
+    for (size_t i = 0; i < 3; ++i)
+        m_cell_scale[i] = extent[i] > 0.0 ? m_params.m_spatial_resolution / extent[i] : 0.0;
+
+    const size_t cell_count =
+        m_params.m_spatial_resolution * m_params.m_spatial_resolution * m_params.m_spatial_resolution;
+
+    m_radiance.assign(cell_count * BinCount, 0);
+    m_bin_probs.assign(cell_count * BinCount, 0.0f);
+    m_bin_cdfs.assign(cell_count * BinCount, 0.0f);
+
+    RENDERER_LOG_INFO(
+        "path guiding: %s training %s, %s spatial cells, %s directional bins per cell.",
+        pretty_uint(m_params.m_training_passes).c_str(),
+        plural(m_params.m_training_passes, "pass", "passes").c_str(),
+        pretty_uint(cell_count).c_str(),
+        pretty_uint(BinCount).c_str());
+}
+
+void PathGuide::release()
+{
+    delete this;
+}
+
+void PathGuide::pre_render(
+    const Frame&            frame,
+    JobQueue&               job_queue,
+    IAbortSwitch&           abort_switch)
+{
+}
+
+bool PathGuide::post_render(
+    const Frame&            frame,
+    JobQueue&               job_queue,
+    IAbortSwitch&           abort_switch)
+{
+    // Rebuild the sampling distributions after each training pass.
+    if (is_training())
+    {
+        update_distributions();
+
+        RENDERER_LOG_INFO(
+            "path guiding: pass %s recorded radiance in %s of %s cells.",
+            pretty_uint(m_pass_number + 1).c_str(),
+            pretty_uint(m_guided_cell_count).c_str(),
+            pretty_uint(m_radiance.size() / BinCount).c_str());
+    }
+
+    ++m_pass_number;
+
+    return false;
+}
+
+void PathGuide::record(
+    const Vector3d&         point,
+    const Vector3f&         incoming,
+    const float             radiance)
+{
+    assert(radiance >= 0.0f);
+
+    if (radiance == 0.0f || !FP<float>::is_finite(radiance))
+        return;
+
+    const size_t index = get_cell_index(point) * BinCount + get_bin_index(incoming);
+    atomic_add(&m_radiance[index], float_to_fixed_point(radiance));
+}
+
+void PathGuide::sample(
+    SamplingContext&        sampling_context,
+    const BSDF&             bsdf,
+    const void*             bsdf_data,
+    const bool              adjoint,
+    BSDFSample&             sample) const
+{
+    // Only sample the BSDF when there is nothing to guide.
+    const size_t cell_index = get_cell_index(sample.m_shading_point->get_point());
+    if (m_bin_cdfs[cell_index * BinCount + BinCount - 1] == 0.0f || bsdf.is_purely_specular())
+    {
+        bsdf.sample(sampling_context, bsdf_data, adjoint, true, sample);
+        return;
+    }
+
+    // Choose between BSDF sampling and guided sampling.
+    sampling_context.split_in_place(1, 1);
+    const float s = sampling_context.next2<float>();
+    const float bsdf_fraction = m_params.m_bsdf_sampling_fraction;
+    const bool guided = s >= bsdf_fraction;
+
+    if (!guided)
+    {
+        bsdf.sample(sampling_context, bsdf_data, adjoint, true, sample);
+
+        if (sample.m_mode == ScatteringMode::Absorption)
+            return;
+
+        // Specular directions can only be chosen by BSDF sampling.
+        if (sample.m_probability == BSDF::DiracDelta)
+        {
+            sample.m_value /= bsdf_fraction;
+            return;
+        }
+    }
+    else
+    {
+        // Choose a bin.
+        const float* cdf = &m_bin_cdfs[cell_index * BinCount];
+        sampling_context.split_in_place(3, 1);
+        const Vector3f t = sampling_context.next2<Vector3f>();
+        const size_t bin = min<size_t>(upper_bound(cdf, cdf + BinCount, t[0]) - cdf, BinCount - 1);
+
+        // Uniformly sample a direction in this bin.
+        const size_t iu = bin / DirectionalResolution;
+        const size_t iv = bin % DirectionalResolution;
+        const float cos_theta = 2.0f * (iu + t[1]) / DirectionalResolution - 1.0f;
+        const float sin_theta = sqrt(max(1.0f - cos_theta * cos_theta, 0.0f));
+        const float phi = TwoPi<float>() * (iv + t[2]) / DirectionalResolution - Pi<float>();
+
+        sample.m_incoming = Dual3f(Vector3f(sin_theta * cos(phi), cos_theta, sin_theta * sin(phi)));
+        sample.m_mode =
+            ScatteringMode::has_diffuse(bsdf.get_modes())
+                ? ScatteringMode::Diffuse
+                : ScatteringMode::Glossy;
+    }
+
+    // Evaluate the BSDF in the chosen direction.
+    const float bsdf_prob =
+        bsdf.evaluate(
+            bsdf_data,
+            adjoint,
+            true,
+            sample.m_geometric_normal,
+            sample.m_shading_basis,
+            sample.m_outgoing.get_value(),
+            sample.m_incoming.get_value(),
+            ScatteringMode::All,
+            sample.m_value);
+
+    if (bsdf_prob == 0.0f)
+    {
+        sample.m_mode = ScatteringMode::Absorption;
+        return;
+    }
+
+    // Combine both techniques with one-sample MIS and the balance heuristic. The reported
+    // probability is the one of the BSDF alone, so that the MIS weights computed by other
+    // techniques against the BSDF still sum to one; the value is scaled accordingly.
+    const float guide_prob = evaluate_pdf(cell_index, sample.m_incoming.get_value());
+    const float q_bsdf = bsdf_fraction * bsdf_prob;
+    const float q_guide = (1.0f - bsdf_fraction) * guide_prob;
+    sample.m_value *=
+        guided
+            ? mis_balance(q_guide, q_bsdf) * bsdf_prob / q_guide
+            : mis_balance(q_bsdf, q_guide) / bsdf_fraction;
+    sample.m_probability = bsdf_prob;
+}
+
+void PathGuide::add_params_metadata(Dictionary& metadata)
+{
+    metadata.dictionaries().insert(
+        "enable_path_guiding",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Enable Path Guiding")
+            .insert("help", "Learn the distribution of incident light during the first passes and use it to guide scattering directions"));
+
+    metadata.dictionaries().insert(
+        "path_guiding_training_passes",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "4")
+            .insert("min", "1")
+            .insert("label", "Path Guiding Training Passes")
+            .insert("help", "Number of passes during which the incident light distribution is learned"));
+
+    metadata.dictionaries().insert(
+        "path_guiding_spatial_resolution",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "16")
+            .insert("min", "1")
+            .insert("label", "Path Guiding Spatial Resolution")
+            .insert("help", "Number of cells along each dimension of the scene bounds"));
+
+    metadata.dictionaries().insert(
+        "path_guiding_bsdf_fraction",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.5")
+            .insert("min", "0.0")
+            .insert("max", "1.0")
+            .insert("label", "Path Guiding BSDF Fraction")
+            .insert("help", "Probability of sampling the BSDF instead of the learned distribution"));
+}
+
+size_t PathGuide::get_cell_index(const Vector3d& point) const
+{
+    const size_t res = m_params.m_spatial_resolution;
+
+    size_t index = 0;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const double x = (point[i] - m_bbox.min[i]) * m_cell_scale[i];
+        const size_t c = x > 0.0 ? min(static_cast<size_t>(x), res - 1) : 0;
+        index = index * res + c;
+    }
+
+    return index;
+}
+
+size_t PathGuide::get_bin_index(const Vector3f& direction)
+{
+    const float u = 0.5f * (direction[1] + 1.0f);
+    const float v = (atan2(direction[2], direction[0]) + Pi<float>()) * RcpTwoPi<float>();
+
+    const size_t iu = min(truncate<size_t>(max(u, 0.0f) * DirectionalResolution), size_t(DirectionalResolution - 1));
+    const size_t iv = min(truncate<size_t>(max(v, 0.0f) * DirectionalResolution), size_t(DirectionalResolution - 1));
+
+    return iu * DirectionalResolution + iv;
+}
+
+void PathGuide::update_distributions()
+{
+    const size_t cell_count = m_radiance.size() / BinCount;
+    m_guided_cell_count = 0;
+
+    for (size_t cell = 0; cell < cell_count; ++cell)
+    {
+        const uint64* radiance = &m_radiance[cell * BinCount];
+        float* probs = &m_bin_probs[cell * BinCount];
+        float* cdf = &m_bin_cdfs[cell * BinCount];
+
+        uint64 total = 0;
+        for (size_t i = 0; i < BinCount; ++i)
+            total += radiance[i];
+
+        // Leave cells without recorded radiance unguided.
+        if (total == 0)
+        {
+            fill(probs, probs + BinCount, 0.0f);
+            fill(cdf, cdf + BinCount, 0.0f);
+            continue;
+        }
+
+        float sum = 0.0f;
+        for (size_t i = 0; i < BinCount; ++i)
+        {
+            probs[i] =
+                  (1.0f - UniformFraction) * static_cast<float>(static_cast<double>(radiance[i]) / total)
+                + UniformFraction / BinCount;
+            sum += probs[i];
+            cdf[i] = sum;
+        }
+
+        // Make the distribution sum to exactly one.
+        for (size_t i = 0; i < BinCount; ++i)
+        {
+            probs[i] /= sum;
+            cdf[i] /= sum;
+        }
+        cdf[BinCount - 1] = 1.0f;
+
+        ++m_guided_cell_count;
+    }
+}
+
+float PathGuide::evaluate_pdf(
+    const size_t            cell_index,
+    const Vector3f&         direction) const
+{
+    // Bins have equal solid angles.
+    const float bin_prob = m_bin_probs[cell_index * BinCount + get_bin_index(direction)];
+    return bin_prob * (BinCount * RcpFourPi<float>());
+}
+
+PathGuide::Parameters::Parameters(const ParamArray& params)
+  : m_training_passes(params.get_optional<size_t>("path_guiding_training_passes", 4))
+  , m_spatial_resolution(max<size_t>(params.get_optional<size_t>("path_guiding_spatial_resolution", 16), 1))
+  , m_bsdf_sampling_fraction(saturate(params.get_optional<float>("path_guiding_bsdf_fraction", 0.5f)))
+{
+}
+
+
+//
+// PathGuideRecorder class implementation.
+//
+
+PathGuideRecorder::PathGuideRecorder(PathGuide& path_guide)
+  : m_path_guide(path_guide)
+  , m_vertex_count(0)
+{
+}
+
+void PathGuideRecorder::add_vertex(
+    const PathVertex&       vertex,
+    const Spectrum&         radiance)
+{
+    if (m_vertex_count == MaxVertexCount)
+        return;
+
+    Vertex& v = m_vertices[m_vertex_count++];
+    v.m_hit = vertex.m_shading_point->hit();
+    if (v.m_hit)
+        v.m_point = vertex.get_point();
+    v.m_incoming = Vector3f(vertex.get_ray().m_dir);
+    v.m_throughput = average_value(vertex.m_throughput);
+    v.m_prev_prob =
+        vertex.m_prev_mode == ScatteringMode::Specular || vertex.m_prev_prob == BSDF::DiracDelta
+            ? 0.0f
+            : vertex.m_prev_prob;
+    v.m_radiance = average_value(radiance);
+}
+
+void PathGuideRecorder::flush()
+{
+    // Accumulate the radiance contributed by the vertices past each vertex and convert
+    // it to the radiance incident at the previous vertex.
+    float radiance = 0.0f;
+
+    for (size_t i = m_vertex_count; i-- > 1; )
+    {
+        const Vertex& v = m_vertices[i];
+        radiance += v.m_radiance;
+
+        const Vertex& prev = m_vertices[i - 1];
+        if (prev.m_hit && v.m_throughput > 0.0f && v.m_prev_prob > 0.0f)
+            m_path_guide.record(prev.m_point, v.m_incoming, radiance / (v.m_throughput * v.m_prev_prob));
+    }
+
+    m_vertex_count = 0;
+}
+
+}   // namespace renderer
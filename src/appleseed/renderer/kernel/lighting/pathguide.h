@@ -0,0 +1,214 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_RENDERER_KERNEL_LIGHTING_PATHGUIDE_H
+#define APPLESEED_RENDERER_KERNEL_LIGHTING_PATHGUIDE_H
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/rendering/ipasscallback.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class Dictionary; }
+namespace foundation    { class IAbortSwitch; }
+namespace foundation    { class JobQueue; }
+namespace renderer      { class BSDF; }
+namespace renderer      { class BSDFSample; }
+namespace renderer      { class Frame; }
+namespace renderer      { class ParamArray; }
+namespace renderer      { class PathVertex; }
+namespace renderer      { class Scene; }
+
+namespace renderer
+{
+
+//
+// A spatial-directional distribution of incident radiance, learned from the paths traced
+// during the first passes and used to guide the scattering directions of subsequent paths.
+//
+// Space is divided into a regular grid over the scene bounds. Each cell holds a histogram
+// of incident radiance over the sphere of directions, using an equal-area cylindrical
+// mapping. Paths record their radiance estimates into the histograms with atomic additions
+// while the sampling distributions are only rebuilt between passes, so that they never
+// change while a pass is being rendered. Histograms are accumulated in fixed point so that
+// they don't depend on the order in which rendering threads record their estimates.
+//
+// Reference:
+//
+//   Practical Path Guiding for Efficient Light-Transport Simulation
+//   Thomas Muller, Markus Gross, Jan Novak
+//   https://tom94.net/data/publications/mueller17practical/mueller17practical.pdf
+//
+
+class PathGuide
+  : public IPassCallback
+{
+  public:
+    // Constructor.
+    PathGuide(
+        const Scene&                scene,
+        const ParamArray&           params);
+
+    // Delete this instance.
+    virtual void release() APPLESEED_OVERRIDE;
+
+    // This method is called at the beginning of a pass.
+    virtual void pre_render(
+        const Frame&                frame,
+        foundation::JobQueue&       job_queue,
+        foundation::IAbortSwitch&   abort_switch) APPLESEED_OVERRIDE;
+
+    // This method is called at the end of a pass.
+    virtual bool post_render(
+        const Frame&                frame,
+        foundation::JobQueue&       job_queue,
+        foundation::IAbortSwitch&   abort_switch) APPLESEED_OVERRIDE;
+
+    // Return true if paths should record their radiance estimates during the current pass.
+    bool is_training() const;
+
+    // Record an estimate of the radiance arriving at a given world space point from a given
+    // direction, divided by the probability density wrt. solid angle of this direction.
+    // This method is thread-safe.
+    void record(
+        const foundation::Vector3d& point,
+        const foundation::Vector3f& incoming,                   // world space direction toward the light, unit-length
+        const float                 radiance);
+
+    // Sample a BSDF, mixing BSDF sampling with sampling of the learned distribution.
+    // Falls back to BSDF sampling where no distribution has been learned yet.
+    void sample(
+        SamplingContext&            sampling_context,
+        const BSDF&                 bsdf,
+        const void*                 bsdf_data,
+        const bool                  adjoint,
+        BSDFSample&                 sample) const;
+
+    // Add the metadata of the path guiding parameters to a dictionary.
+    static void add_params_metadata(foundation::Dictionary& metadata);
+
+  private:
+    enum { DirectionalResolution = 16 };
+    enum { BinCount = DirectionalResolution * DirectionalResolution };
+
+    struct Parameters
+    {
+        const size_t    m_training_passes;                      // number of passes during which radiance is recorded
+        const size_t    m_spatial_resolution;                   // number of grid cells along each dimension
+        const float     m_bsdf_sampling_fraction;               // probability of sampling the BSDF instead of the distribution
+
+        explicit Parameters(const ParamArray& params);
+    };
+
+    const Parameters                m_params;
+    foundation::AABB3d              m_bbox;
+    foundation::Vector3d            m_cell_scale;               // world space to grid space scale
+    size_t                          m_pass_number;
+    size_t                          m_guided_cell_count;
+
+    std::vector<foundation::uint64> m_radiance;                 // recorded radiance in fixed point, per cell and per bin
+    std::vector<float>              m_bin_probs;                // probability of each bin, per cell
+    std::vector<float>              m_bin_cdfs;                 // cumulative bin probabilities, per cell
+
+    size_t get_cell_index(const foundation::Vector3d& point) const;
+
+    static size_t get_bin_index(const foundation::Vector3f& direction);
+
+    // Rebuild the sampling distributions from the recorded radiance.
+    void update_distributions();
+
+    // Return the probability density wrt. solid angle of a direction in a given cell.
+    float evaluate_pdf(
+        const size_t                cell_index,
+        const foundation::Vector3f& direction) const;
+};
+
+
+//
+// Records the vertices of a path and the radiance reaching the camera through them,
+// and hands the resulting incident radiance estimates to a path guide once the path
+// is complete.
+//
+
+class PathGuideRecorder
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    explicit PathGuideRecorder(PathGuide& path_guide);
+
+    // Record a vertex and the radiance it contributes to the path, throughput included.
+    // Vertices that escaped to the environment are recorded as well.
+    void add_vertex(
+        const PathVertex&           vertex,
+        const Spectrum&             radiance);
+
+    // Hand the radiance estimates of the path to the path guide.
+    void flush();
+
+  private:
+    struct Vertex
+    {
+        foundation::Vector3d        m_point;                    // world space position of the vertex
+        foundation::Vector3f        m_incoming;                 // world space direction from the previous vertex, unit-length
+        float                       m_throughput;               // path throughput at this vertex
+        float                       m_prev_prob;                // probability density of reaching this vertex from the previous one, 0 if not applicable
+        float                       m_radiance;                 // radiance contributed by this vertex
+        bool                        m_hit;                      // false if the vertex lies in the environment
+    };
+
+    enum { MaxVertexCount = 32 };
+
+    PathGuide&                      m_path_guide;
+    Vertex                          m_vertices[MaxVertexCount];
+    size_t                          m_vertex_count;
+};
+
+
+//
+// PathGuide class implementation.
+//
+
+inline bool PathGuide::is_training() const
+{
+    return m_pass_number < m_params.m_training_passes;
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_LIGHTING_PATHGUIDE_H
@@ -34,6 +34,7 @@
 #include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/lighting/pathguide.h"
 #include "renderer/kernel/lighting/pathvertex.h"
 #include "renderer/kernel/lighting/scatteringmode.h"
 #include "renderer/kernel/shading/shadingcontext.h"
@@ -76,12 +77,14 @@ class PathTracer
   : public foundation::NonCopyable
 {
   public:
+    // If 'path_guide' is not null, scattering directions are guided by the distribution it learned.
     PathTracer(
         PathVisitor&            path_visitor,
         const size_t            rr_min_path_length,
         const size_t            max_path_length,
         const size_t            max_iterations = 1000,
-        const double            near_start = 0.0);          // abort tracing if the first ray is shorter than this
+        const double            near_start = 0.0,           // abort tracing if the first ray is shorter than this
+        const PathGuide*        path_guide = 0);
 
     size_t trace(
         SamplingContext&        sampling_context,
@@ -94,12 +97,65 @@ class PathTracer
         const ShadingContext&   shading_context,
         const ShadingPoint&     shading_point);
 
+    // Enable efficiency-aware Russian Roulette and splitting. Once Russian Roulette kicks in,
+    // the contribution of a path is estimated as its throughput times 'reference_luminance',
+    // the average luminance of paths, relative to the brightness of the pixel, estimated by
+    // 'path_radiance', the radiance collected so far by the path. Paths of low relative
+    // contribution are terminated earlier; paths of high relative contribution are split,
+    // creating at most 'max_split_count' additional paths per traced path.
+    void enable_adaptive_rr(
+        const Spectrum&         path_radiance,
+        const float             reference_luminance,
+        const size_t            max_split_count);
+
+    // Return the number of additional paths created by splitting during the last trace.
+    size_t get_split_count() const;
+
   private:
     PathVisitor&                m_path_visitor;
     const size_t                m_rr_min_path_length;
     const size_t                m_max_path_length;
     const size_t                m_max_iterations;
     const double                m_near_start;
+    const PathGuide*            m_path_guide;
+
+    const Spectrum*             m_path_radiance;
+    float                       m_reference_luminance;
+    size_t                      m_max_split_count;
+    size_t                      m_split_count;
+
+    // Trace a path starting at a given vertex whose shading point is already known.
+    size_t trace_path(
+        SamplingContext&        sampling_context,
+        const ShadingContext&   shading_context,
+        PathVertex&             vertex,
+        foundation::Vector3d    medium_start);
+
+    // Sample the BSDF at a vertex.
+    void sample_bsdf(
+        SamplingContext&        sampling_context,
+        const PathVertex&       vertex,
+        BSDFSample&             bsdf_sample) const;
+
+    // Construct the ray scattered at a vertex, including its medium list, and
+    // account for absorption in the medium the ray leaves, if any.
+    void build_scattered_ray(
+        SamplingContext&        sampling_context,
+        const ShadingContext&   shading_context,
+        PathVertex&             vertex,
+        const BSDFSample&       bsdf_sample,
+        foundation::Vector3d&   medium_start,
+        ShadingRay&             next_ray) const;
+
+    // Trace one of the additional paths created by splitting the path at a vertex.
+    size_t trace_split_path(
+        SamplingContext&            sampling_context,
+        const ShadingContext&       shading_context,
+        const PathVertex&           vertex,
+        const ScatteringMode::Mode  prev_mode,
+        const Spectrum&             throughput,
+        const size_t                path_count,
+        foundation::Vector3d        medium_start);
 
     // Determine whether a ray can pass through a surface with a given alpha value.
     static bool pass_through(
@@ -118,13 +174,36 @@ inline PathTracer<PathVisitor, Adjoint>::PathTracer(
     const size_t                rr_min_path_length,
     const size_t                max_path_length,
     const size_t                max_iterations,
-    const double                near_start)
+    const double                near_start,
+    const PathGuide*            path_guide)
   : m_path_visitor(path_visitor)
   , m_rr_min_path_length(rr_min_path_length)
   , m_max_path_length(max_path_length)
   , m_max_iterations(max_iterations)
   , m_near_start(near_start)
+  , m_path_guide(path_guide)
+  , m_path_radiance(0)
+  , m_reference_luminance(0.0f)
+  , m_max_split_count(0)
+  , m_split_count(0)
+{
+}
+
+template <typename PathVisitor, bool Adjoint>
+inline void PathTracer<PathVisitor, Adjoint>::enable_adaptive_rr(
+    const Spectrum&             path_radiance,
+    const float                 reference_luminance,
+    const size_t                max_split_count)
 {
+    m_path_radiance = &path_radiance;
+    m_reference_luminance = reference_luminance;
+    m_max_split_count = max_split_count;
+}
+
+template <typename PathVisitor, bool Adjoint>
+inline size_t PathTracer<PathVisitor, Adjoint>::get_split_count() const
+{
+    return m_split_count;
 }
 
 template <typename PathVisitor, bool Adjoint>
@@ -150,13 +229,12 @@ size_t PathTracer<PathVisitor, Adjoint>::trace(
     const ShadingContext&       shading_context,
     const ShadingPoint&         shading_point)
 {
+    m_split_count = 0;
+
     // Terminate the path if the first hit is too close to the origin.
     if (shading_point.hit() && shading_point.get_distance() < m_near_start)
         return 1;
 
-    ShadingPoint shading_points[2];
-    size_t shading_point_index = 0;
-
     PathVertex vertex(sampling_context);
     vertex.m_path_length = 1;
     vertex.m_throughput.set(1.0f);
@@ -164,16 +242,40 @@ size_t PathTracer<PathVisitor, Adjoint>::trace(
     vertex.m_prev_mode = ScatteringMode::Specular;
     vertex.m_prev_prob = BSDF::DiracDelta;
 
-    // This variable tracks the beginning of the path segment inside the current medium.
+    shading_context.get_arena().clear();
+
+    // The medium start tracks the beginning of the path segment inside the current medium.
     // While it is properly initialized when entering a medium, we also initialize it
     // here to silence a gcc warning.
-    foundation::Vector3d medium_start(0.0);
+    return
+        trace_path(
+            sampling_context,
+            shading_context,
+            vertex,
+            foundation::Vector3d(0.0));
+}
+
+template <typename PathVisitor, bool Adjoint>
+size_t PathTracer<PathVisitor, Adjoint>::trace_path(
+    SamplingContext&            sampling_context,
+    const ShadingContext&       shading_context,
+    PathVertex&                 vertex,
+    foundation::Vector3d        medium_start)
+{
+    ShadingPoint shading_points[2];
+    size_t shading_point_index = 0;
 
+    // Memory allocated in the arena before this point belongs to the vertices of the path
+    // this path was split from, if any, and must be preserved.
+    foundation::Arena& arena = shading_context.get_arena();
+    const size_t arena_mark = arena.get_mark();
+
+    size_t path_length = vertex.m_path_length;
     size_t iterations = 0;
 
     while (true)
     {
-        shading_context.get_arena().clear();
+        arena.rewind(arena_mark);
 
 #ifndef NDEBUG
         // Save the sampling context at the beginning of the iteration.
@@ -349,7 +451,7 @@ size_t PathTracer<PathVisitor, Adjoint>::trace(
 
         // Retrieve the EDF, the BSDF and the BSSRDF.
         vertex.m_edf =
-            vertex.m_shading_point->is_curve_primitive() ? 0 : material_data.m_edf;
+            vertex.m_shading_point->is_triangle_primitive() ? material_data.m_edf : 0;
         vertex.m_bsdf = material_data.m_bsdf;
         vertex.m_bssrdf = material_data.m_bssrdf;
 
@@ -364,9 +466,13 @@ size_t PathTracer<PathVisitor, Adjoint>::trace(
             vertex.m_throughput *= 2.0f;
         }
 
-        // Evaluate the inputs of the BSDF.
+        // Evaluate the inputs of the BSDF and choose which of its lobes to evaluate.
         if (vertex.m_bsdf)
-            vertex.m_bsdf_data = vertex.m_bsdf->evaluate_inputs(shading_context, *vertex.m_shading_point);
+        {
+            void* bsdf_data = vertex.m_bsdf->evaluate_inputs(shading_context, *vertex.m_shading_point);
+            vertex.m_bsdf->select_lobes(sampling_context, bsdf_data);
+            vertex.m_bsdf_data = bsdf_data;
+        }
 
         // Evaluate the inputs of the BSSRDF.
         if (vertex.m_bssrdf)
@@ -422,12 +528,7 @@ size_t PathTracer<PathVisitor, Adjoint>::trace(
         if (!vertex.m_bssrdf)
         {
             // Sample the BSDF.
-            vertex.m_bsdf->sample(
-                sampling_context,
-                vertex.m_bsdf_data,
-                Adjoint,
-                true,       // multiply by |cos(incoming, normal)|
-                bsdf_sample);
+            sample_bsdf(sampling_context, vertex, bsdf_sample);
 
             // Terminate the path if it gets absorbed.
             if (bsdf_sample.m_mode == ScatteringMode::Absorption)
@@ -439,10 +540,12 @@ size_t PathTracer<PathVisitor, Adjoint>::trace(
         }
 
         // Properties of this scattering event.
+        const ScatteringMode::Mode prev_mode = vertex.m_prev_mode;
         vertex.m_prev_mode = bsdf_sample.m_mode;
         vertex.m_prev_prob = bsdf_sample.m_probability;
 
         // Update the path throughput.
+        const Spectrum prev_throughput = vertex.m_throughput;
         if (bsdf_sample.m_probability != BSDF::DiracDelta)
             bsdf_sample.m_value /= bsdf_sample.m_probability;
         vertex.m_throughput *= bsdf_sample.m_value;
@@ -454,91 +557,81 @@ size_t PathTracer<PathVisitor, Adjoint>::trace(
             sampling_context.split_in_place(1, 1);
             const float s = sampling_context.next2<float>();
 
-            // Compute the probability of extending this path.
-            const float scattering_prob = std::min(foundation::max_value(bsdf_sample.m_value), 1.0f);
-
-            // Russian Roulette.
-            if (!foundation::pass_rr(scattering_prob, s))
-                break;
-
-            // Adjust throughput to account for terminated paths.
-            assert(scattering_prob > 0.0f);
-            vertex.m_throughput /= scattering_prob;
-        }
-
-        // Keep track of the number of bounces.
-        ++vertex.m_path_length;
-
-        // Construct the scattered ray.
-        const foundation::Vector3d incoming(bsdf_sample.m_incoming.get_value());
-        ShadingRay next_ray(
-            vertex.m_shading_point->get_biased_point(incoming),
-            incoming,
-            ray.m_time,
-            ScatteringMode::get_vis_flags(vertex.m_prev_mode),
-            ray.m_depth + 1);
-        next_ray.m_dir = foundation::improve_normalization<2>(next_ray.m_dir);
-
-        // Compute scattered ray differentials.
-        if (bsdf_sample.m_incoming.has_derivatives())
-        {
-            next_ray.m_rx.m_org = next_ray.m_org + vertex.m_shading_point->get_dpdx();
-            next_ray.m_ry.m_org = next_ray.m_org + vertex.m_shading_point->get_dpdy();
-            next_ray.m_rx.m_dir = next_ray.m_dir + foundation::Vector3d(bsdf_sample.m_incoming.get_dx());
-            next_ray.m_ry.m_dir = next_ray.m_dir + foundation::Vector3d(bsdf_sample.m_incoming.get_dy());
-            next_ray.m_has_differentials = true;
-        }
-
-        // Build the medium list of the scattered ray.
-        const foundation::Vector3d& geometric_normal = vertex.get_geometric_normal();
-        const bool crossing_interface =
-            foundation::dot(vertex.m_outgoing.get_value(), geometric_normal) *
-            foundation::dot(next_ray.m_dir, geometric_normal) < 0.0;
-        if (vertex.m_bsdf != 0 && crossing_interface)
-        {
-            // Refracted ray: inherit the medium list of the parent ray and add/remove the current medium.
-            if (entering)
+            if (m_path_radiance && m_reference_luminance > 0.0f)
             {
-                const float ior =
-                    vertex.m_bsdf->sample_ior(
-                        sampling_context,
-                        vertex.m_bsdf_data);
-                next_ray.add_medium(ray, &object_instance, vertex.get_material(), ior);
-            }
-            else next_ray.remove_medium(ray, &object_instance);
-
-            // Compute absorption for the segment inside the medium the path is leaving.
-            const ShadingRay::Medium* prev_medium = ray.get_current_medium();
-            if (prev_medium != 0 && prev_medium != next_ray.get_current_medium())
-            {
-                const Material::RenderData& render_data = prev_medium->m_material->get_render_data();
-
-                if (render_data.m_bsdf)
+                // Estimate the contribution of the path relative to the brightness of the pixel.
+                // The pixel brightness estimate is bounded from below to limit splitting of paths
+                // that haven't collected any light yet.
+                const float pixel_luminance =
+                    std::max(foundation::average_value(*m_path_radiance), 0.1f * m_reference_luminance);
+                const float relative_contribution =
+                    foundation::average_value(vertex.m_throughput) * m_reference_luminance / pixel_luminance;
+
+                if (relative_contribution < 1.0f)
+                {
+                    // Russian Roulette, with a lower bound on the survival probability to avoid fireflies.
+                    const float scattering_prob = std::max(relative_contribution, 0.05f);
+                    if (!foundation::pass_rr(scattering_prob, s))
+                        break;
+                    vertex.m_throughput /= scattering_prob;
+                }
+                else if (
+                    relative_contribution >= 2.0f &&
+                    m_split_count < m_max_split_count &&
+                    !vertex.m_bssrdf)
                 {
-                    // Execute the OSL shader if there is one.
-                    if (render_data.m_shader_group)
+                    // Splitting: continue the path in several independent directions.
+                    const size_t path_count =
+                        std::min(
+                            foundation::truncate<size_t>(std::min(relative_contribution, 1.0e6f)),
+                            m_max_split_count - m_split_count + 1);
+                    m_split_count += path_count - 1;
+                    vertex.m_throughput /= static_cast<float>(path_count);
+
+                    for (size_t i = 1; i < path_count; ++i)
                     {
-                        shading_context.execute_osl_shading(
-                            *render_data.m_shader_group,
-                            *vertex.m_shading_point);
+                        path_length =
+                            std::max(
+                                path_length,
+                                trace_split_path(
+                                    sampling_context,
+                                    shading_context,
+                                    vertex,
+                                    prev_mode,
+                                    prev_throughput,
+                                    path_count,
+                                    medium_start));
                     }
-
-                    const void* data = render_data.m_bsdf->evaluate_inputs(shading_context, *vertex.m_shading_point);
-                    const float distance = static_cast<float>(norm(vertex.get_point() - medium_start));
-                    Spectrum absorption;
-                    render_data.m_bsdf->compute_absorption(data, distance, absorption);
-                    vertex.m_throughput *= absorption;
                 }
             }
+            else
+            {
+                // Compute the probability of extending this path.
+                const float scattering_prob = std::min(foundation::max_value(bsdf_sample.m_value), 1.0f);
 
-            medium_start = vertex.get_point();
-        }
-        else
-        {
-            // Reflected ray: inherit the medium list of the parent ray.
-            next_ray.copy_media_from(ray);
+                // Russian Roulette.
+                if (!foundation::pass_rr(scattering_prob, s))
+                    break;
+
+                // Adjust throughput to account for terminated paths.
+                assert(scattering_prob > 0.0f);
+                vertex.m_throughput /= scattering_prob;
+            }
         }
 
+        // Keep track of the number of bounces.
+        ++vertex.m_path_length;
+
+        // Construct the scattered ray.
+        ShadingRay next_ray;
+        build_scattered_ray(
+            sampling_context,
+            shading_context,
+            vertex,
+            bsdf_sample,
+            medium_start,
+            next_ray);
+
         // Trace the ray.
         shading_points[shading_point_index].clear();
         shading_context.get_intersector().trace(
@@ -551,7 +644,186 @@ size_t PathTracer<PathVisitor, Adjoint>::trace(
         shading_point_index = 1 - shading_point_index;
     }
 
-    return vertex.m_path_length;
+    return std::max(path_length, vertex.m_path_length);
+}
+
+template <typename PathVisitor, bool Adjoint>
+inline void PathTracer<PathVisitor, Adjoint>::sample_bsdf(
+    SamplingContext&            sampling_context,
+    const PathVertex&           vertex,
+    BSDFSample&                 bsdf_sample) const
+{
+    if (m_path_guide)
+    {
+        m_path_guide->sample(
+            sampling_context,
+            *vertex.m_bsdf,
+            vertex.m_bsdf_data,
+            Adjoint,
+            bsdf_sample);
+    }
+    else
+    {
+        vertex.m_bsdf->sample(
+            sampling_context,
+            vertex.m_bsdf_data,
+            Adjoint,
+            true,       // multiply by |cos(incoming, normal)|
+            bsdf_sample);
+    }
+}
+
+template <typename PathVisitor, bool Adjoint>
+void PathTracer<PathVisitor, Adjoint>::build_scattered_ray(
+    SamplingContext&            sampling_context,
+    const ShadingContext&       shading_context,
+    PathVertex&                 vertex,
+    const BSDFSample&           bsdf_sample,
+    foundation::Vector3d&       medium_start,
+    ShadingRay&                 next_ray) const
+{
+    const ShadingRay& ray = vertex.get_ray();
+    const ObjectInstance& object_instance = vertex.m_shading_point->get_object_instance();
+    const bool entering = vertex.m_shading_point->is_entering();
+
+    // Construct the scattered ray.
+    const foundation::Vector3d incoming(bsdf_sample.m_incoming.get_value());
+    next_ray = ShadingRay(
+        vertex.m_shading_point->get_biased_point(incoming),
+        incoming,
+        ray.m_time,
+        ScatteringMode::get_vis_flags(vertex.m_prev_mode),
+        ray.m_depth + 1);
+    next_ray.m_dir = foundation::improve_normalization<2>(next_ray.m_dir);
+
+    // Compute scattered ray differentials.
+    if (bsdf_sample.m_incoming.has_derivatives())
+    {
+        next_ray.m_rx.m_org = next_ray.m_org + vertex.m_shading_point->get_dpdx();
+        next_ray.m_ry.m_org = next_ray.m_org + vertex.m_shading_point->get_dpdy();
+        next_ray.m_rx.m_dir = next_ray.m_dir + foundation::Vector3d(bsdf_sample.m_incoming.get_dx());
+        next_ray.m_ry.m_dir = next_ray.m_dir + foundation::Vector3d(bsdf_sample.m_incoming.get_dy());
+        next_ray.m_has_differentials = true;
+    }
+
+    // Build the medium list of the scattered ray.
+    const foundation::Vector3d& geometric_normal = vertex.get_geometric_normal();
+    const bool crossing_interface =
+        foundation::dot(vertex.m_outgoing.get_value(), geometric_normal) *
+        foundation::dot(next_ray.m_dir, geometric_normal) < 0.0;
+    if (vertex.m_bsdf != 0 && crossing_interface)
+    {
+        // Refracted ray: inherit the medium list of the parent ray and add/remove the current medium.
+        if (entering)
+        {
+            const float ior =
+                vertex.m_bsdf->sample_ior(
+                    sampling_context,
+                    vertex.m_bsdf_data);
+            next_ray.add_medium(ray, &object_instance, vertex.get_material(), ior);
+        }
+        else next_ray.remove_medium(ray, &object_instance);
+
+        // Compute absorption for the segment inside the medium the path is leaving.
+        const ShadingRay::Medium* prev_medium = ray.get_current_medium();
+        if (prev_medium != 0 && prev_medium != next_ray.get_current_medium())
+        {
+            const Material::RenderData& render_data = prev_medium->m_material->get_render_data();
+
+            if (render_data.m_bsdf)
+            {
+                // Execute the OSL shader if there is one.
+                if (render_data.m_shader_group)
+                {
+                    shading_context.execute_osl_shading(
+                        *render_data.m_shader_group,
+                        *vertex.m_shading_point);
+                }
+
+                const void* data = render_data.m_bsdf->evaluate_inputs(shading_context, *vertex.m_shading_point);
+                const float distance = static_cast<float>(norm(vertex.get_point() - medium_start));
+                Spectrum absorption;
+                render_data.m_bsdf->compute_absorption(data, distance, absorption);
+                vertex.m_throughput *= absorption;
+            }
+        }
+
+        medium_start = vertex.get_point();
+    }
+    else
+    {
+        // Reflected ray: inherit the medium list of the parent ray.
+        next_ray.copy_media_from(ray);
+    }
+}
+
+template <typename PathVisitor, bool Adjoint>
+size_t PathTracer<PathVisitor, Adjoint>::trace_split_path(
+    SamplingContext&            sampling_context,
+    const ShadingContext&       shading_context,
+    const PathVertex&           vertex,
+    const ScatteringMode::Mode  prev_mode,
+    const Spectrum&             throughput,
+    const size_t                path_count,
+    foundation::Vector3d        medium_start)
+{
+    // Sample a new scattering direction.
+    BSDFSample bsdf_sample(
+        vertex.m_shading_point,
+        foundation::Dual3f(vertex.m_outgoing));
+    sample_bsdf(sampling_context, vertex, bsdf_sample);
+
+    if (bsdf_sample.m_mode == ScatteringMode::Absorption)
+        return vertex.m_path_length;
+
+    if (!m_path_visitor.accept_scattering(prev_mode, bsdf_sample.m_mode))
+        return vertex.m_path_length;
+
+    PathVertex split_vertex(vertex.m_sampling_context);
+    split_vertex.m_path_length = vertex.m_path_length;
+    split_vertex.m_shading_point = vertex.m_shading_point;
+    split_vertex.m_outgoing = vertex.m_outgoing;
+    split_vertex.m_cos_on = vertex.m_cos_on;
+    split_vertex.m_edf = vertex.m_edf;
+    split_vertex.m_bsdf = vertex.m_bsdf;
+    split_vertex.m_bsdf_data = vertex.m_bsdf_data;
+    split_vertex.m_bssrdf = vertex.m_bssrdf;
+    split_vertex.m_bssrdf_data = vertex.m_bssrdf_data;
+    split_vertex.m_prev_mode = bsdf_sample.m_mode;
+    split_vertex.m_prev_prob = bsdf_sample.m_probability;
+
+    // Each of the split paths carries its share of the throughput.
+    split_vertex.m_throughput = throughput;
+    split_vertex.m_throughput *= bsdf_sample.m_value;
+    if (bsdf_sample.m_probability != BSDF::DiracDelta)
+        split_vertex.m_throughput /= bsdf_sample.m_probability;
+    split_vertex.m_throughput /= static_cast<float>(path_count);
+
+    ++split_vertex.m_path_length;
+
+    // Construct and trace the scattered ray.
+    ShadingRay next_ray;
+    build_scattered_ray(
+        sampling_context,
+        shading_context,
+        split_vertex,
+        bsdf_sample,
+        medium_start,
+        next_ray);
+
+    ShadingPoint shading_point;
+    shading_context.get_intersector().trace(
+        next_ray,
+        shading_point,
+        vertex.m_shading_point);
+    split_vertex.m_shading_point = &shading_point;
+
+    return
+        trace_path(
+            sampling_context,
+            shading_context,
+            split_vertex,
+            medium_start);
 }
 
 template <typename PathVisitor, bool Adjoint>
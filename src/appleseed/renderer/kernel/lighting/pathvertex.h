@@ -33,6 +33,7 @@
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/lighting/lightsampler.h"
+#include "renderer/kernel/lighting/lightselectionguide.h"
 #include "renderer/kernel/lighting/scatteringmode.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/kernel/shading/shadingray.h"
@@ -107,8 +108,11 @@ class PathVertex
     // Return the probability density wrt. surface area mesure of reaching this vertex via BSDF sampling.
     float get_bsdf_prob_area() const;
 
-    // Return the probability density wrt. surface area mesure of reaching this vertex via light sampling.
-    float get_light_prob_area(const LightSampler& light_sampler) const;
+    // Return the probability density wrt. surface area mesure of reaching this vertex via light sampling,
+    // with light samples chosen by the light selection guide if one is provided.
+    float get_light_prob_area(
+        const LightSampler&         light_sampler,
+        const LightSelectionGuide*  light_selection_guide = 0) const;
 };
 
 
@@ -173,9 +177,16 @@ inline float PathVertex::get_bsdf_prob_area() const
     return m_prev_prob * g;
 }
 
-inline float PathVertex::get_light_prob_area(const LightSampler& light_sampler) const
+inline float PathVertex::get_light_prob_area(
+    const LightSampler&             light_sampler,
+    const LightSelectionGuide*      light_selection_guide) const
 {
-    return light_sampler.evaluate_pdf(*m_shading_point);
+    // Light samples were taken from the origin of the ray that led to this vertex.
+    const foundation::Vector3d& origin = m_shading_point->get_ray().m_org;
+    return
+        light_selection_guide
+            ? light_selection_guide->evaluate_pdf(*m_shading_point, origin)
+            : light_sampler.evaluate_pdf(*m_shading_point, origin);
 }
 
 }       // namespace renderer
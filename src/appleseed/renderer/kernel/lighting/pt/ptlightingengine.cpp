@@ -36,12 +36,17 @@
 #include "renderer/kernel/aov/spectrumstack.h"
 #include "renderer/kernel/lighting/directlightingintegrator.h"
 #include "renderer/kernel/lighting/imagebasedlighting.h"
+#include "renderer/kernel/lighting/lightreservoir.h"
+#include "renderer/kernel/lighting/lightselectionguide.h"
+#include "renderer/kernel/lighting/pathguide.h"
 #include "renderer/kernel/lighting/pathtracer.h"
 #include "renderer/kernel/lighting/pathvertex.h"
 #include "renderer/kernel/lighting/scatteringmode.h"
+#include "renderer/kernel/rendering/pixelcontext.h"
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/modeling/bsdf/bsdf.h"
+#include "renderer/modeling/color/colorspace.h"
 #include "renderer/modeling/edf/edf.h"
 #include "renderer/modeling/environment/environment.h"
 #include "renderer/modeling/environmentedf/environmentedf.h"
@@ -55,6 +60,7 @@
 #include "foundation/math/vector.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/makevector.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/string.h"
 
@@ -63,11 +69,11 @@
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <memory>
 #include <string>
 
 // Forward declarations.
 namespace renderer  { class LightSampler; }
-namespace renderer  { class PixelContext; }
 namespace renderer  { class TextureCache; }
 
 using namespace foundation;
@@ -94,20 +100,34 @@ namespace
       public:
         struct Parameters
         {
+            enum RRMode
+            {
+                RRModeThroughput,                           // Russian Roulette based on path throughput
+                RRModeAdaptive                              // Russian Roulette and splitting based on estimated path contribution
+            };
+
             const bool      m_enable_dl;                    // is direct lighting enabled?
             const bool      m_enable_ibl;                   // is image-based lighting enabled?
             const bool      m_enable_caustics;              // are caustics enabled?
 
             const size_t    m_max_path_length;              // maximum path length, ~0 for unlimited
             const size_t    m_rr_min_path_length;           // minimum path length before Russian Roulette kicks in, ~0 for unlimited
+            const RRMode    m_rr_mode;                      // Russian Roulette mode
+            const size_t    m_rr_max_splits;                // maximum number of additional paths created by splitting, per path
             const bool      m_next_event_estimation;        // use next event estimation?
 
             const float     m_dl_light_sample_count;        // number of light samples used to estimate direct illumination
+            const bool      m_dl_deferred_shadow_rays;      // trace the shadow rays of direct lighting as a batch?
+            const bool      m_dl_resampling;                // choose a single light sample among candidates by resampling?
             const float     m_ibl_env_sample_count;         // number of environment samples used to estimate IBL
 
             const bool      m_has_max_ray_intensity;
             const float     m_max_ray_intensity;
 
+            const bool      m_enable_path_guiding;          // is path guiding enabled?
+
+            const bool      m_hybrid_spectrum;              // carry light in RGB past materials whose inputs are all RGB?
+
             float           m_rcp_dl_light_sample_count;
             float           m_rcp_ibl_env_sample_count;
 
@@ -117,11 +137,17 @@ namespace
               , m_enable_caustics(params.get_optional<bool>("enable_caustics", false))
               , m_max_path_length(nz(params.get_optional<size_t>("max_path_length", 0)))
               , m_rr_min_path_length(nz(params.get_optional<size_t>("rr_min_path_length", 6)))
+              , m_rr_mode(get_rr_mode(params))
+              , m_rr_max_splits(params.get_optional<size_t>("rr_max_splits", 4))
               , m_next_event_estimation(params.get_optional<bool>("next_event_estimation", true))
               , m_dl_light_sample_count(params.get_optional<float>("dl_light_samples", 1.0f))
+              , m_dl_deferred_shadow_rays(params.get_optional<bool>("dl_deferred_shadow_rays", false))
+              , m_dl_resampling(params.get_optional<bool>("dl_resampling", false))
               , m_ibl_env_sample_count(params.get_optional<float>("ibl_env_samples", 1.0f))
               , m_has_max_ray_intensity(params.strings().exist("max_ray_intensity"))
               , m_max_ray_intensity(params.get_optional<float>("max_ray_intensity", 0.0f))
+              , m_enable_path_guiding(params.get_optional<bool>("enable_path_guiding", false))
+              , m_hybrid_spectrum(get_spectrum_mode(params) == "hybrid")
             {
                 // Precompute the reciprocal of the number of light samples.
                 m_rcp_dl_light_sample_count =
@@ -141,6 +167,26 @@ namespace
                 return x == 0 ? ~0 : x;
             }
 
+            static RRMode get_rr_mode(const ParamArray& params)
+            {
+                const string value =
+                    params.get_optional<string>(
+                        "rr_mode",
+                        "throughput",
+                        make_vector("throughput", "adaptive"));
+
+                return value == "adaptive" ? RRModeAdaptive : RRModeThroughput;
+            }
+
+            static string get_spectrum_mode(const ParamArray& params)
+            {
+                return
+                    params.get_optional<string>(
+                        "spectrum_mode",
+                        "spectral",
+                        make_vector("spectral", "hybrid"));
+            }
+
             void print() const
             {
                 RENDERER_LOG_INFO(
@@ -150,29 +196,51 @@ namespace
                     "  caustics         %s\n"
                     "  max path length  %s\n"
                     "  rr min path len. %s\n"
+                    "  rr mode          %s\n"
+                    "  rr max splits    %s\n"
                     "  next event est.  %s\n"
                     "  dl light samples %s\n"
+                    "  deferred shadows %s\n"
+                    "  dl resampling    %s\n"
                     "  ibl env samples  %s\n"
-                    "  max ray intens.  %s",
+                    "  max ray intens.  %s\n"
+                    "  path guiding     %s\n"
+                    "  spectrum mode    %s",
                     m_enable_dl ? "on" : "off",
                     m_enable_ibl ? "on" : "off",
                     m_enable_caustics ? "on" : "off",
                     m_max_path_length == size_t(~0) ? "infinite" : pretty_uint(m_max_path_length).c_str(),
                     m_rr_min_path_length == size_t(~0) ? "infinite" : pretty_uint(m_rr_min_path_length).c_str(),
+                    m_rr_mode == RRModeAdaptive ? "adaptive" : "throughput",
+                    pretty_uint(m_rr_max_splits).c_str(),
                     m_next_event_estimation ? "on" : "off",
                     pretty_scalar(m_dl_light_sample_count).c_str(),
+                    m_dl_deferred_shadow_rays ? "on" : "off",
+                    m_dl_resampling ? "on" : "off",
                     pretty_scalar(m_ibl_env_sample_count).c_str(),
-                    m_has_max_ray_intensity ? pretty_scalar(m_max_ray_intensity).c_str() : "infinite");
+                    m_has_max_ray_intensity ? pretty_scalar(m_max_ray_intensity).c_str() : "infinite",
+                    m_enable_path_guiding ? "on" : "off",
+                    m_hybrid_spectrum ? "hybrid" : "spectral");
             }
         };
 
         PTLightingEngine(
             const LightSampler&     light_sampler,
+            PathGuide*              path_guide,
+            LightSelectionGuide*    light_selection_guide,
+            LightReservoirBuffer*   light_reservoir_buffer,
             const ParamArray&       params)
           : m_params(params)
           , m_light_sampler(light_sampler)
+          , m_path_guide(path_guide)
+          , m_light_selection_guide(light_selection_guide)
+          , m_light_reservoir_buffer(light_reservoir_buffer)
           , m_path_count(0)
+          , m_split_path_count(0)
+          , m_radiance_sum(0.0)
         {
+            if (m_path_guide)
+                m_path_guide_recorder.reset(new PathGuideRecorder(*m_path_guide));
         }
 
         virtual void release() APPLESEED_OVERRIDE
@@ -192,6 +260,7 @@ namespace
             {
                 do_compute_lighting<PathVisitorNextEventEstimation>(
                     sampling_context,
+                    pixel_context,
                     shading_context,
                     shading_point,
                     radiance,
@@ -201,6 +270,7 @@ namespace
             {
                 do_compute_lighting<PathVisitorSimple>(
                     sampling_context,
+                    pixel_context,
                     shading_context,
                     shading_point,
                     radiance,
@@ -211,17 +281,26 @@ namespace
         template <typename PathVisitor>
         void do_compute_lighting(
             SamplingContext&        sampling_context,
+            const PixelContext&     pixel_context,
             const ShadingContext&   shading_context,
             const ShadingPoint&     shading_point,
             Spectrum&               radiance,               // output radiance, in W.sr^-1.m^-2
             SpectrumStack&          aovs)
         {
+            // Record the path for path guiding during training passes.
+            PathGuideRecorder* path_guide_recorder =
+                m_path_guide && m_path_guide->is_training() ? m_path_guide_recorder.get() : 0;
+
             PathVisitor path_visitor(
                 m_params,
                 m_light_sampler,
                 sampling_context,
                 shading_context,
                 shading_point.get_scene(),
+                path_guide_recorder,
+                m_light_selection_guide,
+                m_light_reservoir_buffer,
+                pixel_context.get_pixel_coords(),
                 radiance,
                 aovs);
 
@@ -229,7 +308,18 @@ namespace
                 path_visitor,
                 m_params.m_rr_min_path_length,
                 m_params.m_max_path_length,
-                shading_context.get_max_iterations());
+                shading_context.get_max_iterations(),
+                0.0,
+                m_path_guide);
+
+            // Splitting is disabled when recording paths since the recorder expects linear paths.
+            if (m_params.m_rr_mode == Parameters::RRModeAdaptive && m_path_count > 0)
+            {
+                path_tracer.enable_adaptive_rr(
+                    radiance,
+                    static_cast<float>(m_radiance_sum / m_path_count),
+                    path_guide_recorder ? 0 : m_params.m_rr_max_splits);
+            }
 
             const size_t path_length =
                 path_tracer.trace(
@@ -237,8 +327,15 @@ namespace
                     shading_context,
                     shading_point);
 
+            if (path_guide_recorder)
+                path_guide_recorder->flush();
+
+            // Keep track of the average path luminance, used as a reference by adaptive Russian Roulette.
+            m_radiance_sum += average_value(radiance);
+
             // Update statistics.
             ++m_path_count;
+            m_split_path_count += path_tracer.get_split_count();
             m_path_length.insert(path_length);
         }
 
@@ -248,15 +345,27 @@ namespace
             stats.insert("path count", m_path_count);
             stats.insert("path length", m_path_length);
 
+            if (m_params.m_rr_mode == Parameters::RRModeAdaptive)
+            {
+                stats.insert("split paths", m_split_path_count);
+                stats.insert_percent("splitting rate", m_split_path_count, m_path_count);
+            }
+
             return StatisticsVector::make("path tracing statistics", stats);
         }
 
       private:
         const Parameters                m_params;
         const LightSampler&             m_light_sampler;
+        PathGuide*                      m_path_guide;
+        auto_ptr<PathGuideRecorder>     m_path_guide_recorder;
+        LightSelectionGuide*            m_light_selection_guide;
+        LightReservoirBuffer*           m_light_reservoir_buffer;
 
         uint64                          m_path_count;
+        uint64                          m_split_path_count;
         Population<uint64>              m_path_length;
+        double                          m_radiance_sum;
 
         //
         // Base path visitor.
@@ -269,6 +378,10 @@ namespace
             SamplingContext&            m_sampling_context;
             const ShadingContext&       m_shading_context;
             const EnvironmentEDF*       m_env_edf;
+            PathGuideRecorder*          m_path_guide_recorder;
+            LightSelectionGuide*        m_light_selection_guide;
+            LightReservoirBuffer*       m_light_reservoir_buffer;
+            const Vector2i              m_pixel_coords;
             Spectrum&                   m_path_radiance;
             SpectrumStack&              m_path_aovs;
             bool                        m_omit_emitted_light;   // todo: get rid of this
@@ -279,6 +392,10 @@ namespace
                 SamplingContext&        sampling_context,
                 const ShadingContext&   shading_context,
                 const Scene&            scene,
+                PathGuideRecorder*      path_guide_recorder,
+                LightSelectionGuide*    light_selection_guide,
+                LightReservoirBuffer*   light_reservoir_buffer,
+                const Vector2i&         pixel_coords,
                 Spectrum&               path_radiance,
                 SpectrumStack&          path_aovs)
               : m_params(params)
@@ -286,6 +403,10 @@ namespace
               , m_sampling_context(sampling_context)
               , m_shading_context(shading_context)
               , m_env_edf(scene.get_environment()->get_environment_edf())
+              , m_path_guide_recorder(path_guide_recorder)
+              , m_light_selection_guide(light_selection_guide)
+              , m_light_reservoir_buffer(light_reservoir_buffer)
+              , m_pixel_coords(pixel_coords)
               , m_path_radiance(path_radiance)
               , m_path_aovs(path_aovs)
               , m_omit_emitted_light(false)
@@ -313,6 +434,20 @@ namespace
 
                 return true;
             }
+
+            // Used in hybrid spectrum mode to carry light in RGB along paths that went
+            // through materials with RGB inputs only.
+            static void downgrade_to_rgb(Spectrum& radiance)
+            {
+                if (radiance.is_spectral())
+                    Spectrum::downgrade(g_std_lighting_conditions, radiance, radiance);
+            }
+
+            static void downgrade_to_rgb(SpectrumStack& aovs)
+            {
+                for (size_t i = 0, e = aovs.size(); i < e; ++i)
+                    downgrade_to_rgb(aovs[i]);
+            }
         };
 
         //
@@ -328,6 +463,10 @@ namespace
                 SamplingContext&        sampling_context,
                 const ShadingContext&   shading_context,
                 const Scene&            scene,
+                PathGuideRecorder*      path_guide_recorder,
+                LightSelectionGuide*    light_selection_guide,
+                LightReservoirBuffer*   light_reservoir_buffer,
+                const Vector2i&         pixel_coords,
                 Spectrum&               path_radiance,
                 SpectrumStack&          path_aovs)
               : PathVisitorBase(
@@ -336,6 +475,10 @@ namespace
                     sampling_context,
                     shading_context,
                     scene,
+                    path_guide_recorder,
+                    light_selection_guide,
+                    light_reservoir_buffer,
+                    pixel_coords,
                     path_radiance,
                     path_aovs)
             {
@@ -343,6 +486,8 @@ namespace
 
             void visit_vertex(const PathVertex& vertex)
             {
+                Spectrum emitted_radiance(0.0f, Spectrum::Illuminance);
+
                 if ((!m_omit_emitted_light || m_params.m_enable_caustics) &&
                     vertex.m_edf &&
                     vertex.m_cos_on > 0.0 &&
@@ -350,14 +495,19 @@ namespace
                     (vertex.m_path_length < 2 || (vertex.m_edf->get_flags() & EDF::CastIndirectLight)))
                 {
                     // Compute the emitted radiance.
-                    Spectrum emitted_radiance(Spectrum::Illuminance);
                     vertex.compute_emitted_radiance(m_shading_context, emitted_radiance);
 
                     // Update the path radiance.
+                    if (m_params.m_hybrid_spectrum && vertex.m_throughput.is_rgb())
+                        downgrade_to_rgb(emitted_radiance);
                     emitted_radiance *= vertex.m_throughput;
                     m_path_radiance += emitted_radiance;
                     m_path_aovs.add(vertex.m_edf->get_render_layer_index(), emitted_radiance);
                 }
+
+                // Record the vertex for path guiding.
+                if (m_path_guide_recorder)
+                    m_path_guide_recorder->add_vertex(vertex, emitted_radiance);
             }
 
             void visit_environment(const PathVertex& vertex)
@@ -382,9 +532,15 @@ namespace
                     env_prob);
 
                 // Update path radiance.
+                if (m_params.m_hybrid_spectrum && vertex.m_throughput.is_rgb())
+                    downgrade_to_rgb(env_radiance);
                 env_radiance *= vertex.m_throughput;
                 m_path_radiance += env_radiance;
                 m_path_aovs.add(m_env_edf->get_render_layer_index(), env_radiance);
+
+                // Record the vertex for path guiding.
+                if (m_path_guide_recorder)
+                    m_path_guide_recorder->add_vertex(vertex, env_radiance);
             }
         };
 
@@ -403,6 +559,10 @@ namespace
                 SamplingContext&        sampling_context,
                 const ShadingContext&   shading_context,
                 const Scene&            scene,
+                PathGuideRecorder*      path_guide_recorder,
+                LightSelectionGuide*    light_selection_guide,
+                LightReservoirBuffer*   light_reservoir_buffer,
+                const Vector2i&         pixel_coords,
                 Spectrum&               path_radiance,
                 SpectrumStack&          path_aovs)
               : PathVisitorBase(
@@ -411,6 +571,10 @@ namespace
                     sampling_context,
                     shading_context,
                     scene,
+                    path_guide_recorder,
+                    light_selection_guide,
+                    light_reservoir_buffer,
+                    pixel_coords,
                     path_radiance,
                     path_aovs)
               , m_is_indirect_lighting(false)
@@ -496,6 +660,15 @@ namespace
                     }
                 }
 
+                // In hybrid spectrum mode, light reflected by a material whose inputs are all RGB
+                // is converted to RGB right away, such that the rest of the path is carried in RGB.
+                if (m_params.m_hybrid_spectrum &&
+                    !vertex.get_material()->get_render_data().m_has_spectral_inputs)
+                {
+                    downgrade_to_rgb(vertex_radiance);
+                    downgrade_to_rgb(vertex_aovs);
+                }
+
                 // Apply path throughput.
                 vertex_radiance *= vertex.m_throughput;
                 vertex_aovs *= vertex.m_throughput;
@@ -510,6 +683,10 @@ namespace
                 // Update path radiance.
                 m_path_radiance += vertex_radiance;
                 m_path_aovs += vertex_aovs;
+
+                // Record the vertex for path guiding.
+                if (m_path_guide_recorder)
+                    m_path_guide_recorder->add_vertex(vertex, vertex_radiance);
             }
 
             void add_direct_lighting_contribution_bsdf(
@@ -525,6 +702,22 @@ namespace
                 Spectrum dl_radiance(Spectrum::Illuminance);
                 SpectrumStack dl_aovs(vertex_aovs.size());
 
+                if (m_params.m_dl_resampling)
+                {
+                    add_direct_lighting_contribution_resampled(
+                        shading_point,
+                        outgoing,
+                        bsdf,
+                        bsdf_data,
+                        scattering_modes,
+                        dl_radiance,
+                        dl_aovs);
+
+                    vertex_radiance += dl_radiance;
+                    vertex_aovs += dl_aovs;
+                    return;
+                }
+
                 const size_t light_sample_count =
                     stochastic_cast<size_t>(
                         m_sampling_context,
@@ -542,7 +735,9 @@ namespace
                     scattering_modes,
                     bsdf_sample_count,
                     light_sample_count,
-                    m_is_indirect_lighting);
+                    m_is_indirect_lighting,
+                    m_params.m_dl_deferred_shadow_rays,
+                    m_light_selection_guide);
 
                 if (last_vertex)
                 {
@@ -576,11 +771,81 @@ namespace
                 vertex_aovs += dl_aovs;
             }
 
+            void add_direct_lighting_contribution_resampled(
+                const ShadingPoint&     shading_point,
+                const Dual3d&           outgoing,
+                const BSDF&             bsdf,
+                const void*             bsdf_data,
+                const int               scattering_modes,
+                Spectrum&               dl_radiance,
+                SpectrumStack&          dl_aovs)
+            {
+                // Light samples are candidates for resampling: always draw at least one.
+                const size_t candidate_count =
+                    max<size_t>(static_cast<size_t>(m_params.m_dl_light_sample_count), 1);
+
+                const DirectLightingIntegrator integrator(
+                    m_shading_context,
+                    m_light_sampler,
+                    shading_point,
+                    bsdf,
+                    bsdf_data,
+                    scattering_modes,
+                    scattering_modes,
+                    0,
+                    candidate_count,
+                    m_is_indirect_lighting,
+                    false,
+                    m_light_selection_guide);
+
+                // Only the reservoirs of the first vertex of camera paths are reused.
+                if (m_light_reservoir_buffer && !m_is_indirect_lighting && shading_point.get_ray().m_depth == 0)
+                {
+                    LightReservoir reused_reservoirs[LightReservoirBuffer::MaxReusedReservoirCount];
+                    const size_t reused_reservoir_count =
+                        m_light_reservoir_buffer->fetch(
+                            shading_point.get_time(),
+                            m_pixel_coords,
+                            shading_point.get_geometric_normal(),
+                            shading_point.get_distance(),
+                            m_sampling_context,
+                            reused_reservoirs);
+
+                    LightReservoir output_reservoir;
+                    integrator.compute_outgoing_radiance_light_sampling_resampled(
+                        m_sampling_context,
+                        outgoing,
+                        dl_radiance,
+                        dl_aovs,
+                        reused_reservoirs,
+                        reused_reservoir_count,
+                        &output_reservoir);
+
+                    m_light_reservoir_buffer->store(
+                        m_pixel_coords,
+                        shading_point.get_geometric_normal(),
+                        shading_point.get_distance(),
+                        output_reservoir);
+                }
+                else
+                {
+                    integrator.compute_outgoing_radiance_light_sampling_resampled(
+                        m_sampling_context,
+                        outgoing,
+                        dl_radiance,
+                        dl_aovs);
+                }
+            }
+
             void add_emitted_light_contribution(
                 const PathVertex&       vertex,
                 Spectrum&               vertex_radiance,
                 SpectrumStack&          vertex_aovs)
             {
+                // Resampled direct lighting is the sole estimator of light reached after a non-specular bounce.
+                if (m_params.m_dl_resampling && vertex.m_prev_mode != ScatteringMode::Specular)
+                    return;
+
                 // Compute the emitted radiance.
                 Spectrum emitted_radiance(Spectrum::Illuminance);
                 vertex.compute_emitted_radiance(m_shading_context, emitted_radiance);
@@ -592,7 +857,7 @@ namespace
                     const float mis_weight =
                         mis_power2(
                             1.0f * vertex.get_bsdf_prob_area(),
-                            light_sample_count * vertex.get_light_prob_area(m_light_sampler));
+                            light_sample_count * vertex.get_light_prob_area(m_light_sampler, m_light_selection_guide));
                     emitted_radiance *= mis_weight;
                 }
 
@@ -701,6 +966,10 @@ namespace
                     env_radiance *= mis_weight;
                 }
 
+                // In hybrid spectrum mode, keep paths that went through RGB materials only in RGB.
+                if (m_params.m_hybrid_spectrum && vertex.m_throughput.is_rgb())
+                    downgrade_to_rgb(env_radiance);
+
                 // Apply path throughput.
                 env_radiance *= vertex.m_throughput;
 
@@ -711,6 +980,10 @@ namespace
                 // Update the path radiance.
                 m_path_radiance += env_radiance;
                 m_path_aovs.add(m_env_edf->get_render_layer_index(), env_radiance);
+
+                // Record the vertex for path guiding.
+                if (m_path_guide_recorder)
+                    m_path_guide_recorder->add_vertex(vertex, env_radiance);
             }
 
             void clamp_contribution(Spectrum& radiance) const
@@ -736,9 +1009,15 @@ namespace
 //
 
 PTLightingEngineFactory::PTLightingEngineFactory(
-    const LightSampler& light_sampler,
-    const ParamArray&   params)
+    const LightSampler&     light_sampler,
+    const ParamArray&       params,
+    PathGuide*              path_guide,
+    LightSelectionGuide*    light_selection_guide,
+    LightReservoirBuffer*   light_reservoir_buffer)
   : m_light_sampler(light_sampler)
+  , m_path_guide(path_guide)
+  , m_light_selection_guide(light_selection_guide)
+  , m_light_reservoir_buffer(light_reservoir_buffer)
   , m_params(params)
 {
     PTLightingEngine::Parameters(params).print();
@@ -751,7 +1030,13 @@ void PTLightingEngineFactory::release()
 
 ILightingEngine* PTLightingEngineFactory::create()
 {
-    return new PTLightingEngine(m_light_sampler, m_params);
+    return
+        new PTLightingEngine(
+            m_light_sampler,
+            m_path_guide,
+            m_light_selection_guide,
+            m_light_reservoir_buffer,
+            m_params);
 }
 
 Dictionary PTLightingEngineFactory::get_params_metadata()
@@ -794,6 +1079,59 @@ Dictionary PTLightingEngineFactory::get_params_metadata()
             .insert("label", "Russian Roulette Start Bounce")
             .insert("help", "Consider pruning low contribution paths starting with this bounce"));
 
+    metadata.dictionaries().insert(
+        "rr_mode",
+        Dictionary()
+            .insert("type", "enum")
+            .insert("values", "throughput|adaptive")
+            .insert("default", "throughput")
+            .insert("label", "Russian Roulette Mode")
+            .insert("help", "How paths are pruned once Russian Roulette kicks in")
+            .insert(
+                "options",
+                Dictionary()
+                    .insert(
+                        "throughput",
+                        Dictionary()
+                            .insert("label", "Throughput")
+                            .insert("help", "Prune paths based on their throughput"))
+                    .insert(
+                        "adaptive",
+                        Dictionary()
+                            .insert("label", "Adaptive")
+                            .insert("help", "Prune or split paths based on their contribution relative to the pixel brightness"))));
+
+    metadata.dictionaries().insert(
+        "rr_max_splits",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "4")
+            .insert("min", "0")
+            .insert("label", "Max Path Splits")
+            .insert("help", "Maximum number of additional paths created by splitting a path in adaptive Russian Roulette mode"));
+
+    metadata.dictionaries().insert(
+        "spectrum_mode",
+        Dictionary()
+            .insert("type", "enum")
+            .insert("values", "spectral|hybrid")
+            .insert("default", "spectral")
+            .insert("label", "Spectrum Mode")
+            .insert("help", "How light is carried along paths when the scene contains spectral data")
+            .insert(
+                "options",
+                Dictionary()
+                    .insert(
+                        "spectral",
+                        Dictionary()
+                            .insert("label", "Spectral")
+                            .insert("help", "Carry light spectrally as soon as it interacts with spectral data"))
+                    .insert(
+                        "hybrid",
+                        Dictionary()
+                            .insert("label", "Hybrid")
+                            .insert("help", "Convert light to RGB when it is reflected by a material whose inputs are all RGB"))));
+
     metadata.dictionaries().insert(
         "next_event_estimation",
         Dictionary()
@@ -802,6 +1140,40 @@ Dictionary PTLightingEngineFactory::get_params_metadata()
             .insert("label", "Next Event Estimation")
             .insert("help", "Explicitly connect path vertices to light sources to improve efficiency"));
 
+    metadata.dictionaries().insert(
+        "dl_deferred_shadow_rays",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Deferred Shadow Rays")
+            .insert("help", "Trace the shadow rays of all light samples of a shading point as a batch"));
+
+    metadata.dictionaries().insert(
+        "dl_resampling",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Resampled Direct Lighting")
+            .insert("help", "Use the light samples as candidates and only trace the shadow ray of one of them, chosen in proportion of its unoccluded contribution"));
+
+    metadata.dictionaries().insert(
+        "dl_resampling_reuse",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Reuse Light Samples")
+            .insert("help", "Reuse the light sample candidates of camera rays across neighboring pixels and passes (biased, meant for interactive rendering)"));
+
+    metadata.dictionaries().insert(
+        "dl_resampling_neighbors",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "2")
+            .insert("min", "0")
+            .insert("max", "4")
+            .insert("label", "Reused Neighbors")
+            .insert("help", "Number of neighboring pixels whose light samples are reused"));
+
     metadata.dictionaries().insert(
         "max_ray_intensity",
         Dictionary()
@@ -812,6 +1184,9 @@ Dictionary PTLightingEngineFactory::get_params_metadata()
             .insert("label", "Max Ray Intensity")
             .insert("help", "Clamp intensity of rays (after the first bounce) to this value to reduce fireflies"));
 
+    PathGuide::add_params_metadata(metadata);
+    LightSelectionGuide::add_params_metadata(metadata);
+
     return metadata;
 }
 
@@ -39,7 +39,10 @@
 
 // Forward declarations.
 namespace foundation    { class Dictionary; }
+namespace renderer      { class LightReservoirBuffer; }
 namespace renderer      { class LightSampler; }
+namespace renderer      { class LightSelectionGuide; }
+namespace renderer      { class PathGuide; }
 
 namespace renderer
 {
@@ -52,10 +55,15 @@ class PTLightingEngineFactory
   : public ILightingEngineFactory
 {
   public:
-    // Constructor.
+    // Constructor. If 'path_guide' is not null, paths are guided by the distribution it learns.
+    // If 'light_selection_guide' is not null, lights are chosen with the probabilities it learns.
+    // If 'light_reservoir_buffer' is not null, resampled light samples of camera rays are reused.
     PTLightingEngineFactory(
-        const LightSampler& light_sampler,
-        const ParamArray&   params);
+        const LightSampler&     light_sampler,
+        const ParamArray&       params,
+        PathGuide*              path_guide = 0,
+        LightSelectionGuide*    light_selection_guide = 0,
+        LightReservoirBuffer*   light_reservoir_buffer = 0);
 
     // Delete this instance.
     virtual void release() APPLESEED_OVERRIDE;
@@ -68,6 +76,9 @@ class PTLightingEngineFactory
 
   private:
     const LightSampler&     m_light_sampler;
+    PathGuide*              m_path_guide;
+    LightSelectionGuide*    m_light_selection_guide;
+    LightReservoirBuffer*   m_light_reservoir_buffer;
     ParamArray              m_params;
 };
 
@@ -40,6 +40,7 @@
 #include "renderer/kernel/lighting/sppm/sppmpasscallback.h"
 #include "renderer/kernel/lighting/sppm/sppmphoton.h"
 #include "renderer/kernel/lighting/sppm/sppmphotonmap.h"
+#include "renderer/kernel/lighting/sppm/sppmvisibleregions.h"
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/modeling/bsdf/bsdf.h"
@@ -211,6 +212,8 @@ namespace
             knn::Answer<float>&         m_answer;
             Spectrum&                   m_path_radiance;
             SpectrumStack&              m_path_aovs;
+            SPPMMonoPhoton              m_decoded_mono_photon;
+            SPPMPolyPhoton              m_decoded_poly_photon;
 
             PathVisitor(
                 const SPPMParameters&   params,
@@ -342,13 +345,19 @@ namespace
                 Spectrum&               vertex_radiance,
                 SpectrumStack&          vertex_aovs)
             {
+                const Vector3f point(vertex.get_point());
+
+                // Record where photons are gathered to guide the photons of the next pass.
+                SPPMVisibleRegions* visible_regions = m_pass_callback.get_visible_regions();
+                if (visible_regions)
+                    visible_regions->insert(point);
+
                 const SPPMPhotonMap& photon_map = m_pass_callback.get_photon_map();
 
                 // No indirect lighting if the photon map is empty.
                 if (photon_map.empty())
                     return;
 
-                const Vector3f point(vertex.get_point());
                 const float radius = m_pass_callback.get_lookup_radius();
 
                 // Find the nearby photons around the path vertex.
@@ -416,7 +425,8 @@ namespace
                     const knn::Answer<float>::Entry& entry = m_answer.get(i);
                     const SPPMMonoPhoton& photon =
                         m_pass_callback.get_mono_photon(
-                            photon_map.remap(entry.m_index));
+                            photon_map.remap(entry.m_index),
+                            m_decoded_mono_photon);
 
                     // Reject photons from the opposite hemisphere as they won't contribute.
                     if (dot(normal, photon.m_incoming) <= 0.0f)
@@ -492,7 +502,8 @@ namespace
                     const knn::Answer<float>::Entry& entry = m_answer.get(i);
                     const SPPMPolyPhoton& photon =
                         m_pass_callback.get_poly_photon(
-                            photon_map.remap(entry.m_index));
+                            photon_map.remap(entry.m_index),
+                            m_decoded_poly_photon);
 
                     // Reject photons from the opposite hemisphere as they won't contribute.
                     if (dot(normal, photon.m_incoming) <= 0.0f)
@@ -607,20 +618,29 @@ namespace
 
             if (m_params.m_photon_type == SPPMParameters::Monochromatic)
             {
+                SPPMMonoPhoton decoded_photon;
+
                 for (size_t i = 0; i < photon_count; ++i)
                 {
                     const knn::Answer<float>::Entry& photon = m_answer.get(i);
                     const SpectrumLine& flux =
-                        m_pass_callback.get_mono_photon(photon_map.remap(photon.m_index)).m_flux;
+                        m_pass_callback.get_mono_photon(
+                            photon_map.remap(photon.m_index),
+                            decoded_photon).m_flux;
                     radiance[flux.m_wavelength] += flux.m_amplitude;
                 }
             }
             else
             {
+                SPPMPolyPhoton decoded_photon;
+
                 for (size_t i = 0; i < photon_count; ++i)
                 {
                     const knn::Answer<float>::Entry& photon = m_answer.get(i);
-                    radiance += m_pass_callback.get_poly_photon(photon_map.remap(photon.m_index)).m_flux;
+                    radiance +=
+                        m_pass_callback.get_poly_photon(
+                            photon_map.remap(photon.m_index),
+                            decoded_photon).m_flux;
                 }
             }
 
@@ -696,6 +716,28 @@ Dictionary SPPMLightingEngineFactory::get_params_metadata()
                             .insert("label", "Poly")
                             .insert("help", "Polychromatic photons"))));
 
+    metadata.dictionaries().insert(
+        "photon_format",
+        Dictionary()
+            .insert("type", "enum")
+            .insert("values", "full|compact")
+            .insert("default", "full")
+            .insert("label", "Photon Format")
+            .insert("help", "Photon storage format")
+            .insert(
+                "options",
+                Dictionary()
+                    .insert(
+                        "full",
+                        Dictionary()
+                            .insert("label", "Full")
+                            .insert("help", "Full precision photons"))
+                    .insert(
+                        "compact",
+                        Dictionary()
+                            .insert("label", "Compact")
+                            .insert("help", "Compact photons with quantized directions and flux, using less than half the memory"))));
+
     metadata.dictionaries().insert(
         "dl_type",
         Dictionary()
@@ -771,6 +813,16 @@ Dictionary SPPMLightingEngineFactory::get_params_metadata()
             .insert("label", "IBL Photons per Pass")
             .insert("help", "Number of environment photons per render pass"));
 
+    metadata.dictionaries().insert(
+        "guided_emission_fraction",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.0")
+            .insert("min", "0.0")
+            .insert("max", "1.0")
+            .insert("label", "Guided Emission Fraction")
+            .insert("help", "Fraction of the photons emitted toward the regions seen by the camera during the previous pass"));
+
     metadata.dictionaries().insert(
         "initial_radius",
         Dictionary()
@@ -72,6 +72,23 @@ namespace
                 : SPPMParameters::Polychromatic;
     }
 
+    SPPMParameters::PhotonFormat get_photon_format(
+        const ParamArray&   params,
+        const char*         name,
+        const char*         default_value)
+    {
+        const string value =
+            params.get_optional<string>(
+                name,
+                default_value,
+                make_vector("full", "compact"));
+
+        return
+            value == "full"
+                ? SPPMParameters::Full
+                : SPPMParameters::Compact;
+    }
+
     SPPMParameters::Mode get_mode(
         const ParamArray&   params,
         const char*         name,
@@ -93,12 +110,14 @@ namespace
 SPPMParameters::SPPMParameters(const ParamArray& params)
   : m_sampling_mode(get_sampling_context_mode(params))
   , m_photon_type(get_photon_type(params, "photon_type", "poly"))
+  , m_photon_format(get_photon_format(params, "photon_format", "full"))
   , m_dl_mode(get_mode(params, "dl_mode", "rt"))
   , m_enable_ibl(params.get_optional<bool>("enable_ibl", true))
   , m_enable_caustics(params.get_optional<bool>("enable_caustics", true))
   , m_light_photon_count(params.get_optional<size_t>("light_photons_per_pass", 1000000))
   , m_env_photon_count(params.get_optional<size_t>("env_photons_per_pass", 1000000))
   , m_photon_packet_size(params.get_optional<size_t>("photon_packet_size", 100000))
+  , m_guided_emission_fraction(params.get_optional<float>("guided_emission_fraction", 0.0f))
   , m_photon_tracing_max_path_length(nz(params.get_optional<size_t>("photon_tracing_max_path_length", 0)))
   , m_photon_tracing_rr_min_path_length(nz(params.get_optional<size_t>("photon_tracing_rr_min_path_length", 6)))
   , m_path_tracing_max_path_length(nz(params.get_optional<size_t>("path_tracing_max_path_length", 0)))
@@ -109,6 +128,7 @@ SPPMParameters::SPPMParameters(const ParamArray& params)
   , m_alpha(params.get_optional<float>("alpha", 0.7f))
   , m_max_photons_per_estimate(params.get_optional<size_t>("max_photons_per_estimate", 100))
   , m_dl_light_sample_count(params.get_optional<float>("dl_light_samples", 1.0))
+  , m_thread_count(get_rendering_thread_count(params))
   , m_view_photons(params.get_optional<bool>("view_photons", false))
   , m_view_photons_radius(params.get_optional<float>("view_photons_radius", 1.0e-3f))
 {
@@ -124,9 +144,11 @@ void SPPMParameters::print() const
     RENDERER_LOG_INFO(
         "sppm settings:\n"
         "  photon type      %s\n"
+        "  photon format    %s\n"
         "  dl               %s\n"
         "  ibl              %s",
         m_photon_type == Monochromatic ? "monochromatic" : "polychromatic",
+        m_photon_format == Full ? "full" : "compact",
         m_dl_mode == RayTraced ? "ray traced" :
         m_dl_mode == SPPM ? "sppm" : "off",
         m_enable_ibl ? "on" : "off");
@@ -135,10 +157,12 @@ void SPPMParameters::print() const
         "sppm photon tracing settings:\n"
         "  light photons    %s\n"
         "  env. photons     %s\n"
+        "  guided emission  %s\n"
         "  max path length  %s\n"
         "  rr min path len. %s",
         pretty_uint(m_light_photon_count).c_str(),
         pretty_uint(m_env_photon_count).c_str(),
+        m_guided_emission_fraction > 0.0f ? pretty_percent(m_guided_emission_fraction, 1.0f).c_str() : "off",
         m_photon_tracing_max_path_length == size_t(~0) ? "infinite" : pretty_uint(m_photon_tracing_max_path_length).c_str(),
         m_photon_tracing_rr_min_path_length == size_t(~0) ? "infinite" : pretty_uint(m_photon_tracing_rr_min_path_length).c_str());
 
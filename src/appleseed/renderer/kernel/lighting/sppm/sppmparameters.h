@@ -45,10 +45,12 @@ namespace renderer
 struct SPPMParameters
 {
     enum PhotonType { Monochromatic, Polychromatic };
+    enum PhotonFormat { Full, Compact };
     enum Mode { RayTraced, SPPM, Off };
 
     const SamplingContext::Mode m_sampling_mode;
     const PhotonType            m_photon_type;
+    const PhotonFormat          m_photon_format;                        // storage format of the photons
 
     const Mode                  m_dl_mode;                              // direct lighting mode
     const bool                  m_enable_ibl;                           // is image-based lighting enabled?
@@ -57,6 +59,7 @@ struct SPPMParameters
     const size_t                m_light_photon_count;                   // number of photons emitted from the lights
     const size_t                m_env_photon_count;                     // number of photons emitted from the environment
     const size_t                m_photon_packet_size;                   // number of photons per tracing job
+    const float                 m_guided_emission_fraction;             // fraction of the photons emitted toward the regions seen by the camera
 
     const size_t                m_photon_tracing_max_path_length;       // maximum photon tracing path length, ~0 for unlimited
     const size_t                m_photon_tracing_rr_min_path_length;    // minimum photon tracing path length before Russian Roulette kicks in, ~0 for unlimited
@@ -73,6 +76,8 @@ struct SPPMParameters
     const float                 m_dl_light_sample_count;                // number of light samples used to estimate direct illumination in ray traced mode
     float                       m_rcp_dl_light_sample_count;
 
+    const size_t                m_thread_count;                         // number of threads used to build the photon map
+
     const bool                  m_view_photons;                         // debug mode to visualize the photons
     const float                 m_view_photons_radius;                  // lookup radius when visualizing photons
 
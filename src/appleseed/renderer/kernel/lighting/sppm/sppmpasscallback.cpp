@@ -33,6 +33,7 @@
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
+#include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/modeling/scene/scene.h"
 
 // appleseed.foundation headers.
@@ -51,6 +52,13 @@ using namespace std;
 namespace renderer
 {
 
+namespace
+{
+    // Number of cells along each axis of the grid tracking the regions seen by the camera.
+    const size_t VisibleRegionsResolution = 8;
+}
+
+
 //
 // SPPMPassCallback class implementation.
 //
@@ -64,6 +72,7 @@ SPPMPassCallback::SPPMPassCallback(
     OSL::ShadingSystem&     shading_system,
     const SPPMParameters&   params)
   : m_params(params)
+  , m_texture_store(texture_store)
   , m_photon_tracer(
         scene,
         light_sampler,
@@ -82,6 +91,13 @@ SPPMPassCallback::SPPMPassCallback(
 
     // Start with the initial lookup radius.
     m_lookup_radius = m_initial_lookup_radius;
+
+    // Track the regions seen by the camera to guide photon emission.
+    if (m_params.m_guided_emission_fraction > 0.0f)
+    {
+        m_visible_regions.reset(
+            new SPPMVisibleRegions(AABB3d(scene_bbox), VisibleRegionsResolution));
+    }
 }
 
 void SPPMPassCallback::release()
@@ -109,6 +125,7 @@ void SPPMPassCallback::pre_render(
     m_photon_tracer.trace_photons(
         m_photons,
         hash_uint32(m_pass_number),
+        m_visible_targets,
         job_queue,
         abort_switch);
 
@@ -117,10 +134,14 @@ void SPPMPassCallback::pre_render(
         return;
 
     // Build a new photon map.
-    m_photon_map.reset(new SPPMPhotonMap(m_photons));
+    m_photon_map.reset(new SPPMPhotonMap(m_photons, m_params.m_thread_count));
+
+    // Let the texture store give back the memory used by the photons.
+    m_texture_store.set_reserved_memory_size(
+        m_photons.get_memory_size() + m_photon_map->get_memory_size());
 }
 
-void SPPMPassCallback::post_render(
+bool SPPMPassCallback::post_render(
     const Frame&            frame,
     JobQueue&               job_queue,
     IAbortSwitch&           abort_switch)
@@ -130,6 +151,14 @@ void SPPMPassCallback::post_render(
     assert(k <= 1.0);
     m_lookup_radius *= sqrt(k);
 
+    // Guide the photons of the next pass toward the regions seen by the camera during this pass.
+    if (m_visible_regions.get())
+    {
+        m_visible_targets.clear();
+        m_visible_regions->get_targets(m_visible_targets);
+        m_visible_regions->clear();
+    }
+
     m_stopwatch.measure();
 
     RENDERER_LOG_INFO(
@@ -138,6 +167,8 @@ void SPPMPassCallback::post_render(
         pretty_time(m_stopwatch.get_seconds()).c_str());
 
     ++m_pass_number;
+
+    return false;
 }
 
 }   // namespace renderer
@@ -35,7 +35,9 @@
 #include "renderer/kernel/lighting/sppm/sppmphoton.h"
 #include "renderer/kernel/lighting/sppm/sppmphotonmap.h"
 #include "renderer/kernel/lighting/sppm/sppmphotontracer.h"
+#include "renderer/kernel/lighting/sppm/sppmvisibleregions.h"
 #include "renderer/kernel/rendering/ipasscallback.h"
+#include "renderer/modeling/light/lighttarget.h"
 
 // appleseed.foundation headers.
 #include "foundation/platform/compiler.h"
@@ -99,14 +101,18 @@ class SPPMPassCallback
         foundation::IAbortSwitch&   abort_switch) APPLESEED_OVERRIDE;
 
     // This method is called at the end of a pass.
-    virtual void post_render(
+    virtual bool post_render(
         const Frame&                frame,
         foundation::JobQueue&       job_queue,
         foundation::IAbortSwitch&   abort_switch) APPLESEED_OVERRIDE;
 
-    // Return the i'th photon.
-    const SPPMMonoPhoton& get_mono_photon(const size_t i) const;
-    const SPPMPolyPhoton& get_poly_photon(const size_t i) const;
+    // Return the i'th photon. Compact photons are decoded into 'storage'.
+    const SPPMMonoPhoton& get_mono_photon(
+        const size_t                i,
+        SPPMMonoPhoton&             storage) const;
+    const SPPMPolyPhoton& get_poly_photon(
+        const size_t                i,
+        SPPMPolyPhoton&             storage) const;
 
     // Return the current photon map.
     const SPPMPhotonMap& get_photon_map() const;
@@ -114,14 +120,22 @@ class SPPMPassCallback
     // Return the current lookup radius.
     float get_lookup_radius() const;
 
+    // Return the regions seen by the camera during the current pass, or 0 if photon
+    // emission is not guided toward them.
+    SPPMVisibleRegions* get_visible_regions() const;
+
   private:
     const SPPMParameters            m_params;
+    TextureStore&                   m_texture_store;
     SPPMPhotonTracer                m_photon_tracer;
     foundation::uint32              m_pass_number;
     SPPMPhotonVector                m_photons;
     std::auto_ptr<SPPMPhotonMap>    m_photon_map;
     float                           m_initial_lookup_radius;
     float                           m_lookup_radius;
+    std::auto_ptr<SPPMVisibleRegions>
+                                    m_visible_regions;
+    LightTargetArray                m_visible_targets;  // regions seen by the camera during the previous pass
     foundation::Stopwatch<foundation::DefaultWallclockTimer>
                                     m_stopwatch;
 };
@@ -131,14 +145,26 @@ class SPPMPassCallback
 // SPPMPassCallback class implementation.
 //
 
-inline const SPPMMonoPhoton& SPPMPassCallback::get_mono_photon(const size_t i) const
+inline const SPPMMonoPhoton& SPPMPassCallback::get_mono_photon(
+    const size_t                    i,
+    SPPMMonoPhoton&                 storage) const
 {
-    return m_photons.m_mono_photons[i];
+    if (m_params.m_photon_format == SPPMParameters::Full)
+        return m_photons.m_mono_photons[i];
+
+    m_photons.m_compact_mono_photons[i].decode(storage);
+    return storage;
 }
 
-inline const SPPMPolyPhoton& SPPMPassCallback::get_poly_photon(const size_t i) const
+inline const SPPMPolyPhoton& SPPMPassCallback::get_poly_photon(
+    const size_t                    i,
+    SPPMPolyPhoton&                 storage) const
 {
-    return m_photons.m_poly_photons[i];
+    if (m_params.m_photon_format == SPPMParameters::Full)
+        return m_photons.m_poly_photons[i];
+
+    m_photons.m_compact_poly_photons[i].decode(storage);
+    return storage;
 }
 
 inline const SPPMPhotonMap& SPPMPassCallback::get_photon_map() const
@@ -151,6 +177,11 @@ inline float SPPMPassCallback::get_lookup_radius() const
     return m_lookup_radius;
 }
 
+inline SPPMVisibleRegions* SPPMPassCallback::get_visible_regions() const
+{
+    return m_visible_regions.get();
+}
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_KERNEL_LIGHTING_SPPM_SPPMPASSCALLBACK_H
@@ -31,13 +31,78 @@
 #include "sppmphoton.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/octahedral.h"
+#include "foundation/math/scalar.h"
 #include "foundation/utility/memory.h"
 
+// OpenEXR headers.
+#include "foundation/platform/exrheaderguards.h"
+BEGIN_EXR_INCLUDES
+#include "OpenEXR/half.h"
+END_EXR_INCLUDES
+
+// Standard headers.
+#include <vector>
+
 using namespace foundation;
+using namespace std;
 
 namespace renderer
 {
 
+//
+// SPPMCompactMonoPhoton class implementation.
+//
+
+void SPPMCompactMonoPhoton::encode(const SPPMMonoPhoton& photon)
+{
+    m_incoming = octahedral_encode(photon.m_incoming);
+    m_geometric_normal = octahedral_encode(photon.m_geometric_normal);
+    m_flux = photon.m_flux;
+}
+
+void SPPMCompactMonoPhoton::decode(SPPMMonoPhoton& photon) const
+{
+    photon.m_incoming = octahedral_decode<float>(m_incoming);
+    photon.m_geometric_normal = octahedral_decode<float>(m_geometric_normal);
+    photon.m_flux = m_flux;
+}
+
+
+//
+// SPPMCompactPolyPhoton class implementation.
+//
+
+void SPPMCompactPolyPhoton::encode(const SPPMPolyPhoton& photon)
+{
+    m_incoming = octahedral_encode(photon.m_incoming);
+    m_geometric_normal = octahedral_encode(photon.m_geometric_normal);
+
+    const size_t size = photon.m_flux.size();
+    m_flux_size = static_cast<uint16>(size);
+
+    float scale = 0.0f;
+    for (size_t i = 0; i < size; ++i)
+        scale = max(scale, photon.m_flux[i]);
+    m_flux_scale = scale;
+
+    const float rcp_scale = scale > 0.0f ? 1.0f / scale : 0.0f;
+    for (size_t i = 0; i < size; ++i)
+        m_flux[i] = half(photon.m_flux[i] * rcp_scale);
+}
+
+void SPPMCompactPolyPhoton::decode(SPPMPolyPhoton& photon) const
+{
+    photon.m_incoming = octahedral_decode<float>(m_incoming);
+    photon.m_geometric_normal = octahedral_decode<float>(m_geometric_normal);
+
+    photon.m_flux.resize(m_flux_size);
+    photon.m_flux.set_intent(Spectrum::Illuminance);
+    for (size_t i = 0; i < m_flux_size; ++i)
+        photon.m_flux[i] = static_cast<float>(m_flux[i]) * m_flux_scale;
+}
+
+
 //
 // SPPMPhotonVector class implementation.
 //
@@ -57,7 +122,19 @@ size_t SPPMPhotonVector::get_memory_size() const
     return
         m_positions.capacity() * sizeof(Vector3f) +
         m_mono_photons.capacity() * sizeof(SPPMMonoPhoton) +
-        m_poly_photons.capacity() * sizeof(SPPMPolyPhoton);
+        m_poly_photons.capacity() * sizeof(SPPMPolyPhoton) +
+        m_compact_mono_photons.capacity() * sizeof(SPPMCompactMonoPhoton) +
+        m_compact_poly_photons.capacity() * sizeof(SPPMCompactPolyPhoton);
+}
+
+size_t SPPMPhotonVector::advise_large_pages() const
+{
+    return
+        foundation::advise_large_pages(m_positions) +
+        foundation::advise_large_pages(m_mono_photons) +
+        foundation::advise_large_pages(m_poly_photons) +
+        foundation::advise_large_pages(m_compact_mono_photons) +
+        foundation::advise_large_pages(m_compact_poly_photons);
 }
 
 void SPPMPhotonVector::swap(SPPMPhotonVector& rhs)
@@ -65,6 +142,8 @@ void SPPMPhotonVector::swap(SPPMPhotonVector& rhs)
     m_positions.swap(rhs.m_positions);
     m_mono_photons.swap(rhs.m_mono_photons);
     m_poly_photons.swap(rhs.m_poly_photons);
+    m_compact_mono_photons.swap(rhs.m_compact_mono_photons);
+    m_compact_poly_photons.swap(rhs.m_compact_poly_photons);
 }
 
 void SPPMPhotonVector::clear_keep_memory()
@@ -72,6 +151,8 @@ void SPPMPhotonVector::clear_keep_memory()
     foundation::clear_keep_memory(m_positions);
     foundation::clear_keep_memory(m_mono_photons);
     foundation::clear_keep_memory(m_poly_photons);
+    foundation::clear_keep_memory(m_compact_mono_photons);
+    foundation::clear_keep_memory(m_compact_poly_photons);
 }
 
 void SPPMPhotonVector::reserve_mono_photons(const size_t capacity)
@@ -102,13 +183,48 @@ void SPPMPhotonVector::push_back(
     m_poly_photons.push_back(photon);
 }
 
-void SPPMPhotonVector::append(const SPPMPhotonVector& rhs)
+void SPPMPhotonVector::push_back(
+    const Vector3f&                 position,
+    const SPPMCompactMonoPhoton&    photon)
 {
-    boost::mutex::scoped_lock lock(m_mutex);
+    m_positions.push_back(position);
+    m_compact_mono_photons.push_back(photon);
+}
+
+void SPPMPhotonVector::push_back(
+    const Vector3f&                 position,
+    const SPPMCompactPolyPhoton&    photon)
+{
+    m_positions.push_back(position);
+    m_compact_poly_photons.push_back(photon);
+}
 
-    m_positions.insert(m_positions.end(), rhs.m_positions.begin(), rhs.m_positions.end());
-    m_mono_photons.insert(m_mono_photons.end(), rhs.m_mono_photons.begin(), rhs.m_mono_photons.end());
-    m_poly_photons.insert(m_poly_photons.end(), rhs.m_poly_photons.begin(), rhs.m_poly_photons.end());
+namespace
+{
+    template <typename T>
+    void append_vectors(
+        const vector<SPPMPhotonVector>&     vectors,
+        vector<T> SPPMPhotonVector::*       member,
+        vector<T>&                          dest)
+    {
+        // Reserve the final storage once to avoid repeated reallocations.
+        size_t count = dest.size();
+        for (size_t i = 0; i < vectors.size(); ++i)
+            count += (vectors[i].*member).size();
+        dest.reserve(count);
+
+        for (size_t i = 0; i < vectors.size(); ++i)
+            dest.insert(dest.end(), (vectors[i].*member).begin(), (vectors[i].*member).end());
+    }
+}
+
+void SPPMPhotonVector::append(const vector<SPPMPhotonVector>& vectors)
+{
+    append_vectors(vectors, &SPPMPhotonVector::m_positions, m_positions);
+    append_vectors(vectors, &SPPMPhotonVector::m_mono_photons, m_mono_photons);
+    append_vectors(vectors, &SPPMPhotonVector::m_poly_photons, m_poly_photons);
+    append_vectors(vectors, &SPPMPhotonVector::m_compact_mono_photons, m_compact_mono_photons);
+    append_vectors(vectors, &SPPMPhotonVector::m_compact_poly_photons, m_compact_poly_photons);
 }
 
 }   // namespace renderer
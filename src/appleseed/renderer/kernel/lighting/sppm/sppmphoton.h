@@ -35,11 +35,14 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/vector.h"
-
-// Boost headers.
-#include "foundation/platform/thread.h"
 #include "foundation/platform/types.h"
 
+// OpenEXR headers.
+#include "foundation/platform/exrheaderguards.h"
+BEGIN_EXR_INCLUDES
+#include "OpenEXR/half.h"
+END_EXR_INCLUDES
+
 // Standard headers.
 #include <cstddef>
 #include <vector>
@@ -79,9 +82,50 @@ class SPPMPolyPhoton
 };
 
 
+//
+// A compact monochromatic photon, half the size of SPPMMonoPhoton.
+//
+
+class SPPMCompactMonoPhoton
+{
+  public:
+    foundation::uint32      m_incoming;             // incoming direction, world space, octahedral encoding
+    foundation::uint32      m_geometric_normal;     // geometric normal at the photon location, world space, octahedral encoding
+    SpectrumLine            m_flux;                 // flux carried by this photon (in W)
+
+    void encode(const SPPMMonoPhoton& photon);
+    void decode(SPPMMonoPhoton& photon) const;
+};
+
+
+//
+// A compact polychromatic photon, less than half the size of SPPMPolyPhoton.
+//
+// The flux components are stored in half precision relative to the largest
+// component, which preserves their relative precision whatever the magnitude
+// of the flux. RGB and spectral fluxes are both supported.
+//
+
+class SPPMCompactPolyPhoton
+{
+  public:
+    foundation::uint32      m_incoming;             // incoming direction, world space, octahedral encoding
+    foundation::uint32      m_geometric_normal;     // geometric normal at the photon location, world space, octahedral encoding
+    float                   m_flux_scale;           // largest flux component (in W)
+    half                    m_flux[Spectrum::Samples];  // flux components divided by m_flux_scale
+    foundation::uint16      m_flux_size;            // number of flux components
+
+    void encode(const SPPMPolyPhoton& photon);
+    void decode(SPPMPolyPhoton& photon) const;
+};
+
+
 //
 // A vector of photons.
 //
+// Depending on the photon format, photons are stored either as full or as compact photons.
+// Positions are always kept in a separate array since they are moved into the photon map.
+//
 
 class SPPMPhotonVector
 {
@@ -89,7 +133,8 @@ class SPPMPhotonVector
     std::vector<foundation::Vector3f>   m_positions;
     std::vector<SPPMMonoPhoton>         m_mono_photons;
     std::vector<SPPMPolyPhoton>         m_poly_photons;
-    boost::mutex                        m_mutex;
+    std::vector<SPPMCompactMonoPhoton>  m_compact_mono_photons;
+    std::vector<SPPMCompactPolyPhoton>  m_compact_poly_photons;
 
     bool empty() const;
     size_t size() const;
@@ -97,6 +142,10 @@ class SPPMPhotonVector
     // Return the size (in bytes) of this object in memory.
     size_t get_memory_size() const;
 
+    // Ask for the photon arrays to be backed by large pages.
+    // Return the number of large pages covered by the request.
+    size_t advise_large_pages() const;
+
     void swap(SPPMPhotonVector& rhs);
     void clear_keep_memory();
     void reserve_mono_photons(const size_t capacity);
@@ -107,9 +156,15 @@ class SPPMPhotonVector
     void push_back(
         const foundation::Vector3f&     position,
         const SPPMPolyPhoton&           photon);
+    void push_back(
+        const foundation::Vector3f&     position,
+        const SPPMCompactMonoPhoton&    photon);
+    void push_back(
+        const foundation::Vector3f&     position,
+        const SPPMCompactPolyPhoton&    photon);
 
-    // The only thread-safe method of this class.
-    void append(const SPPMPhotonVector& rhs);
+    // Append the photons of several vectors, in order.
+    void append(const std::vector<SPPMPhotonVector>& vectors);
 };
 
 }       // namespace renderer
@@ -48,7 +48,10 @@ using namespace foundation;
 namespace renderer
 {
 
-SPPMPhotonMap::SPPMPhotonMap(SPPMPhotonVector& photons)
+SPPMPhotonMap::SPPMPhotonMap(
+    SPPMPhotonVector&   photons,
+    const size_t        thread_count)
+  : m_tracked_memory_size(MemoryTracker::PhotonMaps)
 {
     const size_t photon_count = photons.size();
 
@@ -60,11 +63,14 @@ SPPMPhotonMap::SPPMPhotonMap(SPPMPhotonVector& photons)
             photon_count > 1 ? "photons" : "photon");
 
         knn::Builder3f builder(*this);
-        builder.build_move_points<DefaultWallclockTimer>(photons.m_positions);
+        builder.build_move_points<DefaultWallclockTimer>(photons.m_positions, thread_count);
+        m_tracked_memory_size.set(get_memory_size());
 
         Statistics statistics;
+        statistics.insert("build threads", thread_count);
         statistics.insert_time("build time", builder.get_build_time());
         statistics.insert_size("size", photons.get_memory_size());
+        statistics.insert("large pages", knn::Tree3f::advise_large_pages() + photons.advise_large_pages());
         statistics.merge(knn::TreeStatistics<knn::Tree3f>(*this));
 
         RENDERER_LOG_DEBUG("%s",
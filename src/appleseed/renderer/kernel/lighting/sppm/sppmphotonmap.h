@@ -32,6 +32,10 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/knn.h"
+#include "foundation/utility/memorytracker.h"
+
+// Standard headers.
+#include <cstddef>
 
 // Forward declarations.
 namespace renderer  { class SPPMPhotonVector; }
@@ -44,7 +48,13 @@ class SPPMPhotonMap
 {
   public:
     // Constructor, *moves* the photon positions into the map.
-    explicit SPPMPhotonMap(SPPMPhotonVector& photons);
+    // The map is built using 'thread_count' threads.
+    SPPMPhotonMap(
+        SPPMPhotonVector&   photons,
+        const size_t        thread_count);
+
+  private:
+    foundation::TrackedMemorySize m_tracked_memory_size;
 };
 
 }       // namespace renderer
@@ -171,7 +171,7 @@ namespace
                         m_initial_flux[wavelength] *
                         Spectrum::Samples *
                         spectral_throughput[wavelength];
-                    m_photons.push_back(Vector3f(vertex.get_point()), photon);
+                    store_photon(vertex, photon);
                 }
                 else
                 {
@@ -183,7 +183,7 @@ namespace
                     photon.m_geometric_normal = Vector3f(vertex.get_geometric_normal());
                     photon.m_flux = m_initial_flux;
                     photon.m_flux *= vertex.m_throughput;
-                    m_photons.push_back(Vector3f(vertex.get_point()), photon);
+                    store_photon(vertex, photon);
                 }
             }
         }
@@ -192,9 +192,127 @@ namespace
         {
             // The photon escapes, nothing to do.
         }
+
+        void store_photon(const PathVertex& vertex, const SPPMMonoPhoton& photon)
+        {
+            if (m_params.m_photon_format == SPPMParameters::Compact)
+            {
+                SPPMCompactMonoPhoton compact_photon;
+                compact_photon.encode(photon);
+                m_photons.push_back(Vector3f(vertex.get_point()), compact_photon);
+            }
+            else
+                m_photons.push_back(Vector3f(vertex.get_point()), photon);
+        }
+
+        void store_photon(const PathVertex& vertex, const SPPMPolyPhoton& photon)
+        {
+            if (m_params.m_photon_format == SPPMParameters::Compact)
+            {
+                SPPMCompactPolyPhoton compact_photon;
+                compact_photon.encode(photon);
+                m_photons.push_back(Vector3f(vertex.get_point()), compact_photon);
+            }
+            else
+                m_photons.push_back(Vector3f(vertex.get_point()), photon);
+        }
     };
 
 
+    //
+    // Guided photon emission.
+    //
+    // A fraction of the photons are emitted toward the regions seen by the camera during the
+    // previous pass, the other photons are emitted as usual. The flux of the photons is computed
+    // with the probability density of the combination of both strategies so that it remains
+    // unbiased.
+    //
+
+    // Compute the cone of directions from a point toward the bounding sphere of a target.
+    // Return false if the point is inside the bounding sphere.
+    bool compute_target_cone(
+        const LightTarget&      target,
+        const Vector3d&         origin,
+        Vector3f&               axis,
+        float&                  cos_theta_max)
+    {
+        const Vector3d v = target.get_center() - origin;
+        const double square_dist = square_norm(v);
+        const double square_radius = square(target.get_radius());
+
+        if (square_dist <= square_radius)
+            return false;
+
+        axis = Vector3f(v / sqrt(square_dist));
+        cos_theta_max =
+            min(
+                static_cast<float>(sqrt(1.0 - square_radius / square_dist)),
+                1.0f - 1.0e-6f);
+
+        return true;
+    }
+
+    // Choose a target uniformly at random and sample a direction toward its bounding sphere.
+    Vector3f sample_targets(
+        const LightTargetArray& targets,
+        const Vector3d&         origin,
+        Vector2f                s)
+    {
+        const float x = s[0] * targets.size();
+        const size_t target_index = min(truncate<size_t>(x), targets.size() - 1);
+        s[0] = x - target_index;
+
+        Vector3f axis;
+        float cos_theta_max;
+        if (!compute_target_cone(targets[target_index], origin, axis, cos_theta_max))
+            return sample_sphere_uniform(s);
+
+        return Basis3f(axis).transform_to_parent(sample_cone_uniform(s, cos_theta_max));
+    }
+
+    // Return the probability density with which sample_targets() samples a given direction.
+    float evaluate_targets_pdf(
+        const LightTargetArray& targets,
+        const Vector3d&         origin,
+        const Vector3f&         direction)
+    {
+        float pdf = 0.0f;
+
+        for (size_t i = 0, e = targets.size(); i < e; ++i)
+        {
+            Vector3f axis;
+            float cos_theta_max;
+            if (!compute_target_cone(targets[i], origin, axis, cos_theta_max))
+                pdf += RcpFourPi<float>();
+            else if (dot(direction, axis) >= cos_theta_max)
+                pdf += sample_cone_uniform_pdf(cos_theta_max);
+        }
+
+        return pdf / targets.size();
+    }
+
+    // Return the probability density with which a point is sampled on the projection of the
+    // disks facing a given direction and centered on the targets, choosing a disk uniformly.
+    float evaluate_target_disks_pdf(
+        const LightTargetArray& targets,
+        const Vector3d&         origin,
+        const Vector3d&         direction)
+    {
+        float pdf = 0.0f;
+
+        for (size_t i = 0, e = targets.size(); i < e; ++i)
+        {
+            const Vector3d v = targets[i].get_center() - origin;
+            const double square_radius = square(targets[i].get_radius());
+
+            if (square_norm(v - dot(v, direction) * direction) <= square_radius)
+                pdf += static_cast<float>(1.0 / (Pi<double>() * square_radius));
+        }
+
+        return pdf / targets.size();
+    }
+
+
     //
     // A job to trace a packet of photons from area lights and non-physical lights.
     //
@@ -206,19 +324,22 @@ namespace
         LightPhotonTracingJob(
             const Scene&            scene,
             const LightTargetArray& photon_targets,
+            const LightTargetArray& visible_targets,
             const LightSampler&     light_sampler,
             const TraceContext&     trace_context,
             TextureStore&           texture_store,
             OIIO::TextureSystem&    oiio_texture_system,
             OSL::ShadingSystem&     shading_system,
             const SPPMParameters&   params,
-            SPPMPhotonVector&       global_photons,
+            SPPMPhotonVector&       photons,
             const size_t            photon_begin,
             const size_t            photon_end,
             const size_t            pass_hash,
             IAbortSwitch&           abort_switch)
           : m_scene(scene)
           , m_photon_targets(photon_targets)
+          , m_visible_targets(visible_targets)
+          , m_guided_prob(visible_targets.empty() ? 0.0f : saturate(params.m_guided_emission_fraction))
           , m_light_sampler(light_sampler)
           , m_texture_cache(texture_store)
           , m_intersector(trace_context, m_texture_cache)
@@ -233,11 +354,11 @@ namespace
                 m_params.m_transparency_threshold,
                 m_params.m_max_iterations,
                 false)
-          , m_global_photons(global_photons)
           , m_photon_begin(photon_begin)
           , m_photon_end(photon_end)
           , m_pass_hash(pass_hash)
           , m_abort_switch(abort_switch)
+          , m_local_photons(photons)
         {
             const Camera* camera = scene.get_active_camera();
             m_shutter_open_time = camera->get_shutter_open_time();
@@ -269,13 +390,13 @@ namespace
                 m_arena.clear();
                 trace_light_photon(shading_context, sampling_context);
             }
-
-            m_global_photons.append(m_local_photons);
         }
 
       private:
         const Scene&                m_scene;
         const LightTargetArray&     m_photon_targets;
+        const LightTargetArray&     m_visible_targets;
+        const float                 m_guided_prob;      // probability of emitting photons toward visible targets
         const LightSampler&         m_light_sampler;
         TextureCache                m_texture_cache;
         Intersector                 m_intersector;
@@ -284,12 +405,11 @@ namespace
         OSLShaderGroupExec          m_shadergroup_exec;
         const SPPMParameters        m_params;
         Tracer                      m_tracer;
-        SPPMPhotonVector&           m_global_photons;
         const size_t                m_photon_begin;
         const size_t                m_photon_end;
         const size_t                m_pass_hash;
         IAbortSwitch&               m_abort_switch;
-        SPPMPhotonVector            m_local_photons;
+        SPPMPhotonVector&           m_local_photons;
         float                       m_shutter_open_time;
         float                       m_shutter_close_time;
 
@@ -352,20 +472,65 @@ namespace
                     light_shading_point);
             }
 
-            // Sample the EDF.
+            const void* edf_data = edf->evaluate_inputs(shading_context, light_shading_point);
+            const Vector3f geometric_normal(light_sample.m_geometric_normal);
+            const Basis3f shading_basis(Vector3f(light_sample.m_shading_normal));
+
+            // Choose whether to sample the EDF or to emit the photon toward a visible target.
+            bool guided = false;
+            if (m_guided_prob > 0.0f)
+            {
+                SamplingContext strategy_sampling_context = sampling_context.split(1, 1);
+                guided = strategy_sampling_context.next2<float>() < m_guided_prob;
+            }
+
+            // Sample the emission direction.
             SamplingContext child_sampling_context = sampling_context.split(2, 1);
             Vector3f emission_direction;
             Spectrum edf_value(Spectrum::Illuminance);
             float edf_prob;
-            edf->sample(
-                sampling_context,
-                edf->evaluate_inputs(shading_context, light_shading_point),
-                Vector3f(light_sample.m_geometric_normal),
-                Basis3f(Vector3f(light_sample.m_shading_normal)),
-                child_sampling_context.next2<Vector2f>(),
-                emission_direction,
-                edf_value,
-                edf_prob);
+            if (guided)
+            {
+                emission_direction =
+                    sample_targets(
+                        m_visible_targets,
+                        light_sample.m_point,
+                        child_sampling_context.next2<Vector2f>());
+
+                if (dot(emission_direction, shading_basis.get_normal()) <= 0.0f)
+                    return;
+
+                edf->evaluate(
+                    edf_data,
+                    geometric_normal,
+                    shading_basis,
+                    emission_direction,
+                    edf_value,
+                    edf_prob);
+
+                if (edf_prob == 0.0f)
+                    return;
+            }
+            else
+            {
+                edf->sample(
+                    sampling_context,
+                    edf_data,
+                    geometric_normal,
+                    shading_basis,
+                    child_sampling_context.next2<Vector2f>(),
+                    emission_direction,
+                    edf_value,
+                    edf_prob);
+            }
+
+            // Account for both emission strategies.
+            if (m_guided_prob > 0.0f)
+            {
+                edf_prob =
+                      (1.0f - m_guided_prob) * edf_prob
+                    + m_guided_prob * evaluate_targets_pdf(m_visible_targets, light_sample.m_point, emission_direction);
+            }
 
             // Compute the initial particle weight.
             Spectrum initial_flux = edf_value;
@@ -487,19 +652,25 @@ namespace
         EnvironmentPhotonTracingJob(
             const Scene&            scene,
             const LightTargetArray& photon_targets,
+            const LightTargetArray& visible_targets,
             const LightSampler&     light_sampler,
             const TraceContext&     trace_context,
             TextureStore&           texture_store,
             OIIO::TextureSystem&    oiio_texture_system,
             OSL::ShadingSystem&     shading_system,
             const SPPMParameters&   params,
-            SPPMPhotonVector&       global_photons,
+            SPPMPhotonVector&       photons,
             const size_t            photon_begin,
             const size_t            photon_end,
             const size_t            pass_hash,
             IAbortSwitch&           abort_switch)
           : m_scene(scene)
           , m_photon_targets(photon_targets)
+          , m_visible_targets(visible_targets)
+          , m_guided_prob(
+                photon_targets.empty() && !visible_targets.empty()
+                    ? saturate(params.m_guided_emission_fraction)
+                    : 0.0f)
           , m_env_edf(*scene.get_environment()->get_environment_edf())
           , m_light_sampler(light_sampler)
           , m_texture_cache(texture_store)
@@ -515,11 +686,11 @@ namespace
                 m_params.m_transparency_threshold,
                 m_params.m_max_iterations,
                 false)
-          , m_global_photons(global_photons)
           , m_photon_begin(photon_begin)
           , m_photon_end(photon_end)
           , m_pass_hash(pass_hash)
           , m_abort_switch(abort_switch)
+          , m_local_photons(photons)
         {
             const Scene::RenderData& scene_data = m_scene.get_render_data();
             m_scene_center = Vector3d(scene_data.m_center);
@@ -556,13 +727,13 @@ namespace
                 m_arena.clear();
                 trace_env_photon(shading_context, sampling_context);
             }
-
-            m_global_photons.append(m_local_photons);
         }
 
       private:
         const Scene&                m_scene;
         const LightTargetArray&     m_photon_targets;
+        const LightTargetArray&     m_visible_targets;
+        const float                 m_guided_prob;      // probability of emitting photons toward visible targets, only without photon targets
         const EnvironmentEDF&       m_env_edf;
         const LightSampler&         m_light_sampler;
         TextureCache                m_texture_cache;
@@ -572,12 +743,11 @@ namespace
         OSLShaderGroupExec          m_shadergroup_exec;
         const SPPMParameters        m_params;
         Tracer                      m_tracer;
-        SPPMPhotonVector&           m_global_photons;
         const size_t                m_photon_begin;
         const size_t                m_photon_end;
         const size_t                m_pass_hash;
         IAbortSwitch&               m_abort_switch;
-        SPPMPhotonVector            m_local_photons;
+        SPPMPhotonVector&           m_local_photons;
         float                       m_shutter_open_time;
         float                       m_shutter_close_time;
 
@@ -600,20 +770,29 @@ namespace
                 env_edf_value,
                 env_edf_prob);
 
+            // Choose whether to emit the photon toward the scene or toward a visible target.
+            bool guided = false;
+            if (m_guided_prob > 0.0f)
+            {
+                SamplingContext strategy_sampling_context = sampling_context.split(1, 1);
+                guided = strategy_sampling_context.next2<float>() < m_guided_prob;
+            }
+
             SamplingContext child_sampling_context = sampling_context.split(2, 1);
             Vector2d s = child_sampling_context.next2<Vector2d>();
 
             // Compute the center and radius of the target disk.
             Vector3d disk_center;
             double disk_radius;
-            const size_t target_count = m_photon_targets.size();
+            const LightTargetArray& targets = guided ? m_visible_targets : m_photon_targets;
+            const size_t target_count = targets.size();
             if (target_count > 0)
             {
                 const double x = s[0] * target_count;
                 const size_t target_index = truncate<size_t>(x);
                 s[0] = x - target_index;
 
-                const LightTarget& target = m_photon_targets[target_index];
+                const LightTarget& target = targets[target_index];
                 disk_center = target.get_center();
                 disk_radius = target.get_radius();
             }
@@ -632,7 +811,27 @@ namespace
                 + disk_radius * p[0] * basis.get_tangent_u() +
                 + disk_radius * p[1] * basis.get_tangent_v();
 
-            const float disk_point_prob = 1.0f / (Pi<float>() * square(static_cast<float>(disk_radius)));
+            float disk_point_prob;
+            if (m_guided_prob > 0.0f)
+            {
+                // Account for both emission strategies.
+                const Vector3d scene_disk_offset = m_scene_center - ray_origin;
+                const double scene_disk_square_dist =
+                    square_norm(scene_disk_offset - dot(scene_disk_offset, basis.get_normal()) * basis.get_normal());
+                const float scene_disk_prob =
+                    scene_disk_square_dist <= square(m_scene_radius)
+                        ? static_cast<float>(1.0 / (Pi<double>() * square(m_scene_radius)))
+                        : 0.0f;
+
+                disk_point_prob =
+                      (1.0f - m_guided_prob) * scene_disk_prob
+                    + m_guided_prob * evaluate_target_disks_pdf(m_visible_targets, ray_origin, basis.get_normal());
+            }
+            else
+                disk_point_prob = 1.0f / (Pi<float>() * square(static_cast<float>(disk_radius)));
+
+            if (disk_point_prob == 0.0f)
+                return;
 
             // Compute the initial particle weight.
             Spectrum initial_flux = env_edf_value;
@@ -760,6 +959,7 @@ namespace
 void SPPMPhotonTracer::trace_photons(
     SPPMPhotonVector&       photons,
     const size_t            pass_hash,
+    const LightTargetArray& visible_targets,
     JobQueue&               job_queue,
     IAbortSwitch&           abort_switch)
 {
@@ -774,25 +974,36 @@ void SPPMPhotonTracer::trace_photons(
         Transformd::identity(),
         photon_targets);
 
+    // Each job stores its photons into its own vector, so that jobs never contend
+    // and the final photon order does not depend on the order of job completion.
+    const bool trace_light_photons = m_light_sampler.has_lights_or_emitting_triangles();
+    const bool trace_env_photons = m_params.m_enable_ibl && m_scene.get_environment()->get_environment_edf();
+    size_t total_job_count = 0;
+    if (trace_light_photons)
+        total_job_count += get_job_count(m_params.m_light_photon_count);
+    if (trace_env_photons)
+        total_job_count += get_job_count(m_params.m_env_photon_count);
+    m_job_photons.resize(total_job_count);
+
     // Schedule photon tracing jobs.
     size_t job_count = 0;
     size_t emitted_photon_count = 0;
-    if (m_light_sampler.has_lights_or_emitting_triangles())
+    if (trace_light_photons)
     {
         schedule_light_photon_tracing_jobs(
             photon_targets,
-            photons,
+            visible_targets,
             pass_hash,
             job_queue,
             job_count,
             emitted_photon_count,
             abort_switch);
     }
-    if (m_params.m_enable_ibl && m_scene.get_environment()->get_environment_edf())
+    if (trace_env_photons)
     {
         schedule_environment_photon_tracing_jobs(
             photon_targets,
-            photons,
+            visible_targets,
             pass_hash,
             job_queue,
             job_count,
@@ -803,6 +1014,11 @@ void SPPMPhotonTracer::trace_photons(
     // Wait until the photon tracing jobs have completed.
     job_queue.wait_until_completion();
 
+    // Merge the photons of all jobs.
+    assert(job_count == total_job_count);
+    photons.append(m_job_photons);
+    m_job_photons.clear();
+
     // Update photon tracing statistics.
     m_total_emitted_photon_count += emitted_photon_count;
     m_total_stored_photon_count += photons.size();
@@ -823,9 +1039,14 @@ void SPPMPhotonTracer::trace_photons(
             statistics).to_string().c_str());
 }
 
+size_t SPPMPhotonTracer::get_job_count(const size_t photon_count) const
+{
+    return (photon_count + m_params.m_photon_packet_size - 1) / m_params.m_photon_packet_size;
+}
+
 void SPPMPhotonTracer::schedule_light_photon_tracing_jobs(
     const LightTargetArray& photon_targets,
-    SPPMPhotonVector&       photons,
+    const LightTargetArray& visible_targets,
     const size_t            pass_hash,
     JobQueue&               job_queue,
     size_t&                 job_count,
@@ -846,13 +1067,14 @@ void SPPMPhotonTracer::schedule_light_photon_tracing_jobs(
             new LightPhotonTracingJob(
                 m_scene,
                 photon_targets,
+                visible_targets,
                 m_light_sampler,
                 m_trace_context,
                 m_texture_store,
                 m_oiio_texture_system,
                 m_shading_system,
                 m_params,
-                photons,
+                m_job_photons[job_count],
                 photon_begin,
                 photon_end,
                 pass_hash,
@@ -865,7 +1087,7 @@ void SPPMPhotonTracer::schedule_light_photon_tracing_jobs(
 
 void SPPMPhotonTracer::schedule_environment_photon_tracing_jobs(
     const LightTargetArray& photon_targets,
-    SPPMPhotonVector&       photons,
+    const LightTargetArray& visible_targets,
     const size_t            pass_hash,
     JobQueue&               job_queue,
     size_t&                 job_count,
@@ -886,13 +1108,14 @@ void SPPMPhotonTracer::schedule_environment_photon_tracing_jobs(
             new EnvironmentPhotonTracingJob(
                 m_scene,
                 photon_targets,
+                visible_targets,
                 m_light_sampler,
                 m_trace_context,
                 m_texture_store,
                 m_oiio_texture_system,
                 m_shading_system,
                 m_params,
-                photons,
+                m_job_photons[job_count],
                 photon_begin,
                 photon_end,
                 pass_hash,
@@ -32,6 +32,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/lighting/sppm/sppmparameters.h"
+#include "renderer/kernel/lighting/sppm/sppmphoton.h"
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
@@ -50,6 +51,7 @@ END_OIIO_INCLUDES
 
 // Standard headers.
 #include <cstddef>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
@@ -57,7 +59,6 @@ namespace foundation    { class JobQueue; }
 namespace renderer      { class LightSampler; }
 namespace renderer      { class LightTargetArray; }
 namespace renderer      { class Scene; }
-namespace renderer      { class SPPMPhotonVector; }
 namespace renderer      { class TextureStore; }
 namespace renderer      { class TraceContext; }
 
@@ -77,9 +78,12 @@ class SPPMPhotonTracer
         OSL::ShadingSystem&         shading_system,
         const SPPMParameters&       params);
 
+    // Trace the photons of a pass, guiding part of them toward 'visible_targets'
+    // (if not empty) when guided emission is enabled.
     void trace_photons(
         SPPMPhotonVector&           photons,
         const size_t                pass_hash,
+        const LightTargetArray&     visible_targets,
         foundation::JobQueue&       job_queue,
         foundation::IAbortSwitch&   abort_switch);
 
@@ -93,10 +97,14 @@ class SPPMPhotonTracer
     size_t                          m_total_stored_photon_count;
     OIIO::TextureSystem&            m_oiio_texture_system;
     OSL::ShadingSystem&             m_shading_system;
+    std::vector<SPPMPhotonVector>   m_job_photons;      // photons stored by each tracing job
+
+    // Return the number of tracing jobs needed to trace a given number of photons.
+    size_t get_job_count(const size_t photon_count) const;
 
     void schedule_light_photon_tracing_jobs(
         const LightTargetArray&     photon_targets,
-        SPPMPhotonVector&           photons,
+        const LightTargetArray&     visible_targets,
         const size_t                pass_hash,
         foundation::JobQueue&       job_queue,
         size_t&                     job_count,
@@ -105,7 +113,7 @@ class SPPMPhotonTracer
 
     void schedule_environment_photon_tracing_jobs(
         const LightTargetArray&     photon_targets,
-        SPPMPhotonVector&           photons,
+        const LightTargetArray&     visible_targets,
         const size_t                pass_hash,
         foundation::JobQueue&       job_queue,
         size_t&                     job_count,
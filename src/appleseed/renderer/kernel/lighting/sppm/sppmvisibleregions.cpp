@@ -0,0 +1,103 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "sppmvisibleregions.h"
+
+// appleseed.renderer headers.
+#include "renderer/modeling/light/lighttarget.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+SPPMVisibleRegions::SPPMVisibleRegions(
+    const AABB3d&   scene_bbox,
+    const size_t    resolution)
+  : m_scene_bbox(scene_bbox)
+  , m_resolution(resolution)
+  , m_cells(resolution * resolution * resolution)
+{
+    assert(resolution > 0);
+
+    const Vector3f extent = m_scene_bbox.extent();
+
+    for (size_t i = 0; i < 3; ++i)
+        m_rcp_cell_extent[i] = extent[i] > 0.0f ? resolution / extent[i] : 0.0f;
+
+    // Keep targets from degenerating when all the visible points of a cell are very close.
+    m_target_margin = 0.05f * max_value(extent) / resolution;
+
+    clear();
+}
+
+void SPPMVisibleRegions::clear()
+{
+    for (size_t i = 0, e = m_cells.size(); i < e; ++i)
+        m_cells[i].invalidate();
+}
+
+void SPPMVisibleRegions::insert(const Vector3f& point)
+{
+    size_t cell_index = 0;
+
+    for (size_t i = 3; i-- > 0; )
+    {
+        const float x = (point[i] - m_scene_bbox.min[i]) * m_rcp_cell_extent[i];
+        const size_t c = x > 0.0f ? min(truncate<size_t>(x), m_resolution - 1) : 0;
+        cell_index = cell_index * m_resolution + c;
+    }
+
+    AdaptiveLock::ScopedLock lock(m_locks[cell_index % LockCount]);
+    m_cells[cell_index].insert(point);
+}
+
+void SPPMVisibleRegions::get_targets(LightTargetArray& targets) const
+{
+    for (size_t i = 0, e = m_cells.size(); i < e; ++i)
+    {
+        if (m_cells[i].is_valid())
+        {
+            AABB3f bbox = m_cells[i];
+            bbox.grow(Vector3f(m_target_margin));
+            targets.push_back(LightTarget(AABB3d(bbox)));
+        }
+    }
+}
+
+}   // namespace renderer
@@ -0,0 +1,86 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_RENDERER_KERNEL_LIGHTING_SPPM_SPPMVISIBLEREGIONS_H
+#define APPLESEED_RENDERER_KERNEL_LIGHTING_SPPM_SPPMVISIBLEREGIONS_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/thread.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace renderer  { class LightTargetArray; }
+
+namespace renderer
+{
+
+//
+// Regions of the scene seen by the camera, built from the points where the SPPM eye pass
+// gathers photons. The bounding box of the scene is divided into a regular grid and the
+// bounding box of the visible points falling into each cell is tracked.
+//
+
+class SPPMVisibleRegions
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    SPPMVisibleRegions(
+        const foundation::AABB3d&   scene_bbox,
+        const size_t                resolution);        // number of cells along each axis
+
+    // Remove all visible points.
+    void clear();
+
+    // Insert a visible point. Thread-safe.
+    void insert(const foundation::Vector3f& point);
+
+    // Append one light target per non-empty cell to 'targets'.
+    void get_targets(LightTargetArray& targets) const;
+
+  private:
+    enum { LockCount = 64 };
+
+    const foundation::AABB3f            m_scene_bbox;
+    const size_t                        m_resolution;
+    foundation::Vector3f                m_rcp_cell_extent;
+    float                               m_target_margin;
+    std::vector<foundation::AABB3f>     m_cells;
+    foundation::AdaptiveLock            m_locks[LockCount];
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_LIGHTING_SPPM_SPPMVISIBLEREGIONS_H
@@ -36,6 +36,7 @@
 #include "renderer/modeling/camera/camera.h"
 #include "renderer/modeling/input/source.h"
 #include "renderer/modeling/material/material.h"
+#include "renderer/modeling/object/object.h"
 #include "renderer/modeling/scene/scene.h"
 #include "renderer/modeling/shadergroup/shadergroup.h"
 
@@ -43,9 +44,11 @@
 #include "foundation/utility/string.h"
 
 // Standard headers.
+#include <algorithm>
 #include <string>
 
 using namespace foundation;
+using namespace std;
 
 namespace renderer
 {
@@ -73,6 +76,112 @@ Tracer::Tracer(
     }
 }
 
+void Tracer::trace_between(
+    const ShadingPoint&         origin,
+    const Vector3d              targets[],
+    const size_t                target_count,
+    const VisibilityFlags::Type ray_flags,
+    float                       transmissions[])
+{
+    if (m_assume_no_alpha_mapping)
+    {
+        const size_t MaxBatchSize = 16;
+
+        const ShadingPoint* parent_shading_points[MaxBatchSize];
+        for (size_t i = 0; i < MaxBatchSize; ++i)
+            parent_shading_points[i] = &origin;
+
+        for (size_t begin = 0; begin < target_count; begin += MaxBatchSize)
+        {
+            const size_t ray_count = min(target_count - begin, MaxBatchSize);
+
+            ShadingRay rays[MaxBatchSize];
+            for (size_t i = 0; i < ray_count; ++i)
+            {
+                const Vector3d direction = targets[begin + i] - origin.get_point();
+                const double dist = norm(direction);
+
+                rays[i] =
+                    ShadingRay(
+                        origin.get_biased_point(direction),
+                        direction / dist,
+                        0.0,                        // ray tmin
+                        dist * (1.0 - 1.0e-6),      // ray tmax
+                        origin.get_time(),
+                        ray_flags,
+                        origin.get_ray().m_depth + 1);
+            }
+
+            bool hits[MaxBatchSize];
+            m_intersector.trace_probe(rays, ray_count, hits, parent_shading_points);
+
+            for (size_t i = 0; i < ray_count; ++i)
+                transmissions[begin + i] = hits[i] ? 0.0f : 1.0f;
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < target_count; ++i)
+            transmissions[i] = trace_between(origin, targets[i], ray_flags);
+    }
+}
+
+void Tracer::trace_between(
+    const Vector3d              origins[],
+    const Vector3d              targets[],
+    const ShadingRay::Time      ray_times[],
+    const ShadingRay::DepthType ray_depths[],
+    const size_t                count,
+    const VisibilityFlags::Type ray_flags,
+    float                       transmissions[])
+{
+    if (m_assume_no_alpha_mapping)
+    {
+        const size_t MaxBatchSize = 16;
+
+        for (size_t begin = 0; begin < count; begin += MaxBatchSize)
+        {
+            const size_t ray_count = min(count - begin, MaxBatchSize);
+
+            ShadingRay rays[MaxBatchSize];
+            for (size_t i = 0; i < ray_count; ++i)
+            {
+                const Vector3d direction = targets[begin + i] - origins[begin + i];
+                const double dist = norm(direction);
+
+                rays[i] =
+                    ShadingRay(
+                        origins[begin + i],
+                        direction / dist,
+                        0.0,                        // ray tmin
+                        dist * (1.0 - 1.0e-6),      // ray tmax
+                        ray_times[begin + i],
+                        ray_flags,
+                        ray_depths[begin + i]);
+            }
+
+            bool hits[MaxBatchSize];
+            m_intersector.trace_probe(rays, ray_count, hits);
+
+            for (size_t i = 0; i < ray_count; ++i)
+                transmissions[begin + i] = hits[i] ? 0.0f : 1.0f;
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            transmissions[i] =
+                trace_between(
+                    origins[i],
+                    targets[i],
+                    ray_times[i],
+                    ray_flags,
+                    ray_depths[i]);
+        }
+    }
+}
+
 const ShadingPoint& Tracer::do_trace(
     const Vector3d&             origin,
     const Vector3d&             direction,
@@ -238,6 +347,17 @@ void Tracer::evaluate_alpha(
     const ShadingPoint&         shading_point,
     Alpha&                      alpha) const
 {
+    // Opaque and constant-alpha materials on triangles without an object alpha map
+    // are resolved from the classification made at frame begin, without shading.
+    const Material::RenderData& material_data = material.get_render_data();
+    if (material_data.m_opacity != Material::RenderData::VaryingAlpha &&
+        shading_point.is_triangle_primitive() &&
+        shading_point.get_object().get_alpha_map() == 0)
+    {
+        alpha.set(material_data.m_constant_alpha);
+        return;
+    }
+
     alpha = shading_point.get_alpha();
 
     // Apply OSL transparency if needed.
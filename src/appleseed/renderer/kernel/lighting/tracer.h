@@ -136,6 +136,26 @@ class Tracer
         const foundation::Vector3d&     target,
         const VisibilityFlags::Type     ray_flags);
 
+    // Compute the transmission between a point and several targets. When alpha
+    // mapping does not need to be considered, the rays are traced as a batch.
+    void trace_between(
+        const ShadingPoint&             origin,
+        const foundation::Vector3d      targets[],
+        const size_t                    target_count,
+        const VisibilityFlags::Type     ray_flags,
+        float                           transmissions[]);
+
+    // Compute the transmission between several pairs of points. When alpha
+    // mapping does not need to be considered, the rays are traced as a batch.
+    void trace_between(
+        const foundation::Vector3d      origins[],
+        const foundation::Vector3d      targets[],
+        const ShadingRay::Time          ray_times[],
+        const ShadingRay::DepthType     ray_depths[],
+        const size_t                    count,
+        const VisibilityFlags::Type     ray_flags,
+        float                           transmissions[]);
+
   private:
     const Intersector&                  m_intersector;
     TextureCache&                       m_texture_cache;
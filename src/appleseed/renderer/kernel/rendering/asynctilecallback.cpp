@@ -0,0 +1,360 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "asynctilecallback.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/otherwise.h"
+
+// Boost headers.
+#include "boost/atomic/atomic.hpp"
+#include "boost/lockfree/policies.hpp"
+#include "boost/lockfree/queue.hpp"
+#include "boost/thread/thread.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <set>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    const size_t MaxQueueCapacity = 65534;      // limit of boost::lockfree::queue with fixed_sized<true>
+    const uint32 ConsumerSleepTime = 1;         // in milliseconds
+
+    struct TileEvent
+    {
+        enum Type
+        {
+            PreRender,
+            PostRenderTile,
+            PostRender
+        };
+
+        Type            m_type;
+        const Frame*    m_frame;
+        size_t          m_x;
+        size_t          m_y;
+        size_t          m_width;
+        size_t          m_height;
+
+        // Two events report the same tile (or frame) if neither is less than the other.
+        bool operator<(const TileEvent& rhs) const
+        {
+            if (m_type != rhs.m_type)
+                return m_type < rhs.m_type;
+            if (m_frame != rhs.m_frame)
+                return m_frame < rhs.m_frame;
+            if (m_x != rhs.m_x)
+                return m_x < rhs.m_x;
+            return m_y < rhs.m_y;
+        }
+    };
+
+    class TileEventDispatcher
+      : public NonCopyable
+    {
+      public:
+        TileEventDispatcher(
+            ITileCallbackFactory*   factory,
+            const size_t            queue_capacity,
+            const bool              coalesce)
+          : m_callback(factory->create())
+          , m_coalesce(coalesce)
+          , m_queue(max<size_t>(min(queue_capacity, MaxQueueCapacity), 1))
+          , m_stop_consumer(false)
+          , m_pushed_event_count(0)
+          , m_delivered_event_count(0)
+          , m_coalesced_event_count(0)
+        {
+            m_consumer = new boost::thread(&TileEventDispatcher::consume, this);
+        }
+
+        ~TileEventDispatcher()
+        {
+            m_stop_consumer = true;
+            m_consumer->join();
+            delete m_consumer;
+
+            m_callback->release();
+        }
+
+        // Queue an event. Thread-safe. Only waits when the queue is full.
+        void push(const TileEvent& event)
+        {
+            while (!m_queue.push(event))
+                yield();
+
+            ++m_pushed_event_count;
+        }
+
+        // Wait until all events pushed so far are delivered.
+        void flush() const
+        {
+            const size_t pushed = m_pushed_event_count;
+
+            while (m_delivered_event_count + m_coalesced_event_count < pushed)
+                foundation::sleep(ConsumerSleepTime);
+        }
+
+        size_t get_delivered_event_count() const
+        {
+            return m_delivered_event_count;
+        }
+
+        size_t get_coalesced_event_count() const
+        {
+            return m_coalesced_event_count;
+        }
+
+      private:
+        typedef boost::lockfree::queue<
+            TileEvent,
+            boost::lockfree::fixed_sized<true>
+        > TileEventQueue;
+
+        ITileCallback*              m_callback;
+        const bool                  m_coalesce;
+        TileEventQueue              m_queue;
+        boost::atomic<bool>         m_stop_consumer;
+        boost::atomic<size_t>       m_pushed_event_count;
+        boost::atomic<size_t>       m_delivered_event_count;
+        boost::atomic<size_t>       m_coalesced_event_count;
+        boost::thread*              m_consumer;
+        vector<TileEvent>           m_batch;                // only accessed by the consumer thread
+        vector<bool>                m_skip;                 // only accessed by the consumer thread
+
+        void deliver(const TileEvent& event)
+        {
+            switch (event.m_type)
+            {
+              case TileEvent::PreRender:
+                m_callback->pre_render(event.m_x, event.m_y, event.m_width, event.m_height);
+                break;
+
+              case TileEvent::PostRenderTile:
+                m_callback->post_render_tile(event.m_frame, event.m_x, event.m_y);
+                break;
+
+              case TileEvent::PostRender:
+                m_callback->post_render(event.m_frame);
+                break;
+
+              assert_otherwise;
+            }
+        }
+
+        // Deliver all queued events. Return the number of events taken from the queue.
+        size_t drain()
+        {
+            m_batch.clear();
+
+            TileEvent event;
+            while (m_queue.pop(event))
+                m_batch.push_back(event);
+
+            const size_t event_count = m_batch.size();
+
+            // Only deliver the most recent report of a given tile or frame.
+            m_skip.assign(event_count, false);
+            if (m_coalesce)
+            {
+                set<TileEvent> reported;
+
+                for (size_t i = event_count; i-- > 0; )
+                {
+                    if (m_batch[i].m_type != TileEvent::PreRender && !reported.insert(m_batch[i]).second)
+                        m_skip[i] = true;
+                }
+            }
+
+            size_t coalesced_count = 0;
+
+            for (size_t i = 0; i < event_count; ++i)
+            {
+                if (m_skip[i])
+                    ++coalesced_count;
+                else deliver(m_batch[i]);
+            }
+
+            m_coalesced_event_count += coalesced_count;
+            m_delivered_event_count += event_count - coalesced_count;
+
+            return event_count;
+        }
+
+        void consume()
+        {
+            set_current_thread_name("tile callbacks");
+
+            while (true)
+            {
+                // Read the stop flag before draining so that no event pushed before the request is left behind.
+                const bool stop = m_stop_consumer;
+
+                if (drain() == 0)
+                {
+                    if (stop)
+                        break;
+
+                    foundation::sleep(ConsumerSleepTime);
+                }
+            }
+        }
+    };
+
+    class AsyncTileCallback
+      : public ITileCallback
+    {
+      public:
+        explicit AsyncTileCallback(TileEventDispatcher& dispatcher)
+          : m_dispatcher(dispatcher)
+        {
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            delete this;
+        }
+
+        virtual void pre_render(
+            const size_t    x,
+            const size_t    y,
+            const size_t    width,
+            const size_t    height) APPLESEED_OVERRIDE
+        {
+            TileEvent event;
+            event.m_type = TileEvent::PreRender;
+            event.m_frame = 0;
+            event.m_x = x;
+            event.m_y = y;
+            event.m_width = width;
+            event.m_height = height;
+            m_dispatcher.push(event);
+        }
+
+        virtual void post_render_tile(
+            const Frame*    frame,
+            const size_t    tile_x,
+            const size_t    tile_y) APPLESEED_OVERRIDE
+        {
+            TileEvent event;
+            event.m_type = TileEvent::PostRenderTile;
+            event.m_frame = frame;
+            event.m_x = tile_x;
+            event.m_y = tile_y;
+            event.m_width = 0;
+            event.m_height = 0;
+            m_dispatcher.push(event);
+        }
+
+        virtual void post_render(const Frame* frame) APPLESEED_OVERRIDE
+        {
+            TileEvent event;
+            event.m_type = TileEvent::PostRender;
+            event.m_frame = frame;
+            event.m_x = 0;
+            event.m_y = 0;
+            event.m_width = 0;
+            event.m_height = 0;
+            m_dispatcher.push(event);
+        }
+
+      private:
+        TileEventDispatcher& m_dispatcher;
+    };
+}
+
+
+//
+// AsyncTileCallbackFactory class implementation.
+//
+
+struct AsyncTileCallbackFactory::Impl
+{
+    TileEventDispatcher m_dispatcher;
+
+    Impl(
+        ITileCallbackFactory*   factory,
+        const size_t            queue_capacity,
+        const bool              coalesce)
+      : m_dispatcher(factory, queue_capacity, coalesce)
+    {
+    }
+};
+
+AsyncTileCallbackFactory::AsyncTileCallbackFactory(
+    ITileCallbackFactory*   factory,
+    const size_t            queue_capacity,
+    const bool              coalesce)
+  : impl(new Impl(factory, queue_capacity, coalesce))
+{
+}
+
+AsyncTileCallbackFactory::~AsyncTileCallbackFactory()
+{
+    delete impl;
+}
+
+void AsyncTileCallbackFactory::release()
+{
+    delete this;
+}
+
+ITileCallback* AsyncTileCallbackFactory::create()
+{
+    return new AsyncTileCallback(impl->m_dispatcher);
+}
+
+void AsyncTileCallbackFactory::flush()
+{
+    impl->m_dispatcher.flush();
+}
+
+size_t AsyncTileCallbackFactory::get_delivered_event_count() const
+{
+    return impl->m_dispatcher.get_delivered_event_count();
+}
+
+size_t AsyncTileCallbackFactory::get_coalesced_event_count() const
+{
+    return impl->m_dispatcher.get_coalesced_event_count();
+}
+
+}   // namespace renderer
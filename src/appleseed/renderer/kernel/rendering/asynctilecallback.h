@@ -0,0 +1,87 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_RENDERER_KERNEL_RENDERING_ASYNCTILECALLBACK_H
+#define APPLESEED_RENDERER_KERNEL_RENDERING_ASYNCTILECALLBACK_H
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/itilecallback.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+
+// Standard headers.
+#include <cstddef>
+
+namespace renderer
+{
+
+//
+// A tile callback factory that keeps slow tile callbacks from stalling rendering.
+//
+// Rendering threads push tile events into a bounded lock-free queue and continue;
+// a dedicated thread delivers them, in order of arrival, to a single tile callback
+// created by another factory. Rendering threads only wait when the queue is full.
+//
+// Optionally, an event reporting a rendered tile (or frame) is dropped if the same
+// tile (or frame) is reported again before the event could be delivered.
+//
+
+class AsyncTileCallbackFactory
+  : public ITileCallbackFactory
+{
+  public:
+    // Constructor. 'factory' must outlive this factory.
+    AsyncTileCallbackFactory(
+        ITileCallbackFactory*   factory,
+        const size_t            queue_capacity = 1024,
+        const bool              coalesce = false);
+
+    // Destructor, delivers pending events.
+    ~AsyncTileCallbackFactory();
+
+    virtual void release() APPLESEED_OVERRIDE;
+
+    virtual ITileCallback* create() APPLESEED_OVERRIDE;
+
+    // Wait until all events pushed so far are delivered.
+    void flush();
+
+    // Return the number of events delivered, and dropped because they were coalesced.
+    size_t get_delivered_event_count() const;
+    size_t get_coalesced_event_count() const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_RENDERING_ASYNCTILECALLBACK_H
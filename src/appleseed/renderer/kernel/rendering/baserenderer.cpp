@@ -34,13 +34,18 @@
 #include "renderer/kernel/rendering/oiioerrorhandler.h"
 #include "renderer/kernel/rendering/rendererservices.h"
 #include "renderer/kernel/shading/closures.h"
+#include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/modeling/project/project.h"
 #include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/shadergroup/shadergroup.h"
+#include "renderer/utility/settingsparsing.h"
 
 // appleseed.foundation headers.
 #include "foundation/platform/compiler.h"
+#include "foundation/utility/string.h"
 
 // Standard headers.
+#include <algorithm>
 #include <string>
 
 using namespace foundation;
@@ -58,6 +63,11 @@ BaseRenderer::BaseRenderer(
     const ParamArray&       params)
   : m_project(project)
   , m_params(params)
+  , m_texture_memory_budget(m_params.child("texture_store"))
+  , m_texture_store_access_count(0)
+  , m_texture_store_miss_count(0)
+  , m_oiio_access_count(0)
+  , m_oiio_miss_count(0)
 {
     m_error_handler = new OIIOErrorHandler();
 #ifndef NDEBUG
@@ -139,22 +149,86 @@ bool BaseRenderer::initialize_shading_system(
     TextureStore& texture_store,
     IAbortSwitch& abort_switch)
 {
-    initialize_oiio();
+    initialize_oiio(texture_store);
     return initialize_osl(texture_store, abort_switch);
 }
 
-void BaseRenderer::initialize_oiio()
+void BaseRenderer::set_texture_memory_size(const size_t size)
 {
-    const ParamArray& params = m_params.child("texture_store");
+    m_texture_memory_budget.set_total_size(size);
+}
+
+void BaseRenderer::update_texture_memory_budget(TextureStore& texture_store)
+{
+    // Lookups that miss the per-thread microcache of OIIO reach its shared cache,
+    // like lookups that miss appleseed's per-thread texture caches reach the store.
+    long long oiio_access_count = 0;
+    int oiio_miss_count = 0;
+    m_texture_system->getattribute("stat:find_tile_microcache_misses", OIIO::TypeDesc::INT64, &oiio_access_count);
+    m_texture_system->getattribute("stat:find_tile_cache_misses", OIIO::TypeDesc::INT, &oiio_miss_count);
+
+    const uint64 texture_store_access_count = texture_store.get_access_count();
+    const uint64 texture_store_miss_count = texture_store.get_miss_count();
+
+    // Counters are cumulative: only consider their increase since the previous update.
+    m_texture_memory_budget.update(
+        texture_store_access_count - m_texture_store_access_count,
+        texture_store_miss_count - m_texture_store_miss_count,
+        max<uint64>(static_cast<uint64>(oiio_access_count), m_oiio_access_count) - m_oiio_access_count,
+        max<uint64>(static_cast<uint64>(oiio_miss_count), m_oiio_miss_count) - m_oiio_miss_count);
+
+    m_texture_store_access_count = texture_store_access_count;
+    m_texture_store_miss_count = texture_store_miss_count;
+    m_oiio_access_count = max<uint64>(static_cast<uint64>(oiio_access_count), m_oiio_access_count);
+    m_oiio_miss_count = max<uint64>(static_cast<uint64>(oiio_miss_count), m_oiio_miss_count);
+
+    if (m_texture_memory_budget.is_shared())
+        apply_texture_memory_budget(texture_store);
+}
 
-    const size_t texture_cache_size_bytes =
-        params.get_optional<size_t>("max_size", 256 * 1024 * 1024);
-    RENDERER_LOG_INFO(
-        "setting oiio texture cache size to %s.",
-        pretty_size(texture_cache_size_bytes).c_str());
-    const float texture_cache_size_mb =
-        static_cast<float>(texture_cache_size_bytes) / (1024 * 1024);
-    m_texture_system->attribute("max_memory_MB", texture_cache_size_mb);
+StatisticsVector BaseRenderer::get_texture_memory_statistics() const
+{
+    return m_texture_memory_budget.get_statistics();
+}
+
+void BaseRenderer::apply_texture_memory_budget(TextureStore& texture_store)
+{
+    const size_t texture_store_size = m_texture_memory_budget.get_texture_store_size();
+    const size_t oiio_size = m_texture_memory_budget.get_oiio_size();
+
+    RENDERER_LOG_DEBUG(
+        "dividing texture memory budget of %s: %s for the texture store, %s for the oiio texture cache.",
+        pretty_size(m_texture_memory_budget.get_total_size()).c_str(),
+        pretty_size(texture_store_size).c_str(),
+        pretty_size(oiio_size).c_str());
+
+    texture_store.set_memory_limit(texture_store_size);
+    m_texture_system->attribute("max_memory_MB", static_cast<float>(oiio_size) / (1024 * 1024));
+}
+
+void BaseRenderer::initialize_oiio(TextureStore& texture_store)
+{
+    // The texture store of this rendering session has not been accessed yet.
+    m_texture_store_access_count = 0;
+    m_texture_store_miss_count = 0;
+
+    if (m_texture_memory_budget.is_shared())
+    {
+        RENDERER_LOG_INFO(
+            "sharing a texture memory budget of %s between the texture store and the oiio texture cache.",
+            pretty_size(m_texture_memory_budget.get_total_size()).c_str());
+        apply_texture_memory_budget(texture_store);
+    }
+    else
+    {
+        const size_t texture_cache_size_bytes = m_texture_memory_budget.get_oiio_size();
+        RENDERER_LOG_INFO(
+            "setting oiio texture cache size to %s.",
+            pretty_size(texture_cache_size_bytes).c_str());
+        const float texture_cache_size_mb =
+            static_cast<float>(texture_cache_size_bytes) / (1024 * 1024);
+        m_texture_system->attribute("max_memory_MB", texture_cache_size_mb);
+    }
 
     string prev_search_path;
     m_texture_system->getattribute("searchpath", prev_search_path);
@@ -184,10 +258,33 @@ bool BaseRenderer::initialize_osl(TextureStore& texture_store, IAbortSwitch& abo
     }
 
     // Re-optimize the shader groups that need updating.
-    return
+    ShaderGroupCache shader_group_cache;
+    const bool success =
         m_project.get_scene()->create_optimized_osl_shader_groups(
             *m_shading_system,
+            &abort_switch,
+            &shader_group_cache);
+
+    // Optimize the declared shader groups in parallel.
+    const bool optimization_success =
+        shader_group_cache.optimize_shader_groups(
+            *m_shading_system,
+            get_rendering_thread_count(m_params),
             &abort_switch);
+
+    shader_group_cache.report_optimization_times(10);
+
+    const size_t shared_group_count = shader_group_cache.get_shared_group_count();
+    if (shared_group_count > 0)
+    {
+        RENDERER_LOG_INFO(
+            "reused optimized osl shader groups for %s identical shader group%s, saving %s of shader setup.",
+            pretty_uint(shared_group_count).c_str(),
+            shared_group_count > 1 ? "s" : "",
+            pretty_time(shader_group_cache.get_saved_time()).c_str());
+    }
+
+    return success && optimization_success;
 }
 
 }   // namespace renderer
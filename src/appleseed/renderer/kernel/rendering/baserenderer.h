@@ -30,10 +30,13 @@
 #define APPLESEED_RENDERER_KERNEL_RENDERING_BASERENDERER_H
 
 // appleseed.renderer headers.
+#include "renderer/kernel/texturing/texturememorybudget.h"
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/statistics.h"
 
 // appleseed.main headers.
 #include "main/dllsymbol.h"
@@ -93,8 +96,26 @@ class APPLESEED_DLLSYMBOL BaseRenderer
         Project&                    project,
         const ParamArray&           params);
 
+    // Change the texture memory budget before the texture caches are initialized.
+    void set_texture_memory_size(const size_t size);
+
+    // Record the texture lookups and misses since the previous call and, if the texture
+    // memory budget is shared, divide it again between the texture store and OIIO.
+    void update_texture_memory_budget(TextureStore& texture_store);
+
+    // Return the combined statistics of the texture store and of the OIIO texture cache.
+    foundation::StatisticsVector get_texture_memory_statistics() const;
+
   private:
-    void initialize_oiio();
+    TextureMemoryBudget             m_texture_memory_budget;
+    foundation::uint64              m_texture_store_access_count;
+    foundation::uint64              m_texture_store_miss_count;
+    foundation::uint64              m_oiio_access_count;
+    foundation::uint64              m_oiio_miss_count;
+
+    void initialize_oiio(TextureStore& texture_store);
+
+    void apply_texture_memory_budget(TextureStore& texture_store);
 
     bool initialize_osl(
         TextureStore&               texture_store,
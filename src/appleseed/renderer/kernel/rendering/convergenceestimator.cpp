@@ -0,0 +1,262 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Interface header.
+#include "convergenceestimator.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/analysis.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/math/scalar.h"
+#include "foundation/platform/thread.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// ConvergenceEstimator class implementation.
+//
+
+namespace
+{
+    class ComputeTileErrors
+    {
+      public:
+        ComputeTileErrors(
+            const Image&                    image,
+            const Image&                    snapshot,
+            vector<double>&                 tile_errors,
+            size_t&                         next_tile_index,
+            boost::mutex&                   mutex)
+          : m_image(image)
+          , m_snapshot(snapshot)
+          , m_tile_errors(tile_errors)
+          , m_next_tile_index(next_tile_index)
+          , m_mutex(mutex)
+        {
+        }
+
+        void operator()()
+        {
+            const CanvasProperties& props = m_image.properties();
+
+            while (true)
+            {
+                size_t tile_index;
+
+                {
+                    boost::mutex::scoped_lock lock(m_mutex);
+                    tile_index = m_next_tile_index++;
+                }
+
+                if (tile_index >= props.m_tile_count)
+                    break;
+
+                const size_t tile_x = tile_index % props.m_tile_count_x;
+                const size_t tile_y = tile_index / props.m_tile_count_x;
+
+                m_tile_errors[tile_index] =
+                    compute_relative_rms_deviation(
+                        m_snapshot.tile(tile_x, tile_y),
+                        m_image.tile(tile_x, tile_y));
+            }
+        }
+
+      private:
+        const Image&                        m_image;
+        const Image&                        m_snapshot;
+        vector<double>&                     m_tile_errors;
+        size_t&                             m_next_tile_index;
+        boost::mutex&                       m_mutex;
+    };
+}
+
+struct ConvergenceEstimator::Impl
+{
+    // Only accessed by update().
+    auto_ptr<Image>                         m_snapshot;
+    uint64                                  m_snapshot_sample_count;
+
+    // Protected by m_mutex.
+    mutable boost::mutex                    m_mutex;
+    vector<double>                          m_tile_errors;
+    size_t                                  m_tile_count_x;
+    double                                  m_error;                // error at m_error_sample_count samples
+    uint64                                  m_error_sample_count;   // 0 if there is no estimate yet
+    uint64                                  m_sample_count;         // sample count of the last update
+};
+
+ConvergenceEstimator::ConvergenceEstimator()
+  : impl(new Impl())
+{
+    clear();
+}
+
+ConvergenceEstimator::~ConvergenceEstimator()
+{
+    delete impl;
+}
+
+void ConvergenceEstimator::clear()
+{
+    impl->m_snapshot.reset();
+    impl->m_snapshot_sample_count = 0;
+
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+    impl->m_tile_errors.clear();
+    impl->m_tile_count_x = 0;
+    impl->m_error = 0.0;
+    impl->m_error_sample_count = 0;
+    impl->m_sample_count = 0;
+}
+
+void ConvergenceEstimator::update(
+    const Image&                image,
+    const uint64                sample_count,
+    const size_t                thread_count)
+{
+    const CanvasProperties& props = image.properties();
+
+    if (sample_count < props.m_pixel_count)
+        return;
+
+    {
+        boost::mutex::scoped_lock lock(impl->m_mutex);
+        impl->m_sample_count = sample_count;
+    }
+
+    // Take the first snapshot.
+    if (impl->m_snapshot.get() == 0)
+    {
+        impl->m_snapshot.reset(new Image(image));
+        impl->m_snapshot_sample_count = sample_count;
+        return;
+    }
+
+    // Wait until the number of samples has at least doubled since the snapshot.
+    if (sample_count < 2 * impl->m_snapshot_sample_count)
+        return;
+
+    // Copy the image since it may keep changing while it is being compared.
+    auto_ptr<Image> current(new Image(image));
+
+    // Compare the image to the snapshot, one tile at a time.
+    vector<double> tile_errors(props.m_tile_count);
+    size_t next_tile_index = 0;
+    boost::mutex mutex;
+    ComputeTileErrors compute(*current, *impl->m_snapshot, tile_errors, next_tile_index, mutex);
+    const size_t worker_count = min(thread_count, props.m_tile_count);
+    if (worker_count > 1)
+    {
+        boost::thread_group threads;
+        for (size_t i = 0; i < worker_count; ++i)
+            threads.create_thread(compute);
+        threads.join_all();
+    }
+    else compute();
+
+    // The snapshot contributes 1/k of the samples of the current image, where k is the
+    // ratio of their sample counts: the variance of their difference is (k - 1) times
+    // the variance of the current image.
+    const double k =
+        static_cast<double>(sample_count) / impl->m_snapshot_sample_count;
+    const double rcp_deviation_scale = 1.0 / sqrt(k - 1.0);
+
+    double mse = 0.0;
+    for (size_t i = 0; i < props.m_tile_count; ++i)
+    {
+        tile_errors[i] *= rcp_deviation_scale;
+
+        const size_t tile_x = i % props.m_tile_count_x;
+        const size_t tile_y = i / props.m_tile_count_x;
+        const size_t tile_pixel_count =
+            props.get_tile_width(tile_x) * props.get_tile_height(tile_y);
+
+        mse += square(tile_errors[i]) * tile_pixel_count;
+    }
+
+    {
+        boost::mutex::scoped_lock lock(impl->m_mutex);
+        impl->m_tile_errors.swap(tile_errors);
+        impl->m_tile_count_x = props.m_tile_count_x;
+        impl->m_error = sqrt(mse / props.m_pixel_count);
+        impl->m_error_sample_count = sample_count;
+    }
+
+    impl->m_snapshot = current;
+    impl->m_snapshot_sample_count = sample_count;
+}
+
+bool ConvergenceEstimator::has_estimate() const
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+    return impl->m_error_sample_count > 0;
+}
+
+double ConvergenceEstimator::get_error() const
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    if (impl->m_error_sample_count == 0)
+        return 0.0;
+
+    // The error decreases with the square root of the number of samples.
+    return
+        impl->m_error *
+        sqrt(static_cast<double>(impl->m_error_sample_count) / impl->m_sample_count);
+}
+
+double ConvergenceEstimator::get_tile_error(
+    const size_t                tile_x,
+    const size_t                tile_y) const
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    if (impl->m_tile_errors.empty())
+        return 0.0;
+
+    const size_t tile_index = tile_y * impl->m_tile_count_x + tile_x;
+    assert(tile_index < impl->m_tile_errors.size());
+
+    return impl->m_tile_errors[tile_index];
+}
+
+}   // namespace renderer
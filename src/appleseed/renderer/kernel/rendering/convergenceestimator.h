@@ -0,0 +1,100 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef APPLESEED_RENDERER_KERNEL_RENDERING_CONVERGENCEESTIMATOR_H
+#define APPLESEED_RENDERER_KERNEL_RENDERING_CONVERGENCEESTIMATOR_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class Image; }
+
+namespace renderer
+{
+
+//
+// Estimates the noise remaining in a progressively rendered image, without a reference image.
+//
+// The image is compared to a snapshot of itself taken when it had half as many samples.
+// For a Monte Carlo estimate, the deviation between the two is, on average, equal to the
+// error of the current image. Between two comparisons, the error is extrapolated assuming
+// it decreases with the square root of the number of samples.
+//
+
+class APPLESEED_DLLSYMBOL ConvergenceEstimator
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    ConvergenceEstimator();
+
+    // Destructor.
+    ~ConvergenceEstimator();
+
+    // Forget the snapshot and all estimates.
+    void clear();
+
+    // Update the estimates given an image developed from a total of 'sample_count' samples.
+    // Images with less than one sample per pixel are ignored. The tile errors are computed
+    // in parallel by 'thread_count' threads. Must not be called concurrently.
+    void update(
+        const foundation::Image&    image,
+        const foundation::uint64    sample_count,
+        const size_t                thread_count);
+
+    // Return true if an error estimate is available. Thread-safe.
+    bool has_estimate() const;
+
+    // Return the estimated relative RMS error of the image at the sample count
+    // given to the last call to update(). Thread-safe.
+    double get_error() const;
+
+    // Return the estimated relative RMS error of a given tile, at the sample count
+    // at which it was last estimated. Thread-safe.
+    double get_tile_error(
+        const size_t                tile_x,
+        const size_t                tile_y) const;
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_RENDERING_CONVERGENCEESTIMATOR_H
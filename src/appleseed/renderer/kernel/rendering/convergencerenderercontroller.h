@@ -0,0 +1,74 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef APPLESEED_RENDERER_KERNEL_RENDERING_CONVERGENCERENDERERCONTROLLER_H
+#define APPLESEED_RENDERER_KERNEL_RENDERING_CONVERGENCERENDERERCONTROLLER_H
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/defaultrenderercontroller.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Forward declarations.
+namespace renderer      { class ConvergenceEstimator; }
+
+namespace renderer
+{
+
+//
+// A renderer controller that terminates rendering once the estimated error of the
+// image falls below a target. The estimator is updated by the progressive frame
+// renderer when its "estimate_convergence" parameter is set.
+//
+
+class APPLESEED_DLLSYMBOL ConvergenceRendererController
+  : public DefaultRendererController
+{
+  public:
+    // Constructor.
+    ConvergenceRendererController(
+        const ConvergenceEstimator& estimator,
+        const double                target_error);      // relative RMS error
+
+    // Return the current rendering status.
+    virtual Status get_status() const APPLESEED_OVERRIDE;
+
+  private:
+    const ConvergenceEstimator&     m_estimator;
+    const double                    m_target_error;
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_RENDERING_CONVERGENCERENDERERCONTROLLER_H
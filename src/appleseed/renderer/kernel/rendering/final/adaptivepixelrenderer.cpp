@@ -179,18 +179,21 @@ namespace
 
             m_scratch_fb->clear();
 
-            // Create a sampling context.
+            // Create a sampling context. In blue noise mode, all pixels share the same
+            // sequences and are decorrelated by the blue noise mask instead.
             const size_t frame_width = frame.image().properties().m_canvas_width;
             const size_t instance =
                 mix_uint32(
                     static_cast<uint32>(pass_hash),
-                    static_cast<uint32>(pi.y * frame_width + pi.x));
+                    m_params.m_blue_noise ? 0 : static_cast<uint32>(pi.y * frame_width + pi.x));
             SamplingContext sampling_context(
                 rng,
                 m_params.m_sampling_mode,
                 2,                          // number of dimensions
                 0,                          // number of samples -- unknown
                 instance);                  // initial instance number
+            if (m_params.m_blue_noise)
+                sampling_context.set_blue_noise_pixel(pi.x, pi.y);
 
             VariationTracker trackers[3];
 
@@ -313,6 +316,7 @@ namespace
         struct Parameters
         {
             const SamplingContext::Mode     m_sampling_mode;
+            const bool                      m_blue_noise;
             const size_t                    m_min_samples;
             const size_t                    m_max_samples;
             const float                     m_max_variation;
@@ -320,6 +324,7 @@ namespace
 
             explicit Parameters(const ParamArray& params)
               : m_sampling_mode(get_sampling_context_mode(params))
+              , m_blue_noise(params.get_optional<bool>("blue_noise", false))
               , m_min_samples(params.get_required<size_t>("min_samples", 16))
               , m_max_samples(params.get_required<size_t>("max_samples", 256))
               , m_max_variation(pow(10.0f, -params.get_optional<float>("quality", 2.0f)))
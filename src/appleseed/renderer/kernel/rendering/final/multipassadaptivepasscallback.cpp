@@ -0,0 +1,221 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "multipassadaptivepasscallback.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/modeling/frame/frame.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/scalar.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    // Luminance added to the mean luminance of a pixel when computing its relative
+    // noise, so that very dark pixels are not considered noisy forever.
+    const float DarkLuminance = 1.0e-3f;
+
+    // Maximum number of samples a single pixel may receive in one pass,
+    // as a multiple of the average number of samples per pixel and per pass.
+    const size_t MaxPassSampleFactor = 8;
+}
+
+
+//
+// MultipassAdaptivePassCallback class implementation.
+//
+
+MultipassAdaptivePassCallback::Parameters::Parameters(const ParamArray& params)
+  : m_samples(max<size_t>(params.get_required<size_t>("samples", 16), 2))
+  , m_max_samples(params.get_optional<size_t>("max_samples", 1024))
+  , m_max_error(pow(10.0f, -params.get_optional<float>("quality", 2.0f)))
+{
+}
+
+MultipassAdaptivePassCallback::MultipassAdaptivePassCallback(const ParamArray& params)
+  : m_params(params)
+  , m_pass_number(0)
+  , m_frame_width(0)
+{
+}
+
+void MultipassAdaptivePassCallback::release()
+{
+    delete this;
+}
+
+void MultipassAdaptivePassCallback::pre_render(
+    const Frame&            frame,
+    JobQueue&               job_queue,
+    IAbortSwitch&           abort_switch)
+{
+    if (m_pass_number > 0)
+        return;
+
+    // The first pass renders the same number of samples in every pixel.
+    const CanvasProperties& props = frame.image().properties();
+    const AABB2u& crop_window = frame.get_crop_window();
+
+    PixelStatistics empty_pixel;
+    empty_pixel.m_sample_count = 0;
+    empty_pixel.m_pass_sample_count = 0;
+    empty_pixel.m_valid_sample_count = 0;
+    empty_pixel.m_mean = 0.0f;
+    empty_pixel.m_m2 = 0.0f;
+
+    m_frame_width = props.m_canvas_width;
+    m_pixels.assign(props.m_pixel_count, empty_pixel);
+
+    for (size_t y = crop_window.min.y; y <= crop_window.max.y; ++y)
+    {
+        for (size_t x = crop_window.min.x; x <= crop_window.max.x; ++x)
+            m_pixels[y * m_frame_width + x].m_pass_sample_count = static_cast<uint32>(m_params.m_samples);
+    }
+}
+
+bool MultipassAdaptivePassCallback::post_render(
+    const Frame&            frame,
+    JobQueue&               job_queue,
+    IAbortSwitch&           abort_switch)
+{
+    ++m_pass_number;
+
+    // Stop there if all pixels have converged.
+    return allocate_samples(frame) == 0;
+}
+
+size_t MultipassAdaptivePassCallback::allocate_samples(const Frame& frame)
+{
+    const AABB2u& crop_window = frame.get_crop_window();
+    const size_t pixel_count = (crop_window.extent(0) + 1) * (crop_window.extent(1) + 1);
+
+    // Compute the number of additional samples needed by each pixel.
+    uint64 total_sample_count = 0;
+    uint64 needed_sample_count = 0;
+    size_t converged_pixel_count = 0;
+
+    for (size_t y = crop_window.min.y; y <= crop_window.max.y; ++y)
+    {
+        for (size_t x = crop_window.min.x; x <= crop_window.max.x; ++x)
+        {
+            PixelStatistics& pixel = m_pixels[y * m_frame_width + x];
+            pixel.m_sample_count += pixel.m_pass_sample_count;
+            pixel.m_pass_sample_count = static_cast<uint32>(compute_needed_sample_count(pixel));
+
+            total_sample_count += pixel.m_sample_count;
+            needed_sample_count += pixel.m_pass_sample_count;
+
+            if (pixel.m_pass_sample_count == 0)
+                ++converged_pixel_count;
+        }
+    }
+
+    // Scale allocations down to the sample budget of a pass, diffusing rounding errors
+    // from one pixel to the next so that the budget is neither exceeded nor wasted.
+    const uint64 budget = static_cast<uint64>(m_params.m_samples) * pixel_count;
+
+    if (needed_sample_count > budget)
+    {
+        const double scale = static_cast<double>(budget) / needed_sample_count;
+        double residual = 0.0;
+        needed_sample_count = 0;
+
+        for (size_t y = crop_window.min.y; y <= crop_window.max.y; ++y)
+        {
+            for (size_t x = crop_window.min.x; x <= crop_window.max.x; ++x)
+            {
+                PixelStatistics& pixel = m_pixels[y * m_frame_width + x];
+
+                if (pixel.m_pass_sample_count > 0)
+                {
+                    residual += scale * pixel.m_pass_sample_count;
+                    const double allocated = floor(residual);
+                    residual -= allocated;
+
+                    pixel.m_pass_sample_count = static_cast<uint32>(allocated);
+                    needed_sample_count += pixel.m_pass_sample_count;
+                }
+            }
+        }
+    }
+
+    RENDERER_LOG_INFO(
+        "adaptive sampling: %s of the pixels converged after %s pass%s, %s samples/pixel on average, "
+        "%s samples/pixel allocated to the next pass.",
+        pretty_percent(converged_pixel_count, pixel_count).c_str(),
+        pretty_uint(m_pass_number).c_str(),
+        m_pass_number > 1 ? "es" : "",
+        pretty_ratio(total_sample_count, static_cast<uint64>(pixel_count)).c_str(),
+        pretty_ratio(needed_sample_count, static_cast<uint64>(pixel_count)).c_str());
+
+    return pixel_count - converged_pixel_count;
+}
+
+size_t MultipassAdaptivePassCallback::compute_needed_sample_count(const PixelStatistics& pixel) const
+{
+    // Pixels that reached the maximum number of samples are done.
+    if (pixel.m_sample_count >= m_params.m_max_samples)
+        return 0;
+
+    const size_t max_pass_samples =
+        min(m_params.m_max_samples - pixel.m_sample_count, MaxPassSampleFactor * m_params.m_samples);
+
+    // Without any variance estimate, render another pass worth of samples.
+    if (pixel.m_valid_sample_count < 2)
+        return min(m_params.m_samples, max_pass_samples);
+
+    // Compute the relative standard error of the mean luminance of the pixel.
+    const float n = static_cast<float>(pixel.m_valid_sample_count);
+    const float variance = pixel.m_m2 / (n - 1.0f);
+    const float error = sqrt(variance / n) / (abs(pixel.m_mean) + DarkLuminance);
+
+    if (error <= m_params.m_max_error)
+        return 0;
+
+    // The standard error decreases with the square root of the number of samples.
+    const float needed = n * (square(error / m_params.m_max_error) - 1.0f);
+
+    return min(static_cast<size_t>(ceil(needed)), max_pass_samples);
+}
+
+}   // namespace renderer
@@ -0,0 +1,169 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_RENDERER_KERNEL_RENDERING_FINAL_MULTIPASSADAPTIVEPASSCALLBACK_H
+#define APPLESEED_RENDERER_KERNEL_RENDERING_FINAL_MULTIPASSADAPTIVEPASSCALLBACK_H
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/ipasscallback.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class IAbortSwitch; }
+namespace foundation    { class JobQueue; }
+namespace renderer      { class Frame; }
+
+namespace renderer
+{
+
+//
+// This class keeps per-pixel luminance statistics across the passes of a multi-pass
+// render, and uses them to distribute a fixed sample budget over the whole frame:
+// after each pass, the samples of the next pass go to the pixels whose estimated
+// noise is still above the target noise level, in proportion to the number of
+// samples they still need. Rendering stops when all pixels have converged.
+//
+// The first pass is uniform. The noise of a pixel is the standard error of its
+// mean luminance, relative to that mean.
+//
+
+class MultipassAdaptivePassCallback
+  : public IPassCallback
+{
+  public:
+    // Constructor.
+    explicit MultipassAdaptivePassCallback(const ParamArray& params);
+
+    // Delete this instance.
+    virtual void release() APPLESEED_OVERRIDE;
+
+    // This method is called at the beginning of a pass.
+    virtual void pre_render(
+        const Frame&                frame,
+        foundation::JobQueue&       job_queue,
+        foundation::IAbortSwitch&   abort_switch) APPLESEED_OVERRIDE;
+
+    // This method is called at the end of a pass.
+    virtual bool post_render(
+        const Frame&                frame,
+        foundation::JobQueue&       job_queue,
+        foundation::IAbortSwitch&   abort_switch) APPLESEED_OVERRIDE;
+
+    // Return the number of samples allocated to a given pixel for the current pass.
+    size_t get_pass_sample_count(
+        const size_t                x,
+        const size_t                y) const;
+
+    // Merge the luminance statistics of the valid samples taken in a given pixel
+    // during the current pass: their count, their mean and the sum of their squared
+    // differences to the mean. Must be called at most once per pixel and per pass.
+    void insert(
+        const size_t                x,
+        const size_t                y,
+        const size_t                sample_count,
+        const float                 mean,
+        const float                 m2);
+
+  private:
+    struct Parameters
+    {
+        const size_t                m_samples;          // average number of samples per pixel and per pass
+        const size_t                m_max_samples;      // maximum number of samples per pixel
+        const float                 m_max_error;        // target noise level
+
+        explicit Parameters(const ParamArray& params);
+    };
+
+    struct PixelStatistics
+    {
+        foundation::uint32          m_sample_count;         // total number of samples rendered
+        foundation::uint32          m_pass_sample_count;    // number of samples allocated to the current pass
+        foundation::uint32          m_valid_sample_count;   // number of samples in the statistics
+        float                       m_mean;                 // mean luminance
+        float                       m_m2;                   // sum of squared differences to the mean luminance
+    };
+
+    const Parameters                m_params;
+    size_t                          m_pass_number;
+    size_t                          m_frame_width;
+    std::vector<PixelStatistics>    m_pixels;
+
+    // Allocate the samples of the next pass. Return the number of pixels that received samples.
+    size_t allocate_samples(const Frame& frame);
+
+    // Return the number of additional samples a pixel needs to reach the target noise level.
+    size_t compute_needed_sample_count(const PixelStatistics& pixel) const;
+};
+
+
+//
+// MultipassAdaptivePassCallback class implementation.
+//
+
+inline size_t MultipassAdaptivePassCallback::get_pass_sample_count(
+    const size_t                    x,
+    const size_t                    y) const
+{
+    assert(y * m_frame_width + x < m_pixels.size());
+    return m_pixels[y * m_frame_width + x].m_pass_sample_count;
+}
+
+inline void MultipassAdaptivePassCallback::insert(
+    const size_t                    x,
+    const size_t                    y,
+    const size_t                    sample_count,
+    const float                     mean,
+    const float                     m2)
+{
+    assert(y * m_frame_width + x < m_pixels.size());
+
+    if (sample_count == 0)
+        return;
+
+    // Merge the statistics using the pairwise update of Chan et al.
+    PixelStatistics& pixel = m_pixels[y * m_frame_width + x];
+    const float n_a = static_cast<float>(pixel.m_valid_sample_count);
+    const float n_b = static_cast<float>(sample_count);
+    const float n = n_a + n_b;
+    const float delta = mean - pixel.m_mean;
+    pixel.m_mean += delta * (n_b / n);
+    pixel.m_m2 += m2 + delta * delta * (n_a * n_b / n);
+    pixel.m_valid_sample_count += static_cast<foundation::uint32>(sample_count);
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_RENDERING_FINAL_MULTIPASSADAPTIVEPASSCALLBACK_H
@@ -0,0 +1,267 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "multipassadaptivepixelrenderer.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/aov/imagestack.h"
+#include "renderer/kernel/rendering/final/multipassadaptivepasscallback.h"
+#include "renderer/kernel/rendering/isamplerenderer.h"
+#include "renderer/kernel/rendering/pixelcontext.h"
+#include "renderer/kernel/rendering/pixelrendererbase.h"
+#include "renderer/kernel/rendering/shadingresultframebuffer.h"
+#include "renderer/kernel/shading/shadingresult.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/utility/settingsparsing.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/colorspace.h"
+#include "foundation/image/image.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/hash.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/statistics.h"
+
+// Forward declarations.
+namespace foundation    { class Tile; }
+namespace renderer      { class TileStack; }
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    //
+    // Multi-pass adaptive pixel renderer.
+    //
+
+    class MultipassAdaptivePixelRenderer
+      : public PixelRendererBase
+    {
+      public:
+        MultipassAdaptivePixelRenderer(
+            MultipassAdaptivePassCallback&  pass_callback,
+            ISampleRendererFactory*         factory,
+            const ParamArray&               params,
+            const size_t                    thread_index)
+          : m_pass_callback(pass_callback)
+          , m_sampling_mode(get_sampling_context_mode(params))
+          , m_blue_noise(params.get_optional<bool>("blue_noise", false))
+          , m_sample_renderer(factory->create(thread_index))
+        {
+            if (thread_index == 0 && params.get_optional<size_t>("passes", 1) == 1)
+                RENDERER_LOG_WARNING("doing multi-pass adaptive sampling with a single pass, no sample will be redistributed.");
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            delete this;
+        }
+
+        virtual void render_pixel(
+            const Frame&                frame,
+            Tile&                       tile,
+            TileStack&                  aov_tiles,
+            const AABB2i&               tile_bbox,
+            const size_t                pass_hash,
+            const Vector2i&             pi,
+            const Vector2i&             pt,
+            SamplingContext::RNGType&   rng,
+            ShadingResultFrameBuffer&   framebuffer) APPLESEED_OVERRIDE
+        {
+            const size_t sample_count = m_pass_callback.get_pass_sample_count(pi.x, pi.y);
+
+            // Skip pixels that don't need any more samples.
+            if (sample_count == 0)
+                return;
+
+            const size_t aov_count = frame.aov_images().size();
+
+            on_pixel_begin();
+
+            // Create a sampling context. In blue noise mode, all pixels share the same
+            // sequences and are decorrelated by the blue noise mask instead.
+            const size_t frame_width = frame.image().properties().m_canvas_width;
+            const size_t instance =
+                mix_uint32(
+                    static_cast<uint32>(pass_hash),
+                    m_blue_noise ? 0 : static_cast<uint32>(pi.y * frame_width + pi.x));
+            SamplingContext sampling_context(
+                rng,
+                m_sampling_mode,
+                2,                          // number of dimensions
+                0,                          // number of samples -- unknown
+                instance);                  // initial instance number
+            if (m_blue_noise)
+                sampling_context.set_blue_noise_pixel(pi.x, pi.y);
+
+            // Luminance statistics of the valid samples of this pixel.
+            size_t valid_sample_count = 0;
+            float mean = 0.0f;
+            float m2 = 0.0f;
+
+            for (size_t i = 0; i < sample_count; ++i)
+            {
+                // Generate a uniform sample in [0,1)^2.
+                const Vector2d s = sampling_context.next2<Vector2d>();
+
+                // Compute the sample position in NDC.
+                const Vector2d sample_position = frame.get_sample_position(pi.x + s.x, pi.y + s.y);
+
+                // Create a pixel context that identifies the pixel and sample currently being rendered.
+                const PixelContext pixel_context(pi, sample_position);
+
+                // Render the sample.
+                ShadingResult shading_result(aov_count);
+                SamplingContext child_sampling_context(sampling_context);
+                m_sample_renderer->render_sample(
+                    child_sampling_context,
+                    pixel_context,
+                    sample_position,
+                    shading_result);
+
+                // Ignore invalid samples.
+                if (!shading_result.is_valid_linear_rgb())
+                {
+                    signal_invalid_sample();
+                    continue;
+                }
+
+                // Merge the sample into the framebuffer.
+                framebuffer.add(
+                    static_cast<float>(pt.x + s.x),
+                    static_cast<float>(pt.y + s.y),
+                    shading_result);
+
+                // Update the luminance statistics of this pixel.
+                const float value =
+                    luminance(
+                        Color3f(
+                            shading_result.m_main.m_color[0],
+                            shading_result.m_main.m_color[1],
+                            shading_result.m_main.m_color[2]));
+                ++valid_sample_count;
+                const float delta = value - mean;
+                mean += delta / valid_sample_count;
+                m2 += delta * (value - mean);
+            }
+
+            // Pixels of the tile margins are also rendered by neighboring tiles:
+            // only the tile that owns a pixel reports its statistics.
+            if (tile_bbox.contains(pt))
+                m_pass_callback.insert(pi.x, pi.y, valid_sample_count, mean, m2);
+
+            on_pixel_end(pi);
+        }
+
+        virtual StatisticsVector get_statistics() const APPLESEED_OVERRIDE
+        {
+            return m_sample_renderer->get_statistics();
+        }
+
+      private:
+        MultipassAdaptivePassCallback&      m_pass_callback;
+        const SamplingContext::Mode         m_sampling_mode;
+        const bool                          m_blue_noise;
+        auto_release_ptr<ISampleRenderer>   m_sample_renderer;
+    };
+}
+
+
+//
+// MultipassAdaptivePixelRendererFactory class implementation.
+//
+
+MultipassAdaptivePixelRendererFactory::MultipassAdaptivePixelRendererFactory(
+    MultipassAdaptivePassCallback&  pass_callback,
+    ISampleRendererFactory*         factory,
+    const ParamArray&               params)
+  : m_pass_callback(pass_callback)
+  , m_factory(factory)
+  , m_params(params)
+{
+}
+
+void MultipassAdaptivePixelRendererFactory::release()
+{
+    delete this;
+}
+
+IPixelRenderer* MultipassAdaptivePixelRendererFactory::create(
+    const size_t                    thread_index)
+{
+    return
+        new MultipassAdaptivePixelRenderer(
+            m_pass_callback,
+            m_factory,
+            m_params,
+            thread_index);
+}
+
+Dictionary MultipassAdaptivePixelRendererFactory::get_params_metadata()
+{
+    Dictionary metadata;
+
+    metadata.dictionaries().insert(
+        "samples",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "16")
+            .insert("label", "Samples Per Pass")
+            .insert("help", "Average number of anti-aliasing samples per pixel and per pass"));
+
+    metadata.dictionaries().insert(
+        "max_samples",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "1024")
+            .insert("label", "Max Samples")
+            .insert("help", "Maximum number of anti-aliasing samples per pixel over all passes"));
+
+    metadata.dictionaries().insert(
+        "quality",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "2.0")
+            .insert("label", "Quality")
+            .insert("help", "Target noise level, as the negated base-10 logarithm of the relative error of pixels"));
+
+    return metadata;
+}
+
+}   // namespace renderer
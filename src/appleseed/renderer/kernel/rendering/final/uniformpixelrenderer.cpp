@@ -58,6 +58,7 @@
 
 // Standard headers.
 #include <cmath>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class Tile; }
@@ -87,6 +88,7 @@ namespace
           , m_sample_renderer(factory->create(thread_index))
           , m_sample_count(m_params.m_samples)
           , m_sqrt_sample_count(round<int>(sqrt(static_cast<double>(m_params.m_samples))))
+          , m_max_batch_size(m_sample_renderer->get_max_batch_size())
         {
             if (!m_params.m_decorrelate)
             {
@@ -105,11 +107,27 @@ namespace
             }
         }
 
+        ~UniformPixelRenderer()
+        {
+            clear_sample_queue();
+        }
+
         virtual void release() APPLESEED_OVERRIDE
         {
             delete this;
         }
 
+        virtual void on_tile_begin(
+            const Frame&                frame,
+            Tile&                       tile,
+            TileStack&                  aov_tiles) APPLESEED_OVERRIDE
+        {
+            PixelRendererBase::on_tile_begin(frame, tile, aov_tiles);
+
+            // Drop the samples left over by an aborted tile.
+            clear_sample_queue();
+        }
+
         virtual void render_pixel(
             const Frame&                frame,
             Tile&                       tile,
@@ -123,19 +141,28 @@ namespace
         {
             const size_t aov_count = frame.aov_images().size();
 
-            on_pixel_begin();
+            // When the sample renderer benefits from batches, samples are queued, possibly
+            // across pixels, and rendered once enough of them have been collected.
+            const bool queue_samples = m_max_batch_size > 1;
+
+            if (!queue_samples)
+                on_pixel_begin();
 
             if (m_params.m_decorrelate)
             {
-                // Create a sampling context.
+                // Create a sampling context. In blue noise mode, all pixels share the same
+                // sequences and are decorrelated by the blue noise mask instead.
                 const size_t frame_width = frame.image().properties().m_canvas_width;
-                const size_t instance = hash_uint32(static_cast<uint32>(pass_hash + pi.y * frame_width + pi.x));
+                const size_t pixel_index = m_params.m_blue_noise ? 0 : pi.y * frame_width + pi.x;
+                const size_t instance = hash_uint32(static_cast<uint32>(pass_hash + pixel_index));
                 SamplingContext sampling_context(
                     rng,
                     m_params.m_sampling_mode,
                     2,                          // number of dimensions
                     0,                          // number of samples -- unknown
                     instance);                  // initial instance number
+                if (m_params.m_blue_noise)
+                    sampling_context.set_blue_noise_pixel(pi.x, pi.y);
 
                 for (size_t i = 0; i < m_sample_count; ++i)
                 {
@@ -151,6 +178,19 @@ namespace
                     // Create a pixel context that identifies the pixel and sample currently being rendered.
                     const PixelContext pixel_context(pi, sample_position);
 
+                    if (queue_samples)
+                    {
+                        queue_sample(
+                            sampling_context,
+                            pixel_context,
+                            Vector2f(
+                                static_cast<float>(pt.x + s.x),
+                                static_cast<float>(pt.y + s.y)),
+                            aov_count,
+                            framebuffer);
+                        continue;
+                    }
+
                     // Render the sample.
                     ShadingResult shading_result(aov_count);
                     SamplingContext child_sampling_context(sampling_context);
@@ -200,6 +240,21 @@ namespace
                             1,                          // number of dimensions
                             instance,                   // number of samples
                             instance);                  // initial instance number -- end of sequence
+                        if (m_params.m_blue_noise)
+                            sampling_context.set_blue_noise_pixel(pi.x, pi.y);
+
+                        if (queue_samples)
+                        {
+                            queue_sample(
+                                sampling_context,
+                                pixel_context,
+                                Vector2f(
+                                    static_cast<float>(s.x - pi.x + pt.x),
+                                    static_cast<float>(s.y - pi.y + pt.y)),
+                                aov_count,
+                                framebuffer);
+                            continue;
+                        }
 
                         // Render the sample.
                         ShadingResult shading_result(aov_count);
@@ -222,7 +277,15 @@ namespace
                 }
             }
 
-            on_pixel_end(pi);
+            if (!queue_samples)
+                on_pixel_end(pi);
+        }
+
+        virtual void flush_pixels(
+            const Frame&                frame,
+            ShadingResultFrameBuffer&   framebuffer) APPLESEED_OVERRIDE
+        {
+            render_queued_samples(framebuffer);
         }
 
         virtual StatisticsVector get_statistics() const APPLESEED_OVERRIDE
@@ -234,12 +297,14 @@ namespace
         struct Parameters
         {
             const SamplingContext::Mode     m_sampling_mode;
+            const bool                      m_blue_noise;
             const size_t                    m_samples;
             const bool                      m_force_aa;
             const bool                      m_decorrelate;
 
             explicit Parameters(const ParamArray& params)
               : m_sampling_mode(get_sampling_context_mode(params))
+              , m_blue_noise(params.get_optional<bool>("blue_noise", false))
               , m_samples(params.get_required<size_t>("samples", 64))
               , m_force_aa(params.get_optional<bool>("force_antialiasing", false))
               , m_decorrelate(params.get_optional<bool>("decorrelate_pixels", true))
@@ -247,11 +312,107 @@ namespace
             }
         };
 
+        // A sample waiting to be rendered as part of a batch.
+        struct QueuedSample
+        {
+            SamplingContext                 m_sampling_context;
+            const PixelContext              m_pixel_context;
+            const Vector2f                  m_framebuffer_position;
+            ShadingResult                   m_shading_result;
+
+            QueuedSample(
+                const SamplingContext&      sampling_context,
+                const PixelContext&         pixel_context,
+                const Vector2f&             framebuffer_position,
+                const size_t                aov_count)
+              : m_sampling_context(sampling_context)
+              , m_pixel_context(pixel_context)
+              , m_framebuffer_position(framebuffer_position)
+              , m_shading_result(aov_count)
+            {
+            }
+        };
+
         const Parameters                    m_params;
         auto_release_ptr<ISampleRenderer>   m_sample_renderer;
         const size_t                        m_sample_count;
         const int                           m_sqrt_sample_count;
+        const size_t                        m_max_batch_size;
         PixelSampler                        m_pixel_sampler;
+        vector<QueuedSample*>               m_sample_queue;
+        vector<SampleRequest>               m_sample_requests;
+
+        void queue_sample(
+            const SamplingContext&          sampling_context,
+            const PixelContext&             pixel_context,
+            const Vector2f&                 framebuffer_position,
+            const size_t                    aov_count,
+            ShadingResultFrameBuffer&       framebuffer)
+        {
+            m_sample_queue.push_back(
+                new QueuedSample(
+                    sampling_context,
+                    pixel_context,
+                    framebuffer_position,
+                    aov_count));
+
+            if (m_sample_queue.size() >= m_max_batch_size)
+                render_queued_samples(framebuffer);
+        }
+
+        void render_queued_samples(ShadingResultFrameBuffer& framebuffer)
+        {
+            const size_t count = m_sample_queue.size();
+
+            if (count == 0)
+                return;
+
+            // Render the samples.
+            m_sample_requests.resize(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                QueuedSample& sample = *m_sample_queue[i];
+                SampleRequest& request = m_sample_requests[i];
+                request.m_sampling_context = &sample.m_sampling_context;
+                request.m_pixel_context = &sample.m_pixel_context;
+                request.m_image_point = sample.m_pixel_context.get_sample_position();
+                request.m_shading_result = &sample.m_shading_result;
+            }
+            m_sample_renderer->render_samples(&m_sample_requests[0], count);
+
+            // Merge the samples into the framebuffer. Samples are queued in pixel order
+            // so invalid samples are still reported once per pixel.
+            for (size_t i = 0; i < count; ++i)
+            {
+                const QueuedSample& sample = *m_sample_queue[i];
+                const Vector2i& pi = sample.m_pixel_context.get_pixel_coords();
+
+                if (i == 0 || pi != m_sample_queue[i - 1]->m_pixel_context.get_pixel_coords())
+                    on_pixel_begin();
+
+                if (sample.m_shading_result.is_valid_linear_rgb())
+                {
+                    framebuffer.add(
+                        sample.m_framebuffer_position.x,
+                        sample.m_framebuffer_position.y,
+                        sample.m_shading_result);
+                }
+                else signal_invalid_sample();
+
+                if (i == count - 1 || pi != m_sample_queue[i + 1]->m_pixel_context.get_pixel_coords())
+                    on_pixel_end(pi);
+            }
+
+            clear_sample_queue();
+        }
+
+        void clear_sample_queue()
+        {
+            for (size_t i = 0, e = m_sample_queue.size(); i < e; ++i)
+                delete m_sample_queue[i];
+
+            m_sample_queue.clear();
+        }
     };
 }
 
@@ -0,0 +1,330 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "framedenoiser.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/kernel/aov/imagestack.h"
+#include "renderer/modeling/frame/frame.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/timers.h"
+#include "foundation/utility/job/iabortswitch.h"
+#include "foundation/utility/stopwatch.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// FrameDenoiser class implementation.
+//
+
+namespace
+{
+    // Range parameters of the filter.
+    const float AlbedoSigma = 0.1f;
+    const float NormalSharpness = 64.0f;
+    const float RelativeDepthSigma = 0.05f;
+
+    // Albedo below which the main color is not demodulated.
+    const float MinAlbedo = 0.01f;
+
+    struct DenoiserPixel
+    {
+        Color3f     m_color;            // straight alpha main color, divided by the albedo
+        float       m_alpha;
+        Color3f     m_albedo;
+        Vector3f    m_normal;
+        float       m_depth;
+        bool        m_valid;            // true if the pixel covers a surface
+    };
+
+    Color4f get_straight_pixel(
+        const Image&    image,
+        const size_t    x,
+        const size_t    y,
+        const bool      premultiplied)
+    {
+        Color4f color;
+        image.get_pixel(x, y, color);
+
+        if (premultiplied && color.a > 0.0f)
+            color.rgb() /= color.a;
+
+        return color;
+    }
+
+    float demodulate(const float value, const float albedo)
+    {
+        return albedo > MinAlbedo ? value / albedo : value;
+    }
+
+    float remodulate(const float value, const float albedo)
+    {
+        return albedo > MinAlbedo ? value * albedo : value;
+    }
+
+    class DenoiseRows
+    {
+      public:
+        DenoiseRows(
+            const vector<DenoiserPixel>&    pixels,
+            vector<Color4f>&                result,
+            const size_t                    width,
+            const size_t                    height,
+            const size_t                    radius,
+            const size_t                    first_row,
+            const size_t                    row_step,
+            IAbortSwitch*                   abort_switch)
+          : m_pixels(pixels)
+          , m_result(result)
+          , m_width(width)
+          , m_height(height)
+          , m_radius(radius)
+          , m_first_row(first_row)
+          , m_row_step(row_step)
+          , m_abort_switch(abort_switch)
+        {
+        }
+
+        void operator()()
+        {
+            const int r = static_cast<int>(m_radius);
+            const float rcp_spatial_sigma2 = 1.0f / square(max(0.5f * r, 0.5f));
+            const float rcp_albedo_sigma2 = 1.0f / square(AlbedoSigma);
+
+            for (size_t y = m_first_row; y < m_height; y += m_row_step)
+            {
+                if (is_aborted(m_abort_switch))
+                    return;
+
+                for (size_t x = 0; x < m_width; ++x)
+                {
+                    const DenoiserPixel& center = m_pixels[y * m_width + x];
+
+                    if (!center.m_valid)
+                        continue;
+
+                    const int xmin = max(static_cast<int>(x) - r, 0);
+                    const int ymin = max(static_cast<int>(y) - r, 0);
+                    const int xmax = min(static_cast<int>(x) + r, static_cast<int>(m_width) - 1);
+                    const int ymax = min(static_cast<int>(y) + r, static_cast<int>(m_height) - 1);
+
+                    const float rcp_depth_sigma2 =
+                        1.0f / square(max(RelativeDepthSigma * center.m_depth, 1.0e-6f));
+
+                    Color3f sum(0.0f);
+                    float sum_weight = 0.0f;
+
+                    for (int qy = ymin; qy <= ymax; ++qy)
+                    {
+                        for (int qx = xmin; qx <= xmax; ++qx)
+                        {
+                            const DenoiserPixel& q = m_pixels[qy * m_width + qx];
+
+                            if (!q.m_valid)
+                                continue;
+
+                            const float dx = static_cast<float>(qx - static_cast<int>(x));
+                            const float dy = static_cast<float>(qy - static_cast<int>(y));
+                            const float spatial = (dx * dx + dy * dy) * rcp_spatial_sigma2;
+
+                            const Color3f da = q.m_albedo - center.m_albedo;
+                            const float albedo = (square(da[0]) + square(da[1]) + square(da[2])) * rcp_albedo_sigma2;
+
+                            const float normal = (1.0f - dot(q.m_normal, center.m_normal)) * NormalSharpness;
+
+                            const float depth = square(q.m_depth - center.m_depth) * rcp_depth_sigma2;
+
+                            const float weight =
+                                std::exp(-0.5f * (spatial + albedo + depth) - normal);
+
+                            sum += weight * q.m_color;
+                            sum_weight += weight;
+                        }
+                    }
+
+                    // The center pixel always contributes with a weight of 1.
+                    assert(sum_weight >= 1.0f);
+                    sum /= sum_weight;
+
+                    Color4f& result = m_result[y * m_width + x];
+                    result[0] = remodulate(sum[0], center.m_albedo[0]);
+                    result[1] = remodulate(sum[1], center.m_albedo[1]);
+                    result[2] = remodulate(sum[2], center.m_albedo[2]);
+                    result[3] = center.m_alpha;
+                }
+            }
+        }
+
+      private:
+        const vector<DenoiserPixel>&    m_pixels;
+        vector<Color4f>&                m_result;
+        const size_t                    m_width;
+        const size_t                    m_height;
+        const size_t                    m_radius;
+        const size_t                    m_first_row;
+        const size_t                    m_row_step;
+        IAbortSwitch*                   m_abort_switch;
+    };
+}
+
+FrameDenoiser::FrameDenoiser(
+    const size_t    radius,
+    const size_t    thread_count)
+  : m_radius(radius)
+  , m_thread_count(max<size_t>(thread_count, 1))
+{
+}
+
+bool FrameDenoiser::denoise(
+    const Frame&    frame,
+    IAbortSwitch*   abort_switch) const
+{
+    const ImageStack& aov_images = frame.aov_images();
+    const size_t depth_index = aov_images.get_index("depth");
+    const size_t albedo_index = aov_images.get_index("albedo");
+    const size_t normal_index = aov_images.get_index("normal");
+
+    if (depth_index == size_t(~0) || albedo_index == size_t(~0) || normal_index == size_t(~0))
+    {
+        RENDERER_LOG_ERROR(
+            "cannot denoise frame \"%s\": the feature AOVs are missing.",
+            frame.get_name());
+        return false;
+    }
+
+    RENDERER_LOG_INFO("denoising frame \"%s\"...", frame.get_name());
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    Image& image = frame.image();
+    const Image& depth_image = aov_images.get_image(depth_index);
+    const Image& albedo_image = aov_images.get_image(albedo_index);
+    const Image& normal_image = aov_images.get_image(normal_index);
+
+    const AABB2u& crop_window = frame.get_crop_window();
+    const size_t width = crop_window.extent()[0] + 1;
+    const size_t height = crop_window.extent()[1] + 1;
+    const bool premultiplied = frame.is_premultiplied_alpha();
+
+    // Gather the main color and the features of all pixels of the crop window.
+    vector<DenoiserPixel> pixels(width * height);
+    vector<Color4f> result(width * height);
+    for (size_t y = 0; y < height; ++y)
+    {
+        for (size_t x = 0; x < width; ++x)
+        {
+            const size_t ix = crop_window.min[0] + x;
+            const size_t iy = crop_window.min[1] + y;
+
+            const Color4f color = get_straight_pixel(image, ix, iy, premultiplied);
+            const Color4f albedo = get_straight_pixel(albedo_image, ix, iy, premultiplied);
+            const Color4f normal = get_straight_pixel(normal_image, ix, iy, premultiplied);
+            const Color4f depth = get_straight_pixel(depth_image, ix, iy, premultiplied);
+
+            DenoiserPixel& pixel = pixels[y * width + x];
+            pixel.m_albedo = albedo.rgb();
+            pixel.m_color[0] = demodulate(color[0], albedo[0]);
+            pixel.m_color[1] = demodulate(color[1], albedo[1]);
+            pixel.m_color[2] = demodulate(color[2], albedo[2]);
+            pixel.m_alpha = color.a;
+            pixel.m_normal =
+                safe_normalize(
+                    Vector3f(
+                        normal[0] * 2.0f - 1.0f,
+                        normal[1] * 2.0f - 1.0f,
+                        normal[2] * 2.0f - 1.0f));
+            pixel.m_depth = depth[0];
+            pixel.m_valid = albedo.a > 0.0f;
+        }
+    }
+
+    // Filter the pixels, each thread in charge of every n'th row.
+    boost::thread_group threads;
+    for (size_t i = 0; i < m_thread_count; ++i)
+    {
+        threads.create_thread(
+            DenoiseRows(
+                pixels,
+                result,
+                width,
+                height,
+                m_radius,
+                i,
+                m_thread_count,
+                abort_switch));
+    }
+    threads.join_all();
+
+    if (is_aborted(abort_switch))
+        return false;
+
+    // Store the denoised pixels back into the main image.
+    for (size_t y = 0; y < height; ++y)
+    {
+        for (size_t x = 0; x < width; ++x)
+        {
+            if (!pixels[y * width + x].m_valid)
+                continue;
+
+            Color4f color = result[y * width + x];
+            if (premultiplied)
+                color.rgb() *= color.a;
+
+            image.set_pixel(crop_window.min[0] + x, crop_window.min[1] + y, color);
+        }
+    }
+
+    RENDERER_LOG_INFO(
+        "denoised frame \"%s\" in %s.",
+        frame.get_name(),
+        pretty_time(stopwatch.measure().get_seconds()).c_str());
+
+    return true;
+}
+
+}   // namespace renderer
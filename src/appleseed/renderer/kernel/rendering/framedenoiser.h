@@ -0,0 +1,78 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_RENDERER_KERNEL_RENDERING_FRAMEDENOISER_H
+#define APPLESEED_RENDERER_KERNEL_RENDERING_FRAMEDENOISER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class IAbortSwitch; }
+namespace renderer      { class Frame; }
+
+namespace renderer
+{
+
+//
+// Feature-guided denoiser for the main image of a frame.
+//
+// The main image is divided by the albedo, filtered with a cross-bilateral filter
+// whose range weights only depend on the "albedo", "normal" and "depth" AOVs, then
+// multiplied back by the albedo. Since these features are noise-free in comparison
+// with the beauty, edges and textures survive while the illumination is smoothed.
+//
+
+class APPLESEED_DLLSYMBOL FrameDenoiser
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. 'radius' is the radius of the filter footprint in pixels.
+    FrameDenoiser(
+        const size_t                radius,
+        const size_t                thread_count);
+
+    // Denoise the main image of a frame in place, within its crop window.
+    // Return false if the frame lacks the feature AOVs or if denoising was aborted.
+    bool denoise(
+        const Frame&                frame,
+        foundation::IAbortSwitch*   abort_switch = 0) const;
+
+  private:
+    const size_t    m_radius;
+    const size_t    m_thread_count;
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_RENDERING_FRAMEDENOISER_H
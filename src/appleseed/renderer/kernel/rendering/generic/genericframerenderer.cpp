@@ -38,11 +38,13 @@
 #include "renderer/kernel/rendering/ipasscallback.h"
 #include "renderer/kernel/rendering/itilecallback.h"
 #include "renderer/kernel/rendering/itilerenderer.h"
+#include "renderer/kernel/rendering/itilesource.h"
 #include "renderer/utility/settingsparsing.h"
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/hash.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/thread.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/containers/dictionary.h"
@@ -80,10 +82,12 @@ namespace
             ITileRendererFactory*   tile_renderer_factory,
             ITileCallbackFactory*   tile_callback_factory,
             IPassCallback*          pass_callback,
+            ITileSource*            tile_source,
             const ParamArray&       params)
           : m_frame(frame)
           , m_params(params)
           , m_pass_callback(pass_callback)
+          , m_tile_source(tile_source)
           , m_is_rendering(false)
         {
             // We must have a renderer factory, but it's OK not to have a callback factory.
@@ -95,12 +99,27 @@ namespace
                     global_logger(),
                     m_job_queue,
                     m_params.m_thread_count,
-                    JobManager::KeepRunningOnEmptyQueue));
+                    JobManager::KeepRunningOnEmptyQueue |
+                    (m_params.m_work_stealing ? JobManager::WorkStealing : 0) |
+                    (m_params.m_pin_threads ? JobManager::PinWorkerThreads : 0)));
 
-            // Instantiate tile renderers, one per rendering thread.
+            // Instantiate tile renderers, one per rendering thread. If rendering threads are
+            // pinned, create each tile renderer from the core its thread will run on so that
+            // its memory gets allocated on the same NUMA node.
             m_tile_renderers.reserve(m_params.m_thread_count);
             for (size_t i = 0; i < m_params.m_thread_count; ++i)
+            {
+                auto_ptr<ThreadAffinityContext> affinity_context;
+                if (m_params.m_pin_threads)
+                {
+                    affinity_context.reset(
+                        new ThreadAffinityContext(
+                            System::get_numa_grouped_logical_cpu_core(i),
+                            &global_logger()));
+                }
+
                 m_tile_renderers.push_back(tile_renderer_factory->create(i));
+            }
 
             if (tile_callback_factory)
             {
@@ -172,6 +191,8 @@ namespace
                     m_tile_renderers,
                     m_tile_callbacks,
                     m_pass_callback,
+                    m_tile_source,
+                    m_tile_job_factory,
                     m_job_queue,
                     m_abort_switch,
                     m_is_rendering));
@@ -211,17 +232,52 @@ namespace
             print_tile_renderers_stats();
         }
 
+        virtual StatisticsVector get_statistics() const APPLESEED_OVERRIDE
+        {
+            StatisticsVector stats;
+
+            for (size_t i = 0; i < m_tile_renderers.size(); ++i)
+                stats.merge(m_tile_renderers[i]->get_statistics());
+
+            if (m_params.m_work_stealing)
+            {
+                const LockContentionCounters& counters = m_job_queue.get_worker_queue_lock_counters();
+
+                Statistics job_queue_stats;
+                job_queue_stats.insert<uint64>("lock acquisitions", counters.get_acquisition_count());
+                job_queue_stats.insert_percent("contended", counters.get_contended_count(), counters.get_acquisition_count());
+                job_queue_stats.insert<uint64>("parked threads", counters.get_park_count());
+                job_queue_stats.insert_time("wait time", counters.get_wait_time());
+
+                stats.merge(StatisticsVector::make("job queue statistics", job_queue_stats));
+            }
+
+            return stats;
+        }
+
+        virtual void get_thread_busy_times(vector<double>& busy_times) const APPLESEED_OVERRIDE
+        {
+            busy_times.resize(m_job_manager->get_thread_count());
+
+            for (size_t i = 0; i < busy_times.size(); ++i)
+                busy_times[i] = m_job_manager->get_busy_time(i);
+        }
+
       private:
         struct Parameters
         {
             const size_t                        m_thread_count;     // number of rendering threads
             const TileJobFactory::TileOrdering  m_tile_ordering;    // tile rendering order
             const size_t                        m_pass_count;       // number of rendering passes
+            const bool                          m_work_stealing;    // use per-thread job lists with work stealing?
+            const bool                          m_pin_threads;      // pin rendering threads to cores, grouped by NUMA node?
 
             explicit Parameters(const ParamArray& params)
               : m_thread_count(get_rendering_thread_count(params))
               , m_tile_ordering(get_tile_ordering(params))
               , m_pass_count(params.get_optional<size_t>("passes", 1))
+              , m_work_stealing(params.get_optional<bool>("work_stealing", false))
+              , m_pin_threads(params.get_optional<bool>("pin_rendering_threads", false))
             {
             }
 
@@ -246,6 +302,10 @@ namespace
                 {
                     return TileJobFactory::RandomOrdering;
                 }
+                else if (tile_ordering == "cost")
+                {
+                    return TileJobFactory::CostOrdering;
+                }
                 else
                 {
                     RENDERER_LOG_ERROR(
@@ -270,6 +330,8 @@ namespace
                 vector<ITileRenderer*>&             tile_renderers,
                 vector<ITileCallback*>&             tile_callbacks,
                 IPassCallback*                      pass_callback,
+                ITileSource*                        tile_source,
+                TileJobFactory&                     tile_job_factory,
                 JobQueue&                           job_queue,
                 IAbortSwitch&                       abort_switch,
                 bool&                               is_rendering)
@@ -279,8 +341,10 @@ namespace
               , m_tile_renderers(tile_renderers)
               , m_tile_callbacks(tile_callbacks)
               , m_pass_callback(pass_callback)
+              , m_tile_source(tile_source)
               , m_job_queue(job_queue)
               , m_abort_switch(abort_switch)
+              , m_tile_job_factory(tile_job_factory)
               , m_is_rendering(is_rendering)
             {
             }
@@ -300,21 +364,42 @@ namespace
                         assert(!m_job_queue.has_scheduled_or_running_jobs());
                     }
 
-                    // Create tile jobs.
                     const uint32 pass_hash = hash_uint32(static_cast<uint32>(pass));
-                    TileJobFactory::TileJobVector tile_jobs;
-                    m_tile_job_factory.create(
-                        m_frame,
-                        m_tile_ordering,
-                        m_tile_renderers,
-                        m_tile_callbacks,
-                        pass_hash,
-                        tile_jobs,
-                        m_abort_switch);
-
-                    // Schedule tile jobs.
-                    for (const_each<TileJobFactory::TileJobVector> i = tile_jobs; i; ++i)
-                        m_job_queue.schedule(*i);
+
+                    if (m_tile_source)
+                    {
+                        // Schedule a tile job for each tile handed out by the tile source.
+                        size_t tile_x, tile_y;
+                        while (m_tile_source->acquire_tile(tile_x, tile_y, m_abort_switch))
+                        {
+                            m_job_queue.schedule(
+                                new TileJob(
+                                    m_tile_renderers,
+                                    m_tile_callbacks,
+                                    m_frame,
+                                    tile_x,
+                                    tile_y,
+                                    pass_hash,
+                                    m_abort_switch));
+                        }
+                    }
+                    else
+                    {
+                        // Create tile jobs.
+                        TileJobFactory::TileJobVector tile_jobs;
+                        m_tile_job_factory.create(
+                            m_frame,
+                            m_tile_ordering,
+                            m_tile_renderers,
+                            m_tile_callbacks,
+                            pass_hash,
+                            tile_jobs,
+                            m_abort_switch);
+
+                        // Schedule tile jobs.
+                        for (const_each<TileJobFactory::TileJobVector> i = tile_jobs; i; ++i)
+                            m_job_queue.schedule(*i);
+                    }
 
                     // Wait until tile jobs have effectively stopped.
                     m_job_queue.wait_until_completion();
@@ -323,8 +408,22 @@ namespace
                     if (m_pass_callback)
                     {
                         assert(!m_job_queue.has_scheduled_or_running_jobs());
-                        m_pass_callback->post_render(m_frame, m_job_queue, m_abort_switch);
+                        const bool stop = m_pass_callback->post_render(m_frame, m_job_queue, m_abort_switch);
                         assert(!m_job_queue.has_scheduled_or_running_jobs());
+
+                        // Skip the remaining passes if the pass callback decided so.
+                        if (stop)
+                        {
+                            if (pass + 1 < m_pass_count)
+                            {
+                                RENDERER_LOG_INFO(
+                                    "stopping rendering after pass %s of %s.",
+                                    pretty_uint(pass + 1).c_str(),
+                                    pretty_uint(m_pass_count).c_str());
+                            }
+
+                            break;
+                        }
                     }
                 }
 
@@ -337,11 +436,12 @@ namespace
             vector<ITileRenderer*>&                 m_tile_renderers;
             vector<ITileCallback*>&                 m_tile_callbacks;
             IPassCallback*                          m_pass_callback;
+            ITileSource*                            m_tile_source;
             const size_t                            m_pass_count;
             JobQueue&                               m_job_queue;
             IAbortSwitch&                           m_abort_switch;
+            TileJobFactory&                         m_tile_job_factory;     // shared across renders to keep tile costs
             bool&                                   m_is_rendering;
-            TileJobFactory                          m_tile_job_factory;
         };
 
         const Frame&                m_frame;            // target framebuffer
@@ -354,6 +454,7 @@ namespace
         vector<ITileRenderer*>      m_tile_renderers;   // tile renderers, one per thread
         vector<ITileCallback*>      m_tile_callbacks;   // tile callbacks, none or one per thread
         IPassCallback*              m_pass_callback;
+        ITileSource*                m_tile_source;
 
         TileJobFactory              m_tile_job_factory;
 
@@ -365,12 +466,7 @@ namespace
         {
             assert(!m_tile_renderers.empty());
 
-            StatisticsVector stats;
-
-            for (size_t i = 0; i < m_tile_renderers.size(); ++i)
-                stats.merge(m_tile_renderers[i]->get_statistics());
-
-            RENDERER_LOG_DEBUG("%s", stats.to_string().c_str());
+            RENDERER_LOG_DEBUG("%s", get_statistics().to_string().c_str());
         }
     };
 }
@@ -385,11 +481,13 @@ GenericFrameRendererFactory::GenericFrameRendererFactory(
     ITileRendererFactory*   tile_renderer_factory,
     ITileCallbackFactory*   tile_callback_factory,
     IPassCallback*          pass_callback,
+    ITileSource*            tile_source,
     const ParamArray&       params)
   : m_frame(frame)
   , m_tile_renderer_factory(tile_renderer_factory)
   , m_tile_callback_factory(tile_callback_factory)
   , m_pass_callback(pass_callback)
+  , m_tile_source(tile_source)
   , m_params(params)
 {
 }
@@ -407,6 +505,7 @@ IFrameRenderer* GenericFrameRendererFactory::create()
             m_tile_renderer_factory,
             m_tile_callback_factory,
             m_pass_callback,
+            m_tile_source,
             m_params);
 }
 
@@ -415,6 +514,7 @@ IFrameRenderer* GenericFrameRendererFactory::create(
     ITileRendererFactory*   tile_renderer_factory,
     ITileCallbackFactory*   tile_callback_factory,
     IPassCallback*          pass_callback,
+    ITileSource*            tile_source,
     const ParamArray&       params)
 {
     return
@@ -423,6 +523,7 @@ IFrameRenderer* GenericFrameRendererFactory::create(
             tile_renderer_factory,
             tile_callback_factory,
             pass_callback,
+            tile_source,
             params);
 }
 
@@ -442,7 +543,7 @@ Dictionary GenericFrameRendererFactory::get_params_metadata()
         "tile_ordering",
         Dictionary()
             .insert("type", "enum")
-            .insert("values", "linear|spiral|hilbert|random")
+            .insert("values", "linear|spiral|hilbert|random|cost")
             .insert("default", "spiral")
             .insert("label", "Tile Order")
             .insert("help", "Tile rendering order")
@@ -468,7 +569,12 @@ Dictionary GenericFrameRendererFactory::get_params_metadata()
                         "random",
                         Dictionary()
                             .insert("label", "Random")
-                            .insert("help", "Random tile ordering"))));
+                            .insert("help", "Random tile ordering"))
+                    .insert(
+                        "cost",
+                        Dictionary()
+                            .insert("label", "Cost")
+                            .insert("help", "Most expensive tiles first, based on the render times of the previous pass"))));
 
     return metadata;
 }
@@ -51,9 +51,11 @@
 #include "foundation/math/vector.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/statistics.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <vector>
 
@@ -68,6 +70,15 @@ namespace renderer
 
 namespace
 {
+    //
+    // The generic sample generator spreads samples over the crop window using a Halton
+    // sequence. Once the whole window has received about one sample per pixel, each call
+    // to generate_samples() is restricted to a sampling domain, a square region of the
+    // window, so that the rendering thread keeps hitting the same geometry and textures.
+    // Domains are assigned to sample generators in turn, so that they all receive the
+    // same number of samples over time.
+    //
+
     class GenericSampleGenerator
       : public SampleGeneratorBase
     {
@@ -76,6 +87,7 @@ namespace
             const Frame&                    frame,
             ISampleRendererFactory*         sample_renderer_factory,
             const ParamArray&               params,
+            boost::atomic<size_t>&          next_domain,
             const size_t                    generator_index,
             const size_t                    generator_count)
           : SampleGeneratorBase(generator_index, generator_count)
@@ -89,9 +101,24 @@ namespace
           , m_window_height(static_cast<int>(frame.get_crop_window().extent()[1] + 1))
           , m_lighting_conditions(frame.get_lighting_conditions())
           , m_sample_renderer(sample_renderer_factory->create(generator_index))
-          , m_window_width_next_pow2(next_power(static_cast<double>(m_window_width), 2.0))
-          , m_window_height_next_pow3(next_power(static_cast<double>(m_window_height), 3.0))
+          , m_next_domain(next_domain)
+          , m_domain_count_x(0)
+          , m_domain_count(0)
+          , m_spread_sample_count(0)
+          , m_generated_sample_count(0)
         {
+            if (m_params.m_domain_size > 0)
+            {
+                const size_t domain_size = m_params.m_domain_size;
+                m_domain_count_x = (static_cast<size_t>(m_window_width) + domain_size - 1) / domain_size;
+                m_domain_count = m_domain_count_x * ((static_cast<size_t>(m_window_height) + domain_size - 1) / domain_size);
+
+                // Share the first sample per pixel of the window between all sample generators.
+                m_spread_sample_count =
+                    (static_cast<uint64>(m_window_width) * m_window_height + generator_count - 1) / generator_count;
+            }
+
+            set_domain(m_window_origin_x, m_window_origin_y, m_window_width, m_window_height);
         }
 
         virtual void release() APPLESEED_OVERRIDE
@@ -103,6 +130,32 @@ namespace
         {
             SampleGeneratorBase::reset();
             m_rng = SamplingContext::RNGType();
+            m_generated_sample_count = 0;
+        }
+
+        virtual void generate_samples(
+            const size_t                    sample_count,
+            SampleAccumulationBuffer&       buffer,
+            IAbortSwitch&                   abort_switch) APPLESEED_OVERRIDE
+        {
+            if (m_domain_count > 1 && m_generated_sample_count >= m_spread_sample_count)
+            {
+                // Render all the samples of this batch in the next sampling domain.
+                const size_t domain = m_next_domain++ % m_domain_count;
+                const int domain_size = static_cast<int>(m_params.m_domain_size);
+                const int x = static_cast<int>(domain % m_domain_count_x) * domain_size;
+                const int y = static_cast<int>(domain / m_domain_count_x) * domain_size;
+                set_domain(
+                    m_window_origin_x + x,
+                    m_window_origin_y + y,
+                    min(domain_size, m_window_width - x),
+                    min(domain_size, m_window_height - y));
+            }
+            else set_domain(m_window_origin_x, m_window_origin_y, m_window_width, m_window_height);
+
+            SampleGeneratorBase::generate_samples(sample_count, buffer, abort_switch);
+
+            m_generated_sample_count += sample_count;
         }
 
         virtual StatisticsVector get_statistics() const APPLESEED_OVERRIDE
@@ -122,9 +175,13 @@ namespace
         struct Parameters
         {
             const SamplingContext::Mode     m_sampling_mode;
+            const bool                      m_blue_noise;
+            const size_t                    m_domain_size;      // size of a sampling domain in pixels, 0 to disable
 
             explicit Parameters(const ParamArray& params)
               : m_sampling_mode(get_sampling_context_mode(params))
+              , m_blue_noise(params.get_optional<bool>("blue_noise", false))
+              , m_domain_size(params.get_optional<size_t>("sampling_domain_size", 64))
             {
             }
         };
@@ -141,8 +198,19 @@ namespace
         auto_release_ptr<ISampleRenderer>   m_sample_renderer;
         SamplingContext::RNGType            m_rng;
 
-        const double                        m_window_width_next_pow2;
-        const double                        m_window_height_next_pow3;
+        boost::atomic<size_t>&              m_next_domain;
+        size_t                              m_domain_count_x;
+        size_t                              m_domain_count;
+        uint64                              m_spread_sample_count;
+        uint64                              m_generated_sample_count;
+
+        // Region of the window where samples are currently generated.
+        int                                 m_domain_origin_x;
+        int                                 m_domain_origin_y;
+        int                                 m_domain_width;
+        int                                 m_domain_height;
+        double                              m_domain_width_next_pow2;
+        double                              m_domain_height_next_pow3;
 
         Population<uint64>                  m_total_sampling_dim;
         Population<uint64>                  m_total_sampling_inst;
@@ -155,24 +223,24 @@ namespace
             const size_t Bases[2] = { 2, 3 };
             const Vector2d s = halton_sequence<double, 2>(Bases, sequence_index);
 
-            // Compute the coordinates of the pixel in the padded crop window.
-            const Vector2d t(s[0] * m_window_width_next_pow2, s[1] * m_window_height_next_pow3);
+            // Compute the coordinates of the pixel in the padded sampling domain.
+            const Vector2d t(s[0] * m_domain_width_next_pow2, s[1] * m_domain_height_next_pow3);
             const int x = truncate<int>(t[0]);
             const int y = truncate<int>(t[1]);
 
-            // Reject samples that fall outside the actual frame.
-            if (x >= m_window_width || y >= m_window_height)
+            // Reject samples that fall outside the actual sampling domain.
+            if (x >= m_domain_width || y >= m_domain_height)
                 return 0;
 
             // Transform the sample position back to NDC. Full precision divisions are required
             // to ensure that the sample position indeed lies in the [0,1)^2 interval.
             const Vector2d sample_position(
-                (m_window_origin_x + t[0]) / m_canvas_width,
-                (m_window_origin_y + t[1]) / m_canvas_height);
+                (m_domain_origin_x + t[0]) / m_canvas_width,
+                (m_domain_origin_y + t[1]) / m_canvas_height);
 
             // Create a pixel context that identifies the pixel and sample currently being rendered.
             const PixelContext pixel_context(
-                Vector2i(m_window_origin_x + x, m_window_origin_y + y),
+                Vector2i(m_domain_origin_x + x, m_domain_origin_y + y),
                 sample_position);
 
             // Create a sampling context. We start with an initial dimension of 2,
@@ -183,6 +251,8 @@ namespace
                 2,                          // number of dimensions
                 sequence_index,             // number of samples
                 sequence_index);            // initial instance number
+            if (m_params.m_blue_noise)
+                sampling_context.set_blue_noise_pixel(m_domain_origin_x + x, m_domain_origin_y + y);
 
             // Render the sample.
             ShadingResult shading_result;
@@ -214,6 +284,20 @@ namespace
 
             return 1;
         }
+
+        void set_domain(
+            const int                       origin_x,
+            const int                       origin_y,
+            const int                       width,
+            const int                       height)
+        {
+            m_domain_origin_x = origin_x;
+            m_domain_origin_y = origin_y;
+            m_domain_width = width;
+            m_domain_height = height;
+            m_domain_width_next_pow2 = next_power(static_cast<double>(width), 2.0);
+            m_domain_height_next_pow3 = next_power(static_cast<double>(height), 3.0);
+        }
     };
 }
 
@@ -229,6 +313,7 @@ GenericSampleGeneratorFactory::GenericSampleGeneratorFactory(
   : m_frame(frame)
   , m_sample_renderer_factory(sample_renderer_factory)
   , m_params(params)
+  , m_next_domain(0)
 {
 }
 
@@ -246,6 +331,7 @@ ISampleGenerator* GenericSampleGeneratorFactory::create(
             m_frame,
             m_sample_renderer_factory,
             m_params,
+            m_next_domain,
             generator_index,
             generator_count);
 }
@@ -261,4 +347,19 @@ SampleAccumulationBuffer* GenericSampleGeneratorFactory::create_sample_accumulat
             m_frame.get_filter());
 }
 
+Dictionary GenericSampleGeneratorFactory::get_params_metadata()
+{
+    Dictionary metadata;
+
+    metadata.dictionaries().insert(
+        "sampling_domain_size",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "64")
+            .insert("label", "Sampling Domain Size")
+            .insert("help", "Size in pixels of the regions of the image in which consecutive samples of a rendering thread are generated; 0 to spread them over the whole image"));
+
+    return metadata;
+}
+
 }   // namespace renderer
@@ -35,12 +35,14 @@
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/atomic.h"
 #include "foundation/platform/compiler.h"
 
 // Standard headers.
 #include <cstddef>
 
 // Forward declarations.
+namespace foundation  { class Dictionary; }
 namespace renderer  { class Frame; }
 namespace renderer  { class ISampleRendererFactory; }
 namespace renderer  { class SampleAccumulationBuffer; }
@@ -69,10 +71,14 @@ class GenericSampleGeneratorFactory
     // Create an accumulation buffer for this sample generator.
     virtual SampleAccumulationBuffer* create_sample_accumulation_buffer() APPLESEED_OVERRIDE;
 
+    // Return the metadata of the generic sample generator parameters.
+    static foundation::Dictionary get_params_metadata();
+
   private:
     const Frame&                m_frame;
     ISampleRendererFactory*     m_sample_renderer_factory;
     const ParamArray            m_params;
+    boost::atomic<size_t>       m_next_domain;      // shared by all sample generators
 };
 
 }       // namespace renderer
@@ -33,11 +33,15 @@
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
+#include "renderer/kernel/aov/imagestack.h"
 #include "renderer/kernel/aov/spectrumstack.h"
 #include "renderer/kernel/intersection/intersector.h"
 #include "renderer/kernel/intersection/tracecontext.h"
 #include "renderer/kernel/lighting/ilightingengine.h"
+#include "renderer/kernel/lighting/scatteringmode.h"
 #include "renderer/kernel/lighting/tracer.h"
+#include "renderer/kernel/rendering/liverenderstatistics.h"
+#include "renderer/kernel/rendering/primaryhitcache.h"
 #include "renderer/kernel/shading/oslshadergroupexec.h"
 #include "renderer/kernel/shading/shadingcontext.h"
 #include "renderer/kernel/shading/shadingengine.h"
@@ -46,25 +50,36 @@
 #include "renderer/kernel/shading/shadingray.h"
 #include "renderer/kernel/shading/shadingresult.h"
 #include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/modeling/bsdf/bsdf.h"
+#include "renderer/modeling/bsdf/bsdfsample.h"
 #include "renderer/modeling/camera/camera.h"
 #include "renderer/modeling/frame/frame.h"
+#include "renderer/modeling/material/material.h"
 #include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/shadergroup/shadergroup.h"
 
 // appleseed.foundation headers.
 #include "foundation/image/color.h"
 #include "foundation/image/colorspace.h"
 #include "foundation/image/image.h"
 #include "foundation/image/regularspectrum.h"
+#include "foundation/math/dual.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/arena.h"
+#include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/statistics.h"
 #include "foundation/utility/string.h"
+#include "foundation/utility/version.h"
 
 // Standard headers.
+#include <algorithm>
+#include <cassert>
 #include <cstddef>
+#include <functional>
 #include <limits>
 #include <string>
+#include <vector>
 
 // Forward declarations.
 namespace renderer  { class PixelContext; }
@@ -85,6 +100,25 @@ namespace
     // the requested tile could be found in the cache or not.
     #undef DEBUG_DISPLAY_TEXTURE_CACHE_PERFORMANCES
 
+    // Key used to shade the primary hits of a batch in material order.
+    struct HitSortKey
+    {
+        const Material*     m_material;
+        const ShaderGroup*  m_shader_group;
+        size_t              m_index;
+
+        bool operator<(const HitSortKey& rhs) const
+        {
+            if (m_material != rhs.m_material)
+                return less<const Material*>()(m_material, rhs.m_material);
+
+            if (m_shader_group != rhs.m_shader_group)
+                return less<const ShaderGroup*>()(m_shader_group, rhs.m_shader_group);
+
+            return m_index < rhs.m_index;
+        }
+    };
+
     class GenericSampleRenderer
       : public ISampleRenderer
     {
@@ -98,10 +132,13 @@ namespace
             ShadingEngine&          shading_engine,
             OIIO::TextureSystem&    oiio_texture_system,
             OSL::ShadingSystem&     shading_system,
+            LiveRenderCounters*     live_counters,
+            PrimaryHitCache*        primary_hit_cache,
             const size_t            thread_index,
             const ParamArray&       params)
           : m_params(params)
           , m_scene(scene)
+          , m_trace_context(trace_context)
           , m_lighting_conditions(frame.get_lighting_conditions())
           , m_opacity_threshold(1.0f - m_params.m_transparency_threshold)
           , m_texture_cache(texture_store)
@@ -113,7 +150,9 @@ namespace
           , m_intersector(
                 trace_context,
                 m_texture_cache,
-                m_params.m_report_self_intersections)
+                m_params.m_report_self_intersections,
+                m_params.m_use_occluder_cache,
+                m_params.m_intersection_profiling_period)
           , m_tracer(
                 m_scene,
                 m_intersector,
@@ -133,15 +172,46 @@ namespace
                 m_lighting_engine,
                 m_params.m_transparency_threshold,
                 m_params.m_max_iterations)
+          , m_batch_hits(
+                m_params.m_hit_sorting_batch_size > 0
+                    ? new ShadingPoint[m_params.m_hit_sorting_batch_size]
+                    : 0)
+          , m_sample_count(0)
+          , m_primary_hit_cache(primary_hit_cache)
+          , m_primary_hit_cache_hit_count(0)
+          , m_primary_hit_cache_miss_count(0)
+          , m_live_counters(live_counters)
+          , m_published_sample_count(0)
+          , m_published_shading_ray_count(0)
+          , m_published_probe_ray_count(0)
+          , m_published_texture_cache_hit_count(0)
+          , m_published_texture_cache_miss_count(0)
         {
             // 1/4 of a pixel, like in Renderman RIS.
             const CanvasProperties& c = frame.image().properties();
             m_image_point_dx = Vector2d(1.0 / (4.0 * c.m_canvas_width), 0.0);
             m_image_point_dy = Vector2d(0.0, -1.0 / (4.0 * c.m_canvas_height));
+
+            // Feature AOVs exist only when denoising is enabled.
+            const ImageStack& aov_images = frame.aov_images();
+            m_depth_aov_index = aov_images.get_index("depth");
+            m_albedo_aov_index = aov_images.get_index("albedo");
+            m_normal_aov_index = aov_images.get_index("normal");
+            m_store_features =
+                frame.is_denoising_enabled() &&
+                m_depth_aov_index != size_t(~0) &&
+                m_albedo_aov_index != size_t(~0) &&
+                m_normal_aov_index != size_t(~0);
+            m_min_aov_count =
+                max(m_depth_aov_index, max(m_albedo_aov_index, m_normal_aov_index)) + 1;
         }
 
         ~GenericSampleRenderer()
         {
+            if (m_live_counters)
+                publish_live_counters();
+
+            delete[] m_batch_hits;
             m_lighting_engine->release();
         }
 
@@ -163,13 +233,319 @@ namespace
 
 #endif
 
+            ++m_sample_count;
+
+            // Move the sample to the center of its stratum if primary hits are cached.
+            Vector2d ndc(image_point);
+            const size_t stratum =
+                m_primary_hit_cache
+                    ? m_primary_hit_cache->snap(m_trace_context.get_version_id(), pixel_context, ndc)
+                    : 0;
+
             // Construct a primary ray.
             ShadingRay primary_ray;
             m_scene.get_active_camera()->spawn_ray(
                 sampling_context,
-                Dual2d(image_point, m_image_point_dx, m_image_point_dy),
+                Dual2d(ndc, m_image_point_dx, m_image_point_dy),
                 primary_ray);
 
+            ShadingPoint primary_hit;
+            if (m_primary_hit_cache)
+                trace_primary_ray(stratum, primary_ray, primary_hit);
+
+            trace_and_shade(
+                sampling_context,
+                pixel_context,
+                primary_ray,
+                m_primary_hit_cache ? &primary_hit : 0,
+                shading_result);
+
+            update_live_counters();
+
+#ifdef DEBUG_DISPLAY_TEXTURE_CACHE_PERFORMANCES
+
+            const uint64 delta_hit_count = m_texture_cache.get_hit_count() - last_texture_cache_hit_count;
+            const uint64 delta_miss_count = m_texture_cache.get_miss_count() - last_texture_cache_miss_count;
+
+            if (delta_hit_count + delta_miss_count == 0)
+            {
+                // In black: no access to the texture cache.
+                shading_result.set_main_to_linear_rgba(Color4f(0.0f, 0.0f, 0.0f, 1.0f));
+            }
+            else if (delta_hit_count > delta_miss_count)
+            {
+                // In green: a majority of cache hits.
+                shading_result.set_main_to_linear_rgba(Color4f(0.0f, 1.0f, 0.0f, 1.0f));
+            }
+            else
+            {
+                // In red: a majority of cache misses.
+                shading_result.set_main_to_linear_rgba(Color4f(1.0f, 0.0f, 0.0f, 1.0f));
+            }
+
+#endif
+        }
+
+        virtual void render_samples(
+            const SampleRequest     requests[],
+            const size_t            count) APPLESEED_OVERRIDE
+        {
+            if (m_params.m_hit_sorting_batch_size == 0)
+            {
+                ISampleRenderer::render_samples(requests, count);
+                return;
+            }
+
+            for (size_t begin = 0; begin < count; begin += m_params.m_hit_sorting_batch_size)
+            {
+                const size_t batch_size = min(count - begin, m_params.m_hit_sorting_batch_size);
+                render_sample_batch(requests + begin, batch_size);
+            }
+
+            update_live_counters();
+        }
+
+        virtual size_t get_max_batch_size() const APPLESEED_OVERRIDE
+        {
+            return m_params.m_hit_sorting_batch_size > 0 ? m_params.m_hit_sorting_batch_size : 1;
+        }
+
+        virtual StatisticsVector get_statistics() const APPLESEED_OVERRIDE
+        {
+            Statistics sample_stats;
+            sample_stats.insert("samples", m_sample_count);
+            if (m_primary_hit_cache)
+            {
+                sample_stats.insert_percent(
+                    "primary hit cache hits",
+                    m_primary_hit_cache_hit_count,
+                    m_primary_hit_cache_hit_count + m_primary_hit_cache_miss_count);
+            }
+
+            StatisticsVector stats;
+            stats.insert("generic sample renderer statistics", sample_stats);
+            stats.merge(m_texture_cache.get_statistics());
+            stats.merge(m_intersector.get_statistics());
+            stats.merge(m_lighting_engine->get_statistics());
+
+#ifndef NDEBUG
+            // Per-sample memory should always fit in the arena.
+            Statistics arena_stats;
+            arena_stats.insert<uint64>("heap allocations", m_arena.get_heap_allocation_count());
+            stats.insert("arena statistics", arena_stats);
+#endif
+
+            return stats;
+        }
+
+      private:
+        struct Parameters
+        {
+            const float     m_transparency_threshold;
+            const size_t    m_max_iterations;
+            const bool      m_report_self_intersections;
+            const bool      m_use_occluder_cache;
+            const size_t    m_intersection_profiling_period;
+            const size_t    m_hit_sorting_batch_size;   // 0 to shade samples in the order they are traced
+
+            explicit Parameters(const ParamArray& params)
+              : m_transparency_threshold(params.get_optional<float>("transparency_threshold", 0.001f))
+              , m_max_iterations(params.get_optional<size_t>("max_iterations", 1000))
+              , m_report_self_intersections(params.get_optional<bool>("report_self_intersections", false))
+              , m_use_occluder_cache(params.get_optional<bool>("occluder_cache", true))
+              , m_intersection_profiling_period(params.get_optional<size_t>("intersection_profiling_period", 0))
+              , m_hit_sorting_batch_size(params.get_optional<size_t>("hit_sorting_batch_size", 0))
+            {
+            }
+        };
+
+        const Parameters            m_params;
+        const Scene&                m_scene;
+        const TraceContext&         m_trace_context;
+        const LightingConditions&   m_lighting_conditions;
+        const float                 m_opacity_threshold;
+        TextureCache                m_texture_cache;
+        ILightingEngine*            m_lighting_engine;
+        ShadingEngine&              m_shading_engine;
+        OIIO::TextureSystem&        m_oiio_texture_system;
+        const size_t                m_thread_index;
+
+        Arena                       m_arena;
+        OSLShaderGroupExec          m_shadergroup_exec;
+        const Intersector           m_intersector;
+        Tracer                      m_tracer;
+        const ShadingContext        m_shading_context;
+
+        Vector2d                    m_image_point_dx;
+        Vector2d                    m_image_point_dy;
+
+        bool                        m_store_features;
+        size_t                      m_depth_aov_index;
+        size_t                      m_albedo_aov_index;
+        size_t                      m_normal_aov_index;
+        size_t                      m_min_aov_count;
+
+        // Reusable storage for batches of samples.
+        vector<ShadingRay>          m_batch_rays;
+        vector<Dual2d>              m_batch_ndcs;
+        vector<SamplingContext*>    m_batch_sampling_contexts;
+        ShadingPoint*               m_batch_hits;
+        vector<HitSortKey>          m_batch_keys;
+        vector<size_t>              m_batch_strata;
+
+        uint64                      m_sample_count;
+
+        // Cache of primary hits shared with other rendering threads, or 0.
+        PrimaryHitCache*            m_primary_hit_cache;
+        uint64                      m_primary_hit_cache_hit_count;
+        uint64                      m_primary_hit_cache_miss_count;
+
+        // Counters shared with other rendering threads, updated every few samples.
+        LiveRenderCounters*         m_live_counters;
+        uint64                      m_published_sample_count;
+        uint64                      m_published_shading_ray_count;
+        uint64                      m_published_probe_ray_count;
+        uint64                      m_published_texture_cache_hit_count;
+        uint64                      m_published_texture_cache_miss_count;
+
+        void update_live_counters()
+        {
+            // Number of samples between two updates of the shared counters.
+            const uint64 LiveCountersUpdatePeriod = 64;
+
+            if (m_live_counters && m_sample_count - m_published_sample_count >= LiveCountersUpdatePeriod)
+                publish_live_counters();
+        }
+
+        void publish_live_counters()
+        {
+            const uint64 shading_ray_count = m_intersector.get_shading_ray_count();
+            const uint64 probe_ray_count = m_intersector.get_probe_ray_count();
+            const uint64 texture_cache_hit_count = m_texture_cache.get_hit_count();
+            const uint64 texture_cache_miss_count = m_texture_cache.get_miss_count();
+
+            m_live_counters->add(
+                m_sample_count - m_published_sample_count,
+                shading_ray_count - m_published_shading_ray_count,
+                probe_ray_count - m_published_probe_ray_count,
+                texture_cache_hit_count - m_published_texture_cache_hit_count,
+                texture_cache_miss_count - m_published_texture_cache_miss_count);
+
+            m_published_sample_count = m_sample_count;
+            m_published_shading_ray_count = shading_ray_count;
+            m_published_probe_ray_count = probe_ray_count;
+            m_published_texture_cache_hit_count = texture_cache_hit_count;
+            m_published_texture_cache_miss_count = texture_cache_miss_count;
+        }
+
+        // Trace the primary rays of a batch of samples at once, then shade
+        // their hits grouped by material and shader group.
+        void render_sample_batch(
+            const SampleRequest     requests[],
+            const size_t            count)
+        {
+            assert(count <= m_params.m_hit_sorting_batch_size);
+
+            m_sample_count += count;
+
+            m_batch_rays.resize(count);
+            m_batch_ndcs.resize(count);
+            m_batch_sampling_contexts.resize(count);
+            m_batch_keys.resize(count);
+            m_batch_strata.resize(count);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                Vector2d ndc(requests[i].m_image_point);
+                if (m_primary_hit_cache)
+                {
+                    m_batch_strata[i] =
+                        m_primary_hit_cache->snap(
+                            m_trace_context.get_version_id(),
+                            *requests[i].m_pixel_context,
+                            ndc);
+                }
+
+                m_batch_ndcs[i] = Dual2d(ndc, m_image_point_dx, m_image_point_dy);
+                m_batch_sampling_contexts[i] = requests[i].m_sampling_context;
+                m_batch_hits[i].clear();
+            }
+
+            // Let the camera generate all primary rays of the batch at once.
+            m_scene.get_active_camera()->spawn_rays(
+                &m_batch_sampling_contexts[0],
+                &m_batch_ndcs[0],
+                &m_batch_rays[0],
+                count);
+
+            if (m_primary_hit_cache)
+            {
+                for (size_t i = 0; i < count; ++i)
+                    trace_primary_ray(m_batch_strata[i], m_batch_rays[i], m_batch_hits[i]);
+            }
+            else m_intersector.trace(&m_batch_rays[0], count, m_batch_hits);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const ShadingPoint& hit = m_batch_hits[i];
+                const Material* material = hit.hit() ? hit.get_material() : 0;
+
+                HitSortKey& key = m_batch_keys[i];
+                key.m_material = material;
+                key.m_shader_group = material ? material->get_render_data().m_shader_group : 0;
+                key.m_index = i;
+            }
+
+            sort(m_batch_keys.begin(), m_batch_keys.end());
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const size_t index = m_batch_keys[i].m_index;
+                const SampleRequest& request = requests[index];
+
+                trace_and_shade(
+                    *request.m_sampling_context,
+                    *request.m_pixel_context,
+                    m_batch_rays[index],
+                    &m_batch_hits[index],
+                    *request.m_shading_result);
+            }
+        }
+
+        // Retrieve the hit of a primary ray from the primary hit cache, or trace the ray
+        // and store its hit in the cache. 'shading_point' must be cleared.
+        void trace_primary_ray(
+            const size_t            stratum,
+            const ShadingRay&       primary_ray,
+            ShadingPoint&           shading_point)
+        {
+            if (stratum == PrimaryHitCache::NoStratum)
+            {
+                m_intersector.trace(primary_ray, shading_point);
+                return;
+            }
+
+            const VersionID version_id = m_trace_context.get_version_id();
+
+            if (m_primary_hit_cache->lookup(stratum, version_id, m_intersector, primary_ray, shading_point))
+                ++m_primary_hit_cache_hit_count;
+            else
+            {
+                m_intersector.trace(primary_ray, shading_point);
+                m_primary_hit_cache->store(stratum, version_id, shading_point);
+                ++m_primary_hit_cache_miss_count;
+            }
+        }
+
+        // Shade a primary ray, continuing through transparent surfaces. If 'first_hit'
+        // is not null, it holds the result of tracing 'primary_ray' and is used as is.
+        void trace_and_shade(
+            SamplingContext&        sampling_context,
+            const PixelContext&     pixel_context,
+            ShadingRay&             primary_ray,
+            const ShadingPoint*     first_hit,
+            ShadingResult&          shading_result)
+        {
             ShadingPoint shading_points[2];
             size_t shading_point_index = 0;
             const ShadingPoint* shading_point_ptr = 0;
@@ -188,16 +564,24 @@ namespace
 
                 m_arena.clear();
 
-                // Trace the ray.
-                shading_points[shading_point_index].clear();
-                m_intersector.trace(
-                    primary_ray,
-                    shading_points[shading_point_index],
-                    shading_point_ptr);
-
-                // Update the pointers to the shading points.
-                shading_point_ptr = &shading_points[shading_point_index];
-                shading_point_index = 1 - shading_point_index;
+                if (iterations == 1 && first_hit)
+                {
+                    // The ray was already traced.
+                    shading_point_ptr = first_hit;
+                }
+                else
+                {
+                    // Trace the ray.
+                    shading_points[shading_point_index].clear();
+                    m_intersector.trace(
+                        primary_ray,
+                        shading_points[shading_point_index],
+                        shading_point_ptr);
+
+                    // Update the pointers to the shading points.
+                    shading_point_ptr = &shading_points[shading_point_index];
+                    shading_point_index = 1 - shading_point_index;
+                }
 
                 if (iterations == 1)
                 {
@@ -221,6 +605,13 @@ namespace
                         shading_point_ptr->hit()
                             ? shading_point_ptr->get_distance()
                             : -1.0;
+
+                    // Store the features of the first hit for the denoiser.
+                    // Sample generators that don't collect AOVs are left alone.
+                    if (m_store_features &&
+                        shading_point_ptr->hit() &&
+                        shading_result.m_aovs.size() >= m_min_aov_count)
+                        store_features(sampling_context, *shading_point_ptr, shading_result);
                 }
                 else
                 {
@@ -262,73 +653,78 @@ namespace
 
                 primary_ray.m_tmax = numeric_limits<double>::max();
             }
+        }
 
-#ifdef DEBUG_DISPLAY_TEXTURE_CACHE_PERFORMANCES
-
-            const uint64 delta_hit_count = m_texture_cache.get_hit_count() - last_texture_cache_hit_count;
-            const uint64 delta_miss_count = m_texture_cache.get_miss_count() - last_texture_cache_miss_count;
-
-            if (delta_hit_count + delta_miss_count == 0)
-            {
-                // In black: no access to the texture cache.
-                shading_result.set_main_to_linear_rgba(Color4f(0.0f, 0.0f, 0.0f, 1.0f));
-            }
-            else if (delta_hit_count > delta_miss_count)
+        void store_features(
+            SamplingContext&        sampling_context,
+            const ShadingPoint&     shading_point,
+            ShadingResult&          shading_result)
+        {
+            // Depth.
+            const float depth = static_cast<float>(shading_point.get_distance());
+            ShadingFragment& depth_aov = shading_result.m_aovs[m_depth_aov_index];
+            depth_aov.m_color = Color3f(depth);
+            depth_aov.m_alpha.set(1.0f);
+
+            // Shading normal, remapped to [0,1] to remain a valid color.
+            const Vector3f n(shading_point.get_shading_normal());
+            ShadingFragment& normal_aov = shading_result.m_aovs[m_normal_aov_index];
+            normal_aov.m_color = Color3f(n[0] * 0.5f + 0.5f, n[1] * 0.5f + 0.5f, n[2] * 0.5f + 0.5f);
+            normal_aov.m_alpha.set(1.0f);
+
+            // Albedo, estimated with a single sample of the BSDF. Surfaces without a BSDF
+            // (e.g. pure emitters) get a white albedo so that they are left untouched.
+            Color3f albedo(1.0f);
+            const Material* material = shading_point.get_material();
+            if (material)
             {
-                // In green: a majority of cache hits.
-                shading_result.set_main_to_linear_rgba(Color4f(0.0f, 1.0f, 0.0f, 1.0f));
+                const Material::RenderData& material_data = material->get_render_data();
+                if (material_data.m_bsdf)
+                    albedo = estimate_albedo(sampling_context, shading_point, material_data);
             }
-            else
+            ShadingFragment& albedo_aov = shading_result.m_aovs[m_albedo_aov_index];
+            albedo_aov.m_color = albedo;
+            albedo_aov.m_alpha.set(1.0f);
+        }
+
+        Color3f estimate_albedo(
+            SamplingContext&                sampling_context,
+            const ShadingPoint&             shading_point,
+            const Material::RenderData&     material_data)
+        {
+            if (material_data.m_shader_group)
             {
-                // In red: a majority of cache misses.
-                shading_result.set_main_to_linear_rgba(Color4f(1.0f, 0.0f, 0.0f, 1.0f));
+                m_shading_context.execute_osl_shading(
+                    *material_data.m_shader_group,
+                    shading_point);
             }
 
-#endif
-        }
+            const void* data = material_data.m_bsdf->evaluate_inputs(m_shading_context, shading_point);
 
-        virtual StatisticsVector get_statistics() const APPLESEED_OVERRIDE
-        {
-            StatisticsVector stats;
-            stats.merge(m_texture_cache.get_statistics());
-            stats.merge(m_intersector.get_statistics());
-            stats.merge(m_lighting_engine->get_statistics());
-            return stats;
-        }
+            BSDFSample sample(
+                &shading_point,
+                Dual3f(-normalize(Vector3f(shading_point.get_ray().m_dir))));
 
-      private:
-        struct Parameters
-        {
-            const float     m_transparency_threshold;
-            const size_t    m_max_iterations;
-            const bool      m_report_self_intersections;
+            material_data.m_bsdf->sample(
+                sampling_context,
+                data,
+                false,      // not adjoint
+                true,       // multiply by |cos(incoming, normal)|
+                sample);
 
-            explicit Parameters(const ParamArray& params)
-              : m_transparency_threshold(params.get_optional<float>("transparency_threshold", 0.001f))
-              , m_max_iterations(params.get_optional<size_t>("max_iterations", 1000))
-              , m_report_self_intersections(params.get_optional<bool>("report_self_intersections", false))
-            {
-            }
-        };
+            if (sample.m_mode == ScatteringMode::Absorption)
+                return Color3f(0.0f);
 
-        const Parameters            m_params;
-        const Scene&                m_scene;
-        const LightingConditions&   m_lighting_conditions;
-        const float                 m_opacity_threshold;
-        TextureCache                m_texture_cache;
-        ILightingEngine*            m_lighting_engine;
-        ShadingEngine&              m_shading_engine;
-        OIIO::TextureSystem&        m_oiio_texture_system;
-        const size_t                m_thread_index;
+            if (sample.m_probability != BSDF::DiracDelta)
+                sample.m_value /= sample.m_probability;
 
-        Arena                       m_arena;
-        OSLShaderGroupExec          m_shadergroup_exec;
-        const Intersector           m_intersector;
-        Tracer                      m_tracer;
-        const ShadingContext        m_shading_context;
+            const Color3f albedo =
+                sample.m_value.is_rgb()
+                    ? sample.m_value.rgb()
+                    : sample.m_value.convert_to_rgb(m_lighting_conditions);
 
-        Vector2d                    m_image_point_dx;
-        Vector2d                    m_image_point_dy;
+            return saturate(albedo);
+        }
     };
 }
 
@@ -346,6 +742,7 @@ GenericSampleRendererFactory::GenericSampleRendererFactory(
     ShadingEngine&          shading_engine,
     OIIO::TextureSystem&    oiio_texture_system,
     OSL::ShadingSystem&     shading_system,
+    LiveRenderCounters*     live_counters,
     const ParamArray&       params)
   : m_scene(scene)
   , m_frame(frame)
@@ -355,8 +752,34 @@ GenericSampleRendererFactory::GenericSampleRendererFactory(
   , m_shading_engine(shading_engine)
   , m_oiio_texture_system(oiio_texture_system)
   , m_shading_system(shading_system)
+  , m_live_counters(live_counters)
   , m_params(params)
+  , m_primary_hit_cache(0)
+{
+    if (m_params.get_optional<bool>("primary_hit_cache", false))
+    {
+        if (PrimaryHitCache::is_supported(scene, frame))
+        {
+            const size_t strata = max<size_t>(m_params.get_optional<size_t>("primary_hit_cache_strata", 2), 1);
+            m_primary_hit_cache = new PrimaryHitCache(frame, strata);
+
+            RENDERER_LOG_INFO(
+                "caching primary hits in %s strata per pixel (%s).",
+                pretty_uint(strata * strata).c_str(),
+                pretty_size(m_primary_hit_cache->get_memory_size()).c_str());
+        }
+        else
+        {
+            RENDERER_LOG_WARNING(
+                "primary hits can only be cached with a pinhole camera whose shutter "
+                "opens and closes at the same time, and a box filter; disabling primary hit cache.");
+        }
+    }
+}
+
+GenericSampleRendererFactory::~GenericSampleRendererFactory()
 {
+    delete m_primary_hit_cache;
 }
 
 void GenericSampleRendererFactory::release()
@@ -376,8 +799,33 @@ ISampleRenderer* GenericSampleRendererFactory::create(const size_t thread_index)
             m_shading_engine,
             m_oiio_texture_system,
             m_shading_system,
+            m_live_counters,
+            m_primary_hit_cache,
             thread_index,
             m_params);
 }
 
+Dictionary GenericSampleRendererFactory::get_params_metadata()
+{
+    Dictionary metadata;
+
+    metadata.dictionaries().insert(
+        "primary_hit_cache",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Primary Hit Cache")
+            .insert("help", "Reuse the hits of camera rays across progressive passes by snapping the first samples of each pixel to the centers of its strata; this introduces a bias that fades as more passes are rendered"));
+
+    metadata.dictionaries().insert(
+        "primary_hit_cache_strata",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "2")
+            .insert("label", "Primary Hit Cache Strata")
+            .insert("help", "Number of strata per pixel along each axis; only the first strata x strata samples of each pixel use the primary hit cache"));
+
+    return metadata;
+}
+
 }   // namespace renderer
@@ -50,8 +50,11 @@ BEGIN_OIIO_INCLUDES
 END_OIIO_INCLUDES
 
 // Forward declarations.
+namespace foundation  { class Dictionary; }
 namespace renderer  { class Frame; }
 namespace renderer  { class ILightingEngineFactory; }
+namespace renderer  { class LiveRenderCounters; }
+namespace renderer  { class PrimaryHitCache; }
 namespace renderer  { class Scene; }
 namespace renderer  { class ShadingEngine; }
 namespace renderer  { class TextureStore; }
@@ -68,7 +71,7 @@ class GenericSampleRendererFactory
   : public ISampleRendererFactory
 {
   public:
-    // Constructor.
+    // Constructor. 'live_counters' may be 0.
     GenericSampleRendererFactory(
         const Scene&            scene,
         const Frame&            frame,
@@ -78,8 +81,12 @@ class GenericSampleRendererFactory
         ShadingEngine&          shading_engine,
         OIIO::TextureSystem&    oiio_texture_system,
         OSL::ShadingSystem&     shading_system,
+        LiveRenderCounters*     live_counters,
         const ParamArray&       params);
 
+    // Destructor.
+    ~GenericSampleRendererFactory();
+
     // Delete this instance.
     virtual void release() APPLESEED_OVERRIDE;
 
@@ -87,6 +94,9 @@ class GenericSampleRendererFactory
     virtual ISampleRenderer* create(
         const size_t            thread_index) APPLESEED_OVERRIDE;
 
+    // Return the metadata of the generic sample renderer parameters.
+    static foundation::Dictionary get_params_metadata();
+
   private:
     const Scene&                m_scene;
     const Frame&                m_frame;
@@ -96,7 +106,9 @@ class GenericSampleRendererFactory
     ShadingEngine&              m_shading_engine;
     OIIO::TextureSystem&        m_oiio_texture_system;
     OSL::ShadingSystem&         m_shading_system;
+    LiveRenderCounters*         m_live_counters;
     const ParamArray            m_params;
+    PrimaryHitCache*            m_primary_hit_cache;        // shared by all sample renderers, or 0
 };
 
 }       // namespace renderer
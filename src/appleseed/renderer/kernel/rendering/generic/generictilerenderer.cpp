@@ -43,6 +43,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/image/canvasproperties.h"
+#include "foundation/image/deeptile.h"
 #include "foundation/image/image.h"
 #include "foundation/image/tile.h"
 #include "foundation/math/aabb.h"
@@ -55,6 +56,7 @@
 #include "foundation/platform/breakpoint.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/counterblock.h"
 #include "foundation/utility/iostreamop.h"
 #include "foundation/utility/job.h"
 #include "foundation/utility/statistics.h"
@@ -99,6 +101,9 @@ namespace
             const size_t                        thread_index)
           : m_pixel_renderer(pixel_renderer_factory->create(thread_index))
           , m_framebuffer_factory(framebuffer_factory)
+          , m_tile_counter(m_counters.declare_counter("tiles"))
+          , m_rendering_timer(m_counters.declare_timer("rendering time"))
+          , m_development_timer(m_counters.declare_timer("development time"))
         {
             compute_tile_margins(frame, thread_index == 0);
             compute_pixel_ordering(frame);
@@ -150,6 +155,8 @@ namespace
             padded_tile_bbox.max.x = tile_bbox.max.x + m_margin_width;
             padded_tile_bbox.max.y = tile_bbox.max.y + m_margin_height;
 
+            const uint64 rendering_start_time = m_counters.read_time();
+
             // Inform the pixel renderer that we are about to render a tile.
             m_pixel_renderer->on_tile_begin(frame, tile, aov_tiles);
 
@@ -162,6 +169,12 @@ namespace
                     tile_bbox);
             assert(framebuffer);
 
+            // Record the fragments of the samples if the frame has a deep output.
+            DeepTile* deep_tile = 0;
+            if (frame.is_deep_output_open())
+                deep_tile = get_deep_tile(frame, tile.get_width(), tile.get_height());
+            framebuffer->set_deep_tile(deep_tile);
+
             // Seed the RNG with the tile index and the pass hash.
             // Seeding the RNG per tile instead of per pixel has potential consequences on
             // debugging: rendering a subset of a tile may lead to different computations
@@ -211,21 +224,42 @@ namespace
                     *framebuffer);
             }
 
+            // Complete the samples the pixel renderer may have deferred.
+            m_pixel_renderer->flush_pixels(frame, *framebuffer);
+
+            m_counters.add_time(m_rendering_timer, rendering_start_time);
+
             // Develop the framebuffer to the tile.
-            if (frame.is_premultiplied_alpha())
-                framebuffer->develop_to_tile_premult_alpha(tile, aov_tiles);
-            else framebuffer->develop_to_tile_straight_alpha(tile, aov_tiles);
+            {
+                ScopedCounterBlockTimer timer(m_counters, m_development_timer);
+                if (frame.is_premultiplied_alpha())
+                    framebuffer->develop_to_tile_premult_alpha(tile, aov_tiles);
+                else framebuffer->develop_to_tile_straight_alpha(tile, aov_tiles);
+            }
+
+            // Write the fragments of the tile to the deep output.
+            if (deep_tile)
+            {
+                frame.write_deep_tile(tile_x, tile_y, *deep_tile);
+                framebuffer->set_deep_tile(0);
+            }
 
             // Release the framebuffer.
             m_framebuffer_factory->destroy(framebuffer);
 
             // Inform the pixel renderer that we are done rendering the tile.
             m_pixel_renderer->on_tile_end(frame, tile, aov_tiles);
+
+            // Publish the per-tile counters.
+            m_counters.increment(m_tile_counter);
+            m_counters.flush(m_tile_stats);
         }
 
         virtual StatisticsVector get_statistics() const APPLESEED_OVERRIDE
         {
-            return m_pixel_renderer->get_statistics();
+            StatisticsVector stats = m_pixel_renderer->get_statistics();
+            stats.insert("generic tile renderer statistics", m_tile_stats);
+            return stats;
         }
 
       protected:
@@ -235,6 +269,36 @@ namespace
         int                                 m_margin_height;
         vector<Vector<int16, 2> >           m_pixel_ordering;
         SamplingContext::RNGType            m_rng;
+        auto_ptr<DeepTile>                  m_deep_tile;
+        CounterBlock                        m_counters;
+        const size_t                        m_tile_counter;
+        const size_t                        m_rendering_timer;
+        const size_t                        m_development_timer;
+        Statistics                          m_tile_stats;
+
+        // Return a cleared deep tile of given dimensions, reusing the previous one if possible.
+        DeepTile* get_deep_tile(
+            const Frame&                    frame,
+            const size_t                    width,
+            const size_t                    height)
+        {
+            if (m_deep_tile.get() &&
+                m_deep_tile->get_width() == width &&
+                m_deep_tile->get_height() == height &&
+                m_deep_tile->get_max_fragment_count() == frame.get_deep_max_fragment_count())
+                m_deep_tile->clear();
+            else
+            {
+                m_deep_tile.reset(
+                    new DeepTile(
+                        width,
+                        height,
+                        frame.get_deep_max_fragment_count(),
+                        frame.get_deep_depth_tolerance()));
+            }
+
+            return m_deep_tile.get();
+        }
 
         void compute_tile_margins(const Frame& frame, const bool primary)
         {
@@ -31,6 +31,7 @@
 #include "tilejob.h"
 
 // appleseed.renderer headers.
+#include "renderer/kernel/aov/imagestack.h"
 #include "renderer/kernel/rendering/itilecallback.h"
 #include "renderer/kernel/rendering/itilerenderer.h"
 #include "renderer/modeling/frame/frame.h"
@@ -39,6 +40,10 @@
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/image.h"
 #include "foundation/image/tile.h"
+#include "foundation/platform/tsctimer.h"
+#include "foundation/utility/eventtracer.h"
+#include "foundation/utility/job/iabortswitch.h"
+#include "foundation/utility/stopwatch.h"
 
 // Standard headers.
 #include <cassert>
@@ -61,7 +66,8 @@ TileJob::TileJob(
     const size_t                tile_x,
     const size_t                tile_y,
     const size_t                pass_hash,
-    IAbortSwitch&               abort_switch)
+    IAbortSwitch&               abort_switch,
+    double*                     render_time)
   : m_tile_renderers(tile_renderers)
   , m_tile_callbacks(tile_callbacks)
   , m_frame(frame)
@@ -69,6 +75,7 @@ TileJob::TileJob(
   , m_tile_y(tile_y)
   , m_pass_hash(pass_hash)
   , m_abort_switch(abort_switch)
+  , m_render_time(render_time)
 {
     // Either there is no tile callback, or there is the same number
     // of tile callbacks and rendering threads.
@@ -81,6 +88,8 @@ void TileJob::execute(const size_t thread_index)
 {
     assert(thread_index < m_tile_renderers.size());
 
+    ScopedTraceEvent event("tile", "rendering");
+
     // Retrieve the tile callback.
     ITileCallback* tile_callback =
         m_tile_callbacks.size() == m_tile_renderers.size()
@@ -105,6 +114,9 @@ void TileJob::execute(const size_t thread_index)
 
     try
     {
+        Stopwatch<TSCTimer> stopwatch(0);
+        stopwatch.start();
+
         // Render the tile.
         m_tile_renderers[thread_index]->render_tile(
             m_frame,
@@ -112,6 +124,13 @@ void TileJob::execute(const size_t thread_index)
             m_tile_y,
             m_pass_hash,
             m_abort_switch);
+
+        // Record the render time of the tile, unless rendering was interrupted.
+        if (m_render_time && !m_abort_switch.is_aborted())
+        {
+            stopwatch.measure();
+            *m_render_time = stopwatch.get_seconds();
+        }
     }
     catch (const exception&)
     {
@@ -126,6 +145,10 @@ void TileJob::execute(const size_t thread_index)
     // Call the post-render tile callback.
     if (tile_callback)
         tile_callback->post_render_tile(&m_frame, m_tile_x, m_tile_y);
+
+    // Compress the AOV tiles now that they are no longer needed.
+    if (m_frame.is_aov_tile_compression_enabled())
+        m_frame.aov_images().compress_tiles(m_tile_x, m_tile_y);
 }
 
 }   // namespace renderer
@@ -56,7 +56,8 @@ class TileJob
     typedef std::vector<ITileRenderer*> TileRendererVector;
     typedef std::vector<ITileCallback*> TileCallbackVector;
 
-    // Constructor.
+    // Constructor. If 'render_time' is not null, the time in seconds it took
+    // to render the tile is stored there once the job has completed.
     TileJob(
         const TileRendererVector&   tile_renderers,
         const TileCallbackVector&   tile_callbacks,
@@ -64,7 +65,8 @@ class TileJob
         const size_t                tile_x,
         const size_t                tile_y,
         const size_t                pass_hash,
-        foundation::IAbortSwitch&   abort_switch);
+        foundation::IAbortSwitch&   abort_switch,
+        double*                     render_time = 0);
 
     // Execute the job.
     virtual void execute(const size_t thread_index);
@@ -77,6 +79,7 @@ class TileJob
     const size_t                    m_tile_y;
     const size_t                    m_pass_hash;
     foundation::IAbortSwitch&       m_abort_switch;
+    double*                         m_render_time;
 };
 
 }       // namespace renderer
@@ -40,6 +40,7 @@
 #include "foundation/utility/otherwise.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 
 using namespace foundation;
@@ -48,6 +49,26 @@ using namespace std;
 namespace renderer
 {
 
+namespace
+{
+    // Order tile indices by decreasing render time.
+    struct CompareTileCosts
+    {
+        const vector<double>& m_tile_costs;
+
+        explicit CompareTileCosts(const vector<double>& tile_costs)
+          : m_tile_costs(tile_costs)
+        {
+        }
+
+        bool operator()(const size_t lhs, const size_t rhs) const
+        {
+            return m_tile_costs[lhs] > m_tile_costs[rhs];
+        }
+    };
+}
+
+
 //
 // TileJobFactory class implementation.
 //
@@ -90,7 +111,8 @@ void TileJobFactory::create(
                 tile_x,
                 tile_y,
                 pass_hash,
-                abort_switch));
+                abort_switch,
+                tile_ordering == CostOrdering ? &m_tile_costs[tile_index] : 0));
     }
 }
 
@@ -99,6 +121,10 @@ void TileJobFactory::generate_tile_ordering(
     const TileOrdering                  tile_ordering,
     vector<size_t>&                     tiles)
 {
+    // Forget the tile costs if the frame layout changed.
+    if (m_tile_costs.size() != frame_properties.m_tile_count)
+        m_tile_costs.assign(frame_properties.m_tile_count, 0.0);
+
     switch (tile_ordering)
     {
       case LinearOrdering:
@@ -128,8 +154,29 @@ void TileJobFactory::generate_tile_ordering(
             m_rng);
         break;
 
+      case CostOrdering:
+        generate_cost_ordering(
+            frame_properties,
+            tiles);
+        break;
+
       assert_otherwise;
     }
 }
 
+void TileJobFactory::generate_cost_ordering(
+    const CanvasProperties&             frame_properties,
+    vector<size_t>&                     tiles)
+{
+    // Start from a Hilbert ordering: it is kept for tiles with equal (or unknown) costs.
+    hilbert_ordering(
+        tiles,
+        frame_properties.m_tile_count_x,
+        frame_properties.m_tile_count_y);
+
+    // Schedule the most expensive tiles first so that they don't end up
+    // being rendered by a single thread at the end of the pass.
+    stable_sort(tiles.begin(), tiles.end(), CompareTileCosts(m_tile_costs));
+}
+
 }   // namespace renderer
@@ -36,6 +36,9 @@
 // appleseed.foundation headers.
 #include "foundation/math/rng/mersennetwister.h"
 
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
 // Standard headers.
 #include <cstddef>
 #include <vector>
@@ -53,7 +56,7 @@ namespace renderer
 // Creates tile jobs to render a complete frame.
 //
 
-class TileJobFactory
+class APPLESEED_DLLSYMBOL TileJobFactory
 {
   public:
     typedef std::vector<TileJob*> TileJobVector;
@@ -64,7 +67,8 @@ class TileJobFactory
         LinearOrdering,
         SpiralOrdering,
         HilbertOrdering,
-        RandomOrdering
+        RandomOrdering,
+        CostOrdering            // most expensive tiles first, based on the timings of the previous pass
     };
 
     // Create tile jobs for a given frame.
@@ -77,12 +81,20 @@ class TileJobFactory
         TileJobVector&                      tile_jobs,
         foundation::IAbortSwitch&           abort_switch);
 
+    // Generate the indices of the tiles of a frame in a given order.
+    void generate_tile_ordering(
+        const foundation::CanvasProperties& frame_properties,
+        const TileOrdering                  tile_ordering,
+        std::vector<size_t>&                tiles);
+
   private:
     foundation::MersenneTwister             m_rng;
+    std::vector<double>                     m_tile_costs;   // render time in seconds of each tile, 0 if unknown
 
-    void generate_tile_ordering(
+    // Order tiles by decreasing render time. Tiles that were never rendered
+    // (for instance during the first pass) are ordered along a Hilbert curve.
+    void generate_cost_ordering(
         const foundation::CanvasProperties& frame_properties,
-        const TileOrdering                  tile_ordering,
         std::vector<size_t>&                tiles);
 };
 
@@ -40,10 +40,17 @@
 #include "foundation/image/image.h"
 #include "foundation/image/pixel.h"
 #include "foundation/image/tile.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
 #include "foundation/utility/job/iabortswitch.h"
 
 // Boost headers.
 #include "boost/chrono/duration.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+// Standard headers.
+#include <algorithm>
 
 using namespace foundation;
 using namespace std;
@@ -51,13 +58,112 @@ using namespace std;
 namespace renderer
 {
 
+namespace
+{
+    // Size in pixels of the square buckets in which thread buffers track the pixels they modified.
+    const size_t BucketSize = 32;
+
+    // Maximum number of threads merging thread buffers into the framebuffer.
+    const size_t MaxMergeThreadCount = 8;
+
+    template <typename Lock>
+    bool lock_unless_aborted(Lock& lock, IAbortSwitch& abort_switch)
+    {
+        while (true)
+        {
+            if (abort_switch.is_aborted())
+                return false;
+            if (lock.try_lock_for(boost::chrono::milliseconds(5)))
+                return true;
+        }
+    }
+}
+
+//
+// Samples are splatted into a thread buffer under a mutex that is only contended by
+// the threads sharing that thread buffer, and briefly by clear() and develop_to_frame()
+// which lock the thread buffer once per bucket.
+//
+
+struct GlobalSampleAccumulationBuffer::ThreadBuffer
+{
+    boost::mutex                    m_mutex;
+    FilteredTile                    m_fb;
+    vector<uint8>                   m_dirty_buckets;    // one flag per bucket, set if the bucket holds samples
+
+    ThreadBuffer(
+        const size_t                width,
+        const size_t                height,
+        const Filter2f&             filter,
+        const size_t                bucket_count)
+      : m_fb(width, height, 3, filter)
+      , m_dirty_buckets(bucket_count, 0)
+    {
+        m_fb.clear();
+    }
+};
+
+namespace
+{
+    // Merge a share of the buckets of the thread buffers into the framebuffer.
+    class MergeThreadBuffersFunc
+    {
+      public:
+        MergeThreadBuffersFunc(
+            GlobalSampleAccumulationBuffer& buffer,
+            void (GlobalSampleAccumulationBuffer::*merge)(const size_t, const size_t, IAbortSwitch*),
+            const size_t                    first_bucket,
+            const size_t                    bucket_stride,
+            IAbortSwitch&                   abort_switch)
+          : m_buffer(buffer)
+          , m_merge(merge)
+          , m_first_bucket(first_bucket)
+          , m_bucket_stride(bucket_stride)
+          , m_abort_switch(abort_switch)
+        {
+        }
+
+        void operator()()
+        {
+            (m_buffer.*m_merge)(m_first_bucket, m_bucket_stride, &m_abort_switch);
+        }
+
+      private:
+        GlobalSampleAccumulationBuffer&     m_buffer;
+        void (GlobalSampleAccumulationBuffer::*m_merge)(const size_t, const size_t, IAbortSwitch*);
+        const size_t                        m_first_bucket;
+        const size_t                        m_bucket_stride;
+        IAbortSwitch&                       m_abort_switch;
+    };
+}
+
 GlobalSampleAccumulationBuffer::GlobalSampleAccumulationBuffer(
     const size_t    width,
     const size_t    height,
-    const Filter2f& filter)
+    const Filter2f& filter,
+    const size_t    thread_buffer_count)
   : m_fb(width, height, 3, filter)
   , m_filter_rcp_norm_factor(1.0f / compute_normalization_factor(filter))
+  , m_bucket_count_x((width + BucketSize - 1) / BucketSize)
+  , m_bucket_count_y((height + BucketSize - 1) / BucketSize)
+  , m_updated_buckets(m_bucket_count_x * m_bucket_count_y, 0)
+  , m_touched_buckets(m_bucket_count_x * m_bucket_count_y, 0)
+  , m_displayed_sample_count(0)
+  , m_full_refresh(true)
 {
+    m_thread_buffers.reserve(thread_buffer_count);
+
+    for (size_t i = 0; i < thread_buffer_count; ++i)
+    {
+        m_thread_buffers.push_back(
+            new ThreadBuffer(width, height, filter, m_bucket_count_x * m_bucket_count_y));
+    }
+}
+
+GlobalSampleAccumulationBuffer::~GlobalSampleAccumulationBuffer()
+{
+    for (size_t i = 0, e = m_thread_buffers.size(); i < e; ++i)
+        delete m_thread_buffers[i];
 }
 
 void GlobalSampleAccumulationBuffer::clear()
@@ -66,42 +172,66 @@ void GlobalSampleAccumulationBuffer::clear()
     boost::unique_lock<boost::shared_mutex> lock(m_mutex);
 
     m_sample_count = 0;
+    m_displayed_sample_count = 0;
+    m_full_refresh = true;
 
     m_fb.clear();
+    fill(m_updated_buckets.begin(), m_updated_buckets.end(), 0);
+    fill(m_touched_buckets.begin(), m_touched_buckets.end(), 0);
+
+    for (size_t i = 0, e = m_thread_buffers.size(); i < e; ++i)
+    {
+        ThreadBuffer& thread_buffer = *m_thread_buffers[i];
+        boost::mutex::scoped_lock thread_buffer_lock(thread_buffer.m_mutex);
+        thread_buffer.m_fb.clear();
+        fill(thread_buffer.m_dirty_buckets.begin(), thread_buffer.m_dirty_buckets.end(), 0);
+    }
+}
+
+void GlobalSampleAccumulationBuffer::store_samples(
+    const size_t    sample_count,
+    const Sample    samples[],
+    IAbortSwitch&   abort_switch)
+{
+    store_samples(0, sample_count, samples, abort_switch);
 }
 
 void GlobalSampleAccumulationBuffer::store_samples(
+    const size_t    thread_index,
     const size_t    sample_count,
     const Sample    samples[],
     IAbortSwitch&   abort_switch)
 {
-    // Request non-exclusive access.
-    boost::shared_lock<boost::shared_mutex> lock(m_mutex, boost::defer_lock);
-    while (true)
+    if (m_thread_buffers.empty())
     {
-        if (abort_switch.is_aborted())
+        // Request non-exclusive access.
+        boost::shared_lock<boost::shared_mutex> lock(m_mutex, boost::defer_lock);
+        if (!lock_unless_aborted(lock, abort_switch))
             return;
-        if (lock.try_lock_for(boost::chrono::milliseconds(5)))
-            break;
+
+        add_samples(sample_count, samples, abort_switch);
+        return;
     }
 
+    ThreadBuffer& thread_buffer = *m_thread_buffers[thread_index % m_thread_buffers.size()];
+
     const float fw = static_cast<float>(m_fb.get_width());
     const float fh = static_cast<float>(m_fb.get_height());
-    size_t counter = 0;
+
+    boost::mutex::scoped_lock lock(thread_buffer.m_mutex);
 
     const Sample* sample_end = samples + sample_count;
     for (const Sample* s = samples; s < sample_end; ++s)
     {
-        if ((counter++ & 4096) == 0 && abort_switch.is_aborted())
-            return;
-
         const float fx = s->m_position.x * fw;
         const float fy = s->m_position.y * fh;
 
         Color3f value(s->m_values);
         value *= m_filter_rcp_norm_factor;
 
-        m_fb.add(fx, fy, &value[0]);
+        thread_buffer.m_fb.add_exclusive(fx, fy, &value[0]);
+
+        flag_buckets(fx, fy, thread_buffer.m_dirty_buckets);
     }
 }
 
@@ -111,14 +241,111 @@ void GlobalSampleAccumulationBuffer::develop_to_frame(
 {
     // Request exclusive access.
     boost::unique_lock<boost::shared_mutex> lock(m_mutex, boost::defer_lock);
-    while (true)
+    if (!lock_unless_aborted(lock, abort_switch))
+        return;
+
+    // Gather the samples accumulated by thread buffers.
+    merge_thread_buffers(abort_switch);
+
+    develop_tiles(frame, 0, 0, abort_switch);
+}
+
+void GlobalSampleAccumulationBuffer::develop_dirty_tiles_to_frame(
+    Frame&          frame,
+    vector<size_t>& tiles,
+    IAbortSwitch&   abort_switch)
+{
+    // Request exclusive access.
+    boost::unique_lock<boost::shared_mutex> lock(m_mutex, boost::defer_lock);
+    if (!lock_unless_aborted(lock, abort_switch))
+        return;
+
+    // Gather the samples accumulated by thread buffers.
+    merge_thread_buffers(abort_switch);
+
+    for (size_t b = 0, e = m_updated_buckets.size(); b < e; ++b)
+        m_touched_buckets[b] |= m_updated_buckets[b];
+
+    // If the sample count didn't change, only pixels that received samples have changed.
+    // Otherwise, all the pixels that ever received samples have been renormalized.
+    const uint64 sample_count = m_sample_count;
+    develop_tiles(
+        frame,
+        m_full_refresh ? 0 :
+        sample_count == m_displayed_sample_count ? &m_updated_buckets : &m_touched_buckets,
+        &tiles,
+        abort_switch);
+
+    if (abort_switch.is_aborted())
+        return;
+
+    fill(m_updated_buckets.begin(), m_updated_buckets.end(), 0);
+    m_displayed_sample_count = sample_count;
+    m_full_refresh = false;
+}
+
+void GlobalSampleAccumulationBuffer::increment_sample_count(const uint64 delta_sample_count)
+{
+    m_sample_count += delta_sample_count;
+}
+
+void GlobalSampleAccumulationBuffer::flag_buckets(
+    const float     fx,
+    const float     fy,
+    vector<uint8>&  flags) const
+{
+    const float rx = m_fb.get_filter().get_xradius();
+    const float ry = m_fb.get_filter().get_yradius();
+    const size_t max_x = m_fb.get_width() - 1;
+    const size_t max_y = m_fb.get_height() - 1;
+
+    const size_t bx0 = min(static_cast<size_t>(max(fx - 0.5f - rx, 0.0f)), max_x) / BucketSize;
+    const size_t by0 = min(static_cast<size_t>(max(fy - 0.5f - ry, 0.0f)), max_y) / BucketSize;
+    const size_t bx1 = min(static_cast<size_t>(max(fx - 0.5f + rx + 1.0f, 0.0f)), max_x) / BucketSize;
+    const size_t by1 = min(static_cast<size_t>(max(fy - 0.5f + ry + 1.0f, 0.0f)), max_y) / BucketSize;
+
+    for (size_t by = by0; by <= by1; ++by)
     {
-        if (abort_switch.is_aborted())
-            return;
-        if (lock.try_lock_for(boost::chrono::milliseconds(5)))
-            break;
+        for (size_t bx = bx0; bx <= bx1; ++bx)
+            flags[by * m_bucket_count_x + bx] = 1;
     }
+}
+
+bool GlobalSampleAccumulationBuffer::add_samples(
+    const size_t    sample_count,
+    const Sample    samples[],
+    IAbortSwitch&   abort_switch)
+{
+    const float fw = static_cast<float>(m_fb.get_width());
+    const float fh = static_cast<float>(m_fb.get_height());
+    size_t counter = 0;
+
+    const Sample* sample_end = samples + sample_count;
+    for (const Sample* s = samples; s < sample_end; ++s)
+    {
+        if ((counter++ & 4096) == 0 && abort_switch.is_aborted())
+            return false;
 
+        const float fx = s->m_position.x * fw;
+        const float fy = s->m_position.y * fh;
+
+        Color3f value(s->m_values);
+        value *= m_filter_rcp_norm_factor;
+
+        m_fb.add(fx, fy, &value[0]);
+
+        flag_buckets(fx, fy, m_updated_buckets);
+    }
+
+    return true;
+}
+
+void GlobalSampleAccumulationBuffer::develop_tiles(
+    Frame&                  frame,
+    const vector<uint8>*    buckets,
+    vector<size_t>*         tiles,
+    IAbortSwitch&           abort_switch)
+{
     Image& image = frame.image();
     const CanvasProperties& frame_props = image.properties();
 
@@ -126,6 +353,7 @@ void GlobalSampleAccumulationBuffer::develop_to_frame(
     assert(frame_props.m_canvas_height == m_fb.get_height());
     assert(frame_props.m_channel_count == 4);
 
+    const AABB2u& crop_window = frame.get_crop_window();
     const float scale = 1.0f / m_sample_count;
 
     for (size_t ty = 0; ty < frame_props.m_tile_count_y; ++ty)
@@ -140,37 +368,147 @@ void GlobalSampleAccumulationBuffer::develop_to_frame(
             const size_t x = tx * frame_props.m_tile_width;
             const size_t y = ty * frame_props.m_tile_height;
 
-            develop_to_tile(tile, x, y, tx, ty, scale);
+            const AABB2u tile_rect(
+                Vector2u(x, y),
+                Vector2u(x + tile.get_width() - 1, y + tile.get_height() - 1));
+
+            // Leave the pixels outside of the crop window untouched.
+            if (!AABB2u::overlap(tile_rect, crop_window))
+                continue;
+
+            if (buckets && !is_flagged(*buckets, tile_rect))
+                continue;
+
+            develop_to_tile(tile, x, y, AABB2u::intersect(tile_rect, crop_window), scale);
+
+            if (tiles)
+                tiles->push_back(ty * frame_props.m_tile_count_x + tx);
         }
     }
 }
 
-void GlobalSampleAccumulationBuffer::increment_sample_count(const uint64 delta_sample_count)
+bool GlobalSampleAccumulationBuffer::is_flagged(
+    const vector<uint8>&    flags,
+    const AABB2u&           rect) const
 {
-    m_sample_count += delta_sample_count;
+    const size_t bx0 = rect.min.x / BucketSize;
+    const size_t by0 = rect.min.y / BucketSize;
+    const size_t bx1 = min(rect.max.x / BucketSize, m_bucket_count_x - 1);
+    const size_t by1 = min(rect.max.y / BucketSize, m_bucket_count_y - 1);
+
+    for (size_t by = by0; by <= by1; ++by)
+    {
+        for (size_t bx = bx0; bx <= bx1; ++bx)
+        {
+            if (flags[by * m_bucket_count_x + bx])
+                return true;
+        }
+    }
+
+    return false;
+}
+
+void GlobalSampleAccumulationBuffer::merge_thread_buffers(IAbortSwitch& abort_switch)
+{
+    if (m_thread_buffers.empty())
+        return;
+
+    const size_t bucket_count = m_bucket_count_x * m_bucket_count_y;
+    const size_t merge_thread_count =
+        min(min(m_thread_buffers.size(), bucket_count),
+            min(max<size_t>(boost::thread::hardware_concurrency(), 1), MaxMergeThreadCount));
+
+    if (merge_thread_count <= 1)
+    {
+        merge_thread_buffer_buckets(0, 1, &abort_switch);
+        return;
+    }
+
+    // Each merge thread owns a distinct set of buckets of the framebuffer.
+    boost::thread_group merge_threads;
+
+    for (size_t i = 1; i < merge_thread_count; ++i)
+    {
+        merge_threads.create_thread(
+            MergeThreadBuffersFunc(
+                *this,
+                &GlobalSampleAccumulationBuffer::merge_thread_buffer_buckets,
+                i,
+                merge_thread_count,
+                abort_switch));
+    }
+
+    merge_thread_buffer_buckets(0, merge_thread_count, &abort_switch);
+
+    merge_threads.join_all();
+}
+
+void GlobalSampleAccumulationBuffer::merge_thread_buffer_buckets(
+    const size_t    first_bucket,
+    const size_t    bucket_stride,
+    IAbortSwitch*   abort_switch)
+{
+    const size_t width = m_fb.get_width();
+    const size_t height = m_fb.get_height();
+    const size_t channel_count = m_fb.get_channel_count();
+    const size_t bucket_count = m_bucket_count_x * m_bucket_count_y;
+
+    for (size_t b = first_bucket; b < bucket_count; b += bucket_stride)
+    {
+        if (abort_switch->is_aborted())
+            return;
+
+        const size_t x0 = (b % m_bucket_count_x) * BucketSize;
+        const size_t y0 = (b / m_bucket_count_x) * BucketSize;
+        const size_t x1 = min(x0 + BucketSize, width);
+        const size_t y1 = min(y0 + BucketSize, height);
+        const size_t row_size = (x1 - x0) * channel_count;
+
+        for (size_t i = 0, e = m_thread_buffers.size(); i < e; ++i)
+        {
+            ThreadBuffer& thread_buffer = *m_thread_buffers[i];
+
+            boost::mutex::scoped_lock lock(thread_buffer.m_mutex);
+
+            if (!thread_buffer.m_dirty_buckets[b])
+                continue;
+
+            // Move the samples of the bucket to the framebuffer.
+            for (size_t y = y0; y < y1; ++y)
+            {
+                float* APPLESEED_RESTRICT src = thread_buffer.m_fb.pixel(x0, y);
+                float* APPLESEED_RESTRICT dst = m_fb.pixel(x0, y);
+
+                for (size_t j = 0; j < row_size; ++j)
+                {
+                    dst[j] += src[j];
+                    src[j] = 0.0f;
+                }
+            }
+
+            thread_buffer.m_dirty_buckets[b] = 0;
+            m_updated_buckets[b] = 1;
+        }
+    }
 }
 
 void GlobalSampleAccumulationBuffer::develop_to_tile(
     Tile&           tile,
     const size_t    origin_x,
     const size_t    origin_y,
-    const size_t    tile_x,
-    const size_t    tile_y,
+    const AABB2u&   rect,
     const float     scale) const
 {
-    const size_t tile_width = tile.get_width();
-    const size_t tile_height = tile.get_height();
-
-    for (size_t y = 0; y < tile_height; ++y)
+    for (size_t y = rect.min.y; y <= rect.max.y; ++y)
     {
-        for (size_t x = 0; x < tile_width; ++x)
+        for (size_t x = rect.min.x; x <= rect.max.x; ++x)
         {
-            const float* ptr = m_fb.pixel(origin_x + x, origin_y + y);
+            const float* ptr = m_fb.pixel(x, y);
 
             Color4f color(ptr[1], ptr[2], ptr[3], 1.0f);
             color.rgb() *= scale;
 
-            tile.set_pixel(x, y, color);
+            tile.set_pixel(x - origin_x, y - origin_y, color);
         }
     }
 }
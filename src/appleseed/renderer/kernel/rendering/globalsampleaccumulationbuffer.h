@@ -35,6 +35,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/image/filteredtile.h"
+#include "foundation/math/aabb.h"
 #include "foundation/math/filter.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/thread.h"
@@ -42,6 +43,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
@@ -56,11 +58,19 @@ class GlobalSampleAccumulationBuffer
   : public SampleAccumulationBuffer
 {
   public:
-    // Constructor.
+    // Constructor. If 'thread_buffer_count' is not 0, samples are accumulated into
+    // one of that many full-frame buffers, normally one per rendering thread, without
+    // taking the lock of the framebuffer. Thread buffers are merged into the framebuffer,
+    // by several threads, when the buffer is developed. Each thread buffer takes as much
+    // memory as the framebuffer.
     GlobalSampleAccumulationBuffer(
         const size_t                width,
         const size_t                height,
-        const foundation::Filter2f& filter);
+        const foundation::Filter2f& filter,
+        const size_t                thread_buffer_count = 0);
+
+    // Destructor.
+    ~GlobalSampleAccumulationBuffer();
 
     // Reset the buffer to its initial state. Thread-safe.
     virtual void clear() APPLESEED_OVERRIDE;
@@ -71,25 +81,86 @@ class GlobalSampleAccumulationBuffer
         const Sample                samples[],
         foundation::IAbortSwitch&   abort_switch) APPLESEED_OVERRIDE;
 
+    // Store a set of samples produced by a given rendering thread into the buffer. Thread-safe.
+    void store_samples(
+        const size_t                thread_index,
+        const size_t                sample_count,
+        const Sample                samples[],
+        foundation::IAbortSwitch&   abort_switch);
+
     // Develop the buffer to a frame. Thread-safe.
     virtual void develop_to_frame(
         Frame&                      frame,
         foundation::IAbortSwitch&   abort_switch) APPLESEED_OVERRIDE;
 
+    // Develop to a frame the tiles that may have changed since the last call. Thread-safe.
+    virtual void develop_dirty_tiles_to_frame(
+        Frame&                      frame,
+        std::vector<size_t>&        tiles,
+        foundation::IAbortSwitch&   abort_switch) APPLESEED_OVERRIDE;
+
     // Increment the number of samples used for pixel values renormalization. Thread-safe.
     void increment_sample_count(const foundation::uint64 delta_sample_count);
 
   private:
+    struct ThreadBuffer;
+
     boost::shared_mutex             m_mutex;
     foundation::FilteredTile        m_fb;
     const float                     m_filter_rcp_norm_factor;
+    std::vector<ThreadBuffer*>      m_thread_buffers;
+    const size_t                    m_bucket_count_x;
+    const size_t                    m_bucket_count_y;
+
+    // Since pixel values are renormalized by the total number of samples, all the pixels that
+    // ever received samples change whenever the sample count changes.
+    std::vector<foundation::uint8>  m_updated_buckets;          // one flag per bucket, set if the bucket received samples since the last refresh
+    std::vector<foundation::uint8>  m_touched_buckets;          // one flag per bucket, set if the bucket received samples before the last refresh
+    foundation::uint64              m_displayed_sample_count;   // sample count at the last call to develop_dirty_tiles_to_frame()
+    bool                            m_full_refresh;             // true if all tiles must be developed at the next refresh
+
+    // Flag the buckets overlapped by the footprint of a sample.
+    void flag_buckets(
+        const float                 fx,
+        const float                 fy,
+        std::vector<foundation::uint8>& flags) const;
+
+    // Add samples to the framebuffer. Return false if interrupted.
+    bool add_samples(
+        const size_t                sample_count,
+        const Sample                samples[],
+        foundation::IAbortSwitch&   abort_switch);
+
+    // Merge the samples of all thread buffers into the framebuffer, and clear them.
+    // The caller must have exclusive access to the framebuffer.
+    void merge_thread_buffers(foundation::IAbortSwitch& abort_switch);
+
+    // Merge the buckets of all thread buffers whose index is congruent to a given
+    // value modulo a given stride. The caller must have exclusive access to the framebuffer.
+    void merge_thread_buffer_buckets(
+        const size_t                first_bucket,
+        const size_t                bucket_stride,
+        foundation::IAbortSwitch*   abort_switch);
+
+    // Develop the tiles of the frame overlapping the crop window. If 'buckets' is not 0, only
+    // develop the tiles overlapping flagged buckets. If 'tiles' is not 0, append the indices
+    // of the developed tiles to it. The caller must have exclusive access to the framebuffer.
+    void develop_tiles(
+        Frame&                      frame,
+        const std::vector<foundation::uint8>* buckets,
+        std::vector<size_t>*        tiles,
+        foundation::IAbortSwitch&   abort_switch);
+
+    // Return true if a rectangle of the framebuffer overlaps any flagged bucket.
+    bool is_flagged(
+        const std::vector<foundation::uint8>& flags,
+        const foundation::AABB2u&   rect) const;
 
     void develop_to_tile(
         foundation::Tile&           tile,
         const size_t                origin_x,
         const size_t                origin_y,
-        const size_t                tile_x,
-        const size_t                tile_y,
+        const foundation::AABB2u&   rect,
         const float                 scale) const;
 };
 
@@ -33,6 +33,12 @@
 // appleseed.foundation headers.
 #include "foundation/core/concepts/iunknown.h"
 
+// Standard headers.
+#include <vector>
+
+// Forward declarations.
+namespace foundation    { class StatisticsVector; }
+
 namespace renderer
 {
 
@@ -54,6 +60,13 @@ class IFrameRenderer
     virtual void pause_rendering() = 0;
     virtual void resume_rendering() = 0;
     virtual void terminate_rendering() = 0;
+
+    // Return the statistics of the rendering threads, merged.
+    virtual foundation::StatisticsVector get_statistics() const = 0;
+
+    // Return the wall clock time each rendering thread spent executing jobs, in seconds.
+    // Unlike other methods, this one may be called from any thread while rendering.
+    virtual void get_thread_busy_times(std::vector<double>& busy_times) const = 0;
 };
 
 
@@ -0,0 +1,82 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_RENDERER_KERNEL_RENDERING_IFRAMESEQUENCE_H
+#define APPLESEED_RENDERER_KERNEL_RENDERING_IFRAMESEQUENCE_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace renderer  { class Project; }
+
+namespace renderer
+{
+
+//
+// Frame sequence interface.
+//
+// A frame sequence lets the master renderer render several frames in a row
+// while keeping the scene preparation of the first frame (scene trees, texture
+// store, shader groups). Between frames, the project may only be changed in
+// ways that don't require reinitializing rendering, such as moving the camera
+// or assembly instances, or changing entity parameters: scene entities inputs
+// are bound again and the trace context is updated (refitting the assembly
+// tree when only assembly instance transforms changed) before each frame.
+//
+
+class APPLESEED_DLLSYMBOL IFrameSequence
+  : public foundation::NonCopyable
+{
+  public:
+    // Destructor.
+    virtual ~IFrameSequence() {}
+
+    // Return the number of frames in the sequence.
+    virtual size_t get_frame_count() const = 0;
+
+    // This method is called before a frame is rendered, and may alter the project.
+    // Return false to abort rendering.
+    virtual bool on_frame_begin(
+        Project&        project,
+        const size_t    frame_index) = 0;
+
+    // This method is called after a frame is completely rendered.
+    virtual void on_frame_end(
+        const Project&  project,
+        const size_t    frame_index) = 0;
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_RENDERING_IFRAMESEQUENCE_H
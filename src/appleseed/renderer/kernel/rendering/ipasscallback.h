@@ -61,7 +61,8 @@ class APPLESEED_DLLSYMBOL IPassCallback
         foundation::IAbortSwitch&   abort_switch) = 0;
 
     // This method is called at the end of a pass.
-    virtual void post_render(
+    // Return true to stop rendering before the remaining passes.
+    virtual bool post_render(
         const Frame&                frame,
         foundation::JobQueue&       job_queue,
         foundation::IAbortSwitch&   abort_switch) = 0;
@@ -83,6 +83,12 @@ class IPixelRenderer
         SamplingContext::RNGType&   rng,
         ShadingResultFrameBuffer&   framebuffer) = 0;
 
+    // This method is called once all the pixels of a tile have been passed to render_pixel(),
+    // before the framebuffer is developed. Samples deferred by render_pixel() must be completed here.
+    virtual void flush_pixels(
+        const Frame&                frame,
+        ShadingResultFrameBuffer&   framebuffer) = 0;
+
     // Retrieve performance statistics.
     virtual foundation::StatisticsVector get_statistics() const = 0;
 };
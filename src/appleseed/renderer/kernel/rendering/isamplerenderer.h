@@ -48,6 +48,19 @@ namespace renderer      { class ShadingResult; }
 namespace renderer
 {
 
+//
+// A sample to render as part of a batch.
+//
+
+struct SampleRequest
+{
+    SamplingContext*                    m_sampling_context;
+    const PixelContext*                 m_pixel_context;
+    foundation::Vector2d                m_image_point;
+    ShadingResult*                      m_shading_result;
+};
+
+
 //
 // Sample renderer interface.
 //
@@ -64,6 +77,16 @@ class ISampleRenderer
         const foundation::Vector2d&     image_point,
         ShadingResult&                  shading_result) = 0;
 
+    // Render a batch of samples, possibly in a different order than the one of the requests.
+    // The default implementation renders the samples one by one with render_sample().
+    virtual void render_samples(
+        const SampleRequest             requests[],
+        const size_t                    count);
+
+    // Return the maximum number of samples worth passing at once to render_samples(),
+    // 1 if this sample renderer does not benefit from batches.
+    virtual size_t get_max_batch_size() const;
+
     // Retrieve performance statistics.
     virtual foundation::StatisticsVector get_statistics() const = 0;
 };
@@ -81,6 +104,30 @@ class ISampleRendererFactory
     virtual ISampleRenderer* create(const size_t thread_index) = 0;
 };
 
+
+//
+// ISampleRenderer class implementation.
+//
+
+inline void ISampleRenderer::render_samples(
+    const SampleRequest                 requests[],
+    const size_t                        count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        render_sample(
+            *requests[i].m_sampling_context,
+            *requests[i].m_pixel_context,
+            requests[i].m_image_point,
+            *requests[i].m_shading_result);
+    }
+}
+
+inline size_t ISampleRenderer::get_max_batch_size() const
+{
+    return 1;
+}
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_KERNEL_RENDERING_ISAMPLERENDERER_H
@@ -0,0 +1,69 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_RENDERER_KERNEL_RENDERING_ITILESOURCE_H
+#define APPLESEED_RENDERER_KERNEL_RENDERING_ITILESOURCE_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/iunknown.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace foundation    { class IAbortSwitch; }
+
+namespace renderer
+{
+
+//
+// Tile source interface.
+//
+// A tile source lets user code decide which tiles of the frame get rendered,
+// one tile at a time, instead of the generic frame renderer rendering all of
+// them. A typical usage is to render tiles handed out by a remote process.
+//
+
+class APPLESEED_DLLSYMBOL ITileSource
+  : public foundation::IUnknown
+{
+  public:
+    // Retrieve the coordinates of the next tile to render. This method is called
+    // repeatedly by a single thread while tiles are being rendered, and may block.
+    // Return false when there are no more tiles to render in the current pass.
+    virtual bool acquire_tile(
+        size_t&                     tile_x,
+        size_t&                     tile_y,
+        foundation::IAbortSwitch&   abort_switch) = 0;
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_RENDERING_ITILESOURCE_H
@@ -0,0 +1,85 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "liverenderstatistics.h"
+
+using namespace foundation;
+
+namespace renderer
+{
+
+//
+// LiveRenderCounters class implementation.
+//
+
+LiveRenderCounters::LiveRenderCounters()
+{
+    clear();
+}
+
+void LiveRenderCounters::clear()
+{
+    m_stage = "idle";
+    m_sample_count = 0;
+    m_shading_ray_count = 0;
+    m_probe_ray_count = 0;
+    m_texture_cache_hit_count = 0;
+    m_texture_cache_miss_count = 0;
+}
+
+void LiveRenderCounters::set_stage(const char* stage)
+{
+    m_stage = stage;
+}
+
+void LiveRenderCounters::add(
+    const uint64    sample_count,
+    const uint64    shading_ray_count,
+    const uint64    probe_ray_count,
+    const uint64    texture_cache_hit_count,
+    const uint64    texture_cache_miss_count)
+{
+    m_sample_count.fetch_add(sample_count, boost::memory_order_relaxed);
+    m_shading_ray_count.fetch_add(shading_ray_count, boost::memory_order_relaxed);
+    m_probe_ray_count.fetch_add(probe_ray_count, boost::memory_order_relaxed);
+    m_texture_cache_hit_count.fetch_add(texture_cache_hit_count, boost::memory_order_relaxed);
+    m_texture_cache_miss_count.fetch_add(texture_cache_miss_count, boost::memory_order_relaxed);
+}
+
+void LiveRenderCounters::read(LiveRenderStatistics& stats) const
+{
+    stats.m_stage = m_stage;
+    stats.m_sample_count = m_sample_count.load(boost::memory_order_relaxed);
+    stats.m_shading_ray_count = m_shading_ray_count.load(boost::memory_order_relaxed);
+    stats.m_probe_ray_count = m_probe_ray_count.load(boost::memory_order_relaxed);
+    stats.m_texture_cache_hit_count = m_texture_cache_hit_count.load(boost::memory_order_relaxed);
+    stats.m_texture_cache_miss_count = m_texture_cache_miss_count.load(boost::memory_order_relaxed);
+}
+
+}   // namespace renderer
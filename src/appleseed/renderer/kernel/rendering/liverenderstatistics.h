@@ -0,0 +1,105 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_RENDERER_KERNEL_RENDERING_LIVERENDERSTATISTICS_H
+#define APPLESEED_RENDERER_KERNEL_RENDERING_LIVERENDERSTATISTICS_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/atomic.h"
+#include "foundation/platform/types.h"
+
+// Standard headers.
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A snapshot of the progress of a render, taken while rendering.
+//
+// Counters are cumulative since the render started; rates such as rays per second
+// or thread utilization are obtained by comparing two successive snapshots.
+//
+
+struct LiveRenderStatistics
+{
+    const char*                         m_stage;                    // what the renderer is currently doing
+    double                              m_time;                     // wall clock time since the render started, in seconds
+    foundation::uint64                  m_sample_count;
+    foundation::uint64                  m_shading_ray_count;
+    foundation::uint64                  m_probe_ray_count;
+    foundation::uint64                  m_texture_cache_hit_count;
+    foundation::uint64                  m_texture_cache_miss_count;
+
+    // Time spent executing jobs by each rendering thread, in seconds.
+    // Restarts from zero when rendering is reinitialized.
+    std::vector<double>                 m_thread_busy_times;
+};
+
+
+//
+// Counters updated by the rendering threads, that can be read by any thread at any time.
+//
+
+class LiveRenderCounters
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    LiveRenderCounters();
+
+    // Reset all counters. The stage is set to "idle".
+    void clear();
+
+    // Set the current stage. 'stage' must remain valid, typically a string literal.
+    void set_stage(const char* stage);
+
+    // Add to the counters. Thread-safe.
+    void add(
+        const foundation::uint64        sample_count,
+        const foundation::uint64        shading_ray_count,
+        const foundation::uint64        probe_ray_count,
+        const foundation::uint64        texture_cache_hit_count,
+        const foundation::uint64        texture_cache_miss_count);
+
+    // Read the stage and the counters into 'stats'. Other fields are left untouched. Thread-safe.
+    void read(LiveRenderStatistics& stats) const;
+
+  private:
+    boost::atomic<const char*>          m_stage;
+    boost::atomic<foundation::uint64>   m_sample_count;
+    boost::atomic<foundation::uint64>   m_shading_ray_count;
+    boost::atomic<foundation::uint64>   m_probe_ray_count;
+    boost::atomic<foundation::uint64>   m_texture_cache_hit_count;
+    boost::atomic<foundation::uint64>   m_texture_cache_miss_count;
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_RENDERING_LIVERENDERSTATISTICS_H
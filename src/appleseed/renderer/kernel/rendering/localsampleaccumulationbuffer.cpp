@@ -80,10 +80,19 @@ namespace renderer
 
 //#define PRINT_DETAILED_PERF_REPORTS
 
+namespace
+{
+    // Size in pixels of the square buckets in which the buffer tracks the pixels modified since the last refresh.
+    const size_t BucketSize = 32;
+}
+
 LocalSampleAccumulationBuffer::LocalSampleAccumulationBuffer(
     const size_t        width,
     const size_t        height,
     const Filter2f&     filter)
+  : m_bucket_count_x((width + BucketSize - 1) / BucketSize)
+  , m_bucket_count_y((height + BucketSize - 1) / BucketSize)
+  , m_dirty_buckets(m_bucket_count_x * m_bucket_count_y, 0)
 {
     const size_t MinSize = 32;
 
@@ -140,6 +149,10 @@ void LocalSampleAccumulationBuffer::clear()
     }
 
     m_active_level = static_cast<uint32>(m_levels.size() - 1);
+
+    // Force a full refresh.
+    fill(m_dirty_buckets.begin(), m_dirty_buckets.end(), 0);
+    m_displayed_level = ~uint32(0);
 }
 
 void LocalSampleAccumulationBuffer::store_samples(
@@ -167,8 +180,9 @@ void LocalSampleAccumulationBuffer::store_samples(
 #endif
 
         // Store samples at every level, starting with the highest resolution level up to the active level.
+        const uint32 active_level = m_active_level;
         size_t counter = 0;
-        for (uint32 i = 0, e = m_active_level; i <= e; ++i)
+        for (uint32 i = 0, e = active_level; i <= e; ++i)
         {
             FilteredTile* level = m_levels[i];
             const float level_width = static_cast<float>(level->get_width());
@@ -189,6 +203,8 @@ void LocalSampleAccumulationBuffer::store_samples(
             }
         }
 
+        flag_dirty_buckets(*m_levels[active_level], sample_count, samples);
+
         m_lock.unlock_read();
     }
 
@@ -225,6 +241,39 @@ void LocalSampleAccumulationBuffer::store_samples(
     }
 }
 
+void LocalSampleAccumulationBuffer::flag_dirty_buckets(
+    const FilteredTile& level,
+    const size_t        sample_count,
+    const Sample        samples[])
+{
+    // The footprint of a sample is the largest at the coarsest level it was stored into.
+    const FilteredTile& base_level = *m_levels[0];
+    const float fw = static_cast<float>(base_level.get_width());
+    const float fh = static_cast<float>(base_level.get_height());
+    const float rx = (level.get_filter().get_xradius() + 1.0f) * fw / level.get_width();
+    const float ry = (level.get_filter().get_yradius() + 1.0f) * fh / level.get_height();
+    const size_t max_x = base_level.get_width() - 1;
+    const size_t max_y = base_level.get_height() - 1;
+
+    const Sample* sample_end = samples + sample_count;
+    for (const Sample* s = samples; s < sample_end; ++s)
+    {
+        const float fx = s->m_position.x * fw;
+        const float fy = s->m_position.y * fh;
+
+        const size_t bx0 = min(static_cast<size_t>(max(fx - rx, 0.0f)), max_x) / BucketSize;
+        const size_t by0 = min(static_cast<size_t>(max(fy - ry, 0.0f)), max_y) / BucketSize;
+        const size_t bx1 = min(static_cast<size_t>(max(fx + rx, 0.0f)), max_x) / BucketSize;
+        const size_t by1 = min(static_cast<size_t>(max(fy + ry, 0.0f)), max_y) / BucketSize;
+
+        for (size_t by = by0; by <= by1; ++by)
+        {
+            for (size_t bx = bx0; bx <= bx1; ++bx)
+                m_dirty_buckets[by * m_bucket_count_x + bx] = 1;
+        }
+    }
+}
+
 void LocalSampleAccumulationBuffer::develop_to_frame(
     Frame&              frame,
     IAbortSwitch&       abort_switch)
@@ -248,6 +297,49 @@ void LocalSampleAccumulationBuffer::develop_to_frame(
     RENDERER_LOG_DEBUG("develop_to_frame: acquiring lock: %f", t1 * 1000.0);
 #endif
 
+    develop_tiles(frame, false, 0, abort_switch);
+
+    m_lock.unlock_write();
+
+#ifdef PRINT_DETAILED_PERF_REPORTS
+    sw.measure();
+    const double t2 = sw.get_seconds();
+    RENDERER_LOG_DEBUG("develop_to_frame: %f", (t2 - t1) * 1000.0);
+#endif
+}
+
+void LocalSampleAccumulationBuffer::develop_dirty_tiles_to_frame(
+    Frame&              frame,
+    vector<size_t>&     tiles,
+    IAbortSwitch&       abort_switch)
+{
+    // Request exclusive access.
+    while (!m_lock.try_lock_write())
+    {
+        foundation::sleep(5);
+        if (abort_switch.is_aborted())
+            return;
+    }
+
+    // Switching to another level changes every pixel of the frame.
+    const uint32 active_level = m_active_level;
+    develop_tiles(frame, active_level == m_displayed_level, &tiles, abort_switch);
+
+    if (!abort_switch.is_aborted())
+    {
+        fill(m_dirty_buckets.begin(), m_dirty_buckets.end(), 0);
+        m_displayed_level = active_level;
+    }
+
+    m_lock.unlock_write();
+}
+
+void LocalSampleAccumulationBuffer::develop_tiles(
+    Frame&              frame,
+    const bool          dirty_tiles_only,
+    vector<size_t>*     tiles,
+    IAbortSwitch&       abort_switch)
+{
     Image& color_image = frame.image();
     Image& depth_image = frame.aov_images().get_image(0);
 
@@ -266,10 +358,7 @@ void LocalSampleAccumulationBuffer::develop_to_frame(
         for (size_t tx = 0; tx < frame_props.m_tile_count_x; ++tx)
         {
             if (abort_switch.is_aborted())
-            {
-                m_lock.unlock_write();
                 return;
-            }
 
             const size_t origin_x = tx * frame_props.m_tile_width;
             const size_t origin_y = ty * frame_props.m_tile_height;
@@ -283,6 +372,15 @@ void LocalSampleAccumulationBuffer::develop_to_frame(
 
             const AABB2u rect = AABB2u::intersect(tile_rect, crop_window);
 
+            if (tiles)
+            {
+                // Skip tiles entirely outside of the crop window or untouched since the last refresh.
+                if (!rect.is_valid() || (dirty_tiles_only && !is_dirty(tile_rect)))
+                    continue;
+
+                tiles->push_back(ty * frame_props.m_tile_count_x + tx);
+            }
+
             if (undo_premultiplied_alpha)
             {
                 develop_to_tile_undo_premult_alpha(
@@ -309,14 +407,25 @@ void LocalSampleAccumulationBuffer::develop_to_frame(
             }
         }
     }
+}
 
-    m_lock.unlock_write();
+bool LocalSampleAccumulationBuffer::is_dirty(const AABB2u& rect) const
+{
+    const size_t bx0 = rect.min.x / BucketSize;
+    const size_t by0 = rect.min.y / BucketSize;
+    const size_t bx1 = min(rect.max.x / BucketSize, m_bucket_count_x - 1);
+    const size_t by1 = min(rect.max.y / BucketSize, m_bucket_count_y - 1);
 
-#ifdef PRINT_DETAILED_PERF_REPORTS
-    sw.measure();
-    const double t2 = sw.get_seconds();
-    RENDERER_LOG_DEBUG("develop_to_frame: %f", (t2 - t1) * 1000.0);
-#endif
+    for (size_t by = by0; by <= by1; ++by)
+    {
+        for (size_t bx = bx0; bx <= bx1; ++bx)
+        {
+            if (m_dirty_buckets[by * m_bucket_count_x + bx])
+                return true;
+        }
+    }
+
+    return false;
 }
 
 void LocalSampleAccumulationBuffer::develop_to_tile_undo_premult_alpha(
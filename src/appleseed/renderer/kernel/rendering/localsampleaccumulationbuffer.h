@@ -82,6 +82,12 @@ class LocalSampleAccumulationBuffer
         Frame&                              frame,
         foundation::IAbortSwitch&           abort_switch) APPLESEED_OVERRIDE;
 
+    // Develop to a frame the tiles that may have changed since the last call. Thread-safe.
+    virtual void develop_dirty_tiles_to_frame(
+        Frame&                              frame,
+        std::vector<size_t>&                tiles,
+        foundation::IAbortSwitch&           abort_switch) APPLESEED_OVERRIDE;
+
     // Exposed for tests and benchmarks.
     static void develop_to_tile_undo_premult_alpha(
         foundation::Tile&                   color_tile,
@@ -104,13 +110,36 @@ class LocalSampleAccumulationBuffer
 
   private:
     typedef foundation::ReadWriteLock<
-        foundation::SleepWaitPolicy<5>
+        foundation::BackoffWaitPolicy
     > LockType;
 
     LockType                                m_lock;
     std::vector<foundation::FilteredTile*>  m_levels;
     boost::atomic<foundation::int32>*       m_remaining_pixels;
     boost::atomic<foundation::uint32>       m_active_level;
+
+    const size_t                            m_bucket_count_x;
+    const size_t                            m_bucket_count_y;
+    std::vector<foundation::uint8>          m_dirty_buckets;        // one flag per bucket of the base level, set if the bucket received samples since the last refresh
+    foundation::uint32                      m_displayed_level;      // active level at the last call to develop_dirty_tiles_to_frame()
+
+    // Flag the buckets overlapped by the footprints of samples stored up to a given level.
+    void flag_dirty_buckets(
+        const foundation::FilteredTile&     level,
+        const size_t                        sample_count,
+        const Sample                        samples[]);
+
+    // Develop the tiles of the frame. If 'tiles' is not 0, skip the tiles outside of the crop window
+    // (and those not overlapping dirty buckets if 'dirty_tiles_only' is true) and append the indices
+    // of the developed tiles to 'tiles'. The caller must hold the write lock.
+    void develop_tiles(
+        Frame&                              frame,
+        const bool                          dirty_tiles_only,
+        std::vector<size_t>*                tiles,
+        foundation::IAbortSwitch&           abort_switch);
+
+    // Return true if a rectangle of the base level overlaps any dirty bucket.
+    bool is_dirty(const foundation::AABB2u& rect) const;
 };
 
 }       // namespace renderer
@@ -0,0 +1,287 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Interface header.
+#include "lodselector.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
+#include "renderer/modeling/camera/camera.h"
+#include "renderer/modeling/object/curveobject.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/transformsequence.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/beziercurve.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/foreach.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    bool is_curve_object(const Object& object)
+    {
+        return strcmp(object.get_model(), CurveObjectFactory::get_model()) == 0;
+    }
+
+    // Compute the average distance between the end points of the segments of a curve object.
+    double compute_average_segment_length(const CurveObject& object)
+    {
+        const size_t curve1_count = object.get_curve1_count();
+        const size_t curve3_count = object.get_curve3_count();
+
+        if (curve1_count + curve3_count == 0)
+            return 0.0;
+
+        double total_length = 0.0;
+
+        for (size_t i = 0; i < curve1_count; ++i)
+        {
+            const Curve1Type& curve = object.get_curve1(i);
+            total_length += norm(Vector3d(curve.get_control_point(1) - curve.get_control_point(0)));
+        }
+
+        for (size_t i = 0; i < curve3_count; ++i)
+        {
+            const Curve3Type& curve = object.get_curve3(i);
+            total_length += norm(Vector3d(curve.get_control_point(3) - curve.get_control_point(0)));
+        }
+
+        return total_length / (curve1_count + curve3_count);
+    }
+}
+
+
+//
+// LODSelector class implementation.
+//
+
+LODSelector::LODSelector(
+    const Camera&           camera,
+    const size_t            frame_width,
+    const size_t            frame_height)
+  : m_camera(camera)
+  , m_camera_transform(camera.transform_sequence().get_earliest_transform())
+  , m_frame_width(static_cast<double>(frame_width))
+  , m_frame_height(static_cast<double>(frame_height))
+  , m_coarse_instance_count(0)
+  , m_changed_instance_count(0)
+  , m_lod_instance_count(0)
+  , m_curve_instance_count(0)
+  , m_simplified_curve_instance_count(0)
+{
+}
+
+void LODSelector::select(const Scene& scene)
+{
+    m_coverages.clear();
+    m_coarse_instance_count = 0;
+    m_changed_instance_count = 0;
+    m_lod_instance_count = 0;
+    m_curve_instance_count = 0;
+    m_simplified_curve_instance_count = 0;
+
+    collect_coverages(scene.assembly_instances(), Transformd::identity());
+
+    for (each<InstanceCoverageMap> i = m_coverages; i; ++i)
+    {
+        ObjectInstance& object_instance = *i->first;
+        const double pixel_coverage = i->second.m_pixel_coverage;
+        bool changed = false;
+
+        if (i->second.m_has_lods)
+        {
+            ++m_lod_instance_count;
+
+            const size_t level = object_instance.choose_lod(pixel_coverage);
+            changed = object_instance.select_lod(level);
+
+            if (object_instance.get_selected_lod() > 0)
+                ++m_coarse_instance_count;
+        }
+
+        // The selected level of detail may or may not be a curve object.
+        const Object& object = object_instance.get_object();
+        size_t curve_level = 0;
+
+        if (is_curve_object(object))
+        {
+            ++m_curve_instance_count;
+
+            // Express the length of the segments in pixels using the size of the object.
+            const GAABB3 local_bbox = object.compute_local_bbox();
+            if (pixel_coverage < numeric_limits<double>::max() && local_bbox.is_valid())
+            {
+                const double object_size = max_value(Vector3d(local_bbox.extent()));
+                const double segment_pixels =
+                    object_size > 0.0
+                        ? compute_average_segment_length(static_cast<const CurveObject&>(object)) / object_size * pixel_coverage
+                        : 0.0;
+                curve_level = object_instance.choose_curve_lod(segment_pixels);
+            }
+
+            if (curve_level > 0)
+                ++m_simplified_curve_instance_count;
+        }
+
+        if (object_instance.select_curve_lod(curve_level))
+            changed = true;
+
+        if (changed)
+        {
+            // The intersection trees of the assembly must be rebuilt.
+            i->second.m_assembly->bump_version_id();
+            ++m_changed_instance_count;
+        }
+    }
+}
+
+size_t LODSelector::get_instance_count() const
+{
+    return m_lod_instance_count;
+}
+
+size_t LODSelector::get_coarse_instance_count() const
+{
+    return m_coarse_instance_count;
+}
+
+size_t LODSelector::get_changed_instance_count() const
+{
+    return m_changed_instance_count;
+}
+
+size_t LODSelector::get_curve_instance_count() const
+{
+    return m_curve_instance_count;
+}
+
+size_t LODSelector::get_simplified_curve_instance_count() const
+{
+    return m_simplified_curve_instance_count;
+}
+
+double LODSelector::compute_pixel_coverage(const AABB3d& bbox) const
+{
+    AABB2d ndc_bbox;
+    ndc_bbox.invalidate();
+
+    for (size_t i = 0; i < 8; ++i)
+    {
+        Vector2d ndc;
+        if (!m_camera.project_camera_space_point(
+                m_camera_transform.point_to_local(bbox.compute_corner(i)),
+                ndc))
+            return numeric_limits<double>::max();
+
+        ndc_bbox.insert(ndc);
+    }
+
+    // Clip the projected bounding box to the frame.
+    for (size_t i = 0; i < 2; ++i)
+    {
+        ndc_bbox.min[i] = max(ndc_bbox.min[i], 0.0);
+        ndc_bbox.max[i] = min(ndc_bbox.max[i], 1.0);
+
+        if (ndc_bbox.min[i] >= ndc_bbox.max[i])
+            return 0.0;
+    }
+
+    const Vector2d extent = ndc_bbox.extent();
+
+    return max(extent[0] * m_frame_width, extent[1] * m_frame_height);
+}
+
+void LODSelector::collect_coverages(
+    const AssemblyInstanceContainer&    assembly_instances,
+    const Transformd&                   parent_transform)
+{
+    for (const_each<AssemblyInstanceContainer> i = assembly_instances; i; ++i)
+    {
+        Assembly* assembly = i->find_assembly();
+        if (assembly == 0)
+            continue;
+
+        const Transformd transform =
+            i->transform_sequence().get_earliest_transform() * parent_transform;
+
+        for (each<ObjectInstanceContainer> j = assembly->object_instances(); j; ++j)
+        {
+            ObjectInstance& object_instance = *j;
+
+            const Object* object = object_instance.find_object();
+            if (object == 0)
+                continue;
+
+            const bool has_lods = object_instance.get_lod_count() > 1;
+            if (!has_lods && !is_curve_object(*object))
+                continue;
+
+            const GAABB3 local_bbox = object->compute_local_bbox();
+            if (!local_bbox.is_valid())
+                continue;
+
+            const AABB3d bbox =
+                (object_instance.get_transform() * transform).to_parent(AABB3d(local_bbox));
+            const double pixel_coverage = compute_pixel_coverage(bbox);
+
+            const InstanceCoverageMap::iterator it = m_coverages.find(&object_instance);
+
+            if (it == m_coverages.end())
+            {
+                InstanceCoverage coverage;
+                coverage.m_assembly = assembly;
+                coverage.m_pixel_coverage = pixel_coverage;
+                coverage.m_has_lods = has_lods;
+                m_coverages[&object_instance] = coverage;
+            }
+            else it->second.m_pixel_coverage = max(it->second.m_pixel_coverage, pixel_coverage);
+        }
+
+        collect_coverages(assembly->assembly_instances(), transform);
+    }
+}
+
+}   // namespace renderer
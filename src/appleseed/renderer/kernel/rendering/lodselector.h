@@ -0,0 +1,131 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef APPLESEED_RENDERER_KERNEL_RENDERING_LODSELECTOR_H
+#define APPLESEED_RENDERER_KERNEL_RENDERING_LODSELECTOR_H
+
+// appleseed.renderer headers.
+#include "renderer/modeling/scene/containers.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/transform.h"
+
+// Standard headers.
+#include <cstddef>
+#include <map>
+
+// Forward declarations.
+namespace renderer      { class Assembly; }
+namespace renderer      { class Camera; }
+namespace renderer      { class ObjectInstance; }
+namespace renderer      { class Scene; }
+
+namespace renderer
+{
+
+//
+// Selects the level of detail of object instances from their screen coverage.
+//
+// The coverage of an object instance is the size, in pixels, of the projection of
+// its world space bounding box clipped to the frame. Instances seen through several
+// assembly instances use their largest coverage. Instances with a corner of their
+// bounding box behind the camera always use their full resolution object.
+//
+// Object instances must be bound to their objects. Since intersection trees are
+// built from the bound objects, only the selected levels of detail get a tree.
+//
+// Instances of curve objects also get a curve level of detail from the projected
+// length of the segments of their curves, which the curve trees use to merge
+// segments that span too few pixels.
+//
+
+class LODSelector
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. The camera must have been prepared with on_render_begin().
+    LODSelector(
+        const Camera&               camera,
+        const size_t                frame_width,        // in pixels
+        const size_t                frame_height);      // in pixels
+
+    // Select the level of detail of all object instances of a scene. The version ID
+    // of assemblies whose object instances changed level of detail is bumped.
+    void select(const Scene& scene);
+
+    // Return the number of object instances with levels of detail.
+    size_t get_instance_count() const;
+
+    // Return the number of object instances using a coarser level than their object.
+    size_t get_coarse_instance_count() const;
+
+    // Return the number of object instances whose level of detail changed.
+    size_t get_changed_instance_count() const;
+
+    // Return the number of instances of curve objects.
+    size_t get_curve_instance_count() const;
+
+    // Return the number of instances of curve objects whose segments are merged.
+    size_t get_simplified_curve_instance_count() const;
+
+    // Compute the coverage in pixels of a world space bounding box.
+    double compute_pixel_coverage(const foundation::AABB3d& bbox) const;
+
+  private:
+    struct InstanceCoverage
+    {
+        Assembly*                   m_assembly;
+        double                      m_pixel_coverage;
+        bool                        m_has_lods;
+    };
+
+    typedef std::map<ObjectInstance*, InstanceCoverage> InstanceCoverageMap;
+
+    const Camera&                   m_camera;
+    const foundation::Transformd    m_camera_transform;
+    const double                    m_frame_width;
+    const double                    m_frame_height;
+    InstanceCoverageMap             m_coverages;
+    size_t                          m_coarse_instance_count;
+    size_t                          m_changed_instance_count;
+    size_t                          m_lod_instance_count;
+    size_t                          m_curve_instance_count;
+    size_t                          m_simplified_curve_instance_count;
+
+    void collect_coverages(
+        const AssemblyInstanceContainer&    assembly_instances,
+        const foundation::Transformd&       parent_transform);
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_RENDERING_LODSELECTOR_H
@@ -32,29 +32,53 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
+#include "renderer/kernel/intersection/iintersectionbackend.h"
+#include "renderer/kernel/rendering/asynctilecallback.h"
+#include "renderer/kernel/rendering/framedenoiser.h"
 #include "renderer/kernel/rendering/iframerenderer.h"
+#include "renderer/kernel/rendering/iframesequence.h"
+#include "renderer/kernel/rendering/lodselector.h"
+#include "renderer/kernel/rendering/memorylimitpolicy.h"
 #include "renderer/kernel/rendering/renderercomponents.h"
 #include "renderer/kernel/rendering/serialrenderercontroller.h"
 #include "renderer/kernel/rendering/serialtilecallback.h"
+#include "renderer/kernel/texturing/texturememorybudget.h"
 #include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/camera/camera.h"
 #include "renderer/modeling/display/display.h"
 #include "renderer/modeling/entity/onframebeginrecorder.h"
 #include "renderer/modeling/frame/frame.h"
 #include "renderer/modeling/input/inputbinder.h"
 #include "renderer/modeling/project/project.h"
 #include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/settingsparsing.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/math/frustum.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/defaulttimers.h"
 #include "foundation/platform/thread.h"
+#include "foundation/utility/autoreleaseptr.h"
 #include "foundation/utility/job/iabortswitch.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobgraph.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
+#include "foundation/utility/memorytracker.h"
 #include "foundation/utility/otherwise.h"
+#include "foundation/utility/phaseprofile.h"
 #include "foundation/utility/statistics.h"
+#include "foundation/utility/string.h"
 
 // Standard headers.
 #include <cassert>
 #include <exception>
+#include <memory>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 using namespace std;
@@ -70,13 +94,21 @@ MasterRenderer::MasterRenderer(
     Project&                project,
     const ParamArray&       params,
     IRendererController*    renderer_controller,
-    ITileCallbackFactory*   tile_callback_factory)
+    ITileCallbackFactory*   tile_callback_factory,
+    ITileSource*            tile_source)
   : BaseRenderer(project, params)
   , m_renderer_controller(renderer_controller)
   , m_tile_callback_factory(tile_callback_factory)
+  , m_tile_source(tile_source)
+  , m_frame_sequence(0)
+  , m_frame_index(0)
+  , m_deferred_loading_pass_count(0)
   , m_serial_renderer_controller(0)
   , m_serial_tile_callback_factory(0)
   , m_display(0)
+  , m_render_start_time(0)
+  , m_frame_renderer(0)
+  , m_texture_store_scene(0)
 {
     if (m_tile_callback_factory == 0)
     {
@@ -95,11 +127,18 @@ MasterRenderer::MasterRenderer(
     IRendererController*    renderer_controller,
     ITileCallback*          tile_callback)
   : BaseRenderer(project, params)
+  , m_tile_source(0)
+  , m_frame_sequence(0)
+  , m_frame_index(0)
+  , m_deferred_loading_pass_count(0)
   , m_serial_renderer_controller(
         new SerialRendererController(renderer_controller, tile_callback))
   , m_serial_tile_callback_factory(
         new SerialTileCallbackFactory(m_serial_renderer_controller))
   , m_display(0)
+  , m_render_start_time(0)
+  , m_frame_renderer(0)
+  , m_texture_store_scene(0)
 {
     m_renderer_controller = m_serial_renderer_controller;
     m_tile_callback_factory = m_serial_tile_callback_factory;
@@ -114,6 +153,11 @@ MasterRenderer::~MasterRenderer()
     delete m_serial_renderer_controller;
 }
 
+void MasterRenderer::set_frame_sequence(IFrameSequence* frame_sequence)
+{
+    m_frame_sequence = frame_sequence;
+}
+
 bool MasterRenderer::render()
 {
     if (m_project.get_scene() == 0)
@@ -134,12 +178,18 @@ bool MasterRenderer::render()
         return false;
     }
 
+    m_frame_index = 0;
+
+    m_live_counters.clear();
+    m_render_start_time = DefaultWallclockTimer().read();
+
     try
     {
         return do_render();
     }
     catch (const bad_alloc&)
     {
+        m_live_counters.set_stage("idle");
         m_renderer_controller->on_rendering_abort();
         RENDERER_LOG_ERROR("rendering failed (ran out of memory).");
         return false;
@@ -147,12 +197,14 @@ bool MasterRenderer::render()
 #ifdef NDEBUG
     catch (const exception& e)
     {
+        m_live_counters.set_stage("idle");
         m_renderer_controller->on_rendering_abort();
         RENDERER_LOG_ERROR("rendering failed (%s).", e.what());
         return false;
     }
     catch (...)
     {
+        m_live_counters.set_stage("idle");
         m_renderer_controller->on_rendering_abort();
         RENDERER_LOG_ERROR("rendering failed (unknown exception).");
         return false;
@@ -160,8 +212,43 @@ bool MasterRenderer::render()
 #endif
 }
 
+IntersectionBackendRegistrar& MasterRenderer::get_intersection_backend_registrar()
+{
+    return m_intersection_backend_registrar;
+}
+
+const PhaseProfile& MasterRenderer::get_preparation_profile() const
+{
+    return m_preparation_profile;
+}
+
+const StatisticsVector& MasterRenderer::get_render_statistics() const
+{
+    return m_render_statistics;
+}
+
+void MasterRenderer::get_live_statistics(LiveRenderStatistics& stats) const
+{
+    m_live_counters.read(stats);
+
+    DefaultWallclockTimer timer;
+    stats.m_time =
+        m_render_start_time > 0
+            ? static_cast<double>(timer.read() - m_render_start_time) / timer.frequency()
+            : 0.0;
+
+    boost::mutex::scoped_lock lock(m_frame_renderer_mutex);
+
+    if (m_frame_renderer)
+        m_frame_renderer->get_thread_busy_times(stats.m_thread_busy_times);
+    else stats.m_thread_busy_times.clear();
+}
+
 bool MasterRenderer::do_render()
 {
+    m_deferred_loading_pass_count = 0;
+    m_render_statistics.clear();
+
     while (true)
     {
         m_renderer_controller->on_rendering_begin();
@@ -171,10 +258,12 @@ bool MasterRenderer::do_render()
         switch (status)
         {
           case IRendererController::TerminateRendering:
+            m_live_counters.set_stage("idle");
             m_renderer_controller->on_rendering_success();
             return true;
 
           case IRendererController::AbortRendering:
+            m_live_counters.set_stage("idle");
             m_renderer_controller->on_rendering_abort();
             return false;
 
@@ -210,6 +299,107 @@ namespace
       private:
         IRendererController& m_renderer_controller;
     };
+
+    // Make a frame renderer visible to MasterRenderer::get_live_statistics() for the duration of a scope.
+    class ScopedPublishedFrameRenderer
+      : public NonCopyable
+    {
+      public:
+        ScopedPublishedFrameRenderer(
+            boost::mutex&       mutex,
+            IFrameRenderer*&    published,
+            IFrameRenderer&     frame_renderer)
+          : m_mutex(mutex)
+          , m_published(published)
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_published = &frame_renderer;
+        }
+
+        ~ScopedPublishedFrameRenderer()
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_published = 0;
+        }
+
+      private:
+        boost::mutex&       m_mutex;
+        IFrameRenderer*&    m_published;
+    };
+
+    // Run a preparation step of the master renderer as a job of a job graph.
+    // Each job times its step in its own phase profile since jobs run concurrently.
+    class PreparationStepJob
+      : public IJob
+    {
+      public:
+        typedef bool (MasterRenderer::*Step)(TextureStore&, IAbortSwitch&);
+
+        PreparationStepJob(
+            MasterRenderer&     renderer,
+            const Step          step,
+            const char*         phase_name,
+            TextureStore&       texture_store,
+            IAbortSwitch&       abort_switch)
+          : m_renderer(renderer)
+          , m_step(step)
+          , m_phase_name(phase_name)
+          , m_texture_store(texture_store)
+          , m_abort_switch(abort_switch)
+          , m_success(false)
+        {
+        }
+
+        // Skip the step if a given job fails. The job graph must also execute that job first.
+        void add_prerequisite(const PreparationStepJob* job)
+        {
+            m_prerequisites.push_back(job);
+        }
+
+        virtual void execute(const size_t thread_index) APPLESEED_OVERRIDE
+        {
+            for (size_t i = 0, e = m_prerequisites.size(); i < e; ++i)
+            {
+                if (!m_prerequisites[i]->m_success)
+                    return;
+            }
+
+            ScopedPhase phase(m_profile, m_phase_name);
+            m_success = (m_renderer.*m_step)(m_texture_store, m_abort_switch);
+        }
+
+        bool succeeded() const
+        {
+            return m_success;
+        }
+
+        const PhaseProfile& get_profile() const
+        {
+            return m_profile;
+        }
+
+      private:
+        MasterRenderer&                         m_renderer;
+        const Step                              m_step;
+        const char*                             m_phase_name;
+        TextureStore&                           m_texture_store;
+        IAbortSwitch&                           m_abort_switch;
+        vector<const PreparationStepJob*>       m_prerequisites;
+        PhaseProfile                            m_profile;
+        bool                                    m_success;
+    };
+}
+
+bool MasterRenderer::prepare_scene()
+{
+    RendererControllerAbortSwitch abort_switch(*m_renderer_controller);
+
+    m_preparation_profile.clear();
+
+    const bool success = do_prepare_scene(abort_switch);
+    m_live_counters.set_stage("idle");
+
+    return success;
 }
 
 IRendererController::Status MasterRenderer::initialize_and_render_frame_sequence()
@@ -217,50 +407,165 @@ IRendererController::Status MasterRenderer::initialize_and_render_frame_sequence
     // Construct an abort switch based on the renderer controller.
     RendererControllerAbortSwitch abort_switch(*m_renderer_controller);
 
-    // We start by expanding all procedural assemblies.
-    if (!m_project.get_scene()->expand_procedural_assemblies(m_project, &abort_switch))
-        return IRendererController::AbortRendering;
+    // The loading of the project is reported along with the preparation of its first render.
+    m_preparation_profile.clear();
+    m_preparation_profile.append(m_project.get_load_profile());
+    m_project.get_load_profile().clear();
 
-    // Bind entities inputs. This must be done before creating/updating the trace context.
-    if (!bind_scene_entities_inputs())
+    // The root phase ends when the first frame starts rendering.
+    m_preparation_profile.begin_phase("render preparation");
+
+    if (!prepare_scene_entities(abort_switch))
         return IRendererController::AbortRendering;
 
-    m_project.create_aov_images();
-    m_project.update_trace_context();
     m_project.get_frame()->print_settings();
 
-    // Create the texture store.
-    TextureStore texture_store(
-        *m_project.get_scene(),
-        m_params.child("texture_store"));
+    // Degrade the rendering settings if the render would not fit within the memory limit.
+    apply_memory_limit();
 
-    if (!initialize_shading_system(texture_store, abort_switch))
-        return IRendererController::AbortRendering;
+    // Create the texture store, or reuse the one of the previous render of the same scene if requested.
+    m_preparation_profile.begin_phase("texture store creation");
+    const ParamArray& texture_store_params = m_params.child("texture_store");
+    auto_ptr<TextureStore> local_texture_store;
+    if (texture_store_params.get_optional<bool>("keep_between_renders", false))
+    {
+        if (m_texture_store.get() == 0 || m_texture_store_scene != m_project.get_scene())
+        {
+            m_texture_store.reset(new TextureStore(*m_project.get_scene(), texture_store_params));
+            m_texture_store_scene = m_project.get_scene();
+        }
+    }
+    else
+    {
+        m_texture_store.reset();
+        local_texture_store.reset(new TextureStore(*m_project.get_scene(), texture_store_params));
+    }
+    TextureStore& texture_store =
+        local_texture_store.get() ? *local_texture_store : *m_texture_store;
+    m_preparation_profile.end_phase();
+
+    // Build the acceleration structures while the shading system is being initialized:
+    // neither step depends on the other, and both must complete before the scene render begins.
+    {
+        JobQueue job_queue;
+        JobManager job_manager(global_logger(), job_queue, 2);
+        JobGraph job_graph(job_queue);
+
+        PreparationStepJob* trace_context_job =
+            new PreparationStepJob(
+                *this,
+                &MasterRenderer::build_acceleration_structures,
+                "trace context update",
+                texture_store,
+                abort_switch);
+
+        PreparationStepJob* shading_system_job =
+            new PreparationStepJob(
+                *this,
+                &MasterRenderer::initialize_shading_system,
+                "shading system initialization",
+                texture_store,
+                abort_switch);
+
+        PreparationStepJob* render_begin_job =
+            new PreparationStepJob(
+                *this,
+                &MasterRenderer::begin_scene_render,
+                "scene render begin",
+                texture_store,
+                abort_switch);
+
+        render_begin_job->add_prerequisite(trace_context_job);
+        render_begin_job->add_prerequisite(shading_system_job);
+
+        const size_t trace_context_index = job_graph.add_job(trace_context_job);
+        const size_t shading_system_index = job_graph.add_job(shading_system_job);
+        const size_t render_begin_index = job_graph.add_job(render_begin_job);
+        job_graph.add_dependency(trace_context_index, render_begin_index);
+        job_graph.add_dependency(shading_system_index, render_begin_index);
+
+        job_graph.schedule();
+        job_manager.start();
+        job_queue.wait_until_completion();
+
+        m_live_counters.set_stage("renderer preparation");
+
+        // The phases of the first two steps overlap in time.
+        m_preparation_profile.append(trace_context_job->get_profile());
+        m_preparation_profile.append(shading_system_job->get_profile());
+        m_preparation_profile.append(render_begin_job->get_profile());
+
+        if (!trace_context_job->succeeded() ||
+            !shading_system_job->succeeded() ||
+            !render_begin_job->succeeded())
+            return IRendererController::AbortRendering;
+    }
 
     // Don't proceed further if rendering was aborted.
     if (abort_switch.is_aborted())
         return m_renderer_controller->get_status();
 
-    // Perform pre-render rendering actions. Don't proceed if that failed.
-    if (!m_project.get_scene()->on_render_begin(m_project, &abort_switch))
-        return IRendererController::AbortRendering;
+    // Optionally deliver tile callbacks on a dedicated thread so that slow callbacks don't stall rendering.
+    auto_ptr<AsyncTileCallbackFactory> async_tile_callback_factory;
+    if (m_tile_callback_factory && m_params.get_optional<bool>("async_tile_callbacks", false))
+    {
+        async_tile_callback_factory.reset(
+            new AsyncTileCallbackFactory(
+                m_tile_callback_factory,
+                m_params.get_optional<size_t>("tile_callback_queue_capacity", 1024),
+                m_params.get_optional<bool>("coalesce_tile_callbacks", false)));
+    }
 
-    // Create the renderer components.
+    // Create the renderer components. This builds the light sampler unless it can be reused.
+    m_preparation_profile.begin_phase("renderer components creation");
     RendererComponents components(
         m_project,
         m_params,
-        m_tile_callback_factory,
+        async_tile_callback_factory.get()
+            ? async_tile_callback_factory.get()
+            : m_tile_callback_factory,
+        m_tile_source,
         texture_store,
         *m_texture_system,
-        *m_shading_system);
-    if (!components.initialize())
-        return IRendererController::AbortRendering;
+        *m_shading_system,
+        m_light_sampler_cache,
+        &m_live_counters);
+    m_preparation_profile.end_phase();
+
+    {
+        ScopedPhase phase(m_preparation_profile, "renderer components initialization");
+        if (!components.initialize())
+            return IRendererController::AbortRendering;
+    }
 
     // Execute the main rendering loop.
-    const IRendererController::Status status =
-        render_frame_sequence(
-            components.get_frame_renderer(),
-            abort_switch);
+    IRendererController::Status status;
+    {
+        ScopedPublishedFrameRenderer published_frame_renderer(
+            m_frame_renderer_mutex,
+            m_frame_renderer,
+            components.get_frame_renderer());
+
+        status =
+            render_frame_sequence(
+                components.get_frame_renderer(),
+                texture_store,
+                abort_switch);
+    }
+
+    // Deliver the last tile callbacks before reporting the end of the render.
+    if (async_tile_callback_factory.get())
+    {
+        async_tile_callback_factory->flush();
+
+        RENDERER_LOG_DEBUG(
+            "delivered %s tile callback(s) asynchronously, coalesced %s.",
+            pretty_uint(async_tile_callback_factory->get_delivered_event_count()).c_str(),
+            pretty_uint(async_tile_callback_factory->get_coalesced_event_count()).c_str());
+    }
+
+    // Accumulate the statistics of the rendering threads over reinitializations.
+    m_render_statistics.merge(components.get_frame_renderer().get_statistics());
 
     // Perform post-render rendering actions.
     m_project.get_scene()->on_render_end(m_project);
@@ -268,25 +573,158 @@ IRendererController::Status MasterRenderer::initialize_and_render_frame_sequence
     // Print texture store performance statistics.
     RENDERER_LOG_DEBUG("%s", texture_store.get_statistics().to_string().c_str());
 
+    // Print the combined statistics of the texture store and of the oiio texture cache.
+    RENDERER_LOG_INFO("%s", get_texture_memory_statistics().to_string().c_str());
+
+    // Print the breakdown of the memory used by the renderer.
+    RENDERER_LOG_INFO("%s",
+        StatisticsVector::make(
+            "memory statistics",
+            global_memory_tracker().get_statistics()).to_string().c_str());
+
     return status;
 }
 
+void MasterRenderer::apply_memory_limit()
+{
+    const MemoryLimitPolicy policy(m_params);
+    if (policy.get_limit() == 0)
+        return;
+
+    policy.apply(
+        MemoryLimitPolicy::get_current_usage(),
+        m_params,
+        m_project.get_scene()->get_parameters().push("acceleration_structure"));
+
+    // The texture memory budget was read from the parameters when the renderer was created.
+    set_texture_memory_size(
+        TextureMemoryBudget(m_params.child("texture_store")).get_total_size());
+}
+
+bool MasterRenderer::do_prepare_scene(IAbortSwitch& abort_switch)
+{
+    if (!prepare_scene_entities(abort_switch))
+        return false;
+
+    {
+        ScopedPhase phase(m_preparation_profile, "trace context update");
+        m_live_counters.set_stage("acceleration structures building");
+        m_project.update_trace_context();
+        m_live_counters.set_stage("renderer preparation");
+    }
+
+    return true;
+}
+
+bool MasterRenderer::prepare_scene_entities(IAbortSwitch& abort_switch)
+{
+    m_live_counters.set_stage("scene preparation");
+
+    // We start by expanding all procedural assemblies.
+    {
+        ScopedPhase phase(m_preparation_profile, "procedural assemblies expansion");
+        if (!m_project.get_scene()->expand_procedural_assemblies(m_project, &abort_switch))
+            return false;
+    }
+
+    // Bind entities inputs. This must be done before creating/updating the trace context.
+    {
+        ScopedPhase phase(m_preparation_profile, "scene entities inputs binding");
+        if (!bind_scene_entities_inputs())
+            return false;
+    }
+
+    // Select the intersection backend. This must be done before updating the trace context.
+    {
+        ScopedPhase phase(m_preparation_profile, "intersection backend selection");
+        if (!select_intersection_backend())
+            return false;
+    }
+
+    // Select levels of detail. This must be done after binding entities inputs and before updating the trace context.
+    {
+        ScopedPhase phase(m_preparation_profile, "levels of detail selection");
+        if (!select_levels_of_detail(abort_switch))
+            return false;
+    }
+
+    m_project.create_aov_images();
+
+    return true;
+}
+
+bool MasterRenderer::build_acceleration_structures(
+    TextureStore&           texture_store,
+    IAbortSwitch&           abort_switch)
+{
+    m_live_counters.set_stage("acceleration structures building");
+    m_project.update_trace_context();
+
+    return true;
+}
+
+bool MasterRenderer::begin_scene_render(
+    TextureStore&           texture_store,
+    IAbortSwitch&           abort_switch)
+{
+    // Skip the pre-render actions if rendering was aborted in the meantime.
+    if (abort_switch.is_aborted())
+        return true;
+
+    // Perform pre-render rendering actions.
+    return m_project.get_scene()->on_render_begin(m_project, &abort_switch);
+}
+
 IRendererController::Status MasterRenderer::render_frame_sequence(
     IFrameRenderer&         frame_renderer,
+    TextureStore&           texture_store,
     IAbortSwitch&           abort_switch)
 {
+    bool first_frame = true;
+
     while (true)
     {
         assert(!frame_renderer.is_rendering());
 
+        // Only the preparation of the first frame is profiled.
+        if (first_frame)
+            m_preparation_profile.begin_phase("frame preparation");
+
         // The on_frame_begin() method of the renderer controller might alter the scene
         // (e.g. transform the camera), thus it needs to be called before the on_frame_begin()
         // of the scene which assumes the scene is up-to-date and ready to be rendered.
         m_renderer_controller->on_frame_begin();
 
+        // Let the frame sequence prepare the scene for the next frame.
+        if (m_frame_sequence)
+        {
+            if (!m_frame_sequence->on_frame_begin(m_project, m_frame_index))
+            {
+                m_renderer_controller->on_frame_end();
+                return IRendererController::AbortRendering;
+            }
+
+            // Pick up the changes of entity parameters and instance transforms, keeping
+            // the acceleration structures of unchanged assemblies.
+            if (!bind_scene_entities_inputs())
+            {
+                m_renderer_controller->on_frame_end();
+                return IRendererController::AbortRendering;
+            }
+
+            m_live_counters.set_stage("acceleration structures building");
+            m_project.update_trace_context();
+        }
+
         // Perform pre-frame rendering actions. Don't proceed if that failed.
         OnFrameBeginRecorder recorder;
-        if (!m_project.get_scene()->on_frame_begin(m_project, 0, recorder, &abort_switch))
+        if (first_frame)
+            m_preparation_profile.begin_phase("scene frame begin");
+        const bool frame_begin_success =
+            m_project.get_scene()->on_frame_begin(m_project, 0, recorder, &abort_switch);
+        if (first_frame)
+            m_preparation_profile.end_phase();
+        if (!frame_begin_success)
         {
             recorder.on_frame_end(m_project);
             m_renderer_controller->on_frame_end();
@@ -301,9 +739,54 @@ IRendererController::Status MasterRenderer::render_frame_sequence(
             return m_renderer_controller->get_status();
         }
 
+        // Let camera rays skip the assembly instances outside of the view frustum of the camera.
+        // This must be done after the camera was prepared for this frame.
+        const Camera* camera = m_project.get_scene()->get_active_camera();
+        Frustum<double, 4> camera_frustum;
+        m_project.set_camera_frustum(
+            camera && camera->get_view_frustum(camera_frustum) ? &camera_frustum : 0);
+
+        // Report the preparation profile once the first frame is about to be rendered.
+        if (first_frame)
+        {
+            m_preparation_profile.end_phase();      // frame preparation
+            m_preparation_profile.end_phase();      // render preparation
+            RENDERER_LOG_INFO(
+                "startup profile:\n%s",
+                m_preparation_profile.to_string().c_str());
+            first_frame = false;
+        }
+
+        m_live_counters.set_stage("rendering");
         frame_renderer.start_rendering();
 
-        const IRendererController::Status status = wait_for_event(frame_renderer);
+        IRendererController::Status status = wait_for_event(frame_renderer);
+
+        // The frame was completely rendered unless rendering was stopped by the renderer controller.
+        bool frame_completed =
+            !frame_renderer.is_rendering() &&
+            m_renderer_controller->get_status() == IRendererController::ContinueRendering;
+
+        // Render the frame again if rays entered deferred archive assemblies that are not loaded yet.
+        if (status == IRendererController::TerminateRendering &&
+            frame_completed &&
+            m_project.get_scene()->has_pending_archive_expansions())
+        {
+            const size_t max_pass_count = m_params.get_optional<size_t>("max_deferred_loading_passes", 16);
+
+            if (++m_deferred_loading_pass_count <= max_pass_count)
+            {
+                RENDERER_LOG_INFO("rays entered deferred archive assemblies, rendering the frame again...");
+                status = IRendererController::ReinitializeRendering;
+                frame_completed = false;
+            }
+            else
+            {
+                RENDERER_LOG_WARNING(
+                    "rays entered deferred archive assemblies but the maximum number of loading passes (" FMT_SIZE_T ") was reached.",
+                    max_pass_count);
+            }
+        }
 
         switch (status)
         {
@@ -322,10 +805,38 @@ IRendererController::Status MasterRenderer::render_frame_sequence(
 
         assert(!frame_renderer.is_rendering());
 
+        // Denoise the frame once it is rendered, before it gets written out.
+        Frame& frame = *m_project.get_frame();
+        if (status == IRendererController::TerminateRendering && frame.is_denoising_enabled())
+        {
+            m_live_counters.set_stage("denoising");
+            const FrameDenoiser denoiser(
+                frame.get_parameters().get_optional<size_t>("denoise_radius", 4),
+                get_rendering_thread_count(m_params));
+            denoiser.denoise(frame, &abort_switch);
+        }
+
+        // Stop culling since the camera may move before the next frame.
+        m_project.set_camera_frustum(0);
+
+        // Divide the texture memory budget again according to the texture lookups of this frame.
+        update_texture_memory_budget(texture_store);
+
         // Perform post-frame rendering actions
         recorder.on_frame_end(m_project);
         m_renderer_controller->on_frame_end();
 
+        // Move on to the next frame of the sequence, keeping the scene preparation.
+        if (m_frame_sequence && frame_completed)
+        {
+            m_frame_sequence->on_frame_end(m_project, m_frame_index);
+
+            m_deferred_loading_pass_count = 0;
+
+            if (++m_frame_index < m_frame_sequence->get_frame_count())
+                continue;
+        }
+
         switch (status)
         {
           case IRendererController::TerminateRendering:
@@ -387,4 +898,70 @@ bool MasterRenderer::bind_scene_entities_inputs() const
     return input_binder.get_error_count() == 0;
 }
 
+bool MasterRenderer::select_levels_of_detail(IAbortSwitch& abort_switch)
+{
+    Camera* camera = m_project.get_uncached_active_camera();
+    if (camera == 0)
+        return true;
+
+    // Projecting points requires the camera settings derived from its parameters.
+    if (!camera->on_render_begin(m_project, &abort_switch))
+        return false;
+
+    const CanvasProperties& props = m_project.get_frame()->image().properties();
+
+    LODSelector selector(*camera, props.m_canvas_width, props.m_canvas_height);
+    selector.select(*m_project.get_scene());
+
+    if (selector.get_instance_count() > 0)
+    {
+        RENDERER_LOG_INFO(
+            "%s object instance%s with levels of detail, %s using a coarser level, %s changed since the last render.",
+            pretty_uint(selector.get_instance_count()).c_str(),
+            selector.get_instance_count() > 1 ? "s" : "",
+            pretty_uint(selector.get_coarse_instance_count()).c_str(),
+            pretty_uint(selector.get_changed_instance_count()).c_str());
+    }
+
+    if (selector.get_curve_instance_count() > 0)
+    {
+        RENDERER_LOG_INFO(
+            "%s curve object instance%s, %s with merged curve segments.",
+            pretty_uint(selector.get_curve_instance_count()).c_str(),
+            selector.get_curve_instance_count() > 1 ? "s" : "",
+            pretty_uint(selector.get_simplified_curve_instance_count()).c_str());
+    }
+
+    return true;
+}
+
+bool MasterRenderer::select_intersection_backend()
+{
+    const string name = m_params.get_optional<string>("intersection_backend", "builtin");
+
+    if (name == "builtin")
+    {
+        m_project.set_intersection_backend(auto_release_ptr<IIntersectionBackend>());
+        return true;
+    }
+
+    const IIntersectionBackendFactory* factory =
+        m_intersection_backend_registrar.lookup(name.c_str());
+
+    if (factory == 0)
+    {
+        RENDERER_LOG_ERROR(
+            "invalid value for \"intersection_backend\" parameter: \"%s\".",
+            name.c_str());
+        return false;
+    }
+
+    RENDERER_LOG_INFO("using intersection backend \"%s\".", name.c_str());
+
+    m_project.set_intersection_backend(
+        factory->create(*m_project.get_scene(), m_params.child(name.c_str())));
+
+    return true;
+}
+
 }   // namespace renderer
@@ -31,21 +31,38 @@
 #define APPLESEED_RENDERER_KERNEL_RENDERING_MASTERRENDERER_H
 
 // appleseed.renderer headers.
+#include "renderer/kernel/intersection/intersectionbackendregistrar.h"
+#include "renderer/kernel/lighting/lightsampler.h"
 #include "renderer/kernel/rendering/baserenderer.h"
 #include "renderer/kernel/rendering/irenderercontroller.h"
+#include "renderer/kernel/rendering/liverenderstatistics.h"
 #include "renderer/utility/paramarray.h"
 
+// appleseed.foundation headers.
+#include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/phaseprofile.h"
+#include "foundation/utility/statistics.h"
+
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+#include <memory>
+
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
 namespace renderer      { class Display; }
 namespace renderer      { class IFrameRenderer; }
+namespace renderer      { class IFrameSequence; }
 namespace renderer      { class ITileCallback; }
 namespace renderer      { class ITileCallbackFactory; }
+namespace renderer      { class ITileSource; }
 namespace renderer      { class Project; }
+namespace renderer      { class Scene; }
 namespace renderer      { class SerialRendererController; }
+namespace renderer      { class TextureStore; }
 
 namespace renderer
 {
@@ -58,12 +75,14 @@ class APPLESEED_DLLSYMBOL MasterRenderer
   : public BaseRenderer
 {
   public:
-    // Constructor.
+    // Constructor. If 'tile_source' is not null, only the tiles it hands out
+    // are rendered; this requires the generic frame renderer.
     MasterRenderer(
         Project&                    project,
         const ParamArray&           params,
         IRendererController*        renderer_controller,
-        ITileCallbackFactory*       tile_callback_factory = 0);
+        ITileCallbackFactory*       tile_callback_factory = 0,
+        ITileSource*                tile_source = 0);
 
     // Constructor for serial tile callbacks.
     MasterRenderer(
@@ -75,12 +94,40 @@ class APPLESEED_DLLSYMBOL MasterRenderer
     // Destructor.
     ~MasterRenderer();
 
+    // Render the frames of a sequence instead of a single frame. 'frame_sequence' may be 0.
+    void set_frame_sequence(IFrameSequence* frame_sequence);
+
     // Render the project. Return true on success, false otherwise.
     bool render();
 
+    // Prepare the scene and build its acceleration structures without rendering.
+    // The next call to render() reuses them as long as the scene doesn't change.
+    // Return true on success, false otherwise.
+    bool prepare_scene();
+
+    // Access the intersection backends that can be selected with the
+    // "intersection_backend" parameter, in addition to "builtin".
+    IntersectionBackendRegistrar& get_intersection_backend_registrar();
+
+    // Return the wall time and peak memory of the steps that preceded the first
+    // rendered pixel during the last call to render().
+    const foundation::PhaseProfile& get_preparation_profile() const;
+
+    // Return the statistics of the rendering threads (rays, samples, texture cache, etc.)
+    // accumulated over the last call to render().
+    const foundation::StatisticsVector& get_render_statistics() const;
+
+    // Take a snapshot of the progress of the render. Thread-safe: this can be called
+    // at any time while render() is running without interrupting rendering.
+    void get_live_statistics(LiveRenderStatistics& stats) const;
+
   private:
     IRendererController*            m_renderer_controller;
     ITileCallbackFactory*           m_tile_callback_factory;
+    ITileSource*                    m_tile_source;
+    IFrameSequence*                 m_frame_sequence;
+    size_t                          m_frame_index;      // index of the frame being rendered in the sequence
+    size_t                          m_deferred_loading_pass_count;
 
     // Storage for serial tile callbacks.
     SerialRendererController*       m_serial_renderer_controller;
@@ -88,15 +135,58 @@ class APPLESEED_DLLSYMBOL MasterRenderer
 
     Display*                        m_display;
 
+    IntersectionBackendRegistrar    m_intersection_backend_registrar;
+
+    // The light sampler is kept between rendering sessions and only rebuilt when lights change.
+    LightSamplerCache               m_light_sampler_cache;
+
+    // Wall time and peak memory of the steps preceding the first rendered pixel.
+    foundation::PhaseProfile        m_preparation_profile;
+
+    // Statistics of the rendering threads over the last call to render().
+    foundation::StatisticsVector    m_render_statistics;
+
+    // Counters and frame renderer polled by get_live_statistics().
+    LiveRenderCounters              m_live_counters;
+    foundation::uint64              m_render_start_time;
+    mutable boost::mutex            m_frame_renderer_mutex;
+    IFrameRenderer*                 m_frame_renderer;
+
+    // Texture store kept between renders of the same scene when texture_store.keep_between_renders is set.
+    std::auto_ptr<TextureStore>     m_texture_store;
+    const Scene*                    m_texture_store_scene;
+
     // Render frame sequences, each time reinitializing the rendering components.
     bool do_render();
 
     // Initialize the rendering components and render a frame sequence.
     IRendererController::Status initialize_and_render_frame_sequence();
 
-    // Render a frame sequence until the sequence is completed or rendering is aborted.
+    // Prepare the scene and build its acceleration structures. Return true on success, false otherwise.
+    bool do_prepare_scene(foundation::IAbortSwitch& abort_switch);
+
+    // Prepare the scene up to, but excluding, the building of its acceleration structures.
+    // Return true on success, false otherwise.
+    bool prepare_scene_entities(foundation::IAbortSwitch& abort_switch);
+
+    // Degrade the rendering parameters if the render would exceed the memory limit.
+    // Degradations remain in effect for the following renders.
+    void apply_memory_limit();
+
+    // Preparation steps run as jobs of a job graph by initialize_and_render_frame_sequence().
+    // They share the signature of BaseRenderer::initialize_shading_system() which is also
+    // run as such a job. Return true on success, false otherwise.
+    bool build_acceleration_structures(
+        TextureStore&               texture_store,
+        foundation::IAbortSwitch&   abort_switch);
+    bool begin_scene_render(
+        TextureStore&               texture_store,
+        foundation::IAbortSwitch&   abort_switch);
+
+    // Render frames until the sequence is completed or rendering is aborted.
     IRendererController::Status render_frame_sequence(
         IFrameRenderer&             frame_renderer,
+        TextureStore&               texture_store,
         foundation::IAbortSwitch&   abort_switch);
 
     // Wait until the the frame is completed or rendering is aborted.
@@ -104,6 +194,12 @@ class APPLESEED_DLLSYMBOL MasterRenderer
 
     // Bind all scene entities inputs. Return true on success, false otherwise.
     bool bind_scene_entities_inputs() const;
+
+    // Select the level of detail of object instances. Return true on success, false otherwise.
+    bool select_levels_of_detail(foundation::IAbortSwitch& abort_switch);
+
+    // Select the intersection backend of the project. Return true on success, false otherwise.
+    bool select_intersection_backend();
 };
 
 }       // namespace renderer
@@ -0,0 +1,301 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "memorylimitpolicy.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/kernel/aov/imagestack.h"
+#include "renderer/kernel/lighting/sppm/sppmphoton.h"
+#include "renderer/kernel/texturing/texturememorybudget.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/memorytracker.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <algorithm>
+#include <string>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    // Fraction of the limit available to the memory accounted for by the memory tracker.
+    const double AccountedFraction = 0.9;
+
+    // Quantized nodes and indexed leaves about halve the size of acceleration structures.
+    const double CompactTreeRatio = 0.5;
+
+    // The texture caches never shrink below this size.
+    const uint64 MinTextureCacheSize = 16 * 1024 * 1024;
+
+    // Each photon emitted by SPPM is stored about twice on average.
+    const uint64 StoredPhotonsPerEmittedPhoton = 2;
+
+    // Photon counts never drop below this fraction of their configured value.
+    const double MinPhotonCountFraction = 0.1;
+
+    uint64 get_texture_cache_size(const ParamArray& params)
+    {
+        const TextureMemoryBudget budget(params.child("texture_store"));
+        return
+            static_cast<uint64>(budget.get_texture_store_size()) +
+            static_cast<uint64>(budget.get_oiio_size());
+    }
+
+    bool is_sppm_render(const ParamArray& params)
+    {
+        return params.get_optional<string>("lighting_engine", "pt") == "sppm";
+    }
+
+    size_t get_emitted_photon_count(const ParamArray& sppm_params)
+    {
+        return
+            sppm_params.get_optional<size_t>("light_photons_per_pass", 1000000) +
+            sppm_params.get_optional<size_t>("env_photons_per_pass", 1000000);
+    }
+
+    uint64 get_photon_map_size(const ParamArray& params)
+    {
+        if (!is_sppm_render(params))
+            return 0;
+
+        const ParamArray& sppm_params = params.child("sppm");
+        const bool mono = sppm_params.get_optional<string>("photon_type", "poly") == "mono";
+        const bool compact = sppm_params.get_optional<string>("photon_format", "full") == "compact";
+
+        const size_t photon_size =
+            compact
+                ? (mono ? sizeof(SPPMCompactMonoPhoton) : sizeof(SPPMCompactPolyPhoton))
+                : (mono ? sizeof(SPPMMonoPhoton) : sizeof(SPPMPolyPhoton));
+
+        // Positions are stored along with the photons, then again in the photon map.
+        const uint64 stored_photon_size = photon_size + 2 * sizeof(Vector3f);
+
+        return
+            get_emitted_photon_count(sppm_params) *
+            StoredPhotonsPerEmittedPhoton *
+            stored_photon_size;
+    }
+
+    uint64 subtract(const uint64 lhs, const uint64 rhs)
+    {
+        return lhs > rhs ? lhs - rhs : 0;
+    }
+}
+
+
+//
+// MemoryLimitPolicy class implementation.
+//
+
+MemoryLimitPolicy::Usage::Usage()
+  : m_current(0)
+  , m_trees(0)
+{
+}
+
+MemoryLimitPolicy::MemoryLimitPolicy(const ParamArray& params)
+  : m_limit(params.get_optional<uint64>("memory_limit", 0))
+{
+}
+
+uint64 MemoryLimitPolicy::get_limit() const
+{
+    return m_limit;
+}
+
+MemoryLimitPolicy::Usage MemoryLimitPolicy::get_current_usage()
+{
+    const MemoryTracker& tracker = global_memory_tracker();
+
+    const uint64 tessellation_size = tracker.get_size(MemoryTracker::Tessellations);
+    const uint64 tree_size = tracker.get_size(MemoryTracker::Trees);
+
+    Usage usage;
+    usage.m_current =
+        subtract(
+            tracker.get_total_size(),
+            tracker.get_size(MemoryTracker::Textures) + tracker.get_size(MemoryTracker::PhotonMaps));
+    usage.m_trees = subtract(tessellation_size, tree_size);
+
+    return usage;
+}
+
+uint64 MemoryLimitPolicy::get_frame_size(const Frame& frame)
+{
+    const CanvasProperties& props = frame.image().properties();
+    uint64 size = static_cast<uint64>(props.m_pixel_count) * props.m_pixel_size;
+
+    const ImageStack& aov_images = frame.aov_images();
+    for (size_t i = 0, e = aov_images.size(); i < e; ++i)
+    {
+        const CanvasProperties& aov_props = aov_images.get_image(i).properties();
+        size += static_cast<uint64>(aov_props.m_pixel_count) * aov_props.m_pixel_size;
+    }
+
+    return size;
+}
+
+bool MemoryLimitPolicy::should_stream_output(
+    const Usage&                usage,
+    const ParamArray&           params,
+    const uint64                frame_size) const
+{
+    if (m_limit == 0)
+        return false;
+
+    const uint64 budget = static_cast<uint64>(m_limit * AccountedFraction);
+    const uint64 projected_size =
+        usage.m_current +
+        usage.m_trees +
+        get_texture_cache_size(params) +
+        get_photon_map_size(params) +
+        frame_size;
+
+    return projected_size > budget;
+}
+
+size_t MemoryLimitPolicy::apply(
+    const Usage&                usage,
+    ParamArray&                 params,
+    ParamArray&                 scene_tree_params) const
+{
+    if (m_limit == 0)
+        return 0;
+
+    const uint64 budget = static_cast<uint64>(m_limit * AccountedFraction);
+
+    uint64 tree_size = usage.m_trees;
+    uint64 texture_cache_size = get_texture_cache_size(params);
+    uint64 photon_map_size = get_photon_map_size(params);
+    size_t degradation_count = 0;
+
+    // Use compact acceleration structures.
+    if (usage.m_current + tree_size + texture_cache_size + photon_map_size > budget &&
+        tree_size > 0 &&
+        !(scene_tree_params.strings().exist("node_type") && scene_tree_params.strings().exist("leaf_encoding")))
+    {
+        if (!scene_tree_params.strings().exist("node_type"))
+            scene_tree_params.insert("node_type", "quantized");
+
+        if (!scene_tree_params.strings().exist("leaf_encoding"))
+            scene_tree_params.insert("leaf_encoding", "indexed");
+
+        tree_size = static_cast<uint64>(tree_size * CompactTreeRatio);
+
+        RENDERER_LOG_INFO(
+            "memory limit: using compact nodes and leaves in acceleration structures.");
+        ++degradation_count;
+    }
+
+    const uint64 available_size = subtract(budget, usage.m_current + tree_size);
+
+    // Shrink the texture caches, leaving room for the photon maps.
+    if (texture_cache_size + photon_map_size > available_size &&
+        texture_cache_size > MinTextureCacheSize)
+    {
+        const uint64 new_texture_cache_size =
+            max(subtract(available_size, photon_map_size), MinTextureCacheSize);
+
+        // Unless the texture budget is shared, both the texture store and OIIO get max_size.
+        const TextureMemoryBudget texture_budget(params.child("texture_store"));
+        const uint64 new_max_size =
+            texture_budget.is_shared() ? new_texture_cache_size : new_texture_cache_size / 2;
+        params.push("texture_store").insert("max_size", new_max_size);
+
+        RENDERER_LOG_INFO(
+            "memory limit: reducing the size of the texture caches from %s to %s.",
+            pretty_size(texture_cache_size).c_str(),
+            pretty_size(new_texture_cache_size).c_str());
+        texture_cache_size = new_texture_cache_size;
+        ++degradation_count;
+    }
+
+    const uint64 available_photon_map_size = subtract(available_size, texture_cache_size);
+
+    // Use compact photons.
+    if (photon_map_size > available_photon_map_size &&
+        params.child("sppm").get_optional<string>("photon_format", "full") != "compact")
+    {
+        params.push("sppm").insert("photon_format", "compact");
+        photon_map_size = get_photon_map_size(params);
+
+        RENDERER_LOG_INFO("memory limit: using compact sppm photons.");
+        ++degradation_count;
+    }
+
+    // Trace fewer photons.
+    if (photon_map_size > available_photon_map_size)
+    {
+        const double scale =
+            max(
+                static_cast<double>(available_photon_map_size) / photon_map_size,
+                MinPhotonCountFraction);
+
+        ParamArray& sppm_params = params.push("sppm");
+        const size_t photon_count = get_emitted_photon_count(sppm_params);
+        const size_t light_photon_count = sppm_params.get_optional<size_t>("light_photons_per_pass", 1000000);
+        const size_t env_photon_count = sppm_params.get_optional<size_t>("env_photons_per_pass", 1000000);
+
+        sppm_params.insert("light_photons_per_pass", static_cast<size_t>(light_photon_count * scale));
+        sppm_params.insert("env_photons_per_pass", static_cast<size_t>(env_photon_count * scale));
+        photon_map_size = get_photon_map_size(params);
+
+        RENDERER_LOG_INFO(
+            "memory limit: reducing the number of sppm photons per pass from %s to %s.",
+            pretty_uint(photon_count).c_str(),
+            pretty_uint(get_emitted_photon_count(sppm_params)).c_str());
+        ++degradation_count;
+    }
+
+    const uint64 projected_size = usage.m_current + tree_size + texture_cache_size + photon_map_size;
+    if (projected_size > budget)
+    {
+        RENDERER_LOG_WARNING(
+            "memory limit: the render will likely use more than %s, about %s are projected.",
+            pretty_size(m_limit).c_str(),
+            pretty_size(projected_size).c_str());
+    }
+
+    return degradation_count;
+}
+
+}   // namespace renderer
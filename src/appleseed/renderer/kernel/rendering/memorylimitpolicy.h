@@ -0,0 +1,120 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_RENDERER_KERNEL_RENDERING_MEMORYLIMITPOLICY_H
+#define APPLESEED_RENDERER_KERNEL_RENDERING_MEMORYLIMITPOLICY_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace renderer  { class Frame; }
+namespace renderer  { class ParamArray; }
+
+namespace renderer
+{
+
+//
+// Keeps a render within a global memory limit by trading speed and quality for
+// memory as the projected memory usage of the render approaches the limit.
+//
+// The limit is the "memory_limit" rendering parameter, in bytes (0 for no limit).
+// The projected usage is the memory accounted for by the memory tracker, plus
+// estimates of the acceleration structures that remain to be built, of the texture
+// caches and of the photon maps of SPPM. A tenth of the limit is set aside for
+// memory that is not accounted for. When the projection exceeds the rest of the
+// limit, the following degradations are applied in order until it fits, and each
+// one is logged:
+//
+//   1. assemblies that don't choose their tree formats get quantized BVH nodes
+//      and indexed triangle leaves
+//   2. the texture caches shrink, down to 16 MB
+//   3. SPPM switches to compact photons, then traces fewer photons per pass,
+//      down to a tenth of the configured counts
+//
+// The frame is left to the application, which may stream it to disk (see
+// should_stream_output()) or lower the limit by the size of the frame.
+//
+
+class APPLESEED_DLLSYMBOL MemoryLimitPolicy
+  : public foundation::NonCopyable
+{
+  public:
+    // Memory usage of a render, in bytes.
+    struct Usage
+    {
+        foundation::uint64  m_current;      // memory in use, excluding texture caches and photon maps
+        foundation::uint64  m_trees;        // acceleration structures that remain to be built
+
+        Usage();
+    };
+
+    // Constructor. 'params' are the rendering parameters.
+    explicit MemoryLimitPolicy(const ParamArray& params);
+
+    // Return the memory limit in bytes, 0 if there is none.
+    foundation::uint64 get_limit() const;
+
+    // Return the current memory usage as recorded by the global memory tracker.
+    // Acceleration structures are assumed to take about as much memory as the
+    // tessellations they index.
+    static Usage get_current_usage();
+
+    // Return the size in bytes of the images of a frame once all their tiles are allocated.
+    static foundation::uint64 get_frame_size(const Frame& frame);
+
+    // Return true if a frame of a given size does not fit within the limit
+    // along with the rest of the render, without degrading it.
+    bool should_stream_output(
+        const Usage&                usage,
+        const ParamArray&           params,
+        const foundation::uint64    frame_size) const;
+
+    // Degrade the rendering parameters and the acceleration structure parameters
+    // of the scene until the projected usage fits within the limit. Return the
+    // number of degradations applied.
+    size_t apply(
+        const Usage&                usage,
+        ParamArray&                 params,
+        ParamArray&                 scene_tree_params) const;
+
+  private:
+    const foundation::uint64        m_limit;
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_RENDERING_MEMORYLIMITPOLICY_H
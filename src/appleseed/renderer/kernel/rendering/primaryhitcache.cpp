@@ -0,0 +1,248 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Interface header.
+#include "primaryhitcache.h"
+
+// appleseed.renderer headers.
+#include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/rendering/pixelcontext.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/modeling/camera/camera.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/math/filter.h"
+#include "foundation/math/intersection/raytrianglemt.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/transform.h"
+#include "foundation/platform/atomic.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// PrimaryHitCache class implementation.
+//
+
+namespace
+{
+    // Stamp of the entries that are being written.
+    const uint32 WritingStamp = ~uint32(0);
+
+    // Map a version of the trace context to a stamp that is neither 0 nor WritingStamp.
+    uint32 make_stamp(const VersionID version_id)
+    {
+        return static_cast<uint32>(version_id % (WritingStamp - 1)) + 1;
+    }
+}
+
+bool PrimaryHitCache::is_supported(const Scene& scene, const Frame& frame)
+{
+    const Camera* camera = scene.get_active_camera();
+
+    return
+        camera &&
+        strcmp(camera->get_model(), "pinhole_camera") == 0 &&
+        camera->get_shutter_open_time_interval() == 0.0f &&
+        dynamic_cast<const BoxFilter2<float>*>(&frame.get_filter()) != 0;
+}
+
+PrimaryHitCache::PrimaryHitCache(
+    const Frame&                    frame,
+    const size_t                    strata)
+  : m_strata(strata)
+  , m_canvas_width(frame.image().properties().m_canvas_width)
+  , m_canvas_height(frame.image().properties().m_canvas_height)
+  , m_rcp_canvas_width(1.0 / m_canvas_width)
+  , m_rcp_canvas_height(1.0 / m_canvas_height)
+  , m_rcp_strata(1.0 / strata)
+  , m_max_snapped_samples(static_cast<uint32>(strata * strata))
+{
+    assert(strata > 0);
+
+    Entry empty_entry;
+    empty_entry.m_stamp = 0;
+    empty_entry.m_assembly_instance = 0;
+
+    m_entries.assign(m_canvas_width * m_canvas_height * m_strata * m_strata, empty_entry);
+
+    PixelSampleCount empty_count;
+    empty_count.m_stamp = 0;
+    empty_count.m_count = 0;
+
+    m_pixel_sample_counts.assign(m_canvas_width * m_canvas_height, empty_count);
+}
+
+size_t PrimaryHitCache::get_memory_size() const
+{
+    return
+        sizeof(*this) +
+        m_entries.capacity() * sizeof(Entry) +
+        m_pixel_sample_counts.capacity() * sizeof(PixelSampleCount);
+}
+
+size_t PrimaryHitCache::snap(
+    const VersionID                 version_id,
+    const PixelContext&             pixel_context,
+    Vector2d&                       image_point)
+{
+    const Vector2i& pixel = pixel_context.get_pixel_coords();
+    assert(pixel.x >= 0 && static_cast<size_t>(pixel.x) < m_canvas_width);
+    assert(pixel.y >= 0 && static_cast<size_t>(pixel.y) < m_canvas_height);
+
+    // Count the sample, restarting from zero when the trace context was updated.
+    // Samples counted by other threads while the count is being reset may be lost.
+    PixelSampleCount& sample_count = m_pixel_sample_counts[pixel.y * m_canvas_width + pixel.x];
+    const uint32 stamp = make_stamp(version_id);
+    const uint32 current_stamp = atomic_read(&sample_count.m_stamp);
+    if (current_stamp != stamp && atomic_cas(&sample_count.m_stamp, current_stamp, stamp) == current_stamp)
+        atomic_write(&sample_count.m_count, 0);
+
+    // Stop snapping samples once the pixel has received one sample per stratum, to bound the bias.
+    if (atomic_inc(&sample_count.m_count) >= m_max_snapped_samples)
+        return NoStratum;
+
+    // Find the stratum of the sample inside its pixel.
+    const double fx = image_point.x * m_canvas_width - pixel.x;
+    const double fy = image_point.y * m_canvas_height - pixel.y;
+    const size_t sx = min(truncate<size_t>(max(fx, 0.0) * m_strata), m_strata - 1);
+    const size_t sy = min(truncate<size_t>(max(fy, 0.0) * m_strata), m_strata - 1);
+
+    // Move the sample to the center of the stratum.
+    image_point.x = (pixel.x + (sx + 0.5) * m_rcp_strata) * m_rcp_canvas_width;
+    image_point.y = (pixel.y + (sy + 0.5) * m_rcp_strata) * m_rcp_canvas_height;
+
+    return (pixel.y * m_strata + sy) * m_canvas_width * m_strata + pixel.x * m_strata + sx;
+}
+
+bool PrimaryHitCache::lookup(
+    const size_t                    stratum,
+    const VersionID                 version_id,
+    const Intersector&              intersector,
+    const ShadingRay&               ray,
+    ShadingPoint&                   shading_point) const
+{
+    assert(stratum < m_entries.size());
+    const Entry& entry = m_entries[stratum];
+
+    // Entries are never modified once they carry the stamp of the current version.
+    if (atomic_read(const_cast<volatile uint32*>(&entry.m_stamp)) != make_stamp(version_id))
+        return false;
+
+    if (entry.m_assembly_instance == 0)
+    {
+        intersector.manufacture_miss(shading_point, ray);
+        return true;
+    }
+
+    ShadingRay hit_ray(ray);
+    hit_ray.m_tmax = entry.m_distance;
+
+    intersector.manufacture_hit(
+        shading_point,
+        hit_ray,
+        ShadingPoint::PrimitiveTriangle,
+        entry.m_bary,
+        entry.m_assembly_instance,
+        entry.m_assembly_instance->transform_sequence().get_earliest_transform(),
+        entry.m_object_instance_index,
+        entry.m_region_index,
+        entry.m_primitive_index,
+        TriangleSupportPlaneType());
+
+    // The support plane of the triangle is only needed to refine the intersection point.
+    // Rebuild it from the source geometry of the shading point instead of storing it.
+    shading_point.cache_source_geometry();
+    const Transformd& object_instance_transform = shading_point.m_object_instance->get_transform();
+    shading_point.m_triangle_support_plane.initialize(
+        TriangleMT<double>(
+            object_instance_transform.point_to_parent(Vector3d(shading_point.m_v0)),
+            object_instance_transform.point_to_parent(Vector3d(shading_point.m_v1)),
+            object_instance_transform.point_to_parent(Vector3d(shading_point.m_v2))));
+
+    return true;
+}
+
+void PrimaryHitCache::store(
+    const size_t                    stratum,
+    const VersionID                 version_id,
+    const ShadingPoint&             shading_point)
+{
+    if (shading_point.hit())
+    {
+        if (!shading_point.is_triangle_primitive())
+            return;
+
+        // The transform of nested or moving assembly instances can't be recovered from the instance alone.
+        const AssemblyInstance& assembly_instance = shading_point.get_assembly_instance();
+        if (assembly_instance.get_parent() != &shading_point.get_scene() ||
+            assembly_instance.transform_sequence().size() > 1)
+            return;
+    }
+
+    assert(stratum < m_entries.size());
+    Entry& entry = m_entries[stratum];
+
+    // Claim the entry, unless it is up-to-date or another thread is writing it.
+    const uint32 stamp = make_stamp(version_id);
+    const uint32 current_stamp = atomic_read(&entry.m_stamp);
+    if (current_stamp == stamp || current_stamp == WritingStamp)
+        return;
+    if (atomic_cas(&entry.m_stamp, current_stamp, WritingStamp) != current_stamp)
+        return;
+
+    if (shading_point.hit())
+    {
+        entry.m_object_instance_index = static_cast<uint32>(shading_point.get_object_instance_index());
+        entry.m_region_index = static_cast<uint32>(shading_point.get_region_index());
+        entry.m_primitive_index = static_cast<uint32>(shading_point.get_primitive_index());
+        entry.m_distance = shading_point.get_distance();
+        entry.m_bary = shading_point.get_bary();
+        entry.m_assembly_instance = &shading_point.get_assembly_instance();
+    }
+    else entry.m_assembly_instance = 0;
+
+    // Publish the entry.
+    atomic_write(&entry.m_stamp, stamp);
+}
+
+}   // namespace renderer
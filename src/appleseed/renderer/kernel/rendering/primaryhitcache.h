@@ -0,0 +1,164 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef APPLESEED_RENDERER_KERNEL_RENDERING_PRIMARYHITCACHE_H
+#define APPLESEED_RENDERER_KERNEL_RENDERING_PRIMARYHITCACHE_H
+
+// appleseed.renderer headers.
+#include "renderer/kernel/shading/shadingray.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/version.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+// Forward declarations.
+namespace renderer  { class AssemblyInstance; }
+namespace renderer  { class Frame; }
+namespace renderer  { class Intersector; }
+namespace renderer  { class PixelContext; }
+namespace renderer  { class Scene; }
+namespace renderer  { class ShadingPoint; }
+
+namespace renderer
+{
+
+//
+// A cache of the first hits of camera rays, shared by all rendering threads.
+//
+// Sample positions are snapped to the centers of a regular grid of strata inside each pixel
+// such that all the samples of a stratum trace the same camera ray. The hit of this ray is
+// stored the first time it is traced and reused by the following passes of a progressive
+// render, as long as the trace context is not updated.
+//
+// Snapping samples is biased: it replaces the integral over the pixel by a sum over the
+// centers of its strata, which doesn't converge to the right image. To bound this bias,
+// samples are only snapped until their pixel has received as many samples as it has strata
+// (i.e. about as many passes as there are strata); later samples are left where they are
+// and bypass the cache, so that their contribution eventually dominates.
+//
+// This is only correct if camera rays are entirely determined by their position on the
+// film, i.e. with a pinhole camera whose shutter opens and closes at the same time, and if
+// moving samples inside their pixel doesn't change how they are filtered, i.e. with a box
+// filter. Only hits on triangles of static, top-level assembly instances are cached, along
+// with rays that escape the scene.
+//
+
+class PrimaryHitCache
+  : public foundation::NonCopyable
+{
+  public:
+    // Stratum index returned by snap() when a sample must not use the cache.
+    static const size_t NoStratum = ~size_t(0);
+
+    // Return true if primary hits can be cached when rendering a given frame of a given scene.
+    static bool is_supported(const Scene& scene, const Frame& frame);
+
+    // Constructor. 'strata' is the number of strata per pixel along each axis.
+    PrimaryHitCache(
+        const Frame&                    frame,
+        const size_t                    strata);
+
+    // Return the number of strata per pixel along each axis.
+    size_t get_strata() const;
+
+    // Return the size (in bytes) of this object in memory.
+    size_t get_memory_size() const;
+
+    // Snap a sample position, expressed in normalized device coordinates, to the center
+    // of its stratum. Returns the index of the stratum, or NoStratum without moving the
+    // sample if its pixel already received strata x strata samples with this version of
+    // the trace context. Thread-safe; samples are counted approximately.
+    size_t snap(
+        const foundation::VersionID     version_id,
+        const PixelContext&             pixel_context,
+        foundation::Vector2d&           image_point);
+
+    // Retrieve the hit of a camera ray traced through the center of a given stratum.
+    // Returns false if no hit was stored for this stratum with this version of the trace context.
+    bool lookup(
+        const size_t                    stratum,
+        const foundation::VersionID     version_id,
+        const Intersector&              intersector,
+        const ShadingRay&               ray,
+        ShadingPoint&                   shading_point) const;
+
+    // Store the hit of a camera ray traced through the center of a given stratum.
+    // Hits that cannot be cached are ignored. Thread-safe.
+    void store(
+        const size_t                    stratum,
+        const foundation::VersionID     version_id,
+        const ShadingPoint&             shading_point);
+
+  private:
+    struct Entry
+    {
+        volatile foundation::uint32     m_stamp;                    // version of the trace context, 0 if empty
+        foundation::uint32              m_object_instance_index;
+        foundation::uint32              m_region_index;
+        foundation::uint32              m_primitive_index;
+        double                          m_distance;
+        foundation::Vector2f            m_bary;
+        const AssemblyInstance*         m_assembly_instance;        // 0 if the ray escaped the scene
+    };
+
+    struct PixelSampleCount
+    {
+        volatile foundation::uint32     m_stamp;                    // version of the trace context, 0 if never counted
+        volatile foundation::uint32     m_count;
+    };
+
+    const size_t                        m_strata;
+    const size_t                        m_canvas_width;
+    const size_t                        m_canvas_height;
+    const double                        m_rcp_canvas_width;
+    const double                        m_rcp_canvas_height;
+    const double                        m_rcp_strata;
+    const foundation::uint32            m_max_snapped_samples;
+    std::vector<Entry>                  m_entries;
+    std::vector<PixelSampleCount>       m_pixel_sample_counts;
+};
+
+
+//
+// PrimaryHitCache class implementation.
+//
+
+inline size_t PrimaryHitCache::get_strata() const
+{
+    return m_strata;
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_RENDERING_PRIMARYHITCACHE_H
@@ -32,6 +32,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
+#include "renderer/kernel/rendering/convergenceestimator.h"
 #include "renderer/kernel/rendering/iframerenderer.h"
 #include "renderer/kernel/rendering/isamplegenerator.h"
 #include "renderer/kernel/rendering/itilecallback.h"
@@ -53,6 +54,7 @@
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/thread.h"
 #include "foundation/platform/timers.h"
 #include "foundation/platform/types.h"
@@ -118,12 +120,25 @@ namespace
                     global_logger(),
                     m_job_queue,
                     m_params.m_thread_count,
-                    JobManager::KeepRunningOnEmptyQueue));
+                    JobManager::KeepRunningOnEmptyQueue |
+                    (m_params.m_work_stealing ? JobManager::WorkStealing : 0) |
+                    (m_params.m_pin_threads ? JobManager::PinWorkerThreads : 0)));
 
-            // Instantiate sample generators, one per rendering thread.
+            // Instantiate sample generators, one per rendering thread. If rendering threads are
+            // pinned, create each sample generator from the core its thread will run on so that
+            // its memory gets allocated on the same NUMA node.
             m_sample_generators.reserve(m_params.m_thread_count);
             for (size_t i = 0; i < m_params.m_thread_count; ++i)
             {
+                auto_ptr<ThreadAffinityContext> affinity_context;
+                if (m_params.m_pin_threads)
+                {
+                    affinity_context.reset(
+                        new ThreadAffinityContext(
+                            System::get_numa_grouped_logical_cpu_core(i),
+                            &global_logger()));
+                }
+
                 m_sample_generators.push_back(
                     generator_factory->create(i, m_params.m_thread_count));
             }
@@ -140,6 +155,7 @@ namespace
                         m_job_queue,
                         i,                              // job index
                         m_params.m_thread_count,        // job count
+                        m_params.m_job_duration,
                         m_abort_switch));
             }
 
@@ -233,6 +249,7 @@ namespace
             m_abort_switch.clear();
             m_buffer->clear();
             m_sample_counter.clear();
+            m_project.get_frame()->get_convergence_estimator().clear();
 
             // Reset sample generators.
             for (size_t i = 0, e = m_sample_generators.size(); i < e; ++i)
@@ -258,6 +275,9 @@ namespace
                     m_params.m_luminance_stats,
                     m_ref_image.get(),
                     m_ref_image_avg_lum,
+                    m_params.m_estimate_convergence,
+                    m_tile_callback.get() == 0,     // without a display thread, develop the frame for the estimator
+                    m_params.m_thread_count,
                     m_abort_switch));
             m_statistics_thread.reset(
                 new boost::thread(
@@ -356,6 +376,24 @@ namespace
             print_sample_generators_stats();
         }
 
+        virtual StatisticsVector get_statistics() const APPLESEED_OVERRIDE
+        {
+            StatisticsVector stats;
+
+            for (size_t i = 0; i < m_sample_generators.size(); ++i)
+                stats.merge(m_sample_generators[i]->get_statistics());
+
+            return stats;
+        }
+
+        virtual void get_thread_busy_times(vector<double>& busy_times) const APPLESEED_OVERRIDE
+        {
+            busy_times.resize(m_job_manager->get_thread_count());
+
+            for (size_t i = 0; i < busy_times.size(); ++i)
+                busy_times[i] = m_job_manager->get_busy_time(i);
+        }
+
       private:
         //
         // Progressive frame renderer parameters.
@@ -369,6 +407,10 @@ namespace
             const bool      m_perf_stats;               // collect and print performance statistics?
             const bool      m_luminance_stats;          // collect and print luminance statistics?
             const string    m_ref_image_path;           // path to the reference image
+            const bool      m_work_stealing;            // use per-thread job lists with work stealing?
+            const bool      m_pin_threads;              // pin rendering threads to cores, grouped by NUMA node?
+            const bool      m_estimate_convergence;     // update the convergence estimator of the frame?
+            const double    m_job_duration;             // target duration of a rendering job in seconds, 0 for fixed job sizes
 
             explicit Parameters(const ParamArray& params)
               : m_thread_count(get_rendering_thread_count(params))
@@ -377,6 +419,10 @@ namespace
               , m_perf_stats(params.get_optional<bool>("performance_statistics", false))
               , m_luminance_stats(params.get_optional<bool>("luminance_statistics", false))
               , m_ref_image_path(params.get_optional<string>("reference_image", ""))
+              , m_work_stealing(params.get_optional<bool>("work_stealing", false))
+              , m_pin_threads(params.get_optional<bool>("pin_rendering_threads", false))
+              , m_estimate_convergence(params.get_optional<bool>("estimate_convergence", false))
+              , m_job_duration(params.get_optional<double>("target_job_duration", 20.0) * 0.001)
             {
             }
         };
@@ -463,8 +509,9 @@ namespace
                 const double t1 = m_stopwatch.get_seconds();
 #endif
 
-                // Develop the accumulation buffer to the frame.
-                m_buffer.develop_to_frame(m_frame, m_abort_switch);
+                // Develop the tiles of the accumulation buffer that changed since the last refresh.
+                m_dirty_tiles.clear();
+                m_buffer.develop_dirty_tiles_to_frame(m_frame, m_dirty_tiles, m_abort_switch);
 
 #ifdef PRINT_DISPLAY_THREAD_PERFS
                 m_stopwatch.measure();
@@ -475,8 +522,21 @@ namespace
                 if (m_abort_switch.is_aborted())
                     return;
 
-                // Present the frame.
-                m_tile_callback->post_render(&m_frame);
+                // Present the frame, or only the tiles that changed.
+                const CanvasProperties& frame_props = m_frame.image().properties();
+                if (m_dirty_tiles.size() == frame_props.m_tile_count)
+                    m_tile_callback->post_render(&m_frame);
+                else
+                {
+                    for (size_t i = 0, e = m_dirty_tiles.size(); i < e; ++i)
+                    {
+                        const size_t tile_index = m_dirty_tiles[i];
+                        m_tile_callback->post_render_tile(
+                            &m_frame,
+                            tile_index % frame_props.m_tile_count_x,
+                            tile_index / frame_props.m_tile_count_x);
+                    }
+                }
 
 #ifdef PRINT_DISPLAY_THREAD_PERFS
                 m_stopwatch.measure();
@@ -503,6 +563,7 @@ namespace
             IAbortSwitch&                       m_abort_switch;
             ThreadFlag                          m_pause_flag;
             Stopwatch<DefaultWallclockTimer>    m_stopwatch;
+            vector<size_t>                      m_dirty_tiles;
         };
 
         //
@@ -520,6 +581,9 @@ namespace
                 const bool                  luminance_stats,
                 const Image*                ref_image,
                 const double                ref_image_avg_lum,
+                const bool                  estimate_convergence,
+                const bool                  develop_frame,
+                const size_t                thread_count,
                 IAbortSwitch&               abort_switch)
               : m_project(project)
               , m_buffer(buffer)
@@ -527,6 +591,9 @@ namespace
               , m_luminance_stats(luminance_stats)
               , m_ref_image(ref_image)
               , m_ref_image_avg_lum(ref_image_avg_lum)
+              , m_estimate_convergence(estimate_convergence)
+              , m_develop_frame(develop_frame)
+              , m_thread_count(thread_count)
               , m_abort_switch(abort_switch)
               , m_rcp_timer_frequency(1.0 / m_timer.frequency())
               , m_timer_start_value(m_timer.read())
@@ -594,6 +661,9 @@ namespace
 
                         if (m_luminance_stats || m_ref_image)
                             record_and_print_convergence_stats();
+
+                        if (m_estimate_convergence)
+                            estimate_convergence();
                     }
 
                     sleep(1000, m_abort_switch);
@@ -607,6 +677,9 @@ namespace
             const bool                      m_luminance_stats;
             const Image*                    m_ref_image;
             const double                    m_ref_image_avg_lum;
+            const bool                      m_estimate_convergence;
+            const bool                      m_develop_frame;
+            const size_t                    m_thread_count;
             IAbortSwitch&                   m_abort_switch;
             ThreadFlag                      m_pause_flag;
 
@@ -673,6 +746,30 @@ namespace
 
                 RENDERER_LOG_DEBUG("%s", output.c_str());
             }
+
+            void estimate_convergence()
+            {
+                Frame& frame = *m_project.get_frame();
+                const uint64 sample_count = m_buffer.get_sample_count();
+
+                if (m_develop_frame)
+                {
+                    m_buffer.develop_to_frame(frame, m_abort_switch);
+
+                    if (m_abort_switch.is_aborted())
+                        return;
+                }
+
+                ConvergenceEstimator& estimator = frame.get_convergence_estimator();
+                estimator.update(frame.image(), sample_count, m_thread_count);
+
+                if (estimator.has_estimate())
+                {
+                    RENDERER_LOG_INFO(
+                        "estimated relative rms error %s",
+                        pretty_scalar(estimator.get_error(), 4).c_str());
+                }
+            }
         };
 
         //
@@ -711,12 +808,7 @@ namespace
         {
             assert(!m_sample_generators.empty());
 
-            StatisticsVector stats;
-
-            for (size_t i = 0; i < m_sample_generators.size(); ++i)
-                stats.merge(m_sample_generators[i]->get_statistics());
-
-            RENDERER_LOG_DEBUG("%s", stats.to_string().c_str());
+            RENDERER_LOG_DEBUG("%s", get_statistics().to_string().c_str());
         }
     };
 }
@@ -786,6 +878,22 @@ Dictionary ProgressiveFrameRendererFactory::get_params_metadata()
             .insert("label", "Max Samples")
             .insert("help", "Maximum number of samples per pixel"));
 
+    metadata.dictionaries().insert(
+        "estimate_convergence",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Estimate Convergence")
+            .insert("help", "Estimate the noise remaining in the frame, for instance to stop rendering once a target error is reached"));
+
+    metadata.dictionaries().insert(
+        "target_job_duration",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "20.0")
+            .insert("label", "Target Job Duration")
+            .insert("help", "Duration in milliseconds of a rendering job, used to size jobs from the measured rendering speed; 0 for fixed job sizes"));
+
     return metadata;
 }
 
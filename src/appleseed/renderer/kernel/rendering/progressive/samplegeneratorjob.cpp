@@ -41,6 +41,8 @@
 #include "foundation/image/image.h"
 #include "foundation/math/scalar.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/tsctimer.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/stopwatch.h"
 
 // Boost headers.
@@ -65,6 +67,7 @@ SampleGeneratorJob::SampleGeneratorJob(
     JobQueue&                   job_queue,
     const size_t                job_index,
     const size_t                job_count,
+    const double                target_job_duration,
     IAbortSwitch&               abort_switch)
   : m_buffer(buffer)
   , m_sample_generator(sample_generator)
@@ -72,7 +75,9 @@ SampleGeneratorJob::SampleGeneratorJob(
   , m_job_queue(job_queue)
   , m_job_index(job_index)
   , m_job_count(job_count)
+  , m_target_job_duration(target_job_duration)
   , m_abort_switch(abort_switch)
+  , m_samples_per_second(0.0)
 {
 }
 
@@ -93,6 +98,10 @@ namespace
     // Shape of the curve in the exponential phase.
     const double CurveExponentInExponentialPhase = 2.0;
 
+    // Bounds of the number of samples per job when jobs are sized from their measured duration.
+    const uint64 MinSamplesPerJobInAdaptiveMode = 64;
+    const uint64 MaxSamplesPerJobInAdaptiveMode = MaxSamplesPerJobInExponentialPhase;
+
     // Constraints.
     BOOST_STATIC_ASSERT(SamplesPerJobInLinearPhase <= SamplesInUninterruptiblePhase);
 }
@@ -108,8 +117,22 @@ uint64 SampleGeneratorJob::samples_to_samples_per_job(const uint64 samples)
     return min(y, MaxSamplesPerJobInExponentialPhase);
 }
 
+uint64 SampleGeneratorJob::duration_to_samples_per_job(
+    const double                samples_per_second,
+    const double                job_duration)
+{
+    const double samples = samples_per_second * job_duration;
+
+    if (samples >= static_cast<double>(MaxSamplesPerJobInAdaptiveMode))
+        return MaxSamplesPerJobInAdaptiveMode;
+
+    return max(truncate<uint64>(samples), MinSamplesPerJobInAdaptiveMode);
+}
+
 void SampleGeneratorJob::execute(const size_t thread_index)
 {
+    ScopedTraceEvent event("sample generation", "rendering");
+
 #ifdef PRINT_DETAILED_PROGRESS
     Stopwatch<DefaultWallclockTimer> stopwatch(0);
     stopwatch.measure();
@@ -120,19 +143,29 @@ void SampleGeneratorJob::execute(const size_t thread_index)
     // the number of samples already reserved (not necessarily rendered).
     const uint64 current_sample_count = m_sample_counter.read();
 
+    // The first phase is uninterruptible in order to always have something to
+    // show during navigation. todo: the renderer freezes if it cannot generate
+    // samples during this phase; fix.
+    const bool abortable = current_sample_count > SamplesInUninterruptiblePhase;
+
+    // Past the first phase, and once the rendering speed is known, size the job
+    // such that it lasts the target duration: short jobs waste time in scheduling
+    // and in locking the accumulation buffer, long jobs hurt interactivity.
+    const bool adaptive = abortable && m_target_job_duration > 0.0 && m_samples_per_second > 0.0;
+    const uint64 samples_per_job =
+        adaptive
+            ? duration_to_samples_per_job(m_samples_per_second, m_target_job_duration)
+            : samples_to_samples_per_job(current_sample_count);
+
     // Reserve a number of samples to be rendered by this job.
-    const uint64 acquired_sample_count =
-        m_sample_counter.reserve(
-            samples_to_samples_per_job(current_sample_count));
+    const uint64 acquired_sample_count = m_sample_counter.reserve(samples_per_job);
 
     // Terminate this job is there are no more samples to render.
     if (acquired_sample_count == 0)
         return;
 
-    // The first phase is uninterruptible in order to always have something to
-    // show during navigation. todo: the renderer freezes if it cannot generate
-    // samples during this phase; fix.
-    const bool abortable = current_sample_count > SamplesInUninterruptiblePhase;
+    Stopwatch<TSCTimer> job_stopwatch(0);
+    job_stopwatch.start();
 
     // Render the samples and store them into the accumulation buffer.
     if (abortable)
@@ -151,6 +184,22 @@ void SampleGeneratorJob::execute(const size_t thread_index)
             no_abort);
     }
 
+    // Update the rendering speed, unless the job was cut short.
+    if (m_target_job_duration > 0.0 && (!abortable || !m_abort_switch.is_aborted()))
+    {
+        job_stopwatch.measure();
+        const double seconds = job_stopwatch.get_seconds();
+
+        if (seconds > 0.0)
+        {
+            const double samples_per_second = acquired_sample_count / seconds;
+            m_samples_per_second =
+                m_samples_per_second > 0.0
+                    ? 0.5 * (m_samples_per_second + samples_per_second)
+                    : samples_per_second;
+        }
+    }
+
 #ifdef PRINT_DETAILED_PROGRESS
     stopwatch.measure();
     const double t2 = stopwatch.get_seconds();
@@ -53,7 +53,15 @@ class SampleGeneratorJob
     static foundation::uint64 samples_to_samples_per_job(
         const foundation::uint64    samples);
 
-    // Constructor.
+    // Number of samples per job such that a job lasts a given duration (in seconds)
+    // at a given rendering speed (in samples per second).
+    static foundation::uint64 duration_to_samples_per_job(
+        const double                samples_per_second,
+        const double                job_duration);
+
+    // Constructor. If 'target_job_duration' (in seconds) is positive, the number of
+    // samples per job is adjusted based on the measured duration of previous jobs;
+    // otherwise it only depends on the number of samples already rendered.
     SampleGeneratorJob(
         SampleAccumulationBuffer&   buffer,
         ISampleGenerator*           sample_generator,
@@ -61,6 +69,7 @@ class SampleGeneratorJob
         foundation::JobQueue&       job_queue,
         const size_t                job_index,
         const size_t                job_count,
+        const double                target_job_duration,
         foundation::IAbortSwitch&   abort_switch);
 
     // Execute the job.
@@ -73,7 +82,9 @@ class SampleGeneratorJob
     foundation::JobQueue&           m_job_queue;
     const size_t                    m_job_index;
     const size_t                    m_job_count;
+    const double                    m_target_job_duration;
     foundation::IAbortSwitch&       m_abort_switch;
+    double                          m_samples_per_second;   // measured rendering speed, 0 if unknown
 };
 
 }       // namespace renderer
@@ -32,7 +32,9 @@
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
 #include "renderer/kernel/lighting/drt/drtlightingengine.h"
+#include "renderer/kernel/lighting/lightselectionguide.h"
 #include "renderer/kernel/lighting/lighttracing/lighttracingsamplegenerator.h"
+#include "renderer/kernel/lighting/pathguide.h"
 #include "renderer/kernel/lighting/pt/ptlightingengine.h"
 #include "renderer/kernel/lighting/sppm/sppmlightingengine.h"
 #include "renderer/kernel/lighting/sppm/sppmparameters.h"
@@ -43,6 +45,8 @@
 #include "renderer/kernel/rendering/debug/debugtilerenderer.h"
 #include "renderer/kernel/rendering/ephemeralshadingresultframebufferfactory.h"
 #include "renderer/kernel/rendering/final/adaptivepixelrenderer.h"
+#include "renderer/kernel/rendering/final/multipassadaptivepasscallback.h"
+#include "renderer/kernel/rendering/final/multipassadaptivepixelrenderer.h"
 #include "renderer/kernel/rendering/final/uniformpixelrenderer.h"
 #include "renderer/kernel/rendering/generic/genericframerenderer.h"
 #include "renderer/kernel/rendering/generic/genericsamplegenerator.h"
@@ -50,9 +54,14 @@
 #include "renderer/kernel/rendering/generic/generictilerenderer.h"
 #include "renderer/kernel/rendering/permanentshadingresultframebufferfactory.h"
 #include "renderer/kernel/rendering/progressive/progressiveframerenderer.h"
+#include "renderer/modeling/frame/frame.h"
 #include "renderer/modeling/project/project.h"
 #include "renderer/utility/paramarray.h"
 
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+
 // Standard headers.
 #include <string>
 
@@ -82,30 +91,89 @@ namespace
     {
         ParamArray child = source.child(name);
         copy_param(child, source, "sampling_mode");
+        copy_param(child, source, "blue_noise");
         copy_param(child, source, "rendering_threads");
+        copy_param(child, source, "work_stealing");
+        copy_param(child, source, "pin_rendering_threads");
         return child;
     }
+
+    // A pass callback that forwards the notifications to two other pass callbacks.
+    class PassCallbackPair
+      : public IPassCallback
+    {
+      public:
+        PassCallbackPair(
+            IPassCallback*  first,
+            IPassCallback*  second)
+          : m_first(first)
+          , m_second(second)
+        {
+        }
+
+        virtual ~PassCallbackPair()
+        {
+            m_first->release();
+            m_second->release();
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            delete this;
+        }
+
+        virtual void pre_render(
+            const Frame&                frame,
+            foundation::JobQueue&       job_queue,
+            foundation::IAbortSwitch&   abort_switch) APPLESEED_OVERRIDE
+        {
+            m_first->pre_render(frame, job_queue, abort_switch);
+            m_second->pre_render(frame, job_queue, abort_switch);
+        }
+
+        virtual bool post_render(
+            const Frame&                frame,
+            foundation::JobQueue&       job_queue,
+            foundation::IAbortSwitch&   abort_switch) APPLESEED_OVERRIDE
+        {
+            const bool first_done = m_first->post_render(frame, job_queue, abort_switch);
+            const bool second_done = m_second->post_render(frame, job_queue, abort_switch);
+            return first_done || second_done;
+        }
+
+      private:
+        IPassCallback*      m_first;
+        IPassCallback*      m_second;
+    };
 }
 
 RendererComponents::RendererComponents(
     const Project&          project,
     const ParamArray&       params,
     ITileCallbackFactory*   tile_callback_factory,
+    ITileSource*            tile_source,
     TextureStore&           texture_store,
     OIIO::TextureSystem&    texture_system,
-    OSL::ShadingSystem&     shading_system
-    )
+    OSL::ShadingSystem&     shading_system,
+    LightSamplerCache&      light_sampler_cache,
+    LiveRenderCounters*     live_counters)
   : m_project(project)
   , m_params(params)
   , m_tile_callback_factory(tile_callback_factory)
+  , m_tile_source(tile_source)
   , m_scene(*project.get_scene())
   , m_frame(*project.get_frame())
   , m_trace_context(project.get_trace_context())
-  , m_light_sampler(m_scene, get_child_and_inherit_globals(params, "light_sampler"))
+  , m_light_sampler(
+        light_sampler_cache.get(
+            m_scene,
+            get_child_and_inherit_globals(params, "light_sampler"),
+            &texture_store))
   , m_shading_engine(get_child_and_inherit_globals(params, "shading_engine"))
   , m_texture_store(texture_store)
   , m_texture_system(texture_system)
   , m_shading_system(shading_system)
+  , m_live_counters(live_counters)
 {
 }
 
@@ -152,16 +220,51 @@ bool RendererComponents::create_lighting_engine_factory()
     {
         m_lighting_engine_factory.reset(
             new DRTLightingEngineFactory(
+                m_scene,
                 m_light_sampler,
                 get_child_and_inherit_globals(m_params, "drt")));   // todo: change to "drt_lighting_engine"?
         return true;
     }
     else if (name == "pt")
     {
+        const ParamArray pt_params = get_child_and_inherit_globals(m_params, "pt");  // todo: change to "pt_lighting_engine"?
+
+        // The path guide and the light selection guide learn between passes, so they act as the pass callback.
+        PathGuide* path_guide = 0;
+        if (pt_params.get_optional<bool>("enable_path_guiding", false))
+            path_guide = new PathGuide(m_scene, pt_params);
+
+        LightSelectionGuide* light_selection_guide = 0;
+        if (pt_params.get_optional<bool>("enable_adaptive_light_selection", false))
+            light_selection_guide = new LightSelectionGuide(m_scene, m_light_sampler, pt_params);
+
+        if (path_guide && light_selection_guide)
+            m_pass_callback.reset(new PassCallbackPair(path_guide, light_selection_guide));
+        else if (path_guide)
+            m_pass_callback.reset(path_guide);
+        else if (light_selection_guide)
+            m_pass_callback.reset(light_selection_guide);
+
+        // Resampled light samples of camera rays are reused across pixels and passes.
+        if (pt_params.get_optional<bool>("dl_resampling", false) &&
+            pt_params.get_optional<bool>("dl_resampling_reuse", false))
+        {
+            const foundation::CanvasProperties& props = m_frame.image().properties();
+            m_light_reservoir_buffer.reset(
+                new LightReservoirBuffer(
+                    m_light_sampler,
+                    props.m_canvas_width,
+                    props.m_canvas_height,
+                    pt_params));
+        }
+
         m_lighting_engine_factory.reset(
             new PTLightingEngineFactory(
                 m_light_sampler,
-                get_child_and_inherit_globals(m_params, "pt")));    // todo: change to "pt_lighting_engine"?
+                pt_params,
+                path_guide,
+                light_selection_guide,
+                m_light_reservoir_buffer.get()));
         return true;
     }
     else if (name == "sppm")
@@ -218,6 +321,7 @@ bool RendererComponents::create_sample_renderer_factory()
                 m_shading_engine,
                 m_texture_system,
                 m_shading_system,
+                m_live_counters,
                 get_child_and_inherit_globals(m_params, "generic_sample_renderer")));
         return true;
     }
@@ -325,6 +429,40 @@ bool RendererComponents::create_pixel_renderer_factory()
                 get_child_and_inherit_globals(m_params, "adaptive_pixel_renderer")));
         return true;
     }
+    else if (name == "multipass_adaptive")
+    {
+        if (m_sample_renderer_factory.get() == 0)
+        {
+            RENDERER_LOG_ERROR("cannot use the multi-pass adaptive pixel renderer without a sample renderer.");
+            return false;
+        }
+
+        if (m_pass_callback.get() != 0)
+        {
+            RENDERER_LOG_ERROR("cannot use the multi-pass adaptive pixel renderer with this lighting engine.");
+            return false;
+        }
+
+        // Pixels that receive no sample in a pass must keep the samples of previous passes.
+        if (m_params.get_optional<string>("shading_result_framebuffer", "ephemeral") != "permanent")
+        {
+            RENDERER_LOG_ERROR("cannot use the multi-pass adaptive pixel renderer without a permanent shading result framebuffer.");
+            return false;
+        }
+
+        ParamArray params = get_child_and_inherit_globals(m_params, "multipass_adaptive_pixel_renderer");
+        copy_param(params, m_params, "passes");
+
+        MultipassAdaptivePassCallback* pass_callback = new MultipassAdaptivePassCallback(params);
+        m_pass_callback.reset(pass_callback);
+
+        m_pixel_renderer_factory.reset(
+            new MultipassAdaptivePixelRendererFactory(
+                *pass_callback,
+                m_sample_renderer_factory.get(),
+                params));
+        return true;
+    }
     else
     {
         RENDERER_LOG_ERROR(
@@ -434,6 +572,7 @@ bool RendererComponents::create_frame_renderer_factory()
                 m_tile_renderer_factory.get(),
                 m_tile_callback_factory,
                 m_pass_callback.get(),
+                m_tile_source,
                 get_child_and_inherit_globals(m_params, "generic_frame_renderer")));
         return true;
     }
@@ -445,6 +584,12 @@ bool RendererComponents::create_frame_renderer_factory()
             return false;
         }
 
+        if (m_tile_source)
+        {
+            RENDERER_LOG_ERROR("cannot use the progressive frame renderer with a tile source.");
+            return false;
+        }
+
         m_frame_renderer.reset(
             ProgressiveFrameRendererFactory::create(
                 m_project,
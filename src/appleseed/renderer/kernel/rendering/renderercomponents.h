@@ -31,6 +31,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/lighting/ilightingengine.h"
+#include "renderer/kernel/lighting/lightreservoir.h"
 #include "renderer/kernel/lighting/lightsampler.h"
 #include "renderer/kernel/rendering/iframerenderer.h"
 #include "renderer/kernel/rendering/ipasscallback.h"
@@ -63,6 +64,8 @@ END_OSL_INCLUDES
 namespace renderer  { class Frame; }
 namespace renderer  { class IFrameRenderer; }
 namespace renderer  { class ITileCallbackFactory; }
+namespace renderer  { class ITileSource; }
+namespace renderer  { class LiveRenderCounters; }
 namespace renderer  { class ParamArray; }
 namespace renderer  { class Project; }
 namespace renderer  { class Scene; }
@@ -84,9 +87,12 @@ class RendererComponents
         const Project&          project,
         const ParamArray&       params,
         ITileCallbackFactory*   tile_callback_factory,
+        ITileSource*            tile_source,
         TextureStore&           texture_store,
         OIIO::TextureSystem&    texture_system,
-        OSL::ShadingSystem&     shading_system);
+        OSL::ShadingSystem&     shading_system,
+        LightSamplerCache&      light_sampler_cache,
+        LiveRenderCounters*     live_counters = 0);
 
     bool initialize();
 
@@ -96,15 +102,18 @@ class RendererComponents
     const Project&              m_project;
     const ParamArray&           m_params;
     ITileCallbackFactory*       m_tile_callback_factory;
+    ITileSource*                m_tile_source;
     const Scene&                m_scene;
     const Frame&                m_frame;
     const TraceContext&         m_trace_context;
-    LightSampler                m_light_sampler;
+    const LightSampler&         m_light_sampler;
     ShadingEngine               m_shading_engine;
     TextureStore&               m_texture_store;
     OIIO::TextureSystem&        m_texture_system;
     OSL::ShadingSystem&         m_shading_system;
+    LiveRenderCounters*         m_live_counters;
 
+    std::auto_ptr<LightReservoirBuffer>                 m_light_reservoir_buffer;
     std::auto_ptr<ILightingEngineFactory>               m_lighting_engine_factory;
     std::auto_ptr<ISampleRendererFactory>               m_sample_renderer_factory;
     std::auto_ptr<ISampleGeneratorFactory>              m_sample_generator_factory;
@@ -98,31 +98,32 @@ RendererServices::RendererServices(
   , m_project(project)
   , m_texture_store(0)
 {
-    // Set up attribute getters.
-    m_global_attr_getters[OIIO::ustring("object:object_instance_id")] = &RendererServices::get_attr_object_instance_id;
-    m_global_attr_getters[OIIO::ustring("object:object_instance_index")] = &RendererServices::get_attr_object_instance_index;
-    m_global_attr_getters[OIIO::ustring("object:assembly_instance_id")] = &RendererServices::get_attr_assembly_instance_id;
-    m_global_attr_getters[OIIO::ustring("camera:resolution")] = &RendererServices::get_attr_camera_resolution;
-    m_global_attr_getters[OIIO::ustring("camera:projection")] = &RendererServices::get_attr_camera_projection;
-    m_global_attr_getters[OIIO::ustring("camera:pixelaspect")] = &RendererServices::get_attr_camera_pixelaspect;
-    m_global_attr_getters[OIIO::ustring("camera:screen_window")] = &RendererServices::get_attr_camera_screen_window;
-    m_global_attr_getters[OIIO::ustring("camera:fov")] = &RendererServices::get_attr_camera_fov;
-    m_global_attr_getters[OIIO::ustring("camera:clip")] = &RendererServices::get_attr_camera_clip;
-    m_global_attr_getters[OIIO::ustring("camera:clip_near")] = &RendererServices::get_attr_camera_clip_near;
-    m_global_attr_getters[OIIO::ustring("camera:clip_far")] = &RendererServices::get_attr_camera_clip_far;
-    m_global_attr_getters[OIIO::ustring("camera:shutter")] = &RendererServices::get_attr_camera_shutter;
-    m_global_attr_getters[OIIO::ustring("camera:shutter_open")] = &RendererServices::get_attr_camera_shutter_open;
-    m_global_attr_getters[OIIO::ustring("camera:shutter_close")] = &RendererServices::get_attr_camera_shutter_close;
-    m_global_attr_getters[OIIO::ustring("path:ray_depth")] = &RendererServices::get_attr_ray_depth;
-    m_global_attr_getters[OIIO::ustring("path:ray_length")] = &RendererServices::get_attr_ray_length;
-    m_global_attr_getters[OIIO::ustring("path:ray_ior")] = &RendererServices::get_attr_ray_ior;
-    m_global_attr_getters[OIIO::ustring("path:ray_has_differentials")] = &RendererServices::get_attr_ray_has_differentials;
-    m_global_attr_getters[OIIO::ustring("appleseed:version_major")] = &RendererServices::get_attr_appleseed_version_major;
-    m_global_attr_getters[OIIO::ustring("appleseed:version_minor")] = &RendererServices::get_attr_appleseed_version_minor;
-    m_global_attr_getters[OIIO::ustring("appleseed:version_patch")] = &RendererServices::get_attr_appleseed_version_patch;
-    m_global_attr_getters[OIIO::ustring("appleseed:version")] = &RendererServices::get_attr_appleseed_version;
-    m_global_attr_getters[OIIO::ustring("surface_shader:color")] = &RendererServices::get_attr_surface_shader_color;
-    m_global_attr_getters[OIIO::ustring("surface_shader:alpha")] = &RendererServices::get_attr_surface_shader_alpha;
+    // Set up attribute getters. Camera and appleseed attributes are constant during a
+    // frame and can be folded into constants by the runtime optimizer of OSL.
+    add_attr_getter("object:object_instance_id", &RendererServices::get_attr_object_instance_id, false);
+    add_attr_getter("object:object_instance_index", &RendererServices::get_attr_object_instance_index, false);
+    add_attr_getter("object:assembly_instance_id", &RendererServices::get_attr_assembly_instance_id, false);
+    add_attr_getter("camera:resolution", &RendererServices::get_attr_camera_resolution, true);
+    add_attr_getter("camera:projection", &RendererServices::get_attr_camera_projection, true);
+    add_attr_getter("camera:pixelaspect", &RendererServices::get_attr_camera_pixelaspect, true);
+    add_attr_getter("camera:screen_window", &RendererServices::get_attr_camera_screen_window, true);
+    add_attr_getter("camera:fov", &RendererServices::get_attr_camera_fov, true);
+    add_attr_getter("camera:clip", &RendererServices::get_attr_camera_clip, true);
+    add_attr_getter("camera:clip_near", &RendererServices::get_attr_camera_clip_near, true);
+    add_attr_getter("camera:clip_far", &RendererServices::get_attr_camera_clip_far, true);
+    add_attr_getter("camera:shutter", &RendererServices::get_attr_camera_shutter, true);
+    add_attr_getter("camera:shutter_open", &RendererServices::get_attr_camera_shutter_open, true);
+    add_attr_getter("camera:shutter_close", &RendererServices::get_attr_camera_shutter_close, true);
+    add_attr_getter("path:ray_depth", &RendererServices::get_attr_ray_depth, false);
+    add_attr_getter("path:ray_length", &RendererServices::get_attr_ray_length, false);
+    add_attr_getter("path:ray_ior", &RendererServices::get_attr_ray_ior, false);
+    add_attr_getter("path:ray_has_differentials", &RendererServices::get_attr_ray_has_differentials, false);
+    add_attr_getter("appleseed:version_major", &RendererServices::get_attr_appleseed_version_major, true);
+    add_attr_getter("appleseed:version_minor", &RendererServices::get_attr_appleseed_version_minor, true);
+    add_attr_getter("appleseed:version_patch", &RendererServices::get_attr_appleseed_version_patch, true);
+    add_attr_getter("appleseed:version", &RendererServices::get_attr_appleseed_version, true);
+    add_attr_getter("surface_shader:color", &RendererServices::get_attr_surface_shader_color, false);
+    add_attr_getter("surface_shader:alpha", &RendererServices::get_attr_surface_shader_alpha, false);
 
     // Set up user data getters.
     m_global_user_data_getters[OIIO::ustring("Tn")] = &RendererServices::get_user_data_tn;
@@ -131,6 +132,16 @@ RendererServices::RendererServices(
     m_global_user_data_getters[OIIO::ustring("dNdv")] = &RendererServices::get_user_data_dndv;
 }
 
+void RendererServices::add_attr_getter(
+    const char*                 name,
+    const AttrGetterFun         getter,
+    const bool                  frame_constant)
+{
+    AttrGetter& attr_getter = m_global_attr_getters[OIIO::ustring(name)];
+    attr_getter.m_getter = getter;
+    attr_getter.m_frame_constant = frame_constant;
+}
+
 void RendererServices::initialize(TextureStore& texture_store)
 {
     m_texture_store = &texture_store;
@@ -430,6 +441,18 @@ bool RendererServices::trace(
     const ShadingPoint* parent =
         reinterpret_cast<const ShadingPoint*>(sg->renderstate);
 
+    ShadingPoint::OSLTraceData* trace_data =
+        reinterpret_cast<ShadingPoint::OSLTraceData*>(sg->tracedata);
+
+    trace_data->m_traced = true;
+
+    // Nothing can be hit in an empty distance interval.
+    if (options.maxdist <= options.mindist)
+    {
+        trace_data->m_hit = false;
+        return false;
+    }
+
     Vector3d pos;
     const ShadingPoint* origin_shading_point;
 
@@ -463,9 +486,11 @@ bool RendererServices::trace(
         VisibilityFlags::ProbeRay,
         parent->get_ray().m_depth + 1);
 
-    // todo: move this out of the hot code path (but it must remain thread-local).
-    TextureCache texture_cache(*m_texture_store);
-    Intersector intersector(m_project.get_trace_context(), texture_cache);
+    // Trace with the texture cache of the thread shading the parent point: it is already
+    // warm, while creating and flushing a cache of our own for every ray is costly.
+    // todo: move the intersector out of the hot code path (but it must remain thread-local).
+    assert(parent->m_texture_cache);
+    Intersector intersector(m_project.get_trace_context(), *parent->m_texture_cache);
 
     ShadingPoint shading_point;
     intersector.trace(
@@ -473,11 +498,6 @@ bool RendererServices::trace(
         shading_point,
         origin_shading_point);
 
-    ShadingPoint::OSLTraceData* trace_data =
-        reinterpret_cast<ShadingPoint::OSLTraceData*>(sg->tracedata);
-
-    trace_data->m_traced = true;
-
     if (shading_point.hit())
     {
         trace_data->m_hit = true;
@@ -549,16 +569,21 @@ bool RendererServices::get_attribute(
     if (object != g_empty_ustr)
         return false;
 
+    // The runtime optimizer of OSL queries attributes speculatively, without a shading point.
+    const bool has_shading_point = sg != 0 && sg->renderstate != 0;
+
     // Try global attributes.
     AttrGetterMapType::const_iterator i = m_global_attr_getters.find(name);
     if (i != m_global_attr_getters.end())
     {
-        AttrGetterFun getter = i->second;
-        return (this->*(getter))(sg, derivatives, object, type, name, val);
+        const AttrGetter& attr_getter = i->second;
+        if (!has_shading_point && !attr_getter.m_frame_constant)
+            return false;
+        return (this->*(attr_getter.m_getter))(sg, derivatives, object, type, name, val);
     }
 
     // Try user data from the current object.
-    if (object.empty())
+    if (has_shading_point)
         return get_userdata(derivatives, name, type, sg, val);
 
     return false;
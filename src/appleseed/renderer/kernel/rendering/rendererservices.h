@@ -313,7 +313,13 @@ class RendererServices
         OIIO::ustring               name,
         void*                       val) const;
 
-    typedef boost::unordered_map<OIIO::ustring, AttrGetterFun, OIIO::ustringHash> AttrGetterMapType;
+    struct AttrGetter
+    {
+        AttrGetterFun               m_getter;
+        bool                        m_frame_constant;   // true if the value doesn't depend on the shading point
+    };
+
+    typedef boost::unordered_map<OIIO::ustring, AttrGetter, OIIO::ustringHash> AttrGetterMapType;
 
     typedef bool (RendererServices::*UserDataGetterFun)(
         bool                        derivatives,
@@ -335,6 +341,11 @@ class RendererServices
     const Project&                  m_project;
     TextureStore*                   m_texture_store;
 
+    void add_attr_getter(
+        const char*                 name,
+        const AttrGetterFun         getter,
+        const bool                  frame_constant);
+
     #define DECLARE_ATTR_GETTER(name)           \
         bool get_attr_##name(                   \
             OSL::ShaderGlobals*     sg,         \
@@ -37,6 +37,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <vector>
 
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
@@ -70,6 +71,15 @@ class SampleAccumulationBuffer
         Frame&                      frame,
         foundation::IAbortSwitch&   abort_switch) = 0;
 
+    // Develop to a frame only the tiles whose pixels may have changed since the last call
+    // to this method (or since the buffer was cleared), and append the indices of these tiles
+    // (tile_y * tile_count_x + tile_x) to 'tiles'. Calls to develop_to_frame() don't affect
+    // which tiles are reported. Thread-safe.
+    virtual void develop_dirty_tiles_to_frame(
+        Frame&                      frame,
+        std::vector<size_t>&        tiles,
+        foundation::IAbortSwitch&   abort_switch) = 0;
+
   protected:
     boost::atomic<foundation::uint64> m_sample_count;
 };
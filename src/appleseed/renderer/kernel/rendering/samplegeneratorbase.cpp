@@ -98,7 +98,16 @@ void SampleGeneratorBase::generate_samples(
     }
 
     if (stored > 0)
-        buffer.store_samples(stored, &m_samples[0], abort_switch);
+        store_samples(buffer, stored, &m_samples[0], abort_switch);
+}
+
+void SampleGeneratorBase::store_samples(
+    SampleAccumulationBuffer&   buffer,
+    const size_t                sample_count,
+    const Sample                samples[],
+    IAbortSwitch&               abort_switch)
+{
+    buffer.store_samples(sample_count, samples, abort_switch);
 }
 
 void SampleGeneratorBase::signal_invalid_sample()
@@ -78,6 +78,18 @@ class SampleGeneratorBase
         const size_t                sequence_index,
         SampleVector&               samples) = 0;
 
+    // Store samples into an accumulation buffer. The default implementation calls
+    // SampleAccumulationBuffer::store_samples(); derived classes may override it to
+    // pass additional information to buffers they know about.
+    virtual void store_samples(
+        SampleAccumulationBuffer&   buffer,
+        const size_t                sample_count,
+        const Sample                samples[],
+        foundation::IAbortSwitch&   abort_switch);
+
+    // Return the index of this sample generator.
+    size_t get_generator_index() const;
+
     void signal_invalid_sample();
 
   private:
@@ -89,6 +101,16 @@ class SampleGeneratorBase
     foundation::uint64              m_invalid_sample_count;
 };
 
+
+//
+// SampleGeneratorBase class implementation.
+//
+
+inline size_t SampleGeneratorBase::get_generator_index() const
+{
+    return m_generator_index;
+}
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_KERNEL_RENDERING_SAMPLEGENERATORBASE_H
@@ -46,14 +46,18 @@
 #include "renderer/modeling/material/material.h"
 #include "renderer/modeling/material/materialtraits.h"
 #include "renderer/modeling/project/project.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
 #include "renderer/modeling/scene/scene.h"
 #include "renderer/modeling/surfaceshader/surfaceshadertraits.h"
+#include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
 #include "foundation/image/canvasproperties.h"
 #include "foundation/image/image.h"
 
 // Standard headers.
+#include <algorithm>
+#include <cassert>
 #include <limits>
 
 using namespace foundation;
@@ -62,6 +66,19 @@ using namespace std;
 namespace renderer
 {
 
+namespace
+{
+    // Texture lookups only happen for alpha maps, so a small store without
+    // prefetch threads is enough and keeps picker construction cheap.
+    ParamArray get_texture_store_params()
+    {
+        return
+            ParamArray()
+                .insert("shard_count", 1)
+                .insert("prefetch_thread_count", 0);
+    }
+}
+
 struct ScenePicker::Impl
 {
     const Project&      m_project;
@@ -73,11 +90,41 @@ struct ScenePicker::Impl
     explicit Impl(const Project& project)
       : m_project(project)
       , m_trace_context(m_project.get_trace_context())
-      , m_texture_store(m_trace_context.get_scene())
+      , m_texture_store(m_trace_context.get_scene(), get_texture_store_params())
       , m_texture_cache(m_texture_store)
       , m_intersector(m_trace_context, m_texture_cache)
     {
     }
+
+    // Trace a camera ray without ray differentials and fill the identifiers of the hit instances.
+    void pick_ids(
+        const Camera&           camera,
+        const Vector2d&         ndc,
+        ShadingPoint&           shading_point,
+        IDPickingResult&        result) const
+    {
+        SamplingContext::RNGType rng;
+        SamplingContext sampling_context(rng, SamplingContext::QMCMode);
+
+        ShadingRay ray;
+        camera.spawn_ray(sampling_context, Dual2d(ndc), ray);
+
+        shading_point.clear();
+        result.m_hit = m_intersector.trace(ray, shading_point);
+
+        if (result.m_hit)
+        {
+            result.m_assembly_instance_uid = shading_point.get_assembly_instance().get_uid();
+            result.m_object_instance_uid = shading_point.get_object_instance().get_uid();
+            result.m_primitive_index = shading_point.get_primitive_index();
+        }
+        else
+        {
+            result.m_assembly_instance_uid = ~UniqueID(0);
+            result.m_object_instance_uid = ~UniqueID(0);
+            result.m_primitive_index = ~size_t(0);
+        }
+    }
 };
 
 ScenePicker::ScenePicker(const Project& project)
@@ -208,4 +255,61 @@ ScenePicker::PickingResult ScenePicker::pick(const Vector2d& ndc) const
     return result;
 }
 
+ScenePicker::IDPickingResult ScenePicker::pick_ids(const Vector2d& ndc) const
+{
+    IDPickingResult result;
+    result.m_hit = false;
+    result.m_assembly_instance_uid = ~UniqueID(0);
+    result.m_object_instance_uid = ~UniqueID(0);
+    result.m_primitive_index = ~size_t(0);
+
+    const Camera* camera = impl->m_project.get_uncached_active_camera();
+
+    if (camera)
+    {
+        ShadingPoint shading_point;
+        impl->pick_ids(*camera, ndc, shading_point, result);
+    }
+
+    return result;
+}
+
+void ScenePicker::pick_ids(
+    const AABB2u&                   rect,
+    vector<IDPickingResult>&        results) const
+{
+    results.clear();
+
+    const Frame* frame = impl->m_project.get_frame();
+    const Camera* camera = impl->m_project.get_uncached_active_camera();
+
+    if (frame == 0 || camera == 0 || !rect.is_valid())
+        return;
+
+    const CanvasProperties& c = frame->image().properties();
+
+    if (rect.min.x >= c.m_canvas_width || rect.min.y >= c.m_canvas_height)
+        return;
+
+    // Clip the rectangle to the frame.
+    const size_t max_x = min<size_t>(rect.max.x, c.m_canvas_width - 1);
+    const size_t max_y = min<size_t>(rect.max.y, c.m_canvas_height - 1);
+
+    results.resize((max_x - rect.min.x + 1) * (max_y - rect.min.y + 1));
+
+    ShadingPoint shading_point;
+    size_t i = 0;
+
+    for (size_t y = rect.min.y; y <= max_y; ++y)
+    {
+        for (size_t x = rect.min.x; x <= max_x; ++x)
+        {
+            const Vector2d ndc = frame->get_sample_position(x, y, 0.5, 0.5);
+            impl->pick_ids(*camera, ndc, shading_point, results[i++]);
+        }
+    }
+
+    assert(i == results.size());
+}
+
 }   // namespace renderer
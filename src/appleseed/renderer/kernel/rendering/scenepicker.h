@@ -35,12 +35,18 @@
 #include "renderer/modeling/scene/objectinstance.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/aabb.h"
 #include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
+#include "foundation/utility/uid.h"
 
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
 // Forward declarations.
 namespace renderer  { class Assembly; }
 namespace renderer  { class AssemblyInstance; }
@@ -97,12 +103,31 @@ class APPLESEED_DLLSYMBOL ScenePicker
         const EDF*                      m_edf;
     };
 
+    // Identifiers of the picked instances. Much cheaper to compute than a full picking
+    // result since no shading point quantity is evaluated and no entity is looked up.
+    struct IDPickingResult
+    {
+        bool                            m_hit;
+        foundation::UniqueID            m_assembly_instance_uid;        // ~0 if nothing was hit
+        foundation::UniqueID            m_object_instance_uid;          // ~0 if nothing was hit
+        size_t                          m_primitive_index;              // ~0 if nothing was hit
+    };
+
+    // Only the trees of the project's trace context are used; they must have been built.
     explicit ScenePicker(const Project& project);
 
     ~ScenePicker();
 
     PickingResult pick(const foundation::Vector2d& ndc) const;
 
+    IDPickingResult pick_ids(const foundation::Vector2d& ndc) const;
+
+    // Pick the center of every pixel of a rectangle of the frame (ID-buffer mode).
+    // 'results' receives one entry per pixel of the rectangle, in row-major order.
+    void pick_ids(
+        const foundation::AABB2u&       rect,                           // pixel coordinates, inclusive
+        std::vector<IDPickingResult>&   results) const;
+
   private:
     struct Impl;
     Impl* impl;
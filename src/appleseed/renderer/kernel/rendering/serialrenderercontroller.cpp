@@ -167,13 +167,17 @@ void SerialRendererController::exec_callback(const PendingTileCallback& cb)
 
 void SerialRendererController::exec_callbacks()
 {
-    boost::mutex::scoped_lock lock(m_mutex);
+    // Take the pending callbacks and execute them without holding the lock,
+    // so that rendering threads never wait for the tile callback.
+    std::deque<PendingTileCallback> callbacks;
 
-    while (!m_pending_callbacks.empty())
     {
-        exec_callback(m_pending_callbacks.front());
-        m_pending_callbacks.pop_front();
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_pending_callbacks.swap(callbacks);
     }
+
+    for (size_t i = 0, e = callbacks.size(); i < e; ++i)
+        exec_callback(callbacks[i]);
 }
 
 }   // namespace renderer
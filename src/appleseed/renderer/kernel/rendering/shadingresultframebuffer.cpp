@@ -38,11 +38,16 @@
 // appleseed.foundation headers.
 #include "foundation/image/color.h"
 #include "foundation/image/colorspace.h"
+#include "foundation/image/deeptile.h"
 #include "foundation/image/tile.h"
 #include "foundation/platform/compiler.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
 
 // Standard headers.
 #include <cassert>
+#include <limits>
 
 using namespace foundation;
 using namespace std;
@@ -57,6 +62,37 @@ namespace
         // The main image plus a number of AOVs, all RGBA.
         return (1 + aov_count) * 4;
     }
+
+    // Compute color * scaling, where color points to four RGBA components.
+    APPLESEED_FORCE_INLINE Color4f scale_color(const float* color, const float scaling)
+    {
+#ifdef APPLESEED_USE_SSE
+        Color4f result;
+        _mm_storeu_ps(&result[0], _mm_mul_ps(_mm_loadu_ps(color), _mm_set1_ps(scaling)));
+        return result;
+#else
+        return Color4f(color[0], color[1], color[2], color[3]) * scaling;
+#endif
+    }
+
+    // Compute (color.rgb * rgb_scaling, color.a * alpha_scaling).
+    APPLESEED_FORCE_INLINE Color4f scale_color(
+        const float*    color,
+        const float     rgb_scaling,
+        const float     alpha_scaling)
+    {
+#ifdef APPLESEED_USE_SSE
+        Color4f result;
+        const __m128 mscaling = _mm_setr_ps(rgb_scaling, rgb_scaling, rgb_scaling, alpha_scaling);
+        _mm_storeu_ps(&result[0], _mm_mul_ps(_mm_loadu_ps(color), mscaling));
+        return result;
+#else
+        Color4f result(color[0], color[1], color[2], color[3]);
+        result.rgb() *= rgb_scaling;
+        result.a *= alpha_scaling;
+        return result;
+#endif
+    }
 }
 
 ShadingResultFrameBuffer::ShadingResultFrameBuffer(
@@ -71,7 +107,10 @@ ShadingResultFrameBuffer::ShadingResultFrameBuffer(
         filter)
   , m_aov_count(aov_count)
   , m_scratch(get_total_channel_count(aov_count))
+  , m_deep_tile(0)
+  , m_tracked_memory_size(MemoryTracker::FrameBuffers)
 {
+    m_tracked_memory_size.set(get_memory_size());
 }
 
 ShadingResultFrameBuffer::ShadingResultFrameBuffer(
@@ -88,7 +127,18 @@ ShadingResultFrameBuffer::ShadingResultFrameBuffer(
         filter)
   , m_aov_count(aov_count)
   , m_scratch(get_total_channel_count(aov_count))
+  , m_deep_tile(0)
+  , m_tracked_memory_size(MemoryTracker::FrameBuffers)
 {
+    m_tracked_memory_size.set(get_memory_size());
+}
+
+void ShadingResultFrameBuffer::set_deep_tile(DeepTile* deep_tile)
+{
+    assert(deep_tile == 0 || deep_tile->get_width() == m_width);
+    assert(deep_tile == 0 || deep_tile->get_height() == m_height);
+
+    m_deep_tile = deep_tile;
 }
 
 void ShadingResultFrameBuffer::add(
@@ -115,7 +165,26 @@ void ShadingResultFrameBuffer::add(
         *ptr++ = aov.m_alpha[0];
     }
 
-    FilteredTile::add(x, y, &m_scratch[0]);
+    // Only the thread rendering the tile accesses its framebuffer.
+    FilteredTile::add_exclusive(x, y, &m_scratch[0]);
+
+    // Deep fragments are not filtered: each sample only belongs to the pixel it falls in.
+    if (m_deep_tile && x >= 0.0f && y >= 0.0f)
+    {
+        const size_t ix = static_cast<size_t>(x);
+        const size_t iy = static_cast<size_t>(y);
+
+        if (ix < m_width && iy < m_height)
+        {
+            // Samples that hit nothing but the environment are infinitely far away.
+            const float depth =
+                sample.m_depth >= 0.0
+                    ? static_cast<float>(sample.m_depth)
+                    : numeric_limits<float>::max();
+
+            m_deep_tile->add(ix, iy, depth, &m_scratch[0]);
+        }
+    }
 }
 
 void ShadingResultFrameBuffer::merge(
@@ -131,7 +200,19 @@ void ShadingResultFrameBuffer::merge(
     const float* APPLESEED_RESTRICT source_ptr = source.pixel(source_x, source_y);
     float* APPLESEED_RESTRICT dest_ptr = pixel(dest_x, dest_y);
 
-    for (size_t i = 0; i < m_channel_count; ++i)
+    size_t i = 0;
+
+#ifdef APPLESEED_USE_SSE
+    const __m128 mscaling = _mm_set1_ps(scaling);
+
+    for (; i + 4 <= m_channel_count; i += 4)
+    {
+        const __m128 msource = _mm_mul_ps(_mm_loadu_ps(source_ptr + i), mscaling);
+        _mm_storeu_ps(dest_ptr + i, _mm_add_ps(_mm_loadu_ps(dest_ptr + i), msource));
+    }
+#endif
+
+    for (; i < m_channel_count; ++i)
         dest_ptr[i] += source_ptr[i] * scaling;
 }
 
@@ -148,14 +229,12 @@ void ShadingResultFrameBuffer::develop_to_tile_premult_alpha(
             const float weight = *ptr++;
             const float rcp_weight = weight == 0.0f ? 0.0f : 1.0f / weight;
 
-            const Color4f color(ptr[0], ptr[1], ptr[2], ptr[3]);
-            tile.set_pixel(x, y, color * rcp_weight);
+            tile.set_pixel(x, y, scale_color(ptr, rcp_weight));
             ptr += 4;
 
             for (size_t i = 0; i < m_aov_count; ++i)
             {
-                const Color4f aov(ptr[0], ptr[1], ptr[2], ptr[3]);
-                aov_tiles.set_pixel(x, y, i, aov * rcp_weight);
+                aov_tiles.set_pixel(x, y, i, scale_color(ptr, rcp_weight));
                 ptr += 4;
             }
         }
@@ -175,20 +254,14 @@ void ShadingResultFrameBuffer::develop_to_tile_straight_alpha(
             const float weight = *ptr++;
             const float rcp_weight = weight == 0.0f ? 0.0f : 1.0f / weight;
 
-            Color4f color(ptr[0], ptr[1], ptr[2], ptr[3]);
             const float rcp_weight_alpha = ptr[3] == 0.0f ? 0.0f : 1.0f / ptr[3];
-            color.rgb() *= rcp_weight_alpha;
-            color.a *= rcp_weight;
-            tile.set_pixel(x, y, color);
+            tile.set_pixel(x, y, scale_color(ptr, rcp_weight_alpha, rcp_weight));
             ptr += 4;
 
             for (size_t i = 0; i < m_aov_count; ++i)
             {
-                Color4f aov(ptr[0], ptr[1], ptr[2], ptr[3]);
                 const float rcp_weight_alpha = ptr[3] == 0.0f ? 0.0f : 1.0f / ptr[3];
-                aov.rgb() *= rcp_weight_alpha;
-                aov.a *= rcp_weight;
-                aov_tiles.set_pixel(x, y, i, aov);
+                aov_tiles.set_pixel(x, y, i, scale_color(ptr, rcp_weight_alpha, rcp_weight));
                 ptr += 4;
             }
         }
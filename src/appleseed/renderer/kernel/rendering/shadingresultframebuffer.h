@@ -34,12 +34,14 @@
 #include "foundation/image/filteredtile.h"
 #include "foundation/math/aabb.h"
 #include "foundation/math/filter.h"
+#include "foundation/utility/memorytracker.h"
 
 // Standard headers.
 #include <cstddef>
 #include <vector>
 
 // Forward declarations.
+namespace foundation    { class DeepTile; }
 namespace foundation    { class Tile; }
 namespace renderer      { class ShadingResult; }
 namespace renderer      { class TileStack; }
@@ -64,6 +66,10 @@ class ShadingResultFrameBuffer
         const foundation::AABB2u&       crop_window,
         const foundation::Filter2f&     filter);
 
+    // Also record the samples added to this framebuffer as fragments of a deep tile
+    // of the same dimensions. 'deep_tile' may be 0 to stop recording fragments.
+    void set_deep_tile(foundation::DeepTile* deep_tile);
+
     // The sample must be in the linear RGB color space.
     void add(
         const float                     x,
@@ -89,6 +95,8 @@ class ShadingResultFrameBuffer
   private:
     const size_t                        m_aov_count;
     std::vector<float>                  m_scratch;
+    foundation::DeepTile*               m_deep_tile;
+    foundation::TrackedMemorySize       m_tracked_memory_size;
 };
 
 }       // namespace renderer
@@ -612,6 +612,7 @@ namespace
             values->m_roughness = max(p->roughness, 0.0f);
             values->m_anisotropy = clamp(p->anisotropy, -1.0f, 1.0f);
             values->m_ior = max(p->ior, 0.001f);
+            values->m_energy_compensation = 0.0f;
         }
     };
 
@@ -900,6 +901,7 @@ namespace
             values->m_roughness = 0.0f;
             values->m_anisotropy = 0.0f;
             values->m_ior = max(p->ior, 0.001f);
+            values->m_energy_compensation = 0.0f;
         }
     };
 
@@ -1285,6 +1287,62 @@ namespace
 
         return static_cast<const OSL::ClosureColor*>(p->substrate);
     }
+
+    // Return the number of closure components in a closure tree, including those
+    // nested in layered closures. This is an upper bound on the number of closures
+    // any composite closure built from this tree can hold.
+    size_t count_closure_components(const OSL::ClosureColor* closure)
+    {
+        if (closure == 0)
+            return 0;
+
+#if OSL_LIBRARY_VERSION_CODE >= 10700
+        switch (closure->id)
+#else
+        switch (closure->type)
+#endif
+        {
+          case OSL::ClosureColor::MUL:
+            {
+                const OSL::ClosureMul* c = reinterpret_cast<const OSL::ClosureMul*>(closure);
+                return count_closure_components(c->closure);
+            }
+
+          case OSL::ClosureColor::ADD:
+            {
+                const OSL::ClosureAdd* c = reinterpret_cast<const OSL::ClosureAdd*>(closure);
+                return
+                    count_closure_components(c->closureA) +
+                    count_closure_components(c->closureB);
+            }
+
+          default:
+            {
+                const OSL::ClosureComponent* c = reinterpret_cast<const OSL::ClosureComponent*>(closure);
+                return
+                    c->id >= FirstLayeredClosure
+                        ? 1 + count_closure_components(get_nested_closure_color(c->id, c->data()))
+                        : 1;
+            }
+        }
+    }
+
+    // Allocate an array of default-constructed objects in an arena.
+    template <typename T>
+    T* allocate_constructed_array(Arena& arena, const size_t count)
+    {
+        T* array = arena.allocate_array<T>(count);
+
+        for (size_t i = 0; i < count; ++i)
+            new (&array[i]) T();
+
+        return array;
+    }
+
+    void log_closure_overflow()
+    {
+        RENDERER_LOG_ERROR("maximum number of closures in osl shader group exceeded, dropping closure.");
+    }
 }
 
 
@@ -1292,8 +1350,17 @@ namespace
 // CompositeClosure class implementation.
 //
 
-CompositeClosure::CompositeClosure()
+CompositeClosure::CompositeClosure(
+    const size_t                closure_capacity,
+    Arena&                      arena)
   : m_closure_count(0)
+  , m_closure_capacity(closure_capacity)
+  , m_input_values(arena.allocate_array<void*>(closure_capacity))
+  , m_closure_types(arena.allocate_array<ClosureID>(closure_capacity))
+  , m_weights(allocate_constructed_array<Spectrum>(arena, closure_capacity))
+  , m_cdf(arena.allocate_array<float>(closure_capacity))
+  , m_pdf_weights(arena.allocate_array<float>(closure_capacity))
+  , m_bases(allocate_constructed_array<Basis3f>(arena, closure_capacity))
 {
 }
 
@@ -1443,11 +1510,12 @@ InputValues* CompositeClosure::do_add_closure(
     const Vector3f&             tangent,
     Arena&                      arena)
 {
-    // Make sure we have enough space.
-    if APPLESEED_UNLIKELY(get_closure_count() >= MaxClosureEntries)
+    // The capacity is an upper bound on the number of closures in the closure tree,
+    // but don't rely on it to write past the end of the arrays: drop the closure.
+    if APPLESEED_UNLIKELY(get_closure_count() >= m_closure_capacity)
     {
-        throw ExceptionOSLRuntimeError(
-            "maximum number of closures in osl shader group exceeded");
+        log_closure_overflow();
+        return arena.allocate<InputValues>();
     }
 
     // We use the luminance of the weight as the BSDF weight.
@@ -1480,8 +1548,13 @@ CompositeSurfaceClosure::CompositeSurfaceClosure(
     const Basis3f&              original_shading_basis,
     const OSL::ClosureColor*    ci,
     Arena&                      arena)
-  : m_ior_count(0)
+  : CompositeClosure(count_closure_components(ci), arena)
+  , m_ior_count(0)
 {
+    // There is at most one IOR per closure, or the default IOR.
+    m_iors = arena.allocate_array<float>(max<size_t>(m_closure_capacity, 1));
+    m_ior_cdf = arena.allocate_array<float>(max<size_t>(m_closure_capacity, 1));
+
     process_closure_tree(ci, original_shading_basis, Color3f(1.0f), arena);
     compute_cdf();
 
@@ -1519,6 +1592,12 @@ void CompositeSurfaceClosure::add_ior(
     const float w = luminance(weight);
     assert(w > 0.0f);
 
+    if APPLESEED_UNLIKELY(m_ior_count >= max<size_t>(m_closure_capacity, 1))
+    {
+        log_closure_overflow();
+        return;
+    }
+
     m_iors[m_ior_count] = ior;
     m_ior_cdf[m_ior_count] = w;
     ++m_ior_count;
@@ -1587,6 +1666,7 @@ CompositeSubsurfaceClosure::CompositeSubsurfaceClosure(
     const Basis3f&              original_shading_basis,
     const OSL::ClosureColor*    ci,
     Arena&                      arena)
+  : CompositeClosure(count_closure_components(ci), arena)
 {
     process_closure_tree(ci, original_shading_basis, Color3f(1.0f), arena);
     compute_cdf();
@@ -1658,6 +1738,7 @@ void CompositeSubsurfaceClosure::process_closure_tree(
 CompositeEmissionClosure::CompositeEmissionClosure(
     const OSL::ClosureColor*    ci,
     Arena&                      arena)
+  : CompositeClosure(count_closure_components(ci), arena)
 {
     process_closure_tree(ci, Color3f(1.0f), arena);
     compute_cdf();
@@ -1670,11 +1751,10 @@ InputValues* CompositeEmissionClosure::add_closure(
     const float                 max_weight_component,
     Arena&                      arena)
 {
-    // Make sure we have enough space.
-    if APPLESEED_UNLIKELY(get_closure_count() >= MaxClosureEntries)
+    if APPLESEED_UNLIKELY(get_closure_count() >= m_closure_capacity)
     {
-        throw ExceptionOSLRuntimeError(
-            "maximum number of closures in osl shader group exceeded");
+        log_closure_overflow();
+        return arena.allocate<InputValues>();
     }
 
     m_closure_types[m_closure_count] = closure_type;
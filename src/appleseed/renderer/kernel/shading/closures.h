@@ -145,6 +145,9 @@ struct ExceptionOSLRuntimeError
 //
 // Composite OSL closure.
 //
+// The closure entries are allocated in the arena passed to the constructor
+// of derived classes, and sized to the number of closures in the closure tree.
+//
 
 class APPLESEED_ALIGN(16) CompositeClosure
   : public foundation::NonCopyable
@@ -188,17 +191,19 @@ class APPLESEED_ALIGN(16) CompositeClosure
         foundation::Arena&          arena);
 
   protected:
-    enum { MaxClosureEntries = 16 };
-
     size_t                          m_closure_count;
-    void*                           m_input_values[MaxClosureEntries];
-    ClosureID                       m_closure_types[MaxClosureEntries];
-    Spectrum                        m_weights[MaxClosureEntries];
-    float                           m_cdf[MaxClosureEntries];
-    float                           m_pdf_weights[MaxClosureEntries];
-    foundation::Basis3f             m_bases[MaxClosureEntries];
-
-    CompositeClosure();
+    size_t                          m_closure_capacity;
+    void**                          m_input_values;
+    ClosureID*                      m_closure_types;
+    Spectrum*                       m_weights;
+    float*                          m_cdf;
+    float*                          m_pdf_weights;
+    foundation::Basis3f*            m_bases;
+
+    // Allocate space for at most 'closure_capacity' closures in 'arena'.
+    CompositeClosure(
+        const size_t                closure_capacity,
+        foundation::Arena&          arena);
 
     void compute_cdf();
 
@@ -235,8 +240,8 @@ class APPLESEED_ALIGN(16) CompositeSurfaceClosure
 
   private:
     size_t                          m_ior_count;
-    float                           m_iors[MaxClosureEntries];
-    float                           m_ior_cdf[MaxClosureEntries];
+    float*                          m_iors;
+    float*                          m_ior_cdf;
 
     void process_closure_tree(
         const OSL::ClosureColor*    closure,
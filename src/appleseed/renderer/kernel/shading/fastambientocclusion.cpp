@@ -228,9 +228,9 @@ void AOVoxelTree::build(
                     const Triangle& triangle = tess->m_primitives[triangle_index];
 
                     // Retrieve object instance space vertices of the triangle.
-                    const GVector3& v0_os = tess->m_vertices[triangle.m_v0];
-                    const GVector3& v1_os = tess->m_vertices[triangle.m_v1];
-                    const GVector3& v2_os = tess->m_vertices[triangle.m_v2];
+                    const GVector3 v0_os = tess->get_vertex(triangle.m_v0);
+                    const GVector3 v1_os = tess->get_vertex(triangle.m_v1);
+                    const GVector3 v2_os = tess->get_vertex(triangle.m_v2);
 
                     // Transform triangle vertices to world space.
                     const GVector3 v0(transform.point_to_parent(v0_os));
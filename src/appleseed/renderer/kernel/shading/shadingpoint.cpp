@@ -32,10 +32,12 @@
 
 // appleseed.renderer headers.
 #include "renderer/kernel/intersection/intersector.h"
+#include "renderer/modeling/environmentedf/sphericalcoordinates.h"
 #include "renderer/modeling/input/source.h"
 #include "renderer/modeling/material/ibasismodifier.h"
 #include "renderer/modeling/object/iregion.h"
 #include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/particleobject.h"
 #include "renderer/modeling/scene/scene.h"
 #include "renderer/modeling/shadergroup/shadergroup.h"
 
@@ -167,6 +169,8 @@ void ShadingPoint::fetch_source_geometry() const
     // Fetch primitive-specific geometry.
     if (m_primitive_type == PrimitiveTriangle)
         fetch_triangle_source_geometry();
+    else if (m_primitive_type == PrimitiveParticle)
+        fetch_particle_source_geometry();
     else
     {
         assert(is_curve_primitive());
@@ -230,9 +234,9 @@ void ShadingPoint::fetch_triangle_source_geometry() const
         // Fetch vertices from previous pose.
         if (base_index == 0)
         {
-            m_v0 = tess.m_vertices[triangle.m_v0];
-            m_v1 = tess.m_vertices[triangle.m_v1];
-            m_v2 = tess.m_vertices[triangle.m_v2];
+            m_v0 = tess.get_vertex(triangle.m_v0);
+            m_v1 = tess.get_vertex(triangle.m_v1);
+            m_v2 = tess.get_vertex(triangle.m_v2);
         }
         else
         {
@@ -251,9 +255,9 @@ void ShadingPoint::fetch_triangle_source_geometry() const
     }
     else
     {
-        m_v0 = tess.m_vertices[triangle.m_v0];
-        m_v1 = tess.m_vertices[triangle.m_v1];
-        m_v2 = tess.m_vertices[triangle.m_v2];
+        m_v0 = tess.get_vertex(triangle.m_v0);
+        m_v1 = tess.get_vertex(triangle.m_v1);
+        m_v2 = tess.get_vertex(triangle.m_v2);
     }
 
     // Copy or compute triangle vertex normals (in object instance space).
@@ -266,9 +270,9 @@ void ShadingPoint::fetch_triangle_source_geometry() const
             // Fetch vertex normals from previous pose.
             if (base_index == 0)
             {
-                m_n0 = tess.m_vertex_normals[triangle.m_n0];
-                m_n1 = tess.m_vertex_normals[triangle.m_n1];
-                m_n2 = tess.m_vertex_normals[triangle.m_n2];
+                m_n0 = tess.get_vertex_normal(triangle.m_n0);
+                m_n1 = tess.get_vertex_normal(triangle.m_n1);
+                m_n2 = tess.get_vertex_normal(triangle.m_n2);
             }
             else
             {
@@ -293,9 +297,9 @@ void ShadingPoint::fetch_triangle_source_geometry() const
         }
         else
         {
-            m_n0 = tess.m_vertex_normals[triangle.m_n0];
-            m_n1 = tess.m_vertex_normals[triangle.m_n1];
-            m_n2 = tess.m_vertex_normals[triangle.m_n2];
+            m_n0 = tess.get_vertex_normal(triangle.m_n0);
+            m_n1 = tess.get_vertex_normal(triangle.m_n1);
+            m_n2 = tess.get_vertex_normal(triangle.m_n2);
         }
 
         assert(is_normalized(m_n0));
@@ -360,6 +364,25 @@ void ShadingPoint::fetch_curve_source_geometry() const
     m_primitive_pa = 0;
 }
 
+void ShadingPoint::fetch_particle_source_geometry() const
+{
+    // Particles are shaded with the first material of the object instance.
+    m_primitive_pa = 0;
+
+    // Store the object instance space center of the hit particle.
+    const ParticleObject* particles = static_cast<const ParticleObject*>(m_object);
+    m_v0 = GVector3(particles->get_particle_center(m_primitive_index));
+}
+
+Vector3d ShadingPoint::get_particle_center() const
+{
+    cache_source_geometry();
+
+    return
+        m_assembly_instance_transform.point_to_parent(
+            m_object_instance->get_transform().point_to_parent(Vector3d(m_v0)));
+}
+
 void ShadingPoint::refine_and_offset() const
 {
     assert(hit());
@@ -387,7 +410,14 @@ void ShadingPoint::refine_and_offset() const
         m_asm_geo_normal = faceforward(m_asm_geo_normal, local_ray.m_dir);
 
         // Compute the offset points in assembly instance space.
-#ifdef RENDERER_ADAPTIVE_OFFSET
+#if defined APPLESEED_USE_SINGLE_PRECISION_TRIANGLES
+        Intersector::error_bounded_offset(
+            m_triangle_support_plane,
+            local_ray.m_org,
+            m_asm_geo_normal,
+            m_front_point,
+            m_back_point);
+#elif defined RENDERER_ADAPTIVE_OFFSET
         Intersector::adaptive_offset(
             m_triangle_support_plane,
             local_ray.m_org,
@@ -402,6 +432,23 @@ void ShadingPoint::refine_and_offset() const
             m_back_point);
 #endif
     }
+    else if (m_primitive_type == PrimitiveParticle)
+    {
+        // Offset along the normal of spheres; disks always face the incoming ray.
+        const ParticleObject* particles = static_cast<const ParticleObject*>(m_object);
+        if (particles->get_shape() == ParticleObject::ShapeSphere)
+        {
+            const Vector3d center = m_object_instance->get_transform().point_to_parent(Vector3d(m_v0));
+            m_asm_geo_normal = faceforward(normalize(local_ray.m_org - center), local_ray.m_dir);
+        }
+        else m_asm_geo_normal = normalize(-local_ray.m_dir);
+
+        Intersector::fixed_offset(
+            local_ray.m_org,
+            m_asm_geo_normal,
+            m_front_point,
+            m_back_point);
+    }
     else
     {
         assert(is_curve_primitive());
@@ -466,7 +513,7 @@ Vector3d ShadingPoint::get_biased_point(const Vector3d& direction) const
     return m_biased_point;
 }
 
-void ShadingPoint::compute_world_space_partial_derivatives() const
+void ShadingPoint::compute_world_space_point_partial_derivatives() const
 {
     cache_source_geometry();
 
@@ -490,7 +537,6 @@ void ShadingPoint::compute_world_space_partial_derivatives() const
 
             m_dpdu = basis.get_tangent_u();
             m_dpdv = basis.get_tangent_v();
-            m_dndu = m_dndv = Vector3d(0.0);
         }
         else
         {
@@ -502,33 +548,15 @@ void ShadingPoint::compute_world_space_partial_derivatives() const
 
             m_dpdu = (dv1 * dp0 - dv0 * dp1) * rcp_det;
             m_dpdv = (du0 * dp1 - du1 * dp0) * rcp_det;
-
-            if (m_members & HasTriangleVertexNormals)
-            {
-                const Vector3d dn0(m_n0 - m_n2);
-                const Vector3d dn1(m_n1 - m_n2);
-
-                m_dndu = (dv1 * dn0 - dv0 * dn1) * rcp_det;
-                m_dndv = (du0 * dn1 - du1 * dn0) * rcp_det;
-
-                // Transform the normal derivatives to world space.
-                const Transformd& obj_instance_transform =
-                    m_object_instance->get_transform();
-
-                m_dndu =
-                    m_assembly_instance_transform.normal_to_parent(
-                        obj_instance_transform.normal_to_parent(m_dndu));
-
-                m_dndv =
-                    m_assembly_instance_transform.normal_to_parent(
-                        obj_instance_transform.normal_to_parent(m_dndv));
-            }
-            else
-            {
-                m_dndu = m_dndv = Vector3d(0.0);
-            }
         }
     }
+    else if (m_primitive_type == PrimitiveParticle)
+    {
+        const Basis3d basis(get_original_shading_normal());
+
+        m_dpdu = basis.get_tangent_u();
+        m_dpdv = basis.get_tangent_v();
+    }
     else
     {
         assert(is_curve_primitive());
@@ -545,8 +573,57 @@ void ShadingPoint::compute_world_space_partial_derivatives() const
 
         m_dpdu = normalize(Vector3d(tangent));
         m_dpdv = normalize(cross(sn, m_dpdu));
+    }
+}
+
+void ShadingPoint::compute_world_space_normal_partial_derivatives() const
+{
+    cache_source_geometry();
+
+    // Only triangles with per-vertex normals have a varying normal.
+    if (m_primitive_type != PrimitiveTriangle || !(m_members & HasTriangleVertexNormals))
+    {
         m_dndu = m_dndv = Vector3d(0.0);
+        return;
     }
+
+    //
+    // Reference:
+    //
+    //   Physically Based Rendering, first edition, pp. 128-129
+    //
+
+    const double du0 = static_cast<double>(m_v0_uv[0] - m_v2_uv[0]);
+    const double dv0 = static_cast<double>(m_v0_uv[1] - m_v2_uv[1]);
+    const double du1 = static_cast<double>(m_v1_uv[0] - m_v2_uv[0]);
+    const double dv1 = static_cast<double>(m_v1_uv[1] - m_v2_uv[1]);
+    const double det = du0 * dv1 - dv0 * du1;
+
+    if (det == 0.0)
+    {
+        m_dndu = m_dndv = Vector3d(0.0);
+        return;
+    }
+
+    const double rcp_det = 1.0 / det;
+
+    const Vector3d dn0(m_n0 - m_n2);
+    const Vector3d dn1(m_n1 - m_n2);
+
+    m_dndu = (dv1 * dn0 - dv0 * dn1) * rcp_det;
+    m_dndv = (du0 * dn1 - du1 * dn0) * rcp_det;
+
+    // Transform the normal derivatives to world space.
+    const Transformd& obj_instance_transform =
+        m_object_instance->get_transform();
+
+    m_dndu =
+        m_assembly_instance_transform.normal_to_parent(
+            obj_instance_transform.normal_to_parent(m_dndu));
+
+    m_dndv =
+        m_assembly_instance_transform.normal_to_parent(
+            obj_instance_transform.normal_to_parent(m_dndv));
 }
 
 void ShadingPoint::compute_screen_space_partial_derivatives() const
@@ -672,6 +749,29 @@ void ShadingPoint::compute_geometric_normal() const
                 m_geometric_normal = -m_geometric_normal;
         }
     }
+    else if (m_primitive_type == PrimitiveParticle)
+    {
+        cache_source_geometry();
+
+        const ParticleObject* particles = static_cast<const ParticleObject*>(m_object);
+        if (particles->get_shape() == ParticleObject::ShapeSphere)
+        {
+            // Spheres are closed: rays starting inside them hit the back side.
+            m_geometric_normal = normalize(get_point() - get_particle_center());
+            m_side =
+                dot(m_ray.m_dir, m_geometric_normal) > 0.0
+                    ? ObjectInstance::BackSide
+                    : ObjectInstance::FrontSide;
+            if (m_side == ObjectInstance::BackSide)
+                m_geometric_normal = -m_geometric_normal;
+        }
+        else
+        {
+            // Disks face incoming rays.
+            m_geometric_normal = -m_ray.m_dir;
+            m_side = ObjectInstance::FrontSide;
+        }
+    }
     else
     {
         assert(is_curve_primitive());
@@ -710,6 +810,16 @@ void ShadingPoint::compute_original_shading_normal() const
             m_original_shading_normal = get_geometric_normal();
         }
     }
+    else if (m_primitive_type == PrimitiveParticle)
+    {
+        cache_source_geometry();
+
+        const ParticleObject* particles = static_cast<const ParticleObject*>(m_object);
+        m_original_shading_normal =
+            particles->get_shape() == ParticleObject::ShapeSphere
+                ? normalize(get_point() - get_particle_center())
+                : -m_ray.m_dir;
+    }
     else
     {
         assert(is_curve_primitive());
@@ -812,9 +922,9 @@ void ShadingPoint::compute_world_space_point_velocity() const
         if (motion_segment_count > 0)
         {
             // Fetch triangle vertices from the first pose.
-            const GVector3& first_v0 = tess.m_vertices[triangle.m_v0];
-            const GVector3& first_v1 = tess.m_vertices[triangle.m_v1];
-            const GVector3& first_v2 = tess.m_vertices[triangle.m_v2];
+            const GVector3 first_v0 = tess.get_vertex(triangle.m_v0);
+            const GVector3 first_v1 = tess.get_vertex(triangle.m_v1);
+            const GVector3 first_v2 = tess.get_vertex(triangle.m_v2);
 
             // Fetch triangle vertices from the last pose.
             const GVector3 last_v0 = tess.get_vertex_pose(triangle.m_v0, motion_segment_count - 1);
@@ -864,6 +974,28 @@ void ShadingPoint::compute_world_space_point_velocity() const
     m_point_velocity = p1 - p0;
 }
 
+void ShadingPoint::compute_particle_uv() const
+{
+    // Express the direction from the particle center to the hit point in object instance space.
+    Vector3d d = get_point() - get_particle_center();
+    d = m_assembly_instance_transform.vector_to_local(d);
+    d = m_object_instance->get_transform().vector_to_local(d);
+
+    const double n = norm(d);
+    if (n == 0.0)
+    {
+        m_uv = Vector2f(0.0f);
+        return;
+    }
+
+    // Map the direction to the unit square through spherical coordinates.
+    double theta, phi, u, v;
+    unit_vector_to_angles(d / n, theta, phi);
+    angles_to_unit_square(theta, phi, u, v);
+    m_uv[0] = static_cast<float>(u);
+    m_uv[1] = static_cast<float>(v);
+}
+
 void ShadingPoint::compute_alpha() const
 {
     m_alpha.set(1.0f);
@@ -890,7 +1022,7 @@ void ShadingPoint::compute_alpha() const
     }
     else
     {
-        assert(is_curve_primitive());
+        assert(is_curve_primitive() || is_particle_primitive());
 
         // todo: interpolate per vertex alpha for curves here...
     }
@@ -37,6 +37,7 @@
 #include "renderer/kernel/tessellation/statictessellation.h"
 #include "renderer/modeling/material/material.h"
 #include "renderer/modeling/object/curveobject.h"
+#include "renderer/modeling/object/particleobject.h"
 #include "renderer/modeling/object/regionkit.h"
 #include "renderer/modeling/object/triangle.h"
 #include "renderer/modeling/scene/assembly.h"
@@ -90,7 +91,8 @@ class ShadingPoint
         PrimitiveTriangle   = 1 << 1,
         PrimitiveCurve      = 1 << 2,
         PrimitiveCurve1     = PrimitiveCurve | 0,
-        PrimitiveCurve3     = PrimitiveCurve | 1
+        PrimitiveCurve3     = PrimitiveCurve | 1,
+        PrimitiveParticle   = 1 << 3
     };
 
     // Constructor, calls clear().
@@ -122,6 +124,7 @@ class ShadingPoint
     PrimitiveType get_primitive_type() const;
     bool is_triangle_primitive() const;
     bool is_curve_primitive() const;
+    bool is_particle_primitive() const;
 
     // Return the distance from the ray origin to the intersection point.
     double get_distance() const;
@@ -262,6 +265,8 @@ class ShadingPoint
     friend class CurveLeafVisitor;
     friend class Intersector;
     friend class OSLShaderGroupExec;
+    friend class ParticleLeafVisitor;
+    friend class PrimaryHitCache;
     friend class RegionLeafVisitor;
     friend class RendererServices;
     friend class ShadingPointBuilder;
@@ -289,54 +294,49 @@ class ShadingPoint
     // Flags to keep track of which on-demand results have been computed and cached.
     enum Members
     {
-        HasSourceGeometry                = 1 << 0,
-        HasTriangleVertexNormals         = 1 << 1,
-        HasTriangleVertexTangents        = 1 << 2,
-        HasUV0                           = 1 << 3,
-        HasPoint                         = 1 << 4,
-        HasBiasedPoint                   = 1 << 5,
-        HasRefinedPoints                 = 1 << 6,
-        HasWorldSpacePartialDerivatives  = 1 << 7,
-        HasGeometricNormal               = 1 << 8,
-        HasOriginalShadingNormal         = 1 << 9,
-        HasShadingBasis                  = 1 << 10,
-        HasWorldSpaceTriangleVertices    = 1 << 11,
-        HasMaterials                     = 1 << 12,
-        HasWorldSpacePointVelocity       = 1 << 13,
-        HasAlpha                         = 1 << 14,
-        HasScreenSpacePartialDerivatives = 1 << 15,
-        HasOSLShaderGlobals              = 1 << 16
+        HasSourceGeometry                       = 1 << 0,
+        HasTriangleVertexNormals                = 1 << 1,
+        HasTriangleVertexTangents               = 1 << 2,
+        HasUV0                                  = 1 << 3,
+        HasPoint                                = 1 << 4,
+        HasBiasedPoint                          = 1 << 5,
+        HasRefinedPoints                        = 1 << 6,
+        HasWorldSpacePointPartialDerivatives    = 1 << 7,
+        HasGeometricNormal                      = 1 << 8,
+        HasOriginalShadingNormal                = 1 << 9,
+        HasShadingBasis                         = 1 << 10,
+        HasWorldSpaceTriangleVertices           = 1 << 11,
+        HasMaterials                            = 1 << 12,
+        HasWorldSpacePointVelocity              = 1 << 13,
+        HasAlpha                                = 1 << 14,
+        HasScreenSpacePartialDerivatives        = 1 << 15,
+        HasOSLShaderGlobals                     = 1 << 16,
+        HasWorldSpaceNormalPartialDerivatives   = 1 << 17
     };
     mutable foundation::uint32          m_members;
 
+    //
+    // The members below are ordered by frequency of use: results needed to shade
+    // or offset almost every hit come first, while results only needed by texturing,
+    // bump mapping, motion blur or OSL come last, so that queries that only need hit
+    // information (distance, point, normals, materials) touch as few cache lines as possible.
+    //
+
     // Source geometry (derived from primary intersection results).
     mutable const Assembly*             m_assembly;                     // hit assembly
     mutable const ObjectInstance*       m_object_instance;              // hit object instance
     mutable Object*                     m_object;                       // hit object
     mutable foundation::uint32          m_primitive_pa;                 // hit primitive attribute index
-    mutable GVector2                    m_v0_uv, m_v1_uv, m_v2_uv;      // texture coordinates from UV set #0 at triangle vertices
     mutable GVector3                    m_v0, m_v1, m_v2;               // object instance space triangle vertices
     mutable GVector3                    m_n0, m_n1, m_n2;               // object instance space triangle vertex normals
-    mutable GVector3                    m_t0, m_t1, m_t2;               // object instance space triangle vertex tangents
 
-    // On-demand intersection results (derived from primary intersection results).
-    mutable foundation::Vector2f        m_uv;                           // texture coordinates from UV set #0
-    mutable foundation::Vector2f        m_duvdx;                        // screen space partial derivative of the texture coords wrt. X
-    mutable foundation::Vector2f        m_duvdy;                        // screen space partial derivative of the texture coords wrt. Y
+    // Frequently used on-demand intersection results (derived from primary intersection results).
     mutable foundation::Vector3d        m_point;                        // world space intersection point
     mutable foundation::Vector3d        m_biased_point;                 // world space intersection point with per-object-instance bias applied
-    mutable foundation::Vector3d        m_dpdu;                         // world space partial derivative of the intersection point wrt. U
-    mutable foundation::Vector3d        m_dpdv;                         // world space partial derivative of the intersection point wrt. V
-    mutable foundation::Vector3d        m_dndu;                         // world space partial derivative of the intersection normal wrt. U
-    mutable foundation::Vector3d        m_dndv;                         // world space partial derivative of the intersection normal wrt. V
-    mutable foundation::Vector3d        m_dpdx;                         // screen space partial derivative of the intersection point wrt. X
-    mutable foundation::Vector3d        m_dpdy;                         // screen space partial derivative of the intersection point wrt. Y
     mutable foundation::Vector3d        m_geometric_normal;             // world space geometric normal, unit-length
     mutable foundation::Vector3d        m_original_shading_normal;      // original world space shading normal, unit-length
     mutable foundation::Basis3d         m_shading_basis;                // world space orthonormal basis around shading normal
     mutable ObjectInstance::Side        m_side;                         // side of the surface that was hit
-    mutable foundation::Vector3d        m_v0_w, m_v1_w, m_v2_w;         // world space triangle vertices
-    mutable foundation::Vector3d        m_point_velocity;               // world space point velocity
     mutable const Material*             m_material;                     // material at intersection point
     mutable const Material*             m_opposite_material;            // opposite material at intersection point
     mutable Alpha                       m_alpha;                        // opacity at intersection point
@@ -347,6 +347,23 @@ class ShadingPoint
     mutable foundation::Vector3d        m_front_point;                  // hit point refined to front, in assembly instance space
     mutable foundation::Vector3d        m_back_point;                   // hit point refined to back, in assembly instance space
 
+    // Less frequently used source geometry.
+    mutable GVector2                    m_v0_uv, m_v1_uv, m_v2_uv;      // texture coordinates from UV set #0 at triangle vertices
+    mutable GVector3                    m_t0, m_t1, m_t2;               // object instance space triangle vertex tangents
+
+    // Less frequently used on-demand intersection results.
+    mutable foundation::Vector2f        m_uv;                           // texture coordinates from UV set #0
+    mutable foundation::Vector2f        m_duvdx;                        // screen space partial derivative of the texture coords wrt. X
+    mutable foundation::Vector2f        m_duvdy;                        // screen space partial derivative of the texture coords wrt. Y
+    mutable foundation::Vector3d        m_dpdu;                         // world space partial derivative of the intersection point wrt. U
+    mutable foundation::Vector3d        m_dpdv;                         // world space partial derivative of the intersection point wrt. V
+    mutable foundation::Vector3d        m_dndu;                         // world space partial derivative of the intersection normal wrt. U
+    mutable foundation::Vector3d        m_dndv;                         // world space partial derivative of the intersection normal wrt. V
+    mutable foundation::Vector3d        m_dpdx;                         // screen space partial derivative of the intersection point wrt. X
+    mutable foundation::Vector3d        m_dpdy;                         // screen space partial derivative of the intersection point wrt. Y
+    mutable foundation::Vector3d        m_v0_w, m_v1_w, m_v2_w;         // world space triangle vertices
+    mutable foundation::Vector3d        m_point_velocity;               // world space point velocity
+
     // OSl-related data.
     mutable OSLObjectTransformInfo      m_obj_transform_info;
     mutable OSLTraceData                m_osl_trace_data;
@@ -361,11 +378,16 @@ class ShadingPoint
     void fetch_source_geometry() const;
     void fetch_triangle_source_geometry() const;
     void fetch_curve_source_geometry() const;
+    void fetch_particle_source_geometry() const;
+
+    // Return the world space center of the hit particle.
+    foundation::Vector3d get_particle_center() const;
 
     // Refine and offset the intersection point.
     void refine_and_offset() const;
 
-    void compute_world_space_partial_derivatives() const;
+    void compute_world_space_point_partial_derivatives() const;
+    void compute_world_space_normal_partial_derivatives() const;
     void compute_screen_space_partial_derivatives() const;
     void compute_geometric_normal() const;
     void compute_shading_normal() const;
@@ -373,6 +395,7 @@ class ShadingPoint
     void compute_shading_basis() const;
     void compute_world_space_triangle_vertices() const;
     void compute_world_space_point_velocity() const;
+    void compute_particle_uv() const;
 
     void compute_alpha() const;
 
@@ -489,6 +512,11 @@ inline bool ShadingPoint::is_curve_primitive() const
     return (m_primitive_type & PrimitiveCurve) != 0;
 }
 
+inline bool ShadingPoint::is_particle_primitive() const
+{
+    return m_primitive_type == PrimitiveParticle;
+}
+
 inline double ShadingPoint::get_distance() const
 {
     assert(hit());
@@ -518,6 +546,11 @@ inline const foundation::Vector2f& ShadingPoint::get_uv(const size_t uvset) cons
                 + m_v1_uv * m_bary[0]
                 + m_v2_uv * m_bary[1];
         }
+        else if (m_primitive_type == PrimitiveParticle)
+        {
+            // Spherical coordinates around the particle center.
+            compute_particle_uv();
+        }
         else
         {
             assert(is_curve_primitive());
@@ -588,10 +621,10 @@ inline const foundation::Vector3d& ShadingPoint::get_dpdu(const size_t uvset) co
     assert(hit());
     assert(uvset == 0);     // todo: support multiple UV sets
 
-    if (!(m_members & HasWorldSpacePartialDerivatives))
+    if (!(m_members & HasWorldSpacePointPartialDerivatives))
     {
-        compute_world_space_partial_derivatives();
-        m_members |= HasWorldSpacePartialDerivatives;
+        compute_world_space_point_partial_derivatives();
+        m_members |= HasWorldSpacePointPartialDerivatives;
     }
 
     return m_dpdu;
@@ -602,10 +635,10 @@ inline const foundation::Vector3d& ShadingPoint::get_dpdv(const size_t uvset) co
     assert(hit());
     assert(uvset == 0);     // todo: support multiple UV sets
 
-    if (!(m_members & HasWorldSpacePartialDerivatives))
+    if (!(m_members & HasWorldSpacePointPartialDerivatives))
     {
-        compute_world_space_partial_derivatives();
-        m_members |= HasWorldSpacePartialDerivatives;
+        compute_world_space_point_partial_derivatives();
+        m_members |= HasWorldSpacePointPartialDerivatives;
     }
 
     return m_dpdv;
@@ -616,10 +649,10 @@ inline const foundation::Vector3d& ShadingPoint::get_dndu(const size_t uvset) co
     assert(hit());
     assert(uvset == 0);     // todo: support multiple UV sets
 
-    if (!(m_members & HasWorldSpacePartialDerivatives))
+    if (!(m_members & HasWorldSpaceNormalPartialDerivatives))
     {
-        compute_world_space_partial_derivatives();
-        m_members |= HasWorldSpacePartialDerivatives;
+        compute_world_space_normal_partial_derivatives();
+        m_members |= HasWorldSpaceNormalPartialDerivatives;
     }
 
     return m_dndu;
@@ -630,10 +663,10 @@ inline const foundation::Vector3d& ShadingPoint::get_dndv(const size_t uvset) co
     assert(hit());
     assert(uvset == 0);     // todo: support multiple UV sets
 
-    if (!(m_members & HasWorldSpacePartialDerivatives))
+    if (!(m_members & HasWorldSpaceNormalPartialDerivatives))
     {
-        compute_world_space_partial_derivatives();
-        m_members |= HasWorldSpacePartialDerivatives;
+        compute_world_space_normal_partial_derivatives();
+        m_members |= HasWorldSpaceNormalPartialDerivatives;
     }
 
     return m_dndv;
@@ -36,14 +36,23 @@
 
 // appleseed.foundation headers.
 #include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/aabb.h"
+#include "foundation/math/octahedral.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/attributeset.h"
 #include "foundation/utility/lazy.h"
+#include "foundation/utility/memory.h"
+#include "foundation/utility/memorytracker.h"
 #include "foundation/utility/numerictype.h"
 #include "foundation/utility/poolallocator.h"
+#include "foundation/utility/siphash.h"
 
 // Standard headers.
 #include <cassert>
 #include <cstddef>
+#include <cstring>
 #include <vector>
 
 namespace renderer
@@ -83,6 +92,19 @@ class StaticTessellation
     // Constructor.
     StaticTessellation();
 
+    // Access vertices and vertex normals, whether or not they are stored in compact form.
+    size_t get_vertex_count() const;
+    GVector3 get_vertex(const size_t index) const;
+    size_t get_vertex_normal_count() const;
+    GVector3 get_vertex_normal(const size_t index) const;
+
+    // Replace vertices, vertex normals, texture coordinates and their poses by lossy, compact
+    // representations: positions and texture coordinates are quantized to 16 bits per component
+    // within their bounding box, and normals are octahedral-encoded on 32 bits. Once compacted,
+    // these features can still be accessed but can no longer be inserted or modified.
+    void compact_vertex_attributes();
+    bool has_compact_vertex_attributes() const;
+
     // Insert and access texture coordinates.
     void reserve_tex_coords(const size_t count);
     size_t push_tex_coords(const GVector2& uv);
@@ -144,6 +166,22 @@ class StaticTessellation
     // Compute the local space bounding box of the tessellation over the shutter interval.
     GAABB3 compute_local_bbox() const;
 
+    // Compute a hash of the content of the tessellation.
+    foundation::uint64 compute_hash() const;
+
+    // Return true if this tessellation has the same content as another one.
+    bool is_equal(const StaticTessellation& rhs) const;
+
+    // Return the amount of memory used by the tessellation, in bytes.
+    size_t get_memory_size() const;
+
+    // Record the current amount of memory used by the tessellation in the global memory tracker.
+    void track_memory_size();
+
+    // Ask for the vertex and primitive arrays to be backed by large pages.
+    // Return the number of large pages covered by the request.
+    size_t advise_large_pages() const;
+
   private:
     foundation::AttributeSet::ChannelID m_uv_0_cid;         // UV coordinates set #0
     foundation::AttributeSet::ChannelID m_tangents_cid;     // per-vertex tangent vectors
@@ -152,8 +190,53 @@ class StaticTessellation
     foundation::AttributeSet::ChannelID m_vnp_cid;          // vertex normal poses
     foundation::AttributeSet::ChannelID m_vtp_cid;          // vertex tangent poses
 
+    // Compact vertex attributes.
+    bool                                m_compact;
+    GVector3                            m_vertex_origin;
+    GVector3                            m_vertex_scale;
+    GVector2                            m_tex_coords_origin;
+    GVector2                            m_tex_coords_scale;
+    std::vector<foundation::uint16>     m_compact_vertices;             // 3 components per vertex
+    std::vector<foundation::uint16>     m_compact_vertex_poses;         // 3 components per vertex and motion segment
+    std::vector<foundation::uint32>     m_compact_vertex_normals;
+    std::vector<foundation::uint32>     m_compact_vertex_normal_poses;
+    std::vector<foundation::uint16>     m_compact_tex_coords;           // 2 components per texture coordinates
+
+    foundation::TrackedMemorySize       m_tracked_memory_size;
+
     void create_uv_0_attribute();
     void create_tangents_attribute();
+
+    // Delete a channel of the vertex attributes, and shift the identifiers of the channels that follow it.
+    void delete_vertex_attributes_channel(foundation::AttributeSet::ChannelID& channel_id);
+
+    template <typename T>
+    static foundation::uint64 hash_vector(const foundation::uint64 hash, const std::vector<T>& vec);
+
+    template <typename T>
+    static bool equal_vectors(const std::vector<T>& lhs, const std::vector<T>& rhs);
+
+    template <typename T>
+    static size_t vector_memory_size(const std::vector<T>& vec);
+
+    template <size_t N>
+    static void compute_quantization(
+        const foundation::AABB<GScalar, N>&     bbox,
+        foundation::Vector<GScalar, N>&         origin,
+        foundation::Vector<GScalar, N>&         scale);
+
+    template <size_t N>
+    static void quantize(
+        const foundation::Vector<GScalar, N>&   v,
+        const foundation::Vector<GScalar, N>&   origin,
+        const foundation::Vector<GScalar, N>&   scale,
+        std::vector<foundation::uint16>&        output);
+
+    template <size_t N>
+    static foundation::Vector<GScalar, N> dequantize(
+        const foundation::uint16                q[],
+        const foundation::Vector<GScalar, N>&   origin,
+        const foundation::Vector<GScalar, N>&   scale);
 };
 
 // Specialization of the StaticTessellation class for triangles.
@@ -184,12 +267,138 @@ inline StaticTessellation<Primitive>::StaticTessellation()
   , m_vp_cid(foundation::AttributeSet::InvalidChannelID)
   , m_vnp_cid(foundation::AttributeSet::InvalidChannelID)
   , m_vtp_cid(foundation::AttributeSet::InvalidChannelID)
+  , m_compact(false)
+  , m_tracked_memory_size(foundation::MemoryTracker::Tessellations)
+{
+}
+
+template <typename Primitive>
+inline size_t StaticTessellation<Primitive>::get_vertex_count() const
 {
+    return m_compact ? m_compact_vertices.size() / 3 : m_vertices.size();
+}
+
+template <typename Primitive>
+inline GVector3 StaticTessellation<Primitive>::get_vertex(const size_t index) const
+{
+    assert(index < get_vertex_count());
+
+    return
+        m_compact
+            ? dequantize(&m_compact_vertices[index * 3], m_vertex_origin, m_vertex_scale)
+            : m_vertices[index];
+}
+
+template <typename Primitive>
+inline size_t StaticTessellation<Primitive>::get_vertex_normal_count() const
+{
+    return m_compact ? m_compact_vertex_normals.size() : m_vertex_normals.size();
+}
+
+template <typename Primitive>
+inline GVector3 StaticTessellation<Primitive>::get_vertex_normal(const size_t index) const
+{
+    assert(index < get_vertex_normal_count());
+
+    return
+        m_compact
+            ? foundation::octahedral_decode<GScalar>(m_compact_vertex_normals[index])
+            : m_vertex_normals[index];
+}
+
+template <typename Primitive>
+void StaticTessellation<Primitive>::compact_vertex_attributes()
+{
+    if (m_compact)
+        return;
+
+    const size_t vertex_count = m_vertices.size();
+    const size_t normal_count = m_vertex_normals.size();
+    const size_t tex_coords_count = get_tex_coords_count();
+    const size_t motion_segment_count = get_motion_segment_count();
+    const bool has_vertex_poses = m_vp_cid != foundation::AttributeSet::InvalidChannelID;
+    const bool has_vertex_normal_poses = m_vnp_cid != foundation::AttributeSet::InvalidChannelID;
+
+    // Quantize vertices and vertex poses within the local bounding box of the tessellation.
+    compute_quantization(compute_local_bbox(), m_vertex_origin, m_vertex_scale);
+
+    m_compact_vertices.reserve(vertex_count * 3);
+    for (size_t i = 0; i < vertex_count; ++i)
+        quantize(m_vertices[i], m_vertex_origin, m_vertex_scale, m_compact_vertices);
+
+    if (has_vertex_poses)
+    {
+        m_compact_vertex_poses.reserve(vertex_count * motion_segment_count * 3);
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            for (size_t j = 0; j < motion_segment_count; ++j)
+                quantize(get_vertex_pose(i, j), m_vertex_origin, m_vertex_scale, m_compact_vertex_poses);
+        }
+    }
+
+    // Encode vertex normals and vertex normal poses.
+    m_compact_vertex_normals.reserve(normal_count);
+    for (size_t i = 0; i < normal_count; ++i)
+        m_compact_vertex_normals.push_back(foundation::octahedral_encode(m_vertex_normals[i]));
+
+    if (has_vertex_normal_poses)
+    {
+        m_compact_vertex_normal_poses.reserve(normal_count * motion_segment_count);
+        for (size_t i = 0; i < normal_count; ++i)
+        {
+            for (size_t j = 0; j < motion_segment_count; ++j)
+            {
+                m_compact_vertex_normal_poses.push_back(
+                    foundation::octahedral_encode(get_vertex_normal_pose(i, j)));
+            }
+        }
+    }
+
+    // Quantize texture coordinates within their bounding box.
+    if (tex_coords_count > 0)
+    {
+        foundation::AABB<GScalar, 2> tex_coords_bbox;
+        tex_coords_bbox.invalidate();
+
+        for (size_t i = 0; i < tex_coords_count; ++i)
+            tex_coords_bbox.insert(get_tex_coords(i));
+
+        compute_quantization(tex_coords_bbox, m_tex_coords_origin, m_tex_coords_scale);
+
+        m_compact_tex_coords.reserve(tex_coords_count * 2);
+        for (size_t i = 0; i < tex_coords_count; ++i)
+            quantize(get_tex_coords(i), m_tex_coords_origin, m_tex_coords_scale, m_compact_tex_coords);
+
+        delete_vertex_attributes_channel(m_uv_0_cid);
+    }
+
+    // Release the full-precision features.
+    if (has_vertex_poses)
+        delete_vertex_attributes_channel(m_vp_cid);
+
+    if (has_vertex_normal_poses)
+    {
+        m_vertex_normal_attributes.delete_channel(m_vnp_cid);
+        m_vnp_cid = foundation::AttributeSet::InvalidChannelID;
+    }
+
+    foundation::clear_release_memory(m_vertices);
+    foundation::clear_release_memory(m_vertex_normals);
+
+    m_compact = true;
+}
+
+template <typename Primitive>
+inline bool StaticTessellation<Primitive>::has_compact_vertex_attributes() const
+{
+    return m_compact;
 }
 
 template <typename Primitive>
 inline void StaticTessellation<Primitive>::reserve_tex_coords(const size_t count)
 {
+    assert(!m_compact);
+
     if (m_uv_0_cid == foundation::AttributeSet::InvalidChannelID)
         create_uv_0_attribute();
 
@@ -199,6 +408,8 @@ inline void StaticTessellation<Primitive>::reserve_tex_coords(const size_t count
 template <typename Primitive>
 inline size_t StaticTessellation<Primitive>::push_tex_coords(const GVector2& uv)
 {
+    assert(!m_compact);
+
     if (m_uv_0_cid == foundation::AttributeSet::InvalidChannelID)
         create_uv_0_attribute();
 
@@ -208,6 +419,9 @@ inline size_t StaticTessellation<Primitive>::push_tex_coords(const GVector2& uv)
 template <typename Primitive>
 inline size_t StaticTessellation<Primitive>::get_tex_coords_count() const
 {
+    if (m_compact)
+        return m_compact_tex_coords.size() / 2;
+
     if (m_uv_0_cid == foundation::AttributeSet::InvalidChannelID)
         return 0;
 
@@ -217,6 +431,12 @@ inline size_t StaticTessellation<Primitive>::get_tex_coords_count() const
 template <typename Primitive>
 inline GVector2 StaticTessellation<Primitive>::get_tex_coords(const size_t index) const
 {
+    if (m_compact)
+    {
+        assert(index < m_compact_tex_coords.size() / 2);
+        return dequantize(&m_compact_tex_coords[index * 2], m_tex_coords_origin, m_tex_coords_scale);
+    }
+
     assert(m_uv_0_cid != foundation::AttributeSet::InvalidChannelID);
 
     GVector2 uv;
@@ -296,6 +516,7 @@ inline void StaticTessellation<Primitive>::set_vertex_pose(
     const size_t    motion_segment_index,
     const GVector3& vertex)
 {
+    assert(!m_compact);
     assert(vertex_index < m_vertices.size());
 
     const size_t motion_segment_count = get_motion_segment_count();
@@ -321,12 +542,23 @@ inline GVector3 StaticTessellation<Primitive>::get_vertex_pose(
     const size_t    vertex_index,
     const size_t    motion_segment_index) const
 {
-    assert(m_vp_cid != foundation::AttributeSet::InvalidChannelID);
-    assert(vertex_index < m_vertices.size());
+    assert(vertex_index < get_vertex_count());
 
     const size_t motion_segment_count = get_motion_segment_count();
     assert(motion_segment_index < motion_segment_count);
 
+    if (m_compact)
+    {
+        assert(!m_compact_vertex_poses.empty());
+        return
+            dequantize(
+                &m_compact_vertex_poses[(vertex_index * motion_segment_count + motion_segment_index) * 3],
+                m_vertex_origin,
+                m_vertex_scale);
+    }
+
+    assert(m_vp_cid != foundation::AttributeSet::InvalidChannelID);
+
     GVector3 vertex;
     m_vertex_attributes.get_attribute(
         m_vp_cid,
@@ -339,11 +571,10 @@ inline GVector3 StaticTessellation<Primitive>::get_vertex_pose(
 template <typename Primitive>
 void StaticTessellation<Primitive>::clear_vertex_poses()
 {
+    foundation::clear_release_memory(m_compact_vertex_poses);
+
     if (m_vp_cid != foundation::AttributeSet::InvalidChannelID)
-    {
-        m_vertex_attributes.delete_channel(m_vp_cid);
-        m_vp_cid = foundation::AttributeSet::InvalidChannelID;
-    }
+        delete_vertex_attributes_channel(m_vp_cid);
 }
 
 template <typename Primitive>
@@ -352,6 +583,7 @@ inline void StaticTessellation<Primitive>::set_vertex_normal_pose(
     const size_t    motion_segment_index,
     const GVector3& normal)
 {
+    assert(!m_compact);
     assert(normal_index < m_vertex_normals.size());
 
     const size_t motion_segment_count = get_motion_segment_count();
@@ -377,12 +609,21 @@ inline GVector3 StaticTessellation<Primitive>::get_vertex_normal_pose(
     const size_t    normal_index,
     const size_t    motion_segment_index) const
 {
-    assert(m_vnp_cid != foundation::AttributeSet::InvalidChannelID);
-    assert(normal_index < m_vertex_normals.size());
+    assert(normal_index < get_vertex_normal_count());
 
     const size_t motion_segment_count = get_motion_segment_count();
     assert(motion_segment_index < motion_segment_count);
 
+    if (m_compact)
+    {
+        assert(!m_compact_vertex_normal_poses.empty());
+        return
+            foundation::octahedral_decode<GScalar>(
+                m_compact_vertex_normal_poses[normal_index * motion_segment_count + motion_segment_index]);
+    }
+
+    assert(m_vnp_cid != foundation::AttributeSet::InvalidChannelID);
+
     GVector3 normal;
     m_vertex_normal_attributes.get_attribute(
         m_vnp_cid,
@@ -395,6 +636,8 @@ inline GVector3 StaticTessellation<Primitive>::get_vertex_normal_pose(
 template <typename Primitive>
 void StaticTessellation<Primitive>::clear_vertex_normal_poses()
 {
+    foundation::clear_release_memory(m_compact_vertex_normal_poses);
+
     if (m_vnp_cid != foundation::AttributeSet::InvalidChannelID)
     {
         m_vertex_normal_attributes.delete_channel(m_vnp_cid);
@@ -434,7 +677,7 @@ inline GVector3 StaticTessellation<Primitive>::get_vertex_tangent_pose(
     const size_t    motion_segment_index) const
 {
     assert(m_vtp_cid != foundation::AttributeSet::InvalidChannelID);
-    assert(tangent_index < m_vertex_normals.size());
+    assert(tangent_index < get_vertex_tangent_count());
 
     const size_t motion_segment_count = get_motion_segment_count();
     assert(motion_segment_index < motion_segment_count);
@@ -464,12 +707,12 @@ GAABB3 StaticTessellation<Primitive>::compute_local_bbox() const
     GAABB3 bbox;
     bbox.invalidate();
 
-    const size_t vertex_count = m_vertices.size();
+    const size_t vertex_count = get_vertex_count();
     const size_t motion_segment_count = get_motion_segment_count();
 
     for (size_t i = 0; i < vertex_count; ++i)
     {
-        bbox.insert(m_vertices[i]);
+        bbox.insert(get_vertex(i));
 
         for (size_t j = 0; j < motion_segment_count; ++j)
             bbox.insert(get_vertex_pose(i, j));
@@ -478,6 +721,95 @@ GAABB3 StaticTessellation<Primitive>::compute_local_bbox() const
     return bbox;
 }
 
+template <typename Primitive>
+foundation::uint64 StaticTessellation<Primitive>::compute_hash() const
+{
+    foundation::uint64 hash = foundation::siphash24(static_cast<foundation::uint64>(m_compact));
+
+    hash = hash_vector(hash, m_vertices);
+    hash = hash_vector(hash, m_vertex_normals);
+    hash = hash_vector(hash, m_primitives);
+    hash = hash_vector(hash, m_compact_vertices);
+    hash = hash_vector(hash, m_compact_vertex_poses);
+    hash = hash_vector(hash, m_compact_vertex_normals);
+    hash = hash_vector(hash, m_compact_vertex_normal_poses);
+    hash = hash_vector(hash, m_compact_tex_coords);
+
+    hash = foundation::siphash24(hash, m_tessellation_attributes.compute_hash());
+    hash = foundation::siphash24(hash, m_vertex_attributes.compute_hash());
+    hash = foundation::siphash24(hash, m_vertex_normal_attributes.compute_hash());
+    hash = foundation::siphash24(hash, m_vertex_tangent_attributes.compute_hash());
+    hash = foundation::siphash24(hash, m_vertex_tangent_poses.compute_hash());
+    hash = foundation::siphash24(hash, m_primitive_attributes.compute_hash());
+
+    return hash;
+}
+
+template <typename Primitive>
+bool StaticTessellation<Primitive>::is_equal(const StaticTessellation& rhs) const
+{
+    return
+        m_compact == rhs.m_compact &&
+        (!m_compact ||
+            (m_vertex_origin == rhs.m_vertex_origin &&
+             m_vertex_scale == rhs.m_vertex_scale &&
+             m_tex_coords_origin == rhs.m_tex_coords_origin &&
+             m_tex_coords_scale == rhs.m_tex_coords_scale)) &&
+        equal_vectors(m_vertices, rhs.m_vertices) &&
+        equal_vectors(m_vertex_normals, rhs.m_vertex_normals) &&
+        equal_vectors(m_primitives, rhs.m_primitives) &&
+        equal_vectors(m_compact_vertices, rhs.m_compact_vertices) &&
+        equal_vectors(m_compact_vertex_poses, rhs.m_compact_vertex_poses) &&
+        equal_vectors(m_compact_vertex_normals, rhs.m_compact_vertex_normals) &&
+        equal_vectors(m_compact_vertex_normal_poses, rhs.m_compact_vertex_normal_poses) &&
+        equal_vectors(m_compact_tex_coords, rhs.m_compact_tex_coords) &&
+        m_tessellation_attributes.is_equal(rhs.m_tessellation_attributes) &&
+        m_vertex_attributes.is_equal(rhs.m_vertex_attributes) &&
+        m_vertex_normal_attributes.is_equal(rhs.m_vertex_normal_attributes) &&
+        m_vertex_tangent_attributes.is_equal(rhs.m_vertex_tangent_attributes) &&
+        m_vertex_tangent_poses.is_equal(rhs.m_vertex_tangent_poses) &&
+        m_primitive_attributes.is_equal(rhs.m_primitive_attributes);
+}
+
+template <typename Primitive>
+size_t StaticTessellation<Primitive>::get_memory_size() const
+{
+    return
+          sizeof(*this)
+        + vector_memory_size(m_vertices)
+        + vector_memory_size(m_vertex_normals)
+        + vector_memory_size(m_primitives)
+        + vector_memory_size(m_compact_vertices)
+        + vector_memory_size(m_compact_vertex_poses)
+        + vector_memory_size(m_compact_vertex_normals)
+        + vector_memory_size(m_compact_vertex_normal_poses)
+        + vector_memory_size(m_compact_tex_coords)
+        + m_tessellation_attributes.get_memory_size()
+        + m_vertex_attributes.get_memory_size()
+        + m_vertex_normal_attributes.get_memory_size()
+        + m_vertex_tangent_attributes.get_memory_size()
+        + m_vertex_tangent_poses.get_memory_size()
+        + m_primitive_attributes.get_memory_size();
+}
+
+template <typename Primitive>
+void StaticTessellation<Primitive>::track_memory_size()
+{
+    m_tracked_memory_size.set(get_memory_size());
+}
+
+template <typename Primitive>
+size_t StaticTessellation<Primitive>::advise_large_pages() const
+{
+    return
+        foundation::advise_large_pages(m_vertices) +
+        foundation::advise_large_pages(m_vertex_normals) +
+        foundation::advise_large_pages(m_primitives) +
+        foundation::advise_large_pages(m_compact_vertices) +
+        foundation::advise_large_pages(m_compact_vertex_normals) +
+        foundation::advise_large_pages(m_compact_tex_coords);
+}
+
 template <typename Primitive>
 void StaticTessellation<Primitive>::create_uv_0_attribute()
 {
@@ -498,6 +830,105 @@ void StaticTessellation<Primitive>::create_tangents_attribute()
             3);
 }
 
+template <typename Primitive>
+void StaticTessellation<Primitive>::delete_vertex_attributes_channel(foundation::AttributeSet::ChannelID& channel_id)
+{
+    assert(channel_id != foundation::AttributeSet::InvalidChannelID);
+
+    m_vertex_attributes.delete_channel(channel_id);
+
+    foundation::AttributeSet::ChannelID* channel_ids[] = { &m_uv_0_cid, &m_tangents_cid, &m_vp_cid };
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        if (*channel_ids[i] != foundation::AttributeSet::InvalidChannelID && *channel_ids[i] > channel_id)
+            --*channel_ids[i];
+    }
+
+    channel_id = foundation::AttributeSet::InvalidChannelID;
+}
+
+template <typename Primitive>
+template <typename T>
+inline foundation::uint64 StaticTessellation<Primitive>::hash_vector(
+    const foundation::uint64                    hash,
+    const std::vector<T>&                       vec)
+{
+    return
+        vec.empty()
+            ? foundation::siphash24(hash, 0)
+            : foundation::siphash24(hash, foundation::siphash24(&vec[0], vec.size() * sizeof(T)));
+}
+
+template <typename Primitive>
+template <typename T>
+inline bool StaticTessellation<Primitive>::equal_vectors(
+    const std::vector<T>&                       lhs,
+    const std::vector<T>&                       rhs)
+{
+    return
+        lhs.size() == rhs.size() &&
+        (lhs.empty() || std::memcmp(&lhs[0], &rhs[0], lhs.size() * sizeof(T)) == 0);
+}
+
+template <typename Primitive>
+template <typename T>
+inline size_t StaticTessellation<Primitive>::vector_memory_size(const std::vector<T>& vec)
+{
+    return vec.capacity() * sizeof(T);
+}
+
+template <typename Primitive>
+template <size_t N>
+void StaticTessellation<Primitive>::compute_quantization(
+    const foundation::AABB<GScalar, N>&         bbox,
+    foundation::Vector<GScalar, N>&             origin,
+    foundation::Vector<GScalar, N>&             scale)
+{
+    if (bbox.is_valid())
+    {
+        origin = bbox.min;
+        scale = bbox.extent() / GScalar(65535.0);
+    }
+    else
+    {
+        origin = foundation::Vector<GScalar, N>(GScalar(0.0));
+        scale = foundation::Vector<GScalar, N>(GScalar(0.0));
+    }
+}
+
+template <typename Primitive>
+template <size_t N>
+inline void StaticTessellation<Primitive>::quantize(
+    const foundation::Vector<GScalar, N>&       v,
+    const foundation::Vector<GScalar, N>&       origin,
+    const foundation::Vector<GScalar, N>&       scale,
+    std::vector<foundation::uint16>&            output)
+{
+    for (size_t i = 0; i < N; ++i)
+    {
+        const GScalar x = scale[i] > GScalar(0.0) ? (v[i] - origin[i]) / scale[i] : GScalar(0.0);
+        output.push_back(
+            foundation::truncate<foundation::uint16>(
+                foundation::clamp(x, GScalar(0.0), GScalar(65535.0)) + GScalar(0.5)));
+    }
+}
+
+template <typename Primitive>
+template <size_t N>
+inline foundation::Vector<GScalar, N> StaticTessellation<Primitive>::dequantize(
+    const foundation::uint16                    q[],
+    const foundation::Vector<GScalar, N>&       origin,
+    const foundation::Vector<GScalar, N>&       scale)
+{
+    foundation::Vector<GScalar, N> v;
+
+    for (size_t i = 0; i < N; ++i)
+        v[i] = origin[i] + static_cast<GScalar>(q[i]) * scale[i];
+
+    return v;
+}
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_KERNEL_TESSELLATION_STATICTESSELLATION_H
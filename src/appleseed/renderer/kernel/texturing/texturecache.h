@@ -44,9 +44,6 @@
 // Standard headers.
 #include <cstddef>
 
-// Forward declarations.
-namespace foundation    { class Tile; }
-
 namespace renderer
 {
 
@@ -61,12 +58,13 @@ class TextureCache
     // Constructor.
     explicit TextureCache(TextureStore& store);
 
-    // Get a tile from the cache.
-    foundation::Tile& get(
+    // Get a tile of a given mipmap level from the cache.
+    const TextureStore::TileRecord& get(
         const foundation::UniqueID  assembly_uid,
         const foundation::UniqueID  texture_uid,
         const size_t                tile_x,
-        const size_t                tile_y);
+        const size_t                tile_y,
+        const size_t                level = 0);
 
     // Retrieve performance statistics.
     foundation::StatisticsVector get_statistics() const;
@@ -127,14 +125,15 @@ inline TextureCache::TextureCache(TextureStore& store)
 {
 }
 
-inline foundation::Tile& TextureCache::get(
+inline const TextureStore::TileRecord& TextureCache::get(
     const foundation::UniqueID      assembly_uid,
     const foundation::UniqueID      texture_uid,
     const size_t                    tile_x,
-    const size_t                    tile_y)
+    const size_t                    tile_y,
+    const size_t                    level)
 {
-    const TileKey key(assembly_uid, texture_uid, tile_x, tile_y);
-    return *m_tile_cache.get(key)->m_tile;
+    const TileKey key(assembly_uid, texture_uid, tile_x, tile_y, level);
+    return *m_tile_cache.get(key);
 }
 
 inline foundation::StatisticsVector TextureCache::get_statistics() const
@@ -166,7 +165,8 @@ inline size_t TextureCache::TileKeyHasher::operator()(const TileKey& key) const
         foundation::mix_uint32(
             static_cast<foundation::uint32>(key.m_assembly_uid),
             static_cast<foundation::uint32>(key.m_texture_uid),
-            static_cast<foundation::uint32>(key.m_tile_xy));
+            static_cast<foundation::uint32>(key.m_tile_xy),
+            key.m_level);
 }
 
 
@@ -0,0 +1,155 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "texturememorybudget.h"
+
+// appleseed.renderer headers.
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/utility/cache.h"
+
+// Standard headers.
+#include <memory>
+#include <string>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    // Minimum share of the budget of each cache.
+    const float MinFraction = 0.1f;
+}
+
+TextureMemoryBudget::TextureMemoryBudget(const ParamArray& params)
+  : m_total_size(params.get_optional<size_t>("max_size", 256 * 1024 * 1024))
+  , m_shared(params.get_optional<bool>("shared_memory_budget", false))
+  , m_texture_store_fraction(0.5f)
+  , m_texture_store_access_count(0)
+  , m_texture_store_miss_count(0)
+  , m_oiio_access_count(0)
+  , m_oiio_miss_count(0)
+{
+}
+
+bool TextureMemoryBudget::is_shared() const
+{
+    return m_shared;
+}
+
+void TextureMemoryBudget::set_total_size(const size_t size)
+{
+    m_total_size = size;
+}
+
+size_t TextureMemoryBudget::get_total_size() const
+{
+    return m_total_size;
+}
+
+size_t TextureMemoryBudget::get_texture_store_size() const
+{
+    return
+        m_shared
+            ? static_cast<size_t>(m_texture_store_fraction * m_total_size)
+            : m_total_size;
+}
+
+size_t TextureMemoryBudget::get_oiio_size() const
+{
+    return
+        m_shared
+            ? m_total_size - get_texture_store_size()
+            : m_total_size;
+}
+
+void TextureMemoryBudget::update(
+    const uint64    texture_store_access_count,
+    const uint64    texture_store_miss_count,
+    const uint64    oiio_access_count,
+    const uint64    oiio_miss_count)
+{
+    m_texture_store_access_count += texture_store_access_count;
+    m_texture_store_miss_count += texture_store_miss_count;
+    m_oiio_access_count += oiio_access_count;
+    m_oiio_miss_count += oiio_miss_count;
+
+    // Keep the current division if neither cache missed.
+    const uint64 miss_count = texture_store_miss_count + oiio_miss_count;
+    if (miss_count == 0)
+        return;
+
+    const float target_fraction =
+        static_cast<float>(static_cast<double>(texture_store_miss_count) / miss_count);
+
+    m_texture_store_fraction =
+        clamp(
+            0.5f * (m_texture_store_fraction + target_fraction),
+            MinFraction,
+            1.0f - MinFraction);
+}
+
+StatisticsVector TextureMemoryBudget::get_statistics() const
+{
+    Statistics texture_store_stats;
+    texture_store_stats.insert(
+        auto_ptr<cache_impl::CacheStatisticsEntry>(
+            new cache_impl::CacheStatisticsEntry(
+                "performances",
+                m_texture_store_access_count - m_texture_store_miss_count,
+                m_texture_store_miss_count)));
+    texture_store_stats.insert_size("budget", get_texture_store_size());
+
+    Statistics oiio_stats;
+    oiio_stats.insert(
+        auto_ptr<cache_impl::CacheStatisticsEntry>(
+            new cache_impl::CacheStatisticsEntry(
+                "performances",
+                m_oiio_access_count - m_oiio_miss_count,
+                m_oiio_miss_count)));
+    oiio_stats.insert_size("budget", get_oiio_size());
+
+    Statistics stats;
+    stats.insert<string>("shared", m_shared ? "yes" : "no");
+    stats.insert_size("total budget", m_total_size);
+
+    StatisticsVector vec = StatisticsVector::make("texture memory statistics", stats);
+    vec.insert("texture store", texture_store_stats);
+    vec.insert("oiio texture cache", oiio_stats);
+
+    return vec;
+}
+
+}   // namespace renderer
@@ -0,0 +1,101 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_RENDERER_KERNEL_TEXTURING_TEXTUREMEMORYBUDGET_H
+#define APPLESEED_RENDERER_KERNEL_TEXTURING_TEXTUREMEMORYBUDGET_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/statistics.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace renderer  { class ParamArray; }
+
+namespace renderer
+{
+
+//
+// A single texture memory budget shared by appleseed's texture store and by the
+// texture cache of OpenImageIO (used by OSL shaders).
+//
+// Each time the budget is updated, it is divided between the two caches in
+// proportion to the number of misses each of them had since the previous update,
+// that is, to their miss rate weighted by their traffic. The division moves
+// halfway toward this target at each update, and each cache always keeps at
+// least a tenth of the budget.
+//
+
+class TextureMemoryBudget
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. 'params' are the texture store parameters.
+    explicit TextureMemoryBudget(const ParamArray& params);
+
+    // Return true if the budget is shared, false if each cache gets the whole budget.
+    bool is_shared() const;
+
+    // Set or get the total budget in bytes.
+    void set_total_size(const size_t size);
+    size_t get_total_size() const;
+
+    // Return the share of the texture store, in bytes.
+    size_t get_texture_store_size() const;
+
+    // Return the share of the OpenImageIO texture cache, in bytes.
+    size_t get_oiio_size() const;
+
+    // Record the lookups and misses of both caches since the previous update,
+    // and divide the budget again.
+    void update(
+        const foundation::uint64    texture_store_access_count,
+        const foundation::uint64    texture_store_miss_count,
+        const foundation::uint64    oiio_access_count,
+        const foundation::uint64    oiio_miss_count);
+
+    // Retrieve the combined statistics of both caches.
+    foundation::StatisticsVector get_statistics() const;
+
+  private:
+    size_t              m_total_size;
+    const bool          m_shared;
+    float               m_texture_store_fraction;
+    foundation::uint64  m_texture_store_access_count;
+    foundation::uint64  m_texture_store_miss_count;
+    foundation::uint64  m_oiio_access_count;
+    foundation::uint64  m_oiio_miss_count;
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_TEXTURING_TEXTUREMEMORYBUDGET_H
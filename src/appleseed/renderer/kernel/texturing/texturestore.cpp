@@ -38,11 +38,14 @@
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
 #include "foundation/image/color.h"
 #include "foundation/image/colorspace.h"
+#include "foundation/image/compressedtile.h"
 #include "foundation/image/tile.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/eventtracer.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/memory.h"
 #include "foundation/utility/statistics.h"
@@ -50,7 +53,10 @@
 
 // Standard headers.
 #include <algorithm>
+#include <functional>
 #include <string>
+#include <utility>
+#include <vector>
 
 using namespace foundation;
 using namespace std;
@@ -58,6 +64,41 @@ using namespace std;
 namespace renderer
 {
 
+//
+// TextureStore::PrefetchJob class implementation.
+//
+
+class TextureStore::PrefetchJob
+  : public IJob
+{
+  public:
+    PrefetchJob(
+        TextureStore&       store,
+        const TileKey&      key)
+      : m_store(store)
+      , m_key(key)
+    {
+    }
+
+    virtual void execute(const size_t thread_index) APPLESEED_OVERRIDE
+    {
+        if (m_store.m_shards[0]->m_tile_swapper.is_valid_key(m_key))
+        {
+            // Bring the tile into the store without prefetching its own neighbors.
+            bool loaded;
+            TileRecord& record = m_store.acquire(m_key, loaded);
+            m_store.release(record);
+        }
+
+        m_store.complete_prefetch(m_key);
+    }
+
+  private:
+    TextureStore&   m_store;
+    const TileKey   m_key;
+};
+
+
 //
 // TextureStore class implementation.
 //
@@ -65,17 +106,241 @@ namespace renderer
 TextureStore::TextureStore(
     const Scene&        scene,
     const ParamArray&   params)
-  : m_tile_swapper(scene, params)
-  , m_tile_cache(m_tile_key_hasher, m_tile_swapper)
+  : m_track_lock_contention(params.get_optional<bool>("track_lock_contention", false))
+  , m_max_pending_prefetches(params.get_optional<size_t>("max_pending_prefetches", 256))
+  , m_prefetch_count(0)
+  , m_coalesced_prefetch_count(0)
+{
+    const size_t shard_count =
+        max<size_t>(params.get_optional<size_t>("shard_count", 16), 1);
+
+    m_shards.reserve(shard_count);
+
+    for (size_t i = 0; i < shard_count; ++i)
+        m_shards.push_back(new Shard(
+            scene,
+            params,
+            shard_count,
+            m_tile_key_hasher,
+            m_track_lock_contention ? &m_shard_lock_counters : 0));
+
+    const size_t prefetch_thread_count = params.get_optional<size_t>("prefetch_thread_count", 2);
+
+    if (prefetch_thread_count > 0)
+    {
+        m_prefetch_job_manager.reset(
+            new JobManager(
+                global_logger(),
+                m_prefetch_job_queue,
+                prefetch_thread_count,
+                JobManager::KeepRunningOnEmptyQueue));
+        m_prefetch_job_manager->start();
+    }
+}
+
+TextureStore::~TextureStore()
+{
+    // Stop prefetching before the shards go away.
+    if (m_prefetch_job_manager.get())
+    {
+        m_prefetch_job_queue.clear_scheduled_jobs();
+        m_prefetch_job_manager->stop();
+    }
+
+    for (size_t i = 0; i < m_shards.size(); ++i)
+        delete m_shards[i];
+}
+
+void TextureStore::set_reserved_memory_size(const size_t size)
+{
+    for (size_t i = 0; i < m_shards.size(); ++i)
+    {
+        Shard& shard = *m_shards[i];
+        AdaptiveLock::ScopedLock lock(shard.m_lock);
+        shard.m_tile_swapper.set_reserved_memory_size(size / m_shards.size());
+    }
+}
+
+void TextureStore::set_memory_limit(const size_t size)
 {
+    for (size_t i = 0; i < m_shards.size(); ++i)
+    {
+        Shard& shard = *m_shards[i];
+        AdaptiveLock::ScopedLock lock(shard.m_lock);
+        shard.m_tile_swapper.set_memory_limit(size / m_shards.size());
+    }
+}
+
+uint64 TextureStore::get_access_count() const
+{
+    uint64 access_count = 0;
+
+    for (size_t i = 0; i < m_shards.size(); ++i)
+    {
+        Shard& shard = *m_shards[i];
+        AdaptiveLock::ScopedLock lock(shard.m_lock);
+        access_count += shard.m_tile_cache.get_hit_count() + shard.m_tile_cache.get_miss_count();
+    }
+
+    return access_count;
+}
+
+uint64 TextureStore::get_miss_count() const
+{
+    uint64 miss_count = 0;
+
+    for (size_t i = 0; i < m_shards.size(); ++i)
+    {
+        Shard& shard = *m_shards[i];
+        AdaptiveLock::ScopedLock lock(shard.m_lock);
+        miss_count += shard.m_tile_cache.get_miss_count();
+    }
+
+    return miss_count;
 }
 
 StatisticsVector TextureStore::get_statistics() const
 {
-    Statistics stats = make_single_stage_cache_stats(m_tile_cache);
-    stats.insert_size("peak size", m_tile_swapper.get_peak_memory_size());
+    Statistics stats;
+    size_t peak_memory_size = 0;
+    size_t memory_limit = 0;
+    TileSwapper::TextureRecordMap texture_records;
 
-    return StatisticsVector::make("texture store statistics", stats);
+    for (size_t i = 0; i < m_shards.size(); ++i)
+    {
+        const TileSwapper& tile_swapper = m_shards[i]->m_tile_swapper;
+
+        // Hit and miss counts of the shards are summed when merging the entries.
+        stats.merge(make_single_stage_cache_stats(m_shards[i]->m_tile_cache));
+
+        // Shards don't reach their peak at the same time: this is an upper bound.
+        peak_memory_size += tile_swapper.get_peak_memory_size();
+        memory_limit += tile_swapper.get_memory_limit();
+
+        // Tiles of a given texture are spread over all shards.
+        const TileSwapper::TextureRecordMap& records = tile_swapper.get_texture_records();
+        for (const_each<TileSwapper::TextureRecordMap> j = records; j; ++j)
+        {
+            TileSwapper::TextureRecord& record = texture_records[j->first];
+            if (record.m_path.empty())
+                record.m_path = j->second.m_path;
+            record.m_hit_count += j->second.m_hit_count;
+            record.m_miss_count += j->second.m_miss_count;
+            record.m_load_count += j->second.m_load_count;
+            record.m_reload_count += j->second.m_reload_count;
+            record.m_loaded_bytes += j->second.m_loaded_bytes;
+            record.m_uncompressed_bytes += j->second.m_uncompressed_bytes;
+        }
+    }
+
+    uint64 loaded_bytes = 0;
+    uint64 uncompressed_bytes = 0;
+    for (const_each<TileSwapper::TextureRecordMap> i = texture_records; i; ++i)
+    {
+        loaded_bytes += i->second.m_loaded_bytes;
+        uncompressed_bytes += i->second.m_uncompressed_bytes;
+    }
+
+    stats.insert_size("peak size", peak_memory_size);
+    stats.insert_size("capacity", memory_limit);
+    stats.insert<uint64>("shards", m_shards.size());
+    stats.insert<uint64>("prefetches", m_prefetch_count);
+    stats.insert<uint64>("coalesced prefetches", m_coalesced_prefetch_count);
+
+    if (m_track_lock_contention)
+    {
+        stats.insert<uint64>("shard locks", m_shard_lock_counters.get_acquisition_count());
+        stats.insert_percent("contended locks", m_shard_lock_counters.get_contended_count(), m_shard_lock_counters.get_acquisition_count());
+        stats.insert<uint64>("parked threads", m_shard_lock_counters.get_park_count());
+        stats.insert_time("lock wait time", m_shard_lock_counters.get_wait_time());
+    }
+
+    if (loaded_bytes > 0 && loaded_bytes < uncompressed_bytes)
+        stats.insert<double>("compression ratio", static_cast<double>(uncompressed_bytes) / loaded_bytes);
+
+    StatisticsVector vec = StatisticsVector::make("texture store statistics", stats);
+
+    // Report the textures that caused the most loading, heaviest first.
+    vector<pair<uint64, UniqueID> > ranked_textures;
+    ranked_textures.reserve(texture_records.size());
+    for (const_each<TileSwapper::TextureRecordMap> i = texture_records; i; ++i)
+        ranked_textures.push_back(make_pair(i->second.m_loaded_bytes, i->first));
+    sort(ranked_textures.begin(), ranked_textures.end(), greater<pair<uint64, UniqueID> >());
+
+    const size_t MaxReportedTextures = 16;
+    for (size_t i = 0; i < min(ranked_textures.size(), MaxReportedTextures); ++i)
+    {
+        const TileSwapper::TextureRecord& record = texture_records[ranked_textures[i].second];
+
+        Statistics texture_stats;
+        texture_stats.insert(
+            auto_ptr<cache_impl::CacheStatisticsEntry>(
+                new cache_impl::CacheStatisticsEntry(
+                    "performances",
+                    record.m_hit_count,
+                    record.m_miss_count)));
+        texture_stats.insert_size("loaded", record.m_loaded_bytes);
+        texture_stats.insert<uint64>("loads", record.m_load_count);
+        texture_stats.insert<uint64>("reloads", record.m_reload_count);
+
+        if (record.m_loaded_bytes > 0 && record.m_loaded_bytes < record.m_uncompressed_bytes)
+        {
+            texture_stats.insert<double>(
+                "compression ratio",
+                static_cast<double>(record.m_uncompressed_bytes) / record.m_loaded_bytes);
+        }
+
+        vec.insert("texture \"" + record.m_path + "\"", texture_stats);
+    }
+
+    return vec;
+}
+
+void TextureStore::prefetch(const TileKey& key)
+{
+    if (!m_prefetch_job_manager.get())
+        return;
+
+    {
+        boost::mutex::scoped_lock lock(m_prefetch_mutex);
+
+        // Drop the request if the prefetchers are lagging behind.
+        if (m_pending_prefetches.size() >= m_max_pending_prefetches)
+            return;
+
+        // Coalesce the request with a pending one for the same tile.
+        if (!m_pending_prefetches.insert(key).second)
+        {
+            ++m_coalesced_prefetch_count;
+            return;
+        }
+
+        ++m_prefetch_count;
+    }
+
+    m_prefetch_job_queue.schedule(new PrefetchJob(*this, key));
+}
+
+void TextureStore::prefetch_neighbors(const TileKey& key)
+{
+    const size_t tile_x = key.get_tile_x();
+    const size_t tile_y = key.get_tile_y();
+
+    // Tiles outside the texture are discarded by the prefetching job.
+    if (tile_x + 1 < (1UL << 16))
+        prefetch(TileKey(key.m_assembly_uid, key.m_texture_uid, tile_x + 1, tile_y, key.m_level));
+    if (tile_y + 1 < (1UL << 16))
+        prefetch(TileKey(key.m_assembly_uid, key.m_texture_uid, tile_x, tile_y + 1, key.m_level));
+
+    // Only mipmapped lookups blend with the next coarser level.
+    if (key.m_level > 0)
+        prefetch(TileKey(key.m_assembly_uid, key.m_texture_uid, tile_x / 2, tile_y / 2, key.m_level + 1));
+}
+
+void TextureStore::complete_prefetch(const TileKey& key)
+{
+    boost::mutex::scoped_lock lock(m_prefetch_mutex);
+    m_pending_prefetches.erase(key);
 }
 
 Dictionary TextureStore::get_params_metadata()
@@ -91,10 +356,83 @@ Dictionary TextureStore::get_params_metadata()
             .insert("label", "Texture Cache Size")
             .insert("help", "Texture cache size in bytes"));
 
+    metadata.dictionaries().insert(
+        "adaptive_max_size",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "0")
+            .insert("label", "Adaptive Texture Cache Size")
+            .insert("help", "Size in bytes up to which the texture cache grows when its miss rate is high (0 disables adaptive sizing)"));
+
+    metadata.dictionaries().insert(
+        "adaptive_max_miss_rate",
+        Dictionary()
+            .insert("type", "float")
+            .insert("default", "0.05")
+            .insert("label", "Adaptive Texture Cache Miss Rate")
+            .insert("help", "Miss rate above which the texture cache grows"));
+
+    metadata.dictionaries().insert(
+        "shared_memory_budget",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Shared Texture Memory Budget")
+            .insert("help", "Divide the texture cache size between appleseed textures and OSL textures according to their miss rates, instead of giving each the full size"));
+
+    metadata.dictionaries().insert(
+        "compress_tiles",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Compress Texture Tiles")
+            .insert("help", "Store the tiles of 8-bit textures block-compressed, trading some quality for memory"));
+
+    metadata.dictionaries().insert(
+        "keep_between_renders",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Keep Texture Cache Between Renders")
+            .insert("help", "Keep the texture cache and its tiles when the same scene is rendered again by the same renderer; textures must not change between renders"));
+
+    metadata.dictionaries().insert(
+        "shard_count",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "16")
+            .insert("label", "Texture Cache Shards")
+            .insert("help", "Number of independently locked partitions of the texture cache"));
+
+    metadata.dictionaries().insert(
+        "prefetch_thread_count",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "2")
+            .insert("label", "Texture Prefetching Threads")
+            .insert("help", "Number of threads loading texture tiles in the background (0 disables prefetching)"));
+
     return metadata;
 }
 
 
+//
+// TextureStore::Shard class implementation.
+//
+
+TextureStore::Shard::Shard(
+    const Scene&                scene,
+    const ParamArray&           params,
+    const size_t                shard_count,
+    TileKeyHasher&              tile_key_hasher,
+    LockContentionCounters*     lock_counters)
+  : m_lock(lock_counters)
+  , m_tile_swapper(scene, params, shard_count)
+  , m_tile_cache(tile_key_hasher, m_tile_swapper)
+{
+}
+
+
 //
 // TextureStore::TileSwapper class implementation.
 //
@@ -158,29 +496,60 @@ namespace
             }
         }
     }
+
+    // Return the size in bytes of the tile held by a record.
+    size_t get_tile_memory_size(const TextureStore::TileRecord& record)
+    {
+        return
+            record.m_compressed_tile
+                ? record.m_compressed_tile->get_memory_size()
+                : record.m_tile->get_memory_size();
+    }
+
+    // Convert a color to the linear RGB color space.
+    Color3f convert_to_linear_rgb(const ColorSpace color_space, const Color3f& color)
+    {
+        switch (color_space)
+        {
+          case ColorSpaceLinearRGB:
+            return color;
+
+          case ColorSpaceSRGB:
+            return srgb_to_linear_rgb(color);
+
+          case ColorSpaceCIEXYZ:
+            return ciexyz_to_linear_rgb(color);
+
+          assert_otherwise_and_return(color);
+        }
+    }
 }
 
 TextureStore::TileSwapper::TileSwapper(
     const Scene&        scene,
-    const ParamArray&   params)
+    const ParamArray&   params,
+    const size_t        shard_count)
   : m_scene(scene)
-  , m_params(params)
+  , m_params(params, shard_count)
   , m_memory_size(0)
   , m_peak_memory_size(0)
+  , m_tracked_memory_size(MemoryTracker::Textures)
+  , m_memory_limit(m_params.m_memory_limit)
+  , m_max_memory_limit(m_params.m_max_memory_limit)
+  , m_reserved_memory_size(0)
+  , m_window_access_count(0)
+  , m_window_miss_count(0)
 {
+    update_effective_memory_limit();
     gather_assemblies(scene.assemblies());
 }
 
 void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
 {
-    // Fetch the texture container.
-    const TextureContainer& textures =
-        key.m_assembly_uid == UniqueID(~0)
-            ? m_scene.textures()
-            : m_assemblies[key.m_assembly_uid]->textures();
+    ScopedTraceEvent event("texture tile load", "texturing");
 
     // Fetch the texture.
-    Texture* texture = textures.get_by_uid(key.m_texture_uid);
+    Texture* texture = get_texture(key);
 
     if (m_params.m_track_tile_loading)
     {
@@ -192,48 +561,84 @@ void TextureStore::TileSwapper::load(const TileKey& key, TileRecord& record)
             texture->get_path().c_str());
     }
 
-    // Load the tile.
-    record.m_tile = texture->load_tile(key.get_tile_x(), key.get_tile_y());
     record.m_owners = 0;
 
-    // Convert the tile to the linear RGB color space.
-    switch (texture->get_color_space())
+    if (key.m_level > 0)
     {
-      case ColorSpaceLinearRGB:
-        break;
+        // Generate the tile, directly in the linear RGB color space.
+        record.m_tile = generate_mip_tile(*texture, key);
+    }
+    else
+    {
+        // Load the tile.
+        record.m_tile = texture->load_tile(key.get_tile_x(), key.get_tile_y());
+
+        // Convert the tile to the linear RGB color space.
+        switch (texture->get_color_space())
+        {
+          case ColorSpaceLinearRGB:
+            break;
 
-      case ColorSpaceSRGB:
-        convert_tile_srgb_to_linear_rgb(*record.m_tile);
-        break;
+          case ColorSpaceSRGB:
+            convert_tile_srgb_to_linear_rgb(*record.m_tile);
+            break;
 
-      case ColorSpaceCIEXYZ:
-        convert_tile_ciexyz_to_linear_rgb(*record.m_tile);
-        break;
+          case ColorSpaceCIEXYZ:
+            convert_tile_ciexyz_to_linear_rgb(*record.m_tile);
+            break;
 
-      assert_otherwise;
+          assert_otherwise;
+        }
+    }
+
+    const size_t uncompressed_memory_size = record.m_tile->get_memory_size();
+
+    // Compress the tile. Mipmap tiles of 8-bit textures are averages of 8-bit values.
+    record.m_compressed_tile = 0;
+    if (m_params.m_compress_tiles && texture->properties().m_pixel_format == PixelFormatUInt8)
+    {
+        record.m_compressed_tile = new CompressedTile(*record.m_tile);
+
+        if (key.m_level > 0)
+            delete record.m_tile;
+        else texture->unload_tile(key.get_tile_x(), key.get_tile_y(), record.m_tile);
+
+        record.m_tile = 0;
     }
 
     // Track the amount of memory used by the tile cache.
-    m_memory_size += record.m_tile->get_memory_size();
+    const size_t tile_memory_size = get_tile_memory_size(record);
+    m_memory_size += tile_memory_size;
     m_peak_memory_size = max(m_peak_memory_size, m_memory_size);
+    m_tracked_memory_size.set(m_memory_size);
+
+    // Update the telemetry of the texture.
+    TextureRecord& texture_record = m_texture_records[key.m_texture_uid];
+    if (texture_record.m_path.empty())
+        texture_record.m_path = texture->get_path().c_str();
+    ++texture_record.m_load_count;
+    texture_record.m_loaded_bytes += tile_memory_size;
+    texture_record.m_uncompressed_bytes += uncompressed_memory_size;
+    if (m_evicted_keys.erase(key) > 0)
+        ++texture_record.m_reload_count;
 
     if (m_params.m_track_store_size)
     {
-        if (m_memory_size > m_params.m_memory_limit)
+        if (m_memory_size > m_effective_memory_limit)
         {
             RENDERER_LOG_DEBUG(
                 "texture store size is %s, exceeding capacity %s by %s",
                 pretty_size(m_memory_size).c_str(),
-                pretty_size(m_params.m_memory_limit).c_str(),
-                pretty_size(m_memory_size - m_params.m_memory_limit).c_str());
+                pretty_size(m_effective_memory_limit).c_str(),
+                pretty_size(m_memory_size - m_effective_memory_limit).c_str());
         }
         else
         {
             RENDERER_LOG_DEBUG(
                 "texture store size is %s, below capacity %s by %s",
                 pretty_size(m_memory_size).c_str(),
-                pretty_size(m_params.m_memory_limit).c_str(),
-                pretty_size(m_params.m_memory_limit - m_memory_size).c_str());
+                pretty_size(m_effective_memory_limit).c_str(),
+                pretty_size(m_effective_memory_limit - m_memory_size).c_str());
         }
     }
 }
@@ -245,18 +650,13 @@ bool TextureStore::TileSwapper::unload(const TileKey& key, TileRecord& record)
         return false;
 
     // Track the amount of memory used by the tile cache.
-    const size_t tile_memory_size = record.m_tile->get_memory_size();
+    const size_t tile_memory_size = get_tile_memory_size(record);
     assert(m_memory_size >= tile_memory_size);
     m_memory_size -= tile_memory_size;
-
-    // Fetch the texture container.
-    const TextureContainer& textures =
-        key.m_assembly_uid == UniqueID(~0)
-            ? m_scene.textures()
-            : m_assemblies[key.m_assembly_uid]->textures();
+    m_tracked_memory_size.set(m_memory_size);
 
     // Fetch the texture.
-    Texture* texture = textures.get_by_uid(key.m_texture_uid);
+    Texture* texture = get_texture(key);
 
     if (m_params.m_track_tile_unloading)
     {
@@ -268,13 +668,127 @@ bool TextureStore::TileSwapper::unload(const TileKey& key, TileRecord& record)
             texture->get_path().c_str());
     }
 
-    // Unload the tile.
-    texture->unload_tile(key.get_tile_x(), key.get_tile_y(), record.m_tile);
+    // Unload the tile. Mipmap and compressed tiles are owned by the store.
+    if (record.m_compressed_tile)
+        delete record.m_compressed_tile;
+    else if (key.m_level > 0)
+        delete record.m_tile;
+    else texture->unload_tile(key.get_tile_x(), key.get_tile_y(), record.m_tile);
+
+    // Remember the tile such that loading it again is reported as a reload.
+    m_evicted_keys.insert(key);
 
     // Successfully unloaded the tile.
     return true;
 }
 
+void TextureStore::TileSwapper::record_access(const TileKey& key, const bool miss)
+{
+    TextureRecord& texture_record = m_texture_records[key.m_texture_uid];
+
+    if (miss)
+        ++texture_record.m_miss_count;
+    else ++texture_record.m_hit_count;
+
+    if (m_memory_limit >= m_max_memory_limit)
+        return;
+
+    // Accesses are considered by windows of fixed size.
+    const size_t AdaptationWindowSize = 4096;
+
+    ++m_window_access_count;
+
+    if (miss)
+        ++m_window_miss_count;
+
+    if (m_window_access_count < AdaptationWindowSize)
+        return;
+
+    // Only grow if misses cause evictions: cold misses don't call for more capacity.
+    if (m_window_miss_count > m_params.m_max_miss_rate * AdaptationWindowSize &&
+        m_memory_size >= m_effective_memory_limit)
+    {
+        m_memory_limit = min(m_memory_limit + m_memory_limit / 4 + 1, m_max_memory_limit);
+        update_effective_memory_limit();
+
+        if (m_params.m_track_store_size)
+        {
+            RENDERER_LOG_DEBUG(
+                "texture store capacity grown to %s after a miss rate of %s.",
+                pretty_size(m_effective_memory_limit).c_str(),
+                pretty_percent(m_window_miss_count, m_window_access_count).c_str());
+        }
+    }
+
+    m_window_access_count = 0;
+    m_window_miss_count = 0;
+}
+
+void TextureStore::TileSwapper::set_reserved_memory_size(const size_t size)
+{
+    m_reserved_memory_size = size;
+    update_effective_memory_limit();
+}
+
+void TextureStore::TileSwapper::set_memory_limit(const size_t size)
+{
+    m_memory_limit = max<size_t>(size, 1);
+    m_max_memory_limit = m_memory_limit;
+    update_effective_memory_limit();
+}
+
+void TextureStore::TileSwapper::update_effective_memory_limit()
+{
+    // Never give back more than three quarters of the capacity to avoid thrashing.
+    m_effective_memory_limit =
+        max<size_t>(
+            m_memory_limit - min(m_reserved_memory_size, m_memory_limit),
+            max<size_t>(m_memory_limit / 4, 1));
+}
+
+bool TextureStore::TileSwapper::is_valid_key(const TileKey& key) const
+{
+    if (key.m_assembly_uid != UniqueID(~0) &&
+        m_assemblies.find(key.m_assembly_uid) == m_assemblies.end())
+        return false;
+
+    Texture* texture = get_texture(key);
+
+    if (texture == 0)
+        return false;
+
+    // Compute the number of tiles of the mipmap level.
+    const CanvasProperties& props = texture->properties();
+    const size_t scale = size_t(1) << key.m_level;
+    const size_t level_width = (props.m_canvas_width + scale - 1) >> key.m_level;
+    const size_t level_height = (props.m_canvas_height + scale - 1) >> key.m_level;
+
+    // The coarsest mipmap level is the first 1x1 level.
+    if (key.m_level > 0)
+    {
+        const size_t parent_scale = scale / 2;
+        const size_t parent_size = max(props.m_canvas_width, props.m_canvas_height);
+        if ((parent_size + parent_scale - 1) / parent_scale == 1)
+            return false;
+    }
+
+    return
+        key.get_tile_x() * props.m_tile_width < level_width &&
+        key.get_tile_y() * props.m_tile_height < level_height;
+}
+
+Texture* TextureStore::TileSwapper::get_texture(const TileKey& key) const
+{
+    // Fetch the texture container.
+    const TextureContainer& textures =
+        key.m_assembly_uid == UniqueID(~0)
+            ? m_scene.textures()
+            : m_assemblies.find(key.m_assembly_uid)->second->textures();
+
+    // Fetch the texture.
+    return textures.get_by_uid(key.m_texture_uid);
+}
+
 void TextureStore::TileSwapper::gather_assemblies(const AssemblyContainer& assemblies)
 {
     for (const_each<AssemblyContainer> i = assemblies; i; ++i)
@@ -284,13 +798,127 @@ void TextureStore::TileSwapper::gather_assemblies(const AssemblyContainer& assem
     }
 }
 
+Tile* TextureStore::TileSwapper::generate_mip_tile(
+    Texture&            texture,
+    const TileKey&      key)
+{
+    const CanvasProperties& props = texture.properties();
+    const ColorSpace color_space = texture.get_color_space();
+    const size_t level = key.m_level;
+    const size_t scale = size_t(1) << level;
+
+    assert(props.m_channel_count == 3 || props.m_channel_count == 4);
+
+    // Pixels of this mipmap level are box-filtered blocks of scale x scale base pixels.
+    const size_t level_width = (props.m_canvas_width + scale - 1) >> level;
+    const size_t level_height = (props.m_canvas_height + scale - 1) >> level;
+    const size_t origin_x = key.get_tile_x() * props.m_tile_width;
+    const size_t origin_y = key.get_tile_y() * props.m_tile_height;
+    assert(origin_x < level_width);
+    assert(origin_y < level_height);
+
+    // Range of base pixels covered by this tile.
+    const size_t base_x0 = origin_x << level;
+    const size_t base_y0 = origin_y << level;
+    const size_t base_x1 = min(min(origin_x + props.m_tile_width, level_width) << level, props.m_canvas_width);
+    const size_t base_y1 = min(min(origin_y + props.m_tile_height, level_height) << level, props.m_canvas_height);
+
+    const size_t pixel_count = props.m_tile_width * props.m_tile_height;
+    vector<Color4f> sums(pixel_count, Color4f(0.0f));
+    vector<float> weights(pixel_count, 0.0f);
+
+    // Accumulate the linear RGB values of all base pixels covered by this tile.
+    for (size_t ty = base_y0 / props.m_tile_height; ty <= (base_y1 - 1) / props.m_tile_height; ++ty)
+    {
+        for (size_t tx = base_x0 / props.m_tile_width; tx <= (base_x1 - 1) / props.m_tile_width; ++tx)
+        {
+            const Tile* base_tile = texture.load_tile(tx, ty);
+
+            const size_t tile_origin_x = tx * props.m_tile_width;
+            const size_t tile_origin_y = ty * props.m_tile_height;
+            const size_t x0 = max(base_x0, tile_origin_x) - tile_origin_x;
+            const size_t y0 = max(base_y0, tile_origin_y) - tile_origin_y;
+            const size_t x1 = min(base_x1 - tile_origin_x, base_tile->get_width());
+            const size_t y1 = min(base_y1 - tile_origin_y, base_tile->get_height());
+
+            for (size_t y = y0; y < y1; ++y)
+            {
+                for (size_t x = x0; x < x1; ++x)
+                {
+                    Color4f color;
+
+                    if (props.m_channel_count == 3)
+                    {
+                        Color3f rgb;
+                        base_tile->get_pixel(x, y, rgb);
+                        color = Color4f(rgb, 1.0f);
+                    }
+                    else base_tile->get_pixel(x, y, color);
+
+                    color.rgb() = convert_to_linear_rgb(color_space, color.rgb());
+
+                    const size_t i =
+                          (((tile_origin_y + y) >> level) - origin_y) * props.m_tile_width
+                        + (((tile_origin_x + x) >> level) - origin_x);
+
+                    sums[i] += color;
+                    weights[i] += 1.0f;
+                }
+            }
+
+            texture.unload_tile(tx, ty, base_tile);
+        }
+    }
+
+    // Normalize the accumulated values into a floating point tile.
+    Tile* tile =
+        new Tile(
+            props.m_tile_width,
+            props.m_tile_height,
+            props.m_channel_count,
+            PixelFormatFloat);
+
+    for (size_t i = 0; i < pixel_count; ++i)
+    {
+        const Color4f color = weights[i] > 0.0f ? sums[i] / weights[i] : Color4f(0.0f);
+
+        if (props.m_channel_count == 3)
+            tile->set_pixel(i, color.rgb());
+        else tile->set_pixel(i, color);
+    }
+
+    return tile;
+}
+
+
+//
+// TextureStore::TileSwapper::TextureRecord class implementation.
+//
+
+TextureStore::TileSwapper::TextureRecord::TextureRecord()
+  : m_hit_count(0)
+  , m_miss_count(0)
+  , m_load_count(0)
+  , m_reload_count(0)
+  , m_loaded_bytes(0)
+  , m_uncompressed_bytes(0)
+{
+}
+
 
 //
 // TextureStore::TileSwapper::Parameters class implementation.
 //
 
-TextureStore::TileSwapper::Parameters::Parameters(const ParamArray& params)
-  : m_memory_limit(params.get_optional<size_t>("max_size", 256 * 1024 * 1024))
+TextureStore::TileSwapper::Parameters::Parameters(
+    const ParamArray&   params,
+    const size_t        shard_count)
+  : m_memory_limit(
+        max<size_t>(params.get_optional<size_t>("max_size", 256 * 1024 * 1024) / shard_count, 1))
+  , m_max_memory_limit(
+        max<size_t>(params.get_optional<size_t>("adaptive_max_size", 0) / shard_count, m_memory_limit))
+  , m_max_miss_rate(params.get_optional<float>("adaptive_max_miss_rate", 0.05f))
+  , m_compress_tiles(params.get_optional<bool>("compress_tiles", false))
   , m_track_tile_loading(params.get_optional<bool>("track_tile_loading", false))
   , m_track_tile_unloading(params.get_optional<bool>("track_tile_unloading", false))
   , m_track_store_size(params.get_optional<bool>("track_store_size", false))
@@ -40,19 +40,27 @@
 #include "foundation/platform/thread.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/cache.h"
+#include "foundation/utility/job.h"
+#include "foundation/utility/memorytracker.h"
 #include "foundation/utility/uid.h"
 
 // Standard headers.
 #include <cassert>
 #include <cstddef>
 #include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
 
 // Forward declarations.
+namespace foundation    { class CompressedTile; }
 namespace foundation    { class Dictionary; }
 namespace foundation    { class StatisticsVector; }
 namespace foundation    { class Tile; }
 namespace renderer      { class ParamArray; }
 namespace renderer      { class Scene; }
+namespace renderer      { class Texture; }
 
 namespace renderer
 {
@@ -60,6 +68,28 @@ namespace renderer
 //
 // A shared store for texture tiles (the backend of the thread-local texture cache).
 //
+// Tiles are distributed over a number of independently locked shards according
+// to the hash of their key, such that threads missing in their own texture cache
+// rarely contend for the same lock. Each shard holds its own share of the store
+// capacity. Shard locks spin briefly before parking the waiting thread; contention
+// on them can optionally be measured and reported in the store statistics.
+//
+// Tiles of the mipmap levels above the base level of a texture are generated on
+// demand from the base level tiles they cover and are cached like any other tile.
+//
+// When a tile is loaded on behalf of a render thread, the tiles that are likely to
+// be needed next (the next tiles in both directions and, for mipmap tiles, the tile
+// of the next coarser level) are loaded in the background by a pool of prefetching
+// threads. Multiple requests for a tile whose prefetching is pending are coalesced.
+//
+// Optionally, tiles of 8-bit textures are stored block-compressed, which divides
+// their memory footprint by 4 (RGBA) to 6 (RGB) at the cost of some quality.
+//
+// When adaptive sizing is enabled, the capacity of a shard grows (up to a limit) as
+// long as its miss rate remains high while it is full. Conversely, other subsystems
+// may reserve memory, temporarily reducing the capacity of the store. The capacity
+// may also be imposed from outside, e.g. by the TextureMemoryBudget class.
+//
 
 class TextureStore
   : public foundation::NonCopyable
@@ -71,6 +101,7 @@ class TextureStore
         foundation::UniqueID    m_assembly_uid;
         foundation::UniqueID    m_texture_uid;
         foundation::uint32      m_tile_xy;
+        foundation::uint32      m_level;            // mipmap level, 0 is the full resolution level
 
         TileKey();
 
@@ -78,7 +109,8 @@ class TextureStore
             const foundation::UniqueID  assembly_uid,
             const foundation::UniqueID  texture_uid,
             const size_t                tile_x,
-            const size_t                tile_y);
+            const size_t                tile_y,
+            const size_t                level = 0);
 
         TileKey(
             const foundation::UniqueID  assembly_uid,
@@ -101,7 +133,8 @@ class TextureStore
 
     struct TileRecord
     {
-        foundation::Tile*           m_tile;
+        foundation::Tile*           m_tile;             // null if the tile is compressed
+        foundation::CompressedTile* m_compressed_tile;  // null if the tile is not compressed
         volatile foundation::uint32 m_owners;
     };
 
@@ -110,12 +143,30 @@ class TextureStore
         const Scene&        scene,
         const ParamArray&   params = ParamArray());
 
+    // Destructor.
+    ~TextureStore();
+
     // Acquire an element from the cache. Thread-safe.
     TileRecord& acquire(const TileKey& key);
 
+    // Request the loading of a tile in the background. Returns immediately. Thread-safe.
+    void prefetch(const TileKey& key);
+
     // Release a previously-acquired element. Thread-safe.
     void release(TileRecord& record) const;
 
+    // Set the amount of memory in bytes that other subsystems need and that the
+    // store should give back. Tiles are evicted as new ones are loaded. Thread-safe.
+    void set_reserved_memory_size(const size_t size);
+
+    // Set the capacity in bytes of the store, replacing the configured capacity and
+    // disabling adaptive sizing. Tiles are evicted as new ones are loaded. Thread-safe.
+    void set_memory_limit(const size_t size);
+
+    // Return the number of tile lookups and tile misses since the store was created. Thread-safe.
+    foundation::uint64 get_access_count() const;
+    foundation::uint64 get_miss_count() const;
+
     // Retrieve performance statistics.
     foundation::StatisticsVector get_statistics() const;
 
@@ -132,10 +183,27 @@ class TextureStore
       : public foundation::NonCopyable
     {
       public:
+        // Per-texture telemetry.
+        struct TextureRecord
+        {
+            std::string         m_path;
+            foundation::uint64  m_hit_count;
+            foundation::uint64  m_miss_count;
+            foundation::uint64  m_load_count;
+            foundation::uint64  m_reload_count;       // loads of tiles that had been evicted
+            foundation::uint64  m_loaded_bytes;
+            foundation::uint64  m_uncompressed_bytes;   // size of the loaded tiles before compression
+
+            TextureRecord();
+        };
+
+        typedef std::map<foundation::UniqueID, TextureRecord> TextureRecordMap;
+
         // Constructor.
         TileSwapper(
             const Scene&        scene,
-            const ParamArray&   params);
+            const ParamArray&   params,
+            const size_t        shard_count);
 
         // Load a cache line.
         void load(const TileKey& key, TileRecord& record);
@@ -149,15 +217,38 @@ class TextureStore
         // Return the peak memory size in bytes of the tile cache.
         size_t get_peak_memory_size() const;
 
+        // Return the current capacity in bytes of the tile cache.
+        size_t get_memory_limit() const;
+
+        // Record an access to the tile cache, and grow its capacity if needed.
+        void record_access(const TileKey& key, const bool miss);
+
+        // Set the amount of memory that the tile cache should give back.
+        void set_reserved_memory_size(const size_t size);
+
+        // Set the capacity of the tile cache and stop growing it.
+        void set_memory_limit(const size_t size);
+
+        // Return the per-texture telemetry.
+        const TextureRecordMap& get_texture_records() const;
+
+        // Return true if a key designates an existing tile. Thread-safe.
+        bool is_valid_key(const TileKey& key) const;
+
       private:
         struct Parameters
         {
             const size_t    m_memory_limit;
+            const size_t    m_max_memory_limit;
+            const float     m_max_miss_rate;
+            const bool      m_compress_tiles;
             const bool      m_track_tile_loading;
             const bool      m_track_tile_unloading;
             const bool      m_track_store_size;
 
-            explicit Parameters(const ParamArray& params);
+            Parameters(
+                const ParamArray&   params,
+                const size_t        shard_count);
         };
 
         typedef std::map<foundation::UniqueID, const Assembly*> AssemblyMap;
@@ -166,9 +257,28 @@ class TextureStore
         const Parameters    m_params;
         size_t              m_memory_size;
         size_t              m_peak_memory_size;
+        foundation::TrackedMemorySize m_tracked_memory_size;
+        size_t              m_memory_limit;             // capacity before reservations
+        size_t              m_max_memory_limit;         // capacity up to which adaptive sizing grows the cache
+        size_t              m_reserved_memory_size;
+        size_t              m_effective_memory_limit;   // capacity after reservations
+        size_t              m_window_access_count;
+        size_t              m_window_miss_count;
         AssemblyMap         m_assemblies;
+        TextureRecordMap    m_texture_records;
+        std::set<TileKey>   m_evicted_keys;
 
         void gather_assemblies(const AssemblyContainer& assemblies);
+
+        void update_effective_memory_limit();
+
+        // Fetch the texture a tile belongs to. Thread-safe.
+        Texture* get_texture(const TileKey& key) const;
+
+        // Generate a tile of a mipmap level above the base level of a texture.
+        static foundation::Tile* generate_mip_tile(
+            Texture&            texture,
+            const TileKey&      key);
     };
 
     typedef foundation::LRUCache<
@@ -178,10 +288,44 @@ class TextureStore
         TileSwapper
     > TileCache;
 
-    boost::mutex            m_mutex;
-    TileKeyHasher           m_tile_key_hasher;
-    TileSwapper             m_tile_swapper;
-    TileCache               m_tile_cache;
+    struct Shard
+      : public foundation::NonCopyable
+    {
+        foundation::AdaptiveLock    m_lock;
+        TileSwapper                 m_tile_swapper;
+        TileCache                   m_tile_cache;
+
+        Shard(
+            const Scene&                            scene,
+            const ParamArray&                       params,
+            const size_t                            shard_count,
+            TileKeyHasher&                          tile_key_hasher,
+            foundation::LockContentionCounters*     lock_counters);
+    };
+
+    class PrefetchJob;
+
+    TileKeyHasher                           m_tile_key_hasher;
+    foundation::LockContentionCounters      m_shard_lock_counters;
+    bool                                    m_track_lock_contention;
+    std::vector<Shard*>                     m_shards;
+
+    boost::mutex                            m_prefetch_mutex;
+    std::set<TileKey>                       m_pending_prefetches;
+    size_t                                  m_max_pending_prefetches;
+    foundation::uint64                      m_prefetch_count;
+    foundation::uint64                      m_coalesced_prefetch_count;
+    foundation::JobQueue                    m_prefetch_job_queue;
+    std::auto_ptr<foundation::JobManager>   m_prefetch_job_manager;
+
+    // Acquire an element from the cache. Set 'loaded' to true if the tile had to be loaded.
+    TileRecord& acquire(const TileKey& key, bool& loaded);
+
+    // Prefetch the tiles likely to be accessed after a given tile.
+    void prefetch_neighbors(const TileKey& key);
+
+    // Complete a prefetch request.
+    void complete_prefetch(const TileKey& key);
 };
 
 
@@ -191,11 +335,30 @@ class TextureStore
 
 inline TextureStore::TileRecord& TextureStore::acquire(const TileKey& key)
 {
-    boost::mutex::scoped_lock lock(m_mutex);
+    bool loaded;
+    TileRecord& record = acquire(key, loaded);
+
+    if (loaded && m_prefetch_job_manager.get())
+        prefetch_neighbors(key);
+
+    return record;
+}
+
+inline TextureStore::TileRecord& TextureStore::acquire(const TileKey& key, bool& loaded)
+{
+    Shard& shard = *m_shards[m_tile_key_hasher(key) % m_shards.size()];
+
+    foundation::AdaptiveLock::ScopedLock lock(shard.m_lock);
 
-    TileRecord& record = m_tile_cache.get(key);
+    const foundation::uint64 miss_count = shard.m_tile_cache.get_miss_count();
+
+    TileRecord& record = shard.m_tile_cache.get(key);
     foundation::atomic_inc(&record.m_owners);
 
+    loaded = shard.m_tile_cache.get_miss_count() != miss_count;
+
+    shard.m_tile_swapper.record_access(key, loaded);
+
     return record;
 }
 
@@ -218,10 +381,12 @@ inline TextureStore::TileKey::TileKey(
     const foundation::UniqueID  assembly_uid,
     const foundation::UniqueID  texture_uid,
     const size_t                tile_x,
-    const size_t                tile_y)
+    const size_t                tile_y,
+    const size_t                level)
   : m_assembly_uid(assembly_uid)
   , m_texture_uid(texture_uid)
   , m_tile_xy(static_cast<foundation::uint32>((tile_y << 16) | tile_x))
+  , m_level(static_cast<foundation::uint32>(level))
 {
     assert(tile_x < (1UL << 16));
     assert(tile_y < (1UL << 16));
@@ -234,6 +399,7 @@ inline TextureStore::TileKey::TileKey(
   : m_assembly_uid(assembly_uid)
   , m_texture_uid(texture_uid)
   , m_tile_xy(tile_xy)
+  , m_level(0)
 {
 }
 
@@ -241,6 +407,7 @@ inline TextureStore::TileKey::TileKey(const TileKey& rhs)
   : m_assembly_uid(rhs.m_assembly_uid)
   , m_texture_uid(rhs.m_texture_uid)
   , m_tile_xy(rhs.m_tile_xy)
+  , m_level(rhs.m_level)
 {
 }
 
@@ -263,6 +430,7 @@ inline bool TextureStore::TileKey::operator==(const TileKey& rhs) const
 {
     return
         m_tile_xy == rhs.m_tile_xy &&
+        m_level == rhs.m_level &&
         m_texture_uid == rhs.m_texture_uid &&
         m_assembly_uid == rhs.m_assembly_uid;
 }
@@ -277,7 +445,9 @@ inline bool TextureStore::TileKey::operator<(const TileKey& rhs) const
     return
         m_assembly_uid == rhs.m_assembly_uid ?
             m_texture_uid == rhs.m_texture_uid ?
-                m_tile_xy < rhs.m_tile_xy :
+                m_level == rhs.m_level ?
+                    m_tile_xy < rhs.m_tile_xy :
+                m_level < rhs.m_level :
             m_texture_uid < rhs.m_texture_uid :
         m_assembly_uid < rhs.m_assembly_uid;
 }
@@ -289,7 +459,7 @@ inline bool TextureStore::TileKey::operator<(const TileKey& rhs) const
 
 inline size_t TextureStore::TileKeyHasher::operator()(const TileKey& key) const
 {
-    return foundation::mix_uint64(key.m_assembly_uid, key.m_texture_uid, key.m_tile_xy);
+    return foundation::mix_uint64(key.m_assembly_uid, key.m_texture_uid, key.m_tile_xy, key.m_level);
 }
 
 
@@ -299,7 +469,7 @@ inline size_t TextureStore::TileKeyHasher::operator()(const TileKey& key) const
 
 inline bool TextureStore::TileSwapper::is_full(const size_t element_count) const
 {
-    return m_memory_size >= m_params.m_memory_limit;
+    return m_memory_size >= m_effective_memory_limit;
 }
 
 inline size_t TextureStore::TileSwapper::get_peak_memory_size() const
@@ -307,6 +477,16 @@ inline size_t TextureStore::TileSwapper::get_peak_memory_size() const
     return m_peak_memory_size;
 }
 
+inline size_t TextureStore::TileSwapper::get_memory_limit() const
+{
+    return m_effective_memory_limit;
+}
+
+inline const TextureStore::TileSwapper::TextureRecordMap& TextureStore::TileSwapper::get_texture_records() const
+{
+    return m_texture_records;
+}
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_KERNEL_TEXTURING_TEXTURESTORE_H
@@ -0,0 +1,186 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "majorantgrid.h"
+
+// appleseed.renderer headers.
+#include "renderer/kernel/volume/sparsevoxelgrid.h"
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// MajorantGrid class implementation.
+//
+
+namespace
+{
+    // Compute the range of voxels along one axis that influence lookups in a given cell.
+    void get_voxel_range(
+        const size_t    cell,
+        const size_t    cell_count,
+        const size_t    voxel_count,
+        size_t&         begin,
+        size_t&         end)
+    {
+        // Extend the range by one voxel on each side to account for both nearest
+        // lookups, which map [0,1] to [0,n), and linear lookups, which map it to [0,n-1].
+        const size_t lo = cell * voxel_count / cell_count;
+        const size_t hi = ((cell + 1) * voxel_count + cell_count - 1) / cell_count;
+        begin = lo > 0 ? lo - 1 : 0;
+        end = min(hi + 1, voxel_count);
+    }
+
+    // Read the density channel of a dense voxel grid.
+    struct DenseVoxelAccessor
+    {
+        const VoxelGrid&        m_grid;
+        const size_t            m_channel_index;
+
+        DenseVoxelAccessor(const VoxelGrid& grid, const size_t channel_index)
+          : m_grid(grid)
+          , m_channel_index(channel_index)
+        {
+        }
+
+        float operator()(const size_t x, const size_t y, const size_t z) const
+        {
+            return m_grid.voxel(x, y, z)[m_channel_index];
+        }
+    };
+
+    // Read a sparse voxel grid.
+    struct SparseVoxelAccessor
+    {
+        const SparseVoxelGrid&  m_grid;
+
+        explicit SparseVoxelAccessor(const SparseVoxelGrid& grid)
+          : m_grid(grid)
+        {
+        }
+
+        float operator()(const size_t x, const size_t y, const size_t z) const
+        {
+            return m_grid.get_voxel(x, y, z);
+        }
+    };
+}
+
+MajorantGrid::MajorantGrid(
+    const VoxelGrid&        voxel_grid,
+    const size_t            density_channel_index,
+    const size_t            cell_size)
+  : m_max_majorant(0.0f)
+{
+    assert(density_channel_index < voxel_grid.get_channel_count());
+
+    const size_t voxel_res[3] =
+    {
+        voxel_grid.get_xres(),
+        voxel_grid.get_yres(),
+        voxel_grid.get_zres()
+    };
+
+    build(voxel_res, DenseVoxelAccessor(voxel_grid, density_channel_index), cell_size);
+}
+
+MajorantGrid::MajorantGrid(
+    const SparseVoxelGrid&  voxel_grid,
+    const size_t            cell_size)
+  : m_max_majorant(0.0f)
+{
+    const size_t voxel_res[3] =
+    {
+        voxel_grid.get_xres(),
+        voxel_grid.get_yres(),
+        voxel_grid.get_zres()
+    };
+
+    build(voxel_res, SparseVoxelAccessor(voxel_grid), cell_size);
+}
+
+template <typename VoxelAccessor>
+void MajorantGrid::build(
+    const size_t            voxel_res[3],
+    const VoxelAccessor&    voxel_accessor,
+    const size_t            cell_size)
+{
+    assert(cell_size > 0);
+
+    m_xres = (voxel_res[0] + cell_size - 1) / cell_size;
+    m_yres = (voxel_res[1] + cell_size - 1) / cell_size;
+    m_zres = (voxel_res[2] + cell_size - 1) / cell_size;
+    m_cells.resize(m_xres * m_yres * m_zres);
+
+    for (size_t cz = 0; cz < m_zres; ++cz)
+    {
+        size_t z_begin, z_end;
+        get_voxel_range(cz, m_zres, voxel_res[2], z_begin, z_end);
+
+        for (size_t cy = 0; cy < m_yres; ++cy)
+        {
+            size_t y_begin, y_end;
+            get_voxel_range(cy, m_yres, voxel_res[1], y_begin, y_end);
+
+            for (size_t cx = 0; cx < m_xres; ++cx)
+            {
+                size_t x_begin, x_end;
+                get_voxel_range(cx, m_xres, voxel_res[0], x_begin, x_end);
+
+                float minorant = numeric_limits<float>::max();
+                float majorant = 0.0f;
+
+                for (size_t z = z_begin; z < z_end; ++z)
+                {
+                    for (size_t y = y_begin; y < y_end; ++y)
+                    {
+                        for (size_t x = x_begin; x < x_end; ++x)
+                        {
+                            const float density = voxel_accessor(x, y, z);
+                            assert(density >= 0.0f);
+
+                            minorant = min(minorant, density);
+                            majorant = max(majorant, density);
+                        }
+                    }
+                }
+
+                Cell& cell = m_cells[(cz * m_yres + cy) * m_xres + cx];
+                cell.m_minorant = minorant;
+                cell.m_majorant = majorant;
+
+                m_max_majorant = max(m_max_majorant, majorant);
+            }
+        }
+    }
+}
+
+}   // namespace renderer
@@ -0,0 +1,490 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_RENDERER_KERNEL_VOLUME_MAJORANTGRID_H
+#define APPLESEED_RENDERER_KERNEL_VOLUME_MAJORANTGRID_H
+
+// appleseed.renderer headers.
+#include "renderer/kernel/volume/volume.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Forward declarations.
+namespace renderer  { class SparseVoxelGrid; }
+
+namespace renderer
+{
+
+//
+// A coarse grid storing, for each of its cells, the minimum and maximum density
+// of a voxel grid over the region covered by the cell. The bounds hold for both
+// nearest and trilinearly interpolated lookups of the voxel grid.
+//
+// The grid is used to sample free-flight distances with delta tracking and to
+// estimate transmittance with ratio tracking, using local bounds instead of a
+// global one: empty cells are skipped, homogeneous cells are handled analytically
+// and thin cells are crossed with large steps.
+//
+// Like the voxel grid, the majorant grid covers the unit cube [0,1]^3; rays and
+// distances are expressed in this space. It can be built from a dense voxel grid
+// or from a sparse one, whose empty bricks yield empty cells.
+//
+// References:
+//
+//   Unbiased Global Illumination with Participating Media
+//   Matthias Raab, Daniel Seibert, Alexander Keller
+//   http://www.uni-ulm.de/fileadmin/website_uni_ulm/iui.inst.100/institut/Papers/ugiwpm.pdf
+//
+//   Residual Ratio Tracking for Estimating Attenuation in Participating Media
+//   Jan Novak, Andrew Selle, Wojciech Jarosz
+//   https://cs.dartmouth.edu/~wjarosz/publications/novak14residual.html
+//
+//   A Fast Voxel Traversal Algorithm for Ray Tracing
+//   John Amanatides, Andrew Woo
+//   http://www.cse.yorku.ca/~amana/research/grid.pdf
+//
+
+class MajorantGrid
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. Each cell covers a block of cell_size^3 voxels.
+    MajorantGrid(
+        const VoxelGrid&            voxel_grid,
+        const size_t                density_channel_index,
+        const size_t                cell_size = 8);
+
+    // Constructor, builds the grid from a sparse voxel grid.
+    explicit MajorantGrid(
+        const SparseVoxelGrid&      voxel_grid,
+        const size_t                cell_size = 8);
+
+    // Get the grid properties.
+    size_t get_xres() const;
+    size_t get_yres() const;
+    size_t get_zres() const;
+
+    // Return the density bounds of a given cell.
+    float get_minorant(const size_t x, const size_t y, const size_t z) const;
+    float get_majorant(const size_t x, const size_t y, const size_t z) const;
+
+    // Return the maximum density over the whole grid.
+    float get_max_majorant() const;
+
+    // Visit the cells pierced by the segment [tmin, tmax) of a ray, front to back.
+    // For each cell with a nonzero majorant, call visitor.visit(minorant, majorant,
+    // t0, t1) with [t0, t1) the part of the segment inside the cell; traversal
+    // stops as soon as this method returns false.
+    template <typename Visitor>
+    void traverse(
+        const foundation::Vector3d& origin,
+        const foundation::Vector3d& direction,
+        const double                tmin,
+        const double                tmax,
+        Visitor&                    visitor) const;
+
+    // Sample a free-flight distance along a ray with delta tracking. The extinction
+    // coefficient at a point is density_scale * density(point), where density(point)
+    // returns the density of the voxel grid. Return true and the distance to the
+    // collision if one happens in [tmin, tmax), false otherwise.
+    template <typename DensityFunction, typename RNG>
+    bool sample_distance(
+        const foundation::Vector3d& origin,
+        const foundation::Vector3d& direction,
+        const double                tmin,
+        const double                tmax,
+        const float                 density_scale,
+        const DensityFunction&      density,
+        RNG&                        rng,
+        double&                     distance) const;
+
+    // Estimate the transmittance along the segment [tmin, tmax) of a ray with ratio tracking.
+    template <typename DensityFunction, typename RNG>
+    float evaluate_transmittance(
+        const foundation::Vector3d& origin,
+        const foundation::Vector3d& direction,
+        const double                tmin,
+        const double                tmax,
+        const float                 density_scale,
+        const DensityFunction&      density,
+        RNG&                        rng) const;
+
+  private:
+    struct Cell
+    {
+        float   m_minorant;
+        float   m_majorant;
+    };
+
+    size_t                          m_xres;
+    size_t                          m_yres;
+    size_t                          m_zres;
+    std::vector<Cell>               m_cells;
+    float                           m_max_majorant;
+
+    const Cell& cell(const size_t x, const size_t y, const size_t z) const;
+
+    template <typename VoxelAccessor>
+    void build(
+        const size_t                voxel_res[3],
+        const VoxelAccessor&        voxel_accessor,
+        const size_t                cell_size);
+
+    template <typename DensityFunction, typename RNG>
+    struct DeltaTrackingVisitor;
+
+    template <typename DensityFunction, typename RNG>
+    struct RatioTrackingVisitor;
+};
+
+
+//
+// MajorantGrid class implementation.
+//
+
+inline size_t MajorantGrid::get_xres() const
+{
+    return m_xres;
+}
+
+inline size_t MajorantGrid::get_yres() const
+{
+    return m_yres;
+}
+
+inline size_t MajorantGrid::get_zres() const
+{
+    return m_zres;
+}
+
+inline const MajorantGrid::Cell& MajorantGrid::cell(const size_t x, const size_t y, const size_t z) const
+{
+    assert(x < m_xres);
+    assert(y < m_yres);
+    assert(z < m_zres);
+    return m_cells[(z * m_yres + y) * m_xres + x];
+}
+
+inline float MajorantGrid::get_minorant(const size_t x, const size_t y, const size_t z) const
+{
+    return cell(x, y, z).m_minorant;
+}
+
+inline float MajorantGrid::get_majorant(const size_t x, const size_t y, const size_t z) const
+{
+    return cell(x, y, z).m_majorant;
+}
+
+inline float MajorantGrid::get_max_majorant() const
+{
+    return m_max_majorant;
+}
+
+template <typename Visitor>
+void MajorantGrid::traverse(
+    const foundation::Vector3d&     origin,
+    const foundation::Vector3d&     direction,
+    const double                    tmin,
+    const double                    tmax,
+    Visitor&                        visitor) const
+{
+    const size_t res[3] = { m_xres, m_yres, m_zres };
+
+    double t_begin = tmin;
+    double t_end = tmax;
+
+    // Clip the segment to the unit cube.
+    for (size_t i = 0; i < 3; ++i)
+    {
+        if (direction[i] == 0.0)
+        {
+            if (origin[i] < 0.0 || origin[i] > 1.0)
+                return;
+        }
+        else
+        {
+            const double rcp_dir = 1.0 / direction[i];
+            double t0 = -origin[i] * rcp_dir;
+            double t1 = (1.0 - origin[i]) * rcp_dir;
+            if (t0 > t1)
+                std::swap(t0, t1);
+            t_begin = std::max(t_begin, t0);
+            t_end = std::min(t_end, t1);
+        }
+    }
+
+    if (t_begin >= t_end)
+        return;
+
+    // Find the cell containing the entry point and set up the traversal.
+    size_t cell_index[3];
+    int step[3];
+    double t_next[3];
+    double t_delta[3];
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const double p = (origin[i] + t_begin * direction[i]) * res[i];
+        cell_index[i] =
+            std::min(
+                foundation::truncate<size_t>(std::max(p, 0.0)),
+                res[i] - 1);
+
+        if (direction[i] > 0.0)
+        {
+            step[i] = +1;
+            t_next[i] = ((cell_index[i] + 1.0) / res[i] - origin[i]) / direction[i];
+            t_delta[i] = 1.0 / (res[i] * direction[i]);
+        }
+        else if (direction[i] < 0.0)
+        {
+            step[i] = -1;
+            t_next[i] = (static_cast<double>(cell_index[i]) / res[i] - origin[i]) / direction[i];
+            t_delta[i] = -1.0 / (res[i] * direction[i]);
+        }
+        else
+        {
+            step[i] = 0;
+            t_next[i] = std::numeric_limits<double>::max();
+            t_delta[i] = std::numeric_limits<double>::max();
+        }
+    }
+
+    double t = t_begin;
+
+    while (true)
+    {
+        // Find the axis along which the ray leaves the current cell.
+        const size_t axis =
+            t_next[0] < t_next[1]
+                ? (t_next[0] < t_next[2] ? 0 : 2)
+                : (t_next[1] < t_next[2] ? 1 : 2);
+
+        const double t_exit = std::min(t_next[axis], t_end);
+
+        const Cell& c = cell(cell_index[0], cell_index[1], cell_index[2]);
+        if (c.m_majorant > 0.0f && t_exit > t)
+        {
+            if (!visitor.visit(c.m_minorant, c.m_majorant, t, t_exit))
+                return;
+        }
+
+        if (t_exit >= t_end)
+            return;
+
+        // Move to the next cell.
+        if (step[axis] > 0 ? cell_index[axis] + 1 >= res[axis] : cell_index[axis] == 0)
+            return;
+
+        cell_index[axis] += step[axis];
+        t = t_exit;
+        t_next[axis] += t_delta[axis];
+    }
+}
+
+template <typename DensityFunction, typename RNG>
+struct MajorantGrid::DeltaTrackingVisitor
+{
+    const foundation::Vector3d&     m_origin;
+    const foundation::Vector3d&     m_direction;
+    const float                     m_density_scale;
+    const DensityFunction&          m_density;
+    RNG&                            m_rng;
+    bool                            m_collided;
+    double                          m_distance;
+
+    DeltaTrackingVisitor(
+        const foundation::Vector3d& origin,
+        const foundation::Vector3d& direction,
+        const float                 density_scale,
+        const DensityFunction&      density,
+        RNG&                        rng)
+      : m_origin(origin)
+      , m_direction(direction)
+      , m_density_scale(density_scale)
+      , m_density(density)
+      , m_rng(rng)
+      , m_collided(false)
+      , m_distance(0.0)
+    {
+    }
+
+    bool visit(
+        const float                 minorant,
+        const float                 majorant,
+        const double                t0,
+        const double                t1)
+    {
+        const double sigma_max = static_cast<double>(m_density_scale) * majorant;
+
+        for (double t = t0; ; )
+        {
+            // Take a tentative step according to the local majorant.
+            t -= std::log(1.0 - foundation::rand1<double>(m_rng)) / sigma_max;
+            if (t >= t1)
+                return true;
+
+            // In homogeneous cells, every tentative collision is a real one.
+            if (minorant == majorant)
+            {
+                m_collided = true;
+                m_distance = t;
+                return false;
+            }
+
+            const float sigma = m_density_scale * m_density(m_origin + t * m_direction);
+            if (foundation::rand1<double>(m_rng) * sigma_max < sigma)
+            {
+                m_collided = true;
+                m_distance = t;
+                return false;
+            }
+        }
+    }
+};
+
+template <typename DensityFunction, typename RNG>
+bool MajorantGrid::sample_distance(
+    const foundation::Vector3d&     origin,
+    const foundation::Vector3d&     direction,
+    const double                    tmin,
+    const double                    tmax,
+    const float                     density_scale,
+    const DensityFunction&          density,
+    RNG&                            rng,
+    double&                         distance) const
+{
+    if (density_scale <= 0.0f)
+        return false;
+
+    DeltaTrackingVisitor<DensityFunction, RNG> visitor(origin, direction, density_scale, density, rng);
+    traverse(origin, direction, tmin, tmax, visitor);
+
+    distance = visitor.m_distance;
+    return visitor.m_collided;
+}
+
+template <typename DensityFunction, typename RNG>
+struct MajorantGrid::RatioTrackingVisitor
+{
+    const foundation::Vector3d&     m_origin;
+    const foundation::Vector3d&     m_direction;
+    const float                     m_density_scale;
+    const DensityFunction&          m_density;
+    RNG&                            m_rng;
+    double                          m_transmittance;
+
+    RatioTrackingVisitor(
+        const foundation::Vector3d& origin,
+        const foundation::Vector3d& direction,
+        const float                 density_scale,
+        const DensityFunction&      density,
+        RNG&                        rng)
+      : m_origin(origin)
+      , m_direction(direction)
+      , m_density_scale(density_scale)
+      , m_density(density)
+      , m_rng(rng)
+      , m_transmittance(1.0)
+    {
+    }
+
+    bool visit(
+        const float                 minorant,
+        const float                 majorant,
+        const double                t0,
+        const double                t1)
+    {
+        const double sigma_max = static_cast<double>(m_density_scale) * majorant;
+
+        // Homogeneous cells are crossed analytically.
+        if (minorant == majorant)
+            m_transmittance *= std::exp(-sigma_max * (t1 - t0));
+        else
+        {
+            for (double t = t0; ; )
+            {
+                t -= std::log(1.0 - foundation::rand1<double>(m_rng)) / sigma_max;
+                if (t >= t1)
+                    break;
+
+                const float sigma = m_density_scale * m_density(m_origin + t * m_direction);
+                m_transmittance *= 1.0 - sigma / sigma_max;
+            }
+        }
+
+        // Russian Roulette once the transmittance becomes small.
+        const double RRThreshold = 0.1;
+        if (m_transmittance < RRThreshold)
+        {
+            if (foundation::rand1<double>(m_rng) >= m_transmittance / RRThreshold)
+            {
+                m_transmittance = 0.0;
+                return false;
+            }
+
+            m_transmittance = RRThreshold;
+        }
+
+        return true;
+    }
+};
+
+template <typename DensityFunction, typename RNG>
+float MajorantGrid::evaluate_transmittance(
+    const foundation::Vector3d&     origin,
+    const foundation::Vector3d&     direction,
+    const double                    tmin,
+    const double                    tmax,
+    const float                     density_scale,
+    const DensityFunction&          density,
+    RNG&                            rng) const
+{
+    if (density_scale <= 0.0f)
+        return 1.0f;
+
+    RatioTrackingVisitor<DensityFunction, RNG> visitor(origin, direction, density_scale, density, rng);
+    traverse(origin, direction, tmin, tmax, visitor);
+
+    return static_cast<float>(visitor.m_transmittance);
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_VOLUME_MAJORANTGRID_H
@@ -0,0 +1,160 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "sparsevoxelgrid.h"
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// SparseVoxelGrid class implementation.
+//
+
+const size_t SparseVoxelGrid::BrickSize;
+const uint32 SparseVoxelGrid::EmptyBrick;
+const size_t SparseVoxelGrid::BrickVoxelCount;
+
+SparseVoxelGrid::SparseVoxelGrid(
+    const size_t        nx,
+    const size_t        ny,
+    const size_t        nz,
+    const Storage       storage)
+  : m_nx(nx)
+  , m_ny(ny)
+  , m_nz(nz)
+  , m_scalar_nx(static_cast<double>(nx))
+  , m_scalar_ny(static_cast<double>(ny))
+  , m_scalar_nz(static_cast<double>(nz))
+  , m_max_x(static_cast<double>(nx - 1))
+  , m_max_y(static_cast<double>(ny - 1))
+  , m_max_z(static_cast<double>(nz - 1))
+  , m_brick_nx((nx + BrickSize - 1) / BrickSize)
+  , m_brick_ny((ny + BrickSize - 1) / BrickSize)
+  , m_brick_nz((nz + BrickSize - 1) / BrickSize)
+  , m_storage(storage)
+  , m_brick_index(m_brick_nx * m_brick_ny * m_brick_nz, EmptyBrick)
+{
+    assert(m_nx > 0);
+    assert(m_ny > 0);
+    assert(m_nz > 0);
+}
+
+SparseVoxelGrid::SparseVoxelGrid(
+    const VoxelGrid&    voxel_grid,
+    const size_t        channel_index,
+    const Storage       storage)
+  : m_nx(voxel_grid.get_xres())
+  , m_ny(voxel_grid.get_yres())
+  , m_nz(voxel_grid.get_zres())
+  , m_scalar_nx(static_cast<double>(m_nx))
+  , m_scalar_ny(static_cast<double>(m_ny))
+  , m_scalar_nz(static_cast<double>(m_nz))
+  , m_max_x(static_cast<double>(m_nx - 1))
+  , m_max_y(static_cast<double>(m_ny - 1))
+  , m_max_z(static_cast<double>(m_nz - 1))
+  , m_brick_nx((m_nx + BrickSize - 1) / BrickSize)
+  , m_brick_ny((m_ny + BrickSize - 1) / BrickSize)
+  , m_brick_nz((m_nz + BrickSize - 1) / BrickSize)
+  , m_storage(storage)
+  , m_brick_index(m_brick_nx * m_brick_ny * m_brick_nz, EmptyBrick)
+{
+    assert(channel_index < voxel_grid.get_channel_count());
+
+    for (size_t z = 0; z < m_nz; ++z)
+    {
+        for (size_t y = 0; y < m_ny; ++y)
+        {
+            for (size_t x = 0; x < m_nx; ++x)
+            {
+                const float value = voxel_grid.voxel(x, y, z)[channel_index];
+                if (value != 0.0f)
+                    set_voxel(x, y, z, value);
+            }
+        }
+    }
+}
+
+size_t SparseVoxelGrid::get_brick_count() const
+{
+    return
+        m_storage == StorageFloat
+            ? m_float_values.size() / BrickVoxelCount
+            : m_half_values.size() / BrickVoxelCount;
+}
+
+size_t SparseVoxelGrid::get_memory_size() const
+{
+    return
+          sizeof(*this)
+        + m_brick_index.capacity() * sizeof(uint32)
+        + m_float_values.capacity() * sizeof(float)
+        + m_half_values.capacity() * sizeof(half);
+}
+
+void SparseVoxelGrid::set_voxel(
+    const size_t        x,
+    const size_t        y,
+    const size_t        z,
+    const float         value)
+{
+    assert(x < m_nx);
+    assert(y < m_ny);
+    assert(z < m_nz);
+
+    uint32& brick =
+        m_brick_index[((z / BrickSize) * m_brick_ny + y / BrickSize) * m_brick_nx + x / BrickSize];
+
+    if (brick == EmptyBrick)
+    {
+        // Empty bricks only hold zeros.
+        if (value == 0.0f)
+            return;
+
+        // Allocate the brick.
+        brick = static_cast<uint32>(get_brick_count());
+        if (m_storage == StorageFloat)
+            m_float_values.resize(m_float_values.size() + BrickVoxelCount, 0.0f);
+        else m_half_values.resize(m_half_values.size() + BrickVoxelCount, half(0.0f));
+    }
+
+    const size_t lx = x % BrickSize;
+    const size_t ly = y % BrickSize;
+    const size_t lz = z % BrickSize;
+    const size_t value_index = brick * BrickVoxelCount + (lz * BrickSize + ly) * BrickSize + lx;
+
+    if (m_storage == StorageFloat)
+        m_float_values[value_index] = value;
+    else m_half_values[value_index] = half(value);
+}
+
+}   // namespace renderer
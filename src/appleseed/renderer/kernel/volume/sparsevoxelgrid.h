@@ -0,0 +1,385 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_RENDERER_KERNEL_VOLUME_SPARSEVOXELGRID_H
+#define APPLESEED_RENDERER_KERNEL_VOLUME_SPARSEVOXELGRID_H
+
+// appleseed.renderer headers.
+#include "renderer/kernel/volume/volume.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+#ifdef APPLESEED_USE_SSE
+#include "foundation/platform/sse.h"
+#endif
+
+// OpenEXR headers.
+#include "foundation/platform/exrheaderguards.h"
+BEGIN_EXR_INCLUDES
+#include "OpenEXR/half.h"
+END_EXR_INCLUDES
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A sparse voxel grid storing a single scalar field, such as the density or the
+// temperature of a smoke simulation.
+//
+// Voxels are grouped into bricks of 8x8x8 voxels. A top-level index maps each
+// brick to its storage, or marks it as empty when all its voxels are zero, in
+// which case it only costs the 4 bytes of its index entry. Values can be stored
+// as half floats to halve the size of the remaining bricks.
+//
+// Like VoxelGrid, the grid covers the unit cube [0,1]^3 and lookups follow the
+// same conventions, so that a MajorantGrid built from a sparse grid bounds its
+// lookups too.
+//
+
+class SparseVoxelGrid
+  : public foundation::NonCopyable
+{
+  public:
+    // Storage format of the voxel values.
+    enum Storage
+    {
+        StorageFloat,
+        StorageHalf
+    };
+
+    // Size of a brick along each axis, in voxels.
+    static const size_t BrickSize = 8;
+
+    // Constructor, creates an empty grid (all voxels are zero).
+    SparseVoxelGrid(
+        const size_t                nx,
+        const size_t                ny,
+        const size_t                nz,
+        const Storage               storage = StorageFloat);
+
+    // Constructor, copies one channel of a dense voxel grid.
+    SparseVoxelGrid(
+        const VoxelGrid&            voxel_grid,
+        const size_t                channel_index,
+        const Storage               storage = StorageFloat);
+
+    // Get the grid properties.
+    size_t get_xres() const;
+    size_t get_yres() const;
+    size_t get_zres() const;
+    Storage get_storage() const;
+
+    // Return the number of allocated (non-empty) bricks.
+    size_t get_brick_count() const;
+
+    // Return the size in bytes of the grid.
+    size_t get_memory_size() const;
+
+    // Set the value of a given voxel. The brick containing the voxel is allocated
+    // the first time one of its voxels is set to a nonzero value.
+    void set_voxel(
+        const size_t                x,
+        const size_t                y,
+        const size_t                z,
+        const float                 value);
+
+    // Return the value of a given voxel.
+    float get_voxel(
+        const size_t                x,
+        const size_t                y,
+        const size_t                z) const;
+
+    // Perform an unfiltered lookup of the grid.
+    // 'point' must be expressed in the unit cube [0,1]^3.
+    float nearest_lookup(const foundation::Vector3d& point) const;
+
+    // Perform a trilinearly interpolated lookup of the grid.
+    // 'point' must be expressed in the unit cube [0,1]^3.
+    float linear_lookup(const foundation::Vector3d& point) const;
+
+  private:
+    static const foundation::uint32 EmptyBrick = ~foundation::uint32(0);
+    static const size_t BrickVoxelCount = BrickSize * BrickSize * BrickSize;
+
+    const size_t                    m_nx;
+    const size_t                    m_ny;
+    const size_t                    m_nz;
+    const double                    m_scalar_nx;
+    const double                    m_scalar_ny;
+    const double                    m_scalar_nz;
+    const double                    m_max_x;
+    const double                    m_max_y;
+    const double                    m_max_z;
+    const size_t                    m_brick_nx;
+    const size_t                    m_brick_ny;
+    const size_t                    m_brick_nz;
+    const Storage                   m_storage;
+    std::vector<foundation::uint32> m_brick_index;
+    std::vector<float>              m_float_values;
+    std::vector<half>               m_half_values;
+
+    foundation::uint32 get_brick(
+        const size_t                x,
+        const size_t                y,
+        const size_t                z) const;
+
+    float get_brick_value(
+        const size_t                value_index) const;
+
+    // Fetch the eight voxels surrounding a lookup point, ordered as (x0, y0 z0),
+    // (x0, y1 z0), (x0, y0 z1), (x0, y1 z1), then the same with x1.
+    void fetch_corners(
+        const size_t                ix,
+        const size_t                iy,
+        const size_t                iz,
+        float                       corners[8]) const;
+};
+
+
+//
+// Density function reading a sparse voxel grid, for use with
+// MajorantGrid::sample_distance() and MajorantGrid::evaluate_transmittance().
+//
+
+class SparseVoxelGridDensity
+{
+  public:
+    explicit SparseVoxelGridDensity(const SparseVoxelGrid& grid);
+
+    float operator()(const foundation::Vector3d& point) const;
+
+  private:
+    const SparseVoxelGrid&          m_grid;
+};
+
+
+//
+// SparseVoxelGrid class implementation.
+//
+
+inline size_t SparseVoxelGrid::get_xres() const
+{
+    return m_nx;
+}
+
+inline size_t SparseVoxelGrid::get_yres() const
+{
+    return m_ny;
+}
+
+inline size_t SparseVoxelGrid::get_zres() const
+{
+    return m_nz;
+}
+
+inline SparseVoxelGrid::Storage SparseVoxelGrid::get_storage() const
+{
+    return m_storage;
+}
+
+APPLESEED_FORCE_INLINE foundation::uint32 SparseVoxelGrid::get_brick(
+    const size_t                    x,
+    const size_t                    y,
+    const size_t                    z) const
+{
+    assert(x < m_nx);
+    assert(y < m_ny);
+    assert(z < m_nz);
+
+    const size_t bx = x / BrickSize;
+    const size_t by = y / BrickSize;
+    const size_t bz = z / BrickSize;
+
+    return m_brick_index[(bz * m_brick_ny + by) * m_brick_nx + bx];
+}
+
+APPLESEED_FORCE_INLINE float SparseVoxelGrid::get_brick_value(
+    const size_t                    value_index) const
+{
+    return
+        m_storage == StorageFloat
+            ? m_float_values[value_index]
+            : static_cast<float>(m_half_values[value_index]);
+}
+
+APPLESEED_FORCE_INLINE float SparseVoxelGrid::get_voxel(
+    const size_t                    x,
+    const size_t                    y,
+    const size_t                    z) const
+{
+    const foundation::uint32 brick = get_brick(x, y, z);
+
+    if (brick == EmptyBrick)
+        return 0.0f;
+
+    const size_t lx = x % BrickSize;
+    const size_t ly = y % BrickSize;
+    const size_t lz = z % BrickSize;
+
+    return get_brick_value(brick * BrickVoxelCount + (lz * BrickSize + ly) * BrickSize + lx);
+}
+
+APPLESEED_FORCE_INLINE void SparseVoxelGrid::fetch_corners(
+    const size_t                    ix,
+    const size_t                    iy,
+    const size_t                    iz,
+    float                           corners[8]) const
+{
+    // Voxels on the upper boundaries of the grid are repeated.
+    const size_t dx = ix + 1 < m_nx ? 1 : 0;
+    const size_t dy = iy + 1 < m_ny ? 1 : 0;
+    const size_t dz = iz + 1 < m_nz ? 1 : 0;
+
+    const size_t lx = ix % BrickSize;
+    const size_t ly = iy % BrickSize;
+    const size_t lz = iz % BrickSize;
+
+    if (lx + 1 < BrickSize && ly + 1 < BrickSize && lz + 1 < BrickSize)
+    {
+        // All eight voxels are in the same brick.
+        const foundation::uint32 brick = get_brick(ix, iy, iz);
+
+        if (brick == EmptyBrick)
+        {
+            for (size_t i = 0; i < 8; ++i)
+                corners[i] = 0.0f;
+            return;
+        }
+
+        const size_t sy = dy * BrickSize;
+        const size_t sz = dz * BrickSize * BrickSize;
+        const size_t base = brick * BrickVoxelCount + (lz * BrickSize + ly) * BrickSize + lx;
+
+        corners[0] = get_brick_value(base);
+        corners[1] = get_brick_value(base + sy);
+        corners[2] = get_brick_value(base + sz);
+        corners[3] = get_brick_value(base + sy + sz);
+        corners[4] = get_brick_value(base + dx);
+        corners[5] = get_brick_value(base + dx + sy);
+        corners[6] = get_brick_value(base + dx + sz);
+        corners[7] = get_brick_value(base + dx + sy + sz);
+    }
+    else
+    {
+        // The voxels straddle bricks.
+        corners[0] = get_voxel(ix,      iy,      iz);
+        corners[1] = get_voxel(ix,      iy + dy, iz);
+        corners[2] = get_voxel(ix,      iy,      iz + dz);
+        corners[3] = get_voxel(ix,      iy + dy, iz + dz);
+        corners[4] = get_voxel(ix + dx, iy,      iz);
+        corners[5] = get_voxel(ix + dx, iy + dy, iz);
+        corners[6] = get_voxel(ix + dx, iy,      iz + dz);
+        corners[7] = get_voxel(ix + dx, iy + dy, iz + dz);
+    }
+}
+
+inline float SparseVoxelGrid::nearest_lookup(const foundation::Vector3d& point) const
+{
+    // Compute the coordinates of the voxel containing the lookup point.
+    const double x = foundation::clamp(point.x * m_scalar_nx, 0.0, m_max_x);
+    const double y = foundation::clamp(point.y * m_scalar_ny, 0.0, m_max_y);
+    const double z = foundation::clamp(point.z * m_scalar_nz, 0.0, m_max_z);
+
+    return
+        get_voxel(
+            foundation::truncate<size_t>(x),
+            foundation::truncate<size_t>(y),
+            foundation::truncate<size_t>(z));
+}
+
+inline float SparseVoxelGrid::linear_lookup(const foundation::Vector3d& point) const
+{
+    // Compute the coordinates of the voxel containing the lookup point.
+    const double x = foundation::saturate(point.x) * m_max_x;
+    const double y = foundation::saturate(point.y) * m_max_y;
+    const double z = foundation::saturate(point.z) * m_max_z;
+    const size_t ix = foundation::truncate<size_t>(x);
+    const size_t iy = foundation::truncate<size_t>(y);
+    const size_t iz = foundation::truncate<size_t>(z);
+
+    // Fetch the surrounding voxels.
+    APPLESEED_SIMD4_ALIGN float corners[8];
+    fetch_corners(ix, iy, iz, corners);
+
+    // Compute interpolation weights.
+    const float x1 = static_cast<float>(x - ix);
+    const float y1 = static_cast<float>(y - iy);
+    const float z1 = static_cast<float>(z - iz);
+    const float x0 = 1.0f - x1;
+    const float y0 = 1.0f - y1;
+    const float z0 = 1.0f - z1;
+
+#ifdef APPLESEED_USE_SSE
+
+    // Blend along x, then weight by the y and z weights and sum.
+    const __m128 yz = _mm_set_ps(y1 * z1, y0 * z1, y1 * z0, y0 * z0);
+    const __m128 vx0 = _mm_load_ps(corners);
+    const __m128 vx1 = _mm_load_ps(corners + 4);
+    const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(vx0, _mm_set1_ps(x0)), _mm_mul_ps(vx1, _mm_set1_ps(x1))), yz);
+    const __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1))));
+
+#else
+
+    return
+          (corners[0] * x0 + corners[4] * x1) * (y0 * z0)
+        + (corners[1] * x0 + corners[5] * x1) * (y1 * z0)
+        + (corners[2] * x0 + corners[6] * x1) * (y0 * z1)
+        + (corners[3] * x0 + corners[7] * x1) * (y1 * z1);
+
+#endif
+}
+
+
+//
+// SparseVoxelGridDensity class implementation.
+//
+
+inline SparseVoxelGridDensity::SparseVoxelGridDensity(const SparseVoxelGrid& grid)
+  : m_grid(grid)
+{
+}
+
+inline float SparseVoxelGridDensity::operator()(const foundation::Vector3d& point) const
+{
+    return m_grid.linear_lookup(point);
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_KERNEL_VOLUME_SPARSEVOXELGRID_H
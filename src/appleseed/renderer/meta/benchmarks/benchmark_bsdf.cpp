@@ -0,0 +1,468 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/lighting/scatteringmode.h"
+#include "renderer/kernel/lighting/tracer.h"
+#include "renderer/kernel/rendering/rendererservices.h"
+#include "renderer/kernel/shading/oslshadergroupexec.h"
+#include "renderer/kernel/shading/shadingcontext.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/bsdf/bsdf.h"
+#include "renderer/modeling/bsdf/bsdffactoryregistrar.h"
+#include "renderer/modeling/bsdf/bsdfsample.h"
+#include "renderer/modeling/bsdf/ibsdffactory.h"
+#include "renderer/modeling/bsdf/lambertianbrdf.h"
+#include "renderer/modeling/entity/onframebeginrecorder.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/meshobjectprimitives.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/project/project.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/visibilityflags.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/math/basis.h"
+#include "foundation/math/dual.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/sampling/mappings.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/arena.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/benchmark.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/otherwise.h"
+#include "foundation/utility/string.h"
+
+// OSL headers.
+#include "foundation/platform/oslheaderguards.h"
+BEGIN_OSL_INCLUDES
+#include "OSL/oslexec.h"
+END_OSL_INCLUDES
+
+// OpenImageIO headers.
+#include "foundation/platform/oiioheaderguards.h"
+BEGIN_OIIO_INCLUDES
+#include "OpenImageIO/texture.h"
+END_OIIO_INCLUDES
+
+// Boost headers.
+#include "boost/bind.hpp"
+#include "boost/shared_ptr.hpp"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+BENCHMARK_SUITE(Renderer_Modeling_BSDF)
+{
+    //
+    // One benchmark case is registered for every combination of BSDF model (as
+    // returned by the BSDF factory registrar), operation and spectrum representation,
+    // so that new BSDF models get benchmarked without any change to this file.
+    //
+
+    enum Operation
+    {
+        Sample,
+        Evaluate,
+        EvaluatePDF,
+        OperationCount
+    };
+
+    const char* const OperationNames[OperationCount] =
+    {
+        "Sample",
+        "Evaluate",
+        "EvaluatePDF"
+    };
+
+    // Everything required to build a shading context.
+    struct ShadingContextStorage
+    {
+        TextureStore                                m_texture_store;
+        TextureCache                                m_texture_cache;
+        boost::shared_ptr<OIIO::TextureSystem>      m_texture_system;
+        RendererServices                            m_renderer_services;
+        boost::shared_ptr<OSL::ShadingSystem>       m_shading_system;
+        Intersector                                 m_intersector;
+        Arena                                       m_arena;
+        OSLShaderGroupExec                          m_sg_exec;
+        Tracer                                      m_tracer;
+        ShadingContext                              m_shading_context;
+
+        ShadingContextStorage(Project& project, Scene& scene)
+          : m_texture_store(scene)
+          , m_texture_cache(m_texture_store)
+          , m_texture_system(
+                OIIO::TextureSystem::create(),
+                boost::bind(&OIIO::TextureSystem::destroy, _1))
+          , m_renderer_services(project, *m_texture_system)
+          , m_shading_system(new OSL::ShadingSystem(&m_renderer_services, m_texture_system.get()))
+          , m_intersector(project.get_trace_context(), m_texture_cache)
+          , m_sg_exec(*m_shading_system, m_arena)
+          , m_tracer(scene, m_intersector, m_texture_cache, m_sg_exec)
+          , m_shading_context(
+                m_intersector,
+                m_tracer,
+                m_texture_cache,
+                *m_texture_system,
+                m_sg_exec,
+                m_arena,
+                0)
+        {
+        }
+    };
+
+    class BSDFBenchmarkCase
+      : public IBenchmarkCase
+      , private TestFixtureBase
+    {
+      public:
+        BSDFBenchmarkCase(
+            const string&       name,
+            const string&       model,
+            const Operation     operation,
+            const bool          spectral)
+          : m_name(name)
+          , m_operation(operation)
+          , m_rng_state(0)
+          , m_sampling_context(
+                m_rng_state,
+                SamplingContext::RNGMode,
+                0,                              // number of dimensions
+                0,                              // number of samples -- unknown
+                0)                              // initial instance number
+          , m_bsdf(0)
+          , m_data(0)
+          , m_dummy(0.0f)
+        {
+            create_scene(spectral);
+            create_bsdf(model);
+
+            bind_inputs();
+
+            m_project.update_trace_context();
+
+            APPLESEED_UNUSED const bool success = m_scene.on_frame_begin(m_project, 0, m_recorder);
+            assert(success);
+
+            m_storage.reset(new ShadingContextStorage(m_project, m_scene));
+
+            // Hit the sphere at the top, where its normal is +Z.
+            const ShadingRay ray(
+                Vector3d(0.0, 0.0, 4.0),
+                Vector3d(0.0, 0.0, -1.0),
+                0.0,                                // tmin
+                numeric_limits<double>::max(),      // tmax
+                ShadingRay::Time(),
+                VisibilityFlags::CameraRay,
+                0);                                 // depth
+            APPLESEED_UNUSED const bool hit = m_storage->m_intersector.trace(ray, m_shading_point);
+            assert(hit);
+
+            m_data = m_bsdf->evaluate_inputs(m_storage->m_shading_context, m_shading_point);
+
+            generate_directions();
+        }
+
+        ~BSDFBenchmarkCase()
+        {
+            m_storage.reset();
+            m_recorder.on_frame_end(m_project);
+        }
+
+        virtual const char* get_name() const APPLESEED_OVERRIDE
+        {
+            return m_name.c_str();
+        }
+
+        virtual void run() APPLESEED_OVERRIDE
+        {
+            switch (m_operation)
+            {
+              case Sample:
+                for (size_t i = 0; i < DirectionCount; ++i)
+                {
+                    BSDFSample sample(&m_shading_point, Dual3f(m_outgoing[i]));
+                    m_bsdf->sample(m_sampling_context, m_data, false, true, sample);
+                    m_dummy += sample.m_probability;
+                }
+                break;
+
+              case Evaluate:
+                for (size_t i = 0; i < DirectionCount; ++i)
+                {
+                    Spectrum value;
+                    m_dummy +=
+                        m_bsdf->evaluate(
+                            m_data,
+                            false,
+                            true,
+                            m_geometric_normal,
+                            m_shading_basis,
+                            m_outgoing[i],
+                            m_incoming[i],
+                            ScatteringMode::All,
+                            value);
+                }
+                break;
+
+              case EvaluatePDF:
+                for (size_t i = 0; i < DirectionCount; ++i)
+                {
+                    m_dummy +=
+                        m_bsdf->evaluate_pdf(
+                            m_data,
+                            m_geometric_normal,
+                            m_shading_basis,
+                            m_outgoing[i],
+                            m_incoming[i],
+                            ScatteringMode::All);
+                }
+                break;
+
+              assert_otherwise;
+            }
+        }
+
+      private:
+        static const size_t DirectionCount = 64;
+
+        const string                        m_name;
+        const Operation                     m_operation;
+        OnFrameBeginRecorder                m_recorder;
+        auto_ptr<ShadingContextStorage>     m_storage;
+        ShadingPoint                        m_shading_point;
+        SamplingContext::RNGType            m_rng_state;
+        SamplingContext                     m_sampling_context;
+        const BSDF*                         m_bsdf;
+        void*                               m_data;
+        Vector3f                            m_geometric_normal;
+        Basis3f                             m_shading_basis;
+        Vector3f                            m_outgoing[DirectionCount];
+        Vector3f                            m_incoming[DirectionCount];
+        float                               m_dummy;
+
+        void create_scene(const bool spectral)
+        {
+            if (spectral)
+            {
+                float values[Spectrum::Samples];
+                for (size_t i = 0; i < Spectrum::Samples; ++i)
+                    values[i] = 0.2f + 0.6f * static_cast<float>(i) / (Spectrum::Samples - 1);
+                create_color_entity("color", Spectrum(values));
+            }
+            else create_color_entity("color", Color3f(0.8f, 0.5f, 0.2f));
+
+            m_assembly.objects().insert(
+                auto_release_ptr<Object>(
+                    create_primitive_mesh(
+                        "object",
+                        ParamArray().insert("primitive", "sphere"))));
+
+            m_assembly.object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "object_instance",
+                    ParamArray(),
+                    "object",
+                    Transformd::identity(),
+                    StringDictionary()));
+
+            m_scene.assembly_instances().insert(
+                AssemblyInstanceFactory::create(
+                    "assembly_instance",
+                    ParamArray(),
+                    "assembly"));
+        }
+
+        // Create the BSDF with its default parameters, except for colors which are bound to
+        // the color entity, and child BSDFs which are Lambertian BRDFs.
+        void create_bsdf(const string& model)
+        {
+            const BSDFFactoryRegistrar registrar;
+            const IBSDFFactory* factory = registrar.lookup(model.c_str());
+            assert(factory);
+
+            ParamArray params;
+            size_t child_count = 0;
+
+            const DictionaryArray metadata = factory->get_input_metadata();
+
+            for (size_t i = 0; i < metadata.size(); ++i)
+            {
+                const Dictionary& input = metadata[i];
+                const string name = input.get<string>("name");
+                const string type = input.get<string>("type");
+
+                const bool accepts_colors =
+                    input.dictionaries().exist("entity_types") &&
+                    input.dictionary("entity_types").strings().exist("color");
+
+                if (type == "entity")
+                {
+                    const string child_name = "child" + to_string(child_count++);
+                    m_assembly.bsdfs().insert(
+                        LambertianBRDFFactory().create(
+                            child_name.c_str(),
+                            ParamArray().insert("reflectance", "color")));
+                    params.insert(name, child_name);
+                }
+                else if (accepts_colors)
+                    params.insert(name, "color");
+                else if (input.strings().exist("default"))
+                    params.insert(name, input.get<string>("default"));
+            }
+
+            auto_release_ptr<BSDF> bsdf(factory->create("bsdf", params));
+            m_bsdf = bsdf.get();
+            m_assembly.bsdfs().insert(bsdf);
+        }
+
+        // Generate pairs of directions around the shading normal. For BSDFs that transmit
+        // light, half of the incoming directions are on the other side of the surface.
+        void generate_directions()
+        {
+            m_geometric_normal = Vector3f(m_shading_point.get_geometric_normal());
+            m_shading_basis = Basis3f(m_shading_point.get_shading_basis());
+
+            const bool transmissive = (m_bsdf->get_type() & BSDF::Transmissive) != 0;
+
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < DirectionCount; ++i)
+            {
+                Vector2f s;
+                s[0] = rand_float2(rng);
+                s[1] = rand_float2(rng);
+                m_outgoing[i] = m_shading_basis.transform_to_parent(sample_hemisphere_cosine(s));
+
+                s[0] = rand_float2(rng);
+                s[1] = rand_float2(rng);
+                Vector3f incoming = sample_hemisphere_cosine(s);
+                if (transmissive && (i & 1) == 1)
+                    incoming.y = -incoming.y;
+                m_incoming[i] = m_shading_basis.transform_to_parent(incoming);
+            }
+        }
+    };
+
+    class BSDFBenchmarkCaseFactory
+      : public IBenchmarkCaseFactory
+    {
+      public:
+        BSDFBenchmarkCaseFactory(
+            const char*         model,
+            const Operation     operation,
+            const bool          spectral)
+          : m_model(model)
+          , m_operation(operation)
+          , m_spectral(spectral)
+          , m_name(
+                m_model + "_" +
+                OperationNames[operation] +
+                (spectral ? "_Spectral" : "_RGB"))
+        {
+        }
+
+        virtual const char* get_name() const APPLESEED_OVERRIDE
+        {
+            return m_name.c_str();
+        }
+
+        virtual IBenchmarkCase* create() APPLESEED_OVERRIDE
+        {
+            return new BSDFBenchmarkCase(m_name, m_model, m_operation, m_spectral);
+        }
+
+      private:
+        const string        m_model;
+        const Operation     m_operation;
+        const bool          m_spectral;
+        const string        m_name;
+    };
+
+    struct RegisterBSDFBenchmarkCases
+    {
+        vector<BSDFBenchmarkCaseFactory*> m_factories;
+
+        RegisterBSDFBenchmarkCases()
+        {
+            const BSDFFactoryRegistrar registrar;
+            const BSDFFactoryArray factories = registrar.get_factories();
+
+            for (size_t i = 0; i < factories.size(); ++i)
+            {
+                for (size_t op = 0; op < OperationCount; ++op)
+                {
+                    for (size_t spectral = 0; spectral < 2; ++spectral)
+                    {
+                        BSDFBenchmarkCaseFactory* factory =
+                            new BSDFBenchmarkCaseFactory(
+                                factories[i]->get_model(),
+                                static_cast<Operation>(op),
+                                spectral == 1);
+                        m_factories.push_back(factory);
+                        current_benchmark_suite__().register_case(factory);
+                    }
+                }
+            }
+        }
+
+        ~RegisterBSDFBenchmarkCases()
+        {
+            for (size_t i = 0; i < m_factories.size(); ++i)
+                delete m_factories[i];
+        }
+    };
+
+    static RegisterBSDFBenchmarkCases RegisterBSDFBenchmarkCases_instance__;
+}
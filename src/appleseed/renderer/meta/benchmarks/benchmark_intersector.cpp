@@ -0,0 +1,201 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/intersection/tracecontext.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/meshobjectprimitives.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/scene/visibilityflags.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/sampling/mappings.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/benchmark.h"
+#include "foundation/utility/containers/dictionary.h"
+
+// Standard headers.
+#include <cstddef>
+#include <limits>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+BENCHMARK_SUITE(Renderer_Kernel_Intersection_Intersector)
+{
+    template <bool UseRegionTrees>
+    struct TestScene
+    {
+        auto_release_ptr<Scene> m_scene;
+
+        TestScene()
+          : m_scene(SceneFactory::create())
+        {
+            m_scene->get_parameters().insert_path(
+                "acceleration_structure.region_trees",
+                UseRegionTrees);
+
+            // Objects of flushable assemblies are stored in region trees unless disabled.
+            auto_release_ptr<Assembly> assembly(
+                AssemblyFactory().create(
+                    "assembly",
+                    ParamArray().insert("flushable", true)));
+
+            assembly->objects().insert(
+                auto_release_ptr<Object>(
+                    create_primitive_mesh(
+                        "object",
+                        ParamArray()
+                            .insert("primitive", "sphere")
+                            .insert("resolution_u", 256)
+                            .insert("resolution_v", 128))));
+
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "object_instance",
+                    ParamArray(),
+                    "object",
+                    Transformd::identity(),
+                    StringDictionary()));
+
+            m_scene->assembly_instances().insert(
+                auto_release_ptr<AssemblyInstance>(
+                    AssemblyInstanceFactory::create(
+                        "assembly_instance",
+                        ParamArray(),
+                        "assembly")));
+
+            m_scene->assemblies().insert(assembly);
+        }
+    };
+
+    template <bool UseRegionTrees>
+    struct Fixture
+      : public BindInputs<TestScene<UseRegionTrees> >
+    {
+        static const size_t RayCount = 1000;
+
+        TraceContext    m_trace_context;
+        TextureStore    m_texture_store;
+        TextureCache    m_texture_cache;
+        Intersector     m_intersector;
+        ShadingRay      m_rays[RayCount];
+        size_t          m_hits;
+
+        Fixture()
+          : m_trace_context(BindInputs<TestScene<UseRegionTrees> >::m_scene.ref())
+          , m_texture_store(BindInputs<TestScene<UseRegionTrees> >::m_scene.ref())
+          , m_texture_cache(m_texture_store)
+          , m_intersector(m_trace_context, m_texture_cache)
+          , m_hits(0)
+        {
+            m_trace_context.update();
+
+            // Shoot rays from a sphere enclosing the object toward random points near its center.
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < RayCount; ++i)
+            {
+                Vector2d s;
+                s[0] = rand_double2(rng);
+                s[1] = rand_double2(rng);
+                const Vector3d origin = 4.0 * sample_sphere_uniform(s);
+
+                const Vector3d target(
+                    rand_double1(rng, -1.0, 1.0),
+                    rand_double1(rng, -1.0, 1.0),
+                    rand_double1(rng, -1.0, 1.0));
+
+                m_rays[i] =
+                    ShadingRay(
+                        origin,
+                        normalize(target - origin),
+                        0.0,                                // tmin
+                        numeric_limits<double>::max(),      // tmax
+                        ShadingRay::Time(),
+                        VisibilityFlags::CameraRay,
+                        0);                                 // depth
+            }
+        }
+
+        void trace()
+        {
+            for (size_t i = 0; i < RayCount; ++i)
+            {
+                ShadingPoint shading_point;
+                if (m_intersector.trace(m_rays[i], shading_point))
+                    ++m_hits;
+            }
+        }
+
+        void trace_probe()
+        {
+            for (size_t i = 0; i < RayCount; ++i)
+            {
+                if (m_intersector.trace_probe(m_rays[i]))
+                    ++m_hits;
+            }
+        }
+    };
+
+    BENCHMARK_CASE_F(Trace_RegionTrees, Fixture<true>)
+    {
+        trace();
+    }
+
+    BENCHMARK_CASE_F(Trace_TriangleTrees, Fixture<false>)
+    {
+        trace();
+    }
+
+    BENCHMARK_CASE_F(TraceProbe_RegionTrees, Fixture<true>)
+    {
+        trace_probe();
+    }
+
+    BENCHMARK_CASE_F(TraceProbe_TriangleTrees, Fixture<false>)
+    {
+        trace_probe();
+    }
+}
@@ -0,0 +1,457 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersector.h"
+#include "renderer/kernel/intersection/tracecontext.h"
+#include "renderer/kernel/rendering/defaultrenderercontroller.h"
+#include "renderer/kernel/rendering/masterrenderer.h"
+#include "renderer/kernel/shading/shadingpoint.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
+#include "renderer/modeling/bsdf/bsdf.h"
+#include "renderer/modeling/bsdf/lambertianbrdf.h"
+#include "renderer/modeling/camera/camera.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/modeling/light/light.h"
+#include "renderer/modeling/light/pointlight.h"
+#include "renderer/modeling/material/genericmaterial.h"
+#include "renderer/modeling/object/curveobject.h"
+#include "renderer/modeling/object/curveobjectreader.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/meshobjectprimitives.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/project/configuration.h"
+#include "renderer/modeling/project/configurationcontainer.h"
+#include "renderer/modeling/project/project.h"
+#include "renderer/modeling/project-builtin/cornellboxproject.h"
+#include "renderer/modeling/project-builtin/defaultproject.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/modeling/surfaceshader/physicalsurfaceshader.h"
+#include "renderer/modeling/surfaceshader/surfaceshader.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exception.h"
+#include "foundation/math/dual.h"
+#include "foundation/math/matrix.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/system.h"
+#include "foundation/platform/timers.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/benchmark.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/phaseprofile.h"
+#include "foundation/utility/searchpaths.h"
+#include "foundation/utility/stopwatch.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+BENCHMARK_SUITE(Renderer_Kernel_Rendering_MasterRenderer)
+{
+    //
+    // Procedurally generated scenes, built on top of the default project
+    // (whose camera looks at the origin from (1, 1, 1)).
+    //
+
+    void create_material(Assembly& assembly)
+    {
+        assembly.bsdfs().insert(
+            LambertianBRDFFactory().create(
+                "material_brdf",
+                ParamArray().insert("reflectance", "0.5")));
+
+        assembly.surface_shaders().insert(
+            PhysicalSurfaceShaderFactory().create(
+                "physical_shader",
+                ParamArray()));
+
+        assembly.materials().insert(
+            GenericMaterialFactory().create(
+                "material",
+                ParamArray()
+                    .insert("surface_shader", "physical_shader")
+                    .insert("bsdf", "material_brdf")));
+    }
+
+    void create_point_light(
+        Assembly&               assembly,
+        const string&           name,
+        const Vector3d&         position,
+        const double            intensity)
+    {
+        auto_release_ptr<Light> light(
+            PointLightFactory().create(
+                name.c_str(),
+                ParamArray().insert("intensity", intensity)));
+
+        light->set_transform(Transformd::from_local_to_parent(Matrix4d::make_translation(position)));
+
+        assembly.lights().insert(light);
+    }
+
+    void create_object_instance(
+        Assembly&               assembly,
+        const char*             object_name,
+        const Transformd&       transform)
+    {
+        assembly.object_instances().insert(
+            ObjectInstanceFactory::create(
+                (string(object_name) + "_inst").c_str(),
+                ParamArray(),
+                object_name,
+                transform,
+                StringDictionary().insert("default", "material")));
+    }
+
+    Assembly& get_default_assembly(Project& project)
+    {
+        return *project.get_scene()->assemblies().get_by_name("assembly");
+    }
+
+    auto_release_ptr<Project> create_cornell_box_project()
+    {
+        return CornellBoxProjectFactory::create();
+    }
+
+    auto_release_ptr<Project> create_default_project()
+    {
+        return DefaultProjectFactory::create();
+    }
+
+    // A 32x32 grid of instances of an assembly containing a single sphere.
+    auto_release_ptr<Project> create_instancing_project()
+    {
+        auto_release_ptr<Project> project(DefaultProjectFactory::create());
+        Scene& scene = *project->get_scene();
+
+        auto_release_ptr<Assembly> sphere_assembly(AssemblyFactory().create("sphere_assembly"));
+        create_material(sphere_assembly.ref());
+        sphere_assembly->objects().insert(
+            auto_release_ptr<Object>(
+                create_primitive_mesh(
+                    "sphere",
+                    ParamArray()
+                        .insert("primitive", "sphere")
+                        .insert("radius", 0.006)
+                        .insert("resolution_u", 32)
+                        .insert("resolution_v", 16))));
+        create_object_instance(sphere_assembly.ref(), "sphere", Transformd::identity());
+        scene.assemblies().insert(sphere_assembly);
+
+        const size_t GridSize = 32;
+
+        for (size_t y = 0; y < GridSize; ++y)
+        {
+            for (size_t x = 0; x < GridSize; ++x)
+            {
+                const Vector3d position(
+                    0.5 * ((x + 0.5) / GridSize - 0.5),
+                    0.0,
+                    0.5 * ((y + 0.5) / GridSize - 0.5));
+
+                auto_release_ptr<AssemblyInstance> assembly_instance(
+                    AssemblyInstanceFactory::create(
+                        ("sphere_assembly_inst_" + to_string(y * GridSize + x)).c_str(),
+                        ParamArray(),
+                        "sphere_assembly"));
+                assembly_instance->transform_sequence().set_transform(
+                    0.0f,
+                    Transformd::from_local_to_parent(Matrix4d::make_translation(position)));
+                scene.assembly_instances().insert(assembly_instance);
+            }
+        }
+
+        create_point_light(get_default_assembly(project.ref()), "light", Vector3d(0.5, 1.0, 0.5), 1.0);
+
+        return project;
+    }
+
+    // A ball covered with 100,000 hair curves.
+    auto_release_ptr<Project> create_hair_project()
+    {
+        auto_release_ptr<Project> project(DefaultProjectFactory::create());
+        Assembly& assembly = get_default_assembly(project.ref());
+
+        create_material(assembly);
+        assembly.objects().insert(
+            auto_release_ptr<Object>(
+                CurveObjectReader::read(
+                    SearchPaths(),
+                    "hair",
+                    ParamArray()
+                        .insert("filepath", "builtin:furryball")
+                        .insert("curves", 100000)
+                        .insert("length", 0.15)
+                        .insert("root_width", 0.004)
+                        .insert("tip_width", 0.001))));
+        create_object_instance(
+            assembly,
+            "hair",
+            Transformd::from_local_to_parent(Matrix4d::make_scaling(Vector3d(0.15))));
+
+        create_point_light(assembly, "light", Vector3d(0.5, 1.0, 0.5), 1.0);
+
+        return project;
+    }
+
+    // A ground plane lit by a 16x16 grid of point lights.
+    auto_release_ptr<Project> create_many_lights_project()
+    {
+        auto_release_ptr<Project> project(DefaultProjectFactory::create());
+        Assembly& assembly = get_default_assembly(project.ref());
+
+        create_material(assembly);
+        assembly.objects().insert(
+            auto_release_ptr<Object>(
+                create_primitive_mesh(
+                    "ground",
+                    ParamArray()
+                        .insert("primitive", "grid")
+                        .insert("width", 1.0)
+                        .insert("height", 1.0))));
+        create_object_instance(assembly, "ground", Transformd::identity());
+
+        const size_t GridSize = 16;
+
+        for (size_t y = 0; y < GridSize; ++y)
+        {
+            for (size_t x = 0; x < GridSize; ++x)
+            {
+                const Vector3d position(
+                    (x + 0.5) / GridSize - 0.5,
+                    0.05,
+                    (y + 0.5) / GridSize - 0.5);
+
+                create_point_light(
+                    assembly,
+                    "light_" + to_string(y * GridSize + x),
+                    position,
+                    0.01);
+            }
+        }
+
+        return project;
+    }
+
+    //
+    // Base class for benchmark cases rendering a project at fixed settings.
+    //
+
+    typedef auto_release_ptr<Project> (*ProjectCreator)();
+
+    double get_phase_seconds(const PhaseProfile& profile, const char* name)
+    {
+        for (size_t i = 0; i < profile.get_phase_count(); ++i)
+        {
+            if (strcmp(profile.get_phase_name(i), name) == 0)
+                return profile.get_phase_seconds(i);
+        }
+
+        return 0.0;
+    }
+
+    template <ProjectCreator CreateProject>
+    struct RenderBenchmarkCase
+      : public IBenchmarkCase
+    {
+        static const size_t Resolution = 128;
+        static const size_t SampleCount = 4;
+        static const size_t RayGridSize = 256;
+
+        enum Metric
+        {
+            SampleRate,
+            RayRate,
+            BuildTime,
+            PeakMemory,
+            MetricCount
+        };
+
+        auto_release_ptr<Project>   m_project;
+        DefaultRendererController   m_renderer_controller;
+        auto_ptr<MasterRenderer>    m_renderer;
+        double                      m_metrics[MetricCount];
+
+        RenderBenchmarkCase()
+          : m_project(CreateProject())
+        {
+            // Render a small frame, with one tile per thread.
+            ParamArray frame_params = m_project->get_frame()->get_parameters();
+            frame_params.insert("resolution", to_string(Resolution) + " " + to_string(Resolution));
+            frame_params.insert("tile_size", "32 32");
+            m_project->set_frame(FrameFactory::create("beauty", frame_params));
+
+            // Use fixed rendering settings so that results are comparable across runs.
+            ParamArray params =
+                m_project->configurations().get_by_name("final")->get_inherited_parameters();
+            params.insert("frame_renderer", "generic");
+            params.insert("tile_renderer", "generic");
+            params.insert("pixel_renderer", "uniform");
+            params.insert("sample_renderer", "generic");
+            params.insert("lighting_engine", "pt");
+            params.insert("rendering_threads", 1);
+            params.insert_path("uniform_pixel_renderer.samples", SampleCount);
+            params.insert_path("pt.max_bounces", 4);
+
+            m_renderer.reset(
+                new MasterRenderer(
+                    m_project.ref(),
+                    params,
+                    &m_renderer_controller));
+
+            fill(m_metrics, m_metrics + MetricCount, 0.0);
+        }
+
+        virtual size_t get_measurement_count() const APPLESEED_OVERRIDE
+        {
+            return 3;
+        }
+
+        virtual size_t get_metric_count() const APPLESEED_OVERRIDE
+        {
+            return MetricCount;
+        }
+
+        virtual void get_metric(const size_t index, MetricResult& metric) const APPLESEED_OVERRIDE
+        {
+            static const char* Names[MetricCount] = { "sample rate", "ray rate", "build time", "peak memory" };
+            static const char* Units[MetricCount] = { "Msamples/s", "Mrays/s", "s", "MB" };
+
+            metric.m_name = Names[index];
+            metric.m_unit = Units[index];
+            metric.m_value = m_metrics[index];
+        }
+
+        void render()
+        {
+            Stopwatch<DefaultWallclockTimer> stopwatch;
+            stopwatch.start();
+
+            if (!m_renderer->render())
+                throw Exception("rendering failed");
+
+            stopwatch.measure();
+
+            // The trace context update is where acceleration structures get built.
+            const PhaseProfile& profile = m_renderer->get_preparation_profile();
+            const double preparation_time = get_phase_seconds(profile, "render preparation");
+            const double render_time = max(stopwatch.get_seconds() - preparation_time, 1.0e-6);
+            const double sample_count = static_cast<double>(Resolution * Resolution * SampleCount);
+
+            m_metrics[SampleRate] = sample_count / render_time * 1.0e-6;
+            m_metrics[RayRate] = measure_camera_ray_rate();
+            m_metrics[BuildTime] = get_phase_seconds(profile, "trace context update");
+            m_metrics[PeakMemory] = static_cast<double>(System::get_peak_process_memory_size()) / (1024 * 1024);
+        }
+
+        // Trace a grid of camera rays through the scene and return millions of rays per second.
+        double measure_camera_ray_rate() const
+        {
+            const Camera* camera = m_project->get_uncached_active_camera();
+            const TraceContext& trace_context = m_project->get_trace_context();
+            TextureStore texture_store(trace_context.get_scene());
+            TextureCache texture_cache(texture_store);
+            Intersector intersector(trace_context, texture_cache);
+
+            SamplingContext::RNGType rng;
+            SamplingContext sampling_context(rng, SamplingContext::QMCMode);
+
+            vector<ShadingRay> rays(RayGridSize * RayGridSize);
+
+            for (size_t y = 0; y < RayGridSize; ++y)
+            {
+                for (size_t x = 0; x < RayGridSize; ++x)
+                {
+                    const Vector2d ndc(
+                        (x + 0.5) / RayGridSize,
+                        (y + 0.5) / RayGridSize);
+                    camera->spawn_ray(sampling_context, Dual2d(ndc), rays[y * RayGridSize + x]);
+                }
+            }
+
+            Stopwatch<DefaultWallclockTimer> stopwatch;
+            stopwatch.start();
+
+            for (size_t i = 0; i < rays.size(); ++i)
+            {
+                ShadingPoint shading_point;
+                intersector.trace(rays[i], shading_point);
+            }
+
+            stopwatch.measure();
+
+            return static_cast<double>(rays.size()) / max(stopwatch.get_seconds(), 1.0e-6) * 1.0e-6;
+        }
+    };
+
+    BENCHMARK_CASE_WITH_BASE(Render_CornellBox, RenderBenchmarkCase<create_cornell_box_project>)
+    {
+        render();
+    }
+
+    BENCHMARK_CASE_WITH_BASE(Render_Default, RenderBenchmarkCase<create_default_project>)
+    {
+        render();
+    }
+
+    BENCHMARK_CASE_WITH_BASE(Render_HeavyInstancing, RenderBenchmarkCase<create_instancing_project>)
+    {
+        render();
+    }
+
+    BENCHMARK_CASE_WITH_BASE(Render_Hair, RenderBenchmarkCase<create_hair_project>)
+    {
+        render();
+    }
+
+    BENCHMARK_CASE_WITH_BASE(Render_ManyLights, RenderBenchmarkCase<create_many_lights_project>)
+    {
+        render();
+    }
+}
@@ -38,6 +38,9 @@
 #include "foundation/math/vector.h"
 #include "foundation/utility/benchmark.h"
 
+// Standard headers.
+#include <cstddef>
+
 using namespace foundation;
 using namespace renderer;
 
@@ -71,4 +74,59 @@ BENCHMARK_SUITE(Renderer_Utility_TransformSequence)
     {
         m_motion_bbox = m_sequence.to_parent(m_bbox);
     }
+
+    struct MultiSegmentFixture
+    {
+        static const size_t KeyCount = 16;
+
+        TransformSequence       m_sequence;
+        TransformSequenceCache  m_cache;
+        size_t                  m_path_index;
+        Transformd              m_transform;
+
+        MultiSegmentFixture()
+          : m_path_index(0)
+        {
+            const Vector3d axis = normalize(Vector3d(0.1, 0.2, 1.0));
+
+            for (size_t i = 0; i < KeyCount; ++i)
+            {
+                const double angle = static_cast<double>(i) * Pi<double>() / KeyCount;
+                m_sequence.set_transform(
+                    static_cast<float>(i) / (KeyCount - 1),
+                    Transformd::from_local_to_parent(
+                        Matrix4d::make_translation(Vector3d(static_cast<double>(i), 0.0, 0.0)) *
+                        Matrix4d::make_rotation(axis, angle)));
+            }
+
+            m_sequence.prepare();
+        }
+
+        // Return the time of the next path, scattered over the whole sequence.
+        float next_path_time()
+        {
+            m_path_index = (m_path_index + 1) % 97;
+            return static_cast<float>(m_path_index) * (1.0f / 97.0f);
+        }
+    };
+
+    // Every ray of a path is traced at the same time: evaluate the sequence
+    // as many times as a path with a few bounces and light samples would.
+    static const size_t RaysPerPath = 8;
+
+    BENCHMARK_CASE_F(Evaluate, MultiSegmentFixture)
+    {
+        const float time = next_path_time();
+
+        for (size_t i = 0; i < RaysPerPath; ++i)
+            m_transform = m_sequence.evaluate(time, m_transform);
+    }
+
+    BENCHMARK_CASE_F(EvaluateWithCache, MultiSegmentFixture)
+    {
+        const float time = next_path_time();
+
+        for (size_t i = 0; i < RaysPerPath; ++i)
+            m_transform = m_cache.evaluate(m_sequence, time);
+    }
 }
@@ -0,0 +1,98 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/modeling/scene/archiveassembly.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Modeling_Scene_ArchiveAssembly)
+{
+    struct Fixture
+    {
+        auto_release_ptr<Assembly>  m_assembly;
+        const ArchiveAssembly*      m_archive_assembly;
+
+        Fixture()
+          : m_assembly(
+                ArchiveAssemblyFactory::static_create(
+                    "archive",
+                    ParamArray()
+                        .insert("filename", "archive.appleseed")
+                        .insert("deferred", true)
+                        .insert("bbox", "-1.0 -2.0 -3.0 1.0 2.0 3.0")))
+          , m_archive_assembly(static_cast<const ArchiveAssembly*>(m_assembly.get()))
+        {
+        }
+    };
+
+    TEST_CASE_F(ComputeLocalBBox_GivenDeferredArchiveNotLoaded_ReturnsDeclaredBBox, Fixture)
+    {
+        EXPECT_EQ(
+            GAABB3(GVector3(-1.0f, -2.0f, -3.0f), GVector3(1.0f, 2.0f, 3.0f)),
+            m_assembly->compute_local_bbox());
+    }
+
+    TEST_CASE_F(IsExpansionPending_GivenNoRayEntry_ReturnsFalse, Fixture)
+    {
+        EXPECT_FALSE(m_archive_assembly->is_expansion_pending());
+    }
+
+    TEST_CASE_F(IsExpansionPending_GivenRayEntry_ReturnsTrue, Fixture)
+    {
+        m_archive_assembly->record_ray_entry();
+
+        EXPECT_TRUE(m_archive_assembly->is_expansion_pending());
+    }
+
+    TEST_CASE(IsExpansionPending_GivenNonDeferredArchive_ReturnsFalse)
+    {
+        auto_release_ptr<Assembly> assembly(
+            ArchiveAssemblyFactory::static_create(
+                "archive",
+                ParamArray().insert("filename", "archive.appleseed")));
+        const ArchiveAssembly* archive_assembly = static_cast<const ArchiveAssembly*>(assembly.get());
+
+        archive_assembly->record_ray_entry();
+
+        EXPECT_FALSE(archive_assembly->is_deferred());
+        EXPECT_FALSE(archive_assembly->is_expansion_pending());
+    }
+}
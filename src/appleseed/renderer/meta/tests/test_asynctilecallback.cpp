@@ -0,0 +1,152 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/asynctilecallback.h"
+#include "renderer/kernel/rendering/itilecallback.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Rendering_AsyncTileCallbackFactory)
+{
+    // Records the tiles it is told about, shared by all instances.
+    class RecordingTileCallback
+      : public ITileCallback
+    {
+      public:
+        explicit RecordingTileCallback(vector<size_t>& tiles)
+          : m_tiles(tiles)
+        {
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            delete this;
+        }
+
+        virtual void pre_render(
+            const size_t    x,
+            const size_t    y,
+            const size_t    width,
+            const size_t    height) APPLESEED_OVERRIDE
+        {
+        }
+
+        virtual void post_render_tile(
+            const Frame*    frame,
+            const size_t    tile_x,
+            const size_t    tile_y) APPLESEED_OVERRIDE
+        {
+            m_tiles.push_back(tile_y * 100 + tile_x);
+        }
+
+        virtual void post_render(const Frame* frame) APPLESEED_OVERRIDE
+        {
+        }
+
+      private:
+        vector<size_t>& m_tiles;
+    };
+
+    class RecordingTileCallbackFactory
+      : public ITileCallbackFactory
+    {
+      public:
+        vector<size_t> m_tiles;
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            delete this;
+        }
+
+        virtual ITileCallback* create() APPLESEED_OVERRIDE
+        {
+            return new RecordingTileCallback(m_tiles);
+        }
+    };
+
+    TEST_CASE(Flush_DeliversEventsInOrderOfArrival)
+    {
+        RecordingTileCallbackFactory recorder;
+
+        {
+            AsyncTileCallbackFactory factory(&recorder);
+
+            ITileCallback* callback = factory.create();
+            for (size_t i = 0; i < 100; ++i)
+                callback->post_render_tile(0, i, 0);
+            callback->release();
+
+            factory.flush();
+
+            EXPECT_EQ(100, factory.get_delivered_event_count());
+        }
+
+        ASSERT_EQ(100, recorder.m_tiles.size());
+
+        for (size_t i = 0; i < 100; ++i)
+            EXPECT_EQ(i, recorder.m_tiles[i]);
+    }
+
+    TEST_CASE(Flush_GivenCoalescing_DeliversEveryTileAtLeastOnce)
+    {
+        RecordingTileCallbackFactory recorder;
+
+        {
+            // A small queue forces rendering threads to wait for the delivery thread.
+            AsyncTileCallbackFactory factory(&recorder, 4, true);
+
+            ITileCallback* callback = factory.create();
+            for (size_t i = 0; i < 1000; ++i)
+                callback->post_render_tile(0, i % 10, 0);
+            callback->release();
+
+            factory.flush();
+
+            EXPECT_EQ(1000, factory.get_delivered_event_count() + factory.get_coalesced_event_count());
+        }
+
+        vector<bool> delivered(10, false);
+        for (size_t i = 0; i < recorder.m_tiles.size(); ++i)
+            delivered[recorder.m_tiles[i]] = true;
+
+        for (size_t i = 0; i < 10; ++i)
+            EXPECT_TRUE(delivered[i]);
+    }
+}
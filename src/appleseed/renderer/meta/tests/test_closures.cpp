@@ -0,0 +1,140 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/shading/closures.h"
+#include "renderer/modeling/edf/diffuseedf.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/utility/arena.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// OSL headers.
+#include "foundation/platform/oslheaderguards.h"
+BEGIN_OSL_INCLUDES
+#include "OSL/oslclosure.h"
+#include "OSL/oslversion.h"
+END_OSL_INCLUDES
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+#if OSL_LIBRARY_VERSION_CODE >= 10700
+
+TEST_SUITE(Renderer_Kernel_Shading_Closures)
+{
+    // A closure tree made of the sum of a number of emission closures.
+    // The weight of the i'th closure is i + 1.
+    class EmissionClosureTree
+    {
+      public:
+        explicit EmissionClosureTree(const size_t closure_count)
+          : m_components(closure_count)
+          , m_adds(closure_count - 1)
+        {
+            for (size_t i = 0; i < closure_count; ++i)
+            {
+                const float w = static_cast<float>(i + 1);
+                m_components[i].id = EmissionID;
+                m_components[i].w = OSL::Vec3(w, w, w);
+            }
+
+            m_root = &m_components[0];
+
+            for (size_t i = 0; i < closure_count - 1; ++i)
+            {
+                m_adds[i].id = OSL::ClosureColor::ADD;
+                m_adds[i].closureA = m_root;
+                m_adds[i].closureB = &m_components[i + 1];
+                m_root = &m_adds[i];
+            }
+        }
+
+        const OSL::ClosureColor* get_root() const
+        {
+            return m_root;
+        }
+
+      private:
+        vector<OSL::ClosureComponent>   m_components;
+        vector<OSL::ClosureAdd>         m_adds;
+        const OSL::ClosureColor*        m_root;
+    };
+
+    TEST_CASE(CompositeEmissionClosure_GivenMoreThan16Closures_KeepsAllClosures)
+    {
+        const size_t ClosureCount = 20;
+        const EmissionClosureTree tree(ClosureCount);
+
+        Arena arena;
+        const CompositeEmissionClosure c(tree.get_root(), arena);
+
+        ASSERT_EQ(ClosureCount, c.get_closure_count());
+
+        const float total_weight = ClosureCount * (ClosureCount + 1) / 2.0f;
+
+        for (size_t i = 0; i < ClosureCount; ++i)
+        {
+            EXPECT_EQ(EmissionID, c.get_closure_type(i));
+            EXPECT_FEQ(Color3f(static_cast<float>(i + 1)), c.get_closure_weight(i).rgb());
+            EXPECT_FEQ((i + 1) / total_weight, c.get_closure_pdf_weight(i));
+        }
+
+        EXPECT_EQ(0, c.choose_closure(0.0f));
+        EXPECT_EQ(ClosureCount - 1, c.choose_closure(0.999f));
+    }
+
+    TEST_CASE(CompositeEmissionClosure_AddClosureBeyondCapacity_DropsClosure)
+    {
+        const size_t ClosureCount = 20;
+        const EmissionClosureTree tree(ClosureCount);
+
+        Arena arena;
+        CompositeEmissionClosure c(tree.get_root(), arena);
+
+        const DiffuseEDFInputValues* values =
+            c.add_closure<DiffuseEDFInputValues>(
+                EmissionID,
+                Color3f(1.0f),
+                1.0f,
+                arena);
+
+        EXPECT_TRUE(values != 0);
+        EXPECT_EQ(ClosureCount, c.get_closure_count());
+    }
+}
+
+#endif
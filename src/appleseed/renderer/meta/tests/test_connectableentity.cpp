@@ -0,0 +1,93 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/modeling/bsdf/bsdf.h"
+#include "renderer/modeling/bsdf/lambertianbrdf.h"
+#include "renderer/modeling/color/colorentity.h"
+#include "renderer/modeling/input/colorsource.h"
+#include "renderer/modeling/input/inputarray.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Modeling_Entity_ConnectableEntity)
+{
+    auto_release_ptr<BSDF> create_lambertian_brdf(const ColorEntity& reflectance)
+    {
+        auto_release_ptr<BSDF> bsdf(LambertianBRDFFactory().create("bsdf", ParamArray()));
+        bsdf->get_inputs().find("reflectance").bind(new ColorSource(reflectance));
+        return bsdf;
+    }
+
+    TEST_CASE(HasSpectralInputs_GivenInputBoundToRGBColor_ReturnsFalse)
+    {
+        ColorValueArray values;
+        values.push_back(0.2f);
+        values.push_back(0.5f);
+        values.push_back(0.8f);
+
+        auto_release_ptr<ColorEntity> color(
+            ColorEntityFactory::create(
+                "color",
+                ParamArray().insert("color_space", "linear_rgb"),
+                values));
+
+        auto_release_ptr<BSDF> bsdf(create_lambertian_brdf(color.ref()));
+
+        EXPECT_FALSE(bsdf->has_spectral_inputs());
+    }
+
+    TEST_CASE(HasSpectralInputs_GivenInputBoundToSpectralColor_ReturnsTrue)
+    {
+        ColorValueArray values;
+        for (size_t i = 0; i < 31; ++i)
+            values.push_back(0.5f);
+
+        auto_release_ptr<ColorEntity> color(
+            ColorEntityFactory::create(
+                "color",
+                ParamArray()
+                    .insert("color_space", "spectral")
+                    .insert("wavelength_range", "400.0 700.0"),
+                values));
+
+        auto_release_ptr<BSDF> bsdf(create_lambertian_brdf(color.ref()));
+
+        EXPECT_TRUE(bsdf->has_spectral_inputs());
+    }
+}
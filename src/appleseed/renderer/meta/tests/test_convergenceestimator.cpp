@@ -0,0 +1,134 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/convergenceestimator.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cmath>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Rendering_ConvergenceEstimator)
+{
+    TEST_CASE(Update_GivenLessThanOneSamplePerPixel_DoesNotTakeSnapshot)
+    {
+        Image image(4, 4, 2, 2, 4, PixelFormatFloat);
+        image.clear(Color4f(1.0f));
+
+        ConvergenceEstimator estimator;
+        estimator.update(image, 8, 1);
+        estimator.update(image, 16, 1);
+
+        EXPECT_FALSE(estimator.has_estimate());
+    }
+
+    TEST_CASE(Update_GivenSampleCountNotYetDoubled_DoesNotEstimateError)
+    {
+        Image image(4, 4, 2, 2, 4, PixelFormatFloat);
+        image.clear(Color4f(1.0f));
+
+        ConvergenceEstimator estimator;
+        estimator.update(image, 16, 1);
+        estimator.update(image, 24, 1);
+
+        EXPECT_FALSE(estimator.has_estimate());
+    }
+
+    TEST_CASE(Update_GivenIdenticalImages_EstimatesZeroError)
+    {
+        Image image(4, 4, 2, 2, 4, PixelFormatFloat);
+        image.clear(Color4f(1.0f));
+
+        ConvergenceEstimator estimator;
+        estimator.update(image, 16, 2);
+        estimator.update(image, 32, 2);
+
+        ASSERT_TRUE(estimator.has_estimate());
+        EXPECT_EQ(0.0, estimator.get_error());
+        EXPECT_EQ(0.0, estimator.get_tile_error(1, 1));
+    }
+
+    TEST_CASE(Update_GivenImageThatChangedSinceSnapshot_EstimatesRelativeDeviation)
+    {
+        Image image(4, 4, 2, 2, 4, PixelFormatFloat);
+        ConvergenceEstimator estimator;
+
+        image.clear(Color4f(1.0f));
+        estimator.update(image, 16, 2);
+
+        image.clear(Color4f(1.5f));
+        estimator.update(image, 32, 2);
+
+        const double expected_error = std::sqrt(0.25 / (2.25 + 0.01));
+
+        ASSERT_TRUE(estimator.has_estimate());
+        EXPECT_FEQ(expected_error, estimator.get_error());
+        EXPECT_FEQ(expected_error, estimator.get_tile_error(0, 1));
+    }
+
+    TEST_CASE(GetError_AfterMoreSamples_ExtrapolatesError)
+    {
+        Image image(4, 4, 2, 2, 4, PixelFormatFloat);
+        ConvergenceEstimator estimator;
+
+        image.clear(Color4f(1.0f));
+        estimator.update(image, 16, 1);
+
+        image.clear(Color4f(1.5f));
+        estimator.update(image, 32, 1);
+        const double error = estimator.get_error();
+
+        estimator.update(image, 48, 1);
+
+        EXPECT_FEQ(error * std::sqrt(32.0 / 48.0), estimator.get_error());
+    }
+
+    TEST_CASE(Clear_ForgetsEstimate)
+    {
+        Image image(4, 4, 2, 2, 4, PixelFormatFloat);
+        image.clear(Color4f(1.0f));
+
+        ConvergenceEstimator estimator;
+        estimator.update(image, 16, 1);
+        estimator.update(image, 32, 1);
+
+        estimator.clear();
+
+        EXPECT_FALSE(estimator.has_estimate());
+        EXPECT_EQ(0.0, estimator.get_error());
+    }
+}
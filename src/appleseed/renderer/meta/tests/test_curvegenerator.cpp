@@ -0,0 +1,113 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
+#include "renderer/modeling/object/curvegenerator.h"
+#include "renderer/modeling/object/curveobject.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Modeling_Object_CurveGenerator)
+{
+    class RandomCurveGenerator
+      : public ICurve3Generator
+    {
+      public:
+        virtual Curve3Type generate(
+            const size_t            curve_index,
+            const size_t            curve_count,
+            MersenneTwister&        rng) const APPLESEED_OVERRIDE
+        {
+            GVector3 points[4];
+
+            for (size_t p = 0; p < 4; ++p)
+                points[p] = rand_vector1<GVector3>(rng);
+
+            return Curve3Type(points, static_cast<GScalar>(curve_index));
+        }
+    };
+
+    bool are_equal(const CurveObject& lhs, const CurveObject& rhs)
+    {
+        if (lhs.get_curve3_count() != rhs.get_curve3_count())
+            return false;
+
+        for (size_t i = 0, e = lhs.get_curve3_count(); i < e; ++i)
+        {
+            const Curve3Type& lhs_curve = lhs.get_curve3(i);
+            const Curve3Type& rhs_curve = rhs.get_curve3(i);
+
+            for (size_t p = 0; p < 4; ++p)
+            {
+                if (lhs_curve.get_control_point(p) != rhs_curve.get_control_point(p) ||
+                    lhs_curve.get_width(p) != rhs_curve.get_width(p))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    TEST_CASE(GenerateCurves3_AppliesPresplits)
+    {
+        auto_release_ptr<CurveObject> object(CurveObjectFactory::create("curves", ParamArray()));
+
+        generate_curves3(object.ref(), RandomCurveGenerator(), 10, 2, 1);
+
+        EXPECT_EQ(40, object->get_curve3_count());
+    }
+
+    TEST_CASE(GenerateCurves3_ResultIsIndependentOfThreadCount)
+    {
+        const size_t CurveCount = 20000;
+
+        auto_release_ptr<CurveObject> object1(CurveObjectFactory::create("curves1", ParamArray()));
+        generate_curves3(object1.ref(), RandomCurveGenerator(), CurveCount, 0, 1);
+
+        auto_release_ptr<CurveObject> object2(CurveObjectFactory::create("curves2", ParamArray()));
+        generate_curves3(object2.ref(), RandomCurveGenerator(), CurveCount, 0, 3);
+
+        EXPECT_EQ(CurveCount, object1->get_curve3_count());
+        EXPECT_TRUE(are_equal(object1.ref(), object2.ref()));
+    }
+}
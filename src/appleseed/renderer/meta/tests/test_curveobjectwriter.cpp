@@ -0,0 +1,166 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
+#include "renderer/modeling/object/curveobject.h"
+#include "renderer/modeling/object/curveobjectreader.h"
+#include "renderer/modeling/object/curveobjectwriter.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/thread.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/searchpaths.h"
+#include "foundation/utility/test.h"
+
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+
+using namespace boost::filesystem;
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Modeling_Object_CurveObjectWriter)
+{
+    struct Fixture
+    {
+        const path                      m_output_directory;
+        auto_release_ptr<CurveObject>   m_object;
+
+        Fixture()
+          : m_output_directory(absolute("unit tests/outputs/test_curveobjectwriter/"))
+          , m_object(CurveObjectFactory::create("curves", ParamArray()))
+        {
+            remove_all(m_output_directory);
+
+            // See the comment in test_projectfilewriter.cpp.
+            foundation::sleep(50);
+
+            create_directory(m_output_directory);
+
+            static const GVector3 Points1[] =
+            {
+                GVector3(0.0f, 0.0f, 0.0f),
+                GVector3(0.0f, 1.0f, 0.0f)
+            };
+            static const GScalar Widths1[] = { 0.1f, 0.2f };
+            m_object->push_curve1(Curve1Type(Points1, Widths1));
+
+            static const GVector3 Points3[] =
+            {
+                GVector3(1.0f, 0.0f, 0.0f),
+                GVector3(1.0f, 1.0f, 0.5f),
+                GVector3(2.0f, 1.0f, 0.5f),
+                GVector3(2.0f, 2.0f, 1.0f)
+            };
+            static const GScalar Widths3[] = { 0.4f, 0.3f, 0.2f, 0.1f };
+            m_object->push_curve3(Curve3Type(Points3, Widths3));
+        }
+
+        bool write(const char* filename) const
+        {
+            return
+                CurveObjectWriter::write(
+                    m_object.ref(),
+                    (m_output_directory / filename).string().c_str());
+        }
+
+        auto_release_ptr<CurveObject> read(const char* filename) const
+        {
+            return
+                CurveObjectReader::read(
+                    SearchPaths(),
+                    "curves",
+                    ParamArray().insert("filepath", (m_output_directory / filename).string()));
+        }
+    };
+
+    template <typename CurveType>
+    bool curves_equal(const CurveType& lhs, const CurveType& rhs)
+    {
+        for (size_t p = 0; p < CurveType::Degree + 1; ++p)
+        {
+            if (!feq(lhs.get_control_point(p), rhs.get_control_point(p)) ||
+                !feq(lhs.get_width(p), rhs.get_width(p)))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool objects_equal(const CurveObject& lhs, const CurveObject& rhs)
+    {
+        if (lhs.get_curve1_count() != rhs.get_curve1_count() ||
+            lhs.get_curve3_count() != rhs.get_curve3_count())
+            return false;
+
+        for (size_t i = 0; i < lhs.get_curve1_count(); ++i)
+        {
+            if (!curves_equal(lhs.get_curve1(i), rhs.get_curve1(i)))
+                return false;
+        }
+
+        for (size_t i = 0; i < lhs.get_curve3_count(); ++i)
+        {
+            if (!curves_equal(lhs.get_curve3(i), rhs.get_curve3(i)))
+                return false;
+        }
+
+        return true;
+    }
+
+    TEST_CASE_F(Write_TextCurveFile_CurvesAreReadBack, Fixture)
+    {
+        ASSERT_TRUE(write("curves.curves"));
+
+        auto_release_ptr<CurveObject> object = read("curves.curves");
+
+        EXPECT_TRUE(objects_equal(m_object.ref(), object.ref()));
+    }
+
+    TEST_CASE_F(Write_BinaryCurveFile_CurvesAreReadBack, Fixture)
+    {
+        ASSERT_TRUE(write("curves.binarycurve"));
+
+        auto_release_ptr<CurveObject> object = read("curves.binarycurve");
+
+        EXPECT_TRUE(objects_equal(m_object.ref(), object.ref()));
+    }
+}
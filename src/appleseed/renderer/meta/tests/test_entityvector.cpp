@@ -35,11 +35,17 @@
 // appleseed.foundation headers.
 #include "foundation/platform/compiler.h"
 #include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/string.h"
 #include "foundation/utility/test.h"
 #include "foundation/utility/uid.h"
 
+// Standard headers.
+#include <cstddef>
+#include <string>
+
 using namespace foundation;
 using namespace renderer;
+using namespace std;
 
 TEST_SUITE(Renderer_Modeling_Entity_EntityVector)
 {
@@ -220,4 +226,34 @@ TEST_SUITE(Renderer_Modeling_Entity_EntityVector)
 
         EXPECT_EQ(entity2_ptr, v.get_by_name("entity2"));
     }
+
+    TEST_CASE(GetByName_AfterRemovingEntitiesFromLargeVector_ReturnsRemainingEntities)
+    {
+        const size_t EntityCount = 1000;
+
+        EntityVector v;
+
+        for (size_t i = 0; i < EntityCount; ++i)
+            v.insert(auto_release_ptr<Entity>(new DummyEntity(("entity" + to_string(i)).c_str())));
+
+        for (size_t i = 0; i < EntityCount; i += 2)
+            v.remove(v.get_by_name(("entity" + to_string(i)).c_str()));
+
+        ASSERT_EQ(EntityCount / 2, v.size());
+
+        for (size_t i = 0; i < EntityCount; ++i)
+        {
+            const string name = "entity" + to_string(i);
+            Entity* entity = v.get_by_name(name.c_str());
+
+            if (i % 2 == 0)
+                EXPECT_EQ(0, entity);
+            else
+            {
+                ASSERT_NEQ(0, entity);
+                EXPECT_EQ(name, entity->get_name());
+                EXPECT_EQ(entity, v.get_by_index(v.get_index(name.c_str())));
+            }
+        }
+    }
 }
@@ -41,8 +41,10 @@
 #include "renderer/modeling/environmentedf/constantenvironmentedf.h"
 #include "renderer/modeling/environmentedf/environmentedf.h"
 #include "renderer/modeling/environmentedf/gradientenvironmentedf.h"
+#include "renderer/modeling/environmentedf/hosekenvironmentedf.h"
 #include "renderer/modeling/environmentedf/latlongmapenvironmentedf.h"
 #include "renderer/modeling/environmentedf/mirrorballmapenvironmentedf.h"
+#include "renderer/modeling/environmentedf/preethamenvironmentedf.h"
 #include "renderer/modeling/scene/containers.h"
 #include "renderer/modeling/scene/scene.h"
 #include "renderer/modeling/texture/texture.h"
@@ -176,13 +178,55 @@ TEST_SUITE(Renderer_Modeling_EnvironmentEDF)
                     new HorizontalGradientTexture(name)));
         }
 
-        bool check_consistency(EnvironmentEDF& env_edf)
+        // Everything required to build a shading context.
+        struct ShadingContextStorage
+        {
+            TextureStore                                m_texture_store;
+            TextureCache                                m_texture_cache;
+            boost::shared_ptr<OIIO::TextureSystem>      m_texture_system;
+            RendererServices                            m_renderer_services;
+            boost::shared_ptr<OSL::ShadingSystem>       m_shading_system;
+            Intersector                                 m_intersector;
+            Arena                                       m_arena;
+            OSLShaderGroupExec                          m_sg_exec;
+            Tracer                                      m_tracer;
+            ShadingContext                              m_shading_context;
+
+            ShadingContextStorage(Project& project, Scene& scene)
+              : m_texture_store(scene)
+              , m_texture_cache(m_texture_store)
+              , m_texture_system(
+                    OIIO::TextureSystem::create(),
+                    boost::bind(&OIIO::TextureSystem::destroy, _1))
+              , m_renderer_services(project, *m_texture_system)
+              , m_shading_system(new OSL::ShadingSystem(&m_renderer_services, m_texture_system.get()))
+              , m_intersector(project.get_trace_context(), m_texture_cache)
+              , m_sg_exec(*m_shading_system, m_arena)
+              , m_tracer(scene, m_intersector, m_texture_cache, m_sg_exec)
+              , m_shading_context(
+                    m_intersector,
+                    m_tracer,
+                    m_texture_cache,
+                    *m_texture_system,
+                    m_sg_exec,
+                    m_arena,
+                    0)
+            {
+            }
+        };
+
+        void set_environment_edf(const EnvironmentEDF& env_edf)
         {
             auto_release_ptr<Environment> environment(
                 EnvironmentFactory().create(
                     "environment", ParamArray().insert("environment_edf", env_edf.get_name())));
 
             m_scene.set_environment(environment);
+        }
+
+        bool check_consistency(EnvironmentEDF& env_edf)
+        {
+            set_environment_edf(env_edf);
 
             bind_inputs();
 
@@ -190,41 +234,8 @@ TEST_SUITE(Renderer_Modeling_EnvironmentEDF)
             APPLESEED_UNUSED const bool success = env_edf.on_frame_begin(m_project, &m_scene, recorder);
             assert(success);
 
-            TextureStore texture_store(m_scene);
-            TextureCache texture_cache(texture_store);
-
-            boost::shared_ptr<OIIO::TextureSystem> texture_system(
-                OIIO::TextureSystem::create(),
-                boost::bind(&OIIO::TextureSystem::destroy, _1));
-
-            RendererServices renderer_services(
-                m_project,
-                *texture_system);
-
-            boost::shared_ptr<OSL::ShadingSystem> shading_system(
-                new OSL::ShadingSystem(&renderer_services, texture_system.get()));
-
-            Intersector intersector(
-                m_project.get_trace_context(),
-                texture_cache);
-
-            Arena arena;
-            OSLShaderGroupExec sg_exec(*shading_system, arena);
-
-            Tracer tracer(
-                m_scene,
-                intersector,
-                texture_cache,
-                sg_exec);
-
-            ShadingContext shading_context(
-                intersector,
-                tracer,
-                texture_cache,
-                *texture_system,
-                sg_exec,
-                arena,
-                0);
+            ShadingContextStorage storage(m_project, m_scene);
+            const ShadingContext& shading_context = storage.m_shading_context;
 
             Vector3f outgoing;
             Spectrum value1(Spectrum::Illuminance);
@@ -250,6 +261,46 @@ TEST_SUITE(Renderer_Modeling_EnvironmentEDF)
 
             return consistent;
         }
+
+        // Check that a sky baked into a radiance table matches the analytic sky away from the horizon.
+        bool check_radiance_table_accuracy(
+            EnvironmentEDF& analytic_env_edf,
+            EnvironmentEDF& baked_env_edf)
+        {
+            set_environment_edf(baked_env_edf);
+
+            bind_inputs();
+
+            OnFrameBeginRecorder recorder;
+            APPLESEED_UNUSED bool success = analytic_env_edf.on_frame_begin(m_project, &m_scene, recorder);
+            assert(success);
+            success = baked_env_edf.on_frame_begin(m_project, &m_scene, recorder);
+            assert(success);
+
+            ShadingContextStorage storage(m_project, m_scene);
+            const ShadingContext& shading_context = storage.m_shading_context;
+
+            bool accurate = true;
+
+            for (size_t i = 0; i < 8; ++i)
+            {
+                const float theta = deg_to_rad(10.0f + 8.0f * i);
+                const float phi = deg_to_rad(135.0f + 25.0f * i);
+                const Vector3f outgoing = Vector3f::make_unit_vector(theta, phi);
+
+                Spectrum analytic_value(Spectrum::Illuminance);
+                analytic_env_edf.evaluate(shading_context, outgoing, analytic_value);
+
+                Spectrum baked_value(Spectrum::Illuminance);
+                baked_env_edf.evaluate(shading_context, outgoing, baked_value);
+
+                accurate = accurate && feq(analytic_value, baked_value, 0.05f);
+            }
+
+            recorder.on_frame_end(m_project);
+
+            return accurate;
+        }
     };
 
     TEST_CASE_F(CheckConstantEnvironmentEDFConsistency, Fixture)
@@ -320,4 +371,77 @@ TEST_SUITE(Renderer_Modeling_EnvironmentEDF)
 
         EXPECT_TRUE(consistent);
     }
+
+    ParamArray make_sky_params()
+    {
+        return
+            ParamArray()
+                .insert("sun_theta", "40.0")
+                .insert("sun_phi", "30.0")
+                .insert("turbidity", "1.0");
+    }
+
+    TEST_CASE_F(CheckHosekEnvironmentEDFWithRadianceTableConsistency, Fixture)
+    {
+        auto_release_ptr<EnvironmentEDF> env_edf(
+            HosekEnvironmentEDFFactory().create(
+                "env_edf",
+                make_sky_params().insert("radiance_table_resolution", "64")));
+        EnvironmentEDF& env_edf_ref = env_edf.ref();
+        m_scene.environment_edfs().insert(env_edf);
+
+        const bool consistent = check_consistency(env_edf_ref);
+
+        EXPECT_TRUE(consistent);
+    }
+
+    TEST_CASE_F(CheckPreethamEnvironmentEDFWithRadianceTableConsistency, Fixture)
+    {
+        auto_release_ptr<EnvironmentEDF> env_edf(
+            PreethamEnvironmentEDFFactory().create(
+                "env_edf",
+                make_sky_params().insert("radiance_table_resolution", "64")));
+        EnvironmentEDF& env_edf_ref = env_edf.ref();
+        m_scene.environment_edfs().insert(env_edf);
+
+        const bool consistent = check_consistency(env_edf_ref);
+
+        EXPECT_TRUE(consistent);
+    }
+
+    TEST_CASE_F(HosekEnvironmentEDFRadianceTableMatchesAnalyticSky, Fixture)
+    {
+        auto_release_ptr<EnvironmentEDF> analytic_env_edf(
+            HosekEnvironmentEDFFactory().create("analytic_env_edf", make_sky_params()));
+        auto_release_ptr<EnvironmentEDF> baked_env_edf(
+            HosekEnvironmentEDFFactory().create(
+                "baked_env_edf",
+                make_sky_params().insert("radiance_table_resolution", "512")));
+        EnvironmentEDF& analytic_env_edf_ref = analytic_env_edf.ref();
+        EnvironmentEDF& baked_env_edf_ref = baked_env_edf.ref();
+        m_scene.environment_edfs().insert(analytic_env_edf);
+        m_scene.environment_edfs().insert(baked_env_edf);
+
+        const bool accurate = check_radiance_table_accuracy(analytic_env_edf_ref, baked_env_edf_ref);
+
+        EXPECT_TRUE(accurate);
+    }
+
+    TEST_CASE_F(PreethamEnvironmentEDFRadianceTableMatchesAnalyticSky, Fixture)
+    {
+        auto_release_ptr<EnvironmentEDF> analytic_env_edf(
+            PreethamEnvironmentEDFFactory().create("analytic_env_edf", make_sky_params()));
+        auto_release_ptr<EnvironmentEDF> baked_env_edf(
+            PreethamEnvironmentEDFFactory().create(
+                "baked_env_edf",
+                make_sky_params().insert("radiance_table_resolution", "512")));
+        EnvironmentEDF& analytic_env_edf_ref = analytic_env_edf.ref();
+        EnvironmentEDF& baked_env_edf_ref = baked_env_edf.ref();
+        m_scene.environment_edfs().insert(analytic_env_edf);
+        m_scene.environment_edfs().insert(baked_env_edf);
+
+        const bool accurate = check_radiance_table_accuracy(analytic_env_edf_ref, baked_env_edf_ref);
+
+        EXPECT_TRUE(accurate);
+    }
 }
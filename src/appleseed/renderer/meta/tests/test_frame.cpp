@@ -0,0 +1,105 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// appleseed.renderer headers.
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/image/pixel.h"
+#include "foundation/image/tile.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Modeling_Frame)
+{
+    // Return true if transforming the pixels of a tile all at once gives the same
+    // result as transforming them one by one.
+    bool transform_is_independent_of_pixel_batching(const char* color_space, const bool clamping)
+    {
+        auto_release_ptr<Frame> frame(
+            FrameFactory::create("frame",
+                ParamArray()
+                    .insert("resolution", "64 64")
+                    .insert("tile_size", "32 32")
+                    .insert("pixel_format", "float")
+                    .insert("color_space", color_space)
+                    .insert("clamping", clamping)));
+
+        // 5x5 pixels: six batches of four pixels and one remaining pixel.
+        Tile tile(5, 5, 4, PixelFormatFloat);
+        for (size_t i = 0; i < tile.get_pixel_count(); ++i)
+        {
+            const float x = static_cast<float>(i) / 8.0f;
+            tile.set_pixel(i, Color4f(x, 1.5f - x, 0.3f * x - 0.2f, 0.5f + x));
+        }
+
+        Tile original_tile(tile);
+        frame->transform_to_output_color_space(tile);
+
+        for (size_t i = 0; i < tile.get_pixel_count(); ++i)
+        {
+            Color4f color;
+            original_tile.get_pixel(i, color);
+
+            Tile pixel_tile(1, 1, 4, PixelFormatFloat);
+            pixel_tile.set_pixel(0, color);
+            frame->transform_to_output_color_space(pixel_tile);
+
+            Color4f expected, result;
+            pixel_tile.get_pixel(0, expected);
+            tile.get_pixel(i, result);
+
+            if (result != expected)
+                return false;
+        }
+
+        return true;
+    }
+
+    TEST_CASE(TransformToOutputColorSpace_SRGB_IsIndependentOfPixelBatching)
+    {
+        EXPECT_TRUE(transform_is_independent_of_pixel_batching("srgb", false));
+        EXPECT_TRUE(transform_is_independent_of_pixel_batching("srgb", true));
+    }
+
+    TEST_CASE(TransformToOutputColorSpace_CIEXYZ_IsIndependentOfPixelBatching)
+    {
+        EXPECT_TRUE(transform_is_independent_of_pixel_batching("ciexyz", false));
+        EXPECT_TRUE(transform_is_independent_of_pixel_batching("ciexyz", true));
+    }
+}
@@ -0,0 +1,157 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/kernel/aov/imagestack.h"
+#include "renderer/kernel/rendering/framedenoiser.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/image/pixel.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Rendering_FrameDenoiser)
+{
+    struct Fixture
+    {
+        auto_release_ptr<Frame> m_frame;
+
+        Fixture()
+          : m_frame(
+                FrameFactory::create(
+                    "frame",
+                    ParamArray()
+                        .insert("resolution", "16 16")
+                        .insert("tile_size", "8 8")
+                        .insert("pixel_format", "float")
+                        .insert("denoise", "true")))
+        {
+            m_frame->aov_images().append("depth", ImageStack::ContributionType, 4, PixelFormatFloat);
+            m_frame->aov_images().append("albedo", ImageStack::ContributionType, 4, PixelFormatFloat);
+            m_frame->aov_images().append("normal", ImageStack::ContributionType, 4, PixelFormatFloat);
+        }
+
+        // Set the features of a pixel; the normal is given in [0,1]^3.
+        void set_features(
+            const size_t    x,
+            const size_t    y,
+            const Color3f&  albedo,
+            const Color3f&  normal,
+            const float     depth)
+        {
+            ImageStack& aov_images = m_frame->aov_images();
+            aov_images.get_image(0).set_pixel(x, y, Color4f(depth, depth, depth, 1.0f));
+            aov_images.get_image(1).set_pixel(x, y, Color4f(albedo[0], albedo[1], albedo[2], 1.0f));
+            aov_images.get_image(2).set_pixel(x, y, Color4f(normal[0], normal[1], normal[2], 1.0f));
+        }
+
+        float get_luminance(const size_t x, const size_t y) const
+        {
+            Color4f color;
+            m_frame->image().get_pixel(x, y, color);
+            return color[0];
+        }
+    };
+
+    TEST_CASE_F(Denoise_GivenFrameWithoutFeatureAOVs_ReturnsFalse, Fixture)
+    {
+        m_frame->aov_images().clear();
+
+        const FrameDenoiser denoiser(2, 1);
+
+        EXPECT_FALSE(denoiser.denoise(m_frame.ref()));
+    }
+
+    TEST_CASE_F(Denoise_GivenNoisyPlane_ReducesNoise, Fixture)
+    {
+        MersenneTwister rng;
+        float input_error = 0.0f;
+
+        for (size_t y = 0; y < 16; ++y)
+        {
+            for (size_t x = 0; x < 16; ++x)
+            {
+                const float value = rand_float1(rng);
+                input_error += (value - 0.5f) * (value - 0.5f);
+                m_frame->image().set_pixel(x, y, Color4f(value, value, value, 1.0f));
+                set_features(x, y, Color3f(1.0f), Color3f(0.5f, 0.5f, 1.0f), 10.0f);
+            }
+        }
+
+        const FrameDenoiser denoiser(3, 2);
+        EXPECT_TRUE(denoiser.denoise(m_frame.ref()));
+
+        float output_error = 0.0f;
+
+        for (size_t y = 0; y < 16; ++y)
+        {
+            for (size_t x = 0; x < 16; ++x)
+            {
+                const float value = get_luminance(x, y);
+                output_error += (value - 0.5f) * (value - 0.5f);
+            }
+        }
+
+        EXPECT_LT(0.25f * input_error, output_error);
+    }
+
+    TEST_CASE_F(Denoise_GivenNormalDiscontinuity_PreservesEdge, Fixture)
+    {
+        for (size_t y = 0; y < 16; ++y)
+        {
+            for (size_t x = 0; x < 16; ++x)
+            {
+                const bool left = x < 8;
+                const float value = left ? 0.0f : 1.0f;
+                m_frame->image().set_pixel(x, y, Color4f(value, value, value, 1.0f));
+                set_features(
+                    x, y,
+                    Color3f(1.0f),
+                    left ? Color3f(1.0f, 0.5f, 0.5f) : Color3f(0.5f, 0.5f, 1.0f),
+                    10.0f);
+            }
+        }
+
+        const FrameDenoiser denoiser(3, 1);
+        EXPECT_TRUE(denoiser.denoise(m_frame.ref()));
+
+        EXPECT_FEQ(0.0f, get_luminance(7, 8));
+        EXPECT_FEQ(1.0f, get_luminance(8, 8));
+    }
+}
@@ -0,0 +1,207 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/globalsampleaccumulationbuffer.h"
+#include "renderer/kernel/rendering/sample.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/color.h"
+#include "foundation/image/image.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/job/abortswitch.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Rendering_GlobalSampleAccumulationBuffer)
+{
+    auto_release_ptr<Frame> create_frame()
+    {
+        // The resolution isn't a multiple of the tile or bucket size.
+        return
+            FrameFactory::create(
+                "frame",
+                ParamArray()
+                    .insert("resolution", "80 48")
+                    .insert("tile_size", "32 32")
+                    .insert("pixel_format", "float")
+                    .insert("color_space", "linear_rgb"));
+    }
+
+    void generate_samples(MersenneTwister& rng, const size_t sample_count, vector<Sample>& samples)
+    {
+        samples.resize(sample_count);
+
+        for (size_t i = 0; i < sample_count; ++i)
+        {
+            samples[i].m_position.x = rand_float1(rng);
+            samples[i].m_position.y = rand_float1(rng);
+            samples[i].m_values[0] = rand_float1(rng);
+            samples[i].m_values[1] = rand_float1(rng);
+            samples[i].m_values[2] = rand_float1(rng);
+            samples[i].m_values[3] = 1.0f;
+            samples[i].m_values[4] = 0.0f;
+        }
+    }
+
+    // Store samples in batches of 'batch_size', handing out batches to rendering threads in turn.
+    void store_samples(
+        GlobalSampleAccumulationBuffer& buffer,
+        const vector<Sample>&           samples,
+        const size_t                    batch_size)
+    {
+        AbortSwitch abort_switch;
+
+        for (size_t i = 0, thread_index = 0; i < samples.size(); i += batch_size, ++thread_index)
+        {
+            const size_t count = min(batch_size, samples.size() - i);
+            buffer.store_samples(thread_index, count, &samples[i], abort_switch);
+        }
+
+        buffer.increment_sample_count(samples.size());
+    }
+
+    bool frames_are_equal(const Frame& lhs, const Frame& rhs)
+    {
+        const CanvasProperties& props = lhs.image().properties();
+
+        for (size_t y = 0; y < props.m_canvas_height; ++y)
+        {
+            for (size_t x = 0; x < props.m_canvas_width; ++x)
+            {
+                Color4f lhs_color, rhs_color;
+                lhs.image().get_pixel(x, y, lhs_color);
+                rhs.image().get_pixel(x, y, rhs_color);
+
+                if (!feq(lhs_color, rhs_color, 1.0e-4f))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    TEST_CASE(DevelopToFrame_GivenThreadBuffers_MatchesSharedFramebuffer)
+    {
+        auto_release_ptr<Frame> shared_frame(create_frame());
+        auto_release_ptr<Frame> per_thread_frame(create_frame());
+
+        GlobalSampleAccumulationBuffer shared_buffer(80, 48, shared_frame->get_filter());
+        GlobalSampleAccumulationBuffer per_thread_buffer(80, 48, per_thread_frame->get_filter(), 3);
+
+        MersenneTwister rng;
+        vector<Sample> samples;
+        AbortSwitch abort_switch;
+
+        // Develop twice to check that thread buffers are correctly emptied when they are merged.
+        for (size_t i = 0; i < 2; ++i)
+        {
+            generate_samples(rng, 5000, samples);
+
+            store_samples(shared_buffer, samples, 100);
+            store_samples(per_thread_buffer, samples, 100);
+
+            shared_buffer.develop_to_frame(shared_frame.ref(), abort_switch);
+            per_thread_buffer.develop_to_frame(per_thread_frame.ref(), abort_switch);
+
+            EXPECT_TRUE(frames_are_equal(shared_frame.ref(), per_thread_frame.ref()));
+        }
+    }
+
+    TEST_CASE(Clear_GivenThreadBuffers_DiscardsPendingSamples)
+    {
+        auto_release_ptr<Frame> reference_frame(create_frame());
+        auto_release_ptr<Frame> frame(create_frame());
+
+        GlobalSampleAccumulationBuffer reference_buffer(80, 48, reference_frame->get_filter(), 3);
+        GlobalSampleAccumulationBuffer buffer(80, 48, frame->get_filter(), 3);
+
+        MersenneTwister rng;
+        vector<Sample> samples;
+        AbortSwitch abort_switch;
+
+        generate_samples(rng, 1000, samples);
+        store_samples(buffer, samples, 100);
+        buffer.clear();
+
+        generate_samples(rng, 1000, samples);
+        store_samples(reference_buffer, samples, 100);
+        store_samples(buffer, samples, 100);
+
+        reference_buffer.develop_to_frame(reference_frame.ref(), abort_switch);
+        buffer.develop_to_frame(frame.ref(), abort_switch);
+
+        EXPECT_TRUE(frames_are_equal(reference_frame.ref(), frame.ref()));
+    }
+
+    TEST_CASE(DevelopDirtyTilesToFrame_GivenSamplesInOneTile_DevelopsOnlyThisTile)
+    {
+        auto_release_ptr<Frame> frame(create_frame());
+
+        GlobalSampleAccumulationBuffer buffer(80, 48, frame->get_filter(), 3);
+
+        AbortSwitch abort_switch;
+        vector<size_t> tiles;
+
+        // The first refresh develops the whole frame.
+        buffer.develop_dirty_tiles_to_frame(frame.ref(), tiles, abort_switch);
+        EXPECT_EQ(6, tiles.size());
+
+        vector<Sample> samples(1);
+        samples[0].m_position.x = 0.1f;
+        samples[0].m_position.y = 0.1f;
+        samples[0].m_values[0] = 1.0f;
+        samples[0].m_values[1] = 1.0f;
+        samples[0].m_values[2] = 1.0f;
+        samples[0].m_values[3] = 1.0f;
+        samples[0].m_values[4] = 0.0f;
+        store_samples(buffer, samples, 1);
+
+        tiles.clear();
+        buffer.develop_dirty_tiles_to_frame(frame.ref(), tiles, abort_switch);
+        ASSERT_EQ(1, tiles.size());
+        EXPECT_EQ(0, tiles[0]);
+
+        tiles.clear();
+        buffer.develop_dirty_tiles_to_frame(frame.ref(), tiles, abort_switch);
+        EXPECT_TRUE(tiles.empty());
+    }
+}
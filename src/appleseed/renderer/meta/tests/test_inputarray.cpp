@@ -95,4 +95,43 @@ TEST_SUITE(Renderer_Modeling_Input_InputArray)
 
         EXPECT_EQ(expected_source, source);
     }
+
+    APPLESEED_DECLARE_INPUT_VALUES(TwoScalarInputValues)
+    {
+        float m_x;
+        float m_y;
+    };
+
+    TEST_CASE(EvaluateUniforms_GivenCompiledInputs_ReturnsPrecomputedValues)
+    {
+        InputArray inputs;
+        inputs.declare("x", InputFormatFloat);
+        inputs.declare("y", InputFormatFloat);
+        inputs.find("x").bind(new ScalarSource(2.0));
+        inputs.compile();
+
+        TwoScalarInputValues values;
+        values.m_x = values.m_y = -1.0f;
+        inputs.evaluate_uniforms(&values);
+
+        EXPECT_TRUE(inputs.is_compiled());
+        EXPECT_EQ(2.0f, values.m_x);
+        EXPECT_EQ(0.0f, values.m_y);
+    }
+
+    TEST_CASE(Bind_GivenCompiledInputs_DiscardsPrecomputedValues)
+    {
+        InputArray inputs;
+        inputs.declare("x", InputFormatFloat);
+        inputs.compile();
+
+        inputs.find("x").bind(new ScalarSource(3.0));
+
+        EXPECT_FALSE(inputs.is_compiled());
+
+        TwoScalarInputValues values;
+        inputs.evaluate_uniforms(&values);
+
+        EXPECT_EQ(3.0f, values.m_x);
+    }
 }
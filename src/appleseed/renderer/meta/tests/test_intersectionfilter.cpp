@@ -0,0 +1,214 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/intersection/intersectionfilter.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Intersection_IntersectionFilter)
+{
+    // Return the texture coordinates of the center of a texel of a width x height mask.
+    Vector2f texel_center(
+        const size_t    x,
+        const size_t    y,
+        const size_t    width,
+        const size_t    height)
+    {
+        return
+            Vector2f(
+                (x + 0.5f) / width,
+                (y + 0.5f) / height);
+    }
+
+    // 8x8 mask whose left half is opaque and right half is transparent.
+    const size_t HalfMaskSize = 8;
+
+    bool is_half_mask_opaque(const size_t x, const size_t y)
+    {
+        return x < HalfMaskSize / 2;
+    }
+
+    TEST_CASE(GetCoverage_GivenTriangleOverOpaqueRegion_ReturnsOpaque)
+    {
+        IntersectionFilter::AlphaMask mask(HalfMaskSize, HalfMaskSize);
+        for (size_t y = 0; y < HalfMaskSize; ++y)
+        {
+            for (size_t x = 0; x < HalfMaskSize; ++x)
+                mask.set_opaque(x, y, is_half_mask_opaque(x, y));
+        }
+        mask.build_coverage_hierarchy();
+
+        const IntersectionFilter::Coverage coverage =
+            mask.get_coverage(
+                texel_center(0, 0, HalfMaskSize, HalfMaskSize),
+                texel_center(3, 0, HalfMaskSize, HalfMaskSize),
+                texel_center(0, 7, HalfMaskSize, HalfMaskSize));
+
+        EXPECT_EQ(IntersectionFilter::CoverageOpaque, coverage);
+    }
+
+    TEST_CASE(GetCoverage_GivenTriangleOverTransparentRegion_ReturnsTransparent)
+    {
+        IntersectionFilter::AlphaMask mask(HalfMaskSize, HalfMaskSize);
+        for (size_t y = 0; y < HalfMaskSize; ++y)
+        {
+            for (size_t x = 0; x < HalfMaskSize; ++x)
+                mask.set_opaque(x, y, is_half_mask_opaque(x, y));
+        }
+        mask.build_coverage_hierarchy();
+
+        const IntersectionFilter::Coverage coverage =
+            mask.get_coverage(
+                texel_center(4, 0, HalfMaskSize, HalfMaskSize),
+                texel_center(7, 0, HalfMaskSize, HalfMaskSize),
+                texel_center(4, 7, HalfMaskSize, HalfMaskSize));
+
+        EXPECT_EQ(IntersectionFilter::CoverageTransparent, coverage);
+    }
+
+    TEST_CASE(GetCoverage_GivenTriangleOverMixedRegion_ReturnsPartial)
+    {
+        IntersectionFilter::AlphaMask mask(HalfMaskSize, HalfMaskSize);
+        for (size_t y = 0; y < HalfMaskSize; ++y)
+        {
+            for (size_t x = 0; x < HalfMaskSize; ++x)
+                mask.set_opaque(x, y, is_half_mask_opaque(x, y));
+        }
+        mask.build_coverage_hierarchy();
+
+        // This triangle straddles the boundary between the two halves of the mask.
+        const IntersectionFilter::Coverage coverage =
+            mask.get_coverage(
+                texel_center(3, 2, HalfMaskSize, HalfMaskSize),
+                texel_center(4, 2, HalfMaskSize, HalfMaskSize),
+                texel_center(3, 3, HalfMaskSize, HalfMaskSize));
+
+        EXPECT_EQ(IntersectionFilter::CoveragePartial, coverage);
+    }
+
+    bool is_pattern_opaque(const size_t x, const size_t y)
+    {
+        return (x * 7 + y * 3) % 5 != 0;
+    }
+
+    TEST_CASE(GetCoverage_GivenNonPowerOfTwoMask_IsConservative)
+    {
+        const size_t Sizes[][2] = { { 1, 3 }, { 5, 3 }, { 7, 5 }, { 13, 9 } };
+
+        for (size_t i = 0; i < sizeof(Sizes) / sizeof(Sizes[0]); ++i)
+        {
+            const size_t width = Sizes[i][0];
+            const size_t height = Sizes[i][1];
+
+            // A uniform mask must be uniform at every level of its coverage hierarchy.
+            IntersectionFilter::AlphaMask opaque_mask(width, height);
+            for (size_t y = 0; y < height; ++y)
+            {
+                for (size_t x = 0; x < width; ++x)
+                    opaque_mask.set_opaque(x, y, true);
+            }
+            opaque_mask.build_coverage_hierarchy();
+
+            EXPECT_EQ(
+                IntersectionFilter::CoverageOpaque,
+                opaque_mask.get_coverage(
+                    texel_center(0, 0, width, height),
+                    texel_center(width - 1, 0, width, height),
+                    texel_center(0, height - 1, width, height)));
+
+            IntersectionFilter::AlphaMask mask(width, height);
+            for (size_t y = 0; y < height; ++y)
+            {
+                for (size_t x = 0; x < width; ++x)
+                    mask.set_opaque(x, y, is_pattern_opaque(x, y));
+            }
+            mask.build_coverage_hierarchy();
+
+            // Check the coverage of the triangles spanning every texel space bounding box.
+            for (size_t y0 = 0; y0 < height; ++y0)
+            {
+                for (size_t y1 = y0; y1 < height; ++y1)
+                {
+                    for (size_t x0 = 0; x0 < width; ++x0)
+                    {
+                        for (size_t x1 = x0; x1 < width; ++x1)
+                        {
+                            bool has_opaque_texels = false;
+                            bool has_transparent_texels = false;
+
+                            for (size_t y = y0; y <= y1; ++y)
+                            {
+                                for (size_t x = x0; x <= x1; ++x)
+                                {
+                                    if (is_pattern_opaque(x, y))
+                                        has_opaque_texels = true;
+                                    else has_transparent_texels = true;
+                                }
+                            }
+
+                            const IntersectionFilter::Coverage coverage =
+                                mask.get_coverage(
+                                    texel_center(x0, y0, width, height),
+                                    texel_center(x1, y0, width, height),
+                                    texel_center(x0, y1, width, height));
+
+                            // A single texel is always classified exactly.
+                            if (x0 == x1 && y0 == y1)
+                            {
+                                EXPECT_EQ(
+                                    has_opaque_texels
+                                        ? IntersectionFilter::CoverageOpaque
+                                        : IntersectionFilter::CoverageTransparent,
+                                    coverage);
+                            }
+
+                            if (coverage == IntersectionFilter::CoverageOpaque)
+                                EXPECT_FALSE(has_transparent_texels);
+
+                            if (coverage == IntersectionFilter::CoverageTransparent)
+                                EXPECT_FALSE(has_opaque_texels);
+
+                            if (has_opaque_texels && has_transparent_texels)
+                                EXPECT_EQ(IntersectionFilter::CoveragePartial, coverage);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
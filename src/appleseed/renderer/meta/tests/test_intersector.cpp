@@ -29,6 +29,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/intersectionsettings.h"
 #include "renderer/kernel/intersection/intersector.h"
 #include "renderer/kernel/intersection/tracecontext.h"
 #include "renderer/kernel/shading/shadingpoint.h"
@@ -46,15 +47,26 @@
 #include "renderer/utility/testutils.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/intersection/raytrianglemt.h"
 #include "foundation/math/matrix.h"
+#include "foundation/math/ray.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/sampling/mappings.h"
 #include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
 #include "foundation/utility/autoreleaseptr.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/test.h"
 
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
 using namespace foundation;
 using namespace renderer;
+using namespace std;
 
 TEST_SUITE(Renderer_Kernel_Intersection_Intersector)
 {
@@ -142,4 +154,74 @@ TEST_SUITE(Renderer_Kernel_Intersection_Intersector)
 
         EXPECT_FALSE(hit);
     }
+
+    Vector3d rand_vector3d(MersenneTwister& rng)
+    {
+        return
+            Vector3d(
+                rand_double1(rng, -1.0, 1.0),
+                rand_double1(rng, -1.0, 1.0),
+                rand_double1(rng, -1.0, 1.0));
+    }
+
+    Vector3d rand_direction(MersenneTwister& rng, const Vector3d& n)
+    {
+        const Vector3d d = sample_sphere_uniform(Vector2d(rand_double2(rng), rand_double2(rng)));
+        return dot(d, n) < 0.0 ? -d : d;
+    }
+
+    TEST_CASE(ErrorBoundedOffset_GivenSinglePrecisionTriangles_PreventsSelfIntersections)
+    {
+        typedef TriangleMT<float> TriangleType;
+
+        MersenneTwister rng;
+        size_t self_intersection_count = 0;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            // Build a triangle of random size and position, up to far away from the origin.
+            const double scale = pow(10.0, rand_double1(rng, -2.0, 6.0));
+            const double size = scale * pow(10.0, rand_double1(rng, -3.0, 0.0));
+            const Vector3d center = scale * rand_vector3d(rng);
+            const TriangleType triangle(
+                Vector3f(center + size * rand_vector3d(rng)),
+                Vector3f(center + size * rand_vector3d(rng)),
+                Vector3f(center + size * rand_vector3d(rng)));
+            const TriangleSupportPlaneType support_plane(triangle);
+
+            // Hit the triangle with a single precision ray.
+            const Vector3d bary = sample_triangle_uniform(Vector2d(rand_double2(rng), rand_double2(rng)));
+            const Vector3d target =
+                  bary[0] * Vector3d(triangle.m_v0)
+                + bary[1] * Vector3d(triangle.m_v0 + triangle.m_e0)
+                + bary[2] * Vector3d(triangle.m_v0 + triangle.m_e1);
+            const Vector3d dir = sample_sphere_uniform(Vector2d(rand_double2(rng), rand_double2(rng)));
+            const Vector3d org = target - 3.0 * size * dir;
+            const Ray3f ray(Vector3f(org), Vector3f(dir), 0.0f, numeric_limits<float>::max());
+
+            float t, u, v;
+            if (!triangle.intersect(ray, t, u, v))
+                continue;
+
+            // Refine and offset the hit point.
+            const Vector3d p = Intersector::refine(support_plane, org + static_cast<double>(t) * dir, dir);
+            const Vector3d n = faceforward(cross(support_plane.m_e0, support_plane.m_e1), dir);
+            Vector3d front, back;
+            Intersector::error_bounded_offset(support_plane, p, n, front, back);
+
+            // Rays leaving the offset points must not hit the triangle.
+            for (size_t j = 0; j < 8; ++j)
+            {
+                const Vector3d out = rand_direction(rng, n);
+
+                if (triangle.intersect(Ray3f(Vector3f(front), Vector3f(out), 0.0f, numeric_limits<float>::max())))
+                    ++self_intersection_count;
+
+                if (triangle.intersect(Ray3f(Vector3f(back), Vector3f(-out), 0.0f, numeric_limits<float>::max())))
+                    ++self_intersection_count;
+            }
+        }
+
+        EXPECT_EQ(0, self_intersection_count);
+    }
 }
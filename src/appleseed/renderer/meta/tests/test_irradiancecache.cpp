@@ -0,0 +1,127 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/lighting/irradiancecache.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/basis.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Lighting_IrradianceCache)
+{
+    struct Fixture
+    {
+        auto_release_ptr<Scene>     m_scene;
+        IrradianceCache             m_cache;
+
+        Fixture()
+          : m_scene(SceneFactory::create())
+          , m_cache(m_scene.ref(), ParamArray().insert("irradiance_cache_samples", 64))
+        {
+        }
+
+        void insert_uniform_record(
+            const Vector3d&         point,
+            const Vector3d&         normal,
+            Spectrum&               irradiance)
+        {
+            const size_t sample_count =
+                m_cache.get_theta_stratum_count() * m_cache.get_phi_stratum_count();
+
+            const vector<Spectrum> radiance(sample_count, Spectrum(1.0f, Spectrum::Illuminance));
+            const vector<double> distances(sample_count, 1.0);
+
+            m_cache.insert(point, Basis3d(normal), &radiance[0], &distances[0], irradiance);
+        }
+    };
+
+    TEST_CASE_F(Insert_UniformRadiance_ReturnsPiTimesRadiance, Fixture)
+    {
+        Spectrum irradiance(Spectrum::Illuminance);
+        insert_uniform_record(Vector3d(0.0), Vector3d(0.0, 1.0, 0.0), irradiance);
+
+        EXPECT_FEQ(Pi<float>(), average_value(irradiance));
+        EXPECT_EQ(1, m_cache.get_record_count());
+    }
+
+    TEST_CASE_F(Lookup_EmptyCache_ReturnsFalse, Fixture)
+    {
+        Spectrum irradiance(Spectrum::Illuminance);
+        const bool found = m_cache.lookup(Vector3d(0.0), Vector3d(0.0, 1.0, 0.0), irradiance);
+
+        EXPECT_FALSE(found);
+    }
+
+    TEST_CASE_F(Lookup_NearRecord_ReturnsIrradianceOfRecord, Fixture)
+    {
+        Spectrum record_irradiance(Spectrum::Illuminance);
+        insert_uniform_record(Vector3d(0.0), Vector3d(0.0, 1.0, 0.0), record_irradiance);
+
+        Spectrum irradiance(Spectrum::Illuminance);
+        const bool found = m_cache.lookup(Vector3d(0.001, 0.0, 0.0), Vector3d(0.0, 1.0, 0.0), irradiance);
+
+        ASSERT_TRUE(found);
+        EXPECT_FEQ(Pi<float>(), average_value(irradiance));
+    }
+
+    TEST_CASE_F(Lookup_FarFromRecord_ReturnsFalse, Fixture)
+    {
+        Spectrum record_irradiance(Spectrum::Illuminance);
+        insert_uniform_record(Vector3d(0.0), Vector3d(0.0, 1.0, 0.0), record_irradiance);
+
+        Spectrum irradiance(Spectrum::Illuminance);
+        const bool found = m_cache.lookup(Vector3d(0.9, 0.0, 0.0), Vector3d(0.0, 1.0, 0.0), irradiance);
+
+        EXPECT_FALSE(found);
+    }
+
+    TEST_CASE_F(Lookup_OppositeNormal_ReturnsFalse, Fixture)
+    {
+        Spectrum record_irradiance(Spectrum::Illuminance);
+        insert_uniform_record(Vector3d(0.0), Vector3d(0.0, 1.0, 0.0), record_irradiance);
+
+        Spectrum irradiance(Spectrum::Illuminance);
+        const bool found = m_cache.lookup(Vector3d(0.0), Vector3d(0.0, -1.0, 0.0), irradiance);
+
+        EXPECT_FALSE(found);
+    }
+}
@@ -0,0 +1,105 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/lightreservoir.h"
+#include "renderer/kernel/lighting/lightsampler.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_LightReservoir)
+{
+    TEST_CASE(GetContributionWeight_GivenEmptyReservoir_ReturnsZero)
+    {
+        const LightReservoir reservoir;
+
+        EXPECT_EQ(0.0f, reservoir.get_contribution_weight());
+    }
+
+    TEST_CASE(Update_GivenFirstCandidate_SelectsIt)
+    {
+        LightReservoir reservoir;
+        LightSample sample;
+        sample.m_probability = 0.5f;
+
+        float s = 0.9f;
+        const bool selected = reservoir.update(sample, 3.0f, 3.0f / 0.5f, 1.0f, s);
+
+        EXPECT_TRUE(selected);
+        EXPECT_FEQ(3.0f, reservoir.m_target);
+        EXPECT_FEQ(0.9f, s);
+    }
+
+    TEST_CASE(Update_GivenCandidateWithZeroWeight_CountsButDoesNotSelectIt)
+    {
+        LightReservoir reservoir;
+        LightSample sample;
+
+        float s = 0.0f;
+        const bool selected = reservoir.update(sample, 0.0f, 0.0f, 1.0f, s);
+
+        EXPECT_FALSE(selected);
+        EXPECT_EQ(1.0f, reservoir.m_sample_count);
+        EXPECT_EQ(0.0f, reservoir.m_weight_sum);
+    }
+
+    TEST_CASE(Update_GivenTwoCandidates_SelectsSecondOneInProportionOfItsWeight)
+    {
+        LightSample sample;
+
+        // The second candidate carries three quarters of the total weight.
+        LightReservoir reservoir1;
+        float s1 = 0.2f;
+        reservoir1.update(sample, 1.0f, 1.0f, 1.0f, s1);
+        EXPECT_TRUE(reservoir1.update(sample, 3.0f, 3.0f, 1.0f, s1));
+
+        LightReservoir reservoir2;
+        float s2 = 0.8f;
+        reservoir2.update(sample, 1.0f, 1.0f, 1.0f, s2);
+        EXPECT_FALSE(reservoir2.update(sample, 3.0f, 3.0f, 1.0f, s2));
+        EXPECT_FEQ(1.0f, reservoir2.m_target);
+    }
+
+    TEST_CASE(GetContributionWeight_GivenCandidatesProportionalToTarget_ReturnsReciprocalOfNormalizedTarget)
+    {
+        LightReservoir reservoir;
+        LightSample sample;
+
+        // Two candidates drawn with a probability density of 0.5 and a constant target function of 2.
+        float s = 0.5f;
+        reservoir.update(sample, 2.0f, 2.0f / 0.5f, 1.0f, s);
+        reservoir.update(sample, 2.0f, 2.0f / 0.5f, 1.0f, s);
+
+        EXPECT_FEQ(2.0f, reservoir.get_contribution_weight());
+    }
+}
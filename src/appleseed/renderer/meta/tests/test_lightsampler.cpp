@@ -28,12 +28,28 @@
 //
 
 // appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
 #include "renderer/kernel/lighting/lightsampler.h"
 #include "renderer/modeling/camera/pinholecamera.h"
+#include "renderer/modeling/light/light.h"
+#include "renderer/modeling/light/maxomnilight.h"
+#include "renderer/modeling/light/spotlight.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
 #include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/matrix.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/test.h"
 
 using namespace foundation;
@@ -49,4 +65,170 @@ TEST_SUITE(Renderer_Kernel_Lighting_LightSampler)
 
         EXPECT_FALSE(light_sampler.has_lights_or_emitting_triangles());
     }
+
+    struct SceneWithLocalLights
+    {
+        auto_release_ptr<Scene> m_scene;
+
+        SceneWithLocalLights()
+          : m_scene(SceneFactory::create())
+        {
+            m_scene->cameras().insert(PinholeCameraFactory().create("camera", ParamArray()));
+
+            auto_release_ptr<Assembly> assembly(AssemblyFactory().create("assembly", ParamArray()));
+
+            // The geometry of the scene defines the extent of the light culling grid.
+            assembly->objects().insert(
+                auto_release_ptr<Object>(
+                    new BoundingBoxObject(
+                        "object",
+                        GAABB3(GVector3(-10.0), GVector3(+10.0)))));
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "object_inst",
+                    ParamArray(),
+                    "object",
+                    Transformd::identity(),
+                    StringDictionary()));
+
+            // Two omni lights with a limited reach, on each side of the origin.
+            insert_omni_light(assembly.ref(), "omni_left", Vector3d(-5.0, 0.0, 0.0));
+            insert_omni_light(assembly.ref(), "omni_right", Vector3d(+5.0, 0.0, 0.0));
+
+            // A spot light at the origin, pointing toward -Z.
+            assembly->lights().insert(
+                SpotLightFactory().create(
+                    "spot",
+                    ParamArray()
+                        .insert("intensity", "1.0")
+                        .insert("inner_angle", "20.0")
+                        .insert("outer_angle", "30.0")));
+
+            auto_release_ptr<AssemblyInstance> assembly_instance(
+                AssemblyInstanceFactory::create("assembly_inst", ParamArray(), "assembly"));
+
+            m_scene->assemblies().insert(assembly);
+            m_scene->assembly_instances().insert(assembly_instance);
+            m_scene->assembly_instances().get_by_name("assembly_inst")->bind_assembly(m_scene->assemblies());
+        }
+
+        static void insert_omni_light(
+            Assembly&           assembly,
+            const char*         name,
+            const Vector3d&     position)
+        {
+            auto_release_ptr<Light> light(
+                MaxOmniLightFactory().create(
+                    name,
+                    ParamArray()
+                        .insert("intensity", "1.0")
+                        .insert("cutoff_distance", "1.0")));
+            light->set_transform(Transformd::from_local_to_parent(Matrix4d::make_translation(position)));
+            assembly.lights().insert(light);
+        }
+    };
+
+    TEST_CASE_F(MayIlluminate_GivenPointBeyondCutoffDistance_ReturnsFalse, SceneWithLocalLights)
+    {
+        LightSampler light_sampler(m_scene.ref(), ParamArray().insert("enable_light_culling", true));
+
+        EXPECT_FALSE(light_sampler.may_illuminate(0, Vector3d(+5.0, 0.0, 0.0)));
+    }
+
+    TEST_CASE_F(MayIlluminate_GivenPointWithinCutoffDistance_ReturnsTrue, SceneWithLocalLights)
+    {
+        LightSampler light_sampler(m_scene.ref(), ParamArray().insert("enable_light_culling", true));
+
+        EXPECT_TRUE(light_sampler.may_illuminate(0, Vector3d(-5.0, 0.5, 0.0)));
+    }
+
+    TEST_CASE_F(MayIlluminate_GivenPointOutsideSpotLightCone_ReturnsFalse, SceneWithLocalLights)
+    {
+        LightSampler light_sampler(m_scene.ref(), ParamArray().insert("enable_light_culling", true));
+
+        EXPECT_FALSE(light_sampler.may_illuminate(2, Vector3d(0.0, 0.0, +5.0)));
+        EXPECT_TRUE(light_sampler.may_illuminate(2, Vector3d(0.0, 0.0, -5.0)));
+    }
+
+    TEST_CASE_F(MayIlluminate_GivenLightCullingDisabled_ReturnsTrue, SceneWithLocalLights)
+    {
+        LightSampler light_sampler(m_scene.ref());
+
+        EXPECT_TRUE(light_sampler.may_illuminate(0, Vector3d(+5.0, 0.0, 0.0)));
+    }
+
+    TEST_CASE_F(SampleNonPhysicalLights_GivenPointNearSingleLight_SamplesThisLightOnly, SceneWithLocalLights)
+    {
+        LightSampler light_sampler(m_scene.ref(), ParamArray().insert("enable_light_culling", true));
+        const Light* omni_left = m_scene->assembly_instances().get_by_name("assembly_inst")->get_assembly().lights().get_by_name("omni_left");
+
+        for (size_t i = 0; i < 8; ++i)
+        {
+            LightSample light_sample;
+            light_sampler.sample_non_physical_lights(
+                ShadingRay::Time(),
+                Vector3d(-5.0, 0.5, 0.0),
+                Vector3f(i / 8.0f, 0.5f, 0.5f),
+                light_sample);
+
+            EXPECT_EQ(omni_left, light_sample.m_light);
+            EXPECT_FEQ(1.0f, light_sample.m_probability);
+        }
+    }
+
+    TEST_CASE_F(ComputeSignature_GivenUnchangedScene_ReturnsSameSignature, SceneWithLocalLights)
+    {
+        const uint64 signature1 = LightSampler::compute_signature(m_scene.ref());
+        const uint64 signature2 = LightSampler::compute_signature(m_scene.ref());
+
+        EXPECT_EQ(signature1, signature2);
+    }
+
+    TEST_CASE_F(ComputeSignature_AfterInsertingLight_ReturnsDifferentSignature, SceneWithLocalLights)
+    {
+        const uint64 signature1 = LightSampler::compute_signature(m_scene.ref());
+        insert_omni_light(*m_scene->assemblies().get_by_name("assembly"), "omni_top", Vector3d(0.0, 5.0, 0.0));
+        const uint64 signature2 = LightSampler::compute_signature(m_scene.ref());
+
+        EXPECT_NEQ(signature1, signature2);
+    }
+
+    TEST_CASE_F(ComputeSignature_AfterMovingAssemblyInstance_ReturnsDifferentSignature, SceneWithLocalLights)
+    {
+        const uint64 signature1 = LightSampler::compute_signature(m_scene.ref());
+        m_scene->assembly_instances().get_by_name("assembly_inst")->transform_sequence().set_transform(
+            0.0f,
+            Transformd::from_local_to_parent(Matrix4d::make_translation(Vector3d(1.0, 0.0, 0.0))));
+        const uint64 signature2 = LightSampler::compute_signature(m_scene.ref());
+
+        EXPECT_NEQ(signature1, signature2);
+    }
+
+    TEST_CASE_F(LightSamplerCacheGet_GivenUnchangedSceneAndParameters_ReusesLightSampler, SceneWithLocalLights)
+    {
+        LightSamplerCache cache;
+        const LightSampler* light_sampler1 = &cache.get(m_scene.ref(), ParamArray());
+        const LightSampler* light_sampler2 = &cache.get(m_scene.ref(), ParamArray());
+
+        EXPECT_EQ(light_sampler1, light_sampler2);
+    }
+
+    TEST_CASE_F(LightSamplerCacheGet_GivenDifferentParameters_RebuildsLightSampler, SceneWithLocalLights)
+    {
+        LightSamplerCache cache;
+        cache.get(m_scene.ref(), ParamArray());
+        const LightSampler& light_sampler = cache.get(m_scene.ref(), ParamArray().insert("enable_light_culling", true));
+
+        EXPECT_FALSE(light_sampler.may_illuminate(0, Vector3d(+5.0, 0.0, 0.0)));
+    }
+
+    TEST_CASE_F(LightSamplerCacheGet_AfterInsertingLight_RebuildsLightSampler, SceneWithLocalLights)
+    {
+        LightSamplerCache cache;
+        cache.get(m_scene.ref(), ParamArray());
+        insert_omni_light(*m_scene->assemblies().get_by_name("assembly"), "omni_top", Vector3d(0.0, 5.0, 0.0));
+        const LightSampler& light_sampler = cache.get(m_scene.ref(), ParamArray());
+
+        EXPECT_EQ(4, light_sampler.get_non_physical_light_count());
+    }
 }
@@ -0,0 +1,174 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/lighting/lightsampler.h"
+#include "renderer/kernel/lighting/lightselectionguide.h"
+#include "renderer/modeling/camera/pinholecamera.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/modeling/light/light.h"
+#include "renderer/modeling/light/maxomnilight.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/matrix.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/job/abortswitch.h"
+#include "foundation/utility/job/jobqueue.h"
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_LightSelectionGuide)
+{
+    struct Fixture
+    {
+        auto_release_ptr<Scene>     m_scene;
+        auto_release_ptr<Frame>     m_frame;
+        JobQueue                    m_job_queue;
+        AbortSwitch                 m_abort_switch;
+
+        Fixture()
+          : m_scene(SceneFactory::create())
+          , m_frame(
+                FrameFactory::create(
+                    "frame",
+                    ParamArray().insert("resolution", "4 4")))
+        {
+            m_scene->cameras().insert(PinholeCameraFactory().create("camera", ParamArray()));
+
+            auto_release_ptr<Assembly> assembly(AssemblyFactory().create("assembly", ParamArray()));
+
+            // The geometry of the scene defines the extent of the grid.
+            assembly->objects().insert(
+                auto_release_ptr<Object>(
+                    new BoundingBoxObject(
+                        "object",
+                        GAABB3(GVector3(-10.0), GVector3(+10.0)))));
+            assembly->object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "object_inst",
+                    ParamArray(),
+                    "object",
+                    Transformd::identity(),
+                    StringDictionary()));
+
+            insert_omni_light(assembly.ref(), "omni_left", Vector3d(-5.0, 0.0, 0.0));
+            insert_omni_light(assembly.ref(), "omni_right", Vector3d(+5.0, 0.0, 0.0));
+
+            auto_release_ptr<AssemblyInstance> assembly_instance(
+                AssemblyInstanceFactory::create("assembly_inst", ParamArray(), "assembly"));
+
+            m_scene->assemblies().insert(assembly);
+            m_scene->assembly_instances().insert(assembly_instance);
+            m_scene->assembly_instances().get_by_name("assembly_inst")->bind_assembly(m_scene->assemblies());
+        }
+
+        static void insert_omni_light(
+            Assembly&           assembly,
+            const char*         name,
+            const Vector3d&     position)
+        {
+            auto_release_ptr<Light> light(
+                MaxOmniLightFactory().create(
+                    name,
+                    ParamArray().insert("intensity", "1.0")));
+            light->set_transform(Transformd::from_local_to_parent(Matrix4d::make_translation(position)));
+            assembly.lights().insert(light);
+        }
+
+        void render_pass(LightSelectionGuide& guide)
+        {
+            guide.pre_render(m_frame.ref(), m_job_queue, m_abort_switch);
+            guide.post_render(m_frame.ref(), m_job_queue, m_abort_switch);
+        }
+    };
+
+    TEST_CASE_F(IsTraining_AfterTrainingPasses_ReturnsFalse, Fixture)
+    {
+        const LightSampler light_sampler(m_scene.ref());
+        LightSelectionGuide guide(
+            m_scene.ref(),
+            light_sampler,
+            ParamArray().insert("adaptive_light_selection_training_passes", 2));
+
+        EXPECT_TRUE(guide.is_training());
+
+        render_pass(guide);
+        EXPECT_TRUE(guide.is_training());
+
+        render_pass(guide);
+        EXPECT_FALSE(guide.is_training());
+    }
+
+    TEST_CASE_F(GetNonPhysicalLightProbability_BeforeTraining_ReturnsOne, Fixture)
+    {
+        const LightSampler light_sampler(m_scene.ref());
+        LightSelectionGuide guide(m_scene.ref(), light_sampler, ParamArray());
+
+        EXPECT_EQ(1.0f, guide.get_non_physical_light_probability(0, Vector3d(0.0)));
+        EXPECT_EQ(1.0f, guide.get_non_physical_light_probability(1, Vector3d(0.0)));
+    }
+
+    TEST_CASE_F(GetNonPhysicalLightProbability_GivenLightWithoutContribution_ReturnsUnlearnedFraction, Fixture)
+    {
+        const LightSampler light_sampler(m_scene.ref());
+        LightSelectionGuide guide(
+            m_scene.ref(),
+            light_sampler,
+            ParamArray().insert("adaptive_light_selection_fraction", 0.75f));
+
+        guide.record_non_physical_light(Vector3d(0.0), 0, 2.0f);
+        render_pass(guide);
+
+        EXPECT_FEQ(1.0f, guide.get_non_physical_light_probability(0, Vector3d(0.0)));
+        EXPECT_FEQ(0.25f, guide.get_non_physical_light_probability(1, Vector3d(0.0)));
+    }
+
+    TEST_CASE_F(PostRender_AlwaysAllowsRemainingPasses, Fixture)
+    {
+        const LightSampler light_sampler(m_scene.ref());
+        LightSelectionGuide guide(m_scene.ref(), light_sampler, ParamArray());
+        guide.record_non_physical_light(Vector3d(0.0), 1, 1.0f);
+
+        EXPECT_FALSE(guide.post_render(m_frame.ref(), m_job_queue, m_abort_switch));
+    }
+}
@@ -0,0 +1,156 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/lighttree.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Lighting_LightTree)
+{
+    LightTree::Item make_item(
+        const Vector3d&     center,
+        const Vector3d&     normal,
+        const float         power)
+    {
+        LightTree::Item item;
+        item.m_bbox = AABB3d(center - Vector3d(0.1), center + Vector3d(0.1));
+        item.m_axis = normal;
+        item.m_cos_theta_o = 1.0;
+        item.m_power = power;
+        return item;
+    }
+
+    struct Fixture
+    {
+        vector<LightTree::Item>     m_items;
+        LightTree                   m_tree;
+
+        Fixture()
+        {
+            MersenneTwister rng;
+
+            for (size_t i = 0; i < 37; ++i)
+            {
+                const Vector3d center(
+                    rand_double1(rng, -10.0, 10.0),
+                    rand_double1(rng, -10.0, 10.0),
+                    rand_double1(rng, -10.0, 10.0));
+                const Vector3d normal(
+                    normalize(
+                        Vector3d(
+                            rand_double1(rng, -1.0, 1.0),
+                            rand_double1(rng, -1.0, 1.0),
+                            rand_double1(rng, -1.0, 1.0))));
+                m_items.push_back(make_item(center, normal, static_cast<float>(rand_double1(rng, 0.5, 2.0))));
+            }
+
+            m_tree.build(m_items);
+        }
+    };
+
+    TEST_CASE(Build_GivenNoItem_ProducesEmptyTree)
+    {
+        LightTree tree;
+        tree.build(vector<LightTree::Item>());
+
+        EXPECT_TRUE(tree.empty());
+    }
+
+    TEST_CASE_F(Build_GivenItems_CreatesOneLeafPerItem, Fixture)
+    {
+        EXPECT_EQ(2 * m_items.size() - 1, m_tree.get_node_count());
+    }
+
+    TEST_CASE_F(EvaluatePDF_SumsToOneOverAllItems, Fixture)
+    {
+        const Vector3d point(1.0, 2.0, 3.0);
+
+        double sum = 0.0;
+        for (size_t i = 0; i < m_items.size(); ++i)
+            sum += m_tree.evaluate_pdf(point, i);
+
+        EXPECT_FEQ_EPS(1.0, sum, 1.0e-5);
+    }
+
+    TEST_CASE_F(EvaluatePDF_MatchesProbabilityReturnedBySample, Fixture)
+    {
+        const Vector3d point(-4.0, 0.5, 7.0);
+
+        for (size_t i = 0; i < 100; ++i)
+        {
+            float probability;
+            const size_t item_index = m_tree.sample(point, i / 100.0f, probability);
+
+            ASSERT_LT(m_items.size(), item_index);
+            EXPECT_EQ(probability, m_tree.evaluate_pdf(point, item_index));
+        }
+    }
+
+    TEST_CASE(Sample_GivenPointBehindEmitter_ChoosesOtherEmitter)
+    {
+        vector<LightTree::Item> items;
+        items.push_back(make_item(Vector3d(0.0, 0.0, -1.0), Vector3d(0.0, 0.0, -1.0), 1.0f));
+        items.push_back(make_item(Vector3d(5.0, 0.0, 0.0), Vector3d(-1.0, 0.0, 0.0), 1.0f));
+
+        LightTree tree;
+        tree.build(items);
+
+        const Vector3d point(0.0, 0.0, 1.0);
+
+        EXPECT_EQ(0.0f, tree.evaluate_pdf(point, 0));
+        EXPECT_EQ(1.0f, tree.evaluate_pdf(point, 1));
+    }
+
+    TEST_CASE(Sample_GivenTwoOmnidirectionalEmitters_FavorsCloserOne)
+    {
+        vector<LightTree::Item> items;
+        items.push_back(make_item(Vector3d(1.0, 0.0, 0.0), Vector3d(0.0, 0.0, 1.0), 1.0f));
+        items.push_back(make_item(Vector3d(-4.0, 0.0, 0.0), Vector3d(0.0, 0.0, 1.0), 1.0f));
+        items[0].m_cos_theta_o = items[1].m_cos_theta_o = -1.0;
+
+        LightTree tree;
+        tree.build(items);
+
+        const Vector3d point(0.0, 0.0, 0.0);
+
+        EXPECT_LT(tree.evaluate_pdf(point, 0), tree.evaluate_pdf(point, 1));
+    }
+}
@@ -0,0 +1,87 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/liverenderstatistics.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstring>
+
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Rendering_LiveRenderCounters)
+{
+    TEST_CASE(Constructor_SetsStageToIdleAndCountersToZero)
+    {
+        const LiveRenderCounters counters;
+
+        LiveRenderStatistics stats;
+        counters.read(stats);
+
+        EXPECT_EQ(0, strcmp(stats.m_stage, "idle"));
+        EXPECT_EQ(0, stats.m_sample_count);
+        EXPECT_EQ(0, stats.m_shading_ray_count);
+        EXPECT_EQ(0, stats.m_probe_ray_count);
+        EXPECT_EQ(0, stats.m_texture_cache_hit_count);
+        EXPECT_EQ(0, stats.m_texture_cache_miss_count);
+    }
+
+    TEST_CASE(Add_GivenTwoAdditions_AccumulatesCounters)
+    {
+        LiveRenderCounters counters;
+        counters.add(1, 2, 3, 4, 5);
+        counters.add(10, 20, 30, 40, 50);
+
+        LiveRenderStatistics stats;
+        counters.read(stats);
+
+        EXPECT_EQ(11, stats.m_sample_count);
+        EXPECT_EQ(22, stats.m_shading_ray_count);
+        EXPECT_EQ(33, stats.m_probe_ray_count);
+        EXPECT_EQ(44, stats.m_texture_cache_hit_count);
+        EXPECT_EQ(55, stats.m_texture_cache_miss_count);
+    }
+
+    TEST_CASE(Clear_GivenStageAndCounters_ResetsThem)
+    {
+        LiveRenderCounters counters;
+        counters.set_stage("rendering");
+        counters.add(1, 2, 3, 4, 5);
+
+        counters.clear();
+
+        LiveRenderStatistics stats;
+        counters.read(stats);
+
+        EXPECT_EQ(0, strcmp(stats.m_stage, "idle"));
+        EXPECT_EQ(0, stats.m_sample_count);
+    }
+}
@@ -0,0 +1,274 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/rendering/lodselector.h"
+#include "renderer/modeling/camera/camera.h"
+#include "renderer/modeling/camera/pinholecamera.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/modeling/object/curveobject.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/project/project.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/assemblyinstance.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/beziercurve.h"
+#include "foundation/math/matrix.h"
+#include "foundation/math/transform.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <limits>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Rendering_LODSelector)
+{
+    auto_release_ptr<ObjectInstance> create_object_instance(
+        const char*         lod_objects,
+        const char*         lod_thresholds,
+        const double        distance = 1.0)
+    {
+        return
+            ObjectInstanceFactory::create(
+                "object_inst",
+                ParamArray()
+                    .insert("lod_objects", lod_objects)
+                    .insert("lod_thresholds", lod_thresholds),
+                "object",
+                Transformd::from_local_to_parent(
+                    Matrix4d::make_translation(Vector3d(0.0, 0.0, -distance))),
+                StringDictionary());
+    }
+
+    TEST_CASE(ChooseLOD_GivenThresholds_ReturnsCoarserLevelsForSmallerCoverages)
+    {
+        auto_release_ptr<ObjectInstance> object_instance =
+            create_object_instance("object_lod1 object_lod2", "100 10");
+
+        ASSERT_EQ(3, object_instance->get_lod_count());
+        EXPECT_EQ(string("object"), object_instance->get_lod_object_name(0));
+        EXPECT_EQ(string("object_lod2"), object_instance->get_lod_object_name(2));
+
+        EXPECT_EQ(0, object_instance->choose_lod(500.0));
+        EXPECT_EQ(1, object_instance->choose_lod(50.0));
+        EXPECT_EQ(2, object_instance->choose_lod(5.0));
+    }
+
+    TEST_CASE(Constructor_GivenMismatchedThresholds_DisablesLevelsOfDetail)
+    {
+        auto_release_ptr<ObjectInstance> object_instance =
+            create_object_instance("object_lod1 object_lod2", "100");
+
+        EXPECT_EQ(1, object_instance->get_lod_count());
+        EXPECT_EQ(0, object_instance->choose_lod(0.0));
+    }
+
+    TEST_CASE(ChooseCurveLOD_GivenShorterSegments_ReturnsHigherLevels)
+    {
+        auto_release_ptr<ObjectInstance> object_instance =
+            ObjectInstanceFactory::create(
+                "object_inst",
+                ParamArray().insert("curve_lod_segment_pixels", "4.0"),
+                "object",
+                Transformd::identity(),
+                StringDictionary());
+
+        EXPECT_EQ(0, object_instance->choose_curve_lod(8.0));
+        EXPECT_EQ(1, object_instance->choose_curve_lod(2.0));
+        EXPECT_EQ(2, object_instance->choose_curve_lod(1.0));
+        EXPECT_EQ(4, object_instance->choose_curve_lod(0.0));
+    }
+
+    struct Fixture
+    {
+        auto_release_ptr<Project>   m_project;
+        Camera*                     m_camera;
+
+        Fixture()
+          : m_project(ProjectFactory::create("project"))
+        {
+            auto_release_ptr<Scene> scene(SceneFactory::create());
+            scene->cameras().insert(
+                PinholeCameraFactory().create(
+                    "camera",
+                    ParamArray()
+                        .insert("film_width", "0.025")
+                        .insert("film_height", "0.025")
+                        .insert("focal_length", "0.025")));
+
+            m_project->set_scene(scene);
+            m_project->set_frame(
+                FrameFactory::create(
+                    "frame",
+                    ParamArray()
+                        .insert("resolution", "100 100")
+                        .insert("camera", "camera")));
+
+            m_camera = m_project->get_scene()->cameras().get_by_name("camera");
+            m_camera->on_render_begin(m_project.ref());
+        }
+
+        ~Fixture()
+        {
+            m_camera->on_render_end(m_project.ref());
+        }
+
+        static auto_release_ptr<Object> create_mesh_object(const char* name)
+        {
+            auto_release_ptr<MeshObject> object(MeshObjectFactory::create(name, ParamArray()));
+            object->push_vertex(GVector3(-0.1f, -0.1f, -0.1f));
+            object->push_vertex(GVector3(+0.1f, +0.1f, +0.1f));
+            return auto_release_ptr<Object>(object);
+        }
+
+        // Create a strand of connected segments, each of length 0.01, along the x axis.
+        static auto_release_ptr<Object> create_curve_object(const char* name)
+        {
+            auto_release_ptr<CurveObject> object(CurveObjectFactory::create(name, ParamArray()));
+
+            for (size_t i = 0; i < 20; ++i)
+            {
+                const GVector3 ctrl_pts[4] =
+                {
+                    GVector3(static_cast<GScalar>(i) * 0.01f, 0.0f, 0.0f),
+                    GVector3((static_cast<GScalar>(i) + 0.25f) * 0.01f, 0.0f, 0.0f),
+                    GVector3((static_cast<GScalar>(i) + 0.75f) * 0.01f, 0.0f, 0.0f),
+                    GVector3((static_cast<GScalar>(i) + 1.0f) * 0.01f, 0.0f, 0.0f)
+                };
+
+                object->push_curve3(Curve3Type(ctrl_pts, 0.001f));
+            }
+
+            return auto_release_ptr<Object>(object);
+        }
+    };
+
+    TEST_CASE_F(ComputePixelCoverage_GivenBoxInFrontOfCamera_ReturnsProjectedSize, Fixture)
+    {
+        const LODSelector selector(*m_camera, 100, 100);
+
+        // The film is as wide as the focal length: a box of size 0.5 at distance 1 covers half the frame.
+        const double coverage =
+            selector.compute_pixel_coverage(
+                AABB3d(Vector3d(-0.25, -0.25, -1.0), Vector3d(0.25, 0.25, -1.0)));
+
+        EXPECT_FEQ(50.0, coverage);
+    }
+
+    TEST_CASE_F(ComputePixelCoverage_GivenBoxBehindCamera_ReturnsMaximumCoverage, Fixture)
+    {
+        const LODSelector selector(*m_camera, 100, 100);
+
+        const double coverage =
+            selector.compute_pixel_coverage(
+                AABB3d(Vector3d(-0.5, -0.5, 1.0), Vector3d(0.5, 0.5, 2.0)));
+
+        EXPECT_EQ(numeric_limits<double>::max(), coverage);
+    }
+
+    TEST_CASE_F(ComputePixelCoverage_GivenBoxOutsideFrame_ReturnsZero, Fixture)
+    {
+        const LODSelector selector(*m_camera, 100, 100);
+
+        const double coverage =
+            selector.compute_pixel_coverage(
+                AABB3d(Vector3d(10.0, -0.5, -1.0), Vector3d(11.0, 0.5, -1.0)));
+
+        EXPECT_EQ(0.0, coverage);
+    }
+
+    TEST_CASE_F(Select_GivenDistantInstance_BindsCoarserObjectAndBumpsAssemblyVersion, Fixture)
+    {
+        auto_release_ptr<Assembly> assembly(AssemblyFactory().create("assembly"));
+        assembly->objects().insert(create_mesh_object("object"));
+        assembly->objects().insert(create_mesh_object("object_lod1"));
+        assembly->object_instances().insert(create_object_instance("object_lod1", "10", 100.0));
+
+        Assembly& assembly_ref = assembly.ref();
+        m_project->get_scene()->assemblies().insert(assembly);
+        m_project->get_scene()->assembly_instances().insert(
+            AssemblyInstanceFactory::create("assembly_inst", ParamArray(), "assembly"));
+
+        ObjectInstance* object_instance = assembly_ref.object_instances().get_by_name("object_inst");
+        object_instance->bind_object(assembly_ref.objects());
+
+        const VersionID initial_version_id = assembly_ref.get_version_id();
+
+        LODSelector selector(*m_camera, 100, 100);
+        selector.select(*m_project->get_scene());
+
+        EXPECT_EQ(1, selector.get_instance_count());
+        EXPECT_EQ(1, selector.get_coarse_instance_count());
+        EXPECT_EQ(1, object_instance->get_selected_lod());
+        EXPECT_EQ(string("object_lod1"), object_instance->get_object().get_name());
+        EXPECT_NEQ(initial_version_id, assembly_ref.get_version_id());
+    }
+
+    TEST_CASE_F(Select_GivenDistantCurveInstance_SelectsCurveLODAndBumpsAssemblyVersion, Fixture)
+    {
+        auto_release_ptr<Assembly> assembly(AssemblyFactory().create("assembly"));
+        assembly->objects().insert(create_curve_object("object"));
+        assembly->object_instances().insert(create_object_instance("", "", 100.0));
+
+        Assembly& assembly_ref = assembly.ref();
+        m_project->get_scene()->assemblies().insert(assembly);
+        m_project->get_scene()->assembly_instances().insert(
+            AssemblyInstanceFactory::create("assembly_inst", ParamArray(), "assembly"));
+
+        ObjectInstance* object_instance = assembly_ref.object_instances().get_by_name("object_inst");
+        object_instance->bind_object(assembly_ref.objects());
+
+        const VersionID initial_version_id = assembly_ref.get_version_id();
+
+        LODSelector selector(*m_camera, 100, 100);
+        selector.select(*m_project->get_scene());
+
+        // The whole strand covers 0.2 pixels: segments are merged as much as possible.
+        EXPECT_EQ(0, selector.get_instance_count());
+        EXPECT_EQ(1, selector.get_curve_instance_count());
+        EXPECT_EQ(1, selector.get_simplified_curve_instance_count());
+        EXPECT_EQ(4, object_instance->get_curve_lod());
+        EXPECT_NEQ(initial_version_id, assembly_ref.get_version_id());
+    }
+}
@@ -0,0 +1,282 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/kernel/volume/majorantgrid.h"
+#include "renderer/kernel/volume/volume.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Volume_MajorantGrid)
+{
+    struct ConstantDensity
+    {
+        const float m_density;
+
+        explicit ConstantDensity(const float density)
+          : m_density(density)
+        {
+        }
+
+        float operator()(const Vector3d& point) const
+        {
+            return m_density;
+        }
+    };
+
+    struct GridDensity
+    {
+        const VoxelGrid& m_grid;
+
+        explicit GridDensity(const VoxelGrid& grid)
+          : m_grid(grid)
+        {
+        }
+
+        float operator()(const Vector3d& point) const
+        {
+            float value;
+            m_grid.linear_lookup(point, &value);
+            return value;
+        }
+    };
+
+    struct CellRecorder
+    {
+        vector<double> m_t0;
+        vector<double> m_t1;
+
+        bool visit(
+            const float     minorant,
+            const float     majorant,
+            const double    t0,
+            const double    t1)
+        {
+            m_t0.push_back(t0);
+            m_t1.push_back(t1);
+            return true;
+        }
+    };
+
+    void fill(VoxelGrid& grid, const float density)
+    {
+        for (size_t z = 0; z < grid.get_zres(); ++z)
+        {
+            for (size_t y = 0; y < grid.get_yres(); ++y)
+            {
+                for (size_t x = 0; x < grid.get_xres(); ++x)
+                    grid.voxel(x, y, z)[0] = density;
+            }
+        }
+    }
+
+    TEST_CASE(Constructor_ComputesCellCountFromCellSize)
+    {
+        VoxelGrid voxel_grid(16, 9, 8, 1);
+        const MajorantGrid grid(voxel_grid, 0, 8);
+
+        EXPECT_EQ(2, grid.get_xres());
+        EXPECT_EQ(2, grid.get_yres());
+        EXPECT_EQ(1, grid.get_zres());
+    }
+
+    TEST_CASE(Constructor_BoundsDensityOfCellAndItsNeighborhood)
+    {
+        VoxelGrid voxel_grid(16, 16, 16, 1);
+        voxel_grid.voxel(3, 3, 3)[0] = 2.0f;
+
+        const MajorantGrid grid(voxel_grid, 0, 4);
+
+        EXPECT_EQ(2.0f, grid.get_majorant(0, 0, 0));
+        EXPECT_EQ(0.0f, grid.get_minorant(0, 0, 0));
+        EXPECT_EQ(2.0f, grid.get_majorant(1, 1, 1));    // voxel 3 influences lookups in cell 1
+        EXPECT_EQ(0.0f, grid.get_majorant(2, 2, 2));
+        EXPECT_EQ(2.0f, grid.get_max_majorant());
+    }
+
+    TEST_CASE(Traverse_DiagonalRay_VisitsCellsInOrderWithoutGaps)
+    {
+        VoxelGrid voxel_grid(8, 8, 8, 1);
+        fill(voxel_grid, 1.0f);
+        const MajorantGrid grid(voxel_grid, 0, 2);
+
+        CellRecorder recorder;
+        grid.traverse(
+            Vector3d(-0.5, 0.1, 0.2),
+            normalize(Vector3d(1.0, 0.3, 0.2)),
+            0.0,
+            10.0,
+            recorder);
+
+        ASSERT_TRUE(recorder.m_t0.size() > 1);
+
+        for (size_t i = 1; i < recorder.m_t0.size(); ++i)
+        {
+            EXPECT_FEQ(recorder.m_t1[i - 1], recorder.m_t0[i]);
+        }
+    }
+
+    TEST_CASE(Traverse_RayMissingGrid_VisitsNothing)
+    {
+        VoxelGrid voxel_grid(8, 8, 8, 1);
+        fill(voxel_grid, 1.0f);
+        const MajorantGrid grid(voxel_grid, 0, 2);
+
+        CellRecorder recorder;
+        grid.traverse(
+            Vector3d(-0.5, 2.0, 0.5),
+            Vector3d(1.0, 0.0, 0.0),
+            0.0,
+            10.0,
+            recorder);
+
+        EXPECT_TRUE(recorder.m_t0.empty());
+    }
+
+    TEST_CASE(EvaluateTransmittance_HomogeneousVolume_MatchesBeerLambert)
+    {
+        VoxelGrid voxel_grid(8, 8, 8, 1);
+        fill(voxel_grid, 1.0f);
+        const MajorantGrid grid(voxel_grid, 0, 2);
+
+        MersenneTwister rng;
+        const float transmittance =
+            grid.evaluate_transmittance(
+                Vector3d(0.0, 0.5, 0.5),
+                Vector3d(1.0, 0.0, 0.0),
+                0.0,
+                1.0,
+                2.0f,
+                ConstantDensity(1.0f),
+                rng);
+
+        EXPECT_FEQ(exp(-2.0f), transmittance);
+    }
+
+    TEST_CASE(EvaluateTransmittance_HeterogeneousVolume_ConvergesToBeerLambert)
+    {
+        // The density increases linearly from 0 to 1 along x.
+        VoxelGrid voxel_grid(9, 2, 2, 1);
+        for (size_t z = 0; z < 2; ++z)
+        {
+            for (size_t y = 0; y < 2; ++y)
+            {
+                for (size_t x = 0; x < 9; ++x)
+                    voxel_grid.voxel(x, y, z)[0] = x / 8.0f;
+            }
+        }
+
+        const MajorantGrid grid(voxel_grid, 0, 2);
+        const GridDensity density(voxel_grid);
+
+        MersenneTwister rng;
+        const size_t SampleCount = 10000;
+        double transmittance = 0.0;
+        for (size_t i = 0; i < SampleCount; ++i)
+        {
+            transmittance +=
+                grid.evaluate_transmittance(
+                    Vector3d(0.0, 0.5, 0.5),
+                    Vector3d(1.0, 0.0, 0.0),
+                    0.0,
+                    1.0,
+                    2.0f,
+                    density,
+                    rng);
+        }
+        transmittance /= SampleCount;
+
+        // The optical depth is 2 * 1/2 = 1.
+        EXPECT_FEQ_EPS(exp(-1.0), transmittance, 0.01);
+    }
+
+    TEST_CASE(SampleDistance_HomogeneousVolume_MeanMatchesMeanFreePath)
+    {
+        VoxelGrid voxel_grid(8, 8, 8, 1);
+        fill(voxel_grid, 1.0f);
+        const MajorantGrid grid(voxel_grid, 0, 2);
+
+        MersenneTwister rng;
+        const size_t SampleCount = 10000;
+        double distance_sum = 0.0;
+        size_t collision_count = 0;
+        for (size_t i = 0; i < SampleCount; ++i)
+        {
+            double distance;
+            if (grid.sample_distance(
+                    Vector3d(0.0, 0.5, 0.5),
+                    Vector3d(1.0, 0.0, 0.0),
+                    0.0,
+                    1.0,
+                    20.0f,
+                    ConstantDensity(1.0f),
+                    rng,
+                    distance))
+            {
+                distance_sum += distance;
+                ++collision_count;
+            }
+        }
+
+        // Almost all particles collide; the mean free path is 1/20.
+        EXPECT_LT(SampleCount / 100, SampleCount - collision_count);
+        EXPECT_FEQ_EPS(0.05, distance_sum / collision_count, 0.02);
+    }
+
+    TEST_CASE(SampleDistance_EmptyVolume_ReturnsFalse)
+    {
+        VoxelGrid voxel_grid(8, 8, 8, 1);
+        const MajorantGrid grid(voxel_grid, 0, 2);
+
+        MersenneTwister rng;
+        double distance;
+        const bool collided =
+            grid.sample_distance(
+                Vector3d(0.0, 0.5, 0.5),
+                Vector3d(1.0, 0.0, 0.0),
+                0.0,
+                1.0,
+                1.0f,
+                ConstantDensity(0.0f),
+                rng,
+                distance);
+
+        EXPECT_FALSE(collided);
+    }
+}
@@ -0,0 +1,168 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/rendering/memorylimitpolicy.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/platform/types.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Rendering_MemoryLimitPolicy)
+{
+    const uint64 MB = 1024 * 1024;
+
+    ParamArray make_params(const uint64 memory_limit, const uint64 texture_store_size)
+    {
+        ParamArray params;
+        params.insert("memory_limit", memory_limit);
+        params.insert_path("texture_store.max_size", texture_store_size);
+        params.insert_path("texture_store.shared_memory_budget", true);
+        return params;
+    }
+
+    MemoryLimitPolicy::Usage make_usage(const uint64 current, const uint64 trees)
+    {
+        MemoryLimitPolicy::Usage usage;
+        usage.m_current = current;
+        usage.m_trees = trees;
+        return usage;
+    }
+
+    TEST_CASE(Apply_GivenNoMemoryLimit_DoesNothing)
+    {
+        ParamArray params = make_params(0, 256 * MB);
+        ParamArray tree_params;
+        const MemoryLimitPolicy policy(params);
+
+        const size_t degradation_count = policy.apply(make_usage(1000 * MB, 1000 * MB), params, tree_params);
+
+        EXPECT_EQ(0, degradation_count);
+        EXPECT_EQ(256 * MB, params.get_path_optional<uint64>("texture_store.max_size", 0));
+        EXPECT_TRUE(tree_params.empty());
+    }
+
+    TEST_CASE(Apply_GivenRenderFitsWithinLimit_DoesNothing)
+    {
+        ParamArray params = make_params(1000 * MB, 256 * MB);
+        ParamArray tree_params;
+        const MemoryLimitPolicy policy(params);
+
+        const size_t degradation_count = policy.apply(make_usage(100 * MB, 100 * MB), params, tree_params);
+
+        EXPECT_EQ(0, degradation_count);
+        EXPECT_EQ(256 * MB, params.get_path_optional<uint64>("texture_store.max_size", 0));
+        EXPECT_TRUE(tree_params.empty());
+    }
+
+    TEST_CASE(Apply_GivenLargeAccelerationStructures_UsesCompactTreeFormats)
+    {
+        ParamArray params = make_params(1000 * MB, 64 * MB);
+        ParamArray tree_params;
+        const MemoryLimitPolicy policy(params);
+
+        const size_t degradation_count = policy.apply(make_usage(100 * MB, 800 * MB), params, tree_params);
+
+        EXPECT_EQ(1, degradation_count);
+        EXPECT_EQ("quantized", tree_params.get_optional<string>("node_type", ""));
+        EXPECT_EQ("indexed", tree_params.get_optional<string>("leaf_encoding", ""));
+        EXPECT_EQ(64 * MB, params.get_path_optional<uint64>("texture_store.max_size", 0));
+    }
+
+    TEST_CASE(Apply_GivenSceneChoosesTreeFormats_KeepsThem)
+    {
+        ParamArray params = make_params(1000 * MB, 64 * MB);
+        ParamArray tree_params;
+        tree_params.insert("node_type", "binary");
+        tree_params.insert("leaf_encoding", "flat");
+        const MemoryLimitPolicy policy(params);
+
+        policy.apply(make_usage(100 * MB, 800 * MB), params, tree_params);
+
+        EXPECT_EQ("binary", tree_params.get_optional<string>("node_type", ""));
+        EXPECT_EQ("flat", tree_params.get_optional<string>("leaf_encoding", ""));
+    }
+
+    TEST_CASE(Apply_GivenLargeTextureCache_ShrinksTextureCacheToAvailableMemory)
+    {
+        ParamArray params = make_params(1000 * MB, 512 * MB);
+        ParamArray tree_params;
+        const MemoryLimitPolicy policy(params);
+
+        const size_t degradation_count = policy.apply(make_usage(500 * MB, 0), params, tree_params);
+
+        EXPECT_EQ(1, degradation_count);
+        EXPECT_EQ(400 * MB, params.get_path_optional<uint64>("texture_store.max_size", 0));
+    }
+
+    TEST_CASE(Apply_GivenLargeSPPMPhotonMaps_UsesCompactPhotonsAndFewerPhotons)
+    {
+        ParamArray params = make_params(1000 * MB, 16 * MB);
+        params.insert("lighting_engine", "sppm");
+        params.insert_path("sppm.light_photons_per_pass", 10000000);
+        params.insert_path("sppm.env_photons_per_pass", 10000000);
+        ParamArray tree_params;
+        const MemoryLimitPolicy policy(params);
+
+        const size_t degradation_count = policy.apply(make_usage(700 * MB, 0), params, tree_params);
+
+        EXPECT_EQ(2, degradation_count);
+        EXPECT_EQ("compact", params.get_path_optional<string>("sppm.photon_format", ""));
+
+
+        // Photon counts don't drop below a tenth of their configured value.
+        EXPECT_EQ(1000000, params.get_path_optional<size_t>("sppm.light_photons_per_pass", 0));
+        EXPECT_EQ(1000000, params.get_path_optional<size_t>("sppm.env_photons_per_pass", 0));
+    }
+
+    TEST_CASE(ShouldStreamOutput_GivenFrameFitsWithinLimit_ReturnsFalse)
+    {
+        const ParamArray params = make_params(1000 * MB, 64 * MB);
+        const MemoryLimitPolicy policy(params);
+
+        EXPECT_FALSE(policy.should_stream_output(make_usage(100 * MB, 100 * MB), params, 100 * MB));
+    }
+
+    TEST_CASE(ShouldStreamOutput_GivenFrameExceedsLimit_ReturnsTrue)
+    {
+        const ParamArray params = make_params(1000 * MB, 64 * MB);
+        const MemoryLimitPolicy policy(params);
+
+        EXPECT_TRUE(policy.should_stream_output(make_usage(100 * MB, 100 * MB), params, 800 * MB));
+    }
+}
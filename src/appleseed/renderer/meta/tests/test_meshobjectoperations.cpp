@@ -0,0 +1,126 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/meshobjectoperations.h"
+#include "renderer/modeling/object/triangle.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/vector.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cmath>
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Modeling_Object_MeshObjectOperations)
+{
+    // Create a bumpy grid large enough for the parallel code paths to be used.
+    auto_release_ptr<MeshObject> create_bumpy_grid()
+    {
+        const size_t GridSize = 150;
+
+        auto_release_ptr<MeshObject> object(MeshObjectFactory::create("grid", ParamArray()));
+
+        for (size_t y = 0; y <= GridSize; ++y)
+        {
+            for (size_t x = 0; x <= GridSize; ++x)
+            {
+                const GScalar fx = static_cast<GScalar>(x);
+                const GScalar fy = static_cast<GScalar>(y);
+                object->push_vertex(GVector3(fx, fy, sin(fx * GScalar(0.37)) * cos(fy * GScalar(0.21))));
+                object->push_tex_coords(GVector2(fx * fx / GridSize, fy));
+            }
+        }
+
+        for (size_t y = 0; y < GridSize; ++y)
+        {
+            for (size_t x = 0; x < GridSize; ++x)
+            {
+                const size_t v0 = y * (GridSize + 1) + x;
+                const size_t v1 = v0 + 1;
+                const size_t v2 = v0 + GridSize + 1;
+                const size_t v3 = v2 + 1;
+                object->push_triangle(Triangle(v0, v1, v3, Triangle::None, Triangle::None, Triangle::None, v0, v1, v3, 0));
+                object->push_triangle(Triangle(v0, v3, v2, Triangle::None, Triangle::None, Triangle::None, v0, v3, v2, 0));
+            }
+        }
+
+        return object;
+    }
+
+    TEST_CASE(ComputeSmoothVertexNormals_GivenSeveralThreads_MatchesSerialVersion)
+    {
+        auto_release_ptr<MeshObject> serial_object(create_bumpy_grid());
+        auto_release_ptr<MeshObject> parallel_object(create_bumpy_grid());
+
+        compute_smooth_vertex_normals(serial_object.ref(), 1);
+        compute_smooth_vertex_normals(parallel_object.ref(), 4);
+
+        ASSERT_EQ(serial_object->get_vertex_normal_count(), parallel_object->get_vertex_normal_count());
+
+        size_t mismatch_count = 0;
+        for (size_t i = 0; i < serial_object->get_vertex_normal_count(); ++i)
+        {
+            if (serial_object->get_vertex_normal(i) != parallel_object->get_vertex_normal(i))
+                ++mismatch_count;
+        }
+
+        EXPECT_EQ(0, mismatch_count);
+        EXPECT_EQ(serial_object->get_triangle(0).m_n2, parallel_object->get_triangle(0).m_n2);
+    }
+
+    TEST_CASE(ComputeSmoothVertexTangents_GivenSeveralThreads_MatchesSerialVersion)
+    {
+        auto_release_ptr<MeshObject> serial_object(create_bumpy_grid());
+        auto_release_ptr<MeshObject> parallel_object(create_bumpy_grid());
+
+        compute_smooth_vertex_tangents(serial_object.ref(), 1);
+        compute_smooth_vertex_tangents(parallel_object.ref(), 4);
+
+        ASSERT_EQ(serial_object->get_vertex_tangent_count(), parallel_object->get_vertex_tangent_count());
+
+        size_t mismatch_count = 0;
+        for (size_t i = 0; i < serial_object->get_vertex_tangent_count(); ++i)
+        {
+            if (serial_object->get_vertex_tangent(i) != parallel_object->get_vertex_tangent(i))
+                ++mismatch_count;
+        }
+
+        EXPECT_EQ(0, mismatch_count);
+    }
+}
@@ -0,0 +1,98 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/pathguide.h"
+#include "renderer/modeling/frame/frame.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/job/abortswitch.h"
+#include "foundation/utility/job/jobqueue.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_PathGuide)
+{
+    struct Fixture
+    {
+        auto_release_ptr<Scene>     m_scene;
+        auto_release_ptr<Frame>     m_frame;
+        JobQueue                    m_job_queue;
+        AbortSwitch                 m_abort_switch;
+
+        Fixture()
+          : m_scene(SceneFactory::create())
+          , m_frame(
+                FrameFactory::create(
+                    "frame",
+                    ParamArray().insert("resolution", "4 4")))
+        {
+        }
+
+        void render_pass(PathGuide& path_guide)
+        {
+            path_guide.pre_render(m_frame.ref(), m_job_queue, m_abort_switch);
+            path_guide.post_render(m_frame.ref(), m_job_queue, m_abort_switch);
+        }
+    };
+
+    TEST_CASE_F(IsTraining_BeforeFirstPass_ReturnsTrue, Fixture)
+    {
+        PathGuide path_guide(m_scene.ref(), ParamArray());
+
+        EXPECT_TRUE(path_guide.is_training());
+    }
+
+    TEST_CASE_F(IsTraining_AfterTrainingPasses_ReturnsFalse, Fixture)
+    {
+        PathGuide path_guide(
+            m_scene.ref(),
+            ParamArray().insert("path_guiding_training_passes", 2));
+
+        render_pass(path_guide);
+        EXPECT_TRUE(path_guide.is_training());
+
+        render_pass(path_guide);
+        EXPECT_FALSE(path_guide.is_training());
+    }
+
+    TEST_CASE_F(PostRender_AlwaysAllowsRemainingPasses, Fixture)
+    {
+        PathGuide path_guide(m_scene.ref(), ParamArray());
+        path_guide.record(Vector3d(0.0), Vector3f(0.0f, 1.0f, 0.0f), 1.0f);
+
+        EXPECT_FALSE(path_guide.post_render(m_frame.ref(), m_job_queue, m_abort_switch));
+    }
+}
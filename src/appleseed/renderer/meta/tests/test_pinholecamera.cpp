@@ -28,6 +28,8 @@
 //
 
 // appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/shading/shadingray.h"
 #include "renderer/modeling/camera/camera.h"
 #include "renderer/modeling/camera/pinholecamera.h"
 #include "renderer/modeling/entity/onframebeginrecorder.h"
@@ -37,6 +39,10 @@
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/dual.h"
+#include "foundation/math/frustum.h"
+#include "foundation/math/intersection/frustumaabb.h"
 #include "foundation/math/vector.h"
 #include "foundation/utility/autoreleaseptr.h"
 #include "foundation/utility/iostreamop.h"
@@ -85,4 +91,101 @@ TEST_SUITE(Renderer_Modeling_Camera_PinholeCamera)
         recorder.on_frame_end(project.ref());
         project->get_scene()->on_render_end(project.ref());
     }
+
+    TEST_CASE(GetViewFrustum_GivenIdentityCamera_OnlyContainsBoxesInFieldOfView)
+    {
+        auto_release_ptr<Scene> scene(SceneFactory::create());
+        scene->cameras().insert(
+            PinholeCameraFactory().create(
+                "camera",
+                ParamArray()
+                    .insert("film_width", "0.025")
+                    .insert("film_height", "0.025")
+                    .insert("focal_length", "0.035")));
+
+        auto_release_ptr<Project> project(ProjectFactory::create("test"));
+        project->set_scene(scene);
+        project->set_frame(
+            FrameFactory::create(
+                "frame",
+                ParamArray()
+                    .insert("resolution", "512 512")
+                    .insert("camera", "camera")));
+
+        bool success = project->get_scene()->on_render_begin(project.ref());
+        ASSERT_TRUE(success);
+
+        OnFrameBeginRecorder recorder;
+        success = project->get_scene()->on_frame_begin(project.ref(), 0, recorder);
+        ASSERT_TRUE(success);
+
+        const Camera* camera = project->get_scene()->get_active_camera();
+
+        Frustum<double, 4> frustum;
+        success = camera->get_view_frustum(frustum);
+
+        ASSERT_TRUE(success);
+        EXPECT_TRUE(intersect(frustum, AABB3d(Vector3d(-0.1, -0.1, -10.0), Vector3d(0.1, 0.1, -9.0))));
+        EXPECT_FALSE(intersect(frustum, AABB3d(Vector3d(-0.1, -0.1, 9.0), Vector3d(0.1, 0.1, 10.0))));
+        EXPECT_FALSE(intersect(frustum, AABB3d(Vector3d(20.0, -0.1, -10.0), Vector3d(21.0, 0.1, -9.0))));
+
+        recorder.on_frame_end(project.ref());
+        project->get_scene()->on_render_end(project.ref());
+    }
+
+    TEST_CASE(SpawnRays_GivenIdentityCamera_ReturnsRaysThroughFilmPoints)
+    {
+        auto_release_ptr<Scene> scene(SceneFactory::create());
+        scene->cameras().insert(
+            PinholeCameraFactory().create(
+                "camera",
+                ParamArray()
+                    .insert("film_width", "0.025")
+                    .insert("film_height", "0.025")
+                    .insert("focal_length", "0.035")));
+
+        auto_release_ptr<Project> project(ProjectFactory::create("test"));
+        project->set_scene(scene);
+        project->set_frame(
+            FrameFactory::create(
+                "frame",
+                ParamArray()
+                    .insert("resolution", "512 512")
+                    .insert("camera", "camera")));
+
+        bool success = project->get_scene()->on_render_begin(project.ref());
+        ASSERT_TRUE(success);
+
+        OnFrameBeginRecorder recorder;
+        success = project->get_scene()->on_frame_begin(project.ref(), 0, recorder);
+        ASSERT_TRUE(success);
+
+        const Camera* camera = project->get_scene()->get_active_camera();
+
+        SamplingContext::RNGType rng;
+        SamplingContext sampling_context(rng, SamplingContext::QMCMode);
+        SamplingContext* sampling_contexts[2] = { &sampling_context, &sampling_context };
+
+        const Dual2d ndc[2] =
+        {
+            Dual2d(Vector2d(0.5, 0.5)),
+            Dual2d(Vector2d(0.0, 0.0), Vector2d(1.0, 0.0), Vector2d(0.0, 1.0))
+        };
+
+        ShadingRay rays[2];
+        camera->spawn_rays(sampling_contexts, ndc, rays, 2);
+
+        EXPECT_FEQ(Vector3d(0.0), rays[0].m_org);
+        EXPECT_FEQ(Vector3d(0.0, 0.0, -1.0), rays[0].m_dir);
+        EXPECT_FALSE(rays[0].m_has_differentials);
+
+        EXPECT_FEQ(Vector3d(0.0), rays[1].m_org);
+        EXPECT_FEQ(normalize(Vector3d(-0.0125, 0.0125, -0.035)), rays[1].m_dir);
+        ASSERT_TRUE(rays[1].m_has_differentials);
+        EXPECT_FEQ(normalize(Vector3d(0.0125, 0.0125, -0.035)), rays[1].m_rx.m_dir);
+        EXPECT_FEQ(normalize(Vector3d(-0.0125, -0.0125, -0.035)), rays[1].m_ry.m_dir);
+
+        recorder.on_frame_end(project.ref());
+        project->get_scene()->on_render_end(project.ref());
+    }
 }
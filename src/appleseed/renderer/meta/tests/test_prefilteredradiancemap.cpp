@@ -0,0 +1,103 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/modeling/environmentedf/prefilteredradiancemap.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/countof.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Modeling_EnvironmentEDF_PrefilteredRadianceMap)
+{
+    struct ConstantRadiance
+    {
+        void operator()(const Vector2f& uv, Color3f& value) const
+        {
+            value = Color3f(1.0f, 2.0f, 3.0f);
+        }
+    };
+
+    struct UpperHemisphereRadiance
+    {
+        void operator()(const Vector2f& uv, Color3f& value) const
+        {
+            value = Color3f(uv[1] < 0.5f ? 1.0f : 0.0f);
+        }
+    };
+
+    TEST_CASE(Lookup_GivenConstantRadiance_ReturnsConstantRadianceAtAllFilterWidths)
+    {
+        PrefilteredRadianceMap map(32, 16);
+        map.build(ConstantRadiance(), 1);
+
+        const float SolidAngles[] = { 0.5f, 1.0f, 2.0f, TwoPi<float>() };
+
+        for (size_t i = 0; i < countof(SolidAngles); ++i)
+        {
+            Color3f value;
+            EXPECT_TRUE(map.lookup(0.3f, 0.6f, SolidAngles[i], value));
+            EXPECT_FEQ_EPS(Color3f(1.0f, 2.0f, 3.0f), value, 1.0e-4f);
+        }
+    }
+
+    TEST_CASE(Lookup_GivenConeNarrowerThanTexels_ReturnsFalse)
+    {
+        PrefilteredRadianceMap map(32, 16);
+        map.build(ConstantRadiance(), 1);
+
+        Color3f value;
+        EXPECT_FALSE(map.lookup(0.3f, 0.6f, 1.0e-4f, value));
+    }
+
+    TEST_CASE(Lookup_GivenWiderCone_BlursAcrossTheHorizon)
+    {
+        PrefilteredRadianceMap map(64, 32);
+        map.build(UpperHemisphereRadiance(), 2);
+
+        // Above the horizon.
+        Color3f narrow, wide;
+        map.lookup(0.5f, 0.4f, 0.05f, narrow);
+        map.lookup(0.5f, 0.4f, Pi<float>(), wide);
+
+        EXPECT_GT(0.9f, narrow[0]);
+        EXPECT_LT(0.9f, wide[0]);
+        EXPECT_GT(0.1f, wide[0]);
+    }
+}
@@ -0,0 +1,158 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// appleseed.renderer headers.
+#include "renderer/modeling/color/colorentity.h"
+#include "renderer/modeling/project/project.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/proceduralassembly.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/test.h"
+
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+namespace bf = boost::filesystem;
+
+TEST_SUITE(Renderer_Modeling_Scene_ProceduralAssembly)
+{
+    class CountingProceduralAssembly
+      : public ProceduralAssembly
+    {
+      public:
+        size_t m_expansion_count;
+
+        explicit CountingProceduralAssembly(const ParamArray& params)
+          : ProceduralAssembly("procedural_assembly", params)
+          , m_expansion_count(0)
+        {
+        }
+
+        virtual const char* get_expansion_version() const APPLESEED_OVERRIDE
+        {
+            return "1";
+        }
+
+        virtual bool expand_contents(
+            const Project&      project,
+            const Assembly*     parent,
+            IAbortSwitch*       abort_switch) APPLESEED_OVERRIDE
+        {
+            ++m_expansion_count;
+
+            static const float ColorValues[] = { 0.5f, 0.5f, 0.5f };
+
+            colors().clear();
+            colors().insert(
+                ColorEntityFactory::create(
+                    "color",
+                    ParamArray()
+                        .insert("color_space", "linear_rgb"),
+                    ColorValueArray(3, ColorValues)));
+
+            return true;
+        }
+    };
+
+    struct Fixture
+    {
+        auto_release_ptr<Project> m_project;
+
+        Fixture()
+          : m_project(ProjectFactory::create("project"))
+        {
+            m_project->set_scene(SceneFactory::create());
+        }
+
+        void enable_cache(const char* cache_directory)
+        {
+            bf::remove_all(cache_directory);
+            m_project->get_scene()->get_parameters().insert("procedural_assembly_cache_directory", cache_directory);
+        }
+    };
+
+    TEST_CASE_F(ExpandContentsCached_GivenNoCacheDirectory_ExpandsContentsEveryTime, Fixture)
+    {
+        CountingProceduralAssembly assembly(ParamArray().insert("density", 10));
+
+        assembly.expand_contents_cached(m_project.ref(), 0);
+        assembly.expand_contents_cached(m_project.ref(), 0);
+
+        EXPECT_EQ(2, assembly.m_expansion_count);
+    }
+
+    TEST_CASE_F(ExpandContentsCached_GivenUnchangedParameters_ExpandsContentsOnce, Fixture)
+    {
+        enable_cache("unit tests/outputs/test_proceduralassembly_unchanged/");
+
+        CountingProceduralAssembly assembly(ParamArray().insert("density", 10));
+
+        assembly.expand_contents_cached(m_project.ref(), 0);
+        assembly.expand_contents_cached(m_project.ref(), 0);
+
+        EXPECT_EQ(1, assembly.m_expansion_count);
+    }
+
+    TEST_CASE_F(ExpandContentsCached_GivenChangedParameters_ExpandsContentsAgain, Fixture)
+    {
+        enable_cache("unit tests/outputs/test_proceduralassembly_changed/");
+
+        CountingProceduralAssembly assembly(ParamArray().insert("density", 10));
+
+        assembly.expand_contents_cached(m_project.ref(), 0);
+        assembly.get_parameters().insert("density", 20);
+        assembly.expand_contents_cached(m_project.ref(), 0);
+
+        EXPECT_EQ(2, assembly.m_expansion_count);
+    }
+
+    TEST_CASE_F(ExpandContentsCached_GivenCachedContents_LoadsContentsFromCache, Fixture)
+    {
+        enable_cache("unit tests/outputs/test_proceduralassembly_reload/");
+
+        CountingProceduralAssembly first_assembly(ParamArray().insert("density", 10));
+        first_assembly.expand_contents_cached(m_project.ref(), 0);
+
+        CountingProceduralAssembly second_assembly(ParamArray().insert("density", 10));
+        second_assembly.expand_contents_cached(m_project.ref(), 0);
+
+        EXPECT_EQ(0, second_assembly.m_expansion_count);
+        EXPECT_EQ(1, second_assembly.colors().size());
+    }
+}
@@ -67,4 +67,46 @@ TEST_SUITE(Renderer_Modeling_Project_ProjectFileReader)
 
         EXPECT_TRUE(identical);
     }
+
+    TEST_CASE(BinaryProjectFileRoundTrip)
+    {
+        ProjectFileReader reader;
+        auto_release_ptr<Project> project =
+            reader.read(
+                "unit tests/inputs/test_projectfilereader_configurationblocks.appleseed",
+                "../../../schemas/project.xsd");    // path relative to input file
+
+        ASSERT_NEQ(0, project.get());
+
+        bool success =
+            ProjectFileWriter::write(
+                project.ref(),
+                "unit tests/outputs/test_projectfilereader_configurationblocks.appleseedb",
+                ProjectFileWriter::OmitHeaderComment);
+
+        ASSERT_TRUE(success);
+
+        auto_release_ptr<Project> binary_project =
+            reader.read(
+                "unit tests/outputs/test_projectfilereader_configurationblocks.appleseedb",
+                0,
+                ProjectFileReader::OmitProjectSchemaValidation);
+
+        ASSERT_NEQ(0, binary_project.get());
+
+        success =
+            ProjectFileWriter::write(
+                binary_project.ref(),
+                "unit tests/outputs/test_projectfilereader_binaryroundtrip.appleseed",
+                ProjectFileWriter::OmitHeaderComment);
+
+        ASSERT_TRUE(success);
+
+        const bool identical =
+            compare_text_files(
+                "unit tests/inputs/test_projectfilereader_configurationblocks.appleseed",
+                "unit tests/outputs/test_projectfilereader_binaryroundtrip.appleseed");
+
+        EXPECT_TRUE(identical);
+    }
 }
@@ -0,0 +1,137 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/intersection/rayorderer.h"
+#include "renderer/kernel/shading/shadingray.h"
+#include "renderer/modeling/scene/visibilityflags.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Intersection_RayOrderer)
+{
+    ShadingRay make_ray(const Vector3d& org, const Vector3d& dir)
+    {
+        return ShadingRay(org, normalize(dir), ShadingRay::Time(), VisibilityFlags::CameraRay, 0);
+    }
+
+    TEST_CASE(ComputeKey_GivenRaysInDifferentOctants_OrdersKeysByOctantFirst)
+    {
+        const AABB3d bbox(Vector3d(0.0), Vector3d(1.0));
+
+        const uint32 key1 = RayOrderer::compute_key(Vector3d(1.0), Vector3d(1.0, 1.0, 1.0), bbox);
+        const uint32 key2 = RayOrderer::compute_key(Vector3d(0.0), Vector3d(-1.0, 1.0, 1.0), bbox);
+
+        EXPECT_LT(key2, key1);
+    }
+
+    TEST_CASE(ComputeKey_GivenOriginsInDifferentOctantsOfBoundingBox_FollowsMortonOrder)
+    {
+        const AABB3d bbox(Vector3d(0.0), Vector3d(1.0));
+        const Vector3d dir(1.0, 1.0, 1.0);
+
+        const uint32 key1 = RayOrderer::compute_key(Vector3d(0.4, 0.4, 0.4), dir, bbox);
+        const uint32 key2 = RayOrderer::compute_key(Vector3d(0.1, 0.1, 0.6), dir, bbox);
+        const uint32 key3 = RayOrderer::compute_key(Vector3d(0.6, 0.1, 0.1), dir, bbox);
+
+        EXPECT_LT(key2, key1);
+        EXPECT_LT(key3, key2);
+    }
+
+    TEST_CASE(ComputeKey_GivenDegenerateBoundingBox_ReturnsOctantOnly)
+    {
+        const AABB3d bbox(Vector3d(2.0), Vector3d(2.0));
+
+        const uint32 key = RayOrderer::compute_key(Vector3d(2.0), Vector3d(1.0, -1.0, 1.0), bbox);
+
+        EXPECT_EQ(2UL << (3 * RayOrderer::OriginBits), key);
+    }
+
+    TEST_CASE(Sort_ReturnsPermutationOfRayIndices)
+    {
+        vector<ShadingRay> rays;
+        for (size_t i = 0; i < 100; ++i)
+        {
+            const double x = static_cast<double>((i * 37) % 100);
+            const double s = (i % 3) == 0 ? -1.0 : 1.0;
+            rays.push_back(make_ray(Vector3d(x, 0.0, 0.0), Vector3d(s, 1.0, 0.0)));
+        }
+
+        RayOrderer orderer;
+        orderer.sort(&rays[0], rays.size());
+
+        vector<size_t> order(orderer.get_order(), orderer.get_order() + rays.size());
+        sort(order.begin(), order.end());
+
+        for (size_t i = 0; i < order.size(); ++i)
+            EXPECT_EQ(i, order[i]);
+    }
+
+    TEST_CASE(Sort_GroupsRaysByDirectionOctant)
+    {
+        vector<ShadingRay> rays;
+        for (size_t i = 0; i < 16; ++i)
+        {
+            const double s = (i % 2) == 0 ? -1.0 : 1.0;
+            rays.push_back(make_ray(Vector3d(static_cast<double>(i), 0.0, 0.0), Vector3d(s, 1.0, 1.0)));
+        }
+
+        RayOrderer orderer;
+        orderer.sort(&rays[0], rays.size());
+
+        // Rays going toward +x come first, in increasing order of origins.
+        for (size_t i = 0; i < 8; ++i)
+        {
+            EXPECT_EQ(2 * i + 1, orderer[i]);
+            EXPECT_EQ(2 * i, orderer[8 + i]);
+        }
+    }
+
+    TEST_CASE(Keep_ReturnsIdentity)
+    {
+        RayOrderer orderer;
+        orderer.keep(5);
+
+        for (size_t i = 0; i < 5; ++i)
+            EXPECT_EQ(i, orderer[i]);
+    }
+}
@@ -67,4 +67,19 @@ TEST_SUITE(Renderer_Kernel_Rendering_Progressive_SampleGeneratorJob)
         plotfile.new_plot().set_points(points);
         plotfile.write("unit tests/outputs/test_samplegeneratorjob.gnuplot");
     }
+
+    TEST_CASE(DurationToSamplesPerJob_GivenModerateSpeed_ReturnsSamplesRenderedInJobDuration)
+    {
+        EXPECT_EQ(5000, SampleGeneratorJob::duration_to_samples_per_job(320000.0, 0.015625));
+    }
+
+    TEST_CASE(DurationToSamplesPerJob_GivenVeryLowSpeed_ReturnsMinimumSampleCount)
+    {
+        EXPECT_EQ(64, SampleGeneratorJob::duration_to_samples_per_job(10.0, 0.02));
+    }
+
+    TEST_CASE(DurationToSamplesPerJob_GivenVeryHighSpeed_ReturnsMaximumSampleCount)
+    {
+        EXPECT_EQ(250000, SampleGeneratorJob::duration_to_samples_per_job(1.0e12, 0.02));
+    }
 }
@@ -0,0 +1,198 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/volume/majorantgrid.h"
+#include "renderer/kernel/volume/sparsevoxelgrid.h"
+#include "renderer/kernel/volume/volume.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/distribution.h"
+#include "foundation/math/rng/mersennetwister.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Volume_SparseVoxelGrid)
+{
+    // Fill a dense grid with a smoke-like blob: nonzero voxels in one corner only.
+    void fill_blob(VoxelGrid& grid)
+    {
+        MersenneTwister rng;
+
+        for (size_t z = 0; z < grid.get_zres(); ++z)
+        {
+            for (size_t y = 0; y < grid.get_yres(); ++y)
+            {
+                for (size_t x = 0; x < grid.get_xres(); ++x)
+                {
+                    grid.voxel(x, y, z)[0] =
+                        x >= 10 && z < 8
+                            ? rand_float1(rng, 0.0f, 4.0f)
+                            : 0.0f;
+                }
+            }
+        }
+    }
+
+    TEST_CASE(Constructor_EmptyGrid_AllocatesNoBrick)
+    {
+        const SparseVoxelGrid grid(64, 64, 64);
+
+        EXPECT_EQ(0, grid.get_brick_count());
+        EXPECT_EQ(0.0f, grid.get_voxel(12, 34, 56));
+    }
+
+    TEST_CASE(SetVoxel_AllocatesBrickOnlyForNonzeroValues)
+    {
+        SparseVoxelGrid grid(16, 16, 16);
+
+        grid.set_voxel(1, 2, 3, 0.0f);
+        EXPECT_EQ(0, grid.get_brick_count());
+
+        grid.set_voxel(1, 2, 3, 5.0f);
+        grid.set_voxel(2, 2, 3, 6.0f);
+        EXPECT_EQ(1, grid.get_brick_count());
+        EXPECT_EQ(5.0f, grid.get_voxel(1, 2, 3));
+        EXPECT_EQ(6.0f, grid.get_voxel(2, 2, 3));
+        EXPECT_EQ(0.0f, grid.get_voxel(3, 2, 3));
+    }
+
+    TEST_CASE(Constructor_FromDenseGrid_OnlyStoresNonEmptyBricks)
+    {
+        VoxelGrid dense_grid(19, 10, 17, 1);
+        fill_blob(dense_grid);
+
+        const SparseVoxelGrid grid(dense_grid, 0);
+
+        // Voxels with x >= 10 and z < 8 span 2 bricks along x, 2 along y and 1 along z.
+        EXPECT_EQ(4, grid.get_brick_count());
+    }
+
+    TEST_CASE(LinearLookup_MatchesDenseGrid)
+    {
+        VoxelGrid dense_grid(19, 10, 17, 1);
+        fill_blob(dense_grid);
+
+        const SparseVoxelGrid grid(dense_grid, 0);
+
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            const Vector3d point(
+                rand_double1(rng),
+                rand_double1(rng),
+                rand_double1(rng));
+
+            float expected;
+            dense_grid.linear_lookup(point, &expected);
+
+            EXPECT_FEQ_EPS(expected, grid.linear_lookup(point), 1.0e-5f);
+        }
+    }
+
+    TEST_CASE(NearestLookup_MatchesDenseGrid)
+    {
+        VoxelGrid dense_grid(19, 10, 17, 1);
+        fill_blob(dense_grid);
+
+        const SparseVoxelGrid grid(dense_grid, 0);
+
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            const Vector3d point(
+                rand_double1(rng),
+                rand_double1(rng),
+                rand_double1(rng));
+
+            float expected;
+            dense_grid.nearest_lookup(point, &expected);
+
+            EXPECT_EQ(expected, grid.nearest_lookup(point));
+        }
+    }
+
+    TEST_CASE(LinearLookup_HalfStorage_MatchesDenseGridWithinHalfPrecision)
+    {
+        VoxelGrid dense_grid(19, 10, 17, 1);
+        fill_blob(dense_grid);
+
+        const SparseVoxelGrid grid(dense_grid, 0, SparseVoxelGrid::StorageHalf);
+
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            const Vector3d point(
+                rand_double1(rng),
+                rand_double1(rng),
+                rand_double1(rng));
+
+            float expected;
+            dense_grid.linear_lookup(point, &expected);
+
+            EXPECT_FEQ_EPS(expected, grid.linear_lookup(point), 1.0e-2f);
+        }
+    }
+
+    TEST_CASE(MajorantGrid_FromSparseGrid_MatchesMajorantGridFromDenseGrid)
+    {
+        VoxelGrid dense_grid(19, 10, 17, 1);
+        fill_blob(dense_grid);
+
+        const SparseVoxelGrid sparse_grid(dense_grid, 0);
+
+        const MajorantGrid expected(dense_grid, 0, 4);
+        const MajorantGrid grid(sparse_grid, 4);
+
+        ASSERT_EQ(expected.get_xres(), grid.get_xres());
+        ASSERT_EQ(expected.get_yres(), grid.get_yres());
+        ASSERT_EQ(expected.get_zres(), grid.get_zres());
+
+        for (size_t z = 0; z < grid.get_zres(); ++z)
+        {
+            for (size_t y = 0; y < grid.get_yres(); ++y)
+            {
+                for (size_t x = 0; x < grid.get_xres(); ++x)
+                {
+                    EXPECT_EQ(expected.get_minorant(x, y, z), grid.get_minorant(x, y, z));
+                    EXPECT_EQ(expected.get_majorant(x, y, z), grid.get_majorant(x, y, z));
+                }
+            }
+        }
+    }
+}
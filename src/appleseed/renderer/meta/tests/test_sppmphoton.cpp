@@ -0,0 +1,118 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/lighting/sppm/sppmphoton.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/color.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_SPPM_SPPMPhoton)
+{
+    TEST_CASE(SizeOfCompactMonoPhoton_IsAtMostHalfOfSizeOfMonoPhoton)
+    {
+        EXPECT_TRUE(2 * sizeof(SPPMCompactMonoPhoton) <= sizeof(SPPMMonoPhoton));
+    }
+
+    TEST_CASE(SizeOfCompactPolyPhoton_IsAtMostHalfOfSizeOfPolyPhoton)
+    {
+        EXPECT_TRUE(2 * sizeof(SPPMCompactPolyPhoton) <= sizeof(SPPMPolyPhoton));
+    }
+
+    TEST_CASE(CompactMonoPhotonDecode_GivenEncodedPhoton_ReturnsOriginalPhoton)
+    {
+        SPPMMonoPhoton photon;
+        photon.m_incoming = normalize(Vector3f(1.0f, 2.0f, -3.0f));
+        photon.m_geometric_normal = Vector3f(0.0f, 1.0f, 0.0f);
+        photon.m_flux.m_wavelength = 7;
+        photon.m_flux.m_amplitude = 1.0e-6f;
+
+        SPPMCompactMonoPhoton compact_photon;
+        compact_photon.encode(photon);
+
+        SPPMMonoPhoton decoded_photon;
+        compact_photon.decode(decoded_photon);
+
+        EXPECT_FEQ_EPS(photon.m_incoming, decoded_photon.m_incoming, 1.0e-4f);
+        EXPECT_FEQ_EPS(photon.m_geometric_normal, decoded_photon.m_geometric_normal, 1.0e-4f);
+        EXPECT_EQ(photon.m_flux.m_wavelength, decoded_photon.m_flux.m_wavelength);
+        EXPECT_EQ(photon.m_flux.m_amplitude, decoded_photon.m_flux.m_amplitude);
+    }
+
+    TEST_CASE(CompactPolyPhotonDecode_GivenEncodedPhotonWithSmallRGBFlux_ReturnsCloseFlux)
+    {
+        SPPMPolyPhoton photon;
+        photon.m_incoming = Vector3f(0.0f, 0.0f, -1.0f);
+        photon.m_geometric_normal = normalize(Vector3f(-1.0f, 1.0f, 1.0f));
+        photon.m_flux = Color3f(2.0e-9f, 1.0e-9f, 0.5e-9f);
+
+        SPPMCompactPolyPhoton compact_photon;
+        compact_photon.encode(photon);
+
+        SPPMPolyPhoton decoded_photon;
+        compact_photon.decode(decoded_photon);
+
+        EXPECT_FEQ_EPS(photon.m_incoming, decoded_photon.m_incoming, 1.0e-4f);
+        EXPECT_FEQ_EPS(photon.m_geometric_normal, decoded_photon.m_geometric_normal, 1.0e-4f);
+        ASSERT_EQ(3, decoded_photon.m_flux.size());
+        EXPECT_FEQ_EPS(2.0e-9f, decoded_photon.m_flux[0], 1.0e-12f);
+        EXPECT_FEQ_EPS(1.0e-9f, decoded_photon.m_flux[1], 1.0e-12f);
+        EXPECT_FEQ_EPS(0.5e-9f, decoded_photon.m_flux[2], 1.0e-12f);
+    }
+
+    TEST_CASE(CompactPolyPhotonDecode_GivenEncodedPhotonWithSpectralFlux_ReturnsCloseFlux)
+    {
+        const size_t SampleCount = Spectrum::Samples;
+
+        SPPMPolyPhoton photon;
+        photon.m_incoming = Vector3f(1.0f, 0.0f, 0.0f);
+        photon.m_geometric_normal = Vector3f(-1.0f, 0.0f, 0.0f);
+        photon.m_flux.resize(SampleCount);
+        for (size_t i = 0; i < SampleCount; ++i)
+            photon.m_flux[i] = 100.0f + static_cast<float>(i);
+
+        SPPMCompactPolyPhoton compact_photon;
+        compact_photon.encode(photon);
+
+        SPPMPolyPhoton decoded_photon;
+        compact_photon.decode(decoded_photon);
+
+        ASSERT_EQ(SampleCount, decoded_photon.m_flux.size());
+        for (size_t i = 0; i < SampleCount; ++i)
+            EXPECT_FEQ_EPS(photon.m_flux[i], decoded_photon.m_flux[i], 0.1f);
+    }
+}
@@ -0,0 +1,87 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/lighting/sppm/sppmvisibleregions.h"
+#include "renderer/modeling/light/lighttarget.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Lighting_SPPM_SPPMVisibleRegions)
+{
+    TEST_CASE(GetTargets_GivenPointsInTwoCells_ReturnsTwoTargetsEnclosingThePoints)
+    {
+        SPPMVisibleRegions regions(AABB3d(Vector3d(0.0), Vector3d(8.0)), 8);
+
+        regions.insert(Vector3f(0.2f, 0.2f, 0.2f));
+        regions.insert(Vector3f(0.8f, 0.5f, 0.3f));
+        regions.insert(Vector3f(7.5f, 7.5f, 7.5f));
+
+        LightTargetArray targets;
+        regions.get_targets(targets);
+
+        ASSERT_EQ(2, targets.size());
+        EXPECT_TRUE(targets[0].get_bbox().contains(Vector3d(0.2, 0.2, 0.2)));
+        EXPECT_TRUE(targets[0].get_bbox().contains(Vector3d(0.8, 0.5, 0.3)));
+        EXPECT_FALSE(targets[0].get_bbox().contains(Vector3d(1.5, 1.5, 1.5)));
+        EXPECT_TRUE(targets[1].get_bbox().contains(Vector3d(7.5, 7.5, 7.5)));
+    }
+
+    TEST_CASE(GetTargets_GivenPointsOutsideSceneBoundingBox_AssignsThemToBorderCells)
+    {
+        SPPMVisibleRegions regions(AABB3d(Vector3d(0.0), Vector3d(8.0)), 8);
+
+        regions.insert(Vector3f(-1.0f, 9.0f, 0.5f));
+
+        LightTargetArray targets;
+        regions.get_targets(targets);
+
+        ASSERT_EQ(1, targets.size());
+        EXPECT_TRUE(targets[0].get_bbox().contains(Vector3d(-1.0, 9.0, 0.5)));
+    }
+
+    TEST_CASE(Clear_RemovesAllVisiblePoints)
+    {
+        SPPMVisibleRegions regions(AABB3d(Vector3d(0.0), Vector3d(8.0)), 8);
+        regions.insert(Vector3f(1.0f, 2.0f, 3.0f));
+
+        regions.clear();
+
+        LightTargetArray targets;
+        regions.get_targets(targets);
+
+        EXPECT_TRUE(targets.empty());
+    }
+}
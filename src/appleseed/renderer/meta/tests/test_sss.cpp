@@ -787,6 +787,29 @@ TEST_SUITE(Renderer_Modeling_BSSRDF_SSS)
         }
     }
 
+    TEST_CASE(NormalizedDiffusion_SampleTabulated_InvertsCDF)
+    {
+        MersenneTwister rng;
+
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            const float u = rand_float2(rng);
+            const float a = rand_float1(rng);
+            const float l = rand_float1(rng, 0.001f, 10.0f);
+
+            const float s = normalized_diffusion_s_dmfp(a);
+            const float r = normalized_diffusion_sample_tabulated(u, l, s);
+
+            EXPECT_FEQ_EPS(u, normalized_diffusion_cdf(r, l, s), 1.0e-3f);
+            EXPECT_LT(1.0001f * normalized_diffusion_max_radius(l, s), r);
+        }
+    }
+
+    TEST_CASE(NormalizedDiffusion_SampleTabulated_GivenZero_ReturnsZero)
+    {
+        EXPECT_EQ(0.0f, normalized_diffusion_sample_tabulated(0.0f, 1.0f, 2.0f));
+    }
+
     TEST_CASE(NormalizedDiffusion_IntegrateProfile)
     {
         const float Rd = 0.5f;
@@ -0,0 +1,160 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/tessellation/statictessellation.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cstddef>
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Tessellation_StaticTessellation)
+{
+    struct Fixture
+    {
+        StaticTriangleTess m_tess;
+
+        Fixture()
+        {
+            populate(m_tess);
+        }
+
+        static void populate(StaticTriangleTess& tess)
+        {
+            tess.m_vertices.push_back(GVector3(-1.0f, 0.0f, 2.0f));
+            tess.m_vertices.push_back(GVector3(3.0f, 0.5f, 2.0f));
+            tess.m_vertices.push_back(GVector3(0.25f, 8.0f, 2.0f));
+
+            tess.m_vertex_normals.push_back(normalize(GVector3(1.0f, 2.0f, 3.0f)));
+            tess.m_vertex_normals.push_back(normalize(GVector3(-1.0f, 0.5f, -3.0f)));
+
+            tess.push_tex_coords(GVector2(0.0f, 0.0f));
+            tess.push_tex_coords(GVector2(0.3f, 1.7f));
+            tess.push_tex_coords(GVector2(2.0f, 1.0f));
+        }
+    };
+
+    TEST_CASE_F(CompactVertexAttributes_PreservesFeatureCounts, Fixture)
+    {
+        m_tess.compact_vertex_attributes();
+
+        EXPECT_TRUE(m_tess.has_compact_vertex_attributes());
+        EXPECT_EQ(3, m_tess.get_vertex_count());
+        EXPECT_EQ(2, m_tess.get_vertex_normal_count());
+        EXPECT_EQ(3, m_tess.get_tex_coords_count());
+        EXPECT_TRUE(m_tess.m_vertices.empty());
+        EXPECT_TRUE(m_tess.m_vertex_normals.empty());
+    }
+
+    TEST_CASE_F(CompactVertexAttributes_ApproximatesFeatures, Fixture)
+    {
+        const GVector3 v1 = m_tess.get_vertex(1);
+        const GVector3 n1 = m_tess.get_vertex_normal(1);
+        const GVector2 uv1 = m_tess.get_tex_coords(1);
+
+        m_tess.compact_vertex_attributes();
+
+        EXPECT_FEQ_EPS(v1, m_tess.get_vertex(1), 1.0e-3f);
+        EXPECT_FEQ_EPS(n1, m_tess.get_vertex_normal(1), 1.0e-3f);
+        EXPECT_FEQ_EPS(uv1, m_tess.get_tex_coords(1), 1.0e-3f);
+    }
+
+    TEST_CASE_F(CompactVertexAttributes_PreservesBoundingBox, Fixture)
+    {
+        const GAABB3 expected_bbox = m_tess.compute_local_bbox();
+
+        m_tess.compact_vertex_attributes();
+
+        EXPECT_FEQ_EPS(expected_bbox.min, m_tess.compute_local_bbox().min, 1.0e-6f);
+        EXPECT_FEQ_EPS(expected_bbox.max, m_tess.compute_local_bbox().max, 1.0e-6f);
+    }
+
+    TEST_CASE_F(CompactVertexAttributes_GivenVertexPoses_CompactsVertexPoses, Fixture)
+    {
+        m_tess.set_motion_segment_count(1);
+        m_tess.set_vertex_pose(0, 0, GVector3(-1.0f, 0.0f, 3.0f));
+        m_tess.set_vertex_pose(1, 0, GVector3(3.0f, 0.5f, 3.0f));
+        m_tess.set_vertex_pose(2, 0, GVector3(0.25f, 8.0f, 3.0f));
+
+        m_tess.compact_vertex_attributes();
+
+        EXPECT_FEQ_EPS(GVector3(3.0f, 0.5f, 3.0f), m_tess.get_vertex_pose(1, 0), 1.0e-3f);
+        EXPECT_FEQ_EPS(GVector3(3.0f, 0.5f, 2.0f), m_tess.get_vertex(1), 1.0e-3f);
+    }
+
+    TEST_CASE_F(IsEqual_GivenIdenticalTessellations_ReturnsTrue, Fixture)
+    {
+        StaticTriangleTess other;
+        populate(other);
+
+        EXPECT_TRUE(m_tess.is_equal(other));
+        EXPECT_EQ(m_tess.compute_hash(), other.compute_hash());
+    }
+
+    TEST_CASE_F(IsEqual_GivenDifferentVertices_ReturnsFalse, Fixture)
+    {
+        StaticTriangleTess other;
+        populate(other);
+        other.m_vertices[1].y += 1.0f;
+
+        EXPECT_FALSE(m_tess.is_equal(other));
+        EXPECT_NEQ(m_tess.compute_hash(), other.compute_hash());
+    }
+
+    TEST_CASE_F(IsEqual_GivenDifferentTexCoords_ReturnsFalse, Fixture)
+    {
+        StaticTriangleTess other;
+        populate(other);
+        other.push_tex_coords(GVector2(0.5f, 0.5f));
+
+        EXPECT_FALSE(m_tess.is_equal(other));
+    }
+
+    TEST_CASE_F(IsEqual_GivenCompactedTessellations_ReturnsTrue, Fixture)
+    {
+        StaticTriangleTess other;
+        populate(other);
+
+        m_tess.compact_vertex_attributes();
+        other.compact_vertex_attributes();
+
+        EXPECT_TRUE(m_tess.is_equal(other));
+        EXPECT_EQ(m_tess.compute_hash(), other.compute_hash());
+    }
+}
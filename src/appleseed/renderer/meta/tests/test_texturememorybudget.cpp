@@ -0,0 +1,95 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/kernel/texturing/texturememorybudget.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/test.h"
+
+using namespace foundation;
+using namespace renderer;
+
+TEST_SUITE(Renderer_Kernel_Texturing_TextureMemoryBudget)
+{
+    ParamArray make_params(const bool shared)
+    {
+        return
+            ParamArray()
+                .insert("max_size", 1000)
+                .insert("shared_memory_budget", shared);
+    }
+
+    TEST_CASE(GetSizes_GivenBudgetIsNotShared_ReturnsTotalSizeForBothCaches)
+    {
+        TextureMemoryBudget budget(make_params(false));
+        budget.update(100, 90, 100, 10);
+
+        EXPECT_EQ(1000, budget.get_texture_store_size());
+        EXPECT_EQ(1000, budget.get_oiio_size());
+    }
+
+    TEST_CASE(GetSizes_GivenBudgetIsShared_InitiallySplitsBudgetEvenly)
+    {
+        TextureMemoryBudget budget(make_params(true));
+
+        EXPECT_EQ(500, budget.get_texture_store_size());
+        EXPECT_EQ(500, budget.get_oiio_size());
+    }
+
+    TEST_CASE(Update_GivenMoreTextureStoreMisses_MovesBudgetTowardTextureStore)
+    {
+        TextureMemoryBudget budget(make_params(true));
+        budget.update(100, 30, 100, 10);
+
+        EXPECT_GT(500, budget.get_texture_store_size());
+        EXPECT_EQ(1000, budget.get_texture_store_size() + budget.get_oiio_size());
+    }
+
+    TEST_CASE(Update_GivenOnlyOIIOMisses_KeepsMinimumShareForTextureStore)
+    {
+        TextureMemoryBudget budget(make_params(true));
+
+        for (size_t i = 0; i < 10; ++i)
+            budget.update(100, 0, 100, 10);
+
+        EXPECT_EQ(100, budget.get_texture_store_size());
+        EXPECT_EQ(900, budget.get_oiio_size());
+    }
+
+    TEST_CASE(Update_GivenNoMisses_KeepsCurrentSplit)
+    {
+        TextureMemoryBudget budget(make_params(true));
+        budget.update(100, 0, 100, 0);
+
+        EXPECT_EQ(500, budget.get_texture_store_size());
+        EXPECT_EQ(500, budget.get_oiio_size());
+    }
+}
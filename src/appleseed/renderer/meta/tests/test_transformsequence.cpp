@@ -381,6 +381,15 @@ TEST_SUITE(Renderer_Utility_TransformSequence)
         EXPECT_FEQ(expected, m_sequence.evaluate(2.0));
     }
 
+    TEST_CASE_F(SegmentToParent_GivenTwoTranslations_ReturnsBoundingBoxSweptAlongSegment, TwoTransformsFixture)
+    {
+        const AABB3d bbox(Vector3d(0.0), Vector3d(1.0));
+
+        const AABB3d motion_bbox = m_sequence.segment_to_parent(bbox, 0);
+
+        EXPECT_EQ(AABB3d(Vector3d(1.0, 2.0, 3.0), Vector3d(5.0, 6.0, 7.0)), motion_bbox);
+    }
+
     TEST_CASE(Evaluate_GivenTwoTransformsSetInReverseOrder_ReturnsCorrectlyInterpolatedTransform)
     {
         const Transformd ExpectedFirstTransform(
@@ -0,0 +1,174 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/triangleencoder.h"
+#include "renderer/kernel/intersection/trianglevertexinfo.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/iostreamop.h"
+#include "foundation/utility/memory.h"
+#include "foundation/utility/test.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Intersection_TriangleEncoder)
+{
+    struct Fixture
+    {
+        vector<TriangleVertexInfo>  m_triangle_vertex_infos;
+        vector<GVector3>            m_triangle_vertices;
+        vector<size_t>              m_triangle_indices;
+
+        // Two triangles sharing an edge.
+        Fixture()
+        {
+            m_triangle_vertices.push_back(GVector3(0.0f, 0.0f, 0.0f));
+            m_triangle_vertices.push_back(GVector3(1.0f, 0.0f, 0.0f));
+            m_triangle_vertices.push_back(GVector3(0.0f, 1.0f, 0.5f));
+            m_triangle_vertices.push_back(GVector3(1.0f, 0.0f, 0.0f));
+            m_triangle_vertices.push_back(GVector3(1.0f, 1.0f, 0.25f));
+            m_triangle_vertices.push_back(GVector3(0.0f, 1.0f, 0.5f));
+
+            m_triangle_vertex_infos.push_back(TriangleVertexInfo(0, 0, 1));
+            m_triangle_vertex_infos.push_back(TriangleVertexInfo(3, 0, 2));
+
+            m_triangle_indices.push_back(0);
+            m_triangle_indices.push_back(1);
+        }
+
+        TriangleEncoder::LeafFormat select_format(const TriangleEncoder::LeafFormat format) const
+        {
+            return
+                TriangleEncoder::select_format(
+                    format,
+                    m_triangle_vertex_infos,
+                    m_triangle_vertices,
+                    m_triangle_indices,
+                    0,
+                    m_triangle_indices.size());
+        }
+
+        vector<uint8> encode(
+            const TriangleEncoder::LeafFormat   format,
+            vector<GVector3>&                   leaf_vertices) const
+        {
+            vector<uint8> data(
+                TriangleEncoder::compute_size(
+                    format,
+                    m_triangle_vertex_infos,
+                    m_triangle_vertices,
+                    m_triangle_indices,
+                    0,
+                    m_triangle_indices.size()));
+
+            MemoryWriter writer(&data[0]);
+            TriangleEncoder::encode(
+                format,
+                m_triangle_vertex_infos,
+                m_triangle_vertices,
+                m_triangle_indices,
+                0,
+                m_triangle_indices.size(),
+                writer,
+                leaf_vertices);
+
+            assert(writer.offset() == data.size());
+
+            return data;
+        }
+    };
+
+    TEST_CASE_F(SelectFormat_GivenMovingTriangle_ReturnsFlatLeaf, Fixture)
+    {
+        m_triangle_vertex_infos[1].m_motion_segment_count = 1;
+
+        EXPECT_EQ(TriangleEncoder::FlatLeaf, select_format(TriangleEncoder::QuantizedLeaf));
+    }
+
+    TEST_CASE_F(Encode_IndexedLeaf_StoresSharedVerticesOnce, Fixture)
+    {
+        ASSERT_EQ(TriangleEncoder::IndexedLeaf, select_format(TriangleEncoder::IndexedLeaf));
+
+        vector<GVector3> leaf_vertices;
+        const vector<uint8> data = encode(TriangleEncoder::IndexedLeaf, leaf_vertices);
+
+        MemoryReader reader(&data[0]);
+        const uint32 header = reader.read<uint32>();
+        EXPECT_EQ(TriangleEncoder::IndexedLeaf, TriangleEncoder::get_leaf_format(header));
+        EXPECT_EQ(4, TriangleEncoder::get_leaf_vertex_count(header));
+        EXPECT_TRUE(leaf_vertices.empty());
+
+        const GVector3* vertices = reinterpret_cast<const GVector3*>(reader.read(4 * sizeof(GVector3)));
+
+        for (size_t i = 0; i < 2; ++i)
+        {
+            EXPECT_EQ(m_triangle_vertex_infos[i].m_vis_flags, reader.read<uint32>());
+            const uint8* indices = reinterpret_cast<const uint8*>(reader.read(4 * sizeof(uint8)));
+
+            for (size_t j = 0; j < 3; ++j)
+                EXPECT_EQ(m_triangle_vertices[i * 3 + j], vertices[indices[j]]);
+        }
+    }
+
+    TEST_CASE_F(Encode_QuantizedLeaf_QuantizedBoundsContainVertices, Fixture)
+    {
+        ASSERT_EQ(TriangleEncoder::QuantizedLeaf, select_format(TriangleEncoder::QuantizedLeaf));
+
+        vector<GVector3> leaf_vertices;
+        const vector<uint8> data = encode(TriangleEncoder::QuantizedLeaf, leaf_vertices);
+
+        MemoryReader reader(&data[0]);
+        const uint32 header = reader.read<uint32>();
+        EXPECT_EQ(TriangleEncoder::QuantizedLeaf, TriangleEncoder::get_leaf_format(header));
+        ASSERT_EQ(4, TriangleEncoder::get_leaf_vertex_count(header));
+        ASSERT_EQ(4, leaf_vertices.size());
+        EXPECT_EQ(0, reader.read<uint32>());
+
+        const GVector3 origin = reader.read<GVector3>();
+        const GVector3 scale = reader.read<GVector3>();
+        const uint16* quantized_vertices = reinterpret_cast<const uint16*>(reader.read(4 * 3 * sizeof(uint16)));
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            const AABB3d bbox = TriangleEncoder::dequantize_vertex(origin, scale, &quantized_vertices[i * 3]);
+            EXPECT_TRUE(bbox.contains(Vector3d(leaf_vertices[i])));
+            EXPECT_LT(0.001, bbox.extent(0));
+        }
+    }
+}
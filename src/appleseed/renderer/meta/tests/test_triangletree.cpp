@@ -0,0 +1,248 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/kernel/intersection/regioninfo.h"
+#include "renderer/kernel/intersection/triangletree.h"
+#include "renderer/modeling/object/iregion.h"
+#include "renderer/modeling/object/meshobject.h"
+#include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/regionkit.h"
+#include "renderer/modeling/object/triangle.h"
+#include "renderer/modeling/scene/assembly.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/objectinstance.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+#include "renderer/utility/testutils.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/transform.h"
+#include "foundation/platform/thread.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/lazy.h"
+#include "foundation/utility/test.h"
+#include "foundation/utility/uid.h"
+
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <fstream>
+#include <memory>
+
+using namespace boost::filesystem;
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+TEST_SUITE(Renderer_Kernel_Intersection_TriangleTree)
+{
+    struct Fixture
+      : public TestFixtureBase
+    {
+        const path m_cache_directory;
+
+        Fixture()
+          : m_cache_directory(absolute("unit tests/outputs/test_triangletree/"))
+        {
+            remove_all(m_cache_directory);
+
+            // See the comment in test_projectfilewriter.cpp.
+            foundation::sleep(50);
+
+            create_directory(m_cache_directory);
+
+            m_scene.get_parameters().insert_path(
+                "acceleration_structure.triangle_tree_cache_directory",
+                m_cache_directory.string());
+
+            auto_release_ptr<MeshObject> object(MeshObjectFactory::create("object", ParamArray()));
+            object->push_vertex(GVector3(0.0f, 0.0f, 0.0f));
+            object->push_vertex(GVector3(1.0f, 0.0f, 0.0f));
+            object->push_vertex(GVector3(0.0f, 1.0f, 0.0f));
+            object->push_vertex(GVector3(1.0f, 1.0f, 0.0f));
+            object->push_triangle(Triangle(0, 1, 2));
+            object->push_triangle(Triangle(1, 3, 2));
+            m_assembly.objects().insert(auto_release_ptr<Object>(object));
+
+            m_assembly.object_instances().insert(
+                ObjectInstanceFactory::create(
+                    "object_instance",
+                    ParamArray(),
+                    "object",
+                    Transformd::identity(),
+                    StringDictionary()));
+
+            bind_inputs();
+        }
+
+        auto_ptr<TriangleTree> build_tree() const
+        {
+            const ObjectInstance* object_instance = m_assembly.object_instances().get_by_index(0);
+            Access<RegionKit> region_kit(&object_instance->get_object().get_region_kit());
+            const GAABB3 bbox = (*region_kit)[0]->compute_local_bbox();
+
+            RegionInfoVector regions;
+            regions.push_back(RegionInfo(0, 0, bbox));
+
+            return
+                auto_ptr<TriangleTree>(
+                    new TriangleTree(
+                        TriangleTree::Arguments(
+                            m_scene,
+                            new_guid(),
+                            bbox,
+                            m_assembly,
+                            regions)));
+        }
+
+        size_t get_cache_file_count() const
+        {
+            size_t count = 0;
+
+            for (directory_iterator i(m_cache_directory), e; i != e; ++i)
+            {
+                if (i->path().extension() == ".tree")
+                    ++count;
+            }
+
+            return count;
+        }
+
+        path get_cache_file_path() const
+        {
+            for (directory_iterator i(m_cache_directory), e; i != e; ++i)
+            {
+                if (i->path().extension() == ".tree")
+                    return i->path();
+            }
+
+            return path();
+        }
+    };
+
+    TEST_CASE_F(Constructor_GivenEmptyCache_BuildsTreeAndStoresItInCache, Fixture)
+    {
+        auto_ptr<TriangleTree> tree = build_tree();
+
+        EXPECT_FALSE(tree->is_loaded_from_cache());
+        EXPECT_EQ(2, tree->get_static_triangle_count());
+        EXPECT_EQ(1, get_cache_file_count());
+    }
+
+    TEST_CASE_F(Constructor_GivenCachedTree_LoadsTreeFromCache, Fixture)
+    {
+        const auto_ptr<TriangleTree> built_tree = build_tree();
+        const auto_ptr<TriangleTree> loaded_tree = build_tree();
+
+        EXPECT_TRUE(loaded_tree->is_loaded_from_cache());
+        EXPECT_EQ(built_tree->get_static_triangle_count(), loaded_tree->get_static_triangle_count());
+        EXPECT_EQ(built_tree->get_moving_triangle_count(), loaded_tree->get_moving_triangle_count());
+        EXPECT_EQ(built_tree->get_memory_size(), loaded_tree->get_memory_size());
+        EXPECT_EQ(1, get_cache_file_count());
+    }
+
+    TEST_CASE_F(Constructor_GivenTruncatedCacheFile_RebuildsTree, Fixture)
+    {
+        build_tree();
+
+        const path cache_file_path = get_cache_file_path();
+        const uintmax_t cache_file_size = file_size(cache_file_path);
+        resize_file(cache_file_path, cache_file_size / 2);
+
+        const auto_ptr<TriangleTree> tree = build_tree();
+
+        EXPECT_FALSE(tree->is_loaded_from_cache());
+        EXPECT_EQ(2, tree->get_static_triangle_count());
+        EXPECT_EQ(cache_file_size, file_size(cache_file_path));
+    }
+
+    TEST_CASE_F(Constructor_GivenCacheFileWithForeignVersion_RebuildsTree, Fixture)
+    {
+        build_tree();
+
+        // Overwrite the format version, stored right after the 4-byte signature.
+        const path cache_file_path = get_cache_file_path();
+        {
+            fstream file(cache_file_path.string().c_str(), ios::in | ios::out | ios::binary);
+            file.seekp(4);
+            const uint32 foreign_version = 0xFFFFFFFFUL;
+            file.write(reinterpret_cast<const char*>(&foreign_version), sizeof(foreign_version));
+        }
+
+        const auto_ptr<TriangleTree> tree = build_tree();
+
+        EXPECT_FALSE(tree->is_loaded_from_cache());
+        EXPECT_EQ(2, tree->get_static_triangle_count());
+    }
+
+    TEST_CASE_F(Constructor_GivenDifferentBuildParameters_MissesCache, Fixture)
+    {
+        build_tree();
+
+        m_assembly.get_parameters().insert_path("acceleration_structure.algorithm", "sbvh");
+
+        const auto_ptr<TriangleTree> tree = build_tree();
+
+        EXPECT_FALSE(tree->is_loaded_from_cache());
+        EXPECT_EQ(2, get_cache_file_count());
+    }
+
+    TEST_CASE_F(Constructor_GivenDifferentSceneLeafEncoding_MissesCache, Fixture)
+    {
+        build_tree();
+
+        // Assemblies without their own leaf encoding use the one of the scene.
+        m_scene.get_parameters().insert_path("acceleration_structure.leaf_encoding", "indexed");
+
+        const auto_ptr<TriangleTree> tree = build_tree();
+
+        EXPECT_FALSE(tree->is_loaded_from_cache());
+        EXPECT_EQ(2, tree->get_static_triangle_count());
+        EXPECT_EQ(2, get_cache_file_count());
+    }
+
+    TEST_CASE_F(Constructor_GivenDifferentSceneNodeType_MissesCache, Fixture)
+    {
+        build_tree();
+
+        m_scene.get_parameters().insert_path("acceleration_structure.node_type", "quantized");
+
+        const auto_ptr<TriangleTree> tree = build_tree();
+
+        EXPECT_FALSE(tree->is_loaded_from_cache());
+        EXPECT_EQ(2, get_cache_file_count());
+    }
+}
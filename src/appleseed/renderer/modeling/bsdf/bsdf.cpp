@@ -84,7 +84,7 @@ void* BSDF::evaluate_inputs(
 
     get_inputs().evaluate(
         shading_context.get_texture_cache(),
-        shading_point.get_uv(0),
+        shading_point,
         data);
 
     prepare_inputs(
@@ -102,6 +102,12 @@ void BSDF::prepare_inputs(
 {
 }
 
+void BSDF::select_lobes(
+    SamplingContext&        sampling_context,
+    void*                   data) const
+{
+}
+
 float BSDF::sample_ior(
     SamplingContext&        sampling_context,
     const void*             data) const
@@ -140,6 +140,14 @@ class APPLESEED_DLLSYMBOL BSDF
         const ShadingPoint&         shading_point,
         void*                       data) const;
 
+    // Draw the random numbers that evaluate() uses to choose which lobes to evaluate
+    // at this shading point. This must be called after evaluate_inputs() and before
+    // any evaluation. If it is not called, evaluate() evaluates all lobes. By default,
+    // this method does nothing.
+    virtual void select_lobes(
+        SamplingContext&            sampling_context,
+        void*                       data) const;
+
     // Given an outgoing direction, sample the BSDF and compute the incoming
     // direction, its probability density and the value of the BSDF for this
     // pair of directions. Return the scattering mode. If the scattering mode
@@ -107,12 +107,22 @@ namespace
             m_bsdf[0] = retrieve_bsdf(*assembly, "bsdf0");
             m_bsdf[1] = retrieve_bsdf(*assembly, "bsdf1");
 
+            m_stochastic_lobe_selection = m_params.get_optional<bool>("stochastic_lobe_selection", false);
+
             if (m_bsdf[0] == 0 || m_bsdf[1] == 0)
                 return false;
 
             return true;
         }
 
+        virtual bool has_spectral_inputs() const APPLESEED_OVERRIDE
+        {
+            return
+                BSDF::has_spectral_inputs() ||
+                (m_bsdf[0] && m_bsdf[0]->has_spectral_inputs()) ||
+                (m_bsdf[1] && m_bsdf[1]->has_spectral_inputs());
+        }
+
         virtual void* evaluate_inputs(
             const ShadingContext&   shading_context,
             const ShadingPoint&     shading_point) const APPLESEED_OVERRIDE
@@ -128,9 +138,30 @@ namespace
             values->m_child_inputs[0] = m_bsdf[0]->evaluate_inputs(shading_context, shading_point);
             values->m_child_inputs[1] = m_bsdf[1]->evaluate_inputs(shading_context, shading_point);
 
+            // Evaluate both BSDFs unless select_lobes() is called.
+            values->m_lobe_selector = -1.0f;
+
             return values;
         }
 
+        virtual void select_lobes(
+            SamplingContext&        sampling_context,
+            void*                   data) const APPLESEED_OVERRIDE
+        {
+            assert(m_bsdf[0] && m_bsdf[1]);
+
+            Values* values = static_cast<Values*>(data);
+
+            if (m_stochastic_lobe_selection)
+            {
+                sampling_context.split_in_place(1, 1);
+                values->m_lobe_selector = sampling_context.next2<float>();
+            }
+
+            m_bsdf[0]->select_lobes(sampling_context, values->m_child_inputs[0]);
+            m_bsdf[1]->select_lobes(sampling_context, values->m_child_inputs[1]);
+        }
+
         virtual void sample(
             SamplingContext&        sampling_context,
             const void*             data,
@@ -193,6 +224,41 @@ namespace
             w0 *= rcp_total_weight;
             w1 *= rcp_total_weight;
 
+            // In stochastic mode, only one of the two BSDFs is evaluated, chosen with a
+            // probability equal to its weight: the weight and the probability cancel out.
+            // The PDF of the other BSDF is still needed to return the PDF of the mix.
+            if (values->m_lobe_selector >= 0.0f && w0 > 0.0f && w1 > 0.0f)
+            {
+                const size_t bsdf_index = values->m_lobe_selector < w0 ? 0 : 1;
+                const size_t other_index = 1 - bsdf_index;
+
+                const float bsdf_prob =
+                    m_bsdf[bsdf_index]->evaluate(
+                        values->m_child_inputs[bsdf_index],
+                        adjoint,
+                        false,                  // do not multiply by |cos(incoming, normal)|
+                        geometric_normal,
+                        shading_basis,
+                        outgoing,
+                        incoming,
+                        modes,
+                        value);
+                if (bsdf_prob == 0.0f)
+                    value.set(0.0f);
+
+                const float other_prob =
+                    m_bsdf[other_index]->evaluate_pdf(
+                        values->m_child_inputs[other_index],
+                        geometric_normal,
+                        shading_basis,
+                        outgoing,
+                        incoming,
+                        modes);
+
+                const float w[2] = { w0, w1 };
+                return bsdf_prob * w[bsdf_index] + other_prob * w[other_index];
+            }
+
             // Evaluate the first BSDF.
             Spectrum bsdf0_value;
             const float bsdf0_prob =
@@ -292,10 +358,12 @@ namespace
             };
 
             const Inputs*   m_inputs;
-            const void*     m_child_inputs[2];
+            void*           m_child_inputs[2];
+            float           m_lobe_selector;    // in [0,1) to evaluate a single BSDF, -1 to evaluate both
         };
 
         const BSDF* m_bsdf[2];
+        bool        m_stochastic_lobe_selection;
 
         const BSDF* retrieve_bsdf(const Assembly& assembly, const char* param_name) const
         {
@@ -377,6 +445,15 @@ DictionaryArray BSDFMixFactory::get_input_metadata() const
             .insert("use", "required")
             .insert("default", "0.5"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "stochastic_lobe_selection")
+            .insert("label", "Stochastic Lobe Selection")
+            .insert("type", "boolean")
+            .insert("use", "optional")
+            .insert("default", "false")
+            .insert("help", "Evaluate only one of the mixed BSDFs for each light sample, picked at random with a probability equal to its weight"));
+
     return metadata;
 }
 
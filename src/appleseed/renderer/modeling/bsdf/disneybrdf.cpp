@@ -35,6 +35,8 @@
 #include "renderer/modeling/bsdf/microfacethelper.h"
 #include "renderer/modeling/color/colorspace.h"
 #include "renderer/modeling/color/wavelengths.h"
+#include "renderer/modeling/input/source.h"
+#include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
 #include "foundation/image/colorspace.h"
@@ -50,6 +52,7 @@
 // Standard headers.
 #include <cmath>
 #include <cstddef>
+#include <string>
 
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
@@ -334,6 +337,7 @@ namespace
             const char*             name,
             const ParamArray&       params)
           : BSDF(name, Reflective, ScatteringMode::Diffuse | ScatteringMode::Glossy, params)
+          , m_lobes(SheenLobe | ClearcoatLobe)
         {
             m_inputs.declare("base_color", InputFormatSpectralReflectance);
             m_inputs.declare("subsurface", InputFormatFloat, "0.0");
@@ -363,6 +367,25 @@ namespace
             return sizeof(InputValues);
         }
 
+        virtual bool on_frame_begin(
+            const Project&          project,
+            const BaseGroup*        parent,
+            OnFrameBeginRecorder&   recorder,
+            IAbortSwitch*           abort_switch) APPLESEED_OVERRIDE
+        {
+            if (!BSDF::on_frame_begin(project, parent, recorder, abort_switch))
+                return false;
+
+            // Select the variant of the BRDF that skips inactive lobes.
+            m_lobes = 0;
+            if (is_lobe_active("sheen"))
+                m_lobes |= SheenLobe;
+            if (is_lobe_active("clearcoat"))
+                m_lobes |= ClearcoatLobe;
+
+            return true;
+        }
+
         virtual void prepare_inputs(
             Arena&                  arena,
             const ShadingPoint&     shading_point,
@@ -391,6 +414,128 @@ namespace
             const bool              adjoint,
             const bool              cosine_mult,
             BSDFSample&             sample) const APPLESEED_OVERRIDE
+        {
+            switch (m_lobes)
+            {
+              case 0:
+                do_sample<false, false>(sampling_context, data, adjoint, cosine_mult, sample);
+                break;
+              case SheenLobe:
+                do_sample<true, false>(sampling_context, data, adjoint, cosine_mult, sample);
+                break;
+              case ClearcoatLobe:
+                do_sample<false, true>(sampling_context, data, adjoint, cosine_mult, sample);
+                break;
+              default:
+                do_sample<true, true>(sampling_context, data, adjoint, cosine_mult, sample);
+                break;
+            }
+        }
+
+        virtual float evaluate(
+            const void*             data,
+            const bool              adjoint,
+            const bool              cosine_mult,
+            const Vector3f&         geometric_normal,
+            const Basis3f&          shading_basis,
+            const Vector3f&         outgoing,
+            const Vector3f&         incoming,
+            const int               modes,
+            Spectrum&               value) const APPLESEED_OVERRIDE
+        {
+            switch (m_lobes)
+            {
+              case 0:
+                return do_evaluate<false, false>(
+                    data, adjoint, cosine_mult, geometric_normal, shading_basis,
+                    outgoing, incoming, modes, value);
+              case SheenLobe:
+                return do_evaluate<true, false>(
+                    data, adjoint, cosine_mult, geometric_normal, shading_basis,
+                    outgoing, incoming, modes, value);
+              case ClearcoatLobe:
+                return do_evaluate<false, true>(
+                    data, adjoint, cosine_mult, geometric_normal, shading_basis,
+                    outgoing, incoming, modes, value);
+              default:
+                return do_evaluate<true, true>(
+                    data, adjoint, cosine_mult, geometric_normal, shading_basis,
+                    outgoing, incoming, modes, value);
+            }
+        }
+
+        virtual float evaluate_pdf(
+            const void*             data,
+            const Vector3f&         geometric_normal,
+            const Basis3f&          shading_basis,
+            const Vector3f&         outgoing,
+            const Vector3f&         incoming,
+            const int               modes) const APPLESEED_OVERRIDE
+        {
+            switch (m_lobes)
+            {
+              case 0:
+                return do_evaluate_pdf<false, false>(
+                    data, geometric_normal, shading_basis,
+                    outgoing, incoming, modes);
+              case SheenLobe:
+                return do_evaluate_pdf<true, false>(
+                    data, geometric_normal, shading_basis,
+                    outgoing, incoming, modes);
+              case ClearcoatLobe:
+                return do_evaluate_pdf<false, true>(
+                    data, geometric_normal, shading_basis,
+                    outgoing, incoming, modes);
+              default:
+                return do_evaluate_pdf<true, true>(
+                    data, geometric_normal, shading_basis,
+                    outgoing, incoming, modes);
+            }
+        }
+
+      private:
+        typedef DisneyBRDFInputValues InputValues;
+
+        // Optional lobes.
+        enum Lobes
+        {
+            SheenLobe       = 1 << 0,
+            ClearcoatLobe   = 1 << 1
+        };
+
+        int m_lobes;
+
+        // Return true if the lobe weighted by a given input may contribute.
+        bool is_lobe_active(const char* input_name) const
+        {
+            // The lobe may be explicitly enabled or disabled by the parameter
+            // "<input_name>_lobe", for instance when the inputs are not used.
+            const string param_name = string(input_name) + "_lobe";
+            const string lobe = m_params.get_optional<string>(param_name.c_str(), "auto");
+
+            if (lobe == "enabled")
+                return true;
+
+            if (lobe == "disabled")
+                return false;
+
+            // Otherwise the lobe is only disabled if its weight is uniformly zero.
+            const Source* source = m_inputs.source(input_name);
+            if (source == 0 || !source->is_uniform())
+                return true;
+
+            float weight;
+            source->evaluate_uniform(weight);
+            return weight != 0.0f;
+        }
+
+        template <bool HasSheen, bool HasClearcoat>
+        void do_sample(
+            SamplingContext&        sampling_context,
+            const void*             data,
+            const bool              adjoint,
+            const bool              cosine_mult,
+            BSDFSample&             sample) const
         {
             // No reflection below the shading surface.
             const Vector3f& n = sample.m_shading_basis.get_normal();
@@ -401,7 +546,7 @@ namespace
             const InputValues* values = static_cast<const InputValues*>(data);
 
             float cdf[NumComponents];
-            compute_component_cdf(values, cdf);
+            compute_component_cdf<HasSheen, HasClearcoat>(values, cdf);
 
             // Choose which of the components to sample.
             sampling_context.split_in_place(1, 1);
@@ -414,7 +559,7 @@ namespace
                     values,
                     sample);
             }
-            else if (s < cdf[SheenComponent])
+            else if (HasSheen && s < cdf[SheenComponent])
             {
                 DisneySheenComponent().sample(
                     sampling_context,
@@ -423,7 +568,7 @@ namespace
             }
             else
             {
-                if (s < cdf[SpecularComponent])
+                if (!HasClearcoat || s < cdf[SpecularComponent])
                 {
                     float alpha_x, alpha_y;
                     microfacet_alpha_from_roughness(
@@ -458,7 +603,8 @@ namespace
             }
         }
 
-        virtual float evaluate(
+        template <bool HasSheen, bool HasClearcoat>
+        float do_evaluate(
             const void*             data,
             const bool              adjoint,
             const bool              cosine_mult,
@@ -467,7 +613,7 @@ namespace
             const Vector3f&         outgoing,
             const Vector3f&         incoming,
             const int               modes,
-            Spectrum&               value) const APPLESEED_OVERRIDE
+            Spectrum&               value) const
         {
             // No reflection below the shading surface.
             const Vector3f& n = shading_basis.get_normal();
@@ -479,7 +625,7 @@ namespace
             const InputValues* values = static_cast<const InputValues*>(data);
 
             float weights[NumComponents];
-            compute_component_weights(values, weights);
+            compute_component_weights<HasSheen, HasClearcoat>(values, weights);
 
             value.set(0.0f);
             float pdf = 0.0f;
@@ -496,7 +642,7 @@ namespace
                         value) * weights[DiffuseComponent];
                 }
 
-                if (weights[SheenComponent] != 0.0f)
+                if (HasSheen && weights[SheenComponent] != 0.0f)
                 {
                     Spectrum sheen;
                     pdf += DisneySheenComponent().evaluate(
@@ -536,7 +682,7 @@ namespace
                     value += spec;
                 }
 
-                if (weights[CleatcoatComponent] != 0.0f)
+                if (HasClearcoat && weights[CleatcoatComponent] != 0.0f)
                 {
                     Spectrum clear;
                     const float alpha = clearcoat_roughness(values);
@@ -559,13 +705,14 @@ namespace
             return pdf;
         }
 
-        virtual float evaluate_pdf(
+        template <bool HasSheen, bool HasClearcoat>
+        float do_evaluate_pdf(
             const void*             data,
             const Vector3f&         geometric_normal,
             const Basis3f&          shading_basis,
             const Vector3f&         outgoing,
             const Vector3f&         incoming,
-            const int               modes) const APPLESEED_OVERRIDE
+            const int               modes) const
         {
             // No reflection below the shading surface.
             const Vector3f& n = shading_basis.get_normal();
@@ -577,7 +724,7 @@ namespace
             const InputValues* values = static_cast<const InputValues*>(data);
 
             float weights[NumComponents];
-            compute_component_weights(values, weights);
+            compute_component_weights<HasSheen, HasClearcoat>(values, weights);
 
             float pdf = 0.0f;
 
@@ -590,7 +737,7 @@ namespace
                         incoming) * weights[DiffuseComponent];
                 }
 
-                if (weights[SheenComponent] != 0.0f)
+                if (HasSheen && weights[SheenComponent] != 0.0f)
                 {
                     pdf += DisneySheenComponent().evaluate_pdf(
                         shading_basis,
@@ -619,7 +766,7 @@ namespace
                         incoming) * weights[SpecularComponent];
                 }
 
-                if (weights[CleatcoatComponent] != 0.0f)
+                if (HasClearcoat && weights[CleatcoatComponent] != 0.0f)
                 {
                     const float alpha = clearcoat_roughness(values);
                     const GTR1MDF gtr1_mdf;
@@ -636,17 +783,16 @@ namespace
             return pdf;
         }
 
-      private:
-        typedef DisneyBRDFInputValues InputValues;
 
+        template <bool HasSheen, bool HasClearcoat>
         static void compute_component_weights(
             const InputValues*      values,
             float                   weights[NumComponents])
         {
             weights[DiffuseComponent] = lerp(values->m_precomputed.m_base_color_luminance, 0.0f, values->m_metallic);
-            weights[SheenComponent] = lerp(values->m_sheen, 0.0f, values->m_metallic);
+            weights[SheenComponent] = HasSheen ? lerp(values->m_sheen, 0.0f, values->m_metallic) : 0.0f;
             weights[SpecularComponent] = lerp(values->m_specular, 1.0f, values->m_metallic);
-            weights[CleatcoatComponent] = values->m_clearcoat * 0.25f;
+            weights[CleatcoatComponent] = HasClearcoat ? values->m_clearcoat * 0.25f : 0.0f;
 
             const float total_weight =
                 weights[DiffuseComponent] +
@@ -664,11 +810,12 @@ namespace
             weights[CleatcoatComponent] *= total_weight_rcp;
         }
 
+        template <bool HasSheen, bool HasClearcoat>
         static void compute_component_cdf(
             const InputValues*      values,
             float                   cdf[NumComponents])
         {
-            compute_component_weights(values, cdf);
+            compute_component_weights<HasSheen, HasClearcoat>(values, cdf);
             cdf[SheenComponent] += cdf[DiffuseComponent];
             cdf[SpecularComponent] += cdf[SheenComponent];
             cdf[CleatcoatComponent] += cdf[SpecularComponent];
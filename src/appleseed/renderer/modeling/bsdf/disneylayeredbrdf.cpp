@@ -91,6 +91,20 @@ bool DisneyLayeredBRDF::on_frame_begin(
     if (!BSDF::on_frame_begin(project, parent, recorder, abort_switch))
         return false;
 
+    // Let the Disney BRDF skip the lobes that are inactive in all layers.
+    bool has_sheen = false;
+    bool has_clearcoat = false;
+    for (size_t i = 0, e = m_parent->get_layer_count(); i < e; ++i)
+    {
+        const DisneyMaterialLayer& layer = m_parent->get_layer(i);
+        has_sheen = has_sheen || layer.has_sheen();
+        has_clearcoat = has_clearcoat || layer.has_clearcoat();
+    }
+
+    m_brdf->get_parameters()
+        .insert("sheen_lobe", has_sheen ? "enabled" : "disabled")
+        .insert("clearcoat_lobe", has_clearcoat ? "enabled" : "disabled");
+
     if (!m_brdf->on_frame_begin(project, parent, recorder, abort_switch))
         return false;
 
@@ -95,12 +95,14 @@ namespace
             const char*             name,
             const ParamArray&       params)
           : BSDF(name, Reflective, ScatteringMode::Glossy | ScatteringMode::Specular, params)
+          , m_albedo_table(0)
         {
             m_inputs.declare("reflectance", InputFormatSpectralReflectance);
             m_inputs.declare("reflectance_multiplier", InputFormatFloat, "1.0");
             m_inputs.declare("roughness", InputFormatFloat, "0.15");
             m_inputs.declare("anisotropy", InputFormatFloat, "0.0");
             m_inputs.declare("ior", InputFormatFloat, "1.5");
+            m_inputs.declare("energy_compensation", InputFormatFloat, "0.0");
         }
 
         virtual void release() APPLESEED_OVERRIDE
@@ -145,12 +147,22 @@ namespace
                     make_vector("beckmann", "ggx", "blinn"),
                     context);
 
+            // Energy compensation is not supported by the Blinn MDF.
             if (mdf == "ggx")
+            {
                 m_mdf.reset(new GGXMDF());
+                m_albedo_table = &get_ggx_albedo_table();
+            }
             else if (mdf == "beckmann")
+            {
                 m_mdf.reset(new BeckmannMDF());
+                m_albedo_table = &get_beckmann_albedo_table();
+            }
             else if (mdf == "blinn")
+            {
                 m_mdf.reset(new BlinnMDF());
+                m_albedo_table = 0;
+            }
             else return false;
 
             return true;
@@ -198,6 +210,14 @@ namespace
                 f,
                 cos_on,
                 sample);
+
+            if (sample.m_mode != ScatteringMode::Absorption &&
+                m_albedo_table &&
+                values->m_energy_compensation > 0.0f)
+            {
+                const float cos_in = dot(sample.m_incoming.get_value(), n);
+                add_energy_compensation_term(values, alpha_x, alpha_y, cos_in, cos_on, sample.m_value);
+            }
         }
 
         virtual float evaluate(
@@ -235,17 +255,23 @@ namespace
                 values->m_reflectance_multiplier,
                 values->m_precomputed.m_outside_ior / values->m_ior);
 
-            return MicrofacetBRDFHelper::evaluate(
-                *m_mdf,
-                alpha_x,
-                alpha_y,
-                shading_basis,
-                outgoing,
-                incoming,
-                f,
-                cos_in,
-                cos_on,
-                value);
+            const float pdf =
+                MicrofacetBRDFHelper::evaluate(
+                    *m_mdf,
+                    alpha_x,
+                    alpha_y,
+                    shading_basis,
+                    outgoing,
+                    incoming,
+                    f,
+                    cos_in,
+                    cos_on,
+                    value);
+
+            if (m_albedo_table && values->m_energy_compensation > 0.0f)
+                add_energy_compensation_term(values, alpha_x, alpha_y, cos_in, cos_on, value);
+
+            return pdf;
         }
 
         virtual float evaluate_pdf(
@@ -287,7 +313,29 @@ namespace
       private:
         typedef GlossyBRDFInputValues InputValues;
 
-        auto_ptr<MDF> m_mdf;
+        auto_ptr<MDF>               m_mdf;
+        const MDFAlbedoTable*       m_albedo_table;
+
+        void add_energy_compensation_term(
+            const InputValues*      values,
+            const float             alpha_x,
+            const float             alpha_y,
+            const float             cos_in,
+            const float             cos_on,
+            Spectrum&               value) const
+        {
+            Spectrum albedo(values->m_reflectance);
+            albedo *= values->m_reflectance_multiplier * values->m_energy_compensation;
+
+            MicrofacetBRDFHelper::add_energy_compensation_term(
+                *m_albedo_table,
+                alpha_x,
+                alpha_y,
+                albedo,
+                cos_in,
+                cos_on,
+                value);
+        }
     };
 
     typedef BSDFWrapper<GlossyBRDFImpl> GlossyBRDF;
@@ -387,6 +435,16 @@ DictionaryArray GlossyBRDFFactory::get_input_metadata() const
             .insert("use", "required")
             .insert("default", "1.5"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "energy_compensation")
+            .insert("label", "Energy Compensation")
+            .insert("type", "numeric")
+            .insert("min_value", "0.0")
+            .insert("max_value", "1.0")
+            .insert("use", "optional")
+            .insert("default", "0.0"));
+
     return metadata;
 }
 
@@ -61,6 +61,7 @@ APPLESEED_DECLARE_INPUT_VALUES(GlossyBRDFInputValues)
     float       m_roughness;
     float       m_anisotropy;
     float       m_ior;
+    float       m_energy_compensation;
 
     struct Precomputed
     {
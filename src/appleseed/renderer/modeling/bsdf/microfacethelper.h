@@ -38,6 +38,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/basis.h"
+#include "foundation/math/microfacet.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
 
@@ -78,6 +79,16 @@ inline void microfacet_alpha_from_roughness(
     }
 }
 
+
+//
+// Directional albedo tables of the microfacet distribution functions that support
+// energy compensation. The tables are built on first use, which is not thread-safe:
+// make sure they are first accessed from a single thread (e.g. in on_frame_begin()).
+//
+
+const foundation::MDFAlbedoTable& get_beckmann_albedo_table();
+const foundation::MDFAlbedoTable& get_ggx_albedo_table();
+
 class MicrofacetBRDFHelper
 {
   public:
@@ -155,6 +166,30 @@ class MicrofacetBRDFHelper
         return mdf.pdf(wo, m, alpha_x, alpha_y) / (4.0f * cos_oh);
     }
 
+    // Add to 'value' the energy lost by single scattering, scaled by 'albedo'.
+    // The lost energy is reintroduced as a diffuse-like lobe.
+    static void add_energy_compensation_term(
+        const foundation::MDFAlbedoTable&   albedo_table,
+        const float                         alpha_x,
+        const float                         alpha_y,
+        const Spectrum&                     albedo,
+        const float                         cos_in,
+        const float                         cos_on,
+        Spectrum&                           value)
+    {
+        const float alpha = std::sqrt(alpha_x * alpha_y);
+        const float avg_albedo = albedo_table.get_average_albedo(alpha);
+        if (avg_albedo >= 1.0f)
+            return;
+
+        const float ms =
+              (1.0f - albedo_table.get_directional_albedo(cos_in, alpha))
+            * (1.0f - albedo_table.get_directional_albedo(cos_on, alpha))
+            / (foundation::Pi<float>() * (1.0f - avg_albedo));
+
+        madd(value, albedo, ms);
+    }
+
     template <typename MDF>
     static float pdf(
         const MDF&                      mdf,
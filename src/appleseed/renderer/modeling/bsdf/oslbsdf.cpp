@@ -89,8 +89,14 @@ namespace
 
             m_diffuse_btdf = create_and_register_diffuse_btdf();
 
+            // The inputs of the Disney BRDF are provided by OSL closures: keep all lobes enabled.
             m_disney_brdf =
-                create_and_register_bsdf(DisneyID, "disney_brdf");
+                create_and_register_bsdf(
+                    DisneyID,
+                    "disney_brdf",
+                    ParamArray()
+                        .insert("sheen_lobe", "enabled")
+                        .insert("clearcoat_lobe", "enabled"));
 
             m_glass_ggx_bsdf =
                 create_and_register_glass_bsdf(GlassGGXID, "ggx");
@@ -354,10 +360,11 @@ namespace
 
         auto_release_ptr<BSDF> create_and_register_bsdf(
             const ClosureID         cid,
-            const char*             model)
+            const char*             model,
+            const ParamArray&       params = ParamArray())
         {
             auto_release_ptr<BSDF> bsdf =
-                BSDFFactoryRegistrar().lookup(model)->create(model, ParamArray());
+                BSDFFactoryRegistrar().lookup(model)->create(model, params);
 
             m_all_bsdfs[cid] = bsdf.get();
             return bsdf;
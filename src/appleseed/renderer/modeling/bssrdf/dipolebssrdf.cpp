@@ -236,6 +236,18 @@ DictionaryArray DipoleBSSRDFFactory::get_input_metadata() const
             .insert("use", "optional")
             .insert("default", "1.0"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "probe_mode")
+            .insert("label", "Probe Mode")
+            .insert("type", "enumeration")
+            .insert("items",
+                Dictionary()
+                    .insert("Single Axis", "single_axis")
+                    .insert("All Axes", "all_axes"))
+            .insert("use", "optional")
+            .insert("default", "single_axis"));
+
     return metadata;
 }
 
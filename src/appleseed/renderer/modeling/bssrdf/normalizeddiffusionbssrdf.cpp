@@ -187,7 +187,7 @@ namespace
             const float l = values->m_mfp[channel];
             const float s = values->m_precomputed.m_s[channel];
 
-            return normalized_diffusion_sample(u, l, s);
+            return normalized_diffusion_sample_tabulated(u, l, s);
         }
 
         virtual float evaluate_profile_pdf(
@@ -358,6 +358,18 @@ DictionaryArray NormalizedDiffusionBSSRDFFactory::get_input_metadata() const
             .insert("use", "optional")
             .insert("default", "1.0"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "probe_mode")
+            .insert("label", "Probe Mode")
+            .insert("type", "enumeration")
+            .insert("items",
+                Dictionary()
+                    .insert("Single Axis", "single_axis")
+                    .insert("All Axes", "all_axes"))
+            .insert("use", "optional")
+            .insert("default", "single_axis"));
+
     return metadata;
 }
 
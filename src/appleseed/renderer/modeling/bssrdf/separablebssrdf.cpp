@@ -39,6 +39,7 @@
 #include "renderer/modeling/bssrdf/bssrdfsample.h"
 #include "renderer/modeling/scene/objectinstance.h"
 #include "renderer/modeling/scene/visibilityflags.h"
+#include "renderer/utility/messagecontext.h"
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
@@ -49,8 +50,10 @@
 #include "foundation/math/mis.h"
 #include "foundation/math/scalar.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/utility/makevector.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <string>
@@ -161,6 +164,94 @@ namespace
         return -1.0f;
     }
 
+    // Build a probe ray inscribed inside the sphere around the sampling disk,
+    // going through a given point of the disk along the normal of a given basis.
+    ShadingRay make_probe_ray(
+        const ShadingPoint&     outgoing_point,
+        const Basis3d&          projection_basis,
+        const Vector2f&         disk_point,
+        const float             h)
+    {
+        const Vector3d hn = static_cast<double>(h) * projection_basis.get_normal();
+
+        // Compute sphere entry point.
+        Vector3d entry_point = outgoing_point.get_point();
+        entry_point += static_cast<double>(disk_point[0]) * projection_basis.get_tangent_u();
+        entry_point += static_cast<double>(disk_point[1]) * projection_basis.get_tangent_v();
+        entry_point += hn;
+
+        return
+            ShadingRay(
+                entry_point,
+                -projection_basis.get_normal(),
+                0.0,
+                2.0 * h,
+                outgoing_point.get_time(),
+                VisibilityFlags::ProbeRay,
+                outgoing_point.get_ray().m_depth + 1);
+    }
+
+    // Trace a probe ray and store all valid incoming points found inside the sphere.
+    // If 'first_hit' is not null, it holds the result of tracing the probe ray once.
+    // Return the number of incoming points found.
+    size_t trace_probe_ray(
+        const ShadingContext&   shading_context,
+        const ShadingPoint&     outgoing_point,
+        ShadingRay&             probe_ray,
+        const ShadingPoint*     first_hit,
+        ShadingPoint            shading_points[],
+        const size_t            max_sample_count)
+    {
+        const Vector3d exit_point = probe_ray.point_at(probe_ray.m_tmax);
+
+        const UniqueID outgoing_obj_inst_uid = outgoing_point.get_object_instance().get_uid();
+        const Material* outgoing_material = outgoing_point.get_material();
+
+        const size_t MaxIterations = 16;
+        size_t sample_count = 0;
+
+        for (size_t i = 0; sample_count < max_sample_count && i < MaxIterations; ++i)
+        {
+            // Continue tracing the ray.
+            ShadingPoint& incoming_point = shading_points[sample_count];
+            if (i == 0 && first_hit)
+            {
+                if (!first_hit->hit())
+                    break;
+                incoming_point = *first_hit;
+            }
+            else if (!shading_context.get_intersector().trace(probe_ray, incoming_point))
+                break;
+
+            // Move the ray's origin past the hit surface.
+            probe_ray.m_org = incoming_point.get_point();
+            probe_ray.m_tmin = 1.0e-6;
+            probe_ray.m_tmax = norm(exit_point - probe_ray.m_org);
+
+            // Only consider incoming points on the same object instance,
+            // and with the same material as the outgoing point.
+            if (incoming_point.get_object_instance().get_uid() == outgoing_obj_inst_uid &&
+                (incoming_point.get_material() == outgoing_material ||
+                 incoming_point.get_opposite_material() == outgoing_material))
+            {
+                // Make sure the incoming point is on the front side of the surface.
+                // There is no such thing as subsurface scattering seen "from the inside".
+                if (incoming_point.get_side() == ObjectInstance::BackSide)
+                    incoming_point.flip_side();
+
+                // Update the number of found incoming points. This invalidates 'incoming_point'.
+                ++sample_count;
+            }
+            else
+            {
+                // Reset the shading point before it gets reused in the next iteration.
+                incoming_point.clear();
+            }
+        }
+
+        return sample_count;
+    }
+
     bool find_incoming_point(
         const ShadingContext&   shading_context,
         SamplingContext&        sampling_context,
@@ -203,69 +294,19 @@ namespace
         // Compute the height of the point on the hemisphere above the sampling disk.
         assert(disk_radius <= max_disk_radius);
         const float h = sqrt(square(max_disk_radius) - square(disk_radius));
-        const Vector3d hn = static_cast<double>(h) * projection_basis.get_normal();
-
-        // Compute sphere entry and exit points.
-        Vector3d entry_point, exit_point;
-        entry_point = outgoing_point.get_point();
-        entry_point += static_cast<double>(disk_point[0]) * projection_basis.get_tangent_u();
-        entry_point += static_cast<double>(disk_point[1]) * projection_basis.get_tangent_v();
-        exit_point = entry_point;
-        entry_point += hn;
-        exit_point -= hn;
-        assert(feq(norm(exit_point - entry_point), 2.0 * h, 1.0e-6));
-
-        // Build a probe ray inscribed inside the sphere around the sampling disk.
-        ShadingRay probe_ray(
-            entry_point,
-            -projection_basis.get_normal(),
-            0.0,
-            2.0 * h,
-            outgoing_point.get_time(),
-            VisibilityFlags::ProbeRay,
-            outgoing_point.get_ray().m_depth + 1);
-
-        const UniqueID outgoing_obj_inst_uid = outgoing_point.get_object_instance().get_uid();
-        const Material* outgoing_material = outgoing_point.get_material();
 
-        const size_t MaxIterations = 16;
+        // Trace the probe ray and store all intersections found inside the sphere.
+        ShadingRay probe_ray = make_probe_ray(outgoing_point, projection_basis, disk_point, h);
         const size_t MaxSampleCount = 16;
         ShadingPoint shading_points[MaxSampleCount];
-        size_t sample_count = 0;
-
-        // Trace the ray and store all intersections found inside the sphere.
-        for (size_t i = 0; sample_count < MaxSampleCount && i < MaxIterations; ++i)
-        {
-            // Continue tracing the ray.
-            ShadingPoint& incoming_point = shading_points[sample_count];
-            if (!shading_context.get_intersector().trace(probe_ray, incoming_point))
-                break;
-
-            // Move the ray's origin past the hit surface.
-            probe_ray.m_org = incoming_point.get_point();
-            probe_ray.m_tmin = 1.0e-6;
-            probe_ray.m_tmax = norm(exit_point - probe_ray.m_org);
-
-            // Only consider incoming points on the same object instance,
-            // and with the same material as the outgoing point.
-            if (incoming_point.get_object_instance().get_uid() == outgoing_obj_inst_uid &&
-                (incoming_point.get_material() == outgoing_material ||
-                 incoming_point.get_opposite_material() == outgoing_material))
-            {
-                // Make sure the incoming point is on the front side of the surface.
-                // There is no such thing as subsurface scattering seen "from the inside".
-                if (incoming_point.get_side() == ObjectInstance::BackSide)
-                    incoming_point.flip_side();
-
-                // Update the number of found incoming points. This invalidates 'incoming_point'.
-                ++sample_count;
-            }
-            else
-            {
-                // Reset the shading point before it gets reused in the next iteration.
-                incoming_point.clear();
-            }
-        }
+        const size_t sample_count =
+            trace_probe_ray(
+                shading_context,
+                outgoing_point,
+                probe_ray,
+                0,
+                shading_points,
+                MaxSampleCount);
 
         // Bail out if no incoming point could be found.
         if (sample_count == 0)
@@ -310,6 +351,139 @@ namespace
 
         return true;
     }
+
+    //
+    // Variant of find_incoming_point() that traces the probe rays of all three projection
+    // axes together, then chooses one incoming point among all those found along them.
+    //
+    // Each axis acts as a separate technique taking one sample, so the contribution of
+    // an incoming point found along axis a is weighted by w_a / p_a where p_a is its PDF
+    // along axis a and w_a its MIS weight computed with the usual axis probabilities.
+    // Since no probe ray is thrown away, far fewer paths get terminated on thin or
+    // curved geometry where the probe ray along N misses.
+    //
+
+    bool find_incoming_point_all_axes(
+        const ShadingContext&   shading_context,
+        SamplingContext&        sampling_context,
+        const ShadingPoint&     outgoing_point,
+        const SeparableBSSRDF&  bssrdf,
+        const void*             bssrdf_data,
+        const float             max_disk_radius,
+        const size_t            channel,
+        ShadingPoint&           incoming_point,
+        float&                  incoming_point_prob)
+    {
+        sampling_context.split_in_place(2, 1);
+        const Vector2f u = sampling_context.next2<Vector2f>();
+
+        // Sample a radius.
+        const float disk_radius = bssrdf.sample_profile(bssrdf_data, channel, u[0]);
+
+        // Reject points outside the sampling disk.
+        // This introduces negligible bias in comparison to the other approximations.
+        if (disk_radius > max_disk_radius)
+            return false;
+
+        // Compute the position of the point on the disk.
+        const float phi = TwoPi<float>() * u[1];
+        const Vector2f disk_point(disk_radius * cos(phi), disk_radius * sin(phi));
+        const float disk_point_prob = bssrdf.evaluate_profile_pdf(bssrdf_data, disk_radius);
+        assert(disk_point_prob > 0.0f);
+
+        // Compute the height of the point on the hemisphere above the sampling disk.
+        assert(disk_radius <= max_disk_radius);
+        const float h = sqrt(square(max_disk_radius) - square(disk_radius));
+
+        // Build the probe rays of the three projection axes.
+        const size_t AxisCount = 3;
+        const Axis axes[AxisCount] = { NAxis, UAxis, VAxis };
+        const float axis_probs[AxisCount] = { ProbNAxis, ProbUAxis, ProbVAxis };
+        Basis3d bases[AxisCount];
+        ShadingRay probe_rays[AxisCount];
+        for (size_t a = 0; a < AxisCount; ++a)
+        {
+            float axis_prob;
+            Axis axis;
+            pick_projection_axis(
+                outgoing_point.get_shading_basis(),
+                a == 0 ? 0.0f : a == 1 ? ProbNAxis : ProbNAxis + ProbUAxis,
+                axis,
+                axis_prob,
+                bases[a]);
+            assert(axis == axes[a]);
+
+            probe_rays[a] = make_probe_ray(outgoing_point, bases[a], disk_point, h);
+        }
+
+        // Find the first intersection of all probe rays at once.
+        ShadingPoint first_hits[AxisCount];
+        shading_context.get_intersector().trace(probe_rays, AxisCount, first_hits);
+
+        // Store all intersections found inside the sphere along each probe ray.
+        const size_t MaxSampleCountPerAxis = 8;
+        ShadingPoint shading_points[AxisCount * MaxSampleCountPerAxis];
+        size_t sample_counts[AxisCount];
+        size_t total_sample_count = 0;
+        for (size_t a = 0; a < AxisCount; ++a)
+        {
+            sample_counts[a] =
+                trace_probe_ray(
+                    shading_context,
+                    outgoing_point,
+                    probe_rays[a],
+                    &first_hits[a],
+                    shading_points + a * MaxSampleCountPerAxis,
+                    MaxSampleCountPerAxis);
+            total_sample_count += sample_counts[a];
+        }
+
+        // Bail out if no incoming point could be found.
+        if (total_sample_count == 0)
+            return false;
+
+        // Choose one incoming point among all those found.
+        size_t i = 0;
+        if (total_sample_count > 1)
+        {
+            sampling_context.split_in_place(1, 1);
+            const float s = sampling_context.next2<float>();
+            i = min(truncate<size_t>(s * total_sample_count), total_sample_count - 1);
+        }
+
+        // Find the axis along which this incoming point was found.
+        size_t a = 0;
+        while (i >= sample_counts[a])
+            i -= sample_counts[a++];
+        assert(a < AxisCount);
+
+        incoming_point = shading_points[a * MaxSampleCountPerAxis + i];
+
+        // Compute the PDF of this incoming point along its axis.
+        const float dot_nn = static_cast<float>(
+            abs(dot(bases[a].get_normal(), incoming_point.get_shading_normal())));
+        incoming_point_prob = disk_point_prob * dot_nn;
+
+        // Weight the sample contribution with multiple importance sampling.
+        const float mis_weight =
+            compute_mis_weight(
+                bssrdf,
+                bssrdf_data,
+                bases[a],
+                axes[a],
+                axis_probs[a] * incoming_point_prob,
+                outgoing_point.get_point(),
+                incoming_point.get_point(),
+                incoming_point.get_shading_normal());
+
+        // Multiplying the contribution by mis_weight is equivalent to dividing the probability by it.
+        incoming_point_prob /= mis_weight;
+
+        // Account for the probability of choosing this incoming point among those found.
+        incoming_point_prob /= total_sample_count;
+
+        return true;
+    }
 }
 
 SeparableBSSRDF::SeparableBSSRDF(
@@ -321,6 +495,14 @@ SeparableBSSRDF::SeparableBSSRDF(
     m_brdf = LambertianBRDFFactory::static_create(brdf_name.c_str(), ParamArray()).release();
     m_brdf_data.m_reflectance.set(1.0f);
     m_brdf_data.m_reflectance_multiplier = 1.0f;
+
+    const EntityDefMessageContext context("bssrdf", this);
+    m_probe_all_axes =
+        params.get_optional<string>(
+            "probe_mode",
+            "single_axis",
+            make_vector("single_axis", "all_axes"),
+            context) == "all_axes";
 }
 
 SeparableBSSRDF::~SeparableBSSRDF()
@@ -350,7 +532,7 @@ bool SeparableBSSRDF::do_sample(
             sampling_context.next2<float>());
 
     // Find an incoming point.
-    if (!find_incoming_point(
+    if (!(m_probe_all_axes ? find_incoming_point_all_axes : find_incoming_point)(
             shading_context,
             sampling_context,
             outgoing_point,
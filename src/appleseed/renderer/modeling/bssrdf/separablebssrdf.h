@@ -105,6 +105,9 @@ class APPLESEED_DLLSYMBOL SeparableBSSRDF
     const BSDF*                     m_brdf;
     LambertianBRDFInputValues       m_brdf_data;
 
+    // Whether probe rays are traced along all three projection axes instead of a single one.
+    bool                            m_probe_all_axes;
+
     // Implementation of the BSSRDF::sample() method.
     bool do_sample(
         const ShadingContext&       shading_context,
@@ -36,6 +36,7 @@
 #include "foundation/math/scalar.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cmath>
 
 using namespace foundation;
@@ -248,6 +249,61 @@ namespace
             return normalized_diffusion_pdf(r, m_d);
         }
     };
+
+    //
+    // Inverse of cdf(r, 1), tabulated as a function of t = -ln(1 - u).
+    //
+    // Since 1 - cdf(r, 1) = 0.25 * exp(-r) + 0.75 * exp(-r / 3), r(t) is a smooth,
+    // nearly linear function whose slope goes from 2 at t = 0 to 3 as t grows,
+    // which makes linear interpolation in t very accurate, including in the tail.
+    //
+
+    const size_t NDInvCDFTableSize = 256;
+
+    float nd_inv_cdf_table[NDInvCDFTableSize];
+    float nd_inv_cdf_tmax;
+    float nd_inv_cdf_rcp_step;
+
+    double nd_tail(const double r)
+    {
+        return 0.25 * exp(-r) + 0.75 * exp(-r / 3.0);
+    }
+
+    struct InitializeNDInvCDFTable
+    {
+        InitializeNDInvCDFTable()
+        {
+            const double tmax = -log(nd_tail(NDCDFTableRmax));
+
+            for (size_t i = 0; i < NDInvCDFTableSize; ++i)
+            {
+                const double t = fit<size_t, double>(i, 0, NDInvCDFTableSize - 1, 0.0, tmax);
+
+                // Solve ln(tail(r)) + t = 0 using Newton's method; the function is
+                // monotonic and its derivative is bounded by -1 and -1/3.
+                double r = 2.0 * t;
+                for (size_t j = 0; j < 32; ++j)
+                {
+                    const double e1 = 0.25 * exp(-r);
+                    const double e3 = 0.75 * exp(-r / 3.0);
+                    const double f = log(e1 + e3) + t;
+                    const double df = -(e1 + e3 / 3.0) / (e1 + e3);
+                    r -= f / df;
+                }
+
+                nd_inv_cdf_table[i] = static_cast<float>(r);
+            }
+
+            // Make sure the table spans exactly [0, Rmax].
+            nd_inv_cdf_table[0] = 0.0f;
+            nd_inv_cdf_table[NDInvCDFTableSize - 1] = NDCDFTableRmax;
+
+            nd_inv_cdf_tmax = static_cast<float>(tmax);
+            nd_inv_cdf_rcp_step = static_cast<float>((NDInvCDFTableSize - 1) / tmax);
+        }
+    };
+
+    InitializeNDInvCDFTable initialize_nd_inv_cdf_table;
 }
 
 float normalized_diffusion_sample(
@@ -287,6 +343,27 @@ float normalized_diffusion_sample(
         max_iterations);
 }
 
+float normalized_diffusion_sample_tabulated(
+    const float     u,
+    const float     l,
+    const float     s)
+{
+    assert(u >= 0.0f);
+    assert(u < 1.0f);
+
+    const float d = l / s;
+    const float t = -log(1.0f - u);
+
+    if (t >= nd_inv_cdf_tmax)
+        return NDCDFTableRmax * d;
+
+    const float x = t * nd_inv_cdf_rcp_step;
+    const size_t i = min(truncate<size_t>(x), NDInvCDFTableSize - 2);
+    const float k = x - static_cast<float>(i);
+
+    return lerp(nd_inv_cdf_table[i], nd_inv_cdf_table[i + 1], k) * d;
+}
+
 float normalized_diffusion_cdf(
     const float     r,
     const float     d)
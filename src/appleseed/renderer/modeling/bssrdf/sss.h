@@ -174,6 +174,15 @@ float normalized_diffusion_sample(
     const float         eps = 0.0001f,          // root precision
     const size_t        max_iterations = 10);   // max root refinement iterations
 
+// Sample the function r * R(r) using a precomputed table of its inverse CDF.
+// Much cheaper than normalized_diffusion_sample() since no root finding is involved.
+// Since R(r) only depends on r / d, a single table serves all parameter sets,
+// including textured ones.
+float normalized_diffusion_sample_tabulated(
+    const float         u,                      // uniform random sample in [0,1)
+    const float         l,                      // mean free path length or diffuse mean free path length
+    const float         s);                     // scaling factor
+
 // Evaluate the cumulative distribution function of r * R(r).
 float normalized_diffusion_cdf(
     const float         r,                      // radius
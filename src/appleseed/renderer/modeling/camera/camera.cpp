@@ -107,6 +107,16 @@ bool Camera::on_frame_begin(
     return true;
 }
 
+void Camera::spawn_rays(
+    SamplingContext* const  sampling_contexts[],
+    const Dual2d            ndc[],
+    ShadingRay              rays[],
+    const size_t            count) const
+{
+    for (size_t i = 0; i < count; ++i)
+        spawn_ray(*sampling_contexts[i], ndc[i], rays[i]);
+}
+
 bool Camera::project_point(
     const float             time,
     const Vector3d&         point,
@@ -122,6 +132,11 @@ bool Camera::project_point(
     return project_camera_space_point(point_camera, ndc);
 }
 
+bool Camera::get_view_frustum(Frustum<double, 4>& frustum) const
+{
+    return false;
+}
+
 Vector2d Camera::extract_film_dimensions() const
 {
     const Vector2d DefaultFilmDimensions(0.025, 0.025);     // in meters
@@ -37,6 +37,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/dual.h"
+#include "foundation/math/frustum.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/utility/uid.h"
@@ -44,6 +45,9 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace foundation    { class DictionaryArray; }
 namespace foundation    { class IAbortSwitch; }
@@ -118,6 +122,15 @@ class APPLESEED_DLLSYMBOL Camera
         const foundation::Dual2d&       ndc,
         ShadingRay&                     ray) const = 0;
 
+    // Generate a batch of rays at once, one per film point. The i'th ray uses the
+    // i'th sampling context. The default implementation calls spawn_ray() for each
+    // film point; cameras may override it to amortize per-ray work over the batch.
+    virtual void spawn_rays(
+        SamplingContext* const          sampling_contexts[],
+        const foundation::Dual2d        ndc[],
+        ShadingRay                      rays[],
+        const size_t                    count) const;
+
     // Connect a vertex to the camera and return the direction vector from the
     // point to the camera, the normalized device coordinates of the projected
     // point on the camera film and the emitted importance. The direction vector
@@ -155,6 +168,11 @@ class APPLESEED_DLLSYMBOL Camera
         foundation::Vector2d&           a_ndc,
         foundation::Vector2d&           b_ndc) const = 0;
 
+    // Compute a world space frustum enclosing all the rays spawned by the camera during the
+    // current frame. Returns false if the camera cannot provide one, which is what the default
+    // implementation does. This method can only be called after on_frame_begin().
+    virtual bool get_view_frustum(foundation::Frustum<double, 4>& frustum) const;
+
   protected:
     TransformSequence   m_transform_sequence;
     float               m_shutter_open_time;
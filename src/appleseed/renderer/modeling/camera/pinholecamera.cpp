@@ -107,6 +107,7 @@ namespace
             const char*         name,
             const ParamArray&   params)
           : Camera(name, params)
+          , m_is_static(false)
         {
         }
 
@@ -149,6 +150,29 @@ namespace
             return true;
         }
 
+        virtual bool on_frame_begin(
+            const Project&          project,
+            const BaseGroup*        parent,
+            OnFrameBeginRecorder&   recorder,
+            IAbortSwitch*           abort_switch) APPLESEED_OVERRIDE
+        {
+            if (!Camera::on_frame_begin(project, parent, recorder, abort_switch))
+                return false;
+
+            // A static camera maps film points to world space directions with a fixed affine map.
+            m_is_static = m_transform_sequence.size() <= 1;
+            if (m_is_static)
+            {
+                const Transformd transform = m_transform_sequence.evaluate(m_shutter_open_time);
+                m_static_org = transform.get_local_to_parent().extract_translation();
+                m_static_dir = transform.vector_to_parent(-ndc_to_camera(Vector2d(0.0, 0.0)));
+                m_static_dir_dx = transform.vector_to_parent(Vector3d(m_film_dimensions[0], 0.0, 0.0));
+                m_static_dir_dy = transform.vector_to_parent(Vector3d(0.0, -m_film_dimensions[1], 0.0));
+            }
+
+            return true;
+        }
+
         virtual void spawn_ray(
             SamplingContext&    sampling_context,
             const Dual2d&       ndc,
@@ -164,6 +188,12 @@ namespace
             // Initialize the ray.
             initialize_ray(sampling_context, ray);
 
+            if (m_is_static)
+            {
+                set_static_ray_geometry(ndc, ray);
+                return;
+            }
+
             // Retrieve the camera transform.
             Transformd scratch;
             const Transformd& transform =
@@ -186,6 +216,27 @@ namespace
             }
         }
 
+        virtual void spawn_rays(
+            SamplingContext* const  sampling_contexts[],
+            const Dual2d            ndc[],
+            ShadingRay              rays[],
+            const size_t            count) const APPLESEED_OVERRIDE
+        {
+            if (!m_is_static)
+            {
+                Camera::spawn_rays(sampling_contexts, ndc, rays, count);
+                return;
+            }
+
+            // Consume the random numbers of all rays first, then compute their geometry
+            // in a tight loop free of sampling and transform evaluation.
+            for (size_t i = 0; i < count; ++i)
+                initialize_ray(*sampling_contexts[i], rays[i]);
+
+            for (size_t i = 0; i < count; ++i)
+                set_static_ray_geometry(ndc[i], rays[i]);
+        }
+
         virtual bool connect_vertex(
             SamplingContext&    sampling_context,
             const float         time,
@@ -264,6 +315,41 @@ namespace
             return true;
         }
 
+        virtual bool get_view_frustum(Frustum<double, 4>& frustum) const APPLESEED_OVERRIDE
+        {
+            // The frustum of a moving camera would have to enclose all of its poses.
+            if (m_transform_sequence.size() > 1)
+                return false;
+
+            const Transformd& transform = m_transform_sequence.get_earliest_transform();
+            const Vector3d origin = transform.get_local_to_parent().extract_translation();
+
+            // Compute the world space directions toward the corners and the center of the film.
+            const Vector2d corners[4] =
+            {
+                Vector2d(0.0, 0.0),
+                Vector2d(1.0, 0.0),
+                Vector2d(1.0, 1.0),
+                Vector2d(0.0, 1.0)
+            };
+            Vector3d corner_dirs[4];
+            for (size_t i = 0; i < 4; ++i)
+                corner_dirs[i] = transform.vector_to_parent(-ndc_to_camera(corners[i]));
+            const Vector3d center_dir = transform.vector_to_parent(-ndc_to_camera(Vector2d(0.5, 0.5)));
+
+            // Each side of the frustum is the plane through the pin hole and two adjacent corners,
+            // oriented such that the viewing direction lies in its negative half space.
+            for (size_t i = 0; i < 4; ++i)
+            {
+                Vector3d n = normalize(cross(corner_dirs[i], corner_dirs[(i + 1) % 4]));
+                if (dot(n, center_dir) > 0.0)
+                    n = -n;
+                frustum.set_plane(i, Vector4d(n.x, n.y, n.z, -dot(n, origin)));
+            }
+
+            return true;
+        }
+
       private:
         // Parameters.
         Vector2d    m_film_dimensions;      // film dimensions in camera space, in meters
@@ -274,6 +360,31 @@ namespace
         double      m_rcp_film_width;       // film width reciprocal in camera space
         double      m_rcp_film_height;      // film height reciprocal in camera space
         double      m_pixel_area;           // pixel area in meters, in camera space
+        bool        m_is_static;            // is the camera transform constant over the shutter interval?
+        Vector3d    m_static_org;           // world space ray origin of a static camera
+        Vector3d    m_static_dir;           // unnormalized world space direction toward NDC (0, 0)
+        Vector3d    m_static_dir_dx;        // change of m_static_dir per unit of NDC along X
+        Vector3d    m_static_dir_dy;        // change of m_static_dir per unit of NDC along Y
+
+        void set_static_ray_geometry(const Dual2d& ndc, ShadingRay& ray) const
+        {
+            const Vector2d& p = ndc.get_value();
+            const Vector3d dir = m_static_dir + p.x * m_static_dir_dx + p.y * m_static_dir_dy;
+
+            ray.m_org = m_static_org;
+            ray.m_dir = normalize(dir);
+
+            if (ndc.has_derivatives())
+            {
+                const Vector2d& dx = ndc.get_dx();
+                const Vector2d& dy = ndc.get_dy();
+                ray.m_rx.m_org = m_static_org;
+                ray.m_ry.m_org = m_static_org;
+                ray.m_rx.m_dir = normalize(dir + dx.x * m_static_dir_dx + dx.y * m_static_dir_dy);
+                ray.m_ry.m_dir = normalize(dir + dy.x * m_static_dir_dx + dy.y * m_static_dir_dy);
+                ray.m_has_differentials = true;
+            }
+        }
 
         void print_settings() const
         {
@@ -181,6 +181,7 @@ namespace
             const char*             name,
             const ParamArray&       params)
           : Camera(name, params)
+          , m_is_static(false)
         {
             m_inputs.declare("diaphragm_map", InputFormatSpectralReflectance, "");
         }
@@ -270,6 +271,19 @@ namespace
             m_focal_ratio = m_focal_distance / m_focal_length;
             m_rcp_focal_ratio = m_focal_length / m_focal_distance;
 
+            // A static camera maps film points to world space focal points with a fixed affine map.
+            m_is_static = m_transform_sequence.size() <= 1;
+            if (m_is_static)
+            {
+                m_static_transform = m_transform_sequence.evaluate(m_shutter_open_time);
+                m_static_focal_point =
+                    m_static_transform.point_to_parent(-m_focal_ratio * ndc_to_camera(Vector2d(0.0, 0.0)));
+                m_static_focal_point_dx =
+                    m_static_transform.vector_to_parent(Vector3d(m_focal_ratio * m_film_dimensions[0], 0.0, 0.0));
+                m_static_focal_point_dy =
+                    m_static_transform.vector_to_parent(Vector3d(0.0, -m_focal_ratio * m_film_dimensions[1], 0.0));
+            }
+
             return true;
         }
 
@@ -294,6 +308,13 @@ namespace
             // Initialize the ray.
             initialize_ray(sampling_context, ray);
 
+            if (m_is_static)
+            {
+                ray.m_org = m_static_transform.point_to_parent(sample_lens(sampling_context));
+                set_static_ray_directions(ndc, ray);
+                return;
+            }
+
             // Retrieve the camera transform.
             Transformd scratch;
             const Transformd& transform =
@@ -322,6 +343,30 @@ namespace
             }
         }
 
+        virtual void spawn_rays(
+            SamplingContext* const  sampling_contexts[],
+            const Dual2d            ndc[],
+            ShadingRay              rays[],
+            const size_t            count) const APPLESEED_OVERRIDE
+        {
+            if (!m_is_static)
+            {
+                Camera::spawn_rays(sampling_contexts, ndc, rays, count);
+                return;
+            }
+
+            // Sample the lens for all rays first, then compute their directions
+            // in a tight loop free of sampling and transform evaluation.
+            for (size_t i = 0; i < count; ++i)
+            {
+                initialize_ray(*sampling_contexts[i], rays[i]);
+                rays[i].m_org = m_static_transform.point_to_parent(sample_lens(*sampling_contexts[i]));
+            }
+
+            for (size_t i = 0; i < count; ++i)
+                set_static_ray_directions(ndc[i], rays[i]);
+        }
+
         virtual bool connect_vertex(
             SamplingContext&        sampling_context,
             const float             time,
@@ -432,6 +477,11 @@ namespace
         double              m_lens_radius;              // radius of the lens in camera space
         double              m_focal_ratio;              // focal distance / focal length
         double              m_rcp_focal_ratio;          // focal length / focal distance
+        bool                m_is_static;                // is the camera transform constant over the shutter interval?
+        Transformd          m_static_transform;         // camera transform of a static camera
+        Vector3d            m_static_focal_point;       // world space focal point of NDC (0, 0)
+        Vector3d            m_static_focal_point_dx;    // change of m_static_focal_point per unit of NDC along X
+        Vector3d            m_static_focal_point_dy;    // change of m_static_focal_point per unit of NDC along Y
 
         // Vertices of the diaphragm polygon.
         vector<Vector2d>    m_diaphragm_vertices;
@@ -631,6 +681,27 @@ namespace
             }
         }
 
+        // Set the direction and the differentials of a ray of a static camera whose origin is set.
+        void set_static_ray_directions(const Dual2d& ndc, ShadingRay& ray) const
+        {
+            const Vector2d& p = ndc.get_value();
+            const Vector3d dir =
+                m_static_focal_point + p.x * m_static_focal_point_dx + p.y * m_static_focal_point_dy - ray.m_org;
+
+            ray.m_dir = normalize(dir);
+
+            if (ndc.has_derivatives())
+            {
+                const Vector2d& dx = ndc.get_dx();
+                const Vector2d& dy = ndc.get_dy();
+                ray.m_rx.m_org = ray.m_org;
+                ray.m_ry.m_org = ray.m_org;
+                ray.m_rx.m_dir = normalize(dir + dx.x * m_static_focal_point_dx + dx.y * m_static_focal_point_dy);
+                ray.m_ry.m_dir = normalize(dir + dy.x * m_static_focal_point_dx + dy.y * m_static_focal_point_dy);
+                ray.m_has_differentials = true;
+            }
+        }
+
         Vector3d compute_ray_direction(
             const Vector2d&     film_point,         // NDC
             const Vector3d&     lens_point,         // world space
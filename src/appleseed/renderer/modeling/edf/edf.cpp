@@ -122,7 +122,7 @@ void* EDF::evaluate_inputs(
 
     get_inputs().evaluate(
         shading_context.get_texture_cache(),
-        shading_point.get_uv(0),
+        shading_point,
         data);
 
     return data;
@@ -41,9 +41,46 @@
 // Standard headers.
 #include <cassert>
 
+using namespace foundation;
+
 namespace renderer
 {
 
+bool ConnectableEntity::on_frame_begin(
+    const Project&          project,
+    const BaseGroup*        parent,
+    OnFrameBeginRecorder&   recorder,
+    IAbortSwitch*           abort_switch)
+{
+    if (!Entity::on_frame_begin(project, parent, recorder, abort_switch))
+        return false;
+
+    m_inputs.compile();
+
+    return true;
+}
+
+bool ConnectableEntity::has_spectral_inputs() const
+{
+    // Only color entities can hold spectral values, and they are always bound as
+    // uniform sources. Textures are always RGB.
+    for (InputArray::const_iterator i = m_inputs.begin(), e = m_inputs.end(); i != e; ++i)
+    {
+        const Source* source = i.source();
+
+        if (source && source->is_uniform())
+        {
+            Spectrum spectrum;
+            source->evaluate_uniform(spectrum);
+
+            if (spectrum.is_spectral())
+                return true;
+        }
+    }
+
+    return false;
+}
+
 bool ConnectableEntity::is_uniform_zero_scalar(const Source* source)
 {
     assert(source);
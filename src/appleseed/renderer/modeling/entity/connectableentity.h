@@ -35,14 +35,19 @@
 #include "renderer/modeling/input/inputarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/compiler.h"
 #include "foundation/utility/uid.h"
 
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
 // Forward declarations.
-namespace renderer  { class ParamArray; }
-namespace renderer  { class Source; }
+namespace foundation    { class IAbortSwitch; }
+namespace renderer      { class BaseGroup; }
+namespace renderer      { class OnFrameBeginRecorder; }
+namespace renderer      { class ParamArray; }
+namespace renderer      { class Project; }
+namespace renderer      { class Source; }
 
 namespace renderer
 {
@@ -66,6 +71,19 @@ class APPLESEED_DLLSYMBOL ConnectableEntity
     InputArray& get_inputs();
     const InputArray& get_inputs() const;
 
+    // This method is called once before rendering each frame.
+    // Precomputes the values of uniform inputs.
+    // Returns true on success, false otherwise.
+    virtual bool on_frame_begin(
+        const Project&              project,
+        const BaseGroup*            parent,
+        OnFrameBeginRecorder&       recorder,
+        foundation::IAbortSwitch*   abort_switch = 0) APPLESEED_OVERRIDE;
+
+    // Return true if any input of this entity is bound to spectral (as opposed to RGB) values.
+    // Entities that delegate to other entities must also take their inputs into account.
+    virtual bool has_spectral_inputs() const;
+
   protected:
     InputArray m_inputs;
 
@@ -33,9 +33,13 @@
 // appleseed.foundation headers.
 #include "foundation/utility/foreach.h"
 
+// Boost headers.
+#include "boost/unordered_map.hpp"
+
 // Standard headers.
 #include <cassert>
 #include <map>
+#include <string>
 
 using namespace foundation;
 using namespace std;
@@ -46,7 +50,7 @@ namespace renderer
 struct EntityMap::Impl
 {
     typedef map<UniqueID, Entity*> Storage;
-    typedef map<string, Entity*> Index;
+    typedef boost::unordered_map<string, Entity*> Index;
 
     Storage m_storage;
     Index   m_index;
@@ -33,9 +33,12 @@
 // appleseed.foundation headers.
 #include "foundation/utility/foreach.h"
 
+// Boost headers.
+#include "boost/unordered_map.hpp"
+
 // Standard headers.
 #include <cassert>
-#include <map>
+#include <string>
 #include <vector>
 
 using namespace foundation;
@@ -47,8 +50,9 @@ namespace renderer
 struct EntityVector::Impl
 {
     typedef vector<Entity*> Storage;
-    typedef map<UniqueID, size_t> IDIndex;
-    typedef map<string, size_t> NameIndex;
+    // Hash indices keep lookups constant-time in containers holding many entities.
+    typedef boost::unordered_map<UniqueID, size_t> IDIndex;
+    typedef boost::unordered_map<string, size_t> NameIndex;
 
     Storage     m_storage;
     IDIndex     m_id_index;
@@ -272,6 +276,13 @@ bool EntityVector::empty() const
     return impl->m_storage.empty();
 }
 
+void EntityVector::reserve(const size_t size)
+{
+    impl->m_storage.reserve(size);
+    impl->m_id_index.reserve(size);
+    impl->m_name_index.reserve(size);
+}
+
 size_t EntityVector::insert(auto_release_ptr<Entity> entity)
 {
     // Retrieve the entity.
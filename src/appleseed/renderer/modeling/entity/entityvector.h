@@ -165,6 +165,9 @@ class APPLESEED_DLLSYMBOL EntityVector
     // Return true if the container is empty.
     bool empty() const;
 
+    // Reserve memory for a given total number of entities, to speed up bulk insertions.
+    void reserve(const size_t size);
+
     // Insert an entity into the container and return its index.
     size_t insert(foundation::auto_release_ptr<Entity> entity);
 
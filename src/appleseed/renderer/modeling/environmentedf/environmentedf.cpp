@@ -102,4 +102,13 @@ bool EnvironmentEDF::on_frame_begin(
     return true;
 }
 
+void EnvironmentEDF::evaluate_filtered(
+    const ShadingContext&   shading_context,
+    const Vector3f&         outgoing,
+    const float             solid_angle,
+    Spectrum&               value) const
+{
+    evaluate(shading_context, outgoing, value);
+}
+
 }   // namespace renderer
@@ -113,6 +113,14 @@ class APPLESEED_DLLSYMBOL EnvironmentEDF
     virtual float evaluate_pdf(
         const foundation::Vector3f& outgoing) const = 0;        // world space emission direction, unit-length
 
+    // Evaluate the EDF averaged over a cone of directions subtending a given solid angle.
+    // Environment EDFs that don't support prefiltering return the unfiltered value.
+    virtual void evaluate_filtered(
+        const ShadingContext&       shading_context,
+        const foundation::Vector3f& outgoing,                   // world space emission direction, unit-length
+        const float                 solid_angle,                // solid angle of the cone, in steradians
+        Spectrum&                   value) const;               // EDF value averaged over the cone
+
   protected:
     TransformSequence m_transform_sequence;
 };
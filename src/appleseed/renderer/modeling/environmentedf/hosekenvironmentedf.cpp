@@ -31,12 +31,19 @@
 #include "hosekenvironmentedf.h"
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/shading/shadingcontext.h"
+#include "renderer/kernel/texturing/texturecache.h"
+#include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/modeling/environmentedf/environmentedf.h"
+#include "renderer/modeling/environmentedf/skyradiancetable.h"
 #include "renderer/modeling/environmentedf/sphericalcoordinates.h"
 #include "renderer/modeling/input/inputarray.h"
 #include "renderer/modeling/input/source.h"
+#include "renderer/modeling/project/project.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
 #include "renderer/utility/transformsequence.h"
 
 // appleseed.foundation headers.
@@ -49,18 +56,20 @@
 #include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/string.h"
 
 // Standard headers.
 #include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <memory>
 
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
-namespace renderer      { class Project; }
 
 using namespace foundation;
 using namespace std;
@@ -109,6 +118,8 @@ namespace
             m_inputs.declare("luminance_gamma", InputFormatFloat, "1.0");
             m_inputs.declare("saturation_multiplier", InputFormatFloat, "1.0");
             m_inputs.declare("horizon_shift", InputFormatFloat, "0.0");
+
+            m_radiance_table_resolution = m_params.get_optional<size_t>("radiance_table_resolution", 0);
         }
 
         virtual void release() APPLESEED_OVERRIDE
@@ -155,6 +166,11 @@ namespace
                     m_uniform_master_Y);
             }
 
+            // Optionally bake the sky into a radiance table.
+            m_radiance_table.reset();
+            if (m_radiance_table_resolution > 0)
+                build_radiance_table(project, abort_switch);
+
             return true;
         }
 
@@ -165,15 +181,23 @@ namespace
             Spectrum&               value,
             float&                  probability) const APPLESEED_OVERRIDE
         {
-            const Vector3f local_outgoing = sample_hemisphere_cosine(s);
-
             Transformd scratch;
             const Transformd& transform = m_transform_sequence.evaluate(0.0f, scratch);
+
+            if (m_radiance_table.get())
+            {
+                Vector3f local_outgoing;
+                m_radiance_table->sample(s, local_outgoing, value, probability);
+                outgoing = transform.vector_to_parent(local_outgoing);
+                return;
+            }
+
+            const Vector3f local_outgoing = sample_hemisphere_cosine(s);
             outgoing = transform.vector_to_parent(local_outgoing);
             const Vector3f shifted_outgoing = shift(local_outgoing);
 
             if (shifted_outgoing.y > 0.0f)
-                compute_sky_radiance(shading_context, shifted_outgoing, value);
+                compute_sky_radiance(shading_context.get_texture_cache(), shifted_outgoing, value);
             else value.set(0.0f);
 
             probability = shifted_outgoing.y > 0.0f ? shifted_outgoing.y * RcpPi<float>() : 0.0f;
@@ -189,10 +213,17 @@ namespace
             Transformd scratch;
             const Transformd& transform = m_transform_sequence.evaluate(0.0f, scratch);
             const Vector3f local_outgoing = transform.vector_to_local(outgoing);
+
+            if (m_radiance_table.get())
+            {
+                m_radiance_table->lookup(local_outgoing, value);
+                return;
+            }
+
             const Vector3f shifted_outgoing = shift(local_outgoing);
 
             if (shifted_outgoing.y > 0.0f)
-                compute_sky_radiance(shading_context, shifted_outgoing, value);
+                compute_sky_radiance(shading_context.get_texture_cache(), shifted_outgoing, value);
             else value.set(0.0f);
         }
 
@@ -207,10 +238,18 @@ namespace
             Transformd scratch;
             const Transformd& transform = m_transform_sequence.evaluate(0.0f, scratch);
             const Vector3f local_outgoing = transform.vector_to_local(outgoing);
+
+            if (m_radiance_table.get())
+            {
+                m_radiance_table->lookup(local_outgoing, value);
+                probability = m_radiance_table->evaluate_pdf(local_outgoing);
+                return;
+            }
+
             const Vector3f shifted_outgoing = shift(local_outgoing);
 
             if (shifted_outgoing.y > 0.0f)
-                compute_sky_radiance(shading_context, shifted_outgoing, value);
+                compute_sky_radiance(shading_context.get_texture_cache(), shifted_outgoing, value);
             else value.set(0.0f);
 
             probability = shifted_outgoing.y > 0.0f ? shifted_outgoing.y * RcpPi<float>() : 0.0f;
@@ -224,6 +263,10 @@ namespace
             Transformd scratch;
             const Transformd& transform = m_transform_sequence.evaluate(0.0f, scratch);
             const Vector3f local_outgoing = transform.vector_to_local(outgoing);
+
+            if (m_radiance_table.get())
+                return m_radiance_table->evaluate_pdf(local_outgoing);
+
             const Vector3f shifted_outgoing = shift(local_outgoing);
 
             return shifted_outgoing.y > 0.0f ? shifted_outgoing.y * RcpPi<float>() : 0.0f;
@@ -245,6 +288,9 @@ namespace
 
         const LightingConditions    m_lighting_conditions;
 
+        size_t                      m_radiance_table_resolution;    // 0 to evaluate the sky model along every direction
+        auto_ptr<SkyRadianceTable>  m_radiance_table;
+
         InputValues                 m_uniform_values;
 
         float                       m_sun_theta;    // sun zenith angle in radians, 0=zenith
@@ -370,7 +416,7 @@ namespace
 
         // Compute the sky radiance along a given direction.
         void compute_sky_radiance(
-            const ShadingContext&   shading_context,
+            TextureCache&           texture_cache,
             const Vector3f&         outgoing,
             Spectrum&               value) const
         {
@@ -401,7 +447,7 @@ namespace
                 unit_vector_to_angles(outgoing, theta, phi);
                 angles_to_unit_square(theta, phi, u, v);
                 InputValues values;
-                m_inputs.evaluate(shading_context.get_texture_cache(), Vector2f(u, v), &values);
+                m_inputs.evaluate(texture_cache, Vector2f(u, v), &values);
                 float turbidity = values.m_turbidity;
 
                 // Apply turbidity multiplier and bias.
@@ -463,6 +509,61 @@ namespace
             v.y -= m_uniform_values.m_horizon_shift;
             return normalize(v);
         }
+
+        // Evaluate the sky model along local directions while baking the radiance table.
+        class RadianceFunction
+        {
+          public:
+            RadianceFunction(
+                const HosekEnvironmentEDF&   env_edf,
+                TextureCache&                texture_cache)
+              : m_env_edf(env_edf)
+              , m_texture_cache(texture_cache)
+            {
+            }
+
+            void operator()(
+                const Vector3f&              local_outgoing,
+                Spectrum&                    value) const
+            {
+                const Vector3f shifted_outgoing = m_env_edf.shift(local_outgoing);
+
+                if (shifted_outgoing.y > 0.0f)
+                    m_env_edf.compute_sky_radiance(m_texture_cache, shifted_outgoing, value);
+                else value.set(0.0f);
+            }
+
+          private:
+            const HosekEnvironmentEDF&   m_env_edf;
+            TextureCache&                m_texture_cache;
+        };
+
+        void build_radiance_table(const Project& project, IAbortSwitch* abort_switch)
+        {
+            const size_t width = m_radiance_table_resolution;
+            const size_t height = max<size_t>(width / 2, 1);
+
+            RENDERER_LOG_INFO(
+                "baking " FMT_SIZE_T "x" FMT_SIZE_T " radiance table for environment edf \"%s\"...",
+                width,
+                height,
+                get_path().c_str());
+
+            TextureStore texture_store(*project.get_scene());
+            TextureCache texture_cache(texture_store);
+
+            auto_ptr<SkyRadianceTable> radiance_table(new SkyRadianceTable(width, height));
+
+            if (radiance_table->build(RadianceFunction(*this, texture_cache), abort_switch))
+            {
+                m_radiance_table = radiance_table;
+
+                RENDERER_LOG_INFO(
+                    "baked radiance table for environment edf \"%s\" (%s).",
+                    get_path().c_str(),
+                    pretty_size(m_radiance_table->get_memory_size()).c_str());
+            }
+        }
     };
 }
 
@@ -125,6 +125,17 @@ void IEnvironmentEDFFactory::add_common_sky_input_metadata(DictionaryArray& meta
             .insert("use", "optional")
             .insert("default", "0.0")
             .insert("help", "Rotate the sky horizontally by a given number of degrees"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "radiance_table_resolution")
+            .insert("label", "Radiance Table Resolution")
+            .insert("type", "numeric")
+            .insert("min_value", "0")
+            .insert("max_value", "4096")
+            .insert("use", "optional")
+            .insert("default", "0")
+            .insert("help", "Width of the table the sky is baked into at the beginning of each frame, enabling importance sampling of the sky, 0 to evaluate the sky model along every direction"));
 }
 
 }   // namespace renderer
@@ -37,6 +37,7 @@
 #include "renderer/kernel/texturing/texturecache.h"
 #include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/modeling/environmentedf/environmentedf.h"
+#include "renderer/modeling/environmentedf/prefilteredradiancemap.h"
 #include "renderer/modeling/environmentedf/sphericalcoordinates.h"
 #include "renderer/modeling/input/inputarray.h"
 #include "renderer/modeling/input/source.h"
@@ -54,7 +55,7 @@
 #include "foundation/image/colorspace.h"
 #include "foundation/math/fp.h"
 #include "foundation/math/matrix.h"
-#include "foundation/math/sampling/imageimportancesampler.h"
+#include "foundation/math/sampling/hierarchicalimportancesampler.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/transform.h"
 #include "foundation/math/vector.h"
@@ -62,17 +63,31 @@
 #include "foundation/platform/types.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/bufferedfile.h"
 #include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/foreach.h"
 #include "foundation/utility/job/abortswitch.h"
+#include "foundation/utility/searchpaths.h"
+#include "foundation/utility/siphash.h"
+#include "foundation/utility/string.h"
+
+// Boost headers.
+#include "boost/filesystem.hpp"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <cstring>
+#include <exception>
 #include <memory>
+#include <string>
+#include <vector>
 
 using namespace foundation;
 using namespace std;
+namespace bf = boost::filesystem;
 
 namespace renderer
 {
@@ -92,58 +107,107 @@ namespace
     //   http://www.cs.kuleuven.be/~graphics/index.php/environment-maps
     //
 
-    typedef ImageImportanceSampler<Color3f, float> ImageImportanceSamplerType;
+    // Environment maps have millions of pixels: only store their importance, in a pyramid.
+    typedef HierarchicalImportanceSampler<float> ImportanceSamplerType;
 
     class ImageSampler
     {
       public:
+        // Each texel of the importance map averages supersampling^2 lookups into the sources.
         ImageSampler(
             TextureCache&   texture_cache,
             const Source*   radiance_source,
             const Source*   multiplier_source,
             const Source*   exposure_source,
             const size_t    width,
-            const size_t    height)
+            const size_t    height,
+            const size_t    supersampling)
           : m_texture_cache(texture_cache)
           , m_radiance_source(radiance_source)
           , m_multiplier_source(multiplier_source)
           , m_exposure_source(exposure_source)
           , m_rcp_width(1.0f / width)
           , m_rcp_height(1.0f / height)
+          , m_supersampling(supersampling)
+          , m_rcp_supersampling(1.0f / supersampling)
         {
         }
 
-        void sample(const size_t x, const size_t y, Color3f& payload, float& importance)
+        void sample(const size_t x, const size_t y, float& importance)
         {
+            importance = 0.0f;
+
             if (m_radiance_source == 0)
-            {
-                payload.set(0.0f);
-                importance = 0.0f;
                 return;
+
+            for (size_t j = 0; j < m_supersampling; ++j)
+            {
+                for (size_t i = 0; i < m_supersampling; ++i)
+                {
+                    const Vector2f uv(
+                        (x + (i + 0.5f) * m_rcp_supersampling) * m_rcp_width,
+                        1.0f - (y + (j + 0.5f) * m_rcp_supersampling) * m_rcp_height);
+
+                    Color3f radiance;
+                    m_radiance_source->evaluate(m_texture_cache, uv, radiance);
+
+                    if (is_finite(radiance))
+                    {
+                        float multiplier;
+                        m_multiplier_source->evaluate(m_texture_cache, uv, multiplier);
+
+                        float exposure;
+                        m_exposure_source->evaluate(m_texture_cache, uv, exposure);
+
+                        radiance *= multiplier * pow(2.0f, exposure);
+                        importance += luminance(radiance);
+                    }
+                }
             }
 
-            const Vector2f uv(
-                (x + 0.5f) * m_rcp_width,
-                1.0f - (y + 0.5f) * m_rcp_height);
+            importance *= m_rcp_supersampling * m_rcp_supersampling;
+        }
 
-            m_radiance_source->evaluate(m_texture_cache, uv, payload);
+      private:
+        TextureCache&   m_texture_cache;
+        const Source*   m_radiance_source;
+        const Source*   m_multiplier_source;
+        const Source*   m_exposure_source;
+        const float     m_rcp_width;
+        const float     m_rcp_height;
+        const size_t    m_supersampling;
+        const float     m_rcp_supersampling;
+    };
 
-            if (is_finite(payload))
-            {
-                float multiplier;
-                m_multiplier_source->evaluate(m_texture_cache, uv, multiplier);
+    // Evaluates the radiance of the environment map for PrefilteredRadianceMap::build().
+    class PrefilteringRadianceFunction
+    {
+      public:
+        PrefilteringRadianceFunction(
+            TextureCache&   texture_cache,
+            const Source*   radiance_source,
+            const Source*   multiplier_source,
+            const Source*   exposure_source)
+          : m_texture_cache(texture_cache)
+          , m_radiance_source(radiance_source)
+          , m_multiplier_source(multiplier_source)
+          , m_exposure_source(exposure_source)
+        {
+        }
 
-                float exposure;
-                m_exposure_source->evaluate(m_texture_cache, uv, exposure);
+        void operator()(const Vector2f& uv, Color3f& radiance) const
+        {
+            const Vector2f st(uv[0], 1.0f - uv[1]);
 
-                payload *= multiplier * pow(2.0f, exposure);
-                importance = luminance(payload);
-            }
-            else
-            {
-                payload.set(0.0f);
-                importance = 0.0f;
-            }
+            m_radiance_source->evaluate(m_texture_cache, st, radiance);
+
+            float multiplier;
+            m_multiplier_source->evaluate(m_texture_cache, st, multiplier);
+
+            float exposure;
+            m_exposure_source->evaluate(m_texture_cache, st, exposure);
+
+            radiance *= multiplier * pow(2.0f, exposure);
         }
 
       private:
@@ -151,10 +215,33 @@ namespace
         const Source*   m_radiance_source;
         const Source*   m_multiplier_source;
         const Source*   m_exposure_source;
-        const float     m_rcp_width;
-        const float     m_rcp_height;
     };
 
+    // Resolution of the sharpest level of prefiltered environment maps.
+    const size_t PrefilteredMapWidth = 256;
+    const size_t PrefilteredMapHeight = 128;
+
+    // Version of the on-disk format of importance maps; increase when changing it.
+    const uint32 ImportanceMapCacheFormatVersion = 1;
+
+    const char ImportanceMapCacheSignature[] = "ASIM";
+
+    uint64 hash_string(const uint64 hash, const string& s)
+    {
+        return siphash24(hash, siphash24(s.c_str(), s.size()));
+    }
+
+    uint64 hash_params(uint64 hash, const ParamArray& params)
+    {
+        for (const_each<StringDictionary> i = params.strings(); i; ++i)
+        {
+            hash = hash_string(hash, i->key());
+            hash = hash_string(hash, i->value());
+        }
+
+        return hash;
+    }
+
     const char* Model = "latlong_map_environment_edf";
 
     class LatLongMapEnvironmentEDF
@@ -175,6 +262,10 @@ namespace
 
             m_phi_shift = deg_to_rad(m_params.get_optional<float>("horizontal_shift", 0.0f));
             m_theta_shift = deg_to_rad(m_params.get_optional<float>("vertical_shift", 0.0f));
+
+            m_importance_map_max_resolution = m_params.get_optional<size_t>("importance_map_max_resolution", 0);
+            m_importance_map_cache = m_params.get_optional<bool>("importance_map_cache", false);
+            m_prefiltered_lookups = m_params.get_optional<bool>("prefiltered_lookups", false);
         }
 
         virtual void release() APPLESEED_OVERRIDE
@@ -203,7 +294,10 @@ namespace
                 check_non_zero_emission("radiance", "radiance_multiplier");
 
                 if (m_importance_sampler.get() == 0)
-                    build_importance_map(*project.get_scene(), abort_switch);
+                    build_importance_map(project, abort_switch);
+
+                if (m_prefiltered_lookups && m_prefiltered_map.get() == 0)
+                    build_prefiltered_map(project, abort_switch);
             }
 
             return true;
@@ -228,19 +322,28 @@ namespace
 
             // Sample the importance map.
             size_t x, y;
-            Color3f payload;
+            Vector2f pixel_s;
             float prob_xy;
-            m_importance_sampler->sample(s, x, y, payload, prob_xy);
+            m_importance_sampler->sample(s, x, y, pixel_s, prob_xy);
 
-            // Compute the coordinates in [0,1]^2 of the sample.
-            const float u = (x + 0.5f) * m_rcp_importance_map_width;
-            const float v = (y + 0.5f) * m_rcp_importance_map_height;
+            // Compute the coordinates in [0,1)^2 of the sample, anywhere within the chosen texel.
+            const float OneMinusEps = shift(1.0f, -1);
+            const float u = min((x + pixel_s[0]) * m_rcp_importance_map_width, OneMinusEps);
+            float v = min((y + pixel_s[1]) * m_rcp_importance_map_height, OneMinusEps);
 
             // Compute the spherical coordinates of the sample.
             float theta, phi;
             unit_square_to_angles(u, v, theta, phi);
             shift_angles(theta, phi, m_theta_shift, m_phi_shift);
 
+            // The density of directions is infinite at the poles: use the center of the texel instead.
+            if (sin(theta) == 0.0f)
+            {
+                v = (y + 0.5f) * m_rcp_importance_map_height;
+                unit_square_to_angles(u, v, theta, phi);
+                shift_angles(theta, phi, m_theta_shift, m_phi_shift);
+            }
+
             // Compute the local space emission direction.
             const float cos_theta = cos(theta);
             const float sin_theta = sin(theta);
@@ -255,7 +358,7 @@ namespace
             outgoing = transform.vector_to_parent(local_outgoing);
 
             // Return the emitted radiance.
-            value = payload;
+            lookup_environment_map(shading_context, u, v, value);
 
             // Compute the probability density of this direction.
             probability = prob_xy * m_probability_scale / sin_theta;
@@ -354,6 +457,35 @@ namespace
             return compute_pdf(u, v, theta);
         }
 
+        virtual void evaluate_filtered(
+            const ShadingContext&   shading_context,
+            const Vector3f&         outgoing,
+            const float             solid_angle,
+            Spectrum&               value) const APPLESEED_OVERRIDE
+        {
+            assert(is_normalized(outgoing));
+
+            // Transform the emission direction to local space.
+            Transformd scratch;
+            const Transformd& transform = m_transform_sequence.evaluate(0.0f, scratch);
+            const Vector3f local_outgoing = transform.vector_to_local(outgoing);
+
+            // Compute the spherical coordinates of the outgoing direction.
+            float theta, phi;
+            unit_vector_to_angles(local_outgoing, theta, phi);
+            shift_angles(theta, phi, -m_theta_shift, -m_phi_shift);
+
+            // Convert the spherical coordinates to [0,1]^2.
+            float u, v;
+            angles_to_unit_square(theta, phi, u, v);
+
+            // Look up the prefiltered map, unless the cone is too narrow for it.
+            Color3f radiance;
+            if (m_prefiltered_map.get() && m_prefiltered_map->lookup(u, v, solid_angle, radiance))
+                value = Spectrum(radiance, Spectrum::Illuminance);
+            else lookup_environment_map(shading_context, u, v, value);
+        }
+
       private:
         APPLESEED_DECLARE_INPUT_VALUES(InputValues)
         {
@@ -365,6 +497,10 @@ namespace
         float   m_phi_shift;                        // horizontal shift in radians
         float   m_theta_shift;                      // vertical shift in radians
 
+        size_t  m_importance_map_max_resolution;    // 0 for the resolution of the radiance texture
+        bool    m_importance_map_cache;             // store the importance map next to the radiance texture
+        bool    m_prefiltered_lookups;              // prefilter the environment map for evaluate_filtered()
+
         size_t  m_importance_map_width;
         size_t  m_importance_map_height;
 
@@ -372,13 +508,17 @@ namespace
         float   m_rcp_importance_map_height;
         float   m_probability_scale;
 
-        auto_ptr<ImageImportanceSamplerType> m_importance_sampler;
+        auto_ptr<ImportanceSamplerType> m_importance_sampler;
+        auto_ptr<PrefilteredRadianceMap> m_prefiltered_map;
 
-        void build_importance_map(const Scene& scene, IAbortSwitch*abort_switch)
+        void build_importance_map(const Project& project, IAbortSwitch* abort_switch)
         {
             const Source* radiance_source = m_inputs.source("radiance");
             assert(radiance_source);
 
+            size_t supersampling = 1;
+            string cache_file_path;
+
             if (dynamic_cast<const TextureSource*>(radiance_source))
             {
                 const TextureSource* texture_source = static_cast<const TextureSource*>(radiance_source);
@@ -387,6 +527,18 @@ namespace
 
                 m_importance_map_width = texture_props.m_canvas_width;
                 m_importance_map_height = texture_props.m_canvas_height;
+
+                // Optionally build the importance map at a lower resolution, averaging the texels it covers.
+                if (m_importance_map_max_resolution > 0)
+                {
+                    const size_t max_dim = max(m_importance_map_width, m_importance_map_height);
+                    supersampling = (max_dim + m_importance_map_max_resolution - 1) / m_importance_map_max_resolution;
+                    m_importance_map_width = (m_importance_map_width + supersampling - 1) / supersampling;
+                    m_importance_map_height = (m_importance_map_height + supersampling - 1) / supersampling;
+                }
+
+                if (m_importance_map_cache)
+                    cache_file_path = get_cache_file_path(project, texture_instance);
             }
             else
             {
@@ -405,7 +557,23 @@ namespace
             const size_t texel_count = m_importance_map_width * m_importance_map_height;
             m_probability_scale = texel_count / (2.0f * PiSquare<float>());
 
-            TextureStore texture_store(scene);
+            m_importance_sampler.reset(
+                new ImportanceSamplerType(
+                    m_importance_map_width,
+                    m_importance_map_height));
+
+            const uint64 cache_key = cache_file_path.empty() ? 0 : compute_cache_key(project, cache_file_path);
+
+            if (!cache_file_path.empty() && load_from_cache(cache_file_path, cache_key))
+            {
+                RENDERER_LOG_INFO(
+                    "loaded importance map for environment edf \"%s\" from %s.",
+                    get_path().c_str(),
+                    cache_file_path.c_str());
+                return;
+            }
+
+            TextureStore texture_store(*project.get_scene());
             TextureCache texture_cache(texture_store);
             ImageSampler sampler(
                 texture_cache,
@@ -413,12 +581,8 @@ namespace
                 m_inputs.source("radiance_multiplier"),
                 m_inputs.source("exposure"),
                 m_importance_map_width,
-                m_importance_map_height);
-
-            m_importance_sampler.reset(
-                new ImageImportanceSamplerType(
-                    m_importance_map_width,
-                    m_importance_map_height));
+                m_importance_map_height,
+                supersampling);
 
             RENDERER_LOG_INFO(
                 "building " FMT_SIZE_T "x" FMT_SIZE_T " importance map "
@@ -434,8 +598,182 @@ namespace
             else
             {
                 RENDERER_LOG_INFO(
-                    "built importance map for environment edf \"%s\".",
+                    "built importance map for environment edf \"%s\" (%s).",
+                    get_path().c_str(),
+                    pretty_size(m_importance_sampler->get_memory_size()).c_str());
+
+                if (!cache_file_path.empty())
+                    save_to_cache(cache_file_path, cache_key);
+            }
+        }
+
+        void build_prefiltered_map(const Project& project, IAbortSwitch* abort_switch)
+        {
+            const Source* radiance_source = m_inputs.source("radiance");
+            assert(radiance_source);
+
+            // Average enough lookups per texel to cover the radiance texture.
+            size_t supersampling = 1;
+            if (dynamic_cast<const TextureSource*>(radiance_source))
+            {
+                const TextureSource* texture_source = static_cast<const TextureSource*>(radiance_source);
+                const CanvasProperties& texture_props =
+                    texture_source->get_texture_instance().get_texture().properties();
+                supersampling =
+                    min<size_t>(
+                        max<size_t>((texture_props.m_canvas_width + PrefilteredMapWidth - 1) / PrefilteredMapWidth, 1),
+                        8);
+            }
+
+            RENDERER_LOG_INFO(
+                "prefiltering environment map for environment edf \"%s\"...",
+                get_path().c_str());
+
+            TextureStore texture_store(*project.get_scene());
+            TextureCache texture_cache(texture_store);
+            const PrefilteringRadianceFunction radiance_function(
+                texture_cache,
+                radiance_source,
+                m_inputs.source("radiance_multiplier"),
+                m_inputs.source("exposure"));
+
+            m_prefiltered_map.reset(new PrefilteredRadianceMap(PrefilteredMapWidth, PrefilteredMapHeight));
+
+            if (!m_prefiltered_map->build(radiance_function, supersampling, abort_switch))
+                m_prefiltered_map.reset();
+            else
+            {
+                RENDERER_LOG_INFO(
+                    "prefiltered environment map for environment edf \"%s\" (" FMT_SIZE_T " levels, %s).",
+                    get_path().c_str(),
+                    m_prefiltered_map->get_level_count(),
+                    pretty_size(m_prefiltered_map->get_memory_size()).c_str());
+            }
+        }
+
+        // Return the path of the file storing the importance map next to the radiance texture,
+        // or an empty string if the importance map cannot be stored.
+        string get_cache_file_path(const Project& project, const TextureInstance& texture_instance) const
+        {
+            // Textured multipliers would make the importance map depend on other files.
+            if (dynamic_cast<const TextureSource*>(m_inputs.source("radiance_multiplier")) ||
+                dynamic_cast<const TextureSource*>(m_inputs.source("exposure")))
+            {
+                RENDERER_LOG_WARNING(
+                    "not caching importance map for environment edf \"%s\" because its "
+                    "\"radiance_multiplier\" or \"exposure\" input is textured.",
                     get_path().c_str());
+                return string();
+            }
+
+            const ParamArray& texture_params = texture_instance.get_texture().get_parameters();
+            if (!texture_params.strings().exist("filename"))
+                return string();
+
+            return project.search_paths().qualify(texture_params.get("filename")) + ".importance";
+        }
+
+        uint64 compute_cache_key(const Project& project, const string& cache_file_path) const
+        {
+            const TextureSource* texture_source = static_cast<const TextureSource*>(m_inputs.source("radiance"));
+            const TextureInstance& texture_instance = texture_source->get_texture_instance();
+
+            // Format and resolution of the importance map.
+            uint64 key = siphash24(ImportanceMapCacheFormatVersion, m_importance_map_width);
+            key = siphash24(key, m_importance_map_height);
+
+            // Contents of the radiance texture and the way it is looked up.
+            const string texture_file_path = cache_file_path.substr(0, cache_file_path.size() - strlen(".importance"));
+            try
+            {
+                key = hash_string(key, texture_file_path);
+                key = siphash24(key, static_cast<uint64>(bf::file_size(texture_file_path)));
+                key = siphash24(key, static_cast<uint64>(bf::last_write_time(texture_file_path)));
+            }
+            catch (const std::exception&)       // namespace qualification required
+            {
+                // The texture file cannot be found: the key will fail to match a cache file.
+            }
+            key = hash_params(key, texture_instance.get_texture().get_parameters());
+            key = hash_params(key, texture_instance.get_parameters());
+
+            return key;
+        }
+
+        bool load_from_cache(const string& path, const uint64 key)
+        {
+            if (!bf::exists(path))
+                return false;
+
+            BufferedFile file;
+            if (!file.open(path.c_str(), BufferedFile::BinaryType, BufferedFile::ReadMode))
+                return false;
+
+            // Check the header.
+            char signature[sizeof(ImportanceMapCacheSignature) - 1];
+            uint32 version;
+            uint64 stored_key;
+            if (file.read(signature, sizeof(signature)) != sizeof(signature) ||
+                memcmp(signature, ImportanceMapCacheSignature, sizeof(signature)) != 0 ||
+                file.read(version) != sizeof(version) ||
+                version != ImportanceMapCacheFormatVersion ||
+                file.read(stored_key) != sizeof(stored_key) ||
+                stored_key != key)
+            {
+                RENDERER_LOG_WARNING("ignoring outdated importance map cache file %s.", path.c_str());
+                return false;
+            }
+
+            vector<float> importance(m_importance_map_width * m_importance_map_height);
+            const size_t byte_count = importance.size() * sizeof(float);
+            if (file.read(&importance[0], byte_count) != byte_count)
+            {
+                RENDERER_LOG_WARNING("ignoring truncated importance map cache file %s.", path.c_str());
+                return false;
+            }
+
+            m_importance_sampler->set_importance(importance);
+
+            return true;
+        }
+
+        void save_to_cache(const string& path, const uint64 key) const
+        {
+            try
+            {
+                // Write to a temporary file first so that concurrent renders never read a partial file.
+                const bf::path final_path(path);
+                const bf::path temp_path =
+                    final_path.parent_path() / bf::unique_path(final_path.filename().string() + ".%%%%-%%%%-%%%%");
+
+                bool success = false;
+                {
+                    BufferedFile file;
+                    if (file.open(temp_path.string().c_str(), BufferedFile::BinaryType, BufferedFile::WriteMode))
+                    {
+                        const uint32 version = ImportanceMapCacheFormatVersion;
+                        const vector<float>& importance = m_importance_sampler->get_importance();
+                        const size_t byte_count = importance.size() * sizeof(float);
+                        success =
+                            file.write(ImportanceMapCacheSignature, sizeof(ImportanceMapCacheSignature) - 1) == sizeof(ImportanceMapCacheSignature) - 1 &&
+                            file.write(version) == sizeof(version) &&
+                            file.write(key) == sizeof(key) &&
+                            file.write(&importance[0], byte_count) == byte_count;
+                        success = file.close() && success;
+                    }
+                }
+
+                if (success)
+                    bf::rename(temp_path, final_path);
+                else
+                {
+                    bf::remove(temp_path);
+                    RENDERER_LOG_WARNING("failed to write importance map cache file %s.", path.c_str());
+                }
+            }
+            catch (const std::exception& e)     // namespace qualification required
+            {
+                RENDERER_LOG_WARNING("failed to write importance map cache file %s: %s.", path.c_str(), e.what());
             }
         }
 
@@ -558,6 +896,35 @@ DictionaryArray LatLongMapEnvironmentEDFFactory::get_input_metadata() const
             .insert("use", "optional")
             .insert("help", "Environment texture vertical shift in degrees"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "importance_map_max_resolution")
+            .insert("label", "Importance Map Max Resolution")
+            .insert("type", "numeric")
+            .insert("min_value", "0")
+            .insert("max_value", "65536")
+            .insert("default", "0")
+            .insert("use", "optional")
+            .insert("help", "Maximum width or height of the importance map, 0 for the resolution of the environment texture"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "importance_map_cache")
+            .insert("label", "Cache Importance Map")
+            .insert("type", "boolean")
+            .insert("default", "false")
+            .insert("use", "optional")
+            .insert("help", "Store the importance map next to the environment texture and reuse it in subsequent renders"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "prefiltered_lookups")
+            .insert("label", "Prefiltered Lookups")
+            .insert("type", "boolean")
+            .insert("default", "false")
+            .insert("use", "optional")
+            .insert("help", "Prefilter the environment texture at the beginning of each frame so that preview renders can look up blurry reflections in one step"));
+
     return metadata;
 }
 
@@ -0,0 +1,269 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "prefilteredradiancemap.h"
+
+// appleseed.renderer headers.
+#include "renderer/modeling/environmentedf/sphericalcoordinates.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    // Blurrier levels are not subsampled below this height.
+    const size_t MinLevelHeight = 4;
+}
+
+
+//
+// PrefilteredRadianceMap class implementation.
+//
+
+PrefilteredRadianceMap::PrefilteredRadianceMap(
+    const size_t            width,
+    const size_t            height)
+  : m_levels(1)
+  , m_base_radius(Pi<float>() / height)
+{
+    assert(width > 0);
+    assert(height > 0);
+
+    m_levels[0].m_width = width;
+    m_levels[0].m_height = height;
+}
+
+bool PrefilteredRadianceMap::lookup(
+    const float             u,
+    const float             v,
+    const float             solid_angle,
+    Color3f&                value) const
+{
+    assert(!m_levels[0].m_texels.empty());
+
+    // Compute the radius of the cone from its solid angle, Omega = 2 Pi (1 - cos(radius)).
+    const float cos_radius = max(1.0f - solid_angle * RcpTwoPi<float>(), -1.0f);
+    const float radius = acos(cos_radius);
+
+    if (radius <= m_base_radius)
+        return false;
+
+    // The filter radius doubles from one level to the next.
+    const float max_level = static_cast<float>(m_levels.size() - 1);
+    const float level = min(log(radius / m_base_radius) / log(2.0f), max_level);
+    const size_t level0 = truncate<size_t>(level);
+    const float t = level - level0;
+
+    value = interpolate(m_levels[level0], u, v);
+
+    if (t > 0.0f)
+    {
+        value *= 1.0f - t;
+        value += interpolate(m_levels[level0 + 1], u, v) * t;
+    }
+
+    return true;
+}
+
+size_t PrefilteredRadianceMap::get_level_count() const
+{
+    return m_levels.size();
+}
+
+size_t PrefilteredRadianceMap::get_memory_size() const
+{
+    size_t size = sizeof(*this) + m_levels.capacity() * sizeof(Level);
+
+    for (size_t i = 0, e = m_levels.size(); i < e; ++i)
+        size += m_levels[i].m_texels.capacity() * sizeof(Color3f);
+
+    return size;
+}
+
+bool PrefilteredRadianceMap::build_levels(IAbortSwitch* abort_switch)
+{
+    // Stop once the filter covers a hemisphere, like the roughest lobes.
+    for (float radius = 2.0f * m_base_radius; 0.5f * radius < HalfPi<float>(); radius *= 2.0f)
+    {
+        m_levels.push_back(Level());
+
+        if (!build_level(m_levels[m_levels.size() - 2], radius, m_levels.back(), abort_switch))
+            return false;
+    }
+
+    return true;
+}
+
+bool PrefilteredRadianceMap::build_level(
+    const Level&            source,
+    const float             radius,
+    Level&                  level,
+    IAbortSwitch*           abort_switch) const
+{
+    level.m_height = max(source.m_height / 2, MinLevelHeight);
+    level.m_width = max(source.m_width / 2, 2 * MinLevelHeight);
+    level.m_texels.resize(level.m_width * level.m_height);
+
+    // Blur the source level with a kernel such that the variances of both filters add up
+    // to the variance of the filter of this level: sigma^2 = radius^2 - (radius / 2)^2.
+    const float sigma = 0.5f * sqrt(3.0f) * radius;
+    const float rcp_one_minus_cos_sigma = 1.0f / (1.0f - cos(sigma));
+
+    // Ignore texels where the weight of the kernel is negligible (below exp(-9)).
+    const float cutoff = min(3.0f * sigma, Pi<float>());
+    const float cos_cutoff = cos(cutoff);
+
+    // Precompute the spherical coordinates of the centers of the source texels.
+    vector<float> src_theta(source.m_height), src_cos_theta(source.m_height), src_sin_theta(source.m_height);
+    for (size_t y = 0; y < source.m_height; ++y)
+    {
+        float theta, phi;
+        unit_square_to_angles(0.0f, (y + 0.5f) / source.m_height, theta, phi);
+        src_theta[y] = theta;
+        src_cos_theta[y] = cos(theta);
+        src_sin_theta[y] = sin(theta);
+    }
+
+    vector<float> src_cos_phi(source.m_width), src_sin_phi(source.m_width);
+    for (size_t x = 0; x < source.m_width; ++x)
+    {
+        float theta, phi;
+        unit_square_to_angles((x + 0.5f) / source.m_width, 0.0f, theta, phi);
+        src_cos_phi[x] = cos(phi);
+        src_sin_phi[x] = sin(phi);
+    }
+
+    for (size_t y = 0; y < level.m_height; ++y)
+    {
+        if (is_aborted(abort_switch))
+            return false;
+
+        for (size_t x = 0; x < level.m_width; ++x)
+        {
+            float theta, phi;
+            unit_square_to_angles(
+                (x + 0.5f) / level.m_width,
+                (y + 0.5f) / level.m_height,
+                theta,
+                phi);
+
+            const float cos_theta = cos(theta);
+            const float sin_theta = sin(theta);
+            const float cos_phi = cos(phi);
+            const float sin_phi = sin(phi);
+
+            Color3f sum(0.0f);
+            float weight_sum = 0.0f;
+
+            for (size_t sy = 0; sy < source.m_height; ++sy)
+            {
+                if (abs(src_theta[sy] - theta) > cutoff)
+                    continue;
+
+                // The solid angle of a texel is proportional to the sine of its polar angle.
+                const float row_weight = src_sin_theta[sy];
+                const float cc = cos_theta * src_cos_theta[sy];
+                const float ss = sin_theta * src_sin_theta[sy];
+                const Color3f* row = &source.m_texels[sy * source.m_width];
+
+                for (size_t sx = 0; sx < source.m_width; ++sx)
+                {
+                    // Cosine of the angle between the directions of both texels.
+                    const float cos_angle =
+                        cc + ss * (cos_phi * src_cos_phi[sx] + sin_phi * src_sin_phi[sx]);
+
+                    if (cos_angle < cos_cutoff)
+                        continue;
+
+                    const float weight = row_weight * exp((cos_angle - 1.0f) * rcp_one_minus_cos_sigma);
+                    sum += row[sx] * weight;
+                    weight_sum += weight;
+                }
+            }
+
+            level.m_texels[y * level.m_width + x] =
+                weight_sum > 0.0f ? sum / weight_sum : Color3f(0.0f);
+        }
+    }
+
+    return true;
+}
+
+Color3f PrefilteredRadianceMap::interpolate(
+    const Level&            level,
+    const float             u,
+    const float             v)
+{
+    // Texel values are located at texel centers: wrap around horizontally, clamp vertically.
+    const float fx = u * level.m_width - 0.5f;
+    const float fy = v * level.m_height - 0.5f;
+    const float floor_fx = floor(fx);
+    const float floor_fy = floor(fy);
+    const float tx = fx - floor_fx;
+    float ty = fy - floor_fy;
+
+    const ptrdiff_t ix = static_cast<ptrdiff_t>(floor_fx);
+    const size_t x0 = static_cast<size_t>(ix < 0 ? ix + static_cast<ptrdiff_t>(level.m_width) : ix) % level.m_width;
+    const size_t x1 = x0 + 1 < level.m_width ? x0 + 1 : 0;
+
+    size_t y0, y1;
+    if (floor_fy < 0.0f)
+    {
+        y0 = y1 = 0;
+        ty = 0.0f;
+    }
+    else
+    {
+        y0 = min(static_cast<size_t>(floor_fy), level.m_height - 1);
+        y1 = min(y0 + 1, level.m_height - 1);
+    }
+
+    const Color3f* row0 = &level.m_texels[y0 * level.m_width];
+    const Color3f* row1 = &level.m_texels[y1 * level.m_width];
+
+    Color3f result = row0[x0] * ((1.0f - tx) * (1.0f - ty));
+    result += row0[x1] * (tx * (1.0f - ty));
+    result += row1[x0] * ((1.0f - tx) * ty);
+    result += row1[x1] * (tx * ty);
+
+    return result;
+}
+
+}   // namespace renderer
@@ -0,0 +1,185 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_RENDERER_MODELING_ENVIRONMENTEDF_PREFILTEREDRADIANCEMAP_H
+#define APPLESEED_RENDERER_MODELING_ENVIRONMENTEDF_PREFILTEREDRADIANCEMAP_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/color.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/job/iabortswitch.h"
+
+// Standard headers.
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace renderer
+{
+
+//
+// A latitude-longitude radiance map prefiltered into a chain of increasingly blurry
+// levels, indexed by the width of the filter. A single lookup returns the radiance
+// averaged over a cone of directions, which is what a rough glossy lobe integrates;
+// preview lighting engines use it instead of sampling the environment many times.
+//
+// Each level has half the resolution of the previous one (down to a few texels) and
+// twice the filter radius. The sharpest level averages the radiance over its texels.
+//
+// Coordinates are those of the latitude-longitude parameterization, in [0,1]^2.
+//
+
+class PrefilteredRadianceMap
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor. 'width' and 'height' are the resolution of the sharpest level.
+    PrefilteredRadianceMap(
+        const size_t                    width,
+        const size_t                    height);
+
+    // Average supersampling^2 radiance values over every texel of the sharpest level,
+    // then build the blurrier levels. Return false if the operation was aborted, in
+    // which case the map must not be used. The RadianceFunction type must conform to
+    // the following prototype:
+    //
+    //   class RadianceFunction
+    //   {
+    //     public:
+    //       void operator()(
+    //           const foundation::Vector2f&    uv,             // in [0,1)^2
+    //           foundation::Color3f&           value) const;
+    //   };
+    //
+    template <typename RadianceFunction>
+    bool build(
+        const RadianceFunction&         radiance_function,
+        const size_t                    supersampling,
+        foundation::IAbortSwitch*       abort_switch = 0);
+
+    // Return the radiance averaged over a cone of directions subtending a given solid
+    // angle around the direction at (u, v). Return false, leaving 'value' untouched,
+    // if the cone is narrower than the texels of the sharpest level.
+    bool lookup(
+        const float                     u,
+        const float                     v,
+        const float                     solid_angle,
+        foundation::Color3f&            value) const;
+
+    // Return the number of levels.
+    size_t get_level_count() const;
+
+    // Return the size in bytes of the map.
+    size_t get_memory_size() const;
+
+  private:
+    struct Level
+    {
+        size_t                          m_width;
+        size_t                          m_height;
+        std::vector<foundation::Color3f> m_texels;
+    };
+
+    std::vector<Level>                  m_levels;
+    const float                         m_base_radius;      // filter radius of the sharpest level, in radians
+
+    // Build the blurrier levels from the sharpest one.
+    bool build_levels(foundation::IAbortSwitch* abort_switch);
+
+    // Build a level by blurring the previous one.
+    bool build_level(
+        const Level&                    source,
+        const float                     radius,
+        Level&                          level,
+        foundation::IAbortSwitch*       abort_switch) const;
+
+    // Bilinearly interpolate a level at given [0,1]^2 coordinates.
+    static foundation::Color3f interpolate(
+        const Level&                    level,
+        const float                     u,
+        const float                     v);
+};
+
+
+//
+// PrefilteredRadianceMap class implementation.
+//
+
+template <typename RadianceFunction>
+bool PrefilteredRadianceMap::build(
+    const RadianceFunction&             radiance_function,
+    const size_t                        supersampling,
+    foundation::IAbortSwitch*           abort_switch)
+{
+    assert(supersampling > 0);
+
+    m_levels.resize(1);
+
+    Level& base = m_levels[0];
+    base.m_texels.resize(base.m_width * base.m_height);
+
+    const float rcp_supersampling = 1.0f / supersampling;
+
+    for (size_t y = 0; y < base.m_height; ++y)
+    {
+        if (foundation::is_aborted(abort_switch))
+            return false;
+
+        for (size_t x = 0; x < base.m_width; ++x)
+        {
+            foundation::Color3f sum(0.0f);
+
+            for (size_t j = 0; j < supersampling; ++j)
+            {
+                for (size_t i = 0; i < supersampling; ++i)
+                {
+                    const foundation::Vector2f uv(
+                        (x + (i + 0.5f) * rcp_supersampling) / base.m_width,
+                        (y + (j + 0.5f) * rcp_supersampling) / base.m_height);
+
+                    foundation::Color3f value;
+                    radiance_function(uv, value);
+
+                    // Texels with infinite components would spread to the whole level.
+                    if (foundation::is_finite(value))
+                        sum += value;
+                }
+            }
+
+            base.m_texels[y * base.m_width + x] = sum * (rcp_supersampling * rcp_supersampling);
+        }
+    }
+
+    return build_levels(abort_switch);
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_MODELING_ENVIRONMENTEDF_PREFILTEREDRADIANCEMAP_H
@@ -0,0 +1,187 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Interface header.
+#include "skyradiancetable.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/colorspace.h"
+#include "foundation/math/fp.h"
+#include "foundation/math/scalar.h"
+
+// Standard headers.
+#include <cassert>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// SkyRadianceTable class implementation.
+//
+
+SkyRadianceTable::SkyRadianceTable(
+    const size_t            width,
+    const size_t            height)
+  : m_width(width)
+  , m_height(height)
+  , m_probability_scale((width * height) / (2.0f * PiSquare<float>()))
+{
+    assert(width > 0);
+    assert(height > 0);
+}
+
+void SkyRadianceTable::lookup(
+    const Vector3f&         direction,
+    Spectrum&               value) const
+{
+    assert(m_importance_sampler.get());
+
+    float theta, phi;
+    unit_vector_to_angles(direction, theta, phi);
+
+    float u, v;
+    angles_to_unit_square(theta, phi, u, v);
+
+    value = interpolate(&m_radiance[0], u, v);
+}
+
+void SkyRadianceTable::sample(
+    const Vector2f&         s,
+    Vector3f&               direction,
+    Spectrum&               value,
+    float&                  probability) const
+{
+    assert(m_importance_sampler.get());
+
+    // Sample the importance map.
+    size_t x, y;
+    Vector2f pixel_s;
+    float prob_xy;
+    m_importance_sampler->sample(s, x, y, pixel_s, prob_xy);
+
+    // Compute the coordinates in [0,1)^2 of the sample, anywhere within the chosen texel.
+    const float OneMinusEps = shift(1.0f, -1);
+    const float u = min((x + pixel_s[0]) / m_width, OneMinusEps);
+    float v = min((y + pixel_s[1]) / m_height, OneMinusEps);
+
+    float theta, phi;
+    unit_square_to_angles(u, v, theta, phi);
+
+    // The density of directions is infinite at the poles: use the center of the texel instead.
+    if (sin(theta) == 0.0f)
+    {
+        v = (y + 0.5f) / m_height;
+        unit_square_to_angles(u, v, theta, phi);
+    }
+
+    direction = Vector3f::make_unit_vector(theta, phi);
+
+    // Look the radiance up exactly as lookup() would to return consistent values.
+    lookup(direction, value);
+
+    probability = prob_xy * m_probability_scale / sin(theta);
+}
+
+float SkyRadianceTable::evaluate_pdf(const Vector3f& direction) const
+{
+    assert(m_importance_sampler.get());
+
+    float theta, phi;
+    unit_vector_to_angles(direction, theta, phi);
+
+    const float sin_theta = sin(theta);
+    if (sin_theta == 0.0f)
+        return 0.0f;
+
+    float u, v;
+    angles_to_unit_square(theta, phi, u, v);
+
+    const size_t x = min(truncate<size_t>(u * m_width), m_width - 1);
+    const size_t y = min(truncate<size_t>(v * m_height), m_height - 1);
+
+    return m_importance_sampler->get_pdf(x, y) * m_probability_scale / sin_theta;
+}
+
+size_t SkyRadianceTable::get_memory_size() const
+{
+    size_t size = sizeof(*this) + m_radiance.capacity() * sizeof(RegularSpectrum31f);
+
+    if (m_importance_sampler.get())
+        size += m_importance_sampler->get_memory_size();
+
+    return size;
+}
+
+void SkyRadianceTable::build_importance_sampler()
+{
+    const size_t texel_count = m_width * m_height;
+
+    vector<float> texel_luminance(texel_count);
+    for (size_t i = 0; i < texel_count; ++i)
+        texel_luminance[i] = sum_value(m_radiance[i] * XYZCMFCIE19312Deg[1]);
+
+    // The importance of a texel is its average interpolated luminance, estimated from its
+    // center and corners so that every direction with nonzero radiance can be sampled,
+    // weighted by the solid angle covered by the texel.
+    vector<float> importance(texel_count);
+
+    for (size_t y = 0; y < m_height; ++y)
+    {
+        const float v0 = static_cast<float>(y) / m_height;
+        const float v1 = static_cast<float>(y + 1) / m_height;
+        const float vc = (y + 0.5f) / m_height;
+        const float sin_theta = sin(Pi<float>() * vc);
+
+        for (size_t x = 0; x < m_width; ++x)
+        {
+            const float u0 = static_cast<float>(x) / m_width;
+            const float u1 = static_cast<float>(x + 1) / m_width;
+            const float uc = (x + 0.5f) / m_width;
+
+            const float average_luminance =
+                ( interpolate(&texel_luminance[0], uc, vc)
+                + interpolate(&texel_luminance[0], u0, v0)
+                + interpolate(&texel_luminance[0], u1, v0)
+                + interpolate(&texel_luminance[0], u0, v1)
+                + interpolate(&texel_luminance[0], u1, v1)) * 0.2f;
+
+            importance[y * m_width + x] = average_luminance * sin_theta;
+        }
+    }
+
+    m_importance_sampler.reset(new ImportanceSamplerType(m_width, m_height));
+    m_importance_sampler->set_importance(importance);
+}
+
+}   // namespace renderer
@@ -0,0 +1,220 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#ifndef APPLESEED_RENDERER_MODELING_ENVIRONMENTEDF_SKYRADIANCETABLE_H
+#define APPLESEED_RENDERER_MODELING_ENVIRONMENTEDF_SKYRADIANCETABLE_H
+
+// appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
+#include "renderer/modeling/environmentedf/sphericalcoordinates.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/regularspectrum.h"
+#include "foundation/math/sampling/hierarchicalimportancesampler.h"
+#include "foundation/math/vector.h"
+#include "foundation/utility/alignedvector.h"
+#include "foundation/utility/job/iabortswitch.h"
+
+// Standard headers.
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+
+namespace renderer
+{
+
+//
+// A latitude-longitude table of the radiance emitted by an analytic sky, with bilinear
+// lookups and an importance sampler built from the same table. Sky models bake their
+// radiance into such a table once per frame instead of evaluating their model along
+// every direction, and get importance sampling of the sky for free.
+//
+// Directions are expressed in the local space of the environment EDF.
+//
+
+class SkyRadianceTable
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    SkyRadianceTable(
+        const size_t                    width,
+        const size_t                    height);
+
+    // Evaluate the radiance at the center of every texel and build the importance sampler.
+    // Return false if the operation was aborted, in which case the table must not be used.
+    // The RadianceFunction type must conform to the following prototype:
+    //
+    //   class RadianceFunction
+    //   {
+    //     public:
+    //       void operator()(
+    //           const foundation::Vector3f&    direction,      // unit-length, local space
+    //           Spectrum&                      value) const;
+    //   };
+    //
+    template <typename RadianceFunction>
+    bool build(
+        const RadianceFunction&         radiance_function,
+        foundation::IAbortSwitch*       abort_switch = 0);
+
+    // Return the interpolated radiance along a given direction.
+    void lookup(
+        const foundation::Vector3f&     direction,          // unit-length, local space
+        Spectrum&                       value) const;
+
+    // Sample the table and return the sampled direction, the radiance along
+    // this direction and the probability density with respect to solid angle.
+    void sample(
+        const foundation::Vector2f&     s,
+        foundation::Vector3f&           direction,          // unit-length, local space
+        Spectrum&                       value,
+        float&                          probability) const;
+
+    // Return the probability density with respect to solid angle of a given direction.
+    float evaluate_pdf(
+        const foundation::Vector3f&     direction) const;   // unit-length, local space
+
+    // Return the size in bytes of the table and of the importance sampler.
+    size_t get_memory_size() const;
+
+  private:
+    typedef foundation::AlignedVector<foundation::RegularSpectrum31f> RadianceVector;
+    typedef foundation::HierarchicalImportanceSampler<float> ImportanceSamplerType;
+
+    const size_t                            m_width;
+    const size_t                            m_height;
+    const float                             m_probability_scale;
+    RadianceVector                          m_radiance;
+    std::auto_ptr<ImportanceSamplerType>    m_importance_sampler;
+
+    void build_importance_sampler();
+
+    // Bilinearly interpolate a table of width * height texel values at given [0,1]^2 coordinates.
+    template <typename T>
+    T interpolate(
+        const T*                        texels,
+        const float                     u,
+        const float                     v) const;
+
+    float compute_pdf(
+        const float                     u,
+        const float                     v,
+        const float                     sin_theta) const;
+};
+
+
+//
+// SkyRadianceTable class implementation.
+//
+
+template <typename RadianceFunction>
+bool SkyRadianceTable::build(
+    const RadianceFunction&             radiance_function,
+    foundation::IAbortSwitch*           abort_switch)
+{
+    m_radiance.resize(m_width * m_height);
+
+    Spectrum value(Spectrum::Illuminance);
+
+    for (size_t y = 0; y < m_height; ++y)
+    {
+        if (foundation::is_aborted(abort_switch))
+            return false;
+
+        for (size_t x = 0; x < m_width; ++x)
+        {
+            float theta, phi;
+            unit_square_to_angles(
+                (x + 0.5f) / m_width,
+                (y + 0.5f) / m_height,
+                theta,
+                phi);
+
+            radiance_function(foundation::Vector3f::make_unit_vector(theta, phi), value);
+
+            if (value.is_rgb())
+                Spectrum::upgrade(value, value);
+
+            m_radiance[y * m_width + x] = foundation::RegularSpectrum31f(&value[0]);
+        }
+    }
+
+    build_importance_sampler();
+
+    return true;
+}
+
+template <typename T>
+T SkyRadianceTable::interpolate(
+    const T*                            texels,
+    const float                         u,
+    const float                         v) const
+{
+    // Texel values are located at texel centers: wrap around horizontally, clamp vertically.
+    const float fx = u * m_width - 0.5f;
+    const float fy = v * m_height - 0.5f;
+    const float floor_fx = std::floor(fx);
+    const float floor_fy = std::floor(fy);
+    const float tx = fx - floor_fx;
+    float ty = fy - floor_fy;
+
+    const std::ptrdiff_t ix = static_cast<std::ptrdiff_t>(floor_fx);
+    const size_t x0 = static_cast<size_t>(ix < 0 ? ix + static_cast<std::ptrdiff_t>(m_width) : ix) % m_width;
+    const size_t x1 = x0 + 1 < m_width ? x0 + 1 : 0;
+
+    size_t y0, y1;
+    if (floor_fy < 0.0f)
+    {
+        y0 = y1 = 0;
+        ty = 0.0f;
+    }
+    else
+    {
+        y0 = std::min(static_cast<size_t>(floor_fy), m_height - 1);
+        y1 = std::min(y0 + 1, m_height - 1);
+    }
+
+    const T* row0 = texels + y0 * m_width;
+    const T* row1 = texels + y1 * m_width;
+
+    T result = row0[x0] * ((1.0f - tx) * (1.0f - ty));
+    result += row0[x1] * (tx * (1.0f - ty));
+    result += row1[x0] * ((1.0f - tx) * ty);
+    result += row1[x1] * (tx * ty);
+
+    return result;
+}
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_MODELING_ENVIRONMENTEDF_SKYRADIANCETABLE_H
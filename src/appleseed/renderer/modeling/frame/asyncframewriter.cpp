@@ -0,0 +1,279 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Interface header.
+#include "asyncframewriter.h"
+
+// appleseed.renderer headers.
+#include "renderer/kernel/aov/imagestack.h"
+#include "renderer/modeling/frame/frame.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/image.h"
+#include "foundation/image/imageattributes.h"
+#include "foundation/platform/thread.h"
+
+// Boost headers.
+#include "boost/bind.hpp"
+#include "boost/thread/condition_variable.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// AsyncFrameWriter class implementation.
+//
+
+namespace
+{
+    size_t get_image_size(const Image& image)
+    {
+        const CanvasProperties& props = image.properties();
+        return props.m_pixel_count * props.m_pixel_size;
+    }
+
+    size_t get_snapshot_size(const Frame& frame, const bool write_aovs)
+    {
+        size_t size = get_image_size(frame.image());
+
+        if (write_aovs)
+        {
+            const ImageStack& aov_images = frame.aov_images();
+
+            for (size_t i = 0; i < aov_images.size(); ++i)
+                size += get_image_size(aov_images.get_image(i));
+        }
+
+        return size;
+    }
+
+    // Copies of the images of a frame, waiting to be written.
+    struct FrameSnapshot
+      : public NonCopyable
+    {
+        const Frame&        m_frame;
+        const string        m_file_path;
+        const size_t        m_size;
+        Image               m_main_image;
+        vector<Image*>      m_aov_images;
+
+        FrameSnapshot(
+            const Frame&    frame,
+            const char*     file_path,
+            const bool      write_aovs)
+          : m_frame(frame)
+          , m_file_path(file_path)
+          , m_size(get_snapshot_size(frame, write_aovs))
+          , m_main_image(frame.image())
+        {
+            if (write_aovs)
+            {
+                const ImageStack& aov_images = frame.aov_images();
+
+                for (size_t i = 0; i < aov_images.size(); ++i)
+                    m_aov_images.push_back(new Image(aov_images.get_image(i)));
+            }
+        }
+
+        ~FrameSnapshot()
+        {
+            for (size_t i = 0; i < m_aov_images.size(); ++i)
+                delete m_aov_images[i];
+        }
+    };
+}
+
+struct AsyncFrameWriter::Impl
+{
+    const size_t                m_max_pending_bytes;
+
+    boost::mutex                m_mutex;
+    boost::condition_variable   m_queue_changed;
+    deque<FrameSnapshot*>       m_queue;
+    size_t                      m_pending_bytes;        // size of the queued and in-flight snapshots
+    size_t                      m_active_count;         // number of snapshots being written
+    bool                        m_succeeded;
+    bool                        m_terminate;
+
+    boost::thread_group         m_threads;
+
+    explicit Impl(const size_t max_pending_bytes)
+      : m_max_pending_bytes(max_pending_bytes)
+      , m_pending_bytes(0)
+      , m_active_count(0)
+      , m_succeeded(true)
+      , m_terminate(false)
+    {
+    }
+
+    void run()
+    {
+        while (true)
+        {
+            FrameSnapshot* snapshot;
+
+            {
+                boost::mutex::scoped_lock lock(m_mutex);
+
+                while (m_queue.empty() && !m_terminate)
+                    m_queue_changed.wait(lock);
+
+                if (m_queue.empty())
+                    return;
+
+                snapshot = m_queue.front();
+                m_queue.pop_front();
+                ++m_active_count;
+            }
+
+            const bool succeeded = write(*snapshot);
+            const size_t snapshot_size = snapshot->m_size;
+            delete snapshot;
+
+            {
+                boost::mutex::scoped_lock lock(m_mutex);
+
+                if (!succeeded)
+                    m_succeeded = false;
+
+                m_pending_bytes -= snapshot_size;
+                --m_active_count;
+            }
+
+            m_queue_changed.notify_all();
+        }
+    }
+
+    static bool write(FrameSnapshot& snapshot)
+    {
+        const Frame& frame = snapshot.m_frame;
+
+        const ImageAttributes image_attributes =
+            ImageAttributes::create_default_attributes();
+
+        // Color space conversion happens on the writer thread as well.
+        frame.transform_to_output_color_space(snapshot.m_main_image);
+
+        bool result =
+            frame.write_image(
+                snapshot.m_file_path.c_str(),
+                snapshot.m_main_image,
+                image_attributes);
+
+        // Note: AOVs are always in the linear color space.
+        for (size_t i = 0; i < snapshot.m_aov_images.size(); ++i)
+        {
+            const string aov_file_path =
+                frame.get_aov_image_file_path(snapshot.m_file_path.c_str(), i);
+
+            if (!frame.write_image(
+                    aov_file_path.c_str(),
+                    *snapshot.m_aov_images[i],
+                    image_attributes))
+                result = false;
+        }
+
+        return result;
+    }
+};
+
+AsyncFrameWriter::AsyncFrameWriter(
+    const size_t    thread_count,
+    const size_t    max_pending_bytes)
+  : impl(new Impl(max_pending_bytes))
+{
+    for (size_t i = 0; i < max<size_t>(thread_count, 1); ++i)
+        impl->m_threads.create_thread(boost::bind(&Impl::run, impl));
+}
+
+AsyncFrameWriter::~AsyncFrameWriter()
+{
+    {
+        boost::mutex::scoped_lock lock(impl->m_mutex);
+        impl->m_terminate = true;
+    }
+
+    // Writer threads only exit once the queue is empty.
+    impl->m_queue_changed.notify_all();
+    impl->m_threads.join_all();
+
+    delete impl;
+}
+
+void AsyncFrameWriter::write(
+    const Frame&    frame,
+    const char*     file_path,
+    const bool      write_aovs)
+{
+    assert(file_path);
+
+    const size_t snapshot_size = get_snapshot_size(frame, write_aovs);
+
+    // Bound the memory held by pending frames, reserving it before copying the images.
+    {
+        boost::mutex::scoped_lock lock(impl->m_mutex);
+
+        while (impl->m_pending_bytes > 0 &&
+               impl->m_pending_bytes + snapshot_size > impl->m_max_pending_bytes)
+            impl->m_queue_changed.wait(lock);
+
+        impl->m_pending_bytes += snapshot_size;
+    }
+
+    FrameSnapshot* snapshot = new FrameSnapshot(frame, file_path, write_aovs);
+
+    {
+        boost::mutex::scoped_lock lock(impl->m_mutex);
+        impl->m_queue.push_back(snapshot);
+    }
+
+    impl->m_queue_changed.notify_all();
+}
+
+bool AsyncFrameWriter::flush()
+{
+    boost::mutex::scoped_lock lock(impl->m_mutex);
+
+    while (!impl->m_queue.empty() || impl->m_active_count > 0)
+        impl->m_queue_changed.wait(lock);
+
+    return impl->m_succeeded;
+}
+
+}   // namespace renderer
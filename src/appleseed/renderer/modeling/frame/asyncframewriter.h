@@ -0,0 +1,85 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef APPLESEED_RENDERER_MODELING_FRAME_ASYNCFRAMEWRITER_H
+#define APPLESEED_RENDERER_MODELING_FRAME_ASYNCFRAMEWRITER_H
+
+// appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace renderer      { class Frame; }
+
+namespace renderer
+{
+
+//
+// Writes the main image and the AOV images of frames to disk on a pool of writer
+// threads, so that rendering can continue while images are encoded and written.
+//
+// The images of a frame are copied when the frame is queued. Queuing blocks while
+// the copies waiting to be written would exceed a given memory budget; a frame is
+// always accepted when nothing is waiting, whatever its size. Pending frames are
+// written before the writer is destroyed. Queued frames must outlive the writer.
+//
+
+class APPLESEED_DLLSYMBOL AsyncFrameWriter
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    AsyncFrameWriter(
+        const size_t    thread_count,
+        const size_t    max_pending_bytes);
+
+    // Destructor, waits until all queued frames are written.
+    ~AsyncFrameWriter();
+
+    // Queue the main image of a frame, and optionally its AOV images, for writing.
+    void write(
+        const Frame&    frame,
+        const char*     file_path,
+        const bool      write_aovs);
+
+    // Wait until all queued frames are written.
+    // Return true if all images written so far were written successfully.
+    bool flush();
+
+  private:
+    struct Impl;
+    Impl* impl;
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_MODELING_FRAME_ASYNCFRAMEWRITER_H
@@ -33,6 +33,7 @@
 // appleseed.renderer headers.
 #include "renderer/global/globallogger.h"
 #include "renderer/kernel/aov/imagestack.h"
+#include "renderer/kernel/rendering/convergenceestimator.h"
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
@@ -40,6 +41,7 @@
 #include "foundation/core/exceptions/exceptionioerror.h"
 #include "foundation/core/exceptions/exceptionunsupportedfileformat.h"
 #include "foundation/image/color.h"
+#include "foundation/image/deepexrimagefilewriter.h"
 #include "foundation/image/exceptionunsupportedimageformat.h"
 #include "foundation/image/exrimagefilewriter.h"
 #include "foundation/image/genericimagefilewriter.h"
@@ -55,6 +57,8 @@
 #include "foundation/platform/timers.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/eventtracer.h"
+#include "foundation/utility/foreach.h"
 #include "foundation/utility/iostreamop.h"
 #include "foundation/utility/otherwise.h"
 #include "foundation/utility/stopwatch.h"
@@ -64,9 +68,12 @@
 #include "boost/filesystem/path.hpp"
 
 // Standard headers.
+#include <algorithm>
 #include <cmath>
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 using namespace std;
@@ -82,6 +89,25 @@ namespace renderer
 namespace
 {
     const UniqueID g_class_uid = new_guid();
+
+    bool parse_pixel_format(const string& s, PixelFormat& pixel_format)
+    {
+        if (s == "uint8")
+            pixel_format = PixelFormatUInt8;
+        else if (s == "uint16")
+            pixel_format = PixelFormatUInt16;
+        else if (s == "uint32")
+            pixel_format = PixelFormatUInt32;
+        else if (s == "half")
+            pixel_format = PixelFormatHalf;
+        else if (s == "float")
+            pixel_format = PixelFormatFloat;
+        else if (s == "double")
+            pixel_format = PixelFormatDouble;
+        else return false;
+
+        return true;
+    }
 }
 
 UniqueID Frame::get_class_uid()
@@ -104,9 +130,16 @@ struct Frame::Impl
     float                   m_rcp_target_gamma;
     LightingConditions      m_lighting_conditions;
     AABB2u                  m_crop_window;
+    map<string, PixelFormat> m_aov_pixel_formats;
+    bool                    m_compress_aov_tiles;
+    size_t                  m_deep_max_fragment_count;
+    float                   m_deep_depth_tolerance;
+    string                  m_deep_file_path;
+    auto_ptr<DeepEXRImageFileWriter> m_deep_writer;
 
     auto_ptr<Image>         m_image;
     auto_ptr<ImageStack>    m_aov_images;
+    ConvergenceEstimator    m_convergence_estimator;
 
     Impl()
       : m_lighting_conditions(IlluminantCIED65, XYZCMFCIE196410Deg)
@@ -158,6 +191,14 @@ void Frame::release()
 
 void Frame::print_settings()
 {
+    string aov_formats;
+    for (const_each<map<string, PixelFormat> > i = impl->m_aov_pixel_formats; i; ++i)
+    {
+        if (!aov_formats.empty())
+            aov_formats += ", ";
+        aov_formats += i->first + ": " + pixel_format_name(i->second);
+    }
+
     RENDERER_LOG_INFO(
         "frame settings:\n"
         "  camera           %s\n"
@@ -170,6 +211,9 @@ void Frame::print_settings()
         "  premult. alpha   %s\n"
         "  clamping         %s\n"
         "  gamma correction %f\n"
+        "  denoising        %s\n"
+        "  AOV formats      %s\n"
+        "  AOV compression  %s\n"
         "  crop window      (%s, %s)-(%s, %s)",
         get_active_camera_name(),
         pretty_uint(impl->m_frame_width).c_str(),
@@ -183,6 +227,9 @@ void Frame::print_settings()
         m_is_premultiplied_alpha ? "on" : "off",
         impl->m_clamp ? "on" : "off",
         impl->m_target_gamma,
+        m_is_denoising_enabled ? "on" : "off",
+        aov_formats.empty() ? "default" : aov_formats.c_str(),
+        impl->m_compress_aov_tiles ? "on" : "off",
         pretty_uint(impl->m_crop_window.min[0]).c_str(),
         pretty_uint(impl->m_crop_window.min[1]).c_str(),
         pretty_uint(impl->m_crop_window.max[0]).c_str(),
@@ -207,11 +254,41 @@ ImageStack& Frame::aov_images() const
     return *impl->m_aov_images.get();
 }
 
+ConvergenceEstimator& Frame::get_convergence_estimator() const
+{
+    return impl->m_convergence_estimator;
+}
+
 const Filter2f& Frame::get_filter() const
 {
     return *impl->m_filter.get();
 }
 
+PixelFormat Frame::get_aov_pixel_format(
+    const char*         aov_name,
+    const PixelFormat   default_format) const
+{
+    const map<string, PixelFormat>::const_iterator i =
+        impl->m_aov_pixel_formats.find(aov_name);
+
+    return i != impl->m_aov_pixel_formats.end() ? i->second : default_format;
+}
+
+bool Frame::is_aov_tile_compression_enabled() const
+{
+    return impl->m_compress_aov_tiles;
+}
+
+size_t Frame::get_deep_max_fragment_count() const
+{
+    return impl->m_deep_max_fragment_count;
+}
+
+float Frame::get_deep_depth_tolerance() const
+{
+    return impl->m_deep_depth_tolerance;
+}
+
 const LightingConditions& Frame::get_lighting_conditions() const
 {
     return impl->m_lighting_conditions;
@@ -326,12 +403,61 @@ namespace
     >
     void transform_float_tile(Tile& tile, const float rcp_target_gamma)
     {
-        assert(ColorSpace == ColorSpaceLinearRGB || ColorSpace == ColorSpaceSRGB);
         assert(tile.get_channel_count() == 4);
 
         float* pixel_ptr = reinterpret_cast<float*>(tile.pixel(0));
         float* pixel_end = pixel_ptr + tile.get_pixel_count() * 4;
 
+        // Transform four pixels at a time, with one color component per vector.
+        // The alpha channel is left untouched.
+        for (; pixel_ptr + 16 <= pixel_end; pixel_ptr += 16)
+        {
+            // Load the pixel colors.
+            __m128 r = _mm_load_ps(pixel_ptr);
+            __m128 g = _mm_load_ps(pixel_ptr + 4);
+            __m128 b = _mm_load_ps(pixel_ptr + 8);
+            __m128 a = _mm_load_ps(pixel_ptr + 12);
+            _MM_TRANSPOSE4_PS(r, g, b, a);
+
+            // Apply color space conversion.
+            if (ColorSpace == ColorSpaceSRGB)
+            {
+                r = fast_linear_rgb_to_srgb(r);
+                g = fast_linear_rgb_to_srgb(g);
+                b = fast_linear_rgb_to_srgb(b);
+            }
+            else if (ColorSpace == ColorSpaceCIEXYZ)
+                linear_rgb_to_ciexyz(r, g, b);
+
+            // Apply clamping.
+            // todo: mark clamped pixels in the diagnostic map.
+            if (Clamp)
+            {
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 one = _mm_set1_ps(1.0f);
+                r = _mm_min_ps(_mm_max_ps(r, zero), one);
+                g = _mm_min_ps(_mm_max_ps(g, zero), one);
+                b = _mm_min_ps(_mm_max_ps(b, zero), one);
+            }
+
+            // Apply gamma correction.
+            if (GammaCorrect)
+            {
+                const __m128 exponent = _mm_set1_ps(rcp_target_gamma);
+                r = fast_pow(r, exponent);
+                g = fast_pow(g, exponent);
+                b = fast_pow(b, exponent);
+            }
+
+            // Store the pixel colors.
+            _MM_TRANSPOSE4_PS(r, g, b, a);
+            _mm_store_ps(pixel_ptr, r);
+            _mm_store_ps(pixel_ptr + 4, g);
+            _mm_store_ps(pixel_ptr + 8, b);
+            _mm_store_ps(pixel_ptr + 12, a);
+        }
+
+        // Transform the remaining pixels one at a time.
         for (; pixel_ptr < pixel_end; pixel_ptr += 4)
         {
             // Load the pixel color.
@@ -341,6 +467,14 @@ namespace
             // Apply color space conversion.
             if (ColorSpace == ColorSpaceSRGB)
                 color = fast_linear_rgb_to_srgb(color);
+            else if (ColorSpace == ColorSpaceCIEXYZ)
+            {
+                __m128 r = _mm_shuffle_ps(color, color, _MM_SHUFFLE(0, 0, 0, 0));
+                __m128 g = _mm_shuffle_ps(color, color, _MM_SHUFFLE(1, 1, 1, 1));
+                __m128 b = _mm_shuffle_ps(color, color, _MM_SHUFFLE(2, 2, 2, 2));
+                linear_rgb_to_ciexyz(r, g, b);
+                color = _mm_movelh_ps(_mm_unpacklo_ps(r, g), b);
+            }
 
             // Apply clamping.
             // todo: mark clamped pixels in the diagnostic map.
@@ -365,7 +499,6 @@ namespace
     >
     void transform_float_tile(Tile& tile, const float rcp_target_gamma)
     {
-        assert(ColorSpace == ColorSpaceLinearRGB || ColorSpace == ColorSpaceSRGB);
         assert(tile.get_channel_count() == 4);
 
         Color4f* pixel_ptr = reinterpret_cast<Color4f*>(tile.pixel(0));
@@ -379,6 +512,8 @@ namespace
             // Apply color space conversion.
             if (ColorSpace == ColorSpaceSRGB)
                 color.rgb() = fast_linear_rgb_to_srgb(color.rgb());
+            else if (ColorSpace == ColorSpaceCIEXYZ)
+                color.rgb() = linear_rgb_to_ciexyz(color.rgb());
 
             // Apply clamping.
             // todo: mark clamped pixels in the diagnostic map.
@@ -444,7 +579,7 @@ void Frame::transform_to_output_color_space(Tile& tile) const
             break;
 
           case ColorSpaceCIEXYZ:
-            TRANSFORM_GENERIC_TILE(ColorSpaceCIEXYZ);
+            TRANSFORM_FLOAT_TILE(ColorSpaceCIEXYZ);
             break;
 
           assert_otherwise;
@@ -494,6 +629,8 @@ bool Frame::write_main_image(const char* file_path) const
 {
     assert(file_path);
 
+    ScopedTraceEvent event("main image write", "frame");
+
     Image transformed_image(*impl->m_image);
     transform_to_output_color_space(transformed_image);
 
@@ -507,37 +644,192 @@ bool Frame::write_aov_images(const char* file_path) const
 {
     assert(file_path);
 
+    ScopedTraceEvent event("aov images write", "frame");
+
     const ImageAttributes image_attributes =
         ImageAttributes::create_default_attributes();
 
     bool result = true;
 
-    if (!impl->m_aov_images->empty())
+    for (size_t i = 0; i < impl->m_aov_images->size(); ++i)
     {
-        const bf::path boost_file_path(file_path);
-        const bf::path directory = boost_file_path.parent_path();
-        const string base_file_name = boost_file_path.stem().string();
-        const string extension = boost_file_path.extension().string();
-
-        for (size_t i = 0; i < impl->m_aov_images->size(); ++i)
-        {
-            const string aov_name = impl->m_aov_images->get_name(i);
-            const string safe_aov_name = make_safe_filename(aov_name);
-            const string aov_file_name = base_file_name + "." + safe_aov_name + extension;
-            const string aov_file_path = (directory / aov_file_name).string();
-
-            // Note: AOVs are always in the linear color space.
-            if (!write_image(
-                    aov_file_path.c_str(),
-                    impl->m_aov_images->get_image(i),
-                    image_attributes))
-                result = false;
-        }
+        const string aov_file_path = get_aov_image_file_path(file_path, i);
+
+        // Note: AOVs are always in the linear color space.
+        if (!write_image(
+                aov_file_path.c_str(),
+                impl->m_aov_images->get_image(i),
+                image_attributes))
+            result = false;
     }
 
     return result;
 }
 
+bool Frame::write_main_and_aov_images_to_multilayer_exr(const char* file_path) const
+{
+    assert(file_path);
+
+    ScopedTraceEvent event("multilayer image write", "frame");
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    Image transformed_image(*impl->m_image);
+    transform_to_output_color_space(transformed_image);
+
+    // The main image goes into the unnamed layer, AOVs into layers named after them.
+    // Note: AOVs are always in the linear color space.
+    const size_t layer_count = impl->m_aov_images->size() + 1;
+    vector<string> layer_names(layer_count);
+    vector<const char*> layer_name_ptrs(layer_count);
+    vector<const ICanvas*> images(layer_count);
+    images[0] = &transformed_image;
+    for (size_t i = 0; i < impl->m_aov_images->size(); ++i)
+    {
+        layer_names[i + 1] = impl->m_aov_images->get_name(i);
+        images[i + 1] = &impl->m_aov_images->get_image(i);
+    }
+    for (size_t i = 0; i < layer_count; ++i)
+        layer_name_ptrs[i] = layer_names[i].c_str();
+
+    try
+    {
+        EXRImageFileWriter writer;
+        writer.write_layers(
+            file_path,
+            layer_count,
+            &layer_name_ptrs[0],
+            &images[0],
+            ImageAttributes::create_default_attributes());
+    }
+    catch (const ExceptionUnsupportedImageFormat&)
+    {
+        RENDERER_LOG_ERROR(
+            "failed to write image file %s: unsupported image format.",
+            file_path);
+
+        return false;
+    }
+    catch (const ExceptionIOError&)
+    {
+        RENDERER_LOG_ERROR(
+            "failed to write image file %s: i/o error.",
+            file_path);
+
+        return false;
+    }
+    catch (const Exception& e)
+    {
+        RENDERER_LOG_ERROR(
+            "failed to write image file %s: %s.",
+            file_path,
+            e.what());
+
+        return false;
+    }
+
+    stopwatch.measure();
+
+    RENDERER_LOG_INFO(
+        "wrote image file %s with %s layer%s in %s.",
+        file_path,
+        pretty_uint(layer_count).c_str(),
+        layer_count > 1 ? "s" : "",
+        pretty_time(stopwatch.get_seconds()).c_str());
+
+    return true;
+}
+
+bool Frame::open_deep_output(const char* file_path)
+{
+    assert(file_path);
+
+    if (!close_deep_output())
+        return false;
+
+    try
+    {
+        impl->m_deep_writer.reset(new DeepEXRImageFileWriter());
+        impl->m_deep_writer->open(
+            file_path,
+            impl->m_image->properties(),
+            ImageAttributes::create_default_attributes());
+    }
+    catch (const Exception& e)
+    {
+        RENDERER_LOG_ERROR(
+            "failed to create deep image file %s: %s.",
+            file_path,
+            e.what());
+
+        impl->m_deep_writer.reset();
+        return false;
+    }
+
+    impl->m_deep_file_path = file_path;
+
+    RENDERER_LOG_INFO(
+        "writing deep fragments to %s (at most %s per pixel).",
+        file_path,
+        pretty_uint(impl->m_deep_max_fragment_count).c_str());
+
+    return true;
+}
+
+bool Frame::close_deep_output()
+{
+    if (!is_deep_output_open())
+        return true;
+
+    bool success = true;
+
+    try
+    {
+        impl->m_deep_writer->close();
+    }
+    catch (const Exception& e)
+    {
+        RENDERER_LOG_ERROR(
+            "failed to write deep image file %s: %s.",
+            impl->m_deep_file_path.c_str(),
+            e.what());
+
+        success = false;
+    }
+
+    impl->m_deep_writer.reset();
+
+    return success;
+}
+
+bool Frame::is_deep_output_open() const
+{
+    return impl->m_deep_writer.get() != 0;
+}
+
+void Frame::write_deep_tile(
+    const size_t        tile_x,
+    const size_t        tile_y,
+    const DeepTile&     tile) const
+{
+    assert(is_deep_output_open());
+
+    try
+    {
+        impl->m_deep_writer->write_tile(tile_x, tile_y, tile);
+    }
+    catch (const Exception& e)
+    {
+        RENDERER_LOG_ERROR(
+            "failed to write tile (" FMT_SIZE_T ", " FMT_SIZE_T ") to deep image file %s: %s.",
+            tile_x,
+            tile_y,
+            impl->m_deep_file_path.c_str(),
+            e.what());
+    }
+}
+
 bool Frame::archive(
     const char*         directory,
     char**              output_path) const
@@ -611,19 +903,7 @@ void Frame::extract_parameters()
         const char* DefaultPixelFormatString = "half";
         const string pixel_format_str =
             m_params.get_optional<string>("pixel_format", DefaultPixelFormatString);
-        if (pixel_format_str == "uint8")
-            impl->m_pixel_format = PixelFormatUInt8;
-        else if (pixel_format_str == "uint16")
-            impl->m_pixel_format = PixelFormatUInt16;
-        else if (pixel_format_str == "uint32")
-            impl->m_pixel_format = PixelFormatUInt32;
-        else if (pixel_format_str == "half")
-            impl->m_pixel_format = PixelFormatHalf;
-        else if (pixel_format_str == "float")
-            impl->m_pixel_format = PixelFormatFloat;
-        else if (pixel_format_str == "double")
-            impl->m_pixel_format = PixelFormatDouble;
-        else
+        if (!parse_pixel_format(pixel_format_str, impl->m_pixel_format))
         {
             RENDERER_LOG_ERROR(
                 "invalid value \"%s\" for parameter \"%s\", using default value \"%s\".",
@@ -702,6 +982,43 @@ void Frame::extract_parameters()
     impl->m_target_gamma = m_params.get_optional<float>("gamma_correction", 1.0f);
     impl->m_rcp_target_gamma = 1.0f / impl->m_target_gamma;
 
+    // Retrieve denoising parameter.
+    m_is_denoising_enabled = m_params.get_optional<bool>("denoise", false);
+
+    // Retrieve per-AOV pixel format parameters.
+    impl->m_aov_pixel_formats.clear();
+    if (m_params.dictionaries().exist("aov_pixel_formats"))
+    {
+        const StringDictionary& formats = m_params.child("aov_pixel_formats").strings();
+        for (const_each<StringDictionary> i = formats; i; ++i)
+        {
+            PixelFormat pixel_format;
+            if (parse_pixel_format(i->value<string>(), pixel_format))
+                impl->m_aov_pixel_formats[i->key()] = pixel_format;
+            else
+            {
+                RENDERER_LOG_ERROR(
+                    "invalid pixel format \"%s\" for aov \"%s\", using default pixel format.",
+                    i->value(),
+                    i->key());
+            }
+        }
+    }
+
+    // Retrieve AOV tile compression parameter.
+    impl->m_compress_aov_tiles = m_params.get_optional<bool>("compress_aov_tiles", false);
+
+    // Retrieve deep output parameters.
+    impl->m_deep_max_fragment_count = m_params.get_optional<size_t>("deep_max_fragments", 8);
+    if (impl->m_deep_max_fragment_count == 0)
+    {
+        RENDERER_LOG_ERROR(
+            "invalid value \"0\" for parameter \"%s\", using default value \"8\".",
+            "deep_max_fragments");
+        impl->m_deep_max_fragment_count = 8;
+    }
+    impl->m_deep_depth_tolerance = max(m_params.get_optional<float>("deep_depth_tolerance", 0.01f), 0.0f);
+
     // Retrieve crop window parameter.
     const AABB2u default_crop_window(
         Vector2u(0, 0),
@@ -709,6 +1026,22 @@ void Frame::extract_parameters()
     impl->m_crop_window = m_params.get_optional<AABB2u>("crop_window", default_crop_window);
 }
 
+string Frame::get_aov_image_file_path(
+    const char*             file_path,
+    const size_t            aov_index) const
+{
+    const bf::path boost_file_path(file_path);
+    const bf::path directory = boost_file_path.parent_path();
+    const string base_file_name = boost_file_path.stem().string();
+    const string extension = boost_file_path.extension().string();
+
+    const string aov_name = impl->m_aov_images->get_name(aov_index);
+    const string safe_aov_name = make_safe_filename(aov_name);
+    const string aov_file_name = base_file_name + "." + safe_aov_name + extension;
+
+    return (directory / aov_file_name).string();
+}
+
 bool Frame::write_image(
     const char*             file_path,
     const Image&            image,
@@ -893,6 +1226,46 @@ DictionaryArray FrameFactory::get_input_metadata()
             .insert("use", "optional")
             .insert("default", "1.0"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "denoise")
+            .insert("label", "Denoise")
+            .insert("type", "boolean")
+            .insert("use", "optional")
+            .insert("default", "false"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "denoise_radius")
+            .insert("label", "Denoise Radius")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("default", "4"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "compress_aov_tiles")
+            .insert("label", "Compress AOV Tiles")
+            .insert("type", "boolean")
+            .insert("use", "optional")
+            .insert("default", "false"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "deep_max_fragments")
+            .insert("label", "Deep Fragments")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("default", "8"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "deep_depth_tolerance")
+            .insert("label", "Deep Depth Tolerance")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("default", "0.01"));
+
     return metadata;
 }
 
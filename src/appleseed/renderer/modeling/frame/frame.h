@@ -49,13 +49,16 @@
 // Standard headers.
 #include <cassert>
 #include <cstddef>
+#include <string>
 
 // Forward declarations.
+namespace foundation    { class DeepTile; }
 namespace foundation    { class DictionaryArray; }
 namespace foundation    { class Image; }
 namespace foundation    { class ImageAttributes; }
 namespace foundation    { class LightingConditions; }
 namespace foundation    { class Tile; }
+namespace renderer      { class ConvergenceEstimator; }
 namespace renderer      { class ImageStack; }
 namespace renderer      { class ParamArray; }
 
@@ -90,6 +93,10 @@ class APPLESEED_DLLSYMBOL Frame
     // Access the AOV images.
     ImageStack& aov_images() const;
 
+    // Access the estimator of the noise remaining in the main image. It is updated
+    // during progressive rendering if convergence estimation is enabled.
+    ConvergenceEstimator& get_convergence_estimator() const;
+
     // Return the reconstruction filter used by the main image and the AOV images.
     const foundation::Filter2f& get_filter() const;
 
@@ -102,6 +109,19 @@ class APPLESEED_DLLSYMBOL Frame
     // Return true if the frame uses premultiplied alpha, false if it uses straight alpha.
     bool is_premultiplied_alpha() const;
 
+    // Return true if the main image is denoised after rendering, using the
+    // "albedo", "normal" and "depth" feature AOVs as guides.
+    bool is_denoising_enabled() const;
+
+    // Return the pixel format of a given AOV, as set by the "aov_pixel_formats"
+    // parameter, or 'default_format' if the AOV has no explicit pixel format.
+    foundation::PixelFormat get_aov_pixel_format(
+        const char*                     aov_name,
+        const foundation::PixelFormat   default_format) const;
+
+    // Return true if the tiles of the AOV images are compressed in memory once rendered.
+    bool is_aov_tile_compression_enabled() const;
+
     // Set/get the crop window. The crop window is inclusive on all sides.
     void reset_crop_window();
     bool has_crop_window() const;
@@ -140,6 +160,33 @@ class APPLESEED_DLLSYMBOL Frame
     bool write_main_image(const char* file_path) const;
     bool write_aov_images(const char* file_path) const;
 
+    // Write the main image and the AOV images as the layers of a single
+    // OpenEXR file, in one pass. Return true if successful, false otherwise.
+    bool write_main_and_aov_images_to_multilayer_exr(const char* file_path) const;
+
+    // Open a deep OpenEXR file to which the tile renderer writes the fragments of each
+    // tile as soon as the tile is rendered. Deep samples are in the linear RGB color space.
+    // Return true if successful, false otherwise.
+    bool open_deep_output(const char* file_path);
+
+    // Close the deep OpenEXR file. Return true if successful, false otherwise.
+    bool close_deep_output();
+
+    // Return true if a deep OpenEXR file is open.
+    bool is_deep_output_open() const;
+
+    // Write the fragments of a tile to the deep OpenEXR file. Thread-safe.
+    void write_deep_tile(
+        const size_t                    tile_x,
+        const size_t                    tile_y,
+        const foundation::DeepTile&     tile) const;
+
+    // Return the maximum number of deep fragments per pixel.
+    size_t get_deep_max_fragment_count() const;
+
+    // Return the relative depth difference below which samples are merged into one fragment.
+    float get_deep_depth_tolerance() const;
+
     // Archive the frame to a given directory on disk. If output_path is provided,
     // the full path to the output file will be returned. The returned string must
     // be freed using foundation::free_string().
@@ -149,6 +196,7 @@ class APPLESEED_DLLSYMBOL Frame
         char**          output_path = 0) const;
 
   private:
+    friend class AsyncFrameWriter;
     friend class FrameFactory;
 
     struct Impl;
@@ -157,6 +205,7 @@ class APPLESEED_DLLSYMBOL Frame
     foundation::CanvasProperties    m_props;
     foundation::ColorSpace          m_color_space;
     bool                            m_is_premultiplied_alpha;
+    bool                            m_is_denoising_enabled;
 
     // Constructor.
     Frame(
@@ -168,6 +217,11 @@ class APPLESEED_DLLSYMBOL Frame
 
     void extract_parameters();
 
+    // Return the path of the file an AOV image is written to, given the path of the main image.
+    std::string get_aov_image_file_path(
+        const char*                         file_path,
+        const size_t                        aov_index) const;
+
     // Write an image to disk after transformation to the frame's color space.
     // Return true if successful, false otherwise.
     bool write_image(
@@ -208,6 +262,11 @@ inline bool Frame::is_premultiplied_alpha() const
     return m_is_premultiplied_alpha;
 }
 
+inline bool Frame::is_denoising_enabled() const
+{
+    return m_is_denoising_enabled;
+}
+
 inline foundation::Vector2d Frame::get_sample_position(
     const double    sample_x,
     const double    sample_y) const
@@ -32,6 +32,7 @@
 
 // appleseed.renderer headers.
 #include "renderer/global/globaltypes.h"
+#include "renderer/kernel/shading/shadingpoint.h"
 #include "renderer/modeling/input/source.h"
 
 // appleseed.foundation headers.
@@ -42,6 +43,7 @@
 
 // Standard headers.
 #include <cassert>
+#include <cstddef>
 #include <cstring>
 #include <string>
 #include <vector>
@@ -124,6 +126,7 @@ namespace
         uint8* evaluate(
             TextureCache&       texture_cache,
             const Vector2f&     uv,
+            const ShadingPoint* shading_point,
             uint8*              ptr) const
         {
             switch (m_format)
@@ -134,7 +137,7 @@ namespace
                     float* out_scalar = reinterpret_cast<float*>(ptr);
 
                     if (m_source)
-                        m_source->evaluate(texture_cache, uv, *out_scalar);
+                        evaluate_source(texture_cache, uv, shading_point, *out_scalar);
                     else *out_scalar = 0.0f;
 
                     ptr += sizeof(float);
@@ -149,7 +152,7 @@ namespace
                     new (out_spectrum) Spectrum();
 
                     if (m_source)
-                        m_source->evaluate(texture_cache, uv, *out_spectrum);
+                        evaluate_source(texture_cache, uv, shading_point, *out_spectrum);
                     else out_spectrum->set(0.0f);
 
                     out_spectrum->set_intent(Spectrum::Reflectance);
@@ -166,7 +169,7 @@ namespace
                     new (out_spectrum) Spectrum();
 
                     if (m_source)
-                        m_source->evaluate(texture_cache, uv, *out_spectrum);
+                        evaluate_source(texture_cache, uv, shading_point, *out_spectrum);
                     else out_spectrum->set(0.0f);
 
                     out_spectrum->set_intent(Spectrum::Illuminance);
@@ -185,7 +188,7 @@ namespace
                     new (out_alpha) Alpha();
 
                     if (m_source)
-                        m_source->evaluate(texture_cache, uv, *out_spectrum, *out_alpha);
+                        evaluate_source(texture_cache, uv, shading_point, *out_spectrum, *out_alpha);
                     else
                     {
                         out_spectrum->set(0.0f);
@@ -209,7 +212,7 @@ namespace
                     new (out_alpha) Alpha();
 
                     if (m_source)
-                        m_source->evaluate(texture_cache, uv, *out_spectrum, *out_alpha);
+                        evaluate_source(texture_cache, uv, shading_point, *out_spectrum, *out_alpha);
                     else
                     {
                         out_spectrum->set(0.0f);
@@ -233,6 +236,45 @@ namespace
             return ptr;
         }
 
+        template <typename T>
+        void evaluate_source(
+            TextureCache&       texture_cache,
+            const Vector2f&     uv,
+            const ShadingPoint* shading_point,
+            T&                  value) const
+        {
+            if (shading_point && m_source->uses_uv_derivatives())
+            {
+                m_source->evaluate(
+                    texture_cache,
+                    uv,
+                    shading_point->get_duvdx(0),
+                    shading_point->get_duvdy(0),
+                    value);
+            }
+            else m_source->evaluate(texture_cache, uv, value);
+        }
+
+        void evaluate_source(
+            TextureCache&       texture_cache,
+            const Vector2f&     uv,
+            const ShadingPoint* shading_point,
+            Spectrum&           spectrum,
+            Alpha&              alpha) const
+        {
+            if (shading_point && m_source->uses_uv_derivatives())
+            {
+                m_source->evaluate(
+                    texture_cache,
+                    uv,
+                    shading_point->get_duvdx(0),
+                    shading_point->get_duvdy(0),
+                    spectrum,
+                    alpha);
+            }
+            else m_source->evaluate(texture_cache, uv, spectrum, alpha);
+        }
+
         uint8* evaluate_uniform(uint8* ptr) const
         {
             switch (m_format)
@@ -348,7 +390,62 @@ namespace
 
 struct InputArray::Impl
 {
-    InputVector m_inputs;
+    // A varying input and the offset of its value in the input values block.
+    struct VaryingInput
+    {
+        const Input*    m_input;
+        size_t          m_offset;
+    };
+
+    typedef vector<VaryingInput> VaryingInputVector;
+
+    InputVector         m_inputs;
+
+    // Input program, built by compile().
+    bool                m_is_compiled;
+    size_t              m_data_size;
+    uint8*              m_uniform_values;       // 16-byte aligned
+    VaryingInputVector  m_varying_inputs;
+
+    Impl()
+      : m_is_compiled(false)
+      , m_data_size(0)
+      , m_uniform_values(0)
+    {
+    }
+
+    ~Impl()
+    {
+        clear_program();
+    }
+
+    void clear_program()
+    {
+        if (m_uniform_values)
+        {
+            aligned_free(m_uniform_values);
+            m_uniform_values = 0;
+        }
+
+        m_varying_inputs.clear();
+        m_data_size = 0;
+        m_is_compiled = false;
+    }
+
+    void evaluate_program(
+        TextureCache&       texture_cache,
+        const Vector2f&     uv,
+        const ShadingPoint* shading_point,
+        uint8*              values) const
+    {
+        assert(m_is_compiled);
+
+        if (m_data_size > 0)
+            memcpy(values, m_uniform_values, m_data_size);
+
+        for (const_each<VaryingInputVector> i = m_varying_inputs; i; ++i)
+            i->m_input->evaluate(texture_cache, uv, shading_point, values + i->m_offset);
+    }
 };
 
 InputArray::InputArray()
@@ -383,6 +480,7 @@ void InputArray::declare(
     input.m_entity = 0;
 
     impl->m_inputs.push_back(input);
+    impl->clear_program();
 }
 
 InputArray::iterator InputArray::begin()
@@ -463,6 +561,9 @@ Entity* InputArray::get_entity(const char* name) const
 
 size_t InputArray::compute_data_size() const
 {
+    if (impl->m_is_compiled)
+        return impl->m_data_size;
+
     size_t size = 0;
 
     for (const_each<InputVector> i = impl->m_inputs; i; ++i)
@@ -473,6 +574,45 @@ size_t InputArray::compute_data_size() const
     return size;
 }
 
+void InputArray::compile()
+{
+    impl->clear_program();
+
+    const size_t data_size = compute_data_size();
+
+    if (data_size > 0)
+    {
+        impl->m_uniform_values = static_cast<uint8*>(aligned_malloc(data_size, 16));
+
+        // Uniform inputs are evaluated once and for all, varying inputs are left to zero.
+        evaluate_uniforms(impl->m_uniform_values);
+
+        // Record the offset of the value of each varying input. Since the values block
+        // is 16-byte aligned, offsets are valid for any other 16-byte aligned block.
+        size_t offset = 0;
+        for (const_each<InputVector> i = impl->m_inputs; i; ++i)
+        {
+            if (i->m_source && !i->m_source->is_uniform())
+            {
+                Impl::VaryingInput varying_input;
+                varying_input.m_input = &*i;
+                varying_input.m_offset = offset;
+                impl->m_varying_inputs.push_back(varying_input);
+            }
+
+            offset = i->add_size(offset);
+        }
+    }
+
+    impl->m_data_size = data_size;
+    impl->m_is_compiled = true;
+}
+
+bool InputArray::is_compiled() const
+{
+    return impl->m_is_compiled;
+}
+
 void InputArray::evaluate(
     TextureCache&       texture_cache,
     const Vector2f&     uv,
@@ -486,8 +626,39 @@ void InputArray::evaluate(
     assert(is_aligned(ptr, 16));
 #endif
 
+    if (impl->m_is_compiled)
+    {
+        impl->evaluate_program(texture_cache, uv, 0, ptr);
+        return;
+    }
+
+    for (const_each<InputVector> i = impl->m_inputs; i; ++i)
+        ptr = i->evaluate(texture_cache, uv, 0, ptr);
+}
+
+void InputArray::evaluate(
+    TextureCache&       texture_cache,
+    const ShadingPoint& shading_point,
+    void*               values) const
+{
+    assert(values);
+
+    uint8* ptr = static_cast<uint8*>(values);
+
+#ifdef APPLESEED_USE_SSE
+    assert(is_aligned(ptr, 16));
+#endif
+
+    const Vector2f& uv = shading_point.get_uv(0);
+
+    if (impl->m_is_compiled)
+    {
+        impl->evaluate_program(texture_cache, uv, &shading_point, ptr);
+        return;
+    }
+
     for (const_each<InputVector> i = impl->m_inputs; i; ++i)
-        ptr = i->evaluate(texture_cache, uv, ptr);
+        ptr = i->evaluate(texture_cache, uv, &shading_point, ptr);
 }
 
 void InputArray::evaluate_uniforms(
@@ -501,6 +672,13 @@ void InputArray::evaluate_uniforms(
     assert(is_aligned(ptr, 16));
 #endif
 
+    if (impl->m_is_compiled)
+    {
+        if (impl->m_data_size > 0)
+            memcpy(ptr, impl->m_uniform_values, impl->m_data_size);
+        return;
+    }
+
     for (const_each<InputVector> i = impl->m_inputs; i; ++i)
         ptr = i->evaluate_uniform(ptr);
 }
@@ -637,6 +815,7 @@ void InputArray::iterator::bind(Source* source)
     Input& input = m_input_array->impl->m_inputs[m_input_index];
     delete input.m_source;
     input.m_source = source;
+    m_input_array->impl->clear_program();
 }
 
 void InputArray::iterator::bind(Entity* entity)
@@ -43,6 +43,7 @@
 
 // Forward declarations.
 namespace renderer  { class Entity; }
+namespace renderer  { class ShadingPoint; }
 namespace renderer  { class Source; }
 namespace renderer  { class TextureCache; }
 
@@ -214,6 +215,14 @@ class APPLESEED_DLLSYMBOL InputArray
     // Compute the cumulated size in bytes of the input values.
     size_t compute_data_size() const;
 
+    // Precompute the values of all uniform inputs (including unbound inputs) such
+    // that evaluate() only copies them and evaluates varying inputs. The precomputed
+    // values are discarded when a source is bound to an input.
+    void compile();
+
+    // Return true if the values of uniform inputs are currently precomputed.
+    bool is_compiled() const;
+
     // Evaluate all inputs into a preallocated block of memory.
     // 'values' must be 16-byte aligned.
     void evaluate(
@@ -221,6 +230,15 @@ class APPLESEED_DLLSYMBOL InputArray
         const foundation::Vector2f& uv,
         void*                       values) const;
 
+    // Evaluate all inputs at a given shading point into a preallocated block of memory.
+    // Sources that support it filter their values according to the screen space partial
+    // derivatives of the texture coordinates of the shading point.
+    // 'values' must be 16-byte aligned.
+    void evaluate(
+        TextureCache&               texture_cache,
+        const ShadingPoint&         shading_point,
+        void*                       values) const;
+
     // Evaluate all uniform inputs into a preallocated block of memory.
     // 'values' must be 16-byte aligned.
     void evaluate_uniforms(
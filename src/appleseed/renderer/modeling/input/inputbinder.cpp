@@ -124,8 +124,9 @@ namespace
         const EntityContainer&      entities,
         const SymbolTable::SymbolID symbol_id)
     {
+        // Entities are mutable even when their container is not (see get_by_name()).
         for (const_each<EntityContainer> i = entities; i; ++i)
-            symbols.insert(i->get_name(), symbol_id);
+            symbols.insert(i->get_name(), symbol_id, const_cast<Entity*>(static_cast<const Entity*>(&*i)));
     }
 }
 
@@ -144,7 +145,7 @@ void InputBinder::build_scene_symbol_table(
         insert_entities(symbols, scene.shader_groups(), SymbolTable::SymbolShaderGroup);
 
         if (scene.get_environment())
-            symbols.insert(scene.get_environment()->get_name(), SymbolTable::SymbolEnvironment);
+            symbols.insert(scene.get_environment()->get_name(), SymbolTable::SymbolEnvironment, scene.get_environment());
 
         insert_entities(symbols, scene.assemblies(), SymbolTable::SymbolAssembly);
         insert_entities(symbols, scene.assembly_instances(), SymbolTable::SymbolAssemblyInstance);
@@ -546,19 +547,22 @@ bool InputBinder::try_bind_scene_entity_to_input(
 {
     if (input.format() == InputFormatEntity)
     {
-        #define BIND(symbol, collection)                        \
-            case symbol:                                        \
-              input.bind(collection.get_by_name(param_value));  \
+        // The symbol table resolves the name to the entity in a single lookup.
+        #define BIND(symbol)                \
+            case symbol:                    \
+              input.bind(entity);           \
               return true
 
-        switch (scene_symbols.lookup(param_value))
+        Entity* entity;
+
+        switch (scene_symbols.lookup(param_value, entity))
         {
-          BIND(SymbolTable::SymbolColor, scene.colors());
-          BIND(SymbolTable::SymbolTexture, scene.textures());
-          BIND(SymbolTable::SymbolTextureInstance, scene.texture_instances());
-          BIND(SymbolTable::SymbolShaderGroup, scene.shader_groups());
-          BIND(SymbolTable::SymbolEnvironmentEDF, scene.environment_edfs());
-          BIND(SymbolTable::SymbolEnvironmentShader, scene.environment_shaders());
+          BIND(SymbolTable::SymbolColor);
+          BIND(SymbolTable::SymbolTexture);
+          BIND(SymbolTable::SymbolTextureInstance);
+          BIND(SymbolTable::SymbolShaderGroup);
+          BIND(SymbolTable::SymbolEnvironmentEDF);
+          BIND(SymbolTable::SymbolEnvironmentShader);
         }
 
         #undef BIND
@@ -626,25 +630,28 @@ bool InputBinder::try_bind_assembly_entity_to_input(
 {
     if (input.format() == InputFormatEntity)
     {
-        #define BIND(symbol, collection)                        \
-            case symbol:                                        \
-              input.bind(collection.get_by_name(param_value));  \
+        // The symbol table resolves the name to the entity in a single lookup.
+        #define BIND(symbol)                \
+            case symbol:                    \
+              input.bind(entity);           \
               return true
 
-        switch (assembly_symbols.lookup(param_value))
+        Entity* entity;
+
+        switch (assembly_symbols.lookup(param_value, entity))
         {
-          BIND(SymbolTable::SymbolColor, assembly.colors());
-          BIND(SymbolTable::SymbolTexture, assembly.textures());
-          BIND(SymbolTable::SymbolTextureInstance, assembly.texture_instances());
-          BIND(SymbolTable::SymbolBSDF, assembly.bsdfs());
-          BIND(SymbolTable::SymbolBSSRDF, assembly.bssrdfs());
-          BIND(SymbolTable::SymbolEDF, assembly.edfs());
-          BIND(SymbolTable::SymbolShaderGroup, assembly.shader_groups());
-          BIND(SymbolTable::SymbolSurfaceShader, assembly.surface_shaders());
-          BIND(SymbolTable::SymbolMaterial, assembly.materials());
-          BIND(SymbolTable::SymbolLight, assembly.lights());
-          BIND(SymbolTable::SymbolObject, assembly.objects());
-          BIND(SymbolTable::SymbolObjectInstance, assembly.object_instances());
+          BIND(SymbolTable::SymbolColor);
+          BIND(SymbolTable::SymbolTexture);
+          BIND(SymbolTable::SymbolTextureInstance);
+          BIND(SymbolTable::SymbolBSDF);
+          BIND(SymbolTable::SymbolBSSRDF);
+          BIND(SymbolTable::SymbolEDF);
+          BIND(SymbolTable::SymbolShaderGroup);
+          BIND(SymbolTable::SymbolSurfaceShader);
+          BIND(SymbolTable::SymbolMaterial);
+          BIND(SymbolTable::SymbolLight);
+          BIND(SymbolTable::SymbolObject);
+          BIND(SymbolTable::SymbolObjectInstance);
         }
 
         #undef BIND
@@ -63,6 +63,10 @@ class Source
     // Return true if the source is uniform, false if it is varying.
     bool is_uniform() const;
 
+    // Return true if the source filters its values according to the screen space
+    // partial derivatives of the texture coordinates, false otherwise.
+    virtual bool uses_uv_derivatives() const;
+
     // Evaluate the source at a given shading point.
     virtual void evaluate(
         TextureCache&               texture_cache,
@@ -91,6 +95,58 @@ class Source
         Spectrum&                   spectrum,
         Alpha&                      alpha) const;
 
+    // Evaluate the source at a given shading point, filtering its values according to
+    // the screen space partial derivatives of the texture coordinates. By default, the
+    // derivatives are ignored.
+    virtual void evaluate(
+        TextureCache&               texture_cache,
+        const foundation::Vector2f& uv,
+        const foundation::Vector2f& duvdx,
+        const foundation::Vector2f& duvdy,
+        float&                      scalar) const;
+    virtual void evaluate(
+        TextureCache&               texture_cache,
+        const foundation::Vector2f& uv,
+        const foundation::Vector2f& duvdx,
+        const foundation::Vector2f& duvdy,
+        foundation::Color3f&        linear_rgb) const;
+    virtual void evaluate(
+        TextureCache&               texture_cache,
+        const foundation::Vector2f& uv,
+        const foundation::Vector2f& duvdx,
+        const foundation::Vector2f& duvdy,
+        Spectrum&                   spectrum) const;
+    virtual void evaluate(
+        TextureCache&               texture_cache,
+        const foundation::Vector2f& uv,
+        const foundation::Vector2f& duvdx,
+        const foundation::Vector2f& duvdy,
+        Alpha&                      alpha) const;
+    virtual void evaluate(
+        TextureCache&               texture_cache,
+        const foundation::Vector2f& uv,
+        const foundation::Vector2f& duvdx,
+        const foundation::Vector2f& duvdy,
+        foundation::Color3f&        linear_rgb,
+        Alpha&                      alpha) const;
+    virtual void evaluate(
+        TextureCache&               texture_cache,
+        const foundation::Vector2f& uv,
+        const foundation::Vector2f& duvdx,
+        const foundation::Vector2f& duvdy,
+        Spectrum&                   spectrum,
+        Alpha&                      alpha) const;
+
+    // Evaluate the source and its partial derivatives with respect to the texture
+    // coordinates at a given shading point. By default, the derivatives are computed
+    // by forward differences with steps 'delta', which requires three evaluations.
+    virtual void evaluate_with_gradient(
+        TextureCache&               texture_cache,
+        const foundation::Vector2f& uv,
+        const foundation::Vector2f& delta,
+        float&                      scalar,
+        foundation::Vector2f&       gradient) const;
+
     // Evaluate the source as a uniform source.
     virtual void evaluate_uniform(
         float&                      scalar) const;
@@ -130,6 +186,11 @@ inline bool Source::is_uniform() const
     return m_uniform;
 }
 
+inline bool Source::uses_uv_derivatives() const
+{
+    return false;
+}
+
 inline void Source::evaluate(
     TextureCache&                   texture_cache,
     const foundation::Vector2f&     uv,
@@ -180,6 +241,84 @@ inline void Source::evaluate(
     evaluate_uniform(spectrum, alpha);
 }
 
+inline void Source::evaluate(
+    TextureCache&                   texture_cache,
+    const foundation::Vector2f&     uv,
+    const foundation::Vector2f&     duvdx,
+    const foundation::Vector2f&     duvdy,
+    float&                          scalar) const
+{
+    evaluate(texture_cache, uv, scalar);
+}
+
+inline void Source::evaluate(
+    TextureCache&                   texture_cache,
+    const foundation::Vector2f&     uv,
+    const foundation::Vector2f&     duvdx,
+    const foundation::Vector2f&     duvdy,
+    foundation::Color3f&            linear_rgb) const
+{
+    evaluate(texture_cache, uv, linear_rgb);
+}
+
+inline void Source::evaluate(
+    TextureCache&                   texture_cache,
+    const foundation::Vector2f&     uv,
+    const foundation::Vector2f&     duvdx,
+    const foundation::Vector2f&     duvdy,
+    Spectrum&                       spectrum) const
+{
+    evaluate(texture_cache, uv, spectrum);
+}
+
+inline void Source::evaluate(
+    TextureCache&                   texture_cache,
+    const foundation::Vector2f&     uv,
+    const foundation::Vector2f&     duvdx,
+    const foundation::Vector2f&     duvdy,
+    Alpha&                          alpha) const
+{
+    evaluate(texture_cache, uv, alpha);
+}
+
+inline void Source::evaluate(
+    TextureCache&                   texture_cache,
+    const foundation::Vector2f&     uv,
+    const foundation::Vector2f&     duvdx,
+    const foundation::Vector2f&     duvdy,
+    foundation::Color3f&            linear_rgb,
+    Alpha&                          alpha) const
+{
+    evaluate(texture_cache, uv, linear_rgb, alpha);
+}
+
+inline void Source::evaluate(
+    TextureCache&                   texture_cache,
+    const foundation::Vector2f&     uv,
+    const foundation::Vector2f&     duvdx,
+    const foundation::Vector2f&     duvdy,
+    Spectrum&                       spectrum,
+    Alpha&                          alpha) const
+{
+    evaluate(texture_cache, uv, spectrum, alpha);
+}
+
+inline void Source::evaluate_with_gradient(
+    TextureCache&                   texture_cache,
+    const foundation::Vector2f&     uv,
+    const foundation::Vector2f&     delta,
+    float&                          scalar,
+    foundation::Vector2f&           gradient) const
+{
+    float scalar_du, scalar_dv;
+    evaluate(texture_cache, uv, scalar);
+    evaluate(texture_cache, foundation::Vector2f(uv[0] + delta[0], uv[1]), scalar_du);
+    evaluate(texture_cache, foundation::Vector2f(uv[0], uv[1] + delta[1]), scalar_dv);
+
+    gradient[0] = (scalar_du - scalar) / delta[0];
+    gradient[1] = (scalar_dv - scalar) / delta[1];
+}
+
 inline void Source::evaluate_uniform(
     float&                          scalar) const
 {
@@ -34,12 +34,17 @@
 #include "foundation/core/exceptions/stringexception.h"
 #include "foundation/utility/kvpair.h"
 
+// Boost headers.
+#include "boost/unordered_map.hpp"
+
 // Standard headers.
 #include <cassert>
-#include <map>
 #include <string>
 #include <utility>
 
+// Forward declarations.
+namespace renderer  { class Entity; }
+
 namespace renderer
 {
 
@@ -85,16 +90,23 @@ class SymbolTable
     // Return a human-readable representation of a symbol identifier.
     static const char* symbol_name(const SymbolID symbol_id);
 
-    // Insert a symbol.
+    // Insert a symbol, optionally referring to the entity it names.
     void insert(
         const std::string&  name,
-        const SymbolID      symbol_id);
+        const SymbolID      symbol_id,
+        Entity*             entity = 0);
 
     // Lookup a symbol.
     SymbolID lookup(const std::string& name) const;
 
+    // Lookup a symbol and retrieve the entity it names (0 if none was given).
+    SymbolID lookup(
+        const std::string&  name,
+        Entity*&            entity) const;
+
   private:
-    typedef std::map<std::string, SymbolID> SymbolContainer;
+    typedef std::pair<SymbolID, Entity*> SymbolInfo;
+    typedef boost::unordered_map<std::string, SymbolInfo> SymbolContainer;
 
     SymbolContainer m_symbols;
 };
@@ -140,16 +152,33 @@ inline const char* SymbolTable::symbol_name(const SymbolID symbol_id)
 
 inline void SymbolTable::insert(
     const std::string&  name,
-    const SymbolID      symbol_id)
+    const SymbolID      symbol_id,
+    Entity*             entity)
 {
-    if (!m_symbols.insert(std::make_pair(name, symbol_id)).second)
+    if (!m_symbols.insert(std::make_pair(name, SymbolInfo(symbol_id, entity))).second)
         throw ExceptionDuplicateSymbol(name.c_str());
 }
 
 inline SymbolTable::SymbolID SymbolTable::lookup(const std::string& name) const
 {
     const SymbolContainer::const_iterator i = m_symbols.find(name);
-    return i == m_symbols.end() ? SymbolNotFound : i->second;
+    return i == m_symbols.end() ? SymbolNotFound : i->second.first;
+}
+
+inline SymbolTable::SymbolID SymbolTable::lookup(
+    const std::string&  name,
+    Entity*&            entity) const
+{
+    const SymbolContainer::const_iterator i = m_symbols.find(name);
+
+    if (i == m_symbols.end())
+    {
+        entity = 0;
+        return SymbolNotFound;
+    }
+
+    entity = i->second.second;
+    return i->second.first;
 }
 
 }       // namespace renderer
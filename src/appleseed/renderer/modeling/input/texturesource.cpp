@@ -36,12 +36,15 @@
 #include "renderer/modeling/texture/texture.h"
 
 // appleseed.foundation headers.
+#include "foundation/image/compressedtile.h"
 #include "foundation/image/tile.h"
+#include "foundation/math/fastmath.h"
 #include "foundation/math/hash.h"
 #include "foundation/math/scalar.h"
 #include "foundation/platform/types.h"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 
 using namespace foundation;
@@ -136,6 +139,38 @@ namespace
                 static_cast<size_t>(iy));
     }
 
+    // Compute the scaling factors mapping the UV space covered by a texture to [0, 1]^2.
+    Vector2f compute_uv_scale(Texture& texture)
+    {
+        const Vector2u uv_tile_count = texture.get_uv_tile_count();
+
+        return
+            Vector2f(
+                1.0f / static_cast<float>(uv_tile_count.x),
+                1.0f / static_cast<float>(uv_tile_count.y));
+    }
+
+    // Utility function to fetch a pixel of a tile, compressed or not.
+    inline void get_pixel(
+        const TextureStore::TileRecord& record,
+        const size_t                    pixel_x,
+        const size_t                    pixel_y,
+        Color4f&                        sample)
+    {
+        if (record.m_compressed_tile)
+            record.m_compressed_tile->get_pixel(pixel_x, pixel_y, sample);
+        else if (record.m_tile->get_channel_count() == 3)
+        {
+            Color3f rgb;
+            record.m_tile->get_pixel(pixel_x, pixel_y, rgb);
+            sample[0] = rgb[0];
+            sample[1] = rgb[1];
+            sample[2] = rgb[2];
+            sample[3] = 1.0f;
+        }
+        else record.m_tile->get_pixel(pixel_x, pixel_y, sample);
+    }
+
     // Utility function to sample a tile.
     inline void sample_tile(
         TextureCache&               texture_cache,
@@ -143,29 +178,22 @@ namespace
         const UniqueID              texture_uid,
         const size_t                tile_x,
         const size_t                tile_y,
+        const size_t                level,
         const size_t                pixel_x,
         const size_t                pixel_y,
         Color4f&                    sample)
     {
         // Retrieve the tile.
-        const Tile& tile =
+        const TextureStore::TileRecord& record =
             texture_cache.get(
                 assembly_uid,
                 texture_uid,
                 tile_x,
-                tile_y);
+                tile_y,
+                level);
 
         // Sample the tile.
-        if (tile.get_channel_count() == 3)
-        {
-            Color3f rgb;
-            tile.get_pixel(pixel_x, pixel_y, rgb);
-            sample[0] = rgb[0];
-            sample[1] = rgb[1];
-            sample[2] = rgb[2];
-            sample[3] = 1.0f;
-        }
-        else tile.get_pixel(pixel_x, pixel_y, sample);
+        get_pixel(record, pixel_x, pixel_y, sample);
     }
 }
 
@@ -178,11 +206,23 @@ TextureSource::TextureSource(
   , m_texture_uid(texture_instance.get_texture().get_uid())
   , m_texture_props(texture_instance.get_texture().properties())
   , m_texture_transform(texture_instance.get_transform())
-  , m_scalar_canvas_width(static_cast<float>(m_texture_props.m_canvas_width))
-  , m_scalar_canvas_height(static_cast<float>(m_texture_props.m_canvas_height))
-  , m_max_x(static_cast<float>(m_texture_props.m_canvas_width - 1))
-  , m_max_y(static_cast<float>(m_texture_props.m_canvas_height - 1))
+  , m_uv_scale(compute_uv_scale(texture_instance.get_texture()))
 {
+    // Each mipmap level halves the resolution of the previous one, rounding up.
+    for (size_t level = 0; ; ++level)
+    {
+        MipLevel mip_level;
+        mip_level.m_canvas_width = (m_texture_props.m_canvas_width + (size_t(1) << level) - 1) >> level;
+        mip_level.m_canvas_height = (m_texture_props.m_canvas_height + (size_t(1) << level) - 1) >> level;
+        mip_level.m_scalar_canvas_width = static_cast<float>(mip_level.m_canvas_width);
+        mip_level.m_scalar_canvas_height = static_cast<float>(mip_level.m_canvas_height);
+        mip_level.m_max_x = static_cast<float>(mip_level.m_canvas_width - 1);
+        mip_level.m_max_y = static_cast<float>(mip_level.m_canvas_height - 1);
+        m_mip_levels.push_back(mip_level);
+
+        if (mip_level.m_canvas_width == 1 && mip_level.m_canvas_height == 1)
+            break;
+    }
 }
 
 uint64 TextureSource::compute_signature() const
@@ -190,6 +230,11 @@ uint64 TextureSource::compute_signature() const
     return m_texture_instance.compute_signature();
 }
 
+bool TextureSource::uses_uv_derivatives() const
+{
+    return m_texture_instance.get_filtering_mode() == TextureFilteringTrilinear;
+}
+
 Vector2f TextureSource::apply_transform(const Vector2f& uv) const
 {
     // Convert to 3D coordinates.
@@ -198,23 +243,50 @@ Vector2f TextureSource::apply_transform(const Vector2f& uv) const
     // Apply transform.
     p = m_texture_transform.point_to_local(p);
 
-    // Convert back to 2D coordinates.
-    return Vector2f(p.x, p.y);
+    // Convert back to 2D coordinates, mapping textures covering several
+    // unit squares of UV space (such as UDIM texture sets) to [0, 1]^2.
+    return Vector2f(p.x * m_uv_scale.x, p.y * m_uv_scale.y);
+}
+
+float TextureSource::compute_lod(
+    const Vector2f&             duvdx,
+    const Vector2f&             duvdy) const
+{
+    // Transform the derivatives to texture space.
+    Vector3f dpdx = m_texture_transform.vector_to_local(Vector3f(duvdx.x, duvdx.y, 0.0f));
+    Vector3f dpdy = m_texture_transform.vector_to_local(Vector3f(duvdy.x, duvdy.y, 0.0f));
+    dpdx.x *= m_uv_scale.x;
+    dpdx.y *= m_uv_scale.y;
+    dpdy.x *= m_uv_scale.x;
+    dpdy.y *= m_uv_scale.y;
+
+    // Compute the squared length in texels of the largest axis of the footprint.
+    const MipLevel& base_level = m_mip_levels[0];
+    const float lx = square(dpdx.x * base_level.m_scalar_canvas_width) + square(dpdx.y * base_level.m_scalar_canvas_height);
+    const float ly = square(dpdy.x * base_level.m_scalar_canvas_width) + square(dpdy.y * base_level.m_scalar_canvas_height);
+    const float l2 = max(lx, ly);
+
+    // Footprints smaller than a texel use the base level.
+    if (!(l2 > 1.0f))
+        return 0.0f;
+
+    const float lod = 0.5f * fast_log2(l2);
+    return min(lod, static_cast<float>(m_mip_levels.size() - 1));
 }
 
 Color4f TextureSource::get_texel(
     TextureCache&               texture_cache,
+    const size_t                level,
     const size_t                ix,
     const size_t                iy) const
 {
-    assert(ix < m_texture_props.m_canvas_width);
-    assert(iy < m_texture_props.m_canvas_height);
+    assert(level < m_mip_levels.size());
+    assert(ix < m_mip_levels[level].m_canvas_width);
+    assert(iy < m_mip_levels[level].m_canvas_height);
 
     // Compute the coordinates of the tile containing the texel (x, y).
     const size_t tile_x = truncate<size_t>(ix * m_texture_props.m_rcp_tile_width);
     const size_t tile_y = truncate<size_t>(iy * m_texture_props.m_rcp_tile_height);
-    assert(tile_x < m_texture_props.m_tile_count_x);
-    assert(tile_y < m_texture_props.m_tile_count_y);
 
 #ifdef DEBUG_DISPLAY_TEXTURE_TILES
 
@@ -242,6 +314,7 @@ Color4f TextureSource::get_texel(
         m_texture_uid,
         tile_x,
         tile_y,
+        level,
         pixel_x,
         pixel_y,
         sample);
@@ -251,6 +324,7 @@ Color4f TextureSource::get_texel(
 
 void TextureSource::get_texels_2x2(
     TextureCache&               texture_cache,
+    const size_t                level,
     const int                   ix,
     const int                   iy,
     Color4f&                    t00,
@@ -258,19 +332,22 @@ void TextureSource::get_texels_2x2(
     Color4f&                    t01,
     Color4f&                    t11) const
 {
+    assert(level < m_mip_levels.size());
+    const MipLevel& mip_level = m_mip_levels[level];
+
     const Vector<size_t, 2> p00 =
         constrain_to_canvas(
             m_texture_instance.get_addressing_mode(),
-            m_texture_props.m_canvas_width,
-            m_texture_props.m_canvas_height,
+            mip_level.m_canvas_width,
+            mip_level.m_canvas_height,
             ix + 0,
             iy + 0);
 
     const Vector<size_t, 2> p11 =
         constrain_to_canvas(
             m_texture_instance.get_addressing_mode(),
-            m_texture_props.m_canvas_width,
-            m_texture_props.m_canvas_height,
+            mip_level.m_canvas_width,
+            mip_level.m_canvas_height,
             ix + 1,
             iy + 1);
 
@@ -296,10 +373,10 @@ void TextureSource::get_texels_2x2(
         const size_t pixel_y_11 = p11.y - tile_y_11 * m_texture_props.m_tile_height;
 
         // Sample the tile.
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_00, pixel_x_00, pixel_y_00, t00);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_00, pixel_x_11, pixel_y_00, t10);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_11, pixel_x_00, pixel_y_11, t01);
-        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_11, pixel_x_11, pixel_y_11, t11);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_00, level, pixel_x_00, pixel_y_00, t00);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_00, level, pixel_x_11, pixel_y_00, t10);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_00, tile_y_11, level, pixel_x_00, pixel_y_11, t01);
+        sample_tile(texture_cache, m_assembly_uid, m_texture_uid, tile_x_11, tile_y_11, level, pixel_x_11, pixel_y_11, t11);
     }
     else
     {
@@ -312,55 +389,147 @@ void TextureSource::get_texels_2x2(
         const size_t pixel_y_11 = p11.y - org_y;
 
         // Retrieve the tile.
-        const Tile& tile =
+        const TextureStore::TileRecord& record =
             texture_cache.get(
                 m_assembly_uid,
                 m_texture_uid,
                 tile_x_00,
-                tile_y_00);
+                tile_y_00,
+                level);
 
         // Sample the tile.
-        if (tile.get_channel_count() == 3)
-        {
-            Color3f rgb;
-
-            tile.get_pixel(pixel_x_00, pixel_y_00, rgb);
-            t00[0] = rgb[0];
-            t00[1] = rgb[1];
-            t00[2] = rgb[2];
-            t00[3] = 1.0f;
-
-            tile.get_pixel(pixel_x_11, pixel_y_00, rgb);
-            t10[0] = rgb[0];
-            t10[1] = rgb[1];
-            t10[2] = rgb[2];
-            t10[3] = 1.0f;
-
-            tile.get_pixel(pixel_x_00, pixel_y_11, rgb);
-            t01[0] = rgb[0];
-            t01[1] = rgb[1];
-            t01[2] = rgb[2];
-            t01[3] = 1.0f;
-
-            tile.get_pixel(pixel_x_11, pixel_y_11, rgb);
-            t11[0] = rgb[0];
-            t11[1] = rgb[1];
-            t11[2] = rgb[2];
-            t11[3] = 1.0f;
-        }
-        else
-        {
-            tile.get_pixel(pixel_x_00, pixel_y_00, t00);
-            tile.get_pixel(pixel_x_11, pixel_y_00, t10);
-            tile.get_pixel(pixel_x_00, pixel_y_11, t01);
-            tile.get_pixel(pixel_x_11, pixel_y_11, t11);
-        }
+        get_pixel(record, pixel_x_00, pixel_y_00, t00);
+        get_pixel(record, pixel_x_11, pixel_y_00, t10);
+        get_pixel(record, pixel_x_00, pixel_y_11, t01);
+        get_pixel(record, pixel_x_11, pixel_y_11, t11);
     }
 }
 
+Color4f TextureSource::sample_bilinear(
+    TextureCache&               texture_cache,
+    const size_t                level,
+    const Vector2f&             p) const
+{
+    const MipLevel& mip_level = m_mip_levels[level];
+
+    const float x = p.x * mip_level.m_max_x;
+    const float y = p.y * mip_level.m_max_y;
+
+    const int ix = truncate<int>(x);
+    const int iy = truncate<int>(y);
+
+    // Retrieve the four surrounding texels.
+    Color4f t00, t10, t01, t11;
+    get_texels_2x2(
+        texture_cache,
+        level,
+        ix, iy,
+        t00, t10, t01, t11);
+
+    // Compute weights.
+    const float wx1 = x - ix;
+    const float wy1 = y - iy;
+    const float wx0 = 1.0f - wx1;
+    const float wy0 = 1.0f - wy1;
+
+    // Apply weights.
+    t00 *= wx0 * wy0;
+    t10 *= wx1 * wy0;
+    t01 *= wx0 * wy1;
+    t11 *= wx1 * wy1;
+
+    // Accumulate.
+    t00 += t10;
+    t00 += t01;
+    t00 += t11;
+
+    return t00;
+}
+
+Color4f TextureSource::sample_bilinear(
+    TextureCache&               texture_cache,
+    const size_t                level,
+    const Vector2f&             p,
+    Color4f&                    dcdx,
+    Color4f&                    dcdy) const
+{
+    const MipLevel& mip_level = m_mip_levels[level];
+
+    const float x = p.x * mip_level.m_max_x;
+    const float y = p.y * mip_level.m_max_y;
+
+    const int ix = truncate<int>(x);
+    const int iy = truncate<int>(y);
+
+    // Retrieve the four surrounding texels.
+    Color4f t00, t10, t01, t11;
+    get_texels_2x2(
+        texture_cache,
+        level,
+        ix, iy,
+        t00, t10, t01, t11);
+
+    // Compute weights.
+    const float wx1 = x - ix;
+    const float wy1 = y - iy;
+    const float wx0 = 1.0f - wx1;
+    const float wy0 = 1.0f - wy1;
+
+    // Compute the partial derivatives of the bilinear interpolant.
+    dcdx = (t10 - t00) * wy0 + (t11 - t01) * wy1;
+    dcdy = (t01 - t00) * wx0 + (t11 - t10) * wx1;
+
+    // Apply weights.
+    t00 *= wx0 * wy0;
+    t10 *= wx1 * wy0;
+    t01 *= wx0 * wy1;
+    t11 *= wx1 * wy1;
+
+    // Accumulate.
+    t00 += t10;
+    t00 += t01;
+    t00 += t11;
+
+    return t00;
+}
+
+void TextureSource::evaluate_with_gradient(
+    TextureCache&               texture_cache,
+    const Vector2f&             uv,
+    const Vector2f&             delta,
+    float&                      scalar,
+    Vector2f&                   gradient) const
+{
+    // Start with the transformed input texture coordinates.
+    Vector2f p = apply_transform(uv);
+    p.y = 1.0f - p.y;
+
+    // Apply the texture addressing mode.
+    apply_addressing_mode(m_texture_instance.get_addressing_mode(), p);
+
+    // Always reconstruct the base level bilinearly: the derivatives of the
+    // nearest neighbor reconstruction would be zero almost everywhere.
+    Color4f dcdx, dcdy;
+    scalar = sample_bilinear(texture_cache, 0, p, dcdx, dcdy)[0];
+
+    // Compute the partial derivatives of the texel space coordinates with respect to (u, v).
+    const MipLevel& base_level = m_mip_levels[0];
+    const Vector3f dpdu = m_texture_transform.vector_to_local(Vector3f(1.0f, 0.0f, 0.0f));
+    const Vector3f dpdv = m_texture_transform.vector_to_local(Vector3f(0.0f, 1.0f, 0.0f));
+    const float dxdu = dpdu.x * m_uv_scale.x * base_level.m_max_x;
+    const float dxdv = dpdv.x * m_uv_scale.x * base_level.m_max_x;
+    const float dydu = -dpdu.y * m_uv_scale.y * base_level.m_max_y;
+    const float dydv = -dpdv.y * m_uv_scale.y * base_level.m_max_y;
+
+    // Apply the chain rule.
+    gradient[0] = dcdx[0] * dxdu + dcdy[0] * dydu;
+    gradient[1] = dcdx[0] * dxdv + dcdy[0] * dydv;
+}
+
 Color4f TextureSource::sample_texture(
     TextureCache&               texture_cache,
-    const Vector2f&             uv) const
+    const Vector2f&             uv,
+    const float                 lod) const
 {
     // Start with the transformed input texture coordinates.
     Vector2f p = apply_transform(uv);
@@ -373,48 +542,38 @@ Color4f TextureSource::sample_texture(
     {
       case TextureFilteringNearest:
         {
-            p.x = clamp(p.x * m_scalar_canvas_width, 0.0f, m_max_x);
-            p.y = clamp(p.y * m_scalar_canvas_height, 0.0f, m_max_y);
+            const MipLevel& base_level = m_mip_levels[0];
+
+            p.x = clamp(p.x * base_level.m_scalar_canvas_width, 0.0f, base_level.m_max_x);
+            p.y = clamp(p.y * base_level.m_scalar_canvas_height, 0.0f, base_level.m_max_y);
 
             const size_t ix = truncate<size_t>(p.x);
             const size_t iy = truncate<size_t>(p.y);
 
-            return get_texel(texture_cache, ix, iy);
+            return get_texel(texture_cache, 0, ix, iy);
         }
 
       case TextureFilteringBilinear:
+        return sample_bilinear(texture_cache, 0, p);
+
+      case TextureFilteringTrilinear:
         {
-            p.x *= m_max_x;
-            p.y *= m_max_y;
-
-            const int ix = truncate<int>(p.x);
-            const int iy = truncate<int>(p.y);
-
-            // Retrieve the four surrounding texels.
-            Color4f t00, t10, t01, t11;
-            get_texels_2x2(
-                texture_cache,
-                ix, iy,
-                t00, t10, t01, t11);
-
-            // Compute weights.
-            const float wx1 = p.x - ix;
-            const float wy1 = p.y - iy;
-            const float wx0 = 1.0f - wx1;
-            const float wy0 = 1.0f - wy1;
-
-            // Apply weights.
-            t00 *= wx0 * wy0;
-            t10 *= wx1 * wy0;
-            t01 *= wx0 * wy1;
-            t11 *= wx1 * wy1;
-
-            // Accumulate.
-            t00 += t10;
-            t00 += t01;
-            t00 += t11;
-
-            return t00;
+            assert(lod >= 0.0f && lod <= m_mip_levels.size() - 1);
+
+            const size_t level = truncate<size_t>(lod);
+            const float t = lod - level;
+
+            // Blend the two nearest mipmap levels.
+            Color4f c0 = sample_bilinear(texture_cache, level, p);
+            if (t > 0.0f)
+            {
+                Color4f c1 = sample_bilinear(texture_cache, level + 1, p);
+                c0 *= 1.0f - t;
+                c1 *= t;
+                c0 += c1;
+            }
+
+            return c0;
         }
 
       default:
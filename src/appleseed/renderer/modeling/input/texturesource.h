@@ -46,6 +46,7 @@
 
 // Standard headers.
 #include <cstddef>
+#include <vector>
 
 // Forward declarations.
 namespace renderer      { class TextureCache; }
@@ -72,6 +73,9 @@ class TextureSource
     // Compute a signature unique to this source.
     virtual foundation::uint64 compute_signature() const APPLESEED_OVERRIDE;
 
+    // Return true if the texture instance uses trilinear filtering.
+    virtual bool uses_uv_derivatives() const APPLESEED_OVERRIDE;
+
     // Evaluate the source at a given shading point.
     virtual void evaluate(
         TextureCache&                       texture_cache,
@@ -100,30 +104,96 @@ class TextureSource
         Spectrum&                           spectrum,
         Alpha&                              alpha) const APPLESEED_OVERRIDE;
 
+    // Evaluate the source and the exact partial derivatives of its bilinear
+    // reconstruction from the same 2x2 block of texels. 'delta' is ignored.
+    virtual void evaluate_with_gradient(
+        TextureCache&                       texture_cache,
+        const foundation::Vector2f&         uv,
+        const foundation::Vector2f&         delta,
+        float&                              scalar,
+        foundation::Vector2f&               gradient) const APPLESEED_OVERRIDE;
+
+    // Evaluate the source at a given shading point, selecting the mipmap levels
+    // according to the screen space footprint of the shading point in the texture.
+    virtual void evaluate(
+        TextureCache&                       texture_cache,
+        const foundation::Vector2f&         uv,
+        const foundation::Vector2f&         duvdx,
+        const foundation::Vector2f&         duvdy,
+        float&                              scalar) const APPLESEED_OVERRIDE;
+    virtual void evaluate(
+        TextureCache&                       texture_cache,
+        const foundation::Vector2f&         uv,
+        const foundation::Vector2f&         duvdx,
+        const foundation::Vector2f&         duvdy,
+        foundation::Color3f&                linear_rgb) const APPLESEED_OVERRIDE;
+    virtual void evaluate(
+        TextureCache&                       texture_cache,
+        const foundation::Vector2f&         uv,
+        const foundation::Vector2f&         duvdx,
+        const foundation::Vector2f&         duvdy,
+        Spectrum&                           spectrum) const APPLESEED_OVERRIDE;
+    virtual void evaluate(
+        TextureCache&                       texture_cache,
+        const foundation::Vector2f&         uv,
+        const foundation::Vector2f&         duvdx,
+        const foundation::Vector2f&         duvdy,
+        Alpha&                              alpha) const APPLESEED_OVERRIDE;
+    virtual void evaluate(
+        TextureCache&                       texture_cache,
+        const foundation::Vector2f&         uv,
+        const foundation::Vector2f&         duvdx,
+        const foundation::Vector2f&         duvdy,
+        foundation::Color3f&                linear_rgb,
+        Alpha&                              alpha) const APPLESEED_OVERRIDE;
+    virtual void evaluate(
+        TextureCache&                       texture_cache,
+        const foundation::Vector2f&         uv,
+        const foundation::Vector2f&         duvdx,
+        const foundation::Vector2f&         duvdy,
+        Spectrum&                           spectrum,
+        Alpha&                              alpha) const APPLESEED_OVERRIDE;
+
   private:
+    struct MipLevel
+    {
+        size_t                              m_canvas_width;
+        size_t                              m_canvas_height;
+        float                               m_scalar_canvas_width;
+        float                               m_scalar_canvas_height;
+        float                               m_max_x;
+        float                               m_max_y;
+    };
+
     const foundation::UniqueID              m_assembly_uid;
     const TextureInstance&                  m_texture_instance;
     const foundation::UniqueID              m_texture_uid;
     const foundation::CanvasProperties      m_texture_props;
     const foundation::Transformf            m_texture_transform;
-    const float                             m_scalar_canvas_width;
-    const float                             m_scalar_canvas_height;
-    const float                             m_max_x;
-    const float                             m_max_y;
+    const foundation::Vector2f              m_uv_scale;         // maps the UV space covered by the texture to [0, 1]^2
+    std::vector<MipLevel>                   m_mip_levels;       // the base level first, down to 1x1
 
     // Apply the texture instance transform to UV coordinates.
     foundation::Vector2f apply_transform(
         const foundation::Vector2f&         uv) const;
 
+    // Compute the mipmap level of detail matching the given screen space partial
+    // derivatives of the texture coordinates.
+    float compute_lod(
+        const foundation::Vector2f&         duvdx,
+        const foundation::Vector2f&         duvdy) const;
+
     // Retrieve a given texel. Return a color in the linear RGB color space.
     foundation::Color4f get_texel(
         TextureCache&                       texture_cache,
+        const size_t                        level,
         const size_t                        ix,
         const size_t                        iy) const;
 
     // Retrieve a 2x2 block of texels. Texels are expressed in the linear RGB color space.
     void get_texels_2x2(
         TextureCache&                       texture_cache,
+        const size_t                        level,
         const int                           ix,
         const int                           iy,
         foundation::Color4f&                t00,
@@ -131,10 +201,26 @@ class TextureSource
         foundation::Color4f&                t01,
         foundation::Color4f&                t11) const;
 
-    // Sample the texture. Return a color in the linear RGB color space.
+    // Sample a given mipmap level of the texture with bilinear filtering.
+    foundation::Color4f sample_bilinear(
+        TextureCache&                       texture_cache,
+        const size_t                        level,
+        const foundation::Vector2f&         p) const;
+
+    // Sample a given mipmap level of the texture with bilinear filtering, and compute the
+    // partial derivatives of the filtered color with respect to texel space coordinates.
+    foundation::Color4f sample_bilinear(
+        TextureCache&                       texture_cache,
+        const size_t                        level,
+        const foundation::Vector2f&         p,
+        foundation::Color4f&                dcdx,
+        foundation::Color4f&                dcdy) const;
+
+    // Sample the texture at a given level of detail. Return a color in the linear RGB color space.
     foundation::Color4f sample_texture(
         TextureCache&                       texture_cache,
-        const foundation::Vector2f&         uv) const;
+        const foundation::Vector2f&         uv,
+        const float                         lod = 0.0f) const;
 
     // Compute an alpha value given a linear RGBA color and the alpha mode of the texture instance.
     void evaluate_alpha(
@@ -210,6 +296,76 @@ inline void TextureSource::evaluate(
     evaluate_alpha(color, alpha);
 }
 
+inline void TextureSource::evaluate(
+    TextureCache&                           texture_cache,
+    const foundation::Vector2f&             uv,
+    const foundation::Vector2f&             duvdx,
+    const foundation::Vector2f&             duvdy,
+    float&                                  scalar) const
+{
+    const foundation::Color4f color = sample_texture(texture_cache, uv, compute_lod(duvdx, duvdy));
+    scalar = color[0];
+}
+
+inline void TextureSource::evaluate(
+    TextureCache&                           texture_cache,
+    const foundation::Vector2f&             uv,
+    const foundation::Vector2f&             duvdx,
+    const foundation::Vector2f&             duvdy,
+    foundation::Color3f&                linear_rgb) const
+{
+    const foundation::Color4f color = sample_texture(texture_cache, uv, compute_lod(duvdx, duvdy));
+    linear_rgb = color.rgb();
+}
+
+inline void TextureSource::evaluate(
+    TextureCache&                           texture_cache,
+    const foundation::Vector2f&             uv,
+    const foundation::Vector2f&             duvdx,
+    const foundation::Vector2f&             duvdy,
+    Spectrum&                           spectrum) const
+{
+    const foundation::Color4f color = sample_texture(texture_cache, uv, compute_lod(duvdx, duvdy));
+    spectrum = color.rgb();
+}
+
+inline void TextureSource::evaluate(
+    TextureCache&                           texture_cache,
+    const foundation::Vector2f&             uv,
+    const foundation::Vector2f&             duvdx,
+    const foundation::Vector2f&             duvdy,
+    Alpha&                                  alpha) const
+{
+    const foundation::Color4f color = sample_texture(texture_cache, uv, compute_lod(duvdx, duvdy));
+    evaluate_alpha(color, alpha);
+}
+
+inline void TextureSource::evaluate(
+    TextureCache&                           texture_cache,
+    const foundation::Vector2f&             uv,
+    const foundation::Vector2f&             duvdx,
+    const foundation::Vector2f&             duvdy,
+    foundation::Color3f&                linear_rgb,
+    Alpha&                                  alpha) const
+{
+    const foundation::Color4f color = sample_texture(texture_cache, uv, compute_lod(duvdx, duvdy));
+    linear_rgb = color.rgb();
+    evaluate_alpha(color, alpha);
+}
+
+inline void TextureSource::evaluate(
+    TextureCache&                           texture_cache,
+    const foundation::Vector2f&             uv,
+    const foundation::Vector2f&             duvdx,
+    const foundation::Vector2f&             duvdy,
+    Spectrum&                           spectrum,
+    Alpha&                                  alpha) const
+{
+    const foundation::Color4f color = sample_texture(texture_cache, uv, compute_lod(duvdx, duvdy));
+    spectrum = color.rgb();
+    evaluate_alpha(color, alpha);
+}
+
 inline void TextureSource::evaluate_alpha(
     const foundation::Color4f&              color,
     Alpha&                                  alpha) const
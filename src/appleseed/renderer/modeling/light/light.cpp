@@ -37,9 +37,11 @@
 #include "foundation/utility/api/apistring.h"
 
 // Standard headers.
+#include <limits>
 #include <string>
 
 using namespace foundation;
+using namespace std;
 
 namespace renderer
 {
@@ -145,4 +147,15 @@ void Light::sample(
             probability);
 }
 
+void Light::get_influence_bounds(
+    const Transformd&       light_transform,
+    Vector3d&               axis,
+    double&                 cos_half_angle,
+    double&                 max_distance) const
+{
+    axis = Vector3d(0.0, 1.0, 0.0);
+    cos_half_angle = -1.0;
+    max_distance = numeric_limits<double>::max();
+}
+
 }   // namespace renderer
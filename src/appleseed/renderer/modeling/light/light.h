@@ -136,6 +136,16 @@ class APPLESEED_DLLSYMBOL Light
         const foundation::Vector3d&     target,                     // world space target point
         const foundation::Vector3d&     position) const = 0;        // world space emission position
 
+    // Compute a conservative bound of the region of space lit by this light: a cone whose apex
+    // is the light position, truncated at a given distance from the apex. Only relies on the
+    // parameters of the light, hence may be called before on_frame_begin(). By default the
+    // region is unbounded.
+    virtual void get_influence_bounds(
+        const foundation::Transformd&   light_transform,            // light space to world space transform
+        foundation::Vector3d&           axis,                       // world space cone axis, unit-length
+        double&                         cos_half_angle,             // cosine of the cone half-angle, -1 for omnidirectional lights
+        double&                         max_distance) const;        // world space distance reached by the light
+
   private:
     struct Impl;
     Impl* impl;
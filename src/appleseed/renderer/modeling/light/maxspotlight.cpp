@@ -49,6 +49,7 @@
 
 // Standard headers.
 #include <cmath>
+#include <limits>
 
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
@@ -116,6 +117,7 @@ namespace
 
             m_decay_start = m_params.get_optional<float>("decay_start", 0.0f);
             m_decay_exponent = m_params.get_optional<float>("decay_exponent", 2.0f);
+            m_cutoff_distance = m_params.get_optional<float>("cutoff_distance", 0.0f);
 
             return true;
         }
@@ -163,13 +165,32 @@ namespace
             const Vector3d&         target,
             const Vector3d&         position) const APPLESEED_OVERRIDE
         {
+            const float distance = sqrt(static_cast<float>(square_distance(target, position)));
+
+            if (m_cutoff_distance > 0.0f && distance > m_cutoff_distance)
+                return 0.0f;
+
             return
                 autodesk_max_decay(
-                    sqrt(static_cast<float>(square_distance(target, position))),
+                    distance,
                     m_decay_start,
                     m_decay_exponent);
         }
 
+        virtual void get_influence_bounds(
+            const Transformd&       light_transform,
+            Vector3d&               axis,
+            double&                 cos_half_angle,
+            double&                 max_distance) const APPLESEED_OVERRIDE
+        {
+            const double outer_half_angle = deg_to_rad(m_params.get_required<double>("outer_angle", 30.0) / 2.0);
+            axis = -normalize(light_transform.get_parent_z());
+            cos_half_angle = cos(outer_half_angle);
+
+            const double cutoff_distance = m_params.get_optional<double>("cutoff_distance", 0.0);
+            max_distance = cutoff_distance > 0.0 ? cutoff_distance : numeric_limits<double>::max();
+        }
+
       private:
         APPLESEED_DECLARE_INPUT_VALUES(InputValues)
         {
@@ -188,6 +209,7 @@ namespace
 
         float           m_decay_start;              // distance at which light decay starts
         float           m_decay_exponent;           // exponent of the light decay function
+        float           m_cutoff_distance;          // distance beyond which the light does not illuminate, 0 for unlimited
 
         static Vector3d rotate_minus_pi_around_x(const Vector3d& v)
         {
@@ -332,6 +354,17 @@ DictionaryArray MaxSpotLightFactory::get_input_metadata() const
             .insert("default", "2.0")
             .insert("help", "Exponent of the light decay function"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "cutoff_distance")
+            .insert("label", "Cutoff Distance")
+            .insert("type", "numeric")
+            .insert("min_value", "0.0")
+            .insert("max_value", "100.0")
+            .insert("use", "optional")
+            .insert("default", "0.0")
+            .insert("help", "Distance beyond which the light does not illuminate; 0 for unlimited"));
+
     add_common_input_metadata(metadata);
 
     return metadata;
@@ -49,6 +49,7 @@
 
 // Standard headers.
 #include <cmath>
+#include <limits>
 
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
@@ -165,6 +166,18 @@ namespace
             return 1.0f / static_cast<float>(square_distance(target, position));
         }
 
+        virtual void get_influence_bounds(
+            const Transformd&       light_transform,
+            Vector3d&               axis,
+            double&                 cos_half_angle,
+            double&                 max_distance) const APPLESEED_OVERRIDE
+        {
+            const double outer_half_angle = deg_to_rad(m_params.get_required<double>("outer_angle", 30.0) / 2.0);
+            axis = -normalize(light_transform.get_parent_z());
+            cos_half_angle = cos(outer_half_angle);
+            max_distance = numeric_limits<double>::max();
+        }
+
       private:
         APPLESEED_DECLARE_INPUT_VALUES(InputValues)
         {
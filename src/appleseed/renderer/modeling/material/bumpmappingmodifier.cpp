@@ -66,9 +66,6 @@ BumpMappingModifier::BumpMappingModifier(
     {
         m_du = m_dv = offset;
     }
-
-    m_rcp_du = 1.0f / m_du;
-    m_rcp_dv = 1.0f / m_dv;
 }
 
 Basis3d BumpMappingModifier::modify(
@@ -76,21 +73,14 @@ Basis3d BumpMappingModifier::modify(
     const Vector2f&     uv,
     const Basis3d&      basis) const
 {
-    // Evaluate the displacement function at (u, v).
+    // Evaluate the displacement function and its partial derivatives at (u, v).
     float val;
-    m_map->evaluate(texture_cache, uv, val);
-
-    // Evaluate the displacement function at (u + delta_u, v).
-    float val_du;
-    m_map->evaluate(texture_cache, Vector2f(uv[0] + m_du, uv[1]), val_du);
-
-    // Evaluate the displacement function at (u, v + delta_v).
-    float val_dv;
-    m_map->evaluate(texture_cache, Vector2f(uv[0], uv[1] + m_dv), val_dv);
+    Vector2f dval;
+    m_map->evaluate_with_gradient(texture_cache, uv, Vector2f(m_du, m_dv), val, dval);
 
     // Compute the partial derivatives of the displacement function d(u, v).
-    const double ddispdu = m_amplitude * (val_du - val) * m_rcp_du;
-    const double ddispdv = m_amplitude * (val_dv - val) * m_rcp_dv;
+    const double ddispdu = m_amplitude * dval[0];
+    const double ddispdv = m_amplitude * dval[1];
 
     // Compute the partial derivatives of the displaced surface p(u, v) + d(u, v) * n.
     const Vector3d perturbed_dpdu = basis.get_tangent_u() + ddispdu * basis.get_normal();
@@ -63,7 +63,6 @@ class BumpMappingModifier
     const Source*   m_map;
     const float     m_amplitude;
     float           m_du, m_dv;
-    float           m_rcp_du, m_rcp_dv;
 };
 
 }       // namespace renderer
@@ -67,7 +67,10 @@ namespace
 {
     //
     // The DisneyLayerParam class wraps an SeAppleseedExpr object to add basic optimizations
-    // for straightforward expressions such as a single scalar or a simple texture lookup.
+    // for straightforward expressions. Expressions made of arithmetic, common math functions,
+    // $u, $v and texture lookups are compiled into SeExprProgram objects that are folded into
+    // constants when possible and otherwise evaluated without going through SeExpr. Other
+    // expressions are evaluated by the SeExpr interpreter.
     //
 
     class DisneyLayerParam
@@ -81,7 +84,6 @@ namespace
           , m_expr(params.get<string>(name))
           , m_is_vector(is_vector)
           , m_is_constant(false)
-          , m_texture_is_srgb(true)
         {
         }
 
@@ -91,8 +93,8 @@ namespace
           , m_is_vector(other.m_is_vector)
           , m_is_constant(other.m_is_constant)
           , m_constant_value(other.m_constant_value)
-          , m_texture_filename(other.m_texture_filename)
-          , m_texture_options(other.m_texture_options)
+          , m_program(other.m_program)
+          , m_texture_filenames(other.m_texture_filenames)
           , m_texture_is_srgb(other.m_texture_is_srgb)
         {
         }
@@ -107,8 +109,47 @@ namespace
             return m_expr;
         }
 
-        bool prepare()
+        bool prepare(SeExprProgramCache* program_cache)
         {
+            // Nothing to do if this parameter was copied from a prepared one.
+            if (m_is_constant || m_program)
+                return true;
+
+            // Try to compile the expression into a program.
+            SeExprProgramCache::ProgramPtr program;
+            if (program_cache)
+                program = program_cache->get(m_expr, m_is_vector);
+            else
+            {
+                SeExprProgram* new_program = new SeExprProgram();
+                program.reset(new_program);
+                if (!new_program->compile(m_expr, m_is_vector))
+                    program.reset();
+            }
+
+            if (program)
+            {
+                if (program->is_constant())
+                {
+                    m_is_constant = true;
+                    m_constant_value = program->evaluate(0.0, 0.0);
+                    return true;
+                }
+
+                m_program = program;
+
+                const vector<string>& paths = m_program->get_texture_paths();
+                for (const_each<vector<string> > i = paths; i; ++i)
+                {
+                    const OIIO::ustring filename(*i);
+                    m_texture_filenames.push_back(filename);
+                    m_texture_is_srgb.push_back(texture_is_srgb(filename));
+                }
+
+                return true;
+            }
+
+            // Fall back to the SeExpr interpreter.
             m_expression.setWantVec(m_is_vector);
             m_expression.set_expr(m_expr);
 
@@ -119,49 +160,21 @@ namespace
                 return false;
             }
 
-            // Case of a simple constant.
             m_is_constant = m_expression.isConstant();
             if (m_is_constant)
             {
                 const SeVec3d result = m_expression.evaluate();
                 m_constant_value = Color3d(result[0], result[1], result[2]);
-                return true;
-            }
-
-            // Case of a simple texture lookup of the form texture("path/to/texture", $u, $v).
-            {
-                const string expression = trim_both(m_expression.getExpr(), " \r\n");
-                vector<string> tokens;
-                tokenize(expression, "()", tokens);
-
-                if (tokens.size() != 2)
-                    return true;
-
-                if (trim_both(tokens[0]) != "texture")
-                    return true;
-
-                const string inner_content = tokens[1];
-                tokens.clear();
-                tokenize(inner_content, ",", tokens);
-
-                if (tokens.size() != 3)
-                    return true;
-
-                if (trim_both(tokens[1]) != "$u")
-                    return true;
-
-                if (trim_both(tokens[2]) != "$v")
-                    return true;
-
-                m_texture_filename = OIIO::ustring(trim_both(tokens[0], " \""));
-                m_texture_is_srgb = texture_is_srgb(m_texture_filename);
-                m_texture_options.swrap = OIIO::TextureOpt::WrapPeriodic;
-                m_texture_options.rwrap = OIIO::TextureOpt::WrapPeriodic;
             }
 
             return true;
         }
 
+        bool is_constant_zero() const
+        {
+            return m_is_constant && m_constant_value[0] == 0.0;
+        }
+
         Color3f evaluate(
             const ShadingPoint&     shading_point,
             OIIO::TextureSystem&    texture_system) const
@@ -169,38 +182,20 @@ namespace
             if (m_is_constant)
                 return m_constant_value;
 
-            if (!m_texture_filename.empty())
+            if (m_program)
             {
-                const Vector2f& uv = shading_point.get_uv(0);
+                const SeExprProgramTextureLookup texture_lookup(
+                    texture_system,
+                    m_texture_filenames,
+                    m_texture_is_srgb);
 
-                Color3f color;
-                if (!texture_system.texture(
-                        m_texture_filename,
-                        m_texture_options,
-                        uv[0],
-                        uv[1],
-                        0.0f,
-                        0.0f,
-                        0.0f,
-                        0.0f,
-                        3,
-                        &color[0]))
-                {
-                    // Failed to find or open the texture.
-                    const string message = texture_system.geterror();
-                    if (!message.empty())
-                    {
-                        const string trimmed_message = trim_both(message);
-                        RENDERER_LOG_ERROR("oiio: %s", trimmed_message.c_str());
-                    }
-                    return Color3f(1.0f, 0.0f, 1.0f);
-                }
-
-                // Colors in SeExpr are always in the sRGB color space.
-                if (!m_texture_is_srgb)
-                    color = linear_rgb_to_srgb(color);
+                const Vector2f& uv = shading_point.get_uv(0);
 
-                return color;
+                return
+                    m_program->evaluate(
+                        static_cast<double>(uv[0]),
+                        static_cast<double>(uv[1]),
+                        &texture_lookup);
             }
 
             return
@@ -210,15 +205,15 @@ namespace
         }
 
       private:
-        const char*                 m_param_name;
-        string                      m_expr;
-        bool                        m_is_vector;
-        bool                        m_is_constant;
-        Color3d                     m_constant_value;
-        OIIO::ustring               m_texture_filename;
-        mutable OIIO::TextureOpt    m_texture_options;
-        bool                        m_texture_is_srgb;
-        mutable SeAppleseedExpr     m_expression;
+        const char*                     m_param_name;
+        string                          m_expr;
+        bool                            m_is_vector;
+        bool                            m_is_constant;
+        Color3d                         m_constant_value;
+        SeExprProgramCache::ProgramPtr  m_program;
+        vector<OIIO::ustring>           m_texture_filenames;
+        vector<bool>                    m_texture_is_srgb;
+        mutable SeAppleseedExpr         m_expression;
     };
 }
 
@@ -311,21 +306,31 @@ int DisneyMaterialLayer::get_layer_number() const
     return impl->m_layer_number;
 }
 
-bool DisneyMaterialLayer::prepare_expressions() const
+bool DisneyMaterialLayer::prepare_expressions(SeExprProgramCache* program_cache) const
 {
     return
-        impl->m_mask.prepare() &&
-        impl->m_base_color.prepare() &&
-        impl->m_subsurface.prepare() &&
-        impl->m_metallic.prepare() &&
-        impl->m_specular.prepare() &&
-        impl->m_specular_tint.prepare() &&
-        impl->m_anisotropic.prepare() &&
-        impl->m_roughness.prepare() &&
-        impl->m_sheen.prepare() &&
-        impl->m_sheen_tint.prepare() &&
-        impl->m_clearcoat.prepare() &&
-        impl->m_clearcoat_gloss.prepare();
+        impl->m_mask.prepare(program_cache) &&
+        impl->m_base_color.prepare(program_cache) &&
+        impl->m_subsurface.prepare(program_cache) &&
+        impl->m_metallic.prepare(program_cache) &&
+        impl->m_specular.prepare(program_cache) &&
+        impl->m_specular_tint.prepare(program_cache) &&
+        impl->m_anisotropic.prepare(program_cache) &&
+        impl->m_roughness.prepare(program_cache) &&
+        impl->m_sheen.prepare(program_cache) &&
+        impl->m_sheen_tint.prepare(program_cache) &&
+        impl->m_clearcoat.prepare(program_cache) &&
+        impl->m_clearcoat_gloss.prepare(program_cache);
+}
+
+bool DisneyMaterialLayer::has_sheen() const
+{
+    return !impl->m_mask.is_constant_zero() && !impl->m_sheen.is_constant_zero();
+}
+
+bool DisneyMaterialLayer::has_clearcoat() const
+{
+    return !impl->m_mask.is_constant_zero() && !impl->m_clearcoat.is_constant_zero();
 }
 
 void DisneyMaterialLayer::evaluate_expressions(
@@ -579,6 +584,7 @@ struct DisneyMaterial::Impl
     static const size_t MaxThreadCount = 256;
 
     DisneyMaterialLayerContainer                m_layers;
+    SeExprProgramCache                          m_program_cache;
     auto_ptr<DisneyLayeredBRDF>                 m_brdf;
     mutable TLS<DisneyMaterialLayerContainer*>  m_per_thread_layers;
 
@@ -680,15 +686,20 @@ bool DisneyMaterial::on_frame_begin(
     if (!Material::on_frame_begin(project, parent, recorder, abort_switch))
         return false;
 
-    if (!impl->m_brdf->on_frame_begin(project, parent, recorder, abort_switch))
+    const EntityDefMessageContext context("material", this);
+
+    // Layers are prepared first since the BRDF depends on them.
+    if (!prepare_layers(context))
         return false;
 
-    const EntityDefMessageContext context("material", this);
+    if (!impl->m_brdf->on_frame_begin(project, parent, recorder, abort_switch))
+        return false;
 
     m_render_data.m_bsdf = impl->m_brdf.get();
     m_render_data.m_basis_modifier = create_basis_modifier(context);
+    classify_spectral_inputs();
 
-    return prepare_layers(context);
+    return true;
 }
 
 void DisneyMaterial::on_frame_end(
@@ -697,6 +708,7 @@ void DisneyMaterial::on_frame_end(
 {
     impl->clear_per_thread_layers();
     impl->m_layers.clear();
+    impl->m_program_cache.clear();
 
     Material::on_frame_end(project, parent);
 }
@@ -750,6 +762,8 @@ const DisneyMaterialLayer& DisneyMaterial::get_layer(
 
     if (layers == 0)
     {
+        // The copies share the programs of the prepared layers; only expressions
+        // that could not be compiled need to be parsed again by SeExpr.
         layers = new vector<DisneyMaterialLayer>(impl->m_layers);
 
         for (const_each<vector<DisneyMaterialLayer> > it = *layers; it; ++it)
@@ -774,7 +788,7 @@ bool DisneyMaterial::prepare_layers(const MessageContext& context)
         {
             DisneyMaterialLayer layer(it->key(), it->value());
 
-            if (!layer.prepare_expressions())
+            if (!layer.prepare_expressions(&impl->m_program_cache))
                 return false;
 
             impl->m_layers.push_back(layer);
@@ -51,6 +51,7 @@ END_OIIO_INCLUDES
 // Forward declarations.
 namespace foundation    { class Dictionary; }
 namespace foundation    { class DictionaryArray; }
+namespace foundation    { class SeExprProgramCache; }
 namespace foundation    { class StringArray; }
 namespace foundation    { class StringDictionary; }
 namespace renderer      { class BaseGroup; }
@@ -85,7 +86,16 @@ class APPLESEED_DLLSYMBOL DisneyMaterialLayer
 
     int get_layer_number() const;
 
-    bool prepare_expressions() const;
+    // Prepare the expressions of this layer for evaluation. Expressions are compiled
+    // into programs shared through a cache if one is provided; layers copied from a
+    // prepared layer reuse its programs.
+    bool prepare_expressions(
+        foundation::SeExprProgramCache* program_cache = 0) const;
+
+    // Return false if the sheen (resp. clearcoat) of this layer is known to be
+    // zero everywhere. Only valid after prepare_expressions() has been called.
+    bool has_sheen() const;
+    bool has_clearcoat() const;
 
     void evaluate_expressions(
         const ShadingPoint&             shading_point,
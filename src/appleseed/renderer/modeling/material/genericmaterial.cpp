@@ -91,6 +91,7 @@ namespace
             m_render_data.m_bssrdf = get_uncached_bssrdf();
             m_render_data.m_edf = get_uncached_edf();
             m_render_data.m_basis_modifier = create_basis_modifier(context);
+            classify_spectral_inputs();
 
             if (m_render_data.m_edf && m_render_data.m_alpha_map)
             {
@@ -43,6 +43,7 @@
 #include "renderer/modeling/project/project.h"
 #include "renderer/modeling/scene/scene.h"
 #include "renderer/modeling/scene/textureinstance.h"
+#include "renderer/modeling/shadergroup/shadergroup.h"
 #include "renderer/modeling/surfaceshader/surfaceshader.h"
 #include "renderer/modeling/texture/texture.h"
 #include "renderer/utility/messagecontext.h"
@@ -164,6 +165,8 @@ bool Material::on_frame_begin(
     m_render_data.m_alpha_map = get_uncached_alpha_map();
     m_render_data.m_shader_group = 0;
     m_render_data.m_basis_modifier = 0;
+    classify_opacity();
+    classify_spectral_inputs();
     m_has_render_data = true;
 
     return true;
@@ -197,6 +200,39 @@ const char* Material::get_non_empty(const ParamArray& params, const char* name)
     return is_empty_string(value) ? 0 : value;
 }
 
+void Material::classify_opacity()
+{
+    m_render_data.m_opacity = RenderData::Opaque;
+    m_render_data.m_constant_alpha = 1.0f;
+
+    if (m_render_data.m_alpha_map)
+    {
+        if (m_render_data.m_alpha_map->is_uniform())
+        {
+            Alpha alpha;
+            m_render_data.m_alpha_map->evaluate_uniform(alpha);
+
+            if (alpha[0] < 1.0f)
+            {
+                m_render_data.m_opacity = RenderData::ConstantAlpha;
+                m_render_data.m_constant_alpha = alpha[0];
+            }
+        }
+        else m_render_data.m_opacity = RenderData::VaryingAlpha;
+    }
+
+    if (m_render_data.m_shader_group && m_render_data.m_shader_group->has_transparency())
+        m_render_data.m_opacity = RenderData::VaryingAlpha;
+}
+
+void Material::classify_spectral_inputs()
+{
+    m_render_data.m_has_spectral_inputs =
+        (m_render_data.m_bsdf && m_render_data.m_bsdf->has_spectral_inputs()) ||
+        (m_render_data.m_bssrdf && m_render_data.m_bssrdf->has_spectral_inputs()) ||
+        (m_render_data.m_edf && m_render_data.m_edf->has_spectral_inputs());
+}
+
 IBasisModifier* Material::create_basis_modifier(const MessageContext& context) const
 {
     // Retrieve the source bound to the displacement map input.
@@ -130,6 +130,13 @@ class APPLESEED_DLLSYMBOL Material
 
     struct RenderData
     {
+        enum Opacity
+        {
+            Opaque,                                     // no alpha map, no OSL transparency
+            ConstantAlpha,                              // uniform alpha map, no OSL transparency
+            VaryingAlpha                                // textured alpha map or OSL transparency
+        };
+
         const SurfaceShader*        m_surface_shader;
         const BSDF*                 m_bsdf;
         const BSSRDF*               m_bssrdf;
@@ -137,6 +144,9 @@ class APPLESEED_DLLSYMBOL Material
         const Source*               m_alpha_map;
         const ShaderGroup*          m_shader_group;
         const IBasisModifier*       m_basis_modifier;   // owned by RenderData
+        Opacity                     m_opacity;
+        float                       m_constant_alpha;   // alpha of Opaque and ConstantAlpha materials
+        bool                        m_has_spectral_inputs;  // is the BSDF, BSSRDF or EDF bound to spectral values?
     };
 
     // Return render-time data of this entity.
@@ -155,6 +165,14 @@ class APPLESEED_DLLSYMBOL Material
 
     const char* get_non_empty(const ParamArray& params, const char* name) const;
 
+    // Classify the opacity of the material from its alpha map and its OSL shader group.
+    // Must be called again whenever m_render_data.m_shader_group changes.
+    void classify_opacity();
+
+    // Find whether the BSDF, BSSRDF or EDF of the material is bound to spectral values.
+    // Must be called again whenever any of them changes.
+    void classify_spectral_inputs();
+
     IBasisModifier* create_basis_modifier(const MessageContext& context) const;
 };
 
@@ -127,6 +127,9 @@ namespace
                     m_render_data.m_edf = m_osl_edf.get();
             }
 
+            classify_opacity();
+            classify_spectral_inputs();
+
             return true;
         }
 
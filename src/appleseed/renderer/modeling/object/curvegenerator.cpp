@@ -0,0 +1,196 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "curvegenerator.h"
+
+// appleseed.renderer headers.
+#include "renderer/modeling/object/curveobject.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/hash.h"
+#include "foundation/platform/types.h"
+
+// Boost headers.
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+namespace
+{
+    // Number of curves per block, before splitting. Must not depend on the number of threads.
+    const size_t CurveBlockSize = 4096;
+
+    // Number of blocks generated per thread before they are appended to the curve object.
+    const size_t BlocksPerThreadPerBatch = 4;
+
+    typedef vector<Curve3Type> CurveBlock;
+
+    void split_and_store(CurveBlock& block, const Curve3Type& curve, const size_t split_count)
+    {
+        if (split_count > 0)
+        {
+            Curve3Type child1, child2;
+            curve.split(child1, child2);
+            split_and_store(block, child1, split_count - 1);
+            split_and_store(block, child2, split_count - 1);
+        }
+        else block.push_back(curve);
+    }
+
+    class GenerateCurveBlocks
+    {
+      public:
+        GenerateCurveBlocks(
+            const ICurve3Generator&     generator,
+            const size_t                curve_count,
+            const size_t                split_count,
+            const size_t                first_block_index,
+            vector<CurveBlock>&         blocks,
+            size_t&                     next_index,
+            boost::mutex&               mutex)
+          : m_generator(generator)
+          , m_curve_count(curve_count)
+          , m_split_count(split_count)
+          , m_first_block_index(first_block_index)
+          , m_blocks(blocks)
+          , m_next_index(next_index)
+          , m_mutex(mutex)
+        {
+        }
+
+        void operator()()
+        {
+            while (true)
+            {
+                size_t index;
+
+                {
+                    boost::mutex::scoped_lock lock(m_mutex);
+                    if (m_next_index >= m_blocks.size())
+                        break;
+                    index = m_next_index++;
+                }
+
+                generate_block(m_first_block_index + index, m_blocks[index]);
+            }
+        }
+
+      private:
+        const ICurve3Generator&     m_generator;
+        const size_t                m_curve_count;
+        const size_t                m_split_count;
+        const size_t                m_first_block_index;
+        vector<CurveBlock>&         m_blocks;
+        size_t&                     m_next_index;
+        boost::mutex&               m_mutex;
+
+        void generate_block(const size_t block_index, CurveBlock& block) const
+        {
+            const size_t begin = block_index * CurveBlockSize;
+            const size_t end = min(begin + CurveBlockSize, m_curve_count);
+            assert(begin < end);
+
+            block.reserve((end - begin) << m_split_count);
+
+            MersenneTwister rng(hash_uint32(static_cast<uint32>(block_index)));
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                const Curve3Type curve = m_generator.generate(i, m_curve_count, rng);
+                split_and_store(block, curve, m_split_count);
+            }
+        }
+    };
+}
+
+void generate_curves3(
+    CurveObject&                object,
+    const ICurve3Generator&     generator,
+    const size_t                curve_count,
+    const size_t                split_count,
+    const size_t                thread_count)
+{
+    if (curve_count == 0)
+        return;
+
+    object.reserve_curves3(object.get_curve3_count() + (curve_count << split_count));
+
+    const size_t block_count = (curve_count + CurveBlockSize - 1) / CurveBlockSize;
+    const size_t worker_count = max<size_t>(thread_count, 1);
+    const size_t batch_size = worker_count * BlocksPerThreadPerBatch;
+
+    // Generate blocks in batches to bound the amount of temporary storage.
+    for (size_t first_block = 0; first_block < block_count; first_block += batch_size)
+    {
+        vector<CurveBlock> blocks(min(batch_size, block_count - first_block));
+
+        size_t next_index = 0;
+        boost::mutex mutex;
+        GenerateCurveBlocks generate(
+            generator,
+            curve_count,
+            split_count,
+            first_block,
+            blocks,
+            next_index,
+            mutex);
+
+        const size_t batch_worker_count = min(worker_count, blocks.size());
+        if (batch_worker_count > 1)
+        {
+            boost::thread_group threads;
+            for (size_t i = 0; i < batch_worker_count; ++i)
+                threads.create_thread(generate);
+            threads.join_all();
+        }
+        else generate();
+
+        // Append the blocks in order, so that the results are independent of the number of threads.
+        for (size_t i = 0, e = blocks.size(); i < e; ++i)
+        {
+            if (!blocks[i].empty())
+                object.push_curves3(&blocks[i][0], blocks[i].size());
+            CurveBlock().swap(blocks[i]);
+        }
+    }
+}
+
+}   // namespace renderer
@@ -0,0 +1,88 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_RENDERER_MODELING_OBJECT_CURVEGENERATOR_H
+#define APPLESEED_RENDERER_MODELING_OBJECT_CURVEGENERATOR_H
+
+// appleseed.renderer headers.
+#include "renderer/kernel/intersection/intersectionsettings.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/rng/mersennetwister.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Standard headers.
+#include <cstddef>
+
+// Forward declarations.
+namespace renderer      { class CurveObject; }
+
+namespace renderer
+{
+
+//
+// Interface of a procedural generator of degree-3 curves.
+//
+
+class APPLESEED_DLLSYMBOL ICurve3Generator
+{
+  public:
+    // Destructor.
+    virtual ~ICurve3Generator() {}
+
+    // Generate the curve of a given index. Called concurrently from multiple threads.
+    virtual Curve3Type generate(
+        const size_t                    curve_index,
+        const size_t                    curve_count,
+        foundation::MersenneTwister&    rng) const = 0;
+};
+
+
+//
+// Generate curves in parallel and append them to a curve object.
+//
+// Curves are generated in fixed-size blocks. Each block uses its own random number
+// generator, seeded from the block index, and blocks are appended to the curve object
+// in order, so the result does not depend on the number of threads.
+//
+// Each generated curve is split split_count times before being stored.
+//
+
+APPLESEED_DLLSYMBOL void generate_curves3(
+    CurveObject&                        object,
+    const ICurve3Generator&             generator,
+    const size_t                        curve_count,
+    const size_t                        split_count,
+    const size_t                        thread_count);
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_MODELING_OBJECT_CURVEGENERATOR_H
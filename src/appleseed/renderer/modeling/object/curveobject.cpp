@@ -137,6 +137,13 @@ size_t CurveObject::push_curve3(const Curve3Type& curve)
     return index;
 }
 
+size_t CurveObject::push_curves3(const Curve3Type* curves, const size_t count)
+{
+    const size_t index = impl->m_curves3.size();
+    impl->m_curves3.insert(impl->m_curves3.end(), curves, curves + count);
+    return index;
+}
+
 size_t CurveObject::get_curve1_count() const
 {
     return impl->m_curves1.size();
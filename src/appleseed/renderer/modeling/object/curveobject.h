@@ -79,6 +79,7 @@ class APPLESEED_DLLSYMBOL CurveObject
     void reserve_curves3(const size_t count);
     size_t push_curve1(const Curve1Type& curve);
     size_t push_curve3(const Curve3Type& curve);
+    size_t push_curves3(const Curve3Type* curves, const size_t count);     // returns the index of the first curve
     size_t get_curve1_count() const;
     size_t get_curve3_count() const;
     const Curve1Type& get_curve1(const size_t index) const;
@@ -33,6 +33,7 @@
 #include "renderer/global/globallogger.h"
 #include "renderer/global/globaltypes.h"
 #include "renderer/kernel/intersection/intersectionsettings.h"
+#include "renderer/modeling/object/curvegenerator.h"
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
@@ -45,8 +46,11 @@
 #include "foundation/math/sampling/mappings.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/types.h"
+#include "foundation/utility/bufferedfile.h"
 #include "foundation/utility/memory.h"
 #include "foundation/utility/otherwise.h"
 #include "foundation/utility/searchpaths.h"
@@ -57,9 +61,11 @@
 #include "boost/filesystem/path.hpp"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <string>
 
@@ -88,8 +94,10 @@ auto_release_ptr<CurveObject> CurveObjectReader::read(
     else
     {
         const string extension = lower_case(bf::path(filepath).extension().string());
-        if (extension == ".txt")
+        if (extension == ".txt" || extension == ".curves")
             return load_text_curve_file(search_paths, name, params);
+        else if (extension == ".binarycurve")
+            return load_binary_curve_file(search_paths, name, params);
         else if (extension == ".mitshair")
             return load_mitsuba_curve_file(search_paths, name, params);
         else throw ExceptionUnsupportedFileFormat(filepath.c_str());
@@ -109,6 +117,96 @@ namespace
         }
         else object.push_curve3(curve);
     }
+
+    size_t get_generation_thread_count(const ParamArray& params)
+    {
+        const size_t thread_count =
+            params.get_optional<size_t>("threads", System::get_logical_cpu_core_count());
+        return max<size_t>(thread_count, 1);
+    }
+
+    class HairBallGenerator
+      : public ICurve3Generator
+    {
+      public:
+        explicit HairBallGenerator(const GScalar curve_width)
+          : m_curve_width(curve_width)
+        {
+        }
+
+        virtual Curve3Type generate(
+            const size_t            curve_index,
+            const size_t            curve_count,
+            MersenneTwister&        rng) const APPLESEED_OVERRIDE
+        {
+            const size_t ControlPointCount = 4;
+            GVector3 points[ControlPointCount];
+
+            for (size_t p = 0; p < ControlPointCount; ++p)
+            {
+                // http://math.stackexchange.com/questions/87230/picking-random-points-in-the-volume-of-sphere-with-uniform-probability
+                const GScalar r = pow(GScalar(1.0) - rand2<GScalar>(rng), GScalar(1.0) / 3);
+                const GVector3 d = sample_sphere_uniform(rand_vector2<GVector2>(rng));
+                points[p] = r * d;
+            }
+
+            return Curve3Type(points, m_curve_width);
+        }
+
+      private:
+        const GScalar m_curve_width;
+    };
+
+    class FurryBallGenerator
+      : public ICurve3Generator
+    {
+      public:
+        explicit FurryBallGenerator(const ParamArray& params)
+          : m_curve_length(params.get_optional<GScalar>("length", GScalar(0.1)))
+          , m_length_fuzziness(params.get_optional<GScalar>("length_fuzziness", GScalar(0.3)))
+          , m_root_width(params.get_optional<GScalar>("root_width", GScalar(0.001)))
+          , m_tip_width(params.get_optional<GScalar>("tip_width", GScalar(0.0001)))
+          , m_curliness(params.get_optional<GScalar>("curliness", GScalar(0.5)))
+        {
+        }
+
+        virtual Curve3Type generate(
+            const size_t            curve_index,
+            const size_t            curve_count,
+            MersenneTwister&        rng) const APPLESEED_OVERRIDE
+        {
+            const size_t ControlPointCount = 4;
+            GVector3 points[ControlPointCount];
+            GScalar widths[ControlPointCount];
+
+            static const size_t Bases[] = { 2 };
+            const GVector2 s = hammersley_sequence<GScalar, 2>(Bases, curve_count, curve_index);
+            const GVector3 d = sample_sphere_uniform(s);
+
+            points[0] = d;
+            widths[0] = m_root_width;
+
+            const GScalar f = rand1(rng, -m_length_fuzziness, +m_length_fuzziness);
+            const GScalar length = m_curve_length * (GScalar(1.0) + f);
+
+            for (size_t p = 1; p < ControlPointCount; ++p)
+            {
+                const GScalar r = static_cast<GScalar>(p) / (ControlPointCount - 1);
+                const GVector3 f = m_curliness * sample_sphere_uniform(rand_vector2<GVector2>(rng));
+                points[p] = points[0] + length * (r * d + f);
+                widths[p] = lerp(m_root_width, m_tip_width, r);
+            }
+
+            return Curve3Type(points, widths);
+        }
+
+      private:
+        const GScalar m_curve_length;
+        const GScalar m_length_fuzziness;
+        const GScalar m_root_width;
+        const GScalar m_tip_width;
+        const GScalar m_curliness;
+    };
 }
 
 auto_release_ptr<CurveObject> CurveObjectReader::create_hair_ball(
@@ -117,30 +215,16 @@ auto_release_ptr<CurveObject> CurveObjectReader::create_hair_ball(
 {
     auto_release_ptr<CurveObject> object = CurveObjectFactory::create(name, params);
 
-    const size_t ControlPointCount = 4;
     const size_t curve_count = params.get_optional<size_t>("curves", 100);
     const GScalar curve_width = params.get_optional<GScalar>("width", GScalar(0.002));
     const size_t split_count = params.get_optional<size_t>("presplits", 0);
 
-    object->reserve_curves3(curve_count);
-
-    MersenneTwister rng;
-
-    for (size_t c = 0; c < curve_count; ++c)
-    {
-        GVector3 points[ControlPointCount];
-
-        for (size_t p = 0; p < ControlPointCount; ++p)
-        {
-            // http://math.stackexchange.com/questions/87230/picking-random-points-in-the-volume-of-sphere-with-uniform-probability
-            const GScalar r = pow(GScalar(1.0) - rand2<GScalar>(rng), GScalar(1.0) / 3);
-            const GVector3 d = sample_sphere_uniform(rand_vector2<GVector2>(rng));
-            points[p] = r * d;
-        }
-
-        const Curve3Type curve(points, curve_width);
-        split_and_store(object.ref(), curve, split_count);
-    }
+    generate_curves3(
+        object.ref(),
+        HairBallGenerator(curve_width),
+        curve_count,
+        split_count,
+        get_generation_thread_count(params));
 
     return object;
 }
@@ -151,45 +235,15 @@ auto_release_ptr<CurveObject> CurveObjectReader::create_furry_ball(
 {
     auto_release_ptr<CurveObject> object = CurveObjectFactory::create(name, params);
 
-    const size_t ControlPointCount = 4;
     const size_t curve_count = params.get_optional<size_t>("curves", 100);
-    const GScalar curve_length = params.get_optional<GScalar>("length", GScalar(0.1));
-    const GScalar length_fuzziness = params.get_optional<GScalar>("length_fuzziness", GScalar(0.3));
-    const GScalar root_width = params.get_optional<GScalar>("root_width", GScalar(0.001));
-    const GScalar tip_width = params.get_optional<GScalar>("tip_width", GScalar(0.0001));
-    const GScalar curliness = params.get_optional<GScalar>("curliness", GScalar(0.5));
     const size_t split_count = params.get_optional<size_t>("presplits", 0);
 
-    object->reserve_curves3(curve_count);
-
-    MersenneTwister rng;
-
-    for (size_t c = 0; c < curve_count; ++c)
-    {
-        GVector3 points[ControlPointCount];
-        GScalar widths[ControlPointCount];
-
-        static const size_t Bases[] = { 2 };
-        const GVector2 s = hammersley_sequence<GScalar, 2>(Bases, curve_count, c);
-        const GVector3 d = sample_sphere_uniform(s);
-
-        points[0] = d;
-        widths[0] = root_width;
-
-        const GScalar f = rand1(rng, -length_fuzziness, +length_fuzziness);
-        const GScalar length = curve_length * (GScalar(1.0) + f);
-
-        for (size_t p = 1; p < ControlPointCount; ++p)
-        {
-            const GScalar r = static_cast<GScalar>(p) / (ControlPointCount - 1);
-            const GVector3 f = curliness * sample_sphere_uniform(rand_vector2<GVector2>(rng));
-            points[p] = points[0] + length * (r * d + f);
-            widths[p] = lerp(root_width, tip_width, r);
-        }
-
-        const Curve3Type curve(points, widths);
-        split_and_store(object.ref(), curve, split_count);
-    }
+    generate_curves3(
+        object.ref(),
+        FurryBallGenerator(params),
+        curve_count,
+        split_count,
+        get_generation_thread_count(params));
 
     return object;
 }
@@ -292,6 +346,139 @@ auto_release_ptr<CurveObject> CurveObjectReader::load_text_curve_file(
     return object;
 }
 
+namespace
+{
+    template <typename File>
+    bool checked_read(File& file, void* outbuf, const size_t size)
+    {
+        return file.read(outbuf, size) == size;
+    }
+
+    template <typename CurveType>
+    bool read_binary_curve(ReaderAdapter& reader, CurveType& curve)
+    {
+        // Control points are stored as (x, y, z, width) quadruples of 32-bit floats.
+        const size_t ControlPointCount = CurveType::Degree + 1;
+        float values[ControlPointCount * 4];
+
+        if (!checked_read(reader, values, sizeof(values)))
+            return false;
+
+        GVector3 points[ControlPointCount];
+        GScalar widths[ControlPointCount];
+
+        for (size_t p = 0; p < ControlPointCount; ++p)
+        {
+            points[p] = GVector3(values[p * 4 + 0], values[p * 4 + 1], values[p * 4 + 2]);
+            widths[p] = static_cast<GScalar>(values[p * 4 + 3]);
+        }
+
+        curve = CurveType(points, widths);
+        return true;
+    }
+}
+
+auto_release_ptr<CurveObject> CurveObjectReader::load_binary_curve_file(
+    const SearchPaths&      search_paths,
+    const char*             name,
+    const ParamArray&       params)
+{
+    // todo: fix for big endian CPUs.
+
+    auto_release_ptr<CurveObject> object = CurveObjectFactory::create(name, params);
+
+    const string filepath = search_paths.qualify(params.get<string>("filepath"));
+    const size_t split_count = params.get_optional<size_t>("presplits", 0);
+
+    BufferedFile file(
+        filepath.c_str(),
+        BufferedFile::BinaryType,
+        BufferedFile::ReadMode);
+
+    if (!file.is_open())
+    {
+        RENDERER_LOG_ERROR("failed to open curve file %s.", filepath.c_str());
+        return object;
+    }
+
+    static const char ExpectedSig[11] = { 'B', 'I', 'N', 'A', 'R', 'Y', 'C', 'U', 'R', 'V', 'E' };
+    char signature[sizeof(ExpectedSig)];
+
+    if (!checked_read(file, signature, sizeof(signature)) ||
+        memcmp(signature, ExpectedSig, sizeof(ExpectedSig)) != 0)
+    {
+        RENDERER_LOG_ERROR("failed to load curve file %s: unknown signature.", filepath.c_str());
+        return object;
+    }
+
+    uint16 version;
+    if (!checked_read(file, &version, sizeof(version)))
+    {
+        RENDERER_LOG_ERROR("failed to load curve file %s: i/o error.", filepath.c_str());
+        return object;
+    }
+
+    if (version != 1)
+    {
+        RENDERER_LOG_ERROR("failed to load curve file %s: unknown format version.", filepath.c_str());
+        return object;
+    }
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    LZ4CompressedReaderAdapter reader(file);
+
+    uint32 curve1_count, curve3_count;
+    if (!checked_read(reader, &curve1_count, sizeof(curve1_count)) ||
+        !checked_read(reader, &curve3_count, sizeof(curve3_count)))
+    {
+        RENDERER_LOG_ERROR("failed to load curve file %s: i/o error.", filepath.c_str());
+        return object;
+    }
+
+    object->reserve_curves1(curve1_count);
+    object->reserve_curves3(curve3_count);
+
+    for (uint32 c = 0; c < curve1_count; ++c)
+    {
+        Curve1Type curve;
+        if (!read_binary_curve(reader, curve))
+        {
+            RENDERER_LOG_ERROR("failed to load curve file %s: i/o error.", filepath.c_str());
+            return object;
+        }
+
+        // We never presplit degree-1 curves.
+        object->push_curve1(curve);
+    }
+
+    for (uint32 c = 0; c < curve3_count; ++c)
+    {
+        Curve3Type curve;
+        if (!read_binary_curve(reader, curve))
+        {
+            RENDERER_LOG_ERROR("failed to load curve file %s: i/o error.", filepath.c_str());
+            return object;
+        }
+
+        split_and_store(object.ref(), curve, split_count);
+    }
+
+    stopwatch.measure();
+
+    const size_t curve_count = static_cast<size_t>(curve1_count) + curve3_count;
+
+    RENDERER_LOG_INFO(
+        "loaded curve file %s (%s curve%s) in %s.",
+        filepath.c_str(),
+        pretty_uint(curve_count).c_str(),
+        curve_count > 1 ? "s" : "",
+        pretty_time(stopwatch.get_seconds()).c_str());
+
+    return object;
+}
+
 auto_release_ptr<CurveObject> CurveObjectReader::load_mitsuba_curve_file(
     const SearchPaths&      search_paths,
     const char*             name,
@@ -38,9 +38,14 @@
 #include "foundation/core/exceptions/exception.h"
 #include "foundation/core/exceptions/exceptionioerror.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/bufferedfile.h"
 #include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
 
+// Boost headers.
+#include "boost/filesystem/path.hpp"
+
 // Standard headers.
 #include <cassert>
 #include <cstddef>
@@ -48,6 +53,7 @@
 
 using namespace foundation;
 using namespace std;
+namespace bf = boost::filesystem;
 
 namespace renderer
 {
@@ -75,6 +81,25 @@ namespace
 
         output << endl;
     }
+
+    template <typename CurveType>
+    bool write_binary_curve(WriterAdapter& writer, const CurveType& curve)
+    {
+        // Control points are stored as (x, y, z, width) quadruples of 32-bit floats.
+        const size_t ControlPointCount = CurveType::Degree + 1;
+        float values[ControlPointCount * 4];
+
+        for (size_t p = 0; p < ControlPointCount; ++p)
+        {
+            const GVector3& point = curve.get_control_point(p);
+            values[p * 4 + 0] = static_cast<float>(point.x);
+            values[p * 4 + 1] = static_cast<float>(point.y);
+            values[p * 4 + 2] = static_cast<float>(point.z);
+            values[p * 4 + 3] = static_cast<float>(curve.get_width(p));
+        }
+
+        return writer.write(values, sizeof(values)) == sizeof(values);
+    }
 }
 
 bool CurveObjectWriter::write(
@@ -83,6 +108,18 @@ bool CurveObjectWriter::write(
 {
     assert(filepath);
 
+    const string extension = lower_case(bf::path(filepath).extension().string());
+
+    return
+        extension == ".binarycurve"
+            ? write_binary_curve_file(object, filepath)
+            : write_text_curve_file(object, filepath);
+}
+
+bool CurveObjectWriter::write_text_curve_file(
+    const CurveObject&  object,
+    const char*         filepath)
+{
     Stopwatch<DefaultWallclockTimer> stopwatch;
     stopwatch.start();
 
@@ -125,4 +162,66 @@ bool CurveObjectWriter::write(
     return true;
 }
 
+bool CurveObjectWriter::write_binary_curve_file(
+    const CurveObject&  object,
+    const char*         filepath)
+{
+    // todo: fix for big endian CPUs.
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    BufferedFile file(
+        filepath,
+        BufferedFile::BinaryType,
+        BufferedFile::WriteMode);
+
+    if (!file.is_open())
+    {
+        RENDERER_LOG_ERROR("failed to create curve file %s.", filepath);
+        return false;
+    }
+
+    static const char Signature[11] = { 'B', 'I', 'N', 'A', 'R', 'Y', 'C', 'U', 'R', 'V', 'E' };
+    const uint16 Version = 1;
+
+    bool success =
+        file.write(Signature, sizeof(Signature)) == sizeof(Signature) &&
+        file.write(&Version, sizeof(Version)) == sizeof(Version);
+
+    if (success)
+    {
+        // The adapter flushes its last compressed block when it is destroyed.
+        LZ4CompressedWriterAdapter writer(file, 256 * 1024);
+
+        const uint32 curve1_count = static_cast<uint32>(object.get_curve1_count());
+        const uint32 curve3_count = static_cast<uint32>(object.get_curve3_count());
+
+        success =
+            writer.write(&curve1_count, sizeof(curve1_count)) == sizeof(curve1_count) &&
+            writer.write(&curve3_count, sizeof(curve3_count)) == sizeof(curve3_count);
+
+        for (uint32 i = 0; success && i < curve1_count; ++i)
+            success = write_binary_curve(writer, object.get_curve1(i));
+
+        for (uint32 i = 0; success && i < curve3_count; ++i)
+            success = write_binary_curve(writer, object.get_curve3(i));
+    }
+
+    if (!file.close() || !success)
+    {
+        RENDERER_LOG_ERROR("failed to write curve file %s: i/o error.", filepath);
+        return false;
+    }
+
+    stopwatch.measure();
+
+    RENDERER_LOG_INFO(
+        "wrote curve file %s in %s.",
+        filepath,
+        pretty_time(stopwatch.get_seconds()).c_str());
+
+    return true;
+}
+
 }   // namespace renderer
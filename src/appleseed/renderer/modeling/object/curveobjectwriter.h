@@ -52,11 +52,21 @@ namespace renderer
 class APPLESEED_DLLSYMBOL CurveObjectWriter
 {
   public:
-    // Write a curve object to disk.
+    // Write a curve object to disk. The file format is selected from the
+    // extension of the file path: BinaryCurve for .binarycurve, text otherwise.
     // Return true on success, false otherwise.
     static bool write(
         const CurveObject&  object,
         const char*         filepath);
+
+  private:
+    static bool write_text_curve_file(
+        const CurveObject&  object,
+        const char*         filepath);
+
+    static bool write_binary_curve_file(
+        const CurveObject&  object,
+        const char*         filepath);
 };
 
 }       // namespace renderer
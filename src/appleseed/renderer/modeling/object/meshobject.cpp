@@ -41,8 +41,12 @@
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/string.h"
 
+// Boost headers.
+#include "boost/shared_ptr.hpp"
+
 // Standard headers.
 #include <cassert>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -64,9 +68,14 @@ namespace
     {
       public:
         explicit MeshRegion(StaticTriangleTess* tess)
-          : m_tess(tess)
-          , m_lazy_tess(tess)
         {
+            set_tess(tess);
+        }
+
+        void set_tess(StaticTriangleTess* tess)
+        {
+            m_tess = tess;
+            m_lazy_tess.reset(new Lazy<StaticTriangleTess>(tess));
         }
 
         virtual GAABB3 compute_local_bbox() const APPLESEED_OVERRIDE
@@ -76,25 +85,26 @@ namespace
 
         virtual Lazy<StaticTriangleTess>& get_static_triangle_tess() const APPLESEED_OVERRIDE
         {
-            return m_lazy_tess;
+            return *m_lazy_tess;
         }
 
       private:
-        StaticTriangleTess*                 m_tess;
-        mutable Lazy<StaticTriangleTess>    m_lazy_tess;
+        StaticTriangleTess*                         m_tess;
+        auto_ptr<Lazy<StaticTriangleTess> >         m_lazy_tess;
     };
 }
 
 struct MeshObject::Impl
 {
-    StaticTriangleTess          m_tess;
-    MeshRegion                  m_region;
-    RegionKit                   m_region_kit;
-    mutable Lazy<RegionKit>     m_lazy_region_kit;
-    vector<string>              m_material_slots;
+    boost::shared_ptr<StaticTriangleTess>   m_tess;
+    MeshRegion                              m_region;
+    RegionKit                               m_region_kit;
+    mutable Lazy<RegionKit>                 m_lazy_region_kit;
+    vector<string>                          m_material_slots;
 
     Impl()
-      : m_region(&m_tess)
+      : m_tess(new StaticTriangleTess())
+      , m_region(m_tess.get())
       , m_lazy_region_kit(&m_region_kit)
     {
         m_region_kit.push_back(&m_region);
@@ -137,6 +147,10 @@ bool MeshObject::on_frame_begin(
     m_alpha_map = get_uncached_alpha_map();
     m_shade_alpha_cutouts = m_params.get_optional<bool>("shade_alpha_cutouts", false);
 
+    // The tessellation is complete by now, and may be shared with other mesh objects.
+    impl->m_tess->track_memory_size();
+    impl->m_tess->advise_large_pages();
+
     return true;
 }
 
@@ -167,7 +181,7 @@ const Source* MeshObject::get_uncached_alpha_map() const
 
 GAABB3 MeshObject::compute_local_bbox() const
 {
-    return impl->m_tess.compute_local_bbox();
+    return impl->m_tess->compute_local_bbox();
 }
 
 Lazy<RegionKit>& MeshObject::get_region_kit()
@@ -177,135 +191,168 @@ Lazy<RegionKit>& MeshObject::get_region_kit()
 
 void MeshObject::reserve_vertices(const size_t count)
 {
-    impl->m_tess.m_vertices.reserve(count);
+    impl->m_tess->m_vertices.reserve(count);
 }
 
 size_t MeshObject::push_vertex(const GVector3& vertex)
 {
-    const size_t index = impl->m_tess.m_vertices.size();
-    impl->m_tess.m_vertices.push_back(vertex);
+    const size_t index = impl->m_tess->m_vertices.size();
+    impl->m_tess->m_vertices.push_back(vertex);
     return index;
 }
 
+void MeshObject::push_vertices(const GVector3 vertices[], const size_t count)
+{
+    impl->m_tess->m_vertices.insert(impl->m_tess->m_vertices.end(), vertices, vertices + count);
+}
+
 size_t MeshObject::get_vertex_count() const
 {
-    return impl->m_tess.m_vertices.size();
+    return impl->m_tess->get_vertex_count();
 }
 
-const GVector3& MeshObject::get_vertex(const size_t index) const
+GVector3 MeshObject::get_vertex(const size_t index) const
 {
-    return impl->m_tess.m_vertices[index];
+    return impl->m_tess->get_vertex(index);
+}
+
+const GVector3* MeshObject::get_vertices() const
+{
+    const StaticTriangleTess::VectorArray& vertices = impl->m_tess->m_vertices;
+    return vertices.empty() ? 0 : &vertices[0];
 }
 
 void MeshObject::reserve_vertex_normals(const size_t count)
 {
-    impl->m_tess.m_vertex_normals.reserve(count);
+    impl->m_tess->m_vertex_normals.reserve(count);
 }
 
 size_t MeshObject::push_vertex_normal(const GVector3& normal)
 {
     assert(is_normalized(normal));
 
-    const size_t index = impl->m_tess.m_vertex_normals.size();
-    impl->m_tess.m_vertex_normals.push_back(normal);
+    const size_t index = impl->m_tess->m_vertex_normals.size();
+    impl->m_tess->m_vertex_normals.push_back(normal);
     return index;
 }
 
+void MeshObject::push_vertex_normals(const GVector3 normals[], const size_t count)
+{
+    impl->m_tess->m_vertex_normals.insert(impl->m_tess->m_vertex_normals.end(), normals, normals + count);
+}
+
 size_t MeshObject::get_vertex_normal_count() const
 {
-    return impl->m_tess.m_vertex_normals.size();
+    return impl->m_tess->get_vertex_normal_count();
 }
 
-const GVector3& MeshObject::get_vertex_normal(const size_t index) const
+GVector3 MeshObject::get_vertex_normal(const size_t index) const
 {
-    return impl->m_tess.m_vertex_normals[index];
+    return impl->m_tess->get_vertex_normal(index);
 }
 
 void MeshObject::clear_vertex_normals()
 {
-    impl->m_tess.m_vertex_normals.clear();
+    impl->m_tess->m_vertex_normals.clear();
+}
+
+const GVector3* MeshObject::get_vertex_normals() const
+{
+    const StaticTriangleTess::VectorArray& normals = impl->m_tess->m_vertex_normals;
+    return normals.empty() ? 0 : &normals[0];
 }
 
 void MeshObject::reserve_vertex_tangents(const size_t count)
 {
-    impl->m_tess.reserve_vertex_tangents(count);
+    impl->m_tess->reserve_vertex_tangents(count);
 }
 
 size_t MeshObject::push_vertex_tangent(const GVector3& tangent)
 {
-    return impl->m_tess.push_vertex_tangent(tangent);
+    return impl->m_tess->push_vertex_tangent(tangent);
 }
 
 size_t MeshObject::get_vertex_tangent_count() const
 {
-    return impl->m_tess.get_vertex_tangent_count();
+    return impl->m_tess->get_vertex_tangent_count();
 }
 
 GVector3 MeshObject::get_vertex_tangent(const size_t index) const
 {
-    return impl->m_tess.get_vertex_tangent(index);
+    return impl->m_tess->get_vertex_tangent(index);
 }
 
 void MeshObject::reserve_tex_coords(const size_t count)
 {
-    impl->m_tess.reserve_tex_coords(count);
+    impl->m_tess->reserve_tex_coords(count);
 }
 
 size_t MeshObject::push_tex_coords(const GVector2& tex_coords)
 {
-    return impl->m_tess.push_tex_coords(tex_coords);
+    return impl->m_tess->push_tex_coords(tex_coords);
 }
 
 size_t MeshObject::get_tex_coords_count() const
 {
-    return impl->m_tess.get_tex_coords_count();
+    return impl->m_tess->get_tex_coords_count();
 }
 
 GVector2 MeshObject::get_tex_coords(const size_t index) const
 {
-    return impl->m_tess.get_tex_coords(index);
+    return impl->m_tess->get_tex_coords(index);
 }
 
 void MeshObject::reserve_triangles(const size_t count)
 {
-    impl->m_tess.m_primitives.reserve(count);
+    impl->m_tess->m_primitives.reserve(count);
 }
 
 size_t MeshObject::push_triangle(const Triangle& triangle)
 {
-    const size_t index = impl->m_tess.m_primitives.size();
-    impl->m_tess.m_primitives.push_back(triangle);
+    const size_t index = impl->m_tess->m_primitives.size();
+    impl->m_tess->m_primitives.push_back(triangle);
     return index;
 }
 
+void MeshObject::push_triangles(const Triangle triangles[], const size_t count)
+{
+    impl->m_tess->m_primitives.insert(impl->m_tess->m_primitives.end(), triangles, triangles + count);
+}
+
 size_t MeshObject::get_triangle_count() const
 {
-    return impl->m_tess.m_primitives.size();
+    return impl->m_tess->m_primitives.size();
 }
 
 const Triangle& MeshObject::get_triangle(const size_t index) const
 {
-    return impl->m_tess.m_primitives[index];
+    return impl->m_tess->m_primitives[index];
 }
 
 Triangle& MeshObject::get_triangle(const size_t index)
 {
-    return impl->m_tess.m_primitives[index];
+    return impl->m_tess->m_primitives[index];
 }
 
 void MeshObject::clear_triangles()
 {
-    impl->m_tess.m_primitives.clear();
+    impl->m_tess->m_primitives.clear();
+}
+
+const Triangle* MeshObject::get_triangles() const
+{
+    const StaticTriangleTess::PrimitiveArray& triangles = impl->m_tess->m_primitives;
+    return triangles.empty() ? 0 : &triangles[0];
 }
 
 void MeshObject::set_motion_segment_count(const size_t count)
 {
-    impl->m_tess.set_motion_segment_count(count);
+    impl->m_tess->set_motion_segment_count(count);
 }
 
 size_t MeshObject::get_motion_segment_count() const
 {
-    return impl->m_tess.get_motion_segment_count();
+    return impl->m_tess->get_motion_segment_count();
 }
 
 void MeshObject::set_vertex_pose(
@@ -313,19 +360,19 @@ void MeshObject::set_vertex_pose(
     const size_t            motion_segment_index,
     const GVector3&         vertex)
 {
-    impl->m_tess.set_vertex_pose(vertex_index, motion_segment_index, vertex);
+    impl->m_tess->set_vertex_pose(vertex_index, motion_segment_index, vertex);
 }
 
 GVector3 MeshObject::get_vertex_pose(
     const size_t            vertex_index,
     const size_t            motion_segment_index) const
 {
-    return impl->m_tess.get_vertex_pose(vertex_index, motion_segment_index);
+    return impl->m_tess->get_vertex_pose(vertex_index, motion_segment_index);
 }
 
 void MeshObject::clear_vertex_poses()
 {
-    impl->m_tess.clear_vertex_poses();
+    impl->m_tess->clear_vertex_poses();
 }
 
 void MeshObject::set_vertex_normal_pose(
@@ -333,19 +380,19 @@ void MeshObject::set_vertex_normal_pose(
     const size_t            motion_segment_index,
     const GVector3&         normal)
 {
-    impl->m_tess.set_vertex_normal_pose(normal_index, motion_segment_index, normal);
+    impl->m_tess->set_vertex_normal_pose(normal_index, motion_segment_index, normal);
 }
 
 GVector3 MeshObject::get_vertex_normal_pose(
     const size_t            normal_index,
     const size_t            motion_segment_index) const
 {
-    return impl->m_tess.get_vertex_normal_pose(normal_index, motion_segment_index);
+    return impl->m_tess->get_vertex_normal_pose(normal_index, motion_segment_index);
 }
 
 void MeshObject::clear_vertex_normal_poses()
 {
-    impl->m_tess.clear_vertex_normal_poses();
+    impl->m_tess->clear_vertex_normal_poses();
 }
 
 void MeshObject::set_vertex_tangent_pose(
@@ -353,19 +400,47 @@ void MeshObject::set_vertex_tangent_pose(
     const size_t            motion_segment_index,
     const GVector3&         tangent)
 {
-    impl->m_tess.set_vertex_tangent_pose(tangent_index, motion_segment_index, tangent);
+    impl->m_tess->set_vertex_tangent_pose(tangent_index, motion_segment_index, tangent);
 }
 
 GVector3 MeshObject::get_vertex_tangent_pose(
     const size_t            tangent_index,
     const size_t            motion_segment_index) const
 {
-    return impl->m_tess.get_vertex_tangent_pose(tangent_index, motion_segment_index);
+    return impl->m_tess->get_vertex_tangent_pose(tangent_index, motion_segment_index);
 }
 
 void MeshObject::clear_vertex_tangent_poses()
 {
-    impl->m_tess.clear_vertex_tangent_poses();
+    impl->m_tess->clear_vertex_tangent_poses();
+}
+
+void MeshObject::compact_vertex_attributes()
+{
+    impl->m_tess->compact_vertex_attributes();
+}
+
+uint64 MeshObject::compute_tessellation_hash() const
+{
+    return impl->m_tess->compute_hash();
+}
+
+bool MeshObject::has_same_tessellation(const MeshObject& other) const
+{
+    return
+        impl->m_tess == other.impl->m_tess ||
+        impl->m_tess->is_equal(*other.impl->m_tess);
+}
+
+void MeshObject::share_tessellation(const MeshObject& other)
+{
+    impl->m_tess = other.impl->m_tess;
+    impl->m_region.set_tess(impl->m_tess.get());
+}
+
+size_t MeshObject::get_tessellation_memory_size() const
+{
+    return impl->m_tess->get_memory_size();
 }
 
 void MeshObject::reserve_material_slots(const size_t count)
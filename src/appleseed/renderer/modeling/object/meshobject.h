@@ -37,6 +37,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/autoreleaseptr.h"
 #include "foundation/utility/lazy.h"
 
@@ -104,16 +105,26 @@ class APPLESEED_DLLSYMBOL MeshObject
     // Insert and access vertices.
     void reserve_vertices(const size_t count);
     size_t push_vertex(const GVector3& vertex);
+    void push_vertices(const GVector3 vertices[], const size_t count);
     size_t get_vertex_count() const;
-    const GVector3& get_vertex(const size_t index) const;
+    GVector3 get_vertex(const size_t index) const;
+
+    // Return the vertex array, or 0 if there are no vertices or if they are stored in compact form.
+    // The pointer is invalidated by any subsequent insertion.
+    const GVector3* get_vertices() const;
 
     // Insert and access vertex normals.
     void reserve_vertex_normals(const size_t count);
     size_t push_vertex_normal(const GVector3& normal);      // the normal must be unit-length
+    void push_vertex_normals(const GVector3 normals[], const size_t count);
     size_t get_vertex_normal_count() const;
-    const GVector3& get_vertex_normal(const size_t index) const;
+    GVector3 get_vertex_normal(const size_t index) const;
     void clear_vertex_normals();
 
+    // Return the vertex normal array, or 0 if there are no vertex normals or if they are stored
+    // in compact form. The pointer is invalidated by any subsequent insertion.
+    const GVector3* get_vertex_normals() const;
+
     // Insert and access vertex tangents.
     void reserve_vertex_tangents(const size_t count);
     size_t push_vertex_tangent(const GVector3& tangent);    // the tangent must be unit-length
@@ -129,11 +140,16 @@ class APPLESEED_DLLSYMBOL MeshObject
     // Insert and access triangles.
     void reserve_triangles(const size_t count);
     size_t push_triangle(const Triangle& triangle);
+    void push_triangles(const Triangle triangles[], const size_t count);
     size_t get_triangle_count() const;
     const Triangle& get_triangle(const size_t index) const;
     Triangle& get_triangle(const size_t index);
     void clear_triangles();
 
+    // Return the triangle array, or 0 if there are no triangles.
+    // The pointer is invalidated by any subsequent insertion.
+    const Triangle* get_triangles() const;
+
     // Set/get the number of motion segments (the number of motion vectors per vertex).
     void set_motion_segment_count(const size_t count);
     size_t get_motion_segment_count() const;
@@ -180,6 +196,23 @@ class APPLESEED_DLLSYMBOL MeshObject
     // Remove all vertex tangent poses.
     void clear_vertex_tangent_poses();
 
+    // Store vertices, vertex normals, texture coordinates and their poses in lossy, compact form.
+    // These features can no longer be inserted or modified afterward.
+    void compact_vertex_attributes();
+
+    // Compute a hash of the tessellation of this mesh object.
+    foundation::uint64 compute_tessellation_hash() const;
+
+    // Return true if this mesh object has the same tessellation as another one.
+    bool has_same_tessellation(const MeshObject& other) const;
+
+    // Share the tessellation of another mesh object, releasing the one of this object.
+    // Neither tessellation should be modified afterward.
+    void share_tessellation(const MeshObject& other);
+
+    // Return the amount of memory used by the tessellation of this mesh object, in bytes.
+    size_t get_tessellation_memory_size() const;
+
     // Insert and access material slots.
     void reserve_material_slots(const size_t count);
     size_t push_material_slot(const char* name);
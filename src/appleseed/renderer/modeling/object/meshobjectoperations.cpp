@@ -36,8 +36,14 @@
 
 // appleseed.foundation headers.
 #include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+
+// Boost headers.
+#include "boost/thread/thread.hpp"
 
 // Standard headers.
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <vector>
@@ -48,6 +54,296 @@ using namespace std;
 namespace renderer
 {
 
+namespace
+{
+    //
+    // The parallel versions of the operations below first compute the contribution of every
+    // triangle, then sum the contributions of the triangles incident to each vertex. Since
+    // triangles are visited in increasing order for each vertex, the sums are performed in
+    // the same order as in the serial versions and the results are bit-identical.
+    //
+
+    // Minimum number of triangles or vertices handled by each thread.
+    const size_t MinItemsPerThread = 16 * 1024;
+
+    // Pseudo motion segment index designating the base pose.
+    const size_t BasePose = ~size_t(0);
+
+    // Process a block of items on a separate thread.
+    template <typename Func>
+    class BlockFunc
+    {
+      public:
+        BlockFunc(
+            const Func&     func,
+            const size_t    begin,
+            const size_t    end)
+          : m_func(func)
+          , m_begin(begin)
+          , m_end(end)
+        {
+        }
+
+        void operator()()
+        {
+            m_func(m_begin, m_end);
+        }
+
+      private:
+        const Func&         m_func;
+        const size_t        m_begin;
+        const size_t        m_end;
+    };
+
+    // Split a range of items into contiguous blocks and process them on up to 'thread_count' threads.
+    template <typename Func>
+    void process_blocks(
+        const Func&         func,
+        const size_t        item_count,
+        const size_t        thread_count)
+    {
+        const size_t block_count = max<size_t>(min(thread_count, item_count / MinItemsPerThread), 1);
+
+        if (block_count == 1)
+        {
+            func(0, item_count);
+            return;
+        }
+
+        boost::thread_group threads;
+
+        for (size_t i = 1; i < block_count; ++i)
+        {
+            threads.create_thread(
+                BlockFunc<Func>(
+                    func,
+                    i * item_count / block_count,
+                    (i + 1) * item_count / block_count));
+        }
+
+        func(0, item_count / block_count);
+
+        threads.join_all();
+    }
+
+    // Triangles incident to each vertex, in increasing order.
+    struct VertexTriangles
+    {
+        vector<size_t>      m_offsets;      // index in m_triangles of the first triangle of each vertex, plus one past the end
+        vector<uint32>      m_triangles;    // incident triangles, grouped by vertex
+    };
+
+    void collect_vertex_triangles(
+        const MeshObject&   object,
+        VertexTriangles&    vertex_triangles)
+    {
+        const size_t vertex_count = object.get_vertex_count();
+        const size_t triangle_count = object.get_triangle_count();
+
+        vector<size_t>& offsets = vertex_triangles.m_offsets;
+        offsets.assign(vertex_count + 1, 0);
+
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            const Triangle& triangle = object.get_triangle(i);
+            ++offsets[triangle.m_v0 + 1];
+            ++offsets[triangle.m_v1 + 1];
+            ++offsets[triangle.m_v2 + 1];
+        }
+
+        for (size_t i = 0; i < vertex_count; ++i)
+            offsets[i + 1] += offsets[i];
+
+        vector<size_t> cursors(offsets.begin(), offsets.end() - 1);
+        vector<uint32>& triangles = vertex_triangles.m_triangles;
+        triangles.resize(3 * triangle_count);
+
+        for (size_t i = 0; i < triangle_count; ++i)
+        {
+            const Triangle& triangle = object.get_triangle(i);
+            triangles[cursors[triangle.m_v0]++] = static_cast<uint32>(i);
+            triangles[cursors[triangle.m_v1]++] = static_cast<uint32>(i);
+            triangles[cursors[triangle.m_v2]++] = static_cast<uint32>(i);
+        }
+    }
+
+    GVector3 get_vertex(
+        const MeshObject&   object,
+        const size_t        index,
+        const size_t        motion_segment_index)
+    {
+        return
+            motion_segment_index == BasePose
+                ? object.get_vertex(index)
+                : object.get_vertex_pose(index, motion_segment_index);
+    }
+
+    // Compute the unit normal of a range of triangles.
+    class ComputeTriangleNormals
+    {
+      public:
+        ComputeTriangleNormals(
+            const MeshObject&   object,
+            const size_t        motion_segment_index,
+            vector<GVector3>&   normals,
+            vector<uint8>&      valid)
+          : m_object(object)
+          , m_motion_segment_index(motion_segment_index)
+          , m_normals(normals)
+          , m_valid(valid)
+        {
+        }
+
+        void operator()(const size_t begin, const size_t end) const
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const Triangle& triangle = m_object.get_triangle(i);
+
+                const GVector3 v0 = get_vertex(m_object, triangle.m_v0, m_motion_segment_index);
+                const GVector3 v1 = get_vertex(m_object, triangle.m_v1, m_motion_segment_index);
+                const GVector3 v2 = get_vertex(m_object, triangle.m_v2, m_motion_segment_index);
+
+                m_normals[i] = normalize(cross(v1 - v0, v2 - v0));
+                m_valid[i] = 1;
+            }
+        }
+
+      private:
+        const MeshObject&       m_object;
+        const size_t            m_motion_segment_index;
+        vector<GVector3>&       m_normals;
+        vector<uint8>&          m_valid;
+    };
+
+    // Compute the unit tangent of a range of triangles. Triangles without texture coordinates
+    // or with degenerate texture coordinates are flagged as invalid.
+    class ComputeTriangleTangents
+    {
+      public:
+        ComputeTriangleTangents(
+            const MeshObject&   object,
+            const size_t        motion_segment_index,
+            vector<GVector3>&   tangents,
+            vector<uint8>&      valid)
+          : m_object(object)
+          , m_motion_segment_index(motion_segment_index)
+          , m_tangents(tangents)
+          , m_valid(valid)
+        {
+        }
+
+        void operator()(const size_t begin, const size_t end) const
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const Triangle& triangle = m_object.get_triangle(i);
+
+                m_valid[i] = 0;
+
+                if (!triangle.has_vertex_attributes())
+                    continue;
+
+                const GVector2 v0_uv = m_object.get_tex_coords(triangle.m_a0);
+                const GVector2 v1_uv = m_object.get_tex_coords(triangle.m_a1);
+                const GVector2 v2_uv = m_object.get_tex_coords(triangle.m_a2);
+
+                const GScalar du0 = v0_uv[0] - v2_uv[0];
+                const GScalar dv0 = v0_uv[1] - v2_uv[1];
+                const GScalar du1 = v1_uv[0] - v2_uv[0];
+                const GScalar dv1 = v1_uv[1] - v2_uv[1];
+                const GScalar det = du0 * dv1 - dv0 * du1;
+
+                if (det == GScalar(0.0))
+                    continue;
+
+                const GVector3 v2 = get_vertex(m_object, triangle.m_v2, m_motion_segment_index);
+                const GVector3 dp0 = get_vertex(m_object, triangle.m_v0, m_motion_segment_index) - v2;
+                const GVector3 dp1 = get_vertex(m_object, triangle.m_v1, m_motion_segment_index) - v2;
+
+                m_tangents[i] = normalize(dv1 * dp0 - dv0 * dp1);
+                m_valid[i] = 1;
+            }
+        }
+
+      private:
+        const MeshObject&       m_object;
+        const size_t            m_motion_segment_index;
+        vector<GVector3>&       m_tangents;
+        vector<uint8>&          m_valid;
+    };
+
+    // Sum and normalize the vectors of the valid triangles incident to a range of vertices.
+    class AccumulateVertexVectors
+    {
+      public:
+        AccumulateVertexVectors(
+            const VertexTriangles&      vertex_triangles,
+            const vector<GVector3>&     triangle_vectors,
+            const vector<uint8>&        valid,
+            vector<GVector3>&           vertex_vectors)
+          : m_vertex_triangles(vertex_triangles)
+          , m_triangle_vectors(triangle_vectors)
+          , m_valid(valid)
+          , m_vertex_vectors(vertex_vectors)
+        {
+        }
+
+        void operator()(const size_t begin, const size_t end) const
+        {
+            const size_t* APPLESEED_RESTRICT offsets = &m_vertex_triangles.m_offsets[0];
+            const uint32* APPLESEED_RESTRICT triangles = &m_vertex_triangles.m_triangles[0];
+
+            for (size_t i = begin; i < end; ++i)
+            {
+                GVector3 sum(0.0);
+
+                for (size_t j = offsets[i], e = offsets[i + 1]; j < e; ++j)
+                {
+                    const uint32 triangle_index = triangles[j];
+                    if (m_valid[triangle_index])
+                        sum += m_triangle_vectors[triangle_index];
+                }
+
+                m_vertex_vectors[i] = safe_normalize(sum);
+            }
+        }
+
+      private:
+        const VertexTriangles&          m_vertex_triangles;
+        const vector<GVector3>&         m_triangle_vectors;
+        const vector<uint8>&            m_valid;
+        vector<GVector3>&               m_vertex_vectors;
+    };
+
+    // Compute smooth vertex vectors of a given pose in parallel.
+    template <typename ComputeTriangleVectors>
+    void compute_vertex_vectors(
+        const MeshObject&           object,
+        const VertexTriangles&      vertex_triangles,
+        const size_t                motion_segment_index,
+        const size_t                thread_count,
+        vector<GVector3>&           triangle_vectors,
+        vector<uint8>&              valid,
+        vector<GVector3>&           vertex_vectors)
+    {
+        process_blocks(
+            ComputeTriangleVectors(object, motion_segment_index, triangle_vectors, valid),
+            object.get_triangle_count(),
+            thread_count);
+
+        process_blocks(
+            AccumulateVertexVectors(vertex_triangles, triangle_vectors, valid, vertex_vectors),
+            object.get_vertex_count(),
+            thread_count);
+    }
+
+    bool use_serial_version(const MeshObject& object, const size_t thread_count)
+    {
+        return thread_count <= 1 || object.get_triangle_count() < 2 * MinItemsPerThread;
+    }
+}
+
 void compute_smooth_vertex_normals_base_pose(MeshObject& object)
 {
     assert(object.get_vertex_normal_count() == 0);
@@ -105,12 +401,56 @@ void compute_smooth_vertex_normals_pose(MeshObject& object, const size_t motion_
         object.set_vertex_normal_pose(i, motion_segment_index, safe_normalize(normals[i]));
 }
 
-void compute_smooth_vertex_normals(MeshObject& object)
+void compute_smooth_vertex_normals(
+    MeshObject&     object,
+    const size_t    thread_count)
 {
-    compute_smooth_vertex_normals_base_pose(object);
+    if (use_serial_version(object, thread_count))
+    {
+        compute_smooth_vertex_normals_base_pose(object);
+
+        for (size_t i = 0; i < object.get_motion_segment_count(); ++i)
+            compute_smooth_vertex_normals_pose(object, i);
+
+        return;
+    }
+
+    assert(object.get_vertex_normal_count() == 0);
+
+    const size_t vertex_count = object.get_vertex_count();
+    const size_t triangle_count = object.get_triangle_count();
 
-    for (size_t i = 0; i < object.get_motion_segment_count(); ++i)
-        compute_smooth_vertex_normals_pose(object, i);
+    for (size_t i = 0; i < triangle_count; ++i)
+    {
+        Triangle& triangle = object.get_triangle(i);
+        triangle.m_n0 = triangle.m_v0;
+        triangle.m_n1 = triangle.m_v1;
+        triangle.m_n2 = triangle.m_v2;
+    }
+
+    VertexTriangles vertex_triangles;
+    collect_vertex_triangles(object, vertex_triangles);
+
+    vector<GVector3> triangle_normals(triangle_count);
+    vector<uint8> valid(triangle_count);
+    vector<GVector3> normals(vertex_count);
+
+    compute_vertex_vectors<ComputeTriangleNormals>(
+        object, vertex_triangles, BasePose, thread_count, triangle_normals, valid, normals);
+
+    object.reserve_vertex_normals(vertex_count);
+
+    for (size_t i = 0; i < vertex_count; ++i)
+        object.push_vertex_normal(normals[i]);
+
+    for (size_t m = 0; m < object.get_motion_segment_count(); ++m)
+    {
+        compute_vertex_vectors<ComputeTriangleNormals>(
+            object, vertex_triangles, m, thread_count, triangle_normals, valid, normals);
+
+        for (size_t i = 0; i < vertex_count; ++i)
+            object.set_vertex_normal_pose(i, m, normals[i]);
+    }
 }
 
 void compute_smooth_vertex_tangents_base_pose(MeshObject& object)
@@ -214,12 +554,49 @@ void compute_smooth_vertex_tangents_pose(MeshObject& object, const size_t motion
         object.set_vertex_tangent_pose(i, motion_segment_index, safe_normalize(tangents[i]));
 }
 
-void compute_smooth_vertex_tangents(MeshObject& object)
+void compute_smooth_vertex_tangents(
+    MeshObject&     object,
+    const size_t    thread_count)
 {
-    compute_smooth_vertex_tangents_base_pose(object);
+    if (use_serial_version(object, thread_count))
+    {
+        compute_smooth_vertex_tangents_base_pose(object);
 
-    for (size_t i = 0; i < object.get_motion_segment_count(); ++i)
-        compute_smooth_vertex_tangents_pose(object, i);
+        for (size_t i = 0; i < object.get_motion_segment_count(); ++i)
+            compute_smooth_vertex_tangents_pose(object, i);
+
+        return;
+    }
+
+    assert(object.get_vertex_tangent_count() == 0);
+    assert(object.get_tex_coords_count() > 0);
+
+    const size_t vertex_count = object.get_vertex_count();
+    const size_t triangle_count = object.get_triangle_count();
+
+    VertexTriangles vertex_triangles;
+    collect_vertex_triangles(object, vertex_triangles);
+
+    vector<GVector3> triangle_tangents(triangle_count);
+    vector<uint8> valid(triangle_count);
+    vector<GVector3> tangents(vertex_count);
+
+    compute_vertex_vectors<ComputeTriangleTangents>(
+        object, vertex_triangles, BasePose, thread_count, triangle_tangents, valid, tangents);
+
+    object.reserve_vertex_tangents(vertex_count);
+
+    for (size_t i = 0; i < vertex_count; ++i)
+        object.push_vertex_tangent(tangents[i]);
+
+    for (size_t m = 0; m < object.get_motion_segment_count(); ++m)
+    {
+        compute_vertex_vectors<ComputeTriangleTangents>(
+            object, vertex_triangles, m, thread_count, triangle_tangents, valid, tangents);
+
+        for (size_t i = 0; i < vertex_count; ++i)
+            object.set_vertex_tangent_pose(i, m, tangents[i]);
+    }
 }
 
 }   // namespace renderer
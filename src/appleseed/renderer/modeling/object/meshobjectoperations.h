@@ -32,20 +32,29 @@
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <cstddef>
+
 // Forward declarations.
 namespace renderer  { class MeshObject; }
 
 namespace renderer
 {
 
-// Compute smooth vertex normal vectors for a mesh object.
+// Compute smooth vertex normal vectors for a mesh object, using a given number of threads.
 // The mesh object must not already have normals.
-APPLESEED_DLLSYMBOL void compute_smooth_vertex_normals(MeshObject& object);
+// The results do not depend on the number of threads.
+APPLESEED_DLLSYMBOL void compute_smooth_vertex_normals(
+    MeshObject&     object,
+    const size_t    thread_count = 1);
 
-// Compute smooth vertex tangent vectors for a mesh object.
+// Compute smooth vertex tangent vectors for a mesh object, using a given number of threads.
 // The mesh object must not already have tangent vectors.
 // The mesh object must have texture coordinates.
-APPLESEED_DLLSYMBOL void compute_smooth_vertex_tangents(MeshObject& object);
+// The results do not depend on the number of threads.
+APPLESEED_DLLSYMBOL void compute_smooth_vertex_tangents(
+    MeshObject&     object,
+    const size_t    thread_count = 1);
 
 }       // namespace renderer
 
@@ -50,6 +50,7 @@
 #include "foundation/mesh/objmeshfilereader.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/autoreleaseptr.h"
@@ -60,6 +61,9 @@
 #include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
 
+// Boost headers.
+#include "boost/static_assert.hpp"
+
 // Standard headers.
 #include <algorithm>
 #include <cassert>
@@ -203,6 +207,41 @@ namespace
             return m_objects.back()->push_material_slot(name);
         }
 
+        virtual bool push_triangle_arrays(const TriangleMeshArrays& arrays) APPLESEED_OVERRIDE
+        {
+            // The arrays must be dropped or rewritten to ignore vertex normals.
+            if (m_ignore_vertex_normals)
+                return false;
+
+            // The arrays have the memory layout of the mesh object's own arrays.
+            BOOST_STATIC_ASSERT(sizeof(GVector3) == 3 * sizeof(float));
+            BOOST_STATIC_ASSERT(sizeof(GVector2) == 2 * sizeof(float));
+            BOOST_STATIC_ASSERT(sizeof(Triangle) == 10 * sizeof(uint32));
+
+            MeshObject& object = *m_objects.back();
+
+            object.push_vertices(
+                reinterpret_cast<const GVector3*>(arrays.m_vertices),
+                arrays.m_vertex_count);
+
+            object.push_vertex_normals(
+                reinterpret_cast<const GVector3*>(arrays.m_vertex_normals),
+                arrays.m_vertex_normal_count);
+
+            object.reserve_tex_coords(arrays.m_tex_coords_count);
+            for (size_t i = 0; i < arrays.m_tex_coords_count; ++i)
+                object.push_tex_coords(reinterpret_cast<const GVector2*>(arrays.m_tex_coords)[i]);
+
+            object.push_triangles(
+                reinterpret_cast<const Triangle*>(arrays.m_triangles),
+                arrays.m_triangle_count);
+
+            m_normal_count += arrays.m_vertex_normal_count;
+            m_face_count += arrays.m_triangle_count;
+
+            return true;
+        }
+
         virtual void begin_face(const size_t vertex_count) APPLESEED_OVERRIDE
         {
             assert(vertex_count >= 3);
@@ -432,6 +471,12 @@ namespace
                 reader.get_obj_options() | OBJMeshFileReader::FavorSpeedOverPrecision);
         }
 
+        if (params.get_optional<bool>("obj_parallel_parsing", true))
+        {
+            reader.set_obj_options(
+                reader.get_obj_options() | OBJMeshFileReader::ParallelParsing);
+        }
+
         MeshObjectBuilder builder(params, base_object_name);
 
         Stopwatch<DefaultWallclockTimer> stopwatch;
@@ -792,7 +837,7 @@ namespace
 
         RENDERER_LOG_INFO("computing smooth normal vectors for mesh object \"%s\"...", object.get_path().c_str());
 
-        compute_smooth_vertex_normals(object);
+        compute_smooth_vertex_normals(object, System::get_logical_cpu_core_count());
     }
 
     void compute_smooth_tangents(MeshObject& object)
@@ -815,7 +860,7 @@ namespace
 
         RENDERER_LOG_INFO("computing smooth tangent vectors for mesh object \"%s\"...", object.get_path().c_str());
 
-        compute_smooth_vertex_tangents(object);
+        compute_smooth_vertex_tangents(object, System::get_logical_cpu_core_count());
     }
 }
 
@@ -946,6 +991,17 @@ bool MeshObjectReader::read(
         }
     }
 
+    // Store vertex attributes in compact form.
+    if (params.get_optional<bool>("compact_vertex_attributes", false))
+    {
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            MeshObject& object = *objects[i];
+            RENDERER_LOG_INFO("compacting vertex attributes of mesh object \"%s\"...", object.get_path().c_str());
+            object.compact_vertex_attributes();
+        }
+    }
+
     return true;
 }
 
@@ -0,0 +1,206 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "particleobject.h"
+
+// appleseed.renderer headers.
+#include "renderer/utility/messagecontext.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/makevector.h"
+
+// Standard headers.
+#include <cassert>
+#include <string>
+#include <vector>
+
+using namespace foundation;
+using namespace std;
+
+namespace renderer
+{
+
+//
+// ParticleObject class implementation.
+//
+
+struct ParticleObject::Impl
+{
+    RegionKit           m_region_kit;
+    Lazy<RegionKit>     m_lazy_region_kit;
+    Shape               m_shape;
+    vector<Vector3f>    m_centers;
+    vector<float>       m_radii;
+
+    Impl()
+      : m_lazy_region_kit(&m_region_kit)
+    {
+    }
+
+    GAABB3 compute_bounds() const
+    {
+        GAABB3 bbox;
+        bbox.invalidate();
+
+        const size_t particle_count = m_centers.size();
+
+        for (size_t i = 0; i < particle_count; ++i)
+        {
+            const GVector3 center(m_centers[i]);
+            const GVector3 extent(static_cast<GScalar>(m_radii[i]));
+            bbox.insert(center - extent);
+            bbox.insert(center + extent);
+        }
+
+        return bbox;
+    }
+};
+
+ParticleObject::ParticleObject(
+    const char*         name,
+    const ParamArray&   params)
+  : Object(name, params)
+  , impl(new Impl())
+{
+    const EntityDefMessageContext message_context("particle object", this);
+
+    const string shape =
+        m_params.get_optional<string>("shape", "sphere", make_vector("sphere", "disk"), message_context);
+
+    impl->m_shape = shape == "disk" ? ShapeDisk : ShapeSphere;
+}
+
+ParticleObject::~ParticleObject()
+{
+    delete impl;
+}
+
+void ParticleObject::release()
+{
+    delete this;
+}
+
+const char* ParticleObject::get_model() const
+{
+    return ParticleObjectFactory::get_model();
+}
+
+GAABB3 ParticleObject::compute_local_bbox() const
+{
+    return impl->compute_bounds();
+}
+
+Lazy<RegionKit>& ParticleObject::get_region_kit()
+{
+    return impl->m_lazy_region_kit;
+}
+
+ParticleObject::Shape ParticleObject::get_shape() const
+{
+    return impl->m_shape;
+}
+
+void ParticleObject::reserve_particles(const size_t count)
+{
+    impl->m_centers.reserve(count);
+    impl->m_radii.reserve(count);
+}
+
+size_t ParticleObject::push_particle(const Vector3f& center, const float radius)
+{
+    assert(radius >= 0.0f);
+
+    const size_t index = impl->m_centers.size();
+    impl->m_centers.push_back(center);
+    impl->m_radii.push_back(radius);
+    return index;
+}
+
+size_t ParticleObject::get_particle_count() const
+{
+    return impl->m_centers.size();
+}
+
+const Vector3f& ParticleObject::get_particle_center(const size_t index) const
+{
+    assert(index < impl->m_centers.size());
+    return impl->m_centers[index];
+}
+
+float ParticleObject::get_particle_radius(const size_t index) const
+{
+    assert(index < impl->m_radii.size());
+    return impl->m_radii[index];
+}
+
+size_t ParticleObject::get_material_slot_count() const
+{
+    return 0;
+}
+
+const char* ParticleObject::get_material_slot(const size_t index) const
+{
+    return 0;
+}
+
+void ParticleObject::collect_asset_paths(StringArray& paths) const
+{
+    if (m_params.strings().exist("filepath"))
+        paths.push_back(m_params.get("filepath"));
+}
+
+void ParticleObject::update_asset_paths(const StringDictionary& mappings)
+{
+    if (m_params.strings().exist("filepath"))
+        m_params.set("filepath", mappings.get(m_params.get("filepath")));
+}
+
+
+//
+// ParticleObjectFactory class implementation.
+//
+
+const char* ParticleObjectFactory::get_model()
+{
+    return "particle_object";
+}
+
+auto_release_ptr<ParticleObject> ParticleObjectFactory::create(
+    const char*         name,
+    const ParamArray&   params)
+{
+    return auto_release_ptr<ParticleObject>(new ParticleObject(name, params));
+}
+
+}   // namespace renderer
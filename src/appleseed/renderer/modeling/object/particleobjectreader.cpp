@@ -0,0 +1,214 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Interface header.
+#include "particleobjectreader.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/core/exceptions/exceptionunsupportedfileformat.h"
+#include "foundation/math/vector.h"
+#include "foundation/platform/defaulttimers.h"
+#include "foundation/utility/searchpaths.h"
+#include "foundation/utility/stopwatch.h"
+#include "foundation/utility/string.h"
+
+// Partio headers.
+#ifdef APPLESEED_WITH_PARTIO
+#include <Partio.h>
+#endif
+
+// Boost headers.
+#include "boost/filesystem/path.hpp"
+
+// Standard headers.
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+using namespace foundation;
+using namespace std;
+namespace bf = boost::filesystem;
+
+namespace renderer
+{
+
+//
+// ParticleObjectReader class implementation.
+//
+
+auto_release_ptr<ParticleObject> ParticleObjectReader::read(
+    const SearchPaths&      search_paths,
+    const char*             name,
+    const ParamArray&       params)
+{
+    const string filepath = params.get<string>("filepath");
+    const string extension = lower_case(bf::path(filepath).extension().string());
+
+    if (extension == ".particles")
+        return load_text_particle_file(search_paths, name, params);
+
+#ifdef APPLESEED_WITH_PARTIO
+    return load_partio_file(search_paths, name, params);
+#else
+    throw ExceptionUnsupportedFileFormat(filepath.c_str());
+#endif
+}
+
+namespace
+{
+    void print_loading_statistics(
+        const string&       filepath,
+        const size_t        particle_count,
+        const double        seconds)
+    {
+        RENDERER_LOG_INFO(
+            "loaded particle file %s (%s %s) in %s.",
+            filepath.c_str(),
+            pretty_uint(particle_count).c_str(),
+            plural(particle_count, "particle").c_str(),
+            pretty_time(seconds).c_str());
+    }
+}
+
+auto_release_ptr<ParticleObject> ParticleObjectReader::load_text_particle_file(
+    const SearchPaths&      search_paths,
+    const char*             name,
+    const ParamArray&       params)
+{
+    auto_release_ptr<ParticleObject> object = ParticleObjectFactory::create(name, params);
+
+    const string filepath = search_paths.qualify(params.get<string>("filepath"));
+
+    ifstream input;
+    input.open(filepath.c_str());
+
+    if (!input.is_open())
+    {
+        RENDERER_LOG_ERROR("failed to open particle file %s.", filepath.c_str());
+        return object;
+    }
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    size_t particle_count;
+    input >> particle_count;
+
+    object->reserve_particles(particle_count);
+
+    for (size_t i = 0; i < particle_count; ++i)
+    {
+        Vector3f center;
+        float radius;
+        input >> center.x >> center.y >> center.z >> radius;
+        object->push_particle(center, radius);
+    }
+
+    input.close();
+
+    if (input.bad())
+    {
+        RENDERER_LOG_ERROR("failed to load particle file %s: i/o error.", filepath.c_str());
+        return object;
+    }
+
+    print_loading_statistics(filepath, particle_count, stopwatch.measure().get_seconds());
+
+    return object;
+}
+
+#ifdef APPLESEED_WITH_PARTIO
+
+auto_release_ptr<ParticleObject> ParticleObjectReader::load_partio_file(
+    const SearchPaths&      search_paths,
+    const char*             name,
+    const ParamArray&       params)
+{
+    auto_release_ptr<ParticleObject> object = ParticleObjectFactory::create(name, params);
+
+    const string filepath = search_paths.qualify(params.get<string>("filepath"));
+    const string radius_attribute_name = params.get_optional<string>("radius_attribute", "radius");
+    const float default_radius = params.get_optional<float>("radius", 0.01f);
+
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    Partio::ParticlesDataMutable* particles = Partio::read(filepath.c_str());
+
+    if (particles == 0)
+    {
+        RENDERER_LOG_ERROR("failed to load particle file %s.", filepath.c_str());
+        return object;
+    }
+
+    Partio::ParticleAttribute position_attribute;
+    if (!particles->attributeInfo("position", position_attribute) ||
+        (position_attribute.type != Partio::VECTOR && position_attribute.type != Partio::FLOAT) ||
+        position_attribute.count != 3)
+    {
+        RENDERER_LOG_ERROR("failed to load particle file %s: particles have no position.", filepath.c_str());
+        particles->release();
+        return object;
+    }
+
+    Partio::ParticleAttribute radius_attribute;
+    const bool has_radius =
+        particles->attributeInfo(radius_attribute_name.c_str(), radius_attribute) &&
+        radius_attribute.type == Partio::FLOAT &&
+        radius_attribute.count == 1;
+
+    const size_t particle_count = static_cast<size_t>(particles->numParticles());
+    object->reserve_particles(particle_count);
+
+    for (size_t i = 0; i < particle_count; ++i)
+    {
+        const int index = static_cast<int>(i);
+        const float* position = particles->data<float>(position_attribute, index);
+        const float radius =
+            has_radius
+                ? *particles->data<float>(radius_attribute, index)
+                : default_radius;
+
+        object->push_particle(Vector3f(position[0], position[1], position[2]), radius);
+    }
+
+    particles->release();
+
+    print_loading_statistics(filepath, particle_count, stopwatch.measure().get_seconds());
+
+    return object;
+}
+
+#endif
+
+}   // namespace renderer
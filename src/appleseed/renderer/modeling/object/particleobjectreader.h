@@ -0,0 +1,85 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+#ifndef APPLESEED_RENDERER_MODELING_OBJECT_PARTICLEOBJECTREADER_H
+#define APPLESEED_RENDERER_MODELING_OBJECT_PARTICLEOBJECTREADER_H
+
+// appleseed.renderer headers.
+#include "renderer/modeling/object/particleobject.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/autoreleaseptr.h"
+
+// appleseed.main headers.
+#include "main/dllsymbol.h"
+
+// Forward declarations.
+namespace foundation    { class SearchPaths; }
+namespace renderer      { class ParamArray; }
+
+namespace renderer
+{
+
+//
+// Particle object reader.
+//
+// Text files (.particles) hold the particle count followed by one "x y z radius"
+// line per particle. When appleseed is built with Partio support, all the file
+// formats of Partio (.bgeo, .geo, .pdb, .ptc, .bin, etc.) can be read as well:
+// particle positions are read from the "position" attribute, and radii from the
+// attribute named by the "radius_attribute" parameter (by default "radius").
+// Particles without a radius attribute use the "radius" parameter.
+//
+
+class APPLESEED_DLLSYMBOL ParticleObjectReader
+{
+  public:
+    // Read a particle object from disk. The filepath is defined in params.
+    static foundation::auto_release_ptr<ParticleObject> read(
+        const foundation::SearchPaths&  search_paths,
+        const char*                     name,
+        const ParamArray&               params);
+
+  private:
+    static foundation::auto_release_ptr<ParticleObject> load_text_particle_file(
+        const foundation::SearchPaths&  search_paths,
+        const char*                     name,
+        const ParamArray&               params);
+
+#ifdef APPLESEED_WITH_PARTIO
+    static foundation::auto_release_ptr<ParticleObject> load_partio_file(
+        const foundation::SearchPaths&  search_paths,
+        const char*                     name,
+        const ParamArray&               params);
+#endif
+};
+
+}       // namespace renderer
+
+#endif  // !APPLESEED_RENDERER_MODELING_OBJECT_PARTICLEOBJECTREADER_H
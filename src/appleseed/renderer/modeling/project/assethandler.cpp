@@ -38,18 +38,27 @@
 #include "renderer/modeling/scene/scene.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/platform/defaulttimers.h"
 #include "foundation/platform/path.h"
+#include "foundation/platform/system.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/foreach.h"
+#include "foundation/utility/job/abortswitch.h"
 #include "foundation/utility/otherwise.h"
 #include "foundation/utility/searchpaths.h"
+#include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
 
 // Boost headers.
+#include "boost/bind.hpp"
 #include "boost/filesystem/operations.hpp"
+#include "boost/thread/thread.hpp"
 
 // Standard headers.
 #include <cstddef>
+#include <cstdio>
+#include <memory>
 #include <vector>
 
 using namespace boost;
@@ -128,18 +137,62 @@ namespace
                 search_paths.remove(i);
         }
     }
+
+    // Read files on a background thread, in order, so that they are already in the
+    // file system cache when they are needed. Reading is abandoned on destruction.
+    class FilePrefetcher
+      : public NonCopyable
+    {
+      public:
+        explicit FilePrefetcher(const vector<string>& filepaths)
+          : m_filepaths(filepaths)
+          , m_thread(boost::bind(&FilePrefetcher::run, this))
+        {
+        }
+
+        ~FilePrefetcher()
+        {
+            m_abort_switch.abort();
+            m_thread.join();
+        }
+
+      private:
+        const vector<string>    m_filepaths;
+        AbortSwitch             m_abort_switch;
+        boost::thread           m_thread;
+
+        void run()
+        {
+            vector<char> buffer(1024 * 1024);
+
+            for (size_t i = 0, e = m_filepaths.size(); i < e && !m_abort_switch.is_aborted(); ++i)
+            {
+                FILE* file = fopen(m_filepaths[i].c_str(), "rb");
+
+                if (file == 0)
+                    continue;
+
+                while (!m_abort_switch.is_aborted() &&
+                       fread(&buffer[0], 1, buffer.size(), file) == buffer.size()) ;
+
+                fclose(file);
+            }
+        }
+    };
 }
 
 AssetHandler::AssetHandler(
     const Project&      project,
     const char*         filepath,
-    const Mode          mode)
+    const Mode          mode,
+    const bool          prefetch)
   : m_project(project)
   , m_project_old_root_path(absolute(project.get_path()))
   , m_project_new_root_path(absolute(filepath))
   , m_project_old_root_dir(canonical(m_project_old_root_path.parent_path()))
   , m_project_new_root_dir(canonical(m_project_new_root_path.parent_path()))
   , m_mode(mode)
+  , m_prefetch(prefetch)
 {
 }
 
@@ -164,6 +217,32 @@ bool AssetHandler::handle_assets() const
         unique(unique_paths.begin(), unique_paths.end()),
         unique_paths.end());
 
+    // Resolve all asset paths at once: checking the existence of asset files one
+    // by one is very slow on network file systems.
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+    StringArray unique_path_array;
+    for (size_t i = 0, e = unique_paths.size(); i < e; ++i)
+        unique_path_array.push_back(unique_paths[i].c_str());
+    StringArray qualified_paths;
+    StringArray search_paths;
+    m_project.search_paths().qualify(
+        unique_path_array,
+        qualified_paths,
+        search_paths,
+        System::get_logical_cpu_core_count());
+    stopwatch.measure();
+    RENDERER_LOG_DEBUG(
+        "resolved %s in %s.",
+        plural(unique_paths.size(), "asset path").c_str(),
+        pretty_time(stopwatch.get_seconds()).c_str());
+
+    // Asset files are only read if they need to be copied.
+    auto_ptr<FilePrefetcher> prefetcher;
+    if (m_prefetch &&
+        (m_mode == CopyAllAssets || m_project_old_root_dir != m_project_new_root_dir))
+        prefetcher.reset(new FilePrefetcher(array_vector<vector<string> >(qualified_paths)));
+
     StringDictionary mappings;
     bool success = true;
 
@@ -171,12 +250,14 @@ bool AssetHandler::handle_assets() const
     {
         string asset_path = unique_paths[i];
 
-        if (!handle_asset(asset_path))
+        if (!handle_asset(asset_path, qualified_paths[i], search_paths[i]))
             success = false;
 
         mappings.insert(unique_paths[i], asset_path);
     }
 
+    prefetcher.reset();
+
     if (!success)
         return false;
 
@@ -196,20 +277,16 @@ bool AssetHandler::handle_assets() const
     return true;
 }
 
-bool AssetHandler::handle_asset(string& asset_path) const
+bool AssetHandler::handle_asset(
+    string&             asset_path,
+    const string&       qualified_asset_path,
+    const string&       search_path) const
 {
     // Let's first get rid of the case where the asset path is absolute.
     if (path(asset_path).is_absolute())
-        return handle_absolute_asset(asset_path);
+        return handle_absolute_asset(asset_path, qualified_asset_path);
 
     // Otherwise, let's check if the asset is found in a search path.
-    string qualified_asset_path;
-    string search_path;
-    m_project.search_paths().qualify(
-        asset_path,
-        qualified_asset_path,
-        search_path);
-
     if (search_path.empty() || path(search_path).is_relative())
     {
         // Relative asset path, found in a relative search path or in the root directory.
@@ -217,12 +294,12 @@ bool AssetHandler::handle_asset(string& asset_path) const
             is_extension_of(qualified_asset_path, m_project.search_paths().get_root_path()))
         {
             // Relative asset/search path, below the project's root path.
-            return copy_relative_asset(asset_path);
+            return copy_relative_asset(asset_path, qualified_asset_path);
         }
         else
         {
             // Relative asset/search path, above the project's root path -> consider it absolute.
-            return handle_absolute_asset(asset_path);
+            return handle_absolute_asset(asset_path, qualified_asset_path);
         }
     }
     else
@@ -236,33 +313,35 @@ bool AssetHandler::handle_asset(string& asset_path) const
             return true;
     
           case CopyAllAssets:
-            return copy_absolute_asset(asset_path);
+            return copy_absolute_asset(asset_path, qualified_asset_path);
     
           assert_otherwise_and_return(false);
         }
     }
 }
 
-bool AssetHandler::handle_absolute_asset(string& asset_path) const
+bool AssetHandler::handle_absolute_asset(
+    string&             asset_path,
+    const string&       qualified_asset_path) const
 {
     switch (m_mode)
     {
       case CopyRelativeAssetsOnly:
-        return make_absolute_asset_path(asset_path);
+        return make_absolute_asset_path(asset_path, qualified_asset_path);
 
       case CopyAllAssets:
-        return copy_absolute_asset(asset_path);
+        return copy_absolute_asset(asset_path, qualified_asset_path);
 
       assert_otherwise_and_return(false);
     }
 }
 
-bool AssetHandler::make_absolute_asset_path(string& asset_path) const
+bool AssetHandler::make_absolute_asset_path(
+    string&             asset_path,
+    const string&       qualified_asset_path) const
 {
     // Make sure the asset path is qualified and canonized.
-    path absolute_asset_path =
-        canonical(
-            m_project.search_paths().qualify(asset_path));
+    path absolute_asset_path = canonical(qualified_asset_path);
 
     // Make sure absolute paths use native separators.
     absolute_asset_path.make_preferred();
@@ -271,7 +350,9 @@ bool AssetHandler::make_absolute_asset_path(string& asset_path) const
     return true;
 }
 
-bool AssetHandler::copy_absolute_asset(string& asset_path) const
+bool AssetHandler::copy_absolute_asset(
+    string&             asset_path,
+    const string&       qualified_asset_path) const
 {
     const path old_absolute_asset_path(asset_path);
     const path asset_filename = old_absolute_asset_path.filename();
@@ -280,7 +361,7 @@ bool AssetHandler::copy_absolute_asset(string& asset_path) const
 
     // Copy the asset file.
     if (!safe_copy_file(
-            m_project.search_paths().qualify(asset_path),
+            qualified_asset_path,
             new_absolute_asset_path))
         return false;
 
@@ -293,14 +374,16 @@ bool AssetHandler::copy_absolute_asset(string& asset_path) const
     return true;
 }
 
-bool AssetHandler::copy_relative_asset(string& asset_path) const
+bool AssetHandler::copy_relative_asset(
+    string&             asset_path,
+    const string&       qualified_asset_path) const
 {
     // Copy the asset file only if the destination differs from the source.
     if (m_project_old_root_dir != m_project_new_root_dir)
     {
         // Copy the asset file.
         if (!safe_copy_file(
-                m_project.search_paths().qualify(asset_path),
+                qualified_asset_path,
                 m_project_new_root_dir / asset_path))
             return false;
     }
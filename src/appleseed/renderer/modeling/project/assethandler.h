@@ -50,11 +50,13 @@ class AssetHandler
         CopyAllAssets               // bring all asset files
     };
 
-    // Constructor.
+    // Constructor. If 'prefetch' is true, asset files that need to be copied are read
+    // ahead in the background to warm the file system cache before they are copied.
     AssetHandler(
         const Project&              project,
         const char*                 filepath,
-        const Mode                  mode);
+        const Mode                  mode,
+        const bool                  prefetch = false);
 
     bool handle_assets() const;
 
@@ -65,12 +67,26 @@ class AssetHandler
     const boost::filesystem::path   m_project_old_root_dir;
     const boost::filesystem::path   m_project_new_root_dir;
     const Mode                      m_mode;
+    const bool                      m_prefetch;
 
-    bool handle_asset(std::string& asset_path) const;
-    bool handle_absolute_asset(std::string& asset_path) const;
-    bool make_absolute_asset_path(std::string& asset_path) const;
-    bool copy_absolute_asset(std::string& asset_path) const;
-    bool copy_relative_asset(std::string& asset_path) const;
+    // 'qualified_asset_path' and 'search_path' are the results of qualifying 'asset_path'
+    // against the search paths of the project.
+    bool handle_asset(
+        std::string&                asset_path,
+        const std::string&          qualified_asset_path,
+        const std::string&          search_path) const;
+    bool handle_absolute_asset(
+        std::string&                asset_path,
+        const std::string&          qualified_asset_path) const;
+    bool make_absolute_asset_path(
+        std::string&                asset_path,
+        const std::string&          qualified_asset_path) const;
+    bool copy_absolute_asset(
+        std::string&                asset_path,
+        const std::string&          qualified_asset_path) const;
+    bool copy_relative_asset(
+        std::string&                asset_path,
+        const std::string&          qualified_asset_path) const;
 };
 
 }       // namespace renderer
@@ -35,8 +35,11 @@
 #include "renderer/kernel/lighting/pt/ptlightingengine.h"
 #include "renderer/kernel/lighting/sppm/sppmlightingengine.h"
 #include "renderer/kernel/rendering/final/adaptivepixelrenderer.h"
+#include "renderer/kernel/rendering/final/multipassadaptivepixelrenderer.h"
 #include "renderer/kernel/rendering/final/uniformpixelrenderer.h"
 #include "renderer/kernel/rendering/generic/genericframerenderer.h"
+#include "renderer/kernel/rendering/generic/genericsamplegenerator.h"
+#include "renderer/kernel/rendering/generic/genericsamplerenderer.h"
 #include "renderer/kernel/rendering/progressive/progressiveframerenderer.h"
 #include "renderer/kernel/texturing/texturestore.h"
 #include "renderer/utility/paramarray.h"
@@ -112,7 +115,7 @@ Dictionary Configuration::get_metadata()
         "sampling_mode",
         Dictionary()
             .insert("type", "enum")
-            .insert("values", "rng|qmc")
+            .insert("values", "rng|qmc|sobol")
             .insert("default", "rng")
             .insert("label", "Sampler")
             .insert("help", "Sampler to use when generating samples")
@@ -128,7 +131,20 @@ Dictionary Configuration::get_metadata()
                         "qmc",
                         Dictionary()
                             .insert("label", "QMC")
-                            .insert("help", "Quasi Monte Carlo sampler"))));
+                            .insert("help", "Quasi Monte Carlo sampler"))
+                    .insert(
+                        "sobol",
+                        Dictionary()
+                            .insert("label", "Sobol")
+                            .insert("help", "Owen-scrambled Sobol sampler"))));
+
+    metadata.insert(
+        "blue_noise",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Blue Noise")
+            .insert("help", "Decorrelate the samples of neighboring pixels with a blue noise mask, for less visible noise at low sample counts"));
 
     metadata.insert(
         "lighting_engine",
@@ -157,6 +173,14 @@ Dictionary Configuration::get_metadata()
                             .insert("label", "Progressive Photon Mapping")
                             .insert("help", "Stochastic progressive photon mapping"))));
 
+    metadata.insert(
+        "intersection_backend",
+        Dictionary()
+            .insert("type", "text")
+            .insert("default", "builtin")
+            .insert("label", "Intersection Backend")
+            .insert("help", "Intersection backend used to trace rays"));
+
     metadata.insert(
         "rendering_threads",
         Dictionary()
@@ -164,6 +188,46 @@ Dictionary Configuration::get_metadata()
             .insert("label", "Render Threads")
             .insert("help", "Number of threads to use for rendering"));
 
+    metadata.insert(
+        "pin_rendering_threads",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Pin Render Threads")
+            .insert("help", "Pin each render thread to a CPU core, filling one NUMA node after the other"));
+
+    metadata.insert(
+        "work_stealing",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Work Stealing")
+            .insert("help", "Give each render thread its own job list and let idle threads steal jobs from the others"));
+
+    metadata.insert(
+        "async_tile_callbacks",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Asynchronous Tile Callbacks")
+            .insert("help", "Deliver tile callbacks on a dedicated thread so that slow callbacks don't stall rendering"));
+
+    metadata.insert(
+        "coalesce_tile_callbacks",
+        Dictionary()
+            .insert("type", "bool")
+            .insert("default", "false")
+            .insert("label", "Coalesce Tile Callbacks")
+            .insert("help", "With asynchronous tile callbacks, skip reports of tiles that were rendered again before the report was delivered"));
+
+    metadata.insert(
+        "memory_limit",
+        Dictionary()
+            .insert("type", "int")
+            .insert("default", "0")
+            .insert("label", "Memory Limit")
+            .insert("help", "Memory in bytes the render should fit in, trading speed and quality for memory when needed; 0 for no limit"));
+
     metadata.dictionaries().insert(
         "texture_store",
         TextureStore::get_params_metadata());
@@ -176,6 +240,10 @@ Dictionary Configuration::get_metadata()
         "adaptive_pixel_renderer",
         AdaptivePixelRendererFactory::get_params_metadata());
 
+    metadata.dictionaries().insert(
+        "multipass_adaptive_pixel_renderer",
+        MultipassAdaptivePixelRendererFactory::get_params_metadata());
+
     metadata.dictionaries().insert(
         "generic_frame_renderer",
         GenericFrameRendererFactory::get_params_metadata());
@@ -184,6 +252,14 @@ Dictionary Configuration::get_metadata()
         "progressive_frame_renderer",
         ProgressiveFrameRendererFactory::get_params_metadata());
 
+    metadata.dictionaries().insert(
+        "generic_sample_generator",
+        GenericSampleGeneratorFactory::get_params_metadata());
+
+    metadata.dictionaries().insert(
+        "generic_sample_renderer",
+        GenericSampleRendererFactory::get_params_metadata());
+
     metadata.dictionaries().insert("drt", DRTLightingEngineFactory::get_params_metadata());
     metadata.dictionaries().insert("pt", PTLightingEngineFactory::get_params_metadata());
     metadata.dictionaries().insert("sppm", SPPMLightingEngineFactory::get_params_metadata());
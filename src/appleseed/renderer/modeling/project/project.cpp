@@ -34,6 +34,7 @@
 #include "renderer/global/globallogger.h"
 #include "renderer/kernel/aov/aovsettings.h"
 #include "renderer/kernel/aov/imagestack.h"
+#include "renderer/kernel/intersection/iintersectionbackend.h"
 #include "renderer/kernel/intersection/tracecontext.h"
 #include "renderer/modeling/display/display.h"
 #include "renderer/modeling/edf/edf.h"
@@ -62,6 +63,7 @@
 #include "foundation/platform/types.h"
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/foreach.h"
+#include "foundation/utility/phaseprofile.h"
 #include "foundation/utility/searchpaths.h"
 
 // Standard headers.
@@ -102,6 +104,7 @@ struct Project::Impl
     ConfigurationContainer      m_configurations;
     SearchPaths                 m_search_paths;
     auto_ptr<TraceContext>      m_trace_context;
+    PhaseProfile                m_load_profile;
 
     Impl()
       : m_format_revision(ProjectFormatRevision)
@@ -159,6 +162,11 @@ SearchPaths& Project::search_paths() const
     return impl->m_search_paths;
 }
 
+PhaseProfile& Project::get_load_profile() const
+{
+    return impl->m_load_profile;
+}
+
 string Project::make_search_path_string() const
 {
     return impl->m_search_paths.to_string_reversed(SearchPaths::osl_path_separator());
@@ -236,6 +244,7 @@ namespace
       public:
         ApplyRenderLayer(Scene& scene, Frame& frame)
           : m_scene(scene)
+          , m_frame(frame)
           , m_aov_images(frame.aov_images())
           , m_pixel_format(frame.image().properties().m_pixel_format)
         {
@@ -273,6 +282,7 @@ namespace
         typedef map<string, RenderLayer> RenderLayerMapping;
 
         Scene&                  m_scene;
+        const Frame&            m_frame;
         ImageStack&             m_aov_images;
         const PixelFormat       m_pixel_format;
         RenderLayerMapping      m_mapping;
@@ -389,7 +399,7 @@ namespace
                         render_layer_name.c_str(),
                         type,
                         4,
-                        m_pixel_format);
+                        m_frame.get_aov_pixel_format(render_layer_name.c_str(), m_pixel_format));
 
                 RenderLayer& render_layer = m_mapping[render_layer_name];
                 render_layer.m_type = type;
@@ -430,9 +440,31 @@ void Project::create_aov_images()
     assert(impl->m_scene.get());
     assert(impl->m_frame.get());
 
-    impl->m_frame->aov_images().clear();
+    const Frame& frame = impl->m_frame.ref();
+    ImageStack& aov_images = frame.aov_images();
+
+    aov_images.clear();
 
-    impl->m_frame->aov_images().append("depth", ImageStack::ContributionType, 4, PixelFormatFloat);
+    aov_images.append(
+        "depth",
+        ImageStack::ContributionType,
+        4,
+        frame.get_aov_pixel_format("depth", PixelFormatFloat));
+
+    // Feature AOVs used to guide the denoiser.
+    if (frame.is_denoising_enabled())
+    {
+        aov_images.append(
+            "albedo",
+            ImageStack::ContributionType,
+            4,
+            frame.get_aov_pixel_format("albedo", PixelFormatFloat));
+        aov_images.append(
+            "normal",
+            ImageStack::ContributionType,
+            4,
+            frame.get_aov_pixel_format("normal", PixelFormatFloat));
+    }
 
     ApplyRenderLayer apply_render_layers(
         impl->m_scene.ref(),
@@ -457,12 +489,24 @@ const TraceContext& Project::get_trace_context() const
     return *impl->m_trace_context;
 }
 
+void Project::set_intersection_backend(auto_release_ptr<IIntersectionBackend> backend)
+{
+    get_trace_context();
+    impl->m_trace_context->set_backend(backend);
+}
+
 void Project::update_trace_context()
 {
     if (impl->m_trace_context.get())
         impl->m_trace_context->update();
 }
 
+void Project::set_camera_frustum(const Frustum<double, 4>* frustum)
+{
+    if (impl->m_trace_context.get())
+        impl->m_trace_context->set_camera_frustum(frustum);
+}
+
 void Project::add_base_configurations()
 {
     impl->m_configurations.insert(BaseConfigurationFactory::create_base_final());
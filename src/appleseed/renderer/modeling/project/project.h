@@ -37,6 +37,7 @@
 #include "renderer/modeling/project/renderlayerrulecontainer.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/frustum.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/utility/autoreleaseptr.h"
 #include "foundation/utility/uid.h"
@@ -49,10 +50,12 @@
 #include <string>
 
 // Forward declarations.
+namespace foundation    { class PhaseProfile; }
 namespace foundation    { class SearchPaths; }
 namespace renderer      { class Camera; }
 namespace renderer      { class Display; }
 namespace renderer      { class Frame; }
+namespace renderer      { class IIntersectionBackend; }
 namespace renderer      { class Scene; }
 namespace renderer      { class TraceContext; }
 
@@ -86,6 +89,9 @@ class APPLESEED_DLLSYMBOL Project
     // Access the search paths.
     foundation::SearchPaths& search_paths() const;
 
+    // Access the profile of the steps that loaded this project from disk.
+    foundation::PhaseProfile& get_load_profile() const;
+
     // Return the search paths as a string, in reverse order (for OIIO/OSL).
     std::string make_search_path_string() const;
 
@@ -136,9 +142,17 @@ class APPLESEED_DLLSYMBOL Project
     // Get the trace context.
     const TraceContext& get_trace_context() const;
 
+    // Set the intersection backend of the trace context, or pass a null
+    // pointer to use the built-in one. Creates the trace context if needed.
+    void set_intersection_backend(foundation::auto_release_ptr<IIntersectionBackend> backend);
+
     // Synchronize the trace context with the scene.
     void update_trace_context();
 
+    // Let camera rays skip the parts of the scene outside of a world space frustum enclosing
+    // all of them, or stop culling if 'frustum' is null. Does nothing if there is no trace context.
+    void set_camera_frustum(const foundation::Frustum<double, 4>* frustum);
+
   private:
     friend class ProjectFactory;
 
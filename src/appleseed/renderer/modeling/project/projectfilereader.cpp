@@ -66,6 +66,8 @@
 #include "renderer/modeling/object/meshobject.h"
 #include "renderer/modeling/object/meshobjectreader.h"
 #include "renderer/modeling/object/object.h"
+#include "renderer/modeling/object/particleobject.h"
+#include "renderer/modeling/object/particleobjectreader.h"
 #include "renderer/modeling/project/configuration.h"
 #include "renderer/modeling/project/configurationcontainer.h"
 #include "renderer/modeling/project/eventcounters.h"
@@ -96,6 +98,8 @@
 #include "renderer/utility/transformsequence.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
+#include "foundation/core/exceptions/exception.h"
 #include "foundation/math/aabb.h"
 #include "foundation/math/matrix.h"
 #include "foundation/math/scalar.h"
@@ -103,15 +107,22 @@
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/defaulttimers.h"
+#include "foundation/platform/system.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/api/apistring.h"
+#include "foundation/utility/binaryxml.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/iterators.h"
+#include "foundation/utility/job/ijob.h"
+#include "foundation/utility/job/jobmanager.h"
+#include "foundation/utility/job/jobqueue.h"
 #include "foundation/utility/log.h"
 #include "foundation/utility/memory.h"
 #include "foundation/utility/otherwise.h"
+#include "foundation/utility/phaseprofile.h"
 #include "foundation/utility/searchpaths.h"
+#include "foundation/utility/statistics.h"
 #include "foundation/utility/stopwatch.h"
 #include "foundation/utility/string.h"
 #include "foundation/utility/xercesc.h"
@@ -198,6 +209,181 @@ namespace
     };
 
 
+    //
+    // Reads mesh and curve files on a pool of worker threads while the project file is being parsed.
+    //
+
+    class ObjectFileLoader
+      : public NonCopyable
+    {
+      public:
+        // An object being read. The objects belong to the load until they are taken.
+        class Load
+          : public IJob
+        {
+          public:
+            Load(
+                const SearchPaths&      search_paths,
+                const string&           name,
+                const string&           model,
+                const ParamArray&       params)
+              : m_search_paths(search_paths)
+              , m_name(name)
+              , m_model(model)
+              , m_params(params)
+              , m_success(false)
+            {
+            }
+
+            ~Load()
+            {
+                for (size_t i = 0; i < m_objects.size(); ++i)
+                    m_objects[i]->release();
+            }
+
+            virtual void execute(const size_t thread_index) APPLESEED_OVERRIDE
+            {
+                try
+                {
+                    if (m_model == MeshObjectFactory::get_model())
+                    {
+                        MeshObjectArray objects;
+                        m_success =
+                            MeshObjectReader::read(
+                                m_search_paths,
+                                m_name.c_str(),
+                                m_params,
+                                objects);
+
+                        for (size_t i = 0; i < objects.size(); ++i)
+                            m_objects.push_back(objects[i]);
+                    }
+                    else if (m_model == ParticleObjectFactory::get_model())
+                    {
+                        m_objects.push_back(
+                            ParticleObjectReader::read(
+                                m_search_paths,
+                                m_name.c_str(),
+                                m_params).release());
+                        m_success = true;
+                    }
+                    else
+                    {
+                        assert(m_model == CurveObjectFactory::get_model());
+                        m_objects.push_back(
+                            CurveObjectReader::read(
+                                m_search_paths,
+                                m_name.c_str(),
+                                m_params).release());
+                        m_success = true;
+                    }
+                }
+                catch (const ExceptionDictionaryKeyNotFound& e)
+                {
+                    RENDERER_LOG_ERROR(
+                        "while defining object \"%s\": required parameter \"%s\" missing.",
+                        m_name.c_str(),
+                        e.string());
+                }
+                catch (const Exception& e)
+                {
+                    RENDERER_LOG_ERROR(
+                        "while defining object \"%s\": %s.",
+                        m_name.c_str(),
+                        e.what());
+                }
+            }
+
+            // Return true if the mesh object was successfully read.
+            bool succeeded() const
+            {
+                return m_success;
+            }
+
+            // Transfer the ownership of the objects to the caller.
+            void take_objects(vector<Object*>& objects)
+            {
+                for (size_t i = 0; i < m_objects.size(); ++i)
+                    objects.push_back(m_objects[i]);
+
+                m_objects.clear();
+            }
+
+          private:
+            const SearchPaths   m_search_paths;
+            const string        m_name;
+            const string        m_model;
+            const ParamArray    m_params;
+            vector<Object*>     m_objects;
+            bool                m_success;
+        };
+
+        ObjectFileLoader()
+          : m_pending_load_count(0)
+        {
+        }
+
+        ~ObjectFileLoader()
+        {
+            wait();
+
+            for (size_t i = 0; i < m_loads.size(); ++i)
+                delete m_loads[i];
+        }
+
+        // Schedule the reading of a mesh or curve object. The load remains owned by the loader.
+        Load* schedule(
+            const SearchPaths&          search_paths,
+            const string&               name,
+            const string&               model,
+            const ParamArray&           params)
+        {
+            if (m_job_manager.get() == 0)
+            {
+                m_job_manager.reset(
+                    new JobManager(
+                        global_logger(),
+                        m_job_queue,
+                        System::get_logical_cpu_core_count()));
+                m_job_manager->start();
+            }
+
+            Load* load = new Load(search_paths, name, model, params);
+            m_loads.push_back(load);
+            m_job_queue.schedule(load, false);
+            ++m_pending_load_count;
+
+            return load;
+        }
+
+        // Wait until all scheduled loads are completed.
+        void wait()
+        {
+            if (m_pending_load_count == 0)
+                return;
+
+            Stopwatch<DefaultWallclockTimer> stopwatch;
+            stopwatch.start();
+
+            m_job_queue.wait_until_completion();
+
+            RENDERER_LOG_DEBUG(
+                "waited %s for %s %s to load.",
+                pretty_time(stopwatch.measure().get_seconds()).c_str(),
+                pretty_uint(m_pending_load_count).c_str(),
+                plural(m_pending_load_count, "object").c_str());
+
+            m_pending_load_count = 0;
+        }
+
+      private:
+        JobQueue                m_job_queue;
+        auto_ptr<JobManager>    m_job_manager;
+        vector<Load*>           m_loads;
+        size_t                  m_pending_load_count;
+    };
+
+
     //
     // A set of objects that is passed to all element handlers.
     //
@@ -215,6 +401,11 @@ namespace
         {
         }
 
+        ObjectFileLoader& get_object_file_loader()
+        {
+            return m_object_file_loader;
+        }
+
         Project& get_project()
         {
             return m_project;
@@ -234,6 +425,7 @@ namespace
         Project&            m_project;
         const int           m_options;
         EventCounters&      m_event_counters;
+        ObjectFileLoader    m_object_file_loader;
     };
 
 
@@ -1563,6 +1755,7 @@ namespace
 
         explicit ObjectElementHandler(ParseContext& context)
           : m_context(context)
+          , m_object_load(0)
         {
         }
 
@@ -1571,6 +1764,7 @@ namespace
             ParametrizedElementHandler::start_element(attrs);
 
             clear_keep_memory(m_objects);
+            m_object_load = 0;
 
             m_name = get_value(attrs, "name");
             m_model = get_value(attrs, "model");
@@ -1593,23 +1787,23 @@ namespace
                     }
                     else
                     {
-                        MeshObjectArray object_array;
-                        if (MeshObjectReader::read(
+                        m_object_load =
+                            m_context.get_object_file_loader().schedule(
                                 m_context.get_project().search_paths(),
-                                m_name.c_str(),
-                                m_params,
-                                object_array))
-                            m_objects = array_vector<ObjectVector>(object_array);
-                        else m_context.get_event_counters().signal_error();
+                                m_name,
+                                m_model,
+                                m_params);
                     }
                 }
-                else if (m_model == CurveObjectFactory::get_model())
+                else if (m_model == CurveObjectFactory::get_model() ||
+                         m_model == ParticleObjectFactory::get_model())
                 {
-                    m_objects.push_back(
-                        CurveObjectReader::read(
+                    m_object_load =
+                        m_context.get_object_file_loader().schedule(
                             m_context.get_project().search_paths(),
-                            m_name.c_str(),
-                            m_params).release());
+                            m_name,
+                            m_model,
+                            m_params);
                 }
                 else
                 {
@@ -1635,11 +1829,18 @@ namespace
             return m_objects;
         }
 
+        // Return the object being read from disk, or 0 if there is none.
+        ObjectFileLoader::Load* get_object_load() const
+        {
+            return m_object_load;
+        }
+
       private:
-        ParseContext&   m_context;
-        ObjectVector    m_objects;
-        string          m_name;
-        string          m_model;
+        ParseContext&           m_context;
+        ObjectVector            m_objects;
+        ObjectFileLoader::Load* m_object_load;
+        string                  m_name;
+        string                  m_model;
     };
 
 
@@ -2061,6 +2262,7 @@ namespace
             m_lights.clear();
             m_materials.clear();
             m_objects.clear();
+            m_object_definitions.clear();
             m_object_instances.clear();
             m_shader_groups.clear();
             m_surface_shaders.clear();
@@ -2075,6 +2277,10 @@ namespace
         {
             ParametrizedElementHandler::end_element();
 
+            // Wait for object files to be read, and insert objects in the order of their definitions.
+            m_context.get_object_file_loader().wait();
+            insert_objects();
+
             const AssemblyFactoryRegistrar factories;
             const IAssemblyFactory *factory = factories.lookup(m_model.c_str());
 
@@ -2162,9 +2368,12 @@ namespace
                 break;
 
               case ElementObject:
-                for (const_each<ObjectElementHandler::ObjectVector> i =
-                        static_cast<ObjectElementHandler*>(handler)->get_objects(); i; ++i)
-                    insert(m_objects, auto_release_ptr<Object>(*i));
+                {
+                    const ObjectElementHandler* object_handler = static_cast<ObjectElementHandler*>(handler);
+                    m_object_definitions.push_back(ObjectDefinition());
+                    m_object_definitions.back().m_objects = object_handler->get_objects();
+                    m_object_definitions.back().m_object_load = object_handler->get_object_load();
+                }
                 break;
 
               case ElementObjectInstance:
@@ -2209,9 +2418,17 @@ namespace
         }
 
       private:
+        // Objects defined by an <object> element, possibly still being read from disk.
+        struct ObjectDefinition
+        {
+            ObjectElementHandler::ObjectVector  m_objects;
+            ObjectFileLoader::Load*             m_object_load;
+        };
+
         auto_release_ptr<Assembly>  m_assembly;
         string                      m_name;
         string                      m_model;
+        vector<ObjectDefinition>    m_object_definitions;
         AssemblyContainer           m_assemblies;
         AssemblyInstanceContainer   m_assembly_instances;
         BSDFContainer               m_bsdfs;
@@ -2226,6 +2443,24 @@ namespace
         SurfaceShaderContainer      m_surface_shaders;
         TextureContainer            m_textures;
         TextureInstanceContainer    m_texture_instances;
+
+        void insert_objects()
+        {
+            for (each<vector<ObjectDefinition> > i = m_object_definitions; i; ++i)
+            {
+                if (i->m_object_load)
+                {
+                    if (i->m_object_load->succeeded())
+                        i->m_object_load->take_objects(i->m_objects);
+                    else m_context.get_event_counters().signal_error();
+                }
+
+                for (const_each<ObjectElementHandler::ObjectVector> j = i->m_objects; j; ++j)
+                    insert(m_objects, auto_release_ptr<Object>(*j));
+            }
+
+            m_object_definitions.clear();
+        }
     };
 
 
@@ -3052,7 +3287,10 @@ auto_release_ptr<Project> ProjectFileReader::read(
     if (!xerces_context.is_initialized())
         return auto_release_ptr<Project>(0);
 
-    if ((options & OmitProjectSchemaValidation) == false && schema_filepath == 0)
+    // Binary project files were validated when they were written.
+    const bool binary = is_binary_xml_file(project_filepath);
+
+    if (!binary && (options & OmitProjectSchemaValidation) == false && schema_filepath == 0)
     {
         RENDERER_LOG_ERROR(
             "project schema validation enabled, but no schema filepath provided.");
@@ -3062,6 +3300,14 @@ auto_release_ptr<Project> ProjectFileReader::read(
     Stopwatch<DefaultWallclockTimer> stopwatch;
     stopwatch.start();
 
+    PhaseProfile load_profile;
+    load_profile.begin_phase("project loading");
+
+    // Xerces validates the project against the schema while parsing it.
+    load_profile.begin_phase(
+        binary || (options & OmitProjectSchemaValidation)
+            ? "project file parsing"
+            : "project file parsing and validation");
     EventCounters event_counters;
     auto_release_ptr<Project> project(
         load_project_file(
@@ -3069,9 +3315,18 @@ auto_release_ptr<Project> ProjectFileReader::read(
             schema_filepath,
             options,
             event_counters));
+    load_profile.end_phase();
 
     if (project.get())
+    {
+        ScopedPhase phase(load_profile, "project post-processing");
         postprocess_project(project.ref(), event_counters, options);
+    }
+
+    load_profile.end_phase();
+
+    if (project.get())
+        project->get_load_profile().append(load_profile);
 
     stopwatch.measure();
 
@@ -3207,6 +3462,21 @@ auto_release_ptr<Project> ProjectFileReader::load_project_file(
             project.get(),
             context));
 
+    // Binary project files are replayed directly into the content handler.
+    if (is_binary_xml_file(project_filepath))
+    {
+        RENDERER_LOG_INFO("loading binary project file %s...", project_filepath);
+
+        if (!BinaryXMLFileReader::read(project_filepath, *content_handler))
+        {
+            RENDERER_LOG_ERROR("failed to load project file %s: invalid binary project file.", project_filepath);
+            event_counters.signal_error();
+            return auto_release_ptr<Project>(0);
+        }
+
+        return project;
+    }
+
     // Create the parser.
     auto_ptr<SAX2XMLReader> parser(XMLReaderFactory::createXMLReader());
     parser->setFeature(XMLUni::fgSAX2CoreNameSpaces, true);         // perform namespace processing
@@ -3290,6 +3560,9 @@ void ProjectFileReader::postprocess_project(
         !(options & OmitProjectFileUpdate) &&
         project.get_format_revision() < ProjectFormatRevision)
         upgrade_project(project, event_counters);
+
+    if (!event_counters.has_errors() && (options & DeduplicateMeshObjects))
+        deduplicate_mesh_objects(project);
 }
 
 void ProjectFileReader::validate_project(
@@ -3353,6 +3626,79 @@ void ProjectFileReader::upgrade_project(
     updater.update(project, event_counters);
 }
 
+namespace
+{
+    void collect_mesh_objects(
+        AssemblyContainer&      assemblies,
+        vector<MeshObject*>&    mesh_objects)
+    {
+        for (each<AssemblyContainer> i = assemblies; i; ++i)
+        {
+            for (each<ObjectContainer> j = i->objects(); j; ++j)
+            {
+                if (strcmp(j->get_model(), MeshObjectFactory::get_model()) == 0)
+                    mesh_objects.push_back(static_cast<MeshObject*>(&*j));
+            }
+
+            collect_mesh_objects(i->assemblies(), mesh_objects);
+        }
+    }
+}
+
+void ProjectFileReader::deduplicate_mesh_objects(
+    Project&                project) const
+{
+    Stopwatch<DefaultWallclockTimer> stopwatch;
+    stopwatch.start();
+
+    vector<MeshObject*> mesh_objects;
+    collect_mesh_objects(project.get_scene()->assemblies(), mesh_objects);
+
+    // Bucket mesh objects by tessellation hash, then compare the content
+    // of each mesh object against the distinct tessellations of its bucket.
+    typedef map<uint64, vector<MeshObject*> > MeshObjectBuckets;
+    MeshObjectBuckets buckets;
+
+    size_t deduplicated_count = 0;
+    uint64 saved_memory = 0;
+
+    for (const_each<vector<MeshObject*> > i = mesh_objects; i; ++i)
+    {
+        MeshObject* mesh_object = *i;
+        vector<MeshObject*>& bucket = buckets[mesh_object->compute_tessellation_hash()];
+
+        bool shared = false;
+
+        for (const_each<vector<MeshObject*> > j = bucket; j; ++j)
+        {
+            if (mesh_object->has_same_tessellation(**j))
+            {
+                saved_memory += mesh_object->get_tessellation_memory_size();
+                mesh_object->share_tessellation(**j);
+                ++deduplicated_count;
+                shared = true;
+                break;
+            }
+        }
+
+        if (!shared)
+            bucket.push_back(mesh_object);
+    }
+
+    stopwatch.measure();
+
+    Statistics statistics;
+    statistics.insert<uint64>("mesh objects", mesh_objects.size());
+    statistics.insert<uint64>("deduplicated", deduplicated_count);
+    statistics.insert_size("memory saved", saved_memory);
+    statistics.insert_time("time", stopwatch.get_seconds());
+
+    RENDERER_LOG_INFO("%s",
+        StatisticsVector::make(
+            "mesh deduplication statistics",
+            statistics).to_string().c_str());
+}
+
 void ProjectFileReader::print_loading_results(
     const char*             project_name,
     const bool              builtin_project,
@@ -58,10 +58,12 @@ class APPLESEED_DLLSYMBOL ProjectFileReader
         OmitReadingMeshFiles        = 1 << 0,   // do not read mesh files from disk
         OmitProjectFileUpdate       = 1 << 1,   // do not update the project file format to the latest revision
         OmitSearchPaths             = 1 << 2,   // do not read search paths from the project
-        OmitProjectSchemaValidation = 1 << 3    // do not validate project against schema
+        OmitProjectSchemaValidation = 1 << 3,   // do not validate project against schema
+        DeduplicateMeshObjects      = 1 << 4    // share the tessellation of mesh objects with identical geometry
     };
 
     // Read a project from disk (or load a built-in project).
+    // Binary project files are recognized by their signature and are never validated.
     // Return 0 if reading or parsing the file failed.
     foundation::auto_release_ptr<Project> read(
         const char*                     project_filepath,
@@ -114,6 +116,10 @@ class APPLESEED_DLLSYMBOL ProjectFileReader
         Project&                        project,
         EventCounters&                  event_counters) const;
 
+    // Let mesh objects with identical geometry share a single tessellation.
+    void deduplicate_mesh_objects(
+        Project&                        project) const;
+
     void print_loading_results(
         const char*                     project_name,
         const bool                      builtin_project,
@@ -31,6 +31,7 @@
 #include "projectfilewriter.h"
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #include "renderer/modeling/bsdf/bsdf.h"
 #include "renderer/modeling/bssrdf/bssrdf.h"
 #include "renderer/modeling/camera/camera.h"
@@ -72,11 +73,13 @@
 // appleseed.foundation headers.
 #include "foundation/core/appleseed.h"
 #include "foundation/math/transform.h"
+#include "foundation/utility/binaryxml.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/indenter.h"
 #include "foundation/utility/searchpaths.h"
 #include "foundation/utility/string.h"
+#include "foundation/utility/xercesc.h"
 #include "foundation/utility/xmlelement.h"
 
 // Boost headers.
@@ -106,6 +109,9 @@ namespace renderer
 
 namespace
 {
+    // Extension of binary project files.
+    const char* BinaryProjectFileExtension = ".appleseedb";
+
     // Floating-point formatting settings.
     const char* MatrixFormat     = "%.15f";
     const char* ColorValueFormat = "%.6f";
@@ -869,6 +875,34 @@ namespace
             write_transform(texture_instance.get_transform());
         }
     };
+
+    bool is_binary_project_filepath(const char* filepath)
+    {
+        return lower_case(filesystem::path(filepath).extension().string()) == BinaryProjectFileExtension;
+    }
+
+    // Convert the XML document held in a temporary file to a binary project file.
+    bool write_binary_project_file(const char* filepath, FILE* xml_file)
+    {
+        XercesCContext xerces_context(global_logger());
+        if (!xerces_context.is_initialized())
+            return false;
+
+        if (fseek(xml_file, 0, SEEK_END) != 0)
+            return false;
+
+        const long xml_size = ftell(xml_file);
+        if (xml_size <= 0)
+            return false;
+
+        rewind(xml_file);
+
+        vector<char> xml(static_cast<size_t>(xml_size));
+        if (fread(&xml[0], 1, xml.size(), xml_file) != xml.size())
+            return false;
+
+        return BinaryXMLFileWriter::write(filepath, &xml[0], xml.size());
+    }
 }
 
 bool ProjectFileWriter::write(
@@ -886,7 +920,8 @@ bool ProjectFileWriter::write(
             filepath,
             (options & CopyAllAssets) != 0
                 ? AssetHandler::CopyAllAssets
-                : AssetHandler::CopyRelativeAssetsOnly);
+                : AssetHandler::CopyRelativeAssetsOnly,
+            (options & PrefetchAssetFiles) != 0);
         if (!asset_handler.handle_assets())
         {
             RENDERER_LOG_ERROR("failed to write project file %s.", filepath);
@@ -894,8 +929,11 @@ bool ProjectFileWriter::write(
         }
     }
 
+    // Binary project files are converted from an XML document written to a temporary file.
+    const bool binary = is_binary_project_filepath(filepath);
+
     // Open the file for writing.
-    FILE* file = fopen(filepath, "wt");
+    FILE* file = binary ? tmpfile() : fopen(filepath, "wt");
     if (file == 0)
     {
         RENDERER_LOG_ERROR("failed to write project file %s: i/o error.", filepath);
@@ -918,6 +956,13 @@ bool ProjectFileWriter::write(
     Writer writer(project, filepath, file, options);
     writer.write_project(project);
 
+    if (binary && !write_binary_project_file(filepath, file))
+    {
+        fclose(file);
+        RENDERER_LOG_ERROR("failed to write project file %s: i/o error.", filepath);
+        return false;
+    }
+
     // Close the file.
     fclose(file);
 
@@ -52,10 +52,12 @@ class APPLESEED_DLLSYMBOL ProjectFileWriter
         OmitHeaderComment           = 1 << 0,   // do not write the header comment
         OmitWritingGeometryFiles    = 1 << 1,   // do not write geometry files to disk
         OmitHandlingAssetFiles      = 1 << 2,   // do not change paths to asset files (such as texture files)
-        CopyAllAssets               = 1 << 3    // copy all asset files (by default copy asset files with relative paths only)
+        CopyAllAssets               = 1 << 3,   // copy all asset files (by default copy asset files with relative paths only)
+        PrefetchAssetFiles          = 1 << 4    // read asset files in the background ahead of copying them
     };
 
-    // Write a project to disk. Return true on success, false otherwise.
+    // Write a project to disk. Projects are written in binary form if 'filepath'
+    // has the .appleseedb extension. Return true on success, false otherwise.
     static bool write(
         const Project&  project,
         const char*     filepath,
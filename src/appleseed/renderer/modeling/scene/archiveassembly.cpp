@@ -33,15 +33,20 @@
 #include <string>
 
 // appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
 #include "renderer/modeling/project/project.h"
 #include "renderer/modeling/project/projectfilereader.h"
+#include "renderer/modeling/scene/assembly.h"
 #include "renderer/modeling/scene/scene.h"
 #include "renderer/utility/paramarray.h"
 
 // appleseed.foundation headers.
+#include "foundation/platform/system.h"
+#include "foundation/utility/api/apistring.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/foreach.h"
+#include "foundation/utility/iostreamop.h"
 #include "foundation/utility/job/abortswitch.h"
 #include "foundation/utility/searchpaths.h"
 
@@ -68,7 +73,15 @@ ArchiveAssembly::ArchiveAssembly(
     const ParamArray&   params)
   : ProceduralAssembly(name, params)
   , m_archive_opened(false)
+  , m_deferred(params.get_optional<bool>("deferred", false))
+  , m_deferred_bbox(AABB3d::invalid())
+  , m_ray_entered(0)
 {
+    if (m_deferred)
+    {
+        m_deferred_bbox =
+            AABB3d(params.get_required<GAABB3>("bbox", GAABB3(GVector3(0.0f), GVector3(0.0f))));
+    }
 }
 
 void ArchiveAssembly::release()
@@ -92,48 +105,100 @@ void ArchiveAssembly::update_asset_paths(const StringDictionary& mappings)
     m_params.set("filename", mappings.get(m_params.get("filename")));
 }
 
+GAABB3 ArchiveAssembly::compute_local_bbox() const
+{
+    return
+        m_deferred && !m_archive_opened
+            ? GAABB3(m_deferred_bbox)
+            : ProceduralAssembly::compute_local_bbox();
+}
+
+GAABB3 ArchiveAssembly::compute_non_hierarchical_local_bbox() const
+{
+    return
+        m_deferred && !m_archive_opened
+            ? GAABB3(m_deferred_bbox)
+            : ProceduralAssembly::compute_non_hierarchical_local_bbox();
+}
+
 bool ArchiveAssembly::expand_contents(
     const Project&      project,
     const Assembly*     parent,
     IAbortSwitch*       abort_switch)
 {
+    if (!m_deferred)
+    {
+        if (!m_archive_opened)
+            load_contents(project);
+
+        return true;
+    }
+
+    // Start recording ray entries anew for the upcoming render.
+    const bool ray_entered = atomic_read(&m_ray_entered) != 0;
+    atomic_write(&m_ray_entered, 0);
+
     if (!m_archive_opened)
     {
-        // Establish and store the qualified path to the archive project.
-        const SearchPaths& search_paths = project.search_paths();
-        const string filepath = search_paths.qualify(m_params.get_required<string>("filename", ""));
-
-        ProjectFileReader reader;
-        auto_release_ptr<Assembly> assembly =
-            reader.read_archive(
-                filepath.c_str(),
-                0,  // for now, we don't validate archives
-                search_paths,
-                ProjectFileReader::OmitProjectSchemaValidation);
-
-        if (assembly.get())
+        if (ray_entered)
+        {
+            RENDERER_LOG_INFO("loading deferred archive assembly \"%s\"...", get_path().c_str());
+            load_contents(project);
+        }
+    }
+    else if (!ray_entered)
+    {
+        const size_t unload_threshold = m_params.get_optional<size_t>("unload_threshold", 0);
+
+        if (unload_threshold > 0 &&
+            System::get_process_virtual_memory_size() > static_cast<uint64>(unload_threshold) * 1024 * 1024)
         {
-            assemblies().swap(assembly->assemblies());
-            assembly_instances().swap(assembly->assembly_instances());
-            bsdfs().swap(assembly->bsdfs());
-            bssrdfs().swap(assembly->bssrdfs());
-            colors().swap(assembly->colors());
-            edfs().swap(assembly->edfs());
-            lights().swap(assembly->lights());
-            materials().swap(assembly->materials());
-            objects().swap(assembly->objects());
-            object_instances().swap(assembly->object_instances());
-            shader_groups().swap(assembly->shader_groups());
-            surface_shaders().swap(assembly->surface_shaders());
-            textures().swap(assembly->textures());
-            texture_instances().swap(assembly->texture_instances());
-            m_archive_opened = true;
+            RENDERER_LOG_INFO("unloading unused deferred archive assembly \"%s\"...", get_path().c_str());
+            unload_contents();
         }
     }
 
     return true;
 }
 
+bool ArchiveAssembly::load_contents(const Project& project)
+{
+    // Establish and store the qualified path to the archive project.
+    const SearchPaths& search_paths = project.search_paths();
+    const string filepath = search_paths.qualify(m_params.get_required<string>("filename", ""));
+
+    ProjectFileReader reader;
+    auto_release_ptr<Assembly> assembly =
+        reader.read_archive(
+            filepath.c_str(),
+            0,  // for now, we don't validate archives
+            search_paths,
+            ProjectFileReader::OmitProjectSchemaValidation);
+
+    if (!assembly.get())
+        return false;
+
+    swap_contents(assembly.ref());
+    m_archive_opened = true;
+
+    // Let the acceleration structures pick up the new contents.
+    bump_version_id();
+
+    return true;
+}
+
+void ArchiveAssembly::unload_contents()
+{
+    // Swapping with an empty assembly releases the contents when it goes out of scope.
+    auto_release_ptr<Assembly> empty_assembly =
+        AssemblyFactory().create("empty", ParamArray());
+
+    swap_contents(empty_assembly.ref());
+    m_archive_opened = false;
+
+    bump_version_id();
+}
+
 
 //
 // ArchiveAssemblyFactory class implementation.
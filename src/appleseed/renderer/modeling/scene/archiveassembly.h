@@ -30,12 +30,16 @@
 #define APPLESEED_RENDERER_MODELING_SCENE_ARCHIVEASSEMBLY_H
 
 // appleseed.renderer headers.
+#include "renderer/global/globaltypes.h"
 #include "renderer/modeling/scene/basegroup.h"
 #include "renderer/modeling/scene/iassemblyfactory.h"
 #include "renderer/modeling/scene/proceduralassembly.h"
 
 // appleseed.foundation headers.
+#include "foundation/math/aabb.h"
+#include "foundation/platform/atomic.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
 #include "foundation/utility/autoreleaseptr.h"
 
 // appleseed.main headers.
@@ -55,6 +59,13 @@ namespace renderer
 // An archive assembly loads and references geometries, materials and lights
 // from other appleseed projects.
 //
+// A deferred archive assembly ("deferred" parameter set to true) declares its
+// local space bounding box with the "bbox" parameter and is only loaded once a
+// ray enters that box: the frame is then rendered again with the archive loaded.
+// If the "unload_threshold" parameter is set, a loaded deferred archive that no
+// ray entered during the last render is unloaded when the memory used by the
+// process exceeds that many megabytes.
+//
 
 class APPLESEED_DLLSYMBOL ArchiveAssembly
   : public ProceduralAssembly
@@ -70,11 +81,30 @@ class APPLESEED_DLLSYMBOL ArchiveAssembly
     virtual void collect_asset_paths(foundation::StringArray& paths) const APPLESEED_OVERRIDE;
     virtual void update_asset_paths(const foundation::StringDictionary& mappings) APPLESEED_OVERRIDE;
 
+    // The bounding boxes of a deferred archive that is not loaded are its declared bounding box.
+    virtual GAABB3 compute_local_bbox() const APPLESEED_OVERRIDE;
+    virtual GAABB3 compute_non_hierarchical_local_bbox() const APPLESEED_OVERRIDE;
+
     virtual bool expand_contents(
         const Project&              project,
         const Assembly*             parent,
         foundation::IAbortSwitch*   abort_switch = 0) APPLESEED_OVERRIDE;
 
+    // Return true if this archive is only loaded once a ray enters its bounding box.
+    bool is_deferred() const;
+
+    // Return true if the contents of the archive are loaded.
+    bool is_expanded() const;
+
+    // Return the declared local space bounding box of a deferred archive.
+    const foundation::AABB3d& get_deferred_bbox() const;
+
+    // Record that a ray entered the bounding box of a deferred archive. Thread-safe.
+    void record_ray_entry() const;
+
+    // Return true if a ray entered the bounding box of a deferred archive that is not loaded.
+    bool is_expansion_pending() const;
+
   private:
     friend class ArchiveAssemblyFactory;
 
@@ -83,10 +113,51 @@ class APPLESEED_DLLSYMBOL ArchiveAssembly
         const char*                 name,
         const ParamArray&           params);
 
-    bool m_archive_opened;
+    bool                            m_archive_opened;
+    bool                            m_deferred;
+    foundation::AABB3d              m_deferred_bbox;
+    mutable volatile foundation::uint32 m_ray_entered;
+
+    bool load_contents(const Project& project);
+    void unload_contents();
 };
 
 
+//
+// ArchiveAssembly class implementation.
+//
+
+inline bool ArchiveAssembly::is_deferred() const
+{
+    return m_deferred;
+}
+
+inline bool ArchiveAssembly::is_expanded() const
+{
+    return m_archive_opened;
+}
+
+inline const foundation::AABB3d& ArchiveAssembly::get_deferred_bbox() const
+{
+    return m_deferred_bbox;
+}
+
+inline void ArchiveAssembly::record_ray_entry() const
+{
+    // Avoid writing to the shared flag once it is set.
+    if (foundation::atomic_read(&m_ray_entered) == 0)
+        foundation::atomic_write(&m_ray_entered, 1);
+}
+
+inline bool ArchiveAssembly::is_expansion_pending() const
+{
+    return
+        m_deferred &&
+        !m_archive_opened &&
+        foundation::atomic_read(&m_ray_entered) != 0;
+}
+
+
 //
 // ArchiveAssembly factory.
 //
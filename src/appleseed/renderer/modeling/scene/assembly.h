@@ -104,11 +104,11 @@ class APPLESEED_DLLSYMBOL Assembly
 
     // Compute the local space bounding box of the assembly, including all child assemblies,
     // over the shutter interval.
-    GAABB3 compute_local_bbox() const;
+    virtual GAABB3 compute_local_bbox() const;
 
     // Compute the local space bounding box of this assembly, excluding all child assemblies,
     // over the shutter interval.
-    GAABB3 compute_non_hierarchical_local_bbox() const;
+    virtual GAABB3 compute_non_hierarchical_local_bbox() const;
 
     // Expose asset file paths referenced by this entity to the outside.
     virtual void collect_asset_paths(foundation::StringArray& paths) const APPLESEED_OVERRIDE;
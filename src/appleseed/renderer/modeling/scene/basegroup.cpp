@@ -99,7 +99,8 @@ ShaderGroupContainer& BaseGroup::shader_groups() const
 
 bool BaseGroup::create_optimized_osl_shader_groups(
     OSL::ShadingSystem& shading_system,
-    IAbortSwitch*       abort_switch)
+    IAbortSwitch*       abort_switch,
+    ShaderGroupCache*   cache)
 {
     bool success = true;
 
@@ -110,7 +111,8 @@ bool BaseGroup::create_optimized_osl_shader_groups(
 
         success = success && i->create_optimized_osl_shader_groups(
             shading_system,
-            abort_switch);
+            abort_switch,
+            cache);
     }
 
     for (each<ShaderGroupContainer> i = shader_groups(); i; ++i)
@@ -120,7 +122,8 @@ bool BaseGroup::create_optimized_osl_shader_groups(
 
         success = success && i->create_optimized_osl_shader_group(
             shading_system,
-            abort_switch);
+            abort_switch,
+            cache);
     }
 
     return success;
@@ -47,6 +47,7 @@ namespace foundation    { class IAbortSwitch; }
 namespace foundation    { class StringArray; }
 namespace foundation    { class StringDictionary; }
 namespace renderer      { class Entity; }
+namespace renderer      { class ShaderGroupCache; }
 
 namespace renderer
 {
@@ -76,10 +77,12 @@ class APPLESEED_DLLSYMBOL BaseGroup
     // Access the OSL shader groups.
     ShaderGroupContainer& shader_groups() const;
 
-    // Create OSL shader groups and optimize them.
+    // Create OSL shader groups and optimize them. If 'cache' is not null, identical
+    // shader groups share a single optimized OSL shader group.
     bool create_optimized_osl_shader_groups(
         OSL::ShadingSystem&         shading_system,
-        foundation::IAbortSwitch*   abort_switch = 0);
+        foundation::IAbortSwitch*   abort_switch = 0,
+        ShaderGroupCache*           cache = 0);
 
     // Release internal OSL shader groups.
     void release_optimized_osl_shader_groups();
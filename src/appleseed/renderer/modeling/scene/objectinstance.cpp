@@ -44,9 +44,13 @@
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/makevector.h"
+#include "foundation/utility/string.h"
 
 // Standard headers.
+#include <cassert>
+#include <cstring>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 using namespace std;
@@ -110,6 +114,11 @@ struct ObjectInstance::Impl
     string                  m_object_name;
     StringDictionary        m_front_material_mappings;
     StringDictionary        m_back_material_mappings;
+    vector<string>          m_lod_object_names;
+    vector<double>          m_lod_thresholds;
+    size_t                  m_selected_lod;
+    double                  m_curve_lod_segment_pixels;
+    size_t                  m_curve_lod;
 };
 
 ObjectInstance::ObjectInstance(
@@ -155,6 +164,39 @@ ObjectInstance::ObjectInstance(
     // Retrieve ray bias distance.
     m_ray_bias_distance = params.get_optional<double>("ray_bias_distance", 0.0);
 
+    // Retrieve levels of detail.
+    impl->m_selected_lod = 0;
+    tokenize(params.get_optional<string>("lod_objects", ""), Blanks, impl->m_lod_object_names);
+    if (!impl->m_lod_object_names.empty())
+    {
+        vector<string> thresholds;
+        tokenize(params.get_optional<string>("lod_thresholds", ""), Blanks, thresholds);
+
+        try
+        {
+            for (size_t i = 0; i < thresholds.size(); ++i)
+                impl->m_lod_thresholds.push_back(from_string<double>(thresholds[i]));
+        }
+        catch (const ExceptionStringConversionError&)
+        {
+            impl->m_lod_thresholds.clear();
+        }
+
+        if (impl->m_lod_thresholds.size() != impl->m_lod_object_names.size())
+        {
+            RENDERER_LOG_ERROR(
+                "%s: \"lod_thresholds\" must list one pixel coverage per object in \"lod_objects\"; "
+                "levels of detail are disabled.",
+                message_context.get());
+            impl->m_lod_object_names.clear();
+            impl->m_lod_thresholds.clear();
+        }
+    }
+
+    // Retrieve curve levels of detail settings.
+    impl->m_curve_lod_segment_pixels = params.get_optional<double>("curve_lod_segment_pixels", 1.0);
+    impl->m_curve_lod = 0;
+
     // No bound object yet.
     m_object = 0;
 }
@@ -187,26 +229,156 @@ const Transformd& ObjectInstance::get_transform() const
     return impl->m_transform;
 }
 
-Object* ObjectInstance::find_object() const
+namespace
 {
-    const Entity* parent = get_parent();
+    Object* find_object_in_parents(const Entity* parent, const char* object_name)
+    {
+        while (parent)
+        {
+            if (dynamic_cast<const Assembly*>(parent) == 0)
+                break;
+
+            Object* object =
+                static_cast<const Assembly*>(parent)
+                    ->objects().get_by_name(object_name);
+
+            if (object)
+                return object;
 
-    while (parent)
+            parent = parent->get_parent();
+        }
+
+        return 0;
+    }
+
+    bool have_same_material_slots(const Object& lhs, const Object& rhs)
     {
-        if (dynamic_cast<const Assembly*>(parent) == 0)
-            break;
+        const size_t slot_count = lhs.get_material_slot_count();
 
-        Object* object =
-            static_cast<const Assembly*>(parent)
-                ->objects().get_by_name(impl->m_object_name.c_str());
+        if (rhs.get_material_slot_count() != slot_count)
+            return false;
 
-        if (object)
-            return object;
+        for (size_t i = 0; i < slot_count; ++i)
+        {
+            if (strcmp(lhs.get_material_slot(i), rhs.get_material_slot(i)) != 0)
+                return false;
+        }
 
-        parent = parent->get_parent();
+        return true;
     }
+}
+
+Object* ObjectInstance::find_object() const
+{
+    return find_object_in_parents(get_parent(), impl->m_object_name.c_str());
+}
 
-    return 0;
+size_t ObjectInstance::get_lod_count() const
+{
+    return impl->m_lod_object_names.size() + 1;
+}
+
+const char* ObjectInstance::get_lod_object_name(const size_t level) const
+{
+    assert(level < get_lod_count());
+
+    return
+        level == 0
+            ? impl->m_object_name.c_str()
+            : impl->m_lod_object_names[level - 1].c_str();
+}
+
+size_t ObjectInstance::choose_lod(const double pixel_coverage) const
+{
+    size_t level = 0;
+
+    while (level < impl->m_lod_thresholds.size() &&
+           pixel_coverage < impl->m_lod_thresholds[level])
+        ++level;
+
+    return level;
+}
+
+bool ObjectInstance::select_lod(const size_t level)
+{
+    assert(level < get_lod_count());
+    assert(m_object);
+
+    // The object bound by bind_object() may already have been replaced by a level of detail.
+    Object* base_object = find_object();
+    if (base_object == 0)
+        base_object = m_object;
+
+    Object* object = base_object;
+    size_t selected_lod = 0;
+
+    if (level > 0)
+    {
+        Object* lod_object = find_object_in_parents(get_parent(), get_lod_object_name(level));
+        const EntityDefMessageContext context("object instance", this);
+
+        if (lod_object == 0)
+        {
+            RENDERER_LOG_ERROR(
+                "%s: level of detail object \"%s\" not found; using the full resolution object.",
+                context.get(),
+                get_lod_object_name(level));
+        }
+        else if (!have_same_material_slots(*base_object, *lod_object))
+        {
+            RENDERER_LOG_ERROR(
+                "%s: level of detail object \"%s\" does not have the same material slots as object \"%s\"; "
+                "using the full resolution object.",
+                context.get(),
+                get_lod_object_name(level),
+                impl->m_object_name.c_str());
+        }
+        else
+        {
+            object = lod_object;
+            selected_lod = level;
+        }
+    }
+
+    const bool changed = selected_lod != impl->m_selected_lod;
+
+    m_object = object;
+    impl->m_selected_lod = selected_lod;
+
+    return changed;
+}
+
+size_t ObjectInstance::get_selected_lod() const
+{
+    return impl->m_selected_lod;
+}
+
+size_t ObjectInstance::choose_curve_lod(const double segment_pixels) const
+{
+    // Merging more segments than this would visibly flatten curly strands.
+    const size_t MaxCurveLOD = 4;
+
+    size_t level = 0;
+
+    while (level < MaxCurveLOD &&
+           segment_pixels * (1 << level) < impl->m_curve_lod_segment_pixels)
+        ++level;
+
+    return level;
+}
+
+bool ObjectInstance::select_curve_lod(const size_t level)
+{
+    const bool changed = level != impl->m_curve_lod;
+
+    impl->m_curve_lod = level;
+
+    return changed;
+}
+
+size_t ObjectInstance::get_curve_lod() const
+{
+    return impl->m_curve_lod;
 }
 
 GAABB3 ObjectInstance::compute_parent_bbox() const
@@ -488,6 +660,32 @@ DictionaryArray ObjectInstanceFactory::get_input_metadata()
             .insert("use", "optional")
             .insert("default", "0.0"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "lod_objects")
+            .insert("label", "Level of Detail Objects")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("default", ""));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "lod_thresholds")
+            .insert("label", "Level of Detail Thresholds")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("default", ""));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "curve_lod_segment_pixels")
+            .insert("label", "Curve Level of Detail Segment Size")
+            .insert("type", "numeric")
+            .insert("min_value", "0.0")
+            .insert("max_value", "16.0")
+            .insert("use", "optional")
+            .insert("default", "1.0"));
+
     return metadata;
 }
 
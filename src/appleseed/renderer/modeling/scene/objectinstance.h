@@ -124,6 +124,33 @@ class APPLESEED_DLLSYMBOL ObjectInstance
     // Find the object bound to this instance.
     Object* find_object() const;
 
+    // Levels of detail. Level 0 is the instantiated object; levels 1 and above are
+    // the coarser objects listed in the "lod_objects" parameter. Level i (i > 0) is
+    // used when the instance covers fewer pixels than the i-th value of the
+    // "lod_thresholds" parameter.
+    size_t get_lod_count() const;
+    const char* get_lod_object_name(const size_t level) const;
+    size_t choose_lod(const double pixel_coverage) const;
+
+    // Bind the object of a given level of detail in place of the object bound by
+    // bind_object(). The selected level persists until the next call to this method.
+    // Return true if the selected level changed, false otherwise.
+    bool select_lod(const size_t level);
+
+    // Return the selected level of detail.
+    size_t get_selected_lod() const;
+
+    // Curve levels of detail. Level i merges runs of up to 2^i connected curve segments
+    // into one, and is used when the segments of the bound curve object would span fewer
+    // pixels than the "curve_lod_segment_pixels" parameter at level i - 1.
+    size_t choose_curve_lod(const double segment_pixels) const;
+
+    // Set the curve level of detail. Return true if it changed, false otherwise.
+    bool select_curve_lod(const size_t level);
+
+    // Return the selected curve level of detail.
+    size_t get_curve_lod() const;
+
     // Compute the parent space bounding box of the instance.
     GAABB3 compute_parent_bbox() const;
 
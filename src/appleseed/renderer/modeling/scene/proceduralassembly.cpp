@@ -26,14 +26,42 @@
 // THE SOFTWARE.
 //
 
+
 // Interface header.
 #include "proceduralassembly.h"
 
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/modeling/project/project.h"
+#include "renderer/modeling/project/projectfilereader.h"
+#include "renderer/modeling/project/projectfilewriter.h"
+#include "renderer/modeling/scene/containers.h"
+#include "renderer/modeling/scene/scene.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/api/apistring.h"
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/foreach.h"
+#include "foundation/utility/job/abortswitch.h"
+#include "foundation/utility/searchpaths.h"
+#include "foundation/utility/siphash.h"
+
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
 // Standard headers.
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <sstream>
 #include <string>
 
-// appleseed.renderer headers.
-#include "renderer/utility/paramarray.h"
+using namespace foundation;
+using namespace std;
+namespace bf = boost::filesystem;
 
 namespace renderer
 {
@@ -42,11 +70,214 @@ namespace renderer
 // ProceduralAssembly class implementation.
 //
 
+namespace
+{
+    const char* CacheEntryFileName = "contents.appleseed";
+
+    uint64 hash_string(const uint64 hash, const char* s)
+    {
+        return siphash24(hash, siphash24(s, strlen(s)));
+    }
+
+    uint64 hash_dictionary(uint64 hash, const Dictionary& dictionary)
+    {
+        // Dictionaries are sorted by key, so the hash does not depend on insertion order.
+        for (const_each<StringDictionary> i = dictionary.strings(); i; ++i)
+        {
+            hash = hash_string(hash, i->key());
+            hash = hash_string(hash, i->value());
+        }
+
+        for (const_each<DictionaryDictionary> i = dictionary.dictionaries(); i; ++i)
+        {
+            hash = hash_string(hash, i->key());
+            hash = hash_dictionary(hash, i->value());
+        }
+
+        return hash;
+    }
+
+    string make_cache_entry_name(const uint64 key)
+    {
+        stringstream sstr;
+        sstr << hex << setw(16) << setfill('0') << key;
+        return sstr.str();
+    }
+}
+
 ProceduralAssembly::ProceduralAssembly(
     const char*         name,
     const ParamArray&   params)
   : Assembly(name, params)
+  , m_expansion_key(0)
+{
+}
+
+const char* ProceduralAssembly::get_expansion_version() const
+{
+    return 0;
+}
+
+bool ProceduralAssembly::expand_contents_cached(
+    const Project&      project,
+    const Assembly*     parent,
+    IAbortSwitch*       abort_switch)
+{
+    const char* version = get_expansion_version();
+
+    // Retrieve the location of the on-disk expansion cache.
+    const string cache_directory =
+        project.get_scene()->get_parameters().get_optional<string>("procedural_assembly_cache_directory", "");
+
+    if (version == 0 || cache_directory.empty())
+        return expand_contents(project, parent, abort_switch);
+
+    const uint64 key = compute_expansion_key();
+
+    // The current contents were generated or loaded for the same parameters.
+    if (key == m_expansion_key)
+        return true;
+
+    const string cache_entry_path =
+        (bf::path(cache_directory) / make_cache_entry_name(key)).string();
+
+    if (load_expansion(project, cache_entry_path))
+    {
+        RENDERER_LOG_INFO(
+            "loaded contents of procedural assembly \"%s\" from %s.",
+            get_path().c_str(),
+            cache_entry_path.c_str());
+        m_expansion_key = key;
+        return true;
+    }
+
+    if (!expand_contents(project, parent, abort_switch))
+        return false;
+
+    if (is_aborted(abort_switch))
+        return true;
+
+    if (save_expansion(cache_entry_path))
+        m_expansion_key = key;
+
+    return true;
+}
+
+void ProceduralAssembly::swap_contents(Assembly& other)
+{
+    assemblies().swap(other.assemblies());
+    assembly_instances().swap(other.assembly_instances());
+    bsdfs().swap(other.bsdfs());
+    bssrdfs().swap(other.bssrdfs());
+    colors().swap(other.colors());
+    edfs().swap(other.edfs());
+    lights().swap(other.lights());
+    materials().swap(other.materials());
+    objects().swap(other.objects());
+    object_instances().swap(other.object_instances());
+    shader_groups().swap(other.shader_groups());
+    surface_shaders().swap(other.surface_shaders());
+    textures().swap(other.textures());
+    texture_instances().swap(other.texture_instances());
+}
+
+uint64 ProceduralAssembly::compute_expansion_key() const
+{
+    uint64 key = hash_string(0, get_model());
+    key = hash_string(key, get_expansion_version());
+    key = hash_dictionary(key, m_params);
+    return key;
+}
+
+bool ProceduralAssembly::load_expansion(
+    const Project&      project,
+    const string&       cache_entry_path)
+{
+    const bf::path filepath = bf::path(cache_entry_path) / CacheEntryFileName;
+
+    try
+    {
+        if (!bf::exists(filepath))
+            return false;
+    }
+    catch (const exception&)
+    {
+        return false;
+    }
+
+    // Geometry files are stored next to the cached project.
+    SearchPaths search_paths = project.search_paths();
+    search_paths.push_back(bf::absolute(cache_entry_path).string());
+
+    ProjectFileReader reader;
+    auto_release_ptr<Assembly> assembly =
+        reader.read_archive(
+            filepath.string().c_str(),
+            0,
+            search_paths,
+            ProjectFileReader::OmitProjectSchemaValidation);
+
+    if (assembly.get() == 0)
+        return false;
+
+    swap_contents(assembly.ref());
+    bump_version_id();
+
+    return true;
+}
+
+bool ProceduralAssembly::save_expansion(const string& cache_entry_path)
 {
+    try
+    {
+        bf::create_directories(cache_entry_path);
+    }
+    catch (const exception& e)
+    {
+        RENDERER_LOG_WARNING(
+            "failed to create procedural assembly cache directory %s: %s.",
+            cache_entry_path.c_str(),
+            e.what());
+        return false;
+    }
+
+    // Temporarily move the contents of this assembly into an archive project.
+    auto_release_ptr<Project> project(ProjectFactory::create("cache"));
+    project->set_scene(SceneFactory::create());
+    auto_release_ptr<Assembly> assembly(AssemblyFactory().create("assembly", ParamArray()));
+    Assembly& assembly_ref = assembly.ref();
+    swap_contents(assembly_ref);
+    project->get_scene()->assemblies().insert(assembly);
+
+    // Write the project under a temporary name so that incomplete entries are never loaded.
+    const bf::path filepath = bf::path(cache_entry_path) / CacheEntryFileName;
+    const bf::path temp_filepath = bf::path(cache_entry_path) / (string(CacheEntryFileName) + ".tmp");
+
+    bool success =
+        ProjectFileWriter::write(
+            project.ref(),
+            temp_filepath.string().c_str(),
+            ProjectFileWriter::OmitHeaderComment | ProjectFileWriter::OmitHandlingAssetFiles);
+
+    swap_contents(assembly_ref);
+
+    if (success)
+    {
+        try
+        {
+            bf::rename(temp_filepath, filepath);
+        }
+        catch (const exception& e)
+        {
+            RENDERER_LOG_WARNING(
+                "failed to store procedural assembly cache entry %s: %s.",
+                filepath.string().c_str(),
+                e.what());
+            success = false;
+        }
+    }
+
+    return success;
 }
 
 }   // namespace renderer
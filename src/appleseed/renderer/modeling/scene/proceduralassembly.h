@@ -35,13 +35,18 @@
 
 // appleseed.foundation headers.
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
 
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
+// Standard headers.
+#include <string>
+
 // Forward declarations.
 namespace foundation    { class IAbortSwitch; }
 namespace renderer      { class ParamArray; }
+namespace renderer      { class Project; }
 
 namespace renderer
 {
@@ -49,6 +54,12 @@ namespace renderer
 //
 // An assembly that generates its contents procedurally.
 //
+// If the scene defines a "procedural_assembly_cache_directory" parameter, the contents
+// of procedural assemblies that report an expansion version are stored on disk after
+// expansion (as an archive project with BinaryMesh geometry files), and are reloaded
+// instead of being generated again as long as that version and the parameters of the
+// assembly are unchanged.
+//
 
 class APPLESEED_DLLSYMBOL ProceduralAssembly
   : public Assembly
@@ -60,11 +71,37 @@ class APPLESEED_DLLSYMBOL ProceduralAssembly
         const Assembly*             parent,
         foundation::IAbortSwitch*   abort_switch = 0) = 0;
 
+    // Return a string identifying the version of the algorithm that generates the contents
+    // of the assembly, or 0 if the contents cannot be cached. Return a new string whenever
+    // the generated contents change for identical parameters.
+    virtual const char* get_expansion_version() const;
+
+    // Expand the contents of the assembly, or reload them from the expansion cache.
+    bool expand_contents_cached(
+        const Project&              project,
+        const Assembly*             parent,
+        foundation::IAbortSwitch*   abort_switch = 0);
+
   protected:
     // Constructor.
     ProceduralAssembly(
         const char*                 name,
         const ParamArray&           params);
+
+    // Swap the contents of this assembly with the ones of another assembly.
+    void swap_contents(Assembly& other);
+
+  private:
+    foundation::uint64              m_expansion_key;    // key of the current contents, 0 if unknown
+
+    foundation::uint64 compute_expansion_key() const;
+
+    bool load_expansion(
+        const Project&              project,
+        const std::string&          cache_entry_path);
+
+    bool save_expansion(
+        const std::string&          cache_entry_path);
 };
 
 }       // namespace renderer
@@ -37,6 +37,7 @@
 #include "renderer/modeling/frame/frame.h"
 #include "renderer/modeling/object/object.h"
 #include "renderer/modeling/project/project.h"
+#include "renderer/modeling/scene/archiveassembly.h"
 #include "renderer/modeling/scene/assembly.h"
 #include "renderer/modeling/scene/assemblyinstance.h"
 #include "renderer/modeling/scene/objectinstance.h"
@@ -299,7 +300,7 @@ namespace
 
         if (proc_assembly)
         {
-            if (!proc_assembly->expand_contents(project, parent, abort_switch))
+            if (!proc_assembly->expand_contents_cached(project, parent, abort_switch))
                 return false;
         }
 
@@ -326,6 +327,31 @@ bool Scene::expand_procedural_assemblies(
     return true;
 }
 
+namespace
+{
+    bool has_pending_archive_expansions(const AssemblyContainer& assemblies)
+    {
+        for (const_each<AssemblyContainer> i = assemblies; i; ++i)
+        {
+            const ArchiveAssembly* archive_assembly =
+                dynamic_cast<const ArchiveAssembly*>(&*i);
+
+            if (archive_assembly && archive_assembly->is_expansion_pending())
+                return true;
+
+            if (has_pending_archive_expansions(i->assemblies()))
+                return true;
+        }
+
+        return false;
+    }
+}
+
+bool Scene::has_pending_archive_expansions() const
+{
+    return renderer::has_pending_archive_expansions(assemblies());
+}
+
 namespace
 {
     template <typename EntityCollection>
@@ -122,6 +122,9 @@ class APPLESEED_DLLSYMBOL Scene
         const Project&              project,
         foundation::IAbortSwitch*   abort_switch = 0);
 
+    // Return true if rays entered deferred archive assemblies that are not loaded yet.
+    bool has_pending_archive_expansions() const;
+
     // This method is called once before rendering each frame.
     // Returns true on success, false otherwise.
     virtual bool on_frame_begin(
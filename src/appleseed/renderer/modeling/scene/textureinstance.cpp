@@ -108,10 +108,12 @@ TextureInstance::TextureInstance(
 
     // Retrieve the texture filtering mode.
     const string filtering_mode =
-        m_params.get_optional<string>("filtering_mode", "bilinear", make_vector("nearest", "bilinear"), message_context);
+        m_params.get_optional<string>("filtering_mode", "bilinear", make_vector("nearest", "bilinear", "trilinear"), message_context);
     if (filtering_mode == "nearest")
         m_filtering_mode = TextureFilteringNearest;
-    else m_filtering_mode = TextureFilteringBilinear;
+    else if (filtering_mode == "bilinear")
+        m_filtering_mode = TextureFilteringBilinear;
+    else m_filtering_mode = TextureFilteringTrilinear;
 
     // Retrieve the texture alpha mode.
     const string alpha_mode =
@@ -281,7 +283,8 @@ DictionaryArray TextureInstanceFactory::get_input_metadata()
             .insert("items",
                 Dictionary()
                     .insert("Nearest", "nearest")
-                    .insert("Bilinear", "bilinear"))
+                    .insert("Bilinear", "bilinear")
+                    .insert("Trilinear", "trilinear"))
             .insert("use", "optional")
             .insert("default", "bilinear"));
 
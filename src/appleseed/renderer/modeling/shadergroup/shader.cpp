@@ -40,12 +40,22 @@
 #include "foundation/utility/string.h"
 #include "foundation/utility/uid.h"
 
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
+
 // Standard headers.
 #include <cassert>
+#include <map>
+#include <set>
 #include <string>
+#include <vector>
 
 using namespace foundation;
 using namespace std;
+namespace bf = boost::filesystem;
 
 namespace renderer
 {
@@ -57,6 +67,107 @@ namespace renderer
 namespace
 {
     const UniqueID g_class_uid = new_guid();
+
+    //
+    // An application-wide index of the compiled shaders found in the shader search paths.
+    //
+    // Locating a shader by probing every search path for its .oso file costs one file
+    // system query per search path, which is slow on network shares. Instead, each
+    // directory of the search paths is listed once, the first time a shader is looked
+    // up in it, and later lookups are answered from the cached listing.
+    //
+
+    class CompiledShaderIndex
+    {
+      public:
+        // Return the path to the .oso file of a given shader, or an empty string if the
+        // shader could not be found in the index. Thread-safe.
+        string find(const string& search_path, const string& shader_name)
+        {
+            // Let OSL handle shaders given by path.
+            if (shader_name.empty() || shader_name.find_first_of("/\\") != string::npos)
+                return string();
+
+            const string filename =
+                normalize(ends_with(shader_name, ".oso") ? shader_name : shader_name + ".oso");
+
+            vector<string> directories;
+            split_search_path(search_path, directories);
+
+            boost::lock_guard<boost::mutex> lock(m_mutex);
+
+            for (const_each<vector<string> > i = directories; i; ++i)
+            {
+                const set<string>& listing = get_listing(*i);
+
+                if (listing.find(filename) != listing.end())
+                    return (bf::path(*i) / filename).string();
+            }
+
+            return string();
+        }
+
+      private:
+        typedef map<string, set<string> > ListingMap;
+
+        boost::mutex    m_mutex;
+        ListingMap      m_listings;
+
+        static string normalize(const string& name)
+        {
+#if defined _WIN32 || defined __APPLE__
+            // These file systems are case-insensitive by default.
+            return lower_case(name);
+#else
+            return name;
+#endif
+        }
+
+        // Split a search path string the way OSL does.
+        static void split_search_path(const string& search_path, vector<string>& directories)
+        {
+            vector<string> tokens;
+            tokenize(search_path, ":;", tokens);
+
+            for (size_t i = 0; i < tokens.size(); ++i)
+            {
+#ifdef _WIN32
+                // Don't split drive letters from the rest of the path.
+                if (tokens[i].size() == 1 && i + 1 < tokens.size())
+                {
+                    directories.push_back(tokens[i] + ":" + tokens[i + 1]);
+                    ++i;
+                    continue;
+                }
+#endif
+                directories.push_back(tokens[i]);
+            }
+        }
+
+        const set<string>& get_listing(const string& directory)
+        {
+            ListingMap::iterator it = m_listings.find(directory);
+
+            if (it == m_listings.end())
+            {
+                it = m_listings.insert(make_pair(directory, set<string>())).first;
+
+                // Directories that don't exist or can't be read have no entries.
+                boost::system::error_code ec;
+                bf::directory_iterator i(directory, ec), e;
+
+                while (!ec && i != e)
+                {
+                    it->second.insert(normalize(i->path().filename().string()));
+                    i.increment(ec);
+                }
+            }
+
+            return it->second;
+        }
+    };
+
+    CompiledShaderIndex g_compiled_shader_index;
 }
 
 struct Shader::Impl
@@ -269,7 +380,15 @@ bool Shader::add(OSL::ShadingSystem& shading_system)
             return false;
     }
 
-    if (!shading_system.Shader("surface", get_shader(), get_layer()))
+    // Resolve the shader on demand from the cached index, falling back to OSL's own
+    // search for shaders that are not indexed (e.g. compiled after the directory was listed).
+    string search_path;
+    shading_system.getattribute("searchpath:shader", search_path);
+    string shader_path = g_compiled_shader_index.find(search_path, get_shader());
+    if (shader_path.empty())
+        shader_path = get_shader();
+
+    if (!shading_system.Shader("surface", shader_path.c_str(), get_layer()))
     {
         RENDERER_LOG_ERROR("error adding shader %s, %s.", get_shader(), get_layer());
         return false;
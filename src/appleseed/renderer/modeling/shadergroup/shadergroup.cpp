@@ -40,14 +40,23 @@
 #include "foundation/utility/api/apistring.h"
 #include "foundation/utility/foreach.h"
 #include "foundation/utility/job/abortswitch.h"
+#include "foundation/utility/stopwatch.h"
+#include "foundation/utility/string.h"
 #include "foundation/utility/uid.h"
 
 // Boost headers
+#include "boost/bind.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
 #include "boost/unordered/unordered_map.hpp"
 
 // Standard headers.
+#include <algorithm>
 #include <exception>
+#include <sstream>
+#include <string>
 #include <utility>
+#include <vector>
 
 using namespace foundation;
 using namespace std;
@@ -69,6 +78,32 @@ namespace
     const OIIO::ustring g_holdout_str("holdout");
     const OIIO::ustring g_debug_str("debug");
     const OIIO::ustring g_dPdtime_str("dPdtime");
+
+    // Serialize the shaders, parameters and connections of a shader group, as well as
+    // the OSL version, into a string that identifies its optimized OSL shader group.
+    string compute_signature(const ShaderGroup& shader_group)
+    {
+        stringstream ss;
+
+        ss << OSL_LIBRARY_VERSION_CODE << "\n";
+
+        for (const_each<ShaderContainer> i = shader_group.shaders(); i; ++i)
+        {
+            ss << "shader " << i->get_type() << " " << i->get_shader() << " " << i->get_layer() << "\n";
+
+            for (const_each<ShaderParamContainer> j = i->shader_params(); j; ++j)
+                ss << "param " << j->get_name() << " " << j->get_value_as_string() << "\n";
+        }
+
+        for (const_each<ShaderConnectionContainer> i = shader_group.shader_connections(); i; ++i)
+        {
+            ss << "connect "
+               << i->get_src_layer() << " " << i->get_src_param() << " "
+               << i->get_dst_layer() << " " << i->get_dst_param() << "\n";
+        }
+
+        return ss.str();
+    }
 }
 
 struct ShaderGroup::Impl
@@ -82,6 +117,7 @@ struct ShaderGroup::Impl
     mutable SurfaceAreaMap      m_surface_areas;
     const OSL::ShaderSymbol*    m_surface_shader_color_sym;
     const OSL::ShaderSymbol*    m_surface_shader_alpha_sym;
+    double                      m_optimization_time;        // in seconds
 };
 
 ShaderGroup::ShaderGroup(const char* name)
@@ -115,6 +151,7 @@ void ShaderGroup::clear()
     m_flags = 0;
     impl->m_surface_shader_color_sym = 0;
     impl->m_surface_shader_alpha_sym = 0;
+    impl->m_optimization_time = 0.0;
 }
 
 void ShaderGroup::add_shader(
@@ -159,12 +196,70 @@ void ShaderGroup::add_connection(
 }
 
 bool ShaderGroup::create_optimized_osl_shader_group(
+    OSL::ShadingSystem& shading_system,
+    IAbortSwitch*       abort_switch,
+    ShaderGroupCache*   cache)
+{
+    if (!is_valid() && cache)
+    {
+        const ShaderGroup* source = cache->lookup(*this);
+
+        if (source)
+        {
+            RENDERER_LOG_DEBUG(
+                "shader group \"%s\" is identical to \"%s\", reusing its optimized osl shader group.",
+                get_path().c_str(),
+                source->get_path().c_str());
+
+            cache->record_sharing(*this, *source);
+            return true;
+        }
+    }
+
+    bool needs_optimization = false;
+
+    if (!is_valid())
+    {
+        Stopwatch<DefaultWallclockTimer> stopwatch;
+        stopwatch.start();
+
+        if (cache)
+        {
+            // Only declare the shader group, the cache optimizes it later in parallel with others.
+            if (!declare_osl_shader_group(shading_system, abort_switch))
+                return false;
+
+            needs_optimization = true;
+        }
+        else if (!do_create_optimized_osl_shader_group(shading_system, abort_switch))
+            return false;
+
+        stopwatch.measure();
+        impl->m_optimization_time = stopwatch.get_seconds();
+    }
+
+    // Shader groups left unfinished by an abort are not cached.
+    if (is_valid() && cache)
+        cache->insert(*this, needs_optimization);
+
+    return true;
+}
+
+bool ShaderGroup::do_create_optimized_osl_shader_group(
     OSL::ShadingSystem& shading_system,
     IAbortSwitch*       abort_switch)
 {
-    if (is_valid())
-        return true;
+    if (!declare_osl_shader_group(shading_system, abort_switch))
+        return false;
 
+    // Shader groups left unfinished by an abort are not optimized.
+    return is_valid() ? optimize_osl_shader_group(shading_system) : true;
+}
+
+bool ShaderGroup::declare_osl_shader_group(
+    OSL::ShadingSystem& shading_system,
+    IAbortSwitch*       abort_switch)
+{
     RENDERER_LOG_DEBUG("setting up shader group \"%s\"...", get_path().c_str());
 
     try
@@ -209,6 +304,21 @@ bool ShaderGroup::create_optimized_osl_shader_group(
 
         impl->m_shader_group_ref = shader_group_ref;
 
+        return true;
+    }
+    catch (const exception& e)
+    {
+        RENDERER_LOG_ERROR("failed to setup shader group \"%s\": %s.", get_path().c_str(), e.what());
+        return false;
+    }
+}
+
+bool ShaderGroup::optimize_osl_shader_group(OSL::ShadingSystem& shading_system)
+{
+    assert(is_valid());
+
+    try
+    {
         // Set the shadergroup outputs and get symbols if needed.
         for (each<ShaderContainer> i = impl->m_shaders; i; ++i)
         {
@@ -227,6 +337,7 @@ bool ShaderGroup::create_optimized_osl_shader_group(
                         OIIO::TypeDesc(OIIO::TypeDesc::STRING, 2),
                         &renderer_outputs[0]))
                 {
+                    // Contexts are per-thread; release it since optimization threads are short-lived.
                     OSL::ShadingContext *ctx = shading_system.get_context();
                     OSL::ShaderGlobals sg;
                     memset(&sg, 0, sizeof(OSL::ShaderGlobals));
@@ -251,6 +362,8 @@ bool ShaderGroup::create_optimized_osl_shader_group(
                                 *impl->m_shader_group_ref,
                                 OIIO::ustring("Aout"));
                     }
+
+                    shading_system.release_context(ctx);
                 }
                 break;
             }
@@ -281,6 +394,17 @@ void ShaderGroup::release_optimized_osl_shader_group()
     impl->m_shader_group_ref.reset();
 }
 
+void ShaderGroup::share_optimized_osl_shader_group(const ShaderGroup& source)
+{
+    assert(source.is_valid());
+
+    impl->m_shader_group_ref = source.impl->m_shader_group_ref;
+    impl->m_surface_shader_color_sym = source.impl->m_surface_shader_color_sym;
+    impl->m_surface_shader_alpha_sym = source.impl->m_surface_shader_alpha_sym;
+    impl->m_optimization_time = source.impl->m_optimization_time;
+    m_flags = source.m_flags;
+}
+
 const ShaderContainer& ShaderGroup::shaders() const
 {
     return impl->m_shaders;
@@ -496,6 +620,211 @@ void ShaderGroup::set_surface_area(
 }
 
 
+//
+// ShaderGroupCache class implementation.
+//
+
+struct ShaderGroupCache::Impl
+{
+    typedef boost::unordered_map<string, const ShaderGroup*> ShaderGroupMap;
+    typedef pair<ShaderGroup*, const ShaderGroup*> Sharing;
+
+    ShaderGroupMap              m_shader_groups;
+    size_t                      m_shared_group_count;
+    double                      m_saved_time;
+
+    // Shader groups declared but not yet optimized, and their optimization status.
+    vector<ShaderGroup*>        m_scheduled_groups;
+    vector<char>                m_optimized;
+
+    // Shader groups waiting for the optimized OSL shader group of another shader group.
+    vector<Sharing>             m_sharings;
+
+    // Optimized shader groups, for reporting.
+    vector<const ShaderGroup*>  m_optimized_groups;
+
+    // State shared by optimization threads.
+    boost::mutex                m_mutex;
+    size_t                      m_next_index;
+    bool                        m_success;
+};
+
+ShaderGroupCache::ShaderGroupCache()
+  : impl(new Impl())
+{
+    impl->m_shared_group_count = 0;
+    impl->m_saved_time = 0.0;
+}
+
+ShaderGroupCache::~ShaderGroupCache()
+{
+    delete impl;
+}
+
+size_t ShaderGroupCache::get_shared_group_count() const
+{
+    return impl->m_shared_group_count;
+}
+
+double ShaderGroupCache::get_saved_time() const
+{
+    return impl->m_saved_time;
+}
+
+const ShaderGroup* ShaderGroupCache::lookup(const ShaderGroup& shader_group) const
+{
+    const Impl::ShaderGroupMap::const_iterator i =
+        impl->m_shader_groups.find(compute_signature(shader_group));
+
+    return i != impl->m_shader_groups.end() ? i->second : 0;
+}
+
+bool ShaderGroupCache::optimize_shader_groups(
+    OSL::ShadingSystem&         shading_system,
+    const size_t                thread_count,
+    IAbortSwitch*               abort_switch)
+{
+    const size_t group_count = impl->m_scheduled_groups.size();
+
+    impl->m_optimized.assign(group_count, 0);
+    impl->m_next_index = 0;
+    impl->m_success = true;
+
+    if (group_count > 0)
+    {
+        RENDERER_LOG_INFO(
+            "optimizing %s osl shader group%s...",
+            pretty_uint(group_count).c_str(),
+            group_count > 1 ? "s" : "");
+    }
+
+    const size_t worker_count = min(thread_count, group_count);
+    if (worker_count > 1)
+    {
+        boost::thread_group threads;
+        for (size_t i = 0; i < worker_count; ++i)
+        {
+            threads.create_thread(
+                boost::bind(
+                    &ShaderGroupCache::optimize_scheduled_shader_groups,
+                    this,
+                    boost::ref(shading_system),
+                    abort_switch));
+        }
+        threads.join_all();
+    }
+    else optimize_scheduled_shader_groups(shading_system, abort_switch);
+
+    // Shader groups left unoptimized by an abort must be recreated by the next rendering session.
+    for (size_t i = 0; i < group_count; ++i)
+    {
+        if (impl->m_optimized[i])
+            impl->m_optimized_groups.push_back(impl->m_scheduled_groups[i]);
+        else impl->m_scheduled_groups[i]->release_optimized_osl_shader_group();
+    }
+
+    impl->m_scheduled_groups.clear();
+    impl->m_optimized.clear();
+
+    // Let identical shader groups share the optimized OSL shader groups.
+    for (size_t i = 0, e = impl->m_sharings.size(); i < e; ++i)
+    {
+        ShaderGroup& shader_group = *impl->m_sharings[i].first;
+        const ShaderGroup& source = *impl->m_sharings[i].second;
+
+        if (source.is_valid())
+        {
+            shader_group.share_optimized_osl_shader_group(source);
+            ++impl->m_shared_group_count;
+            impl->m_saved_time += source.impl->m_optimization_time;
+        }
+    }
+
+    impl->m_sharings.clear();
+
+    return impl->m_success;
+}
+
+void ShaderGroupCache::report_optimization_times(const size_t max_count) const
+{
+    typedef pair<double, const ShaderGroup*> TimedShaderGroup;
+
+    vector<TimedShaderGroup> shader_groups;
+    shader_groups.reserve(impl->m_optimized_groups.size());
+
+    for (size_t i = 0, e = impl->m_optimized_groups.size(); i < e; ++i)
+    {
+        const ShaderGroup* shader_group = impl->m_optimized_groups[i];
+        shader_groups.push_back(TimedShaderGroup(shader_group->impl->m_optimization_time, shader_group));
+    }
+
+    // Slowest shader groups first.
+    sort(shader_groups.rbegin(), shader_groups.rend());
+
+    for (size_t i = 0, e = shader_groups.size(); i < e; ++i)
+    {
+        const string path = shader_groups[i].second->get_path().c_str();
+        const string time = pretty_time(shader_groups[i].first);
+
+        if (i < max_count)
+            RENDERER_LOG_INFO("osl shader group \"%s\" took %s to set up.", path.c_str(), time.c_str());
+        else RENDERER_LOG_DEBUG("osl shader group \"%s\" took %s to set up.", path.c_str(), time.c_str());
+    }
+}
+
+void ShaderGroupCache::insert(ShaderGroup& shader_group, const bool needs_optimization)
+{
+    assert(shader_group.is_valid());
+
+    impl->m_shader_groups.insert(
+        make_pair(compute_signature(shader_group), &shader_group));
+
+    if (needs_optimization)
+        impl->m_scheduled_groups.push_back(&shader_group);
+}
+
+void ShaderGroupCache::record_sharing(ShaderGroup& shader_group, const ShaderGroup& source)
+{
+    impl->m_sharings.push_back(Impl::Sharing(&shader_group, &source));
+}
+
+void ShaderGroupCache::optimize_scheduled_shader_groups(
+    OSL::ShadingSystem&         shading_system,
+    IAbortSwitch*               abort_switch)
+{
+    while (true)
+    {
+        size_t index;
+
+        {
+            boost::mutex::scoped_lock lock(impl->m_mutex);
+            index = impl->m_next_index++;
+        }
+
+        if (index >= impl->m_scheduled_groups.size() || is_aborted(abort_switch))
+            break;
+
+        ShaderGroup& shader_group = *impl->m_scheduled_groups[index];
+
+        Stopwatch<DefaultWallclockTimer> stopwatch;
+        stopwatch.start();
+
+        const bool success = shader_group.optimize_osl_shader_group(shading_system);
+
+        stopwatch.measure();
+        shader_group.impl->m_optimization_time += stopwatch.get_seconds();
+
+        impl->m_optimized[index] = 1;
+
+        if (!success)
+        {
+            boost::mutex::scoped_lock lock(impl->m_mutex);
+            impl->m_success = false;
+        }
+    }
+}
+
+
 //
 // ShaderGroupFactory class implementation.
 //
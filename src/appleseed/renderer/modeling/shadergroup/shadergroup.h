@@ -34,10 +34,14 @@
 #include "renderer/modeling/scene/containers.h"
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/platform/types.h"
 #include "foundation/utility/autoreleaseptr.h"
 
+// Standard headers.
+#include <cstddef>
+
 // appleseed.main headers.
 #include "main/dllsymbol.h"
 
@@ -52,6 +56,7 @@ namespace foundation    { class IAbortSwitch; }
 namespace renderer      { class AssemblyInstance; }
 namespace renderer      { class ParamArray; }
 namespace renderer      { class ObjectInstance; }
+namespace renderer      { class ShaderGroupCache; }
 
 namespace renderer
 {
@@ -87,10 +92,13 @@ class APPLESEED_DLLSYMBOL ShaderGroup
         const char*                 dst_layer,
         const char*                 dst_param);
 
-    // Create OSL shader group.
+    // Create OSL shader group. If 'cache' is not null, the OSL shader group is only declared
+    // and ShaderGroupCache::optimize_shader_groups() must be called to optimize it; shader
+    // groups identical to one already in the cache then reuse its optimized OSL shader group.
     bool create_optimized_osl_shader_group(
         OSL::ShadingSystem&         shading_system,
-        foundation::IAbortSwitch*   abort_switch = 0);
+        foundation::IAbortSwitch*   abort_switch = 0,
+        ShaderGroupCache*           cache = 0);
 
     // Release internal OSL shader group.
     void release_optimized_osl_shader_group();
@@ -138,6 +146,7 @@ class APPLESEED_DLLSYMBOL ShaderGroup
 
   private:
     friend class LightSampler;
+    friend class ShaderGroupCache;
     friend class ShaderGroupFactory;
 
     struct Impl;
@@ -172,6 +181,21 @@ class APPLESEED_DLLSYMBOL ShaderGroup
     // Destructor.
     ~ShaderGroup();
 
+    bool do_create_optimized_osl_shader_group(
+        OSL::ShadingSystem&         shading_system,
+        foundation::IAbortSwitch*   abort_switch);
+
+    // Declare the shaders and connections of the OSL shader group. Must not run concurrently.
+    bool declare_osl_shader_group(
+        OSL::ShadingSystem&         shading_system,
+        foundation::IAbortSwitch*   abort_switch);
+
+    // Optimize a declared OSL shader group and query its closures and globals.
+    // Distinct shader groups can be optimized concurrently.
+    bool optimize_osl_shader_group(OSL::ShadingSystem& shading_system);
+
+    void share_optimized_osl_shader_group(const ShaderGroup& source);
+
     void get_shadergroup_closures_info(OSL::ShadingSystem& shading_system);
     void report_has_closure(const char* closure_name, const Flags flag) const;
 
@@ -185,6 +209,60 @@ class APPLESEED_DLLSYMBOL ShaderGroup
 };
 
 
+//
+// Optimized shader groups indexed by their shaders, parameters and connections.
+// Shader groups with identical contents share the same optimized OSL shader group.
+//
+
+class APPLESEED_DLLSYMBOL ShaderGroupCache
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    ShaderGroupCache();
+
+    // Destructor.
+    ~ShaderGroupCache();
+
+    // Return the number of shader groups that reused an optimized OSL shader group.
+    size_t get_shared_group_count() const;
+
+    // Return the time, in seconds, that creating the shared OSL shader groups took originally.
+    double get_saved_time() const;
+
+    // Optimize the OSL shader groups declared through this cache using a given number of
+    // threads, then let identical shader groups share them. Returns false on failure.
+    bool optimize_shader_groups(
+        OSL::ShadingSystem&         shading_system,
+        const size_t                thread_count,
+        foundation::IAbortSwitch*   abort_switch = 0);
+
+    // Log the time it took to create each optimized shader group, slowest first.
+    // The 'max_count' slowest ones are logged as info messages, all of them as debug messages.
+    void report_optimization_times(const size_t max_count) const;
+
+  private:
+    friend class ShaderGroup;
+
+    struct Impl;
+    Impl* impl;
+
+    // Return a shader group identical to 'shader_group', or 0 if there is none.
+    const ShaderGroup* lookup(const ShaderGroup& shader_group) const;
+
+    // Insert a shader group into the cache, and schedule its optimization if required.
+    void insert(ShaderGroup& shader_group, const bool needs_optimization);
+
+    // Record that a shader group will share the optimized OSL shader group of 'source'.
+    void record_sharing(ShaderGroup& shader_group, const ShaderGroup& source);
+
+    // Optimize scheduled shader groups until none is left; run by each optimization thread.
+    void optimize_scheduled_shader_groups(
+        OSL::ShadingSystem&         shading_system,
+        foundation::IAbortSwitch*   abort_switch);
+};
+
+
 //
 // ShaderGroup factory.
 //
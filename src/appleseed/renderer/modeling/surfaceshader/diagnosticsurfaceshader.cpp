@@ -379,7 +379,7 @@ void DiagnosticSurfaceShader::evaluate(
             }
             else
             {
-                assert(shading_point.is_curve_primitive());
+                assert(shading_point.is_curve_primitive() || shading_point.is_particle_primitive());
 
                 // todo: implement.
             }
@@ -420,7 +420,7 @@ void DiagnosticSurfaceShader::evaluate(
             }
             else
             {
-                assert(shading_point.is_curve_primitive());
+                assert(shading_point.is_curve_primitive() || shading_point.is_particle_primitive());
 
                 // todo: implement.
             }
@@ -157,7 +157,7 @@ namespace
             InputValues values;
             m_inputs.evaluate(
                 shading_context.get_texture_cache(),
-                shading_point.get_uv(0),
+                shading_point,
                 &values);
 
             Spectrum radiance(Spectrum::Illuminance);
@@ -41,18 +41,29 @@
 #include "foundation/image/colorspace.h"
 #include "foundation/image/genericprogressiveimagefilereader.h"
 #include "foundation/image/tile.h"
+#include "foundation/image/tilecachefile.h"
 #include "foundation/platform/thread.h"
 #include "foundation/utility/api/specializedapiarrays.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/makevector.h"
 #include "foundation/utility/searchpaths.h"
+#include "foundation/utility/siphash.h"
+
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
 
 // Standard headers.
 #include <cstddef>
+#include <ctime>
+#include <exception>
+#include <iomanip>
+#include <sstream>
 #include <string>
 
 using namespace foundation;
 using namespace std;
+namespace bf = boost::filesystem;
 
 namespace renderer
 {
@@ -93,6 +104,9 @@ namespace
             else if (color_space == "srgb")
                 m_color_space = ColorSpaceSRGB;
             else m_color_space = ColorSpaceCIEXYZ;
+
+            // Retrieve the directory where decoded tiles are cached, if any.
+            m_tile_cache_directory = m_params.get_optional<string>("tile_cache_directory", "");
         }
 
         virtual void release() APPLESEED_OVERRIDE
@@ -142,6 +156,12 @@ namespace
         {
             boost::mutex::scoped_lock lock(m_mutex);
             open_image_file();
+
+            // Tiles are modified in place when converted to linear RGB: only linear RGB
+            // tiles can use the pixels of the memory mapping directly.
+            if (m_tile_cache_file.is_open())
+                return m_tile_cache_file.read_tile(tile_x, tile_y, m_color_space != ColorSpaceLinearRGB);
+
             return m_reader.read_tile(tile_x, tile_y);
         }
 
@@ -156,21 +176,80 @@ namespace
       private:
         string                              m_filepath;
         ColorSpace                          m_color_space;
+        string                              m_tile_cache_directory;
 
         mutable boost::mutex                m_mutex;
         GenericProgressiveImageFileReader   m_reader;
+        TileCacheFile                       m_tile_cache_file;      // stays open until the texture is destroyed
         CanvasProperties                    m_props;
 
         void open_image_file()
         {
-            if (!m_reader.is_open())
+            if (m_reader.is_open() || m_tile_cache_file.is_open())
+                return;
+
+            if (!m_tile_cache_directory.empty() && open_tile_cache_file())
+            {
+                m_props = m_tile_cache_file.properties();
+                return;
+            }
+
+            RENDERER_LOG_INFO(
+                "opening texture file %s and reading metadata...",
+                m_filepath.c_str());
+
+            m_reader.open(m_filepath.c_str());
+            m_reader.read_canvas_properties(m_props);
+        }
+
+        bool open_tile_cache_file()
+        {
+            try
             {
+                // The cache file is named after the texture file, and stamped with its size
+                // and modification time such that it gets rebuilt when the texture changes.
+                const uint64 source_stamp =
+                    siphash24(
+                        static_cast<uint64>(bf::file_size(m_filepath)),
+                        static_cast<uint64>(bf::last_write_time(m_filepath)));
+
+                stringstream sstr;
+                sstr << hex << setw(16) << setfill('0') << siphash24(m_filepath.c_str(), m_filepath.size()) << ".tiles";
+                const string cache_filepath = (bf::path(m_tile_cache_directory) / sstr.str()).string();
+
+                if (m_tile_cache_file.open(cache_filepath.c_str(), source_stamp))
+                {
+                    RENDERER_LOG_INFO(
+                        "using tile cache file %s for texture file %s.",
+                        cache_filepath.c_str(),
+                        m_filepath.c_str());
+                    return true;
+                }
+
                 RENDERER_LOG_INFO(
-                    "opening texture file %s and reading metadata...",
+                    "writing tile cache file %s for texture file %s...",
+                    cache_filepath.c_str(),
                     m_filepath.c_str());
 
+                bf::create_directories(m_tile_cache_directory);
+
                 m_reader.open(m_filepath.c_str());
-                m_reader.read_canvas_properties(m_props);
+                TileCacheFile::write(cache_filepath.c_str(), m_reader, source_stamp);
+                m_reader.close();
+
+                return m_tile_cache_file.open(cache_filepath.c_str(), source_stamp);
+            }
+            catch (const exception& e)
+            {
+                RENDERER_LOG_WARNING(
+                    "failed to use a tile cache file for texture file %s: %s.",
+                    m_filepath.c_str(),
+                    e.what());
+
+                if (m_reader.is_open())
+                    m_reader.close();
+
+                return false;
             }
         }
     };
@@ -221,6 +300,14 @@ DictionaryArray DiskTexture2dFactory::get_input_metadata() const
             .insert("use", "required")
             .insert("default", "srgb"));
 
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "tile_cache_directory")
+            .insert("label", "Tile Cache Directory")
+            .insert("type", "text")
+            .insert("use", "optional")
+            .insert("default", ""));
+
     return metadata;
 }
 
@@ -57,4 +57,9 @@ Texture::Texture(
     set_name(name);
 }
 
+Vector2u Texture::get_uv_tile_count()
+{
+    return Vector2u(1, 1);
+}
+
 }   // namespace renderer
@@ -35,6 +35,7 @@
 
 // appleseed.foundation headers.
 #include "foundation/image/colorspace.h"
+#include "foundation/math/vector.h"
 #include "foundation/utility/uid.h"
 
 // appleseed.main headers.
@@ -76,6 +77,11 @@ class APPLESEED_DLLSYMBOL Texture
     // Access canvas properties.
     virtual const foundation::CanvasProperties& properties() = 0;
 
+    // Return the number of unit squares of UV space covered by the canvas, in each
+    // direction: the canvas spans [0, n.x) x [0, n.y) in UV space. The default
+    // implementation returns (1, 1).
+    virtual foundation::Vector2u get_uv_tile_count();
+
     // Load a given tile.
     virtual foundation::Tile* load_tile(
         const size_t                tile_x,
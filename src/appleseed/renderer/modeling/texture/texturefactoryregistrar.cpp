@@ -34,6 +34,7 @@
 #include "renderer/modeling/texture/disktexture2d.h"
 #include "renderer/modeling/texture/itexturefactory.h"
 #include "renderer/modeling/texture/memorytexture2d.h"
+#include "renderer/modeling/texture/udimtexture2d.h"
 
 // appleseed.foundation headers.
 #include "foundation/utility/foreach.h"
@@ -61,6 +62,7 @@ TextureFactoryRegistrar::TextureFactoryRegistrar()
 {
     register_factory(auto_ptr<FactoryType>(new DiskTexture2dFactory()));
     register_factory(auto_ptr<FactoryType>(new MemoryTexture2dFactory()));
+    register_factory(auto_ptr<FactoryType>(new UDIMTexture2dFactory()));
 }
 
 TextureFactoryRegistrar::~TextureFactoryRegistrar()
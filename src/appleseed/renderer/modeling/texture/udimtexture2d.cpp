@@ -0,0 +1,521 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+// Interface header.
+#include "udimtexture2d.h"
+
+// appleseed.renderer headers.
+#include "renderer/global/globallogger.h"
+#include "renderer/modeling/texture/texture.h"
+#include "renderer/utility/messagecontext.h"
+#include "renderer/utility/paramarray.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/canvasproperties.h"
+#include "foundation/image/colorspace.h"
+#include "foundation/image/genericprogressiveimagefilereader.h"
+#include "foundation/image/tile.h"
+#include "foundation/platform/thread.h"
+#include "foundation/utility/api/apistring.h"
+#include "foundation/utility/api/specializedapiarrays.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/makevector.h"
+#include "foundation/utility/searchpaths.h"
+#include "foundation/utility/string.h"
+
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
+// Standard headers.
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <list>
+#include <map>
+#include <string>
+
+using namespace foundation;
+using namespace std;
+namespace bf = boost::filesystem;
+
+namespace renderer
+{
+
+namespace
+{
+    //
+    // UDIM texture set.
+    //
+    // The UDIM tiles are laid out side by side on a virtual canvas of 10 columns,
+    // (u, v) = (0, 0) being the bottom left one. Image files are opened on first
+    // access to one of their tiles, and the least recently used files are closed
+    // to honor a budget of open files. All image files must share the same canvas
+    // properties, and their dimensions must be multiples of their tile dimensions.
+    //
+
+    const char* Model = "udim_texture_2d";
+
+    const char* UDIMToken = "<UDIM>";
+    const size_t UDIMColumnCount = 10;
+    const size_t UDIMFirstIndex = 1001;
+
+    class UDIMTexture2d
+      : public Texture
+    {
+      public:
+        UDIMTexture2d(
+            const char*         name,
+            const ParamArray&   params,
+            const SearchPaths&  search_paths)
+          : Texture(name, params)
+          , m_initialized(false)
+          , m_row_count(0)
+          , m_tile_count_x(0)
+          , m_tile_count_y(0)
+        {
+            const EntityDefMessageContext message_context("texture", this);
+
+            // Split the filename pattern into a directory and a filename pattern, and
+            // qualify the directory since the pattern itself doesn't designate any file.
+            const bf::path pattern(m_params.get_required<string>("filename", ""));
+            m_directory =
+                pattern.has_parent_path()
+                    ? search_paths.qualify(pattern.parent_path().string())
+                    : search_paths.qualify(".");
+            m_filename_pattern = pattern.filename().string();
+
+            // Retrieve the color space.
+            const string color_space =
+                m_params.get_required<string>(
+                    "color_space",
+                    "linear_rgb",
+                    make_vector("linear_rgb", "srgb", "ciexyz"),
+                    message_context);
+            if (color_space == "linear_rgb")
+                m_color_space = ColorSpaceLinearRGB;
+            else if (color_space == "srgb")
+                m_color_space = ColorSpaceSRGB;
+            else m_color_space = ColorSpaceCIEXYZ;
+
+            // Retrieve the maximum number of simultaneously open image files.
+            m_max_open_files = max<size_t>(m_params.get_optional<size_t>("max_open_files", 64), 1);
+        }
+
+        virtual ~UDIMTexture2d()
+        {
+            close_image_files();
+        }
+
+        virtual void release() APPLESEED_OVERRIDE
+        {
+            delete this;
+        }
+
+        virtual const char* get_model() const APPLESEED_OVERRIDE
+        {
+            return Model;
+        }
+
+        virtual void on_frame_end(
+            const Project&      project,
+            const BaseGroup*    parent) APPLESEED_OVERRIDE
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            close_image_files();
+        }
+
+        virtual ColorSpace get_color_space() const APPLESEED_OVERRIDE
+        {
+            return m_color_space;
+        }
+
+        virtual void collect_asset_paths(StringArray& paths) const APPLESEED_OVERRIDE
+        {
+            if (m_params.strings().exist("filename"))
+                paths.push_back(m_params.get("filename"));
+        }
+
+        virtual void update_asset_paths(const StringDictionary& mappings) APPLESEED_OVERRIDE
+        {
+            m_params.set("filename", mappings.get(m_params.get("filename")));
+        }
+
+        virtual const CanvasProperties& properties() APPLESEED_OVERRIDE
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            initialize();
+            return m_props;
+        }
+
+        virtual Vector2u get_uv_tile_count() APPLESEED_OVERRIDE
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            initialize();
+            return Vector2u(UDIMColumnCount, max<size_t>(m_row_count, 1));
+        }
+
+        virtual Tile* load_tile(
+            const size_t        tile_x,
+            const size_t        tile_y) APPLESEED_OVERRIDE
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            initialize();
+
+            if (m_tile_count_x == 0)
+                return create_empty_tile();
+
+            // Find the UDIM tile containing this tile. Rows of the canvas go downward.
+            const size_t column = tile_x / m_tile_count_x;
+            const size_t row = m_row_count - 1 - tile_y / m_tile_count_y;
+            const size_t udim = UDIMFirstIndex + column + row * UDIMColumnCount;
+
+            GenericProgressiveImageFileReader* reader = get_reader(udim);
+
+            return
+                reader
+                    ? reader->read_tile(tile_x % m_tile_count_x, tile_y % m_tile_count_y)
+                    : create_empty_tile();
+        }
+
+        virtual void unload_tile(
+            const size_t        tile_x,
+            const size_t        tile_y,
+            const Tile*         tile) APPLESEED_OVERRIDE
+        {
+            delete tile;
+        }
+
+      private:
+        typedef map<size_t, string> PathMap;
+        typedef list<size_t> UDIMList;
+
+        struct OpenFile
+        {
+            GenericProgressiveImageFileReader*  m_reader;
+            UDIMList::iterator                  m_lru_position;
+        };
+
+        typedef map<size_t, OpenFile> OpenFileMap;
+
+        string                              m_directory;
+        string                              m_filename_pattern;
+        ColorSpace                          m_color_space;
+        size_t                              m_max_open_files;
+
+        mutable boost::mutex                m_mutex;
+        bool                                m_initialized;
+        PathMap                             m_paths;            // UDIM -> image file path
+        size_t                              m_row_count;
+        CanvasProperties                    m_file_props;       // canvas properties of one image file
+        size_t                              m_tile_count_x;     // number of tiles per image file, horizontally
+        size_t                              m_tile_count_y;     // number of tiles per image file, vertically
+        CanvasProperties                    m_props;            // canvas properties of the whole set
+        OpenFileMap                         m_open_files;
+        UDIMList                            m_lru_udims;        // UDIMs of the open files, most recently used first
+
+        void initialize()
+        {
+            if (m_initialized)
+                return;
+
+            m_initialized = true;
+
+            find_image_files();
+
+            if (m_paths.empty())
+            {
+                RENDERER_LOG_ERROR(
+                    "no image file found matching %s in directory %s.",
+                    m_filename_pattern.c_str(),
+                    m_directory.c_str());
+                m_props = CanvasProperties(1, 1, 1, 1, 4, PixelFormatFloat);
+                return;
+            }
+
+            // Read the canvas properties of one of the image files, all others must match.
+            GenericProgressiveImageFileReader* reader = get_reader(m_paths.begin()->first);
+            if (reader == 0)
+            {
+                m_props = CanvasProperties(1, 1, 1, 1, 4, PixelFormatFloat);
+                return;
+            }
+
+            reader->read_canvas_properties(m_file_props);
+
+            if (m_file_props.m_canvas_width % m_file_props.m_tile_width != 0 ||
+                m_file_props.m_canvas_height % m_file_props.m_tile_height != 0)
+            {
+                RENDERER_LOG_ERROR(
+                    "the dimensions of the image files of texture \"%s\" must be multiples of their tile dimensions.",
+                    get_path().c_str());
+                m_props = CanvasProperties(1, 1, 1, 1, m_file_props.m_channel_count, m_file_props.m_pixel_format);
+                return;
+            }
+
+            m_row_count = (m_paths.rbegin()->first - UDIMFirstIndex) / UDIMColumnCount + 1;
+            m_tile_count_x = m_file_props.m_tile_count_x;
+            m_tile_count_y = m_file_props.m_tile_count_y;
+
+            m_props =
+                CanvasProperties(
+                    UDIMColumnCount * m_file_props.m_canvas_width,
+                    m_row_count * m_file_props.m_canvas_height,
+                    m_file_props.m_tile_width,
+                    m_file_props.m_tile_height,
+                    m_file_props.m_channel_count,
+                    m_file_props.m_pixel_format);
+
+            RENDERER_LOG_INFO(
+                "found " FMT_SIZE_T " %s for texture \"%s\", spanning " FMT_SIZE_T " %s.",
+                m_paths.size(),
+                plural(m_paths.size(), "image file").c_str(),
+                get_path().c_str(),
+                m_row_count,
+                plural(m_row_count, "UDIM row").c_str());
+        }
+
+        // List the image files of the set without opening them.
+        void find_image_files()
+        {
+            const size_t token_pos = m_filename_pattern.find(UDIMToken);
+
+            if (token_pos == string::npos)
+            {
+                RENDERER_LOG_ERROR(
+                    "filename pattern %s of texture \"%s\" does not contain the %s token.",
+                    m_filename_pattern.c_str(),
+                    get_path().c_str(),
+                    UDIMToken);
+                return;
+            }
+
+            const string prefix = m_filename_pattern.substr(0, token_pos);
+            const string suffix = m_filename_pattern.substr(token_pos + strlen(UDIMToken));
+
+            if (!bf::is_directory(m_directory))
+                return;
+
+            for (bf::directory_iterator i(m_directory), e; i != e; ++i)
+            {
+                const string filename = i->path().filename().string();
+
+                if (filename.size() != prefix.size() + 4 + suffix.size() ||
+                    filename.compare(0, prefix.size(), prefix) != 0 ||
+                    filename.compare(prefix.size() + 4, suffix.size(), suffix) != 0)
+                    continue;
+
+                const string digits = filename.substr(prefix.size(), 4);
+                if (digits.find_first_not_of("0123456789") != string::npos)
+                    continue;
+
+                const size_t udim = from_string<size_t>(digits);
+                if (udim < UDIMFirstIndex)
+                    continue;
+
+                m_paths[udim] = i->path().string();
+            }
+        }
+
+        // Return the reader of the image file of a given UDIM, opening the file if necessary.
+        // Return 0 if the set has no such image file, or if it could not be opened.
+        GenericProgressiveImageFileReader* get_reader(const size_t udim)
+        {
+            // Use the file if it is already open.
+            const OpenFileMap::iterator it = m_open_files.find(udim);
+            if (it != m_open_files.end())
+            {
+                m_lru_udims.splice(m_lru_udims.begin(), m_lru_udims, it->second.m_lru_position);
+                return it->second.m_reader;
+            }
+
+            const PathMap::const_iterator path = m_paths.find(udim);
+            if (path == m_paths.end())
+                return 0;
+
+            // Close the least recently used file if the budget of open files is exhausted.
+            if (m_open_files.size() >= m_max_open_files)
+                close_image_file(m_lru_udims.back());
+
+            RENDERER_LOG_DEBUG("opening texture file %s...", path->second.c_str());
+
+            GenericProgressiveImageFileReader* reader = new GenericProgressiveImageFileReader(&global_logger());
+
+            try
+            {
+                reader->open(path->second.c_str());
+            }
+            catch (const exception& e)
+            {
+                RENDERER_LOG_ERROR(
+                    "failed to open texture file %s: %s.",
+                    path->second.c_str(),
+                    e.what());
+                delete reader;
+                m_paths.erase(udim);
+                return 0;
+            }
+
+            // Check that the file matches the other files of the set.
+            if (m_tile_count_x > 0)
+            {
+                CanvasProperties props;
+                reader->read_canvas_properties(props);
+
+                if (props.m_canvas_width != m_file_props.m_canvas_width ||
+                    props.m_canvas_height != m_file_props.m_canvas_height ||
+                    props.m_tile_width != m_file_props.m_tile_width ||
+                    props.m_tile_height != m_file_props.m_tile_height ||
+                    props.m_channel_count != m_file_props.m_channel_count ||
+                    props.m_pixel_format != m_file_props.m_pixel_format)
+                {
+                    RENDERER_LOG_ERROR(
+                        "texture file %s does not have the same format as the other files of texture \"%s\".",
+                        path->second.c_str(),
+                        get_path().c_str());
+                    delete reader;
+                    m_paths.erase(udim);
+                    return 0;
+                }
+            }
+
+            m_lru_udims.push_front(udim);
+
+            OpenFile& open_file = m_open_files[udim];
+            open_file.m_reader = reader;
+            open_file.m_lru_position = m_lru_udims.begin();
+
+            return reader;
+        }
+
+        void close_image_file(const size_t udim)
+        {
+            const OpenFileMap::iterator it = m_open_files.find(udim);
+            assert(it != m_open_files.end());
+
+            delete it->second.m_reader;
+            m_lru_udims.erase(it->second.m_lru_position);
+            m_open_files.erase(it);
+        }
+
+        void close_image_files()
+        {
+            while (!m_lru_udims.empty())
+                close_image_file(m_lru_udims.back());
+        }
+
+        // Create a tile for the parts of the canvas covered by no image file.
+        Tile* create_empty_tile() const
+        {
+            Tile* tile =
+                new Tile(
+                    m_props.m_tile_width,
+                    m_props.m_tile_height,
+                    m_props.m_channel_count,
+                    m_props.m_pixel_format);
+
+            memset(tile->get_storage(), 0, tile->get_size());
+
+            return tile;
+        }
+    };
+}
+
+
+//
+// UDIMTexture2dFactory class implementation.
+//
+
+const char* UDIMTexture2dFactory::get_model() const
+{
+    return Model;
+}
+
+Dictionary UDIMTexture2dFactory::get_model_metadata() const
+{
+    return
+        Dictionary()
+            .insert("name", Model)
+            .insert("label", "UDIM Texture Set");
+}
+
+DictionaryArray UDIMTexture2dFactory::get_input_metadata() const
+{
+    DictionaryArray metadata;
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "filename")
+            .insert("label", "File Path Pattern")
+            .insert("type", "text")
+            .insert("use", "required"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "color_space")
+            .insert("label", "Color Space")
+            .insert("type", "enumeration")
+            .insert("items",
+                Dictionary()
+                    .insert("Linear RGB", "linear_rgb")
+                    .insert("sRGB", "srgb")
+                    .insert("CIE XYZ", "ciexyz"))
+            .insert("use", "required")
+            .insert("default", "srgb"));
+
+    metadata.push_back(
+        Dictionary()
+            .insert("name", "max_open_files")
+            .insert("label", "Maximum Open Files")
+            .insert("type", "int")
+            .insert("use", "optional")
+            .insert("default", "64"));
+
+    return metadata;
+}
+
+auto_release_ptr<Texture> UDIMTexture2dFactory::create(
+    const char*         name,
+    const ParamArray&   params,
+    const SearchPaths&  search_paths) const
+{
+    return auto_release_ptr<Texture>(new UDIMTexture2d(name, params, search_paths));
+}
+
+auto_release_ptr<Texture> UDIMTexture2dFactory::static_create(
+    const char*         name,
+    const ParamArray&   params,
+    const SearchPaths&  search_paths)
+{
+    return auto_release_ptr<Texture>(new UDIMTexture2d(name, params, search_paths));
+}
+
+}   // namespace renderer
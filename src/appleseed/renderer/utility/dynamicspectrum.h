@@ -428,7 +428,24 @@ inline void DynamicSpectrum<T, N>::set(const ValueType val)
         m_samples[i] = val;
 }
 
-#ifdef APPLESEED_USE_SSE
+#if defined APPLESEED_USE_AVX
+
+template <>
+APPLESEED_FORCE_INLINE void DynamicSpectrum<float, 31>::set(const float val)
+{
+    const __m256 mval = _mm256_set1_ps(val);
+
+    if (m_size > 3)
+    {
+        _mm256_storeu_ps(&m_samples[ 0], mval);
+        _mm256_storeu_ps(&m_samples[ 8], mval);
+        _mm256_storeu_ps(&m_samples[16], mval);
+        _mm256_storeu_ps(&m_samples[24], mval);
+    }
+    else _mm_store_ps(&m_samples[ 0], _mm256_castps256_ps128(mval));
+}
+
+#elif defined APPLESEED_USE_SSE
 
 template <>
 APPLESEED_FORCE_INLINE void DynamicSpectrum<float, 31>::set(const float val)
@@ -449,7 +466,7 @@ APPLESEED_FORCE_INLINE void DynamicSpectrum<float, 31>::set(const float val)
     }
 }
 
-#endif  // APPLESEED_USE_SSE
+#endif
 
 template <typename T, size_t N>
 inline T& DynamicSpectrum<T, N>::operator[](const size_t i)
@@ -785,7 +802,42 @@ inline DynamicSpectrum<T, N>& operator+=(DynamicSpectrum<T, N>& lhs, const Dynam
     return lhs;
 }
 
-#ifdef APPLESEED_USE_SSE
+#if defined APPLESEED_USE_AVX
+
+template <>
+APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator+=(DynamicSpectrum<float, 31>& lhs, const DynamicSpectrum<float, 31>& rhs)
+{
+    assert(lhs.get_intent() == rhs.get_intent());
+
+    if (lhs.size() <= rhs.size())
+    {
+        if (lhs.size() < rhs.size())
+            DynamicSpectrum<float, 31>::upgrade(lhs, lhs);
+
+        if (lhs.size() > 3)
+        {
+            _mm256_storeu_ps(&lhs[ 0], _mm256_add_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&rhs[ 0])));
+            _mm256_storeu_ps(&lhs[ 8], _mm256_add_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&rhs[ 8])));
+            _mm256_storeu_ps(&lhs[16], _mm256_add_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&rhs[16])));
+            _mm256_storeu_ps(&lhs[24], _mm256_add_ps(_mm256_loadu_ps(&lhs[24]), _mm256_loadu_ps(&rhs[24])));
+        }
+        else _mm_store_ps(&lhs[ 0], _mm_add_ps(_mm_load_ps(&lhs[ 0]), _mm_load_ps(&rhs[ 0])));
+    }
+    else
+    {
+        DynamicSpectrum<float, 31> up_rhs;
+        DynamicSpectrum<float, 31>::upgrade(rhs, up_rhs);
+
+        _mm256_storeu_ps(&lhs[ 0], _mm256_add_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&up_rhs[ 0])));
+        _mm256_storeu_ps(&lhs[ 8], _mm256_add_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&up_rhs[ 8])));
+        _mm256_storeu_ps(&lhs[16], _mm256_add_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&up_rhs[16])));
+        _mm256_storeu_ps(&lhs[24], _mm256_add_ps(_mm256_loadu_ps(&lhs[24]), _mm256_loadu_ps(&up_rhs[24])));
+    }
+
+    return lhs;
+}
+
+#elif defined APPLESEED_USE_SSE
 
 template <>
 APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator+=(DynamicSpectrum<float, 31>& lhs, const DynamicSpectrum<float, 31>& rhs)
@@ -828,7 +880,7 @@ APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator+=(DynamicSpectrum<fl
     return lhs;
 }
 
-#endif  // APPLESEED_USE_SSE
+#endif
 
 template <typename T, size_t N>
 inline DynamicSpectrum<T, N>& operator-=(DynamicSpectrum<T, N>& lhs, const DynamicSpectrum<T, N>& rhs)
@@ -864,7 +916,26 @@ inline DynamicSpectrum<T, N>& operator*=(DynamicSpectrum<T, N>& lhs, const T rhs
     return lhs;
 }
 
-#ifdef APPLESEED_USE_SSE
+#if defined APPLESEED_USE_AVX
+
+template <>
+APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator*=(DynamicSpectrum<float, 31>& lhs, const float rhs)
+{
+    const __m256 mrhs = _mm256_set1_ps(rhs);
+
+    if (lhs.size() > 3)
+    {
+        _mm256_storeu_ps(&lhs[ 0], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 0]), mrhs));
+        _mm256_storeu_ps(&lhs[ 8], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 8]), mrhs));
+        _mm256_storeu_ps(&lhs[16], _mm256_mul_ps(_mm256_loadu_ps(&lhs[16]), mrhs));
+        _mm256_storeu_ps(&lhs[24], _mm256_mul_ps(_mm256_loadu_ps(&lhs[24]), mrhs));
+    }
+    else _mm_store_ps(&lhs[ 0], _mm_mul_ps(_mm_load_ps(&lhs[ 0]), _mm256_castps256_ps128(mrhs)));
+
+    return lhs;
+}
+
+#elif defined APPLESEED_USE_SSE
 
 template <>
 APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator*=(DynamicSpectrum<float, 31>& lhs, const float rhs)
@@ -887,7 +958,7 @@ APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator*=(DynamicSpectrum<fl
     return lhs;
 }
 
-#endif  // APPLESEED_USE_SSE
+#endif
 
 template <typename T, size_t N>
 inline DynamicSpectrum<T, N>& operator*=(DynamicSpectrum<T, N>& lhs, const DynamicSpectrum<T, N>& rhs)
@@ -915,7 +986,43 @@ inline DynamicSpectrum<T, N>& operator*=(DynamicSpectrum<T, N>& lhs, const Dynam
     return lhs;
 }
 
-#ifdef APPLESEED_USE_SSE
+#if defined APPLESEED_USE_AVX
+
+template <>
+APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator*=(DynamicSpectrum<float, 31>& lhs, const DynamicSpectrum<float, 31>& rhs)
+{
+    if (lhs.size() <= rhs.size())
+    {
+        if (lhs.size() < rhs.size())
+            DynamicSpectrum<float, 31>::upgrade(lhs, lhs);
+
+        if (lhs.size() > 3)
+        {
+            _mm256_storeu_ps(&lhs[ 0], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&rhs[ 0])));
+            _mm256_storeu_ps(&lhs[ 8], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&rhs[ 8])));
+            _mm256_storeu_ps(&lhs[16], _mm256_mul_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&rhs[16])));
+            _mm256_storeu_ps(&lhs[24], _mm256_mul_ps(_mm256_loadu_ps(&lhs[24]), _mm256_loadu_ps(&rhs[24])));
+        }
+        else _mm_store_ps(&lhs[ 0], _mm_mul_ps(_mm_load_ps(&lhs[ 0]), _mm_load_ps(&rhs[ 0])));
+    }
+    else
+    {
+        DynamicSpectrum<float, 31> up_rhs;
+        DynamicSpectrum<float, 31>::upgrade(rhs, up_rhs);
+
+        _mm256_storeu_ps(&lhs[ 0], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 0]), _mm256_loadu_ps(&up_rhs[ 0])));
+        _mm256_storeu_ps(&lhs[ 8], _mm256_mul_ps(_mm256_loadu_ps(&lhs[ 8]), _mm256_loadu_ps(&up_rhs[ 8])));
+        _mm256_storeu_ps(&lhs[16], _mm256_mul_ps(_mm256_loadu_ps(&lhs[16]), _mm256_loadu_ps(&up_rhs[16])));
+        _mm256_storeu_ps(&lhs[24], _mm256_mul_ps(_mm256_loadu_ps(&lhs[24]), _mm256_loadu_ps(&up_rhs[24])));
+    }
+
+    // If rhs is an illuminance, then lhs becomes an illuminance.
+    lhs.set_intent(combine_intents(lhs, rhs));
+
+    return lhs;
+}
+
+#elif defined APPLESEED_USE_SSE
 
 template <>
 APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator*=(DynamicSpectrum<float, 31>& lhs, const DynamicSpectrum<float, 31>& rhs)
@@ -959,7 +1066,7 @@ APPLESEED_FORCE_INLINE DynamicSpectrum<float, 31>& operator*=(DynamicSpectrum<fl
     return lhs;
 }
 
-#endif  // APPLESEED_USE_SSE
+#endif
 
 template <typename T, size_t N>
 inline DynamicSpectrum<T, N>& operator/=(DynamicSpectrum<T, N>& lhs, const T rhs)
@@ -1059,7 +1166,70 @@ inline void madd(
     }
 }
 
-#ifdef APPLESEED_USE_SSE
+#if defined APPLESEED_USE_AVX
+
+template <>
+APPLESEED_FORCE_INLINE void madd(
+    DynamicSpectrum<float, 31>&             a,
+    const DynamicSpectrum<float, 31>&       b,
+    const DynamicSpectrum<float, 31>&       c)
+{
+    assert(a.get_intent() == combine_intents(b, c));
+
+    if (a.size() == b.size() && a.size() == c.size())
+    {
+        if (a.size() > 3)
+        {
+            _mm256_storeu_ps(&a[ 0], _mm256_add_ps(_mm256_loadu_ps(&a[ 0]), _mm256_mul_ps(_mm256_loadu_ps(&b[ 0]), _mm256_loadu_ps(&c[ 0]))));
+            _mm256_storeu_ps(&a[ 8], _mm256_add_ps(_mm256_loadu_ps(&a[ 8]), _mm256_mul_ps(_mm256_loadu_ps(&b[ 8]), _mm256_loadu_ps(&c[ 8]))));
+            _mm256_storeu_ps(&a[16], _mm256_add_ps(_mm256_loadu_ps(&a[16]), _mm256_mul_ps(_mm256_loadu_ps(&b[16]), _mm256_loadu_ps(&c[16]))));
+            _mm256_storeu_ps(&a[24], _mm256_add_ps(_mm256_loadu_ps(&a[24]), _mm256_mul_ps(_mm256_loadu_ps(&b[24]), _mm256_loadu_ps(&c[24]))));
+        }
+        else _mm_store_ps(&a[0], _mm_add_ps(_mm_load_ps(&a[0]), _mm_mul_ps(_mm_load_ps(&b[0]), _mm_load_ps(&c[0]))));
+    }
+    else
+    {
+        a += b * c;
+    }
+}
+
+template <>
+APPLESEED_FORCE_INLINE void madd(
+    DynamicSpectrum<float, 31>&             a,
+    const DynamicSpectrum<float, 31>&       b,
+    const float                             c)
+{
+    assert(a.get_intent() == b.get_intent());
+
+    const __m256 k = _mm256_set1_ps(c);
+
+    if (a.size() <= b.size())
+    {
+        if (a.size() < b.size())
+            DynamicSpectrum<float, 31>::upgrade(a, a);
+
+        if (a.size() > 3)
+        {
+            _mm256_storeu_ps(&a[ 0], _mm256_add_ps(_mm256_loadu_ps(&a[ 0]), _mm256_mul_ps(_mm256_loadu_ps(&b[ 0]), k)));
+            _mm256_storeu_ps(&a[ 8], _mm256_add_ps(_mm256_loadu_ps(&a[ 8]), _mm256_mul_ps(_mm256_loadu_ps(&b[ 8]), k)));
+            _mm256_storeu_ps(&a[16], _mm256_add_ps(_mm256_loadu_ps(&a[16]), _mm256_mul_ps(_mm256_loadu_ps(&b[16]), k)));
+            _mm256_storeu_ps(&a[24], _mm256_add_ps(_mm256_loadu_ps(&a[24]), _mm256_mul_ps(_mm256_loadu_ps(&b[24]), k)));
+        }
+        else _mm_store_ps(&a[0], _mm_add_ps(_mm_load_ps(&a[0]), _mm_mul_ps(_mm_load_ps(&b[0]), _mm256_castps256_ps128(k))));
+    }
+    else
+    {
+        DynamicSpectrum<float, 31> up_b;
+        DynamicSpectrum<float, 31>::upgrade(b, up_b);
+
+        _mm256_storeu_ps(&a[ 0], _mm256_add_ps(_mm256_loadu_ps(&a[ 0]), _mm256_mul_ps(_mm256_loadu_ps(&up_b[ 0]), k)));
+        _mm256_storeu_ps(&a[ 8], _mm256_add_ps(_mm256_loadu_ps(&a[ 8]), _mm256_mul_ps(_mm256_loadu_ps(&up_b[ 8]), k)));
+        _mm256_storeu_ps(&a[16], _mm256_add_ps(_mm256_loadu_ps(&a[16]), _mm256_mul_ps(_mm256_loadu_ps(&up_b[16]), k)));
+        _mm256_storeu_ps(&a[24], _mm256_add_ps(_mm256_loadu_ps(&a[24]), _mm256_mul_ps(_mm256_loadu_ps(&up_b[24]), k)));
+    }
+}
+
+#elif defined APPLESEED_USE_SSE
 
 template <>
 APPLESEED_FORCE_INLINE void madd(
@@ -1134,7 +1304,7 @@ APPLESEED_FORCE_INLINE void madd(
     }
 }
 
-#endif  // APPLESEED_USE_SSE
+#endif
 
 }       // namespace renderer
 
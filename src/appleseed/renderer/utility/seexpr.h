@@ -39,6 +39,7 @@
 #include "foundation/math/vector.h"
 #include "foundation/platform/compiler.h"
 #include "foundation/utility/foreach.h"
+#include "foundation/utility/seexpr.h"
 #include "foundation/utility/string.h"
 
 // SeExpr headers.
@@ -61,7 +62,9 @@ END_OIIO_INCLUDES
 
 // Standard headers.
 #include <cassert>
+#include <cstddef>
 #include <string>
+#include <vector>
 
 namespace renderer
 {
@@ -71,6 +74,47 @@ inline bool texture_is_srgb(const OIIO::ustring& filename)
    return filename.rfind(".exr") != filename.length() - 4;
 }
 
+// Perform a texture lookup with the semantics of SeExpr's texture() function:
+// the returned color is in the sRGB color space, and magenta is returned if
+// the texture cannot be found or opened.
+inline foundation::Color3d lookup_seexpr_texture(
+    OIIO::TextureSystem&        texture_system,
+    const OIIO::ustring&        filename,
+    OIIO::TextureOpt&           options,
+    const bool                  is_srgb,
+    const double                u,
+    const double                v)
+{
+    foundation::Color3f color;
+    if (!texture_system.texture(
+            filename,
+            options,
+            static_cast<float>(u),
+            static_cast<float>(v),
+            0.0f,
+            0.0f,
+            0.0f,
+            0.0f,
+            3,
+            &color[0]))
+    {
+        // Failed to find or open the texture.
+        const std::string message = texture_system.geterror();
+        if (!message.empty())
+        {
+            const std::string trimmed_message = foundation::trim_both(message);
+            RENDERER_LOG_ERROR("oiio: %s", trimmed_message.c_str());
+        }
+        return foundation::Color3d(1.0, 0.0, 1.0);
+    }
+
+    // Colors in SeExpr are always in the sRGB color space.
+    if (!is_srgb)
+        color = foundation::linear_rgb_to_srgb(color);
+
+    return foundation::Color3d(color[0], color[1], color[2]);
+}
+
 
 //
 // TextureSeExprFunc class.
@@ -133,33 +177,14 @@ class TextureSeExprFunc
         node->child(1)->eval(u);
         node->child(2)->eval(v);
 
-        foundation::Color3f color;
-        if (!m_texture_system->texture(
+        const foundation::Color3d color =
+            lookup_seexpr_texture(
+                *m_texture_system,
                 m_texture_filename,
                 m_texture_options,
-                static_cast<float>(u[0]),
-                static_cast<float>(v[0]),
-                0.0f,
-                0.0f,
-                0.0f,
-                0.0f,
-                3,
-                &color[0]))
-        {
-            // Failed to find or open the texture.
-            const std::string message = m_texture_system->geterror();
-            if (!message.empty())
-            {
-                const std::string trimmed_message = foundation::trim_both(message);
-                RENDERER_LOG_ERROR("oiio: %s", trimmed_message.c_str());
-            }
-            result = SeVec3d(1.0, 0.0, 1.0);
-            return;
-        }
-
-        // Colors in SeExpr are always in the sRGB color space.
-        if (!m_texture_is_srgb)
-            color = foundation::linear_rgb_to_srgb(color);
+                m_texture_is_srgb,
+                u[0],
+                v[0]);
 
         result = SeVec3d(color[0], color[1], color[2]);
     }
@@ -172,6 +197,54 @@ class TextureSeExprFunc
 };
 
 
+//
+// Texture lookups of compiled SeExpr programs (foundation::SeExprProgram).
+//
+
+class SeExprProgramTextureLookup
+  : public foundation::SeExprProgram::ITextureLookup
+{
+  public:
+    // Bind a texture system to the textures referenced by a program.
+    SeExprProgramTextureLookup(
+        OIIO::TextureSystem&                texture_system,
+        const std::vector<OIIO::ustring>&   filenames,
+        const std::vector<bool>&            is_srgb)
+      : m_texture_system(texture_system)
+      , m_filenames(filenames)
+      , m_is_srgb(is_srgb)
+    {
+        assert(m_filenames.size() == m_is_srgb.size());
+
+        m_texture_options.swrap = OIIO::TextureOpt::WrapPeriodic;
+        m_texture_options.twrap = OIIO::TextureOpt::WrapPeriodic;
+    }
+
+    virtual foundation::Color3d lookup(
+        const size_t                        texture_index,
+        const double                        u,
+        const double                        v) const APPLESEED_OVERRIDE
+    {
+        assert(texture_index < m_filenames.size());
+
+        return
+            lookup_seexpr_texture(
+                m_texture_system,
+                m_filenames[texture_index],
+                m_texture_options,
+                m_is_srgb[texture_index],
+                u,
+                v);
+    }
+
+  private:
+    OIIO::TextureSystem&                    m_texture_system;
+    const std::vector<OIIO::ustring>&       m_filenames;
+    const std::vector<bool>&                m_is_srgb;
+    mutable OIIO::TextureOpt                m_texture_options;
+};
+
+
 //
 // SeAppleseedExpr class.
 //
@@ -54,12 +54,12 @@ SamplingContext::Mode get_sampling_context_mode(const ParamArray& params)
         params.get_required<string>(
             "sampling_mode",
             "rng",
-            make_vector("rng", "qmc"));
+            make_vector("rng", "qmc", "sobol"));
 
     return
-        sampling_mode == "rng"
-            ? SamplingContext::RNGMode
-            : SamplingContext::QMCMode;
+        sampling_mode == "rng" ? SamplingContext::RNGMode :
+        sampling_mode == "qmc" ? SamplingContext::QMCMode :
+        SamplingContext::SobolMode;
 }
 
 string get_sampling_context_mode_name(const SamplingContext::Mode mode)
@@ -68,6 +68,7 @@ string get_sampling_context_mode_name(const SamplingContext::Mode mode)
     {
       case SamplingContext::RNGMode: return "rng";
       case SamplingContext::QMCMode: return "qmc";
+      case SamplingContext::SobolMode: return "sobol";
       default: return "unknown";
     }
 }
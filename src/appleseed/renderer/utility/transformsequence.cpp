@@ -52,7 +52,7 @@ TransformSequence::TransformSequence()
   : m_capacity(0)
   , m_size(0)
   , m_keys(0)
-  , m_interpolators(0)
+  , m_segments(0)
   , m_can_swap_handedness(false)
   , m_all_swap_handedness(false)
 {
@@ -82,8 +82,8 @@ void TransformSequence::clear()
     delete [] m_keys;
     m_keys = 0;
 
-    delete [] m_interpolators;
-    m_interpolators = 0;
+    delete [] m_segments;
+    m_segments = 0;
 
     m_can_swap_handedness = false;
     m_all_swap_handedness = false;
@@ -181,8 +181,8 @@ void TransformSequence::optimize()
 
 bool TransformSequence::prepare()
 {
-    delete [] m_interpolators;
-    m_interpolators = 0;
+    delete [] m_segments;
+    m_segments = 0;
 
     bool success = true;
 
@@ -190,12 +190,17 @@ bool TransformSequence::prepare()
     {
         sort(m_keys, m_keys + m_size);
 
-        m_interpolators = new TransformInterpolatord[m_size - 1];
+        m_segments = new Segment[m_size - 1];
 
         for (size_t i = 0; i < m_size - 1; ++i)
         {
+            Segment& segment = m_segments[i];
+            segment.m_begin_time = m_keys[i].m_time;
+            segment.m_rcp_duration =
+                1.0 / (static_cast<double>(m_keys[i + 1].m_time) - static_cast<double>(m_keys[i].m_time));
+
             success = success &&
-                m_interpolators[i].set_transforms(
+                segment.m_interpolator.set_transforms(
                     m_keys[i].m_transform,
                     m_keys[i + 1].m_transform);
         }
@@ -292,14 +297,14 @@ void TransformSequence::copy_from(const TransformSequence& rhs)
     }
     else m_keys = 0;
 
-    if (rhs.m_interpolators)
+    if (rhs.m_segments)
     {
-        m_interpolators = new TransformInterpolatord[m_size - 1];
+        m_segments = new Segment[m_size - 1];
 
         for (size_t i = 0; i < m_size - 1; ++i)
-            m_interpolators[i] = rhs.m_interpolators[i];
+            m_segments[i] = rhs.m_segments[i];
     }
-    else m_interpolators = 0;
+    else m_segments = 0;
 
     m_can_swap_handedness = rhs.m_can_swap_handedness;
     m_all_swap_handedness = rhs.m_all_swap_handedness;
@@ -309,27 +314,25 @@ void TransformSequence::interpolate(
     const float         time,
     Transformd&         result) const
 {
-    assert(m_size > 0);
+    assert(m_size > 1);
 
+    // Find the segment containing 'time' by only touching the compact segment table.
     size_t begin = 0;
-    size_t end = m_size;
+    size_t end = m_size - 1;
 
     while (end - begin > 1)
     {
         const size_t mid = (begin + end) / 2;
-        if (time < m_keys[mid].m_time)
+        if (time < m_segments[mid].m_begin_time)
             end = mid;
         else begin = mid;
     }
 
-    const float begin_time = m_keys[begin].m_time;
-    const float end_time = m_keys[end].m_time;
-
-    assert(end_time > begin_time);
+    const Segment& segment = m_segments[begin];
+    const double t =
+        (static_cast<double>(time) - static_cast<double>(segment.m_begin_time)) * segment.m_rcp_duration;
 
-    const float t = (time - begin_time) / (end_time - begin_time);
-
-    m_interpolators[begin].evaluate(static_cast<double>(t), result);
+    segment.m_interpolator.evaluate(t, result);
 }
 
 namespace
@@ -586,4 +589,23 @@ AABB3d TransformSequence::compute_motion_segment_bbox(
     return motion_bbox;
 }
 
+
+
+//
+// TransformSequenceCache class implementation.
+//
+
+TransformSequenceCache::TransformSequenceCache()
+  : m_hit_count(0)
+  , m_miss_count(0)
+{
+    clear();
+}
+
+void TransformSequenceCache::clear()
+{
+    for (size_t i = 0; i < LineCount; ++i)
+        m_lines[i].m_sequence = 0;
+}
+
 }   // namespace renderer
@@ -31,9 +31,12 @@
 #define APPLESEED_RENDERER_UTILITY_TRANSFORMSEQUENCE_H
 
 // appleseed.foundation headers.
+#include "foundation/core/concepts/noncopyable.h"
 #include "foundation/math/aabb.h"
 #include "foundation/math/transform.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/types.h"
+#include "foundation/utility/casts.h"
 
 // appleseed.main headers.
 #include "main/dllsymbol.h"
@@ -124,6 +127,13 @@ class APPLESEED_DLLSYMBOL TransformSequence
     template <typename T>
     foundation::AABB<T, 3> to_parent(const foundation::AABB<T, 3>& bbox) const;
 
+    // Transform a 3D axis-aligned bounding box across the motion between the transforms
+    // at indices 'index' and 'index + 1' in this sequence. The bounding box must be valid.
+    template <typename T>
+    foundation::AABB<T, 3> segment_to_parent(
+        const foundation::AABB<T, 3>&   bbox,
+        const size_t                    index) const;
+
   private:
     struct TransformKey
     {
@@ -136,10 +146,19 @@ class APPLESEED_DLLSYMBOL TransformSequence
         }
     };
 
+    // Interpolation data of the motion segment between two consecutive keys,
+    // stored apart from the keys so that the search in interpolate() stays compact.
+    struct Segment
+    {
+        float                           m_begin_time;
+        double                          m_rcp_duration;
+        foundation::TransformInterpolatord m_interpolator;
+    };
+
     size_t                              m_capacity;
     size_t                              m_size;
     TransformKey*                       m_keys;
-    foundation::TransformInterpolatord* m_interpolators;
+    Segment*                            m_segments;
     bool                                m_can_swap_handedness;
     bool                                m_all_swap_handedness;
 
@@ -156,6 +175,51 @@ class APPLESEED_DLLSYMBOL TransformSequence
 };
 
 
+//
+// A small direct-mapped cache of evaluated transform sequences, keyed on the
+// sequence and the exact evaluation time. All the rays of a given path share
+// the same time, so moving instances are only interpolated once per path.
+//
+// The cache stores pointers to transform sequences: it must be cleared whenever
+// these sequences are modified or destroyed. It is not thread-safe.
+//
+
+class APPLESEED_DLLSYMBOL TransformSequenceCache
+  : public foundation::NonCopyable
+{
+  public:
+    // Constructor.
+    TransformSequenceCache();
+
+    // Invalidate all cache lines.
+    void clear();
+
+    // Evaluate a transform sequence at a given time. The returned reference
+    // remains valid until the next call to evaluate() or clear().
+    const foundation::Transformd& evaluate(
+        const TransformSequence&        sequence,
+        const float                     time);
+
+    // Return the number of cache hits and misses since construction.
+    foundation::uint64 get_hit_count() const;
+    foundation::uint64 get_miss_count() const;
+
+  private:
+    enum { LineCountLog = 4, LineCount = 1 << LineCountLog };
+
+    struct Line
+    {
+        const TransformSequence*        m_sequence;
+        float                           m_time;
+        foundation::Transformd          m_transform;
+    };
+
+    Line                                m_lines[LineCount];
+    foundation::uint64                  m_hit_count;
+    foundation::uint64                  m_miss_count;
+};
+
+
 //
 // TransformSequence class implementation.
 //
@@ -188,7 +252,7 @@ APPLESEED_FORCE_INLINE const foundation::Transformd& TransformSequence::evaluate
     if (m_size == 0)
         return foundation::Transformd::identity();
 
-    assert(m_size == 1 || m_interpolators != 0);
+    assert(m_size == 1 || m_segments != 0);
 
     const TransformKey* first = m_keys;
 
@@ -217,23 +281,81 @@ foundation::AABB<T, 3> TransformSequence::to_parent(const foundation::AABB<T, 3>
     foundation::AABB<T, 3> result;
     result.invalidate();
 
+    // Insert the bounding box of the path from each key frame to the next.
     for (size_t i = 0; i < m_size - 1; ++i)
-    {
-        // Insert the bounding box of the path from this key frame to the next.
-        result.insert(
-            foundation::AABB<T, 3>(
-                compute_motion_segment_bbox(
-                    foundation::AABB3d(bbox),
-                    m_keys[i].m_transform,
-                    m_keys[i + 1].m_transform)));
-    }
+        result.insert(segment_to_parent(bbox, i));
 
-    // Insert the bounding box at the last key frame.
+    // Insert the bounding box at the last key frame (needed if there is a single key frame).
     result.insert(m_keys[m_size - 1].m_transform.to_parent(bbox));
 
     return result;
 }
 
+template <typename T>
+foundation::AABB<T, 3> TransformSequence::segment_to_parent(
+    const foundation::AABB<T, 3>&   bbox,
+    const size_t                    index) const
+{
+    assert(bbox.is_valid());
+    assert(index + 1 < m_size);
+
+    foundation::AABB<T, 3> result(
+        compute_motion_segment_bbox(
+            foundation::AABB3d(bbox),
+            m_keys[index].m_transform,
+            m_keys[index + 1].m_transform));
+
+    // The motion bounding box does not always include the bounding box at the end of the segment.
+    result.insert(m_keys[index + 1].m_transform.to_parent(bbox));
+
+    return result;
+}
+
+
+
+//
+// TransformSequenceCache class implementation.
+//
+
+APPLESEED_FORCE_INLINE const foundation::Transformd& TransformSequenceCache::evaluate(
+    const TransformSequence&        sequence,
+    const float                     time)
+{
+    const foundation::uint32 key =
+        static_cast<foundation::uint32>(reinterpret_cast<uintptr_t>(&sequence) >> 4) ^
+        foundation::binary_cast<foundation::uint32>(time);
+    const size_t index = (key * 2654435761U) >> (32 - LineCountLog);
+
+    Line& line = m_lines[index];
+
+    if (line.m_sequence == &sequence && line.m_time == time)
+    {
+        ++m_hit_count;
+        return line.m_transform;
+    }
+
+    ++m_miss_count;
+
+    line.m_sequence = &sequence;
+    line.m_time = time;
+
+    const foundation::Transformd& transform = sequence.evaluate(time, line.m_transform);
+    if (&transform != &line.m_transform)
+        line.m_transform = transform;
+
+    return line.m_transform;
+}
+
+inline foundation::uint64 TransformSequenceCache::get_hit_count() const
+{
+    return m_hit_count;
+}
+
+inline foundation::uint64 TransformSequenceCache::get_miss_count() const
+{
+    return m_miss_count;
+}
+
 }       // namespace renderer
 
 #endif  // !APPLESEED_RENDERER_UTILITY_TRANSFORMSEQUENCE_H
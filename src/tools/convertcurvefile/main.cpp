@@ -0,0 +1,132 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2010-2013 Francois Beaune, Jupiter Jazz Limited
+// Copyright (c) 2014-2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+// Project headers.
+#include "commandlinehandler.h"
+
+// appleseed.shared headers.
+#include "application/application.h"
+#include "application/superlogger.h"
+
+// appleseed.renderer headers.
+#include "renderer/api/log.h"
+#include "renderer/api/object.h"
+#include "renderer/api/types.h"
+#include "renderer/api/utility.h"
+
+// appleseed.foundation headers.
+#include "foundation/utility/autoreleaseptr.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/log.h"
+#include "foundation/utility/searchpaths.h"
+#include "foundation/utility/string.h"
+
+// Standard headers.
+#include <cstddef>
+#include <string>
+
+using namespace appleseed::convertcurvefile;
+using namespace appleseed::shared;
+using namespace foundation;
+using namespace renderer;
+using namespace std;
+
+
+//
+// Entry point of convertcurvefile.
+//
+
+int main(int argc, const char* argv[])
+{
+    // Initialize the logger that will be used throughout the program.
+    SuperLogger logger;
+
+    // Make sure appleseed is correctly installed.
+    Application::check_installation(logger);
+
+    // Parse the command line.
+    CommandLineHandler cl;
+    cl.parse(argc, argv, logger);
+
+    // Load an apply settings from the settings file.
+    Dictionary settings;
+    Application::load_settings("appleseed.tools.xml", settings, logger);
+    logger.configure_from_settings(settings);
+
+    // Apply command line arguments.
+    cl.apply(logger);
+
+    // Configure the renderer's global logger.
+    // Must be done after settings have been loaded and the command line
+    // has been parsed, because these two operations may replace the log
+    // target of the global logger.
+    global_logger().initialize_from(logger);
+
+    // Retrieve the input and output file paths.
+    const string& input_filepath = cl.m_filenames.values()[0];
+    const string& output_filepath = cl.m_filenames.values()[1];
+
+    // Read the input curve file.
+    auto_release_ptr<CurveObject> object(
+        CurveObjectReader::read(
+            SearchPaths(),
+            "curves",
+            ParamArray().insert("filepath", input_filepath)));
+
+    const size_t curve_count = object->get_curve1_count() + object->get_curve3_count();
+
+    // Print a warning message and exit if no curve were defined in the input file.
+    if (curve_count == 0)
+    {
+        LOG_WARNING(logger, "no curve defined.");
+        return 0;
+    }
+
+    // Optionally print the bounding box of the curves.
+    if (cl.m_print_bbox.is_set())
+    {
+        const GAABB3 bbox = object->compute_local_bbox();
+
+        LOG_INFO(
+            logger,
+            "bounding box of %s curve%s: (%f, %f, %f)-(%f, %f, %f).",
+            pretty_uint(curve_count).c_str(),
+            curve_count > 1 ? "s" : "",
+            bbox.min[0], bbox.min[1], bbox.min[2],
+            bbox.max[0], bbox.max[1], bbox.max[2]);
+    }
+
+    // Write the output curve file.
+    const bool success =
+        CurveObjectWriter::write(
+            object.ref(),
+            output_filepath.c_str());
+
+    return success ? 0 : 1;
+}
@@ -50,13 +50,49 @@ CommandLineHandler::CommandLineHandler()
 
     parser().set_default_option_handler(
         &m_filenames
-            .set_exact_value_count(2));
+            .set_min_value_count(1));
 
     parser().add_option_handler(
         &m_print_bboxes
             .add_name("--print-bounding-boxes")
             .add_name("-b")
             .set_description("print mesh bounding boxes"));
+
+    parser().add_option_handler(
+        &m_mappable
+            .add_name("--mappable")
+            .add_name("-m")
+            .set_description("write BinaryMesh files in the memory-mappable format (version 4)"));
+
+    parser().add_option_handler(
+        &m_output_directory
+            .add_name("--output-directory")
+            .add_name("-o")
+            .set_description("convert all input files into this directory (batch mode)")
+            .set_syntax("directory")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_output_format
+            .add_name("--output-format")
+            .add_name("-f")
+            .set_description("set the format of the files written in batch mode (obj or binarymesh)")
+            .set_syntax("format")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_threads
+            .add_name("--threads")
+            .add_name("-t")
+            .set_description("set the number of files converted in parallel in batch mode (default: one per CPU core)")
+            .set_syntax("count")
+            .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_update
+            .add_name("--update")
+            .add_name("-u")
+            .set_description("in batch mode, only convert files whose output file is missing or older"));
 }
 
 void CommandLineHandler::print_program_usage(
@@ -68,6 +104,8 @@ void CommandLineHandler::print_program_usage(
     logger.set_format(LogMessage::Info, "{message}");
 
     LOG_INFO(logger, "usage: %s [options] input-file output-file", executable_name);
+    LOG_INFO(logger, "       %s [options] -o directory -f format input...", executable_name);
+    LOG_INFO(logger, "in batch mode, inputs are mesh files, directories or file name patterns using * and ?.");
     LOG_INFO(logger, "options:");
 
     parser().print_usage(logger);
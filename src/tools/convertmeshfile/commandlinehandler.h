@@ -37,6 +37,7 @@
 #include "application/commandlinehandlerbase.h"
 
 // Standard headers.
+#include <cstddef>
 #include <string>
 
 // Forward declarations.
@@ -55,6 +56,11 @@ class CommandLineHandler
   public:
     foundation::ValueOptionHandler<std::string> m_filenames;
     foundation::FlagOptionHandler               m_print_bboxes;
+    foundation::FlagOptionHandler               m_mappable;
+    foundation::ValueOptionHandler<std::string> m_output_directory;
+    foundation::ValueOptionHandler<std::string> m_output_format;
+    foundation::ValueOptionHandler<size_t>      m_threads;
+    foundation::FlagOptionHandler               m_update;
 
     // Constructor.
     CommandLineHandler();
@@ -42,11 +42,21 @@
 #include "foundation/mesh/imeshbuilder.h"
 #include "foundation/mesh/imeshwalker.h"
 #include "foundation/platform/compiler.h"
+#include "foundation/platform/system.h"
+#include "foundation/platform/timers.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/foreach.h"
+#include "foundation/utility/job.h"
 #include "foundation/utility/log.h"
+#include "foundation/utility/stopwatch.h"
+#include "foundation/utility/string.h"
+
+// Boost headers.
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
 
 // Standard headers.
+#include <algorithm>
 #include <cstddef>
 #include <deque>
 #include <exception>
@@ -58,6 +68,7 @@ using namespace appleseed::convertmeshfile;
 using namespace appleseed::shared;
 using namespace foundation;
 using namespace std;
+namespace bf = boost::filesystem;
 
 namespace
 {
@@ -269,6 +280,303 @@ namespace
             bbox.min[0], bbox.min[1], bbox.min[2],
             bbox.max[0], bbox.max[1], bbox.max[2]);
     }
+
+    // Convert a single mesh file. Returns false if the conversion failed.
+    bool convert_mesh_file(
+        Logger&             logger,
+        const string&       input_filepath,
+        const string&       output_filepath,
+        const bool          print_bboxes,
+        const bool          mappable_binarymesh)
+    {
+        // Read the input mesh file.
+        MeshBuilder builder;
+        try
+        {
+            GenericMeshFileReader reader(input_filepath.c_str());
+            reader.read(builder);
+        }
+        catch (const exception& e)
+        {
+            LOG_ERROR(
+                logger,
+                "could not read mesh file %s (%s).",
+                input_filepath.c_str(),
+                e.what());
+            return false;
+        }
+
+        // Print a warning message and skip the file if no mesh were defined in it.
+        if (builder.get_meshes().empty())
+        {
+            LOG_WARNING(logger, "no mesh defined in %s.", input_filepath.c_str());
+            return true;
+        }
+
+        // Optionally print the bounding box of each loaded mesh.
+        if (print_bboxes)
+        {
+            for (const_each<list<Mesh> > i = builder.get_meshes(); i; ++i)
+                print_bbox(logger, *i);
+        }
+
+        // Write the output mesh file.
+        try
+        {
+            GenericMeshFileWriter writer(output_filepath.c_str(), mappable_binarymesh);
+
+            for (const_each<list<Mesh> > i = builder.get_meshes(); i; ++i)
+            {
+                const MeshWalker walker(*i);
+                writer.write(walker);
+            }
+        }
+        catch (const exception& e)
+        {
+            LOG_ERROR(
+                logger,
+                "could not write mesh file %s (%s).",
+                output_filepath.c_str(),
+                e.what());
+            return false;
+        }
+
+        return true;
+    }
+
+
+    //
+    // Batch mode.
+    //
+    // Each conversion job holds at most one mesh file in memory, so the number
+    // of worker threads bounds the memory used by a batch conversion.
+    //
+
+    bool is_supported_mesh_file(const bf::path& path)
+    {
+        const string extension = lower_case(path.extension().string());
+        return extension == ".obj" || extension == ".abc" || extension == ".binarymesh";
+    }
+
+    // Match a file name against a pattern where * matches any sequence of characters
+    // and ? matches any single character.
+    bool match_pattern(const char* pattern, const char* name)
+    {
+        if (*pattern == '\0')
+            return *name == '\0';
+
+        if (*pattern == '*')
+            return match_pattern(pattern + 1, name) || (*name != '\0' && match_pattern(pattern, name + 1));
+
+        return
+            *name != '\0' &&
+            (*pattern == '?' || *pattern == *name) &&
+            match_pattern(pattern + 1, name + 1);
+    }
+
+    // Expand an input argument (file, directory or file name pattern) into a list of mesh files.
+    void collect_input_files(
+        Logger&             logger,
+        const string&       input,
+        vector<bf::path>&   input_files)
+    {
+        const bf::path input_path(input);
+        const string filename = input_path.filename().string();
+
+        if (filename.find_first_of("*?") != string::npos)
+        {
+            const bf::path directory = input_path.has_parent_path() ? input_path.parent_path() : bf::path(".");
+
+            vector<bf::path> matches;
+            if (bf::is_directory(directory))
+            {
+                for (bf::directory_iterator i(directory), e; i != e; ++i)
+                {
+                    if (bf::is_regular_file(i->path()) && match_pattern(filename.c_str(), i->path().filename().string().c_str()))
+                        matches.push_back(i->path());
+                }
+            }
+
+            if (matches.empty())
+                LOG_WARNING(logger, "no file matching %s.", input.c_str());
+
+            sort(matches.begin(), matches.end());
+            input_files.insert(input_files.end(), matches.begin(), matches.end());
+        }
+        else if (bf::is_directory(input_path))
+        {
+            vector<bf::path> matches;
+            for (bf::directory_iterator i(input_path), e; i != e; ++i)
+            {
+                if (bf::is_regular_file(i->path()) && is_supported_mesh_file(i->path()))
+                    matches.push_back(i->path());
+            }
+
+            sort(matches.begin(), matches.end());
+            input_files.insert(input_files.end(), matches.begin(), matches.end());
+        }
+        else if (bf::exists(input_path))
+            input_files.push_back(input_path);
+        else LOG_ERROR(logger, "file %s does not exist.", input.c_str());
+    }
+
+    class ConversionJob
+      : public IJob
+    {
+      public:
+        ConversionJob(
+            Logger&         logger,
+            const bf::path& input_filepath,
+            const bf::path& output_filepath,
+            const bool      print_bboxes,
+            const bool      mappable_binarymesh)
+          : m_logger(logger)
+          , m_input_filepath(input_filepath.string())
+          , m_output_filepath(output_filepath.string())
+          , m_print_bboxes(print_bboxes)
+          , m_mappable_binarymesh(mappable_binarymesh)
+          , m_succeeded(false)
+        {
+        }
+
+        virtual void execute(const size_t thread_index) APPLESEED_OVERRIDE
+        {
+            LOG_INFO(
+                m_logger,
+                "converting %s to %s...",
+                m_input_filepath.c_str(),
+                m_output_filepath.c_str());
+
+            m_succeeded =
+                convert_mesh_file(
+                    m_logger,
+                    m_input_filepath,
+                    m_output_filepath,
+                    m_print_bboxes,
+                    m_mappable_binarymesh);
+        }
+
+        bool succeeded() const
+        {
+            return m_succeeded;
+        }
+
+      private:
+        Logger&             m_logger;
+        const string        m_input_filepath;
+        const string        m_output_filepath;
+        const bool          m_print_bboxes;
+        const bool          m_mappable_binarymesh;
+        bool                m_succeeded;
+    };
+
+    int convert_mesh_files(
+        Logger&                     logger,
+        const CommandLineHandler&   cl)
+    {
+        string output_format =
+            cl.m_output_format.is_set() ? lower_case(cl.m_output_format.value()) : "";
+        if (!output_format.empty() && output_format[0] == '.')
+            output_format.erase(0, 1);
+        if (output_format != "obj" && output_format != "binarymesh")
+            LOG_FATAL(logger, "batch mode requires an output format (obj or binarymesh).");
+
+        const size_t thread_count =
+            cl.m_threads.is_set() ? max<size_t>(cl.m_threads.value(), 1) : System::get_logical_cpu_core_count();
+
+        // Collect the input files.
+        vector<bf::path> input_files;
+        for (const_each<vector<string> > i = cl.m_filenames.values(); i; ++i)
+            collect_input_files(logger, *i, input_files);
+
+        const bf::path output_directory(cl.m_output_directory.value());
+        try
+        {
+            bf::create_directories(output_directory);
+        }
+        catch (const exception& e)
+        {
+            LOG_FATAL(
+                logger,
+                "could not create directory %s (%s).",
+                output_directory.string().c_str(),
+                e.what());
+        }
+
+        // Create one conversion job per input file whose output is not up-to-date.
+        vector<ConversionJob*> jobs;
+        size_t skipped_count = 0;
+        for (const_each<vector<bf::path> > i = input_files; i; ++i)
+        {
+            bf::path output_filepath = output_directory / i->filename();
+            output_filepath.replace_extension("." + output_format);
+
+            if (bf::equivalent(*i, output_filepath))
+            {
+                LOG_ERROR(logger, "skipping %s: input and output files are the same.", i->string().c_str());
+                continue;
+            }
+
+            if (cl.m_update.is_set() &&
+                bf::exists(output_filepath) &&
+                bf::last_write_time(output_filepath) >= bf::last_write_time(*i))
+            {
+                ++skipped_count;
+                continue;
+            }
+
+            jobs.push_back(
+                new ConversionJob(
+                    logger,
+                    *i,
+                    output_filepath,
+                    cl.m_print_bboxes.is_set(),
+                    cl.m_mappable.is_set()));
+        }
+
+        LOG_INFO(
+            logger,
+            "converting %s %s using %s %s (%s up-to-date %s skipped)...",
+            pretty_uint(jobs.size()).c_str(),
+            plural(jobs.size(), "file").c_str(),
+            pretty_uint(thread_count).c_str(),
+            plural(thread_count, "thread").c_str(),
+            pretty_uint(skipped_count).c_str(),
+            plural(skipped_count, "file").c_str());
+
+        Stopwatch<DefaultWallclockTimer> stopwatch;
+        stopwatch.start();
+
+        JobQueue job_queue;
+        for (const_each<vector<ConversionJob*> > i = jobs; i; ++i)
+            job_queue.schedule(*i, false);
+
+        // Convert the files.
+        {
+            JobManager job_manager(logger, job_queue, thread_count);
+            job_manager.start();
+            job_queue.wait_until_completion();
+        }
+
+        size_t failure_count = 0;
+        for (const_each<vector<ConversionJob*> > i = jobs; i; ++i)
+        {
+            if (!(*i)->succeeded())
+                ++failure_count;
+            delete *i;
+        }
+
+        LOG_INFO(
+            logger,
+            "converted %s %s in %s, %s %s.",
+            pretty_uint(jobs.size() - failure_count).c_str(),
+            plural(jobs.size() - failure_count, "file").c_str(),
+            pretty_time(stopwatch.measure().get_seconds()).c_str(),
+            pretty_uint(failure_count).c_str(),
+            plural(failure_count, "failure").c_str());
+
+        return failure_count == 0 ? 0 : 1;
+    }
 }
 
 
@@ -296,58 +604,22 @@ int main(int argc, const char* argv[])
     // Apply command line arguments.
     cl.apply(logger);
 
+    // Batch mode.
+    if (cl.m_output_directory.is_set())
+        return convert_mesh_files(logger, cl);
+
+    if (cl.m_filenames.values().size() != 2)
+        LOG_FATAL(logger, "expected an input file and an output file, or an output directory (-o) in batch mode.");
+
     // Retrieve the input and output file paths.
     const string& input_filepath = cl.m_filenames.values()[0];
     const string& output_filepath = cl.m_filenames.values()[1];
 
-    // Read the input mesh file.
-    MeshBuilder builder;
-    try
-    {
-        GenericMeshFileReader reader(input_filepath.c_str());
-        reader.read(builder);
-    }
-    catch (const exception& e)
-    {
-        LOG_FATAL(
+    return
+        convert_mesh_file(
             logger,
-            "could not read mesh file %s (%s).",
-            input_filepath.c_str(),
-            e.what());
-    }
-
-    // Print a warning message and exit if no mesh were defined in the input file.
-    if (builder.get_meshes().empty())
-    {
-        LOG_WARNING(logger, "no mesh defined.");
-        return 0;
-    }
-
-    // Optionally print the bounding box of each loaded mesh.
-    if (cl.m_print_bboxes.is_set())
-    {
-        for (const_each<list<Mesh> > i = builder.get_meshes(); i; ++i)
-            print_bbox(logger, *i);
-    }
-
-    // Write the output mesh file.
-    GenericMeshFileWriter writer(output_filepath.c_str());
-    try
-    {
-        for (const_each<list<Mesh> > i = builder.get_meshes(); i; ++i)
-        {
-            const MeshWalker walker(*i);
-            writer.write(walker);
-        }
-    }
-    catch (const exception& e)
-    {
-        LOG_FATAL(
-            logger,
-            "could not write mesh file %s (%s).",
-            output_filepath.c_str(),
-            e.what());
-    }
-
-    return 0;
+            input_filepath,
+            output_filepath,
+            cl.m_print_bboxes.is_set(),
+            cl.m_mappable.is_set()) ? 0 : 1;
 }
@@ -113,6 +113,14 @@ CommandLineHandler::CommandLineHandler()
             .set_exact_value_count(1)
             .set_default_value(0));
 
+    parser().add_option_handler(
+        &m_threads
+            .add_name("--threads")
+            .add_name("-t")
+            .set_description("set the number of threads used to generate the curves (default: one per CPU core)")
+            .set_syntax("count")
+            .set_exact_value_count(1));
+
     parser().add_option_handler(
         &m_include
             .add_name("--include")
@@ -46,6 +46,8 @@
 #include "foundation/math/sampling/mappings.h"
 #include "foundation/math/scalar.h"
 #include "foundation/math/vector.h"
+#include "foundation/platform/compiler.h"
+#include "foundation/platform/system.h"
 #include "foundation/utility/autoreleaseptr.h"
 #include "foundation/utility/containers/dictionary.h"
 #include "foundation/utility/filter.h"
@@ -89,6 +91,7 @@ namespace
         GScalar     m_length_fuzziness;
         GScalar     m_curliness;
         size_t      m_split_count;
+        size_t      m_thread_count;
 
         explicit FluffParams(const CommandLineHandler& cl)
         {
@@ -102,6 +105,10 @@ namespace
             m_length_fuzziness = static_cast<GScalar>(cl.m_length_fuzziness.value());
             m_curliness = static_cast<GScalar>(cl.m_curliness.value());
             m_split_count = cl.m_presplits.value();
+            m_thread_count =
+                cl.m_threads.is_set()
+                    ? max<size_t>(cl.m_threads.value(), 1)
+                    : System::get_logical_cpu_core_count();
         }
     };
 
@@ -160,76 +167,85 @@ namespace
         cdf.prepare();
     }
 
-    void split_and_store(
-        CurveObject&                object,
-        const Curve3Type&           curve,
-        const size_t                split_count)
+    class FluffGenerator
+      : public ICurve3Generator
     {
-        if (split_count > 0)
+      public:
+        FluffGenerator(
+            const vector<SupportTriangle>&  support_triangles,
+            const CDF<size_t, GScalar>&     cdf,
+            const FluffParams&              params)
+          : m_support_triangles(support_triangles)
+          , m_cdf(cdf)
+          , m_params(params)
         {
-            Curve3Type child1, child2;
-            curve.split(child1, child2);
-            split_and_store(object, child1, split_count - 1);
-            split_and_store(object, child2, split_count - 1);
         }
-        else object.push_curve3(curve);
-    }
-
-    auto_release_ptr<CurveObject> create_curve_object(
-        const Assembly&             assembly,
-        const MeshObject&           support_object,
-        const FluffParams&          params)
-    {
-        const size_t ControlPointCount = 4;
-
-        vector<SupportTriangle> support_triangles;
-        CDF<size_t, GScalar> cdf;
-        extract_support_triangles(support_object, support_triangles, cdf);
-
-        const string curve_object_name = string(support_object.get_name()) + "_curves";
-        auto_release_ptr<CurveObject> curve_object =
-            CurveObjectFactory::create(
-                curve_object_name.c_str(),
-                ParamArray());
-
-        curve_object->reserve_curves3(params.m_curve_count);
-
-        GVector3 points[ControlPointCount];
-        GScalar widths[ControlPointCount];
-
-        MersenneTwister rng;
 
-        for (size_t i = 0; i < params.m_curve_count; ++i)
+        virtual Curve3Type generate(
+            const size_t                    curve_index,
+            const size_t                    curve_count,
+            MersenneTwister&                rng) const APPLESEED_OVERRIDE
         {
+            const size_t ControlPointCount = 4;
+            GVector3 points[ControlPointCount];
+            GScalar widths[ControlPointCount];
+
             static const size_t Bases[] = { 2, 3 };
-            const GVector3 s(hammersley_sequence<double, 3>(Bases, params.m_curve_count, i));
+            const GVector3 s(hammersley_sequence<double, 3>(Bases, curve_count, curve_index));
 
-            const size_t triangle_index = cdf.sample(s[0]).first;
-            const SupportTriangle& st = support_triangles[triangle_index];
+            const size_t triangle_index = m_cdf.sample(s[0]).first;
+            const SupportTriangle& st = m_support_triangles[triangle_index];
             const GVector3 bary = sample_triangle_uniform(GVector2(s[1], s[2]));
 
             points[0] = st.m_v0 * bary[0] + st.m_v1 * bary[1] + st.m_v2 * bary[2];
-            widths[0] = params.m_root_width;
+            widths[0] = m_params.m_root_width;
 
             GScalar f, length;
             do
             {
-                f = rand1(rng, -params.m_length_fuzziness, +params.m_length_fuzziness);
-                length = max(params.m_curve_length * (GScalar(1.0) + f), GScalar(0.0));
+                f = rand1(rng, -m_params.m_length_fuzziness, +m_params.m_length_fuzziness);
+                length = max(m_params.m_curve_length * (GScalar(1.0) + f), GScalar(0.0));
             } while (length <= 0.0);
 
             for (size_t p = 1; p < ControlPointCount; ++p)
             {
                 const GScalar r = static_cast<GScalar>(p) / (ControlPointCount - 1);
-                const GVector3 f = params.m_curliness * sample_sphere_uniform(rand_vector2<GVector2>(rng));
+                const GVector3 f = m_params.m_curliness * sample_sphere_uniform(rand_vector2<GVector2>(rng));
                 points[p] = points[0] + length * (r * st.m_normal + f);
-                widths[p] = lerp(params.m_root_width, params.m_tip_width, r);
+                widths[p] = lerp(m_params.m_root_width, m_params.m_tip_width, r);
             }
 
-            const Curve3Type curve(&points[0], &widths[0]);
-            split_and_store(curve_object.ref(), curve, params.m_split_count);
+            return Curve3Type(&points[0], &widths[0]);
         }
 
+      private:
+        const vector<SupportTriangle>&  m_support_triangles;
+        const CDF<size_t, GScalar>&     m_cdf;
+        const FluffParams&              m_params;
+    };
+
+    auto_release_ptr<CurveObject> create_curve_object(
+        const Assembly&             assembly,
+        const MeshObject&           support_object,
+        const FluffParams&          params)
+    {
+        vector<SupportTriangle> support_triangles;
+        CDF<size_t, GScalar> cdf;
+        extract_support_triangles(support_object, support_triangles, cdf);
+
+        const string curve_object_name = string(support_object.get_name()) + "_curves";
+        auto_release_ptr<CurveObject> curve_object =
+            CurveObjectFactory::create(
+                curve_object_name.c_str(),
+                ParamArray());
+
+        generate_curves3(
+            curve_object.ref(),
+            FluffGenerator(support_triangles, cdf, params),
+            params.m_curve_count,
+            params.m_split_count,
+            params.m_thread_count);
+
         return curve_object;
     }
 
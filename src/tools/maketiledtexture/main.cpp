@@ -0,0 +1,108 @@
+
+//
+// This source file is part of appleseed.
+// Visit http://appleseedhq.net/ for additional information and resources.
+//
+// This software is released under the MIT license.
+//
+// Copyright (c) 2017 Francois Beaune, The appleseedhq Organization
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+
+// Project headers.
+#include "commandlinehandler.h"
+
+// appleseed.shared headers.
+#include "application/application.h"
+#include "application/superlogger.h"
+
+// appleseed.foundation headers.
+#include "foundation/image/texturemaker.h"
+#include "foundation/utility/containers/dictionary.h"
+#include "foundation/utility/log.h"
+
+// Standard headers.
+#include <cstddef>
+#include <exception>
+#include <string>
+
+using namespace appleseed::maketiledtexture;
+using namespace appleseed::shared;
+using namespace foundation;
+using namespace std;
+
+
+//
+// Entry point of maketiledtexture.
+//
+
+int main(int argc, const char* argv[])
+{
+    // Initialize the logger that will be used throughout the program.
+    SuperLogger logger;
+
+    // Make sure appleseed is correctly installed.
+    Application::check_installation(logger);
+
+    // Parse the command line.
+    CommandLineHandler cl;
+    cl.parse(argc, argv, logger);
+
+    // Load an apply settings from the settings file.
+    Dictionary settings;
+    Application::load_settings("appleseed.tools.xml", settings, logger);
+    logger.configure_from_settings(settings);
+
+    // Apply command line arguments.
+    cl.apply(logger);
+
+    // Retrieve the input and output file paths.
+    const string& input_filepath = cl.m_filenames.values()[0];
+    const string& output_filepath = cl.m_filenames.values()[1];
+
+    // Retrieve the tile size.
+    const size_t tile_size = cl.m_tile_size.is_set() ? cl.m_tile_size.value() : 64;
+    if (tile_size == 0)
+        LOG_FATAL(logger, "the tile size must be greater than zero.");
+
+    // Write the texture file.
+    try
+    {
+        make_tiled_texture(
+            input_filepath.c_str(),
+            output_filepath.c_str(),
+            tile_size,
+            !cl.m_no_mipmaps.is_set());
+    }
+    catch (const exception& e)
+    {
+        LOG_FATAL(
+            logger,
+            "could not convert %s to texture file %s (%s).",
+            input_filepath.c_str(),
+            output_filepath.c_str(),
+            e.what());
+    }
+
+    LOG_INFO(logger, "wrote texture file %s.", output_filepath.c_str());
+
+    return 0;
+}
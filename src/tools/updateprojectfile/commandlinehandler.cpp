@@ -59,6 +59,14 @@ CommandLineHandler::CommandLineHandler()
             .set_description("update the project to this revision (by default, update to the latest revision)")
             .set_syntax("revision")
             .set_exact_value_count(1));
+
+    parser().add_option_handler(
+        &m_output_filename
+            .add_name("--output")
+            .add_name("-o")
+            .set_description("write the updated project to this file instead of overwriting the input file; use the .appleseedb extension to write a binary project file")
+            .set_syntax("filename")
+            .set_exact_value_count(1));
 }
 
 void CommandLineHandler::print_program_usage(
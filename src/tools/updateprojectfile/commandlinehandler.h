@@ -55,6 +55,7 @@ class CommandLineHandler
   public:
     foundation::ValueOptionHandler<std::string> m_filename;
     foundation::ValueOptionHandler<int>         m_to_revision;
+    foundation::ValueOptionHandler<std::string> m_output_filename;
 
     // Constructor.
     CommandLineHandler();
@@ -116,11 +116,16 @@ int main(int argc, const char* argv[])
     if (!success)
         return 1;
 
-    // Write the project back to disk.
+    // Write the project back to disk, possibly converting it to another format.
+    // The output file is expected to be in the same directory as the input file.
+    const string output_filepath =
+        cl.m_output_filename.is_set()
+            ? cl.m_output_filename.value()
+            : string(project->get_path());
     success =
         ProjectFileWriter::write(
             project.ref(),
-            project->get_path(),
+            output_filepath.c_str(),
             ProjectFileWriter::OmitWritingGeometryFiles | ProjectFileWriter::OmitHandlingAssetFiles);
     if (!success)
         return 1;